@@ -0,0 +1,30 @@
+include (FindPackageHandleStandardArgs REQUIRED)
+
+find_library (Libdeflate_LIBRARY
+  NAMES libdeflate.a deflate
+  HINTS ${REDPANDA_DEPS_INSTALL_DIR}/lib)
+
+find_path (Libdeflate_INCLUDE_DIR
+  NAMES libdeflate.h
+  HINTS ${REDPANDA_DEPS_INSTALL_DIR}/include)
+
+mark_as_advanced (
+  Libdeflate_LIBRARY
+  Libdeflate_INCLUDE_DIR)
+
+find_package_handle_standard_args (Libdeflate DEFAULT_MSG
+  Libdeflate_LIBRARY
+  Libdeflate_INCLUDE_DIR)
+
+if (Libdeflate_FOUND)
+  set (Libdeflate_LIBRARIES ${Libdeflate_LIBRARY})
+  set (Libdeflate_INCLUDE_DIRS ${Libdeflate_INCLUDE_DIR})
+endif ()
+
+if (Libdeflate_FOUND AND NOT (TARGET Libdeflate::libdeflate))
+  add_library (Libdeflate::libdeflate UNKNOWN IMPORTED)
+  set_target_properties (Libdeflate::libdeflate
+    PROPERTIES
+      IMPORTED_LOCATION ${Libdeflate_LIBRARY}
+      INTERFACE_INCLUDE_DIRECTORIES ${Libdeflate_INCLUDE_DIR})
+endif ()
@@ -0,0 +1,291 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/s3_client.h"
+
+#include "archival/logger.h"
+#include "bytes/iobuf_parser.h"
+#include "vlog.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+
+#include <boost/beast/http/field.hpp>
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+
+namespace archival {
+
+std::vector<upload_part> split_parts(size_t size, size_t part_size) {
+    std::vector<upload_part> ret;
+    // empty objects are still uploaded as one part
+    if (size == 0 || part_size == 0) {
+        ret.push_back(upload_part{.number = 1, .offset = 0, .size = size});
+        return ret;
+    }
+    ret.reserve((size + part_size - 1) / part_size);
+    for (size_t offset = 0; offset < size; offset += part_size) {
+        ret.push_back(upload_part{
+          .number = ret.size() + 1,
+          .offset = offset,
+          .size = std::min(part_size, size - offset)});
+    }
+    return ret;
+}
+
+std::optional<ss::sstring> parse_upload_id(std::string_view body) {
+    constexpr std::string_view open = "<UploadId>";
+    constexpr std::string_view close = "</UploadId>";
+    const auto begin = body.find(open);
+    if (begin == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const auto value = begin + open.size();
+    const auto end = body.find(close, value);
+    if (end == std::string_view::npos || end == value) {
+        return std::nullopt;
+    }
+    return ss::sstring(body.substr(value, end - value));
+}
+
+ss::sstring complete_multipart_body(const std::vector<ss::sstring>& etags) {
+    fmt::memory_buffer out;
+    fmt::format_to(out, "<CompleteMultipartUpload>");
+    for (size_t i = 0; i < etags.size(); ++i) {
+        fmt::format_to(
+          out,
+          "<Part><PartNumber>{}</PartNumber><ETag>{}</ETag></Part>",
+          i + 1,
+          etags[i]);
+    }
+    fmt::format_to(out, "</CompleteMultipartUpload>");
+    return ss::sstring(out.data(), out.size());
+}
+
+ss::sstring uri_encode(std::string_view in) {
+    fmt::memory_buffer out;
+    for (const char c : in) {
+        if (
+          (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+          || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.'
+          || c == '~') {
+            fmt::format_to(out, "{}", c);
+        } else {
+            fmt::format_to(out, "%{:02X}", static_cast<uint8_t>(c));
+        }
+    }
+    return ss::sstring(out.data(), out.size());
+}
+
+static iobuf string_to_iobuf(std::string_view s) {
+    iobuf b;
+    b.append(s.data(), s.size());
+    return b;
+}
+
+static ss::sstring iobuf_to_string(iobuf b) {
+    iobuf_parser p(std::move(b));
+    return p.read_string(p.bytes_left());
+}
+
+s3_client::s3_client(s3_configuration cfg, http::client_pool& pool)
+  : _cfg(std::move(cfg))
+  , _client(pool.acquire(_cfg.transport)) {}
+
+ss::future<> s3_client::stop() {
+    _client.release();
+    return ss::now();
+}
+
+ss::sstring s3_client::object_target(const ss::sstring& key) const {
+    return fmt::format("/{}/{}", _cfg.bucket, key);
+}
+
+http::client::request_header s3_client::make_header(
+  boost::beast::http::verb verb, const ss::sstring& target, size_t length) {
+    http::client::request_header header;
+    header.method(verb);
+    header.target(std::string(target));
+    header.insert(boost::beast::http::field::host, std::string(_cfg.host));
+    header.insert(boost::beast::http::field::content_length, length);
+    return header;
+}
+
+ss::future<s3_client::response>
+s3_client::read_response(http::client::response_stream& resp) {
+    return ss::do_with(iobuf(), [&resp](iobuf& body) {
+        return ss::do_until(
+                 [&resp] { return resp.is_done(); },
+                 [&resp, &body] {
+                     return resp.recv_some().then([&body](iobuf b) {
+                         body.append(std::move(b));
+                     });
+                 })
+          .then([&resp, &body] {
+              auto& headers = resp.get_headers();
+              auto etag = headers[boost::beast::http::field::etag];
+              return response{
+                .status = headers.result(),
+                .etag = ss::sstring(etag.data(), etag.size()),
+                .body = std::move(body)};
+          });
+    });
+}
+
+ss::future<s3_client::response>
+s3_client::expect_ok(response r, std::string_view request) {
+    if (r.status == boost::beast::http::status::ok) {
+        return ss::make_ready_future<response>(std::move(r));
+    }
+    auto msg = fmt::format(
+      "{} failed with status {} - {}",
+      request,
+      r.status,
+      iobuf_to_string(std::move(r.body)));
+    return ss::make_exception_future<response>(s3_error(r.status, msg));
+}
+
+ss::future<s3_client::response> s3_client::send(
+  boost::beast::http::verb verb, const ss::sstring& target, iobuf body) {
+    vlog(archival_log.trace, "{} {}", verb, target);
+    auto header = make_header(verb, target, body.size_bytes());
+    return _client->make_request(std::move(header))
+      .then([body = std::move(body)](
+              http::client::request_response_t rr) mutable {
+          auto req = std::get<0>(rr);
+          auto resp = std::get<1>(rr);
+          return req->send_some(std::move(body))
+            .then([req] { return req->send_eof(); })
+            .then([resp] { return read_response(*resp); })
+            .finally([req, resp] {});
+      });
+}
+
+ss::future<ss::sstring>
+s3_client::create_multipart_upload(const ss::sstring& key) {
+    return send(
+             boost::beast::http::verb::post,
+             object_target(key) + "?uploads",
+             iobuf())
+      .then([](response r) {
+          return expect_ok(std::move(r), "CreateMultipartUpload");
+      })
+      .then([key](response r) {
+          auto id = parse_upload_id(iobuf_to_string(std::move(r.body)));
+          if (!id) {
+              return ss::make_exception_future<ss::sstring>(s3_error(
+                r.status,
+                fmt::format("No upload id in the response for {}", key)));
+          }
+          return ss::make_ready_future<ss::sstring>(std::move(*id));
+      });
+}
+
+ss::future<ss::sstring> s3_client::upload_part(
+  const ss::sstring& key,
+  const ss::sstring& upload_id,
+  upload_part part,
+  ss::input_stream<char>& in,
+  throttle_fn& throttle) {
+    auto target = fmt::format(
+      "{}?partNumber={}&uploadId={}",
+      object_target(key),
+      part.number,
+      uri_encode(upload_id));
+    vlog(archival_log.trace, "PUT {} ({} bytes)", target, part.size);
+    auto header = make_header(
+      boost::beast::http::verb::put, target, part.size);
+    return _client->make_request(std::move(header))
+      .then([&in, &throttle, part](http::client::request_response_t rr) {
+          auto req = std::get<0>(rr);
+          auto resp = std::get<1>(rr);
+          return ss::do_with(
+                   part.size,
+                   [&in, &throttle, req](size_t& remaining) {
+                       return ss::do_until(
+                         [&remaining] { return remaining == 0; },
+                         [&in, &throttle, &remaining, req] {
+                             return in.read_up_to(remaining)
+                               .then([&throttle, &remaining, req](
+                                       ss::temporary_buffer<char> buf) {
+                                   if (buf.empty()) {
+                                       return ss::make_exception_future<>(
+                                         std::runtime_error(
+                                           "Object shorter than its size"));
+                                   }
+                                   remaining -= buf.size();
+                                   const auto n = buf.size();
+                                   return throttle(n).then(
+                                     [req, buf = std::move(buf)]() mutable {
+                                         iobuf b;
+                                         b.append(std::move(buf));
+                                         return req->send_some(std::move(b));
+                                     });
+                               });
+                         });
+                   })
+            .then([req] { return req->send_eof(); })
+            .then([resp] { return read_response(*resp); })
+            .finally([req, resp] {});
+      })
+      .then([](response r) { return expect_ok(std::move(r), "UploadPart"); })
+      .then([](response r) { return std::move(r.etag); });
+}
+
+ss::future<> s3_client::complete_multipart_upload(
+  const ss::sstring& key,
+  const ss::sstring& upload_id,
+  const std::vector<ss::sstring>& etags) {
+    return send(
+             boost::beast::http::verb::post,
+             fmt::format(
+               "{}?uploadId={}", object_target(key), uri_encode(upload_id)),
+             string_to_iobuf(complete_multipart_body(etags)))
+      .then([](response r) {
+          return expect_ok(std::move(r), "CompleteMultipartUpload");
+      })
+      .then([key](response r) {
+          // errors found while completing come with a 200 status
+          auto body = iobuf_to_string(std::move(r.body));
+          if (body.find("<Error>") != ss::sstring::npos) {
+              return ss::make_exception_future<>(s3_error(
+                r.status,
+                fmt::format(
+                  "Completing the upload of {} failed - {}", key, body)));
+          }
+          return ss::now();
+      });
+}
+
+ss::future<> s3_client::abort_multipart_upload(
+  const ss::sstring& key, const ss::sstring& upload_id) {
+    return send(
+             boost::beast::http::verb::delete_,
+             fmt::format(
+               "{}?uploadId={}", object_target(key), uri_encode(upload_id)),
+             iobuf())
+      .then([](response r) {
+          if (r.status != boost::beast::http::status::no_content) {
+              return expect_ok(std::move(r), "AbortMultipartUpload")
+                .discard_result();
+          }
+          return ss::now();
+      });
+}
+
+ss::future<> s3_client::put_object(const ss::sstring& key, iobuf body) {
+    return send(
+             boost::beast::http::verb::put, object_target(key), std::move(body))
+      .then([](response r) { return expect_ok(std::move(r), "PutObject"); })
+      .discard_result();
+}
+
+} // namespace archival
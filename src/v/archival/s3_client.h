@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "http/client.h"
+#include "http/client_pool.h"
+#include "rpc/transport.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <boost/beast/http/status.hpp>
+#include <boost/beast/http/verb.hpp>
+
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace archival {
+
+struct s3_configuration {
+    rpc::base_transport::configuration transport;
+    // value of the Host header
+    ss::sstring host;
+    ss::sstring bucket;
+};
+
+/// byte range of an object sent as one part of a multipart upload
+struct upload_part {
+    // parts are numbered from 1
+    size_t number;
+    size_t offset;
+    size_t size;
+};
+
+/// splits an object of `size` bytes into parts of `part_size`, the last
+/// part is shorter
+std::vector<upload_part> split_parts(size_t size, size_t part_size);
+
+/// value of the UploadId element of a CreateMultipartUpload response
+std::optional<ss::sstring> parse_upload_id(std::string_view body);
+
+/// CompleteMultipartUpload request body listing the ETags of the parts
+ss::sstring complete_multipart_body(const std::vector<ss::sstring>& etags);
+
+/// percent-encodes everything but the unreserved characters of RFC 3986
+ss::sstring uri_encode(std::string_view);
+
+/// unexpected response of the object store
+class s3_error final : public std::runtime_error {
+public:
+    s3_error(boost::beast::http::status status, const ss::sstring& msg)
+      : std::runtime_error(msg)
+      , _status(status) {}
+
+    boost::beast::http::status status() const { return _status; }
+
+private:
+    boost::beast::http::status _status;
+};
+
+/**
+ * Client of the multipart upload API of an S3 compatible object store.
+ *
+ * Objects are addressed path-style, /<bucket>/<key>. The client borrows a
+ * single connection from the pool and sends one request at a time, callers
+ * run several clients to upload concurrently. The connection goes back to
+ * the pool when the client is stopped, and is reused by the next client of
+ * the endpoint unless a request failed on it. Part bodies are streamed from
+ * an input stream, only one buffer of the stream is held at a time.
+ *
+ * Requests are not signed, the endpoint is expected to accept them for the
+ * bucket, e.g. through a bucket policy or a signing proxy next to the
+ * broker.
+ */
+class s3_client {
+public:
+    // waits until the given number of body bytes may be sent
+    using throttle_fn = ss::noncopyable_function<ss::future<>(size_t)>;
+
+    s3_client(s3_configuration, http::client_pool&);
+
+    /// starts a multipart upload of `key`, returns its upload id
+    ss::future<ss::sstring> create_multipart_upload(const ss::sstring& key);
+
+    /// streams the `part.size` next bytes of `in` as a part of the upload,
+    /// returns the ETag of the part
+    ss::future<ss::sstring> upload_part(
+      const ss::sstring& key,
+      const ss::sstring& upload_id,
+      upload_part part,
+      ss::input_stream<char>& in,
+      throttle_fn& throttle);
+
+    ss::future<> complete_multipart_upload(
+      const ss::sstring& key,
+      const ss::sstring& upload_id,
+      const std::vector<ss::sstring>& etags);
+
+    /// drops the parts of an upload which is not completed
+    ss::future<> abort_multipart_upload(
+      const ss::sstring& key, const ss::sstring& upload_id);
+
+    /// uploads a small object in a single request
+    ss::future<> put_object(const ss::sstring& key, iobuf body);
+
+    /// returns the connection to the pool
+    ss::future<> stop();
+
+private:
+    struct response {
+        boost::beast::http::status status;
+        ss::sstring etag;
+        iobuf body;
+    };
+
+    http::client::request_header make_header(
+      boost::beast::http::verb, const ss::sstring& target, size_t length);
+    ss::sstring object_target(const ss::sstring& key) const;
+
+    ss::future<response>
+    send(boost::beast::http::verb, const ss::sstring& target, iobuf body);
+    static ss::future<response> read_response(http::client::response_stream&);
+    static ss::future<response> expect_ok(response, std::string_view request);
+
+    s3_configuration _cfg;
+    http::client_pool::lease _client;
+};
+
+} // namespace archival
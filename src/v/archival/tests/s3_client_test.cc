@@ -0,0 +1,60 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE archival
+#include "archival/s3_client.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(parts_cover_the_object) {
+    auto parts = archival::split_parts(20, 8);
+    BOOST_REQUIRE_EQUAL(parts.size(), 3);
+    size_t offset = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        BOOST_CHECK_EQUAL(parts[i].number, i + 1);
+        BOOST_CHECK_EQUAL(parts[i].offset, offset);
+        offset += parts[i].size;
+    }
+    BOOST_CHECK_EQUAL(parts.back().size, 4);
+    BOOST_CHECK_EQUAL(offset, 20);
+
+    BOOST_CHECK_EQUAL(archival::split_parts(16, 8).size(), 2);
+    // empty objects are a single empty part
+    auto empty = archival::split_parts(0, 8);
+    BOOST_REQUIRE_EQUAL(empty.size(), 1);
+    BOOST_CHECK_EQUAL(empty[0].size, 0);
+}
+
+BOOST_AUTO_TEST_CASE(upload_id_is_parsed) {
+    constexpr std::string_view body
+      = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<InitiateMultipartUploadResult>"
+        "<Bucket>bucket</Bucket><Key>kafka/topic/0_1/0-1-v1.log</Key>"
+        "<UploadId>VXBsb2FkIElE.-_</UploadId>"
+        "</InitiateMultipartUploadResult>";
+    BOOST_CHECK_EQUAL(
+      archival::parse_upload_id(body).value(), "VXBsb2FkIElE.-_");
+    BOOST_CHECK(!archival::parse_upload_id("<UploadId></UploadId>"));
+    BOOST_CHECK(!archival::parse_upload_id("<UploadId>abc"));
+    BOOST_CHECK(!archival::parse_upload_id("<Error></Error>"));
+}
+
+BOOST_AUTO_TEST_CASE(complete_body_lists_the_parts_in_order) {
+    BOOST_CHECK_EQUAL(
+      archival::complete_multipart_body({"\"a\"", "\"b\""}),
+      "<CompleteMultipartUpload>"
+      "<Part><PartNumber>1</PartNumber><ETag>\"a\"</ETag></Part>"
+      "<Part><PartNumber>2</PartNumber><ETag>\"b\"</ETag></Part>"
+      "</CompleteMultipartUpload>");
+}
+
+BOOST_AUTO_TEST_CASE(uri_encoding_keeps_unreserved_characters) {
+    BOOST_CHECK_EQUAL(archival::uri_encode("aZ09-_.~"), "aZ09-_.~");
+    BOOST_CHECK_EQUAL(archival::uri_encode("a+b/c="), "a%2Bb%2Fc%3D");
+}
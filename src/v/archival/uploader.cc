@@ -0,0 +1,354 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/uploader.h"
+
+#include "archival/logger.h"
+#include "cluster/namespace.h"
+#include "config/configuration.h"
+#include "model/adl_serde.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "reflection/adl.h"
+#include "resource_mgmt/io_priority.h"
+#include "vlog.h"
+
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/seastar.hh>
+
+#include <fmt/format.h>
+
+#include <filesystem>
+
+namespace archival {
+
+uploader::uploader(
+  uploader_config cfg,
+  ss::sharded<cluster::partition_manager>& partitions,
+  ss::sharded<storage::api>& storage)
+  : _cfg(std::move(cfg))
+  , _partitions(partitions)
+  , _storage(storage)
+  , _throttle(
+      storage::compaction_throttle::config{
+        .max_bytes_per_sec = _cfg.max_bytes_per_sec},
+      _as)
+  , _throttle_fn([this](size_t n) {
+      _uploaded_bytes += n;
+      return _throttle.throttle(n);
+  })
+  , _uploads(std::max<size_t>(1, _cfg.upload_concurrency))
+  , _connections(http::client_pool::configuration{
+      .max_idle_per_target = std::max<size_t>(1, _cfg.upload_concurrency)}) {}
+
+ss::future<> uploader::start() {
+    setup_metrics();
+    _timer.set_callback([this] { tick(); });
+    _timer.arm_periodic(_cfg.interval);
+    return ss::now();
+}
+
+ss::future<> uploader::stop() {
+    _timer.cancel();
+    _as.request_abort();
+    _uploads.broken();
+    return _gate.close().then([this] {
+        _ntps.clear();
+        return _connections.stop();
+    });
+}
+
+void uploader::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("archival:uploads"),
+      {
+        sm::make_derive(
+          "segments",
+          [this] { return _uploaded_segments; },
+          sm::description("Number of segments uploaded to the object store")),
+        sm::make_derive(
+          "bytes",
+          [this] { return _uploaded_bytes; },
+          sm::description("Number of bytes uploaded to the object store")),
+        sm::make_derive(
+          "failures",
+          [this] { return _failed_uploads; },
+          sm::description("Number of segment uploads which failed")),
+        sm::make_gauge(
+          "rate",
+          [this] { return _throttle.current_rate(); },
+          sm::description("Upload rate limit in bytes per second")),
+      });
+}
+
+void uploader::setup_metrics(ntp_state& st) {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    auto ns_label = sm::label("namespace");
+    auto topic_label = sm::label("topic");
+    auto partition_label = sm::label("partition");
+    const std::vector<sm::label_instance> labels = {
+      ns_label(st.ntp.ns()),
+      topic_label(st.ntp.tp.topic()),
+      partition_label(st.ntp.tp.partition()),
+    };
+    st.metrics.add_group(
+      prometheus_sanitize::metrics_name("archival:partition"),
+      {
+        sm::make_gauge(
+          "upload_lag",
+          [&st] {
+              // nothing uploaded yet is an uploaded offset of -1
+              const int64_t uploaded = std::max<int64_t>(st.uploaded(), -1);
+              return std::max<int64_t>(0, st.committed() - uploaded);
+          },
+          sm::description("Committed offsets not uploaded yet"),
+          labels),
+      });
+}
+
+uploader::ntp_state_ptr uploader::make_state(const model::ntp& ntp) {
+    auto st = ss::make_lw_shared<ntp_state>(ntp);
+    st->uploaded = read_uploaded_offset(ntp);
+    setup_metrics(*st);
+    return st;
+}
+
+void uploader::tick() {
+    if (_as.abort_requested()) {
+        return;
+    }
+    auto& partitions = _partitions.local().partitions();
+    // partitions not led here anymore are left to their new leader
+    absl::erase_if(_ntps, [&partitions](const auto& e) {
+        auto it = partitions.find(e.first);
+        return !e.second->uploading
+               && (it == partitions.end() || !it->second->is_leader());
+    });
+    for (auto& [ntp, p] : partitions) {
+        if (ntp.ns != cluster::kafka_namespace || !p->is_leader()) {
+            continue;
+        }
+        auto& st = _ntps[ntp];
+        if (!st) {
+            st = make_state(ntp);
+        }
+        st->committed = p->committed_offset();
+        if (st->uploading || st->committed <= st->uploaded) {
+            continue;
+        }
+        st->uploading = true;
+        (void)ss::with_gate(_gate, [this, st] {
+            return upload_partition(st).finally(
+              [st] { st->uploading = false; });
+        });
+    }
+}
+
+ss::future<> uploader::upload_partition(ntp_state_ptr st) {
+    return ss::repeat([this, st] { return upload_next_segment(st); })
+      .handle_exception([this, st](const std::exception_ptr& e) {
+          if (_as.abort_requested()) {
+              return;
+          }
+          ++_failed_uploads;
+          vlog(
+            archival_log.warn,
+            "Error uploading segments of {} - {}, retrying in {}ms",
+            st->ntp,
+            e,
+            _cfg.interval.count());
+      });
+}
+
+ss::future<ss::stop_iteration>
+uploader::upload_next_segment(ntp_state_ptr st) {
+    auto log = _storage.local().log_mgr().get(st->ntp);
+    if (_as.abort_requested() || !log) {
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::yes);
+    }
+    const auto segments = log->closed_segments();
+    auto it = std::find_if(
+      segments.begin(),
+      segments.end(),
+      [&st](const storage::segment_file& f) {
+          return f.committed_offset > st->uploaded;
+      });
+    // the data of the segment may not be replicated yet
+    if (it == segments.end() || it->committed_offset > st->committed) {
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::yes);
+    }
+    return ss::with_semaphore(
+             _uploads,
+             1,
+             [this, st, seg = *it] {
+                 return upload_segment(st->ntp, seg).then([this, st, seg] {
+                     ++_uploaded_segments;
+                     st->uploaded = seg.committed_offset;
+                     return write_uploaded_offset(st->ntp, st->uploaded);
+                 });
+             })
+      .then([] { return ss::stop_iteration::no; });
+}
+
+ss::future<> uploader::upload_segment(
+  const model::ntp& ntp, const storage::segment_file& seg) {
+    auto prefix = ntp.path();
+    auto data_key = fmt::format(
+      "{}/{}",
+      prefix,
+      std::filesystem::path(seg.data_path.c_str()).filename().string());
+    auto index_key = fmt::format(
+      "{}/{}",
+      prefix,
+      std::filesystem::path(seg.index_path.c_str()).filename().string());
+    vlog(archival_log.debug, "Uploading segment {} of {}", seg, ntp);
+    return _cfg.endpoint.resolve().then(
+      [this,
+       seg,
+       data_key = std::move(data_key),
+       index_key = std::move(index_key)](ss::socket_address addr) mutable {
+          s3_configuration cfg{
+            .host = _cfg.endpoint.host(), .bucket = _cfg.bucket};
+          cfg.transport.server_addr = addr;
+          cfg.transport.disable_metrics = rpc::metrics_disabled::yes;
+          return ss::do_with(
+            s3_client(std::move(cfg), _connections),
+            [this, seg, data_key, index_key](s3_client& client) {
+                return upload_data_file(client, data_key, seg)
+                  .then([this, &client, index_key, seg] {
+                      // the index refers to the data, it goes last
+                      return upload_index_file(
+                        client, index_key, seg.index_path);
+                  })
+                  .finally([&client] { return client.stop(); });
+            });
+      });
+}
+
+ss::future<> uploader::upload_parts(
+  s3_client& client,
+  const ss::sstring& key,
+  const ss::sstring& upload_id,
+  ss::input_stream<char>& in,
+  size_t size) {
+    return ss::do_with(
+      split_parts(size, _cfg.part_size),
+      std::vector<ss::sstring>{},
+      [this, &client, &in, key, upload_id](
+        std::vector<upload_part>& parts, std::vector<ss::sstring>& etags) {
+          return ss::do_for_each(
+                   parts,
+                   [this, &client, &in, &etags, key, upload_id](upload_part p) {
+                       return client
+                         .upload_part(key, upload_id, p, in, _throttle_fn)
+                         .then([&etags](ss::sstring etag) {
+                             etags.push_back(std::move(etag));
+                         });
+                   })
+            .then([&client, &etags, key, upload_id] {
+                return client.complete_multipart_upload(key, upload_id, etags);
+            });
+      });
+}
+
+ss::future<> uploader::upload_data_file(
+  s3_client& client, const ss::sstring& key, const storage::segment_file& seg) {
+    return ss::open_file_dma(seg.data_path, ss::open_flags::ro)
+      .then([this, &client, key, size = seg.size_bytes](ss::file f) {
+          ss::file_input_stream_options opts;
+          opts.buffer_size = 128_KiB;
+          opts.read_ahead = 2;
+          opts.io_priority_class = archival_priority();
+          return ss::do_with(
+                   ss::make_file_input_stream(f, 0, size, std::move(opts)),
+                   [this, &client, key, size](ss::input_stream<char>& in) {
+                       return client.create_multipart_upload(key)
+                         .then([this, &client, &in, key, size](
+                                 ss::sstring upload_id) {
+                             return upload_parts(
+                                      client, key, upload_id, in, size)
+                               .handle_exception(
+                                 [&client, key, upload_id](
+                                   const std::exception_ptr& e) {
+                                     return abort_upload(
+                                       client, key, upload_id, e);
+                                 });
+                         })
+                         .finally([&in] { return in.close(); });
+                   })
+            .finally([f]() mutable { return f.close(); });
+      });
+}
+
+ss::future<> uploader::abort_upload(
+  s3_client& client,
+  const ss::sstring& key,
+  const ss::sstring& upload_id,
+  std::exception_ptr e) {
+    // the parts uploaded so far are dropped, a failed abort leaves them to
+    // the lifecycle rules of the bucket
+    return client.abort_multipart_upload(key, upload_id)
+      .handle_exception([](const std::exception_ptr&) {})
+      .then([e] { return ss::make_exception_future<>(e); });
+}
+
+ss::future<> uploader::upload_index_file(
+  s3_client& client, const ss::sstring& key, const ss::sstring& path) {
+    return ss::open_file_dma(path, ss::open_flags::ro)
+      .then([this, &client, key](ss::file f) {
+          return f.size()
+            .then([f](uint64_t size) mutable {
+                return f.dma_read_bulk<char>(0, size, archival_priority());
+            })
+            .then([this, &client, key](ss::temporary_buffer<char> buf) {
+                return _throttle_fn(buf.size()).then(
+                  [&client, key, buf = std::move(buf)]() mutable {
+                      iobuf body;
+                      body.append(std::move(buf));
+                      return client.put_object(key, std::move(body));
+                  });
+            })
+            .finally([f]() mutable { return f.close(); });
+      });
+}
+
+bytes uploader::uploaded_offset_key(const model::ntp& ntp) {
+    iobuf buf;
+    reflection::serialize(buf, ntp);
+    return iobuf_to_bytes(buf);
+}
+
+model::offset uploader::read_uploaded_offset(const model::ntp& ntp) {
+    auto value = _storage.local().kvs().get(
+      storage::kvstore::key_space::archival, uploaded_offset_key(ntp));
+    if (value) {
+        return reflection::adl<model::offset>{}.from(std::move(*value));
+    }
+    return model::offset{};
+}
+
+ss::future<>
+uploader::write_uploaded_offset(const model::ntp& ntp, model::offset o) {
+    return _storage.local().kvs().put(
+      storage::kvstore::key_space::archival,
+      uploaded_offset_key(ntp),
+      reflection::to_iobuf(o));
+}
+
+} // namespace archival
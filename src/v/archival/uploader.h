@@ -0,0 +1,138 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "archival/s3_client.h"
+#include "cluster/partition_manager.h"
+#include "http/client_pool.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "storage/api.h"
+#include "storage/compaction_throttle.h"
+#include "storage/types.h"
+#include "units.h"
+#include "utils/unresolved_address.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+
+namespace archival {
+
+struct uploader_config {
+    unresolved_address endpoint;
+    ss::sstring bucket;
+    // segments uploaded at the same time by a shard
+    size_t upload_concurrency{2};
+    // per shard, zero does not limit the uploads
+    size_t max_bytes_per_sec{0};
+    std::chrono::milliseconds interval{std::chrono::seconds(10)};
+    size_t part_size{8_MiB};
+};
+
+/**
+ * Uploads the closed segments of the partitions led by the shard to an S3
+ * compatible object store.
+ *
+ * Segments are uploaded in offset order, one at a time per partition, with
+ * their index next to them under `<ntp path>/<segment file name>`. Only
+ * segments whose data is committed by raft are uploaded. The data file is
+ * streamed with a multipart upload from the archival io priority class, at
+ * most `upload_concurrency` segments of the shard are in flight and their
+ * bytes are rate limited by a token bucket, so uploads only use the disk and
+ * network capacity produce requests leave over. The last offset uploaded for
+ * every partition is kept in the kvstore. A new leader does not know what
+ * the previous one uploaded and uploads the segments again under the same
+ * keys.
+ */
+class uploader {
+public:
+    uploader(
+      uploader_config,
+      ss::sharded<cluster::partition_manager>&,
+      ss::sharded<storage::api>&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+private:
+    struct ntp_state {
+        explicit ntp_state(model::ntp n)
+          : ntp(std::move(n)) {}
+
+        model::ntp ntp;
+        // last offset of the segments uploaded
+        model::offset uploaded;
+        // raft committed offset of the partition when last seen
+        model::offset committed;
+        bool uploading{false};
+        ss::metrics::metric_groups metrics;
+    };
+    using ntp_state_ptr = ss::lw_shared_ptr<ntp_state>;
+
+    void tick();
+    ntp_state_ptr make_state(const model::ntp&);
+    void setup_metrics();
+    void setup_metrics(ntp_state&);
+
+    ss::future<> upload_partition(ntp_state_ptr);
+    ss::future<ss::stop_iteration> upload_next_segment(ntp_state_ptr);
+    ss::future<>
+    upload_segment(const model::ntp&, const storage::segment_file&);
+    ss::future<> upload_data_file(
+      s3_client&, const ss::sstring& key, const storage::segment_file&);
+    ss::future<> upload_parts(
+      s3_client&,
+      const ss::sstring& key,
+      const ss::sstring& upload_id,
+      ss::input_stream<char>&,
+      size_t size);
+    static ss::future<> abort_upload(
+      s3_client&,
+      const ss::sstring& key,
+      const ss::sstring& upload_id,
+      std::exception_ptr);
+    ss::future<> upload_index_file(
+      s3_client&, const ss::sstring& key, const ss::sstring& path);
+
+    static bytes uploaded_offset_key(const model::ntp&);
+    model::offset read_uploaded_offset(const model::ntp&);
+    ss::future<> write_uploaded_offset(const model::ntp&, model::offset);
+
+    uploader_config _cfg;
+    ss::sharded<cluster::partition_manager>& _partitions;
+    ss::sharded<storage::api>& _storage;
+
+    ss::abort_source _as;
+    storage::compaction_throttle _throttle;
+    s3_client::throttle_fn _throttle_fn;
+    ss::semaphore _uploads;
+    http::client_pool _connections;
+    absl::flat_hash_map<model::ntp, ntp_state_ptr> _ntps;
+    ss::timer<> _timer;
+    ss::gate _gate;
+
+    uint64_t _uploaded_segments{0};
+    uint64_t _uploaded_bytes{0};
+    uint64_t _failed_uploads{0};
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace archival
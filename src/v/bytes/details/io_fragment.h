@@ -11,14 +11,18 @@
 
 #pragma once
 
+#include "bytes/details/io_fragment_pool.h"
 #include "bytes/details/out_of_range.h"
 #include "seastarx.h"
 #include "utils/intrusive_list_helpers.h"
 
+#include <seastar/core/deleter.hh>
 #include <seastar/core/temporary_buffer.hh>
 
+#include <new>
+
 namespace details {
-class io_fragment {
+class io_fragment final {
 public:
     struct full {};
     struct empty {};
@@ -35,6 +39,22 @@ public:
     io_fragment& operator=(const io_fragment& o) = delete;
     ~io_fragment() noexcept = default;
 
+    /// empty fragment of `size` bytes, co-allocated with its buffer when the
+    /// size is a pooled size class. release with dispose()
+    static io_fragment* make_empty(size_t size);
+    /// releases a fragment, whichever way it was allocated
+    static void dispose(io_fragment*) noexcept;
+
+    // fragment objects are recycled by the shard's io_fragment_pool
+    static void* operator new(size_t size) {
+        return io_fragment_pool::local().allocate_fragment(size);
+    }
+    static void* operator new(size_t, void* p) noexcept { return p; }
+    static void operator delete(void* p) noexcept {
+        io_fragment_pool::local().deallocate_fragment(p);
+    }
+    static void operator delete(void*, void*) noexcept {}
+
     bool operator==(const io_fragment& o) const {
         return _used_bytes == o._used_bytes && _buf == o._buf;
     }
@@ -78,7 +98,9 @@ public:
             return;
         }
         size_t half = _buf.size() / 2;
-        if (_used_bytes <= half) {
+        // a co-allocated buffer is only released with its fragment, copying
+        // the used bytes out would not free it
+        if (_used_bytes <= half && !_block) {
             // this is an important optimization. often times during RPC
             // serialization we append some small controll bytes, _right_
             // before we append a full new chain of iobufs
@@ -88,6 +110,13 @@ public:
         }
     }
     void trim(size_t len) { _used_bytes = std::min(len, _used_bytes); }
+    /// splits the unused capacity off into a separate buffer sharing the same
+    /// allocation. the fragment is left full.
+    ss::temporary_buffer<char> split_available() {
+        auto tail = _buf.share(_used_bytes, available_bytes());
+        _buf.trim(_used_bytes);
+        return tail;
+    }
     void trim_front(size_t pos) {
         // required by input_stream<char> converter
         _buf.trim_front(pos);
@@ -99,8 +128,99 @@ public:
     safe_intrusive_list_hook hook;
 
 private:
+    struct block;
+
+    io_fragment(ss::temporary_buffer<char> buf, ss::deleter block) noexcept
+      : _buf(std::move(buf))
+      , _used_bytes(0)
+      , _block(std::move(block)) {}
+
     ss::temporary_buffer<char> _buf;
     size_t _used_bytes;
+    // keeps the block of a co-allocated fragment alive, empty otherwise
+    ss::deleter _block;
 };
 
+/*
+ * A fragment co-allocated with its buffer lives in a single block of
+ *
+ *   [prefix][block][io_fragment][buffer of `size` bytes]
+ *
+ * `block` is the deleter of the buffer, shared by the fragment and every
+ * share of the buffer. The block is returned to the pool when the last of
+ * them is released.
+ */
+struct io_fragment::block final : ss::deleter::impl {
+    struct prefix {
+        uint32_t size;
+        uint32_t cls;
+    };
+
+    static constexpr size_t align_up(size_t n, size_t a) {
+        return (n + a - 1) / a * a;
+    }
+    static constexpr size_t block_offset = align_up(
+      sizeof(prefix), alignof(std::max_align_t));
+    static constexpr size_t fragment_offset = block_offset
+                                              + align_up(
+                                                sizeof(ss::deleter::impl),
+                                                alignof(io_fragment));
+    static constexpr size_t data_offset = align_up(
+      fragment_offset + sizeof(io_fragment), alignof(std::max_align_t));
+
+    static constexpr size_t bytes(size_t size) { return data_offset + size; }
+
+    block() noexcept
+      : ss::deleter::impl(ss::deleter()) {}
+    ~block() override = default;
+
+    static void* operator new(size_t, void* p) noexcept { return p; }
+    static void operator delete(void* p) noexcept {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto* mem = static_cast<char*>(p) - block_offset;
+        const auto* pre = reinterpret_cast<const prefix*>(mem); // NOLINT
+        io_fragment_pool::local().deallocate_block(
+          pre->cls, mem, bytes(pre->size));
+    }
+    static void operator delete(void*, void*) noexcept {}
+};
+
+inline io_fragment* io_fragment::make_empty(size_t size) {
+    static_assert(
+      sizeof(block) == sizeof(ss::deleter::impl),
+      "fragment_offset assumes the block adds no members to the deleter");
+    const auto cls = io_fragment_pool::size_class(size);
+    if (!cls) {
+        return new io_fragment(ss::temporary_buffer<char>(size), empty{});
+    }
+    auto* mem = static_cast<char*>(
+      io_fragment_pool::local().allocate_block(*cls, block::bytes(size)));
+    new (mem) block::prefix{
+      .size = static_cast<uint32_t>(size), .cls = static_cast<uint32_t>(*cls)};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    ss::deleter owner(new (mem + block::block_offset) block());
+    ss::temporary_buffer<char> buf(
+      mem + block::data_offset, size, owner.share()); // NOLINT
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return new (mem + block::fragment_offset)
+      io_fragment(std::move(buf), std::move(owner));
+}
+
+inline void io_fragment::dispose(io_fragment* f) noexcept {
+    auto& pool = io_fragment_pool::local();
+    if (!f->_block) {
+        pool.record_release(f->size(), f->capacity());
+        delete f; // NOLINT
+        return;
+    }
+    // the storage of the fragment is part of the block, which may only be
+    // released once the fragment is destroyed
+    auto owner = std::move(f->_block);
+    const auto* pre = reinterpret_cast<const block::prefix*>( // NOLINT
+      reinterpret_cast<const char*>(f) - block::fragment_offset);
+    pool.record_release(f->size(), pre->size);
+    pool.release_block_fragment();
+    f->~io_fragment();
+}
+
 } // namespace details
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/details/io_allocation_size.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+
+namespace details {
+
+/**
+ * Per shard free lists of the memory of iobuf fragments.
+ *
+ * Fragment objects wrapping a buffer of their own, e.g. one shared from
+ * another iobuf, are recycled through a free list of fragment sized slots.
+ * Fragments iobuf allocates for the size classes of io_allocation_size that
+ * fit seastar's small object pool are co-allocated with their buffer in one
+ * block. The block goes back to the free list of its size class once the
+ * fragment and every share of its buffer are gone. Larger classes are left
+ * to seastar's large allocator, which already works on spans.
+ *
+ * Only up to max_cached_bytes of blocks are kept per shard, the rest is
+ * returned to the allocator.
+ */
+class io_fragment_pool {
+public:
+    struct stats {
+        // live fragment objects
+        uint64_t fragments{0};
+        uint64_t fragment_allocations{0};
+        uint64_t fragment_reuses{0};
+        uint64_t block_allocations{0};
+        uint64_t block_reuses{0};
+        // bytes of the blocks in the free lists
+        uint64_t cached_bytes{0};
+        // bytes used and allocated by the fragments released so far
+        uint64_t released_used_bytes{0};
+        uint64_t released_capacity_bytes{0};
+    };
+
+    static constexpr size_t max_cached_bytes = 1024 * 1024;
+    static constexpr size_t max_cached_fragments = 4096;
+
+    static constexpr size_t pooled_classes() {
+        size_t n = 0;
+        for (auto size : io_allocation_size::alloc_table) {
+            if (size <= io_allocation_size::ss_max_small_allocation) {
+                ++n;
+            }
+        }
+        return n;
+    }
+    static constexpr size_t class_count = pooled_classes();
+
+    /// \brief pooled size class of buffers of exactly `size` bytes
+    static std::optional<size_t> size_class(size_t size) {
+        for (size_t i = 0; i < class_count; ++i) {
+            if (io_allocation_size::alloc_table[i] == size) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    io_fragment_pool() noexcept = default;
+    io_fragment_pool(const io_fragment_pool&) = delete;
+    io_fragment_pool& operator=(const io_fragment_pool&) = delete;
+    io_fragment_pool(io_fragment_pool&&) = delete;
+    io_fragment_pool& operator=(io_fragment_pool&&) = delete;
+    ~io_fragment_pool() noexcept;
+
+    static io_fragment_pool& local() {
+        static thread_local io_fragment_pool pool;
+        return pool;
+    }
+
+    void* allocate_fragment(size_t size) {
+        ++_stats.fragments;
+        if (_fragments) {
+            ++_stats.fragment_reuses;
+            --_fragment_count;
+            return pop(_fragments);
+        }
+        ++_stats.fragment_allocations;
+        return ::operator new(size);
+    }
+    void deallocate_fragment(void* p) noexcept {
+        --_stats.fragments;
+        if (_draining || _fragment_count >= max_cached_fragments) {
+            ::operator delete(p);
+            return;
+        }
+        ++_fragment_count;
+        push(_fragments, p);
+    }
+
+    /// \brief memory of `bytes` for a fragment of size class `cls`
+    void* allocate_block(size_t cls, size_t bytes) {
+        ++_stats.fragments;
+        if (_blocks[cls]) {
+            ++_stats.block_reuses;
+            _stats.cached_bytes -= bytes;
+            return pop(_blocks[cls]);
+        }
+        ++_stats.block_allocations;
+        return ::operator new(bytes);
+    }
+    /// \brief the fragment of a block is released, its buffer may live on
+    void release_block_fragment() noexcept { --_stats.fragments; }
+    /// \brief the last share of the buffer of a block is released
+    void deallocate_block(size_t cls, void* p, size_t bytes) noexcept {
+        if (_draining || _stats.cached_bytes + bytes > max_cached_bytes) {
+            ::operator delete(p);
+            return;
+        }
+        _stats.cached_bytes += bytes;
+        push(_blocks[cls], p);
+    }
+
+    void record_release(size_t used, size_t capacity) noexcept {
+        _stats.released_used_bytes += used;
+        _stats.released_capacity_bytes += capacity;
+    }
+
+    const stats& get_stats() const { return _stats; }
+
+private:
+    struct free_slot {
+        free_slot* next;
+    };
+
+    static void push(free_slot*& head, void* p) noexcept {
+        head = new (p) free_slot{head};
+    }
+    static void* pop(free_slot*& head) noexcept {
+        auto* slot = head;
+        head = slot->next;
+        return slot;
+    }
+
+    free_slot* _fragments{nullptr};
+    size_t _fragment_count{0};
+    std::array<free_slot*, class_count> _blocks{};
+    // memory released while the shard exits is not cached anymore
+    bool _draining{false};
+    stats _stats;
+};
+
+} // namespace details
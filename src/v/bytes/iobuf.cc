@@ -10,6 +10,7 @@
 #include "bytes/iobuf.h"
 
 #include "bytes/details/io_allocation_size.h"
+#include "bytes/details/io_fragment_pool.h"
 #include "vassert.h"
 
 #include <seastar/core/bitops.hh>
@@ -20,6 +21,19 @@
 #include <iostream>
 #include <limits>
 
+details::io_fragment_pool::~io_fragment_pool() noexcept {
+    _draining = true;
+    while (_fragments) {
+        ::operator delete(pop(_fragments));
+    }
+    for (auto& head : _blocks) {
+        while (head) {
+            ::operator delete(pop(head));
+        }
+    }
+    _stats.cached_bytes = 0;
+}
+
 std::ostream& operator<<(std::ostream& o, const iobuf& io) {
     return o << "{bytes=" << io.size_bytes()
              << ", fragments=" << std::distance(io.cbegin(), io.cend()) << "}";
@@ -181,6 +195,19 @@ iobuf iobuf::share(size_t pos, size_t len) {
     return ret;
 }
 
+iobuf iobuf::foreign_share(ss::deleter owner) const {
+    iobuf ret;
+    for (const auto& frag : _frags) {
+        // the bytes are immutable, fragments are never written once full
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        auto buf = ss::temporary_buffer<char>(
+          const_cast<char*>(frag.get()), frag.size(), owner.share());
+        ret.append_take_ownership(
+          new fragment(std::move(buf), fragment::full{}));
+    }
+    return ret;
+}
+
 bool iobuf::operator==(const iobuf& o) const {
     if (_size != o._size) {
         return false;
@@ -200,3 +227,60 @@ bool iobuf::operator==(const iobuf& o) const {
     }
     return true;
 }
+
+std::string_view iobuf::linearize() {
+    if (auto view = contiguous_view()) {
+        return *view;
+    }
+    oncore_debug_verify(_verify_shard);
+    auto f = new fragment(ss::temporary_buffer<char>(_size), fragment::empty{});
+    for (auto& frag : _frags) {
+        f->append(frag.get(), frag.size());
+    }
+    _frags.clear_and_dispose(&fragment::dispose);
+    _frags.push_back(*f);
+    return std::string_view(f->get(), f->size());
+}
+
+bool iobuf::compact(size_t min_fragment_size) {
+    oncore_debug_verify(_verify_shard);
+    bool moved = false;
+    auto it = _frags.begin();
+    while (it != _frags.end()) {
+        auto run_end = it;
+        size_t run_bytes = 0;
+        size_t run_length = 0;
+        while (run_end != _frags.end() && run_end->size() < min_fragment_size) {
+            run_bytes += run_end->size();
+            ++run_length;
+            ++run_end;
+        }
+        if (run_length < 2) {
+            it = run_length ? run_end : std::next(it);
+            continue;
+        }
+        // the run is copied into fragments inserted in front of its end
+        fragment* dst = nullptr;
+        while (it != run_end) {
+            std::string_view src(it->get(), it->size());
+            while (!src.empty()) {
+                if (!dst || dst->available_bytes() == 0) {
+                    dst = fragment::make_empty(
+                      details::io_allocation_size::next_allocation_size(
+                        run_bytes));
+                    _frags.insert(run_end, *dst);
+                }
+                const size_t sz = dst->append(src.data(), src.size());
+                src.remove_prefix(sz);
+                run_bytes -= sz;
+            }
+            it = _frags.erase_and_dispose(it, &fragment::dispose);
+        }
+        if (dst && run_end != _frags.end()) {
+            // only the last fragment keeps capacity for appends
+            dst->trim();
+        }
+        moved = true;
+    }
+    return moved;
+}
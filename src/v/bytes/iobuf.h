@@ -33,8 +33,10 @@
 
 #include <cstddef>
 #include <list>
+#include <optional>
 #include <ostream>
 #include <stdexcept>
+#include <string_view>
 #include <type_traits>
 
 /// our iobuf is a fragmented buffer. modeled after
@@ -114,6 +116,9 @@ public:
 
     /// shares the underlying temporary buffers
     iobuf share(size_t pos, size_t len);
+    /// shares the bytes with another shard. the fragments of the result are
+    /// kept alive by `owner` alone, the buffers of this one are not touched
+    iobuf foreign_share(ss::deleter owner) const;
 
     /**
      * Copying an iobuf is optimized for cases where the size of the resulting
@@ -131,6 +136,10 @@ public:
     /// as an empty details::io_fragment
     void reserve_memory(size_t reservation);
 
+    /// like reserve_memory but allocates exactly the reservation, for
+    /// writers which know the size of their output upfront
+    void reserve_exact_memory(size_t reservation);
+
     /// append src + len into storage
     void append(const char*, size_t);
     /// append src + len into storage
@@ -139,6 +148,9 @@ public:
     void append(ss::temporary_buffer<char>);
     /// appends the contents of buffer; might pack values into existing space
     void append(iobuf);
+    /// appends the fragments of the buffer by reference, data is never copied.
+    /// meant for large payloads shared from other buffers, e.g. batch cache
+    void append_fragments(iobuf);
     /// \brief trims the back, and appends direct.
     void append_take_ownership(fragment*);
     /// prepends the _the buffer_ as iobuf::details::io_fragment::full{}
@@ -159,6 +171,20 @@ public:
     bool operator==(const iobuf&) const;
     bool operator!=(const iobuf&) const;
 
+    /// \brief the data when it is held by at most one fragment, O(1)
+    std::optional<std::string_view> contiguous_view() const;
+    /// \brief moves the data into a single fragment unless it already is,
+    /// for consumers that need contiguous memory, e.g. compression codecs.
+    /// invalidates iterators and placeholders when data is moved
+    std::string_view linearize();
+    /// \brief merges runs of adjacent fragments smaller than
+    /// min_fragment_size into fragments of the allocation table sizes, e.g.
+    /// for buffers assembled from many small network reads. fragments of at
+    /// least min_fragment_size are kept as they are. returns true when data
+    /// was moved, which invalidates iterators and placeholders
+    bool compact(size_t min_fragment_size
+                 = details::io_allocation_size::default_chunk_size);
+
     iterator begin();
     iterator end();
     reverse_iterator rbegin();
@@ -183,9 +209,7 @@ private:
 };
 
 inline void iobuf::clear() {
-    _frags.clear_and_dispose([](fragment* f) {
-        delete f; // NOLINT
-    });
+    _frags.clear_and_dispose(&fragment::dispose);
     _size = 0;
 }
 inline iobuf::~iobuf() noexcept { clear(); }
@@ -201,6 +225,15 @@ inline iobuf::const_iterator iobuf::cend() const { return _frags.cend(); }
 inline bool iobuf::operator!=(const iobuf& o) const { return !(*this == o); }
 inline bool iobuf::empty() const { return _frags.empty(); }
 inline size_t iobuf::size_bytes() const { return _size; }
+inline std::optional<std::string_view> iobuf::contiguous_view() const {
+    if (_frags.empty()) {
+        return std::string_view();
+    }
+    if (&_frags.front() != &_frags.back()) {
+        return std::nullopt;
+    }
+    return std::string_view(_frags.front().get(), _frags.front().size());
+}
 
 inline size_t iobuf::available_bytes() const {
     oncore_debug_verify(_verify_shard);
@@ -232,8 +265,7 @@ inline void iobuf::create_new_fragment(size_t sz) {
     oncore_debug_verify(_verify_shard);
     auto chunk_max = std::max(sz, last_allocation_size());
     auto asz = details::io_allocation_size::next_allocation_size(chunk_max);
-    auto f = new fragment(ss::temporary_buffer<char>(asz), fragment::empty{});
-    append_take_ownership(f);
+    append_take_ownership(fragment::make_empty(asz));
 }
 inline iobuf::placeholder iobuf::reserve(size_t sz) {
     oncore_debug_verify(_verify_shard);
@@ -257,6 +289,16 @@ inline void iobuf::reserve_memory(size_t reservation) {
     }
 }
 
+inline void iobuf::reserve_exact_memory(size_t reservation) {
+    oncore_debug_verify(_verify_shard);
+    if (available_bytes() >= reservation) {
+        return;
+    }
+    auto f = new fragment(
+      ss::temporary_buffer<char>(reservation), fragment::empty{});
+    append_take_ownership(f);
+}
+
 [[gnu::always_inline]] void inline iobuf::prepend(
   ss::temporary_buffer<char> b) {
     if (unlikely(!b.size())) {
@@ -270,7 +312,7 @@ inline void iobuf::reserve_memory(size_t reservation) {
     while (!b._frags.empty()) {
         b._frags.pop_back_and_dispose([this](fragment* f) {
             prepend(f->share());
-            delete f; // NOLINT
+            fragment::dispose(f);
         });
     }
 }
@@ -334,24 +376,53 @@ inline void iobuf::append(iobuf o) {
     while (!o._frags.empty()) {
         o._frags.pop_front_and_dispose([this](fragment* f) {
             append(f->share());
-            delete f; // NOLINT
+            fragment::dispose(f);
         });
     }
 }
+/// appends the fragments of the buffer by reference, data is never copied
+inline void iobuf::append_fragments(iobuf o) {
+    oncore_debug_verify(_verify_shard);
+    if (o.empty()) {
+        return;
+    }
+    /*
+     * unused capacity of the current back fragment is moved behind the
+     * appended fragments. this way small writes that follow (e.g. headers)
+     * do not trigger allocations sized after a large shared fragment.
+     */
+    fragment* tail = nullptr;
+    if (available_bytes() > 0) {
+        if (_frags.back().is_empty()) {
+            tail = &_frags.back();
+            _frags.pop_back();
+        } else {
+            tail = new fragment(
+              _frags.back().split_available(), fragment::empty{});
+        }
+    }
+    while (!o._frags.empty()) {
+        auto& f = o._frags.front();
+        o._frags.pop_front();
+        o._size -= f.size();
+        f.trim();
+        _size += f.size();
+        _frags.push_back(f);
+    }
+    if (tail) {
+        _frags.push_back(*tail);
+    }
+}
 /// used for iostreams
 inline void iobuf::pop_front() {
     oncore_debug_verify(_verify_shard);
     _size -= _frags.front().size();
-    _frags.pop_front_and_dispose([](fragment* f) {
-        delete f; // NOLINT
-    });
+    _frags.pop_front_and_dispose(&fragment::dispose);
 }
 inline void iobuf::pop_back() {
     oncore_debug_verify(_verify_shard);
     _size -= _frags.back().size();
-    _frags.pop_back_and_dispose([](fragment* f) {
-        delete f; // NOLINT
-    });
+    _frags.pop_back_and_dispose(&fragment::dispose);
 }
 inline void iobuf::trim_front(size_t n) {
     oncore_debug_verify(_verify_shard);
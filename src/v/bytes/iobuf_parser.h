@@ -45,6 +45,10 @@ public:
 
     size_t bytes_consumed() const { return _in.bytes_consumed(); }
 
+    // contiguous bytes left in the current fragment of the buffer
+    const char* segment_data() const { return _in.segment_data(); }
+    size_t segment_bytes_left() const { return _in.segment_bytes_left(); }
+
     std::pair<int64_t, uint8_t> read_varlong() {
         auto [val, length_size] = vint::deserialize(_in);
         _in.skip(length_size);
@@ -71,6 +75,9 @@ public:
         return _in.consume_type<T>();
     }
 
+    /// copies the next n bytes to out, throws if fewer are left
+    void consume_to(size_t n, char* out) { _in.consume_to(n, out); }
+
     template<typename T>
     T consume_be_type() {
         return _in.consume_be_type<T>();
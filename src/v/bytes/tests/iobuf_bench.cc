@@ -0,0 +1,60 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/details/io_fragment.h"
+#include "bytes/iobuf.h"
+
+#include <seastar/core/temporary_buffer.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+
+// small buffers built and dropped per message, e.g. rpc headers
+static constexpr size_t buffers = 1000;
+static constexpr std::array<char, 100> payload{};
+
+PERF_TEST(iobuf, small_buffer_churn) {
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < buffers; ++i) {
+        iobuf buf;
+        buf.append(payload.data(), payload.size());
+        perf_tests::do_not_optimize(buf);
+    }
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(iobuf, small_buffer_share_churn) {
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < buffers; ++i) {
+        iobuf buf;
+        buf.append(payload.data(), payload.size());
+        auto shared = buf.share(0, buf.size_bytes());
+        perf_tests::do_not_optimize(shared);
+    }
+    perf_tests::stop_measuring_time();
+}
+
+// the allocations of a fragment before pooling, the fragment object and its
+// buffer are allocated separately from the heap
+PERF_TEST(iobuf, unpooled_fragment_churn) {
+    const auto size = details::io_allocation_size::next_allocation_size(
+      details::io_allocation_size::default_chunk_size);
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < buffers; ++i) {
+        using header_t = std::array<char, sizeof(iobuf::fragment)>;
+        auto header = std::make_unique<header_t>();
+        ss::temporary_buffer<char> buf(size);
+        std::copy_n(payload.data(), payload.size(), buf.get_write());
+        perf_tests::do_not_optimize(header);
+        perf_tests::do_not_optimize(buf);
+    }
+    perf_tests::stop_measuring_time();
+}
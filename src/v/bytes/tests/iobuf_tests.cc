@@ -9,6 +9,7 @@
 
 #include "bytes/bytes.h"
 #include "bytes/details/io_allocation_size.h"
+#include "bytes/details/io_fragment_pool.h"
 #include "bytes/iobuf.h"
 #include "bytes/iobuf_ostreambuf.h"
 #include "bytes/tests/utils.h"
@@ -403,6 +404,35 @@ SEASTAR_THREAD_TEST_CASE(test_next_chunk_allocation_append_iobuf) {
     BOOST_REQUIRE_EQUAL(msg.size(), sz);
 }
 
+SEASTAR_THREAD_TEST_CASE(test_append_fragments_shares_data) {
+    const auto payload = random_generators::gen_alphanum_string(16384);
+    iobuf source;
+    source.append(payload.data(), payload.size());
+    auto shared = source.share(0, source.size_bytes());
+
+    iobuf buf;
+    buf.append("header", 6);
+    buf.append_fragments(std::move(shared));
+    buf.append("trailer", 7);
+
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), 6 + payload.size() + 7);
+    // the payload fragment points to the memory of the source buffer
+    auto it = std::next(buf.begin());
+    BOOST_REQUIRE_EQUAL(it->get(), source.begin()->get());
+    BOOST_REQUIRE_EQUAL(it->size(), payload.size());
+    // trailer reuses the spare capacity of the header fragment
+    BOOST_REQUIRE_EQUAL(std::distance(buf.begin(), buf.end()), 3);
+    const auto first_chunk = details::io_allocation_size::next_allocation_size(
+      details::io_allocation_size::default_chunk_size);
+    BOOST_REQUIRE_EQUAL(std::prev(buf.end())->capacity(), first_chunk - 6);
+
+    iobuf expected;
+    expected.append("header", 6);
+    expected.append(payload.data(), payload.size());
+    expected.append("trailer", 7);
+    BOOST_REQUIRE_EQUAL(buf, expected);
+}
+
 /*
  * testing various trim_front scenarios
  *
@@ -492,3 +522,99 @@ SEASTAR_THREAD_TEST_CASE(trim_front) {
         BOOST_TEST(buf.size_bytes() == 99);
     }
 }
+
+SEASTAR_THREAD_TEST_CASE(fragments_are_recycled) {
+    auto& pool = details::io_fragment_pool::local();
+    const auto payload = random_generators::gen_alphanum_string(100);
+    {
+        iobuf buf;
+        buf.append(payload.data(), payload.size());
+    }
+    const auto before = pool.get_stats();
+    {
+        iobuf buf;
+        buf.append(payload.data(), payload.size());
+        BOOST_REQUIRE_EQUAL(pool.get_stats().fragments, before.fragments + 1);
+    }
+    // the block released by the first buffer is reused
+    const auto& after = pool.get_stats();
+    BOOST_REQUIRE_EQUAL(after.block_reuses, before.block_reuses + 1);
+    BOOST_REQUIRE_EQUAL(after.block_allocations, before.block_allocations);
+    BOOST_REQUIRE_EQUAL(after.fragments, before.fragments);
+    BOOST_REQUIRE_EQUAL(
+      after.released_used_bytes, before.released_used_bytes + payload.size());
+}
+
+SEASTAR_THREAD_TEST_CASE(shares_keep_coallocated_buffers_alive) {
+    auto& pool = details::io_fragment_pool::local();
+    const auto payload = random_generators::gen_alphanum_string(100);
+    const auto fragments = pool.get_stats().fragments;
+    iobuf shared;
+    {
+        iobuf buf;
+        buf.append(payload.data(), payload.size());
+        shared = buf.share(0, buf.size_bytes());
+    }
+    // only the fragment of the share is left, the block lives on with it
+    BOOST_REQUIRE_EQUAL(pool.get_stats().fragments, fragments + 1);
+    iobuf expected;
+    expected.append(ss::temporary_buffer<char>(payload.data(), payload.size()));
+    BOOST_REQUIRE_EQUAL(shared, expected);
+    shared.clear();
+    BOOST_REQUIRE_EQUAL(pool.get_stats().fragments, fragments);
+}
+
+// a buffer of fragments of `fragment_size` bytes each
+static iobuf fragmented_iobuf(const ss::sstring& data, size_t fragment_size) {
+    iobuf buf;
+    for (size_t end = data.size(); end > 0;) {
+        const size_t begin = end > fragment_size ? end - fragment_size : 0;
+        buf.prepend(
+          ss::temporary_buffer<char>(data.data() + begin, end - begin));
+        end = begin;
+    }
+    return buf;
+}
+
+SEASTAR_THREAD_TEST_CASE(compact_merges_small_fragments) {
+    const auto data = random_generators::gen_alphanum_string(2000);
+    auto buf = fragmented_iobuf(data, 10);
+    BOOST_REQUIRE_EQUAL(std::distance(buf.begin(), buf.end()), 200);
+    BOOST_REQUIRE(buf.compact());
+    BOOST_REQUIRE_LE(std::distance(buf.begin(), buf.end()), 2);
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), data.size());
+    iobuf expected;
+    expected.append(data.data(), data.size());
+    BOOST_REQUIRE_EQUAL(buf, expected);
+    BOOST_REQUIRE(!buf.compact());
+}
+
+SEASTAR_THREAD_TEST_CASE(compact_keeps_large_fragments) {
+    const auto data = random_generators::gen_alphanum_string(100);
+    iobuf buf;
+    buf.prepend(ss::temporary_buffer<char>(data.data(), 10));
+    buf.prepend(ss::temporary_buffer<char>(4096));
+    buf.prepend(ss::temporary_buffer<char>(data.data(), 10));
+    BOOST_REQUIRE(!buf.compact());
+    BOOST_REQUIRE_EQUAL(std::distance(buf.begin(), buf.end()), 3);
+
+    // the small fragments on both sides of the large one are merged
+    auto small = fragmented_iobuf(data, 10);
+    buf.prepend(small.share(0, small.size_bytes()));
+    buf.append_fragments(std::move(small));
+    BOOST_REQUIRE(buf.compact());
+    BOOST_REQUIRE_EQUAL(std::distance(buf.begin(), buf.end()), 3);
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), 4096 + 2 * data.size() + 20);
+}
+
+SEASTAR_THREAD_TEST_CASE(linearize_fragmented_buffer) {
+    const auto data = random_generators::gen_alphanum_string(1000);
+    auto buf = fragmented_iobuf(data, 7);
+    BOOST_REQUIRE(!buf.contiguous_view());
+    const auto view = buf.linearize();
+    BOOST_REQUIRE_EQUAL(view, std::string_view(data));
+    BOOST_REQUIRE_EQUAL(std::distance(buf.begin(), buf.end()), 1);
+    BOOST_REQUIRE(buf.contiguous_view());
+    BOOST_REQUIRE_EQUAL(buf.contiguous_view()->data(), view.data());
+    BOOST_REQUIRE(iobuf().contiguous_view());
+}
@@ -14,10 +14,8 @@
 #include "hashing/crc32c.h"
 
 inline void crc_extend_iobuf(crc32& crc, const iobuf& buf) {
-    auto in = iobuf::iterator_consumer(buf.cbegin(), buf.cend());
-    (void)in.consume(buf.size_bytes(), [&crc](const char* src, size_t sz) {
-        // NOLINTNEXTLINE
-        crc.extend(reinterpret_cast<const uint8_t*>(src), sz);
-        return ss::stop_iteration::no;
-    });
+    // whole fragments at a time; the consumer's bookkeeping is not needed
+    for (const auto& f : buf) {
+        crc.extend(f.get(), f.size());
+    }
 }
@@ -17,6 +17,7 @@
 #include "model/record.h"
 #include "reflection/adl.h"
 #include "reflection/async_adl.h"
+#include "security/scram_credential.h"
 #include "utils/named_type.h"
 
 #include <seastar/core/do_with.hh>
@@ -30,6 +31,8 @@ namespace cluster {
 // filter the batches out
 static constexpr model::record_batch_type topic_batch_type
   = model::record_batch_type(6);
+static constexpr model::record_batch_type user_batch_type
+  = model::record_batch_type(8);
 
 using command_type = named_type<int8_t, struct command_type_tag>;
 // Controller state updates are represented in terms of commands. Each
@@ -80,6 +83,22 @@ using move_partition_replicas_cmd = controller_command<
   move_partition_replicas_cmd_type,
   topic_batch_type()>;
 
+// user commands
+static constexpr int8_t create_user_cmd_type = 0;
+static constexpr int8_t delete_user_cmd_type = 1;
+
+using create_user_cmd = controller_command<
+  security::credential_user,
+  security::scram_credential,
+  create_user_cmd_type,
+  user_batch_type()>;
+
+using delete_user_cmd = controller_command<
+  security::credential_user,
+  security::credential_user,
+  delete_user_cmd_type,
+  user_batch_type()>;
+
 // typelist utils
 // clang-format off
 CONCEPT(
@@ -15,9 +15,12 @@
 #include "cluster/raft0_utils.h"
 #include "cluster/topics_frontend.h"
 #include "cluster/types.h"
+#include "config/configuration.h"
 #include "model/metadata.h"
 #include "model/timeout_clock.h"
+#include "prometheus/prometheus_sanitize.h"
 
+#include <seastar/core/metrics.hh>
 #include <seastar/core/thread.hh>
 
 namespace cluster {
@@ -31,7 +34,8 @@ controller::controller(
   , _partition_manager(pm)
   , _shard_table(st)
   , _storage(storage)
-  , _tp_updates_dispatcher(_partition_allocator, _tp_state) {}
+  , _tp_updates_dispatcher(_partition_allocator, _tp_state)
+  , _security_manager(_credentials) {}
 
 ss::future<> controller::wire_up() {
     return _as.start()
@@ -39,7 +43,8 @@ ss::future<> controller::wire_up() {
       .then([this] { return _partition_leaders.start(); })
       .then(
         [this] { return _partition_allocator.start_single(raft::group_id(0)); })
-      .then([this] { return _tp_state.start(); });
+      .then([this] { return _tp_state.start(); })
+      .then([this] { return _credentials.start(); });
 }
 
 ss::future<> controller::start() {
@@ -61,6 +66,7 @@ ss::future<> controller::start() {
             std::ref(_connections),
             std::ref(_partition_allocator),
             std::ref(_storage),
+            std::ref(_stm),
             std::ref(_as));
       })
       .then([this] {
@@ -68,7 +74,14 @@ ss::future<> controller::start() {
             std::ref(clusterlog),
             _raft0.get(),
             raft::persistent_last_applied::yes,
-            std::ref(_tp_updates_dispatcher));
+            std::ref(_tp_updates_dispatcher),
+            std::ref(_security_manager));
+      })
+      .then([this] {
+          return _stm.invoke_on(controller_stm_shard, [](controller_stm& stm) {
+              stm.set_snapshot_interval(
+                config::shard_local_cfg().controller_snapshot_batches());
+          });
       })
       .then([this] {
           return _backend.start(
@@ -88,6 +101,9 @@ ss::future<> controller::start() {
             std::ref(_partition_leaders),
             std::ref(_as));
       })
+      .then([this] {
+          return _security_frontend.start(std::ref(_stm), std::ref(_as));
+      })
       .then([this] {
           return _stm.invoke_on(controller_stm_shard, &controller_stm::start);
       })
@@ -102,16 +118,91 @@ ss::future<> controller::start() {
               return stm.wait(stm.bootstrap_last_applied(), model::no_timeout);
           });
       })
+      .then([this] { setup_metrics(); })
+      .then([this] {
+          return _shard_mover.start_single(
+            _raft0->self(),
+            std::ref(_tp_state),
+            std::ref(_shard_table),
+            std::ref(_partition_manager),
+            std::ref(_backend),
+            std::ref(_storage));
+      })
+      .then([this] {
+          // partitions moved between shards are created where they were
+          // moved to
+          return _shard_mover.invoke_on(
+            shard_mover::shard, &shard_mover::start);
+      })
       .then(
-        [this] { return _backend.invoke_on_all(&controller_backend::start); });
+        [this] { return _backend.invoke_on_all(&controller_backend::start); })
+      .then([this] {
+          return _leader_balancer.start_single(
+            _raft0->self(),
+            std::ref(_partition_leaders),
+            std::ref(_members_table),
+            std::ref(_shard_table),
+            std::ref(_partition_manager),
+            std::ref(_shard_mover),
+            std::ref(_as));
+      })
+      .then([this] {
+          return _leader_balancer.invoke_on(
+            leader_balancer::shard, &leader_balancer::start);
+      })
+      .then([this] {
+          return _load_reporter.start_single(
+            _raft0->self(),
+            std::ref(_partition_manager),
+            std::ref(_members_table),
+            std::ref(_members_manager),
+            std::ref(_connections));
+      })
+      .then([this] {
+          return _load_reporter.invoke_on(
+            node_load_reporter::shard, &node_load_reporter::start);
+      });
+}
+void controller::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    auto stats = [this] { return _stm.local().get_snapshot_stats(); };
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("cluster:controller"),
+      {sm::make_derive(
+         "snapshots_written",
+         [stats] { return stats().written; },
+         sm::description("Number of controller snapshots written")),
+       sm::make_gauge(
+         "snapshot_size_bytes",
+         [stats] { return stats().written_bytes; },
+         sm::description("Size of the last controller snapshot written")),
+       sm::make_derive(
+         "snapshots_loaded",
+         [stats] { return stats().loaded; },
+         sm::description("Number of controller snapshots loaded")),
+       sm::make_gauge(
+         "snapshot_load_ms",
+         [stats] { return stats().load_time.count(); },
+         sm::description(
+           "Milliseconds it took to load the last controller snapshot"))});
 }
+
 ss::future<> controller::stop() {
+    _metrics.clear();
     return _as.invoke_on_all(&ss::abort_source::request_abort)
+      .then([this] { return _load_reporter.stop(); })
+      .then([this] { return _leader_balancer.stop(); })
+      .then([this] { return _shard_mover.stop(); })
       .then([this] { return _stm.stop(); })
       .then([this] { return _members_manager.stop(); })
       .then([this] { return _tp_frontend.stop(); })
+      .then([this] { return _security_frontend.stop(); })
       .then([this] { return _backend.stop(); })
       .then([this] { return _tp_state.stop(); })
+      .then([this] { return _credentials.stop(); })
       .then([this] { return _partition_allocator.stop(); })
       .then([this] { return _partition_leaders.stop(); })
       .then([this] { return _members_table.stop(); })
@@ -14,19 +14,26 @@
 #include "cluster/controller_backend.h"
 #include "cluster/controller_service.h"
 #include "cluster/controller_stm.h"
+#include "cluster/leader_balancer.h"
 #include "cluster/members_manager.h"
 #include "cluster/metadata_dissemination_service.h"
+#include "cluster/node_load_reporter.h"
 #include "cluster/partition_leaders_table.h"
 #include "cluster/partition_manager.h"
+#include "cluster/security_frontend.h"
+#include "cluster/security_manager.h"
+#include "cluster/shard_mover.h"
 #include "cluster/shard_table.h"
 #include "cluster/topic_table.h"
 #include "cluster/topic_updates_dispatcher.h"
 #include "cluster/topics_frontend.h"
 #include "cluster/types.h"
 #include "rpc/connection_cache.h"
+#include "security/credential_store.h"
 #include "storage/api.h"
 
 #include <seastar/core/abort_source.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/sharded.hh>
 
 #include <vector>
@@ -50,6 +57,12 @@ public:
     ss::sharded<partition_leaders_table>& get_partition_leaders() {
         return _partition_leaders;
     }
+    ss::sharded<security_frontend>& get_security_frontend() {
+        return _security_frontend;
+    }
+    ss::sharded<security::credential_store>& get_credential_store() {
+        return _credentials;
+    }
 
     ss::future<> wire_up();
 
@@ -57,23 +70,34 @@ public:
     ss::future<> stop();
 
 private:
+    void setup_metrics();
+
     ss::sharded<ss::abort_source> _as;                     // instance per core
     ss::sharded<partition_allocator> _partition_allocator; // single instance
     ss::sharded<topic_table> _tp_state;                    // instance per core
     ss::sharded<members_table> _members_table;             // instance per core
     ss::sharded<partition_leaders_table>
-      _partition_leaders;                          // instance per core
-    ss::sharded<members_manager> _members_manager; // single instance
-    ss::sharded<topics_frontend> _tp_frontend;     // instance per core
-    ss::sharded<controller_backend> _backend;      // instance per core
-    ss::sharded<controller_stm> _stm;              // single instance
-    ss::sharded<controller_service> _service;      // instance per core
+      _partition_leaders;                           // instance per core
+    ss::sharded<security::credential_store>
+      _credentials;                                 // instance per core
+    ss::sharded<members_manager> _members_manager;  // single instance
+    ss::sharded<topics_frontend> _tp_frontend;      // instance per core
+    ss::sharded<security_frontend>
+      _security_frontend;                           // instance per core
+    ss::sharded<controller_backend> _backend;       // instance per core
+    ss::sharded<controller_stm> _stm;               // single instance
+    ss::sharded<controller_service> _service;       // instance per core
+    ss::sharded<shard_mover> _shard_mover;          // single instance
+    ss::sharded<leader_balancer> _leader_balancer;  // single instance
+    ss::sharded<node_load_reporter> _load_reporter; // single instance
     ss::sharded<rpc::connection_cache>& _connections;
     ss::sharded<partition_manager>& _partition_manager;
     ss::sharded<shard_table>& _shard_table;
     ss::sharded<storage::api>& _storage;
     topic_updates_dispatcher _tp_updates_dispatcher;
+    security_manager _security_manager;
     consensus_ptr _raft0;
+    ss::metrics::metric_groups _metrics;
 };
 
 } // namespace cluster
\ No newline at end of file
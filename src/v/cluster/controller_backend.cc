@@ -31,6 +31,7 @@
 #include <seastar/core/sharded.hh>
 #include <seastar/core/smp.hh>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 
 /// Class that contains the controller state, for now we will have single
@@ -106,13 +107,54 @@ void controller_backend::housekeeping() {
 
 // caller must hold _topics_sem lock
 ss::future<> controller_backend::reconcile_topics() {
-    using meta_t = task_meta<topic_table::delta>;
-    // _topic_deltas are chronologically ordered, we cannot reorder applying
-    // them, hence we have to use `ss::do_for_each`
-    return ss::do_for_each(
-             std::begin(_topic_deltas),
-             std::end(_topic_deltas),
-             [this](meta_t& task) { return do_reconcile_topic(task); })
+    // _topic_deltas are chronologically ordered, the changes of a partition
+    // have to be applied in that order. Different partitions do not depend
+    // on each other, they are reconciled concurrently
+    absl::flat_hash_map<model::ntp, size_t> ntp_idx;
+    std::vector<std::vector<partition_op>> ops;
+    auto add = [&ntp_idx, &ops](
+                 meta_t& task,
+                 partition_op::op_type type,
+                 const topic_table::delta::partition& p) {
+        model::ntp ntp(p.first.ns, p.first.tp, p.second.id);
+        auto [it, inserted] = ntp_idx.emplace(std::move(ntp), ops.size());
+        if (inserted) {
+            ops.emplace_back();
+        }
+        ops[it->second].push_back(
+          partition_op{.task = &task, .type = type, .partition = &p});
+    };
+    for (auto& task : _topic_deltas) {
+        // cleared by the first failing change of the delta
+        task.finished = true;
+        for (auto& p : task.delta.partitions.additions) {
+            add(task, partition_op::op_type::addition, p);
+        }
+        for (auto& p : task.delta.partitions.deletions) {
+            add(task, partition_op::op_type::deletion, p);
+        }
+        for (auto& p : task.delta.partitions.updates) {
+            add(task, partition_op::op_type::update, p);
+        }
+    }
+    const auto concurrency = std::max<size_t>(
+      1,
+      config::shard_local_cfg()
+        .controller_backend_reconciliation_concurrency());
+    return ss::do_with(
+             std::move(ops),
+             ss::semaphore(concurrency),
+             [this](
+               std::vector<std::vector<partition_op>>& ops,
+               ss::semaphore& sem) {
+                 return ss::parallel_for_each(
+                   ops, [this, &sem](std::vector<partition_op>& ntp_ops) {
+                       return ss::with_semaphore(sem, 1, [this, &ntp_ops] {
+                           return reconcile_ntp(ntp_ops);
+                       });
+                   });
+             })
+      .finally([this] { return flush_shard_table_updates(); })
       .then([this] {
           // remove finished tasks
           auto it = std::stable_partition(
@@ -123,13 +165,40 @@ ss::future<> controller_backend::reconcile_topics() {
       });
 }
 
+ss::future<>
+controller_backend::reconcile_ntp(std::vector<partition_op>& ops) {
+    return ss::do_for_each(ops, [this](partition_op& op) {
+        // only mark task as finished if all operations are successfull
+        return ss::futurize_invoke([this, &op] { return execute(op); })
+          .then_wrapped([&op](ss::future<std::error_code> f) {
+              try {
+                  if (f.get0()) {
+                      op.task->finished = false;
+                  }
+              } catch (...) {
+                  op.task->finished = false;
+                  vlog(
+                    clusterlog.error,
+                    "Error while reconciling partition {}/{} - {}",
+                    op.partition->first,
+                    op.partition->second.id,
+                    std::current_exception());
+              }
+          });
+    });
+}
+
 bool has_local_replicas(
-  model::node_id self, const std::vector<model::broker_shard>& replicas) {
+  model::node_id self,
+  const std::vector<model::broker_shard>& replicas,
+  std::optional<ss::shard_id> placement) {
+    // a partition moved to another shard of this node stays there
     return std::find_if(
              std::cbegin(replicas),
              std::cend(replicas),
-             [self](const model::broker_shard& bs) {
-                 return bs.node_id == self && bs.shard == ss::this_shard_id();
+             [self, placement](const model::broker_shard& bs) {
+                 return bs.node_id == self
+                        && placement.value_or(bs.shard) == ss::this_shard_id();
              })
            != replicas.cend();
 }
@@ -154,68 +223,31 @@ std::vector<model::broker> create_brokers_set(
     return brokers;
 }
 
-controller_backend::results_t join_results(
-  controller_backend::results_t prev_results,
-  controller_backend::results_t new_results) {
-    std::move(
-      new_results.begin(), new_results.end(), std::back_inserter(prev_results));
-    return prev_results;
-}
-
-ss::future<>
-controller_backend::do_reconcile_topic(task_meta<topic_table::delta>& task) {
-    // new partitions
-    auto f = ssx::parallel_transform(
-      task.delta.partitions.additions,
-      [this, o = task.delta.offset](topic_table::delta::partition p) {
-          // only create partitions for this backend
-          // partitions created on current shard at this node
-          if (!has_local_replicas(_self, p.second.replicas)) {
-              return ss::make_ready_future<std::error_code>(errc::success);
-          }
-          return create_partition(
-            model::ntp(p.first.ns, p.first.tp, p.second.id),
-            p.second.group,
-            o,
-            create_brokers_set(p.second.replicas, _members_table.local()));
-      });
-
-    // delete partitions
-    f = f.then([this, &task](results_t results) {
-        return ssx::parallel_transform(
-                 task.delta.partitions.deletions,
-                 [this](const topic_table::delta::partition& p) {
-                     return delete_partition(
-                       model::ntp(p.first.ns, p.first.tp, p.second.id));
-                 })
-          .then([results = std::move(results)](results_t new_results) mutable {
-              return join_results(std::move(results), std::move(new_results));
-          });
-    });
-
-    // partition updates
-    f = f.then([this, &task](results_t results) {
-        return ssx::parallel_transform(
-                 task.delta.partitions.updates,
-                 [this, o = task.delta.offset](
-                   const topic_table::delta::partition& p) {
-                     return process_partition_update(p, o);
-                 })
-          .then([results = std::move(results)](results_t new_res) mutable {
-              return join_results(std::move(results), std::move(new_res));
-          });
-    });
-
-    return f.then([&task](results_t all_results) {
-        auto success = std::all_of(
-          std::cbegin(all_results),
-          std::cend(all_results),
-          [](std::error_code ec) { return !ec; });
-        // only mark task as finished if all operations are successfull
-        if (success) {
-            task.finished = true;
+ss::future<std::error_code>
+controller_backend::execute(const partition_op& op) {
+    const auto& p = *op.partition;
+    model::ntp ntp(p.first.ns, p.first.tp, p.second.id);
+    switch (op.type) {
+    case partition_op::op_type::addition:
+        // only create partitions for this backend
+        // partitions created on current shard at this node
+        if (!has_local_replicas(
+              _self,
+              p.second.replicas,
+              _shard_table.local().placement(p.second.group))) {
+            return ss::make_ready_future<std::error_code>(errc::success);
         }
-    });
+        return create_partition(
+          std::move(ntp),
+          p.second.group,
+          op.task->delta.offset,
+          create_brokers_set(p.second.replicas, _members_table.local()));
+    case partition_op::op_type::deletion:
+        return delete_partition(std::move(ntp));
+    case partition_op::op_type::update:
+        return process_partition_update(p, op.task->delta.offset);
+    }
+    __builtin_unreachable();
 }
 
 ss::future<std::error_code> controller_backend::process_partition_update(
@@ -225,7 +257,10 @@ ss::future<std::error_code> controller_backend::process_partition_update(
     // partition with requested ntp exists on this broker core
     // it has to be removed after new configuration is stable
     auto partition = _partition_manager.local().get(ntp);
-    if (!has_local_replicas(_self, p.second.replicas)) {
+    if (!has_local_replicas(
+          _self,
+          p.second.replicas,
+          _shard_table.local().placement(p.second.group))) {
         // we do not have local replicas and partition does not
         // exists, it is ok
         if (!partition) {
@@ -302,13 +337,17 @@ ss::future<std::error_code> controller_backend::update_partition_replica_set(
     return ss::make_ready_future<std::error_code>(errc::success);
 }
 
-ss::future<> controller_backend::add_to_shard_table(
-  model::ntp ntp, raft::group_id raft_group, uint32_t shard) {
-    // update shard_table: broadcast
+ss::future<> controller_backend::flush_shard_table_updates() {
+    if (_shard_table_updates.empty()) {
+        return ss::now();
+    }
+    // update shard_table: one broadcast for all the partitions of the round
     return _shard_table.invoke_on_all(
-      [ntp = std::move(ntp), raft_group, shard](shard_table& s) mutable {
-          s.insert(std::move(ntp), shard);
-          s.insert(raft_group, shard);
+      [updates = std::exchange(_shard_table_updates, {}),
+       shard = ss::this_shard_id()](shard_table& s) {
+          for (auto& [ntp, group] : updates) {
+              s.insert(ntp, group, shard);
+          }
       });
 }
 
@@ -338,13 +377,12 @@ ss::future<std::error_code> controller_backend::create_partition(
               .discard_result();
     }
 
-    return f
-      .then([this, ntp = std::move(ntp), group_id]() mutable {
-          // we create only partitions that belongs to current shard
-          return add_to_shard_table(
-            std::move(ntp), group_id, ss::this_shard_id());
-      })
-      .then([] { return make_error_code(errc::success); });
+    return f.then([this, ntp = std::move(ntp), group_id]() mutable {
+        // we create only partitions that belongs to current shard, they are
+        // added to the shard tables at the end of the reconciliation round
+        _shard_table_updates.emplace_back(std::move(ntp), group_id);
+        return make_error_code(errc::success);
+    });
 }
 
 ss::future<std::error_code>
@@ -354,6 +392,15 @@ controller_backend::delete_partition(model::ntp ntp) {
         return ss::make_ready_future<std::error_code>(errc::success);
     }
     auto group_id = part->group();
+    // created in this round, not yet in the shard tables
+    _shard_table_updates.erase(
+      std::remove_if(
+        _shard_table_updates.begin(),
+        _shard_table_updates.end(),
+        [&ntp](const std::pair<model::ntp, raft::group_id>& u) {
+            return u.first == ntp;
+        }),
+      _shard_table_updates.end());
 
     return _shard_table
       .invoke_on_all(
@@ -20,6 +20,7 @@
 #include "outcome.h"
 
 #include <seastar/core/gate.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sharded.hh>
 
 namespace cluster {
@@ -28,7 +29,6 @@ namespace cluster {
 
 class controller_backend {
 public:
-    using results_t = std::vector<std::error_code>;
     controller_backend(
       ss::sharded<cluster::topic_table>&,
       ss::sharded<shard_table>&,
@@ -40,6 +40,12 @@ public:
     ss::future<> stop();
     ss::future<> start();
 
+    /// Runs `f` while the partitions of this shard are not reconciled
+    template<typename Func>
+    auto with_reconciliation_paused(Func&& f) {
+        return ss::with_semaphore(_topics_sem, 1, std::forward<Func>(f));
+    }
+
 private:
     template<typename T>
     struct task_meta {
@@ -50,13 +56,24 @@ private:
         T delta;
     };
 
+    using meta_t = task_meta<topic_table::delta>;
+
+    // change of a single partition carried by a delta
+    struct partition_op {
+        enum class op_type { addition, deletion, update };
+        meta_t* task;
+        op_type type;
+        const topic_table::delta::partition* partition;
+    };
+
     // Topics
     void start_topics_reconciliation_loop();
     ss::future<> reconcile_topics();
-    ss::future<> do_reconcile_topic(task_meta<topic_table::delta>&);
+    ss::future<> reconcile_ntp(std::vector<partition_op>&);
+    ss::future<std::error_code> execute(const partition_op&);
     ss::future<std::error_code> create_partition(
       model::ntp, raft::group_id, model::offset, std::vector<model::broker>);
-    ss::future<> add_to_shard_table(model::ntp, raft::group_id, ss::shard_id);
+    ss::future<> flush_shard_table_updates();
     ss::future<std::error_code> process_partition_update(
       const topic_table::delta::partition&, model::offset);
 
@@ -75,6 +92,8 @@ private:
     ss::sstring _data_directory;
     ss::sharded<ss::abort_source>& _as;
     std::vector<task_meta<topic_table::delta>> _topic_deltas;
+    // partitions created during the reconciliation round
+    std::vector<std::pair<model::ntp, raft::group_id>> _shard_table_updates;
     ss::timer<> _housekeeping_timer;
     ss::semaphore _topics_sem{1};
     ss::gate _gate;
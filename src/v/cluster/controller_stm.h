@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "cluster/security_manager.h"
 #include "cluster/topic_table.h"
 #include "cluster/topic_updates_dispatcher.h"
 #include "raft/mux_state_machine.h"
@@ -18,7 +19,8 @@
 namespace cluster {
 
 // single instance
-using controller_stm = raft::mux_state_machine<topic_updates_dispatcher>;
+using controller_stm
+  = raft::mux_state_machine<topic_updates_dispatcher, security_manager>;
 
 static constexpr ss::shard_id controller_stm_shard = 0;
 
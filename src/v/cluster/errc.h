@@ -32,7 +32,15 @@ enum class errc {
     topic_not_exists,
     invalid_topic_name,
     partition_not_exists,
-    not_leader
+    not_leader,
+    invalid_shard,
+    partition_move_failed,
+    sequence_out_of_order,
+    duplicate_sequence,
+    invalid_producer_epoch,
+    unknown_producer_id,
+    user_exists,
+    user_does_not_exist,
 };
 struct errc_category final : public std::error_category {
     const char* name() const noexcept final { return "cluster::errc"; }
@@ -79,6 +87,23 @@ struct errc_category final : public std::error_category {
             return "Invalid topic name";
         case errc::partition_not_exists:
             return "Requested partition does not exists";
+        case errc::invalid_shard:
+            return "Requested shard does not exists on this node";
+        case errc::partition_move_failed:
+            return "Partition could not be moved to the requested shard";
+        case errc::sequence_out_of_order:
+            return "Batch sequence does not follow the last batch of the "
+                   "producer";
+        case errc::duplicate_sequence:
+            return "Batch of the producer is already being replicated";
+        case errc::invalid_producer_epoch:
+            return "Producer epoch is older than the current one";
+        case errc::unknown_producer_id:
+            return "Partition does not know the producer";
+        case errc::user_exists:
+            return "User already exists";
+        case errc::user_does_not_exist:
+            return "User does not exist";
         default:
             return "cluster::errc::unknown";
         }
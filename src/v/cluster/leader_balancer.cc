@@ -0,0 +1,409 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/leader_balancer.h"
+
+#include "cluster/logger.h"
+#include "cluster/namespace.h"
+#include "cluster/partition.h"
+#include "config/configuration.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <absl/container/flat_hash_set.h>
+
+#include <algorithm>
+
+namespace cluster {
+
+std::vector<leadership_transfer> plan_leadership_transfers(
+  model::node_id self,
+  absl::flat_hash_map<model::node_id, size_t> leader_counts,
+  std::vector<local_leader> leaders,
+  size_t shards,
+  size_t imbalance_percent,
+  size_t max_transfers) {
+    std::vector<leadership_transfer> ret;
+    if (leader_counts.empty() || leaders.empty() || shards == 0) {
+        return ret;
+    }
+    size_t total_leaders = 0;
+    for (auto& [_, count] : leader_counts) {
+        total_leaders += count;
+    }
+    const double mean_leaders = double(total_leaders) / leader_counts.size();
+    // a node is not expected to be closer than one leader to the mean
+    const double leaders_slack = std::max(
+      1.0, mean_leaders * imbalance_percent / 100.0);
+
+    std::vector<uint64_t> shard_load(shards, 0);
+    for (auto& l : leaders) {
+        shard_load[l.shard % shards] += l.load;
+    }
+
+    // tracked apart, inserting into the map invalidates references
+    size_t self_count = leader_counts[self];
+    auto node_overloaded = [&] {
+        return self_count > mean_leaders + leaders_slack;
+    };
+
+    // most loaded shards first, their busiest partitions first
+    std::sort(
+      leaders.begin(),
+      leaders.end(),
+      [&shard_load, shards](const local_leader& a, const local_leader& b) {
+          const auto la = shard_load[a.shard % shards];
+          const auto lb = shard_load[b.shard % shards];
+          if (la != lb) {
+              return la > lb;
+          }
+          return a.load > b.load;
+      });
+
+    for (auto& l : leaders) {
+        if (ret.size() >= max_transfers || !node_overloaded()) {
+            break;
+        }
+        std::optional<model::node_id> target;
+        size_t target_count = 0;
+        for (auto id : l.replicas) {
+            if (id == self) {
+                continue;
+            }
+            auto it = leader_counts.find(id);
+            const auto count = it == leader_counts.end() ? 0 : it->second;
+            if (!target || count < target_count) {
+                target = id;
+                target_count = count;
+            }
+        }
+        if (!target || target_count + 2 > self_count) {
+            continue;
+        }
+        --self_count;
+        ++leader_counts[*target];
+        ret.push_back(leadership_transfer{
+          .ntp = l.ntp, .shard = l.shard, .target = *target});
+    }
+    return ret;
+}
+
+std::vector<shard_move> plan_shard_moves(
+  std::vector<local_leader> leaders,
+  size_t shards,
+  size_t imbalance_percent,
+  size_t max_moves) {
+    std::vector<shard_move> ret;
+    if (leaders.empty() || shards < 2) {
+        return ret;
+    }
+    std::vector<uint64_t> shard_load(shards, 0);
+    uint64_t total_load = 0;
+    for (auto& l : leaders) {
+        shard_load[l.shard % shards] += l.load;
+        total_load += l.load;
+    }
+    if (total_load == 0) {
+        return ret;
+    }
+    const double max_shard_load = double(total_load) / shards
+                                  * (100 + imbalance_percent) / 100.0;
+
+    std::vector<ss::shard_id> hot;
+    for (ss::shard_id s = 0; s < shards; ++s) {
+        if (shard_load[s] > max_shard_load) {
+            hot.push_back(s);
+        }
+    }
+    std::sort(hot.begin(), hot.end(), [&shard_load](auto a, auto b) {
+        return shard_load[a] > shard_load[b];
+    });
+
+    for (auto source : hot) {
+        if (ret.size() >= max_moves) {
+            break;
+        }
+        const auto target = ss::shard_id(std::distance(
+          shard_load.begin(),
+          std::min_element(shard_load.begin(), shard_load.end())));
+        const auto gap = shard_load[source] - shard_load[target];
+        // the partition closest to evening out both shards, partitions as
+        // loaded as the gap would only swap the hotspot
+        local_leader* best = nullptr;
+        uint64_t best_distance = 0;
+        for (auto& l : leaders) {
+            if (l.shard % shards != source || l.load == 0 || l.load >= gap) {
+                continue;
+            }
+            const auto half = gap / 2;
+            const auto distance = l.load > half ? l.load - half
+                                                : half - l.load;
+            if (!best || distance < best_distance) {
+                best = &l;
+                best_distance = distance;
+            }
+        }
+        if (!best) {
+            continue;
+        }
+        shard_load[source] -= best->load;
+        shard_load[target] += best->load;
+        ret.push_back(
+          shard_move{.ntp = best->ntp, .source = source, .target = target});
+    }
+    return ret;
+}
+
+leader_balancer::leader_balancer(
+  model::node_id self,
+  ss::sharded<partition_leaders_table>& leaders,
+  ss::sharded<members_table>& members,
+  ss::sharded<shard_table>& st,
+  ss::sharded<partition_manager>& pm,
+  ss::sharded<shard_mover>& mover,
+  ss::sharded<ss::abort_source>& as)
+  : _self(self)
+  , _leaders(leaders)
+  , _members(members)
+  , _shard_table(st)
+  , _partition_manager(pm)
+  , _shard_mover(mover)
+  , _as(as) {}
+
+ss::future<> leader_balancer::start() {
+    if (!config::shard_local_cfg().leader_balancer_enabled()) {
+        return ss::now();
+    }
+    _timer.set_callback([this] { tick(); });
+    _timer.arm_periodic(
+      config::shard_local_cfg().leader_balancer_interval_ms());
+    return ss::now();
+}
+
+ss::future<> leader_balancer::stop() {
+    _timer.cancel();
+    return _gate.close();
+}
+
+void leader_balancer::tick() {
+    // a round may outlast the interval while transfers wait for recovery
+    if (_balancing || _as.local().abort_requested()) {
+        return;
+    }
+    _balancing = true;
+    (void)ss::with_gate(_gate, [this] {
+        return balance()
+          .handle_exception([](const std::exception_ptr& e) {
+              vlog(clusterlog.info, "Error balancing leaders - {}", e);
+          })
+          .finally([this] { _balancing = false; });
+    });
+}
+
+absl::flat_hash_map<model::node_id, size_t>
+leader_balancer::leader_counts() const {
+    absl::flat_hash_map<model::node_id, size_t> ret;
+    // members leading nothing are the first to receive leaderships
+    for (auto id : _members.local().all_broker_ids()) {
+        ret.emplace(id, 0);
+    }
+    _leaders.local().for_each_leader(
+      [&ret](
+        model::topic_namespace_view,
+        model::partition_id,
+        std::optional<model::node_id> leader,
+        model::term_id) {
+          if (leader) {
+              ++ret[*leader];
+          }
+      });
+    return ret;
+}
+
+ss::future<std::vector<local_leader>>
+leader_balancer::collect_local_leaders() {
+    return _partition_manager.map_reduce0(
+      [](partition_manager& pm) {
+          std::vector<local_leader> ret;
+          for (auto& [ntp, p] : pm.partitions()) {
+              // controller leadership is not balanced
+              if (!p->is_leader() || ntp == controller_ntp) {
+                  continue;
+              }
+              ret.push_back(local_leader{
+                .ntp = ntp,
+                .shard = ss::this_shard_id(),
+                .load = p->probe().records_produced(),
+                .replicas = p->group_configuration().unique_voter_ids()});
+          }
+          return ret;
+      },
+      std::vector<local_leader>{},
+      [](std::vector<local_leader> acc, std::vector<local_leader> v) {
+          std::move(v.begin(), v.end(), std::back_inserter(acc));
+          return acc;
+      });
+}
+
+ss::future<> leader_balancer::balance() {
+    return collect_local_leaders().then(
+      [this](std::vector<local_leader> leaders) {
+          const auto now = ss::lowres_clock::now();
+          const auto cooldown
+            = config::shard_local_cfg().leader_balancer_interval_ms()
+              * transfer_cooldown_rounds;
+          absl::erase_if(_last_transfer, [now, cooldown](const auto& e) {
+              return now - e.second >= cooldown;
+          });
+          absl::flat_hash_map<model::ntp, uint64_t> produced;
+          std::vector<local_leader> candidates;
+          candidates.reserve(leaders.size());
+          for (auto& l : leaders) {
+              // the counter is the total produced to the partition, the load
+              // is what was produced since the last round. partitions which
+              // just became leaders here have no load yet
+              const auto total = l.load;
+              auto it = _produced.find(l.ntp);
+              l.load = it == _produced.end() || it->second > total
+                         ? 0
+                         : total - it->second;
+              produced.emplace(l.ntp, total);
+
+              if (_last_transfer.contains(l.ntp)) {
+                  continue;
+              }
+              candidates.push_back(std::move(l));
+          }
+          _produced = std::move(produced);
+
+          const auto imbalance
+            = config::shard_local_cfg().leader_balancer_imbalance_percent();
+          auto transfers = plan_leadership_transfers(
+            _self,
+            leader_counts(),
+            candidates,
+            ss::smp::count,
+            imbalance,
+            config::shard_local_cfg().leader_balancer_transfers_per_round());
+          // the leaderships staying here are spread over the shards
+          absl::flat_hash_set<model::ntp> transferred;
+          for (auto& t : transfers) {
+              transferred.insert(t.ntp);
+          }
+          candidates.erase(
+            std::remove_if(
+              candidates.begin(),
+              candidates.end(),
+              [&transferred](const local_leader& l) {
+                  return transferred.contains(l.ntp);
+              }),
+            candidates.end());
+          auto moves = plan_shard_moves(
+            std::move(candidates),
+            ss::smp::count,
+            imbalance,
+            config::shard_local_cfg().leader_balancer_shard_moves_per_round());
+          if (transfers.empty() && moves.empty()) {
+              return ss::now();
+          }
+          vlog(
+            clusterlog.info,
+            "Transferring {} partition leaderships and moving {} partitions "
+            "between shards to balance leaders",
+            transfers.size(),
+            moves.size());
+          // one at a time, a transfer stops the produce requests of the
+          // partition until the target caught up and a move until it is
+          // started on the target shard
+          return ss::do_with(
+            std::move(transfers),
+            std::move(moves),
+            [this](
+              std::vector<leadership_transfer>& ts,
+              std::vector<shard_move>& ms) {
+                return ss::do_for_each(
+                         ts,
+                         [this](leadership_transfer& t) {
+                             if (_as.local().abort_requested()) {
+                                 return ss::now();
+                             }
+                             return transfer(t);
+                         })
+                  .then([this, &ms] {
+                      return ss::do_for_each(ms, [this](shard_move& m) {
+                          if (_as.local().abort_requested()) {
+                              return ss::now();
+                          }
+                          return move(m);
+                      });
+                  });
+            });
+      });
+}
+
+ss::future<> leader_balancer::transfer(leadership_transfer t) {
+    _last_transfer[t.ntp] = ss::lowres_clock::now();
+    // the partition may have moved to another shard since it was collected
+    const auto shard = _shard_table.local().shard_for(t.ntp);
+    if (!shard) {
+        return ss::now();
+    }
+    return _partition_manager
+      .invoke_on(
+        *shard,
+        [ntp = t.ntp, target = t.target](partition_manager& pm) {
+            auto p = pm.get(ntp);
+            if (!p) {
+                return ss::make_ready_future<std::error_code>(
+                  errc::partition_not_exists);
+            }
+            return p->transfer_leadership(target);
+        })
+      .then([t = std::move(t)](std::error_code ec) {
+          if (ec) {
+              vlog(
+                clusterlog.debug,
+                "Leadership transfer of {} to {} failed - {}",
+                t.ntp,
+                t.target,
+                ec.message());
+              return;
+          }
+          vlog(
+            clusterlog.debug,
+            "Transferred leadership of {} to {}",
+            t.ntp,
+            t.target);
+      });
+}
+
+ss::future<> leader_balancer::move(shard_move m) {
+    _last_transfer[m.ntp] = ss::lowres_clock::now();
+    return _shard_mover.local()
+      .move(m.ntp, m.target)
+      .then([m = std::move(m)](std::error_code ec) {
+          if (ec) {
+              vlog(
+                clusterlog.debug,
+                "Moving {} to shard {} failed - {}",
+                m.ntp,
+                m.target,
+                ec.message());
+              return;
+          }
+          vlog(
+            clusterlog.debug,
+            "Moved {} from shard {} to shard {}",
+            m.ntp,
+            m.source,
+            m.target);
+      });
+}
+
+} // namespace cluster
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "cluster/members_table.h"
+#include "cluster/partition_leaders_table.h"
+#include "cluster/partition_manager.h"
+#include "cluster/shard_mover.h"
+#include "cluster/shard_table.h"
+#include "model/fundamental.h"
+#include "model/metadata.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <vector>
+
+namespace cluster {
+
+/// Partition led by this node as seen by the leader balancer
+struct local_leader {
+    model::ntp ntp;
+    ss::shard_id shard;
+    // records produced since the previous balancing round
+    uint64_t load;
+    // voters the leadership may be transferred to
+    std::vector<model::node_id> replicas;
+};
+
+struct leadership_transfer {
+    model::ntp ntp;
+    ss::shard_id shard;
+    model::node_id target;
+};
+
+struct shard_move {
+    model::ntp ntp;
+    ss::shard_id source;
+    ss::shard_id target;
+};
+
+/**
+ * Chooses the leaderships `self` hands over to even out the leaders.
+ *
+ * A node leading more than `imbalance_percent` above the mean leader count
+ * of the cluster gives leaderships away, partitions of its most loaded
+ * `shards` first. Every transfer goes to the replica leading the fewest
+ * partitions and only when it leads at least two less than `self`, the
+ * transfers never widen the spread of leader counts so two nodes do not pass
+ * leaderships back and forth.
+ */
+std::vector<leadership_transfer> plan_leadership_transfers(
+  model::node_id self,
+  absl::flat_hash_map<model::node_id, size_t> leader_counts,
+  std::vector<local_leader> leaders,
+  size_t shards,
+  size_t imbalance_percent,
+  size_t max_transfers);
+
+/**
+ * Chooses the partitions moved between the `shards` of this node to even out
+ * their produce load.
+ *
+ * Every shard producing more than `imbalance_percent` above the mean moves
+ * one partition to the least loaded shard, the one closest to half of the
+ * difference between the two shards. Only moves lowering the load of the
+ * busier of the two shards are made, so one round never makes the target a
+ * worse hotspot than the source was.
+ */
+std::vector<shard_move> plan_shard_moves(
+  std::vector<local_leader> leaders,
+  size_t shards,
+  size_t imbalance_percent,
+  size_t max_moves);
+
+/**
+ * Moves partition leaderships away from overloaded nodes and shards.
+ *
+ * Elections place leaders wherever they happen to resolve, after restarts
+ * the leaders pile on the nodes which stayed up. Every node periodically
+ * compares the leaders it holds with the cluster wide counts of the
+ * partition leaders table, then hands some of its leaderships to less loaded
+ * replicas with raft leadership transfers. Each node only gives its own
+ * leaderships away so the nodes do not have to coordinate, a node short of
+ * leaders is filled up by the others. The produce load of the shards of the
+ * node is evened out by moving partitions to its other shards with the
+ * shard mover, which leaves the leaderships in place. Bounded number of
+ * transfers and moves happen per round and a partition is not touched again
+ * for a few rounds after it was transferred or moved.
+ */
+class leader_balancer {
+public:
+    static constexpr ss::shard_id shard = 0;
+    // rounds a moved partition is left alone
+    static constexpr size_t transfer_cooldown_rounds = 5;
+
+    leader_balancer(
+      model::node_id self,
+      ss::sharded<partition_leaders_table>&,
+      ss::sharded<members_table>&,
+      ss::sharded<shard_table>&,
+      ss::sharded<partition_manager>&,
+      ss::sharded<shard_mover>&,
+      ss::sharded<ss::abort_source>&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+private:
+    void tick();
+    ss::future<> balance();
+    ss::future<std::vector<local_leader>> collect_local_leaders();
+    absl::flat_hash_map<model::node_id, size_t> leader_counts() const;
+    ss::future<> transfer(leadership_transfer);
+    ss::future<> move(shard_move);
+
+    model::node_id _self;
+    ss::sharded<partition_leaders_table>& _leaders;
+    ss::sharded<members_table>& _members;
+    ss::sharded<shard_table>& _shard_table;
+    ss::sharded<partition_manager>& _partition_manager;
+    ss::sharded<shard_mover>& _shard_mover;
+    ss::sharded<ss::abort_source>& _as;
+
+    // produced records counters seen in the previous round
+    absl::flat_hash_map<model::ntp, uint64_t> _produced;
+    absl::flat_hash_map<model::ntp, ss::lowres_clock::time_point>
+      _last_transfer;
+    ss::timer<ss::lowres_clock> _timer;
+    bool _balancing{false};
+    ss::gate _gate;
+};
+
+} // namespace cluster
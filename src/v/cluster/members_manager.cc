@@ -38,6 +38,7 @@ members_manager::members_manager(
   ss::sharded<rpc::connection_cache>& connections,
   ss::sharded<partition_allocator>& allocator,
   ss::sharded<storage::api>& storage,
+  ss::sharded<controller_stm>& stm,
   ss::sharded<ss::abort_source>& as)
   : _seed_servers(config::shard_local_cfg().seed_servers())
   , _self(make_self_broker(config::shard_local_cfg()))
@@ -48,6 +49,7 @@ members_manager::members_manager(
   , _connection_cache(connections)
   , _allocator(allocator)
   , _storage(storage)
+  , _stm(stm)
   , _as(as)
   , _rpc_tls_config(config::shard_local_cfg().rpc_server_tls()) {}
 
@@ -150,6 +152,14 @@ members_manager::handle_raft0_cfg_update(raft::group_configuration cfg) {
       });
 }
 
+ss::future<> members_manager::handle_node_load_report(node_load load) {
+    return _allocator.invoke_on(
+      partition_allocator::shard,
+      [load = std::move(load)](partition_allocator& allocator) {
+          allocator.update_node_load(load);
+      });
+}
+
 ss::future<std::error_code>
 members_manager::apply_update(model::record_batch b) {
     auto cfg = reflection::from_iobuf<raft::group_configuration>(
@@ -309,14 +319,17 @@ members_manager::handle_join_request(model::broker broker) {
     vlog(clusterlog.info, "Processing node '{}' join request", broker.id());
     // curent node is a leader
     if (_raft0->is_leader()) {
-        // Just update raft0 configuration
-        return _raft0->add_group_members({std::move(broker)})
-          .then([](std::error_code ec) {
-              if (!ec) {
-                  return ret_t(join_reply{true});
-              }
+        return snapshot_for_joining_node(broker).then(
+          [this, broker = std::move(broker)]() mutable {
+              // Just update raft0 configuration
+              return _raft0->add_group_members({std::move(broker)})
+                .then([](std::error_code ec) {
+                    if (!ec) {
+                        return ret_t(join_reply{true});
+                    }
 
-              return ret_t(ec);
+                    return ret_t(ec);
+                });
           });
     }
     // Current node is not the leader have to send an RPC to leader
@@ -339,6 +352,37 @@ members_manager::handle_join_request(model::broker broker) {
       });
 }
 
+/**
+ * The log of raft0 is prefix truncated up to the controller snapshot, so a
+ * node joining for the first time is brought up to date by installing the
+ * snapshot, streamed by the recovery of raft0, followed by the batches
+ * replicated after it. Snapshotting right before the node is added keeps
+ * that tail short, the node creates its partitions once it applied the
+ * snapshot instead of after replaying every controller batch since the
+ * last periodic snapshot. Snapshots are best effort, the node replays the
+ * log otherwise.
+ */
+ss::future<>
+members_manager::snapshot_for_joining_node(const model::broker& broker) {
+    if (
+      _raft0->config().contains_broker(broker.id())
+      || config::shard_local_cfg().controller_snapshot_batches() == 0) {
+        return ss::now();
+    }
+    vlog(
+      clusterlog.info,
+      "Snapshotting controller state for joining node {}",
+      broker.id());
+    return _stm
+      .invoke_on(controller_stm_shard, &controller_stm::write_snapshot_now)
+      .handle_exception([](const std::exception_ptr& e) {
+          vlog(
+            clusterlog.warn,
+            "Unable to snapshot controller state for joining node - {}",
+            e);
+      });
+}
+
 ss::future<> members_manager::validate_configuration_invariants() {
     static const bytes invariants_key("configuration_invariants");
     auto invariants_buf = _storage.local().kvs().get(
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "cluster/controller_stm.h"
 #include "cluster/members_table.h"
 #include "cluster/partition_allocator.h"
 #include "cluster/types.h"
@@ -39,6 +40,7 @@ public:
       ss::sharded<rpc::connection_cache>&,
       ss::sharded<partition_allocator>&,
       ss::sharded<storage::api>&,
+      ss::sharded<controller_stm>&,
       ss::sharded<ss::abort_source>&);
 
     ss::future<> start();
@@ -50,6 +52,10 @@ public:
     ss::future<result<configuration_update_reply>>
       handle_configuration_update_request(configuration_update_request);
 
+    /// Load reports of all the nodes are kept by every allocator, the
+    /// controller leader may change any time
+    ss::future<> handle_node_load_report(node_load);
+
     bool is_batch_applicable(const model::record_batch& b) {
         return b.header().type == raft::configuration_batch_type;
     }
@@ -68,6 +74,7 @@ private:
     dispatch_join_to_remote(const config::seed_server&, model::broker);
 
     ss::future<join_reply> dispatch_join_request();
+    ss::future<> snapshot_for_joining_node(const model::broker&);
     template<typename Func>
     auto dispatch_rpc_to_leader(Func&& f);
 
@@ -92,6 +99,7 @@ private:
     ss::sharded<rpc::connection_cache>& _connection_cache;
     ss::sharded<partition_allocator>& _allocator;
     ss::sharded<storage::api>& _storage;
+    ss::sharded<controller_stm>& _stm;
     ss::sharded<ss::abort_source>& _as;
     config::tls_config _rpc_tls_config;
     ss::gate _gate;
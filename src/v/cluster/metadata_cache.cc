@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <iterator>
 #include <optional>
+#include <string_view>
 
 namespace cluster {
 
@@ -65,6 +66,16 @@ metadata_cache::get_topic_timestamp_type(model::topic_namespace_view tp) const {
     return _topics_state.local().get_topic_timestamp_type(tp);
 }
 
+std::optional<metadata_cache::topic_revision>
+metadata_cache::get_topic_revision(model::topic_namespace_view tp) const {
+    auto rev = _topics_state.local().get_topic_revision(tp);
+    if (!rev) {
+        return std::nullopt;
+    }
+    return topic_revision{
+      .topic = *rev, .leaders = _leaders.local().get_topic_revision(tp)};
+}
+
 std::vector<model::topic_metadata> metadata_cache::all_topics_metadata() const {
     auto all_md = _topics_state.local().all_topics_metadata();
     for (auto& md : all_md) {
@@ -102,4 +113,31 @@ std::optional<model::node_id> metadata_cache::get_controller_leader_id() {
     return _leaders.local().get_leader(controller_ntp);
 }
 
+std::optional<model::node_id> metadata_cache::get_preferred_read_replica(
+  const model::ntp& ntp, std::string_view rack) const {
+    auto assignment = _topics_state.local().get_partition_assignment(ntp);
+    if (!assignment) {
+        return std::nullopt;
+    }
+    auto leader = _leaders.local().get_leader(ntp);
+    std::vector<model::node_id> in_rack;
+    for (auto& bs : assignment->replicas) {
+        auto broker = _members_table.local().get_broker(bs.node_id);
+        if (!broker || !(*broker)->rack()) {
+            continue;
+        }
+        if (std::string_view(*(*broker)->rack()) != rack) {
+            continue;
+        }
+        if (bs.node_id == leader) {
+            return std::nullopt;
+        }
+        in_rack.push_back(bs.node_id);
+    }
+    if (in_rack.empty()) {
+        return std::nullopt;
+    }
+    return in_rack[std::hash<model::ntp>{}(ntp) % in_rack.size()];
+}
+
 } // namespace cluster
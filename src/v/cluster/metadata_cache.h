@@ -25,6 +25,8 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <string_view>
+
 namespace cluster {
 
 /// Metadata cache provides all informationrequired to fill Kafka metadata
@@ -52,6 +54,17 @@ namespace cluster {
 /// +---------+   +----------+    +------------+
 class metadata_cache {
 public:
+    /// Identifies a version of the topic metadata, both revisions change
+    /// whenever the topic metadata returned by the cache would
+    struct topic_revision {
+        uint64_t topic;
+        uint64_t leaders;
+
+        bool operator==(const topic_revision& o) const {
+            return topic == o.topic && leaders == o.leaders;
+        }
+    };
+
     metadata_cache(
       ss::sharded<topic_table>&,
       ss::sharded<members_table>&,
@@ -80,6 +93,12 @@ public:
     std::optional<model::timestamp_type>
       get_topic_timestamp_type(model::topic_namespace_view) const;
 
+    ///\brief Returns revision of the topic metadata.
+    ///
+    /// If topic does not exists it returns an empty optional
+    std::optional<topic_revision>
+      get_topic_revision(model::topic_namespace_view) const;
+
     /// Returns metadata of all topics.
     std::vector<model::topic_metadata> all_topics_metadata() const;
 
@@ -113,6 +132,16 @@ public:
     /// If present returns a leader of raft0 group
     std::optional<model::node_id> get_controller_leader_id();
 
+    /**
+     * Replica of the partition a consumer in `rack` should fetch from.
+     *
+     * None when the leader is in that rack itself or when no replica is, the
+     * consumer keeps fetching from the leader. Partitions with several
+     * replicas in the rack are spread over them.
+     */
+    std::optional<model::node_id>
+    get_preferred_read_replica(const model::ntp&, std::string_view rack) const;
+
 private:
     ss::sharded<topic_table>& _topics_state;
     ss::sharded<members_table>& _members_table;
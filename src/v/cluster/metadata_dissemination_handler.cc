@@ -19,6 +19,7 @@
 #include "model/metadata.h"
 #include "model/timeout_clock.h"
 #include "rpc/connection_cache.h"
+#include "vlog.h"
 
 namespace cluster {
 metadata_dissemination_handler::metadata_dissemination_handler(
@@ -40,6 +41,17 @@ metadata_dissemination_handler::update_leadership(
 ss::future<update_leadership_reply>
 metadata_dissemination_handler::do_update_leadership(
   update_leadership_request&& req) {
+    if (
+      req.from_version > 0
+      && !_leaders.local().get_peer_version(req.source)) {
+        // delta is based on updates this node does not have
+        vlog(
+          clusterlog.debug,
+          "Requesting full leadership sync from node {}",
+          req.source);
+        return ss::make_ready_future<update_leadership_reply>(
+          update_leadership_reply{.full_sync_required = true});
+    }
     return _leaders
       .invoke_on_all(
         [req = std::move(req)](partition_leaders_table& pl) mutable {
@@ -47,6 +59,7 @@ metadata_dissemination_handler::do_update_leadership(
                 pl.update_partition_leader(
                   leader.ntp, leader.term, leader.leader_id);
             }
+            pl.set_peer_version(req.source, req.to_version);
         })
       .then([] { return ss::make_ready_future<update_leadership_reply>(); });
 }
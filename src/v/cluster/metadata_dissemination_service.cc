@@ -22,6 +22,7 @@
 #include "model/fundamental.h"
 #include "model/metadata.h"
 #include "model/timeout_clock.h"
+#include "prometheus/prometheus_sanitize.h"
 #include "rpc/connection_cache.h"
 #include "rpc/types.h"
 #include "utils/retry.h"
@@ -31,6 +32,7 @@
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
+#include <seastar/core/metrics.hh>
 #include <seastar/core/sleep.hh>
 
 #include <absl/container/flat_hash_set.h>
@@ -59,7 +61,10 @@ metadata_dissemination_service::metadata_dissemination_service(
         (void)ss::with_gate(
           _bg, [this] { return dispatch_disseminate_leadership(); });
     });
-    _dispatch_timer.arm_periodic(_dissemination_interval);
+    // updates are collected and disseminated by shard 0
+    if (ss::this_shard_id() == 0) {
+        _dispatch_timer.arm_periodic(_dissemination_interval);
+    }
 
     for (auto& seed : config::shard_local_cfg().seed_servers()) {
         _seed_server_ids.push_back(seed.id);
@@ -76,28 +81,38 @@ void metadata_dissemination_service::disseminate_leadership(
       ntp,
       leader_id.value());
 
-    _requests.push_back(ntp_leader{std::move(ntp), term, leader_id});
+    // only the latest update of the partition has to be delivered
+    auto version = ++_version;
+    _updates.insert_or_assign(
+      ntp,
+      versioned_update{
+        .leader = ntp_leader{ntp, term, leader_id}, .version = version});
 }
 
 ss::future<> metadata_dissemination_service::start() {
     _notification_handle
-      = _raft_manager.local().register_leadership_notification(
-        [this](
-          raft::group_id group,
-          model::term_id term,
-          std::optional<model::node_id> leader_id) {
-            auto c = _partition_manager.local().consensus_for(group);
-            if (!c) {
-                return;
+      = _raft_manager.local().register_leadership_batch_notification(
+        [this](const std::vector<raft::leadership_status>& changes) {
+            ntp_leaders leaders;
+            leaders.reserve(changes.size());
+            for (const auto& st : changes) {
+                auto c = _partition_manager.local().consensus_for(st.group);
+                if (c) {
+                    leaders.push_back(ntp_leader{
+                      .ntp = c->ntp(),
+                      .term = st.term,
+                      .leader_id = st.current_leader});
+                }
+            }
+            if (!leaders.empty()) {
+                handle_leadership_notification(std::move(leaders));
             }
-            auto ntp = c->ntp();
-            handle_leadership_notification(
-              std::move(ntp), term, std::move(leader_id));
         });
 
     if (ss::this_shard_id() != 0) {
         return ss::make_ready_future<>();
     }
+    setup_metrics();
     // poll either seed servers or configuration
     auto ids = _members_table.local().all_broker_ids();
     // use hash set to deduplicate ids
@@ -132,38 +147,49 @@ ss::future<> metadata_dissemination_service::start() {
 }
 
 void metadata_dissemination_service::handle_leadership_notification(
-  model::ntp ntp, model::term_id term, std::optional<model::node_id> lid) {
-    (void)ss::with_gate(_bg, [this, ntp = std::move(ntp), lid, term]() mutable {
+  ntp_leaders leaders) {
+    // the changes of a tick of this shard cross to shard 0 together
+    (void)ss::with_gate(_bg, [this, leaders = std::move(leaders)]() mutable {
         return container().invoke_on(
           0,
-          [ntp = std::move(ntp), lid, term](
+          [leaders = std::move(leaders)](
             metadata_dissemination_service& s) mutable {
-              return s.apply_leadership_notification(std::move(ntp), term, lid);
+              return s.apply_leadership_notification(std::move(leaders));
           });
     });
 }
 
-ss::future<> metadata_dissemination_service::apply_leadership_notification(
-  model::ntp ntp, model::term_id term, std::optional<model::node_id> lid) {
+ss::future<>
+metadata_dissemination_service::apply_leadership_notification(
+  ntp_leaders leaders) {
     // the gate also needs to be taken on the destination core.
-    return ss::with_gate(
-      _bg, [this, ntp = std::move(ntp), lid, term]() mutable {
-          // the lock sequences the updates from raft
-          return _lock.with([this, ntp = std::move(ntp), lid, term]() mutable {
-              // update partition leaders
-              auto f = _leaders.invoke_on_all(
-                [ntp, lid, term](partition_leaders_table& leaders) {
-                    leaders.update_partition_leader(ntp, term, lid);
-                });
-              if (lid == _self) {
-                  // only disseminate from current leader
-                  f = f.then([this, ntp = std::move(ntp), term, lid]() mutable {
-                      return disseminate_leadership(std::move(ntp), term, lid);
-                  });
-              }
-              return f;
-          });
-      });
+    return ss::with_gate(_bg, [this, leaders = std::move(leaders)]() mutable {
+        // the lock sequences the updates from raft
+        return _lock.with([this, leaders = std::move(leaders)]() mutable {
+            // update partition leaders, once per shard for the whole batch.
+            // the shards read the batch in place until they are all done
+            return ss::do_with(
+              std::move(leaders), [this](ntp_leaders& leaders) {
+                  const auto* l = &leaders;
+                  return _leaders
+                    .invoke_on_all([l](partition_leaders_table& table) {
+                        for (const auto& e : *l) {
+                            table.update_partition_leader(
+                              e.ntp, e.term, e.leader_id);
+                        }
+                    })
+                    .then([this, &leaders] {
+                        for (auto& e : leaders) {
+                            // only disseminate from current leader
+                            if (e.leader_id == _self) {
+                                disseminate_leadership(
+                                  std::move(e.ntp), e.term, e.leader_id);
+                            }
+                        }
+                    });
+              });
+        });
+    });
 }
 
 static inline ss::future<>
@@ -253,89 +279,258 @@ metadata_dissemination_service::dispatch_get_metadata_update(
         });
 }
 
-void metadata_dissemination_service::collect_pending_updates() {
+metadata_dissemination_service::requests_t
+metadata_dissemination_service::collect_pending_updates() {
     auto brokers = _members_table.local().all_broker_ids();
-    for (auto& ntp_leader : _requests) {
-        auto tp_md = _topics.local().get_topic_metadata(
-          model::topic_namespace_view(ntp_leader.ntp));
+    // forget nodes that are no longer part of the cluster
+    absl::erase_if(_peers, [&brokers](const peers_t::value_type& p) {
+        return std::find(brokers.begin(), brokers.end(), p.first)
+               == brokers.end();
+    });
 
-        if (!tp_md) {
-            // Topic metadata is not there anymore, partition was removed
+    requests_t requests;
+    bool full_sync = false;
+    for (auto id : brokers) {
+        if (id == _self) {
             continue;
         }
-        auto non_overlapping = calculate_non_overlapping_nodes(
-          get_partition_members(ntp_leader.ntp.tp.partition, *tp_md), brokers);
-        for (auto& id : non_overlapping) {
-            if (!_pending_updates.contains(id)) {
-                _pending_updates.emplace(id, update_retry_meta{ntp_leaders{}});
+        auto& peer = _peers[id];
+        if (
+          peer.in_flight
+          || (!peer.full_sync && peer.acked_version == _version)) {
+            continue;
+        }
+        full_sync |= peer.full_sync;
+        requests.emplace(
+          id,
+          update_leadership_request{
+            .source = _self,
+            .from_version = peer.full_sync ? 0 : peer.acked_version,
+            .to_version = _version});
+    }
+    if (requests.empty()) {
+        return requests;
+    }
+
+    // topic metadata is looked up once per topic in a round
+    absl::flat_hash_map<
+      model::topic_namespace,
+      std::optional<model::topic_metadata>,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      topics;
+    auto append = [this, &requests, &topics](
+                    const ntp_leader& leader, auto&& should_send) {
+        model::topic_namespace_view tp_ns(leader.ntp);
+        auto it = topics.find(tp_ns);
+        if (it == topics.end()) {
+            it = topics
+                   .emplace(
+                     model::topic_namespace(tp_ns),
+                     _topics.local().get_topic_metadata(tp_ns))
+                   .first;
+        }
+        if (!it->second) {
+            // Topic metadata is not there anymore, partition was removed
+            return;
+        }
+        // only nodes that are not partition replicas have to be informed
+        auto members = get_partition_members(
+          leader.ntp.tp.partition, *it->second);
+        for (auto& [id, req] : requests) {
+            const bool is_member = std::find(members.begin(), members.end(), id)
+                                   != members.end();
+            if (!is_member && should_send(_peers.find(id)->second, req)) {
+                req.leaders.push_back(leader);
             }
-            _pending_updates[id].updates.push_back(ntp_leader);
         }
+    };
+
+    if (full_sync) {
+        _leaders.local().for_each_leader(
+          [this, &append](
+            model::topic_namespace_view tp_ns,
+            model::partition_id pid,
+            std::optional<model::node_id> leader,
+            model::term_id term) {
+              if (leader != _self) {
+                  return;
+              }
+              append(
+                ntp_leader{
+                  .ntp = model::ntp(tp_ns.ns, tp_ns.tp, pid),
+                  .term = term,
+                  .leader_id = leader},
+                [](const peer_state& peer, const update_leadership_request&) {
+                    return peer.full_sync;
+                });
+          });
+    }
+    for (auto& [ntp, update] : _updates) {
+        append(
+          update.leader,
+          [version = update.version](
+            const peer_state& peer, const update_leadership_request& req) {
+              return !peer.full_sync && version > req.from_version;
+          });
     }
-    _requests.clear();
+
+    // nothing relevant for the peer, it is up to date without a request
+    absl::erase_if(requests, [this](const requests_t::value_type& r) {
+        auto& peer = _peers.find(r.first)->second;
+        if (peer.full_sync || !r.second.leaders.empty()) {
+            if (!peer.behind_since) {
+                peer.behind_since = ss::lowres_clock::now();
+            }
+            return false;
+        }
+        peer.acked_version = r.second.to_version;
+        return true;
+    });
+    return requests;
 }
 
-void metadata_dissemination_service::cleanup_finished_updates() {
-    std::vector<model::node_id> _to_remove;
-    _to_remove.reserve(_pending_updates.size());
-    for (auto& [node_id, meta] : _pending_updates) {
-        if (meta.finished) {
-            _to_remove.push_back(node_id);
+void metadata_dissemination_service::prune_acknowledged_updates() {
+    // peers waiting for a full sync do not need the updates
+    uint64_t min_acked = _version;
+    for (auto& [id, peer] : _peers) {
+        if (!peer.full_sync) {
+            min_acked = std::min(min_acked, peer.acked_version);
         }
     }
-    for (auto id : _to_remove) {
-        _pending_updates.erase(id);
-    }
+    absl::erase_if(_updates, [min_acked](const updates_t::value_type& u) {
+        return u.second.version <= min_acked;
+    });
 }
 
 ss::future<> metadata_dissemination_service::dispatch_disseminate_leadership() {
-    collect_pending_updates();
-    return ss::parallel_for_each(
-             _pending_updates.begin(),
-             _pending_updates.end(),
-             [this](broker_updates_t::value_type& br_update) {
-                 return dispatch_one_update(br_update.first, br_update.second);
-             })
-      .then([this] { cleanup_finished_updates(); });
+    auto requests = collect_pending_updates();
+    prune_acknowledged_updates();
+    return ss::do_with(std::move(requests), [this](requests_t& requests) {
+        return ss::parallel_for_each(
+          requests.begin(), requests.end(), [this](requests_t::value_type& r) {
+              return dispatch_one_update(r.first, std::move(r.second));
+          });
+    });
 }
 
 ss::future<> metadata_dissemination_service::dispatch_one_update(
-  model::node_id target_id, update_retry_meta& meta) {
+  model::node_id target_id, update_leadership_request req) {
+    _peers[target_id].in_flight = true;
+    const bool full_sync = req.from_version == 0;
+    const auto to_version = req.to_version;
+    const auto updates = req.leaders.size();
     return _clients.local()
       .with_node_client<metadata_dissemination_rpc_client_protocol>(
         _self,
         ss::this_shard_id(),
         target_id,
-        [this, &meta, target_id](
+        [this, req = std::move(req), target_id](
           metadata_dissemination_rpc_client_protocol proto) mutable {
             vlog(
               clusterlog.trace,
-              "Sending {} metadata updates to {}",
-              meta.updates.size(),
-              target_id);
+              "Sending {} metadata updates to {}, versions ({}, {}]",
+              req.leaders.size(),
+              target_id,
+              req.from_version,
+              req.to_version);
             return proto
               .update_leadership(
-                update_leadership_request{meta.updates},
+                std::move(req),
                 rpc::client_opts(
                   _dissemination_interval + rpc::clock_type::now()))
               .then(&rpc::get_ctx_data<update_leadership_reply>);
         })
-      .then([target_id, &meta](result<update_leadership_reply> r) {
-          if (r) {
-              meta.finished = true;
+      .then([this, target_id, full_sync, to_version, updates](
+              result<update_leadership_reply> r) {
+          auto it = _peers.find(target_id);
+          if (it == _peers.end()) {
+              // node left the cluster
               return;
           }
-          vlog(
-            clusterlog.warn,
-            "Error sending metadata update {} to {}",
-            r.error().message(),
-            target_id);
+          auto& peer = it->second;
+          if (!r) {
+              vlog(
+                clusterlog.warn,
+                "Error sending metadata update {} to {}",
+                r.error().message(),
+                target_id);
+              return;
+          }
+          if (r.value().full_sync_required) {
+              vlog(
+                clusterlog.info,
+                "Node {} requested full leadership metadata sync",
+                target_id);
+              peer.full_sync = true;
+              return;
+          }
+          if (full_sync) {
+              peer.full_sync = false;
+              ++_full_syncs;
+          }
+          peer.acked_version = to_version;
+          peer.behind_since = std::nullopt;
+          _updates_sent += updates;
       })
       .handle_exception([](std::exception_ptr e) {
           vlog(clusterlog.warn, "Error when sending metadata update {}", e);
+      })
+      .finally([this, target_id] {
+          if (auto it = _peers.find(target_id); it != _peers.end()) {
+              it->second.in_flight = false;
+          }
       });
 }
 
+void metadata_dissemination_service::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("cluster:metadata_dissemination"),
+      {sm::make_gauge(
+         "pending_updates",
+         [this] { return _updates.size(); },
+         sm::description(
+           "Number of leadership updates not acknowledged by all nodes")),
+       sm::make_gauge(
+         "max_version_lag",
+         [this] {
+             uint64_t lag = 0;
+             for (auto& [id, peer] : _peers) {
+                 lag = std::max(lag, _version - peer.acked_version);
+             }
+             return lag;
+         },
+         sm::description(
+           "Maximum number of leadership updates a node is behind")),
+       sm::make_gauge(
+         "max_lag_ms",
+         [this] {
+             auto now = ss::lowres_clock::now();
+             ss::lowres_clock::duration lag{0};
+             for (auto& [id, peer] : _peers) {
+                 if (peer.behind_since) {
+                     lag = std::max(lag, now - *peer.behind_since);
+                 }
+             }
+             return std::chrono::duration_cast<std::chrono::milliseconds>(lag)
+               .count();
+         },
+         sm::description("Maximum time a node is behind leadership updates")),
+       sm::make_derive(
+         "full_syncs",
+         [this] { return _full_syncs; },
+         sm::description("Number of full leadership syncs sent to nodes")),
+       sm::make_derive(
+         "updates_sent",
+         [this] { return _updates_sent; },
+         sm::description("Number of leadership updates delivered to nodes"))});
+}
+
 ss::future<> metadata_dissemination_service::stop() {
     _raft_manager.local().unregister_leadership_notification(
       _notification_handle);
@@ -26,6 +26,8 @@
 #include "utils/retry.h"
 
 #include <seastar/core/abort_source.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/sharded.hh>
 
 #include <absl/container/flat_hash_map.h>
@@ -42,6 +44,12 @@ namespace cluster {
 /// responsible for querying one of the cluster nodes for current leadership
 /// metadata when node has started.
 ///
+/// Updates are versioned, the service keeps only the latest update of each
+/// partition and tracks the version acknowledged by every other node, so each
+/// batch carries only updates the receiver has not seen yet. Nodes that lost
+/// the preceding updates, i.e. were restarted, ask for a full sync that is
+/// built from current state of the leaders table.
+///
 /// Used acronymes:
 /// RG<num> - raft group with <num> id
 ///
@@ -90,12 +98,20 @@ public:
     ss::future<> stop();
 
 private:
-    // Used to store pending updates
-    // When update was delivered successfully the finished flag is set to true
-    // and object is removed from pending updates map
-    struct update_retry_meta {
-        ntp_leaders updates;
-        bool finished = false;
+    // Latest leadership update of a partition led by this node
+    struct versioned_update {
+        ntp_leader leader;
+        uint64_t version;
+    };
+    // Dissemination state of other cluster node
+    struct peer_state {
+        // last version acknowledged by the peer
+        uint64_t acked_version{0};
+        // peer has to receive all leaderships, not only the recent updates
+        bool full_sync{true};
+        bool in_flight{false};
+        // time the peer started to lag behind, used to report the lag
+        std::optional<ss::lowres_clock::time_point> behind_since;
     };
     // Used to track the process of requesting update when redpanda starts
     // when update using a node from ids will fail we will try the next one
@@ -108,18 +124,19 @@ private:
         exp_backoff_policy backoff_policy;
     };
 
-    using broker_updates_t
-      = absl::flat_hash_map<model::node_id, update_retry_meta>;
+    using updates_t = absl::flat_hash_map<model::ntp, versioned_update>;
+    using peers_t = absl::flat_hash_map<model::node_id, peer_state>;
+    using requests_t
+      = absl::flat_hash_map<model::node_id, update_leadership_request>;
 
-    void handle_leadership_notification(
-      model::ntp, model::term_id, std::optional<model::node_id>);
-    ss::future<> apply_leadership_notification(
-      model::ntp, model::term_id, std::optional<model::node_id>);
+    void handle_leadership_notification(ntp_leaders);
+    ss::future<> apply_leadership_notification(ntp_leaders);
 
-    void collect_pending_updates();
-    void cleanup_finished_updates();
+    requests_t collect_pending_updates();
+    void prune_acknowledged_updates();
     ss::future<> dispatch_disseminate_leadership();
-    ss::future<> dispatch_one_update(model::node_id, update_retry_meta&);
+    ss::future<> dispatch_one_update(model::node_id, update_leadership_request);
+    void setup_metrics();
     ss::future<result<get_leadership_reply>>
       dispatch_get_metadata_update(model::node_id);
     ss::future<> do_request_metadata_update(request_retry_meta&);
@@ -136,9 +153,13 @@ private:
     ss::sharded<rpc::connection_cache>& _clients;
     model::node_id _self;
     std::chrono::milliseconds _dissemination_interval;
-    std::vector<ntp_leader> _requests;
     std::vector<model::node_id> _seed_server_ids;
-    broker_updates_t _pending_updates;
+    updates_t _updates;
+    uint64_t _version{0};
+    peers_t _peers;
+    uint64_t _full_syncs{0};
+    uint64_t _updates_sent{0};
+    ss::metrics::metric_groups _metrics;
     mutex _lock;
     ss::timer<> _dispatch_timer;
     ss::abort_source _as;
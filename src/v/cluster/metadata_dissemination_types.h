@@ -12,6 +12,7 @@
 #pragma once
 #include "model/fundamental.h"
 #include "model/metadata.h"
+#include "reflection/async_adl.h"
 
 #include <ostream>
 
@@ -25,11 +26,22 @@ struct ntp_leader {
 
 using ntp_leaders = std::vector<ntp_leader>;
 
+/// Leadership updates are versioned by the node sending them. A request
+/// carries updates with versions in (from_version, to_version] that are
+/// relevant for the receiver, from_version equal to zero marks a full sync
+/// of all leaderships the sender is responsible for.
 struct update_leadership_request {
     ntp_leaders leaders;
+    model::node_id source;
+    uint64_t from_version{0};
+    uint64_t to_version{0};
 };
 
-struct update_leadership_reply {};
+struct update_leadership_reply {
+    // receiver does not hold the updates preceding from_version, i.e. it was
+    // restarted, sender is expected to follow up with a full sync
+    bool full_sync_required{false};
+};
 
 struct get_leadership_request {};
 
@@ -43,4 +55,45 @@ inline std::ostream& operator<<(std::ostream& o, const ntp_leader& l) {
     return o;
 }
 
-} // namespace cluster
\ No newline at end of file
+} // namespace cluster
+
+namespace reflection {
+// a full sync carries the leaders of every partition of the node, the vector
+// is (de)serialized in chunks not to stall the reactor. the layout is the one
+// of adl
+template<>
+struct async_adl<cluster::update_leadership_request> {
+    ss::future<> to(iobuf& out, cluster::update_leadership_request&& r) {
+        auto leaders = std::move(r.leaders);
+        return async_adl<cluster::ntp_leaders>{}
+          .to(out, std::move(leaders))
+          .then([&out, r = std::move(r)] {
+              serialize(out, r.source, r.from_version, r.to_version);
+          });
+    }
+    ss::future<cluster::update_leadership_request> from(iobuf_parser& in) {
+        return async_adl<cluster::ntp_leaders>{}.from(in).then(
+          [&in](cluster::ntp_leaders leaders) {
+              cluster::update_leadership_request r;
+              r.leaders = std::move(leaders);
+              r.source = adl<model::node_id>{}.from(in);
+              r.from_version = adl<uint64_t>{}.from(in);
+              r.to_version = adl<uint64_t>{}.from(in);
+              return r;
+          });
+    }
+};
+
+template<>
+struct async_adl<cluster::get_leadership_reply> {
+    ss::future<> to(iobuf& out, cluster::get_leadership_reply&& r) {
+        return async_adl<cluster::ntp_leaders>{}.to(out, std::move(r.leaders));
+    }
+    ss::future<cluster::get_leadership_reply> from(iobuf_parser& in) {
+        return async_adl<cluster::ntp_leaders>{}.from(in).then(
+          [](cluster::ntp_leaders leaders) {
+              return cluster::get_leadership_reply{std::move(leaders)};
+          });
+    }
+};
+} // namespace reflection
@@ -0,0 +1,287 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/node_load_reporter.h"
+
+#include "cluster/controller_service.h"
+#include "cluster/logger.h"
+#include "cluster/partition.h"
+#include "config/configuration.h"
+#include "rpc/types.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/reactor.hh>
+
+#include <boost/range/irange.hpp>
+
+#include <fstream>
+
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace cluster {
+
+struct disk_space {
+    uint64_t free{0};
+    uint64_t total{0};
+};
+
+/// NUMA node of the core the calling thread runs on, shards are pinned
+static int32_t current_numa_node() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return -1;
+    }
+    return static_cast<int32_t>(node);
+}
+
+static bool is_wildcard(const ss::socket_address& addr) {
+    if (addr.family() == AF_INET) {
+        return addr.as_posix_sockaddr_in().sin_addr.s_addr == INADDR_ANY;
+    }
+    return IN6_IS_ADDR_UNSPECIFIED(&addr.as_posix_sockaddr_in6().sin6_addr);
+}
+
+static bool same_host(const sockaddr& a, const ss::socket_address& b) {
+    if (a.sa_family != b.family()) {
+        return false;
+    }
+    if (a.sa_family == AF_INET) {
+        return reinterpret_cast<const sockaddr_in&>(a).sin_addr.s_addr
+               == b.as_posix_sockaddr_in().sin_addr.s_addr;
+    }
+    return a.sa_family == AF_INET6
+           && IN6_ARE_ADDR_EQUAL(
+             &reinterpret_cast<const sockaddr_in6&>(a).sin6_addr,
+             &b.as_posix_sockaddr_in6().sin6_addr);
+}
+
+/// NUMA node of the device of the interface carrying the address, as found
+/// in sysfs. Virtual interfaces and wildcard addresses have none
+static int32_t nic_numa_node(const ss::socket_address& addr) {
+    if (is_wildcard(addr)) {
+        return -1;
+    }
+    ifaddrs* ifs = nullptr;
+    if (::getifaddrs(&ifs) != 0) {
+        return -1;
+    }
+    std::optional<ss::sstring> name;
+    for (auto* i = ifs; i != nullptr; i = i->ifa_next) {
+        if (i->ifa_addr != nullptr && same_host(*i->ifa_addr, addr)) {
+            name = i->ifa_name;
+            break;
+        }
+    }
+    ::freeifaddrs(ifs);
+    if (!name) {
+        return -1;
+    }
+    // a small sysfs attribute, read once at startup
+    std::ifstream f(fmt::format("/sys/class/net/{}/device/numa_node", *name));
+    int32_t node = -1;
+    if (!(f >> node)) {
+        return -1;
+    }
+    return node;
+}
+
+node_load_reporter::node_load_reporter(
+  model::node_id self,
+  ss::sharded<partition_manager>& pm,
+  ss::sharded<members_table>& members,
+  ss::sharded<members_manager>& mm,
+  ss::sharded<rpc::connection_cache>& clients)
+  : _self(self)
+  , _partition_manager(pm)
+  , _members(members)
+  , _members_manager(mm)
+  , _clients(clients)
+  , _interval(config::shard_local_cfg().node_load_report_interval_ms()) {}
+
+ss::future<> node_load_reporter::start() {
+    return config::shard_local_cfg()
+      .kafka_api()
+      .resolve()
+      .then([this](ss::socket_address addr) {
+          _nic_numa_node = nic_numa_node(addr);
+          vlog(
+            clusterlog.info,
+            "Kafka API interface of {} is on NUMA node {}",
+            addr,
+            _nic_numa_node);
+      })
+      .handle_exception([](const std::exception_ptr& e) {
+          vlog(clusterlog.warn, "Unable to find the Kafka API NIC - {}", e);
+      })
+      .then([this] {
+          _timer.set_callback([this] { tick(); });
+          _timer.arm_periodic(_interval);
+      });
+}
+
+ss::future<> node_load_reporter::stop() {
+    _timer.cancel();
+    return _gate.close();
+}
+
+void node_load_reporter::tick() {
+    if (_reporting) {
+        return;
+    }
+    _reporting = true;
+    (void)ss::with_gate(_gate, [this] {
+        return report()
+          .handle_exception([](const std::exception_ptr& e) {
+              vlog(clusterlog.debug, "Error reporting node load - {}", e);
+          })
+          .finally([this] { _reporting = false; });
+    });
+}
+
+ss::future<node_load> node_load_reporter::measure() {
+    auto samples = ss::make_lw_shared<std::vector<shard_sample>>(
+      ss::smp::count);
+    auto f = ss::parallel_for_each(
+      boost::irange<ss::shard_id>(0, ss::smp::count),
+      [this, samples](ss::shard_id s) {
+          return _partition_manager
+            .invoke_on(
+              s,
+              [](partition_manager& pm) {
+                  shard_sample sample{.numa_node = current_numa_node()};
+                  for (auto& [ntp, p] : pm.partitions()) {
+                      if (auto log = pm.log(ntp); log) {
+                          auto offsets = log->offsets();
+                          sample.partitions_bytes += log->size_bytes(
+                            offsets.start_offset, offsets.dirty_offset);
+                      }
+                      sample.produced_records += p->probe().records_produced();
+                  }
+                  return sample;
+              })
+            .then([samples, s](shard_sample sample) {
+                (*samples)[s] = sample;
+            });
+      });
+    return f
+      .then([] {
+          // summed over the disks of all the data directories
+          auto dirs = ss::make_lw_shared<std::vector<ss::sstring>>(
+            config::shard_local_cfg().extra_data_directories());
+          dirs->push_back(
+            config::shard_local_cfg().data_directory().as_sstring());
+          return ss::map_reduce(
+                   dirs->begin(),
+                   dirs->end(),
+                   [](const ss::sstring& dir) {
+                       return ss::engine().statvfs(dir).then(
+                         [](struct statvfs st) {
+                             return disk_space{
+                               .free = uint64_t(st.f_bavail) * st.f_frsize,
+                               .total = uint64_t(st.f_blocks) * st.f_frsize};
+                         });
+                   },
+                   disk_space{},
+                   [](disk_space acc, disk_space d) {
+                       acc.free += d.free;
+                       acc.total += d.total;
+                       return acc;
+                   })
+            .finally([dirs] {});
+      })
+      .then([this, samples](disk_space disk) {
+          const auto now = ss::lowres_clock::now();
+          const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                                 now - _sampled_at)
+                                 .count();
+          node_load load{
+            .id = _self,
+            .disk_free_bytes = disk.free,
+            .disk_total_bytes = disk.total,
+            .nic_numa_node = _nic_numa_node,
+          };
+          load.shards.reserve(samples->size());
+          for (size_t i = 0; i < samples->size(); ++i) {
+              const auto& cur = (*samples)[i];
+              shard_load l{
+                .partitions_bytes = cur.partitions_bytes,
+                .numa_node = cur.numa_node};
+              // the throughput is known from the second report on
+              if (i < _samples.size() && elapsed > 0) {
+                  const auto& prev = _samples[i];
+                  if (cur.produced_records >= prev.produced_records) {
+                      l.produced_records_rate = (cur.produced_records
+                                                 - prev.produced_records)
+                                                / elapsed;
+                  }
+              }
+              load.shards.push_back(l);
+          }
+          _samples = std::move(*samples);
+          _sampled_at = now;
+          return load;
+      });
+}
+
+ss::future<> node_load_reporter::report() {
+    return measure().then([this](node_load load) {
+        return ss::do_with(
+          std::move(load),
+          _members.local().all_broker_ids(),
+          [this](node_load& load, std::vector<model::node_id>& ids) {
+              return ss::parallel_for_each(
+                       ids,
+                       [this, &load](model::node_id id) {
+                           if (id == _self) {
+                               return ss::now();
+                           }
+                           return dispatch(id, load);
+                       })
+                .then([this, &load] {
+                    return _members_manager.invoke_on(
+                      members_manager::shard,
+                      [load](members_manager& mm) mutable {
+                          return mm.handle_node_load_report(std::move(load));
+                      });
+                });
+          });
+    });
+}
+
+ss::future<> node_load_reporter::dispatch(model::node_id id, node_load load) {
+    return _clients.local()
+      .with_node_client<controller_client_protocol>(
+        _self,
+        ss::this_shard_id(),
+        id,
+        [this, load = std::move(load)](controller_client_protocol c) mutable {
+            return c
+              .report_node_load(
+                node_load_report_request{.load = std::move(load)},
+                rpc::client_opts(rpc::clock_type::now() + _interval))
+              .then(&rpc::get_ctx_data<node_load_report_reply>);
+        })
+      .then([id](result<node_load_report_reply> r) {
+          if (!r) {
+              vlog(
+                clusterlog.debug,
+                "Error reporting node load to {} - {}",
+                id,
+                r.error().message());
+          }
+      });
+}
+
+} // namespace cluster
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "cluster/members_manager.h"
+#include "cluster/members_table.h"
+#include "cluster/partition_manager.h"
+#include "cluster/types.h"
+#include "model/metadata.h"
+#include "rpc/connection_cache.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
+#include <vector>
+
+namespace cluster {
+
+/// Periodically measures the load of this node and reports it to all the
+/// cluster members, their partition allocators weight new replicas with it.
+/// The report holds the bytes of the logs and the produce throughput of
+/// every shard and the free space of the data directory disks, with the NUMA
+/// nodes of the cores and of the network interface of the kafka api.
+class node_load_reporter {
+public:
+    static constexpr ss::shard_id shard = 0;
+
+    node_load_reporter(
+      model::node_id self,
+      ss::sharded<partition_manager>&,
+      ss::sharded<members_table>&,
+      ss::sharded<members_manager>&,
+      ss::sharded<rpc::connection_cache>&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+private:
+    // totals measured on a shard
+    struct shard_sample {
+        uint64_t partitions_bytes{0};
+        uint64_t produced_records{0};
+        int32_t numa_node{-1};
+    };
+
+    void tick();
+    ss::future<> report();
+    ss::future<node_load> measure();
+    ss::future<> dispatch(model::node_id, node_load);
+
+    model::node_id _self;
+    ss::sharded<partition_manager>& _partition_manager;
+    ss::sharded<members_table>& _members;
+    ss::sharded<members_manager>& _members_manager;
+    ss::sharded<rpc::connection_cache>& _clients;
+    std::chrono::milliseconds _interval;
+    int32_t _nic_numa_node{-1};
+    // previous samples to compute the produce throughput
+    std::vector<shard_sample> _samples;
+    ss::lowres_clock::time_point _sampled_at;
+    ss::timer<ss::lowres_clock> _timer;
+    bool _reporting{false};
+    ss::gate _gate;
+};
+
+} // namespace cluster
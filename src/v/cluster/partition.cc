@@ -9,8 +9,12 @@
 
 #include "cluster/partition.h"
 
+#include "cluster/errc.h"
 #include "cluster/logger.h"
+#include "cluster/namespace.h"
+#include "config/configuration.h"
 #include "prometheus/prometheus_sanitize.h"
+#include "resource_mgmt/io_priority.h"
 
 namespace cluster {
 
@@ -21,15 +25,22 @@ partition::partition(consensus_ptr r)
         _nop_stm = std::make_unique<raft::log_eviction_stm>(
           _raft.get(), clusterlog, _as);
     }
+    if (
+      config::shard_local_cfg().enable_idempotence()
+      && _raft->ntp().ns == kafka_namespace) {
+        _producer_stm = std::make_unique<producer_state_stm>(
+          _raft.get(), clusterlog, raft_priority());
+    }
 }
 
 ss::future<> partition::start() {
-    _probe.setup_metrics(_raft->ntp());
-
     auto f = _raft->start();
 
     if (_nop_stm != nullptr) {
-        return f.then([this] { return _nop_stm->start(); });
+        f = f.then([this] { return _nop_stm->start(); });
+    }
+    if (_producer_stm != nullptr) {
+        f = f.then([this] { return _producer_stm->start(); });
     }
 
     return f;
@@ -37,12 +48,26 @@ ss::future<> partition::start() {
 
 ss::future<> partition::stop() {
     _as.request_abort();
-    // no state machine
-    if (_nop_stm == nullptr) {
-        return ss::now();
+    auto f = ss::now();
+    if (_nop_stm != nullptr) {
+        f = _nop_stm->stop();
+    }
+    if (_producer_stm != nullptr) {
+        f = f.then([this] { return _producer_stm->stop(); });
     }
+    return f;
+}
 
-    return _nop_stm->stop();
+ss::future<result<raft::replicate_result>> partition::replicate(
+  const model::record_batch_header& hdr,
+  model::record_batch_reader&& r,
+  raft::replicate_options opts) {
+    if (
+      _producer_stm == nullptr
+      || !producer_state_table::is_idempotent(hdr)) {
+        return _raft->replicate(std::move(r), opts);
+    }
+    return _producer_stm->replicate(hdr, std::move(r), opts);
 }
 
 ss::future<std::optional<storage::timequery_result>>
@@ -51,6 +76,21 @@ partition::timequery(model::timestamp t, ss::io_priority_class p) {
     return _raft->timequery(cfg);
 }
 
+ss::future<std::error_code> partition::prefix_truncate(
+  model::offset start_offset, model::timeout_clock::time_point deadline) {
+    if (_nop_stm == nullptr) {
+        return ss::make_ready_future<std::error_code>(
+          make_error_code(errc::topic_invalid_config));
+    }
+    return _nop_stm->truncate(start_offset, deadline);
+}
+
+ss::future<std::optional<storage::key_lookup_result>>
+partition::lookup_key(bytes key, ss::io_priority_class p) {
+    storage::key_lookup_config cfg(std::move(key), high_watermark(), p);
+    return _raft->lookup_key(std::move(cfg));
+}
+
 std::ostream& operator<<(std::ostream& o, const partition& x) {
     return o << x._raft;
 }
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "cluster/partition_probe.h"
+#include "cluster/producer_state_stm.h"
 #include "cluster/types.h"
 #include "model/record_batch_reader.h"
 #include "raft/configuration.h"
@@ -38,6 +39,16 @@ public:
         return _raft->replicate(std::move(r), std::move(opts));
     }
 
+    /// \brief replicates a batch of an idempotent producer, see
+    /// producer_state_stm::replicate
+    ss::future<result<raft::replicate_result>> replicate(
+      const model::record_batch_header&,
+      model::record_batch_reader&&,
+      raft::replicate_options);
+
+    /// \brief true when the batches of idempotent producers are deduplicated
+    bool is_idempotence_enabled() const { return _producer_stm != nullptr; }
+
     /**
      * The reader is modified such that the max offset is configured to be
      * the minimum of the max offset requested and the committed index of the
@@ -89,13 +100,45 @@ public:
      */
     model::offset high_watermark() const { return _raft->last_visible_index(); }
 
+    /**
+     * Wait until the high watermark reaches the given offset. Used by long
+     * polling consumers to park until new data becomes visible.
+     */
+    ss::future<> wait_for_high_watermark(
+      model::offset offset, model::timeout_clock::time_point deadline) {
+        return _raft->wait_for_visible_offset(offset, deadline);
+    }
+
     const model::ntp& ntp() const { return _raft->ntp(); }
 
+    const storage::ntp_config& log_config() const {
+        return _raft->log_config();
+    }
+
+    const storage::log& log() const { return _raft->log(); }
+
     ss::future<std::optional<storage::timequery_result>>
       timequery(model::timestamp, ss::io_priority_class);
 
+    /// latest record of `key` visible to consumers, see
+    /// storage::log::lookup_key
+    ss::future<std::optional<storage::key_lookup_result>>
+      lookup_key(bytes key, ss::io_priority_class);
+
+    /// \brief removes the records below `start_offset` on all the replicas,
+    /// the log of the topic must be collectable, see
+    /// raft::log_eviction_stm::truncate
+    ss::future<std::error_code> prefix_truncate(
+      model::offset start_offset, model::timeout_clock::time_point deadline);
+
     bool is_leader() const { return _raft->is_leader(); }
 
+    /// \brief see raft::consensus::linearizable_barrier
+    ss::future<result<model::offset>>
+    linearizable_barrier(raft::clock_type::time_point deadline) {
+        return _raft->linearizable_barrier(deadline);
+    }
+
     ss::future<std::error_code>
     transfer_leadership(std::optional<model::node_id> target) {
         return _raft->transfer_leadership(target);
@@ -112,6 +155,10 @@ public:
 
     partition_probe& probe() { return _probe; }
 
+    raft::produce_latency_probe& produce_latency() {
+        return _raft->produce_latency();
+    }
+
 private:
     friend partition_manager;
 
@@ -120,6 +167,7 @@ private:
 private:
     consensus_ptr _raft;
     std::unique_ptr<raft::log_eviction_stm> _nop_stm;
+    std::unique_ptr<producer_state_stm> _producer_stm;
     ss::abort_source _as;
     partition_probe _probe;
 
@@ -10,6 +10,7 @@
 #include "cluster/partition_allocator.h"
 
 #include "cluster/logger.h"
+#include "cluster/namespace.h"
 #include "vlog.h"
 
 #include <boost/container_hash/hash.hpp>
@@ -63,7 +64,8 @@ static bool is_machine_in_replicas(
 }
 
 std::optional<std::vector<model::broker_shard>>
-partition_allocator::allocate_replicas(int16_t replication_factor) {
+partition_allocator::allocate_replicas(
+  int16_t replication_factor, topic_spread* spread) {
     std::vector<model::broker_shard> replicas;
     replicas.reserve(replication_factor);
 
@@ -73,13 +75,55 @@ partition_allocator::allocate_replicas(int16_t replication_factor) {
             rollback(replicas);
             return std::nullopt;
         }
+        // the least loaded node which does not hold a replica yet, ties are
+        // broken in round robin order
         auto& rr = round_robin_ptr();
-        auto& machine = *rr;
-        rr++;
-        if (is_machine_in_replicas(machine, replicas)) {
-            continue;
+        auto it = rr;
+        auto chosen = _available_machines.end();
+        std::pair<double, double> min_score{
+          std::numeric_limits<double>::max(),
+          std::numeric_limits<double>::max()};
+        // replicas of the topic per core of the node
+        auto placed = [spread](const allocation_node& n) -> double {
+            if (!spread) {
+                return 0;
+            }
+            auto found = spread->find(n.id());
+            if (found == spread->end()) {
+                return 0;
+            }
+            return double(std::accumulate(
+                     found->second.begin(), found->second.end(), uint32_t(0)))
+                   / n.cpus();
+        };
+        for (size_t i = 0; i < _available_machines.size(); ++i) {
+            if (it == _available_machines.end()) {
+                it = _available_machines.begin();
+            }
+            const std::pair<double, double> score{placed(*it), it->score()};
+            if (
+              !it->is_disk_full() && score < min_score
+              && !is_machine_in_replicas(*it, replicas)) {
+                chosen = it;
+                min_score = score;
+            }
+            ++it;
+        }
+        if (chosen == _available_machines.end()) {
+            rollback(replicas);
+            return std::nullopt;
+        }
+        auto& machine = *chosen;
+        rr = std::next(chosen);
+        uint32_t cpu = 0;
+        if (spread) {
+            auto& cores = (*spread)[machine.id()];
+            cores.resize(machine.cpus());
+            cpu = machine.allocate(&cores);
+            ++cores[cpu];
+        } else {
+            cpu = machine.allocate();
         }
-        const uint32_t cpu = machine.allocate();
         model::broker_shard bs{.node_id = machine.id(), .shard = cpu};
         replicas.push_back(bs);
         if (machine.is_full()) {
@@ -116,10 +160,24 @@ partition_allocator::allocate(const topic_configuration& cfg) {
     }
     std::vector<partition_assignment> ret;
     ret.reserve(cfg.partition_count);
+    /**
+     * The partitions of the group topic are the coordinators of the consumer
+     * groups, their requests come from the connections on every core. They
+     * are spread evenly over the nodes and cores of the cluster rather than
+     * packed on the least loaded ones, so that no core serves the groups of
+     * several coordinators while others serve none.
+     */
+    std::optional<topic_spread> spread;
+    if (
+      cfg.tp_ns.ns == kafka_internal_namespace
+      && cfg.tp_ns.tp == kafka_group_topic) {
+        spread.emplace();
+    }
     for (int32_t i = 0; i < cfg.partition_count; ++i) {
         // all replicas must belong to the same raft group
         raft::group_id partition_group = raft::group_id(_highest_group() + 1);
-        auto replicas_assignment = allocate_replicas(cfg.replication_factor);
+        auto replicas_assignment = allocate_replicas(
+          cfg.replication_factor, spread ? &*spread : nullptr);
         if (replicas_assignment == std::nullopt) {
             rollback(ret);
             return std::nullopt;
@@ -200,12 +258,62 @@ partition_allocator::find_node(model::node_id id) {
     return _machines.find(id);
 }
 
+void partition_allocator::update_node_load(const node_load& load) {
+    auto it = find_node(load.id);
+    if (it == _machines.end()) {
+        return;
+    }
+    auto& machine = *it->second;
+    const auto cores = std::min<size_t>(load.shards.size(), machine.cpus());
+    std::fill(machine._load.begin(), machine._load.end(), shard_load{});
+    std::copy_n(load.shards.begin(), cores, machine._load.begin());
+    machine._disk_free_ratio
+      = load.disk_total_bytes == 0
+          ? 1.0
+          : double(load.disk_free_bytes) / load.disk_total_bytes;
+    machine._nic_numa_node = load.nic_numa_node;
+    update_load_weights();
+}
+
+void partition_allocator::update_load_weights() {
+    // the reported bytes and throughput are converted to the number of
+    // partitions of average size and throughput they amount to, so that
+    // they add up with the allocation counts of the cores
+    uint64_t partitions = 0;
+    double bytes = 0;
+    double rate = 0;
+    for (auto& [_, m] : _machines) {
+        partitions += m->_total_weight;
+        for (auto& l : m->_load) {
+            bytes += l.partitions_bytes;
+            rate += l.produced_records_rate;
+        }
+    }
+    const double dimensions = (bytes > 0) + (rate > 0);
+    for (auto& [_, m] : _machines) {
+        m->_total_load_weight = 0;
+        for (size_t c = 0; c < m->_load.size(); ++c) {
+            double w = 0;
+            if (bytes > 0) {
+                w += m->_load[c].partitions_bytes * partitions / bytes;
+            }
+            if (rate > 0) {
+                w += m->_load[c].produced_records_rate * partitions / rate;
+            }
+            m->_load_weights[c] = dimensions > 0 ? w / dimensions : 0;
+            m->_total_load_weight += m->_load_weights[c];
+        }
+    }
+}
+
 void partition_allocator::test_only_saturate_all_machines() {
     for (auto& [id, m] : _machines) {
         m->_partition_capacity = 0;
         for (auto& w : m->_weights) {
             w = allocation_node::max_allocations_per_core;
         }
+        m->_total_weight = uint64_t(allocation_node::max_allocations_per_core)
+                           * m->cpus();
     }
     _available_machines.clear();
 }
@@ -229,7 +337,9 @@ std::ostream& operator<<(std::ostream& o, const allocation_node& n) {
     for (auto w : n._weights) {
         o << "(" << w << ")";
     }
-    return o << "]}";
+    return o << "], load_weight: " << n._total_load_weight
+             << ", disk_free_ratio: " << n._disk_free_ratio
+             << ", nic_numa_node: " << n._nic_numa_node << "}";
 }
 
 } // namespace cluster
@@ -16,9 +16,12 @@
 #include "utils/intrusive_list_helpers.h"
 #include "vassert.h"
 
+#include <absl/container/flat_hash_map.h>
 #include <boost/container/flat_map.hpp>
 #include <fmt/ostream.h>
 
+#include <limits>
+#include <utility>
 #include <vector>
 
 namespace cluster {
@@ -36,9 +39,12 @@ public:
       std::unordered_map<ss::sstring, ss::sstring> labels)
       : _id(id)
       , _weights(cpus)
+      , _load(cpus)
+      , _load_weights(cpus, 0.0)
       , _machine_labels(std::move(labels)) {
         // add extra weights to core 0
         _weights[0] = core0_extra_weight;
+        _total_weight = core0_extra_weight;
         _partition_capacity = (cpus * max_allocations_per_core)
                               - core0_extra_weight;
     }
@@ -46,6 +52,12 @@ public:
     allocation_node(allocation_node&& o) noexcept
       : _id(o._id)
       , _weights(std::move(o._weights))
+      , _total_weight(o._total_weight)
+      , _load(std::move(o._load))
+      , _load_weights(std::move(o._load_weights))
+      , _total_load_weight(o._total_load_weight)
+      , _disk_free_ratio(o._disk_free_ratio)
+      , _nic_numa_node(o._nic_numa_node)
       , _partition_capacity(o._partition_capacity)
       , _machine_labels(std::move(o._machine_labels)) {
         _hook.swap_nodes(o._hook);
@@ -59,9 +71,33 @@ public:
     model::node_id id() const { return _id; }
     uint32_t partition_capacity() const { return _partition_capacity; }
 
+    /// Allocations and reported load per core, compared between nodes to
+    /// place new replicas. Cores are the capacity, a node with twice the
+    /// cores takes twice the load. The less disk is free the more loaded
+    /// the node looks
+    double score() const {
+        return (_total_weight + _total_load_weight) / cpus()
+               / std::max(_disk_free_ratio, min_disk_free_ratio);
+    }
+
+    /// Nodes running out of disk are not given new replicas
+    bool is_disk_full() const {
+        return _disk_free_ratio < min_disk_free_ratio;
+    }
+
 private:
     friend partition_allocator;
 
+    static constexpr double min_disk_free_ratio = 0.05;
+    // cores on another socket than the kafka api NIC look this much more
+    // loaded, their produce traffic crosses the interconnect
+    static constexpr double remote_numa_penalty = 1.25;
+
+    bool is_remote_core(uint32_t core) const {
+        const auto numa = _load[core].numa_node;
+        return _nic_numa_node >= 0 && numa >= 0 && numa != _nic_numa_node;
+    }
+
     bool is_full() const {
         for (uint32_t w : _weights) {
             if (w != max_allocations_per_core) {
@@ -70,11 +106,29 @@ private:
         }
         return true;
     }
-    uint32_t allocate() {
-        auto it = std::min_element(_weights.begin(), _weights.end());
-        (*it)++; // increment the weights
-        _partition_capacity--;
-        return std::distance(_weights.begin(), it);
+    /// \brief the core of a new replica, with `spread` the cores holding
+    ///        the fewest of the replicas counted there come first
+    uint32_t allocate(const std::vector<uint32_t>* spread = nullptr) {
+        // the least loaded core which is not full, counting the new replica
+        // so that cores local to the NIC win ties between idle cores
+        uint32_t core = 0;
+        std::pair<uint32_t, double> min_score{
+          std::numeric_limits<uint32_t>::max(),
+          std::numeric_limits<double>::max()};
+        for (uint32_t c = 0; c < _weights.size(); ++c) {
+            double s = _weights[c] + _load_weights[c] + 1;
+            if (is_remote_core(c)) {
+                s *= remote_numa_penalty;
+            }
+            const std::pair<uint32_t, double> score{
+              spread ? (*spread)[c] : 0, s};
+            if (_weights[c] < max_allocations_per_core && score < min_score) {
+                core = c;
+                min_score = score;
+            }
+        }
+        allocate(core);
+        return core;
     }
     void deallocate(uint32_t core) {
         vassert(
@@ -84,6 +138,7 @@ private:
           *this);
         _partition_capacity++;
         _weights[core]--;
+        _total_weight--;
     }
     void allocate(uint32_t core) {
         vassert(
@@ -92,6 +147,7 @@ private:
           core,
           *this);
         _weights[core]++;
+        _total_weight++;
         _partition_capacity--;
     }
     const std::unordered_map<ss::sstring, ss::sstring>& machine_labels() const {
@@ -101,6 +157,16 @@ private:
     model::node_id _id;
     /// each index is a CPU. A weight is roughly the number of assigments
     std::vector<uint32_t> _weights;
+    uint64_t _total_weight{0};
+    /// last load reported by the node for each CPU
+    std::vector<shard_load> _load;
+    /// reported load of each CPU expressed in average partitions, set by
+    /// the partition allocator relative to the load of the whole cluster
+    std::vector<double> _load_weights;
+    double _total_load_weight{0};
+    double _disk_free_ratio{1.0};
+    /// NUMA node of the NIC of the kafka api, -1 when unknown
+    int32_t _nic_numa_node{-1};
     uint32_t _partition_capacity{0};
     /// generated by `rpk` usually in /etc/redpanda/machine_labels.json
     std::unordered_map<ss::sstring, ss::sstring> _machine_labels;
@@ -183,6 +249,11 @@ public:
 
     const underlying_t& allocation_nodes() { return _machines; }
 
+    /// Updates the load reported by a node, load of unknown nodes is
+    /// ignored. Until a node reported its load only the number of
+    /// allocations is considered
+    void update_node_load(const node_load&);
+
     ~partition_allocator() {
         _available_machines.clear();
         _rr = _available_machines.end();
@@ -196,9 +267,16 @@ private:
     void rollback(const std::vector<partition_assignment>& pa);
     void rollback(const std::vector<model::broker_shard>& v);
 
-    std::optional<std::vector<model::broker_shard>>
-    allocate_replicas(int16_t replication_factor);
+    /// replicas of a topic placed so far by node and core
+    using topic_spread
+      = absl::flat_hash_map<model::node_id, std::vector<uint32_t>>;
+
+    /// \brief with `spread` the nodes and cores with the fewest replicas of
+    ///        the topic come first, the load only breaks ties
+    std::optional<std::vector<model::broker_shard>> allocate_replicas(
+      int16_t replication_factor, topic_spread* spread = nullptr);
     iterator find_node(model::node_id id);
+    void update_load_weights();
 
     [[gnu::always_inline]] inline cil_t::iterator& round_robin_ptr() {
         if (_rr == _available_machines.end()) {
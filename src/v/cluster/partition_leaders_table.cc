@@ -56,6 +56,7 @@ void partition_leaders_table::update_partition_leader(
           leader_key{
             model::topic_namespace(ntp.ns, ntp.tp.topic), ntp.tp.partition},
           leader_meta{leader_id, term});
+        bump_revision(model::topic_namespace_view(ntp));
         it = new_it;
     }
 
@@ -64,6 +65,9 @@ void partition_leaders_table::update_partition_leader(
         return;
     }
     // existing partition
+    if (it->second.id != leader_id || it->second.update_term != term) {
+        bump_revision(model::topic_namespace_view(ntp));
+    }
     it->second.id = leader_id;
     it->second.update_term = term;
 
@@ -79,6 +83,22 @@ void partition_leaders_table::update_partition_leader(
     }
 }
 
+uint64_t partition_leaders_table::get_topic_revision(
+  model::topic_namespace_view tp_ns) const {
+    if (auto it = _revisions.find(tp_ns); it != _revisions.end()) {
+        return it->second;
+    }
+    return 0;
+}
+
+void partition_leaders_table::bump_revision(model::topic_namespace_view tp_ns) {
+    if (auto it = _revisions.find(tp_ns); it != _revisions.end()) {
+        it->second = ++_revision;
+        return;
+    }
+    _revisions.emplace(model::topic_namespace(tp_ns), ++_revision);
+}
+
 ss::future<model::node_id> partition_leaders_table::wait_for_leader(
   const model::ntp& ntp,
   ss::lowres_clock::time_point timeout,
@@ -61,12 +61,32 @@ public:
     void remove_leader(const model::ntp& ntp) {
         _leaders.erase(
           leader_key_view{model::topic_namespace_view(ntp), ntp.tp.partition});
+        bump_revision(model::topic_namespace_view(ntp));
     }
 
     void update_partition_leader(
       const model::ntp&, model::term_id, std::optional<model::node_id>);
 
+    /// Returns a revision of the leaders of the topic partitions that changes
+    /// whenever one of them does. Zero if no leader of the topic was ever set
+    uint64_t get_topic_revision(model::topic_namespace_view) const;
+
+    /// Returns the version of last leadership updates applied from a peer,
+    /// empty if no updates were received from the peer since this node started
+    std::optional<uint64_t> get_peer_version(model::node_id id) const {
+        if (auto it = _peer_versions.find(id); it != _peer_versions.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    void set_peer_version(model::node_id id, uint64_t version) {
+        _peer_versions[id] = version;
+    }
+
 private:
+    void bump_revision(model::topic_namespace_view);
+
     // optimized to reduce number of ntp copies
     struct leader_key {
         model::topic_namespace tp_ns;
@@ -131,6 +151,18 @@ private:
     absl::flat_hash_map<leader_key, leader_meta, leader_key_hash, leader_key_eq>
       _leaders;
 
+    // per topic revisions drawn from a shard local counter
+    absl::flat_hash_map<
+      model::topic_namespace,
+      uint64_t,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      _revisions;
+    uint64_t _revision{0};
+
+    // versions of leadership updates disseminated by other nodes
+    absl::flat_hash_map<model::node_id, uint64_t> _peer_versions;
+
     // per-ntp notifications for leadership election. note that the
     // namespace is currently ignored pending an update to the metadata
     // cache that attaches a namespace to all topics partition references.
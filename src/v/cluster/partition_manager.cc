@@ -13,6 +13,7 @@
 #include "config/configuration.h"
 #include "model/metadata.h"
 #include "raft/consensus.h"
+#include "raft/consensus_utils.h"
 #include "raft/log_eviction_stm.h"
 #include "raft/rpc_client_protocol.h"
 #include "raft/types.h"
@@ -28,7 +29,14 @@ namespace cluster {
 partition_manager::partition_manager(
   ss::sharded<storage::api>& storage, ss::sharded<raft::group_manager>& raft)
   : _storage(storage.local())
-  , _raft_manager(raft) {}
+  , _raft_manager(raft)
+  , _probes(partition_probes::config{
+      .aggregate = config::shard_local_cfg().aggregate_partition_metrics(),
+      .detail_limit
+      = config::shard_local_cfg().partition_metrics_detail_limit(),
+      .rank_interval
+      = config::shard_local_cfg().partition_metrics_rank_interval_ms(),
+    }) {}
 
 ss::future<consensus_ptr> partition_manager::manage(
   storage::ntp_config ntp_cfg,
@@ -45,12 +53,14 @@ ss::future<consensus_ptr> partition_manager::manage(
                 _ntp_table.emplace(log.config().ntp(), p);
                 _raft_table.emplace(group, p);
                 _manage_watchers.notify(p->ntp(), p);
+                _probes.add(p->probe(), p->ntp());
                 return p->start().then([c] { return c; });
             });
       });
 }
 
 ss::future<> partition_manager::stop() {
+    _probes.stop();
     return ss::parallel_for_each(
       _ntp_table, [](auto& p) { return p.second->stop(); });
 }
@@ -77,6 +87,73 @@ ss::future<> partition_manager::remove(const model::ntp& ntp) {
       .finally([partition] {}); // in the end remove partition
 }
 
+ss::future<partition_handover>
+partition_manager::shutdown(const model::ntp& ntp) {
+    auto partition = get(ntp);
+    auto log = _storage.log_mgr().get(ntp);
+    if (!partition || !log) {
+        return ss::make_exception_future<partition_handover>(
+          std::invalid_argument(fmt::format(
+            "Can not shutdown partition. NTP {} is not present in partition "
+            "manager",
+            ntp)));
+    }
+    partition_handover handover{
+      .ntp_cfg = log->config().copy(),
+      .group = partition->group(),
+      .brokers = partition->group_configuration().brokers()};
+
+    _ntp_table.erase(ntp);
+    _raft_table.erase(handover.group);
+
+    return _raft_manager.local()
+      .shutdown(partition->raft())
+      .then([partition] { return partition->stop(); })
+      .then([this, ntp] { return _storage.log_mgr().shutdown(ntp); })
+      .then([this, handover = std::move(handover)]() mutable {
+          // read once stopped, the group does not update its state anymore
+          auto read = [this, &handover](
+                        storage::kvstore::key_space ks,
+                        std::vector<bytes> keys) {
+              for (auto& key : keys) {
+                  auto value = _storage.kvs().get(ks, key);
+                  if (!value) {
+                      continue;
+                  }
+                  handover.kvstore_entries.push_back(
+                    partition_handover::kvstore_entry{
+                      .ks = ks,
+                      .key = std::move(key),
+                      .value = iobuf_to_bytes(*value)});
+              }
+          };
+          read(
+            storage::kvstore::key_space::consensus,
+            raft::details::persistent_state_keys(handover.group));
+          read(
+            storage::kvstore::key_space::storage,
+            storage::log_manager::kvstore_keys(handover.ntp_cfg.ntp()));
+          return std::move(handover);
+      })
+      .finally([partition] {});
+}
+
+ss::future<>
+partition_manager::import_persistent_state(const partition_handover& h) {
+    return ss::do_for_each(
+      h.kvstore_entries, [this](const partition_handover::kvstore_entry& e) {
+          return _storage.kvs().put(e.ks, e.key, bytes_to_iobuf(e.value));
+      });
+}
+
+ss::future<>
+partition_manager::remove_persistent_state(const partition_handover& h) {
+    return ss::do_for_each(
+      h.kvstore_entries, [this](const partition_handover::kvstore_entry& e) {
+          return _storage.kvs().remove(e.ks, e.key);
+      });
+}
+
 std::ostream& operator<<(std::ostream& o, const partition_manager& pm) {
     return o << "{shard:" << ss::this_shard_id() << ", mngr:{}"
              << pm._storage.log_mgr()
@@ -24,6 +24,22 @@
 #include <absl/container/flat_hash_map.h>
 
 namespace cluster {
+
+/// Partition stopped on one shard of the node to be managed on another
+struct partition_handover {
+    struct kvstore_entry {
+        storage::kvstore::key_space ks;
+        bytes key;
+        bytes value;
+    };
+
+    storage::ntp_config ntp_cfg;
+    raft::group_id group;
+    std::vector<model::broker> brokers;
+    // state of the raft group and of the log kept in the kvstore of the shard
+    std::vector<kvstore_entry> kvstore_entries;
+};
+
 class partition_manager {
 public:
     partition_manager(
@@ -55,6 +71,11 @@ public:
         return nullptr;
     }
 
+    const absl::flat_hash_map<model::ntp, ss::lw_shared_ptr<partition>>&
+    partitions() const {
+        return _ntp_table;
+    }
+
     ss::future<> start() { return ss::now(); }
     ss::future<> stop();
     ss::future<consensus_ptr>
@@ -62,6 +83,17 @@ public:
 
     ss::future<> remove(const model::ntp& ntp);
 
+    /**
+     * Stops the partition and its log and reads its kvstore state, leaving
+     * the state and the files in place. The partition manager of another
+     * shard takes over by importing the state and managing the partition.
+     */
+    ss::future<partition_handover> shutdown(const model::ntp& ntp);
+    /// Writes the kvstore state of a handover into the kvstore of this shard
+    ss::future<> import_persistent_state(const partition_handover&);
+    /// Removes the kvstore state of a handover from this shard
+    ss::future<> remove_persistent_state(const partition_handover&);
+
     std::optional<storage::log> log(const model::ntp& ntp) {
         return _storage.log_mgr().get(ntp);
     }
@@ -104,6 +136,7 @@ private:
     ss::sharded<raft::group_manager>& _raft_manager;
 
     ntp_callbacks<manage_cb_t> _manage_watchers;
+    partition_probes _probes;
     // XXX use intrusive containers here
     absl::flat_hash_map<model::ntp, ss::lw_shared_ptr<partition>> _ntp_table;
     absl::flat_hash_map<raft::group_id, ss::lw_shared_ptr<partition>>
@@ -15,7 +15,37 @@
 
 #include <seastar/core/metrics.hh>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace cluster {
+partition_counters&
+partition_counters::operator-=(const partition_counters& o) {
+    // the partition restarted on the shard in between, counts from zero
+    auto sub = [](uint64_t a, uint64_t b) { return a >= b ? a - b : a; };
+    produce_bytes = sub(produce_bytes, o.produce_bytes);
+    fetch_bytes = sub(fetch_bytes, o.fetch_bytes);
+    requests = sub(requests, o.requests);
+    cache_misses = sub(cache_misses, o.cache_misses);
+    return *this;
+}
+
+partition_counters partition_probe::counters() const {
+    return partition_counters{
+      .produce_bytes = _produce_bytes,
+      .fetch_bytes = _fetch_bytes,
+      .requests = _requests,
+      .cache_misses = _partition.log().batch_cache_misses(),
+    };
+}
+
+partition_probe::~partition_probe() noexcept {
+    if (_topic_hook.is_linked()) {
+        _topic->remove(*this);
+    }
+}
+
 void partition_probe::setup_metrics(const model::ntp& ntp) {
     namespace sm = ss::metrics;
 
@@ -64,4 +94,145 @@ void partition_probe::setup_metrics(const model::ntp& ntp) {
           labels),
       });
 }
+
+topic_probe::topic_probe(const model::topic_namespace& tp_ns) {
+    setup_metrics(tp_ns);
+}
+
+void topic_probe::add(partition_probe& p) {
+    p._topic = this;
+    _partitions.push_back(p);
+}
+
+void topic_probe::remove(partition_probe& p) {
+    _removed_records_produced += p._records_produced;
+    _removed_records_fetched += p._records_fetched;
+    p._topic_hook.unlink();
+    p._topic = nullptr;
+}
+
+uint64_t topic_probe::records_produced() const {
+    auto records = _removed_records_produced;
+    for (const auto& p : _partitions) {
+        records += p._records_produced;
+    }
+    return records;
+}
+
+uint64_t topic_probe::records_fetched() const {
+    auto records = _removed_records_fetched;
+    for (const auto& p : _partitions) {
+        records += p._records_fetched;
+    }
+    return records;
+}
+
+size_t topic_probe::leaders() const {
+    return std::count_if(
+      _partitions.begin(),
+      _partitions.end(),
+      [](const partition_probe& p) { return p._partition.is_leader(); });
+}
+
+void topic_probe::setup_metrics(const model::topic_namespace& tp_ns) {
+    namespace sm = ss::metrics;
+
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    auto ns_label = sm::label("namespace");
+    auto topic_label = sm::label("topic");
+
+    const std::vector<sm::label_instance> labels = {
+      ns_label(tp_ns.ns()),
+      topic_label(tp_ns.tp()),
+    };
+
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("cluster:topic"),
+      {
+        sm::make_gauge(
+          "partitions",
+          [this] { return _partitions.size(); },
+          sm::description("Number of partitions of the topic on the shard"),
+          labels),
+        sm::make_gauge(
+          "leaders",
+          [this] { return leaders(); },
+          sm::description("Number of partitions of the topic on the shard "
+                          "this node leads"),
+          labels),
+        sm::make_derive(
+          "records_produced",
+          [this] { return records_produced(); },
+          sm::description("Total number of records produced to the topic"),
+          labels),
+        sm::make_derive(
+          "records_fetched",
+          [this] { return records_fetched(); },
+          sm::description("Total number of records fetched from the topic"),
+          labels),
+      });
+}
+
+partition_probes::partition_probes(config cfg)
+  : _cfg(cfg) {
+    if (_cfg.aggregate && _cfg.rank_interval.count() > 0) {
+        _rank_timer.set_callback([this] { rank(); });
+        _rank_timer.arm_periodic(_cfg.rank_interval);
+    }
+}
+
+void partition_probes::add(partition_probe& p, const model::ntp& ntp) {
+    if (!_cfg.aggregate) {
+        p.setup_metrics(ntp);
+        return;
+    }
+    auto it = _topics.find(model::topic_namespace_view(ntp));
+    if (it == _topics.end()) {
+        auto tp_ns = model::topic_namespace(ntp.ns, ntp.tp.topic);
+        it = _topics.try_emplace(tp_ns, tp_ns).first;
+    }
+    it->second.add(p);
+}
+
+void partition_probes::rank() {
+    std::vector<std::pair<uint64_t, partition_probe*>> busy;
+    for (auto it = _topics.begin(); it != _topics.end();) {
+        if (it->second._partitions.empty()) {
+            _topics.erase(it++);
+            continue;
+        }
+        for (auto& p : it->second._partitions) {
+            const auto records = p._records_produced + p._records_fetched;
+            const auto delta = records
+                               - std::exchange(p._ranked_records, records);
+            if (delta > 0) {
+                busy.emplace_back(delta, &p);
+            } else if (p._detailed) {
+                p._detailed = false;
+                p.clear_metrics();
+            }
+        }
+        ++it;
+    }
+    const auto n = std::min(_cfg.detail_limit, busy.size());
+    std::nth_element(
+      busy.begin(),
+      busy.begin() + n,
+      busy.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; i < busy.size(); ++i) {
+        auto& p = *busy[i].second;
+        if (i < n && !p._detailed) {
+            p._detailed = true;
+            p.setup_metrics(p._partition.ntp());
+        } else if (i >= n && p._detailed) {
+            p._detailed = false;
+            p.clear_metrics();
+        }
+    }
+    _detailed = n;
+}
 } // namespace cluster
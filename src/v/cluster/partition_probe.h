@@ -11,34 +11,160 @@
 
 #pragma once
 #include "model/fundamental.h"
+#include "model/metadata.h"
+#include "utils/intrusive_list_helpers.h"
 
+#include <seastar/core/lowres_clock.hh>
 #include <seastar/core/metrics_registration.hh>
+#include <seastar/core/timer.hh>
 
+#include <absl/container/node_hash_map.h>
+
+#include <chrono>
 #include <cstdint>
 
 namespace cluster {
 
 class partition;
+class topic_probe;
+
+/// \brief counters of a partition since it started on the shard. They are
+/// plain integers bumped by the kafka handlers, a sample is the difference
+/// of two snapshots
+struct partition_counters {
+    uint64_t produce_bytes{0};
+    uint64_t fetch_bytes{0};
+    uint64_t requests{0};
+    uint64_t cache_misses{0};
+
+    partition_counters& operator-=(const partition_counters&);
+};
 
 class partition_probe {
 public:
     explicit partition_probe(partition& partition)
       : _partition(partition) {}
+    partition_probe(const partition_probe&) = delete;
+    partition_probe& operator=(const partition_probe&) = delete;
+    partition_probe(partition_probe&&) = delete;
+    partition_probe& operator=(partition_probe&&) = delete;
+    ~partition_probe() noexcept;
 
     void setup_metrics(const model::ntp&);
+    void clear_metrics() { _metrics.clear(); }
 
     void add_records_produced(uint64_t num_records) {
         _records_produced += num_records;
     }
 
+    uint64_t records_produced() const { return _records_produced; }
+
     void add_records_fetched(uint64_t num_records) {
         _records_fetched += num_records;
     }
 
+    void add_bytes_produced(uint64_t bytes) { _produce_bytes += bytes; }
+    void add_bytes_fetched(uint64_t bytes) { _fetch_bytes += bytes; }
+    /// a produce or fetch of the partition
+    void request() { ++_requests; }
+
+    partition_counters counters() const;
+
 private:
+    friend class topic_probe;
+    friend class partition_probes;
+
     partition& _partition;
     uint64_t _records_produced = 0;
     uint64_t _records_fetched = 0;
+    uint64_t _produce_bytes = 0;
+    uint64_t _fetch_bytes = 0;
+    uint64_t _requests = 0;
+    ss::metrics::metric_groups _metrics;
+
+    // set while the metrics of the partition are aggregated into its topic
+    topic_probe* _topic{nullptr};
+    intrusive_list_hook _topic_hook;
+    // records produced and fetched when the partition was last ranked
+    uint64_t _ranked_records{0};
+    bool _detailed{false};
+};
+
+/**
+ * Sums of the metrics of the partitions of a topic on this shard.
+ *
+ * The counters of the partitions which left the shard are kept, the sums do
+ * not go backwards when a partition moves away.
+ */
+class topic_probe {
+public:
+    explicit topic_probe(const model::topic_namespace&);
+    topic_probe(const topic_probe&) = delete;
+    topic_probe& operator=(const topic_probe&) = delete;
+    topic_probe(topic_probe&&) = delete;
+    topic_probe& operator=(topic_probe&&) = delete;
+    ~topic_probe() noexcept = default;
+
+    void add(partition_probe&);
+    /// \brief keeps the counters of a partition which is going away
+    void remove(partition_probe&);
+
+private:
+    friend class partition_probes;
+
+    uint64_t records_produced() const;
+    uint64_t records_fetched() const;
+    size_t leaders() const;
+    void setup_metrics(const model::topic_namespace&);
+
+    intrusive_list<partition_probe, &partition_probe::_topic_hook> _partitions;
+    uint64_t _removed_records_produced{0};
+    uint64_t _removed_records_fetched{0};
     ss::metrics::metric_groups _metrics;
 };
+
+/**
+ * The metrics of the partitions of a shard, bounded in cardinality.
+ *
+ * When aggregating, the partitions are summed into a series per topic and
+ * the detail of a partition is registered only while it ranks among the
+ * `detail_limit` partitions of the shard with the most records produced and
+ * fetched in the last `rank_interval`. An idle partition registers nothing.
+ */
+class partition_probes {
+public:
+    struct config {
+        bool aggregate{false};
+        size_t detail_limit{0};
+        std::chrono::milliseconds rank_interval{0};
+    };
+
+    explicit partition_probes(config);
+    partition_probes(const partition_probes&) = delete;
+    partition_probes& operator=(const partition_probes&) = delete;
+    partition_probes(partition_probes&&) = delete;
+    partition_probes& operator=(partition_probes&&) = delete;
+    ~partition_probes() noexcept = default;
+
+    void add(partition_probe&, const model::ntp&);
+
+    void stop() { _rank_timer.cancel(); }
+
+    /// \brief registers the detail of the busiest partitions, and clears it
+    /// from the others
+    void rank();
+
+    size_t detailed() const { return _detailed; }
+
+private:
+    config _cfg;
+    absl::node_hash_map<
+      model::topic_namespace,
+      topic_probe,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      _topics;
+    ss::timer<ss::lowres_clock> _rank_timer;
+    size_t _detailed{0};
+};
 } // namespace cluster
@@ -0,0 +1,237 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/producer_state.h"
+
+#include "bytes/iobuf_parser.h"
+#include "reflection/adl.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace cluster {
+
+static constexpr model::offset pending_offset(-1);
+
+int32_t producer_state_table::increment(int32_t seq, int32_t delta) {
+    // sequences wrap around to 0 like they do in the kafka producer
+    if (seq > std::numeric_limits<int32_t>::max() - delta) {
+        return delta - (std::numeric_limits<int32_t>::max() - seq) - 1;
+    }
+    return seq + delta;
+}
+
+producer_state_table::batch_meta*
+producer_state_table::producer_state::find(int32_t first_seq, int32_t last) {
+    for (size_t i = 0; i < count; ++i) {
+        auto& b = at(i);
+        if (b.first_seq == first_seq && b.last_seq == last) {
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+void producer_state_table::producer_state::push(batch_meta b) {
+    if (count == max_cached_batches) {
+        head = (head + 1) % max_cached_batches;
+        --count;
+    }
+    at(count) = b;
+    ++count;
+}
+
+void producer_state_table::producer_state::reset(int16_t e) {
+    epoch = e;
+    last_seq = -1;
+    head = 0;
+    count = 0;
+}
+
+/// newest offset of the producer, pending_offset while a batch is replicated
+model::offset producer_state_table::producer_state::last_offset() const {
+    model::offset last = model::offset(0);
+    for (size_t i = 0; i < count; ++i) {
+        if (at(i).last_offset == pending_offset) {
+            return pending_offset;
+        }
+        last = std::max(last, at(i).last_offset);
+    }
+    return last;
+}
+
+producer_state_table::check_result
+producer_state_table::try_begin(const model::record_batch_header& h) {
+    const auto first = h.base_sequence;
+    const auto last = increment(first, h.last_offset_delta);
+    auto it = _producers.find(h.producer_id);
+    if (it == _producers.end()) {
+        if (first != 0) {
+            return {check_status::unknown_producer, pending_offset};
+        }
+        it = _producers.emplace(h.producer_id, producer_state{}).first;
+        it->second.reset(h.producer_epoch);
+    }
+    auto& p = it->second;
+    if (h.producer_epoch < p.epoch) {
+        return {check_status::invalid_epoch, pending_offset};
+    }
+    if (h.producer_epoch > p.epoch) {
+        // a bumped epoch starts its sequences over
+        if (first != 0) {
+            return {check_status::out_of_order_sequence, pending_offset};
+        }
+        p.reset(h.producer_epoch);
+    } else if (auto* b = p.find(first, last); b) {
+        return {check_status::duplicate, b->last_offset};
+    } else if (first != increment(p.last_seq, 1)) {
+        return {check_status::out_of_order_sequence, pending_offset};
+    }
+    p.push(batch_meta{first, last, pending_offset});
+    p.last_seq = last;
+    maybe_evict();
+    return {check_status::accept, pending_offset};
+}
+
+void producer_state_table::complete(
+  const model::record_batch_header& h, model::offset last_offset) {
+    auto it = _producers.find(h.producer_id);
+    if (it == _producers.end() || it->second.epoch != h.producer_epoch) {
+        return;
+    }
+    const auto first = h.base_sequence;
+    const auto last = increment(first, h.last_offset_delta);
+    if (auto* b = it->second.find(first, last); b) {
+        b->last_offset = last_offset;
+    }
+}
+
+void producer_state_table::abort(const model::record_batch_header& h) {
+    auto it = _producers.find(h.producer_id);
+    if (it == _producers.end() || it->second.epoch != h.producer_epoch) {
+        return;
+    }
+    auto& p = it->second;
+    const auto first = h.base_sequence;
+    const auto last = increment(first, h.last_offset_delta);
+    for (size_t i = 0; i < p.count; ++i) {
+        auto& b = p.at(i);
+        if (b.first_seq != first || b.last_seq != last) {
+            continue;
+        }
+        // the batch was committed even though replicate failed
+        if (b.last_offset != pending_offset) {
+            return;
+        }
+        if (i > 0) {
+            p.last_seq = p.at(i - 1).last_seq;
+        } else {
+            p.last_seq = first == 0 ? -1 : first - 1;
+        }
+        p.count = i;
+        return;
+    }
+}
+
+void producer_state_table::apply(const model::record_batch_header& h) {
+    const auto first = h.base_sequence;
+    const auto last = increment(first, h.last_offset_delta);
+    auto [it, inserted] = _producers.try_emplace(h.producer_id);
+    auto& p = it->second;
+    if (inserted || h.producer_epoch > p.epoch) {
+        p.reset(h.producer_epoch);
+    } else if (h.producer_epoch < p.epoch) {
+        return;
+    }
+    if (auto* b = p.find(first, last); b) {
+        b->last_offset = h.last_offset();
+        return;
+    }
+    // batches the leader recorded past this one are not rolled back
+    if (p.count == 0 || first == increment(p.last_seq, 1)) {
+        p.push(batch_meta{first, last, h.last_offset()});
+        p.last_seq = last;
+    }
+    maybe_evict();
+}
+
+void producer_state_table::maybe_evict() {
+    if (_producers.size() <= max_producers) {
+        return;
+    }
+    // evict a tenth at once so that the scan is amortized
+    std::vector<std::pair<model::offset, int64_t>> idle;
+    idle.reserve(_producers.size());
+    for (const auto& [id, p] : _producers) {
+        auto offset = p.last_offset();
+        if (offset != pending_offset) {
+            idle.emplace_back(offset, id);
+        }
+    }
+    const size_t n = std::min(
+      idle.size(), _producers.size() - max_producers * 9 / 10);
+    std::nth_element(idle.begin(), idle.begin() + n, idle.end());
+    for (size_t i = 0; i < n; ++i) {
+        _producers.erase(idle[i].second);
+    }
+}
+
+iobuf producer_state_table::serialize(model::offset max_offset) const {
+    iobuf buf;
+    reflection::serialize(buf, static_cast<uint32_t>(_producers.size()));
+    for (const auto& [id, p] : _producers) {
+        size_t known = 0;
+        while (known < p.count) {
+            auto offset = p.at(known).last_offset;
+            if (offset == pending_offset || offset > max_offset) {
+                break;
+            }
+            ++known;
+        }
+        int32_t last_seq = p.last_seq;
+        if (known < p.count) {
+            const auto first = p.at(known).first_seq;
+            last_seq = known > 0 ? p.at(known - 1).last_seq
+                                 : (first == 0 ? -1 : first - 1);
+        }
+        reflection::serialize(
+          buf, id, p.epoch, last_seq, static_cast<uint8_t>(known));
+        for (size_t i = 0; i < known; ++i) {
+            const auto& b = p.at(i);
+            reflection::serialize(buf, b.first_seq, b.last_seq, b.last_offset);
+        }
+    }
+    return buf;
+}
+
+producer_state_table producer_state_table::deserialize(iobuf buf) {
+    iobuf_parser in(std::move(buf));
+    producer_state_table table;
+    auto size = reflection::adl<uint32_t>{}.from(in);
+    table._producers.reserve(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        auto id = reflection::adl<int64_t>{}.from(in);
+        auto& p = table._producers[id];
+        p.epoch = reflection::adl<int16_t>{}.from(in);
+        p.last_seq = reflection::adl<int32_t>{}.from(in);
+        auto count = reflection::adl<uint8_t>{}.from(in);
+        for (uint8_t j = 0; j < count; ++j) {
+            batch_meta b;
+            b.first_seq = reflection::adl<int32_t>{}.from(in);
+            b.last_seq = reflection::adl<int32_t>{}.from(in);
+            b.last_offset = reflection::adl<model::offset>{}.from(in);
+            p.push(b);
+        }
+    }
+    return table;
+}
+
+} // namespace cluster
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+#include "model/record.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <array>
+#include <cstdint>
+
+namespace cluster {
+
+/**
+ * Sequence numbers of the idempotent producers of a partition.
+ *
+ * A producer numbers the records it sends to a partition, the table keeps the
+ * sequence range and offset of the last max_cached_batches batches of every
+ * producer, as many as a producer may have in flight. A retried batch within
+ * them is recognized as a duplicate, a batch that does not follow the last one
+ * is out of order. The entry of a producer has a fixed size and the producers
+ * that were idle the longest are evicted past max_producers.
+ *
+ * The leader checks and records a batch before replicating it with
+ * try_begin() and completes or aborts the batch with the replication result,
+ * so the requests a producer pipelines are checked against each other. Every
+ * replica applies the committed batches with apply(), which also fills in what
+ * the leader may not have recorded before a leadership change.
+ */
+class producer_state_table {
+public:
+    static constexpr size_t max_cached_batches = 5;
+    static constexpr size_t max_producers = 10000;
+
+    enum class check_status {
+        accept,
+        // offset is the last offset of the original batch or negative while
+        // it is replicated
+        duplicate,
+        out_of_order_sequence,
+        invalid_epoch,
+        unknown_producer,
+    };
+    struct check_result {
+        check_status status;
+        model::offset last_offset;
+    };
+
+    /// \brief true for batches of an idempotent producer
+    static bool is_idempotent(const model::record_batch_header& h) {
+        return h.producer_id >= 0;
+    }
+
+    check_result try_begin(const model::record_batch_header&);
+    void complete(const model::record_batch_header&, model::offset);
+    /// \brief the batch and the batches its producer sent after it failed
+    void abort(const model::record_batch_header&);
+    void apply(const model::record_batch_header&);
+
+    size_t size() const { return _producers.size(); }
+
+    /// \brief the batches known to be in the log up to the offset
+    iobuf serialize(model::offset) const;
+    static producer_state_table deserialize(iobuf);
+
+private:
+    struct batch_meta {
+        int32_t first_seq{0};
+        int32_t last_seq{0};
+        // unknown while the batch is replicated
+        model::offset last_offset;
+    };
+
+    struct producer_state {
+        int16_t epoch{-1};
+        // last sequence accepted, the next batch starts right after it
+        int32_t last_seq{-1};
+        // ring of the last batches, oldest at head
+        std::array<batch_meta, max_cached_batches> batches;
+        uint8_t head{0};
+        uint8_t count{0};
+
+        batch_meta& at(size_t i) {
+            return batches[(head + i) % max_cached_batches];
+        }
+        const batch_meta& at(size_t i) const {
+            return batches[(head + i) % max_cached_batches];
+        }
+        batch_meta* find(int32_t first_seq, int32_t last_seq);
+        void push(batch_meta);
+        void reset(int16_t);
+        model::offset last_offset() const;
+    };
+
+    static int32_t increment(int32_t seq, int32_t delta);
+    void maybe_evict();
+
+    absl::flat_hash_map<int64_t, producer_state> _producers;
+};
+
+} // namespace cluster
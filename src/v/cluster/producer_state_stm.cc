@@ -0,0 +1,205 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/producer_state_stm.h"
+
+#include "bytes/iobuf_parser.h"
+#include "cluster/errc.h"
+#include "raft/consensus.h"
+#include "reflection/adl.h"
+#include "vlog.h"
+
+#include <seastar/core/do_with.hh>
+
+#include <filesystem>
+
+namespace cluster {
+
+producer_state_stm::producer_state_stm(
+  raft::consensus* raft, ss::logger& log, ss::io_priority_class io_prio)
+  : raft::state_machine(raft, log, io_prio)
+  , _raft(raft)
+  , _log(log)
+  , _snapshot_mgr(
+      std::filesystem::path(raft->log_config().work_directory()),
+      io_prio,
+      snapshot_filename) {}
+
+ss::future<> producer_state_stm::start() {
+    return _snapshot_mgr.remove_partial_snapshots()
+      .then([this] { return load_producers_snapshot(); })
+      .then([this] { return raft::state_machine::start(); });
+}
+
+ss::future<> producer_state_stm::stop() {
+    return raft::state_machine::stop()
+      .then([this] { return _gate.close(); })
+      .then([this] {
+          if (_applied_since_snapshot == 0) {
+              return ss::now();
+          }
+          return write_producers_snapshot();
+      });
+}
+
+ss::future<> producer_state_stm::load_producers_snapshot() {
+    return _snapshot_mgr.open_snapshot().then(
+      [this](std::optional<storage::snapshot_reader> reader) {
+          if (!reader) {
+              return ss::now();
+          }
+          return ss::do_with(
+            std::move(*reader), [this](storage::snapshot_reader& reader) {
+                return reader.read_metadata()
+                  .then([this](iobuf buf) {
+                      iobuf_parser in(std::move(buf));
+                      auto offset = reflection::adl<model::offset>{}.from(in);
+                      _table = producer_state_table::deserialize(
+                        in.share(in.bytes_left()));
+                      _last_applied = offset;
+                      skip_applied(offset);
+                      vlog(
+                        _log.info,
+                        "Loaded {} producers up to offset {}",
+                        _table.size(),
+                        offset);
+                  })
+                  .finally([&reader] { return reader.close(); });
+            });
+      });
+}
+
+ss::future<> producer_state_stm::write_producers_snapshot() {
+    // the table and its offset are one blob, covered by the metadata crc
+    iobuf data;
+    reflection::serialize(data, _last_applied);
+    data.append(_table.serialize(_last_applied));
+    _applied_since_snapshot = 0;
+    _writing_snapshot = true;
+    return _snapshot_mgr.start_snapshot()
+      .then([this, data = std::move(data)](
+              storage::snapshot_writer writer) mutable {
+          return ss::do_with(
+            std::move(writer),
+            [this, data = std::move(data)](
+              storage::snapshot_writer& writer) mutable {
+                return writer.write_metadata(std::move(data))
+                  .finally([&writer] { return writer.close(); })
+                  .then([this, &writer] {
+                      return _snapshot_mgr.finish_snapshot(writer);
+                  });
+            });
+      })
+      .handle_exception([this](const std::exception_ptr& e) {
+          vlog(_log.warn, "Unable to write producers snapshot - {}", e);
+      })
+      .finally([this] { _writing_snapshot = false; });
+}
+
+ss::future<> producer_state_stm::apply(model::record_batch b) {
+    const auto& hdr = b.header();
+    _last_applied = b.last_offset();
+    if (
+      hdr.type != raft::data_batch_type
+      || !producer_state_table::is_idempotent(hdr)) {
+        return ss::now();
+    }
+    _table.apply(hdr);
+    if (
+      ++_applied_since_snapshot >= snapshot_interval_batches
+      && !_writing_snapshot && !_gate.is_closed()) {
+        (void)ss::with_gate(
+          _gate, [this] { return write_producers_snapshot(); });
+    }
+    return ss::now();
+}
+
+ss::future<bool> producer_state_stm::sync() {
+    if (!_raft->is_leader()) {
+        return ss::make_ready_future<bool>(false);
+    }
+    const auto term = _raft->term();
+    if (_synced_term == term) {
+        return ss::make_ready_future<bool>(true);
+    }
+    // entries of earlier terms are committed with the first of this term
+    const auto offset = _raft->meta().prev_log_index;
+    return wait(offset, model::timeout_clock::now() + sync_timeout)
+      .then_wrapped([this, term](ss::future<> f) {
+          if (f.failed()) {
+              f.ignore_ready_future();
+              return false;
+          }
+          if (_raft->is_leader() && _raft->term() == term) {
+              _synced_term = term;
+              return true;
+          }
+          return false;
+      });
+}
+
+ss::future<result<raft::replicate_result>> producer_state_stm::replicate(
+  model::record_batch_header hdr,
+  model::record_batch_reader&& reader,
+  raft::replicate_options opts) {
+    // batches must be checked in the order they arrive, the fast path does
+    // not defer
+    if (_raft->is_leader() && _synced_term == _raft->term()) {
+        return do_replicate(hdr, std::move(reader), opts);
+    }
+    return sync().then([this, hdr, reader = std::move(reader), opts](
+                         bool synced) mutable {
+        if (!synced) {
+            return ss::make_ready_future<result<raft::replicate_result>>(
+              errc::not_leader);
+        }
+        return do_replicate(hdr, std::move(reader), opts);
+    });
+}
+
+ss::future<result<raft::replicate_result>> producer_state_stm::do_replicate(
+  model::record_batch_header hdr,
+  model::record_batch_reader&& reader,
+  raft::replicate_options opts) {
+    using ret_t = result<raft::replicate_result>;
+    auto check = _table.try_begin(hdr);
+    switch (check.status) {
+    case producer_state_table::check_status::accept:
+        break;
+    case producer_state_table::check_status::duplicate:
+        if (check.last_offset >= model::offset(0)) {
+            return ss::make_ready_future<ret_t>(
+              raft::replicate_result{check.last_offset});
+        }
+        return ss::make_ready_future<ret_t>(errc::duplicate_sequence);
+    case producer_state_table::check_status::out_of_order_sequence:
+        return ss::make_ready_future<ret_t>(errc::sequence_out_of_order);
+    case producer_state_table::check_status::invalid_epoch:
+        return ss::make_ready_future<ret_t>(errc::invalid_producer_epoch);
+    case producer_state_table::check_status::unknown_producer:
+        return ss::make_ready_future<ret_t>(errc::unknown_producer_id);
+    }
+    // the partition owning the state machine outlives the replication
+    return _raft->replicate(std::move(reader), opts)
+      .then_wrapped([this, hdr](ss::future<ret_t> f) {
+          if (f.failed()) {
+              _table.abort(hdr);
+              return f;
+          }
+          auto r = f.get0();
+          if (r) {
+              _table.complete(hdr, r.value().last_offset);
+          } else {
+              _table.abort(hdr);
+          }
+          return ss::make_ready_future<ret_t>(r);
+      });
+}
+
+} // namespace cluster
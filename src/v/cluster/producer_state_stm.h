@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "cluster/producer_state.h"
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "model/record_batch_reader.h"
+#include "outcome.h"
+#include "raft/state_machine.h"
+#include "raft/types.h"
+#include "seastarx.h"
+#include "storage/snapshot.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/util/log.hh>
+
+namespace cluster {
+
+/**
+ * Keeps the producer_state_table of a partition from the committed batches.
+ *
+ * The leader checks the batches of idempotent producers against the table
+ * before replicating them. A new leader first waits until the batches of the
+ * earlier terms are applied, so the table reflects every batch acknowledged
+ * by previous leaders. Every snapshot_interval_batches idempotent batches the
+ * table is written to a `producers` snapshot next to the raft snapshot of the
+ * partition, at startup applying resumes after it rather than from the start
+ * of the log.
+ */
+class producer_state_stm final : public raft::state_machine {
+public:
+    static constexpr size_t snapshot_interval_batches = 10000;
+    static constexpr const char* snapshot_filename = "producers";
+    static constexpr auto sync_timeout = std::chrono::seconds(5);
+
+    producer_state_stm(raft::consensus*, ss::logger&, ss::io_priority_class);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+    /// \brief replicates the batch of an idempotent producer described by
+    /// the header, duplicates resolve with the offset of the original batch
+    ss::future<result<raft::replicate_result>> replicate(
+      model::record_batch_header,
+      model::record_batch_reader&&,
+      raft::replicate_options);
+
+    ss::future<> apply(model::record_batch) final;
+
+    const producer_state_table& table() const { return _table; }
+
+private:
+    ss::future<bool> sync();
+    ss::future<result<raft::replicate_result>> do_replicate(
+      model::record_batch_header,
+      model::record_batch_reader&&,
+      raft::replicate_options);
+    ss::future<> load_producers_snapshot();
+    ss::future<> write_producers_snapshot();
+
+    raft::consensus* _raft;
+    ss::logger& _log;
+    producer_state_table _table;
+    storage::snapshot_manager _snapshot_mgr;
+    model::offset _last_applied;
+    size_t _applied_since_snapshot{0};
+    bool _writing_snapshot{false};
+    // term in which the table caught up with the log as the leader
+    model::term_id _synced_term;
+    ss::gate _gate;
+};
+
+} // namespace cluster
@@ -42,8 +42,7 @@ static ss::future<consensus_ptr> create_raft0(
           // Add raft 0 to shard table
           return st
             .invoke_on_all([gr = p->group()](shard_table& local_st) {
-                local_st.insert(controller_ntp, controller_stm_shard);
-                local_st.insert(gr, controller_stm_shard);
+                local_st.insert(controller_ntp, gr, controller_stm_shard);
             })
             .then([p] { return p; });
       });
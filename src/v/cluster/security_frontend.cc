@@ -0,0 +1,53 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/security_frontend.h"
+
+#include "cluster/logger.h"
+#include "vlog.h"
+
+namespace cluster {
+
+security_frontend::security_frontend(
+  ss::sharded<controller_stm>& s, ss::sharded<ss::abort_source>& as)
+  : _stm(s)
+  , _as(as) {}
+
+ss::future<std::error_code> security_frontend::create_user(
+  security::credential_user user,
+  security::scram_credential credential,
+  model::timeout_clock::time_point timeout) {
+    vlog(clusterlog.info, "Creating user {}", user);
+    create_user_cmd cmd(std::move(user), std::move(credential));
+    return replicate_and_wait(std::move(cmd), timeout);
+}
+
+ss::future<std::error_code> security_frontend::delete_user(
+  security::credential_user user, model::timeout_clock::time_point timeout) {
+    vlog(clusterlog.info, "Deleting user {}", user);
+    delete_user_cmd cmd(user, user);
+    return replicate_and_wait(std::move(cmd), timeout);
+}
+
+template<typename Cmd>
+ss::future<std::error_code> security_frontend::replicate_and_wait(
+  Cmd&& cmd, model::timeout_clock::time_point timeout) {
+    return _stm.invoke_on(
+      controller_stm_shard,
+      [cmd = std::forward<Cmd>(cmd), &as = _as, timeout](
+        controller_stm& stm) mutable {
+          return serialize_cmd(std::forward<Cmd>(cmd))
+            .then([&stm, timeout, &as](model::record_batch b) {
+                return stm.replicate_and_wait(
+                  std::move(b), timeout, as.local());
+            });
+      });
+}
+
+} // namespace cluster
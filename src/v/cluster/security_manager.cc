@@ -0,0 +1,99 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/security_manager.h"
+
+#include "bytes/iobuf_parser.h"
+#include "cluster/errc.h"
+#include "reflection/adl.h"
+
+#include <seastar/core/do_with.hh>
+
+#include <utility>
+#include <vector>
+
+namespace cluster {
+
+security_manager::security_manager(
+  ss::sharded<security::credential_store>& credentials)
+  : _credentials(credentials) {}
+
+ss::future<std::error_code>
+security_manager::apply_update(model::record_batch b) {
+    return deserialize(std::move(b), commands).then([this](auto cmd) {
+        return ss::visit(
+          std::move(cmd),
+          [this](create_user_cmd cmd) {
+              // the stores of all cores hold the same users
+              if (_credentials.local().contains(cmd.key)) {
+                  return ss::make_ready_future<std::error_code>(
+                    errc::user_exists);
+              }
+              return _credentials
+                .invoke_on_all(
+                  [cmd = std::move(cmd)](security::credential_store& store) {
+                      store.put(cmd.key, cmd.value);
+                  })
+                .then([] { return std::error_code(errc::success); });
+          },
+          [this](delete_user_cmd cmd) {
+              if (!_credentials.local().contains(cmd.key)) {
+                  return ss::make_ready_future<std::error_code>(
+                    errc::user_does_not_exist);
+              }
+              return _credentials
+                .invoke_on_all(
+                  [cmd = std::move(cmd)](security::credential_store& store) {
+                      store.remove(cmd.key);
+                  })
+                .then([] { return std::error_code(errc::success); });
+          });
+    });
+}
+
+ss::future<iobuf> security_manager::take_snapshot() {
+    // count followed by the users and their credentials
+    iobuf out;
+    const auto& store = _credentials.local();
+    reflection::adl<int32_t>{}.to(out, store.size());
+    for (const auto& [user, credential] : store) {
+        reflection::serialize(out, user, credential);
+    }
+    return ss::make_ready_future<iobuf>(std::move(out));
+}
+
+ss::future<> security_manager::apply_snapshot(model::offset, iobuf data) {
+    using user_credential
+      = std::pair<security::credential_user, security::scram_credential>;
+    std::vector<user_credential> users;
+    if (data.size_bytes() > 0) {
+        iobuf_parser parser(std::move(data));
+        const auto count = reflection::adl<int32_t>{}.from(parser);
+        users.reserve(count);
+        for (int32_t i = 0; i < count; ++i) {
+            auto user = reflection::adl<security::credential_user>{}.from(
+              parser);
+            auto credential = reflection::adl<security::scram_credential>{}
+                                .from(parser);
+            users.emplace_back(std::move(user), std::move(credential));
+        }
+    }
+    return ss::do_with(
+      std::move(users), [this](const std::vector<user_credential>& users) {
+          return _credentials.invoke_on_all(
+            [&users](security::credential_store& store) {
+                store.clear();
+                for (const auto& [user, credential] : users) {
+                    store.put(user, credential);
+                }
+            });
+      });
+}
+
+} // namespace cluster
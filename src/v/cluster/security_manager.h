@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "cluster/commands.h"
+#include "model/record.h"
+#include "security/credential_store.h"
+
+#include <seastar/core/sharded.hh>
+
+#include <system_error>
+
+namespace cluster {
+
+// Applies the user commands of the controller log to the credential stores
+// of all cores. Credentials are replicated already derived, applying them
+// is a copy.
+class security_manager {
+public:
+    explicit security_manager(ss::sharded<security::credential_store>&);
+
+    static constexpr auto commands
+      = make_commands_list<create_user_cmd, delete_user_cmd>();
+
+    bool is_batch_applicable(const model::record_batch& batch) const {
+        return batch.header().type == user_batch_type;
+    }
+
+    ss::future<std::error_code> apply_update(model::record_batch);
+
+    /// \brief the credentials of the users
+    ss::future<iobuf> take_snapshot();
+    /// \brief replaces the credentials of all cores, a snapshot written
+    /// before users existed is empty
+    ss::future<> apply_snapshot(model::offset, iobuf);
+
+private:
+    ss::sharded<security::credential_store>& _credentials;
+};
+
+} // namespace cluster
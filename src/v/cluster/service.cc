@@ -103,4 +103,19 @@ ss::future<configuration_update_reply> service::update_node_configuration(
       });
 }
 
+ss::future<node_load_report_reply> service::report_node_load(
+  node_load_report_request&& req, rpc::streaming_context&) {
+    return ss::with_scheduling_group(
+      get_scheduling_group(), [this, req = std::move(req)]() mutable {
+          return _members_manager
+            .invoke_on(
+              members_manager::shard,
+              get_smp_service_group(),
+              [load = std::move(req.load)](members_manager& mm) mutable {
+                  return mm.handle_node_load_report(std::move(load));
+              })
+            .then([] { return node_load_report_reply{}; });
+      });
+}
+
 } // namespace cluster
@@ -41,6 +41,9 @@ public:
     ss::future<configuration_update_reply> update_node_configuration(
       configuration_update_request&&, rpc::streaming_context&) final;
 
+    ss::future<node_load_report_reply> report_node_load(
+      node_load_report_request&&, rpc::streaming_context&) final;
+
 private:
     std::
       pair<std::vector<model::topic_metadata>, std::vector<topic_configuration>>
@@ -0,0 +1,249 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/shard_mover.h"
+
+#include "cluster/errc.h"
+#include "cluster/logger.h"
+#include "reflection/adl.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/smp.hh>
+
+#include <algorithm>
+
+namespace cluster {
+
+static const bytes placements_key("shard_placements");
+
+shard_mover::shard_mover(
+  model::node_id self,
+  ss::sharded<topic_table>& topics,
+  ss::sharded<shard_table>& st,
+  ss::sharded<partition_manager>& pm,
+  ss::sharded<controller_backend>& backend,
+  ss::sharded<storage::api>& storage)
+  : _self(self)
+  , _topics(topics)
+  , _shard_table(st)
+  , _partition_manager(pm)
+  , _backend(backend)
+  , _storage(storage) {}
+
+ss::future<> shard_mover::start() {
+    auto buf = _storage.local().kvs().get(
+      storage::kvstore::key_space::controller, placements_key);
+    if (!buf) {
+        return ss::now();
+    }
+    auto placements = reflection::from_iobuf<std::vector<shard_placement>>(
+      std::move(*buf));
+    for (auto& p : placements) {
+        // the configuration invariants do not let the core count shrink
+        if (p.shard >= ss::smp::count) {
+            vlog(
+              clusterlog.warn,
+              "Ignoring placement of group {} on missing shard {}",
+              p.group,
+              p.shard);
+            continue;
+        }
+        _placements.emplace(p.group, p.shard);
+    }
+    vlog(clusterlog.info, "Loaded {} shard placements", _placements.size());
+    return _shard_table.invoke_on_all([this](shard_table& st) {
+        for (auto& [group, shard] : _placements) {
+            st.set_placement(group, shard);
+        }
+    });
+}
+
+ss::future<> shard_mover::stop() { return _gate.close(); }
+
+ss::future<std::error_code>
+shard_mover::move(model::ntp ntp, ss::shard_id target) {
+    if (target >= ss::smp::count) {
+        return ss::make_ready_future<std::error_code>(errc::invalid_shard);
+    }
+    return ss::with_gate(_gate, [this, ntp = std::move(ntp), target]() mutable {
+        return _lock.with([this, ntp = std::move(ntp), target]() mutable {
+            auto source = _shard_table.local().shard_for(ntp);
+            if (!source) {
+                return ss::make_ready_future<std::error_code>(
+                  errc::partition_not_exists);
+            }
+            if (*source == target) {
+                return ss::make_ready_future<std::error_code>(errc::success);
+            }
+            // the backends are paused source first, the moves being
+            // serialized no two moves wait for each other
+            return _backend.invoke_on(
+              *source,
+              [this, ntp = std::move(ntp), source = *source, target](
+                controller_backend& src) mutable {
+                  return src.with_reconciliation_paused(
+                    [this, ntp = std::move(ntp), source, target]() mutable {
+                        return _backend.invoke_on(
+                          target,
+                          [this, ntp = std::move(ntp), source, target](
+                            controller_backend& dst) mutable {
+                              return dst.with_reconciliation_paused(
+                                [this, ntp = std::move(ntp), source, target] {
+                                    return ss::smp::submit_to(
+                                      shard, [this, ntp, source, target] {
+                                          return do_move(ntp, source, target);
+                                      });
+                                });
+                          });
+                    });
+              });
+        });
+    });
+}
+
+ss::future<std::error_code> shard_mover::do_move(
+  model::ntp ntp, ss::shard_id source, ss::shard_id target) {
+    // a topic delta applied before the backends were paused may have
+    // removed the partition from this node
+    auto assignment = _topics.local().get_partition_assignment(ntp);
+    const bool replicated_here = assignment
+                                 && std::any_of(
+                                   assignment->replicas.cbegin(),
+                                   assignment->replicas.cend(),
+                                   [this](const model::broker_shard& bs) {
+                                       return bs.node_id == _self;
+                                   });
+    if (!replicated_here || _shard_table.local().shard_for(ntp) != source) {
+        return ss::make_ready_future<std::error_code>(
+          errc::partition_not_exists);
+    }
+    vlog(
+      clusterlog.info,
+      "Moving partition {} from shard {} to shard {}",
+      ntp,
+      source,
+      target);
+    return _partition_manager
+      .invoke_on(
+        source, [ntp](partition_manager& pm) { return pm.shutdown(ntp); })
+      .then([this, ntp, source, target](partition_handover h) {
+          return ss::do_with(
+            std::move(h),
+            [this, ntp, source, target](partition_handover& h) {
+                return handover(ntp, h, target)
+                  .then([this, ntp, target, &h] {
+                      return _shard_table.invoke_on_all(
+                        [&ntp, &h, target](shard_table& st) {
+                            st.update(ntp, h.group, target);
+                        });
+                  })
+                  .then([this, ntp, source, target, &h] {
+                      vlog(
+                        clusterlog.info,
+                        "Moved partition {} to shard {}",
+                        ntp,
+                        target);
+                      // the state left behind is never read, the partition
+                      // starts on the target after a restart
+                      return _partition_manager
+                        .invoke_on(
+                          source,
+                          [&h](partition_manager& pm) {
+                              return pm.remove_persistent_state(h);
+                          })
+                        .handle_exception([ntp](const std::exception_ptr& e) {
+                            vlog(
+                              clusterlog.warn,
+                              "Error removing moved state of {} - {}",
+                              ntp,
+                              e);
+                        })
+                        .then([] { return make_error_code(errc::success); });
+                  })
+                  .handle_exception(
+                    [this, ntp, source, target, &h](
+                      const std::exception_ptr& e) {
+                        vlog(
+                          clusterlog.error,
+                          "Error moving partition {} to shard {}, restarting "
+                          "it on shard {} - {}",
+                          ntp,
+                          target,
+                          source,
+                          e);
+                        _placements.erase(h.group);
+                        return persist_placements()
+                          .then([this, &h, target] {
+                              return _partition_manager.invoke_on(
+                                target, [&h](partition_manager& pm) {
+                                    auto f = pm.get(h.ntp_cfg.ntp())
+                                               ? pm.shutdown(h.ntp_cfg.ntp())
+                                                   .discard_result()
+                                               : ss::now();
+                                    return f.then([&pm, &h] {
+                                        return pm.remove_persistent_state(h);
+                                    });
+                                });
+                          })
+                          .then([this, &h, source] {
+                              return _partition_manager.invoke_on(
+                                source, [&h](partition_manager& pm) {
+                                    return pm
+                                      .manage(
+                                        h.ntp_cfg.copy(), h.group, h.brokers)
+                                      .discard_result();
+                                });
+                          })
+                          .then([] {
+                              return make_error_code(
+                                errc::partition_move_failed);
+                          });
+                    });
+            });
+      });
+}
+
+ss::future<> shard_mover::handover(
+  model::ntp ntp, partition_handover& h, ss::shard_id target) {
+    return _partition_manager
+      .invoke_on(
+        target,
+        [&h](partition_manager& pm) { return pm.import_persistent_state(h); })
+      .then([this, &h, target] {
+          // from now on the partition is started on the target after a
+          // restart, its state is already there
+          _placements.insert_or_assign(h.group, target);
+          return persist_placements();
+      })
+      .then([this, &h, target] {
+          return _partition_manager.invoke_on(
+            target, [&h](partition_manager& pm) {
+                return pm.manage(h.ntp_cfg.copy(), h.group, h.brokers)
+                  .discard_result();
+            });
+      })
+      .then([ntp = std::move(ntp)] {
+          vlog(clusterlog.debug, "Partition {} started on target shard", ntp);
+      });
+}
+
+ss::future<> shard_mover::persist_placements() {
+    std::vector<shard_placement> placements;
+    placements.reserve(_placements.size());
+    for (auto& [group, shard] : _placements) {
+        placements.push_back(shard_placement{.group = group, .shard = shard});
+    }
+    return _storage.local().kvs().put(
+      storage::kvstore::key_space::controller,
+      placements_key,
+      reflection::to_iobuf(std::move(placements)));
+}
+
+} // namespace cluster
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "cluster/controller_backend.h"
+#include "cluster/partition_manager.h"
+#include "cluster/shard_table.h"
+#include "cluster/topic_table.h"
+#include "model/fundamental.h"
+#include "raft/types.h"
+#include "storage/api.h"
+#include "utils/mutex.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/sharded.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <system_error>
+#include <vector>
+
+namespace cluster {
+
+/// Shard of this node a partition was moved to, persisted in the kvstore
+struct shard_placement {
+    raft::group_id group;
+    ss::shard_id shard;
+};
+
+/**
+ * Moves partitions between the shards of this node.
+ *
+ * The controller assigns every replica to a shard when it is created, a
+ * produce hotspot then stays on that shard. Moving the partition hands its
+ * raft group and log over to another shard, the node stays a member of the
+ * group with the same log and the same persistent raft state so the move is
+ * invisible to the other replicas. The source shard stops the partition and
+ * closes its log, the kvstore state of the group and of the log is copied to
+ * the target shard which then manages the partition from the same ntp
+ * directory. The shard table of every core is switched to the target once it
+ * runs. The controller backends of both shards are paused during the move
+ * so no topic delta applies to a partition in flight.
+ *
+ * The placements are node local, the topic table keeps the shard assigned by
+ * the controller. They are persisted in the kvstore of shard 0 before the
+ * target starts the partition and loaded before the controller backends
+ * reconcile the topics after a restart, so the partition is always started
+ * on the shard owning its kvstore state.
+ */
+class shard_mover {
+public:
+    static constexpr ss::shard_id shard = 0;
+
+    shard_mover(
+      model::node_id self,
+      ss::sharded<topic_table>&,
+      ss::sharded<shard_table>&,
+      ss::sharded<partition_manager>&,
+      ss::sharded<controller_backend>&,
+      ss::sharded<storage::api>&);
+
+    /// Loads the persisted placements into the shard tables, has to run
+    /// before the controller backends start
+    ss::future<> start();
+    ss::future<> stop();
+
+    /// Moves the partition to the `target` shard of this node
+    ss::future<std::error_code> move(model::ntp, ss::shard_id target);
+
+private:
+    ss::future<std::error_code>
+      do_move(model::ntp, ss::shard_id source, ss::shard_id target);
+    ss::future<> handover(model::ntp, partition_handover&, ss::shard_id);
+    ss::future<> persist_placements();
+
+    model::node_id _self;
+    ss::sharded<topic_table>& _topics;
+    ss::sharded<shard_table>& _shard_table;
+    ss::sharded<partition_manager>& _partition_manager;
+    ss::sharded<controller_backend>& _backend;
+    ss::sharded<storage::api>& _storage;
+
+    absl::flat_hash_map<raft::group_id, ss::shard_id> _placements;
+    // one move at a time, a move pauses the backends of two shards
+    mutex _lock;
+    ss::gate _gate;
+};
+
+} // namespace cluster
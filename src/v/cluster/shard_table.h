@@ -31,17 +31,38 @@ public:
         return _group_idx.find(group)->second;
     }
 
+    /**
+     * \brief Owning shard and raft group of an ntp.
+     *
+     * The group is the id the controller assigned to the partition, unique
+     * in the cluster. Requests naming an ntp look it up once here and
+     * address the partition on its shard by the group from there on.
+     */
+    struct ntp_location {
+        ss::shard_id shard;
+        raft::group_id group;
+    };
+
+    std::optional<ntp_location> locate(const model::ntp& ntp) const {
+        if (auto it = _ntp_idx.find(ntp); it != _ntp_idx.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
     /**
      * \brief Lookup the owning shard for an ntp.
      */
     std::optional<ss::shard_id> shard_for(const model::ntp& ntp) {
         if (auto it = _ntp_idx.find(ntp); it != _ntp_idx.end()) {
-            return it->second;
+            return it->second.shard;
         }
         return std::nullopt;
     }
-    void insert(model::ntp ntp, ss::shard_id i) {
-        _ntp_idx.insert({std::move(ntp), i});
+    /// \brief indexes a partition by its ntp and by its group
+    void insert(model::ntp ntp, raft::group_id g, ss::shard_id i) {
+        _ntp_idx.insert({std::move(ntp), ntp_location{.shard = i, .group = g}});
+        _group_idx.insert({g, i});
     }
     void insert(raft::group_id g, ss::shard_id i) { _group_idx.insert({g, i}); }
 
@@ -50,10 +71,35 @@ public:
         _group_idx.erase(g);
     }
 
+    /**
+     * \brief Points both indexes at the shard a partition was moved to.
+     *
+     * The move is recorded as the placement of the group, the partition
+     * stays on that shard regardless of the shard the controller assigned.
+     */
+    void update(const model::ntp& ntp, raft::group_id g, ss::shard_id i) {
+        _ntp_idx.insert_or_assign(ntp, ntp_location{.shard = i, .group = g});
+        _group_idx.insert_or_assign(g, i);
+        _placements.insert_or_assign(g, i);
+    }
+
+    /// \brief Shard of this node a group was moved to, if any
+    std::optional<ss::shard_id> placement(raft::group_id g) const {
+        if (auto it = _placements.find(g); it != _placements.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+    void set_placement(raft::group_id g, ss::shard_id i) {
+        _placements.insert_or_assign(g, i);
+    }
+
 private:
     // kafka index
-    absl::flat_hash_map<model::ntp, ss::shard_id> _ntp_idx;
+    absl::flat_hash_map<model::ntp, ntp_location> _ntp_idx;
     // raft index
     absl::flat_hash_map<raft::group_id, ss::shard_id> _group_idx;
+    // groups moved between the shards of this node
+    absl::flat_hash_map<raft::group_id, ss::shard_id> _placements;
 };
 } // namespace cluster
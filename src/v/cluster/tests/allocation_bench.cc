@@ -47,3 +47,60 @@ PERF_TEST_F(partition_allocator_tester, recovery) {
     pa.update_allocation_state(md, raft::group_id(partitions_per_topic));
     perf_tests::stop_measuring_time();
 }
+
+// 100k partitions replicated three times on 30 nodes with 16 cores, every
+// node reported its load
+struct large_cluster_tester : partition_allocator_tester {
+    static constexpr uint32_t nodes = 30;
+    static constexpr uint32_t cpus = 16;
+    static constexpr int32_t partitions = 100'000;
+
+    large_cluster_tester()
+      : partition_allocator_tester(nodes, cpus)
+      , allocated(pa.allocate(gen_topic_configuration(partitions, 3))) {
+        for (uint32_t n = 0; n < nodes; ++n) {
+            pa.update_node_load(make_load(model::node_id(n)));
+        }
+    }
+
+    node_load make_load(model::node_id id) {
+        node_load load{
+          .id = id,
+          .disk_free_bytes = _prng() % 1000 + 100,
+          .disk_total_bytes = 2000};
+        for (uint32_t c = 0; c < cpus; ++c) {
+            load.shards.push_back(shard_load{
+              .partitions_bytes = uint64_t(_prng()) * 256,
+              .produced_records_rate = _prng() % 100'000});
+        }
+        return load;
+    }
+
+    std::optional<partition_allocator::allocation_units> allocated;
+};
+
+PERF_TEST_F(large_cluster_tester, allocation_3_100k) {
+    auto cfg = gen_topic_configuration(1, 3);
+
+    perf_tests::start_measuring_time();
+    auto vals = pa.allocate(cfg);
+    perf_tests::do_not_optimize(vals);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(large_cluster_tester, allocation_1000x3_100k) {
+    auto cfg = gen_topic_configuration(1000, 3);
+
+    perf_tests::start_measuring_time();
+    auto vals = pa.allocate(cfg);
+    perf_tests::do_not_optimize(vals);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(large_cluster_tester, load_report_100k) {
+    auto load = make_load(model::node_id(_prng() % nodes));
+
+    perf_tests::start_measuring_time();
+    pa.update_node_load(load);
+    perf_tests::stop_measuring_time();
+}
@@ -0,0 +1,137 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE cluster
+#include "cluster/leader_balancer.h"
+#include "model/fundamental.h"
+#include "model/metadata.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace {
+
+model::node_id n(int id) { return model::node_id(id); }
+
+cluster::local_leader
+make_leader(int partition, ss::shard_id shard, uint64_t load = 0) {
+    return cluster::local_leader{
+      .ntp = model::ntp(
+        model::ns("kafka"), model::topic("t"), model::partition_id(partition)),
+      .shard = shard,
+      .load = load,
+      .replicas = {n(0), n(1), n(2)}};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(balanced_cluster_stays_put) {
+    std::vector<cluster::local_leader> leaders;
+    for (int i = 0; i < 10; ++i) {
+        leaders.push_back(make_leader(i, i % 2));
+    }
+    auto transfers = cluster::plan_leadership_transfers(
+      n(0), {{n(0), 10}, {n(1), 10}, {n(2), 9}}, std::move(leaders), 2, 20, 4);
+    BOOST_REQUIRE(transfers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(overloaded_node_gives_leaders_to_least_loaded) {
+    std::vector<cluster::local_leader> leaders;
+    for (int i = 0; i < 12; ++i) {
+        leaders.push_back(make_leader(i, i % 2));
+    }
+    // mean is 6, node 0 leads twice as many
+    auto transfers = cluster::plan_leadership_transfers(
+      n(0), {{n(0), 12}, {n(1), 4}, {n(2), 2}}, std::move(leaders), 2, 20, 10);
+    // stops once node 0 is within the slack of the mean, 6 + 1.2
+    BOOST_REQUIRE_EQUAL(transfers.size(), 5);
+    size_t to_1 = 0;
+    size_t to_2 = 0;
+    for (auto& t : transfers) {
+        to_1 += t.target == n(1);
+        to_2 += t.target == n(2);
+    }
+    BOOST_REQUIRE_EQUAL(to_1, 2);
+    BOOST_REQUIRE_EQUAL(to_2, 3);
+}
+
+BOOST_AUTO_TEST_CASE(transfers_are_rate_limited) {
+    std::vector<cluster::local_leader> leaders;
+    for (int i = 0; i < 12; ++i) {
+        leaders.push_back(make_leader(i, 0));
+    }
+    auto transfers = cluster::plan_leadership_transfers(
+      n(0), {{n(0), 12}, {n(1), 0}, {n(2), 0}}, std::move(leaders), 1, 20, 2);
+    BOOST_REQUIRE_EQUAL(transfers.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(transfers_never_widen_the_spread) {
+    std::vector<cluster::local_leader> leaders;
+    for (int i = 0; i < 10; ++i) {
+        leaders.push_back(make_leader(i, 0));
+    }
+    // node 0 is overloaded but the other replicas of its partitions lead
+    // only one less
+    auto transfers = cluster::plan_leadership_transfers(
+      n(0),
+      {{n(0), 10}, {n(1), 9}, {n(2), 9}, {n(3), 0}, {n(4), 0}},
+      std::move(leaders),
+      2,
+      20,
+      4);
+    BOOST_REQUIRE(transfers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(hot_shard_is_not_balanced_with_transfers) {
+    std::vector<cluster::local_leader> leaders;
+    leaders.push_back(make_leader(0, 0, 100));
+    leaders.push_back(make_leader(1, 0, 1000));
+    leaders.push_back(make_leader(2, 1, 10));
+    leaders.push_back(make_leader(3, 1, 10));
+    // leader counts are within the slack, shard 0 is hot
+    auto transfers = cluster::plan_leadership_transfers(
+      n(0), {{n(0), 4}, {n(1), 2}, {n(2), 3}}, std::move(leaders), 2, 20, 4);
+    BOOST_REQUIRE(transfers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(hot_shard_moves_the_partition_evening_out_shards) {
+    std::vector<cluster::local_leader> leaders;
+    leaders.push_back(make_leader(0, 0, 100));
+    leaders.push_back(make_leader(1, 0, 1000));
+    leaders.push_back(make_leader(2, 1, 10));
+    leaders.push_back(make_leader(3, 1, 10));
+    auto moves = cluster::plan_shard_moves(leaders, 2, 20, 4);
+    // moving the busiest partition would only swap the hotspot
+    BOOST_REQUIRE_EQUAL(moves.size(), 1);
+    BOOST_REQUIRE_EQUAL(moves[0].ntp.tp.partition, model::partition_id(0));
+    BOOST_REQUIRE_EQUAL(moves[0].source, 0u);
+    BOOST_REQUIRE_EQUAL(moves[0].target, 1u);
+
+    // next round, the remaining partition is as loaded as the gap
+    leaders[0].shard = 1;
+    BOOST_REQUIRE(cluster::plan_shard_moves(leaders, 2, 20, 4).empty());
+}
+
+BOOST_AUTO_TEST_CASE(shard_moves_go_to_the_least_loaded_shard) {
+    std::vector<cluster::local_leader> leaders;
+    for (int i = 0; i < 4; ++i) {
+        leaders.push_back(make_leader(i, 0, 100));
+    }
+    leaders.push_back(make_leader(4, 1, 50));
+    leaders.push_back(make_leader(5, 2, 10));
+    leaders.push_back(make_leader(6, 3, 200));
+    auto moves = cluster::plan_shard_moves(leaders, 4, 20, 4);
+    BOOST_REQUIRE_EQUAL(moves.size(), 1);
+    BOOST_REQUIRE_EQUAL(moves[0].source, 0u);
+    BOOST_REQUIRE_EQUAL(moves[0].target, 2u);
+
+    BOOST_REQUIRE(cluster::plan_shard_moves(leaders, 4, 20, 0).empty());
+    BOOST_REQUIRE(cluster::plan_shard_moves(leaders, 1, 20, 4).empty());
+}
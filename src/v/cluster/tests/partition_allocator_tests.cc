@@ -7,10 +7,12 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "cluster/namespace.h"
 #include "cluster/partition_allocator.h"
 #include "cluster/tests/partition_allocator_tester.h"
 #include "raft/types.h"
 #include "test_utils/fixture.h"
+#include "units.h"
 
 using namespace cluster; // NOLINT
 
@@ -197,4 +199,122 @@ FIXTURE_TEST(allocation_units_test, partition_allocator_tester) {
       machines().at(model::node_id(2))->partition_capacity(), max);
     // we do not decrement the highest raft group
     BOOST_REQUIRE_EQUAL(highest_group()(), partitions);
-}
\ No newline at end of file
+}
+static node_load loaded_node(
+  model::node_id id,
+  uint32_t cpus,
+  uint64_t bytes_per_core,
+  uint64_t disk_free = 100,
+  uint64_t disk_total = 100) {
+    node_load load{
+      .id = id, .disk_free_bytes = disk_free, .disk_total_bytes = disk_total};
+    load.shards.resize(cpus, shard_load{.partitions_bytes = bytes_per_core});
+    return load;
+}
+
+FIXTURE_TEST(allocation_prefers_less_loaded_nodes, partition_allocator_tester) {
+    using ts = partition_allocator_tester;
+    pa.update_node_load(
+      loaded_node(model::node_id(0), ts::cpus_per_node, 1_GiB));
+    auto allocs = pa.allocate(gen_topic_configuration(30, 1)).value();
+    std::map<model::node_id, int> per_node;
+    for (auto& a : allocs.get_assignments()) {
+        per_node[a.replicas[0].node_id]++;
+    }
+    BOOST_REQUIRE_LT(per_node[model::node_id(0)], per_node[model::node_id(1)]);
+    BOOST_REQUIRE_LT(per_node[model::node_id(0)], per_node[model::node_id(2)]);
+    BOOST_REQUIRE_EQUAL(
+      per_node[model::node_id(1)], per_node[model::node_id(2)]);
+}
+
+FIXTURE_TEST(allocation_avoids_loaded_cores, partition_allocator_tester) {
+    using ts = partition_allocator_tester;
+    auto load = loaded_node(model::node_id(0), ts::cpus_per_node, 0);
+    load.shards[3].partitions_bytes = 1_GiB;
+    pa.update_node_load(load);
+    auto allocs = pa.allocate(gen_topic_configuration(9, 3)).value();
+    for (auto& a : allocs.get_assignments()) {
+        for (auto& bs : a.replicas) {
+            if (bs.node_id == model::node_id(0)) {
+                BOOST_REQUIRE_NE(bs.shard, 3);
+            }
+        }
+    }
+}
+
+FIXTURE_TEST(allocation_prefers_cores_near_nic, partition_allocator_tester) {
+    using ts = partition_allocator_tester;
+    // the upper half of the cores and the NIC are on the second socket
+    auto load = loaded_node(model::node_id(0), ts::cpus_per_node, 0);
+    for (uint32_t c = 0; c < ts::cpus_per_node; ++c) {
+        load.shards[c].numa_node = c < ts::cpus_per_node / 2 ? 0 : 1;
+    }
+    load.nic_numa_node = 1;
+    pa.update_node_load(load);
+    auto allocs = pa.allocate(gen_topic_configuration(10, 3)).value();
+    uint32_t local = 0;
+    uint32_t remote = 0;
+    for (auto& a : allocs.get_assignments()) {
+        for (auto& bs : a.replicas) {
+            if (bs.node_id == model::node_id(0)) {
+                bs.shard < ts::cpus_per_node / 2 ? ++remote : ++local;
+            }
+        }
+    }
+    BOOST_REQUIRE_EQUAL(local + remote, 10);
+    BOOST_REQUIRE_GT(local, remote);
+}
+
+FIXTURE_TEST(allocation_skips_nodes_out_of_disk, partition_allocator_tester) {
+    using ts = partition_allocator_tester;
+    pa.update_node_load(
+      loaded_node(model::node_id(2), ts::cpus_per_node, 0, 1, 100));
+    auto allocs = pa.allocate(gen_topic_configuration(10, 2)).value();
+    for (auto& a : allocs.get_assignments()) {
+        for (auto& bs : a.replicas) {
+            BOOST_REQUIRE_NE(bs.node_id, model::node_id(2));
+        }
+    }
+    // the replicas do not fit on the nodes left
+    BOOST_REQUIRE(std::nullopt == pa.allocate(gen_topic_configuration(1, 3)));
+}
+
+FIXTURE_TEST(group_topic_spreads_over_cores, partition_allocator_tester) {
+    using ts = partition_allocator_tester;
+    // the load would otherwise keep the partitions off the loaded cores
+    auto load = loaded_node(model::node_id(0), ts::cpus_per_node, 0);
+    load.shards[3].partitions_bytes = 1_GiB;
+    pa.update_node_load(load);
+    pa.update_node_load(
+      loaded_node(model::node_id(1), ts::cpus_per_node, 1_GiB));
+    auto allocs = pa.allocate(topic_configuration(
+                                kafka_internal_namespace,
+                                kafka_group_topic,
+                                3 * ts::cpus_per_node,
+                                1))
+                    .value();
+    std::map<std::pair<model::node_id, uint32_t>, int> per_core;
+    for (auto& a : allocs.get_assignments()) {
+        per_core[{a.replicas[0].node_id, a.replicas[0].shard}]++;
+    }
+    BOOST_REQUIRE_EQUAL(per_core.size(), 3 * ts::cpus_per_node);
+    for (auto& [core, n] : per_core) {
+        BOOST_REQUIRE_EQUAL(n, 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(allocation_scales_with_cores) {
+    partition_allocator_tester test(2, 10);
+    // node 1 has twice the cores of node 0
+    test.pa.register_node(std::make_unique<allocation_node>(
+      model::node_id(7), 20, std::unordered_map<ss::sstring, ss::sstring>()));
+    auto allocs
+      = test.pa.allocate(test.gen_topic_configuration(400, 1)).value();
+    std::map<model::node_id, int> per_node;
+    for (auto& a : allocs.get_assignments()) {
+        per_node[a.replicas[0].node_id]++;
+    }
+    BOOST_REQUIRE_EQUAL(per_node[model::node_id(0)], 100);
+    BOOST_REQUIRE_EQUAL(per_node[model::node_id(1)], 100);
+    BOOST_REQUIRE_EQUAL(per_node[model::node_id(7)], 200);
+}
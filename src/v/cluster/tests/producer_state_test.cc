@@ -0,0 +1,126 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/producer_state.h"
+#include "model/fundamental.h"
+#include "model/record.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <limits>
+
+using status = cluster::producer_state_table::check_status;
+
+static model::record_batch_header
+make_header(int64_t pid, int16_t epoch, int32_t seq, int32_t records) {
+    model::record_batch_header h{};
+    h.producer_id = pid;
+    h.producer_epoch = epoch;
+    h.base_sequence = seq;
+    h.last_offset_delta = records - 1;
+    return h;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_pipelined_batches_are_accepted_in_order) {
+    cluster::producer_state_table table;
+    for (int32_t seq = 0; seq < 50; seq += 10) {
+        auto r = table.try_begin(make_header(1, 0, seq, 10));
+        BOOST_REQUIRE(r.status == status::accept);
+    }
+    // a gap in the sequences
+    auto r = table.try_begin(make_header(1, 0, 60, 10));
+    BOOST_REQUIRE(r.status == status::out_of_order_sequence);
+    // a new producer starts at 0
+    r = table.try_begin(make_header(2, 0, 5, 1));
+    BOOST_REQUIRE(r.status == status::unknown_producer);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_retried_batch_is_a_duplicate) {
+    cluster::producer_state_table table;
+    auto h = make_header(1, 0, 0, 10);
+    BOOST_REQUIRE(table.try_begin(h).status == status::accept);
+
+    // still replicated
+    auto r = table.try_begin(h);
+    BOOST_REQUIRE(r.status == status::duplicate);
+    BOOST_REQUIRE_LT(r.last_offset, model::offset(0));
+
+    table.complete(h, model::offset(109));
+    r = table.try_begin(h);
+    BOOST_REQUIRE(r.status == status::duplicate);
+    BOOST_REQUIRE_EQUAL(r.last_offset, model::offset(109));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_aborted_batch_can_be_retried) {
+    cluster::producer_state_table table;
+    auto first = make_header(1, 0, 0, 10);
+    auto second = make_header(1, 0, 10, 10);
+    auto third = make_header(1, 0, 20, 10);
+    BOOST_REQUIRE(table.try_begin(first).status == status::accept);
+    BOOST_REQUIRE(table.try_begin(second).status == status::accept);
+    BOOST_REQUIRE(table.try_begin(third).status == status::accept);
+    table.complete(first, model::offset(9));
+
+    // the second batch failed, so did the one pipelined after it
+    table.abort(second);
+    BOOST_REQUIRE(table.try_begin(second).status == status::accept);
+    BOOST_REQUIRE(table.try_begin(third).status == status::accept);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_epochs_fence_producers) {
+    cluster::producer_state_table table;
+    BOOST_REQUIRE(
+      table.try_begin(make_header(1, 1, 0, 10)).status == status::accept);
+    BOOST_REQUIRE(
+      table.try_begin(make_header(1, 0, 10, 10)).status
+      == status::invalid_epoch);
+    // a bumped epoch starts its sequences over
+    BOOST_REQUIRE(
+      table.try_begin(make_header(1, 2, 10, 10)).status
+      == status::out_of_order_sequence);
+    BOOST_REQUIRE(
+      table.try_begin(make_header(1, 2, 0, 10)).status == status::accept);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_sequences_wrap_around) {
+    // a follower applying the batch of the last sequence
+    auto last = make_header(1, 0, std::numeric_limits<int32_t>::max() - 4, 5);
+    last.base_offset = model::offset(10);
+    cluster::producer_state_table follower;
+    follower.apply(last);
+    BOOST_REQUIRE(
+      follower.try_begin(make_header(1, 0, 0, 5)).status == status::accept);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_committed_batches_roundtrip) {
+    cluster::producer_state_table table;
+    for (int64_t pid = 0; pid < 10; ++pid) {
+        for (int32_t seq = 0; seq < 100; seq += 10) {
+            auto h = make_header(pid, 0, seq, 10);
+            h.base_offset = model::offset(pid * 1000 + seq);
+            table.apply(h);
+        }
+    }
+    // replicated but not yet committed
+    BOOST_REQUIRE(
+      table.try_begin(make_header(0, 0, 100, 10)).status == status::accept);
+
+    auto restored = cluster::producer_state_table::deserialize(
+      table.serialize(model::offset(100000)));
+    BOOST_REQUIRE_EQUAL(restored.size(), 10);
+    for (int64_t pid = 0; pid < 10; ++pid) {
+        auto r = restored.try_begin(make_header(pid, 0, 90, 10));
+        BOOST_REQUIRE(r.status == status::duplicate);
+        BOOST_REQUIRE_EQUAL(r.last_offset, model::offset(pid * 1000 + 99));
+    }
+    // the pending batch is not part of the snapshot
+    BOOST_REQUIRE(
+      restored.try_begin(make_header(0, 0, 100, 10)).status
+      == status::accept);
+}
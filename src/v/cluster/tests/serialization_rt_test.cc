@@ -29,6 +29,9 @@ SEASTAR_THREAD_TEST_CASE(topic_config_rt_test) {
     cfg.compaction_strategy = model::compaction_strategy::offset;
     cfg.compression = model::compression::snappy;
     cfg.segment_size = std::optional<size_t>(1_GiB);
+    cfg.index_interval = std::optional<size_t>(4_KiB);
+    cfg.write_behind = 20ms;
+    cfg.ephemeral = true;
     cfg.retention_bytes = tristate<size_t>{};
     cfg.retention_duration = tristate<std::chrono::milliseconds>(10h);
 
@@ -48,6 +51,9 @@ SEASTAR_THREAD_TEST_CASE(topic_config_rt_test) {
       model::compaction_strategy::offset, d.compaction_strategy);
     BOOST_CHECK(10h == d.retention_duration.value());
     BOOST_REQUIRE_EQUAL(tristate<size_t>{}, d.retention_bytes);
+    BOOST_REQUIRE_EQUAL(d.index_interval, 4_KiB);
+    BOOST_CHECK(d.write_behind == 20ms);
+    BOOST_CHECK(d.ephemeral);
 }
 
 SEASTAR_THREAD_TEST_CASE(broker_metadata_rt_test) {
@@ -8,7 +8,9 @@
 // by the Apache License, Version 2.0
 
 #include "cluster/tests/topic_table_fixture.h"
+#include "bytes/iobuf_parser.h"
 #include "model/fundamental.h"
+#include "reflection/adl.h"
 
 #include <seastar/testing/thread_test_case.hh>
 
@@ -120,3 +122,106 @@ FIXTURE_TEST(test_wait_aborted, topic_table_fixture) {
       table.local().wait_for_changes(local_as).get0(),
       ss::abort_requested_exception);
 }
+
+FIXTURE_TEST(test_topic_revisions, topic_table_fixture) {
+    BOOST_REQUIRE(!table.local().get_topic_revision(make_tp_ns("test_tp_2")));
+    create_topics();
+    auto rev_1 = table.local().get_topic_revision(make_tp_ns("test_tp_1"));
+    auto rev_2 = table.local().get_topic_revision(make_tp_ns("test_tp_2"));
+    BOOST_REQUIRE(rev_1);
+    BOOST_REQUIRE(rev_2);
+    BOOST_REQUIRE_NE(*rev_1, *rev_2);
+
+    // unrelated topic change does not touch other topics revision
+    table.local()
+      .apply(
+        cluster::delete_topic_cmd(
+          make_tp_ns("test_tp_3"), make_tp_ns("test_tp_3")),
+        model::offset(0))
+      .get0();
+    BOOST_REQUIRE(!table.local().get_topic_revision(make_tp_ns("test_tp_3")));
+    BOOST_REQUIRE(
+      table.local().get_topic_revision(make_tp_ns("test_tp_1")) == rev_1);
+    BOOST_REQUIRE(
+      table.local().get_topic_revision(make_tp_ns("test_tp_2")) == rev_2);
+}
+
+static size_t
+added_partitions(const std::vector<cluster::topic_table::delta>& deltas) {
+    size_t n = 0;
+    for (auto& d : deltas) {
+        n += d.partitions.additions.size();
+    }
+    return n;
+}
+
+FIXTURE_TEST(test_snapshot_restores_topics, topic_table_fixture) {
+    create_topics();
+    table.local().wait_for_changes(as).get0();
+    // move the single replica of a partition to another node
+    model::ntp ntp(test_ns, model::topic("test_tp_3"), model::partition_id(0));
+    auto current = table.local().get_partition_assignment(ntp).value();
+    model::node_id target(current.replicas[0].node_id() % 3 + 1);
+    auto res = table.local()
+                 .apply(
+                   cluster::move_partition_replicas_cmd(
+                     ntp, {model::broker_shard{target, 0}}),
+                   model::offset(10))
+                 .get0();
+    BOOST_REQUIRE_EQUAL(res, cluster::errc::success);
+
+    iobuf data = reflection::to_iobuf(table.local().snapshot());
+    iobuf_parser parser(std::move(data));
+    auto snapshot = reflection::adl<cluster::topic_table_snapshot>{}.from(
+      parser);
+
+    cluster::topic_table restored;
+    restored.apply_snapshot(std::move(snapshot), model::offset(20), target);
+    BOOST_REQUIRE_EQUAL(restored.all_topics_metadata().size(), 3);
+    BOOST_REQUIRE_EQUAL(
+      restored.get_partition_assignment(ntp)->replicas[0].node_id, target);
+
+    auto deltas = restored.wait_for_changes(as).get0();
+    BOOST_REQUIRE_EQUAL(added_partitions(deltas), 21);
+    // the moved replica is created at the revision of the move
+    for (auto& d : deltas) {
+        for (auto& [tp_ns, p] : d.partitions.additions) {
+            if (model::ntp(tp_ns.ns, tp_ns.tp, p.id) == ntp) {
+                BOOST_REQUIRE_EQUAL(d.offset, model::offset(10));
+            }
+        }
+    }
+    restored.stop().get0();
+}
+
+FIXTURE_TEST(test_snapshot_diffs_current_state, topic_table_fixture) {
+    create_topics();
+    table.local().wait_for_changes(as).get0();
+    auto snapshot = table.local().snapshot();
+
+    // topics deleted after the snapshot come back, no other delta is made
+    auto res = table.local()
+                 .apply(
+                   cluster::delete_topic_cmd(
+                     make_tp_ns("test_tp_2"), make_tp_ns("test_tp_2")),
+                   model::offset(1))
+                 .get0();
+    BOOST_REQUIRE_EQUAL(res, cluster::errc::success);
+    table.local().wait_for_changes(as).get0();
+    table.local().apply_snapshot(
+      snapshot, model::offset(5), model::node_id(1));
+    auto deltas = table.local().wait_for_changes(as).get0();
+    BOOST_REQUIRE_EQUAL(added_partitions(deltas), 12);
+    BOOST_REQUIRE_EQUAL(table.local().all_topics_metadata().size(), 3);
+
+    // topics missing from the snapshot are deleted
+    auto cmd = make_create_topic_cmd("test_tp_4", 2, 1);
+    table.local().apply(std::move(cmd), model::offset(6)).get0();
+    table.local().wait_for_changes(as).get0();
+    table.local().apply_snapshot(
+      std::move(snapshot), model::offset(7), model::node_id(1));
+    deltas = table.local().wait_for_changes(as).get0();
+    BOOST_REQUIRE_EQUAL(deltas.size(), 1);
+    validate_delta(deltas[0], 0, 0, 1, 2);
+    BOOST_REQUIRE_EQUAL(table.local().all_topics_metadata().size(), 3);
+}
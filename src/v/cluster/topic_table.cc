@@ -12,6 +12,9 @@
 #include "cluster/types.h"
 #include "model/metadata.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace cluster {
 
 template<typename Func>
@@ -44,6 +47,8 @@ topic_table::apply(create_topic_cmd cmd, model::offset offset) {
     }
     _pending_deltas.push_back(std::move(d));
 
+    _revisions[cmd.key] = ++_revision;
+    set_replica_revisions(cmd.value, offset);
     _topics.insert({cmd.key, std::move(cmd.value)});
     notify_waiters();
     return ss::make_ready_future<std::error_code>(errc::success);
@@ -65,6 +70,11 @@ topic_table::apply(delete_topic_cmd cmd, model::offset offset) {
             d.partitions.deletions.emplace_back(tp->first, p);
         }
         _pending_deltas.push_back(std::move(d));
+        for (auto& p : tp->second.assignments) {
+            _replica_revisions.erase(
+              model::ntp(tp->first.ns, tp->first.tp, p.id));
+        }
+        _revisions.erase(tp->first);
         _topics.erase(tp);
         notify_waiters();
         return ss::make_ready_future<std::error_code>(errc::success);
@@ -90,8 +100,24 @@ topic_table::apply(move_partition_replicas_cmd cmd, model::offset o) {
         return ss::make_ready_future<std::error_code>(
           errc::partition_not_exists);
     }
+    // replicas that stay keep their revision
+    auto& revisions = _replica_revisions[cmd.key];
+    std::vector<replica_revision> moved;
+    moved.reserve(cmd.value.size());
+    for (auto& bs : cmd.value) {
+        auto it = std::find_if(
+          revisions.begin(), revisions.end(), [&bs](const replica_revision& r) {
+              return r.node_id == bs.node_id;
+          });
+        moved.push_back(replica_revision{
+          .node_id = bs.node_id,
+          .revision = it == revisions.end() ? o : it->revision});
+    }
+    revisions = std::move(moved);
+
     // replace partition replica set
     current_assignment_it->replicas = cmd.value;
+    _revisions[tp->first] = ++_revision;
 
     // calculate deleta for backend
     delta d(o);
@@ -102,6 +128,135 @@ topic_table::apply(move_partition_replicas_cmd cmd, model::offset o) {
     return ss::make_ready_future<std::error_code>(errc::success);
 }
 
+void topic_table::set_replica_revisions(
+  const topic_configuration_assignment& assignment, model::offset o) {
+    for (auto& pas : assignment.assignments) {
+        auto& revisions = _replica_revisions[model::ntp(
+          assignment.cfg.tp_ns.ns, assignment.cfg.tp_ns.tp, pas.id)];
+        revisions.clear();
+        for (auto& bs : pas.replicas) {
+            revisions.push_back(
+              replica_revision{.node_id = bs.node_id, .revision = o});
+        }
+    }
+}
+
+topic_table_snapshot topic_table::snapshot() const {
+    topic_table_snapshot snapshot;
+    snapshot.topics.reserve(_topics.size());
+    for (auto& [_, assignment] : _topics) {
+        snapshot.topics.push_back(assignment);
+    }
+    snapshot.revisions.reserve(_replica_revisions.size());
+    for (auto& [ntp, replicas] : _replica_revisions) {
+        snapshot.revisions.push_back(
+          partition_revisions{.ntp = ntp, .replicas = replicas});
+    }
+    return snapshot;
+}
+
+static bool same_replicas(
+  const std::vector<model::broker_shard>& lhs,
+  const std::vector<model::broker_shard>& rhs) {
+    return std::equal(
+      lhs.begin(),
+      lhs.end(),
+      rhs.begin(),
+      rhs.end(),
+      [](const model::broker_shard& l, const model::broker_shard& r) {
+          return l.node_id == r.node_id && l.shard == r.shard;
+      });
+}
+
+void topic_table::apply_snapshot(
+  topic_table_snapshot snapshot, model::offset offset, model::node_id self) {
+    absl::flat_hash_map<model::ntp, std::vector<replica_revision>> revisions;
+    revisions.reserve(snapshot.revisions.size());
+    for (auto& p : snapshot.revisions) {
+        revisions.emplace(std::move(p.ntp), std::move(p.replicas));
+    }
+    // revision of the local replica, the offset of the snapshot otherwise
+    auto revision_of = [&revisions, offset, self](const model::ntp& ntp) {
+        if (auto it = revisions.find(ntp); it != revisions.end()) {
+            for (auto& r : it->second) {
+                if (r.node_id == self) {
+                    return r.revision;
+                }
+            }
+        }
+        return offset;
+    };
+
+    absl::flat_hash_map<
+      model::topic_namespace,
+      topic_configuration_assignment,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      topics;
+    topics.reserve(snapshot.topics.size());
+    for (auto& t : snapshot.topics) {
+        auto tp_ns = t.cfg.tp_ns;
+        topics.emplace(std::move(tp_ns), std::move(t));
+    }
+
+    // topics deleted since the state of the table
+    for (auto& [tp_ns, current] : _topics) {
+        if (topics.contains(tp_ns)) {
+            continue;
+        }
+        delta d(offset);
+        d.topics.deletions.push_back(current.cfg);
+        for (auto& p : current.assignments) {
+            d.partitions.deletions.emplace_back(tp_ns, p);
+        }
+        _pending_deltas.push_back(std::move(d));
+        _revisions.erase(tp_ns);
+    }
+
+    for (auto& [tp_ns, assignment] : topics) {
+        auto current = _topics.find(tp_ns);
+        if (current == _topics.end()) {
+            // created since, a delta per partition at its revision
+            bool first = true;
+            for (auto& p : assignment.assignments) {
+                delta d(revision_of(model::ntp(tp_ns.ns, tp_ns.tp, p.id)));
+                if (std::exchange(first, false)) {
+                    d.topics.additions.push_back(assignment.cfg);
+                }
+                d.partitions.additions.emplace_back(tp_ns, p);
+                _pending_deltas.push_back(std::move(d));
+            }
+            _revisions[tp_ns] = ++_revision;
+            continue;
+        }
+        // partitions moved since
+        bool changed = false;
+        for (auto& p : assignment.assignments) {
+            auto it = std::find_if(
+              current->second.assignments.begin(),
+              current->second.assignments.end(),
+              [id = p.id](const partition_assignment& c) {
+                  return c.id == id;
+              });
+            if (
+              it == current->second.assignments.end()
+              || !same_replicas(it->replicas, p.replicas)) {
+                delta d(revision_of(model::ntp(tp_ns.ns, tp_ns.tp, p.id)));
+                d.partitions.updates.emplace_back(tp_ns, p);
+                _pending_deltas.push_back(std::move(d));
+                changed = true;
+            }
+        }
+        if (changed) {
+            _revisions[tp_ns] = ++_revision;
+        }
+    }
+
+    _topics = std::move(topics);
+    _replica_revisions = std::move(revisions);
+    notify_waiters();
+}
+
 void topic_table::notify_waiters() {
     if (_waiters.empty()) {
         return;
@@ -187,6 +342,14 @@ std::vector<model::topic_metadata> topic_table::all_topics_metadata() const {
     });
 }
 
+std::optional<uint64_t>
+topic_table::get_topic_revision(model::topic_namespace_view tp) const {
+    if (auto it = _revisions.find(tp); it != _revisions.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
 bool topic_table::contains(
   model::topic_namespace_view topic, model::partition_id pid) const {
     if (auto it = _topics.find(topic); it != _topics.end()) {
@@ -199,4 +362,23 @@ bool topic_table::contains(
     return false;
 }
 
+std::optional<partition_assignment>
+topic_table::get_partition_assignment(const model::ntp& ntp) const {
+    auto it = _topics.find(model::topic_namespace_view(ntp));
+    if (it == _topics.end()) {
+        return std::nullopt;
+    }
+    const auto& assignments = it->second.assignments;
+    auto p_it = std::find_if(
+      assignments.cbegin(),
+      assignments.cend(),
+      [&ntp](const partition_assignment& pas) {
+          return pas.id == ntp.tp.partition;
+      });
+    if (p_it == assignments.cend()) {
+        return std::nullopt;
+    }
+    return *p_it;
+}
+
 } // namespace cluster
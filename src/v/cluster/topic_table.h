@@ -63,6 +63,14 @@ public:
     ss::future<std::error_code>
       apply(move_partition_replicas_cmd, model::offset);
 
+    /// \brief the topics and the revisions of their replicas
+    topic_table_snapshot snapshot() const;
+    /// \brief replaces the table with a snapshot which includes every
+    /// command up to `offset`. deltas move the backend of the `self` node
+    /// from the current partitions to the ones of the snapshot, partitions
+    /// of the node are created at the revisions of their replicas
+    void apply_snapshot(topic_table_snapshot, model::offset, model::node_id);
+
     ss::future<> stop();
 
     /// Delta API
@@ -100,6 +108,19 @@ public:
     /// Checks if it has given partition
     bool contains(model::topic_namespace_view, model::partition_id) const;
 
+    ///\brief Returns the replicas assignment of a partition
+    ///
+    /// If partition does not exists it returns an empty optional
+    std::optional<partition_assignment>
+    get_partition_assignment(const model::ntp&) const;
+
+    ///\brief Returns a revision of the topic that changes whenever its
+    /// configuration or partition assignments do.
+    ///
+    /// If topic does not exists it returns an empty optional
+    std::optional<uint64_t>
+      get_topic_revision(model::topic_namespace_view) const;
+
     /// Returns partition leader
     std::optional<model::node_id> get_leader(const model::ntp&) const;
 
@@ -116,6 +137,8 @@ private:
         uint64_t id;
     };
     void deallocate_topic_partitions(const std::vector<partition_assignment>&);
+    void
+    set_replica_revisions(const topic_configuration_assignment&, model::offset);
 
     void notify_waiters();
 
@@ -130,6 +153,18 @@ private:
       model::topic_namespace_eq>
       _topics;
 
+    // per topic revisions drawn from a shard local counter
+    absl::flat_hash_map<
+      model::topic_namespace,
+      uint64_t,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      _revisions;
+    uint64_t _revision{0};
+
+    absl::flat_hash_map<model::ntp, std::vector<replica_revision>>
+      _replica_revisions;
+
     std::vector<delta> _pending_deltas;
     std::vector<std::unique_ptr<waiter>> _waiters;
     uint64_t _waiter_id{0};
@@ -9,9 +9,17 @@
 
 #include "cluster/topic_updates_dispatcher.h"
 
+#include "bytes/iobuf_parser.h"
 #include "cluster/commands.h"
+#include "config/configuration.h"
+#include "model/adl_serde.h"
 #include "model/metadata.h"
+#include "model/record_view.h"
 #include "raft/types.h"
+#include "reflection/adl.h"
+#include "reflection/async_adl.h"
+
+#include <seastar/core/do_with.hh>
 
 #include <iterator>
 #include <system_error>
@@ -50,7 +58,7 @@ topic_updates_dispatcher::apply_update(model::record_batch b) {
                 return dispatch_updates_to_cores(create_cmd, base_offset)
                   .then([this, create_cmd](std::error_code ec) {
                       if (ec == errc::success) {
-                          update_allocations(create_cmd);
+                          update_allocations(create_cmd.value);
                       }
                       return ec;
                   });
@@ -84,6 +92,59 @@ topic_updates_dispatcher::apply_update(model::record_batch b) {
       });
 }
 
+std::optional<bytes> topic_updates_dispatcher::concurrency_key(
+  const model::record_batch& b) const {
+    if (b.compressed() || b.record_count() != 1) {
+        return std::nullopt;
+    }
+    /*
+     * the keys of the topic commands are a topic namespace or an ntp, which
+     * is serialized as the namespace and the topic followed by the partition.
+     * either way the key starts with the topic namespace.
+     */
+    auto key = model::record_view_reader(b).next().copy_key();
+    iobuf_parser parser(key.share(0, key.size_bytes()));
+    reflection::adl<model::topic_namespace>{}.from(parser);
+    return iobuf_to_bytes(key.share(0, parser.bytes_consumed()));
+}
+
+ss::future<iobuf> topic_updates_dispatcher::take_snapshot() {
+    return ss::do_with(iobuf(), [this](iobuf& out) {
+        return reflection::async_adl<topic_table_snapshot>{}
+          .to(out, _topic_table.local().snapshot())
+          .then([&out] { return std::move(out); });
+    });
+}
+
+ss::future<>
+topic_updates_dispatcher::apply_snapshot(model::offset offset, iobuf data) {
+    return ss::do_with(
+      iobuf_parser(std::move(data)), [this, offset](iobuf_parser& parser) {
+          return reflection::async_adl<topic_table_snapshot>{}
+            .from(parser)
+            .then([this, offset](topic_table_snapshot snapshot) {
+                return do_apply_snapshot(offset, std::move(snapshot));
+            });
+      });
+}
+
+ss::future<> topic_updates_dispatcher::do_apply_snapshot(
+  model::offset offset, topic_table_snapshot snapshot) {
+    // allocations of the current topics are replaced by the ones of the
+    // snapshot
+    for (auto& tp_md : _topic_table.local().all_topics_metadata()) {
+        deallocate_topic(tp_md);
+    }
+    for (auto& t : snapshot.topics) {
+        update_allocations(t);
+    }
+    model::node_id self(config::shard_local_cfg().node_id());
+    return _topic_table.invoke_on_all(
+      [snapshot = std::move(snapshot), offset, self](topic_table& table) {
+          table.apply_snapshot(snapshot, offset, self);
+      });
+}
+
 template<typename Cmd>
 ss::future<std::error_code> do_apply(
   ss::shard_id shard,
@@ -147,11 +208,12 @@ void topic_updates_dispatcher::reallocate_partition(
       current, raft::group_id(0));
 }
 
-void topic_updates_dispatcher::update_allocations(const create_topic_cmd& cmd) {
+void topic_updates_dispatcher::update_allocations(
+  const topic_configuration_assignment& assignment) {
     // for create topics we update allocation state
     std::vector<model::broker_shard> shards;
     raft::group_id max_group_id = raft::group_id(0);
-    for (auto& pas : cmd.value.assignments) {
+    for (auto& pas : assignment.assignments) {
         max_group_id = std::max(max_group_id, pas.group);
         std::move(
           pas.replicas.begin(), pas.replicas.end(), std::back_inserter(shards));
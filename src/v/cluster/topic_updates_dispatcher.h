@@ -10,6 +10,7 @@
  */
 
 #pragma once
+#include "bytes/bytes.h"
 #include "cluster/commands.h"
 #include "cluster/partition_allocator.h"
 #include "cluster/topic_table.h"
@@ -17,6 +18,8 @@
 
 #include <seastar/core/sharded.hh>
 
+#include <optional>
+
 namespace cluster {
 
 // The topic updates dispatcher is resposible for receiving update_apply upcalls
@@ -62,11 +65,22 @@ public:
         return batch.header().type == topic_batch_type;
     }
 
+    /// \brief commands of distinct topics commute, see
+    /// raft::mux_state_machine. the allocator updates they make are counts
+    /// and maxima, which do not depend on the order either
+    std::optional<bytes> concurrency_key(const model::record_batch&) const;
+
+    /// \brief the topic table, the allocator state is derived from it
+    ss::future<iobuf> take_snapshot();
+    /// \brief replaces the topic tables of all cores and the allocations
+    ss::future<> apply_snapshot(model::offset, iobuf);
+
 private:
     template<typename Cmd>
     ss::future<std::error_code> dispatch_updates_to_cores(Cmd, model::offset);
 
-    void update_allocations(const create_topic_cmd&);
+    ss::future<> do_apply_snapshot(model::offset, topic_table_snapshot);
+    void update_allocations(const topic_configuration_assignment&);
     void deallocate_topic(const model::topic_metadata&);
     void reallocate_partition(
       const std::vector<model::broker_shard>&,
@@ -62,18 +62,7 @@ ss::future<std::vector<topic_result>> topics_frontend::create_topics(
               return ss::make_ready_future<std::vector<topic_result>>(
                 create_topic_results(topics, errc::not_leader_controller));
           }
-          std::vector<ss::future<topic_result>> futures;
-          futures.reserve(topics.size());
-
-          std::transform(
-            std::begin(topics),
-            std::end(topics),
-            std::back_inserter(futures),
-            [this, timeout](topic_configuration& t_cfg) {
-                return do_create_topic(std::move(t_cfg), timeout);
-            });
-
-          return ss::when_all_succeed(futures.begin(), futures.end());
+          return do_create_topics(std::move(topics), timeout);
       });
 }
 
@@ -125,79 +114,161 @@ ss::future<std::error_code> topics_frontend::replicate_and_wait(
       });
 }
 
-ss::future<topic_result> topics_frontend::do_create_topic(
-  topic_configuration t_cfg, model::timeout_clock::time_point timeout) {
-    if (!validate_topic_name(t_cfg.tp_ns)) {
-        return ss::make_ready_future<topic_result>(
-          topic_result(t_cfg.tp_ns, errc::invalid_topic_name));
+template<typename Cmd>
+ss::future<std::vector<std::error_code>>
+topics_frontend::replicate_and_wait_all(
+  std::vector<Cmd> cmds, model::timeout_clock::time_point timeout) {
+    return _stm.invoke_on(
+      controller_stm_shard,
+      [cmds = std::move(cmds), &as = _as, timeout](
+        controller_stm& stm) mutable {
+          std::vector<ss::future<model::record_batch>> batches;
+          batches.reserve(cmds.size());
+          for (auto& cmd : cmds) {
+              batches.push_back(serialize_cmd(std::move(cmd)));
+          }
+          return ss::do_with(
+            std::move(batches),
+            [&stm, &as, timeout](
+              std::vector<ss::future<model::record_batch>>& batches) {
+                return ss::when_all_succeed(batches.begin(), batches.end())
+                  .then([&stm, &as, timeout](
+                          std::vector<model::record_batch> batches) {
+                      return stm.replicate_and_wait(
+                        std::move(batches), timeout, as.local());
+                  });
+            });
+      });
+}
+
+ss::future<std::vector<topic_result>> topics_frontend::do_create_topics(
+  std::vector<topic_configuration> topics,
+  model::timeout_clock::time_point timeout) {
+    auto results = create_topic_results(topics, errc::success);
+    // positions of the topics left to create in the results
+    std::vector<size_t> positions;
+    std::vector<topic_configuration> valid;
+    for (size_t i = 0; i < topics.size(); ++i) {
+        if (!validate_topic_name(topics[i].tp_ns)) {
+            results[i].ec = errc::invalid_topic_name;
+            continue;
+        }
+        positions.push_back(i);
+        valid.push_back(std::move(topics[i]));
     }
+    if (valid.empty()) {
+        return ss::make_ready_future<std::vector<topic_result>>(
+          std::move(results));
+    }
+    using units_t = std::optional<partition_allocator::allocation_units>;
+    // a single pass over the topics, every allocation accounts for the
+    // partitions of the topics allocated before it
     return _allocator
       .invoke_on(
         partition_allocator::shard,
-        [t_cfg](partition_allocator& al) { return al.allocate(t_cfg); })
-      .then(
-        [this, t_cfg = std::move(t_cfg), timeout](
-          std::optional<partition_allocator::allocation_units> units) mutable {
-            // no assignments, error
-            if (!units) {
-                return ss::make_ready_future<topic_result>(
-                  topic_result(t_cfg.tp_ns, errc::topic_invalid_partitions));
+        [cfgs = valid](partition_allocator& al) {
+            std::vector<units_t> units;
+            units.reserve(cfgs.size());
+            for (const auto& cfg : cfgs) {
+                units.push_back(al.allocate(cfg));
             }
-
-            return replicate_create_topic(
-              std::move(t_cfg), std::move(*units), timeout);
-        });
+            return units;
+        })
+      .then([this,
+             results = std::move(results),
+             positions = std::move(positions),
+             valid = std::move(valid),
+             timeout](std::vector<units_t> units) mutable {
+          std::vector<create_topic_cmd> cmds;
+          std::vector<partition_allocator::allocation_units> allocated;
+          std::vector<size_t> replicated;
+          for (size_t i = 0; i < valid.size(); ++i) {
+              // no assignments, error
+              if (!units[i]) {
+                  results[positions[i]].ec = errc::topic_invalid_partitions;
+                  continue;
+              }
+              auto tp_ns = valid[i].tp_ns;
+              cmds.emplace_back(
+                std::move(tp_ns),
+                topic_configuration_assignment(
+                  std::move(valid[i]), units[i]->get_assignments()));
+              allocated.push_back(std::move(*units[i]));
+              replicated.push_back(positions[i]);
+          }
+          if (cmds.empty()) {
+              return ss::make_ready_future<std::vector<topic_result>>(
+                std::move(results));
+          }
+          return replicate_create_topics(
+                   std::move(cmds), std::move(allocated), timeout)
+            .then([results = std::move(results),
+                   replicated = std::move(replicated)](
+                    std::vector<errc> errors) mutable {
+                for (size_t i = 0; i < errors.size(); ++i) {
+                    results[replicated[i]].ec = errors[i];
+                }
+                return std::move(results);
+            });
+      });
 }
 
-ss::future<topic_result> topics_frontend::replicate_create_topic(
-  topic_configuration cfg,
-  partition_allocator::allocation_units units,
+ss::future<std::vector<errc>> topics_frontend::replicate_create_topics(
+  std::vector<create_topic_cmd> cmds,
+  std::vector<partition_allocator::allocation_units> units,
   model::timeout_clock::time_point timeout) {
-    auto tp_ns = cfg.tp_ns;
-    create_topic_cmd cmd(
-      tp_ns,
-      topic_configuration_assignment(std::move(cfg), units.get_assignments()));
-
-    std::vector<ntp_leader> leaders;
-    leaders.reserve(cmd.value.assignments.size());
-    for (auto& p_as : cmd.value.assignments) {
-        std::shuffle(
-          p_as.replicas.begin(),
-          p_as.replicas.end(),
-          random_generators::internal::gen);
-        // guesstimate leaders
-        leaders.emplace_back(
-          model::ntp(tp_ns.ns, tp_ns.tp, p_as.id),
-          p_as.replicas.begin()->node_id);
+    std::vector<std::vector<ntp_leader>> leaders;
+    leaders.reserve(cmds.size());
+    for (auto& cmd : cmds) {
+        auto& topic_leaders = leaders.emplace_back();
+        topic_leaders.reserve(cmd.value.assignments.size());
+        for (auto& p_as : cmd.value.assignments) {
+            std::shuffle(
+              p_as.replicas.begin(),
+              p_as.replicas.end(),
+              random_generators::internal::gen);
+            // guesstimate leaders
+            topic_leaders.emplace_back(
+              model::ntp(cmd.key.ns, cmd.key.tp, p_as.id),
+              p_as.replicas.begin()->node_id);
+        }
     }
-
-    return replicate_and_wait(std::move(cmd), timeout)
-      .then_wrapped(
-        [this,
-         tp_ns = std::move(tp_ns),
-         units = std::move(units),
-         leaders = std::move(leaders)](ss::future<std::error_code> f) mutable {
-            try {
-                auto error_code = f.get0();
-                auto ret_f = ss::now();
-                if (!error_code) {
-                    ret_f = update_leaders_with_estimates(std::move(leaders));
-                }
-
-                return ret_f.then([tp_ns = std::move(tp_ns),
-                                   error_code]() mutable {
-                    return topic_result(std::move(tp_ns), map_errc(error_code));
-                });
-
-            } catch (...) {
-                vlog(
-                  clusterlog.warn,
-                  "Unable to create topic - {}",
-                  std::current_exception());
-                return ss::make_ready_future<topic_result>(
-                  topic_result(std::move(tp_ns), errc::replication_error));
-            }
-        });
+    const auto n = cmds.size();
+    // the allocation units are held until the commands are applied
+    return replicate_and_wait_all(std::move(cmds), timeout)
+      .then_wrapped([this,
+                     n,
+                     units = std::move(units),
+                     leaders = std::move(leaders)](
+                      ss::future<std::vector<std::error_code>> f) mutable {
+          std::vector<std::error_code> codes;
+          try {
+              codes = f.get0();
+          } catch (...) {
+              vlog(
+                clusterlog.warn,
+                "Unable to create topics - {}",
+                std::current_exception());
+              return ss::make_ready_future<std::vector<errc>>(
+                std::vector<errc>(n, errc::replication_error));
+          }
+          std::vector<errc> errors;
+          errors.reserve(codes.size());
+          std::vector<ntp_leader> created;
+          for (size_t i = 0; i < codes.size(); ++i) {
+              errors.push_back(map_errc(codes[i]));
+              if (!codes[i]) {
+                  std::move(
+                    leaders[i].begin(),
+                    leaders[i].end(),
+                    std::back_inserter(created));
+              }
+          }
+          return update_leaders_with_estimates(std::move(created))
+            .then([errors = std::move(errors)]() mutable {
+                return std::move(errors);
+            });
+      });
 }
 
 ss::future<> topics_frontend::update_leaders_with_estimates(
@@ -57,12 +57,13 @@ public:
 private:
     using ntp_leader = std::pair<model::ntp, model::node_id>;
 
-    ss::future<topic_result>
-      do_create_topic(topic_configuration, model::timeout_clock::time_point);
+    ss::future<std::vector<topic_result>> do_create_topics(
+      std::vector<topic_configuration>, model::timeout_clock::time_point);
 
-    ss::future<topic_result> replicate_create_topic(
-      topic_configuration,
-      partition_allocator::allocation_units,
+    // returns the results in the order of the commands
+    ss::future<std::vector<errc>> replicate_create_topics(
+      std::vector<create_topic_cmd>,
+      std::vector<partition_allocator::allocation_units>,
       model::timeout_clock::time_point);
 
     ss::future<topic_result>
@@ -72,6 +73,11 @@ private:
     ss::future<std::error_code>
     replicate_and_wait(Cmd&&, model::timeout_clock::time_point);
 
+    // replicates the commands with a single append to the controller log
+    template<typename Cmd>
+    ss::future<std::vector<std::error_code>>
+    replicate_and_wait_all(std::vector<Cmd>, model::timeout_clock::time_point);
+
     ss::future<std::vector<topic_result>> dispatch_create_to_leader(
       model::node_id,
       std::vector<topic_configuration>,
@@ -33,10 +33,12 @@ storage::ntp_config topic_configuration::make_ntp_config(
   model::partition_id p_id,
   storage::ntp_config::ntp_id version) const {
     auto has_overrides = cleanup_policy_bitflags || compaction_strategy
-                         || segment_size || retention_bytes.has_value()
+                         || segment_size || index_interval
+                         || retention_bytes.has_value()
                          || retention_bytes.is_disabled()
                          || retention_duration.has_value()
-                         || retention_duration.is_disabled();
+                         || retention_duration.is_disabled() || write_behind
+                         || compression || ephemeral;
     std::unique_ptr<storage::ntp_config::default_overrides> overrides = nullptr;
 
     if (has_overrides) {
@@ -45,8 +47,12 @@ storage::ntp_config topic_configuration::make_ntp_config(
             .cleanup_policy_bitflags = cleanup_policy_bitflags,
             .compaction_strategy = compaction_strategy,
             .segment_size = segment_size,
+            .index_interval = index_interval,
             .retention_bytes = retention_bytes,
-            .retention_time = retention_duration});
+            .retention_time = retention_duration,
+            .write_behind = write_behind,
+            .compression = compression,
+            .ephemeral = ephemeral});
     }
     return storage::ntp_config(
       model::ntp(tp_ns.ns, tp_ns.tp, p_id),
@@ -81,7 +87,8 @@ std::ostream& operator<<(std::ostream& o, const topic_configuration& cfg) {
       "{{ topic: {}, partition_count: {}, replication_factor: {}, compression: "
       "{}, cleanup_policy_bitflags: {}, compaction_strategy: {}, "
       "retention_bytes: {}, "
-      "retention_duration_hours: {}, segment_size: {}, timestamp_type: {} }}",
+      "retention_duration_hours: {}, segment_size: {}, index_interval: {}, "
+      "timestamp_type: {}, write_behind_ms: {}, ephemeral: {} }}",
       cfg.tp_ns,
       cfg.partition_count,
       cfg.replication_factor,
@@ -91,7 +98,10 @@ std::ostream& operator<<(std::ostream& o, const topic_configuration& cfg) {
       cfg.retention_bytes,
       cfg.retention_duration,
       cfg.segment_size,
-      cfg.timestamp_type);
+      cfg.index_interval,
+      cfg.timestamp_type,
+      cfg.write_behind,
+      cfg.ephemeral);
 
     return o;
 }
@@ -126,7 +136,10 @@ void adl<cluster::topic_configuration>::to(
       t.timestamp_type,
       t.segment_size,
       t.retention_bytes,
-      t.retention_duration);
+      t.retention_duration,
+      t.index_interval,
+      t.write_behind,
+      t.ephemeral);
 }
 
 cluster::topic_configuration
@@ -149,6 +162,10 @@ adl<cluster::topic_configuration>::from(iobuf_parser& in) {
     cfg.retention_bytes = adl<tristate<size_t>>{}.from(in);
     cfg.retention_duration = adl<tristate<std::chrono::milliseconds>>{}.from(
       in);
+    cfg.index_interval = adl<std::optional<size_t>>{}.from(in);
+    cfg.write_behind = adl<std::optional<std::chrono::milliseconds>>{}.from(
+      in);
+    cfg.ephemeral = adl<bool>{}.from(in);
 
     return cfg;
 }
@@ -256,6 +273,63 @@ adl<cluster::topic_configuration_assignment>::from(iobuf_parser& in) {
       std::move(cfg), std::move(assignments));
 }
 
+void adl<cluster::topic_table_snapshot>::to(
+  iobuf& out, cluster::topic_table_snapshot&& snapshot) {
+    reflection::serialize(
+      out,
+      cluster::topic_table_snapshot::current_version,
+      std::move(snapshot.topics),
+      std::move(snapshot.revisions));
+}
+
+cluster::topic_table_snapshot
+adl<cluster::topic_table_snapshot>::from(iobuf_parser& in) {
+    auto version = adl<int8_t>{}.from(in);
+    vassert(
+      version == cluster::topic_table_snapshot::current_version,
+      "Unsupported topic table snapshot version {}",
+      version);
+    cluster::topic_table_snapshot snapshot;
+    snapshot.topics
+      = adl<std::vector<cluster::topic_configuration_assignment>>{}.from(in);
+    snapshot.revisions
+      = adl<std::vector<cluster::partition_revisions>>{}.from(in);
+    return snapshot;
+}
+
+ss::future<> async_adl<cluster::topic_table_snapshot>::to(
+  iobuf& out, cluster::topic_table_snapshot&& snapshot) {
+    adl<int8_t>{}.to(out, cluster::topic_table_snapshot::current_version);
+    auto revisions = std::move(snapshot.revisions);
+    return async_adl<std::vector<cluster::topic_configuration_assignment>>{}
+      .to(out, std::move(snapshot.topics))
+      .then([&out, revisions = std::move(revisions)]() mutable {
+          return async_adl<std::vector<cluster::partition_revisions>>{}.to(
+            out, std::move(revisions));
+      });
+}
+
+ss::future<cluster::topic_table_snapshot>
+async_adl<cluster::topic_table_snapshot>::from(iobuf_parser& in) {
+    auto version = adl<int8_t>{}.from(in);
+    vassert(
+      version == cluster::topic_table_snapshot::current_version,
+      "Unsupported topic table snapshot version {}",
+      version);
+    using topics_t = std::vector<cluster::topic_configuration_assignment>;
+    return async_adl<topics_t>{}.from(in).then([&in](topics_t topics) {
+        return async_adl<std::vector<cluster::partition_revisions>>{}
+          .from(in)
+          .then([topics = std::move(topics)](
+                  std::vector<cluster::partition_revisions> revisions) mutable {
+              cluster::topic_table_snapshot snapshot;
+              snapshot.topics = std::move(topics);
+              snapshot.revisions = std::move(revisions);
+              return snapshot;
+          });
+    });
+}
+
 void adl<cluster::configuration_invariants>::to(
   iobuf& out, cluster::configuration_invariants&& r) {
     reflection::serialize(out, r.version, r.node_id, r.core_count);
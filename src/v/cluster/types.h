@@ -18,6 +18,7 @@
 #include "model/timeout_clock.h"
 #include "raft/types.h"
 #include "reflection/adl.h"
+#include "reflection/async_adl.h"
 #include "storage/types.h"
 #include "tristate.h"
 #include "utils/to_string.h"
@@ -56,6 +57,34 @@ struct configuration_update_reply {
     bool success;
 };
 
+/// Load of a single shard as measured by the node owning it
+struct shard_load {
+    // bytes of the logs of the partitions hosted by the shard
+    uint64_t partitions_bytes{0};
+    // records produced per second to the partitions the shard leads
+    uint64_t produced_records_rate{0};
+    // NUMA node of the core running the shard, -1 when unknown
+    int32_t numa_node{-1};
+};
+
+/// Load reported periodically by every node, used to weight partition
+/// allocation
+struct node_load {
+    model::node_id id;
+    std::vector<shard_load> shards;
+    uint64_t disk_free_bytes{0};
+    uint64_t disk_total_bytes{0};
+    // NUMA node of the network interface serving the kafka api, -1 when
+    // unknown or when listening on every interface
+    int32_t nic_numa_node{-1};
+};
+
+struct node_load_report_request {
+    node_load load;
+};
+
+struct node_load_report_reply {};
+
 /// Partition assignment describes an assignment of all replicas for single NTP.
 /// The replicas are hold in vector of broker_shard.
 struct partition_assignment {
@@ -95,6 +124,7 @@ struct topic_configuration {
     std::optional<model::compaction_strategy> compaction_strategy;
     std::optional<model::timestamp_type> timestamp_type;
     std::optional<size_t> segment_size;
+    std::optional<size_t> index_interval;
 
     // Tristate fields
     // Mapped according to the following policy:
@@ -105,6 +135,12 @@ struct topic_configuration {
     tristate<size_t> retention_bytes;
     tristate<std::chrono::milliseconds> retention_duration;
 
+    // lag allowed to relaxed consistency writes acknowledged ahead of the log
+    std::optional<std::chrono::milliseconds> write_behind;
+
+    // partitions are replicated but kept in memory only
+    bool ephemeral{false};
+
     friend std::ostream& operator<<(std::ostream&, const topic_configuration&);
 };
 
@@ -120,6 +156,26 @@ struct topic_configuration_assignment {
     model::topic_metadata get_metadata() const;
 };
 
+/// Offset of the controller command that placed a replica of a partition on
+/// a node. The partition directory of the replica is named after it.
+struct replica_revision {
+    model::node_id node_id;
+    model::offset revision;
+};
+
+struct partition_revisions {
+    model::ntp ntp;
+    std::vector<replica_revision> replicas;
+};
+
+/// State of the topic table persisted in controller snapshots
+struct topic_table_snapshot {
+    static constexpr int8_t current_version = 0;
+
+    std::vector<topic_configuration_assignment> topics;
+    std::vector<partition_revisions> revisions;
+};
+
 struct topic_result {
     explicit topic_result(model::topic_namespace t, errc ec = errc::success)
       : tp_ns(std::move(t))
@@ -243,6 +299,20 @@ struct adl<cluster::topic_configuration_assignment> {
     cluster::topic_configuration_assignment from(iobuf_parser&);
 };
 
+template<>
+struct adl<cluster::topic_table_snapshot> {
+    void to(iobuf&, cluster::topic_table_snapshot&&);
+    cluster::topic_table_snapshot from(iobuf_parser&);
+};
+
+// the snapshot holds every topic of the cluster, it is (de)serialized in
+// chunks not to stall the reactor. the layout is the one of adl
+template<>
+struct async_adl<cluster::topic_table_snapshot> {
+    ss::future<> to(iobuf&, cluster::topic_table_snapshot&&);
+    ss::future<cluster::topic_table_snapshot> from(iobuf_parser&);
+};
+
 template<>
 struct adl<cluster::configuration_invariants> {
     void to(iobuf&, cluster::configuration_invariants&&);
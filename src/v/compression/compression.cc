@@ -13,6 +13,7 @@
 #include "compression/internal/lz4_frame_compressor.h"
 #include "compression/internal/snappy_java_compressor.h"
 #include "compression/internal/zstd_compressor.h"
+#include "compression/zstd_dictionary.h"
 
 namespace compression {
 iobuf compressor::compress(const iobuf& io, type t) {
@@ -30,6 +31,33 @@ iobuf compressor::compress(const iobuf& io, type t) {
     }
     __builtin_unreachable();
 }
+iobuf compressor::compress(const iobuf& io, type t, int level) {
+    switch (t) {
+    case type::lz4:
+        return internal::lz4_frame_compressor::compress(io, level);
+    case type::zstd:
+        return internal::zstd_compressor::compress(io, level);
+    default:
+        throw std::runtime_error(fmt::format(
+          "compressor: levels are only supported by lz4 and zstd, not:{}",
+          (int)t));
+    }
+}
+iobuf compressor::compress(
+  const iobuf& io, type t, const seastar::sstring& dictionary) {
+    if (t != type::zstd) {
+        throw std::runtime_error(fmt::format(
+          "compressor: dictionaries are only supported by zstd, not:{}",
+          (int)t));
+    }
+    auto d = zstd_dictionaries().find(dictionary);
+    if (!d) {
+        throw std::runtime_error(
+          fmt::format("compressor: unknown dictionary:{}", dictionary));
+    }
+    return internal::zstd_compressor::compress(io, *d);
+}
+
 iobuf compressor::uncompress(const iobuf& io, type t) {
     if (io.empty()) {
         throw std::runtime_error(
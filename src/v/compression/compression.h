@@ -12,6 +12,9 @@
 #pragma once
 #include "bytes/iobuf.h"
 #include "model/compression.h"
+
+#include <seastar/core/sstring.hh>
+
 namespace compression {
 
 using type = model::compression;
@@ -21,6 +24,13 @@ using type = model::compression;
 struct compressor {
     static iobuf compress(const iobuf&, type);
     static iobuf uncompress(const iobuf&, type);
+    /// compression with a codec specific level. supported by lz4 and zstd
+    static iobuf compress(const iobuf&, type, int level);
+    /// compression with a dictionary registered with zstd_dictionaries() on
+    /// this shard. only zstd supports dictionaries. uncompress() needs no
+    /// dictionary name since zstd frames identify their dictionary
+    static iobuf
+    compress(const iobuf&, type, const seastar::sstring& dictionary);
 };
 
 } // namespace compression
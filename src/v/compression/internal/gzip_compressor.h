@@ -13,6 +13,10 @@
 #include "bytes/iobuf.h"
 namespace compression::internal {
 
+/// gzip through libdeflate, which picks the crc32 and adler32 kernels for
+/// the cpu at runtime. libdeflate works on whole buffers, so the streams it
+/// cannot size from their trailer, such as those of several members, are
+/// handed to zlib_gzip_compressor
 struct gzip_compressor {
     static iobuf compress(const iobuf&);
     static iobuf uncompress(const iobuf&);
@@ -9,7 +9,6 @@
 
 #include "compression/internal/lz4_frame_compressor.h"
 
-#include "bytes/bytes.h"
 #include "compression/logger.h"
 #include "static_deleter_fn.h"
 #include "units.h"
@@ -21,6 +20,9 @@
 #include <lz4.h>
 #include <lz4frame.h>
 
+#include <algorithm>
+#include <array>
+
 namespace compression::internal {
 // from frameCompress.c
 static constexpr size_t lz4f_header_size = 19;
@@ -66,13 +68,26 @@ static lz4_decompression_ctx make_decompression_context() {
     return lz4_decompression_ctx(c);
 }
 
-iobuf lz4_frame_compressor::compress(const iobuf& b) {
-    auto ctx_ptr = make_compression_context();
-    LZ4F_compressionContext_t ctx = ctx_ptr.get();
+// (de)compression is synchronous, contexts are created once per shard. lz4f
+// resets a compression context in LZ4F_compressBegin and a decompression
+// context once it reaches the end of a frame
+static LZ4F_cctx* shard_compression_context() {
+    static thread_local lz4_compression_ctx ctx = make_compression_context();
+    return ctx.get();
+}
+
+static LZ4F_dctx* shard_decompression_context() {
+    static thread_local lz4_decompression_ctx ctx
+      = make_decompression_context();
+    return ctx.get();
+}
+
+iobuf lz4_frame_compressor::compress(const iobuf& b, int level) {
+    LZ4F_compressionContext_t ctx = shard_compression_context();
     /* Required by Kafka */
     LZ4F_preferences_t prefs;
     std::memset(&prefs, 0, sizeof(prefs));
-    prefs.compressionLevel = 1; // default
+    prefs.compressionLevel = level;
     prefs.frameInfo = {
       .blockMode = LZ4F_blockIndependent, .contentSize = b.size_bytes()};
     const size_t output_buffer_size = LZ4F_compressBound(b.size_bytes(), &prefs)
@@ -120,69 +135,87 @@ compute_frame_uncompressed_size(size_t frame_size, size_t original) {
     return frame_size;
 }
 
-static iobuf do_uncompressed(const char* src, const size_t src_size) {
-    auto ctx_ptr = make_decompression_context();
-    LZ4F_decompressionContext_t ctx = ctx_ptr.get();
+/// the frame is decoded fragment by fragment, only its header is copied
+static iobuf do_uncompressed(const iobuf& b) {
+    LZ4F_decompressionContext_t ctx = shard_decompression_context();
+    // a frame that failed to decode leaves state behind
+    LZ4F_resetDecompressionContext(ctx);
+    const size_t src_size = b.size_bytes();
+    std::array<char, lz4f_header_size> header{};
+    size_t in_sz = std::min(src_size, header.size());
+    iobuf::iterator_consumer(b.cbegin(), b.cend())
+      .consume_to(in_sz, header.data());
     LZ4F_frameInfo_t fi;
-    size_t in_sz = src_size;
-    LZ4F_errorCode_t code = LZ4F_getFrameInfo(ctx, &fi, src, &in_sz);
+    LZ4F_errorCode_t code = LZ4F_getFrameInfo(ctx, &fi, header.data(), &in_sz);
     check_lz4_error("lz4f_getframeinfo error: {}", code);
     size_t estimated_output_size = compute_frame_uncompressed_size(
       fi.contentSize, src_size);
     ss::temporary_buffer<char> obuf(estimated_output_size);
     char* out = obuf.get_write();
-    /* Decompress input buffer t o output buffer until input is exhausted. */
 
+    // the header bytes were consumed by LZ4F_getFrameInfo
+    size_t skip = in_sz;
     size_t bytes_remaining = in_sz;
     size_t consumed_bytes = 0;
-    while (bytes_remaining < src_size) {
-        size_t step_output_bytes = estimated_output_size - consumed_bytes;
-        size_t step_remaining_bytes = src_size - bytes_remaining;
-        code = LZ4F_decompress(
-          ctx,
-          // NOLINTNEXTLINE
-          out + consumed_bytes,
-          &step_output_bytes,
-          // NOLINTNEXTLINE
-          src + bytes_remaining,
-          &step_remaining_bytes,
-          nullptr);
-        check_lz4_error("lz4f_decompress error: {}", code);
-        vassert(
-          consumed_bytes + step_output_bytes <= estimated_output_size,
-          "Appended more bytes that allowed. Max:{}, consumed:{}",
-          estimated_output_size,
-          consumed_bytes + step_output_bytes);
-        vassert(
-          bytes_remaining <= src_size,
-          "Consumed more bytes than input. Max:{}, consumed:{}",
-          src_size,
-          bytes_remaining);
-        consumed_bytes += step_output_bytes;
-        bytes_remaining += step_remaining_bytes;
+    for (const auto& frag : b) {
+        if (skip >= frag.size()) {
+            skip -= frag.size();
+            continue;
+        }
+        // NOLINTNEXTLINE
+        const char* src = frag.get() + skip;
+        size_t left = frag.size() - skip;
+        skip = 0;
+        while (left > 0) {
+            size_t step_output_bytes = estimated_output_size - consumed_bytes;
+            size_t step_remaining_bytes = left;
+            code = LZ4F_decompress(
+              ctx,
+              // NOLINTNEXTLINE
+              out + consumed_bytes,
+              &step_output_bytes,
+              src,
+              &step_remaining_bytes,
+              nullptr);
+            check_lz4_error("lz4f_decompress error: {}", code);
+            vassert(
+              consumed_bytes + step_output_bytes <= estimated_output_size,
+              "Appended more bytes that allowed. Max:{}, consumed:{}",
+              estimated_output_size,
+              consumed_bytes + step_output_bytes);
+            consumed_bytes += step_output_bytes;
+            bytes_remaining += step_remaining_bytes;
+            // NOLINTNEXTLINE
+            src += step_remaining_bytes;
+            left -= step_remaining_bytes;
+            if (code == 0) {
+                break;
+            }
+            /* Need to grow output buffer, this shouldn't happen if
+             * contentSize was properly set. Happens all of the time with the
+             * console producer 2.3.1 and below*/
+            if (consumed_bytes == estimated_output_size) {
+                // TODO: add probes for re-growth
+                const size_t next_size = 1_KiB /*slack*/
+                                         + ((estimated_output_size * 3) + 1)
+                                             / 2;
+                vlog(
+                  complog.trace,
+                  "Consumed bytes:{} has reached preallocated size. Growing "
+                  "to size:{}",
+                  consumed_bytes,
+                  next_size);
+                ss::temporary_buffer<char> tmpo(next_size);
+                std::copy_n(obuf.get(), consumed_bytes, tmpo.get_write());
+                obuf = std::move(tmpo);
+                // update the pointer back to the original position
+                out = obuf.get_write();
+                estimated_output_size = next_size;
+            }
+        }
         if (code == 0) {
             break;
         }
-        /* Need to grow output buffer, this shouldn't happen if
-         * contentSize was properly set. Happens all of the time with the
-         * console producer 2.3.1 and below*/
-        if (consumed_bytes == estimated_output_size) {
-            // TODO: add probes for re-growth
-            const size_t next_size = 1_KiB /*slack*/
-                                     + ((estimated_output_size * 3) + 1) / 2;
-            vlog(
-              complog.trace,
-              "Consumed bytes:{} has reached preallocated size. Growing to "
-              "size:{}",
-              consumed_bytes,
-              next_size);
-            ss::temporary_buffer<char> tmpo(next_size);
-            std::copy_n(obuf.get(), consumed_bytes, tmpo.get_write());
-            obuf = std::move(tmpo);
-            // update the pointer back to the original position
-            out = obuf.get_write();
-            estimated_output_size = next_size;
-        }
     }
 
     if (unlikely(bytes_remaining < src_size)) {
@@ -200,16 +233,7 @@ static iobuf do_uncompressed(const char* src, const size_t src_size) {
 }
 
 iobuf lz4_frame_compressor::uncompress(const iobuf& b) {
-    if (std::distance(b.begin(), b.end()) == 1) {
-        return do_uncompressed(b.begin()->get(), b.size_bytes());
-    }
-    // linearize buffer
-    // TODO: optimize iobuf
-    auto linearized = iobuf_to_bytes(b);
-    return do_uncompressed(
-      // NOLINTNEXTLINE
-      reinterpret_cast<const char*>(linearized.data()),
-      linearized.size());
+    return do_uncompressed(b);
 }
 
 } // namespace compression::internal
@@ -14,7 +14,11 @@
 namespace compression::internal {
 
 struct lz4_frame_compressor {
-    static iobuf compress(const iobuf&);
+    // default level, negative levels trade ratio for speed
+    static constexpr int default_level = 1;
+
+    static iobuf compress(const iobuf& b) { return compress(b, default_level); }
+    static iobuf compress(const iobuf&, int level);
     static iobuf uncompress(const iobuf&);
 };
 
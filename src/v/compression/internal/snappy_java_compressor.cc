@@ -9,14 +9,16 @@
 
 #include "compression/internal/snappy_java_compressor.h"
 
-#include "bytes/bytes.h"
 #include "bytes/details/io_iterator_consumer.h"
 #include "bytes/iobuf.h"
 #include "compression/logger.h"
 #include "compression/snappy_standard_compressor.h"
 #include "likely.h"
+#include "units.h"
 #include "vlog.h"
 
+#include <seastar/core/temporary_buffer.hh>
+
 #include <fmt/format.h>
 
 #include <cstring>
@@ -33,6 +35,22 @@ struct snappy_magic {
                                                + sizeof(min_compatible_version);
 };
 
+// larger staging buffers are not kept around
+static constexpr size_t max_scratch_size = 256_KiB;
+
+/// (de)compression is synchronous, the staging buffer of a chunk is kept per
+/// shard and grows to the largest chunk seen, up to max_scratch_size
+static ss::temporary_buffer<char> shard_scratch(size_t size) {
+    static thread_local ss::temporary_buffer<char> buf;
+    if (unlikely(size > max_scratch_size)) {
+        return ss::temporary_buffer<char>(size);
+    }
+    if (buf.size() < size) {
+        buf = ss::temporary_buffer<char>(size);
+    }
+    return buf.share();
+}
+
 size_t find_max_size_in_frags(const iobuf& x) {
     size_t ret = 0;
     for (const auto& f : x) {
@@ -62,7 +80,7 @@ iobuf snappy_java_compressor::compress(const iobuf& x) {
     append_le(ret, snappy_magic::default_version);
     append_le(ret, snappy_magic::min_compatible_version);
     // staging buffer
-    ss::temporary_buffer<char> obuf(find_max_size_in_frags(x));
+    auto obuf = shard_scratch(find_max_size_in_frags(x));
     for (const auto& f : x) {
         // do compression
         size_t omax = obuf.size();
@@ -73,6 +91,25 @@ iobuf snappy_java_compressor::compress(const iobuf& x) {
     }
     return ret;
 }
+static void
+uncompress_chunk(iobuf& out, const char* chunk, size_t size, const iobuf& x) {
+    size_t output_size = 0;
+    if (unlikely(!::snappy::GetUncompressedLength(chunk, size, &output_size))) {
+        throw std::runtime_error(fmt::format(
+          "Could not find uncompressed size from input buffer of size: {}",
+          size));
+    }
+    auto ph = out.reserve(output_size);
+    char* output = ph.mutable_index();
+    if (!::snappy::RawUncompress(chunk, size, output)) {
+        throw std::runtime_error(fmt_with_ctx(
+          fmt::format,
+          "snappy: Could not decompress frame: {}, from:{}",
+          size,
+          x));
+    }
+}
+
 iobuf snappy_java_compressor::uncompress(const iobuf& x) {
     auto iter = details::io_iterator_consumer(x.cbegin(), x.cend());
     if (unlikely(x.size_bytes() < snappy_magic::header_len)) {
@@ -98,32 +135,26 @@ iobuf snappy_java_compressor::uncompress(const iobuf& x) {
     iobuf ret;
     const size_t input_bytes = x.size_bytes();
     while (iter.bytes_consumed() != input_bytes) {
-        auto compressed_length = iter.consume_be_type<int32_t>();
-        auto chunk = ss::uninitialized_string<bytes>(compressed_length);
-        iter.consume_to(chunk.size(), chunk.data());
-        size_t output_size = 0;
-        if (unlikely(!::snappy::GetUncompressedLength(
-              // NOLINTNEXTLINE
-              reinterpret_cast<const char*>(chunk.data()),
-              chunk.size(),
-              &output_size))) {
+        const auto compressed_length = static_cast<size_t>(
+          iter.consume_be_type<int32_t>());
+        if (unlikely(compressed_length > input_bytes - iter.bytes_consumed())) {
             throw std::runtime_error(fmt::format(
-              "Could not find uncompressed size from input buffer of size: {}",
-              chunk.size()));
-        }
-        auto ph = ret.reserve(output_size);
-        char* output = ph.mutable_index();
-        if (!::snappy::RawUncompress(
-              // NOLINTNEXTLINE
-              reinterpret_cast<const char*>(chunk.data()),
-              chunk.size(),
-              output)) {
-            throw std::runtime_error(fmt_with_ctx(
-              fmt::format,
-              "snappy: Could not decompress frame: {}, from:{}",
-              chunk.size(),
+              "snappy: chunk of {} bytes past the end of the input: {}",
+              compressed_length,
               x));
         }
+        // a chunk within a fragment is read in place, others are copied
+        if (iter.segment_bytes_left() >= compressed_length) {
+            iter.consume(
+              compressed_length, [&ret, &x](const char* src, size_t n) {
+                  uncompress_chunk(ret, src, n, x);
+                  return ss::stop_iteration::no;
+              });
+        } else {
+            auto chunk = shard_scratch(compressed_length);
+            iter.consume_to(compressed_length, chunk.get_write());
+            uncompress_chunk(ret, chunk.get(), compressed_length, x);
+        }
     }
     return ret;
 }
@@ -0,0 +1,22 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+namespace compression::internal {
+
+/// gzip through zlib's streaming API. It handles any gzip stream, e.g. of
+/// several members, and backs up gzip_compressor
+struct zlib_gzip_compressor {
+    static iobuf compress(const iobuf&);
+    static iobuf uncompress(const iobuf&);
+};
+} // namespace compression::internal
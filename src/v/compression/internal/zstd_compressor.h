@@ -15,13 +15,23 @@
 namespace compression::internal {
 
 struct zstd_compressor {
-    static iobuf compress(const iobuf& b) {
-        stream_zstd fn;
-        return fn.compress(b);
+    static iobuf compress(const iobuf& b) { return shard_stream().compress(b); }
+    static iobuf compress(const iobuf& b, const zstd_dictionary& d) {
+        return shard_stream().compress(b, d);
+    }
+    static iobuf compress(const iobuf& b, int level) {
+        return shard_stream().compress(b, level);
     }
     static iobuf uncompress(const iobuf& b) {
-        stream_zstd fn;
-        return fn.uncompress(b);
+        return shard_stream().uncompress(b);
+    }
+
+private:
+    // (de)compression is synchronous, so one set of zstd contexts per shard
+    // serves every call without reallocating them
+    static stream_zstd& shard_stream() {
+        static thread_local stream_zstd fn;
+        return fn;
     }
 };
 
@@ -29,8 +29,8 @@ inline iobuf do_compress(const char* src, size_t src_size) {
 }
 
 iobuf snappy_standard_compressor::compress(const iobuf& b) {
-    if (std::distance(b.begin(), b.end()) == 1) {
-        return do_compress(b.begin()->get(), b.size_bytes());
+    if (auto view = b.contiguous_view()) {
+        return do_compress(view->data(), view->size());
     }
     // TODO: use snappy::Source interface instead
     auto linearized = iobuf_to_bytes(b);
@@ -65,8 +65,8 @@ iobuf do_uncompressed(const char* src, size_t src_size) {
 }
 
 iobuf snappy_standard_compressor::uncompress(const iobuf& b) {
-    if (std::distance(b.begin(), b.end()) == 1) {
-        return do_uncompressed(b.begin()->get(), b.size_bytes());
+    if (auto view = b.contiguous_view()) {
+        return do_uncompressed(view->data(), view->size());
     }
     // linearize buffer
     // TODO: use snappy::Sink interface instead
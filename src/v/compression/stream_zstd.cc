@@ -12,6 +12,7 @@
 #include "bytes/bytes.h"
 #include "bytes/details/io_allocation_size.h"
 #include "compression/logger.h"
+#include "compression/zstd_dictionary.h"
 #include "likely.h"
 #include "units.h"
 #include "vlog.h"
@@ -60,9 +61,17 @@ stream_zstd::zstd_decompress_ctx& stream_zstd::decompressor() {
     return _decompress;
 }
 
-iobuf stream_zstd::do_compress(const iobuf& x) {
-    reset_compressor();
+iobuf stream_zstd::do_compress(
+  const iobuf& x, const zstd_dictionary* d, int level) {
+    // contexts are reused across calls. a session reset keeps the buffers and
+    // tables allocated by the previous call
     ZSTD_CCtx* ctx = compressor().get();
+    throw_if_error(ZSTD_CCtx_reset(ctx, ZSTD_reset_session_only));
+    // parameters are sticky too. a dictionary supersedes the level
+    throw_if_error(
+      ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level));
+    // the dictionary is sticky, a null one returns to plain compression
+    throw_if_error(ZSTD_CCtx_refCDict(ctx, d ? d->cdict() : nullptr));
     // NOTE: always enable content size. **decompression** depends on this
     throw_if_error(ZSTD_CCtx_setPledgedSrcSize(ctx, x.size_bytes()));
     // zstd requires linearized memory
@@ -83,12 +92,33 @@ iobuf stream_zstd::do_compress(const iobuf& x) {
     return ret;
 }
 
-size_t find_zstd_size(const iobuf& x) {
+using frame_header = std::array<char, ZSTD_FRAMEHEADERSIZE_MAX>;
+
+static frame_header read_frame_header(const iobuf& x) {
     auto consumer = iobuf::iterator_consumer(x.cbegin(), x.cend());
     // defined in zstd.h ONLY under static allocation - sigh
     // our v::compression defines that public define
-    std::array<char, ZSTD_FRAMEHEADERSIZE_MAX> sz_arr{};
-    consumer.consume_to(std::min(sz_arr.size(), x.size_bytes()), sz_arr.data());
+    frame_header hdr{};
+    consumer.consume_to(std::min(hdr.size(), x.size_bytes()), hdr.data());
+    return hdr;
+}
+
+static const ZSTD_DDict* find_zstd_dictionary(const iobuf& x) {
+    const auto hdr = read_frame_header(x);
+    const auto id = ZSTD_getDictID_fromFrame(
+      hdr.data(), std::min(hdr.size(), x.size_bytes()));
+    if (id == 0) {
+        return nullptr;
+    }
+    if (auto d = zstd_dictionaries().find(id); d) {
+        return d->ddict();
+    }
+    throw std::runtime_error(fmt::format(
+      "Cannot decompress. Unknown zstd dictionary id:{}", id));
+}
+
+size_t find_zstd_size(const iobuf& x) {
+    const auto sz_arr = read_frame_header(x);
     auto zstd_size = ZSTD_getFrameContentSize(
       static_cast<const void*>(sz_arr.data()), x.size_bytes());
     if (zstd_size == ZSTD_CONTENTSIZE_ERROR) {
@@ -133,27 +163,42 @@ iobuf stream_zstd::do_uncompress(const iobuf& x) {
         throw std::runtime_error(
           "Asked to stream_zstd::uncompress empty buffer");
     }
-    reset_decompressor();
     ZSTD_DCtx* dctx = decompressor().get();
+    throw_if_error(ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only));
+    throw_if_error(ZSTD_DCtx_refDDict(dctx, find_zstd_dictionary(x)));
     iobuf ret;
-    ss::temporary_buffer<char> obuf(decompression_step(x));
+    const size_t step = decompression_step(x);
+    ss::temporary_buffer<char> obuf(step);
     ZSTD_outBuffer out = {
       .dst = obuf.get_write(), .size = obuf.size(), .pos = 0};
+    // full fragments are handed over to the result instead of being copied
+    auto next_fragment = [&ret, &obuf, &out, step] {
+        ret.append(std::move(obuf));
+        obuf = ss::temporary_buffer<char>(step);
+        out = {.dst = obuf.get_write(), .size = obuf.size(), .pos = 0};
+    };
+    size_t rc = 0;
     for (auto& ibuf : x) {
         ZSTD_inBuffer in = {.src = ibuf.get(), .size = ibuf.size(), .pos = 0};
         while (in.pos != in.size) {
-            auto err = ZSTD_decompressStream(dctx, &out, &in);
-            if (in.pos != in.size && out.pos == out.size) {
-                ret.append(obuf.get(), obuf.size());
-                out.size = obuf.size();
-                out.pos = 0;
-            } else {
-                throw_if_error(err);
+            if (out.pos == out.size) {
+                next_fragment();
             }
+            rc = ZSTD_decompressStream(dctx, &out, &in);
+            throw_if_error(rc);
         }
     }
+    // the decoder may still hold output once all of the input is consumed
+    while (rc != 0 && out.pos == out.size) {
+        next_fragment();
+        ZSTD_inBuffer in = {.src = nullptr, .size = 0, .pos = 0};
+        rc = ZSTD_decompressStream(dctx, &out, &in);
+        throw_if_error(rc);
+    }
     obuf.trim(out.pos);
-    ret.append(std::move(obuf));
+    if (!obuf.empty()) {
+        ret.append(std::move(obuf));
+    }
     return ret;
 }
 
@@ -17,6 +17,10 @@
 #include <zstd.h>
 
 namespace compression {
+class zstd_dictionary;
+
+/// Frames compressed with a dictionary are decompressed with the dictionary
+/// of the same id registered on the shard (see zstd_dictionaries()).
 class stream_zstd {
 public:
     using zstd_compress_ctx = std::unique_ptr<
@@ -29,12 +33,21 @@ public:
       static_sized_deleter_fn<ZSTD_DCtx, &ZSTD_freeDCtx>>;
 
     iobuf compress(const iobuf& b) { return do_compress(b); }
+    iobuf compress(const iobuf& b, const zstd_dictionary& d) {
+        return do_compress(b, &d);
+    }
+    iobuf compress(const iobuf& b, int level) {
+        return do_compress(b, nullptr, level);
+    }
     iobuf uncompress(const iobuf& b) { return do_uncompress(b); }
     iobuf compress(iobuf&& b) { return do_compress(b); }
     iobuf uncompress(iobuf&& b) { return do_uncompress(b); }
 
 private:
-    iobuf do_compress(const iobuf&);
+    iobuf do_compress(
+      const iobuf&,
+      const zstd_dictionary* = nullptr,
+      int level = ZSTD_CLEVEL_DEFAULT);
     iobuf do_uncompress(const iobuf&);
 
     void reset_compressor();
@@ -0,0 +1,64 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "compression/internal/gzip_compressor.h"
+#include "compression/internal/zlib_gzip_compressor.h"
+#include "random/generators.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+/// compressible input, a random text repeated, as in zstd_stream_bench
+static inline iobuf gen(const size_t data_size) {
+    const auto data = random_generators::gen_alphanum_string(512);
+    iobuf ret;
+    size_t i = data_size;
+    while (i > 0) {
+        const auto step = std::min<size_t>(i, data.size());
+        ret.append(data.data(), step);
+        i -= step;
+    }
+    return ret;
+}
+
+template<typename Fn>
+inline void compress_test(size_t data_size) {
+    auto o = gen(data_size);
+    perf_tests::start_measuring_time();
+    perf_tests::do_not_optimize(Fn::compress(o));
+    perf_tests::stop_measuring_time();
+}
+
+template<typename Fn>
+inline void uncompress_test(size_t data_size) {
+    // legacy clients produce the gzip of zlib
+    auto o = compression::internal::zlib_gzip_compressor::compress(
+      gen(data_size));
+    perf_tests::start_measuring_time();
+    perf_tests::do_not_optimize(Fn::uncompress(o));
+    perf_tests::stop_measuring_time();
+}
+
+using zlib = compression::internal::zlib_gzip_compressor;
+using libdeflate = compression::internal::gzip_compressor;
+
+PERF_TEST(gzip_zlib_16kb, compress) { compress_test<zlib>(16 << 10); }
+PERF_TEST(gzip_zlib_16kb, uncompress) { uncompress_test<zlib>(16 << 10); }
+PERF_TEST(gzip_zlib_1mb, compress) { compress_test<zlib>(1 << 20); }
+PERF_TEST(gzip_zlib_1mb, uncompress) { uncompress_test<zlib>(1 << 20); }
+
+PERF_TEST(gzip_libdeflate_16kb, compress) {
+    compress_test<libdeflate>(16 << 10);
+}
+PERF_TEST(gzip_libdeflate_16kb, uncompress) {
+    uncompress_test<libdeflate>(16 << 10);
+}
+PERF_TEST(gzip_libdeflate_1mb, compress) { compress_test<libdeflate>(1 << 20); }
+PERF_TEST(gzip_libdeflate_1mb, uncompress) {
+    uncompress_test<libdeflate>(1 << 20);
+}
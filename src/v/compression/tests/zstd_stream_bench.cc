@@ -11,10 +11,16 @@
 #include "random/generators.h"
 #include "vassert.h"
 
+#include <seastar/core/memory.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/testing/perf_tests.hh>
 
+#include <fmt/format.h>
+
+#include <map>
+#include <string>
+
 static inline iobuf gen(const size_t data_size) {
     const auto data = random_generators::gen_alphanum_string(512);
     iobuf ret;
@@ -32,20 +38,59 @@ static inline iobuf gen(const size_t data_size) {
     return ret;
 }
 
+/// allocations per MB of input of the measured section of each test,
+/// reported at exit since perf_tests has no custom counters
+class allocation_tracker {
+public:
+    ~allocation_tracker() {
+        for (auto& [name, s] : _samples) {
+            fmt::print(
+              "{}: {:.1f} allocations/MB\n",
+              name,
+              static_cast<double>(s.allocs) / (s.bytes / double(1 << 20)));
+        }
+    }
+
+    template<typename Func>
+    auto measure(const std::string& name, size_t bytes, Func&& f) {
+        const auto before = ss::memory::stats().mallocs();
+        perf_tests::start_measuring_time();
+        auto ret = f();
+        perf_tests::stop_measuring_time();
+        auto& s = _samples[name];
+        s.allocs += ss::memory::stats().mallocs() - before;
+        s.bytes += bytes;
+        return ret;
+    }
+
+private:
+    struct sample {
+        uint64_t allocs{0};
+        uint64_t bytes{0};
+    };
+    std::map<std::string, sample> _samples;
+};
+
+static allocation_tracker tracker;
+
 inline void compress_test(size_t data_size) {
     auto o = gen(data_size);
-    compression::stream_zstd fn;
-    perf_tests::start_measuring_time();
-    perf_tests::do_not_optimize(fn.compress(std::move(o)));
-    perf_tests::stop_measuring_time();
+    // contexts are reused across runs as they are by the shard compressor
+    static thread_local compression::stream_zstd fn;
+    perf_tests::do_not_optimize(
+      tracker.measure(fmt::format("compress_{}", data_size), data_size, [&] {
+          return fn.compress(std::move(o));
+      }));
 }
 
 inline void uncompress_test(size_t data_size) {
-    compression::stream_zstd fn;
+    // contexts are reused across runs as they are by the shard compressor
+    static thread_local compression::stream_zstd fn;
     auto o = fn.compress(gen(data_size));
-    perf_tests::start_measuring_time();
-    perf_tests::do_not_optimize(fn.uncompress(std::move(o)));
-    perf_tests::stop_measuring_time();
+    perf_tests::do_not_optimize(
+      tracker.measure(fmt::format("uncompress_{}", data_size), data_size, [&] {
+          return fn.uncompress(std::move(o));
+      }));
 }
 
 PERF_TEST(streaming_zstd_1mb, compress) { compress_test(1 << 20); }
@@ -7,12 +7,15 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "bytes/bytes.h"
 #include "compression/internal/gzip_compressor.h"
 #include "compression/internal/lz4_frame_compressor.h"
 #include "compression/internal/snappy_java_compressor.h"
+#include "compression/internal/zlib_gzip_compressor.h"
 #include "compression/internal/zstd_compressor.h"
 #include "compression/snappy_standard_compressor.h"
 #include "compression/stream_zstd.h"
+#include "compression/zstd_dictionary.h"
 #include "random/generators.h"
 #include "units.h"
 #include "vassert.h"
@@ -65,6 +68,72 @@ SEASTAR_THREAD_TEST_CASE(stream_zstd_test) {
     }
 }
 
+SEASTAR_THREAD_TEST_CASE(stream_zstd_reuses_context_multi_fragment) {
+    // a reused stream must produce the same results for outputs that span
+    // several output fragments
+    compression::stream_zstd fn;
+    for (size_t i : {64_KiB, 64_KiB + 1, 1_MiB + 3}) {
+        iobuf buf = gen(i);
+        auto cbuf = fn.compress(buf.share(0, i));
+        auto dbuf = fn.uncompress(std::move(cbuf));
+        BOOST_CHECK_EQUAL(dbuf, buf);
+    }
+}
+
+static std::vector<iobuf> internal_topic_samples(size_t n) {
+    std::vector<iobuf> samples;
+    for (size_t i = 0; i < n; ++i) {
+        auto s = fmt::format(
+          R"({{"group":"consumer-{}","topic":"orders","partition":{},)"
+          R"("offset":{}}})",
+          i % 37,
+          i % 12,
+          i * 1013);
+        iobuf b;
+        b.append(s.data(), s.size());
+        samples.push_back(std::move(b));
+    }
+    return samples;
+}
+
+SEASTAR_THREAD_TEST_CASE(zstd_dictionary_roundtrip) {
+    auto samples = internal_topic_samples(2000);
+    auto d = ss::make_lw_shared<const compression::zstd_dictionary>(
+      compression::zstd_dictionary::train(samples));
+    BOOST_REQUIRE_NE(d->id(), 0);
+    compression::zstd_dictionaries().add("test_group_metadata", d);
+
+    using compression::compressor;
+    const auto& payload = samples.back();
+    auto plain = compressor::compress(payload, compression::type::zstd);
+    auto trained = compressor::compress(
+      payload, compression::type::zstd, "test_group_metadata");
+    BOOST_CHECK_LT(trained.size_bytes(), plain.size_bytes());
+
+    // the frame identifies its dictionary
+    BOOST_CHECK_EQUAL(
+      compressor::uncompress(trained, compression::type::zstd), payload);
+    BOOST_CHECK_EQUAL(
+      compressor::uncompress(plain, compression::type::zstd), payload);
+
+    // a dictionary restored from its content decodes the same frames
+    compression::zstd_dictionary restored(d->content());
+    BOOST_CHECK_EQUAL(restored.id(), d->id());
+}
+
+SEASTAR_THREAD_TEST_CASE(zstd_dictionary_must_be_registered) {
+    auto d = compression::zstd_dictionary::train(
+      internal_topic_samples(1000), 4_KiB);
+    compression::stream_zstd fn;
+    auto samples = internal_topic_samples(1);
+    auto c = fn.compress(samples.front(), d);
+    BOOST_CHECK_THROW(fn.uncompress(std::move(c)), std::runtime_error);
+    BOOST_CHECK_THROW(
+      compression::compressor::compress(
+        samples.front(), compression::type::zstd, "no_such_dictionary"),
+      std::runtime_error);
+}
+
 SEASTAR_THREAD_TEST_CASE(lz4_block_tests) {
     using fn = compression::internal::lz4_frame_compressor;
     roundtrip_compression(fn::compress, fn::uncompress);
@@ -73,6 +142,41 @@ SEASTAR_THREAD_TEST_CASE(snapy_java_test) {
     using fn = compression::internal::snappy_java_compressor;
     roundtrip_compression(fn::compress, fn::uncompress);
 }
+/// the same bytes, in fragments of `step` bytes
+static iobuf fragmented(const iobuf& b, size_t step) {
+    iobuf ret;
+    auto in = iobuf::iterator_consumer(b.cbegin(), b.cend());
+    size_t left = b.size_bytes();
+    while (left > 0) {
+        const auto n = std::min(left, step);
+        ss::temporary_buffer<char> buf(n);
+        in.consume_to(n, buf.get_write());
+        // appending would pack the small buffers back together
+        ret.append_take_ownership(
+          new iobuf::fragment(std::move(buf), iobuf::fragment::full{}));
+        left -= n;
+    }
+    return ret;
+}
+
+SEASTAR_THREAD_TEST_CASE(lz4_snappy_java_fragmented_test) {
+    using lz4 = compression::internal::lz4_frame_compressor;
+    using snappy = compression::internal::snappy_java_compressor;
+    for (size_t step : {1, 7, 4_KiB}) {
+        roundtrip_compression(
+          [step](const iobuf& b) { return lz4::compress(fragmented(b, step)); },
+          [step](const iobuf& b) {
+              return lz4::uncompress(fragmented(b, step));
+          });
+        roundtrip_compression(
+          [step](const iobuf& b) {
+              return snappy::compress(fragmented(b, step));
+          },
+          [step](const iobuf& b) {
+              return snappy::uncompress(fragmented(b, step));
+          });
+    }
+}
 SEASTAR_THREAD_TEST_CASE(snapy_std_test) {
     using fn = compression::snappy_standard_compressor;
     roundtrip_compression(fn::compress, fn::uncompress);
@@ -85,3 +189,35 @@ SEASTAR_THREAD_TEST_CASE(gzip_test) {
     using fn = compression::internal::gzip_compressor;
     roundtrip_compression(fn::compress, fn::uncompress);
 }
+
+SEASTAR_THREAD_TEST_CASE(zlib_gzip_test) {
+    using fn = compression::internal::zlib_gzip_compressor;
+    roundtrip_compression(fn::compress, fn::uncompress);
+}
+
+SEASTAR_THREAD_TEST_CASE(gzip_interoperates_with_zlib) {
+    using fn = compression::internal::gzip_compressor;
+    using zlib = compression::internal::zlib_gzip_compressor;
+    roundtrip_compression(fn::compress, zlib::uncompress);
+    roundtrip_compression(zlib::compress, fn::uncompress);
+}
+
+SEASTAR_THREAD_TEST_CASE(gzip_uncompress_multi_member) {
+    using fn = compression::internal::gzip_compressor;
+    // concatenated members make a valid gzip stream
+    auto a = gen(6_KiB);
+    auto b = gen(10_KiB);
+    auto c = fn::compress(a);
+    c.append(fn::compress(b));
+    a.append(std::move(b));
+    BOOST_CHECK_EQUAL(fn::uncompress(c), a);
+}
+
+SEASTAR_THREAD_TEST_CASE(gzip_uncompress_corrupt) {
+    using fn = compression::internal::gzip_compressor;
+    auto c = iobuf_to_bytes(fn::compress(gen(10_KiB)));
+    c[c.size() / 2] ^= 0xff;
+    iobuf corrupt;
+    corrupt.append(c.data(), c.size());
+    BOOST_CHECK_THROW(fn::uncompress(corrupt), std::runtime_error);
+}
@@ -0,0 +1,100 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "compression/zstd_dictionary.h"
+
+#include "vassert.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <zdict.h>
+
+namespace compression {
+
+zstd_dictionary
+zstd_dictionary::train(const std::vector<iobuf>& samples, size_t max_size) {
+    // zdict trains from one buffer holding every sample back to back
+    size_t total = 0;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& s : samples) {
+        sizes.push_back(s.size_bytes());
+        total += s.size_bytes();
+    }
+    bytes buffer(bytes::initialized_later{}, total);
+    size_t pos = 0;
+    for (const auto& s : samples) {
+        for (const auto& f : s) {
+            std::copy_n(f.get(), f.size(), buffer.begin() + pos);
+            pos += f.size();
+        }
+    }
+
+    bytes dict(bytes::initialized_later{}, max_size);
+    const auto rc = ZDICT_trainFromBuffer(
+      dict.data(), dict.size(), buffer.data(), sizes.data(), sizes.size());
+    if (ZDICT_isError(rc)) {
+        throw std::runtime_error(fmt::format(
+          "Cannot train zstd dictionary from {} samples: {}",
+          samples.size(),
+          ZDICT_getErrorName(rc)));
+    }
+    dict.resize(rc);
+    return zstd_dictionary(std::move(dict));
+}
+
+zstd_dictionary::zstd_dictionary(bytes content)
+  : _content(std::move(content))
+  , _id(ZSTD_getDictID_fromDict(_content.data(), _content.size()))
+  , _cdict(ZSTD_createCDict(
+      _content.data(), _content.size(), ZSTD_CLEVEL_DEFAULT))
+  , _ddict(ZSTD_createDDict(_content.data(), _content.size())) {
+    // raw content dictionaries have no id and could not be found again
+    if (_id == 0) {
+        throw std::runtime_error(
+          "Not a zstd dictionary: missing dictionary id");
+    }
+    if (!_cdict || !_ddict) {
+        throw std::bad_alloc{};
+    }
+}
+
+void zstd_dictionary_registry::add(const ss::sstring& name, dictionary_ptr d) {
+    vassert(d, "cannot register a null dictionary as {}", name);
+    _by_id[d->id()] = d;
+    _by_name[name] = std::move(d);
+}
+
+void zstd_dictionary_registry::remove(const ss::sstring& name) {
+    _by_name.erase(name);
+}
+
+zstd_dictionary_registry::dictionary_ptr
+zstd_dictionary_registry::find(const ss::sstring& name) const {
+    if (auto it = _by_name.find(name); it != _by_name.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+zstd_dictionary_registry::dictionary_ptr
+zstd_dictionary_registry::find(uint32_t id) const {
+    if (auto it = _by_id.find(id); it != _by_id.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+zstd_dictionary_registry& zstd_dictionaries() {
+    static thread_local zstd_dictionary_registry registry;
+    return registry;
+}
+
+} // namespace compression
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "seastarx.h"
+#include "static_deleter_fn.h"
+#include "units.h"
+
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sstring.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <zstd.h>
+
+namespace compression {
+
+/// A zstd dictionary trained from samples of small, repetitive payloads such
+/// as those of internal topics. Every frame compressed with a dictionary
+/// carries its id, which is how decompression finds it again.
+class zstd_dictionary {
+public:
+    static constexpr size_t default_max_size = 16_KiB;
+
+    using cdict_ptr = std::unique_ptr<
+      ZSTD_CDict,
+      static_sized_deleter_fn<ZSTD_CDict, &ZSTD_freeCDict>>;
+    using ddict_ptr = std::unique_ptr<
+      ZSTD_DDict,
+      static_sized_deleter_fn<ZSTD_DDict, &ZSTD_freeDDict>>;
+
+    /// trains a dictionary of at most `max_size` bytes. throws if the samples
+    /// are too few or too small to train from
+    static zstd_dictionary train(
+      const std::vector<iobuf>& samples, size_t max_size = default_max_size);
+
+    /// loads a dictionary from its content, e.g. as returned by content() of
+    /// a trained dictionary. throws if the content is not a zstd dictionary
+    explicit zstd_dictionary(bytes content);
+
+    uint32_t id() const { return _id; }
+    const bytes& content() const { return _content; }
+    const ZSTD_CDict* cdict() const { return _cdict.get(); }
+    const ZSTD_DDict* ddict() const { return _ddict.get(); }
+
+private:
+    bytes _content;
+    uint32_t _id;
+    cdict_ptr _cdict;
+    ddict_ptr _ddict;
+};
+
+/// Dictionaries known to a shard, by name for compression and by id for
+/// decompression. A dictionary stays available by id after its name is
+/// replaced or removed since data compressed with it may still be read.
+class zstd_dictionary_registry {
+public:
+    using dictionary_ptr = ss::lw_shared_ptr<const zstd_dictionary>;
+
+    void add(const ss::sstring& name, dictionary_ptr);
+    void remove(const ss::sstring& name);
+
+    dictionary_ptr find(const ss::sstring& name) const;
+    dictionary_ptr find(uint32_t id) const;
+
+private:
+    absl::flat_hash_map<ss::sstring, dictionary_ptr> _by_name;
+    absl::flat_hash_map<uint32_t, dictionary_ptr> _by_id;
+};
+
+zstd_dictionary_registry& zstd_dictionaries();
+
+} // namespace compression
@@ -20,6 +20,14 @@ configuration::configuration()
     "data_directory",
     "Place where redpanda will keep the data",
     required::yes)
+  , extra_data_directories(
+      *this,
+      "extra_data_directories",
+      "Data directories on other disks, new partitions are spread across "
+      "them and data_directory by free space. The controller log and the "
+      "kvstore stay in data_directory",
+      required::no,
+      {})
   , developer_mode(
       *this,
       "developer_mode",
@@ -40,6 +48,20 @@ configuration::configuration()
       "256MiB)",
       required::no,
       256_MiB)
+  , log_index_interval_bytes(
+      *this,
+      "log_index_interval_bytes",
+      "Bytes of batches between the offset index entries of a segment, "
+      "topics override it with index.interval.bytes",
+      required::no,
+      32_KiB)
+  , log_index_adaptive(
+      *this,
+      "log_index_adaptive",
+      "Pick the index interval of the segments of topics without "
+      "index.interval.bytes from their batch sizes",
+      required::no,
+      false)
   , rpc_server(
       *this,
       "rpc_server",
@@ -67,6 +89,28 @@ configuration::configuration()
       "IpAddress and port for supervisor service",
       required::no,
       unresolved_address("127.0.0.1", 43189))
+  , coproc_shared_memory_ring_bytes(
+      *this,
+      "coproc_shared_memory_ring_bytes",
+      "Size of each of the shared memory rings exchanging batches with the "
+      "coprocessor engine, 0 sends them over RPC only",
+      required::no,
+      0)
+  , coproc_max_inflight_requests_per_partition(
+      *this,
+      "coproc_max_inflight_requests_per_partition",
+      "Requests to the coprocessor engine carrying data of a source partition "
+      "whose results may be in flight at the same time",
+      required::no,
+      2)
+  , coproc_offset_checkpoint_interval_ms(
+      *this,
+      "coproc_offset_checkpoint_interval_ms",
+      "Interval of the checkpoints of the offsets routed through the "
+      "coprocessors of a shard, a restart routes again up to this much of "
+      "their input",
+      required::no,
+      1s)
   , node_id(
       *this,
       "node_id",
@@ -139,13 +183,14 @@ configuration::configuration()
   , default_num_windows(
       *this,
       "default_num_windows",
-      "Default number of quota tracking windows",
+      "Unused, quotas are token buckets refilled over default_window_sec",
       required::no,
       10)
   , default_window_sec(
       *this,
       "default_window_sec",
-      "Default quota tracking window size in milliseconds",
+      "Default quota tracking window size in milliseconds, a client may "
+      "burst a window worth of its quota",
       required::no,
       std::chrono::milliseconds(1000))
   , quota_manager_gc_sec(
@@ -157,9 +202,23 @@ configuration::configuration()
   , target_quota_byte_rate(
       *this,
       "target_quota_byte_rate",
-      "Target quota byte rate (bytes per second) - 64MB default",
+      "Target produce quota byte rate per client (bytes per second) - 64MB "
+      "default",
       required::no,
       64_MiB)
+  , target_fetch_quota_byte_rate(
+      *this,
+      "target_fetch_quota_byte_rate",
+      "Target fetch quota byte rate per client (bytes per second), fetches "
+      "are not throttled if unset",
+      required::no,
+      std::nullopt)
+  , quota_manager_aggregation_ms(
+      *this,
+      "quota_manager_aggregation_ms",
+      "Period of the exchange of quota usage between shards in milliseconds",
+      required::no,
+      std::chrono::milliseconds(250))
   , rack(*this, "rack", "Rack identifier", required::no, std::nullopt)
   , disable_metrics(
       *this,
@@ -167,6 +226,27 @@ configuration::configuration()
       "Disable registering metrics",
       required::no,
       false)
+  , aggregate_partition_metrics(
+      *this,
+      "aggregate_partition_metrics",
+      "Export the metrics of partitions summed per topic, with the metrics of "
+      "each partition only for the busiest partitions of a shard",
+      required::no,
+      true)
+  , partition_metrics_detail_limit(
+      *this,
+      "partition_metrics_detail_limit",
+      "Number of the busiest partitions of a shard exporting their own "
+      "metrics when partition metrics are aggregated",
+      required::no,
+      32)
+  , partition_metrics_rank_interval_ms(
+      *this,
+      "partition_metrics_rank_interval_ms",
+      "Interval over which partitions are ranked by throughput to pick the "
+      "ones exporting their own metrics",
+      required::no,
+      30000ms)
   , group_min_session_timeout_ms(
       *this,
       "group_min_session_timeout_ms",
@@ -197,6 +277,27 @@ configuration::configuration()
       "Timeout for new member joins",
       required::no,
       30'000ms)
+  , group_offset_commit_batch_window_ms(
+      *this,
+      "group_offset_commit_batch_window_ms",
+      "Time offset commits wait to be replicated in a batch with the commits "
+      "of other groups of the same coordinator partition",
+      required::no,
+      2ms)
+  , group_snapshot_interval_ms(
+      *this,
+      "group_snapshot_interval_ms",
+      "Interval between snapshots of the group metadata partitions, recovery "
+      "of a partition replays the log following its latest snapshot",
+      required::no,
+      300'000ms)
+  , group_lag_metrics_interval_ms(
+      *this,
+      "group_lag_metrics_interval_ms",
+      "Interval between updates of the consumer lag metrics of the groups "
+      "coordinated by the broker",
+      required::no,
+      10'000ms)
   , metadata_dissemination_interval_ms(
       *this,
       "metadata_dissemination_interval_ms",
@@ -215,12 +316,98 @@ configuration::configuration()
       "How often do we trigger background compaction",
       required::no,
       5min)
+  , compaction_max_bytes_per_sec(
+      *this,
+      "compaction_max_bytes_per_sec",
+      "Per shard ceiling on the bytes compaction reads and rewrites per "
+      "second. 0 disables the limit",
+      required::no,
+      100_MiB)
+  , compaction_backpressure_latency_ms(
+      *this,
+      "compaction_backpressure_latency_ms",
+      "Compaction slows down while the p99 of foreground log flushes is "
+      "above this latency. 0 disables the backpressure",
+      required::no,
+      100ms)
+  , log_deletion_max_bytes_per_sec(
+      *this,
+      "log_deletion_max_bytes_per_sec",
+      "Per shard ceiling on the bytes of removed logs freed on disk per "
+      "second. 0 disables the limit",
+      required::no,
+      256_MiB)
+  , compaction_round_max_bytes(
+      *this,
+      "compaction_round_max_bytes",
+      "Per shard ceiling on the dirty bytes of the compacted logs visited by "
+      "one housekeeping round, the dirtiest logs go first. 0 disables the "
+      "limit",
+      required::no,
+      1_GiB)
+  , log_segment_pool_files(
+      *this,
+      "log_segment_pool_files",
+      "Data files of segments removed by retention kept per shard and data "
+      "directory, new segments reuse them instead of creating files. 0 "
+      "removes them",
+      required::no,
+      2)
+  , log_segment_prepare_percent(
+      *this,
+      "log_segment_prepare_percent",
+      "Fill of the active segment, in percent of its size, from which the "
+      "files of the next segment are opened in the background. 0 creates "
+      "them when the segment rolls",
+      required::no,
+      80)
+  , log_readers_cache_size(
+      *this,
+      "log_readers_cache_size",
+      "Readers parked per partition between fetches, the next fetch at the "
+      "offset a reader stopped at resumes it. 0 disables the cache",
+      required::no,
+      4)
+  , log_readers_cache_idle_ms(
+      *this,
+      "log_readers_cache_idle_ms",
+      "Parked readers not resumed within this time are closed",
+      required::no,
+      5s)
   , retention_bytes(
       *this,
       "retention_bytes",
       "max bytes per partition on disk before triggering a compaction",
       required::no,
       std::nullopt)
+  , disk_pressure_free_percent(
+      *this,
+      "disk_pressure_free_percent",
+      "Free space of a data directory, in percent of its size, under which "
+      "the oldest segments of all the topics that allow deletion are removed "
+      "regardless of their retention. 0 disables it",
+      required::no,
+      0)
+  , disk_pressure_target_free_percent(
+      *this,
+      "disk_pressure_target_free_percent",
+      "Free space of a data directory, in percent of its size, the removal "
+      "of segments under disk pressure restores",
+      required::no,
+      10)
+  , disk_pressure_check_interval_ms(
+      *this,
+      "disk_pressure_check_interval_ms",
+      "Interval of the free space checks of the data directories",
+      required::no,
+      10s)
+  , ephemeral_log_memory_bytes(
+      *this,
+      "ephemeral_log_memory_bytes",
+      "Memory per shard held by the logs of in-memory topics. The oldest "
+      "batches of a log appending above it are evicted",
+      required::no,
+      256_MiB)
   , group_topic_partitions(
       *this,
       "group_topic_partitions",
@@ -263,6 +450,34 @@ configuration::configuration()
       "Election timeout expressed in milliseconds",
       required::no,
       1'500ms)
+  , raft_adaptive_election_timeout(
+      *this,
+      "raft_adaptive_election_timeout",
+      "Derive the election timeout of followers from the heartbeat round "
+      "trip times to their leader rather than from election_timeout_ms",
+      required::no,
+      false)
+  , raft_election_timeout_floor_ms(
+      *this,
+      "raft_election_timeout_floor_ms",
+      "Lower bound of adaptive election timeouts, leader leases are computed "
+      "from it",
+      required::no,
+      500ms)
+  , raft_election_timeout_ceiling_ms(
+      *this,
+      "raft_election_timeout_ceiling_ms",
+      "Upper bound of adaptive election timeouts",
+      required::no,
+      10'000ms)
+  , raft_leader_lease_clock_drift_ms(
+      *this,
+      "raft_leader_lease_clock_drift_ms",
+      "Part of the election timeout a leader lease is shortened by to bound "
+      "the clock drift between nodes, leases are not used when it is not "
+      "shorter than the election timeout",
+      required::no,
+      300ms)
   , kafka_group_recovery_timeout_ms(
       *this,
       "kafka_group_recovery_timeout_ms",
@@ -282,6 +497,74 @@ configuration::configuration()
       "follower",
       required::no,
       5s)
+  , recovery_snapshot_min_lag_bytes(
+      *this,
+      "recovery_snapshot_min_lag_bytes",
+      "Install the snapshot on a stale follower instead of sending it the log "
+      "when at least this many bytes of the log it misses are covered by the "
+      "snapshot",
+      required::no,
+      256_MiB)
+  , recovery_snapshot_chunks_in_flight(
+      *this,
+      "recovery_snapshot_chunks_in_flight",
+      "Number of snapshot chunks sent to a follower without waiting for their "
+      "replies",
+      required::no,
+      4)
+  , recovery_max_concurrent_per_shard(
+      *this,
+      "recovery_max_concurrent_per_shard",
+      "Number of stale followers a shard updates at the same time, the others "
+      "wait with the ones missing the least data admitted first",
+      required::no,
+      32)
+  , recovery_rate_bytes(
+      *this,
+      "recovery_rate_bytes",
+      "Bytes per second the node sends to stale followers, shared evenly "
+      "between its shards. 0 disables the limit",
+      required::no,
+      0)
+  , raft_replication_window_bytes(
+      *this,
+      "raft_replication_window_bytes",
+      "Bytes of the batches a leader appended last kept in memory per raft "
+      "group to recover followers a little behind without reading the log. "
+      "0 disables the window",
+      required::no,
+      256_KiB)
+  , raft_write_behind_max_bytes(
+      *this,
+      "raft_write_behind_max_bytes",
+      "Bytes of relaxed consistency writes a raft group of a write behind "
+      "topic acknowledges ahead of its log",
+      required::no,
+      1_MiB)
+  , raft_max_inflight_bytes_per_follower(
+      *this,
+      "raft_max_inflight_bytes_per_follower",
+      "Bytes of replicate requests a leader keeps in flight to one follower "
+      "of a raft group. Rounds past it skip the follower, which then catches "
+      "up through recovery rather than slowing down quorum writes",
+      required::no,
+      4_MiB)
+  , raft_batch_append_entries(
+      *this,
+      "raft_batch_append_entries",
+      "Send the append entries requests of the raft groups of a shard to the "
+      "same node in one rpc. Disable while nodes not serving the batched rpc "
+      "are part of the cluster",
+      required::no,
+      true)
+  , raft_leader_cache_warmup_bytes(
+      *this,
+      "raft_leader_cache_warmup_bytes",
+      "Last bytes of the active segment a new leader reads into the batch "
+      "cache at a low io priority, ahead of the fetches following a "
+      "failover. 0 disables the warm up",
+      required::no,
+      1_MiB)
   , reclaim_min_size(
       *this,
       "reclaim_min_size",
@@ -306,18 +589,84 @@ configuration::configuration()
       "Length of time above which growth is reset",
       required::no,
       10'000ms)
+  , reclaim_adaptive_target(
+      *this,
+      "reclaim_adaptive_target",
+      "Keep the batch cache to a size target that follows the free memory "
+      "of the shard, so that it shrinks before reclaims in the allocation "
+      "path are needed",
+      required::no,
+      true)
+  , enable_memory_broker(
+      *this,
+      "enable_memory_broker",
+      "Let the kafka and internal rpc services, the segment appenders and "
+      "the batch cache of a shard borrow the memory the others leave idle, "
+      "instead of fixed shares",
+      required::no,
+      true)
+  , rpc_server_protected_memory(
+      *this,
+      "rpc_server_protected_memory",
+      "Memory per shard reserved for the latency critical requests of the "
+      "internal rpc, e.g. raft heartbeats and votes, so that they are not "
+      "admitted behind bulk traffic. 0 admits them from the shared memory",
+      required::no,
+      2_MiB)
+  , rpc_server_bulk_memory_percent(
+      *this,
+      "rpc_server_bulk_memory_percent",
+      "Share of the internal rpc memory that bulk requests, e.g. raft "
+      "snapshots, may hold at once",
+      required::no,
+      50)
+  , enable_storage_hugepages(
+      *this,
+      "enable_storage_hugepages",
+      "Back the chunk cache and the batch cache with 2MiB pages allocated at "
+      "startup, to reduce TLB misses of large caches",
+      required::no,
+      false)
   , auto_create_topics_enabled(
       *this,
       "auto_create_topics_enabled",
       "Allow topic auto creation",
       required::no,
       false)
+  , enable_idempotence(
+      *this,
+      "enable_idempotence",
+      "Deduplicate the batches of idempotent producers. Every partition then "
+      "tracks the sequences of its producers from the committed batches",
+      required::no,
+      true)
+  , enable_sasl(
+      *this,
+      "enable_sasl",
+      "Require kafka clients to authenticate with SASL SCRAM-SHA-256 or "
+      "SCRAM-SHA-512 before any request other than api versions",
+      required::no,
+      false)
   , enable_pid_file(
       *this,
       "enable_pid_file",
       "Enable pid file. You probably don't want to change this.",
       required::no,
       true)
+  , enable_disk_calibration(
+      *this,
+      "enable_disk_calibration",
+      "Measure the data directory disk at startup when no io properties are "
+      "given and none were stored next to the configuration file, and store "
+      "the results there as an io-properties file for the next start",
+      required::no,
+      false)
+  , disk_calibration_duration_ms(
+      *this,
+      "disk_calibration_duration_ms",
+      "Duration of each of the four runs of the disk calibration",
+      required::no,
+      2000ms)
   , kvstore_flush_interval(
       *this,
       "kvstore_flush_interval",
@@ -356,6 +705,20 @@ configuration::configuration()
       "Timeout waiting for follower recovery when transferring leadership",
       required::no,
       10s)
+  , shutdown_leadership_transfer_concurrency(
+      *this,
+      "shutdown_leadership_transfer_concurrency",
+      "Leadership transfers in flight per core while a stopping node hands "
+      "over the groups it leads",
+      required::no,
+      32)
+  , shutdown_leadership_transfer_timeout_ms(
+      *this,
+      "shutdown_leadership_transfer_timeout_ms",
+      "No leadership transfers are started past this time after a node is "
+      "asked to stop, 0 stops the node without transferring leadership",
+      required::no,
+      30s)
   , release_cache_on_segment_roll(
       *this,
       "release_cache_on_segment_roll",
@@ -368,6 +731,77 @@ configuration::configuration()
       "Maximum delay until buffered data is written",
       required::no,
       std::chrono::milliseconds(1s))
+  , segment_fsync_coalesce_window_us(
+      *this,
+      "segment_fsync_coalesce_window_us",
+      "How long segment flushes on a shard are held back so that their "
+      "fdatasync calls are issued together. 0 only batches flushes issued "
+      "in the same reactor poll",
+      required::no,
+      0)
+  , cold_storage_directory(
+      *this,
+      "cold_storage_directory",
+      "Directory of the storage tier, e.g. a mount of an object store. "
+      "Closed segments older than the local retention are moved there",
+      required::no,
+      std::nullopt)
+  , cold_storage_local_retention_ms(
+      *this,
+      "cold_storage_local_retention_ms",
+      "Age after which closed segments move to the storage tier",
+      required::no,
+      24h)
+  , cold_storage_cache_bytes(
+      *this,
+      "cold_storage_cache_bytes",
+      "Local disk space per shard used to stage the chunks read from the "
+      "storage tier",
+      required::no,
+      1_GiB)
+  , cold_storage_prefetch_chunks(
+      *this,
+      "cold_storage_prefetch_chunks",
+      "Chunks of a cold segment read ahead of a cache miss",
+      required::no,
+      2)
+  , archival_bucket(
+      *this,
+      "archival_bucket",
+      "Bucket of the S3 compatible object store the closed segments are "
+      "uploaded to. Segments are not uploaded when unset",
+      required::no,
+      std::nullopt)
+  , archival_api_endpoint(
+      *this,
+      "archival_api_endpoint",
+      "Address and port of the S3 compatible object store",
+      required::no,
+      unresolved_address("127.0.0.1", 9000))
+  , archival_upload_concurrency(
+      *this,
+      "archival_upload_concurrency",
+      "Segments uploaded at the same time by a shard",
+      required::no,
+      2)
+  , archival_upload_max_bytes_per_sec(
+      *this,
+      "archival_upload_max_bytes_per_sec",
+      "Upload rate limit of a shard, 0 does not limit the uploads",
+      required::no,
+      16_MiB)
+  , archival_upload_interval_ms(
+      *this,
+      "archival_upload_interval_ms",
+      "How often the partitions are checked for segments to upload",
+      required::no,
+      10s)
+  , archival_upload_part_size(
+      *this,
+      "archival_upload_part_size",
+      "Size of the parts of the multipart uploads, at least 5MiB",
+      required::no,
+      8_MiB)
   , fetch_session_eviction_timeout_ms(
       *this,
       "fetch_session_eviction_timeout_ms",
@@ -377,6 +811,166 @@ configuration::configuration()
       "cache",
       required::no,
       60s)
+  , fetch_session_cache_memory_bytes(
+      *this,
+      "fetch_session_cache_memory_bytes",
+      "Memory the incremental fetch sessions of a shard may use. Sessions "
+      "are evicted least recently used first, the larger ones before the "
+      "smaller ones",
+      required::no,
+      10_MiB)
+  , kafka_down_conversion_cache_bytes(
+      *this,
+      "kafka_down_conversion_cache_bytes",
+      "Memory a shard may use to cache record batches converted to the "
+      "legacy message formats for consumers fetching with versions older "
+      "than 4. 0 converts every fetch",
+      required::no,
+      32_MiB)
+  , kafka_max_inflight_requests_per_connection(
+      *this,
+      "kafka_max_inflight_requests_per_connection",
+      "Requests of a kafka connection processed concurrently, the responses "
+      "are sent in request order",
+      required::no,
+      32)
+  , kafka_produce_affinity_requests(
+      *this,
+      "kafka_produce_affinity_requests",
+      "Produce requests in a row of a kafka connection whose partitions all "
+      "live on one other shard before the next ones are served on that shard, "
+      "0 disables",
+      required::no,
+      8)
+  , kafka_follower_fetching_enabled(
+      *this,
+      "kafka_follower_fetching_enabled",
+      "Point consumers which send their rack to a replica in that rack, the "
+      "consumers then fetch from it instead of the leader",
+      required::no,
+      false)
+  , raft_max_inflight_append_requests(
+      *this,
+      "raft_max_inflight_append_requests",
+      "Maximum number of append entries requests in flight to each follower "
+      "of a raft group",
+      required::no,
+      4)
+  , rpc_client_connections_per_peer(
+      *this,
+      "rpc_client_connections_per_peer",
+      "Number of shards owning a connection to each of the peers, requests "
+      "from the other shards are forwarded to the owners. With at least as "
+      "many connections as cores every core uses its own connection",
+      required::no,
+      3)
+  , produce_latency_max_partitions(
+      *this,
+      "produce_latency_max_partitions",
+      "Maximum number of partitions per core exporting histograms of the "
+      "produce latency stages",
+      required::no,
+      16)
+  , cpu_profiler_enabled(
+      *this,
+      "cpu_profiler_enabled",
+      "Sample the stacks of every core, served by the admin api under "
+      "/v1/profiler/cpu",
+      required::no,
+      true)
+  , cpu_profiler_sample_period_ms(
+      *this,
+      "cpu_profiler_sample_period_ms",
+      "Cpu time between two samples of the profiler",
+      required::no,
+      10ms)
+  , scheduling_group_probe_interval_ms(
+      *this,
+      "scheduling_group_probe_interval_ms",
+      "Interval of the run queue delay probes of each scheduling group",
+      required::no,
+      100ms)
+  , produce_smp_max_nonlocal_requests(
+      *this,
+      "produce_smp_max_nonlocal_requests",
+      "Produce calls of a shard in flight on another one",
+      required::no,
+      5000)
+  , fetch_smp_max_nonlocal_requests(
+      *this,
+      "fetch_smp_max_nonlocal_requests",
+      "Fetch calls of a shard in flight on another one",
+      required::no,
+      5000)
+  , group_smp_max_nonlocal_requests(
+      *this,
+      "group_smp_max_nonlocal_requests",
+      "Group coordinator calls of a shard in flight on another one",
+      required::no,
+      5000)
+  , admin_smp_max_nonlocal_requests(
+      *this,
+      "admin_smp_max_nonlocal_requests",
+      "Admin API calls of a shard in flight on another one",
+      required::no,
+      100)
+  , leader_balancer_enabled(
+      *this,
+      "leader_balancer_enabled",
+      "Transfer partition leaderships away from nodes and shards leading "
+      "more than their share",
+      required::no,
+      true)
+  , leader_balancer_interval_ms(
+      *this,
+      "leader_balancer_interval_ms",
+      "Interval between the leader balancing rounds of a node",
+      required::no,
+      1min)
+  , leader_balancer_imbalance_percent(
+      *this,
+      "leader_balancer_imbalance_percent",
+      "Percent above the mean leader count of the nodes, or above the mean "
+      "produce load of the shards of a node, tolerated before leaderships "
+      "are transferred",
+      required::no,
+      20)
+  , leader_balancer_transfers_per_round(
+      *this,
+      "leader_balancer_transfers_per_round",
+      "Maximum number of leadership transfers a node starts per balancing "
+      "round",
+      required::no,
+      4)
+  , leader_balancer_shard_moves_per_round(
+      *this,
+      "leader_balancer_shard_moves_per_round",
+      "Maximum number of partitions a node moves from its loaded shards to "
+      "other shards per balancing round, 0 disables the moves",
+      required::no,
+      1)
+  , node_load_report_interval_ms(
+      *this,
+      "node_load_report_interval_ms",
+      "Interval of the reports of partition bytes, throughput and free disk "
+      "space a node sends to the partition allocators of the cluster",
+      required::no,
+      10s)
+  , controller_backend_reconciliation_concurrency(
+      *this,
+      "controller_backend_reconciliation_concurrency",
+      "Number of partitions a shard creates, updates or removes at the same "
+      "time when applying topic changes",
+      required::no,
+      128)
+  , controller_snapshot_batches(
+      *this,
+      "controller_snapshot_batches",
+      "Number of controller log batches applied between snapshots of the "
+      "controller state, the log is truncated up to the last snapshot. Zero "
+      "disables snapshots",
+      required::no,
+      1000)
   , _advertised_kafka_api(
       *this,
       "advertised_kafka_api",
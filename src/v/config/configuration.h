@@ -30,9 +30,12 @@ namespace config {
 struct configuration final : public config_store {
     // WAL
     property<data_directory_path> data_directory;
+    property<std::vector<ss::sstring>> extra_data_directories;
     property<bool> developer_mode;
     property<uint64_t> log_segment_size;
     property<uint64_t> compacted_log_segment_size;
+    property<size_t> log_index_interval_bytes;
+    property<bool> log_index_adaptive;
     // Network
     property<unresolved_address> rpc_server;
     property<tls_config> rpc_server_tls;
@@ -40,6 +43,9 @@ struct configuration final : public config_store {
     property<bool> enable_coproc;
     property<unresolved_address> coproc_script_manager_server;
     property<unresolved_address> coproc_supervisor_server;
+    property<size_t> coproc_shared_memory_ring_bytes;
+    property<size_t> coproc_max_inflight_requests_per_partition;
+    property<std::chrono::milliseconds> coproc_offset_checkpoint_interval_ms;
     // Raft
     property<int32_t> node_id;
     property<int32_t> seed_server_meta_topic_partitions;
@@ -59,18 +65,38 @@ struct configuration final : public config_store {
     property<std::chrono::milliseconds> default_window_sec;
     property<std::chrono::milliseconds> quota_manager_gc_sec;
     property<uint32_t> target_quota_byte_rate;
+    property<std::optional<uint32_t>> target_fetch_quota_byte_rate;
+    property<std::chrono::milliseconds> quota_manager_aggregation_ms;
     property<std::optional<ss::sstring>> rack;
     property<bool> disable_metrics;
+    property<bool> aggregate_partition_metrics;
+    property<size_t> partition_metrics_detail_limit;
+    property<std::chrono::milliseconds> partition_metrics_rank_interval_ms;
     property<std::chrono::milliseconds> group_min_session_timeout_ms;
     property<std::chrono::milliseconds> group_max_session_timeout_ms;
     property<std::chrono::milliseconds> group_initial_rebalance_delay;
     property<std::chrono::milliseconds> group_new_member_join_timeout;
+    property<std::chrono::milliseconds> group_offset_commit_batch_window_ms;
+    property<std::chrono::milliseconds> group_snapshot_interval_ms;
+    property<std::chrono::milliseconds> group_lag_metrics_interval_ms;
     property<std::chrono::milliseconds> metadata_dissemination_interval_ms;
     // same as delete.retention.ms in kafka
     property<std::chrono::milliseconds> delete_retention_ms;
     property<std::chrono::milliseconds> log_compaction_interval_ms;
+    property<size_t> compaction_max_bytes_per_sec;
+    property<std::chrono::milliseconds> compaction_backpressure_latency_ms;
+    property<size_t> log_deletion_max_bytes_per_sec;
+    property<size_t> compaction_round_max_bytes;
+    property<size_t> log_segment_pool_files;
+    property<uint32_t> log_segment_prepare_percent;
+    property<size_t> log_readers_cache_size;
+    property<std::chrono::milliseconds> log_readers_cache_idle_ms;
     // same as retention.size in kafka - TODO: size not implemented
     property<std::optional<size_t>> retention_bytes;
+    property<uint32_t> disk_pressure_free_percent;
+    property<uint32_t> disk_pressure_target_free_percent;
+    property<std::chrono::milliseconds> disk_pressure_check_interval_ms;
+    property<size_t> ephemeral_log_memory_bytes;
     property<int32_t> group_topic_partitions;
     property<int16_t> default_topic_replication;
     property<std::chrono::milliseconds> create_topic_timeout_ms;
@@ -78,16 +104,38 @@ struct configuration final : public config_store {
     property<int32_t> default_topic_partitions;
     property<bool> disable_batch_cache;
     property<std::chrono::milliseconds> raft_election_timeout_ms;
+    property<bool> raft_adaptive_election_timeout;
+    property<std::chrono::milliseconds> raft_election_timeout_floor_ms;
+    property<std::chrono::milliseconds> raft_election_timeout_ceiling_ms;
+    property<std::chrono::milliseconds> raft_leader_lease_clock_drift_ms;
     property<std::chrono::milliseconds> kafka_group_recovery_timeout_ms;
     property<std::chrono::milliseconds> replicate_append_timeout_ms;
     property<std::chrono::milliseconds> recovery_append_timeout_ms;
+    property<size_t> recovery_snapshot_min_lag_bytes;
+    property<size_t> recovery_snapshot_chunks_in_flight;
+    property<size_t> recovery_max_concurrent_per_shard;
+    property<size_t> recovery_rate_bytes;
+    property<size_t> raft_replication_window_bytes;
+    property<size_t> raft_write_behind_max_bytes;
+    property<size_t> raft_max_inflight_bytes_per_follower;
+    property<bool> raft_batch_append_entries;
+    property<size_t> raft_leader_cache_warmup_bytes;
 
     property<size_t> reclaim_min_size;
     property<size_t> reclaim_max_size;
     property<std::chrono::milliseconds> reclaim_growth_window;
     property<std::chrono::milliseconds> reclaim_stable_window;
+    property<bool> reclaim_adaptive_target;
+    property<bool> enable_memory_broker;
+    property<size_t> rpc_server_protected_memory;
+    property<uint32_t> rpc_server_bulk_memory_percent;
+    property<bool> enable_storage_hugepages;
     property<bool> auto_create_topics_enabled;
+    property<bool> enable_idempotence;
+    property<bool> enable_sasl;
     property<bool> enable_pid_file;
+    property<bool> enable_disk_calibration;
+    property<std::chrono::milliseconds> disk_calibration_duration_ms;
     property<std::chrono::milliseconds> kvstore_flush_interval;
     property<size_t> kvstore_max_segment_size;
     property<std::chrono::milliseconds> max_kafka_throttle_delay_ms;
@@ -96,9 +144,45 @@ struct configuration final : public config_store {
     property<std::chrono::milliseconds> raft_timeout_now_timeout_ms;
     property<std::chrono::milliseconds>
       raft_transfer_leader_recovery_timeout_ms;
+    property<size_t> shutdown_leadership_transfer_concurrency;
+    property<std::chrono::milliseconds> shutdown_leadership_transfer_timeout_ms;
     property<bool> release_cache_on_segment_roll;
     property<std::chrono::milliseconds> segment_appender_flush_timeout_ms;
+    property<uint32_t> segment_fsync_coalesce_window_us;
+    property<std::optional<ss::sstring>> cold_storage_directory;
+    property<std::chrono::milliseconds> cold_storage_local_retention_ms;
+    property<size_t> cold_storage_cache_bytes;
+    property<size_t> cold_storage_prefetch_chunks;
+    property<std::optional<ss::sstring>> archival_bucket;
+    property<unresolved_address> archival_api_endpoint;
+    property<size_t> archival_upload_concurrency;
+    property<size_t> archival_upload_max_bytes_per_sec;
+    property<std::chrono::milliseconds> archival_upload_interval_ms;
+    property<size_t> archival_upload_part_size;
     property<std::chrono::milliseconds> fetch_session_eviction_timeout_ms;
+    property<size_t> fetch_session_cache_memory_bytes;
+    property<size_t> kafka_down_conversion_cache_bytes;
+    property<size_t> kafka_max_inflight_requests_per_connection;
+    property<size_t> kafka_produce_affinity_requests;
+    property<bool> kafka_follower_fetching_enabled;
+    property<size_t> raft_max_inflight_append_requests;
+    property<size_t> rpc_client_connections_per_peer;
+    property<size_t> produce_latency_max_partitions;
+    property<bool> cpu_profiler_enabled;
+    property<std::chrono::milliseconds> cpu_profiler_sample_period_ms;
+    property<std::chrono::milliseconds> scheduling_group_probe_interval_ms;
+    property<uint32_t> produce_smp_max_nonlocal_requests;
+    property<uint32_t> fetch_smp_max_nonlocal_requests;
+    property<uint32_t> group_smp_max_nonlocal_requests;
+    property<uint32_t> admin_smp_max_nonlocal_requests;
+    property<bool> leader_balancer_enabled;
+    property<std::chrono::milliseconds> leader_balancer_interval_ms;
+    property<size_t> leader_balancer_imbalance_percent;
+    property<size_t> leader_balancer_transfers_per_round;
+    property<size_t> leader_balancer_shard_moves_per_round;
+    property<std::chrono::milliseconds> node_load_report_interval_ms;
+    property<size_t> controller_backend_reconciliation_concurrency;
+    property<size_t> controller_snapshot_batches;
 
     configuration();
 
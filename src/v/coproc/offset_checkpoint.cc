@@ -0,0 +1,54 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Licensed as a Redpanda Enterprise file under the Redpanda Community
+// License (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+
+#include "coproc/offset_checkpoint.h"
+
+#include "bytes/iobuf_parser.h"
+#include "coproc/logger.h"
+#include "reflection/adl.h"
+#include "vlog.h"
+
+namespace coproc {
+
+namespace {
+constexpr int8_t checkpoint_version = 0;
+} // namespace
+
+bytes offset_checkpoint_key() { return bytes("offset_checkpoint"); }
+
+iobuf serialize_checkpoint(const offset_checkpoint& c) {
+    iobuf out;
+    reflection::serialize(out, checkpoint_version, int32_t(c.size()));
+    for (const auto& [ntp, offset] : c) {
+        reflection::serialize(out, ntp, offset);
+    }
+    return out;
+}
+
+offset_checkpoint deserialize_checkpoint(iobuf buf) {
+    iobuf_parser in(std::move(buf));
+    const auto version = reflection::adl<int8_t>{}.from(in);
+    if (version != checkpoint_version) {
+        vlog(
+          coproclog.warn,
+          "Ignoring offset checkpoint of unknown version {}",
+          version);
+        return offset_checkpoint{};
+    }
+    const auto n = reflection::adl<int32_t>{}.from(in);
+    offset_checkpoint c;
+    c.reserve(n);
+    for (int32_t i = 0; i < n; ++i) {
+        auto ntp = reflection::adl<model::ntp>{}.from(in);
+        auto offset = reflection::adl<model::offset>{}.from(in);
+        c.emplace(std::move(ntp), offset);
+    }
+    return c;
+}
+
+} // namespace coproc
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Licensed as a Redpanda Enterprise file under the Redpanda Community
+ * License (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+
+#include <absl/container/flat_hash_map.h>
+
+namespace coproc {
+
+/// Last offsets of the source ntps of a shard whose results were written to
+/// the materialized topics. The router of the shard keeps them in a single
+/// kvstore entry, rewritten periodically, and resumes the ntps from them
+using offset_checkpoint = absl::flat_hash_map<model::ntp, model::offset>;
+
+/// Key of the checkpoint in the coproc key space of the kvstore
+bytes offset_checkpoint_key();
+
+iobuf serialize_checkpoint(const offset_checkpoint&);
+
+/// An entry of an unknown format reads as an empty checkpoint
+offset_checkpoint deserialize_checkpoint(iobuf);
+
+} // namespace coproc
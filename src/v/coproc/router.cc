@@ -8,6 +8,7 @@
 
 #include "coproc/router.h"
 
+#include "config/configuration.h"
 #include "coproc/logger.h"
 #include "coproc/reference_window_consumer.hpp"
 #include "coproc/supervisor.h"
@@ -16,17 +17,22 @@
 #include "model/limits.h"
 #include "model/record_batch_reader.h"
 #include "rpc/backoff_policy.h"
+#include "storage/kvstore.h"
 #include "storage/types.h"
 #include "units.h"
 #include "vassert.h"
 #include "vlog.h"
 
+#include <seastar/core/condition-variable.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/loop.hh>
 #include <seastar/core/map_reduce.hh>
+#include <seastar/core/sleep.hh>
 
 #include <absl/container/flat_hash_map.h>
 
+#include <functional>
+
 namespace coproc {
 
 ss::future<std::optional<router::offset_rbr_pair>>
@@ -46,12 +52,115 @@ router::extract_offset(model::record_batch_reader reader) {
 router::router(ss::socket_address addr, ss::sharded<storage::api>& api)
   : _api(api)
   , _jitter(std::chrono::milliseconds(10))
+  , _engine_port(addr.port())
   , _transport(
       {rpc::transport_configuration{
         .server_addr = addr, .credentials = nullptr}},
       rpc::make_exponential_backoff_policy<rpc::clock_type>(
         std::chrono::seconds(1), std::chrono::seconds(10))) {}
 
+ss::future<> router::start() {
+    load_checkpoint();
+    open_shared_memory();
+    const auto interval
+      = config::shard_local_cfg().coproc_offset_checkpoint_interval_ms();
+    _checkpoint_timer.set_callback([this] { checkpoint(); });
+    _checkpoint_timer.arm_periodic(
+      std::max(interval, std::chrono::milliseconds(10)));
+    (void)route();
+    return ss::now();
+}
+
+ss::future<> router::stop() {
+    _checkpoint_timer.cancel();
+    _abort_source.request_abort();
+    _ready_cv.broken();
+    return _gate.close()
+      .then([this] {
+          // the offsets committed since the last checkpoint are not lost
+          if (!_checkpoint_dirty) {
+              return ss::now();
+          }
+          return write_checkpoint().handle_exception(
+            [](const std::exception_ptr& e) {
+                vlog(coproclog.warn, "Error checkpointing offsets: {}", e);
+            });
+      })
+      .then([this] {
+          _shm.reset();
+          return _transport.stop();
+      });
+}
+
+void router::load_checkpoint() {
+    auto value = _api.local().kvs().get(
+      storage::kvstore::key_space::coproc, offset_checkpoint_key());
+    if (value) {
+        _restored = deserialize_checkpoint(std::move(*value));
+        vlog(
+          coproclog.info,
+          "Restored the offsets of {} source ntps",
+          _restored.size());
+    }
+}
+
+void router::checkpoint() {
+    if (!_checkpoint_dirty || _checkpointing || _gate.is_closed()) {
+        return;
+    }
+    (void)ss::with_gate(_gate, [this] { return write_checkpoint(); })
+      .handle_exception([](const std::exception_ptr& e) {
+          vlog(coproclog.warn, "Error checkpointing offsets: {}", e);
+      });
+}
+
+ss::future<> router::write_checkpoint() {
+    offset_checkpoint c = _restored;
+    for (const auto& [ntp, ts] : _sources) {
+        if (ts.head->committed != model::model_limits<model::offset>::min()) {
+            c[ntp] = ts.head->committed;
+        }
+    }
+    _checkpoint_dirty = false;
+    _checkpointing = true;
+    return _api.local()
+      .kvs()
+      .put(
+        storage::kvstore::key_space::coproc,
+        offset_checkpoint_key(),
+        serialize_checkpoint(c))
+      .handle_exception([this](const std::exception_ptr& e) {
+          // retried by the next interval
+          _checkpoint_dirty = true;
+          return ss::make_exception_future<>(e);
+      })
+      .finally([this] { _checkpointing = false; });
+}
+
+void router::open_shared_memory() {
+    const auto ring_bytes
+      = config::shard_local_cfg().coproc_shared_memory_ring_bytes();
+    if (ring_bytes == 0) {
+        return;
+    }
+    auto name = shared_memory_transport::region_name(
+      _engine_port, ss::this_shard_id());
+    try {
+        _shm = std::make_unique<shared_memory_transport>(
+          std::move(name), ring_bytes);
+        vlog(
+          coproclog.info,
+          "Created shared memory region {} with rings of {} bytes",
+          _shm->name(),
+          ring_bytes);
+    } catch (const std::system_error& e) {
+        vlog(
+          coproclog.warn,
+          "Cannot create shared memory region, using RPC only: {}",
+          e.what());
+    }
+}
+
 ss::future<result<supervisor_client_protocol>> router::get_client() {
     return _transport.get_connected().then(
       [this](result<rpc::transport*> transport)
@@ -77,64 +186,145 @@ ss::future<result<supervisor_client_protocol>> router::get_client() {
 
 ss::future<> router::route() {
     /**
-     * Main run loop, polls constantly for new data on registered ntps.
-     * New data is defined as the latest offset being greater then the
-     * last observed offset for that ntp.
+     * Main run loop, waits for registered ntps to have new data. New data is
+     * defined as the committed offset of the log being greater then the
+     * last routed offset for that ntp, the log resolves the wait of the ntp
+     * when a flush commits such data.
      *
-     * Data is consumed from the topic (max 32KiB read) and sent to the
-     * interested topics, the reply is processed as writes to new materialized
-     * topics.
+     * Data is consumed from the ready topics (max 32KiB read each) and sent
+     * to the interested topics in a single request, the reply is processed
+     * as writes to new materialized topics. The ntps becoming ready while a
+     * request is in flight are routed together in the next one.
      *
      * The loop is broken if the abort_source has been initiated externally or
      * it can be initiated internally by detection of a failed connection to the
      * engine (after retry policy expires)
      */
-    try {
-        return ss::with_gate(_gate, [this] {
-            if (unlikely(_abort_source.abort_requested())) {
-                vlog(
-                  coproclog.info, "Abort source triggered, shutting down loop");
-                return ss::now();
-            }
-            return do_route();
-        });
-    } catch (const ss::gate_closed_exception& gce) {
-        vlog(coproclog.debug, "Gate closed exception encountered: {}", gce);
-        return ss::now();
+    return ss::with_gate(_gate, [this] {
+               return ss::do_until(
+                 [this] { return _abort_source.abort_requested(); },
+                 [this] {
+                     return _ready_cv
+                       .wait([this] {
+                           return !_ready.empty()
+                                  || _abort_source.abort_requested();
+                       })
+                       .then([this] {
+                           if (unlikely(_abort_source.abort_requested())) {
+                               return ss::now();
+                           }
+                           return do_route(std::exchange(_ready, {}));
+                       });
+                 });
+           })
+      .handle_exception_type([](const ss::broken_condition_variable&) {})
+      .handle_exception([](const std::exception_ptr& e) {
+          vlog(coproclog.info, "Routing loop stopped: {}", e);
+      })
+      .finally([] {
+          vlog(coproclog.info, "Abort source triggered, shutting down loop");
+      });
+}
+
+ss::future<> router::do_route(absl::flat_hash_set<model::ntp> ready) {
+    auto reducer = [](routed_batch acc, opt_req_data x) {
+        if (x.has_value()) {
+            acc.reqs.emplace_back(std::move(x->first));
+            acc.routed.emplace_back(std::move(x->second));
+        }
+        return acc;
+    };
+    return ss::do_with(
+      std::move(ready),
+      [this, reducer = std::move(reducer)](
+        absl::flat_hash_set<model::ntp>& ready) mutable {
+          return ss::map_reduce(
+                   ready.begin(),
+                   ready.end(),
+                   [this](const model::ntp& ntp) {
+                       auto found = _sources.find(ntp);
+                       if (found == _sources.end()) {
+                           return ss::make_ready_future<opt_req_data>(
+                             std::nullopt);
+                       }
+                       return route_ntp(found->first, found->second);
+                   },
+                   routed_batch(),
+                   std::move(reducer))
+            .then([this](routed_batch b) {
+                return process_batch(std::move(b));
+            })
+            .then([this] {
+                if (!std::exchange(_backoff, false)) {
+                    return ss::now();
+                }
+                return ss::sleep_abortable(_jitter(), _abort_source)
+                  .handle_exception_type([](const ss::sleep_aborted&) {});
+            })
+            .then([this, &ready] {
+                // wait for the data past what was routed, the ntps with as
+                // many requests in flight as allowed are watched again once
+                // the results of one were written
+                for (auto& ntp : ready) {
+                    if (auto found = _sources.find(ntp);
+                        found != _sources.end()
+                        && found->second.head->inflight < max_inflight()) {
+                        watch(found->first, found->second);
+                    }
+                }
+            });
+      });
+}
+
+void router::watch(const model::ntp& ntp, topic_state& ts) {
+    const auto next = ts.head->dirty
+                          == model::model_limits<model::offset>::min()
+                        ? model::offset(0)
+                        : ts.head->dirty + model::offset(1);
+    const auto id = ts.watch_id = ++_next_watch_id;
+    if (_gate.is_closed()) {
+        return;
     }
+    (void)ss::with_gate(_gate, [this, ntp, id, next, log = ts.log]() mutable {
+        return log.wait_for_committed_offset(next, _abort_source)
+          .then([this, ntp, id](model::offset) {
+              auto found = _sources.find(ntp);
+              if (found != _sources.end() && found->second.watch_id == id) {
+                  mark_ready(ntp);
+              }
+          })
+          .handle_exception([ntp](const std::exception_ptr& e) {
+              vlog(coproclog.debug, "Stopped waiting for {}: {}", ntp, e);
+          });
+    });
 }
 
-ss::future<> router::do_route() {
-    auto reducer =
-      [](std::vector<process_batch_request::data> acc, opt_req_data x) {
-          if (x.has_value()) {
-              acc.emplace_back(std::move(*x));
-          }
-          return acc;
-      };
-    return ss::map_reduce(
-             _sources.begin(),
-             _sources.end(),
-             [this](std::pair<const model::ntp, topic_state>& p) {
-                 return route_ntp(p.first, p.second);
-             },
-             std::vector<process_batch_request::data>(),
-             std::move(reducer))
-      .then([this](std::vector<process_batch_request::data> batch) {
-          return process_batch(std::move(batch));
-      })
-      .then([this, next_loop = _jitter()] { _loop_timer.rearm(next_loop); });
+void router::mark_ready(const model::ntp& ntp) {
+    _ready.insert(ntp);
+    _ready_cv.signal();
 }
 
-ss::future<>
-router::process_batch(std::vector<process_batch_request::data> batch) {
-    if (batch.empty()) {
+size_t router::max_inflight() {
+    return std::max<size_t>(
+      config::shard_local_cfg().coproc_max_inflight_requests_per_partition(),
+      1);
+}
+
+ss::future<> router::process_batch(routed_batch r) {
+    if (r.reqs.empty()) {
         return ss::now();
     }
+    if (_shm && _shm->attached()) {
+        return send_batch_shm(
+          process_batch_request{.reqs = std::move(r.reqs)},
+          std::move(r.routed));
+    }
     return get_client().then(
-      [this, batch = std::move(batch)](
+      [this, r = std::move(r)](
         result<supervisor_client_protocol> transport) mutable {
           if (!transport) {
+              _backoff = true;
+              abandon(r.routed);
               const auto err = transport.error();
               if (err == rpc::errc::disconnected_endpoint) {
                   vlog(
@@ -146,7 +336,9 @@ router::process_batch(std::vector<process_batch_request::data> batch) {
               return ss::now();
           }
           return send_batch(
-            transport.value(), process_batch_request{.reqs = std::move(batch)});
+            transport.value(),
+            process_batch_request{.reqs = std::move(r.reqs)},
+            std::move(r.routed));
       });
 }
 
@@ -157,156 +349,286 @@ router::route_ntp(const model::ntp& ntp, topic_state& ts) {
      * requested log. This is OK for now since the only topic_ingestion_policy
      * supported will be 'latest'
      *
-     * The last offset is recorded and the request is prepared and returned.
+     * Reading resumes after the data of the requests in flight. The last
+     * offset is recorded and the request is prepared and returned.
      */
-    return make_reader_cfg(ts.log, ts.head)
-      .then([this, ntp, log = ts.log, sids = ts.scripts](
-              opt_cfg config) mutable {
-          if (!config) {
-              return ss::make_ready_future<opt_req_data>(std::nullopt);
+    if (ts.head->inflight >= max_inflight()) {
+        return ss::make_ready_future<opt_req_data>(std::nullopt);
+    }
+    auto config = make_reader_cfg(ts.log, *ts.head);
+    if (!config) {
+        return ss::make_ready_future<opt_req_data>(std::nullopt);
+    }
+    return ts.log.make_reader(*config)
+      .then([this](model::record_batch_reader reader) {
+          return extract_offset(std::move(reader));
+      })
+      .then([this,
+             ntp,
+             head = ts.head,
+             prev = ts.head->dirty,
+             sids = ts.scripts](std::optional<offset_rbr_pair> p) mutable {
+          if (!p) {
+              return opt_req_data(std::nullopt);
           }
-          return log.make_reader(*config)
-            .then([this, ntp](model::record_batch_reader reader) {
-                return extract_offset(std::move(reader));
-            })
-            .then([this, ntp, sids = std::move(sids)](
-                    std::optional<offset_rbr_pair> p) {
-                if (!p) {
-                    return opt_req_data(std::nullopt);
-                }
-                auto& [offset, rbr] = *p;
-                auto found = _sources.find(ntp);
-                if (found == _sources.end()) {
-                    vlog(
-                      coproclog.info,
-                      "Ntp removed before batch assemble: {}",
-                      ntp);
-                    return opt_req_data(std::nullopt);
-                }
-                found->second.head.dirty = offset;
-                std::vector<script_id> ids(
-                  std::make_move_iterator(sids.begin()),
-                  std::make_move_iterator(sids.end()));
-                return opt_req_data(process_batch_request::data{
-                  .ids = std::move(ids), .ntp = ntp, .reader = std::move(rbr)});
-            });
+          auto& [offset, rbr] = *p;
+          auto found = _sources.find(ntp);
+          if (found == _sources.end() || found->second.head != head) {
+              vlog(
+                coproclog.info, "Ntp removed before batch assemble: {}", ntp);
+              return opt_req_data(std::nullopt);
+          }
+          if (head->dirty != prev) {
+              // a failed write rewound the ntp while it was read
+              return opt_req_data(std::nullopt);
+          }
+          head->dirty = offset;
+          ++head->inflight;
+          std::vector<script_id> ids(
+            std::make_move_iterator(sids.begin()),
+            std::make_move_iterator(sids.end()));
+          return opt_req_data(std::make_pair(
+            process_batch_request::data{
+              .ids = std::move(ids), .ntp = ntp, .reader = std::move(rbr)},
+            routed_ntp{
+              .ntp = ntp,
+              .head = std::move(head),
+              .prev = prev,
+              .last = offset}));
       });
 }
 
 ss::future<> router::send_batch(
-  supervisor_client_protocol transport, process_batch_request r) {
+  supervisor_client_protocol transport,
+  process_batch_request r,
+  std::vector<routed_ntp> routed) {
     using reply_type = result<rpc::client_context<process_batch_reply>>;
     return transport
       .process_batch(std::move(r), rpc::client_opts(model::no_timeout))
-      .then_wrapped([this](ss::future<reply_type> f) {
-          try {
-              auto reply = f.get0();
-              if (reply) {
-                  return process_reply(std::move(reply.value().data));
-              }
-              vlog(
-                coproclog.error, "Error on copro request: {}", reply.error());
-          } catch (const std::exception& e) {
-              vlog(coproclog.error, "Copro request future threw: {}", e.what());
-          }
-          return ss::now();
-      });
+      .then_wrapped(
+        [this, routed = std::move(routed)](ss::future<reply_type> f) mutable {
+            try {
+                auto reply = f.get0();
+                if (reply) {
+                    write_reply(
+                      std::move(reply.value().data), std::move(routed));
+                    return;
+                }
+                vlog(
+                  coproclog.error,
+                  "Error on copro request: {}",
+                  reply.error());
+            } catch (const std::exception& e) {
+                vlog(
+                  coproclog.error, "Copro request future threw: {}", e.what());
+            }
+            _backoff = true;
+            abandon(routed);
+        });
 }
 
-ss::future<> router::process_reply(process_batch_reply r) {
-    if (r.resps.empty()) {
-        vlog(coproclog.error, "Erroneous empty response received");
-        return ss::now();
+ss::future<> router::send_batch_shm(
+  process_batch_request r, std::vector<routed_ntp> routed) {
+    using reply_type = result<process_batch_reply>;
+    return _shm->process_batch(std::move(r), _abort_source)
+      .then_wrapped(
+        [this, routed = std::move(routed)](ss::future<reply_type> f) mutable {
+            try {
+                auto reply = f.get0();
+                if (reply) {
+                    write_reply(std::move(reply.value()), std::move(routed));
+                    return;
+                }
+                // nothing was written, the next round sends the same data
+                // over RPC
+                vlog(
+                  coproclog.warn,
+                  "Error on shared memory copro request, falling back to "
+                  "RPC: {}",
+                  reply.error().message());
+            } catch (const ss::sleep_aborted&) {
+            } catch (const std::exception& e) {
+                vlog(
+                  coproclog.error,
+                  "Shared memory copro request threw: {}",
+                  e.what());
+                _backoff = true;
+            }
+            abandon(routed);
+        });
+}
+
+void router::abandon(std::vector<routed_ntp>& routed) {
+    for (auto& r : routed) {
+        --r.head->inflight;
+        // the requests are sent one at a time, none routed after this one
+        if (r.head->dirty == r.last) {
+            r.head->dirty = r.prev;
+        }
     }
-    return ss::do_with(
-      std::move(r.resps),
-      [this](std::vector<process_batch_reply::data>& resps) mutable {
-          const auto range = boost::irange<size_t>(0, resps.size());
-          return ss::do_for_each(range, [this, &resps](size_t i) {
-              return process_reply_one(std::move(resps[i]));
-          });
-      });
 }
 
-void router::bump_offset(const model::ntp& src_ntp, const script_id sid) {
-    auto found = _sources.find(src_ntp);
-    if (found == _sources.end()) {
-        vlog(coproclog.warn, "Ntp removed before offset set: {}", src_ntp);
-        return;
+void router::write_reply(
+  process_batch_reply r, std::vector<routed_ntp> routed) {
+    if (r.resps.empty()) {
+        vlog(coproclog.error, "Erroneous empty response received");
     }
-    auto fsid = found->second.scripts.find(sid);
-    if (fsid == found->second.scripts.end()) {
-        vlog(coproclog.warn, "Script id removed before offset set: {}", sid);
+    // the results of every source ntp by materialized ntp, a reply without
+    // a materialized topic means the batch was filtered out
+    outputs_t outputs;
+    for (auto& e : r.resps) {
+        const auto mt = model::make_materialized_topic(e.ntp.tp.topic);
+        if (!mt) {
+            outputs[e.ntp];
+            continue;
+        }
+        model::ntp src_ntp(e.ntp.ns, mt->src, e.ntp.tp.partition);
+        outputs[src_ntp][e.ntp].push_back(std::move(e.reader));
+    }
+    if (_gate.is_closed()) {
+        abandon(routed);
         return;
     }
-    found->second.head.committed = found->second.head.dirty;
+    // the next request is sent while the results of this one are written
+    (void)ss::with_gate(
+      _gate,
+      [this,
+       outputs = std::move(outputs),
+       routed = std::move(routed)]() mutable {
+          return ss::do_with(
+            std::move(outputs),
+            std::move(routed),
+            [this](outputs_t& outputs, std::vector<routed_ntp>& routed) {
+                return ss::parallel_for_each(
+                  routed, [this, &outputs](routed_ntp& r) {
+                      auto found = outputs.find(r.ntp);
+                      return write_results(
+                        r, found == outputs.end() ? nullptr : &found->second);
+                  });
+            });
+      });
 }
 
-ss::future<> router::process_reply_one(process_batch_reply::data e) {
-    // Strip the source/dest topics from the materialized topic
-    const auto mt = model::make_materialized_topic(e.ntp.tp.topic);
-    if (!mt) {
-        // For now this will signify a null response, which means the
-        // record_batch was is to be filtered out of the materialized_topic.
-        // Mark offset, to continue to next record and do nothing else.
-        bump_offset(e.ntp, e.id);
-        return ss::now();
-    }
-    // The original ntp without the .$<destination>$ part of the topic
-    model::ntp src_ntp(e.ntp.ns, mt->src, e.ntp.tp.partition);
-    // Create the materialized log, the name of the log will be of the
-    // format: <src>.$<destination>$
-    return get_log(e.ntp).then([this,
-                                src_ntp,
-                                id = e.id,
-                                reader = std::move(e.reader)](
-                                 storage::log log) mutable {
-        // Append the requested data to the end of the log
-        storage::log_append_config cfg{
-          .should_fsync = storage::log_append_config::fsync::no,
-          .io_priority = ss::default_priority_class(),
-          .timeout = model::no_timeout};
-        return std::move(reader)
-          .for_each_ref(
-            coproc::reference_window_consumer(
-              model::record_batch_crc_checker(), log.make_appender(cfg)),
-            model::no_timeout)
-          .then(
-            [this, src_ntp, id, log](
-              std::tuple<bool, ss::future<storage::append_result>> t) mutable {
-                /// TODO(rob) NOT ideal to flush on every response.
-                /// Clubhouse ticket 'coprocessor enhancments' filed for this
-                const auto& [crc_parse_success, _] = t;
-                if (!crc_parse_success) {
-                    vlog(
-                      coproclog.warn,
-                      "record_batch failed to pass crc checks, not promoting "
-                      "log offset for source ntp: {}",
-                      src_ntp);
-                    return ss::now();
+ss::future<>
+router::write_results(routed_ntp& r, materialized_t* materialized) {
+    // the writes of one ntp are applied in the order of its requests
+    return r.head->mtx
+      .with([this, &r, materialized] {
+          if (r.head->committed != r.prev) {
+              // an earlier request failed, this data is routed again
+              return ss::now();
+          }
+          if (!materialized) {
+              vlog(coproclog.warn, "No response for routed ntp: {}", r.ntp);
+              r.head->dirty = r.head->committed;
+              return ss::now();
+          }
+          return ss::map_reduce(
+                   materialized->begin(),
+                   materialized->end(),
+                   [this](auto& p) {
+                       return write_materialized(p.first, std::move(p.second));
+                   },
+                   true,
+                   std::logical_and<>())
+            .then([this, &r](bool success) {
+                if (success) {
+                    r.head->committed = r.last;
+                    _checkpoint_dirty = true;
+                } else {
+                    r.head->dirty = r.head->committed;
                 }
-                bump_offset(src_ntp, id);
-                return log.flush();
             });
-    });
+      })
+      .handle_exception([&r](const std::exception_ptr& e) {
+          vlog(coproclog.warn, "Error writing results of {}: {}", r.ntp, e);
+          r.head->dirty = r.head->committed;
+      })
+      .finally([this, &r] {
+          --r.head->inflight;
+          auto found = _sources.find(r.ntp);
+          if (found != _sources.end() && found->second.head == r.head) {
+              watch(found->first, found->second);
+          }
+      });
 }
 
-ss::future<router::opt_cfg>
-router::make_reader_cfg(storage::log log, topic_offsets& head) {
-    return head.mtx.with([this, log, committed = head.committed]() {
-        const storage::offset_stats ostats = log.offsets();
-        if (committed >= ostats.committed_offset) {
-            // Signifies materialized log is up-to-date with source, there
-            // isn't anything more to read
-            return opt_cfg(std::nullopt);
-        }
-        const model::offset start
-          = (committed == model::model_limits<model::offset>::min())
-              ? model::offset(0)
-              : committed + model::offset(1);
-        return opt_cfg(
-          reader_cfg(start, model::model_limits<model::offset>::max()));
-    });
+ss::future<bool> router::write_materialized(
+  model::ntp ntp, std::vector<model::record_batch_reader> readers) {
+    // the results of all the scripts writing to the topic are coalesced
+    // into one append and one flush
+    return ss::do_with(
+             std::move(readers),
+             model::record_batch_reader::data_t(),
+             [](
+               std::vector<model::record_batch_reader>& readers,
+               model::record_batch_reader::data_t& batches) {
+                 return ss::do_for_each(
+                          readers,
+                          [&batches](model::record_batch_reader& reader) {
+                              return model::consume_reader_to_memory(
+                                       std::move(reader), model::no_timeout)
+                                .then([&batches](
+                                        model::record_batch_reader::data_t d) {
+                                    std::move(
+                                      d.begin(),
+                                      d.end(),
+                                      std::back_inserter(batches));
+                                });
+                          })
+                   .then([&batches] { return std::move(batches); });
+             })
+      .then([this, ntp](model::record_batch_reader::data_t batches) {
+          // Create the materialized log, the name of the log will be of the
+          // format: <src>.$<destination>$
+          return get_log(ntp).then(
+            [ntp, batches = std::move(batches)](storage::log log) mutable {
+                storage::log_append_config cfg{
+                  .should_fsync = storage::log_append_config::fsync::no,
+                  .io_priority = ss::default_priority_class(),
+                  .timeout = model::no_timeout};
+                return model::make_memory_record_batch_reader(
+                         std::move(batches))
+                  .for_each_ref(
+                    coproc::reference_window_consumer(
+                      model::record_batch_crc_checker(),
+                      log.make_appender(cfg)),
+                    model::no_timeout)
+                  .then([ntp, log](
+                          std::tuple<bool, ss::future<storage::append_result>>
+                            t) mutable {
+                      auto& [crc_parse_success, appended] = t;
+                      return std::move(appended).then(
+                        [ntp, log, crc_parse_success = crc_parse_success](
+                          storage::append_result) mutable {
+                            if (!crc_parse_success) {
+                                vlog(
+                                  coproclog.warn,
+                                  "record_batch failed to pass crc checks, "
+                                  "not promoting log offset for: {}",
+                                  ntp);
+                                return ss::make_ready_future<bool>(false);
+                            }
+                            return log.flush().then([] { return true; });
+                        });
+                  });
+            });
+      });
+}
+
+router::opt_cfg
+router::make_reader_cfg(storage::log log, const topic_offsets& head) {
+    const storage::offset_stats ostats = log.offsets();
+    if (head.dirty >= ostats.committed_offset) {
+        // Signifies everything committed to the source was routed, there
+        // isn't anything more to read
+        return std::nullopt;
+    }
+    const model::offset start
+      = (head.dirty == model::model_limits<model::offset>::min())
+          ? model::offset(0)
+          : head.dirty + model::offset(1);
+    return reader_cfg(start, model::model_limits<model::offset>::max());
 }
 
 ss::future<storage::log> router::get_log(const model::ntp& ntp) {
@@ -336,8 +658,17 @@ errc router::add_source(
         auto found = _sources.find(ntp);
         if (found == _sources.end()) {
             topic_state ts{
-              .log = log, .head = topic_offsets(), .scripts = {id}};
+              .log = log,
+              .head = ss::make_lw_shared<topic_offsets>(),
+              .scripts = {id}};
+            // resumes after the results written before the restart
+            if (auto it = _restored.find(ntp); it != _restored.end()) {
+                ts.head->committed = ts.head->dirty = it->second;
+                _restored.erase(it);
+            }
             _sources.emplace(ntp, std::move(ts));
+            // routes what the log already holds, then waits for more
+            mark_ready(ntp);
         } else {
             found->second.scripts.emplace(id);
         }
@@ -360,6 +691,8 @@ bool router::remove_source(const script_id sid) {
     absl::erase_if(_sources, [&deleted](const auto& p) {
         return deleted.contains(p.first);
     });
+    // the offsets of the removed ntps leave the checkpoint
+    _checkpoint_dirty |= !deleted.empty();
 
     return !deleted.empty();
 }
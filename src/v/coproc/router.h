@@ -11,6 +11,8 @@
 #pragma once
 #include "coproc/errc.h"
 #include "coproc/logger.h"
+#include "coproc/offset_checkpoint.h"
+#include "coproc/shared_memory_transport.h"
 #include "coproc/supervisor.h"
 #include "coproc/types.h"
 #include "model/fundamental.h"
@@ -24,37 +26,42 @@
 #include "utils/mutex.h"
 
 #include <seastar/core/abort_source.hh>
+#include <seastar/core/condition-variable.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
 #include <seastar/net/inet_address.hh>
 #include <seastar/net/socket_defs.hh>
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 
+#include <memory>
+#include <vector>
+
 namespace coproc {
 /// Reads data from registered input topics and routes them to the coprocessor
-/// engine connected locally. This is done by polling the registered ntps in a
-/// loop. Offsets are managed for each coprocessor/input topic so materialized
+/// engine connected locally. Every registered ntp waits for its log to commit
+/// data past what was routed, the ntps with new data are routed together in
+/// one request as soon as the previous request was answered. The results of a
+/// reply are written to the materialized topics while the next requests are
+/// in flight, a bounded number of requests per ntp. Idle ntps are not read.
+/// Offsets are managed for each coprocessor/input topic so materialized
 /// topics can resume upon last processed record in the case of a failure.
+/// The offsets of all the ntps of the shard are checkpointed together in the
+/// kvstore at an interval, a restart routes again at most the data of the
+/// interval.
 class router {
 public:
     router(ss::socket_address, ss::sharded<storage::api>&);
 
     /// Begin the loop on the current shard
-    ss::future<> start() {
-        _loop_timer.set_callback([this] { (void)route(); });
-        _loop_timer.arm(_jitter());
-        return ss::now();
-    }
+    ss::future<> start();
 
     /// Shut down the loop on the current shard
-    ss::future<> stop() {
-        _loop_timer.cancel();
-        _abort_source.request_abort();
-        return _gate.close().then([this] { return _transport.stop(); });
-    }
+    ss::future<> stop();
 
     errc add_source(
       const script_id, const model::topic_namespace&, topic_ingestion_policy);
@@ -67,39 +74,88 @@ public:
 private:
     using offset_rbr_pair
       = std::pair<model::offset, model::record_batch_reader>;
-    using opt_req_data = std::optional<process_batch_request::data>;
     using opt_cfg = std::optional<storage::log_reader_config>;
 
     struct topic_offsets {
+        /// Last offset written to the materialized topics
         model::offset committed{model::model_limits<model::offset>::min()};
+        /// Last offset sent to the engine, ahead of committed while results
+        /// are in flight
         model::offset dirty{model::model_limits<model::offset>::min()};
+        /// Requests in flight carrying data of the ntp
+        size_t inflight{0};
+        /// Applies the results of the requests in order
         mutex mtx;
     };
 
     struct topic_state {
         /// For now the only possible topic_ingestion_policy is latest
         storage::log log;
-        topic_offsets head;
+        /// Shared with the writes in flight, which outlive a removed state
+        ss::lw_shared_ptr<topic_offsets> head;
         absl::flat_hash_set<script_id> scripts;
+        /// Identifies the wait for new data of this state, a wait left over
+        /// by a removed state of the same ntp is ignored
+        uint64_t watch_id{0};
+    };
+
+    /// Data of a source ntp carried by a request
+    struct routed_ntp {
+        model::ntp ntp;
+        ss::lw_shared_ptr<topic_offsets> head;
+        /// Last offset routed before the request
+        model::offset prev;
+        /// Last offset of the request
+        model::offset last;
+    };
+
+    struct routed_batch {
+        std::vector<process_batch_request::data> reqs;
+        std::vector<routed_ntp> routed;
     };
 
+    using opt_req_data
+      = std::optional<std::pair<process_batch_request::data, routed_ntp>>;
+    /// Results of a source ntp by materialized ntp
+    using materialized_t = absl::
+      flat_hash_map<model::ntp, std::vector<model::record_batch_reader>>;
+    using outputs_t = absl::flat_hash_map<model::ntp, materialized_t>;
+
     ss::future<result<supervisor_client_protocol>> get_client();
     ss::future<storage::log> get_log(const model::ntp& ntp);
 
-    ss::future<> process_reply(process_batch_reply);
-    ss::future<> process_reply_one(process_batch_reply::data);
-
     ss::future<> route();
-    ss::future<> do_route();
+    ss::future<> do_route(absl::flat_hash_set<model::ntp>);
+    void watch(const model::ntp&, topic_state&);
+    void mark_ready(const model::ntp&);
+    static size_t max_inflight();
     ss::future<opt_req_data> route_ntp(const model::ntp&, topic_state&);
-    ss::future<> process_batch(std::vector<process_batch_request::data>);
-    ss::future<> send_batch(supervisor_client_protocol, process_batch_request);
+    ss::future<> process_batch(routed_batch);
+    ss::future<> send_batch(
+      supervisor_client_protocol,
+      process_batch_request,
+      std::vector<routed_ntp>);
+    ss::future<>
+      send_batch_shm(process_batch_request, std::vector<routed_ntp>);
+    void open_shared_memory();
+
+    /// Gives the data of a request which was not answered back to the ntps
+    void abandon(std::vector<routed_ntp>&);
+    /// Writes the results of a reply in the background
+    void write_reply(process_batch_reply, std::vector<routed_ntp>);
+    ss::future<> write_results(routed_ntp&, materialized_t*);
+    ss::future<bool>
+      write_materialized(model::ntp, std::vector<model::record_batch_reader>);
 
     ss::future<std::optional<offset_rbr_pair>>
       extract_offset(model::record_batch_reader);
-    void bump_offset(const model::ntp&, const script_id);
 
-    ss::future<opt_cfg> make_reader_cfg(storage::log, topic_offsets&);
+    void load_checkpoint();
+    /// Writes the offsets in the background unless a write is in flight
+    void checkpoint();
+    ss::future<> write_checkpoint();
+
+    opt_cfg make_reader_cfg(storage::log, const topic_offsets&);
     storage::log_reader_config reader_cfg(model::offset, model::offset);
 
 private:
@@ -107,19 +163,36 @@ private:
     /// desired ntp to be tracked
     ss::sharded<storage::api>& _api;
 
-    /// Primitives used to manage the poll loop and close gracefully
+    /// Primitives used to manage the routing loop and close gracefully
     ss::gate _gate;
     ss::abort_source _abort_source;
     uint8_t _connection_attempts{0};
+    /// Delays the next round after a failed request to the engine
     simple_time_jitter<ss::lowres_clock> _jitter;
-    ss::timer<ss::lowres_clock> _loop_timer;
+    bool _backoff{false};
+
+    /// Ntps with data committed past what was routed
+    absl::flat_hash_set<model::ntp> _ready;
+    ss::condition_variable _ready_cv;
+    uint64_t _next_watch_id{0};
 
     /// Core in-memory data structure that manages the relationships between
     /// topics and coprocessor scripts
     absl::flat_hash_map<model::ntp, topic_state> _sources;
 
+    /// Offsets of the last checkpoint of ntps not registered again since the
+    /// start, they are kept in the next checkpoints until they are
+    offset_checkpoint _restored;
+    ss::timer<ss::lowres_clock> _checkpoint_timer;
+    /// Offsets were committed since the last checkpoint
+    bool _checkpoint_dirty{false};
+    bool _checkpointing{false};
+
     /// Connection to the coprocessor engine
+    uint16_t _engine_port;
     rpc::reconnect_transport _transport;
+    /// Used instead of the connection while the engine is attached to it
+    std::unique_ptr<shared_memory_transport> _shm;
 };
 
 } // namespace coproc
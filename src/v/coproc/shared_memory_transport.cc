@@ -0,0 +1,167 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Licensed as a Redpanda Enterprise file under the Redpanda Community
+// License (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+
+#include "coproc/shared_memory_transport.h"
+
+#include "coproc/logger.h"
+#include "reflection/async_adl.h"
+#include "rpc/errc.h"
+#include "vlog.h"
+
+#include <seastar/core/loop.hh>
+#include <seastar/core/sleep.hh>
+
+#include <fmt/format.h>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace coproc {
+
+ss::sstring
+shared_memory_transport::region_name(uint16_t port, ss::shard_id shard) {
+    return fmt::format("/redpanda-coproc-{}-{}", port, shard);
+}
+
+size_t shared_memory_transport::ring_offset() {
+    return (sizeof(region_header) + ring_alignment - 1) / ring_alignment
+           * ring_alignment;
+}
+
+static char* map_region(const ss::sstring& name, size_t bytes) {
+    // a region left behind by a crashed broker is recreated empty
+    ::shm_unlink(name.c_str());
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::system_error(
+          errno, std::system_category(), "shm_open " + name);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) < 0) {
+        const auto err = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::system_error(
+          err, std::system_category(), "ftruncate " + name);
+    }
+    void* addr = ::mmap(
+      nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const auto err = errno;
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::system_error(err, std::system_category(), "mmap " + name);
+    }
+    return static_cast<char*>(addr);
+}
+
+shared_memory_transport::shared_memory_transport(
+  ss::sstring name, size_t ring_bytes)
+  : _name(std::move(name))
+  , _region_bytes(ring_offset() + 2 * shared_ring::region_bytes(ring_bytes))
+  , _region(map_region(_name, _region_bytes))
+  , _header(new (_region) region_header{})
+  , _requests(shared_ring::create(_region + ring_offset(), ring_bytes))
+  , _replies(shared_ring::create(
+      _region + ring_offset() + shared_ring::region_bytes(ring_bytes),
+      ring_bytes)) {
+    _header->version = version;
+    _header->ring_bytes = ring_bytes;
+    _header->engine_attached.store(0, std::memory_order_relaxed);
+    // the engine accepts the region once it sees the magic
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = magic;
+}
+
+shared_memory_transport::~shared_memory_transport() noexcept {
+    ::munmap(_region, _region_bytes);
+    ::shm_unlink(_name.c_str());
+}
+
+bool shared_memory_transport::attached() const {
+    return _header->engine_attached.load(std::memory_order_acquire) != 0;
+}
+
+void shared_memory_transport::detach() {
+    _header->engine_attached.store(0, std::memory_order_release);
+}
+
+ss::future<result<process_batch_reply>> shared_memory_transport::process_batch(
+  process_batch_request r, ss::abort_source& as) {
+    const auto id = ++_next_id;
+    return ss::do_with(
+      iobuf(), [this, id, r = std::move(r), &as](iobuf& buf) mutable {
+          return reflection::async_adl<process_batch_request>{}
+            .to(buf, std::move(r))
+            .then([this, id, &buf, &as] {
+                using ret_t = result<process_batch_reply>;
+                if (!attached()) {
+                    return ss::make_ready_future<ret_t>(
+                      rpc::errc::disconnected_endpoint);
+                }
+                if (!_requests.try_push(id, buf)) {
+                    vlog(
+                      coproclog.warn,
+                      "Request of {} bytes does not fit the {} bytes "
+                      "shared memory ring {}",
+                      buf.size_bytes(),
+                      _requests.capacity(),
+                      _name);
+                    detach();
+                    return ss::make_ready_future<ret_t>(
+                      rpc::errc::service_error);
+                }
+                return wait_reply(id, clock_type::now() + reply_timeout, as);
+            });
+      });
+}
+
+ss::future<result<process_batch_reply>> shared_memory_transport::wait_reply(
+  uint64_t id, clock_type::time_point deadline, ss::abort_source& as) {
+    using ret_t = std::optional<result<process_batch_reply>>;
+    return ss::repeat_until_value([this, id, deadline, &as] {
+               auto f = _replies.try_pop();
+               if (f && f->id == id) {
+                   return ss::do_with(
+                     iobuf_parser(std::move(f->payload)), [](iobuf_parser& p) {
+                         return reflection::async_adl<process_batch_reply>{}
+                           .from(p)
+                           .then([](process_batch_reply reply) {
+                               return ret_t(std::move(reply));
+                           });
+                     });
+               }
+               if (f) {
+                   // reply to a request which timed out before
+                   vlog(coproclog.debug, "Dropping stale reply {}", f->id);
+                   return ss::make_ready_future<ret_t>(std::nullopt);
+               }
+               if (clock_type::now() >= deadline) {
+                   detach();
+                   return ss::make_ready_future<ret_t>(
+                     rpc::errc::client_request_timeout);
+               }
+               return ss::sleep_abortable(poll_interval, as).then([] {
+                   return ret_t(std::nullopt);
+               });
+           })
+      .handle_exception_type([this](const std::runtime_error& e) {
+          vlog(
+            coproclog.error,
+            "Corrupt shared memory ring {}: {}",
+            _name,
+            e.what());
+          detach();
+          return result<process_batch_reply>(rpc::errc::service_error);
+      });
+}
+
+} // namespace coproc
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Licensed as a Redpanda Enterprise file under the Redpanda Community
+ * License (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+ */
+
+#pragma once
+#include "coproc/shared_ring.h"
+#include "coproc/types.h"
+#include "outcome.h"
+#include "seastarx.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sstring.hh>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace coproc {
+
+/// Exchanges batches with the coprocessor engine through a POSIX shared
+/// memory region instead of the loopback RPC connection.
+///
+/// Every shard creates its own region, named after the port of the engine
+/// and the shard, holding a request ring written by the broker and a reply
+/// ring written by the engine. The frames carry the same serialized
+/// process_batch_request and process_batch_reply as the RPC payloads, so the
+/// engine reads the record batches right out of the region. The engine
+/// empties both rings then sets the attached flag of the region once it
+/// mapped it. Requests are only sent while it is set. A request which does
+/// not fit the ring or is not answered in time clears the flag, the broker
+/// then goes back to RPC until the engine attaches again.
+class shared_memory_transport {
+public:
+    using clock_type = ss::lowres_clock;
+    static constexpr uint64_t magic = 0x7270636f70726f63; // "rpcoproc"
+    static constexpr uint32_t version = 1;
+    static constexpr auto poll_interval = std::chrono::microseconds(50);
+    static constexpr auto reply_timeout = std::chrono::seconds(10);
+
+    /// Name of the region of `shard` for the engine listening on `port`
+    static ss::sstring region_name(uint16_t port, ss::shard_id shard);
+
+    /// Creates the region, throws std::system_error when it cannot be
+    /// created or mapped
+    shared_memory_transport(ss::sstring name, size_t ring_bytes);
+    shared_memory_transport(const shared_memory_transport&) = delete;
+    shared_memory_transport& operator=(const shared_memory_transport&)
+      = delete;
+    shared_memory_transport(shared_memory_transport&&) = delete;
+    shared_memory_transport& operator=(shared_memory_transport&&) = delete;
+    /// Unmaps and removes the region
+    ~shared_memory_transport() noexcept;
+
+    /// True while the engine serves requests from the region
+    bool attached() const;
+
+    ss::future<result<process_batch_reply>>
+    process_batch(process_batch_request, ss::abort_source&);
+
+    const ss::sstring& name() const { return _name; }
+
+private:
+    struct region_header {
+        uint64_t magic;
+        uint32_t version;
+        // set by the engine, cleared by the broker
+        std::atomic<uint32_t> engine_attached;
+        uint64_t ring_bytes;
+    };
+    static constexpr size_t ring_alignment = 64;
+    static size_t ring_offset();
+
+    ss::future<result<process_batch_reply>>
+    wait_reply(uint64_t id, clock_type::time_point deadline, ss::abort_source&);
+    void detach();
+
+    ss::sstring _name;
+    size_t _region_bytes;
+    char* _region;
+    region_header* _header;
+    shared_ring _requests;
+    shared_ring _replies;
+    uint64_t _next_id{0};
+};
+
+} // namespace coproc
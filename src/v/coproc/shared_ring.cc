@@ -0,0 +1,123 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Licensed as a Redpanda Enterprise file under the Redpanda Community
+// License (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+
+#include "coproc/shared_ring.h"
+
+#include "vassert.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace coproc {
+
+size_t shared_ring::region_bytes(size_t capacity) {
+    // keeps the header of a ring placed right after this one aligned
+    constexpr auto align = alignof(header);
+    return sizeof(header) + (capacity + align - 1) / align * align;
+}
+
+shared_ring shared_ring::create(char* region, size_t capacity) {
+    vassert(
+      capacity > frame_header_bytes,
+      "Shared ring of {} bytes cannot hold a frame",
+      capacity);
+    auto h = new (region) header{};
+    h->head.store(0, std::memory_order_relaxed);
+    h->tail.store(0, std::memory_order_relaxed);
+    h->capacity = capacity;
+    std::atomic_thread_fence(std::memory_order_release);
+    return shared_ring(region);
+}
+
+shared_ring::shared_ring(char* region) noexcept
+  : _header(reinterpret_cast<header*>(region)) // NOLINT
+  , _data(region + sizeof(header)) {}
+
+size_t shared_ring::used() const {
+    return _header->tail.load(std::memory_order_acquire)
+           - _header->head.load(std::memory_order_acquire);
+}
+
+void shared_ring::write(uint64_t pos, const char* src, size_t n) {
+    const auto offset = pos % capacity();
+    const auto first = std::min(n, capacity() - offset);
+    std::memcpy(_data + offset, src, first);
+    std::memcpy(_data, src + first, n - first);
+}
+
+void shared_ring::read(uint64_t pos, char* dst, size_t n) const {
+    const auto offset = pos % capacity();
+    const auto first = std::min(n, capacity() - offset);
+    std::memcpy(dst, _data + offset, first);
+    std::memcpy(dst + first, _data, n - first);
+}
+
+bool shared_ring::try_push(uint64_t id, const iobuf& payload) {
+    const auto size = payload.size_bytes();
+    const auto head = _header->head.load(std::memory_order_acquire);
+    const auto tail = _header->tail.load(std::memory_order_relaxed);
+    if (
+      size > std::numeric_limits<uint32_t>::max()
+      || frame_header_bytes + size > capacity() - (tail - head)) {
+        return false;
+    }
+    const auto frame_size = static_cast<uint32_t>(size);
+    auto pos = tail;
+    write(pos, reinterpret_cast<const char*>(&frame_size), sizeof(frame_size));
+    pos += sizeof(frame_size);
+    write(pos, reinterpret_cast<const char*>(&id), sizeof(id));
+    pos += sizeof(id);
+    for (const auto& f : payload) {
+        write(pos, f.get(), f.size());
+        pos += f.size();
+    }
+    // publishes the frame once it is complete
+    _header->tail.store(pos, std::memory_order_release);
+    return true;
+}
+
+std::optional<shared_ring::frame> shared_ring::try_pop() {
+    const auto tail = _header->tail.load(std::memory_order_acquire);
+    const auto head = _header->head.load(std::memory_order_relaxed);
+    if (tail == head) {
+        return std::nullopt;
+    }
+    auto pos = head;
+    uint32_t size = 0;
+    read(pos, reinterpret_cast<char*>(&size), sizeof(size));
+    pos += sizeof(size);
+    frame f{.id = 0, .payload = iobuf()};
+    read(pos, reinterpret_cast<char*>(&f.id), sizeof(f.id));
+    pos += sizeof(f.id);
+    if (frame_header_bytes + size > tail - head) {
+        // the other side is not trusted with the memory of the broker
+        throw std::runtime_error(fmt::format(
+          "Shared ring frame of {} bytes past the {} produced bytes",
+          size,
+          tail - head));
+    }
+    ss::temporary_buffer<char> buf(size);
+    read(pos, buf.get_write(), size);
+    pos += size;
+    f.payload.append(std::move(buf));
+    // the bytes of the frame may be reused by the producer from now on
+    _header->head.store(pos, std::memory_order_release);
+    return f;
+}
+
+void shared_ring::reset() {
+    _header->head.store(0, std::memory_order_relaxed);
+    _header->tail.store(0, std::memory_order_release);
+}
+
+} // namespace coproc
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Licensed as a Redpanda Enterprise file under the Redpanda Community
+ * License (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace coproc {
+
+/// Single producer, single consumer ring of frames living in memory shared
+/// with another process. The producer and the consumer only synchronize
+/// through the head and tail counters of the header, each written by one
+/// side only. A frame is made of its size, the id of the request it belongs
+/// to and its payload, it wraps around the end of the ring.
+class shared_ring {
+public:
+    struct frame {
+        uint64_t id;
+        iobuf payload;
+    };
+
+    /// Bytes of shared memory used by a ring holding `capacity` bytes
+    static size_t region_bytes(size_t capacity);
+
+    /// Initializes an empty ring at the start of `region`
+    static shared_ring create(char* region, size_t capacity);
+
+    /// Ring already initialized at the start of `region`
+    explicit shared_ring(char* region) noexcept;
+
+    /// Appends a frame, false when the ring has no room for it
+    bool try_push(uint64_t id, const iobuf& payload);
+
+    /// Removes the oldest frame, if any. Throws when the frame overruns the
+    /// produced bytes
+    std::optional<frame> try_pop();
+
+    /// Drops all the frames, only safe when the other side is not attached
+    void reset();
+
+    size_t capacity() const { return _header->capacity; }
+    size_t used() const;
+
+private:
+    struct header {
+        // bytes consumed, written by the consumer
+        alignas(64) std::atomic<uint64_t> head;
+        // bytes produced, written by the producer
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) uint64_t capacity;
+    };
+    static constexpr size_t frame_header_bytes = sizeof(uint32_t)
+                                                 + sizeof(uint64_t);
+
+    void write(uint64_t pos, const char* src, size_t n);
+    void read(uint64_t pos, char* dst, size_t n) const;
+
+    header* _header;
+    char* _data;
+};
+
+} // namespace coproc
@@ -0,0 +1,38 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Licensed as a Redpanda Enterprise file under the Redpanda Community
+// License (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+
+#include "coproc/offset_checkpoint.h"
+#include "model/fundamental.h"
+#include "reflection/adl.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+SEASTAR_THREAD_TEST_CASE(test_checkpoint_roundtrip) {
+    coproc::offset_checkpoint c;
+    for (int i = 0; i < 100; ++i) {
+        c.emplace(
+          model::ntp(
+            model::ns("kafka"),
+            model::topic(i % 2 ? "foo" : "bar"),
+            model::partition_id(i)),
+          model::offset(i * 1000));
+    }
+    auto restored = coproc::deserialize_checkpoint(
+      coproc::serialize_checkpoint(c));
+    BOOST_REQUIRE(restored == c);
+
+    BOOST_REQUIRE(coproc::deserialize_checkpoint(
+                    coproc::serialize_checkpoint(coproc::offset_checkpoint{}))
+                    .empty());
+}
+
+SEASTAR_THREAD_TEST_CASE(test_checkpoint_unknown_version) {
+    iobuf buf;
+    reflection::serialize(buf, int8_t(1), int32_t(1));
+    BOOST_REQUIRE(coproc::deserialize_checkpoint(std::move(buf)).empty());
+}
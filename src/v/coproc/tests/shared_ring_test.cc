@@ -0,0 +1,80 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Licensed as a Redpanda Enterprise file under the Redpanda Community
+// License (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// https://github.com/vectorizedio/redpanda/blob/master/licenses/rcl.md
+
+#include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
+#include "coproc/shared_ring.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// the ring header is cache line aligned
+struct region {
+    alignas(64) char data[1024];
+};
+
+iobuf make_payload(size_t size, char c) {
+    iobuf buf;
+    std::vector<char> bytes(size, c);
+    buf.append(bytes.data(), bytes.size());
+    return buf;
+}
+
+void check_payload(iobuf buf, size_t size, char c) {
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), size);
+    iobuf_parser p(std::move(buf));
+    auto s = p.read_string(size);
+    BOOST_CHECK(
+      std::all_of(s.begin(), s.end(), [c](char x) { return x == c; }));
+}
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(frames_come_out_in_order) {
+    region r;
+    auto producer = coproc::shared_ring::create(r.data, 256);
+    coproc::shared_ring consumer(r.data);
+    BOOST_CHECK(!consumer.try_pop());
+
+    BOOST_REQUIRE(producer.try_push(1, make_payload(10, 'a')));
+    BOOST_REQUIRE(producer.try_push(2, make_payload(20, 'b')));
+    auto first = consumer.try_pop();
+    BOOST_REQUIRE(first);
+    BOOST_CHECK_EQUAL(first->id, 1);
+    check_payload(std::move(first->payload), 10, 'a');
+    auto second = consumer.try_pop();
+    BOOST_REQUIRE(second);
+    BOOST_CHECK_EQUAL(second->id, 2);
+    check_payload(std::move(second->payload), 20, 'b');
+    BOOST_CHECK(!consumer.try_pop());
+    BOOST_CHECK_EQUAL(consumer.used(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(full_ring_rejects_frames) {
+    region r;
+    auto ring = coproc::shared_ring::create(r.data, 128);
+    BOOST_REQUIRE(ring.try_push(1, make_payload(100, 'a')));
+    BOOST_CHECK(!ring.try_push(2, make_payload(100, 'b')));
+    BOOST_REQUIRE(ring.try_pop());
+    BOOST_CHECK(ring.try_push(2, make_payload(100, 'b')));
+}
+
+SEASTAR_THREAD_TEST_CASE(frames_wrap_around_the_ring) {
+    region r;
+    auto ring = coproc::shared_ring::create(r.data, 128);
+    for (uint64_t id = 0; id < 20; ++id) {
+        const auto c = static_cast<char>('a' + id);
+        BOOST_REQUIRE(ring.try_push(id, make_payload(50, c)));
+        auto f = ring.try_pop();
+        BOOST_REQUIRE(f);
+        BOOST_CHECK_EQUAL(f->id, id);
+        check_payload(std::move(f->payload), 50, c);
+    }
+}
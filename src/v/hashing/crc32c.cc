@@ -0,0 +1,76 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "hashing/crc32c.h"
+
+#include <array>
+
+namespace {
+
+// reflected castagnoli polynomial
+constexpr uint32_t crc32c_poly = 0x82f63b78;
+
+// a * b modulo the polynomial, in the reflected bit order where the most
+// significant bit holds the coefficient of x^0
+constexpr uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1U << 31U;
+    uint32_t p = 0;
+    while (true) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1U;
+        b = (b & 1U) ? (b >> 1U) ^ crc32c_poly : b >> 1U;
+    }
+    return p;
+}
+
+// x2n_table[n] = x^(2^n) modulo the polynomial
+constexpr std::array<uint32_t, 64> make_x2n_table() {
+    std::array<uint32_t, 64> table{};
+    uint32_t p = 1U << 30U; // x^1
+    table[0] = p;
+    for (size_t n = 1; n < table.size(); ++n) {
+        p = multmodp(p, p);
+        table[n] = p;
+    }
+    return table;
+}
+
+constexpr auto x2n_table = make_x2n_table();
+
+// x^(n * 2^k) modulo the polynomial
+constexpr uint32_t x2nmodp(size_t n, size_t k) {
+    uint32_t p = 1U << 31U; // x^0
+    while (n) {
+        if (n & 1U) {
+            p = multmodp(x2n_table[k], p);
+        }
+        n >>= 1U;
+        ++k;
+    }
+    return p;
+}
+
+} // namespace
+
+uint32_t crc32c_combine(uint32_t crc_a, uint32_t crc_b, size_t len_b) {
+    // shifting crc_a over the len_b bytes of b is a multiplication by
+    // x^(8 * len_b). the pre and post conditioning of both crcs cancel out
+    return crc32c_shift(crc32c_zeros(len_b), crc_a) ^ crc_b;
+}
+
+uint32_t crc32c_zeros(size_t len) { return x2nmodp(len, 3); }
+
+uint32_t crc32c_shift(uint32_t zeros, uint32_t crc) {
+    return multmodp(zeros, crc);
+}
@@ -12,8 +12,21 @@
 #pragma once
 #include <crc32c/crc32c.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
+/// crc32c of the concatenation a + b computed from the crcs of a and b,
+/// without touching the data. O(log(len_b))
+uint32_t crc32c_combine(uint32_t crc_a, uint32_t crc_b, size_t len_b);
+
+/// x^(8 * len) modulo the polynomial. crc32c_shift() by it extends a crc over
+/// len zero bytes, for patching crcs over a fixed length in constant time
+uint32_t crc32c_zeros(size_t len);
+uint32_t crc32c_shift(uint32_t zeros, uint32_t crc);
+
+/// crc32c. crc32c::Extend selects the SSE4.2 or ARMv8 CRC kernel at runtime
+/// when the cpu supports it and falls back to a portable implementation.
 class crc32 {
 public:
     template<typename T, typename = std::enable_if_t<std::is_integral_v<T>, T>>
@@ -31,6 +44,11 @@ public:
           size);
     }
 
+    /// extend with `size` bytes whose crc32c is already known
+    void combine(uint32_t crc, size_t size) {
+        _crc = crc32c_combine(_crc, crc, size);
+    }
+
     uint32_t value() const { return _crc; }
 
 private:
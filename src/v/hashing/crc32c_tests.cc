@@ -0,0 +1,58 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE crc32c
+#include "hashing/crc32c.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+static uint32_t crc_of(const std::string& s) {
+    crc32 crc;
+    crc.extend(s.data(), s.size());
+    return crc.value();
+}
+
+BOOST_AUTO_TEST_CASE(known_value) {
+    // check value of the castagnoli crc
+    BOOST_CHECK_EQUAL(crc_of("123456789"), 0xe3069283);
+}
+
+BOOST_AUTO_TEST_CASE(combine_same_as_extend) {
+    std::string data;
+    for (size_t i = 0; i < 10000; ++i) {
+        data.push_back(static_cast<char>(i * 31 + 7));
+    }
+    const auto expected = crc_of(data);
+    for (size_t split : {0UL, 1UL, 7UL, 64UL, 4095UL, 9999UL, 10000UL}) {
+        const auto a = data.substr(0, split);
+        const auto b = data.substr(split);
+        BOOST_CHECK_EQUAL(
+          crc32c_combine(crc_of(a), crc_of(b), b.size()), expected);
+
+        crc32 crc;
+        crc.extend(a.data(), a.size());
+        crc.combine(crc_of(b), b.size());
+        BOOST_CHECK_EQUAL(crc.value(), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(combine_many_fragments) {
+    std::string data(1 << 20, 'x');
+    for (size_t i = 0; i < data.size(); i += 97) {
+        data[i] = static_cast<char>(i);
+    }
+    crc32 crc;
+    for (size_t pos = 0, len = 1; pos < data.size(); pos += len, len *= 3) {
+        const auto frag = data.substr(pos, len);
+        crc.combine(crc_of(frag), frag.size());
+    }
+    BOOST_CHECK_EQUAL(crc.value(), crc_of(data));
+}
@@ -72,3 +72,47 @@ PERF_TEST(xx64_twang_fn, header_hash) {
     perf_tests::do_not_optimize(o);
     perf_tests::stop_measuring_time();
 }
+
+static constexpr size_t batch_bytes = 1 << 20;
+static constexpr size_t fragment_bytes = 16 << 10;
+
+PERF_TEST(crc32_fn, batch_contiguous) {
+    auto buffer = random_generators::gen_alphanum_string(batch_bytes);
+    crc32 crc;
+    perf_tests::start_measuring_time();
+    crc.extend(buffer.data(), buffer.size());
+    auto o = crc.value();
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(crc32_fn, batch_fragmented) {
+    auto buffer = random_generators::gen_alphanum_string(batch_bytes);
+    crc32 crc;
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < buffer.size(); i += fragment_bytes) {
+        crc.extend(buffer.data() + i, fragment_bytes);
+    }
+    auto o = crc.value();
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(crc32_fn, combine_fragment) {
+    auto buffer = random_generators::gen_alphanum_string(step_bytes);
+    crc32 crc;
+    crc.extend(buffer.data(), buffer.size());
+    perf_tests::start_measuring_time();
+    crc.combine(crc.value(), fragment_bytes);
+    auto o = crc.value();
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(xx64_fn, batch_contiguous) {
+    auto buffer = random_generators::gen_alphanum_string(batch_bytes);
+    perf_tests::start_measuring_time();
+    auto o = xxhash_64(buffer.data(), buffer.size());
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
@@ -13,36 +13,61 @@
 
 #include <seastar/core/temporary_buffer.hh>
 
-#include <boost/asio/buffer.hpp>
-#include <boost/asio/error.hpp>
-#include <boost/beast/core.hpp>
-#include <boost/beast/core/error.hpp>
-#include <boost/beast/http.hpp>
-#include <boost/beast/http/chunk_encode.hpp>
-#include <boost/beast/http/field.hpp>
+#include <fmt/format.h>
+
+#include <string_view>
 
 namespace http {
 
+namespace {
+
+constexpr std::string_view crlf = "\r\n";
+constexpr std::string_view last_chunk = "0\r\n\r\n";
+// hex digits of the size and crlf
+constexpr size_t max_header_size = 2 * sizeof(size_t) + crlf.size();
+
+/// Buffer referencing static data, no allocation and nothing to free
+ss::temporary_buffer<char> static_buffer(std::string_view s) {
+    return ss::temporary_buffer<char>(
+      const_cast<char*>(s.data()), s.size(), ss::deleter());
+}
+
+/// Appends the buffer as a fragment of its own. iobuf::append would copy
+/// small buffers into a new fragment sized after the previous one, which
+/// for the framing that follows a payload is an allocation as large as the
+/// payload, which the next payload could then be copied into.
+void append_fragment(iobuf& seq, ss::temporary_buffer<char> buf) {
+    seq.append_take_ownership(
+      new iobuf::fragment(std::move(buf), iobuf::fragment::full{}));
+}
+
+} // namespace
+
 void chunked_encoder::append_chunk_body(
-  iobuf& seq, ss::temporary_buffer<char>&& payload) {
-    size_t sz = payload.size();
-    boost::beast::http::chunk_header header(sz);
-    for (const auto& buf : header) {
-        seq.append(static_cast<const uint8_t*>(buf.data()), buf.size());
-    }
-    seq.append(std::move(payload));
-    boost::beast::http::chunk_crlf crlf;
-    for (const auto& buf : crlf) {
-        seq.append(static_cast<const uint8_t*>(buf.data()), buf.size());
-    }
+  iobuf& seq,
+  ss::temporary_buffer<char>& headers,
+  ss::temporary_buffer<char>&& payload) {
+    auto begin = headers.get_write();
+    auto end = fmt::format_to(begin, "{:x}{}", payload.size(), crlf);
+    const auto n = static_cast<size_t>(end - begin);
+    append_fragment(seq, headers.share(0, n));
+    headers.trim_front(n);
+    append_fragment(seq, std::move(payload));
+    append_fragment(seq, static_buffer(crlf));
+}
+
+size_t chunked_encoder::chunks(size_t size) const {
+    return (size + _max_chunk_size - 1) / _max_chunk_size;
 }
 
 void chunked_encoder::encode_impl(
-  iobuf& seq, ss::temporary_buffer<char>&& buf) const {
+  iobuf& seq,
+  ss::temporary_buffer<char>& headers,
+  ss::temporary_buffer<char>&& buf) const {
     for (size_t pos = 0; pos < buf.size(); pos += _max_chunk_size) {
         size_t chunk_size = std::min(_max_chunk_size, buf.size() - pos);
         auto tmp = buf.share(pos, chunk_size);
-        append_chunk_body(seq, std::move(tmp));
+        append_chunk_body(seq, headers, std::move(tmp));
     }
 }
 
@@ -54,8 +79,9 @@ iobuf chunked_encoder::encode(ss::temporary_buffer<char>&& buf) const {
     iobuf seq;
     if (_bypass) {
         seq.append(std::move(buf));
-    } else {
-        encode_impl(seq, std::move(buf));
+    } else if (const auto n = chunks(buf.size()); n > 0) {
+        ss::temporary_buffer<char> headers(n * max_header_size);
+        encode_impl(seq, headers, std::move(buf));
     }
     return seq;
 }
@@ -64,10 +90,19 @@ iobuf chunked_encoder::encode(iobuf&& inp) {
     if (_bypass) {
         return std::move(inp);
     }
+    // the headers of all the chunks share one allocation
+    size_t n = 0;
+    for (const auto& frag : inp) {
+        n += chunks(frag.size());
+    }
     iobuf out;
+    if (n == 0) {
+        return out;
+    }
+    ss::temporary_buffer<char> headers(n * max_header_size);
     for (auto& frag : inp) {
         auto tmp = frag.share();
-        encode_impl(out, std::move(tmp));
+        encode_impl(out, headers, std::move(tmp));
     }
     return out;
 }
@@ -75,10 +110,7 @@ iobuf chunked_encoder::encode(iobuf&& inp) {
 iobuf chunked_encoder::encode_eof() const {
     iobuf seq;
     if (!_bypass) {
-        boost::beast::http::chunk_last<> last;
-        for (const auto& buf : last) {
-            seq.append(static_cast<const uint8_t*>(buf.data()), buf.size());
-        }
+        append_fragment(seq, static_buffer(last_chunk));
     }
     return seq;
 }
@@ -51,10 +51,20 @@ private:
     ///     - crlf
     ///     - chunk payload
     ///     - crlf
-    static void
-    append_chunk_body(iobuf& seq, ss::temporary_buffer<char>&& payload);
+    /// The header is written to the front of 'headers' and shared from it,
+    /// the payload and the framing are referenced by 'seq', not copied.
+    static void append_chunk_body(
+      iobuf& seq,
+      ss::temporary_buffer<char>& headers,
+      ss::temporary_buffer<char>&& payload);
 
-    void encode_impl(iobuf& seq, ss::temporary_buffer<char>&& buf) const;
+    /// Number of chunks 'size' bytes are split into
+    size_t chunks(size_t size) const;
+
+    void encode_impl(
+      iobuf& seq,
+      ss::temporary_buffer<char>& headers,
+      ss::temporary_buffer<char>&& buf) const;
 
     const size_t _max_chunk_size;
     const bool _bypass;
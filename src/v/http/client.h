@@ -59,6 +59,10 @@ public:
 
     explicit client(const rpc::base_transport::configuration& cfg);
 
+    using rpc::base_transport::server_address;
+    using rpc::base_transport::shutdown;
+    using rpc::base_transport::stop;
+
     // Response state machine
     class response_stream {
     public:
@@ -139,10 +143,16 @@ public:
     // first otherwise the future will resolve immediately.
     ss::future<request_response_t> make_request(request_header&& header);
 
+    /// Return true if the last response was received to the end and the
+    /// server keeps the connection open for the next request
+    bool is_reusable() const { return _reusable && is_valid(); }
+
 private:
     template<class BufferSeq>
     static ss::future<>
     forward(rpc::batched_output_stream& stream, BufferSeq&& seq);
+
+    bool _reusable{false};
 };
 
 template<class BufferSeq>
@@ -0,0 +1,140 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "http/client_pool.h"
+
+#include "http/logger.h"
+#include "vlog.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace http {
+
+client_pool::lease&
+client_pool::lease::operator=(client_pool::lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        _pool = other._pool;
+        _client = std::move(other._client);
+    }
+    return *this;
+}
+
+void client_pool::lease::release() noexcept {
+    if (_client) {
+        _pool->release(std::move(_client));
+    }
+}
+
+client_pool::client_pool(configuration cfg)
+  : _cfg(cfg) {
+    _timer.set_callback([this] { close_expired(); });
+}
+
+client_pool::lease
+client_pool::acquire(const rpc::base_transport::configuration& cfg) {
+    auto it = std::find_if(
+      _targets.begin(), _targets.end(), [&cfg](const target& t) {
+          return t.address == cfg.server_addr;
+      });
+    if (it != _targets.end()) {
+        auto& clients = it->clients;
+        while (!clients.empty()) {
+            auto c = std::move(clients.back().client);
+            clients.pop_back();
+            // the server may have closed it while it was idle
+            if (c->is_reusable()) {
+                ++_reused;
+                return lease(this, std::move(c));
+            }
+            close(std::move(c));
+        }
+    }
+    ++_created;
+    return lease(this, std::make_unique<client>(cfg));
+}
+
+void client_pool::release(std::unique_ptr<client> c) noexcept {
+    if (_gate.is_closed() || !c->is_reusable()) {
+        close(std::move(c));
+        return;
+    }
+    auto it = std::find_if(
+      _targets.begin(), _targets.end(), [&c](const target& t) {
+          return t.address == c->server_address();
+      });
+    if (it == _targets.end()) {
+        _targets.push_back(target{.address = c->server_address()});
+        it = std::prev(_targets.end());
+    }
+    auto& clients = it->clients;
+    if (clients.size() >= _cfg.max_idle_per_target) {
+        // the least recently used goes first, it is the first to expire
+        close(std::move(clients.front().client));
+        clients.pop_front();
+    }
+    clients.push_back(
+      idle_client{.client = std::move(c), .since = clock_type::now()});
+    if (!_timer.armed()) {
+        _timer.arm_periodic(_cfg.idle_timeout / 2);
+    }
+}
+
+void client_pool::close(std::unique_ptr<client> c) noexcept {
+    vlog(http_log.trace, "closing connection to {}", c->server_address());
+    c->shutdown();
+    // nothing runs in the background of an http client once it is shut down,
+    // stop only waits for the gate of the transport
+    auto* p = c.get();
+    auto f = _gate.is_closed()
+               ? p->stop()
+               : ss::with_gate(_gate, [p] { return p->stop(); });
+    (void)f.finally([c = std::move(c)] {});
+}
+
+void client_pool::close_expired() {
+    const auto deadline = clock_type::now() - _cfg.idle_timeout;
+    for (auto& t : _targets) {
+        while (!t.clients.empty() && t.clients.front().since < deadline) {
+            close(std::move(t.clients.front().client));
+            t.clients.pop_front();
+        }
+    }
+    _targets.erase(
+      std::remove_if(
+        _targets.begin(),
+        _targets.end(),
+        [](const target& t) { return t.clients.empty(); }),
+      _targets.end());
+    if (_targets.empty()) {
+        _timer.cancel();
+    }
+}
+
+size_t client_pool::idle() const {
+    size_t n = 0;
+    for (const auto& t : _targets) {
+        n += t.clients.size();
+    }
+    return n;
+}
+
+ss::future<> client_pool::stop() {
+    _timer.cancel();
+    auto targets = std::exchange(_targets, {});
+    for (auto& t : targets) {
+        for (auto& c : t.clients) {
+            close(std::move(c.client));
+        }
+    }
+    return _gate.close();
+}
+
+} // namespace http
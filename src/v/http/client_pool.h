@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "http/client.h"
+#include "rpc/transport.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/net/socket_defs.hh>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace http {
+
+/**
+ * Per shard pool of keep-alive connections to http servers.
+ *
+ * A lease hands out a client of the target, connected already if the pool
+ * had an idle one, and gives it back to the pool when it is released. The
+ * client is kept only if the last response was received to the end and the
+ * server did not ask to close the connection, so the requests of a lease
+ * are sent one after the other. Targets are told apart by their address,
+ * all the clients of an address share the credentials of the first one.
+ *
+ * Connections idle for longer than idle_timeout are closed. The timeout is
+ * expected to be below the keep-alive timeout of the servers, so that a
+ * lease rarely gets a connection the server is closing.
+ */
+class client_pool {
+public:
+    using clock_type = ss::lowres_clock;
+
+    struct configuration {
+        // idle connections kept for each target
+        size_t max_idle_per_target{4};
+        clock_type::duration idle_timeout{std::chrono::seconds(10)};
+    };
+
+    /// Client borrowed from the pool, returned when released or dropped
+    class lease {
+    public:
+        lease() = default;
+        lease(lease&&) noexcept = default;
+        lease& operator=(lease&&) noexcept;
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+        ~lease() noexcept { release(); }
+
+        explicit operator bool() const { return bool(_client); }
+        client& operator*() { return *_client; }
+        client* operator->() { return _client.get(); }
+
+        /// Returns the client to the pool, the lease is empty afterwards
+        void release() noexcept;
+
+    private:
+        friend client_pool;
+
+        lease(client_pool* pool, std::unique_ptr<client> c)
+          : _pool(pool)
+          , _client(std::move(c)) {}
+
+        client_pool* _pool{nullptr};
+        std::unique_ptr<client> _client;
+    };
+
+    explicit client_pool(configuration);
+    client_pool(const client_pool&) = delete;
+    client_pool& operator=(const client_pool&) = delete;
+    client_pool(client_pool&&) = delete;
+    client_pool& operator=(client_pool&&) = delete;
+    ~client_pool() noexcept = default;
+
+    /// Lends a client of the target, a new one connects on its first request
+    lease acquire(const rpc::base_transport::configuration&);
+
+    /// Closes the idle connections, the leases must be released before
+    ss::future<> stop();
+
+    size_t idle() const;
+    // leases served by an idle connection
+    uint64_t reused() const { return _reused; }
+    // leases served by a new client
+    uint64_t created() const { return _created; }
+
+private:
+    struct idle_client {
+        std::unique_ptr<client> client;
+        clock_type::time_point since;
+    };
+
+    struct target {
+        ss::socket_address address;
+        // most recently released last
+        std::deque<idle_client> clients;
+    };
+
+    void release(std::unique_ptr<client>) noexcept;
+    void close(std::unique_ptr<client>) noexcept;
+    void close_expired();
+
+    configuration _cfg;
+    std::vector<target> _targets;
+    ss::timer<clock_type> _timer;
+    ss::gate _gate;
+    uint64_t _reused{0};
+    uint64_t _created{0};
+};
+
+} // namespace http
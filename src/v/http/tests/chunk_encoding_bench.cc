@@ -0,0 +1,54 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "http/chunk_encoding.h"
+#include "units.h"
+
+#include <seastar/core/temporary_buffer.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <algorithm>
+
+static iobuf make_body(size_t fragments, size_t fragment_size) {
+    iobuf body;
+    for (size_t i = 0; i < fragments; ++i) {
+        ss::temporary_buffer<char> buf(fragment_size);
+        std::fill_n(buf.get_write(), buf.size(), 'x');
+        iobuf frag;
+        frag.append(std::move(buf));
+        body.append_fragments(std::move(frag));
+    }
+    return body;
+}
+
+/// encodes the fragments of 'body', shared and not copied
+static void encode(http::chunked_encoder& enc, iobuf& body) {
+    auto in = body.share(0, body.size_bytes());
+    perf_tests::start_measuring_time();
+    auto out = enc.encode(std::move(in));
+    auto eof = enc.encode_eof();
+    perf_tests::stop_measuring_time();
+    perf_tests::do_not_optimize(out);
+    perf_tests::do_not_optimize(eof);
+}
+
+// a streamed upload, read from disk in large buffers
+PERF_TEST(chunk_encoding, large_fragments) {
+    static thread_local iobuf body = make_body(16, 128_KiB);
+    http::chunked_encoder enc(false, 32_KiB);
+    encode(enc, body);
+}
+
+// a streamed response, made of many small records
+PERF_TEST(chunk_encoding, small_fragments) {
+    static thread_local iobuf body = make_body(512, 512);
+    http::chunked_encoder enc(false, 32_KiB);
+    encode(enc, body);
+}
@@ -22,6 +22,7 @@
 #include <optional>
 #include <random>
 #include <sstream>
+#include <string_view>
 
 #define REQUIRE_CRLF(exp)                                                      \
     BOOST_REQUIRE_EQUAL((exp)[0], '\r');                                       \
@@ -152,4 +153,23 @@ SEASTAR_THREAD_TEST_CASE(test_chunked_bypass) {
     actual.append(encoder.encode(std::move(inp)));
     actual.append(encoder.encode_eof());
     BOOST_REQUIRE(expected == actual);
-}
\ No newline at end of file
+}
+SEASTAR_THREAD_TEST_CASE(test_chunked_encoding_shares_payload) {
+    ss::temporary_buffer<char> buf(0x1000);
+    std::fill_n(buf.get_write(), buf.size(), 'x');
+    const char* payload = buf.get();
+    http::chunked_encoder encoder(false, 0x400);
+    auto out = encoder.encode(std::move(buf));
+
+    // header, payload and crlf for every chunk
+    std::vector<std::string_view> frags;
+    for (const auto& f : out) {
+        frags.emplace_back(f.get(), f.size());
+    }
+    BOOST_REQUIRE_EQUAL(frags.size(), 12);
+    for (size_t i = 0; i < 4; ++i) {
+        BOOST_REQUIRE(frags[i * 3] == "400\r\n");
+        BOOST_REQUIRE(frags[i * 3 + 1].data() == payload + i * 0x400);
+        BOOST_REQUIRE(frags[i * 3 + 2] == "\r\n");
+    }
+}
@@ -11,6 +11,7 @@
 #include "bytes/iobuf_parser.h"
 #include "http/chunk_encoding.h"
 #include "http/client.h"
+#include "http/client_pool.h"
 #include "rpc/transport.h"
 #include "seastarx.h"
 
@@ -245,6 +246,60 @@ SEASTAR_TEST_CASE(test_http_PUT_roundtrip) {
     });
 }
 
+/// Send GET /get over the client and read the reply to the end
+static void get_roundtrip(
+  const rpc::base_transport::configuration& conf, http::client& client) {
+    http::client::request_header header;
+    header.method(boost::beast::http::verb::get);
+    header.target("/get");
+    header.insert(boost::beast::http::field::host, conf.server_addr);
+    auto [req_stream, resp_stream]
+      = client.make_request(std::move(header)).get0();
+    req_stream->send_eof().get();
+    iobuf body;
+    while (!resp_stream->is_done()) {
+        body.append(resp_stream->recv_some().get0());
+    }
+    BOOST_REQUIRE_EQUAL(
+      resp_stream->get_headers().result(), boost::beast::http::status::ok);
+}
+
+SEASTAR_TEST_CASE(test_client_pool_reuses_connections) {
+    return ss::async([] {
+        auto config = transport_configuration();
+        auto server = ss::make_shared<ss::httpd::http_server_control>();
+        server->start().get();
+        server->set_routes(set_routes).get();
+        server->listen(config.server_addr).get();
+        http::client_pool pool({});
+
+        for (int i = 0; i < 3; ++i) {
+            auto lease = pool.acquire(config);
+            get_roundtrip(config, *lease);
+        }
+        BOOST_REQUIRE_EQUAL(pool.created(), 1);
+        BOOST_REQUIRE_EQUAL(pool.reused(), 2);
+        BOOST_REQUIRE_EQUAL(pool.idle(), 1);
+
+        // a response which is not read to the end leaves the connection in
+        // the middle of it
+        {
+            auto lease = pool.acquire(config);
+            http::client::request_header header;
+            header.method(boost::beast::http::verb::get);
+            header.target("/get");
+            header.insert(boost::beast::http::field::host, config.server_addr);
+            auto [req_stream, resp_stream]
+              = lease->make_request(std::move(header)).get0();
+            req_stream->send_eof().get();
+        }
+        BOOST_REQUIRE_EQUAL(pool.idle(), 0);
+
+        pool.stop().get();
+        server->stop().get();
+    });
+}
+
 /// Simple tcp server that can receive pre-defined request and
 /// reply with pre-defined response.
 /// Seastar.Httpd doesn't support chunked encoding at the moment
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "json/json.h"
+
+#include <rapidjson/writer.h>
+
+#include <array>
+#include <cstddef>
+
+namespace json {
+
+/**
+ * rapidjson output stream into an iobuf.
+ *
+ * The characters the writer puts one at a time are staged in a small buffer
+ * and appended to the fragments of the iobuf a chunk at a time, the output is
+ * never held in one contiguous buffer that grows with it.
+ */
+class iobuf_ostream {
+public:
+    // the names are the ones of the rapidjson stream concept
+    using Ch = char;
+
+    iobuf_ostream() = default;
+    iobuf_ostream(const iobuf_ostream&) = delete;
+    iobuf_ostream& operator=(const iobuf_ostream&) = delete;
+    iobuf_ostream(iobuf_ostream&&) = delete;
+    iobuf_ostream& operator=(iobuf_ostream&&) = delete;
+    ~iobuf_ostream() = default;
+
+    void Put(Ch c) {
+        if (_staged == _stage.size()) {
+            Flush();
+        }
+        _stage[_staged++] = c;
+    }
+
+    void Flush() {
+        _buf.append(_stage.data(), _staged);
+        _staged = 0;
+    }
+
+    /// \brief the output, the stream is empty afterwards
+    iobuf release() {
+        Flush();
+        return std::move(_buf);
+    }
+
+private:
+    std::array<Ch, 512> _stage;
+    size_t _staged{0};
+    iobuf _buf;
+};
+
+/**
+ * rapidjson input stream over the fragments of an iobuf, the iobuf is read
+ * in place rather than linearized. It must outlive the stream.
+ */
+class iobuf_istream {
+public:
+    // the names are the ones of the rapidjson stream concept
+    using Ch = char;
+
+    explicit iobuf_istream(const iobuf& buf)
+      : _it(buf.cbegin())
+      , _end(buf.cend()) {
+        next_fragment();
+    }
+
+    Ch Peek() const { return _cur != _frag_end ? *_cur : '\0'; }
+
+    Ch Take() {
+        if (_cur == _frag_end) {
+            return '\0';
+        }
+        auto c = *_cur++;
+        ++_consumed;
+        if (_cur == _frag_end) {
+            next_fragment();
+        }
+        return c;
+    }
+
+    size_t Tell() const { return _consumed; }
+
+    // in situ parsing writes to the input, which is const
+    Ch* PutBegin() {
+        RAPIDJSON_ASSERT(false);
+        return nullptr;
+    }
+    void Put(Ch) { RAPIDJSON_ASSERT(false); }
+    void Flush() { RAPIDJSON_ASSERT(false); }
+    size_t PutEnd(Ch*) {
+        RAPIDJSON_ASSERT(false);
+        return 0;
+    }
+
+private:
+    void next_fragment() {
+        while (_cur == _frag_end && _it != _end) {
+            _cur = _it->get();
+            _frag_end = _cur + _it->size();
+            ++_it;
+        }
+    }
+
+    iobuf::const_iterator _it;
+    iobuf::const_iterator _end;
+    const Ch* _cur{nullptr};
+    const Ch* _frag_end{nullptr};
+    size_t _consumed{0};
+};
+
+using iobuf_writer = rapidjson::Writer<iobuf_ostream>;
+
+} // namespace json
@@ -9,50 +9,58 @@
 
 #include "json/json.h"
 
+#include "json/iobuf_stream.h"
+
 namespace json {
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, short v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, short v) {
     w.Int(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, bool v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, bool v) {
     w.Bool(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, long long v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, long long v) {
     w.Int64(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, int v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, int v) {
     w.Int(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, unsigned int v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, unsigned int v) {
     w.Uint(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, long v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, long v) {
     w.Int64(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, unsigned long v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, unsigned long v) {
     w.Uint64(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, double v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, double v) {
     w.Double(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, std::string_view v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, std::string_view v) {
     w.String(v.data(), v.size());
 }
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const ss::socket_address& v) {
+  rapidjson::Writer<Buffer>& w, const ss::socket_address& v) {
     w.StartObject();
 
     std::ostringstream a;
@@ -72,8 +80,9 @@ void rjson_serialize(
     w.EndObject();
 }
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const unresolved_address& v) {
+  rapidjson::Writer<Buffer>& w, const unresolved_address& v) {
     w.StartObject();
 
     w.Key("address");
@@ -85,11 +94,34 @@ void rjson_serialize(
     w.EndObject();
 }
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const std::chrono::milliseconds& v) {
+  rapidjson::Writer<Buffer>& w, const std::chrono::milliseconds& v) {
     uint64_t _tmp = v.count();
     rjson_serialize(w, _tmp);
 }
 
+#define INSTANTIATE_RJSON_SERIALIZE(Buffer)                                    \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, short);          \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, bool);           \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, long long);      \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, int);            \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, unsigned int);   \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, long);           \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, unsigned long);  \
+    template void rjson_serialize(rapidjson::Writer<Buffer>&, double);         \
+    template void rjson_serialize(                                             \
+      rapidjson::Writer<Buffer>&, std::string_view);                           \
+    template void rjson_serialize(                                             \
+      rapidjson::Writer<Buffer>&, const ss::socket_address&);                  \
+    template void rjson_serialize(                                             \
+      rapidjson::Writer<Buffer>&, const unresolved_address&);                  \
+    template void rjson_serialize(                                             \
+      rapidjson::Writer<Buffer>&, const std::chrono::milliseconds&);
+
+INSTANTIATE_RJSON_SERIALIZE(rapidjson::StringBuffer)
+INSTANTIATE_RJSON_SERIALIZE(iobuf_ostream)
+
+#undef INSTANTIATE_RJSON_SERIALIZE
+
 } // namespace json
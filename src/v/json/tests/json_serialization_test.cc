@@ -7,6 +7,9 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
+#include "json/iobuf_stream.h"
 #include "json/json.h"
 #include "seastarx.h"
 
@@ -134,3 +137,46 @@ SEASTAR_THREAD_TEST_CASE(json_serialization_test) {
 
     BOOST_TEST(res_doc["obj"].IsObject());
 }
+
+SEASTAR_THREAD_TEST_CASE(json_iobuf_ostream_test) {
+    std::vector<ss::sstring> names;
+    for (int i = 0; i < 10000; ++i) {
+        names.push_back(fmt::format("name {}", i));
+    }
+
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> sb_writer(sb);
+    json::rjson_serialize(sb_writer, names);
+
+    json::iobuf_ostream os;
+    json::iobuf_writer os_writer(os);
+    json::rjson_serialize(os_writer, names);
+    auto buf = os.release();
+
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), sb.GetSize());
+    BOOST_REQUIRE_GT(std::distance(buf.begin(), buf.end()), 1);
+    iobuf_parser parser(std::move(buf));
+    BOOST_REQUIRE_EQUAL(
+      parser.read_string(parser.bytes_left()),
+      ss::sstring(sb.GetString(), sb.GetSize()));
+}
+
+SEASTAR_THREAD_TEST_CASE(json_iobuf_istream_test) {
+    std::string_view input = R"({"name": "foo bar", "ids": [1, 22, 333]})";
+    // fragments of three bytes, tokens span them
+    iobuf buf;
+    for (size_t i = 0; i < input.size(); i += 3) {
+        auto chunk = input.substr(i, 3);
+        buf.append(ss::temporary_buffer<char>(chunk.data(), chunk.size()));
+    }
+    BOOST_REQUIRE_GT(std::distance(buf.begin(), buf.end()), 1);
+
+    json::iobuf_istream is(buf);
+    rapidjson::Document doc;
+    doc.ParseStream(is);
+    BOOST_REQUIRE(!doc.HasParseError());
+    BOOST_REQUIRE_EQUAL(is.Tell(), input.size());
+    BOOST_TEST(doc["name"].GetString() == std::string_view("foo bar"));
+    BOOST_REQUIRE_EQUAL(doc["ids"].Size(), 3);
+    BOOST_TEST(doc["ids"][2].GetInt() == 333);
+}
@@ -88,10 +88,19 @@ public:
         return send_recv([this, request_version, r = std::move(r)](
                            response_writer& wr) mutable {
                    write_header(wr, T::api_type::key, request_version);
+                   if (is_flexible_version<typename T::api_type>(
+                         request_version)) {
+                       wr.write_tagged_fields();
+                   }
                    r.encode(wr, request_version);
                })
           .then([response_version](iobuf buf) {
               using response_type = typename T::api_type::response_type;
+              if (is_flexible_version<typename T::api_type>(
+                    response_version)) {
+                  // the broker never sets tagged fields in response headers
+                  buf.trim_front(1);
+              }
               response_type r;
               r.decode(std::move(buf), response_version);
               return ss::make_ready_future<response_type>(std::move(r));
@@ -0,0 +1,231 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/down_conversion.h"
+
+#include "config/configuration.h"
+#include "kafka/requests/response_writer.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "storage/parser_utils.h"
+
+#include <seastar/core/metrics.hh>
+
+#include <boost/crc.hpp>
+
+namespace kafka {
+
+// attribute bits of the batch header and of the legacy message
+static constexpr int16_t control_batch_mask = 0x20;
+static constexpr int8_t legacy_timestamp_type_mask = 0x08;
+
+// label of the clients over max_tracked_clients
+static constexpr std::string_view other_clients = "_other";
+
+std::optional<int8_t> legacy_magic(api_version version) {
+    if (version < api_version(2)) {
+        return 0;
+    }
+    if (version < api_version(4)) {
+        return 1;
+    }
+    return std::nullopt;
+}
+
+iobuf down_convert(const model::record_batch& batch, int8_t magic) {
+    const auto& hdr = batch.header();
+    const bool log_append_time = hdr.attrs.timestamp_type()
+                                 == model::timestamp_type::append_time;
+    int8_t attrs = 0;
+    if (magic > 0 && log_append_time) {
+        attrs |= legacy_timestamp_type_mask;
+    }
+
+    iobuf out;
+    response_writer writer(out);
+    batch.for_each_record([&](model::record r) {
+        iobuf message;
+        response_writer mw(message);
+        mw.write(magic);
+        mw.write(attrs);
+        if (magic > 0) {
+            mw.write(
+              log_append_time ? hdr.max_timestamp()
+                              : hdr.first_timestamp() + r.timestamp_delta());
+        }
+        mw.write(
+          r.key_size() < 0 ? std::nullopt
+                           : std::make_optional(r.release_key()));
+        mw.write(
+          r.value_size() < 0 ? std::nullopt
+                             : std::make_optional(r.release_value()));
+
+        // legacy messages are checksummed with crc32, not crc32c
+        boost::crc_32_type crc;
+        for (const auto& f : message) {
+            crc.process_bytes(f.get(), f.size());
+        }
+        writer.write(int64_t(hdr.base_offset() + r.offset_delta()));
+        writer.write(int32_t(sizeof(uint32_t) + message.size_bytes()));
+        writer.write(uint32_t(crc.checksum()));
+        writer.write_direct(std::move(message));
+    });
+    return out;
+}
+
+down_conversion_cache::down_conversion_cache(size_t max_bytes)
+  : _max_bytes(max_bytes) {
+    register_metrics();
+}
+
+ss::future<iobuf> down_conversion_cache::get(
+  const model::ntp& ntp, model::record_batch&& batch, int8_t magic) {
+    key k{.ntp = ntp, .base_offset = batch.base_offset(), .magic = magic};
+    const auto batch_crc = batch.header().crc;
+    if (auto it = _entries.find(k); it != _entries.end()) {
+        if (it->second->batch_crc == batch_crc) {
+            ++_hits;
+            auto& e = *it->second;
+            e._hook.unlink();
+            _lru.push_back(e);
+            return ss::make_ready_future<iobuf>(
+              e.data.share(0, e.data.size_bytes()));
+        }
+        // the offset was truncated and written again
+        erase(it);
+    }
+
+    ++_misses;
+    auto decompressed = batch.compressed()
+                          ? storage::internal::decompress_batch(
+                            std::move(batch))
+                          : ss::make_ready_future<model::record_batch>(
+                            std::move(batch));
+    return decompressed.then(
+      [this, k = std::move(k), batch_crc, magic](
+        model::record_batch batch) mutable {
+          auto data = down_convert(batch, magic);
+          insert(std::move(k), batch_crc, data);
+          return data;
+      });
+}
+
+void down_conversion_cache::insert(
+  key k, int32_t batch_crc, const iobuf& data) {
+    const auto size = data.size_bytes();
+    if (size > _max_bytes) {
+        return;
+    }
+    // concurrent misses of the same batch
+    if (auto it = _entries.find(k); it != _entries.end()) {
+        erase(it);
+    }
+    while (!_lru.empty() && _bytes + size > _max_bytes) {
+        erase(_entries.find(_lru.front().k));
+    }
+    auto e = std::make_unique<entry>(entry{
+      .k = k,
+      .batch_crc = batch_crc,
+      .data = data.share(0, size),
+    });
+    _lru.push_back(*e);
+    _bytes += size;
+    _entries.emplace(std::move(k), std::move(e));
+}
+
+void down_conversion_cache::erase(underlying_t::iterator it) {
+    _bytes -= it->second->data.size_bytes();
+    it->second->_hook.unlink();
+    _entries.erase(it);
+}
+
+void down_conversion_cache::record_client(
+  std::optional<std::string_view> client_id, uint32_t batches, size_t bytes) {
+    if (batches == 0) {
+        return;
+    }
+    ss::sstring name(client_id.value_or(""));
+    auto it = _clients.find(name);
+    if (it == _clients.end()) {
+        if (_clients.size() >= max_tracked_clients) {
+            name = ss::sstring(other_clients);
+            it = _clients.find(name);
+        }
+        if (it == _clients.end()) {
+            it = _clients.emplace(name, client_stats{}).first;
+            register_client_metrics(name, it->second);
+        }
+    }
+    it->second.batches += batches;
+    it->second.bytes += bytes;
+}
+
+void down_conversion_cache::register_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:down_conversion_cache"),
+      {sm::make_gauge(
+         "entries",
+         [this] { return _entries.size(); },
+         sm::description("Number of converted batches in the cache")),
+       sm::make_gauge(
+         "bytes",
+         [this] { return _bytes; },
+         sm::description("Bytes of converted batches in the cache")),
+       sm::make_derive(
+         "hits",
+         [this] { return _hits; },
+         sm::description("Legacy batches served from the cache")),
+       sm::make_derive(
+         "misses",
+         [this] { return _misses; },
+         sm::description("Batches converted to a legacy format on fetch"))});
+}
+
+void down_conversion_cache::register_client_metrics(
+  std::string_view name, client_stats& stats) {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    const std::vector<sm::label_instance> labels = {
+      sm::label("client_id")(name)};
+    stats.metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:down_conversion"),
+      {sm::make_derive(
+         "batches",
+         [&stats] { return stats.batches; },
+         sm::description("Batches served to the client in a legacy format"),
+         labels),
+       sm::make_derive(
+         "bytes",
+         [&stats] { return stats.bytes; },
+         sm::description("Bytes served to the client in a legacy format"),
+         labels)});
+}
+
+ss::future<ss::stop_iteration>
+legacy_batch_serializer::operator()(model::record_batch&& batch) {
+    if (batch.header().attrs.value() & control_batch_mask) {
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::no);
+    }
+    ++_batch_count;
+    return _cache->get(_ntp, std::move(batch), _magic)
+      .then([this](iobuf data) {
+          _buf.append(std::move(data));
+          return ss::stop_iteration::no;
+      });
+}
+
+} // namespace kafka
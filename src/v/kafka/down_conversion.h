@@ -0,0 +1,169 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "kafka/types.h"
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "seastarx.h"
+#include "utils/intrusive_list_helpers.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/future-util.hh>
+#include <seastar/core/metrics_registration.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/node_hash_map.h>
+
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace kafka {
+
+/// Message format a fetch of the given version is answered with when it
+/// predates the v2 record batch format, none for the current format. Fetch
+/// v0 and v1 read messages of magic 0, v2 and v3 of magic 1.
+std::optional<int8_t> legacy_magic(api_version);
+
+/// Converts an uncompressed v2 record batch into a legacy message set of the
+/// given magic. The messages are uncompressed, record headers are dropped.
+iobuf down_convert(const model::record_batch&, int8_t magic);
+
+/**
+ * Down conversion cache is a core local cache of record batches converted to
+ * the legacy message formats. A legacy consumer can not be served the stored
+ * batches as they are, every batch it reads is decompressed and rewritten
+ * message by message. Legacy consumers of a partition usually read the same
+ * batches, so the converted message sets are kept and shared among them
+ * instead of being converted again for each one.
+ *
+ * Entries are keyed by the partition, the base offset and the magic of the
+ * batch, and carry the crc of the batch they were converted from, a batch
+ * written again at the same offset after a truncation does not match. The
+ * cache is bounded by the bytes it holds and evicts least recently used
+ * entries first.
+ *
+ * The cache also counts the conversions each client forces, since a single
+ * outdated consumer is usually what drives the cost.
+ **/
+class down_conversion_cache {
+public:
+    // clients counted one by one, the others are counted together
+    static constexpr size_t max_tracked_clients = 100;
+
+    explicit down_conversion_cache(size_t max_bytes);
+
+    /// Returns the message set of a batch converted to the magic. The batch
+    /// is converted on a miss, compressed batches are decompressed first.
+    ss::future<iobuf> get(const model::ntp&, model::record_batch&&, int8_t);
+
+    /// Accounts the converted batches a fetch of the client was served
+    void record_client(
+      std::optional<std::string_view> client_id, uint32_t batches, size_t);
+
+    size_t size() const { return _entries.size(); }
+    size_t size_bytes() const { return _bytes; }
+    uint64_t hits() const { return _hits; }
+    uint64_t misses() const { return _misses; }
+
+private:
+    struct key {
+        model::ntp ntp;
+        model::offset base_offset;
+        int8_t magic;
+
+        template<typename H>
+        friend H AbslHashValue(H h, const key& k) {
+            return H::combine(
+              std::move(h),
+              std::hash<model::ntp>{}(k.ntp),
+              k.base_offset(),
+              k.magic);
+        }
+
+        bool operator==(const key& o) const {
+            return ntp == o.ntp && base_offset == o.base_offset
+                   && magic == o.magic;
+        }
+    };
+
+    struct entry {
+        key k;
+        int32_t batch_crc;
+        iobuf data;
+        intrusive_list_hook _hook;
+    };
+
+    struct client_stats {
+        uint64_t batches{0};
+        uint64_t bytes{0};
+        ss::metrics::metric_groups metrics;
+    };
+
+    using underlying_t = absl::flat_hash_map<key, std::unique_ptr<entry>>;
+    using lru_t = intrusive_list<entry, &entry::_hook>;
+
+    void insert(key, int32_t batch_crc, const iobuf&);
+    void erase(underlying_t::iterator);
+    void register_metrics();
+    void register_client_metrics(std::string_view, client_stats&);
+
+    size_t _max_bytes;
+    underlying_t _entries;
+    // least recently used first
+    lru_t _lru;
+    size_t _bytes{0};
+    uint64_t _hits{0};
+    uint64_t _misses{0};
+    // node map, the metrics reference the counters
+    absl::node_hash_map<ss::sstring, client_stats> _clients;
+    ss::metrics::metric_groups _metrics;
+};
+
+/**
+ * A record batch reader consumer that serializes batches into a legacy
+ * message set through the down conversion cache, the counterpart of
+ * kafka_batch_serializer for the fetches of legacy consumers. Control batches
+ * have no legacy form and are left out.
+ */
+class legacy_batch_serializer {
+public:
+    struct result {
+        iobuf data;
+        uint32_t batch_count;
+    };
+
+    legacy_batch_serializer(
+      down_conversion_cache& cache, model::ntp ntp, int8_t magic) noexcept
+      : _cache(&cache)
+      , _ntp(std::move(ntp))
+      , _magic(magic) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch&&);
+
+    result end_of_stream() {
+        return result{
+          .data = std::move(_buf),
+          .batch_count = _batch_count,
+        };
+    }
+
+private:
+    down_conversion_cache* _cache;
+    model::ntp _ntp;
+    int8_t _magic;
+    iobuf _buf;
+    uint32_t _batch_count{0};
+};
+
+} // namespace kafka
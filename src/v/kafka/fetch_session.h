@@ -14,6 +14,7 @@
 #include "model/fundamental.h"
 #include "model/timeout_clock.h"
 #include "model/timestamp.h"
+#include "utils/intrusive_list_helpers.h"
 
 #include <absl/container/flat_hash_map.h>
 #include <boost/iterator/iterator_adaptor.hpp>
@@ -98,7 +99,9 @@ private:
 
     static auto make_partition_iterator(io_list_t::const_iterator it) {
         return boost::iterators::make_transform_iterator(
-          it, [](const entry& e) { return e.partition; });
+          it, [](const entry& e) -> const fetch_partition& {
+              return e.partition;
+          });
     }
 
 public:
@@ -151,11 +154,12 @@ public:
         return make_partition_iterator(insertion_order.cend());
     }
 
-    size_t mem_usage() {
-        using debug = absl::container_internal::hashtable_debug_internal::
-          HashtableDebugAccess<underlying_t>;
-        return debug::AllocatedByteSize(partitions)
-               + partitions.size() * sizeof(fetch_partition);
+    /// constant time, the cache accounts for it on every fetch
+    size_t mem_usage() const {
+        // a slot and a control byte per bucket
+        return partitions.capacity()
+                 * (sizeof(underlying_t::value_type) + 1)
+               + partitions.size() * sizeof(entry);
     }
 
     iterator begin() { return partitions.begin(); }
@@ -208,7 +212,7 @@ public:
 
     bool is_locked() const { return _locked; }
 
-    size_t mem_usage() {
+    size_t mem_usage() const {
         return sizeof(fetch_session) + _partitions.mem_usage();
     }
 
@@ -216,6 +220,8 @@ private:
     friend struct fetch_session_ctx;
     friend class fetch_session_cache;
     fetch_session_id _id;
+    // position in the least recently used order of the cache
+    intrusive_list_hook _lru_hook;
     fetch_partitions_linked_hash_map _partitions;
     model::timeout_clock::time_point _created;
     model::timeout_clock::time_point _last_used;
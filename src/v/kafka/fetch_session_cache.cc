@@ -48,11 +48,12 @@ void update_fetch_session(fetch_session& session, const fetch_request& req) {
 }
 
 fetch_session_cache::fetch_session_cache(
-  std::chrono::milliseconds eviction_timeout)
+  std::chrono::milliseconds eviction_timeout, size_t max_mem_usage)
   : _min_session_id(max_sessions_per_core() * seastar::this_shard_id())
   , _max_session_id(max_sessions_per_core() + _min_session_id - 1)
   , _last_session_id(_min_session_id)
-  , _session_eviction_duration(eviction_timeout) {
+  , _session_eviction_duration(eviction_timeout)
+  , _max_mem_usage(max_mem_usage) {
     register_metrics();
     _session_eviction_timer.set_callback([this] {
         gc_sessions();
@@ -74,8 +75,7 @@ fetch_session_cache::maybe_get_session(const fetch_request& req) {
         if (session_id != invalid_fetch_session_id) {
             if (auto it = _sessions.find(session_id); it != _sessions.end()) {
                 vlog(klog.info, "removing fetch session {}", session_id);
-                _sessions_mem_usage -= it->second->mem_usage();
-                _sessions.erase(it);
+                erase(it);
             }
         }
         if (epoch == final_fetch_session_epoch) {
@@ -94,6 +94,9 @@ fetch_session_cache::maybe_get_session(const fetch_request& req) {
         auto new_session = ss::make_lw_shared<fetch_session>(*new_id);
         // initialize fetch session partitions
         update_fetch_session(*new_session, req);
+        if (!make_room(*new_session)) {
+            return fetch_session_ctx();
+        }
 
         auto [it, success] = _sessions.emplace(*new_id, std::move(new_session));
         vassert(
@@ -103,6 +106,7 @@ fetch_session_cache::maybe_get_session(const fetch_request& req) {
 
         vlog(klog.info, "fetch session created: {}", *new_id);
         _sessions_mem_usage += it->second->mem_usage();
+        _lru.push_back(*it->second);
         return fetch_session_ctx(it->second, true);
     }
     auto it = _sessions.find(session_id);
@@ -131,20 +135,20 @@ fetch_session_cache::maybe_get_session(const fetch_request& req) {
           session->epoch(),
           epoch);
 
-        _sessions.erase(session_id);
+        session->_lru_hook.unlink();
+        _sessions.erase(it);
         return fetch_session_ctx();
     }
 
     session->advance_epoch();
     _sessions_mem_usage += session->mem_usage();
+    touch(*session);
     return fetch_session_ctx(session, false);
 }
 
 // we split whole range from 1 to max int32_t betewen all shards
 std::optional<fetch_session_id> fetch_session_cache::new_session_id() {
-    if (unlikely(
-          mem_usage() > max_mem_usage
-          || _sessions.size() > max_sessions_per_core())) {
+    if (unlikely(_sessions.size() > max_sessions_per_core())) {
         return std::nullopt;
     }
 
@@ -158,20 +162,82 @@ std::optional<fetch_session_id> fetch_session_cache::new_session_id() {
     return _last_session_id;
 }
 
+void fetch_session_cache::touch(fetch_session& session) {
+    session._lru_hook.unlink();
+    _lru.push_back(session);
+}
+
+void fetch_session_cache::erase(underlying_t::iterator it) {
+    _sessions_mem_usage -= it->second->mem_usage();
+    it->second->_lru_hook.unlink();
+    _sessions.erase(it);
+}
+
+bool fetch_session_cache::make_room(const fetch_session& s) {
+    const auto needed = s.mem_usage();
+    const auto now = model::timeout_clock::now();
+    const auto stale = _session_eviction_duration / 2;
+    while (mem_usage() + needed > _max_mem_usage) {
+        // the largest idle time times partition count among the least
+        // recently used sessions the new one may evict
+        const fetch_session* victim = nullptr;
+        uint64_t victim_weight = 0;
+        size_t looked_at = 0;
+        for (auto it = _lru.begin();
+             it != _lru.end() && looked_at < eviction_candidates;
+             ++it, ++looked_at) {
+            if (it->is_locked()) {
+                continue;
+            }
+            const auto idle = now - it->_last_used;
+            if (
+              idle < stale
+              && it->partitions().size() < s.partitions().size()) {
+                continue;
+            }
+            const auto weight
+              = uint64_t(
+                  std::chrono::duration_cast<std::chrono::milliseconds>(idle)
+                    .count()
+                  + 1)
+                * std::max<size_t>(it->partitions().size(), 1);
+            if (!victim || weight > victim_weight) {
+                victim = &*it;
+                victim_weight = weight;
+            }
+        }
+        if (!victim) {
+            vlog(
+              klog.debug,
+              "no room for a fetch session of {} partitions",
+              s.partitions().size());
+            return false;
+        }
+        vlog(
+          klog.debug,
+          "evicting session {} of {} partitions",
+          victim->id(),
+          victim->partitions().size());
+        ++_evictions;
+        erase(_sessions.find(victim->id()));
+    }
+    return true;
+}
+
 void fetch_session_cache::gc_sessions() {
     auto now = model::timeout_clock::now();
-    for (auto it = _sessions.cbegin(); it != _sessions.cend();) {
-        // session is in use or was used recently skip
-        if (
-          it->second->is_locked()
-          || now - it->second->_last_used < _session_eviction_duration) {
-            // do nothing
-            ++it;
-        } else {
-            vlog(klog.debug, "evicting session {}", it->second->id());
-            _sessions_mem_usage -= it->second->mem_usage();
-            _sessions.erase(it++);
+    // least recently used first, stops at the first session used recently
+    for (auto it = _lru.begin(); it != _lru.end();) {
+        if (now - it->_last_used < _session_eviction_duration) {
+            break;
+        }
+        auto& session = *it++;
+        // session is in use, skip
+        if (session.is_locked()) {
+            continue;
         }
+        vlog(klog.debug, "evicting session {}", session.id());
+        erase(_sessions.find(session.id()));
     }
 }
 
@@ -190,7 +256,12 @@ void fetch_session_cache::register_metrics() {
        sm::make_gauge(
          "sessions_count",
          [this] { return _sessions.size(); },
-         sm::description("Total number of fetch sessions"))});
+         sm::description("Total number of fetch sessions")),
+       sm::make_derive(
+         "evictions",
+         [this] { return _evictions; },
+         sm::description("Fetch sessions evicted to make room for new "
+                         "sessions"))});
 }
 
 } // namespace kafka
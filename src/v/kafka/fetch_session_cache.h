@@ -29,20 +29,30 @@ struct fetch_request;
  * for the node (non overlapping ranges of ids are assigned to each core).
  *
  * The cache evicts not used sessions after configurable period of inactivity.
- * Fetch session cache will stop adding new sessions after its max memory usage
- * is reached.
+ * When a new session does not fit in the memory of the cache, sessions are
+ * evicted least recently used first. Among the least recently used ones the
+ * session with the largest idle time times partition count goes first, and
+ * a new session only evicts sessions idle for half of the eviction period
+ * or at least as large as itself, so a large consumer does not push the
+ * active small ones out. The new session is sessionless when it still does
+ * not fit.
  **/
 class fetch_session_cache {
 public:
-    explicit fetch_session_cache(std::chrono::milliseconds);
+    static constexpr size_t default_max_mem_usage = 10_MiB;
+    // least recently used sessions looked at for an eviction
+    static constexpr size_t eviction_candidates = 8;
+
+    explicit fetch_session_cache(
+      std::chrono::milliseconds,
+      size_t max_mem_usage = default_max_mem_usage);
     fetch_session_ctx maybe_get_session(const fetch_request& req);
     size_t size() const { return _sessions.size(); }
 
 private:
     using underlying_t
       = absl::flat_hash_map<fetch_session_id, fetch_session_ptr>;
-
-    static constexpr size_t max_mem_usage = 10_MiB;
+    using lru_t = intrusive_list<fetch_session, &fetch_session::_lru_hook>;
 
     // used to split range of possible session ids to limit memory size we use
     // max_mem_used, this is theoretical limit, the actual number of session
@@ -55,16 +65,22 @@ private:
 
     std::optional<fetch_session_id> new_session_id();
     void gc_sessions();
+    void touch(fetch_session&);
+    void erase(underlying_t::iterator);
+    /// evicts sessions until the new one fits, false when it does not
+    bool make_room(const fetch_session&);
 
     size_t mem_usage() const {
-        using debug = absl::container_internal::hashtable_debug_internal::
-          HashtableDebugAccess<underlying_t>;
-        return debug::AllocatedByteSize(_sessions) + _sessions_mem_usage;
+        // a slot and a control byte per bucket
+        return _sessions.capacity() * (sizeof(underlying_t::value_type) + 1)
+               + _sessions_mem_usage;
     }
 
     void register_metrics();
 
     underlying_t _sessions;
+    // least recently used first
+    lru_t _lru;
     const fetch_session_id _min_session_id;
     const fetch_session_id _max_session_id;
     fetch_session_id _last_session_id;
@@ -72,8 +88,10 @@ private:
     // min time that will elapse since the session was last used before it is
     // going to be evicted
     std::chrono::milliseconds _session_eviction_duration;
+    size_t _max_mem_usage;
 
     size_t _sessions_mem_usage = 0;
+    size_t _evictions = 0;
 
     ss::metrics::metric_groups _metrics;
 };
@@ -48,26 +48,32 @@ group::group(
   kafka::group_id id,
   group_state s,
   config::configuration& conf,
-  ss::lw_shared_ptr<cluster::partition> partition)
+  ss::lw_shared_ptr<cluster::partition> partition,
+  ss::lw_shared_ptr<offset_commit_batcher> commit_batcher)
   : _id(id)
   , _state(s)
   , _state_timestamp(clock_type::now())
   , _generation(0)
   , _num_members_joining(0)
+  , _join_timer(group_timer_wheel())
   , _new_member_added(false)
   , _conf(conf)
-  , _partition(partition) {}
+  , _partition(std::move(partition))
+  , _commit_batcher(std::move(commit_batcher)) {}
 
 group::group(
   kafka::group_id id,
   group_log_group_metadata& md,
   config::configuration& conf,
-  ss::lw_shared_ptr<cluster::partition> partition)
+  ss::lw_shared_ptr<cluster::partition> partition,
+  ss::lw_shared_ptr<offset_commit_batcher> commit_batcher)
   : _id(id)
   , _num_members_joining(0)
+  , _join_timer(group_timer_wheel())
   , _new_member_added(false)
   , _conf(conf)
-  , _partition(partition) {
+  , _partition(std::move(partition))
+  , _commit_batcher(std::move(commit_batcher)) {
     _state = md.members.empty() ? group_state::empty : group_state::stable;
     _generation = md.generation;
     _protocol_type = md.protocol_type;
@@ -151,6 +157,10 @@ void group::add_member_no_join(member_ptr member) {
     for (auto& p : member->protocols()) {
         _supported_protocols[p.name]++;
     }
+
+    if (member->group_instance_id()) {
+        _static_members[*member->group_instance_id()] = member->id();
+    }
 }
 
 ss::future<join_group_response> group::add_member(member_ptr member) {
@@ -428,7 +438,17 @@ group::join_group_unknown_member(join_group_request&& r) {
 
     // <kafka>Only return MEMBER_ID_REQUIRED error if joinGroupRequest version
     // is >= 4 and groupInstanceId is configured to unknown.</kafka>
-    if (r.version >= api_version(4) && !r.data.group_instance_id) {
+    if (r.data.group_instance_id) {
+        // <kafka>If the member is static, check whether it is a rejoining
+        // instance that needs to be fenced and replaced.</kafka>
+        if (_static_members.contains(*r.data.group_instance_id)) {
+            return update_static_member_and_rebalance(
+              std::move(new_member_id), std::move(r));
+        }
+        return add_member_and_rebalance(std::move(new_member_id), std::move(r));
+    }
+
+    if (r.version >= api_version(4)) {
         // <kafka>If member id required (dynamic membership), register the
         // member in the pending member list and send back a response to
         // call for another join group request with allocated member id.
@@ -460,6 +480,12 @@ group::join_group_known_member(join_group_request&& r) {
         kafka::member_id new_member_id = std::move(r.data.member_id);
         return add_member_and_rebalance(std::move(new_member_id), std::move(r));
 
+    } else if (is_fenced_instance(
+                 r.data.group_instance_id, r.data.member_id)) {
+        klog.trace("static member was replaced by a newer instance");
+        return make_join_error(
+          r.data.member_id, error_code::fenced_instance_id);
+
     } else if (!contains_member(r.data.member_id)) {
         klog.trace("member is not registered in the group");
         return make_join_error(r.data.member_id, error_code::unknown_member_id);
@@ -591,16 +617,126 @@ ss::future<join_group_response> group::add_member_and_rebalance(
     auto now = clock_type::now();
     member->set_latest_heartbeat(now);
     auto deadline = now + _conf.group_new_member_join_timeout();
-    member->expire_timer().set_callback(
-      [this, deadline, member_id = member->id()]() {
-          heartbeat_expire(member_id, deadline);
-      });
+    // the timer is owned by the member, so it never outlives the pointer.
+    // capturing the id instead would allocate on every heartbeat.
+    member->expire_timer().set_callback([this, m = member.get()]() {
+        heartbeat_expire(m->id(), m->expire_timer().get_timeout());
+    });
     member->expire_timer().arm(deadline);
 
     try_prepare_rebalance();
     return response;
 }
 
+ss::future<join_group_response> group::update_static_member_and_rebalance(
+  kafka::member_id new_member_id, join_group_request&& r) {
+    auto member = replace_static_member(
+      *r.data.group_instance_id, std::move(new_member_id));
+    klog.trace("replaced static member {} of group {}", member, *this);
+    schedule_next_heartbeat_expiration(member);
+
+    switch (state()) {
+    case group_state::stable:
+        if (r.data.protocols == member->protocols()) {
+            // the instance restarted without changing its subscription, hand
+            // it back the current generation. the leader gets the member
+            // metadata so it can still act on topic metadata changes.
+            klog.trace("static member rejoined stable group");
+            std::vector<member_config> members;
+            if (is_leader(member->id())) {
+                members = member_metadata();
+            }
+            join_group_response response(
+              error_code::none,
+              generation(),
+              protocol().value_or(protocol_name("")),
+              leader().value_or(kafka::member_id("")),
+              member->id(),
+              std::move(members));
+            return ss::make_ready_future<join_group_response>(
+              std::move(response));
+        }
+        return update_member_and_rebalance(member, std::move(r));
+
+    case group_state::completing_rebalance:
+        // <kafka>if the group is in after-sync stage, upon getting a new join
+        // request from a known static member, we should still trigger a new
+        // rebalance, since the old member may already be sent out with an
+        // assignment.</kafka>
+        [[fallthrough]];
+
+    case group_state::preparing_rebalance:
+        return update_member_and_rebalance(member, std::move(r));
+
+    case group_state::empty:
+        [[fallthrough]];
+
+    case group_state::dead:
+        klog.trace("static member rejoin in unexpected state {}", state());
+        return make_join_error(member->id(), error_code::unknown_member_id);
+
+    default:
+        std::terminate(); // make gcc happy
+    }
+}
+
+member_ptr group::replace_static_member(
+  const kafka::group_instance_id& instance_id, kafka::member_id new_member_id) {
+    auto old = get_member(_static_members.at(instance_id));
+
+    // the old instance may still be waiting on a join or sync response, it is
+    // fenced so it never acts on an assignment meant for its replacement.
+    old->expire_timer().cancel();
+    try_finish_joining_member(
+      old, _make_join_error(old->id(), error_code::fenced_instance_id));
+    if (old->is_syncing()) {
+        old->set_sync_response(
+          sync_group_response(error_code::fenced_instance_id));
+    }
+
+    auto member = ss::make_lw_shared<group_member>(
+      std::move(new_member_id),
+      id(),
+      instance_id,
+      old->session_timeout(),
+      old->rebalance_timeout(),
+      old->protocol_type(),
+      old->protocols());
+    member->set_assignment(old->assignment());
+
+    for (auto& p : old->protocols()) {
+        auto& count = _supported_protocols[p.name];
+        --count;
+        vassert(count >= 0, "supported protocols cannot be negative");
+    }
+    if (is_leader(old->id())) {
+        _leader = member->id();
+    }
+    _members.erase(old->id());
+    add_member_no_join(member);
+    return member;
+}
+
+void group::remove_static_member(const member_ptr& member) {
+    if (!member->group_instance_id()) {
+        return;
+    }
+    auto it = _static_members.find(*member->group_instance_id());
+    if (it != _static_members.end() && it->second == member->id()) {
+        _static_members.erase(it);
+    }
+}
+
+bool group::is_fenced_instance(
+  const std::optional<kafka::group_instance_id>& instance_id,
+  const kafka::member_id& member_id) const {
+    if (!instance_id) {
+        return false;
+    }
+    auto it = _static_members.find(*instance_id);
+    return it != _static_members.end() && it->second != member_id;
+}
+
 ss::future<join_group_response>
 group::update_member_and_rebalance(member_ptr member, join_group_request&& r) {
     auto response = update_member(member, r.native_member_protocols());
@@ -704,6 +840,7 @@ void group::complete_join() {
             }
 
             auto leader = is_leader(it->second->id());
+            remove_static_member(it->second);
             _members.erase(it++);
 
             if (leader) {
@@ -824,10 +961,9 @@ void group::schedule_next_heartbeat_expiration(member_ptr member) {
     auto now = clock_type::now();
     member->set_latest_heartbeat(now);
     auto deadline = now + member->session_timeout();
-    member->expire_timer().set_callback(
-      [this, deadline, member_id = member->id()]() {
-          heartbeat_expire(member_id, deadline);
-      });
+    member->expire_timer().set_callback([this, m = member.get()]() {
+        heartbeat_expire(m->id(), m->expire_timer().get_timeout());
+    });
     member->expire_timer().arm(deadline);
 }
 
@@ -864,6 +1000,7 @@ void group::remove_member(member_ptr member) {
             }
         }
         vlog(klog.trace, "removing member {}", member->id());
+        remove_static_member(member);
         _members.erase(it);
     }
 
@@ -909,6 +1046,11 @@ group::handle_sync_group(sync_group_request&& r) {
         klog.trace("group is dead");
         return make_sync_error(error_code::coordinator_not_available);
 
+    } else if (is_fenced_instance(
+                 r.data.group_instance_id, r.data.member_id)) {
+        klog.trace("static member was replaced by a newer instance");
+        return make_sync_error(error_code::fenced_instance_id);
+
     } else if (!contains_member(r.data.member_id)) {
         klog.trace("member not found");
         return make_sync_error(error_code::unknown_member_id);
@@ -1076,6 +1218,11 @@ ss::future<heartbeat_response> group::handle_heartbeat(heartbeat_request&& r) {
         klog.trace("group is dead");
         return make_heartbeat_error(error_code::coordinator_not_available);
 
+    } else if (is_fenced_instance(
+                 r.data.group_instance_id, r.data.member_id)) {
+        klog.trace("static member was replaced by a newer instance");
+        return make_heartbeat_error(error_code::fenced_instance_id);
+
     } else if (!contains_member(r.data.member_id)) {
         klog.trace("member not found");
         return make_heartbeat_error(error_code::unknown_member_id);
@@ -1174,9 +1321,7 @@ void group::fail_offset_commit(
 
 ss::future<offset_commit_response>
 group::store_offsets(offset_commit_request&& r) {
-    cluster::simple_batch_builder builder(
-      raft::data_batch_type, model::offset(0));
-
+    std::vector<offset_commit_batcher::record> records;
     std::vector<std::pair<model::topic_partition, offset_metadata>>
       offset_commits;
 
@@ -1195,7 +1340,10 @@ group::store_offsets(offset_commit_request&& r) {
               p.committed_leader_epoch,
               p.committed_metadata,
             };
-            builder.add_kv(std::move(key), std::move(val));
+            records.push_back(offset_commit_batcher::record{
+              .key = reflection::to_iobuf(std::move(key)),
+              .value = reflection::to_iobuf(std::move(val)),
+            });
 
             model::topic_partition tp(t.name, p.partition_index);
             offset_metadata md{
@@ -1211,13 +1359,9 @@ group::store_offsets(offset_commit_request&& r) {
         }
     }
 
-    auto batch = std::move(builder).build();
-    auto reader = model::make_memory_record_batch_reader(std::move(batch));
-
-    return _partition
-      ->replicate(
-        std::move(reader),
-        raft::replicate_options(raft::consistency_level::quorum_ack))
+    // batched with the commits of the other groups of the partition,
+    // last_offset of the result is the one of the last record of this request
+    return _commit_batcher->replicate(std::move(records))
       .then([this, req = std::move(r), commits = std::move(offset_commits)](
               result<raft::replicate_result> r) mutable {
           error_code error = r ? error_code::none : error_code::not_coordinator;
@@ -1250,6 +1394,11 @@ group::handle_offset_commit(offset_commit_request&& r) {
         // <kafka>The group is only using Kafka to store offsets.</kafka>
         return store_offsets(std::move(r));
 
+    } else if (is_fenced_instance(
+                 r.data.group_instance_id, r.data.member_id)) {
+        return ss::make_ready_future<offset_commit_response>(
+          offset_commit_response(r, error_code::fenced_instance_id));
+
     } else if (!contains_member(r.data.member_id)) {
         return ss::make_ready_future<offset_commit_response>(
           offset_commit_response(r, error_code::unknown_member_id));
@@ -14,6 +14,7 @@
 #include "config/configuration.h"
 #include "kafka/errors.h"
 #include "kafka/groups/member.h"
+#include "kafka/groups/offset_commit_batcher.h"
 #include "kafka/logger.h"
 #include "kafka/requests/heartbeat_request.h"
 #include "kafka/requests/join_group_request.h"
@@ -116,14 +117,16 @@ public:
       kafka::group_id id,
       group_state s,
       config::configuration& conf,
-      ss::lw_shared_ptr<cluster::partition> partition);
+      ss::lw_shared_ptr<cluster::partition> partition,
+      ss::lw_shared_ptr<offset_commit_batcher> commit_batcher = nullptr);
 
     // constructor used when loading state from log
     group(
       kafka::group_id id,
       group_log_group_metadata& md,
       config::configuration& conf,
-      ss::lw_shared_ptr<cluster::partition> partition);
+      ss::lw_shared_ptr<cluster::partition> partition,
+      ss::lw_shared_ptr<offset_commit_batcher> commit_batcher = nullptr);
 
     /// Get the group id.
     const kafka::group_id& id() const { return _id; }
@@ -190,6 +193,16 @@ public:
 
     void remove_pending_member(const kafka::member_id& member_id);
 
+    /**
+     * \brief Check if a static member was replaced by a newer instance.
+     *
+     * Returns true when the instance id is registered with another member id,
+     * requests of the fenced member must then fail with fenced_instance_id.
+     */
+    bool is_fenced_instance(
+      const std::optional<kafka::group_instance_id>& instance_id,
+      const kafka::member_id& member_id) const;
+
     /// Check if a member id refers to the group leader.
     bool is_leader(const kafka::member_id& member_id) const {
         return _leader && _leader.value() == member_id;
@@ -342,6 +355,17 @@ public:
     ss::future<join_group_response> add_member_and_rebalance(
       kafka::member_id member_id, join_group_request&& request);
 
+    /**
+     * \brief Replace a static member rejoining with an unknown member id.
+     *
+     * The member takes a new id and keeps the assignment of the instance.
+     * A stable group is not rebalanced unless the member's protocols changed,
+     * so a restarted static member gets back its partitions without moving
+     * those of the other members.
+     */
+    ss::future<join_group_response> update_static_member_and_rebalance(
+      kafka::member_id new_member_id, join_group_request&& request);
+
     /// Update an existing member and rebalance.
     ss::future<join_group_response> update_member_and_rebalance(
       member_ptr member, join_group_request&& request);
@@ -391,6 +415,11 @@ public:
         return std::nullopt;
     }
 
+    const absl::flat_hash_map<model::topic_partition, offset_metadata>&
+    offsets() const {
+        return _offsets;
+    }
+
     void complete_offset_commit(
       const model::topic_partition& tp, const offset_metadata& md);
 
@@ -420,6 +449,14 @@ private:
 
     model::record_batch checkpoint(const assignments_type& assignments);
 
+    /// Swap the member registered for a static instance with a new member id
+    member_ptr replace_static_member(
+      const kafka::group_instance_id& instance_id,
+      kafka::member_id new_member_id);
+
+    /// Drop the static instance registration of a member being removed
+    void remove_static_member(const member_ptr& member);
+
     kafka::group_id _id;
     group_state _state;
     clock_type::time_point _state_timestamp;
@@ -428,13 +465,18 @@ private:
     member_map _members;
     int _num_members_joining;
     absl::flat_hash_set<kafka::member_id> _pending_members;
+    // static members, by group.instance.id
+    absl::flat_hash_map<kafka::group_instance_id, kafka::member_id>
+      _static_members;
     std::optional<kafka::protocol_type> _protocol_type;
     std::optional<kafka::protocol_name> _protocol;
     std::optional<kafka::member_id> _leader;
-    ss::timer<clock_type> _join_timer;
+    group_member::timer_type _join_timer;
     bool _new_member_added;
     config::configuration& _conf;
     ss::lw_shared_ptr<cluster::partition> _partition;
+    // shared by the groups of the partition
+    ss::lw_shared_ptr<offset_commit_batcher> _commit_batcher;
     absl::flat_hash_map<model::topic_partition, offset_metadata> _offsets;
     absl::flat_hash_map<model::topic_partition, offset_metadata>
       _pending_offset_commits;
@@ -10,13 +10,18 @@
 #include "kafka/groups/group_manager.h"
 
 #include "cluster/simple_batch_builder.h"
+#include "kafka/groups/group_snapshot.h"
 #include "kafka/requests/delete_groups_request.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/offset_commit_request.h"
 #include "kafka/requests/offset_fetch_request.h"
 #include "model/record.h"
+#include "prometheus/prometheus_sanitize.h"
 #include "resource_mgmt/io_priority.h"
 
+#include <seastar/core/future-util.hh>
+#include <seastar/core/metrics.hh>
+
 namespace kafka {
 
 ss::future<> group_manager::start() {
@@ -46,23 +51,35 @@ ss::future<> group_manager::start() {
       cluster::kafka_group_topic,
       [this](ss::lw_shared_ptr<cluster::partition> p) { attach_partition(p); });
 
+    setup_metrics();
+    _snapshot_timer.arm_periodic(_conf.group_snapshot_interval_ms());
+    if (!_conf.disable_metrics()) {
+        _lag_timer.arm_periodic(_conf.group_lag_metrics_interval_ms());
+    }
     return ss::make_ready_future<>();
 }
 
 ss::future<> group_manager::stop() {
     _pm.local().unregister_manage_notification(_manage_notify_handle);
     _gm.local().unregister_leadership_notification(_leader_notify_handle);
+    _snapshot_timer.cancel();
+    _lag_timer.cancel();
 
     for (auto& e : _partitions) {
         e.second->as.request_abort();
     }
 
-    return _gate.close();
+    return _gate.close().then([this] {
+        return ss::parallel_for_each(_partitions, [](auto& e) {
+            return e.second->commit_batcher->stop();
+        });
+    });
 }
 
 void group_manager::attach_partition(ss::lw_shared_ptr<cluster::partition> p) {
     klog.debug("attaching group metadata partition {}", p->ntp());
-    auto attached = ss::make_lw_shared<attached_partition>(p);
+    auto attached = ss::make_lw_shared<attached_partition>(
+      p, _conf.group_offset_commit_batch_window_ms());
     auto res = _partitions.try_emplace(p->ntp(), attached);
     // TODO: this is not a forever assertion. this should just generally never
     // happen _now_ because we don't support partition migration / removal.
@@ -120,55 +137,294 @@ ss::future<> group_manager::handle_partition_leader_change(
         auto timeout
           = ss::lowres_clock::now()
             + config::shard_local_cfg().kafka_group_recovery_timeout_ms();
+        auto started = ss::lowres_clock::now();
         /*
          * we just became leader. make sure the log is up-to-date. see
          * struct group_log_record_key{} for more details.
          */
-        return inject_noop(p->partition, timeout).then([this, timeout, p] {
-            /*
-             * the full log is read and deduplicated. the dedupe processing is
-             * based on the record keys, so this code should be ready to
-             * transparently take advantage of key-based compaction in the
-             * future.
-             */
-            storage::log_reader_config reader_config(
-              p->partition->start_offset(),
-              model::model_limits<model::offset>::max(),
-              0,
-              std::numeric_limits<size_t>::max(),
-              kafka_read_priority(),
-              raft::data_batch_type,
-              std::nullopt,
-              std::nullopt);
-
-            return p->partition->make_reader(reader_config)
-              .then([this, p, timeout](model::record_batch_reader reader) {
-                  return std::move(reader)
-                    .consume(recovery_batch_consumer(&p->as), timeout)
-                    .then([this, p](recovery_batch_consumer ctx) {
-                        // avoid trying to recover if we stopped the reader
-                        // because an abort was requested
-                        if (p->as.abort_requested()) {
-                            return ss::make_ready_future<>();
-                        }
-                        return recover_partition(p->partition, std::move(ctx))
-                          .then([p] { p->loading = false; });
-                    });
-              });
-        });
+        return inject_noop(p->partition, timeout)
+          .then([this, timeout, p] {
+              return read_partition_state(p, timeout);
+          })
+          .then([this, p, started](recovery_batch_consumer ctx) {
+              // avoid trying to recover if we stopped the reader
+              // because an abort was requested
+              if (p->as.abort_requested()) {
+                  return ss::make_ready_future<>();
+              }
+              return recover_partition(p, std::move(ctx))
+                .then([this, p, started] {
+                    p->loading = false;
+                    _last_load_time
+                      = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        ss::lowres_clock::now() - started);
+                    _load_time_ms += _last_load_time.count();
+                    ++_loads;
+                    vlog(
+                      klog.info,
+                      "Loaded groups of {} in {}ms",
+                      p->partition->ntp(),
+                      _last_load_time.count());
+                });
+          });
     } else {
         // TODO: we are not yet handling group / partition deletion
         return ss::make_ready_future<>();
     }
 }
 
+ss::future<recovery_batch_consumer> group_manager::read_partition_state(
+  ss::lw_shared_ptr<attached_partition> p,
+  model::timeout_clock::time_point timeout) {
+    return ss::do_with(
+      recovery_batch_consumer(&p->as),
+      [p, timeout](recovery_batch_consumer& ctx) {
+          return load_group_snapshot(p->snapshots, ctx)
+            .handle_exception([p, &ctx](std::exception_ptr e) {
+                vlog(
+                  klog.warn,
+                  "Ignoring group snapshot of {}, replaying the whole log: {}",
+                  p->partition->ntp(),
+                  e);
+                ctx = recovery_batch_consumer(&p->as);
+                return std::optional<model::offset>();
+            })
+            .then([p, timeout, &ctx](std::optional<model::offset> last) {
+                /*
+                 * the log following the snapshot is read and deduplicated. the
+                 * dedupe processing is based on the record keys, so this code
+                 * should be ready to transparently take advantage of key-based
+                 * compaction in the future.
+                 */
+                auto start = p->partition->start_offset();
+                if (last) {
+                    start = std::max(start, *last + model::offset(1));
+                }
+                storage::log_reader_config reader_config(
+                  start,
+                  model::model_limits<model::offset>::max(),
+                  0,
+                  std::numeric_limits<size_t>::max(),
+                  kafka_read_priority(),
+                  raft::data_batch_type,
+                  std::nullopt,
+                  std::nullopt);
+                return p->partition->make_reader(reader_config)
+                  .then([timeout, &ctx](model::record_batch_reader reader) {
+                      return std::move(reader).consume(
+                        std::move(ctx), timeout);
+                  });
+            });
+      });
+}
+
+void group_manager::snapshot_partitions() {
+    if (_gate.is_closed()) {
+        return;
+    }
+    (void)ss::with_gate(_gate, [this] {
+        std::vector<ss::lw_shared_ptr<attached_partition>> partitions;
+        partitions.reserve(_partitions.size());
+        for (auto& e : _partitions) {
+            partitions.push_back(e.second);
+        }
+        return ss::do_with(std::move(partitions), [this](auto& partitions) {
+            return ss::do_for_each(partitions, [this](auto& p) {
+                return snapshot_partition(p).handle_exception(
+                  [p](std::exception_ptr e) {
+                      vlog(
+                        klog.warn,
+                        "Failed to snapshot groups of {}: {}",
+                        p->partition->ntp(),
+                        e);
+                  });
+            });
+        });
+    });
+}
+
+ss::future<>
+group_manager::snapshot_partition(ss::lw_shared_ptr<attached_partition> p) {
+    return ss::with_semaphore(p->sem, 1, [this, p] {
+        auto committed = p->partition->committed_offset();
+        // nothing was committed since the last snapshot
+        if (
+          p->as.abort_requested()
+          || p->snapshot_committed_offset == committed) {
+            return ss::make_ready_future<>();
+        }
+        return read_partition_state(p, model::no_timeout)
+          .then([this, p, committed](recovery_batch_consumer ctx) {
+              if (
+                p->as.abort_requested()
+                || ctx.last_offset < model::offset(0)) {
+                  return ss::make_ready_future<>();
+              }
+              return ss::do_with(
+                std::move(ctx), [this, p, committed](auto& ctx) {
+                    return write_group_snapshot(p->snapshots, ctx)
+                      .then([this, p, committed] {
+                          p->snapshot_committed_offset = committed;
+                          ++_snapshots;
+                      });
+                });
+          });
+    });
+}
+
+void group_manager::update_lag() {
+    // a slow update is not stacked up with the next one
+    if (_updating_lag || _gate.is_closed()) {
+        return;
+    }
+    _updating_lag = true;
+    (void)ss::with_gate(_gate, [this] {
+        absl::flat_hash_set<model::ntp> ntps;
+        for (const auto& [_, g] : _groups) {
+            for (const auto& e : g->offsets()) {
+                ntps.emplace(cluster::kafka_namespace, e.first);
+            }
+        }
+        return end_offsets(std::move(ntps))
+          .then([this](end_offsets_t end) { apply_lag(end); })
+          .handle_exception([](const std::exception_ptr& e) {
+              vlog(klog.warn, "Error updating consumer group lag - {}", e);
+          })
+          .finally([this] { _updating_lag = false; });
+    });
+}
+
+ss::future<group_manager::end_offsets_t>
+group_manager::end_offsets(absl::flat_hash_set<model::ntp> ntps) {
+    return ss::do_with(std::move(ntps), [this](const auto& ntps) {
+        return _pm.map_reduce0(
+          [&ntps](cluster::partition_manager& pm) {
+              end_offsets_t ret;
+              for (const auto& ntp : ntps) {
+                  // the offset consumers see as the latest one in the
+                  // response to list offsets, lag matches what they compute
+                  if (auto p = pm.get(ntp); p) {
+                      ret.emplace(ntp, p->last_stable_offset());
+                  }
+              }
+              return ret;
+          },
+          end_offsets_t{},
+          [](end_offsets_t acc, end_offsets_t offsets) {
+              acc.merge(std::move(offsets));
+              return acc;
+          });
+    });
+}
+
+void group_manager::apply_lag(const end_offsets_t& end) {
+    for (auto it = _lag.begin(); it != _lag.end();) {
+        if (!_groups.contains(it->first)) {
+            _lag.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& [id, g] : _groups) {
+        auto& lag = _lag[id];
+        if (!lag) {
+            lag = std::make_unique<group_lag>();
+        }
+        bool changed = false;
+        const auto& offsets = g->offsets();
+        // partitions of deleted offsets or no longer hosted by the node
+        for (auto it = lag->partitions.begin(); it != lag->partitions.end();) {
+            model::ntp ntp(cluster::kafka_namespace, it->first);
+            if (!offsets.contains(it->first) || !end.contains(ntp)) {
+                lag->partitions.erase(it++);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+        for (const auto& [tp, md] : offsets) {
+            auto e = end.find(model::ntp(cluster::kafka_namespace, tp));
+            if (e == end.end()) {
+                continue;
+            }
+            const auto value = std::max<int64_t>(0, e->second() - md.offset());
+            auto [it, inserted] = lag->partitions.try_emplace(tp, value);
+            if (inserted) {
+                changed = true;
+            } else {
+                it->second = value;
+            }
+        }
+        if (changed) {
+            setup_lag_metrics(id, *lag);
+        }
+    }
+}
+
+void group_manager::setup_lag_metrics(const group_id& id, group_lag& lag) {
+    namespace sm = ss::metrics;
+    lag.metrics.clear();
+    if (lag.partitions.empty()) {
+        return;
+    }
+    auto group_label = sm::label("group");
+    auto topic_label = sm::label("topic");
+    auto partition_label = sm::label("partition");
+    std::vector<sm::metric_definition> defs;
+    defs.reserve(lag.partitions.size());
+    for (const auto& [tp, value] : lag.partitions) {
+        const std::vector<sm::label_instance> labels = {
+          group_label(id()),
+          topic_label(tp.topic()),
+          partition_label(tp.partition())};
+        defs.push_back(sm::make_gauge(
+          "lag",
+          [&value = value] { return value; },
+          sm::description("Offsets between the committed offset of the group "
+                          "and the end of the partition"),
+          labels));
+    }
+    lag.metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:consumer_group"),
+      std::move(defs));
+}
+
+void group_manager::setup_metrics() {
+    if (_conf.disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:group_recovery"),
+      {
+        sm::make_gauge(
+          "last_load_time_ms",
+          [this] { return _last_load_time.count(); },
+          sm::description("Time the last recovery of a group metadata "
+                          "partition took")),
+        sm::make_derive(
+          "load_time_ms",
+          [this] { return _load_time_ms; },
+          sm::description("Total time spent recovering group metadata "
+                          "partitions")),
+        sm::make_derive(
+          "loads",
+          [this] { return _loads; },
+          sm::description("Number of group metadata partition recoveries")),
+        sm::make_derive(
+          "snapshots",
+          [this] { return _snapshots; },
+          sm::description("Number of group metadata snapshots written")),
+      });
+}
+
 /*
  * TODO: this routine can be improved from a copy vs move perspective, but is
  * rather complicated at the moment to start having to also analyze all the data
  * dependencies that would support optimizing for moves.
  */
 ss::future<> group_manager::recover_partition(
-  ss::lw_shared_ptr<cluster::partition> p, recovery_batch_consumer ctx) {
+  ss::lw_shared_ptr<attached_partition> p, recovery_batch_consumer ctx) {
     /*
      * [group-id -> [topic-partition -> offset-metadata]]
      */
@@ -206,7 +462,8 @@ ss::future<> group_manager::recover_partition(
             continue;
         }
 
-        group = ss::make_lw_shared<kafka::group>(e.first, e.second, _conf, p);
+        group = ss::make_lw_shared<kafka::group>(
+          e.first, e.second, _conf, p->partition, p->commit_batcher);
 
         for (auto& e : offsets) {
             group->insert_offset(
@@ -230,7 +487,11 @@ ss::future<> group_manager::recover_partition(
         }
 
         group = ss::make_lw_shared<kafka::group>(
-          e.first, group_state::empty, _conf, p);
+          e.first,
+          group_state::empty,
+          _conf,
+          p->partition,
+          p->commit_batcher);
 
         for (auto& e : e.second) {
             group->insert_offset(
@@ -276,25 +537,28 @@ recovery_batch_consumer::operator()(model::record_batch batch) {
           ss::stop_iteration::yes);
     }
     batch_base_offset = batch.base_offset();
+    last_offset = batch.last_offset();
     return ss::do_with(
              std::move(batch),
              [this](model::record_batch& batch) {
-                 return model::for_each_record(batch, [this](model::record& r) {
-                     return handle_record(std::move(r));
-                 });
+                 return model::async_for_each_record_view(
+                   batch, [this](const model::record_view& r) {
+                       return handle_record(r);
+                   });
              })
       .then([] { return ss::stop_iteration::no; });
 }
 
-ss::future<> recovery_batch_consumer::handle_record(model::record r) {
-    auto key = reflection::adl<group_log_record_key>{}.from(r.share_key());
+ss::future<>
+recovery_batch_consumer::handle_record(const model::record_view& r) {
+    auto key = reflection::adl<group_log_record_key>{}.from(r.copy_key());
 
     switch (key.record_type) {
     case group_log_record_key::type::group_metadata:
-        return handle_group_metadata(std::move(key.key), r.release_value());
+        return handle_group_metadata(std::move(key.key), r.copy_value());
 
     case group_log_record_key::type::offset_commit:
-        return handle_offset_metadata(std::move(key.key), r.release_value());
+        return handle_offset_metadata(std::move(key.key), r.copy_value());
 
     case group_log_record_key::type::noop:
         // skip control structure
@@ -407,9 +671,13 @@ group_manager::join_group(join_group_request&& r) {
             return make_join_error(
               r.data.member_id, error_code::not_coordinator);
         }
-        auto p = it->second->partition;
+        auto& p = it->second;
         group = ss::make_lw_shared<kafka::group>(
-          r.data.group_id, group_state::empty, _conf, p);
+          r.data.group_id,
+          group_state::empty,
+          _conf,
+          p->partition,
+          p->commit_batcher);
         _groups.emplace(r.data.group_id, group);
         klog.trace("created new group {}", group);
         is_new_group = true;
@@ -422,11 +690,6 @@ ss::future<sync_group_response>
 group_manager::sync_group(sync_group_request&& r) {
     klog.trace("sync request {}", r);
 
-    if (r.data.group_instance_id) {
-        klog.trace("static group membership is unsupported");
-        return make_sync_error(error_code::unsupported_version);
-    }
-
     auto error = validate_group_status(
       r.ntp, r.data.group_id, sync_group_api::key);
     if (error != error_code::none) {
@@ -456,11 +719,6 @@ group_manager::sync_group(sync_group_request&& r) {
 ss::future<heartbeat_response> group_manager::heartbeat(heartbeat_request&& r) {
     klog.trace("heartbeat request {}", r);
 
-    if (r.data.group_instance_id) {
-        klog.trace("static group membership is unsupported");
-        return make_heartbeat_error(error_code::unsupported_version);
-    }
-
     auto error = validate_group_status(
       r.ntp, r.data.group_id, heartbeat_api::key);
     if (error != error_code::none) {
@@ -516,9 +774,13 @@ group_manager::offset_commit(offset_commit_request&& r) {
         if (r.data.generation_id < 0) {
             // <kafka>the group is not relying on Kafka for group management, so
             // allow the commit</kafka>
-            auto p = _partitions.find(r.ntp)->second->partition;
+            auto& p = _partitions.find(r.ntp)->second;
             group = ss::make_lw_shared<kafka::group>(
-              r.data.group_id, group_state::empty, _conf, p);
+              r.data.group_id,
+              group_state::empty,
+              _conf,
+              p->partition,
+              p->commit_batcher);
             _groups.emplace(r.data.group_id, group);
         } else {
             // <kafka>or this is a request coming from an older generation.
@@ -540,13 +802,33 @@ group_manager::offset_fetch(offset_fetch_request&& r) {
           offset_fetch_response(error));
     }
 
-    auto group = get_group(r.data.group_id);
-    if (!group) {
-        return ss::make_ready_future<offset_fetch_response>(
-          offset_fetch_response(r.data.topics));
-    }
-
-    return group->handle_offset_fetch(std::move(r));
+    /*
+     * a node that lost leadership of the partition without noticing yet may
+     * still hold the group, the committed offsets are only returned once the
+     * node is known to be the coordinator. this does not wait while the
+     * leader lease holds.
+     */
+    auto partition = _partitions.find(r.ntp)->second->partition;
+    auto deadline = raft::clock_type::now()
+                    + config::shard_local_cfg().raft_election_timeout_ms();
+    return partition->linearizable_barrier(deadline).then(
+      [this, r = std::move(r)](result<model::offset> barrier) mutable {
+          if (!barrier) {
+              klog.trace(
+                "group partition is not confirmed leader {}/{}: {}",
+                r.data.group_id,
+                r.ntp,
+                barrier.error().message());
+              return ss::make_ready_future<offset_fetch_response>(
+                offset_fetch_response(error_code::not_coordinator));
+          }
+          auto group = get_group(r.data.group_id);
+          if (!group) {
+              return ss::make_ready_future<offset_fetch_response>(
+                offset_fetch_response(r.data.topics));
+          }
+          return group->handle_offset_fetch(std::move(r));
+      });
 }
 
 std::pair<bool, std::vector<listed_group>> group_manager::list_groups() const {
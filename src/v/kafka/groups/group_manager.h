@@ -17,6 +17,7 @@
 #include "kafka/errors.h"
 #include "kafka/groups/group.h"
 #include "kafka/groups/member.h"
+#include "kafka/groups/offset_commit_batcher.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/heartbeat_request.h"
 #include "kafka/requests/join_group_request.h"
@@ -25,14 +26,21 @@
 #include "kafka/requests/offset_commit_request.h"
 #include "kafka/requests/offset_fetch_request.h"
 #include "kafka/requests/sync_group_request.h"
+#include "model/record_view.h"
 #include "raft/group_manager.h"
+#include "resource_mgmt/io_priority.h"
 #include "seastarx.h"
+#include "storage/snapshot.h"
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/future.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/container/node_hash_map.h>
 #include <cluster/partition_manager.h>
 
 namespace kafka {
@@ -96,6 +104,16 @@ struct recovery_batch_consumer;
  * After the log is read the deduplicated state is used to re-populate the
  * in-memory cache of groups/commits through.
  *
+ * Snapshots (background)
+ * ======================
+ *
+ * Every group_snapshot_interval_ms each replica of an attached partition
+ * seeds a recovery_batch_consumer with its latest snapshot, replays the
+ * committed batches that follow it and writes the result as the new snapshot.
+ * Recovery then starts from the snapshot and only replays the tail of the
+ * log. Snapshots are taken while holding the partition semaphore so they
+ * never race with recovery.
+ *
  * Unload (background)
  * ===================
  *
@@ -117,7 +135,9 @@ public:
       : _gm(gm)
       , _pm(pm)
       , _conf(conf)
-      , _self(cluster::make_self_broker(config::shard_local_cfg())) {}
+      , _self(cluster::make_self_broker(config::shard_local_cfg()))
+      , _snapshot_timer([this] { snapshot_partitions(); })
+      , _lag_timer([this] { update_lag(); }) {}
 
     ss::future<> start();
     ss::future<> stop();
@@ -174,10 +194,28 @@ private:
         ss::semaphore sem{1};
         ss::abort_source as;
         ss::lw_shared_ptr<cluster::partition> partition;
-
-        attached_partition(ss::lw_shared_ptr<cluster::partition> p)
+        ss::lw_shared_ptr<offset_commit_batcher> commit_batcher;
+        storage::snapshot_manager snapshots;
+        // committed offset of the partition when the snapshot was taken
+        std::optional<model::offset> snapshot_committed_offset;
+
+        attached_partition(
+          ss::lw_shared_ptr<cluster::partition> p,
+          std::chrono::milliseconds commit_batch_window)
           : loading(true)
-          , partition(std::move(p)) {}
+          , partition(std::move(p))
+          , commit_batcher(ss::make_lw_shared<offset_commit_batcher>(
+              [p = partition](model::record_batch_reader&& r) {
+                  return p->replicate(
+                    std::move(r),
+                    raft::replicate_options(
+                      raft::consistency_level::quorum_ack));
+              },
+              commit_batch_window))
+          , snapshots(
+              std::filesystem::path(partition->log_config().work_directory())
+                / "group_snapshot",
+              kafka_read_priority()) {}
     };
 
     absl::flat_hash_map<model::ntp, ss::lw_shared_ptr<attached_partition>>
@@ -193,7 +231,31 @@ private:
       std::optional<model::node_id> leader_id);
 
     ss::future<> recover_partition(
-      ss ::lw_shared_ptr<cluster::partition>, recovery_batch_consumer);
+      ss::lw_shared_ptr<attached_partition>, recovery_batch_consumer);
+
+    /// reads the deduplicated state of the partition from its snapshot and
+    /// the log that follows it
+    ss::future<recovery_batch_consumer> read_partition_state(
+      ss::lw_shared_ptr<attached_partition>, model::timeout_clock::time_point);
+
+    void snapshot_partitions();
+    ss::future<> snapshot_partition(ss::lw_shared_ptr<attached_partition>);
+    void setup_metrics();
+
+    /// lag of the partitions a group committed offsets for. the series of a
+    /// group are registered again only when its set of partitions changes
+    struct group_lag {
+        // node map, the gauges reference the values
+        absl::node_hash_map<model::topic_partition, int64_t> partitions;
+        ss::metrics::metric_groups metrics;
+    };
+    using end_offsets_t = absl::flat_hash_map<model::ntp, model::offset>;
+
+    void update_lag();
+    /// end offsets of the partitions hosted by the node, of any shard
+    ss::future<end_offsets_t> end_offsets(absl::flat_hash_set<model::ntp>);
+    void apply_lag(const end_offsets_t&);
+    void setup_lag_metrics(const group_id&, group_lag&);
 
     ss::future<> inject_noop(
       ss::lw_shared_ptr<cluster::partition> p,
@@ -204,6 +266,16 @@ private:
     config::configuration& _conf;
     absl::flat_hash_map<group_id, group_ptr> _groups;
     model::broker _self;
+    ss::timer<ss::lowres_clock> _snapshot_timer;
+    ss::timer<ss::lowres_clock> _lag_timer;
+    absl::flat_hash_map<group_id, std::unique_ptr<group_lag>> _lag;
+    bool _updating_lag{false};
+
+    std::chrono::milliseconds _last_load_time{0};
+    uint64_t _load_time_ms{0};
+    uint64_t _loads{0};
+    uint64_t _snapshots{0};
+    ss::metrics::metric_groups _metrics;
 };
 
 /**
@@ -290,13 +362,16 @@ struct recovery_batch_consumer {
 
     ss::future<ss::stop_iteration> operator()(model::record_batch batch);
 
-    ss::future<> handle_record(model::record);
+    ss::future<> handle_record(const model::record_view&);
     ss::future<> handle_group_metadata(iobuf key_buf, iobuf val_buf);
     ss::future<> handle_offset_metadata(iobuf key_buf, iobuf val_buf);
 
     recovery_batch_consumer end_of_stream() { return std::move(*this); }
 
     model::offset batch_base_offset;
+    // last offset of the consumed batches, or of the snapshot the consumer
+    // was seeded with
+    model::offset last_offset{-1};
 
     absl::flat_hash_map<kafka::group_id, group_log_group_metadata>
       loaded_groups;
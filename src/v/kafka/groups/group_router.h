@@ -12,6 +12,7 @@
 #pragma once
 #include "cluster/shard_table.h"
 #include "kafka/groups/coordinator_ntp_mapper.h"
+#include "kafka/groups/offset_fetch_cache.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/heartbeat_request.h"
 #include "kafka/requests/join_group_request.h"
@@ -23,6 +24,7 @@
 #include "kafka/types.h"
 #include "seastarx.h"
 
+#include <seastar/core/lowres_clock.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/scheduling.hh>
 #include <seastar/core/sharded.hh>
@@ -71,13 +73,46 @@ public:
     }
 
     auto offset_commit(offset_commit_request&& request) {
-        return route(std::move(request), &GroupMgr::offset_commit);
+        if (!_offsets.contains(request.data.group_id)) {
+            return route(std::move(request), &GroupMgr::offset_commit);
+        }
+        auto group = request.data.group_id;
+        auto topics = request.data.topics;
+        return route(std::move(request), &GroupMgr::offset_commit)
+          .then([this, group = std::move(group), topics = std::move(topics)](
+                  offset_commit_response resp) {
+              _offsets.apply(group, topics, resp);
+              return resp;
+          });
     }
 
     auto offset_fetch(offset_fetch_request&& request) {
         return route(std::move(request), &GroupMgr::offset_fetch);
     }
 
+    /// \brief committed offsets of all the partitions of the group, served
+    /// from the core local cache when they were fetched from the coordinator
+    /// at most `max_age` ago. for readers that tolerate stale offsets, the
+    /// kafka api fetches through the coordinator.
+    ss::future<offset_fetch_response>
+    cached_offset_fetch(group_id group, ss::lowres_clock::duration max_age) {
+        if (auto cached = _offsets.get(group, max_age); cached) {
+            return ss::make_ready_future<offset_fetch_response>(
+              std::move(*cached));
+        }
+        offset_fetch_request request;
+        request.data.group_id = group;
+        // no topics fetches every partition of the group
+        request.data.topics = std::nullopt;
+        return route(std::move(request), &GroupMgr::offset_fetch)
+          .then([this, group = std::move(group)](offset_fetch_response resp) {
+              if (resp.data.error_code == error_code::none) {
+                  _offsets.put(group, resp);
+              }
+              return resp;
+          });
+    }
+
     // return groups from across all shards, and if any core was still loading
     ss::future<std::pair<bool, std::vector<listed_group>>> list_groups() {
         using type = std::pair<bool, std::vector<listed_group>>;
@@ -151,6 +186,7 @@ private:
     ss::sharded<GroupMgr>& _group_manager;
     ss::sharded<cluster::shard_table>& _shards;
     ss::sharded<coordinator_ntp_mapper>& _coordinators;
+    offset_fetch_cache _offsets;
 };
 
 } // namespace kafka
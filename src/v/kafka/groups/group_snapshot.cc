@@ -0,0 +1,168 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/group_snapshot.h"
+
+#include "bytes/iobuf_parser.h"
+#include "bytes/utils.h"
+#include "hashing/crc32c.h"
+#include "kafka/logger.h"
+#include "reflection/adl.h"
+#include "vlog.h"
+
+#include <seastar/core/seastar.hh>
+
+namespace kafka {
+
+static uint32_t blob_crc(const iobuf& blob) {
+    crc32 crc;
+    crc_extend_iobuf(crc, blob);
+    return crc.value();
+}
+
+// member assignments are iobufs, metadata is not copyable
+static group_log_group_metadata copy(const group_log_group_metadata& md) {
+    group_log_group_metadata ret{
+      .protocol_type = md.protocol_type,
+      .generation = md.generation,
+      .protocol = md.protocol,
+      .leader = md.leader,
+      .state_timestamp = md.state_timestamp,
+    };
+    ret.members.reserve(md.members.size());
+    for (const auto& m : md.members) {
+        ret.members.push_back(m.copy());
+    }
+    return ret;
+}
+
+static group_snapshot make_snapshot(const recovery_batch_consumer& ctx) {
+    group_snapshot s;
+    s.groups.reserve(ctx.loaded_groups.size());
+    for (const auto& [id, md] : ctx.loaded_groups) {
+        s.groups.push_back(
+          group_snapshot_group{.id = id, .metadata = copy(md)});
+    }
+    s.removed_groups.reserve(ctx.removed_groups.size());
+    for (const auto& id : ctx.removed_groups) {
+        s.removed_groups.push_back(id);
+    }
+    s.offsets.reserve(ctx.loaded_offsets.size());
+    for (const auto& [key, e] : ctx.loaded_offsets) {
+        s.offsets.push_back(group_snapshot_offset{
+          .key = key,
+          .log_offset = e.first,
+          .metadata = e.second,
+        });
+    }
+    return s;
+}
+
+static void apply_snapshot(group_snapshot s, recovery_batch_consumer& ctx) {
+    for (auto& g : s.groups) {
+        ctx.loaded_groups.emplace(std::move(g.id), std::move(g.metadata));
+    }
+    for (auto& id : s.removed_groups) {
+        ctx.removed_groups.emplace(std::move(id));
+    }
+    for (auto& o : s.offsets) {
+        ctx.loaded_offsets.emplace(
+          std::move(o.key),
+          std::make_pair(o.log_offset, std::move(o.metadata)));
+    }
+}
+
+static ss::future<std::optional<model::offset>>
+read_snapshot(storage::snapshot_reader& reader, recovery_batch_consumer& ctx) {
+    return reader.read_metadata().then([&reader, &ctx](iobuf buf) {
+        auto md = reflection::from_iobuf<group_snapshot_metadata>(
+          std::move(buf));
+        if (md.version != group_snapshot_metadata::current_version) {
+            return ss::make_exception_future<std::optional<model::offset>>(
+              std::runtime_error(fmt::format(
+                "Unsupported group snapshot version {}", md.version)));
+        }
+        return read_iobuf_exactly(reader.input(), sizeof(int32_t))
+          .then([&reader](iobuf size_buf) {
+              iobuf_parser parser(std::move(size_buf));
+              auto size = reflection::adl<int32_t>{}.from(parser);
+              return read_iobuf_exactly(reader.input(), size);
+          })
+          .then([&ctx, md](iobuf blob) {
+              if (blob_crc(blob) != md.crc) {
+                  return ss::make_exception_future<
+                    std::optional<model::offset>>(std::runtime_error(
+                    "Group snapshot crc mismatch"));
+              }
+              apply_snapshot(
+                reflection::from_iobuf<group_snapshot>(std::move(blob)), ctx);
+              ctx.last_offset = md.last_offset;
+              return ss::make_ready_future<std::optional<model::offset>>(
+                md.last_offset);
+          });
+    });
+}
+
+ss::future<std::optional<model::offset>> load_group_snapshot(
+  storage::snapshot_manager& mgr, recovery_batch_consumer& ctx) {
+    return mgr.open_snapshot().then(
+      [&ctx](std::optional<storage::snapshot_reader> reader) {
+          if (!reader) {
+              return ss::make_ready_future<std::optional<model::offset>>(
+                std::nullopt);
+          }
+          return ss::do_with(
+            std::move(*reader), [&ctx](storage::snapshot_reader& reader) {
+                return read_snapshot(reader, ctx).finally(
+                  [&reader] { return reader.close(); });
+            });
+      });
+}
+
+ss::future<> write_group_snapshot(
+  storage::snapshot_manager& mgr, const recovery_batch_consumer& ctx) {
+    auto blob = reflection::to_iobuf(make_snapshot(ctx));
+    group_snapshot_metadata md{
+      .last_offset = ctx.last_offset,
+      .crc = blob_crc(blob),
+    };
+    iobuf data;
+    reflection::serialize(data, static_cast<int32_t>(blob.size_bytes()));
+    data.append(std::move(blob));
+
+    auto dir = mgr.snapshot_path().parent_path();
+    return ss::recursive_touch_directory(dir.string())
+      .then([&mgr] { return mgr.remove_partial_snapshots(); })
+      .then([&mgr] { return mgr.start_snapshot(); })
+      .then([&mgr, md, data = std::move(data)](
+              storage::snapshot_writer writer) mutable {
+          return ss::do_with(
+            std::move(writer),
+            [&mgr, md, data = std::move(data)](
+              storage::snapshot_writer& writer) mutable {
+                return writer.write_metadata(reflection::to_iobuf(md))
+                  .then([&writer, data = std::move(data)]() mutable {
+                      return write_iobuf_to_output_stream(
+                        std::move(data), writer.output());
+                  })
+                  .finally([&writer] { return writer.close(); })
+                  .then([&mgr, &writer] {
+                      return mgr.finish_snapshot(writer);
+                  });
+            });
+      })
+      .then([md] {
+          vlog(
+            klog.debug,
+            "Wrote group snapshot up to offset {}",
+            md.last_offset);
+      });
+}
+
+} // namespace kafka
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "kafka/groups/group_manager.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "storage/snapshot.h"
+
+#include <seastar/core/future.hh>
+
+#include <optional>
+#include <vector>
+
+namespace kafka {
+
+/**
+ * Snapshots of the deduplicated state of a group metadata partition.
+ *
+ * A snapshot holds the content of a recovery_batch_consumer after it read the
+ * partition log up to and including last_offset, so recovery can seed the
+ * consumer from the snapshot and only replay the batches that follow. Since
+ * only the latest entry of every group and offset commit survives the
+ * deduplication, a snapshot is the compacted form of the log prefix.
+ *
+ * Snapshots are taken independently by every replica, from the committed part
+ * of the log, so that the node becoming leader finds its own.
+ */
+struct group_snapshot_metadata {
+    static constexpr int8_t current_version = 1;
+
+    int8_t version{current_version};
+    model::offset last_offset;
+    // covers the snapshot blob
+    uint32_t crc;
+};
+
+struct group_snapshot_group {
+    kafka::group_id id;
+    group_log_group_metadata metadata;
+};
+
+struct group_snapshot_offset {
+    group_log_offset_key key;
+    model::offset log_offset;
+    group_log_offset_metadata metadata;
+};
+
+struct group_snapshot {
+    std::vector<group_snapshot_group> groups;
+    std::vector<kafka::group_id> removed_groups;
+    std::vector<group_snapshot_offset> offsets;
+};
+
+/// Seeds the consumer with the current snapshot, returns the last offset it
+/// includes or an empty optional if there is no snapshot
+ss::future<std::optional<model::offset>>
+load_group_snapshot(storage::snapshot_manager&, recovery_batch_consumer&);
+
+/// Replaces the current snapshot with the state of the consumer
+ss::future<> write_group_snapshot(
+  storage::snapshot_manager&, const recovery_batch_consumer&);
+
+} // namespace kafka
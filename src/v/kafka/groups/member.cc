@@ -29,6 +29,11 @@
 
 namespace kafka {
 
+timer_wheel<ss::lowres_clock>& group_timer_wheel() {
+    static thread_local timer_wheel<ss::lowres_clock> wheel;
+    return wheel;
+}
+
 [[noreturn]] [[gnu::cold]] static void
 throw_out_of_range(const ss::sstring& msg) {
     throw std::out_of_range(msg);
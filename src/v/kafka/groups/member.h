@@ -17,8 +17,10 @@
 #include "kafka/requests/sync_group_request.h"
 #include "kafka/types.h"
 #include "utils/concepts-enabled.h"
+#include "utils/timer_wheel.h"
 
 #include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
 #include <seastar/core/shared_ptr.hh>
 
 #include <absl/container/flat_hash_set.h>
@@ -75,11 +77,19 @@ struct member_state {
     }
 };
 
+/**
+ * Shard local wheel of the member session timeouts and the group join
+ * timeouts. Every heartbeat rearms the session timeout of its member, with
+ * many members per shard rearming a reactor timer each time is measurable.
+ */
+timer_wheel<ss::lowres_clock>& group_timer_wheel();
+
 /// \brief A Kafka group member.
 class group_member {
 public:
     using clock_type = ss::lowres_clock;
     using duration_type = clock_type::duration;
+    using timer_type = timer_wheel<clock_type>::timer;
 
     group_member(
       kafka::member_id member_id,
@@ -104,7 +114,8 @@ public:
     group_member(kafka::member_state state, kafka::group_id group_id)
       : _state(std::move(state))
       , _group_id(std::move(group_id))
-      , _is_new(false) {}
+      , _is_new(false)
+      , _expire_timer(group_timer_wheel()) {}
 
     const member_state& state() const { return _state; }
 
@@ -221,7 +232,7 @@ public:
         _latest_heartbeat = t;
     }
 
-    ss::timer<clock_type>& expire_timer() { return _expire_timer; }
+    timer_type& expire_timer() { return _expire_timer; }
 
     // helper for kafka api: describe groups
     described_group_member describe(const kafka::protocol_name&) const;
@@ -238,7 +249,7 @@ private:
 
     bool _is_new;
     clock_type::time_point _latest_heartbeat;
-    ss::timer<clock_type> _expire_timer;
+    timer_type _expire_timer;
 
     // external shutdown synchronization
     std::unique_ptr<sync_promise> _sync_promise;
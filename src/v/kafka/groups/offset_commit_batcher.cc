@@ -0,0 +1,115 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/offset_commit_batcher.h"
+
+#include "kafka/logger.h"
+#include "raft/errc.h"
+#include "storage/record_batch_builder.h"
+#include "vlog.h"
+
+namespace kafka {
+
+offset_commit_batcher::offset_commit_batcher(
+  replicate_fn f, std::chrono::milliseconds window, size_t max_batch_bytes)
+  : _replicate(std::move(f))
+  , _window(window)
+  , _max_batch_bytes(max_batch_bytes)
+  , _timer([this] { flush(); }) {}
+
+ss::future<result<raft::replicate_result>>
+offset_commit_batcher::replicate(std::vector<record> records) {
+    if (_gate.is_closed()) {
+        return ss::make_ready_future<result<raft::replicate_result>>(
+          raft::errc::not_leader);
+    }
+    item i{.records = std::move(records)};
+    auto f = i.done.get_future();
+    for (auto& r : i.records) {
+        _pending_bytes += r.key.size_bytes() + r.value.size_bytes();
+    }
+    _pending_records += i.records.size();
+    _pending.push_back(std::move(i));
+
+    if (_pending_bytes >= _max_batch_bytes) {
+        _timer.cancel();
+        flush();
+    } else if (!_timer.armed()) {
+        _timer.arm(_window);
+    }
+    return f;
+}
+
+void offset_commit_batcher::flush() {
+    if (_pending.empty()) {
+        return;
+    }
+    _pending_records = 0;
+    _pending_bytes = 0;
+    (void)ss::with_gate(
+      _gate, [this, items = std::exchange(_pending, {})]() mutable {
+          return do_flush(std::move(items));
+      });
+}
+
+ss::future<> offset_commit_batcher::do_flush(std::vector<item> items) {
+    storage::record_batch_builder builder(
+      raft::data_batch_type, model::offset(0));
+    // offset delta of the last record of each item
+    std::vector<int64_t> last_deltas;
+    last_deltas.reserve(items.size());
+    int64_t records = 0;
+    for (auto& i : items) {
+        for (auto& r : i.records) {
+            builder.add_raw_kv(std::move(r.key), std::move(r.value));
+        }
+        records += i.records.size();
+        last_deltas.push_back(records - 1);
+    }
+    vlog(
+      klog.trace,
+      "replicating {} offset commits in a batch of {} records",
+      items.size(),
+      records);
+    auto reader = model::make_memory_record_batch_reader(
+      std::move(builder).build());
+    return _replicate(std::move(reader))
+      .then_wrapped([items = std::move(items),
+                     last_deltas = std::move(last_deltas),
+                     records](
+                      ss::future<result<raft::replicate_result>> f) mutable {
+          if (f.failed()) {
+              auto e = f.get_exception();
+              for (auto& i : items) {
+                  i.done.set_exception(e);
+              }
+              return;
+          }
+          auto r = f.get0();
+          for (size_t n = 0; n < items.size(); ++n) {
+              if (!r) {
+                  items[n].done.set_value(r.error());
+                  continue;
+              }
+              // the last record of the merged batch is at last_offset
+              auto offset = r.value().last_offset
+                            - model::offset(records - 1 - last_deltas[n]);
+              items[n].done.set_value(
+                raft::replicate_result{.last_offset = offset});
+          }
+      });
+}
+
+ss::future<> offset_commit_batcher::stop() {
+    _timer.cancel();
+    flush();
+    return _gate.close();
+}
+
+} // namespace kafka
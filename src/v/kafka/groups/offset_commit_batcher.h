@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+#include "model/record_batch_reader.h"
+#include "outcome.h"
+#include "raft/types.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <chrono>
+#include <vector>
+
+namespace kafka {
+
+/**
+ * Merges the offset commits of the groups coordinated by one partition into
+ * shared record batches.
+ *
+ * Every offset commit request used to be replicated as a batch of its own,
+ * with many consumers committing frequently the partition spent its time on
+ * raft rounds of a few records each. Commits enqueued within the merge window
+ * of the first pending one are replicated as a single batch, each caller
+ * still gets the result of its own records: the offset of the last of them
+ * within the merged batch, so later commits of a topic partition keep
+ * winning over earlier ones when results are applied.
+ *
+ * A zero window flushes on the next reactor tick, merging only the commits
+ * that arrive while the previous tasks run.
+ */
+class offset_commit_batcher {
+public:
+    using replicate_fn = ss::noncopyable_function<
+      ss::future<result<raft::replicate_result>>(model::record_batch_reader&&)>;
+
+    struct record {
+        iobuf key;
+        iobuf value;
+    };
+
+    // a pending batch this large is flushed without waiting for the window
+    static constexpr size_t default_max_batch_bytes = 512 * 1024;
+
+    offset_commit_batcher(
+      replicate_fn,
+      std::chrono::milliseconds window,
+      size_t max_batch_bytes = default_max_batch_bytes);
+
+    /// Replicates records as part of the next merged batch
+    ss::future<result<raft::replicate_result>> replicate(std::vector<record>);
+
+    /// Flushes pending commits and waits for the in-flight batches
+    ss::future<> stop();
+
+    size_t pending_records() const { return _pending_records; }
+
+private:
+    struct item {
+        std::vector<record> records;
+        ss::promise<result<raft::replicate_result>> done;
+    };
+
+    void flush();
+    ss::future<> do_flush(std::vector<item>);
+
+    replicate_fn _replicate;
+    std::chrono::milliseconds _window;
+    size_t _max_batch_bytes;
+    std::vector<item> _pending;
+    size_t _pending_records{0};
+    size_t _pending_bytes{0};
+    ss::timer<> _timer;
+    ss::gate _gate;
+};
+
+} // namespace kafka
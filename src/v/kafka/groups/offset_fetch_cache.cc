@@ -0,0 +1,128 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/offset_fetch_cache.h"
+
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+
+#include <seastar/core/metrics.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <algorithm>
+
+namespace kafka {
+
+offset_fetch_cache::offset_fetch_cache() { register_metrics(); }
+
+std::optional<offset_fetch_response>
+offset_fetch_cache::get(const group_id& group, clock_type::duration max_age) {
+    auto it = _entries.find(group);
+    if (
+      it == _entries.end()
+      || it->second.fetched_at + max_age < clock_type::now()) {
+        ++_misses;
+        return std::nullopt;
+    }
+    ++_hits;
+    absl::flat_hash_map<
+      model::topic,
+      std::vector<offset_fetch_response_partition>>
+      topics;
+    for (const auto& [tp, p] : it->second.offsets) {
+        topics[tp.topic].push_back(p);
+    }
+    offset_fetch_response resp(error_code::none);
+    resp.data.topics.reserve(topics.size());
+    for (auto& [name, partitions] : topics) {
+        resp.data.topics.push_back(offset_fetch_response_topic{
+          .name = name,
+          .partitions = std::move(partitions),
+        });
+    }
+    return resp;
+}
+
+void offset_fetch_cache::put(
+  const group_id& group, const offset_fetch_response& resp) {
+    if (!_entries.contains(group) && _entries.size() >= max_groups) {
+        // monitoring scrapes every group in turn, the one fetched the
+        // longest ago is the next one to be fetched again anyway
+        auto oldest = std::min_element(
+          _entries.begin(), _entries.end(), [](const auto& a, const auto& b) {
+              return a.second.fetched_at < b.second.fetched_at;
+          });
+        _entries.erase(oldest);
+    }
+    entry e{.fetched_at = clock_type::now()};
+    for (const auto& t : resp.data.topics) {
+        for (const auto& p : t.partitions) {
+            if (p.error_code == error_code::none) {
+                e.offsets.emplace(
+                  model::topic_partition(t.name, p.partition_index), p);
+            }
+        }
+    }
+    _entries.insert_or_assign(group, std::move(e));
+}
+
+void offset_fetch_cache::apply(
+  const group_id& group,
+  const std::vector<offset_commit_request_topic>& topics,
+  const offset_commit_response& resp) {
+    auto it = _entries.find(group);
+    if (it == _entries.end()) {
+        return;
+    }
+    auto& offsets = it->second.offsets;
+    // responses list the topics and partitions in the order of the request
+    for (size_t i = 0; i < topics.size() && i < resp.data.topics.size(); ++i) {
+        const auto& requested = topics[i].partitions;
+        const auto& results = resp.data.topics[i].partitions;
+        for (size_t j = 0; j < requested.size() && j < results.size(); ++j) {
+            const auto& p = requested[j];
+            if (results[j].error_code != error_code::none) {
+                continue;
+            }
+            offsets.insert_or_assign(
+              model::topic_partition(topics[i].name, p.partition_index),
+              offset_fetch_response_partition{
+                .partition_index = p.partition_index,
+                .committed_offset = p.committed_offset,
+                .metadata = p.committed_metadata.value_or(""),
+                .error_code = error_code::none,
+              });
+        }
+    }
+}
+
+void offset_fetch_cache::register_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:offset_fetch_cache"),
+      {sm::make_gauge(
+         "groups_count",
+         [this] { return _entries.size(); },
+         sm::description("Number of groups with cached committed offsets")),
+       sm::make_derive(
+         "hits",
+         [this] { return _hits; },
+         sm::description("Offset fetches served from the cache")),
+       sm::make_derive(
+         "misses",
+         [this] { return _misses; },
+         sm::description("Offset fetches forwarded to the coordinator"))});
+}
+
+} // namespace kafka
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+#pragma once
+
+#include "kafka/requests/offset_commit_request.h"
+#include "kafka/requests/offset_fetch_request.h"
+#include "kafka/types.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <optional>
+
+namespace kafka {
+
+/**
+ * Offset fetch cache is a core local copy of the committed offsets of the
+ * consumer groups, for readers that tolerate offsets a little behind the
+ * coordinator such as lag monitoring. Scrapers fetch the offsets of every
+ * group on a short interval, and without the cache each fetch is a cross
+ * core call that waits on a linearizable barrier of the coordinator.
+ *
+ * A group is cached by a fetch of all of its partitions. The offsets of the
+ * commits routed through the core are applied to the cached groups as they
+ * are acknowledged, commits routed through other cores are only seen once
+ * the entry is older than the age the reader accepts and it is fetched again.
+ **/
+class offset_fetch_cache {
+public:
+    using clock_type = ss::lowres_clock;
+
+    static constexpr size_t max_groups = 1000;
+
+    offset_fetch_cache();
+
+    bool contains(const group_id& group) const {
+        return _entries.contains(group);
+    }
+
+    /// Returns the offsets of all the partitions of the group if they were
+    /// fetched from the coordinator at most `max_age` ago
+    std::optional<offset_fetch_response>
+    get(const group_id&, clock_type::duration max_age);
+
+    /// Caches the response to a fetch of all the partitions of the group
+    void put(const group_id&, const offset_fetch_response&);
+
+    /// Applies the offsets the coordinator acknowledged to a cached group
+    void apply(
+      const group_id&,
+      const std::vector<offset_commit_request_topic>&,
+      const offset_commit_response&);
+
+    size_t size() const { return _entries.size(); }
+    uint64_t hits() const { return _hits; }
+    uint64_t misses() const { return _misses; }
+
+private:
+    using offsets_t = absl::
+      flat_hash_map<model::topic_partition, offset_fetch_response_partition>;
+
+    struct entry {
+        clock_type::time_point fetched_at;
+        offsets_t offsets;
+    };
+
+    void register_metrics();
+
+    absl::flat_hash_map<group_id, entry> _entries;
+    uint64_t _hits{0};
+    uint64_t _misses{0};
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace kafka
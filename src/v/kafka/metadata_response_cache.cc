@@ -0,0 +1,98 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/metadata_response_cache.h"
+
+#include "config/configuration.h"
+#include "kafka/requests/metadata_request.h"
+#include "kafka/requests/response_writer.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "vassert.h"
+
+#include <seastar/core/metrics.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace kafka {
+
+static_assert(
+  metadata_api::max_supported() < metadata_response_cache::max_versions,
+  "metadata response cache must hold every supported version");
+
+metadata_response_cache::metadata_response_cache() { register_metrics(); }
+
+std::optional<iobuf> metadata_response_cache::get(
+  const cluster::metadata_cache& md_cache,
+  const model::topic_namespace& tp_ns,
+  api_version version) {
+    vassert(
+      version() >= 0 && static_cast<size_t>(version()) < max_versions,
+      "unsupported metadata api version {}",
+      version);
+    auto revision = md_cache.get_topic_revision(tp_ns);
+    if (!revision) {
+        _entries.erase(tp_ns);
+        return std::nullopt;
+    }
+
+    auto it = _entries.find(tp_ns);
+    if (it == _entries.end()) {
+        it = _entries.emplace(tp_ns, entry{.revision = *revision}).first;
+    } else if (it->second.revision != *revision) {
+        // topic changed, encodings of all the versions are stale
+        it->second = entry{.revision = *revision};
+    }
+
+    auto& encoded = it->second.encoded[version()];
+    if (!encoded) {
+        ++_misses;
+        // metadata cache is a synchronous facade over the shard local state,
+        // the topic can not disappear in between the two lookups
+        auto md = md_cache.get_topic_metadata(tp_ns);
+        vassert(md, "topic {} with revision must have metadata", tp_ns);
+        iobuf buf;
+        response_writer rw(buf);
+        metadata_response::topic::make_from_topic_metadata(std::move(*md))
+          .encode(version, rw);
+        encoded = std::move(buf);
+    } else {
+        ++_hits;
+    }
+    return encoded->share(0, encoded->size_bytes());
+}
+
+void metadata_response_cache::prune(const cluster::metadata_cache& md_cache) {
+    absl::erase_if(_entries, [&md_cache](const underlying_t::value_type& e) {
+        return !md_cache.get_topic_revision(e.first);
+    });
+}
+
+void metadata_response_cache::register_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:metadata_response_cache"),
+      {sm::make_gauge(
+         "topics_count",
+         [this] { return _entries.size(); },
+         sm::description("Number of topics with cached metadata entries")),
+       sm::make_derive(
+         "hits",
+         [this] { return _hits; },
+         sm::description("Metadata topic entries served from the cache")),
+       sm::make_derive(
+         "misses",
+         [this] { return _misses; },
+         sm::description("Metadata topic entries encoded on request"))});
+}
+
+} // namespace kafka
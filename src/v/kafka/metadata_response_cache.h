@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "cluster/metadata_cache.h"
+#include "kafka/types.h"
+#include "model/metadata.h"
+
+#include <seastar/core/metrics_registration.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <array>
+#include <optional>
+
+namespace kafka {
+
+/**
+ * Metadata response cache is a core local cache of encoded topic entries of
+ * the metadata response. Clients poll the metadata of every topic on a short
+ * interval while the metadata rarely changes, so instead of rebuilding and
+ * encoding the topic entry on every request the cache keeps it encoded for
+ * each of the versions it was requested with.
+ *
+ * An entry is encoded again only when the revision of the topic reported by
+ * the metadata cache changes, i.e. when its partitions are reassigned or any
+ * of its leaders changes. Cached entries are shared with the responses so a
+ * hit does not copy the encoded bytes.
+ **/
+class metadata_response_cache {
+public:
+    // one slot for each supported version of the metadata api
+    static constexpr size_t max_versions = 8;
+
+    metadata_response_cache();
+
+    /// Returns the encoded metadata response entry of a topic, if the topic
+    /// does not exists it returns an empty optional
+    std::optional<iobuf> get(
+      const cluster::metadata_cache&,
+      const model::topic_namespace&,
+      api_version);
+
+    /// Drops entries of topics that no longer exist
+    void prune(const cluster::metadata_cache&);
+
+    size_t size() const { return _entries.size(); }
+    uint64_t hits() const { return _hits; }
+    uint64_t misses() const { return _misses; }
+
+private:
+    struct entry {
+        cluster::metadata_cache::topic_revision revision;
+        std::array<std::optional<iobuf>, max_versions> encoded;
+    };
+
+    using underlying_t = absl::flat_hash_map<
+      model::topic_namespace,
+      entry,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>;
+
+    void register_metrics();
+
+    underlying_t _entries;
+    uint64_t _hits{0};
+    uint64_t _misses{0};
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace kafka
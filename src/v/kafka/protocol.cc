@@ -10,10 +10,16 @@
 #include "protocol.h"
 
 #include "cluster/topics_frontend.h"
+#include "config/configuration.h"
 #include "kafka/logger.h"
 #include "kafka/protocol_utils.h"
+#include "kafka/requests/api_versions_request.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/produce_request.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
+#include "kafka/requests/sasl_authenticate_request.h"
+#include "kafka/requests/sasl_handshake_request.h"
 #include "utils/utf8.h"
 #include "vlog.h"
 
@@ -26,15 +32,29 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <exception>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
 
 namespace kafka {
 using sequence_id = protocol::sequence_id;
 using session_resources = protocol::session_resources;
 
+ss::smp_service_group protocol::api_smp_groups::for_api(api_key key) const {
+    if (key == produce_api::key) {
+        return produce;
+    }
+    if (key == fetch_api::key) {
+        return fetch;
+    }
+    return other;
+}
+
 protocol::protocol(
-  ss::smp_service_group smp,
+  api_smp_groups smp,
   ss::sharded<cluster::metadata_cache>& meta,
   ss::sharded<cluster::topics_frontend>& tf,
   ss::sharded<quota_manager>& quota,
@@ -42,8 +62,11 @@ protocol::protocol(
   ss::sharded<cluster::shard_table>& tbl,
   ss::sharded<cluster::partition_manager>& pm,
   ss::sharded<coordinator_ntp_mapper>& coordinator_mapper,
-  ss::sharded<fetch_session_cache>& session_cache) noexcept
-  : _smp_group(smp)
+  ss::sharded<fetch_session_cache>& session_cache,
+  ss::sharded<metadata_response_cache>& response_cache,
+  ss::sharded<down_conversion_cache>& conversion_cache,
+  ss::sharded<security::credential_store>& credentials) noexcept
+  : _smp_groups(smp)
   , _topics_frontend(tf)
   , _metadata_cache(meta)
   , _quota_mgr(quota)
@@ -51,11 +74,22 @@ protocol::protocol(
   , _shard_table(tbl)
   , _partition_manager(pm)
   , _coordinator_mapper(coordinator_mapper)
-  , _fetch_session_cache(session_cache) {}
+  , _fetch_session_cache(session_cache)
+  , _metadata_response_cache(response_cache)
+  , _down_conversion_cache(conversion_cache)
+  , _credentials(credentials) {}
 
 ss::future<> protocol::apply(rpc::server::resources rs) {
+    const auto sasl_state = config::shard_local_cfg().enable_sasl()
+                              ? security::sasl_server::sasl_state::handshake
+                              : security::sasl_server::sasl_state::complete;
     auto ctx = ss::make_lw_shared<protocol::connection_context>(
-      *this, std::move(rs));
+      *this,
+      std::move(rs),
+      std::max<size_t>(
+        1,
+        config::shard_local_cfg().kafka_max_inflight_requests_per_connection()),
+      sasl_state);
     return ss::do_until(
              [ctx] { return ctx->is_finished_parsing(); },
              [ctx] { return ctx->process_one_request(); })
@@ -63,26 +97,33 @@ ss::future<> protocol::apply(rpc::server::resources rs) {
 }
 
 ss::future<> protocol::connection_context::process_one_request() {
-    return parse_size(_rs.conn->input())
-      .then([this](std::optional<size_t> sz) mutable {
-          if (!sz) {
-              return ss::make_ready_future<>();
-          }
-          return parse_header(_rs.conn->input())
-            .then(
-              [this, s = sz.value()](std::optional<request_header> h) mutable {
-                  _rs.probe().request_received();
-                  _rs.probe().add_bytes_received(s);
-                  if (!h) {
-                      vlog(
-                        klog.debug,
-                        "could not parse header from client: {}",
-                        _rs.conn->addr);
-                      _rs.probe().header_corrupted();
-                      return ss::make_ready_future<>();
-                  }
-                  return dispatch_method_once(std::move(h.value()), s);
-              });
+    // the next request is read once one of the in flight requests of the
+    // connection is answered
+    return ss::get_units(_inflight, 1).then(
+      [this](ss::semaphore_units<> inflight) {
+          return parse_size(_rs.conn->input())
+            .then([this, inflight = std::move(inflight)](
+                    std::optional<size_t> sz) mutable {
+                if (!sz) {
+                    return ss::make_ready_future<>();
+                }
+                return parse_header(_rs.conn->input())
+                  .then([this, s = sz.value(), inflight = std::move(inflight)](
+                          std::optional<request_header> h) mutable {
+                      _rs.probe().request_received();
+                      _rs.probe().add_bytes_received(s);
+                      if (!h) {
+                          vlog(
+                            klog.debug,
+                            "could not parse header from client: {}",
+                            _rs.conn->addr);
+                          _rs.probe().header_corrupted();
+                          return ss::make_ready_future<>();
+                      }
+                      return dispatch_method_once(
+                        std::move(h.value()), s, std::move(inflight));
+                  });
+            });
       });
 }
 
@@ -91,10 +132,18 @@ bool protocol::connection_context::is_finished_parsing() const {
 }
 
 ss::future<session_resources> protocol::connection_context::throttle_request(
-  std::optional<std::string_view> client_id, size_t request_size) {
-    // update the throughput tracker for this client using the
+  const request_header& hdr, size_t request_size) {
+    // clients keep their client id for the lifetime of the connection, the
+    // quota is only looked up again when it changes
+    auto& quotas = _proto._quota_mgr.local();
+    const auto cid = hdr.client_id.value_or("");
+    if (!_client_quota || std::string_view(_client_quota->client_id) != cid) {
+        _client_quota = quotas.get_client_quota(hdr.client_id);
+    }
+    // update the produce throughput of this client using the
     // size of the current request and return any computed delay
-    // to apply for quota throttling.
+    // to apply for quota throttling. fetches are throttled by the
+    // size of the previous responses.
     //
     // note that when throttling is first applied the request is
     // allowed to pass through and subsequent requests and
@@ -103,11 +152,17 @@ ss::future<session_resources> protocol::connection_context::throttle_request(
     // distinguish throttling delays from real delays. delays
     // applied to subsequent messages allow backpressure to take
     // affect.
-    auto delay = _proto._quota_mgr.local().record_tp_and_throttle(
-      client_id, request_size);
+    quota_manager::throttle_delay delay{
+      .first_violation = true, .duration = ss::lowres_clock::duration(0)};
+    if (hdr.key == produce_api::key) {
+        delay = quotas.record_produce_tp_and_throttle(
+          *_client_quota, request_size);
+    } else if (hdr.key == fetch_api::key) {
+        delay = quotas.fetch_throttle(*_client_quota);
+    }
 
     auto fut = ss::now();
-    if (!delay.first_violation) {
+    if (!delay.first_violation && delay.duration.count() > 0) {
         fut = ss::sleep_abortable(delay.duration, _rs.abort_source());
     }
     return fut
@@ -141,9 +196,10 @@ protocol::connection_context::reserve_request_units(size_t size) {
 }
 
 ss::future<> protocol::connection_context::dispatch_method_once(
-  request_header hdr, size_t size) {
-    return throttle_request(hdr.client_id, size)
-      .then([this, hdr = std::move(hdr), size](session_resources sres) mutable {
+  request_header hdr, size_t size, ss::semaphore_units<> inflight) {
+    return throttle_request(hdr, size)
+      .then([this, hdr = std::move(hdr), size, inflight = std::move(inflight)](
+              session_resources sres) mutable {
           if (_rs.abort_requested()) {
               // protect against shutdown behavior
               return ss::make_ready_future<>();
@@ -151,29 +207,28 @@ ss::future<> protocol::connection_context::dispatch_method_once(
           auto remaining = size - sizeof(raw_request_header)
                            - hdr.client_id_buffer.size();
           return read_iobuf_exactly(_rs.conn->input(), remaining)
-            .then([this, hdr = std::move(hdr), sres = std::move(sres)](
-                    iobuf buf) mutable {
+            .then([this,
+                   hdr = std::move(hdr),
+                   sres = std::move(sres),
+                   inflight = std::move(inflight)](iobuf buf) mutable {
                 if (_rs.abort_requested()) {
                     // _proto._cntrl etc might not be alive
                     return;
                 }
-                auto rctx = request_context(
-                  _proto._metadata_cache,
-                  _proto._topics_frontend.local(),
-                  std::move(hdr),
-                  std::move(buf),
-                  sres.backpressure_delay,
-                  _proto._group_router.local(),
-                  _proto._shard_table.local(),
-                  _proto._partition_manager,
-                  _proto._coordinator_mapper,
-                  _proto._fetch_session_cache);
                 // background process this one full request
                 auto self = shared_from_this();
                 (void)ss::with_gate(
                   _rs.conn_gate(),
-                  [this, rctx = std::move(rctx)]() mutable {
-                      return do_process(std::move(rctx));
+                  [this,
+                   hdr = std::move(hdr),
+                   buf = std::move(buf),
+                   delay = sres.backpressure_delay,
+                   inflight = std::move(inflight)]() mutable {
+                      return do_process(
+                        std::move(hdr),
+                        std::move(buf),
+                        delay,
+                        std::move(inflight));
                   })
                   .handle_exception([self](std::exception_ptr e) {
                       vlog(
@@ -185,30 +240,170 @@ ss::future<> protocol::connection_context::dispatch_method_once(
       });
 }
 
-ss::future<> protocol::connection_context::do_process(request_context ctx) {
-    const auto correlation = ctx.header().correlation;
+request_context protocol::make_request_context(
+  request_header hdr,
+  iobuf buf,
+  ss::lowres_clock::duration throttle_delay,
+  security::sasl_server* sasl) {
+    return request_context(
+      _metadata_cache,
+      _topics_frontend.local(),
+      std::move(hdr),
+      std::move(buf),
+      throttle_delay,
+      _group_router.local(),
+      _shard_table.local(),
+      _partition_manager,
+      _coordinator_mapper,
+      _fetch_session_cache,
+      _metadata_response_cache,
+      _down_conversion_cache,
+      _credentials,
+      sasl);
+}
+
+ss::future<> protocol::connection_context::do_process(
+  request_header hdr,
+  iobuf buf,
+  ss::lowres_clock::duration throttle_delay,
+  ss::semaphore_units<> inflight) {
+    const auto correlation = hdr.correlation;
     const sequence_id seq = _seq_idx;
     _seq_idx = _seq_idx + sequence_id(1);
-    return kafka::process_request(std::move(ctx), _proto._smp_group)
-      .then([this, seq, correlation](response_ptr r) mutable {
+    // fetches are accounted by the size of their response
+    quota_manager::client_quota_ptr fetch_quota;
+    if (
+      hdr.key == fetch_api::key
+      && _proto._quota_mgr.local().has_fetch_quota()) {
+        fetch_quota = _client_quota;
+    }
+    return process(std::move(hdr), std::move(buf), throttle_delay)
+      .then([this,
+             seq,
+             correlation,
+             fetch_quota = std::move(fetch_quota),
+             inflight = std::move(inflight)](response_ptr r) mutable {
+          if (fetch_quota) {
+              _proto._quota_mgr.local().record_fetch_tp(
+                *fetch_quota, r->buf().size_bytes());
+          }
           r->set_correlation(correlation);
-          _responses.insert({seq, std::move(r)});
+          // the in flight slots keep the sequences of a connection within
+          // one turn of the ring
+          _responses[seq() % _responses.size()].emplace(pending_response{
+            .response = std::move(r), .inflight = std::move(inflight)});
           return process_next_response();
       });
 }
 
+ss::future<response_ptr> protocol::connection_context::process(
+  request_header hdr, iobuf buf, ss::lowres_clock::duration throttle_delay) {
+    // until authenticated a client may only ask for the api versions and
+    // go through the sasl exchange, anything else closes the connection
+    if (
+      !_sasl.complete() && hdr.key != api_versions_api::key
+      && hdr.key != sasl_handshake_api::key
+      && hdr.key != sasl_authenticate_api::key) {
+        return ss::make_exception_future<response_ptr>(
+          std::runtime_error(fmt::format(
+            "Unauthenticated request {} from {}", hdr.key, _rs.conn->addr)));
+    }
+    const bool produce = hdr.key == produce_api::key;
+    const auto smp_group = _proto._smp_groups.for_api(hdr.key);
+    auto shard = produce ? produce_shard() : std::nullopt;
+    auto f = shard ? process_on(
+               *shard, std::move(hdr), std::move(buf), throttle_delay)
+                   : kafka::process_request(
+                     _proto.make_request_context(
+                       std::move(hdr), std::move(buf), throttle_delay, &_sasl),
+                     smp_group);
+    if (!produce) {
+        return f;
+    }
+    return f.then([this](response_ptr r) {
+        record_produce_shard(r->partition_shard());
+        return r;
+    });
+}
+
+ss::future<response_ptr> protocol::connection_context::process_on(
+  ss::shard_id shard,
+  request_header hdr,
+  iobuf buf,
+  ss::lowres_clock::duration throttle_delay) {
+    std::optional<ss::sstring> client_id;
+    if (hdr.client_id) {
+        client_id = ss::sstring(hdr.client_id->data(), hdr.client_id->size());
+    }
+    // the bytes of the request stay on this shard, the other one shares them
+    // and frees them here once it is done
+    auto request = ss::make_foreign(std::make_unique<iobuf>(std::move(buf)));
+    return _proto._partition_manager.invoke_on(
+      shard,
+      _proto._smp_groups.produce,
+      [proto = &_proto,
+       key = hdr.key,
+       version = hdr.version,
+       correlation = hdr.correlation,
+       client_id = std::move(client_id),
+       request = std::move(request),
+       throttle_delay](cluster::partition_manager&) mutable {
+          request_header hdr{
+            .key = key, .version = version, .correlation = correlation};
+          if (client_id) {
+              hdr.client_id_buffer = ss::temporary_buffer<char>(
+                client_id->data(), client_id->size());
+              hdr.client_id = std::string_view(
+                hdr.client_id_buffer.get(), hdr.client_id_buffer.size());
+          }
+          const iobuf& bytes = *request;
+          auto buf = bytes.foreign_share(
+            ss::make_object_deleter(std::move(request)));
+          // the services of this shard, a produce request does not touch
+          // the sasl state of the connection
+          return kafka::process_request(
+            proto->make_request_context(
+              std::move(hdr), std::move(buf), throttle_delay, nullptr),
+            proto->_smp_groups.produce);
+      });
+}
+
+std::optional<ss::shard_id>
+protocol::connection_context::produce_shard() const {
+    const auto requests
+      = config::shard_local_cfg().kafka_produce_affinity_requests();
+    if (
+      requests == 0 || _produce_shard_requests < requests
+      || _produce_shard == ss::this_shard_id()) {
+        return std::nullopt;
+    }
+    return _produce_shard;
+}
+
+void protocol::connection_context::record_produce_shard(
+  std::optional<ss::shard_id> shard) {
+    if (shard && shard == _produce_shard) {
+        ++_produce_shard_requests;
+        return;
+    }
+    _produce_shard = shard;
+    _produce_shard_requests = shard ? 1 : 0;
+}
+
 ss::future<> protocol::connection_context::process_next_response() {
     return ss::repeat([this]() mutable {
-        auto it = _responses.find(_next_response);
-        if (it == _responses.end()) {
+        auto& slot = _responses[_next_response() % _responses.size()];
+        if (!slot) {
             return ss::make_ready_future<ss::stop_iteration>(
               ss::stop_iteration::yes);
         }
         // found one; increment counter
         _next_response = _next_response + sequence_id(1);
 
-        auto r = std::move(it->second);
-        _responses.erase(it);
+        // frees the in flight slot of the request
+        auto pending = std::move(*slot);
+        slot.reset();
+        auto r = std::move(pending.response);
         _rs.probe().request_completed();
 
         if (r->is_noop()) {
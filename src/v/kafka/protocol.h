@@ -14,23 +14,26 @@
 #include "cluster/partition_manager.h"
 #include "cluster/shard_table.h"
 #include "cluster/topics_frontend.h"
+#include "kafka/down_conversion.h"
 #include "kafka/fetch_session_cache.h"
 #include "kafka/groups/group_router.h"
+#include "kafka/metadata_response_cache.h"
 #include "kafka/quota_manager.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
 #include "rpc/server.h"
+#include "security/credential_store.h"
+#include "security/sasl_authentication.h"
 #include "utils/hdr_hist.h"
 
 #include <seastar/core/future.hh>
 #include <seastar/core/lowres_clock.hh>
 #include <seastar/core/metrics_registration.hh>
 #include <seastar/core/scattered_message.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/shared_ptr.hh>
 
-#include <absl/container/flat_hash_map.h>
-
 #include <cstdint>
 #include <optional>
 #include <vector>
@@ -48,14 +51,25 @@ namespace kafka {
 class protocol final : public rpc::server::protocol {
 public:
     using sequence_id = named_type<uint64_t, struct kafka_protocol_sequence>;
+    /// groups of the cross shard calls of the requests, the hops of produce
+    /// and fetch do not compete for the units of one another
+    struct api_smp_groups {
+        ss::smp_service_group produce;
+        ss::smp_service_group fetch;
+        // the other apis
+        ss::smp_service_group other;
+
+        ss::smp_service_group for_api(api_key) const;
+    };
     struct session_resources {
         ss::lowres_clock::duration backpressure_delay;
         ss::semaphore_units<> memlocks;
+        // recorded into the windowed latency histogram of the server
         std::unique_ptr<hdr_hist::measurement> method_latency;
     };
 
     protocol(
-      ss::smp_service_group,
+      api_smp_groups,
       ss::sharded<cluster::metadata_cache>&,
       ss::sharded<cluster::topics_frontend>&,
       ss::sharded<quota_manager>&,
@@ -63,7 +77,10 @@ public:
       ss::sharded<cluster::shard_table>&,
       ss::sharded<cluster::partition_manager>&,
       ss::sharded<coordinator_ntp_mapper>& coordinator_mapper,
-      ss::sharded<fetch_session_cache>&) noexcept;
+      ss::sharded<fetch_session_cache>&,
+      ss::sharded<metadata_response_cache>&,
+      ss::sharded<down_conversion_cache>&,
+      ss::sharded<security::credential_store>&) noexcept;
 
     ~protocol() noexcept override = default;
     protocol(const protocol&) = delete;
@@ -77,14 +94,26 @@ public:
     ss::future<> apply(rpc::server::resources) final;
 
 private:
-    using map_t = absl::flat_hash_map<sequence_id, response_ptr>;
+    // response waiting for the responses of the requests before it, holds
+    // the in flight slot of its request until it is sent
+    struct pending_response {
+        response_ptr response;
+        ss::semaphore_units<> inflight;
+    };
 
     class connection_context final
       : public ss::enable_lw_shared_from_this<connection_context> {
     public:
-        connection_context(protocol& p, rpc::server::resources&& r) noexcept
+        connection_context(
+          protocol& p,
+          rpc::server::resources&& r,
+          size_t max_inflight,
+          security::sasl_server::sasl_state sasl_state)
           : _proto(p)
-          , _rs(std::move(r)) {}
+          , _rs(std::move(r))
+          , _inflight(max_inflight)
+          , _responses(max_inflight)
+          , _sasl(sasl_state) {}
         ~connection_context() noexcept = default;
         connection_context(const connection_context&) = delete;
         connection_context(connection_context&&) = delete;
@@ -100,23 +129,60 @@ private:
 
         /// apply correct backpressure sequence
         ss::future<session_resources>
-        throttle_request(std::optional<std::string_view>, size_t sz);
+        throttle_request(const request_header&, size_t sz);
 
-        ss::future<> dispatch_method_once(request_header, size_t sz);
+        ss::future<> dispatch_method_once(
+          request_header, size_t sz, ss::semaphore_units<> inflight);
         ss::future<> process_next_response();
-        ss::future<> do_process(request_context);
+        ss::future<> do_process(
+          request_header,
+          iobuf,
+          ss::lowres_clock::duration throttle_delay,
+          ss::semaphore_units<> inflight);
+        /// \brief runs a request on this shard, or on the shard of its
+        /// partitions, see produce_shard()
+        ss::future<response_ptr> process(
+          request_header, iobuf, ss::lowres_clock::duration throttle_delay);
+        ss::future<response_ptr> process_on(
+          ss::shard_id,
+          request_header,
+          iobuf,
+          ss::lowres_clock::duration throttle_delay);
+
+        /// \brief the other shard holding the partitions of the last
+        /// produce requests, once they all went there
+        /// kafka_produce_affinity_requests times in a row
+        std::optional<ss::shard_id> produce_shard() const;
+        void record_produce_shard(std::optional<ss::shard_id>);
 
     private:
         protocol& _proto;
         rpc::server::resources _rs;
         sequence_id _next_response;
         sequence_id _seq_idx;
-        map_t _responses;
+        // requests read but not answered yet, a new request is only read
+        // once a slot is free
+        ss::semaphore _inflight;
+        // responses by sequence, at most one in flight request per slot
+        std::vector<std::optional<pending_response>> _responses;
+        // quota of the client id of the last request
+        quota_manager::client_quota_ptr _client_quota;
+        // shard of the partitions of the last produce requests
+        std::optional<ss::shard_id> _produce_shard;
+        size_t _produce_shard_requests{0};
+        security::sasl_server _sasl;
     };
     friend connection_context;
 
 private:
-    ss::smp_service_group _smp_group;
+    /// \brief context of a request with the services of the current shard
+    request_context make_request_context(
+      request_header,
+      iobuf,
+      ss::lowres_clock::duration throttle_delay,
+      security::sasl_server*);
+
+    api_smp_groups _smp_groups;
 
     // services needed by kafka proto
     ss::sharded<cluster::topics_frontend>& _topics_frontend;
@@ -127,6 +193,9 @@ private:
     ss::sharded<cluster::partition_manager>& _partition_manager;
     ss::sharded<kafka::coordinator_ntp_mapper>& _coordinator_mapper;
     ss::sharded<kafka::fetch_session_cache>& _fetch_session_cache;
+    ss::sharded<kafka::metadata_response_cache>& _metadata_response_cache;
+    ss::sharded<kafka::down_conversion_cache>& _down_conversion_cache;
+    ss::sharded<security::credential_store>& _credentials;
 };
 
 } // namespace kafka
@@ -91,11 +91,18 @@ ss::future<std::optional<size_t>> parse_size(ss::input_stream<char>& src) {
 
 ss::scattered_message<char> response_as_scattered(response_ptr response) {
     auto correlation = response->correlation();
-    auto header = ss::temporary_buffer<char>(sizeof(raw_response_header));
+    // header v1 ends with the tagged fields, no response sets any
+    const size_t tagged_fields = response->flexible_header() ? 1 : 0;
+    auto header = ss::temporary_buffer<char>(
+      sizeof(raw_response_header) + tagged_fields);
     // NOLINTNEXTLINE
     auto* raw_header = reinterpret_cast<raw_response_header*>(
       header.get_write());
-    auto size = int32_t(sizeof(correlation) + response->buf().size_bytes());
+    if (tagged_fields) {
+        header.get_write()[sizeof(raw_response_header)] = 0;
+    }
+    auto size = int32_t(
+      sizeof(correlation) + tagged_fields + response->buf().size_bytes());
     raw_header->size = ss::cpu_to_be(size);
     raw_header->correlation = ss::cpu_to_be(correlation());
     auto& buf = response->buf();
@@ -13,91 +13,223 @@
 #include "kafka/logger.h"
 #include "vlog.h"
 
+#include <seastar/core/smp.hh>
+
+#include <algorithm>
+#include <utility>
+
 namespace kafka {
 using clock = quota_manager::clock;
 using throttle_delay = quota_manager::throttle_delay;
 
-quota_manager::~quota_manager() { _gc_timer.cancel(); }
+quota_manager::~quota_manager() {
+    _gc_timer.cancel();
+    _aggregation_timer.cancel();
+}
 
 ss::future<> quota_manager::stop() {
     _gc_timer.cancel();
-    return ss::make_ready_future<>();
+    _aggregation_timer.cancel();
+    return _gate.close();
 }
 
 ss::future<> quota_manager::start() {
     _gc_timer.arm_periodic(_gc_freq);
+    // a single shard has nothing to exchange
+    if (ss::this_shard_id() == aggregation_shard && ss::smp::count > 1) {
+        _aggregation_timer.arm_periodic(_aggregation_freq);
+    }
     return ss::make_ready_future<>();
 }
 
-// record a new observation and return <previous delay, new delay>
-throttle_delay quota_manager::record_tp_and_throttle(
-  std::optional<std::string_view> client_id,
-  uint64_t bytes,
-  clock::time_point now) {
+quota_manager::client_quota_ptr quota_manager::get_client_quota(
+  std::optional<std::string_view> client_id, clock::time_point now) {
     // requests without a client id are grouped into an anonymous group that
     // shares a default quota. the anonymous group is keyed on empty string.
     auto cid = client_id ? *client_id : "";
 
-    // find or create the throughput tracker for this client
-    //
     // c++20: heterogeneous lookup for unordered_map can avoid creation of
-    // an sstring here but std::unordered_map::find isn't using an
-    // equal_to<> overload. this is a general issue we'll be looking at. for
-    // now, these client-name strings are small. This will be solved in
-    // c++20 via Hash::transparent_key_equal.
-    auto [it, inserted] = _quotas.try_emplace(
-      ss::sstring(cid),
-      quota{
-        now,
-        clock::duration(0),
-        {_default_num_windows, _default_window_width}});
-
+    // an sstring here. the lookup happens once per connection and client
+    // id, these client-name strings are small.
+    auto [it, inserted] = _quotas.try_emplace(ss::sstring(cid), nullptr);
+    if (inserted) {
+        // a new client starts with a full window worth of bytes
+        const auto window = std::chrono::duration<double>(_window_width);
+        it->second = ss::make_lw_shared<client_quota>(client_quota{
+          .client_id = it->first,
+          .last_seen = now,
+          .produce = token_bucket{
+            .tokens = _target_produce_rate * window.count(),
+            .last_refill = now},
+          .fetch = token_bucket{
+            .tokens = _target_fetch_rate.value_or(0) * window.count(),
+            .last_refill = now},
+        });
+    }
     // bump to prevent gc
-    if (!inserted) {
-        it->second.last_seen = now;
+    it->second->last_seen = now;
+    return it->second;
+}
+
+void quota_manager::refill(
+  token_bucket& b, uint32_t rate, clock::time_point now) const {
+    if (now <= b.last_refill) {
+        return;
     }
+    const auto elapsed = std::chrono::duration<double>(now - b.last_refill);
+    const auto window = std::chrono::duration<double>(_window_width);
+    b.tokens = std::min(
+      b.tokens + rate * elapsed.count(), rate * window.count());
+    b.last_refill = now;
+}
 
-    auto rate = it->second.tp_rate.record_and_measure(bytes, now);
+throttle_delay quota_manager::throttle(
+  token_bucket& b,
+  uint32_t rate,
+  const client_quota& q,
+  clock::time_point now) const {
+    refill(b, rate, now);
 
+    // the time until the debt of the bucket is paid off
     uint64_t delay_ms = 0;
-    if (rate > _target_tp_rate) {
-        auto diff = rate - _target_tp_rate;
-        double delay
-          = (diff / _target_tp_rate)
-            * (double)std::chrono::duration_cast<std::chrono::milliseconds>(
-                it->second.tp_rate.window_size())
-                .count();
-        delay_ms = static_cast<uint64_t>(delay);
+    if (b.tokens < 0 && rate > 0) {
+        delay_ms = static_cast<uint64_t>(-b.tokens * 1000 / rate);
     }
     if (delay_ms > (uint64_t)_max_delay.count()) {
         vlog(
           klog.info,
-          "Found data rate for window of: {} bytes. Client:{}, Estimated "
+          "Found quota debt of: {} bytes. Client:{}, Estimated "
           "backpressure delay of {}ms. Limiting to {}ms backpressure delay",
-          rate,
-          cid,
+          -b.tokens,
+          q.client_id,
           delay_ms,
           _max_delay.count());
         delay_ms = _max_delay.count();
     }
 
-    auto prev = it->second.delay;
-    it->second.delay = std::chrono::milliseconds(delay_ms);
+    auto prev = b.delay;
+    b.delay = std::chrono::milliseconds(delay_ms);
 
     throttle_delay res{};
     res.first_violation = prev.count() == 0;
-    res.duration = it->second.delay;
+    res.duration = b.delay;
     return res;
 }
-// erase inactive tracked quotas. windows are considered inactive if they
+
+// record a new observation and return <previous delay, new delay>
+throttle_delay quota_manager::record_produce_tp_and_throttle(
+  client_quota& q, uint64_t bytes, clock::time_point now) {
+    q.last_seen = now;
+    refill(q.produce, _target_produce_rate, now);
+    q.produce.tokens -= bytes;
+    q.produce.unreported += bytes;
+    return throttle(q.produce, _target_produce_rate, q, now);
+}
+
+throttle_delay
+quota_manager::fetch_throttle(client_quota& q, clock::time_point now) {
+    q.last_seen = now;
+    if (!_target_fetch_rate) {
+        return throttle_delay{
+          .first_violation = true, .duration = clock::duration(0)};
+    }
+    return throttle(q.fetch, *_target_fetch_rate, q, now);
+}
+
+void quota_manager::record_fetch_tp(
+  client_quota& q, uint64_t bytes, clock::time_point now) {
+    if (!_target_fetch_rate) {
+        return;
+    }
+    refill(q.fetch, *_target_fetch_rate, now);
+    q.fetch.tokens -= bytes;
+    q.fetch.unreported += bytes;
+}
+
+void quota_manager::aggregate() {
+    // a slow exchange is not stacked up with the next one
+    if (_aggregating || _gate.is_closed()) {
+        return;
+    }
+    _aggregating = true;
+    (void)ss::with_gate(_gate, [this] {
+        return container()
+          .map_reduce0(
+            [](quota_manager& qm) { return qm.collect_usage(); },
+            usage_map{},
+            [](usage_map acc, usage_map u) {
+                for (auto& [id, use] : u) {
+                    auto& total = acc[id];
+                    total.produce += use.produce;
+                    total.fetch += use.fetch;
+                }
+                return acc;
+            })
+          .then([this](usage_map total) {
+              return ss::do_with(
+                std::move(total), [this](const usage_map& total) {
+                    return container().invoke_on_all(
+                      [&total](quota_manager& qm) {
+                          qm.apply_usage(total, clock::now());
+                      });
+                });
+          })
+          .handle_exception([](const std::exception_ptr& e) {
+              vlog(klog.warn, "Error exchanging quota usage - {}", e);
+          })
+          .finally([this] { _aggregating = false; });
+    });
+}
+
+quota_manager::usage_map quota_manager::collect_usage() {
+    usage_map ret;
+    for (auto& [id, q] : _quotas) {
+        auto& p = q->produce;
+        auto& f = q->fetch;
+        if (p.unreported == 0 && f.unreported == 0) {
+            continue;
+        }
+        ret.emplace(id, usage{.produce = p.unreported, .fetch = f.unreported});
+        p.reported = std::exchange(p.unreported, 0);
+        f.reported = std::exchange(f.unreported, 0);
+    }
+    return ret;
+}
+
+void quota_manager::apply_usage(const usage_map& total, clock::time_point now) {
+    // the total includes what this shard reported, only the consumption of
+    // the other shards is taken out of the buckets
+    auto apply = [this, now](token_bucket& b, uint32_t rate, uint64_t sum) {
+        const auto remote = sum > b.reported ? sum - b.reported : 0;
+        b.reported = 0;
+        if (remote > 0) {
+            refill(b, rate, now);
+            b.tokens -= remote;
+        }
+    };
+    for (auto& [id, q] : _quotas) {
+        auto it = total.find(id);
+        if (it == total.end()) {
+            q->produce.reported = 0;
+            q->fetch.reported = 0;
+            continue;
+        }
+        apply(q->produce, _target_produce_rate, it->second.produce);
+        apply(q->fetch, _target_fetch_rate.value_or(0), it->second.fetch);
+    }
+}
+
+// erase inactive tracked quotas. quotas are considered inactive if they
 // have not received any updates in ten window's worth of time.
-void quota_manager::gc(clock::duration full_window) {
+void quota_manager::gc(clock::duration expire_age) {
     auto now = clock::now();
-    auto expire_age = full_window * 10;
     // c++20: replace with std::erase_if
     absl::erase_if(
-      _quotas, [now, expire_age](const std::pair<ss::sstring, quota>& q) {
-          return (now - q.second.last_seen) > expire_age;
+      _quotas,
+      [now, expire_age](const std::pair<ss::sstring, client_quota_ptr>& q) {
+          // quotas of open connections are kept
+          return q.second.use_count() == 1
+                 && (now - q.second->last_seen) > expire_age;
       });
 }
 
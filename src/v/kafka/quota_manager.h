@@ -11,11 +11,13 @@
 
 #pragma once
 #include "config/configuration.h"
-#include "resource_mgmt/rate.h"
 #include "seastarx.h"
 
 #include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
 #include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sharded.hh>
 #include <seastar/core/sstring.hh>
 #include <seastar/core/timer.hh>
 
@@ -29,38 +31,67 @@ namespace kafka {
 
 // quota_manager tracks quota usage
 //
+// every client id has a produce and a fetch token bucket. a bucket refills at
+// the target rate of its quota and holds at most one window worth of bytes,
+// requests take their bytes out of it. once a bucket is in debt the client is
+// throttled until the debt is paid off.
+//
+// the buckets live on every shard the client has connections on. the shards
+// periodically exchange the bytes the clients consumed on them, every shard
+// takes the consumption of the other shards out of its own buckets, so a
+// client gets its quota once per node and not once per shard.
+//
+// connections hold on to the quota of their client, recording a request
+// does not look the client up.
+//
 // TODO:
 //   - we will want to eventually add support for configuring the quotas and
 //   quota settings as runtime through the kafka api and other mechanisms.
 //
-//   - currently only total throughput per client_id is tracked. in the future
-//   we will want to support additional quotas and accouting granularities to be
-//   at parity with kafka. for example:
+//   - accounting per user vs per client (these are separate in kafka)
 //
-//      - splitting out rates separately for produce and fetch
-//      - accounting per user vs per client (these are separate in kafka)
-//
-//   - it may eventually be beneficial to periodically reduce stats across
-//   shards or track stats globally to produce a more accurate per-node
-//   representation of a statistic (e.g. bandwidth).
-//
-class quota_manager {
+class quota_manager : public ss::peering_sharded_service<quota_manager> {
 public:
     using clock = ss::lowres_clock;
+    static constexpr ss::shard_id aggregation_shard = 0;
 
     struct throttle_delay {
         bool first_violation;
         clock::duration duration;
     };
 
+    // tokens: bytes the client may still send, negative once in debt
+    // delay: last calculated delay
+    // unreported: bytes recorded since the last exchange between the shards
+    // reported: bytes of the exchange in progress
+    struct token_bucket {
+        double tokens;
+        clock::time_point last_refill;
+        clock::duration delay{0};
+        uint64_t unreported{0};
+        uint64_t reported{0};
+    };
+
+    // last_seen: used for gc keepalive
+    struct client_quota {
+        ss::sstring client_id;
+        clock::time_point last_seen;
+        token_bucket produce;
+        token_bucket fetch;
+    };
+    using client_quota_ptr = ss::lw_shared_ptr<client_quota>;
+
     quota_manager()
-      : _default_num_windows(config::shard_local_cfg().default_num_windows())
-      , _default_window_width(config::shard_local_cfg().default_window_sec())
-      , _target_tp_rate(config::shard_local_cfg().target_quota_byte_rate())
+      : _window_width(config::shard_local_cfg().default_window_sec())
+      , _target_produce_rate(config::shard_local_cfg().target_quota_byte_rate())
+      , _target_fetch_rate(
+          config::shard_local_cfg().target_fetch_quota_byte_rate())
       , _gc_freq(config::shard_local_cfg().quota_manager_gc_sec())
+      , _aggregation_freq(
+          config::shard_local_cfg().quota_manager_aggregation_ms())
       , _max_delay(config::shard_local_cfg().max_kafka_throttle_delay_ms()) {
-        auto full_window = _default_num_windows * _default_window_width;
-        _gc_timer.set_callback([this, full_window] { gc(full_window); });
+        _gc_timer.set_callback([this] { gc(_window_width * 10); });
+        _aggregation_timer.set_callback([this] { aggregate(); });
     }
 
     quota_manager(const quota_manager&) = delete;
@@ -74,36 +105,64 @@ public:
 
     ss::future<> start();
 
-    // record a new observation and return <previous delay, new delay>
-    throttle_delay record_tp_and_throttle(
+    // the quota tracked for the client on this shard. requests without a
+    // client id share the quota of an anonymous client.
+    client_quota_ptr get_client_quota(
       std::optional<std::string_view> client_id,
-      uint64_t bytes,
       clock::time_point now = clock::now());
 
-private:
-    // erase inactive tracked quotas. windows are considered inactive if they
-    // have not received any updates in ten window's worth of time.
-    void gc(clock::duration full_window);
+    // record a produce request and return <previous delay, new delay>
+    throttle_delay record_produce_tp_and_throttle(
+      client_quota&, uint64_t bytes, clock::time_point now = clock::now());
+
+    // delay of a fetch request, fetched bytes are recorded once known
+    throttle_delay
+    fetch_throttle(client_quota&, clock::time_point now = clock::now());
+
+    // record the size of a fetch response
+    void record_fetch_tp(
+      client_quota&, uint64_t bytes, clock::time_point now = clock::now());
+
+    bool has_fetch_quota() const { return _target_fetch_rate.has_value(); }
 
 private:
-    // last_seen: used for gc keepalive
-    // delay: last calculated delay
-    // tp_rate: throughput tracking
-    struct quota {
-        clock::time_point last_seen;
-        clock::duration delay;
-        rate_tracker tp_rate;
+    struct usage {
+        uint64_t produce{0};
+        uint64_t fetch{0};
     };
+    using usage_map = absl::flat_hash_map<ss::sstring, usage>;
+
+    void refill(token_bucket&, uint32_t rate, clock::time_point now) const;
+    throttle_delay throttle(
+      token_bucket&,
+      uint32_t rate,
+      const client_quota&,
+      clock::time_point now) const;
+
+    // exchange of the consumption between the shards, runs on the
+    // aggregation shard
+    void aggregate();
+    usage_map collect_usage();
+    void apply_usage(const usage_map&, clock::time_point now);
+
+    // erase inactive tracked quotas. quotas are considered inactive if they
+    // have not received any updates in ten window's worth of time and no
+    // connection holds on to them.
+    void gc(clock::duration expire_age);
 
-    const std::size_t _default_num_windows;
-    const clock::duration _default_window_width;
-
-    const uint32_t _target_tp_rate;
-    absl::flat_hash_map<ss::sstring, quota> _quotas;
+private:
+    const clock::duration _window_width;
+    const uint32_t _target_produce_rate;
+    const std::optional<uint32_t> _target_fetch_rate;
+    absl::flat_hash_map<ss::sstring, client_quota_ptr> _quotas;
 
     ss::timer<> _gc_timer;
     const clock::duration _gc_freq;
+    ss::timer<> _aggregation_timer;
+    const clock::duration _aggregation_freq;
+    bool _aggregating{false};
     const clock::duration _max_delay;
+    ss::gate _gate;
 };
 
 } // namespace kafka
@@ -11,12 +11,14 @@
 
 #include "kafka/requests/alter_configs_request.h"
 #include "kafka/requests/create_topics_request.h"
+#include "kafka/requests/delete_records_request.h"
 #include "kafka/requests/delete_topics_request.h"
 #include "kafka/requests/describe_configs_request.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/fetch_request.h"
 #include "kafka/requests/find_coordinator_request.h"
 #include "kafka/requests/heartbeat_request.h"
+#include "kafka/requests/init_producer_id_request.h"
 #include "kafka/requests/join_group_request.h"
 #include "kafka/requests/leave_group_request.h"
 #include "kafka/requests/list_groups_request.h"
@@ -67,7 +69,9 @@ using request_types = make_request_types<
   delete_topics_api,
   describe_groups_api,
   sasl_handshake_api,
-  sasl_authenticate_api>;
+  sasl_authenticate_api,
+  init_producer_id_api,
+  delete_records_api>;
 
 template<typename RequestType>
 static auto make_api() {
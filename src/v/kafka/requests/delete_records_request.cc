@@ -0,0 +1,183 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/delete_records_request.h"
+
+#include "cluster/errc.h"
+#include "cluster/metadata_cache.h"
+#include "cluster/namespace.h"
+#include "cluster/partition_manager.h"
+#include "kafka/errors.h"
+#include "kafka/logger.h"
+#include "kafka/requests/timeout.h"
+#include "raft/errc.h"
+#include "vlog.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/future-util.hh>
+
+#include <vector>
+
+namespace kafka {
+
+static error_code map_delete_records_error(std::error_code ec) {
+    if (ec.category() == raft::error_category()) {
+        switch (static_cast<raft::errc>(ec.value())) {
+        case raft::errc::not_leader:
+            return error_code::not_leader_for_partition;
+        case raft::errc::timeout:
+            return error_code::request_timed_out;
+        default:
+            return error_code::unknown_server_error;
+        }
+    }
+    if (
+      ec.category() == cluster::error_category()
+      && static_cast<cluster::errc>(ec.value())
+           == cluster::errc::topic_invalid_config) {
+        return error_code::policy_violation;
+    }
+    return error_code::unknown_server_error;
+}
+
+static delete_records_partition_result make_partition(
+  model::partition_id id, model::offset low_watermark, error_code error) {
+    return delete_records_partition_result{
+      .partition_index = id,
+      .low_watermark = low_watermark,
+      .error_code = error,
+    };
+}
+
+/**
+ * Truncates the partition on its home shard. The offsets are those of the
+ * kafka high watermark, the records up to it are the ones visible to the
+ * consumers.
+ */
+static ss::future<delete_records_partition_result> delete_partition_records(
+  cluster::partition_manager& mgr,
+  const model::ntp& ntp,
+  model::offset offset,
+  model::timeout_clock::time_point deadline) {
+    const auto id = ntp.tp.partition;
+    auto partition = mgr.get(ntp);
+    if (!partition) {
+        return ss::make_ready_future<delete_records_partition_result>(
+          make_partition(
+            id, model::offset(-1), error_code::unknown_topic_or_partition));
+    }
+    if (!partition->is_leader()) {
+        return ss::make_ready_future<delete_records_partition_result>(
+          make_partition(
+            id, model::offset(-1), error_code::not_leader_for_partition));
+    }
+    // the records of compacted topics are only removed by compaction
+    if (!partition->log_config().is_collectable()) {
+        return ss::make_ready_future<delete_records_partition_result>(
+          make_partition(id, model::offset(-1), error_code::policy_violation));
+    }
+    const auto high_watermark = partition->last_stable_offset();
+    if (offset == delete_records_request::high_watermark) {
+        offset = high_watermark;
+    }
+    if (offset < model::offset(0) || offset > high_watermark) {
+        return ss::make_ready_future<delete_records_partition_result>(
+          make_partition(
+            id, model::offset(-1), error_code::offset_out_of_range));
+    }
+    // nothing left to delete below the offset
+    if (offset <= partition->start_offset()) {
+        return ss::make_ready_future<delete_records_partition_result>(
+          make_partition(id, partition->start_offset(), error_code::none));
+    }
+    return partition->prefix_truncate(offset, deadline)
+      .then([partition, id](std::error_code ec) {
+          if (ec) {
+              return make_partition(
+                id, model::offset(-1), map_delete_records_error(ec));
+          }
+          return make_partition(
+            id, partition->start_offset(), error_code::none);
+      });
+}
+
+ss::future<response_ptr>
+delete_records_api::process(request_context&& ctx, ss::smp_service_group ssg) {
+    delete_records_request request;
+    request.decode(ctx.reader(), ctx.header().version);
+    vlog(klog.trace, "Handling request {}", request);
+
+    return ss::do_with(
+      std::move(ctx),
+      std::move(request),
+      delete_records_response{},
+      [ssg](
+        request_context& ctx,
+        delete_records_request& request,
+        delete_records_response& response) {
+          const auto deadline = to_timeout(request.data.timeout_ms);
+          std::vector<ss::future<>> fs;
+          auto& topics = response.data.topics;
+          topics.reserve(request.data.topics.size());
+          for (auto& topic : request.data.topics) {
+              auto& tr = topics.emplace_back(
+                delete_records_topic_result{.name = topic.name});
+              // no resize past this point, the futures point into the
+              // partitions
+              tr.partitions.reserve(topic.partitions.size());
+              for (auto& part : topic.partitions) {
+                  auto& pr = tr.partitions.emplace_back(make_partition(
+                    part.partition_index,
+                    model::offset(-1),
+                    error_code::unknown_topic_or_partition));
+                  model::ntp ntp(
+                    cluster::kafka_namespace, topic.name, part.partition_index);
+                  if (!ctx.metadata_cache().contains(
+                        model::topic_namespace_view(ntp),
+                        part.partition_index)) {
+                      continue;
+                  }
+                  auto shard = ctx.shards().shard_for(ntp);
+                  if (!shard) {
+                      continue;
+                  }
+                  fs.push_back(
+                    ctx.partition_manager()
+                      .invoke_on(
+                        *shard,
+                        ssg,
+                        [ntp = std::move(ntp), offset = part.offset, deadline](
+                          cluster::partition_manager& mgr) {
+                            return delete_partition_records(
+                              mgr, ntp, offset, deadline);
+                        })
+                      .then_wrapped(
+                        [&pr](ss::future<delete_records_partition_result> f) {
+                            if (f.failed()) {
+                                vlog(
+                                  klog.warn,
+                                  "Error deleting records of partition {} - {}",
+                                  pr.partition_index,
+                                  f.get_exception());
+                                pr.error_code
+                                  = error_code::unknown_server_error;
+                                return;
+                            }
+                            pr = f.get0();
+                        }));
+              }
+          }
+          return ss::when_all_succeed(fs.begin(), fs.end())
+            .then([&ctx, &response] {
+                return ctx.respond(std::move(response));
+            });
+      });
+}
+
+} // namespace kafka
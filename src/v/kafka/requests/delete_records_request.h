@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+#pragma once
+
+#include "kafka/requests/request_context.h"
+#include "kafka/requests/response.h"
+#include "kafka/requests/schemata/delete_records_request.h"
+#include "kafka/requests/schemata/delete_records_response.h"
+#include "kafka/types.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+
+namespace kafka {
+
+struct delete_records_response;
+
+/**
+ * Moves the start offsets of partitions forward. The records below the new
+ * start offset are dropped by prefix truncation of the logs, whole segments
+ * are removed and no segment is rewritten, see
+ * raft::log_eviction_stm::truncate.
+ */
+class delete_records_api final {
+public:
+    using response_type = delete_records_response;
+
+    static constexpr const char* name = "delete records";
+    static constexpr api_key key = api_key(21);
+    static constexpr api_version min_supported = api_version(0);
+    static constexpr api_version max_supported = api_version(1);
+
+    static ss::future<response_ptr>
+    process(request_context&&, ss::smp_service_group);
+};
+
+struct delete_records_request final {
+    using api_type = delete_records_api;
+
+    // deletes all the records of the partition up to the high watermark
+    static constexpr model::offset high_watermark{-1};
+
+    delete_records_request_data data;
+
+    void encode(response_writer& writer, api_version version) {
+        data.encode(writer, version);
+    }
+
+    void decode(request_reader& reader, api_version version) {
+        data.decode(reader, version);
+    }
+};
+
+inline std::ostream&
+operator<<(std::ostream& os, const delete_records_request& r) {
+    return os << r.data;
+}
+
+struct delete_records_response final {
+    using api_type = delete_records_api;
+
+    delete_records_response_data data;
+
+    void encode(const request_context& ctx, response& resp) {
+        data.encode(resp.writer(), ctx.header().version);
+    }
+
+    void decode(iobuf buf, api_version version) {
+        data.decode(std::move(buf), version);
+    }
+};
+
+inline std::ostream&
+operator<<(std::ostream& os, const delete_records_response& r) {
+    return os << r.data;
+}
+
+} // namespace kafka
@@ -9,8 +9,11 @@
 
 #include "kafka/requests/fetch_request.h"
 
+#include "cluster/metadata_cache.h"
 #include "cluster/namespace.h"
 #include "cluster/partition_manager.h"
+#include "config/configuration.h"
+#include "kafka/down_conversion.h"
 #include "kafka/errors.h"
 #include "kafka/fetch_session.h"
 #include "kafka/requests/batch_consumer.h"
@@ -19,15 +22,21 @@
 #include "model/timeout_clock.h"
 #include "resource_mgmt/io_priority.h"
 #include "utils/to_string.h"
+#include "utils/vector_pool.h"
 
 #include <seastar/core/do_with.hh>
+#include <seastar/core/future-util.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/util/log.hh>
 
+#include <absl/container/flat_hash_map.h>
+#include <boost/range/irange.hpp>
+
 #include <fmt/ostream.h>
 
 #include <chrono>
+#include <limits>
 #include <string_view>
 
 namespace kafka {
@@ -76,6 +85,16 @@ void fetch_request::encode(response_writer& writer, api_version version) {
                 [](int32_t p, response_writer& writer) { writer.write(p); });
           });
     }
+    if (version >= api_version(11)) {
+        writer.write(rack_id);
+    }
+}
+
+void fetch_request::recycle() {
+    for (auto& t : topics) {
+        vector_pool<partition>::put(std::move(t.partitions));
+    }
+    vector_pool<topic>::put(std::move(topics));
 }
 
 void fetch_request::decode(request_context& ctx) {
@@ -85,35 +104,36 @@ void fetch_request::decode(request_context& ctx) {
     replica_id = model::node_id(reader.read_int32());
     max_wait_time = std::chrono::milliseconds(reader.read_int32());
     min_bytes = reader.read_int32();
-    if (version >= api_version(3)) {
-        max_bytes = reader.read_int32();
-    }
-    if (version >= api_version(4)) {
-        isolation_level = reader.read_int8();
-    }
+    // older versions have no response limit and read uncommitted
+    max_bytes = version >= api_version(3) ? reader.read_int32()
+                                          : std::numeric_limits<int32_t>::max();
+    isolation_level = version >= api_version(4) ? reader.read_int8() : 0;
 
     if (version >= api_version(7)) {
         session_id = reader.read_int32();
         session_epoch = reader.read_int32();
     }
-    topics = reader.read_array([version](request_reader& reader) {
-        return topic{
-          .name = model::topic(reader.read_string()),
-          .partitions = reader.read_array([version](request_reader& reader) {
-              partition p;
-              p.id = model::partition_id(reader.read_int32());
-              if (version >= api_version(9)) {
-                  p.current_leader_epoch = reader.read_int32();
-              }
-              p.fetch_offset = model::offset(reader.read_int64());
-              if (version >= api_version(5)) {
-                  p.log_start_offset = model::offset(reader.read_int64());
-              }
-              p.partition_max_bytes = reader.read_int32();
-              return p;
-          }),
-        };
-    });
+    topics = reader.read_array(
+      vector_pool<topic>::get(), [version](request_reader& reader) {
+          return topic{
+            .name = model::topic(reader.read_string()),
+            .partitions = reader.read_array(
+              vector_pool<partition>::get(),
+              [version](request_reader& reader) {
+                  partition p;
+                  p.id = model::partition_id(reader.read_int32());
+                  if (version >= api_version(9)) {
+                      p.current_leader_epoch = reader.read_int32();
+                  }
+                  p.fetch_offset = model::offset(reader.read_int64());
+                  if (version >= api_version(5)) {
+                      p.log_start_offset = model::offset(reader.read_int64());
+                  }
+                  p.partition_max_bytes = reader.read_int32();
+                  return p;
+              }),
+          };
+      });
     if (version >= api_version(7)) {
         forgotten_topics = reader.read_array([](request_reader& reader) {
             return forgotten_topic{
@@ -123,6 +143,9 @@ void fetch_request::decode(request_context& ctx) {
             };
         });
     }
+    if (version >= api_version(11)) {
+        rack_id = reader.read_string();
+    }
 }
 
 std::ostream&
@@ -150,7 +173,7 @@ std::ostream& operator<<(std::ostream& o, const fetch_request& r) {
     fmt::print(
       o,
       "{{replica {} max_wait_time {} session_id {} session_epoch {} min_bytes "
-      "{} max_bytes {} isolation {} topics {} forgotten {}}}",
+      "{} max_bytes {} isolation {} topics {} forgotten {} rack {}}}",
       r.replica_id,
       r.max_wait_time,
       r.session_id,
@@ -159,7 +182,8 @@ std::ostream& operator<<(std::ostream& o, const fetch_request& r) {
       r.max_bytes,
       r.isolation_level,
       r.topics,
-      r.forgotten_topics);
+      r.forgotten_topics,
+      r.rack_id);
     return o;
 }
 
@@ -167,7 +191,9 @@ void fetch_response::encode(const request_context& ctx, response& resp) {
     auto& writer = resp.writer();
     auto version = ctx.header().version;
 
-    writer.write(int32_t(throttle_time.count())); // v1
+    if (version >= api_version(1)) {
+        writer.write(int32_t(throttle_time.count()));
+    }
 
     if (version >= api_version(7)) {
         writer.write(error);
@@ -183,16 +209,25 @@ void fetch_response::encode(const request_context& ctx, response& resp) {
                 writer.write(r.id);
                 writer.write(r.error);
                 writer.write(int64_t(r.high_watermark));
-                writer.write(int64_t(r.last_stable_offset)); // v4
+                if (version >= api_version(4)) {
+                    writer.write(int64_t(r.last_stable_offset));
+                }
                 if (version >= api_version(5)) {
                     writer.write(int64_t(r.log_start_offset));
                 }
-                writer.write_array( // v4
-                  r.aborted_transactions,
-                  [](const aborted_transaction& t, response_writer& writer) {
-                      writer.write(t.producer_id);
-                      writer.write(int64_t(t.first_offset));
-                  });
+                if (version >= api_version(4)) {
+                    writer.write_array(
+                      r.aborted_transactions,
+                      [](
+                        const aborted_transaction& t,
+                        response_writer& writer) {
+                          writer.write(t.producer_id);
+                          writer.write(int64_t(t.first_offset));
+                      });
+                }
+                if (version >= api_version(11)) {
+                    writer.write(r.preferred_read_replica);
+                }
                 writer.write(std::move(r.record_set));
             });
       });
@@ -201,7 +236,8 @@ void fetch_response::encode(const request_context& ctx, response& resp) {
 void fetch_response::decode(iobuf buf, api_version version) {
     request_reader reader(std::move(buf));
 
-    throttle_time = std::chrono::milliseconds(reader.read_int32()); // v1
+    throttle_time = std::chrono::milliseconds(
+      version >= api_version(1) ? reader.read_int32() : 0);
 
     error = version >= api_version(7) ? error_code(reader.read_int16())
                                       : kafka::error_code::none;
@@ -215,16 +251,21 @@ void fetch_response::decode(iobuf buf, api_version version) {
               .id = model::partition_id(reader.read_int32()),
               .error = error_code(reader.read_int16()),
               .high_watermark = model::offset(reader.read_int64()),
-              .last_stable_offset = model::offset(reader.read_int64()), // v4
+              .last_stable_offset = model::offset(
+                version >= api_version(4) ? reader.read_int64() : -1),
               .log_start_offset = model::offset(
                 version >= api_version(5) ? reader.read_int64() : -1),
-              .aborted_transactions = reader.read_array( // v4
-                [](request_reader& reader) {
-                    return aborted_transaction{
-                      .producer_id = reader.read_int64(),
-                      .first_offset = model::offset(reader.read_int64()),
-                    };
-                }),
+              .aborted_transactions
+              = version >= api_version(4)
+                  ? reader.read_array([](request_reader& reader) {
+                        return aborted_transaction{
+                          .producer_id = reader.read_int64(),
+                          .first_offset = model::offset(reader.read_int64()),
+                        };
+                    })
+                  : std::vector<aborted_transaction>{},
+              .preferred_read_replica = model::node_id(
+                version >= api_version(11) ? reader.read_int32() : -1),
               .record_set = reader.read_fragmented_nullable_bytes()};
         });
         return p;
@@ -243,12 +284,13 @@ operator<<(std::ostream& o, const fetch_response::partition_response& p) {
     fmt::print(
       o,
       "{{id {} err {} high_water {} last_stable_off {} aborted {} "
-      "record_set_len {}}}",
+      "preferred_replica {} record_set_len {}}}",
       p.id,
       p.error,
       p.high_watermark,
       p.last_stable_offset,
       p.aborted_transactions,
+      p.preferred_read_replica,
       (p.record_set ? p.record_set->size_bytes() : -1));
     return o;
 }
@@ -282,6 +324,14 @@ make_partition_response_error(model::partition_id p_id, error_code error) {
     };
 }
 
+/**
+ * Offset following the last visible one, the high watermark of the kafka
+ * protocol
+ */
+static model::offset kafka_high_watermark(model::offset o) {
+    return o < model::offset(0) ? model::offset(0) : o + model::offset(1);
+}
+
 static ss::future<fetch_response::partition_response>
 make_ready_partition_response_error(error_code error) {
     return ss::make_ready_future<fetch_response::partition_response>(
@@ -299,6 +349,7 @@ static ss::future<read_result> read_from_partition(
   std::optional<model::timeout_clock::time_point> deadline) {
     auto hw = pw.high_watermark();
     auto lso = pw.last_stable_offset();
+    pw.probe().request();
     // if we have no data read, return fast
     if (hw < config.start_offset) {
         return ss::make_ready_future<read_result>(hw, lso);
@@ -316,12 +367,19 @@ static ss::future<read_result> read_from_partition(
 
     reader_config.strict_max_bytes = config.strict_max_bytes;
     return pw.make_reader(reader_config)
-      .then([hw, lso, foreign_read, deadline](model::record_batch_reader rdr) {
+      .then([pw, hw, lso, foreign_read, deadline](
+              model::record_batch_reader rdr) mutable {
           // if we are on remote core, we MUST use foreign record batch reader.
           if (foreign_read) {
               return model::consume_reader_to_memory(
                        std::move(rdr), deadline.value_or(model::no_timeout))
-                .then([hw, lso](ss::circular_buffer<model::record_batch> data) {
+                .then([pw, hw, lso](
+                        ss::circular_buffer<model::record_batch> data) mutable {
+                    uint64_t bytes = 0;
+                    for (const auto& b : data) {
+                        bytes += b.size_bytes();
+                    }
+                    pw.probe().add_bytes_fetched(bytes);
                     return read_result(
                       model::make_foreign_memory_record_batch_reader(
                         std::move(data)),
@@ -329,8 +387,158 @@ static ss::future<read_result> read_from_partition(
                       lso);
                 });
           }
-          return ss::make_ready_future<read_result>(
-            read_result(std::move(rdr), hw, lso));
+          read_result res(std::move(rdr), hw, lso);
+          res.local_partition = pw.partition();
+          return ss::make_ready_future<read_result>(std::move(res));
+      });
+}
+
+/**
+ * Reads from an ntp, runs on the ntp's home core.
+ */
+static ss::future<read_result> read_from_home_partition(
+  cluster::partition_manager& mgr,
+  const model::materialized_ntp& mntpv,
+  raft::group_id group,
+  fetch_config config,
+  bool foreign_read,
+  std::optional<model::timeout_clock::time_point> deadline) {
+    /*
+     * lookup the ntp's partition, by the group of its source ntp
+     */
+    auto partition = mgr.partition_for(group);
+    if (unlikely(!partition)) {
+        return ss::make_ready_future<read_result>(
+          error_code::unknown_topic_or_partition);
+    }
+    const bool leader = partition->is_leader();
+    if (unlikely(
+          !leader && (!config.follower_read || mntpv.is_materialized()))) {
+        return ss::make_ready_future<read_result>(
+          error_code::not_leader_for_partition);
+    }
+    if (mntpv.is_materialized()) {
+        if (auto log = mgr.log(mntpv.input_ntp())) {
+            return read_from_partition(
+              partition_wrapper(partition, log),
+              config,
+              foreign_read,
+              deadline);
+        } else {
+            return ss::make_ready_future<read_result>(
+              error_code::unknown_topic_or_partition);
+        }
+    }
+
+    auto max_offset = kafka_high_watermark(partition->high_watermark());
+    if (config.start_offset < partition->start_offset()) {
+        return ss::make_ready_future<read_result>(
+          error_code::offset_out_of_range);
+    }
+    if (config.start_offset > max_offset) {
+        // a follower may not know yet what the leader made visible
+        if (leader) {
+            return ss::make_ready_future<read_result>(
+              error_code::offset_out_of_range);
+        }
+        return ss::make_ready_future<read_result>(
+          partition->high_watermark(), partition->last_stable_offset());
+    }
+    if (leader && config.preferred_read_replica) {
+        // the consumer reads from the replica in its rack from now on
+        read_result res(
+          partition->high_watermark(), partition->last_stable_offset());
+        res.preferred_read_replica = *config.preferred_read_replica;
+        return ss::make_ready_future<read_result>(std::move(res));
+    }
+
+    return read_from_partition(
+      partition_wrapper(partition), config, foreign_read, deadline);
+}
+
+/**
+ * Serializes the batches of a read into a legacy message set for consumers
+ * fetching with a version older than the v2 record batch format, the
+ * conversions are shared among them through the down conversion cache.
+ */
+static ss::future<iobuf> make_legacy_record_set(
+  op_context& octx,
+  const model::topic_partition_view& tp,
+  model::record_batch_reader reader,
+  int8_t magic,
+  model::timeout_clock::time_point timeout) {
+    auto& cache = octx.rctx.down_conversions();
+    model::ntp ntp(cluster::kafka_namespace, model::topic_partition(tp));
+    return std::move(reader)
+      .consume(legacy_batch_serializer(cache, std::move(ntp), magic), timeout)
+      .then([&octx, &cache](legacy_batch_serializer::result res) {
+          cache.record_client(
+            octx.rctx.header().client_id,
+            res.batch_count,
+            res.data.size_bytes());
+          return std::move(res.data);
+      });
+}
+
+/**
+ * Serializes a read into a partition response, runs on the core of the
+ * request.
+ */
+static ss::future<fetch_response::partition_response>
+make_partition_response(
+  op_context& octx,
+  const model::topic_partition_view& tp,
+  read_result res,
+  model::timeout_clock::time_point timeout) {
+    vlog(klog.trace, "fetch reader {}", res.reader);
+    // error case
+    if (res.error != error_code::none) {
+        return make_ready_partition_response_error(res.error);
+    }
+    auto hw = kafka_high_watermark(res.high_watermark);
+    auto lso = kafka_high_watermark(res.last_stable_offset);
+    if (!res.reader) {
+        return ss::make_ready_future<fetch_response::partition_response>(
+          fetch_response::partition_response{
+            .error = error_code::none,
+            .high_watermark = hw,
+            .last_stable_offset = lso,
+            .preferred_read_replica = res.preferred_read_replica,
+            .record_set = iobuf(),
+          });
+    }
+    auto count_bytes = [p = std::move(res.local_partition)](const iobuf& b) {
+        if (p) {
+            p->probe().add_bytes_fetched(b.size_bytes());
+        }
+    };
+    if (auto magic = legacy_magic(octx.rctx.header().version); magic) {
+        return make_legacy_record_set(
+                 octx, tp, std::move(*res.reader), *magic, timeout)
+          .then([hw, lso, count_bytes = std::move(count_bytes)](iobuf data) {
+              count_bytes(data);
+              return fetch_response::partition_response{
+                .error = error_code::none,
+                .high_watermark = hw,
+                .last_stable_offset = lso,
+                .record_set = std::move(data),
+              };
+          });
+    }
+    return std::move(*res.reader)
+      .consume(kafka_batch_serializer(), timeout)
+      .then([hw, lso, count_bytes = std::move(count_bytes)](
+              kafka_batch_serializer::result res) mutable {
+          count_bytes(res.data);
+          /*
+           * return path will fill in other response fields.
+           */
+          return fetch_response::partition_response{
+            .error = error_code::none,
+            .high_watermark = hw,
+            .last_stable_offset = lso,
+            .record_set = std::move(res.data),
+          };
       });
 }
 
@@ -345,126 +553,72 @@ read_from_ntp(op_context& octx, model::ntp ntp, fetch_config config) {
      * the tp in the metadata cache so that this condition is unlikely
      * to pass.
      */
-    auto mntpv = model::materialized_ntp(std::move(ntp));
-    auto shard = octx.rctx.shards().shard_for(mntpv.source_ntp());
+    auto mntpv = model::materialized_ntp(ntp);
+    auto location = octx.rctx.shards().locate(mntpv.source_ntp());
 
-    if (unlikely(!shard)) {
+    if (unlikely(!location)) {
         return make_ready_partition_response_error(
           error_code::unknown_topic_or_partition);
     }
-    bool foreign_read = shard != ss::this_shard_id();
+    bool foreign_read = location->shard != ss::this_shard_id();
 
     return octx.rctx.partition_manager()
       .invoke_on(
-        *shard,
+        location->shard,
         octx.ssg,
         [mntpv = std::move(mntpv),
+         group = location->group,
          foreign_read,
          config,
          deadline = octx.deadline](cluster::partition_manager& mgr) {
-            /*
-             * lookup the ntp's partition
-             */
-            auto partition = mgr.get(mntpv.source_ntp());
-            if (unlikely(!partition)) {
-                return ss::make_ready_future<read_result>(
-                  error_code::unknown_topic_or_partition);
-            }
-            if (unlikely(!partition->is_leader())) {
-                return ss::make_ready_future<read_result>(
-                  error_code::not_leader_for_partition);
-            }
-            if (mntpv.is_materialized()) {
-                if (auto log = mgr.log(mntpv.input_ntp())) {
-                    return read_from_partition(
-                      partition_wrapper(partition, log),
-                      config,
-                      foreign_read,
-                      deadline);
-                } else {
-                    return ss::make_ready_future<read_result>(
-                      error_code::unknown_topic_or_partition);
-                }
-            }
-
-            auto high_watermark = partition->high_watermark();
-            auto max_offset = high_watermark < model::offset(0)
-                                ? model::offset(0)
-                                : high_watermark + model::offset(1);
-            if (
-              config.start_offset < partition->start_offset()
-              || config.start_offset > max_offset) {
-                return ss::make_ready_future<read_result>(
-                  error_code::offset_out_of_range);
-            }
-
-            return read_from_partition(
-              partition_wrapper(partition), config, foreign_read, deadline);
+            return read_from_home_partition(
+              mgr, mntpv, group, config, foreign_read, deadline);
         })
-      .then([timeout = config.timeout](read_result res) mutable {
-          vlog(klog.trace, "fetch reader {}", res.reader);
-          // error case
-          if (!res.reader) {
-              return make_ready_partition_response_error(res.error);
-          }
-          return std::move(*res.reader)
-            .consume(kafka_batch_serializer(), timeout)
-            .then([](kafka_batch_serializer::result res) mutable {
-                /*
-                 * return path will fill in other response fields.
-                 */
-                return fetch_response::partition_response{
-                  .error = error_code::none,
-                  .record_set = std::move(res.data),
-                };
-            });
+      .then([&octx, ntp = std::move(ntp), timeout = config.timeout](
+              read_result res) mutable {
+          return make_partition_response(
+            octx,
+            model::topic_partition_view(ntp.tp.topic, ntp.tp.partition),
+            std::move(res),
+            timeout);
       });
 }
 
 /**
- * Top-level handler for fetching from a topic-partition. The result is
- * unwrapped and any errors from the storage sub-system are translated
- * into kafka specific response codes. On failure or success the
- * partition response is finalized and placed into its position in the
- * response message.
+ * Places the response of a partition into its position in the response
+ * message. Any errors from the storage sub-system are translated into kafka
+ * specific response codes.
  */
-static ss::future<> handle_ntp_fetch(
-  op_context& octx,
-  model::ntp ntp,
-  fetch_config config,
-  op_context::response_iterator resp_it) {
-    using read_response_type = ss::future<fetch_response::partition_response>;
-    auto p_id = ntp.tp.partition;
-    return read_from_ntp(octx, std::move(ntp), config)
-      .then_wrapped([p_id, resp_it](read_response_type&& f) mutable {
-          try {
-              auto response = f.get0();
-              response.id = p_id;
-              resp_it.set(std::move(response));
-          } catch (...) {
-              /*
-               * TODO: this is where we will want to handle any storage
-               * specific errors and translate them into kafka response
-               * error codes.
-               */
-              resp_it.set(make_partition_response_error(
-                p_id, error_code::unknown_server_error));
-          }
-      });
+static void set_partition_response(
+  op_context::response_iterator& resp_it,
+  model::partition_id p_id,
+  ss::future<fetch_response::partition_response> f) {
+    try {
+        auto response = f.get0();
+        response.id = p_id;
+        resp_it.set(std::move(response));
+    } catch (...) {
+        /*
+         * TODO: this is where we will want to handle any storage
+         * specific errors and translate them into kafka response
+         * error codes.
+         */
+        resp_it.set(make_partition_response_error(
+          p_id, error_code::unknown_server_error));
+    }
 }
 
-static ss::future<> fetch_topic_partition(
-  op_context& octx,
+/**
+ * Config of the next read of a topic-partition, none when it is not read in
+ * this round.
+ */
+static std::optional<fetch_config> make_fetch_config(
+  const op_context& octx,
   const fetch_partition& fp,
-  op_context::response_iterator resp_it) {
-    /*
-     * the next topic-partition to fetch
-     */
-    auto& topic = fp.topic;
-
+  op_context::response_iterator& resp_it) {
     // if over budget skip the fetch.
     if (octx.bytes_left <= 0) {
-        return ss::now();
+        return std::nullopt;
     }
 
     // if we already have data in response for this partition skip it
@@ -479,18 +633,121 @@ static ss::future<> fetch_topic_partition(
         if (
           partition_response->has_error()
           || (!partition_response->record_set->empty() && octx.over_min_bytes())) {
-            return ss::now();
+            return std::nullopt;
         }
     }
-    auto ntp = model::ntp(cluster::kafka_namespace, topic, fp.partition);
 
     fetch_config config{
       .start_offset = fp.fetch_offset,
       .max_bytes = std::min(octx.bytes_left, size_t(fp.max_bytes)),
       .timeout = octx.deadline.value_or(model::no_timeout),
       .strict_max_bytes = octx.response_size > 0,
+      .follower_read = octx.follower_read(),
     };
-    return handle_ntp_fetch(octx, std::move(ntp), config, resp_it);
+    if (
+      config.follower_read && !octx.request.rack_id.empty()
+      && config::shard_local_cfg().kafka_follower_fetching_enabled()) {
+        auto replica = octx.rctx.metadata_cache().get_preferred_read_replica(
+          model::ntp(cluster::kafka_namespace, fp.topic, fp.partition),
+          octx.request.rack_id);
+        // the leaders table may lag behind the leadership of this node
+        if (replica != config::shard_local_cfg().node_id()) {
+            config.preferred_read_replica = replica;
+        }
+    }
+    return config;
+}
+
+/**
+ * Reads of a fetch round going to the same shard
+ */
+struct shard_fetch {
+    std::vector<model::materialized_ntp> ntps;
+    // groups of the source ntps, see shard_table::locate
+    std::vector<raft::group_id> groups;
+    std::vector<fetch_config> configs;
+    std::vector<op_context::response_iterator> responses;
+};
+
+/**
+ * Reads the partitions of a shard with a single cross core call, the reads
+ * run concurrently on the shard. The results are serialized back on the
+ * core of the request and placed at the positions of their partitions.
+ */
+static ss::future<>
+fetch_shard_partitions(op_context& octx, ss::shard_id shard, shard_fetch f) {
+    const bool foreign_read = shard != ss::this_shard_id();
+    auto ntps = std::move(f.ntps);
+    auto groups = std::move(f.groups);
+    auto configs = f.configs;
+    return octx.rctx.partition_manager()
+      .invoke_on(
+        shard,
+        octx.ssg,
+        [ntps = std::move(ntps),
+         groups = std::move(groups),
+         configs = std::move(configs),
+         foreign_read,
+         deadline = octx.deadline](cluster::partition_manager& mgr) {
+            std::vector<ss::future<read_result>> reads;
+            reads.reserve(ntps.size());
+            for (size_t i = 0; i < ntps.size(); ++i) {
+                reads.push_back(
+                  ss::futurize_invoke(
+                    read_from_home_partition,
+                    mgr,
+                    ntps[i],
+                    groups[i],
+                    configs[i],
+                    foreign_read,
+                    deadline)
+                    .handle_exception([](const std::exception_ptr& e) {
+                        vlog(klog.warn, "Error reading partition - {}", e);
+                        return read_result(error_code::unknown_server_error);
+                    }));
+            }
+            return ss::do_with(
+              std::move(reads), [](std::vector<ss::future<read_result>>& rs) {
+                  return ss::when_all_succeed(rs.begin(), rs.end());
+              });
+        })
+      .then_wrapped([&octx, f = std::move(f)](
+                      ss::future<std::vector<read_result>> results) mutable {
+          if (results.failed()) {
+              auto e = results.get_exception();
+              vlog(klog.warn, "Error reading partitions - {}", e);
+              for (auto& resp_it : f.responses) {
+                  resp_it.set(make_partition_response_error(
+                    resp_it->partition_response->id,
+                    error_code::unknown_server_error));
+              }
+              return ss::now();
+          }
+          return ss::do_with(
+            results.get0(),
+            std::move(f),
+            [&octx](std::vector<read_result>& results, shard_fetch& f) {
+                return ss::parallel_for_each(
+                  boost::irange<size_t>(0, results.size()),
+                  [&octx, &results, &f](size_t i) {
+                      auto& resp_it = f.responses[i];
+                      auto p_id = resp_it->partition_response->id;
+                      return make_partition_response(
+                               octx,
+                               model::topic_partition_view(
+                                 resp_it->partition->name, p_id),
+                               std::move(results[i]),
+                               f.configs[i].timeout)
+                        .then_wrapped(
+                          [&resp_it, p_id](
+                            ss::future<fetch_response::partition_response>
+                              r) mutable {
+                              set_partition_response(
+                                resp_it, p_id, std::move(r));
+                          });
+                  });
+            });
+      });
 }
 
 /**
@@ -517,30 +774,299 @@ static ss::future<> fetch_topic_partition(
  * order as the partitions in the request.
  */
 
-static ss::future<> fetch_topic_partitions(op_context& octx) {
+/**
+ * Partition a parked fetch is waiting on. When the partition already
+ * contributed data to the response we wait for the high watermark to move
+ * past its current value, otherwise for the fetch offset to become visible.
+ */
+struct fetch_wait_partition {
+    model::ntp ntp;
+    model::offset fetch_offset;
+    bool has_data;
+};
+
+/**
+ * One shot notification resolved by the first of many concurrent waits. It is
+ * only ever accessed from the shard it was created on.
+ */
+class fetch_wakeup {
+public:
+    ss::future<> get_future() { return _promise.get_future(); }
+
+    void wake() {
+        if (!_woken) {
+            _woken = true;
+            _promise.set_value();
+        }
+    }
+
+private:
+    ss::promise<> _promise;
+    bool _woken = false;
+};
+
+/**
+ * Park on the partitions of a single shard. The returned future resolves when
+ * any of the partitions has new data visible or the deadline expires. Waiters
+ * left behind by the first wakeup are released by the deadline or when the
+ * partition is stopped.
+ */
+static ss::future<> wait_for_shard_partitions(
+  cluster::partition_manager& mgr,
+  std::vector<fetch_wait_partition> partitions,
+  bool follower_read,
+  model::timeout_clock::time_point deadline) {
+    auto wakeup = ss::make_lw_shared<fetch_wakeup>();
+    auto f = wakeup->get_future();
+    for (auto& wp : partitions) {
+        auto mntpv = model::materialized_ntp(std::move(wp.ntp));
+        auto partition = mgr.get(mntpv.source_ntp());
+        if (
+          unlikely(
+            !partition || (!partition->is_leader() && !follower_read))
+          || mntpv.is_materialized()) {
+            /*
+             * materialized logs are not backed by raft and do not provide
+             * visibility notifications, fallback to debounced polling. The
+             * same applies to partitions that moved away, next read round
+             * will report an error for them.
+             */
+            (void)ss::sleep(fetch_reads_debounce_timeout).then([wakeup] {
+                wakeup->wake();
+            });
+            continue;
+        }
+        auto offset = wp.has_data
+                        ? partition->high_watermark() + model::offset(1)
+                        : wp.fetch_offset;
+        (void)partition->wait_for_high_watermark(offset, deadline)
+          .then_wrapped([wakeup](ss::future<> f) {
+              // timeouts and aborts end the wait as well
+              f.ignore_ready_future();
+              wakeup->wake();
+          });
+    }
+    return f;
+}
+
+/**
+ * Instead of polling all the partitions every debounce interval, park the
+ * fetch until any of the partitions it reads from makes new data visible (or
+ * the request deadline expires). Partitions are grouped by their home shard so
+ * that a single cross core call is issued per shard.
+ */
+static ss::future<> wait_for_new_data(op_context& octx) {
+    absl::flat_hash_map<ss::shard_id, std::vector<fetch_wait_partition>>
+      by_shard;
     auto resp_it = octx.response_begin();
-    std::vector<ss::future<>> fetches;
+    octx.for_each_fetch_partition(
+      [&octx, &resp_it, &by_shard](const fetch_partition& fp) {
+          auto& resp = *resp_it->partition_response;
+          ++resp_it;
+          if (resp.has_error()) {
+              return;
+          }
+          auto ntp = model::ntp(
+            cluster::kafka_namespace, fp.topic, fp.partition);
+          auto shard = octx.rctx.shards().shard_for(
+            model::materialized_ntp(ntp).source_ntp());
+          if (unlikely(!shard)) {
+              return;
+          }
+          by_shard[*shard].push_back(fetch_wait_partition{
+            .ntp = std::move(ntp),
+            .fetch_offset = fp.fetch_offset,
+            .has_data = resp.record_set && !resp.record_set->empty(),
+          });
+      });
+
+    if (by_shard.empty()) {
+        return ss::now();
+    }
+
+    auto deadline = octx.deadline.value_or(model::no_timeout);
+    auto wakeup = ss::make_lw_shared<fetch_wakeup>();
+    auto f = wakeup->get_future();
+    for (auto& [shard, partitions] : by_shard) {
+        (void)octx.rctx.partition_manager()
+          .invoke_on(
+            shard,
+            octx.ssg,
+            [partitions = std::move(partitions),
+             follower_read = octx.follower_read(),
+             deadline](cluster::partition_manager& mgr) mutable {
+                return wait_for_shard_partitions(
+                  mgr, std::move(partitions), follower_read, deadline);
+            })
+          .then_wrapped([wakeup](ss::future<> f) {
+              f.ignore_ready_future();
+              wakeup->wake();
+          });
+    }
+    return f;
+}
+
+/**
+ * Caught up partitions of an incremental fetch session probed on one shard
+ */
+struct session_probe {
+    // position of the partitions in the session
+    std::vector<size_t> positions;
+    // high watermarks of the previous response
+    std::vector<model::offset> high_watermarks;
+    std::vector<model::ntp> ntps;
+};
 
+/**
+ * The partitions of an incremental fetch session whose fetch offset was the
+ * high watermark of the previous response have nothing to read for as long
+ * as the high watermark stays the same, and they are left out of the
+ * response. Instead of a read per partition their high watermarks are looked
+ * up with one cross core call per shard, the unchanged ones are not read.
+ */
+static ss::future<> probe_session_partitions(op_context& octx) {
+    octx.unchanged_partitions.clear();
+    if (octx.session_ctx.is_sessionless() || octx.session_ctx.is_full_fetch()) {
+        return ss::now();
+    }
+    octx.unchanged_partitions.resize(
+      octx.session_ctx.session()->partitions().size(), false);
+
+    absl::flat_hash_map<ss::shard_id, session_probe> by_shard;
+    auto resp_it = octx.response_begin();
+    size_t position = 0;
     octx.for_each_fetch_partition(
-      [&resp_it, &octx, &fetches](fetch_partition p) {
-          // we use gate as we may not wait for all the fetch results
-          return fetches.push_back(fetch_topic_partition(octx, p, resp_it++));
+      [&octx, &resp_it, &position, &by_shard](const fetch_partition& fp) {
+          auto& resp = *resp_it->partition_response;
+          ++resp_it;
+          const auto pos = position++;
+          if (
+            resp.has_error() || (resp.record_set && !resp.record_set->empty())
+            || fp.high_watermark < model::offset(0)
+            || fp.fetch_offset != fp.high_watermark) {
+              return;
+          }
+          auto ntp = model::ntp(
+            cluster::kafka_namespace, fp.topic, fp.partition);
+          // materialized logs have no high watermark of their own
+          if (model::materialized_ntp(ntp).is_materialized()) {
+              return;
+          }
+          auto shard = octx.rctx.shards().shard_for(ntp);
+          if (unlikely(!shard)) {
+              return;
+          }
+          auto& probe = by_shard[*shard];
+          probe.positions.push_back(pos);
+          probe.high_watermarks.push_back(fp.high_watermark);
+          probe.ntps.push_back(std::move(ntp));
       });
 
+    if (by_shard.empty()) {
+        return ss::now();
+    }
     return ss::do_with(
-      std::move(fetches), [&octx](std::vector<ss::future<>>& fetches) {
-          return ss::when_all_succeed(fetches.begin(), fetches.end())
-            .then([&octx] {
-                if (octx.should_stop_fetch()) {
-                    return ss::now();
-                }
-                octx.reset_context();
-                // debounce next read retry
-                return ss::sleep(std::min(
-                  fetch_reads_debounce_timeout, octx.request.max_wait_time));
-            });
+      std::move(by_shard),
+      [&octx](absl::flat_hash_map<ss::shard_id, session_probe>& by_shard) {
+          return ss::parallel_for_each(by_shard, [&octx](auto& e) {
+              auto& probe = e.second;
+              return octx.rctx.partition_manager()
+                .invoke_on(
+                  e.first,
+                  octx.ssg,
+                  [ntps = std::move(probe.ntps),
+                   follower_read = octx.follower_read()](
+                    cluster::partition_manager& mgr) {
+                      std::vector<model::offset> ret;
+                      ret.reserve(ntps.size());
+                      for (auto& ntp : ntps) {
+                          auto partition = mgr.get(ntp);
+                          // the read reports why the partition is not here
+                          ret.push_back(
+                            partition
+                                && (partition->is_leader() || follower_read)
+                              ? kafka_high_watermark(
+                                partition->high_watermark())
+                              : model::offset(-1));
+                      }
+                      return ret;
+                  })
+                .then([&octx, &probe](std::vector<model::offset> hws) {
+                    for (size_t i = 0; i < hws.size(); ++i) {
+                        if (hws[i] == probe.high_watermarks[i]) {
+                            octx.unchanged_partitions[probe.positions[i]]
+                              = true;
+                        }
+                    }
+                });
+          });
       });
-} // namespace kafka
+}
+
+/**
+ * One read round over the partitions of the fetch.
+ *
+ * The partitions to read are grouped by their home shard, every shard is
+ * called once per round with all of its partitions instead of once per
+ * partition. The results land at the positions of their partitions, the
+ * response keeps the order of the request.
+ */
+static ss::future<> fetch_topic_partitions(op_context& octx) {
+    return probe_session_partitions(octx).then([&octx] {
+        auto resp_it = octx.response_begin();
+        absl::flat_hash_map<ss::shard_id, shard_fetch> by_shard;
+        size_t position = 0;
+
+        octx.for_each_fetch_partition(
+          [&resp_it, &octx, &by_shard, &position](const fetch_partition& p) {
+              auto it = resp_it++;
+              if (octx.is_unchanged(position++)) {
+                  return;
+              }
+              auto config = make_fetch_config(octx, p, it);
+              if (!config) {
+                  return;
+              }
+              auto mntpv = model::materialized_ntp(
+                model::ntp(cluster::kafka_namespace, p.topic, p.partition));
+              /*
+               * lookup the home shard for this ntp. the caller should check
+               * for the tp in the metadata cache so that this condition is
+               * unlikely to pass.
+               */
+              auto location = octx.rctx.shards().locate(mntpv.source_ntp());
+              if (unlikely(!location)) {
+                  it.set(make_partition_response_error(
+                    p.partition, error_code::unknown_topic_or_partition));
+                  return;
+              }
+              auto& f = by_shard[location->shard];
+              f.ntps.push_back(std::move(mntpv));
+              f.groups.push_back(location->group);
+              f.configs.push_back(*config);
+              f.responses.push_back(it);
+          });
+
+        return ss::do_with(
+          std::move(by_shard),
+          [&octx](absl::flat_hash_map<ss::shard_id, shard_fetch>& by_shard) {
+              return ss::parallel_for_each(
+                       by_shard,
+                       [&octx](auto& e) {
+                           return fetch_shard_partitions(
+                             octx, e.first, std::move(e.second));
+                       })
+                .then([&octx] {
+                    if (octx.should_stop_fetch()) {
+                        return ss::now();
+                    }
+                    octx.reset_context();
+                    // park until any of the partitions has new data
+                    return wait_for_new_data(octx);
+                });
+          });
+    });
+}
 
 ss::future<response_ptr>
 fetch_api::process(request_context&& rctx, ss::smp_service_group ssg) {
@@ -558,7 +1084,8 @@ fetch_api::process(request_context&& rctx, ss::smp_service_group ssg) {
                 [&octx] { return octx.should_stop_fetch(); },
                 [&octx] { return fetch_topic_partitions(octx); });
           })
-          .then([&octx] { return std::move(octx).send_response(); });
+          .then([&octx] { return std::move(octx).send_response(); })
+          .finally([&octx] { octx.request.recycle(); });
     });
 }
 
@@ -630,12 +1157,14 @@ void op_context::create_response_placeholders() {
                   response.partitions.emplace_back(fp.topic);
                   last_topic = fp.topic;
               }
+              // left out of the response unless a read changes it
               fetch_response::partition_response p{
                 .id = fp.partition,
                 .error = error_code::none,
                 .high_watermark = fp.high_watermark,
                 .last_stable_offset = fp.high_watermark,
-                .record_set = iobuf()};
+                .record_set = iobuf(),
+                .has_to_be_included = false};
 
               response.partitions.back().responses.push_back(std::move(p));
           });
@@ -649,6 +1178,10 @@ bool update_fetch_partition(
         // Partitions with new data are always included in the response.
         include = true;
     }
+    if (resp.preferred_read_replica >= model::node_id(0)) {
+        // So are the ones pointing the consumer to another replica.
+        include = true;
+    }
     if (partition.high_watermark != resp.high_watermark) {
         partition.high_watermark = model::offset(resp.high_watermark);
         return true;
@@ -695,6 +1228,8 @@ ss::future<response_ptr> op_context::send_response() && {
           .log_start_offset = it->partition_response->log_start_offset,
           .aborted_transactions = std::move(
             it->partition_response->aborted_transactions),
+          .preferred_read_replica
+          = it->partition_response->preferred_read_replica,
           .record_set = std::move(it->partition_response->record_set)};
 
         final_response.partitions.back().responses.push_back(std::move(r));
@@ -32,8 +32,9 @@ struct fetch_api final {
 
     static constexpr const char* name = "fetch";
     static constexpr api_key key = api_key(1);
-    static constexpr api_version min_supported = api_version(4);
-    static constexpr api_version max_supported = api_version(10);
+    // versions before 4 are served legacy message sets, see down_conversion.h
+    static constexpr api_version min_supported = api_version(0);
+    static constexpr api_version max_supported = api_version(11);
 
     static ss::future<response_ptr>
     process(request_context&&, ss::smp_service_group);
@@ -71,10 +72,15 @@ struct fetch_request final {
     int32_t session_epoch = final_fetch_session_epoch; // >= v7
     std::vector<topic> topics;
     std::vector<forgotten_topic> forgotten_topics; // >= v7
+    ss::sstring rack_id;                           // >= v11
 
     void encode(response_writer& writer, api_version version);
     void decode(request_context& ctx);
 
+    /// Gives the decoded vectors back to the pools of the shard, the
+    /// request is empty afterwards.
+    void recycle();
+
     /*
      * For max_wait_time > 0 the request may be debounced in order to collect
      * additional data for the response. Otherwise, no such delay is requested.
@@ -220,6 +226,7 @@ struct fetch_response final {
         model::offset last_stable_offset;                      // >= v4
         model::offset log_start_offset;                        // >= v5
         std::vector<aborted_transaction> aborted_transactions; // >= v4
+        model::node_id preferred_read_replica{-1};             // >= v11
         std::optional<iobuf> record_set;
         /*
          * _not part of kafka protocol
@@ -249,6 +256,9 @@ struct fetch_response final {
     int32_t session_id; // >= v7
     std::vector<partition> partitions;
 
+    // large responses, sized before they are encoded
+    static constexpr bool presized_encoding = true;
+
     void encode(const request_context& ctx, response& resp);
     void decode(iobuf buf, api_version version);
 
@@ -419,6 +429,12 @@ struct op_context {
                || response_error || deadline <= model::timeout_clock::now();
     }
 
+    /// consumers fetching with v11 may read from followers
+    bool follower_read() const {
+        return rctx.header().version >= api_version(11)
+               && request.replica_id < model::node_id(0);
+    }
+
     bool over_min_bytes() const {
         return static_cast<int32_t>(response_size) >= request.min_bytes;
     }
@@ -471,6 +487,14 @@ struct op_context {
 
     bool initial_fetch = true;
     fetch_session_ctx session_ctx;
+    // partitions of an incremental fetch session, in session order, whose
+    // high watermark did not move since their fetch offset caught up with it
+    std::vector<bool> unchanged_partitions;
+
+    bool is_unchanged(size_t position) const {
+        return position < unchanged_partitions.size()
+               && unchanged_partitions[position];
+    }
 };
 
 class partition_wrapper {
@@ -489,6 +513,10 @@ public:
 
     cluster::partition_probe& probe() { return _partition->probe(); }
 
+    ss::lw_shared_ptr<cluster::partition> partition() const {
+        return _partition;
+    }
+
     model::offset high_watermark() const {
         return _log ? _log->offsets().dirty_offset
                     : _partition->high_watermark();
@@ -509,6 +537,9 @@ struct fetch_config {
     size_t max_bytes;
     model::timeout_clock::time_point timeout;
     bool strict_max_bytes{false};
+    bool follower_read{false};
+    // replica the consumer is pointed to if this node leads the partition
+    std::optional<model::node_id> preferred_read_replica;
 };
 /**
  * Simple type aggregating either reader and offsets or an error
@@ -533,6 +564,10 @@ struct read_result {
     model::offset high_watermark;
     model::offset last_stable_offset;
     error_code error;
+    model::node_id preferred_read_replica{-1};
+    // set by reads on the core of the request, which count the bytes fetched
+    // once serialized. foreign reads count them on the core of the partition
+    ss::lw_shared_ptr<cluster::partition> local_partition;
 };
 
 ss::future<fetch_response::partition_response>
@@ -0,0 +1,103 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/init_producer_id_request.h"
+
+#include "config/configuration.h"
+#include "kafka/errors.h"
+#include "kafka/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/smp.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace kafka {
+
+/*
+ * Producer ids are unique without coordinating with other nodes: the node id
+ * and the shard are the high bits and the low bits count up from the time the
+ * shard started, in units of 1/256 of a second since 2020. A restarted shard
+ * therefore starts past the ids it handed out before as long as it handed out
+ * less than 256 ids per second on average.
+ */
+static constexpr int node_bits = 16;
+static constexpr int shard_bits = 8;
+static constexpr int counter_bits = 63 - node_bits - shard_bits;
+static constexpr int64_t epoch_2020_seconds = 1577836800;
+
+static int64_t next_producer_counter() {
+    static thread_local int64_t counter = [] {
+        auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                     ss::lowres_system_clock::now().time_since_epoch())
+                     .count();
+        return (now - epoch_2020_seconds) << 8U;
+    }();
+    return counter++;
+}
+
+static std::optional<int64_t> allocate_producer_id() {
+    const int64_t node = config::shard_local_cfg().node_id();
+    const int64_t shard = ss::this_shard_id();
+    if (node < 0 || node >= (int64_t(1) << node_bits)) {
+        return std::nullopt;
+    }
+    if (shard >= (int64_t(1) << shard_bits)) {
+        return std::nullopt;
+    }
+    const int64_t counter = next_producer_counter();
+    if (counter >= (int64_t(1) << counter_bits)) {
+        return std::nullopt;
+    }
+    return (node << (shard_bits + counter_bits)) | (shard << counter_bits)
+           | counter;
+}
+
+ss::future<response_ptr> init_producer_id_api::process(
+  request_context&& ctx, [[maybe_unused]] ss::smp_service_group g) {
+    init_producer_id_request request;
+    request.decode(ctx.reader(), ctx.header().version);
+    vlog(klog.trace, "Handling init producer id request {}", request);
+
+    if (request.data.transactional_id) {
+        return ctx.respond(init_producer_id_response(
+          error_code::transactional_id_authorization_failed));
+    }
+
+    init_producer_id_response response;
+    // an idempotent producer resuming after a sequence error keeps its id
+    // with a bumped epoch, partitions then start its sequences over
+    if (
+      request.data.producer_id >= 0 && request.data.producer_epoch >= 0
+      && request.data.producer_epoch < std::numeric_limits<int16_t>::max()) {
+        response.data.producer_id = request.data.producer_id;
+        response.data.producer_epoch = static_cast<int16_t>(
+          request.data.producer_epoch + 1);
+        return ctx.respond(std::move(response));
+    }
+
+    auto id = allocate_producer_id();
+    if (!id) {
+        vlog(
+          klog.error,
+          "Unable to allocate a producer id on node {} shard {}",
+          config::shard_local_cfg().node_id(),
+          ss::this_shard_id());
+        return ctx.respond(
+          init_producer_id_response(error_code::unknown_server_error));
+    }
+    response.data.producer_id = *id;
+    response.data.producer_epoch = 0;
+    return ctx.respond(std::move(response));
+}
+
+} // namespace kafka
@@ -34,11 +34,6 @@ ss::future<response_ptr> join_group_api::process(
   request_context&& ctx, [[maybe_unused]] ss::smp_service_group g) {
     join_group_request request(ctx);
 
-    if (request.data.group_instance_id) {
-        return ctx.respond(
-          join_group_response(error_code::unsupported_version));
-    }
-
     return ss::do_with(
       std::move(ctx),
       std::move(request),
@@ -29,7 +29,7 @@ struct join_group_api final {
     static constexpr const char* name = "join group";
     static constexpr api_key key = api_key(11);
     static constexpr api_version min_supported = api_version(0);
-    static constexpr api_version max_supported = api_version(4);
+    static constexpr api_version max_supported = api_version(5);
 
     static ss::future<response_ptr>
     process(request_context&&, ss::smp_service_group);
@@ -9,11 +9,12 @@
 
 #include "kafka/requests/kafka_batch_adapter.h"
 
-#include "hashing/crc32c.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/request_reader.h"
 #include "likely.h"
+#include "model/errc.h"
 #include "model/record.h"
+#include "model/validation.h"
 #include "raft/types.h"
 #include "storage/parser_utils.h"
 #include "vassert.h"
@@ -90,41 +91,7 @@ model::record_batch_header kafka_batch_adapter::read_header(iobuf_parser& in) {
     return header;
 }
 
-void kafka_batch_adapter::verify_crc(int32_t expected_crc, iobuf_parser in) {
-    auto crc = crc32();
-
-    // 1. move the cursor to correct endpoint
-    //   - 8 base offset
-    //   - 4 batch length
-    //   - 4 partition leader epoch
-    //   - 1 magic
-    //   - 4 exepcted crc
-    in.skip(21);
-
-    // 2. consume & checksum the CRC
-    in.consume(in.bytes_left(), [&crc](const char* src, size_t n) {
-        // NOLINTNEXTLINE
-        crc.extend(reinterpret_cast<const uint8_t*>(src), n);
-        return ss::stop_iteration::no;
-    });
-
-    // the crc is calculated over the bytes we receive as a uint32_t, but the
-    // crc arrives off the wire as a signed 32-bit value.
-    if (unlikely((uint32_t)expected_crc != crc.value())) {
-        valid_crc = false;
-        vlog(
-          klog.error,
-          "Cannot validate Kafka record batch. Missmatching CRC. Expected:{}, "
-          "Got:{}",
-          expected_crc,
-          crc.value());
-    } else {
-        valid_crc = true;
-    }
-}
-
 void kafka_batch_adapter::adapt(iobuf&& kbatch) {
-    auto crcparser = iobuf_parser(kbatch.share(0, kbatch.size_bytes()));
     auto parser = iobuf_parser(std::move(kbatch));
 
     auto header = read_header(parser);
@@ -135,34 +102,36 @@ void kafka_batch_adapter::adapt(iobuf&& kbatch) {
         return;
     }
 
-    verify_crc(header.crc, std::move(crcparser));
-    if (unlikely(!valid_crc)) {
-        vlog(klog.error, "batch has invlaid CRC: {}", header);
-        return;
-    }
-
     auto records_size = header.size_bytes
                         - model::packed_record_batch_header_size;
     auto records = parser.share(records_size);
 
-    auto new_batch = model::record_batch(
-      header, std::move(records), model::record_batch::tag_ctor_ng{});
-
     /**
-     * Perform some type of validation on the uncompressed input. In this case
-     * we make sure that the records can be materialized but we avoid
-     * re-encoding them using the lazy-record optimization.
+     * The crc and the framing of uncompressed records are validated together
+     * in one pass over the records, which are checked in place rather than
+     * materialized.
      */
-    if (!new_batch.compressed()) {
-        try {
-            new_batch.for_each_record([](model::record r) { (void)r; });
-        } catch (const std::exception& e) {
-            vlog(klog.error, "Parsing uncompressed records: {}", e.what());
-            return;
-        }
+    auto err = model::validate_record_batch(header, records);
+    valid_crc = err != model::errc::invalid_batch_crc;
+    if (unlikely(!valid_crc)) {
+        vlog(klog.error, "batch has invalid CRC: {}", header);
+        return;
+    }
+    if (unlikely(err)) {
+        vlog(klog.error, "Parsing uncompressed records: {}", err.message());
+        return;
+    }
+    if (unlikely(parser.bytes_left() > 0)) {
+        vlog(
+          klog.error,
+          "{} bytes on the wire past the batch: {}",
+          parser.bytes_left(),
+          header);
+        return;
     }
 
-    batch = std::move(new_batch);
+    batch = model::record_batch(
+      header, std::move(records), model::record_batch::tag_ctor_ng{});
 }
 
 } // namespace kafka
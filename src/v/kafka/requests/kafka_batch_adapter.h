@@ -59,7 +59,6 @@ public:
     std::optional<model::record_batch> batch;
 
 private:
-    void verify_crc(int32_t, iobuf_parser);
     model::record_batch_header read_header(iobuf_parser&);
 };
 
@@ -13,9 +13,20 @@
 #include "cluster/namespace.h"
 #include "cluster/partition_manager.h"
 #include "kafka/errors.h"
+#include "kafka/logger.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
 #include "resource_mgmt/io_priority.h"
+#include "vlog.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <boost/range/irange.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace kafka {
 
@@ -65,126 +76,193 @@ struct list_offsets_ctx {
       , ssg(ssg) {}
 };
 
-static ss::future<list_offset_partition_response> list_offsets_partition(
-  list_offsets_ctx& octx,
-  model::timestamp timestamp,
-  list_offset_topic& topic,
-  list_offset_partition& part) {
-    auto ntp = model::ntp(
-      cluster::kafka_namespace,
-      model::get_source_topic(topic.name),
-      part.partition_index);
-
-    auto shard = octx.rctx.shards().shard_for(ntp);
-    if (!shard) {
-        return ss::make_ready_future<list_offset_partition_response>(
-          list_offsets_response::make_partition(
-            ntp.tp.partition, error_code::unknown_topic_or_partition));
-    }
-
-    return octx.rctx.partition_manager().invoke_on(
-      *shard,
-      octx.ssg,
-      [timestamp, ntp = std::move(ntp)](cluster::partition_manager& mgr) {
-          auto partition = mgr.get(ntp);
-          if (!partition) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition, error_code::unknown_topic_or_partition));
-          }
+/*
+ * timequeries read the log, the ones of a shard run concurrently up to this
+ * limit so that a request for thousands of partitions does not queue reads
+ * of all of them at once
+ */
+static constexpr size_t max_concurrent_timequeries = 32;
 
-          if (!partition->is_leader()) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition, error_code::not_leader_for_partition));
-          }
+/**
+ * Lookups of a list offsets request going to the same shard
+ */
+struct shard_list_offsets {
+    std::vector<model::ntp> ntps;
+    std::vector<model::timestamp> timestamps;
+    // positions of the partitions in the response
+    std::vector<list_offset_partition_response*> responses;
+};
 
-          /*
-           * the responses for earliest/latest timestamp queries do not require
-           * that the actual timestamp be returned. only the offset is required.
-           */
-          if (timestamp == list_offsets_request::earliest_timestamp) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition,
-                  model::timestamp(-1),
-                  partition->start_offset()));
-
-          } else if (timestamp == list_offsets_request::latest_timestamp) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition,
-                  model::timestamp(-1),
-                  partition->last_stable_offset()));
+static ss::future<list_offset_partition_response> timequery_partition(
+  ss::lw_shared_ptr<cluster::partition> partition, model::timestamp ts) {
+    return partition->timequery(ts, kafka_read_priority())
+      .then([partition, id = partition->ntp().tp.partition](
+              std::optional<storage::timequery_result> res) {
+          if (res) {
+              return list_offsets_response::make_partition(
+                id, res->time, res->offset);
           }
-
-          return partition->timequery(timestamp, kafka_read_priority())
-            .then([partition, id = ntp.tp.partition](
-                    std::optional<storage::timequery_result> res) {
-                if (res) {
-                    return ss::make_ready_future<
-                      list_offset_partition_response>(
-                      list_offsets_response::make_partition(
-                        id, res->time, res->offset));
-                }
-                return ss::make_ready_future<list_offset_partition_response>(
-                  list_offsets_response::make_partition(
-                    id, model::timestamp(-1), partition->last_stable_offset()));
-            });
+          return list_offsets_response::make_partition(
+            id, model::timestamp(-1), partition->last_stable_offset());
       });
 }
 
-static ss::future<list_offset_topic_response>
-list_offsets_topic(list_offsets_ctx& octx, list_offset_topic& topic) {
-    std::vector<ss::future<list_offset_partition_response>> partitions;
-    partitions.reserve(topic.partitions.size());
-
-    for (auto& part : topic.partitions) {
-        if (octx.request.duplicate_tp(topic.name, part.partition_index)) {
-            partitions.push_back(
-              ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  part.partition_index, error_code::invalid_request)));
+/**
+ * Looks up the partitions of a shard on the shard. Earliest and latest
+ * offsets are kept in memory by the partitions and are answered right away,
+ * only timequeries wait.
+ */
+static ss::future<std::vector<list_offset_partition_response>>
+list_offsets_shard_partitions(
+  cluster::partition_manager& mgr,
+  const std::vector<model::ntp>& ntps,
+  const std::vector<model::timestamp>& timestamps) {
+    std::vector<list_offset_partition_response> results;
+    results.reserve(ntps.size());
+    std::vector<std::pair<size_t, ss::lw_shared_ptr<cluster::partition>>>
+      timequeries;
+    for (size_t i = 0; i < ntps.size(); ++i) {
+        const auto id = ntps[i].tp.partition;
+        auto partition = mgr.get(ntps[i]);
+        if (!partition) {
+            results.push_back(list_offsets_response::make_partition(
+              id, error_code::unknown_topic_or_partition));
             continue;
         }
-
-        if (!octx.rctx.metadata_cache().contains(
-              model::topic_namespace_view(
-                cluster::kafka_namespace, model::get_source_topic(topic.name)),
-              part.partition_index)) {
-            partitions.push_back(
-              ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  part.partition_index,
-                  error_code::unknown_topic_or_partition)));
+        if (!partition->is_leader()) {
+            results.push_back(list_offsets_response::make_partition(
+              id, error_code::not_leader_for_partition));
             continue;
         }
-
-        auto pr = list_offsets_partition(octx, part.timestamp, topic, part);
-        partitions.push_back(std::move(pr));
+        /*
+         * the responses for earliest/latest timestamp queries do not require
+         * that the actual timestamp be returned. only the offset is required.
+         */
+        if (timestamps[i] == list_offsets_request::earliest_timestamp) {
+            results.push_back(list_offsets_response::make_partition(
+              id, model::timestamp(-1), partition->start_offset()));
+        } else if (timestamps[i] == list_offsets_request::latest_timestamp) {
+            results.push_back(list_offsets_response::make_partition(
+              id, model::timestamp(-1), partition->last_stable_offset()));
+        } else {
+            // placeholder, answered by the timequery below
+            results.push_back(list_offsets_response::make_partition(
+              id, error_code::unknown_server_error));
+            timequeries.emplace_back(i, std::move(partition));
+        }
     }
-
-    return when_all_succeed(partitions.begin(), partitions.end())
-      .then([name = std::move(topic.name)](
-              std::vector<list_offset_partition_response> parts) mutable {
-          return list_offset_topic_response{
-            .name = std::move(name),
-            .partitions = std::move(parts),
-          };
+    if (timequeries.empty()) {
+        return ss::make_ready_future<
+          std::vector<list_offset_partition_response>>(std::move(results));
+    }
+    /*
+     * the timequeries are split between as many workers as the limit, each
+     * worker runs its share one after the other
+     */
+    return ss::do_with(
+      std::move(results),
+      std::move(timequeries),
+      [&timestamps](auto& results, auto& timequeries) {
+          const auto workers = std::min(
+            max_concurrent_timequeries, timequeries.size());
+          return ss::parallel_for_each(
+                   boost::irange<size_t>(0, workers),
+                   [&results, &timequeries, &timestamps, workers](size_t w) {
+                       return ss::do_for_each(
+                         boost::irange<size_t>(w, timequeries.size(), workers),
+                         [&results, &timequeries, &timestamps](size_t j) {
+                             const auto i = timequeries[j].first;
+                             return timequery_partition(
+                                      timequeries[j].second, timestamps[i])
+                               .then([&results, i](
+                                       list_offset_partition_response r) {
+                                   results[i] = std::move(r);
+                               });
+                         });
+                   })
+            .then([&results] { return std::move(results); });
       });
 }
 
-static std::vector<ss::future<list_offset_topic_response>>
-list_offsets_topics(list_offsets_ctx& octx) {
-    std::vector<ss::future<list_offset_topic_response>> topics;
-    topics.reserve(octx.request.data.topics.size());
+/**
+ * Looks up the partitions of a shard with a single cross core call and
+ * places the results at the positions of their partitions in the response
+ */
+static ss::future<> list_offsets_shard(
+  list_offsets_ctx& octx, ss::shard_id shard, shard_list_offsets l) {
+    auto ntps = std::move(l.ntps);
+    auto timestamps = std::move(l.timestamps);
+    return octx.rctx.partition_manager()
+      .invoke_on(
+        shard,
+        octx.ssg,
+        [ntps = std::move(ntps), timestamps = std::move(timestamps)](
+          cluster::partition_manager& mgr) {
+            return list_offsets_shard_partitions(mgr, ntps, timestamps);
+        })
+      .then_wrapped(
+        [responses = std::move(l.responses)](
+          ss::future<std::vector<list_offset_partition_response>> f) {
+            if (f.failed()) {
+                auto e = f.get_exception();
+                vlog(klog.warn, "Error listing partition offsets - {}", e);
+                for (auto* r : responses) {
+                    *r = list_offsets_response::make_partition(
+                      r->partition_index, error_code::unknown_server_error);
+                }
+                return;
+            }
+            auto results = f.get0();
+            for (size_t i = 0; i < results.size(); ++i) {
+                *responses[i] = std::move(results[i]);
+            }
+        });
+}
 
+/**
+ * Lays out the response in the order of the request and groups the lookups
+ * of the partitions by their home shard, the partitions which can not be
+ * looked up are answered with their error.
+ */
+static absl::flat_hash_map<ss::shard_id, shard_list_offsets>
+list_offsets_plan(list_offsets_ctx& octx) {
+    absl::flat_hash_map<ss::shard_id, shard_list_offsets> by_shard;
+    auto& topics = octx.response.data.topics;
+    topics.reserve(octx.request.data.topics.size());
     for (auto& topic : octx.request.data.topics) {
-        auto tr = list_offsets_topic(octx, topic);
-        topics.push_back(std::move(tr));
+        auto& tr = topics.emplace_back(
+          list_offset_topic_response{.name = topic.name});
+        // no resize past this point, the plan points into the partitions
+        tr.partitions.reserve(topic.partitions.size());
+        const auto source = model::get_source_topic(topic.name);
+        for (auto& part : topic.partitions) {
+            auto& pr = tr.partitions.emplace_back(
+              list_offsets_response::make_partition(
+                part.partition_index, error_code::none));
+            if (octx.request.duplicate_tp(topic.name, part.partition_index)) {
+                pr.error_code = error_code::invalid_request;
+                continue;
+            }
+            if (!octx.rctx.metadata_cache().contains(
+                  model::topic_namespace_view(cluster::kafka_namespace, source),
+                  part.partition_index)) {
+                pr.error_code = error_code::unknown_topic_or_partition;
+                continue;
+            }
+            model::ntp ntp(
+              cluster::kafka_namespace, source, part.partition_index);
+            auto shard = octx.rctx.shards().shard_for(ntp);
+            if (!shard) {
+                pr.error_code = error_code::unknown_topic_or_partition;
+                continue;
+            }
+            auto& l = by_shard[*shard];
+            l.ntps.push_back(std::move(ntp));
+            l.timestamps.push_back(part.timestamp);
+            l.responses.push_back(&pr);
+        }
     }
-
-    return topics;
+    return by_shard;
 }
 
 ss::future<response_ptr>
@@ -197,10 +275,16 @@ list_offsets_api::process(request_context&& ctx, ss::smp_service_group ssg) {
     return ss::do_with(
       list_offsets_ctx(std::move(ctx), std::move(request), ssg),
       [](list_offsets_ctx& octx) {
-          auto topics = list_offsets_topics(octx);
-          return when_all_succeed(topics.begin(), topics.end())
-            .then([&octx](std::vector<list_offset_topic_response> topics) {
-                octx.response.data.topics = std::move(topics);
+          return ss::do_with(
+                   list_offsets_plan(octx),
+                   [&octx](auto& by_shard) {
+                       return ss::parallel_for_each(
+                         by_shard, [&octx](auto& e) {
+                             return list_offsets_shard(
+                               octx, e.first, std::move(e.second));
+                         });
+                   })
+            .then([&octx] {
                 return octx.rctx.respond(std::move(octx.response));
             });
       });
@@ -98,9 +98,13 @@ void metadata_response::encode(const request_context& ctx, response& resp) {
     if (version >= api_version(1)) {
         writer.write(controller_id);
     }
-    writer.write_array(topics, [version](const topic& tp, response_writer& rw) {
-        tp.encode(version, rw);
-    });
+    writer.write(int32_t(topics.size() + encoded_topics.size()));
+    for (const auto& tp : topics) {
+        tp.encode(version, writer);
+    }
+    for (auto& tp : encoded_topics) {
+        writer.write_direct(std::move(tp));
+    }
     if (version >= api_version(8)) {
         writer.write(cluster_authorized_operations);
     }
@@ -291,12 +295,13 @@ std::ostream& operator<<(std::ostream& o, const metadata_response& resp) {
     return fmt_print(
       o,
       "throttle_time {} brokers {} cluster_id {} controller_id {} topics {} "
-      "cluster_aut_ops {}",
+      "encoded_topics {} cluster_aut_ops {}",
       resp.throttle_time,
       resp.brokers,
       resp.cluster_id,
       resp.controller_id,
       resp.topics,
+      resp.encoded_topics.size(),
       resp.cluster_authorized_operations);
 }
 
@@ -345,26 +350,28 @@ create_topic(request_context& ctx, model::topic&& topic) {
       });
 }
 
-static ss::future<std::vector<metadata_response::topic>>
-get_topic_metadata(request_context& ctx, metadata_request& request) {
+static ss::future<std::vector<metadata_response::topic>> get_topic_metadata(
+  request_context& ctx,
+  metadata_request& request,
+  metadata_response& reply) {
     std::vector<metadata_response::topic> res;
+    auto& md_cache = ctx.metadata_cache();
+    auto& response_cache = ctx.metadata_responses();
+    const auto version = ctx.header().version;
 
     // request can be served from whatever happens to be in the cache
     if (request.list_all_topics) {
-        auto topics = ctx.metadata_cache().all_topics_metadata();
-        // only serve topics from the kafka namespace
-        auto it = std::remove_if(
-          topics.begin(), topics.end(), [](model::topic_metadata& t_md) {
-              return t_md.tp_ns.ns != cluster::kafka_namespace;
-          });
-        std::transform(
-          topics.begin(),
-          it,
-          std::back_inserter(res),
-          [](model::topic_metadata& t_md) {
-              return metadata_response::topic::make_from_topic_metadata(
-                std::move(t_md));
-          });
+        for (auto& tp_ns : md_cache.all_topics()) {
+            // only serve topics from the kafka namespace
+            if (tp_ns.ns != cluster::kafka_namespace) {
+                continue;
+            }
+            if (auto encoded = response_cache.get(md_cache, tp_ns, version);
+                encoded) {
+                reply.encoded_topics.push_back(std::move(*encoded));
+            }
+        }
+        response_cache.prune(md_cache);
         return ss::make_ready_future<std::vector<metadata_response::topic>>(
           std::move(res));
     }
@@ -373,7 +380,18 @@ get_topic_metadata(request_context& ctx, metadata_request& request) {
 
     for (auto& topic : *request.topics) {
         auto source_topic = model::get_source_topic(topic);
-        if (auto md = ctx.metadata_cache().get_topic_metadata(
+        if (source_topic == topic) {
+            // materialized topics are answered with the requested name, all
+            // the others share the cached entry
+            if (auto encoded = response_cache.get(
+                  md_cache,
+                  model::topic_namespace(cluster::kafka_namespace, topic),
+                  version);
+                encoded) {
+                reply.encoded_topics.push_back(std::move(*encoded));
+                continue;
+            }
+        } else if (auto md = md_cache.get_topic_metadata(
               model::topic_namespace_view(
                 cluster::kafka_namespace, source_topic));
             md) {
@@ -432,7 +450,7 @@ ss::future<response_ptr> metadata_api::process(
 
           metadata_request request;
           request.decode(ctx);
-          return get_topic_metadata(ctx, request)
+          return get_topic_metadata(ctx, request, reply)
             .then([&reply](std::vector<metadata_response::topic> topics) {
                 reply.topics = std::move(topics);
             })
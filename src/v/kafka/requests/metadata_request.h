@@ -91,8 +91,14 @@ struct metadata_response {
     std::optional<ss::sstring> cluster_id; // version >= 2
     model::node_id controller_id;          // version >= 1
     std::vector<topic> topics;
+    // topics already encoded for the response version, served from the
+    // metadata response cache and written after the topics above
+    std::vector<iobuf> encoded_topics;
     int32_t cluster_authorized_operations = 0; // version >= 8
 
+    // large responses, sized before they are encoded
+    static constexpr bool presized_encoding = true;
+
     void encode(const request_context& ctx, response& resp);
     void decode(iobuf buf, api_version version);
 };
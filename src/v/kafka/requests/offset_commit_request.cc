@@ -54,11 +54,6 @@ offset_commit_api::process(request_context&& ctx, ss::smp_service_group ssg) {
     request.decode(ctx.reader(), ctx.header().version);
     klog.trace("Handling request {}", request);
 
-    if (request.data.group_instance_id) {
-        return ctx.respond(
-          offset_commit_response(request, error_code::unsupported_version));
-    }
-
     offset_commit_ctx octx(std::move(ctx), std::move(request), ssg);
 
     /*
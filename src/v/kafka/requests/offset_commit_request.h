@@ -38,7 +38,8 @@ struct offset_commit_api final {
     // support version 0 then we need to do some code review to see if this has
     // any implications on semantics.
     static constexpr api_version min_supported = api_version(1);
-    static constexpr api_version max_supported = api_version(7);
+    static constexpr api_version max_supported = api_version(8);
+    static constexpr api_version min_flexible = api_version(8);
 
     static ss::future<response_ptr>
     process(request_context&&, ss::smp_service_group);
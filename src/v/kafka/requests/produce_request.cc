@@ -12,7 +12,9 @@
 #include "bytes/iobuf.h"
 #include "cluster/metadata_cache.h"
 #include "cluster/namespace.h"
+#include "cluster/errc.h"
 #include "cluster/partition_manager.h"
+#include "config/configuration.h"
 #include "kafka/errors.h"
 #include "kafka/requests/kafka_batch_adapter.h"
 #include "kafka/requests/response_writer_utils.h"
@@ -25,15 +27,22 @@
 #include "storage/shard_assignment.h"
 #include "utils/remote.h"
 #include "utils/to_string.h"
+#include "utils/vector_pool.h"
 #include "vlog.h"
 
 #include <seastar/core/execution_stage.hh>
+#include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
 #include <seastar/util/log.hh>
 
+#include <absl/container/flat_hash_map.h>
 #include <fmt/ostream.h>
 
+#include <optional>
 #include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace kafka {
 
@@ -59,22 +68,26 @@ void produce_request::decode(request_context& ctx) {
     transactional_id = reader.read_nullable_string();
     acks = reader.read_int16();
     timeout = std::chrono::milliseconds(reader.read_int32());
-    topics = reader.read_array([](request_reader& reader) {
-        return topic{
-          .name = model::topic(reader.read_string()),
-          .partitions = reader.read_array([](request_reader& reader) {
-              return partition{
-                .id = model::partition_id(reader.read_int32()),
-                .data = reader.read_fragmented_nullable_bytes(),
-              };
-          }),
-        };
-    });
+    topics = reader.read_array(
+      vector_pool<topic>::get(), [](request_reader& reader) {
+          return topic{
+            .name = model::topic(reader.read_string()),
+            .partitions = reader.read_array(
+              vector_pool<partition>::get(), [](request_reader& reader) {
+                  return partition{
+                    .id = model::partition_id(reader.read_int32()),
+                    .data = reader.read_fragmented_nullable_bytes(),
+                  };
+              }),
+          };
+      });
 
     for (auto& topic : topics) {
         for (auto& part : topic.partitions) {
             if (part.data) {
+                auto start = std::chrono::steady_clock::now();
                 part.adapter.adapt(std::move(part.data.value()));
+                part.decode_duration = std::chrono::steady_clock::now() - start;
                 if (part.adapter.batch) {
                     const auto& hdr = part.adapter.batch->header();
                     has_transactional = has_transactional
@@ -86,6 +99,13 @@ void produce_request::decode(request_context& ctx) {
     }
 }
 
+void produce_request::recycle() {
+    for (auto& t : topics) {
+        vector_pool<partition>::put(std::move(t.partitions));
+    }
+    vector_pool<topic>::put(std::move(topics));
+}
+
 produce_response produce_request::make_error_response(error_code error) const {
     produce_response response;
 
@@ -215,6 +235,8 @@ struct produce_ctx {
     produce_request request;
     produce_response response;
     ss::smp_service_group ssg;
+    // set when the partitions of the request all live on one shard
+    std::optional<ss::shard_id> partition_shard;
 
     produce_ctx(
       request_context&& rctx,
@@ -250,6 +272,26 @@ reader_from_lcore_batch(model::record_batch&& batch) {
     return model::make_foreign_memory_record_batch_reader(std::move(batch));
 }
 
+static error_code map_produce_error(std::error_code ec) {
+    if (ec.category() != cluster::error_category()) {
+        return error_code::unknown_server_error;
+    }
+    switch (static_cast<cluster::errc>(ec.value())) {
+    case cluster::errc::not_leader:
+        return error_code::not_leader_for_partition;
+    case cluster::errc::sequence_out_of_order:
+        return error_code::out_of_order_sequence_number;
+    case cluster::errc::duplicate_sequence:
+        return error_code::duplicate_sequence_number;
+    case cluster::errc::invalid_producer_epoch:
+        return error_code::invalid_producer_epoch;
+    case cluster::errc::unknown_producer_id:
+        return error_code::unknown_producer_id;
+    default:
+        return error_code::unknown_server_error;
+    }
+}
+
 /*
  * Caller is expected to catch errors that may be thrown while the kafka
  * batch is being deserialized (see reader_from_kafka_batch).
@@ -257,12 +299,17 @@ reader_from_lcore_batch(model::record_batch&& batch) {
 static ss::future<produce_response::partition> partition_append(
   model::partition_id id,
   ss::lw_shared_ptr<cluster::partition> partition,
+  const model::record_batch_header& header,
   model::record_batch_reader reader,
   int16_t acks,
   int32_t num_records) {
+    partition->probe().request();
     return partition
-      ->replicate(std::move(reader), acks_to_replicate_options(acks))
-      .then_wrapped([partition, id, num_records = num_records](
+      ->replicate(header, std::move(reader), acks_to_replicate_options(acks))
+      .then_wrapped([partition,
+                     id,
+                     num_records = num_records,
+                     bytes = header.size_bytes](
                       ss::future<result<raft::replicate_result>> f) {
           produce_response::partition p{.id = id};
           try {
@@ -274,8 +321,9 @@ static ss::future<produce_response::partition> partition_append(
                     r.value().last_offset() - (num_records - 1));
                   p.error = error_code::none;
                   partition->probe().add_records_produced(num_records);
+                  partition->probe().add_bytes_produced(bytes);
               } else {
-                  p.error = error_code::unknown_server_error;
+                  p.error = map_produce_error(r.error());
               }
           } catch (...) {
               p.error = error_code::unknown_server_error;
@@ -285,140 +333,216 @@ static ss::future<produce_response::partition> partition_append(
 }
 
 /**
- * \brief handle writing to a single topic partition.
+ * Batch of a partition sent to the partition's home shard
+ */
+struct partition_produce {
+    model::ntp ntp;
+    // the partition on its shard, see shard_table::locate
+    raft::group_id group;
+    // producer id and sequence of the batch are checked at the partition
+    model::record_batch_header header;
+    model::record_batch_reader reader;
+    int32_t num_records;
+    std::chrono::steady_clock::duration decode_duration;
+};
+
+/**
+ * Batches of a produce request going to the same shard
+ */
+struct shard_produce {
+    std::vector<partition_produce> partitions;
+    // positions of the partition responses, topic and partition index
+    std::vector<std::pair<size_t, size_t>> positions;
+};
+
+/**
+ * \brief handle writing to a single topic partition, runs on the home shard
+ * of the partition.
  */
 static ss::future<produce_response::partition> produce_topic_partition(
+  cluster::partition_manager& mgr, partition_produce p, int16_t acks) {
+    auto partition = mgr.partition_for(p.group);
+    if (!partition) {
+        return ss::make_ready_future<produce_response::partition>(
+          produce_response::partition{
+            .id = p.ntp.tp.partition,
+            .error = error_code::unknown_topic_or_partition});
+    }
+    if (unlikely(!partition->is_leader())) {
+        return ss::make_ready_future<produce_response::partition>(
+          produce_response::partition{
+            .id = p.ntp.tp.partition,
+            .error = error_code::not_leader_for_partition});
+    }
+    partition->produce_latency().record(
+      raft::produce_latency_probe::stage::request_decode, p.decode_duration);
+    return partition_append(
+      p.ntp.tp.partition,
+      partition,
+      p.header,
+      std::move(p.reader),
+      acks,
+      p.num_records);
+}
+
+/**
+ * \brief Prepare the batch of a topic partition for its home shard, or the
+ * error response of the partition.
+ */
+static std::variant<partition_produce, produce_response::partition>
+prepare_topic_partition(
   produce_ctx& octx,
   produce_request::topic& topic,
   produce_request::partition& part) {
-    auto ntp = model::ntp(cluster::kafka_namespace, topic.name, part.id);
+    auto error = [&part](error_code e) {
+        return produce_response::partition{.id = part.id, .error = e};
+    };
+    if (!octx.rctx.metadata_cache().contains(
+          model::topic_namespace_view(cluster::kafka_namespace, topic.name),
+          part.id)) {
+        return error(error_code::unknown_topic_or_partition);
+    }
 
-    /*
-     * A single produce request may contain record batches for many
-     * different partitions that are managed different cores.
-     */
-    auto shard = octx.rctx.shards().shard_for(ntp);
+    if (unlikely(!part.adapter.valid_crc)) {
+        return error(error_code::corrupt_message);
+    }
 
-    if (!shard) {
-        return ss::make_ready_future<produce_response::partition>(
-          produce_response::partition{
-            .id = ntp.tp.partition,
-            .error = error_code::unknown_topic_or_partition});
+    // produce version >= 3 (enforced for all produce requests)
+    // requires exactly one record batch per request and it must use
+    // the v2 format.
+    if (unlikely(!part.adapter.v2_format || !part.adapter.batch)) {
+        return error(error_code::invalid_record);
     }
 
     // steal the batch from the adapter
     auto batch = std::move(part.adapter.batch.value());
     /*
      * grab timestamp type topic configuration option out of the
-     * metadata cache. For append time setting we have to recalculate
-     * the CRC.
+     * metadata cache. For append time setting the kafka CRC is updated from
+     * the header fields alone, the header CRC is computed once by the log
+     * along with the offset of the batch.
      */
     auto timestamp_type = octx.rctx.metadata_cache().get_topic_timestamp_type(
       model::topic_namespace_view(cluster::kafka_namespace, topic.name));
 
     if (timestamp_type == model::timestamp_type::append_time) {
-        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
-          ss::lowres_clock::now().time_since_epoch());
-        batch.set_max_timestamp(
-          model::timestamp_type::append_time, model::timestamp(now.count()));
+        batch.assign_max_timestamp(
+          model::timestamp_type::append_time,
+          model::new_monotonic_timestamp());
     }
 
     auto num_records = batch.record_count();
-    auto reader = reader_from_lcore_batch(std::move(batch));
+    auto header = batch.header();
+    return partition_produce{
+      .ntp = model::ntp(cluster::kafka_namespace, topic.name, part.id),
+      .header = header,
+      .reader = reader_from_lcore_batch(std::move(batch)),
+      .num_records = num_records,
+      .decode_duration = part.decode_duration,
+    };
+}
 
+/**
+ * \brief Appends the batches of a shard with a single cross core call.
+ *
+ * The batches are owned by the message to the shard until they are
+ * appended, the memory units of the request are held by the connection
+ * until the last shard answered.
+ */
+static ss::future<std::vector<produce_response::partition>>
+produce_shard_partitions(
+  produce_ctx& octx,
+  ss::shard_id shard,
+  std::vector<partition_produce> partitions) {
     return octx.rctx.partition_manager().invoke_on(
-      *shard,
+      shard,
       octx.ssg,
-      [reader = std::move(reader),
-       ntp = std::move(ntp),
-       num_records,
+      [partitions = std::move(partitions),
        acks = octx.request.acks](cluster::partition_manager& mgr) mutable {
-          auto partition = mgr.get(ntp);
-          if (!partition) {
-              return ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = ntp.tp.partition,
-                  .error = error_code::unknown_topic_or_partition});
-          }
-          if (unlikely(!partition->is_leader())) {
-              return ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = ntp.tp.partition,
-                  .error = error_code::not_leader_for_partition});
+          std::vector<ss::future<produce_response::partition>> appends;
+          appends.reserve(partitions.size());
+          for (auto& p : partitions) {
+              auto id = p.ntp.tp.partition;
+              appends.push_back(
+                ss::futurize_invoke(
+                  produce_topic_partition, mgr, std::move(p), acks)
+                  .handle_exception([id](const std::exception_ptr& e) {
+                      vlog(klog.warn, "Error producing to {} - {}", id, e);
+                      return produce_response::partition{
+                        .id = id, .error = error_code::unknown_server_error};
+                  }));
           }
-          return partition_append(
-            ntp.tp.partition, partition, std::move(reader), acks, num_records);
+          return ss::do_with(
+            std::move(appends),
+            [](std::vector<ss::future<produce_response::partition>>& as) {
+                return ss::when_all_succeed(as.begin(), as.end());
+            });
       });
 }
 
 /**
- * \brief Dispatch and collect topic partition produce responses
+ * \brief Dispatch the batches of the request and collect the responses
+ *
+ * A single produce request may contain record batches for many different
+ * partitions that are managed by different cores. The batches are grouped by
+ * their home shard, every shard receives one cross core message with all of
+ * its batches. The responses are placed at the positions of their partitions
+ * in the response.
  */
-static ss::future<produce_response::topic>
-produce_topic(produce_ctx& octx, produce_request::topic& topic) {
-    std::vector<ss::future<produce_response::partition>> partitions;
-    partitions.reserve(topic.partitions.size());
-
-    for (auto& part : topic.partitions) {
-        if (!octx.rctx.metadata_cache().contains(
-              model::topic_namespace_view(cluster::kafka_namespace, topic.name),
-              part.id)) {
-            partitions.push_back(
-              ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = part.id,
-                  .error = error_code::unknown_topic_or_partition}));
-            continue;
-        }
-
-        if (unlikely(!part.adapter.valid_crc)) {
-            partitions.push_back(
-              ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = part.id, .error = error_code::corrupt_message}));
-            continue;
-        }
-
-        // produce version >= 3 (enforced for all produce requests)
-        // requires exactly one record batch per request and it must use
-        // the v2 format.
-        if (unlikely(!part.adapter.v2_format || !part.adapter.batch)) {
-            partitions.push_back(
-              ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = part.id, .error = error_code::invalid_record}));
-            continue;
+static ss::future<> produce_topics(produce_ctx& octx) {
+    absl::flat_hash_map<ss::shard_id, shard_produce> by_shard;
+    auto& response = octx.response.topics;
+    response.reserve(octx.request.topics.size());
+
+    for (size_t t = 0; t < octx.request.topics.size(); ++t) {
+        auto& topic = octx.request.topics[t];
+        auto& tr = response.emplace_back(
+          produce_response::topic{.name = topic.name, .partitions = {}});
+        tr.partitions.reserve(topic.partitions.size());
+        for (size_t i = 0; i < topic.partitions.size(); ++i) {
+            auto& part = topic.partitions[i];
+            auto res = prepare_topic_partition(octx, topic, part);
+            if (auto* err = std::get_if<produce_response::partition>(&res)) {
+                tr.partitions.push_back(*err);
+                continue;
+            }
+            // placeholder until the shard answers
+            tr.partitions.push_back(produce_response::partition{
+              .id = part.id, .error = error_code::unknown_server_error});
+            auto& p = std::get<partition_produce>(res);
+            auto location = octx.rctx.shards().locate(p.ntp);
+            if (!location) {
+                tr.partitions.back().error
+                  = error_code::unknown_topic_or_partition;
+                continue;
+            }
+            p.group = location->group;
+            auto& sp = by_shard[location->shard];
+            sp.partitions.push_back(std::move(p));
+            sp.positions.emplace_back(t, i);
         }
-
-        auto pr = produce_topic_partition(octx, topic, part);
-        partitions.push_back(std::move(pr));
     }
 
-    // collect partition responses and build the topic response
-    return when_all_succeed(partitions.begin(), partitions.end())
-      .then([name = std::move(topic.name)](
-              std::vector<produce_response::partition> parts) mutable {
-          return produce_response::topic{
-            .name = std::move(name),
-            .partitions = std::move(parts),
-          };
-      });
-}
-
-/**
- * \brief Dispatch and collect topic produce responses
- */
-static std::vector<ss::future<produce_response::topic>>
-produce_topics(produce_ctx& octx) {
-    std::vector<ss::future<produce_response::topic>> topics;
-    topics.reserve(octx.request.topics.size());
-
-    for (auto& topic : octx.request.topics) {
-        auto tr = produce_topic(octx, topic);
-        topics.push_back(std::move(tr));
+    if (by_shard.size() == 1) {
+        octx.partition_shard = by_shard.begin()->first;
     }
-
-    return topics;
+    return ss::do_with(
+      std::move(by_shard),
+      [&octx](absl::flat_hash_map<ss::shard_id, shard_produce>& by_shard) {
+          return ss::parallel_for_each(by_shard, [&octx](auto& e) {
+              auto& positions = e.second.positions;
+              return produce_shard_partitions(
+                       octx, e.first, std::move(e.second.partitions))
+                .then([&octx, &positions](
+                        std::vector<produce_response::partition> parts) {
+                    for (size_t i = 0; i < parts.size(); ++i) {
+                        auto [t, p] = positions[i];
+                        octx.response.topics[t].partitions[p] = std::move(
+                          parts[i]);
+                    }
+                });
+          });
+      });
 }
 
 ss::future<response_ptr>
@@ -430,14 +554,16 @@ produce_api::process(request_context&& ctx, ss::smp_service_group ssg) {
      *
      * Note that in kafka authorization is performed based on
      * transactional id, producer id, and idempotency. Redpanda does not
-     * yet support these features, so we reject all such requests as if
-     * authorization failed.
+     * yet support transactions, and idempotency only when it is enabled, so
+     * we reject the other requests as if authorization failed.
      */
     if (request.has_transactional) {
         return ctx.respond(request.make_error_response(
           error_code::transactional_id_authorization_failed));
 
-    } else if (request.has_idempotent) {
+    } else if (
+      request.has_idempotent
+      && !config::shard_local_cfg().enable_idempotence()) {
         return ctx.respond(request.make_error_response(
           error_code::cluster_authorization_failed));
 
@@ -460,14 +586,8 @@ produce_api::process(request_context&& ctx, ss::smp_service_group ssg) {
       [](produce_ctx& octx) {
           vlog(klog.trace, "handling produce request {}", octx.request);
 
-          // dispatch produce requests for each topic
-          auto topics = produce_topics(octx);
-
-          // collect topic responses
-          return when_all_succeed(topics.begin(), topics.end())
-            .then([&octx](std::vector<produce_response::topic> topics) {
-                octx.response.topics = std::move(topics);
-            })
+          // dispatch the batches and collect the responses
+          return produce_topics(octx)
             .then([&octx] {
                 // send response immediately
                 if (octx.request.acks != 0) {
@@ -508,7 +628,14 @@ produce_api::process(request_context&& ctx, ss::smp_service_group ssg) {
                     "Closing connection due to error in produce "
                     "response: {}",
                     octx.response)));
-            });
+            })
+            .then([&octx](response_ptr resp) {
+                if (octx.partition_shard) {
+                    resp->set_partition_shard(*octx.partition_shard);
+                }
+                return resp;
+            })
+            .finally([&octx] { octx.request.recycle(); });
       });
 }
 
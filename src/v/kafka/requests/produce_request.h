@@ -21,6 +21,8 @@
 
 #include <seastar/core/future.hh>
 
+#include <chrono>
+
 namespace kafka {
 
 struct produce_response;
@@ -53,6 +55,8 @@ struct produce_request final {
         // data is moved into the batch adapter immediately after its read.
         std::optional<iobuf> data;
         kafka_batch_adapter adapter;
+        // time spent adapting the batch, reported to the partition
+        std::chrono::steady_clock::duration decode_duration{};
     };
 
     struct topic {
@@ -81,6 +85,10 @@ struct produce_request final {
     void encode(response_writer& writer, api_version version);
     void decode(request_context& ctx);
 
+    /// Gives the decoded vectors back to the pools of the shard, the
+    /// request is empty afterwards.
+    void recycle();
+
     /**
      * Build a generic error response for a given request.
      */
@@ -11,11 +11,16 @@
 
 #pragma once
 #include "bytes/iobuf.h"
+#include "kafka/down_conversion.h"
 #include "kafka/fetch_session_cache.h"
 #include "kafka/logger.h"
+#include "kafka/metadata_response_cache.h"
 #include "kafka/requests/request_reader.h"
 #include "kafka/types.h"
 #include "seastarx.h"
+#include "security/credential_store.h"
+#include "security/sasl_authentication.h"
+#include "vassert.h"
 #include "vlog.h"
 
 #include <seastar/core/future.hh>
@@ -25,6 +30,7 @@
 #include <seastar/util/log.hh>
 
 #include <memory>
+#include <type_traits>
 
 namespace cluster {
 class metadata_cache;
@@ -70,6 +76,27 @@ std::ostream& operator<<(std::ostream&, const request_header&);
 class response;
 using response_ptr = ss::foreign_ptr<std::unique_ptr<response>>;
 
+/**
+ * APIs declaring `static constexpr api_version min_flexible` use the flexible
+ * encodings from that version on, both the request and the response headers
+ * then carry tagged fields. APIs without it are never flexible.
+ */
+template<typename Api, typename = void>
+struct flexible_api : std::false_type {};
+
+template<typename Api>
+struct flexible_api<Api, std::void_t<decltype(Api::min_flexible)>>
+  : std::true_type {};
+
+template<typename Api>
+constexpr bool is_flexible_version(api_version version) {
+    if constexpr (flexible_api<Api>::value) {
+        return version >= Api::min_flexible;
+    } else {
+        return false;
+    }
+}
+
 class request_context {
 public:
     request_context(
@@ -82,7 +109,11 @@ public:
       cluster::shard_table& shard_table,
       ss::sharded<cluster::partition_manager>& partition_manager,
       ss::sharded<coordinator_ntp_mapper>& coordinator_mapper,
-      ss::sharded<fetch_session_cache>& fetch_session_cache) noexcept
+      ss::sharded<fetch_session_cache>& fetch_session_cache,
+      ss::sharded<metadata_response_cache>& metadata_response_cache,
+      ss::sharded<down_conversion_cache>& down_conversion_cache,
+      ss::sharded<security::credential_store>& credentials,
+      security::sasl_server* sasl) noexcept
       : _metadata_cache(&metadata_cache)
       , _topics_frontend(&topics_frontend)
       , _header(std::move(header))
@@ -92,7 +123,11 @@ public:
       , _shard_table(&shard_table)
       , _partition_manager(&partition_manager)
       , _coordinator_mapper(&coordinator_mapper)
-      , _fetch_session_cache(&fetch_session_cache) {
+      , _fetch_session_cache(&fetch_session_cache)
+      , _metadata_response_cache(&metadata_response_cache)
+      , _down_conversion_cache(&down_conversion_cache)
+      , _credentials(&credentials)
+      , _sasl(sasl) {
         // XXX: don't forget to extend the move ctor
     }
     ~request_context() noexcept = default;
@@ -106,7 +141,11 @@ public:
       , _shard_table(o._shard_table)
       , _partition_manager(o._partition_manager)
       , _coordinator_mapper(o._coordinator_mapper)
-      , _fetch_session_cache(o._fetch_session_cache) {}
+      , _fetch_session_cache(o._fetch_session_cache)
+      , _metadata_response_cache(o._metadata_response_cache)
+      , _down_conversion_cache(o._down_conversion_cache)
+      , _credentials(o._credentials)
+      , _sasl(o._sasl) {}
     request_context& operator=(request_context&& o) noexcept {
         if (this != &o) {
             this->~request_context();
@@ -151,6 +190,24 @@ public:
         return _fetch_session_cache->local();
     }
 
+    metadata_response_cache& metadata_responses() {
+        return _metadata_response_cache->local();
+    }
+
+    down_conversion_cache& down_conversions() {
+        return _down_conversion_cache->local();
+    }
+
+    const security::credential_store& credentials() const {
+        return _credentials->local();
+    }
+
+    /// \brief sasl state of the connection of the request
+    security::sasl_server& sasl() {
+        vassert(_sasl, "request context without a connection");
+        return *_sasl;
+    }
+
     // clang-format off
     template<typename ResponseType>
     CONCEPT(requires requires (
@@ -166,6 +223,15 @@ public:
           ResponseType::api_type::name,
           r);
         auto resp = std::make_unique<response>();
+        if (is_flexible_version<typename ResponseType::api_type>(
+              _header.version)) {
+            resp->set_flexible_header();
+        }
+        if constexpr (is_presized_response_v<ResponseType>) {
+            response sizing(response_writer::size_only{});
+            r.encode(*this, sizing);
+            resp->reserve(sizing.writer().copied_bytes());
+        }
         r.encode(*this, *resp.get());
         return ss::make_ready_future<response_ptr>(std::move(resp));
     }
@@ -185,6 +251,11 @@ private:
     ss::sharded<cluster::partition_manager>* _partition_manager;
     ss::sharded<kafka::coordinator_ntp_mapper>* _coordinator_mapper;
     ss::sharded<kafka::fetch_session_cache>* _fetch_session_cache;
+    ss::sharded<kafka::metadata_response_cache>* _metadata_response_cache;
+    ss::sharded<kafka::down_conversion_cache>* _down_conversion_cache;
+    ss::sharded<security::credential_store>* _credentials;
+    // null in contexts built outside of a connection
+    security::sasl_server* _sasl;
 };
 
 // Executes the API call identified by the specified request_context.
@@ -24,7 +24,9 @@
 
 #include <fmt/format.h>
 
+#include <limits>
 #include <optional>
+#include <stdexcept>
 #include <type_traits>
 
 namespace kafka {
@@ -59,6 +61,118 @@ public:
 
     bytes read_bytes() { return _parser.read_bytes(read_int32()); }
 
+    // flexible versions
+    // =================
+    //
+    // compact strings, bytes and arrays prefix their length plus one as an
+    // unsigned varint, zero encodes null. tagged fields follow every struct
+    // of a flexible version.
+
+    uint32_t read_unsigned_varint() {
+        uint32_t value = 0;
+        for (uint32_t shift = 0; shift < 35; shift += 7) {
+            auto b = _parser.consume_type<uint8_t>();
+            value |= uint32_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw std::out_of_range("Unsigned varint longer than 5 bytes");
+    }
+
+    ss::sstring read_compact_string() {
+        auto n = read_compact_length();
+        if (unlikely(n < 0)) {
+            throw std::out_of_range("Asked to read a null compact string");
+        }
+        return _parser.read_string(n);
+    }
+
+    std::optional<ss::sstring> read_compact_nullable_string() {
+        auto n = read_compact_length();
+        if (n < 0) {
+            return std::nullopt;
+        }
+        return _parser.read_string(n);
+    }
+
+    bytes read_compact_bytes() {
+        auto n = read_compact_length();
+        if (unlikely(n < 0)) {
+            throw std::out_of_range("Asked to read null compact bytes");
+        }
+        return _parser.read_bytes(n);
+    }
+
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::vector<T> read_compact_array(ElementParser&& parser) {
+        auto len = read_compact_length();
+        if (unlikely(len < 0)) {
+            throw std::out_of_range("Asked to read a null compact array");
+        }
+        return do_read_array(len, std::forward<ElementParser>(parser));
+    }
+
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::optional<std::vector<T>>
+    read_compact_nullable_array(ElementParser&& parser) {
+        auto len = read_compact_length();
+        if (len < 0) {
+            return std::nullopt;
+        }
+        return do_read_array(len, std::forward<ElementParser>(parser));
+    }
+
+    // the compact or the classic form, used by the generated code
+
+    ss::sstring read_flex_string(bool flexible) {
+        return flexible ? read_compact_string() : read_string();
+    }
+
+    std::optional<ss::sstring> read_flex_nullable_string(bool flexible) {
+        return flexible ? read_compact_nullable_string()
+                        : read_nullable_string();
+    }
+
+    bytes read_flex_bytes(bool flexible) {
+        return flexible ? read_compact_bytes() : read_bytes();
+    }
+
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::vector<T> read_flex_array(bool flexible, ElementParser&& parser) {
+        if (flexible) {
+            return read_compact_array(std::forward<ElementParser>(parser));
+        }
+        return read_array(std::forward<ElementParser>(parser));
+    }
+
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::optional<std::vector<T>>
+    read_flex_nullable_array(bool flexible, ElementParser&& parser) {
+        if (flexible) {
+            return read_compact_nullable_array(
+              std::forward<ElementParser>(parser));
+        }
+        return read_nullable_array(std::forward<ElementParser>(parser));
+    }
+
+    /// skips the tagged fields of a struct, none of them are known
+    void consume_tagged_fields() {
+        auto n = read_unsigned_varint();
+        while (n-- > 0) {
+            read_unsigned_varint(); // tag
+            _parser.skip(read_unsigned_varint());
+        }
+    }
+
     // Stronly suggested to use read_nullable_iobuf
     std::optional<iobuf> read_fragmented_nullable_bytes() {
         auto [io, count] = read_nullable_iobuf();
@@ -84,6 +198,17 @@ public:
         return do_read_array(len, std::forward<ElementParser>(parser));
     }
 
+    /// decodes the array into `res`, reusing its storage
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::vector<T> read_array(std::vector<T> res, ElementParser&& parser) {
+        auto len = read_int32();
+        res.clear();
+        return do_read_array(
+          len, std::forward<ElementParser>(parser), std::move(res));
+    }
+
     template<
       typename ElementParser,
       typename T = std::invoke_result_t<ElementParser, request_reader&>>
@@ -96,6 +221,15 @@ public:
     }
 
 private:
+    // -1 for null
+    int32_t read_compact_length() {
+        auto n = read_unsigned_varint();
+        if (unlikely(n > uint32_t(std::numeric_limits<int32_t>::max()))) {
+            throw std::out_of_range("Compact length out of range");
+        }
+        return int32_t(n) - 1;
+    }
+
     ss::sstring do_read_string(int16_t n) {
         if (unlikely(n < 0)) {
             /// FIXME: maybe return empty string?
@@ -111,8 +245,8 @@ private:
         { parser(rr) } -> T;
     })
     // clang-format on
-    std::vector<T> do_read_array(int32_t len, ElementParser&& parser) {
-        std::vector<T> res;
+    std::vector<T> do_read_array(
+      int32_t len, ElementParser&& parser, std::vector<T> res = {}) {
         res.reserve(std::max(0, len));
         while (len-- > 0) {
             res.push_back(parser(*this));
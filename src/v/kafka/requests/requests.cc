@@ -12,12 +12,14 @@
 #include "kafka/requests/alter_configs_request.h"
 #include "kafka/requests/api_versions_request.h"
 #include "kafka/requests/create_topics_request.h"
+#include "kafka/requests/delete_records_request.h"
 #include "kafka/requests/delete_topics_request.h"
 #include "kafka/requests/describe_configs_request.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/fetch_request.h"
 #include "kafka/requests/find_coordinator_request.h"
 #include "kafka/requests/heartbeat_request.h"
+#include "kafka/requests/init_producer_id_request.h"
 #include "kafka/requests/join_group_request.h"
 #include "kafka/requests/leave_group_request.h"
 #include "kafka/requests/list_groups_request.h"
@@ -55,6 +57,10 @@ struct process_dispatch {
                 ctx.header().version,
                 Request::name)));
         }
+        // header v2 of flexible requests, no tagged field is understood
+        if (is_flexible_version<Request>(ctx.header().version)) {
+            ctx.reader().consume_tagged_fields();
+        }
         return Request::process(std::move(ctx), g);
     }
 };
@@ -132,6 +138,10 @@ process_request(request_context&& ctx, ss::smp_service_group g) {
         return do_process<sasl_handshake_api>(std::move(ctx), g);
     case sasl_authenticate_api::key:
         return do_process<sasl_authenticate_api>(std::move(ctx), g);
+    case init_producer_id_api::key:
+        return do_process<init_producer_id_api>(std::move(ctx), g);
+    case delete_records_api::key:
+        return do_process<delete_records_api>(std::move(ctx), g);
     };
     return ss::make_exception_future<response_ptr>(
       std::runtime_error(fmt::format("Unsupported API {}", ctx.header().key)));
@@ -17,17 +17,33 @@
 
 #include <seastar/core/sharded.hh>
 
+#include <algorithm>
 #include <memory>
+#include <optional>
+#include <type_traits>
 
 namespace kafka {
 
 class response {
 public:
+    // largest fragment reserved for a presized encoding, larger encodings
+    // grow the buffer as usual past it
+    static constexpr size_t max_reservation = 128 * 1024;
+
     response() noexcept
       : _writer(_buf) {}
 
+    /// response of a sizing pass, nothing is written into it
+    explicit response(response_writer::size_only s) noexcept
+      : _writer(s) {}
+
     response_writer& writer() { return _writer; }
 
+    /// reserves a single fragment for the bytes an encoding copies
+    void reserve(size_t bytes) {
+        _buf.reserve_exact_memory(std::min(bytes, max_reservation));
+    }
+
     const iobuf& buf() const { return _buf; }
     iobuf& buf() { return _buf; }
     iobuf release() && { return std::move(_buf); }
@@ -44,8 +60,21 @@ public:
     bool is_noop() const { return _noop; }
     void mark_noop() { _noop = true; }
 
+    /// flexible responses carry (empty) tagged fields in their header
+    bool flexible_header() const { return _flexible_header; }
+    void set_flexible_header() { _flexible_header = true; }
+
+    /// shard of the partitions of the request when they all live on one,
+    /// the connection may serve its next requests there
+    std::optional<ss::shard_id> partition_shard() const {
+        return _partition_shard;
+    }
+    void set_partition_shard(ss::shard_id s) { _partition_shard = s; }
+
 private:
     bool _noop{false};
+    bool _flexible_header{false};
+    std::optional<ss::shard_id> _partition_shard;
     correlation_id _correlation;
     iobuf _buf;
     response_writer _writer;
@@ -53,4 +82,21 @@ private:
 
 using response_ptr = ss::foreign_ptr<std::unique_ptr<response>>;
 
+/**
+ * Responses declaring `static constexpr bool presized_encoding = true` are
+ * encoded in two passes. The first one only counts the bytes the encoding
+ * copies, the second one writes them into a fragment reserved for exactly
+ * that size. Shared fragments like record sets are not counted, they are
+ * appended as they are in both cases.
+ */
+template<typename T, typename = void>
+struct is_presized_response : std::false_type {};
+
+template<typename T>
+struct is_presized_response<T, std::void_t<decltype(T::presized_encoding)>>
+  : std::bool_constant<T::presized_encoding> {};
+
+template<typename T>
+inline constexpr bool is_presized_response_v = is_presized_response<T>::value;
+
 } // namespace kafka
@@ -15,6 +15,7 @@
 #include "bytes/iobuf.h"
 #include "kafka/errors.h"
 #include "kafka/types.h"
+#include "likely.h"
 #include "model/fundamental.h"
 #include "model/timestamp.h"
 #include "seastarx.h"
@@ -26,6 +27,7 @@
 
 #include <boost/range/numeric.hpp>
 
+#include <array>
 #include <optional>
 #include <string_view>
 
@@ -39,20 +41,50 @@ class response_writer {
       // clang-format on
       uint32_t serialize_int(IntegerType val) {
         auto nval = ss::cpu_to_be(ExplicitIntegerType(val));
-        _out->append(reinterpret_cast<const char*>(&nval), sizeof(nval));
+        append(reinterpret_cast<const char*>(&nval), sizeof(nval));
         return sizeof(nval);
     }
 
     uint32_t serialize_vint(int64_t val) {
         auto x = vint::to_bytes(val);
-        _out->append(x.data(), x.size());
+        append(x.data(), x.size());
         return x.size();
     }
 
+    void append(const char* data, size_t size) {
+        if (likely(_out)) {
+            _out->append(data, size);
+        } else {
+            _copied += size;
+        }
+    }
+
+    void append_fragments(iobuf&& f) {
+        if (likely(_out)) {
+            _out->append_fragments(std::move(f));
+        } else {
+            _shared += f.size_bytes();
+        }
+    }
+
+    size_t bytes_written() const {
+        return _out ? _out->size_bytes() : _copied + _shared;
+    }
+
 public:
+    /// writer of a sizing pass, counts what an encoding would write
+    struct size_only {};
+
     explicit response_writer(iobuf& out) noexcept
       : _out(&out) {}
 
+    explicit response_writer(size_only) noexcept
+      : _out(nullptr) {}
+
+    /// bytes a sizing pass would have copied into the output, shared
+    /// fragments excluded
+    size_t copied_bytes() const { return _copied; }
+
     uint32_t write(bool v) { return serialize_int<int8_t>(v); }
 
     uint32_t write(int8_t v) { return serialize_int<int8_t>(v); }
@@ -75,11 +107,63 @@ public:
 
     uint32_t write_varint(int32_t v) { return serialize_vint(v); }
 
+    // flexible versions, see request_reader
+
+    uint32_t write_unsigned_varint(uint32_t v) {
+        std::array<char, 5> buf;
+        size_t n = 0;
+        while (v >= 0x80) {
+            buf[n++] = char((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        buf[n++] = char(v);
+        append(buf.data(), n);
+        return n;
+    }
+
+    uint32_t write_compact(std::string_view v) {
+        auto size = write_unsigned_varint(v.size() + 1) + v.size();
+        append(v.data(), v.size());
+        return size;
+    }
+
+    uint32_t write_compact(const ss::sstring& v) {
+        return write_compact(std::string_view(v));
+    }
+
+    template<typename T>
+    uint32_t write_compact(const std::optional<T>& v) {
+        if (!v) {
+            return write_unsigned_varint(0);
+        }
+        return write_compact(*v);
+    }
+
+    uint32_t write_compact(bytes_view bv) {
+        auto size = write_unsigned_varint(bv.size() + 1) + bv.size();
+        append(reinterpret_cast<const char*>(bv.data()), bv.size());
+        return size;
+    }
+
+    template<typename T, typename Tag>
+    uint32_t write_compact(const named_type<T, Tag>& t) {
+        return write_compact(t());
+    }
+
+    // the compact or the classic form, used by the generated code
+    template<typename T>
+    uint32_t write_flex(bool flexible, const T& v) {
+        return flexible ? write_compact(v) : write(v);
+    }
+
+    /// no tagged fields are written
+    uint32_t write_tagged_fields() { return write_unsigned_varint(0); }
+
     uint32_t write_varlong(int64_t v) { return serialize_vint(v); }
 
     uint32_t write(std::string_view v) {
         auto size = serialize_int<int16_t>(v.size()) + v.size();
-        _out->append(v.data(), v.size());
+        append(v.data(), v.size());
         return size;
     }
 
@@ -101,7 +185,7 @@ public:
 
     uint32_t write(bytes_view bv) {
         auto size = serialize_int<int32_t>(bv.size()) + bv.size();
-        _out->append(reinterpret_cast<const char*>(bv.data()), bv.size());
+        append(reinterpret_cast<const char*>(bv.data()), bv.size());
         return size;
     }
 
@@ -113,14 +197,17 @@ public:
         }
         auto size = serialize_int<int32_t>(data->size_bytes())
                     + data->size_bytes();
-        _out->append(std::move(*data));
+        // record sets are large, share their fragments instead of copying
+        append_fragments(std::move(*data));
         return size;
     }
 
-    // write bytes directly to output without a length prefix
+    // write bytes directly to output without a length prefix. fragments are
+    // shared with the output, so payloads read from the batch cache are not
+    // copied when serialized into a response.
     uint32_t write_direct(iobuf&& f) {
         auto size = f.size_bytes();
-        _out->append(std::move(f));
+        append_fragments(std::move(f));
         return size;
     }
 
@@ -143,12 +230,12 @@ public:
     })
     // clang-format on
     uint32_t write_array(const std::vector<T>& v, ElementWriter&& writer) {
-        auto start_size = uint32_t(_out->size_bytes());
+        auto start_size = uint32_t(bytes_written());
         write(int32_t(v.size()));
         for (auto& elem : v) {
             writer(elem, *this);
         }
-        return _out->size_bytes() - start_size;
+        return bytes_written() - start_size;
     }
     // clang-format off
     template<typename T, typename ElementWriter>
@@ -158,12 +245,52 @@ public:
     })
     // clang-format on
     uint32_t write_array(std::vector<T>& v, ElementWriter&& writer) {
-        auto start_size = uint32_t(_out->size_bytes());
+        auto start_size = uint32_t(bytes_written());
         write(int32_t(v.size()));
         for (auto& elem : v) {
             writer(elem, *this);
         }
-        return _out->size_bytes() - start_size;
+        return bytes_written() - start_size;
+    }
+
+    template<typename T, typename ElementWriter>
+    uint32_t write_compact_array(std::vector<T>& v, ElementWriter&& writer) {
+        auto start_size = uint32_t(bytes_written());
+        write_unsigned_varint(v.size() + 1);
+        for (auto& elem : v) {
+            writer(elem, *this);
+        }
+        return bytes_written() - start_size;
+    }
+
+    template<typename T, typename ElementWriter>
+    uint32_t write_compact_nullable_array(
+      std::optional<std::vector<T>>& v, ElementWriter&& writer) {
+        if (!v) {
+            return write_unsigned_varint(0);
+        }
+        return write_compact_array(*v, std::forward<ElementWriter>(writer));
+    }
+
+    template<typename T, typename ElementWriter>
+    uint32_t
+    write_flex_array(bool flexible, std::vector<T>& v, ElementWriter&& writer) {
+        if (flexible) {
+            return write_compact_array(v, std::forward<ElementWriter>(writer));
+        }
+        return write_array(v, std::forward<ElementWriter>(writer));
+    }
+
+    template<typename T, typename ElementWriter>
+    uint32_t write_flex_nullable_array(
+      bool flexible,
+      std::optional<std::vector<T>>& v,
+      ElementWriter&& writer) {
+        if (flexible) {
+            return write_compact_nullable_array(
+              v, std::forward<ElementWriter>(writer));
+        }
+        return write_nullable_array(v, std::forward<ElementWriter>(writer));
     }
 
     // clang-format off
@@ -193,6 +320,12 @@ public:
     })
     // clang-format on
     uint32_t write_bytes_wrapped(ElementWriter&& writer) {
+        if (unlikely(!_out)) {
+            _copied += sizeof(int32_t);
+            auto start_size = bytes_written();
+            writer(*this);
+            return bytes_written() - start_size + sizeof(int32_t);
+        }
         auto ph = _out->reserve(sizeof(int32_t));
         auto start_size = uint32_t(_out->size_bytes());
         auto zero_len_is_null = writer(*this);
@@ -207,7 +340,10 @@ public:
     }
 
 private:
+    // null for a sizing pass
     iobuf* _out;
+    size_t _copied{0};
+    size_t _shared{0};
 };
 
 } // namespace kafka
@@ -17,9 +17,29 @@ ss::future<response_ptr> sasl_authenticate_api::process(
   request_context&& ctx, [[maybe_unused]] ss::smp_service_group g) {
     sasl_authenticate_request request;
     request.decode(ctx.reader(), ctx.header().version);
-    return ctx.respond(sasl_authenticate_response(
-      error_code::illegal_sasl_state,
-      "SASL authenticate request received after successful authentication"));
+    vlog(klog.debug, "Received SASL_AUTHENTICATE {}", request);
+
+    auto& sasl = ctx.sasl();
+    if (sasl.state() != security::sasl_server::sasl_state::authenticate) {
+        return ctx.respond(sasl_authenticate_response(
+          error_code::illegal_sasl_state,
+          "SASL authenticate request received in an unexpected state"));
+    }
+
+    // the credentials are already derived, this is a hmac and a hash
+    auto reply = sasl.mechanism().authenticate(request.data.auth_bytes);
+    if (!reply) {
+        sasl.set_state(security::sasl_server::sasl_state::failed);
+        return ctx.respond(sasl_authenticate_response(
+          error_code::sasl_authentication_failed, reply.error().message()));
+    }
+
+    if (sasl.mechanism().complete()) {
+        sasl.set_principal(sasl.mechanism().principal());
+        sasl.set_state(security::sasl_server::sasl_state::complete);
+        vlog(klog.debug, "Authenticated principal {}", sasl.principal());
+    }
+    return ctx.respond(sasl_authenticate_response(std::move(reply.value())));
 }
 
 } // namespace kafka
@@ -62,12 +62,17 @@ struct sasl_authenticate_response final {
 
     sasl_authenticate_response_data data;
 
-    explicit sasl_authenticate_response(
-      error_code error, ss::sstring error_msg) {
+    sasl_authenticate_response(error_code error, ss::sstring error_msg) {
         data.error_code = error;
         data.error_message = std::move(error_msg);
     }
 
+    /// \brief the reply of the mechanism to the client
+    explicit sasl_authenticate_response(bytes auth_bytes) {
+        data.error_code = error_code::none;
+        data.auth_bytes = std::move(auth_bytes);
+    }
+
     void encode(const request_context& ctx, response& resp) {
         data.encode(resp.writer(), ctx.header().version);
     }
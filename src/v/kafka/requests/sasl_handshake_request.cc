@@ -10,6 +10,7 @@
 #include "kafka/requests/sasl_handshake_request.h"
 
 #include "kafka/errors.h"
+#include "security/scram_authenticator.h"
 
 namespace kafka {
 
@@ -17,7 +18,33 @@ ss::future<response_ptr> sasl_handshake_api::process(
   request_context&& ctx, [[maybe_unused]] ss::smp_service_group g) {
     sasl_handshake_request request;
     request.decode(ctx.reader(), ctx.header().version);
-    return ctx.respond(sasl_handshake_response(error_code::illegal_sasl_state));
+    vlog(klog.debug, "Received SASL_HANDSHAKE {}", request);
+
+    std::vector<ss::sstring> mechanisms{
+      security::scram_sha256::name, security::scram_sha512::name};
+
+    if (ctx.sasl().state() != security::sasl_server::sasl_state::handshake) {
+        return ctx.respond(sasl_handshake_response(
+          error_code::illegal_sasl_state, std::move(mechanisms)));
+    }
+
+    const auto& mechanism = request.data.mechanism;
+    if (mechanism == security::scram_sha256::name) {
+        ctx.sasl().set_mechanism(
+          std::make_unique<security::scram_sha256_authenticator>(
+            ctx.credentials()));
+    } else if (mechanism == security::scram_sha512::name) {
+        ctx.sasl().set_mechanism(
+          std::make_unique<security::scram_sha512_authenticator>(
+            ctx.credentials()));
+    } else {
+        return ctx.respond(sasl_handshake_response(
+          error_code::unsupported_sasl_mechanism, std::move(mechanisms)));
+    }
+
+    ctx.sasl().set_state(security::sasl_server::sasl_state::authenticate);
+    return ctx.respond(
+      sasl_handshake_response(error_code::none, std::move(mechanisms)));
 }
 
 } // namespace kafka
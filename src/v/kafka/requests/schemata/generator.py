@@ -21,12 +21,10 @@
 #   path_type_map to override types, it would be more efficient to specify the
 #   same mapping using the field_name_type_map + a whitelist of request types.
 #
-#   - The current version does not handle flexible versions. It will be some
-#   time before we encounter clients requiring this, but in principle this
-#   generator should be extensible (see type maps below). Note that when the
-#   time comes to support flexible versions, there is a filter in the templates
-#   within this file that ignores such fields, and that filter should be
-#   removed.
+#   - Flexible versions use the compact encodings for strings, bytes and
+#   arrays, and every struct is followed by its tagged fields. No tagged
+#   fields of the schemata are decoded, the tagged fields of a request are
+#   skipped and responses are written without any.
 #
 #   - Handle ignorable fields. Currently we handle nullable fields properly. The
 #   ignorable flag on a field doesn't change the wire protocol, but gives
@@ -155,6 +153,23 @@ path_type_map = {
             },
         },
     },
+    "DeleteRecordsRequestData": {
+        "TimeoutMs": ("std::chrono::milliseconds", "int32"),
+        "Topics": {
+            "Partitions": {
+                "PartitionIndex": ("model::partition_id", "int32"),
+                "Offset": ("model::offset", "int64"),
+            },
+        },
+    },
+    "DeleteRecordsResponseData": {
+        "Topics": {
+            "Partitions": {
+                "PartitionIndex": ("model::partition_id", "int32"),
+                "LowWatermark": ("model::offset", "int64"),
+            },
+        },
+    },
     "DescribeGroupsResponseData": {
         "Groups": {
             "ProtocolType": ("kafka::protocol_type", "string"),
@@ -205,6 +220,13 @@ basic_type_map = dict(
     int64=("int64_t", "read_int64()"),
 )
 
+# decoders of the compact or classic form, picked by the flexible version
+flex_decoder_map = {
+    "read_string()": "read_flex_string(flexible)",
+    "read_nullable_string()": "read_flex_nullable_string(flexible)",
+    "read_bytes()": "read_flex_bytes(flexible)",
+}
+
 # a listing of expected struct types
 STRUCT_TYPES = [
     "ApiVersionsRequestKey",
@@ -518,6 +540,26 @@ class Field:
             return plain_decoder[2], named_type
         return plain_decoder[1], named_type
 
+    def flex_decoder(self, flexible):
+        """
+        The decoder of the field when a message has flexible versions.
+        Strings and bytes switch to their compact form at runtime.
+        """
+        decoder, named_type = self.decoder
+        if flexible:
+            decoder = flex_decoder_map.get(decoder, decoder)
+        return decoder, named_type
+
+    @property
+    def compactable(self):
+        """
+        Strings and bytes have a compact encoding in flexible versions.
+        """
+        t = self._type
+        if isinstance(t, ArrayType):
+            t = t.value_type()
+        return t.name in ("string", "bytes")
+
     @property
     def is_array(self):
         return isinstance(self._type, ArrayType)
@@ -629,22 +671,42 @@ if ({{ cond }}) {
 {%- set fname = field.name %}
 {%- endif %}
 {%- if field.is_array %}
-{%- if field.nullable() %}
-writer.write_nullable_array({{ fname }}, [version]({{ field.value_type }}& v, response_writer& writer) {
+{%- if flexible and field.nullable() %}
+writer.write_flex_nullable_array(flexible, {{ fname }}, [{{ captures }}]({{ field.value_type }}& v, response_writer& writer) {
+{%- elif flexible %}
+writer.write_flex_array(flexible, {{ fname }}, [{{ captures }}]({{ field.value_type }}& v, response_writer& writer) {
+{%- elif field.nullable() %}
+writer.write_nullable_array({{ fname }}, [{{ captures }}]({{ field.value_type }}& v, response_writer& writer) {
 {%- else %}
-writer.write_array({{ fname }}, [version]({{ field.value_type }}& v, response_writer& writer) {
+writer.write_array({{ fname }}, [{{ captures }}]({{ field.value_type }}& v, response_writer& writer) {
 {%- endif %}
 {%- if field.type().value_type().is_struct %}
-{{- struct_serde(field.type().value_type(), field_encoder, "v") | indent }}
+{{- struct_serde(field.type().value_type(), field_encoder, tagged_encoder, "v") | indent }}
+{%- elif flexible and field.compactable %}
+    writer.write_flex(flexible, v);
 {%- else %}
     writer.write(v);
 {%- endif %}
 });
+{%- elif flexible and field.compactable %}
+writer.write_flex(flexible, {{ fname }});
 {%- else %}
 writer.write({{ fname }});
 {%- endif %}
 {%- endmacro %}
 
+{% macro tagged_encoder() %}
+if (flexible) {
+    writer.write_tagged_fields();
+}
+{%- endmacro %}
+
+{% macro tagged_decoder() %}
+if (flexible) {
+    reader.consume_tagged_fields();
+}
+{%- endmacro %}
+
 {% macro field_decoder(field, obj) %}
 {%- if obj %}
 {%- set fname = obj + "." + field.name %}
@@ -652,17 +714,21 @@ writer.write({{ fname }});
 {%- set fname = field.name %}
 {%- endif %}
 {%- if field.is_array %}
-{%- if field.nullable() %}
-{{ fname }} = reader.read_nullable_array([version](request_reader& reader) {
+{%- if flexible and field.nullable() %}
+{{ fname }} = reader.read_flex_nullable_array(flexible, [{{ captures }}](request_reader& reader) {
+{%- elif flexible %}
+{{ fname }} = reader.read_flex_array(flexible, [{{ captures }}](request_reader& reader) {
+{%- elif field.nullable() %}
+{{ fname }} = reader.read_nullable_array([{{ captures }}](request_reader& reader) {
 {%- else %}
-{{ fname }} = reader.read_array([version](request_reader& reader) {
+{{ fname }} = reader.read_array([{{ captures }}](request_reader& reader) {
 {%- endif %}
 {%- if field.type().value_type().is_struct %}
     {{ field.type().value_type().name }} v;
-{{- struct_serde(field.type().value_type(), field_decoder, "v") | indent }}
+{{- struct_serde(field.type().value_type(), field_decoder, tagged_decoder, "v") | indent }}
     return v;
 {%- else %}
-{%- set decoder, named_type = field.decoder %}
+{%- set decoder, named_type = field.flex_decoder(flexible) %}
 {%- if named_type == None %}
     return reader.{{ decoder }};
 {%- elif field.nullable() %}
@@ -679,7 +745,7 @@ writer.write({{ fname }});
 {%- endif %}
 });
 {%- else %}
-{%- set decoder, named_type = field.decoder %}
+{%- set decoder, named_type = field.flex_decoder(flexible) %}
 {%- if named_type == None %}
 {{ fname }} = reader.{{ decoder }};
 {%- elif field.nullable() %}
@@ -695,30 +761,42 @@ writer.write({{ fname }});
 {%- endif %}
 {%- endmacro %}
 
-{% macro struct_serde(struct, field_serde, obj = "") %}
+{% macro struct_serde(struct, field_serde, tagged_serde, obj = "") %}
 {%- for field in struct.fields %}
 {%- call version_guard(field) %}
 {{- field_serde(field, obj) }}
 {%- endcall %}
 {%- endfor %}
+{%- if flexible %}
+{{- tagged_serde() }}
+{%- endif %}
+{%- endmacro %}
+
+{% macro flexible_flag() %}
+{%- if flexible %}
+    const bool flexible = {{ flexible.guard() }};
+{%- endif %}
 {%- endmacro %}
 
 namespace kafka {
 
 {%- if struct.fields %}
 void {{ struct.name }}::encode(response_writer& writer, [[maybe_unused]] api_version version) {
-{{- struct_serde(struct, field_encoder) | indent }}
+{{- flexible_flag() }}
+{{- struct_serde(struct, field_encoder, tagged_encoder) | indent }}
 }
 
 {%- if op_type == "request" %}
 void {{ struct.name }}::decode(request_reader& reader, [[maybe_unused]] api_version version) {
-{{- struct_serde(struct, field_decoder) | indent }}
+{{- flexible_flag() }}
+{{- struct_serde(struct, field_decoder, tagged_decoder) | indent }}
 }
 {%- else %}
 void {{ struct.name }}::decode(iobuf buf, api_version version) {
     request_reader reader(std::move(buf));
+{{- flexible_flag() }}
 
-{{- struct_serde(struct, field_decoder) | indent }}
+{{- struct_serde(struct, field_decoder, tagged_decoder) | indent }}
 }
 {%- endif %}
 {%- else %}
@@ -910,6 +988,12 @@ if __name__ == "__main__":
     # request or response
     op_type = msg["type"]
 
+    # versions using the compact encodings and tagged fields
+    flexible = None
+    if msg["flexibleVersions"] != "none":
+        flexible = VersionRange(msg["flexibleVersions"])
+    captures = "version, flexible" if flexible else "version"
+
     with open(hdr, 'w') as f:
         f.write(
             jinja2.Template(HEADER_TEMPLATE).render(
@@ -921,4 +1005,6 @@ if __name__ == "__main__":
         f.write(
             jinja2.Template(SOURCE_TEMPLATE).render(struct=struct,
                                                     header=hdr.name,
-                                                    op_type=op_type))
+                                                    op_type=op_type,
+                                                    flexible=flexible,
+                                                    captures=captures))
@@ -78,8 +78,11 @@ cluster::topic_configuration to_cluster_type(const creatable_topic& t) {
 
     auto config_entries = config_map(t.configs);
     // Parse topic configuration
-    cfg.compression = get_config_value<model::compression>(
-      config_entries, "compression.type");
+    // `producer` keeps the batches in the codec they were produced with
+    if (auto it = config_entries.find("compression.type");
+        it != config_entries.end() && it->second != "producer") {
+        cfg.compression = boost::lexical_cast<model::compression>(it->second);
+    }
     cfg.cleanup_policy_bitflags
       = get_config_value<model::cleanup_policy_bitflags>(
         config_entries, "cleanup.policy");
@@ -87,12 +90,23 @@ cluster::topic_configuration to_cluster_type(const creatable_topic& t) {
       config_entries, "message.timestamp.type");
     cfg.segment_size = get_config_value<size_t>(
       config_entries, "segment.bytes");
+    cfg.index_interval = get_config_value<size_t>(
+      config_entries, "index.interval.bytes");
     cfg.compaction_strategy = get_config_value<model::compaction_strategy>(
       config_entries, "compaction.strategy");
     cfg.retention_bytes = get_tristate_value<size_t>(
       config_entries, "retention.bytes");
     cfg.retention_duration = get_tristate_value<std::chrono::milliseconds>(
       config_entries, "retention.ms");
+    if (auto lag = get_config_value<int64_t>(
+          config_entries, "redpanda.write.behind.ms");
+        lag && *lag > 0) {
+        cfg.write_behind = std::chrono::milliseconds(*lag);
+    }
+    if (auto it = config_entries.find("redpanda.storage.type");
+        it != config_entries.end()) {
+        cfg.ephemeral = it->second == "memory";
+    }
 
     return cfg;
 }
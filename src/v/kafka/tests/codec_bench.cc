@@ -0,0 +1,348 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/metadata_request.h"
+#include "kafka/requests/produce_request.h"
+#include "kafka/requests/request_reader.h"
+#include "kafka/requests/response_writer.h"
+#include "model/fundamental.h"
+#include "random/generators.h"
+#include "redpanda/tests/fixture.h"
+#include "storage/tests/utils/random_batch.h"
+#include "test_utils/alloc_counter.h"
+#include "units.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+#include <vector>
+
+/**
+ * Encoding and decoding of the requests and responses of the hot apis, for
+ * request mixes of the shape clients send: many small produce requests, a
+ * fetch of 1000 partitions and the metadata of 50k partitions. The requests
+ * are decoded through a request context and the responses encoded through
+ * request_context::respond like the connection does, the in-process cluster
+ * only backs the contexts, nothing is produced to or read from it.
+ */
+struct codec_bench_fixture : redpanda_thread_fixture {
+    static constexpr int produce_requests = 100;
+    static constexpr int records_per_batch = 5;
+    static constexpr int fetch_topics = 4;
+    static constexpr int fetch_partitions_per_topic = 250;
+    static constexpr int metadata_topics = 500;
+    static constexpr int metadata_partitions_per_topic = 100;
+    static constexpr int primitive_fields = 1000;
+
+    codec_bench_fixture() {
+        for (int i = 0; i < produce_requests; ++i) {
+            batches.push_back(storage::test::make_random_batch(
+              model::offset(0), records_per_batch, false));
+            auto r = make_produce_request(i);
+            produce_buffers.push_back(encode_request(r));
+        }
+        fetch = make_fetch_request();
+        fetch_buffer = encode_request(fetch);
+        fetch_response_buffer = encode_response<kafka::fetch_api>(
+          make_fetch_response());
+        metadata_response_buffer = encode_response<kafka::metadata_api>(
+          make_metadata_response());
+    }
+
+    template<typename Api>
+    kafka::request_context make_context(iobuf buf) {
+        kafka::request_header header{
+          .key = Api::key,
+          .version = Api::max_supported,
+        };
+        return kafka::request_context(
+          app.metadata_cache,
+          app.controller->get_topics_frontend().local(),
+          std::move(header),
+          std::move(buf),
+          std::chrono::milliseconds(0),
+          app.group_router.local(),
+          app.shard_table.local(),
+          app.partition_manager,
+          app.coordinator_ntp_mapper,
+          app.fetch_session_cache,
+          app.metadata_response_cache,
+          app.down_conversion_cache,
+          app.controller->get_credential_store(),
+          nullptr);
+    }
+
+    template<typename Request>
+    static iobuf encode_request(Request& r) {
+        iobuf buf;
+        kafka::response_writer writer(buf);
+        r.encode(writer, Request::api_type::max_supported);
+        return buf;
+    }
+
+    template<typename Api, typename Response>
+    iobuf encode_response(Response r) {
+        auto resp = make_context<Api>(iobuf()).respond(std::move(r)).get0();
+        return std::move(*resp).release();
+    }
+
+    /// a single partition of a few small records, as sent by clients with a
+    /// short linger
+    kafka::produce_request make_produce_request(int i) {
+        std::vector<kafka::produce_request::partition> partitions;
+        partitions.push_back(kafka::produce_request::partition{
+          .id = model::partition_id(i % 16),
+        });
+        partitions.back().adapter.batch = batches[i].share();
+        std::vector<kafka::produce_request::topic> topics;
+        topics.push_back(kafka::produce_request::topic{
+          .name = model::topic("codec_bench"),
+          .partitions = std::move(partitions),
+        });
+        kafka::produce_request r(std::nullopt, -1, std::move(topics));
+        r.timeout = std::chrono::seconds(30);
+        return r;
+    }
+
+    static kafka::fetch_request make_fetch_request() {
+        kafka::fetch_request r;
+        r.replica_id = model::node_id(-1);
+        r.max_wait_time = std::chrono::milliseconds(500);
+        r.min_bytes = 1;
+        r.max_bytes = 50_MiB;
+        r.isolation_level = 0;
+        for (int t = 0; t < fetch_topics; ++t) {
+            kafka::fetch_request::topic ft{
+              .name = model::topic(fmt::format("codec_bench_{}", t)),
+              .partitions = {},
+            };
+            for (int p = 0; p < fetch_partitions_per_topic; ++p) {
+                ft.partitions.push_back(kafka::fetch_request::partition{
+                  .id = model::partition_id(p),
+                  .current_leader_epoch = 1,
+                  .fetch_offset = model::offset(1000),
+                  .log_start_offset = model::offset(-1),
+                  .partition_max_bytes = 1_MiB,
+                });
+            }
+            r.topics.push_back(std::move(ft));
+        }
+        return r;
+    }
+
+    /// every partition answers with a small record set
+    static kafka::fetch_response make_fetch_response() {
+        static constexpr size_t record_set_bytes = 512;
+        const auto data = random_generators::gen_alphanum_string(
+          record_set_bytes);
+        kafka::fetch_response r;
+        r.error = kafka::error_code::none;
+        r.session_id = 0;
+        for (int t = 0; t < fetch_topics; ++t) {
+            kafka::fetch_response::partition p(
+              model::topic(fmt::format("codec_bench_{}", t)));
+            for (int i = 0; i < fetch_partitions_per_topic; ++i) {
+                iobuf records;
+                records.append(data.data(), data.size());
+                p.responses.push_back(kafka::fetch_response::partition_response{
+                  .id = model::partition_id(i),
+                  .error = kafka::error_code::none,
+                  .high_watermark = model::offset(2000),
+                  .last_stable_offset = model::offset(2000),
+                  .log_start_offset = model::offset(0),
+                  .aborted_transactions = {},
+                  .record_set = std::move(records),
+                });
+            }
+            r.partitions.push_back(std::move(p));
+        }
+        return r;
+    }
+
+    static kafka::metadata_response make_metadata_response() {
+        const std::vector<model::node_id> replicas{
+          model::node_id(1), model::node_id(2), model::node_id(3)};
+        kafka::metadata_response r;
+        for (const auto& id : replicas) {
+            r.brokers.push_back(kafka::metadata_response::broker{
+              .node_id = id,
+              .host = fmt::format("broker-{}.codec-bench.local", id()),
+              .port = 9092,
+              .rack = std::nullopt,
+            });
+        }
+        r.cluster_id = "codec_bench";
+        r.controller_id = replicas[0];
+        for (int t = 0; t < metadata_topics; ++t) {
+            kafka::metadata_response::topic topic{
+              .err_code = kafka::error_code::none,
+              .name = model::topic(fmt::format("codec_bench_{}", t)),
+              .partitions = {},
+              .topic_authorized_operations = 0,
+            };
+            for (int p = 0; p < metadata_partitions_per_topic; ++p) {
+                topic.partitions.push_back(kafka::metadata_response::partition{
+                  .err_code = kafka::error_code::none,
+                  .index = model::partition_id(p),
+                  .leader = replicas[p % replicas.size()],
+                  .leader_epoch = 1,
+                  .replica_nodes = replicas,
+                  .isr_nodes = replicas,
+                  .offline_replicas = {},
+                });
+            }
+            r.topics.push_back(std::move(topic));
+        }
+        return r;
+    }
+
+    std::vector<model::record_batch> batches;
+    std::vector<iobuf> produce_buffers;
+    kafka::fetch_request fetch;
+    iobuf fetch_buffer;
+    iobuf fetch_response_buffer;
+    iobuf metadata_response_buffer;
+};
+
+PERF_TEST_F(codec_bench_fixture, primitives_encode) {
+    iobuf buf;
+    kafka::response_writer writer(buf);
+    const ss::sstring name("codec_bench_topic");
+    tests::alloc_counter allocs("kafka.primitives_encode");
+    for (int i = 0; i < primitive_fields; ++i) {
+        writer.write(int32_t(i));
+        writer.write(int64_t(i));
+        writer.write_varint(i);
+        writer.write(name);
+    }
+    allocs.stop(primitive_fields);
+    perf_tests::do_not_optimize(buf);
+}
+
+PERF_TEST_F(codec_bench_fixture, primitives_decode) {
+    iobuf buf;
+    kafka::response_writer writer(buf);
+    const ss::sstring name("codec_bench_topic");
+    for (int i = 0; i < primitive_fields; ++i) {
+        writer.write(int32_t(i));
+        writer.write(int64_t(i));
+        writer.write_varint(i);
+        writer.write(name);
+    }
+    kafka::request_reader reader(std::move(buf));
+    int64_t sum = 0;
+    tests::alloc_counter allocs("kafka.primitives_decode");
+    for (int i = 0; i < primitive_fields; ++i) {
+        sum += reader.read_int32();
+        sum += reader.read_int64();
+        sum += reader.read_varint();
+        sum += reader.read_string().size();
+    }
+    allocs.stop(primitive_fields);
+    perf_tests::do_not_optimize(sum);
+}
+
+PERF_TEST_F(codec_bench_fixture, produce_request_encode) {
+    std::vector<kafka::produce_request> requests;
+    requests.reserve(produce_requests);
+    for (int i = 0; i < produce_requests; ++i) {
+        requests.push_back(make_produce_request(i));
+    }
+    iobuf buf;
+    kafka::response_writer writer(buf);
+    tests::alloc_counter allocs("kafka.produce_request_encode");
+    for (auto& r : requests) {
+        r.encode(writer, kafka::produce_api::max_supported);
+    }
+    allocs.stop(requests.size());
+    perf_tests::do_not_optimize(buf);
+}
+
+// decoding a produce request adapts its batches, see kafka_batch_adapter
+PERF_TEST_F(codec_bench_fixture, produce_request_decode) {
+    std::vector<kafka::request_context> contexts;
+    contexts.reserve(produce_buffers.size());
+    for (auto& buf : produce_buffers) {
+        contexts.push_back(make_context<kafka::produce_api>(
+          buf.share(0, buf.size_bytes())));
+    }
+    size_t valid = 0;
+    tests::alloc_counter allocs("kafka.produce_request_decode");
+    for (auto& ctx : contexts) {
+        kafka::produce_request r(ctx);
+        valid += r.topics[0].partitions[0].adapter.valid_crc;
+        r.recycle();
+    }
+    allocs.stop(contexts.size());
+    perf_tests::do_not_optimize(valid);
+}
+
+PERF_TEST_F(codec_bench_fixture, fetch_request_encode_1000_partitions) {
+    iobuf buf;
+    kafka::response_writer writer(buf);
+    tests::alloc_counter allocs("kafka.fetch_request_encode_1000_partitions");
+    fetch.encode(writer, kafka::fetch_api::max_supported);
+    allocs.stop(1);
+    perf_tests::do_not_optimize(buf);
+}
+
+PERF_TEST_F(codec_bench_fixture, fetch_request_decode_1000_partitions) {
+    auto ctx = make_context<kafka::fetch_api>(
+      fetch_buffer.share(0, fetch_buffer.size_bytes()));
+    kafka::fetch_request r;
+    tests::alloc_counter allocs("kafka.fetch_request_decode_1000_partitions");
+    r.decode(ctx);
+    allocs.stop(1);
+    r.recycle();
+}
+
+PERF_TEST_F(codec_bench_fixture, fetch_response_encode_1000_partitions) {
+    auto ctx = make_context<kafka::fetch_api>(iobuf());
+    auto r = make_fetch_response();
+    tests::alloc_counter allocs(
+      "kafka.fetch_response_encode_1000_partitions");
+    auto resp = ctx.respond(std::move(r)).get0();
+    allocs.stop(1);
+    perf_tests::do_not_optimize(resp);
+}
+
+PERF_TEST_F(codec_bench_fixture, fetch_response_decode_1000_partitions) {
+    auto buf = fetch_response_buffer.share(
+      0, fetch_response_buffer.size_bytes());
+    kafka::fetch_response r;
+    tests::alloc_counter allocs(
+      "kafka.fetch_response_decode_1000_partitions");
+    r.decode(std::move(buf), kafka::fetch_api::max_supported);
+    allocs.stop(1);
+    perf_tests::do_not_optimize(r);
+}
+
+PERF_TEST_F(codec_bench_fixture, metadata_response_encode_50k_partitions) {
+    auto ctx = make_context<kafka::metadata_api>(iobuf());
+    auto r = make_metadata_response();
+    tests::alloc_counter allocs(
+      "kafka.metadata_response_encode_50k_partitions");
+    auto resp = ctx.respond(std::move(r)).get0();
+    allocs.stop(1);
+    perf_tests::do_not_optimize(resp);
+}
+
+PERF_TEST_F(codec_bench_fixture, metadata_response_decode_50k_partitions) {
+    auto buf = metadata_response_buffer.share(
+      0, metadata_response_buffer.size_bytes());
+    kafka::metadata_response r;
+    tests::alloc_counter allocs(
+      "kafka.metadata_response_decode_50k_partitions");
+    r.decode(std::move(buf), kafka::metadata_api::max_supported);
+    allocs.stop(1);
+    perf_tests::do_not_optimize(r);
+}
@@ -0,0 +1,152 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/down_conversion.h"
+
+#include "bytes/iobuf_parser.h"
+#include "cluster/namespace.h"
+#include "raft/types.h"
+#include "storage/record_batch_builder.h"
+#include "units.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/crc.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+const model::ntp ntp(
+  cluster::kafka_namespace, model::topic("t"), model::partition_id(0));
+
+iobuf make_iobuf(std::string_view s) {
+    iobuf buf;
+    buf.append(s.data(), s.size());
+    return buf;
+}
+
+model::record_batch make_batch(model::offset base, std::string_view value) {
+    storage::record_batch_builder builder(raft::data_batch_type, base);
+    for (int i = 0; i < 3; ++i) {
+        builder.add_raw_kv(
+          make_iobuf(fmt::format("key-{}", i)), make_iobuf(value));
+    }
+    return std::move(builder).build();
+}
+
+struct legacy_message {
+    model::offset offset;
+    int8_t magic;
+    int64_t timestamp;
+    ss::sstring key;
+    ss::sstring value;
+};
+
+std::vector<legacy_message> parse_message_set(iobuf buf, int8_t magic) {
+    std::vector<legacy_message> ret;
+    iobuf_parser parser(std::move(buf));
+    while (parser.bytes_left()) {
+        legacy_message m;
+        m.offset = model::offset(parser.consume_be_type<int64_t>());
+        auto size = parser.consume_be_type<int32_t>();
+        auto crc = parser.consume_be_type<uint32_t>();
+        auto body = parser.share(size - sizeof(uint32_t));
+        boost::crc_32_type expected;
+        auto linear = iobuf_parser(body.copy()).read_bytes(body.size_bytes());
+        expected.process_bytes(linear.data(), linear.size());
+        BOOST_REQUIRE_EQUAL(crc, expected.checksum());
+
+        iobuf_parser msg(std::move(body));
+        m.magic = msg.consume_type<int8_t>();
+        BOOST_REQUIRE_EQUAL(m.magic, magic);
+        BOOST_REQUIRE_EQUAL(msg.consume_type<int8_t>(), 0);
+        m.timestamp = magic > 0 ? msg.consume_be_type<int64_t>() : -1;
+        m.key = msg.read_string(msg.consume_be_type<int32_t>());
+        m.value = msg.read_string(msg.consume_be_type<int32_t>());
+        BOOST_REQUIRE_EQUAL(msg.bytes_left(), 0);
+        ret.push_back(std::move(m));
+    }
+    return ret;
+}
+
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(down_conversion_legacy_magic) {
+    BOOST_REQUIRE_EQUAL(*kafka::legacy_magic(kafka::api_version(0)), 0);
+    BOOST_REQUIRE_EQUAL(*kafka::legacy_magic(kafka::api_version(1)), 0);
+    BOOST_REQUIRE_EQUAL(*kafka::legacy_magic(kafka::api_version(2)), 1);
+    BOOST_REQUIRE_EQUAL(*kafka::legacy_magic(kafka::api_version(3)), 1);
+    BOOST_REQUIRE(!kafka::legacy_magic(kafka::api_version(4)));
+}
+
+SEASTAR_THREAD_TEST_CASE(down_conversion_message_sets) {
+    auto batch = make_batch(model::offset(10), "value");
+    for (int8_t magic : {0, 1}) {
+        auto msgs = parse_message_set(kafka::down_convert(batch, magic), magic);
+        BOOST_REQUIRE_EQUAL(msgs.size(), 3);
+        for (size_t i = 0; i < msgs.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(msgs[i].offset, model::offset(10 + i));
+            BOOST_REQUIRE_EQUAL(msgs[i].key, fmt::format("key-{}", i));
+            BOOST_REQUIRE_EQUAL(msgs[i].value, "value");
+            if (magic > 0) {
+                BOOST_REQUIRE_EQUAL(
+                  msgs[i].timestamp, batch.header().first_timestamp());
+            }
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(down_conversion_cache_shares_conversions) {
+    kafka::down_conversion_cache cache(1_MiB);
+    auto first = cache.get(ntp, make_batch(model::offset(0), "a"), 1).get0();
+    auto second = cache.get(ntp, make_batch(model::offset(0), "a"), 1).get0();
+    BOOST_REQUIRE_EQUAL(cache.misses(), 1);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1);
+    BOOST_REQUIRE(first == second);
+
+    // each magic is converted on its own
+    cache.get(ntp, make_batch(model::offset(0), "a"), 0).get();
+    BOOST_REQUIRE_EQUAL(cache.misses(), 2);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2);
+
+    // a batch written again at the same offset is converted again
+    auto rewritten
+      = cache.get(ntp, make_batch(model::offset(0), "b"), 1).get0();
+    BOOST_REQUIRE_EQUAL(cache.misses(), 3);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2);
+    auto msgs = parse_message_set(std::move(rewritten), 1);
+    BOOST_REQUIRE_EQUAL(msgs[0].value, "b");
+}
+
+SEASTAR_THREAD_TEST_CASE(down_conversion_cache_evicts_least_recently_used) {
+    const auto size = kafka::down_convert(make_batch(model::offset(0), "a"), 1)
+                        .size_bytes();
+    // configuration under test, room for two conversions
+    kafka::down_conversion_cache cache(2 * size);
+    cache.get(ntp, make_batch(model::offset(0), "a"), 1).get();
+    cache.get(ntp, make_batch(model::offset(3), "a"), 1).get();
+    // offset 0 is used more recently than offset 3
+    cache.get(ntp, make_batch(model::offset(0), "a"), 1).get();
+    cache.get(ntp, make_batch(model::offset(6), "a"), 1).get();
+    BOOST_REQUIRE_EQUAL(cache.size(), 2);
+    BOOST_REQUIRE_EQUAL(cache.size_bytes(), 2 * size);
+
+    cache.get(ntp, make_batch(model::offset(0), "a"), 1).get();
+    BOOST_REQUIRE_EQUAL(cache.hits(), 2);
+    cache.get(ntp, make_batch(model::offset(3), "a"), 1).get();
+    BOOST_REQUIRE_EQUAL(cache.misses(), 4);
+}
+
+SEASTAR_THREAD_TEST_CASE(down_conversion_cache_disabled) {
+    kafka::down_conversion_cache cache(0);
+    cache.get(ntp, make_batch(model::offset(0), "a"), 1).get();
+    cache.get(ntp, make_batch(model::offset(0), "a"), 1).get();
+    BOOST_REQUIRE_EQUAL(cache.misses(), 2);
+    BOOST_REQUIRE_EQUAL(cache.size(), 0);
+}
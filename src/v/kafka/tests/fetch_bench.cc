@@ -0,0 +1,98 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/namespace.h"
+#include "kafka/requests/fetch_request.h"
+#include "model/fundamental.h"
+#include "redpanda/tests/fixture.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+#include <limits>
+
+/**
+ * Fetch requests covering many partitions spread over the shards of an
+ * in-process single node cluster. The partitions are empty, the benchmark
+ * measures the fan out of the reads to the shards and the assembly of the
+ * response rather than the reads themselves.
+ */
+struct fetch_bench_fixture : redpanda_thread_fixture {
+    static constexpr int topics = 4;
+    static constexpr int partitions_per_topic = 250;
+
+    fetch_bench_fixture() {
+        wait_for_controller_leadership().get();
+        request.max_bytes = std::numeric_limits<int32_t>::max();
+        request.min_bytes = 0;
+        request.max_wait_time = std::chrono::milliseconds::zero();
+        request.session_id = kafka::invalid_fetch_session_id;
+        request.session_epoch = kafka::final_fetch_session_epoch;
+        // topics created one at a time, every creation waits for all of
+        // its partitions
+        for (int t = 0; t < topics; ++t) {
+            model::topic topic(fmt::format("fetch_bench_{}", t));
+            add_topic(
+              model::topic_namespace_view(cluster::kafka_namespace, topic),
+              partitions_per_topic)
+              .get();
+            kafka::fetch_request::topic ft{.name = topic, .partitions = {}};
+            for (int p = 0; p < partitions_per_topic; ++p) {
+                wait_for_partition_offset(
+                  make_default_ntp(topic, model::partition_id(p)),
+                  model::offset(0))
+                  .get();
+                ft.partitions.push_back(kafka::fetch_request::partition{
+                  .id = model::partition_id(p),
+                  .fetch_offset = model::offset(0),
+                  .partition_max_bytes = 1_MiB,
+                });
+            }
+            request.topics.push_back(std::move(ft));
+        }
+    }
+
+    kafka::request_context make_fetch_context() {
+        kafka::request_header header{
+          .key = kafka::fetch_api::key,
+          .version = kafka::fetch_api::max_supported,
+        };
+        iobuf buf;
+        kafka::response_writer writer(buf);
+        request.encode(writer, header.version);
+        return kafka::request_context(
+          app.metadata_cache,
+          app.controller->get_topics_frontend().local(),
+          std::move(header),
+          std::move(buf),
+          std::chrono::milliseconds(0),
+          app.group_router.local(),
+          app.shard_table.local(),
+          app.partition_manager,
+          app.coordinator_ntp_mapper,
+          app.fetch_session_cache,
+          app.metadata_response_cache,
+          app.down_conversion_cache,
+          app.controller->get_credential_store(),
+          nullptr);
+    }
+
+    kafka::fetch_request request;
+};
+
+PERF_TEST_F(fetch_bench_fixture, fetch_1000_partitions) {
+    auto rctx = make_fetch_context();
+    perf_tests::start_measuring_time();
+    auto resp = kafka::fetch_api::process(
+                  std::move(rctx), ss::default_smp_service_group())
+                  .get0();
+    perf_tests::stop_measuring_time();
+    perf_tests::do_not_optimize(resp);
+}
@@ -216,3 +216,36 @@ FIXTURE_TEST(test_session_operations, fixture) {
         BOOST_REQUIRE(cache.size() == 0);
     }
 }
+
+FIXTURE_TEST(test_session_eviction_protects_small_sessions, fixture) {
+    // room for one of the large sessions and the small one
+    kafka::fetch_session_cache cache(120s, 256_KiB);
+    auto create_session = [&cache](int partitions) {
+        kafka::fetch_request req;
+        req.session_epoch = kafka::initial_fetch_session_epoch;
+        req.session_id = kafka::invalid_fetch_session_id;
+        req.topics = {make_fetch_request_topic(model::topic("t"), partitions)};
+        auto ctx = cache.maybe_get_session(req);
+        BOOST_REQUIRE(!ctx.is_sessionless());
+        return std::make_pair(ctx.session()->id(), ctx.session()->epoch());
+    };
+    auto error_of = [&cache](auto session) {
+        kafka::fetch_request req;
+        req.session_id = session.first;
+        req.session_epoch = session.second;
+        return cache.maybe_get_session(req).error();
+    };
+
+    auto small = create_session(2);
+    auto large = create_session(2000);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2);
+
+    // the large session makes room by evicting the other large one, the
+    // small one used just now is smaller than the new session
+    auto other_large = create_session(2000);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2);
+    BOOST_REQUIRE_EQUAL(error_of(small), kafka::error_code::none);
+    BOOST_REQUIRE_EQUAL(
+      error_of(large), kafka::error_code::fetch_session_id_not_found);
+    BOOST_REQUIRE_EQUAL(error_of(other_large), kafka::error_code::none);
+}
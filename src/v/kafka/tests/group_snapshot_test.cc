@@ -0,0 +1,93 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/group_snapshot.h"
+#include "random/generators.h"
+#include "seastarx.h"
+#include "storage/snapshot.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+static storage::snapshot_manager make_manager() {
+    return storage::snapshot_manager(
+      std::filesystem::path(fmt::format(
+        "group_snapshot_test_{}", random_generators::gen_alphanum_string(6))),
+      ss::default_priority_class());
+}
+
+SEASTAR_THREAD_TEST_CASE(missing_group_snapshot_loads_nothing) {
+    ss::abort_source as;
+    auto mgr = make_manager();
+    kafka::recovery_batch_consumer ctx(&as);
+    BOOST_REQUIRE(!kafka::load_group_snapshot(mgr, ctx).get0());
+    BOOST_REQUIRE(ctx.loaded_groups.empty());
+}
+
+SEASTAR_THREAD_TEST_CASE(group_snapshot_roundtrip) {
+    ss::abort_source as;
+    auto mgr = make_manager();
+
+    kafka::recovery_batch_consumer ctx(&as);
+    ctx.last_offset = model::offset(41);
+    ctx.loaded_groups[kafka::group_id("g0")] = kafka::group_log_group_metadata{
+      .protocol_type = kafka::protocol_type("consumer"),
+      .generation = kafka::generation_id(3),
+      .protocol = kafka::protocol_name("range"),
+      .leader = kafka::member_id("m0"),
+      .state_timestamp = 10,
+    };
+    ctx.removed_groups.emplace(kafka::group_id("g1"));
+    kafka::group_log_offset_key key{
+      .group = kafka::group_id("g0"),
+      .topic = model::topic("t"),
+      .partition = model::partition_id(2),
+    };
+    ctx.loaded_offsets[key] = std::make_pair(
+      model::offset(40),
+      kafka::group_log_offset_metadata{
+        .offset = model::offset(1000),
+        .leader_epoch = 1,
+        .metadata = "md",
+      });
+    kafka::write_group_snapshot(mgr, ctx).get();
+
+    kafka::recovery_batch_consumer loaded(&as);
+    auto last = kafka::load_group_snapshot(mgr, loaded).get0();
+    BOOST_REQUIRE(last);
+    BOOST_REQUIRE_EQUAL(*last, model::offset(41));
+    BOOST_REQUIRE_EQUAL(loaded.last_offset, model::offset(41));
+
+    BOOST_REQUIRE_EQUAL(loaded.loaded_groups.size(), 1);
+    auto& g = loaded.loaded_groups[kafka::group_id("g0")];
+    BOOST_REQUIRE_EQUAL(g.generation, kafka::generation_id(3));
+    BOOST_REQUIRE_EQUAL(*g.leader, kafka::member_id("m0"));
+    BOOST_REQUIRE(loaded.removed_groups.contains(kafka::group_id("g1")));
+
+    BOOST_REQUIRE_EQUAL(loaded.loaded_offsets.size(), 1);
+    auto& o = loaded.loaded_offsets[key];
+    BOOST_REQUIRE_EQUAL(o.first, model::offset(40));
+    BOOST_REQUIRE_EQUAL(o.second.offset, model::offset(1000));
+    BOOST_REQUIRE_EQUAL(*o.second.metadata, "md");
+}
+
+SEASTAR_THREAD_TEST_CASE(newer_group_snapshot_replaces_older) {
+    ss::abort_source as;
+    auto mgr = make_manager();
+    for (auto o : {10, 20}) {
+        kafka::recovery_batch_consumer ctx(&as);
+        ctx.last_offset = model::offset(o);
+        kafka::write_group_snapshot(mgr, ctx).get();
+    }
+    kafka::recovery_batch_consumer loaded(&as);
+    BOOST_REQUIRE_EQUAL(
+      *kafka::load_group_snapshot(mgr, loaded).get0(), model::offset(20));
+}
@@ -446,6 +446,98 @@ SEASTAR_THREAD_TEST_CASE(generate_member_id) {
     BOOST_TEST(is_uuid(uuid));
 }
 
+static join_group_request static_join_request() {
+    join_group_request r;
+    r.client_id = ss::sstring("c");
+    r.data.member_id = unknown_member_id;
+    r.data.group_instance_id = kafka::group_instance_id("i");
+    r.data.protocol_type = kafka::protocol_type("p");
+    r.data.session_timeout_ms = std::chrono::seconds(1);
+    r.data.rebalance_timeout_ms = std::chrono::milliseconds(2);
+    for (auto& p : test_group_protos) {
+        r.data.protocols.push_back(
+          join_group_request_protocol{.name = p.name, .metadata = p.metadata});
+    }
+    return r;
+}
+
+static group get_stable_static_group() {
+    auto g = get();
+    auto m = get_group_member("m");
+    m->set_assignment(bytes("a"));
+    g.add_member_no_join(m);
+    g.set_state(group_state::preparing_rebalance);
+    g.advance_generation();
+    g.set_state(group_state::stable);
+    return g;
+}
+
+SEASTAR_THREAD_TEST_CASE(static_member_rejoin_stable_group) {
+    auto g = get_stable_static_group();
+
+    auto resp = g.handle_join_group(static_join_request(), false).get0();
+    BOOST_TEST(resp.data.error_code == error_code::none);
+    BOOST_TEST(resp.data.generation_id == 1);
+    auto [id, uuid] = split_member_id(resp.data.member_id);
+    BOOST_TEST(id == "i");
+    BOOST_TEST(is_uuid(uuid));
+
+    // no rebalance, the new member id takes over assignment and leadership
+    BOOST_TEST(g.in_state(group_state::stable));
+    BOOST_TEST(!g.contains_member(kafka::member_id("m")));
+    auto m = g.get_member(resp.data.member_id);
+    BOOST_TEST(m->assignment() == bytes("a"));
+    BOOST_TEST(g.is_leader(resp.data.member_id));
+    BOOST_TEST(resp.data.members.size() == 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(static_member_rejoin_changed_protocols) {
+    auto g = get_stable_static_group();
+
+    auto r = static_join_request();
+    r.data.protocols.pop_back();
+    auto resp = g.handle_join_group(std::move(r), false).get0();
+
+    // the only member rejoined so the join phase completes right away
+    BOOST_TEST(resp.data.error_code == error_code::none);
+    BOOST_TEST(resp.data.generation_id == 2);
+    BOOST_TEST(g.in_state(group_state::completing_rebalance));
+}
+
+SEASTAR_THREAD_TEST_CASE(static_member_fencing) {
+    auto g = get_stable_static_group();
+    BOOST_TEST(!g.is_fenced_instance(
+      kafka::group_instance_id("i"), kafka::member_id("m")));
+    BOOST_TEST(!g.is_fenced_instance(std::nullopt, kafka::member_id("m")));
+
+    auto resp = g.handle_join_group(static_join_request(), false).get0();
+    BOOST_TEST(g.is_fenced_instance(
+      kafka::group_instance_id("i"), kafka::member_id("m")));
+    BOOST_TEST(!g.is_fenced_instance(
+      kafka::group_instance_id("i"), resp.data.member_id));
+
+    heartbeat_request hb;
+    hb.data.member_id = kafka::member_id("m");
+    hb.data.group_instance_id = kafka::group_instance_id("i");
+    hb.data.generation_id = g.generation();
+    BOOST_TEST(
+      g.handle_heartbeat(std::move(hb)).get0().data.error_code
+      == error_code::fenced_instance_id);
+
+    heartbeat_request hb2;
+    hb2.data.member_id = resp.data.member_id;
+    hb2.data.group_instance_id = kafka::group_instance_id("i");
+    hb2.data.generation_id = g.generation();
+    BOOST_TEST(
+      g.handle_heartbeat(std::move(hb2)).get0().data.error_code
+      == error_code::none);
+
+    // expiring the static member releases its instance id
+    g.remove_member(g.get_member(resp.data.member_id));
+    BOOST_TEST(!g.is_fenced_instance(
+      kafka::group_instance_id("i"), kafka::member_id("m")));
+}
+
 SEASTAR_THREAD_TEST_CASE(group_output) {
     auto g = get();
     auto s = fmt::format("{}", g);
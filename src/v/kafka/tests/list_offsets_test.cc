@@ -132,3 +132,59 @@ FIXTURE_TEST(list_offsets_latest, redpanda_thread_fixture) {
       resp.data.topics[0].partitions[0].timestamp == model::timestamp(-1));
     BOOST_CHECK(resp.data.topics[0].partitions[0].offset > model::offset(0));
 }
+
+FIXTURE_TEST(list_offsets_keeps_request_order, redpanda_thread_fixture) {
+    wait_for_controller_leadership().get0();
+    auto ntp = make_data(storage::ntp_config::ntp_id(2));
+    auto shard = app.shard_table.local().shard_for(ntp);
+    tests::cooperative_spin_wait_with_timeout(10s, [this, shard, ntp = ntp] {
+        return app.partition_manager.invoke_on(
+          *shard, [ntp](cluster::partition_manager& mgr) {
+              auto partition = mgr.get(ntp);
+              return partition
+                     && partition->committed_offset() >= model::offset(1);
+          });
+    }).get();
+
+    auto client = make_kafka_client().get0();
+    client.connect().get();
+
+    // lookups answered on the shard, by the timequery and without a shard
+    kafka::list_offsets_request req;
+    req.data.topics = {{
+      .name = ntp.tp.topic,
+      .partitions = {
+        {.partition_index = model::partition_id(1000),
+         .timestamp = kafka::list_offsets_request::latest_timestamp},
+        {.partition_index = ntp.tp.partition,
+         .timestamp = model::timestamp::now()},
+        {.partition_index = model::partition_id(1001),
+         .timestamp = kafka::list_offsets_request::earliest_timestamp},
+      },
+    }};
+    req.data.topics.push_back(req.data.topics[0]);
+    req.data.topics[1].partitions[1].timestamp
+      = kafka::list_offsets_request::latest_timestamp;
+    req.data.topics[1].name = model::topic("unknown");
+
+    auto resp = client.dispatch(req, kafka::api_version(1)).get0();
+    client.stop().then([&client] { client.shutdown(); }).get();
+
+    BOOST_REQUIRE_EQUAL(resp.data.topics.size(), 2);
+    for (const auto& topic : resp.data.topics) {
+        BOOST_REQUIRE_EQUAL(topic.partitions.size(), 3);
+        BOOST_CHECK(
+          topic.partitions[0].error_code
+          == kafka::error_code::unknown_topic_or_partition);
+        BOOST_CHECK(
+          topic.partitions[2].error_code
+          == kafka::error_code::unknown_topic_or_partition);
+    }
+    const auto& found = resp.data.topics[0].partitions[1];
+    BOOST_CHECK_EQUAL(found.partition_index, ntp.tp.partition);
+    BOOST_CHECK(found.error_code == kafka::error_code::none);
+    BOOST_CHECK(found.offset >= model::offset(0));
+    BOOST_CHECK(
+      resp.data.topics[1].partitions[1].error_code
+      == kafka::error_code::unknown_topic_or_partition);
+}
@@ -0,0 +1,128 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/offset_commit_batcher.h"
+#include "model/record_batch_reader.h"
+#include "model/timeout_clock.h"
+#include "raft/errc.h"
+
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std::chrono_literals; // NOLINT
+
+namespace {
+
+struct fake_partition {
+    ss::future<result<raft::replicate_result>>
+    replicate(model::record_batch_reader&& r) {
+        return model::consume_reader_to_memory(std::move(r), model::no_timeout)
+          .then([this](model::record_batch_reader::data_t batches) {
+              ++rounds;
+              for (auto& b : batches) {
+                  last_offset += model::offset(b.record_count());
+              }
+              if (fail) {
+                  return result<raft::replicate_result>(
+                    raft::errc::not_leader);
+              }
+              return result<raft::replicate_result>(
+                raft::replicate_result{.last_offset = last_offset});
+          });
+    }
+
+    kafka::offset_commit_batcher make_batcher(
+      std::chrono::milliseconds window,
+      size_t max_bytes
+      = kafka::offset_commit_batcher::default_max_batch_bytes) {
+        return kafka::offset_commit_batcher(
+          [this](model::record_batch_reader&& r) {
+              return replicate(std::move(r));
+          },
+          window,
+          max_bytes);
+    }
+
+    size_t rounds{0};
+    model::offset last_offset{-1};
+    bool fail{false};
+};
+
+std::vector<kafka::offset_commit_batcher::record> make_records(size_t n) {
+    std::vector<kafka::offset_commit_batcher::record> ret;
+    for (size_t i = 0; i < n; ++i) {
+        iobuf k;
+        k.append("k", 1);
+        iobuf v;
+        v.append("v", 1);
+        ret.push_back({.key = std::move(k), .value = std::move(v)});
+    }
+    return ret;
+}
+
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(merges_commits_within_window) {
+    fake_partition p;
+    auto b = p.make_batcher(10ms);
+    auto f1 = b.replicate(make_records(2));
+    auto f2 = b.replicate(make_records(3));
+    auto f3 = b.replicate(make_records(1));
+    BOOST_REQUIRE_EQUAL(b.pending_records(), 6);
+
+    auto r1 = f1.get0();
+    auto r2 = f2.get0();
+    auto r3 = f3.get0();
+    BOOST_REQUIRE_EQUAL(p.rounds, 1);
+    BOOST_REQUIRE(r1 && r2 && r3);
+    // each caller sees the offset of its last record
+    BOOST_REQUIRE_EQUAL(r1.value().last_offset, model::offset(1));
+    BOOST_REQUIRE_EQUAL(r2.value().last_offset, model::offset(4));
+    BOOST_REQUIRE_EQUAL(r3.value().last_offset, model::offset(5));
+    BOOST_REQUIRE_EQUAL(b.pending_records(), 0);
+    b.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(flushes_full_batch_early) {
+    fake_partition p;
+    // two bytes per record
+    auto b = p.make_batcher(1h, 4);
+    auto f1 = b.replicate(make_records(1));
+    auto f2 = b.replicate(make_records(1));
+    auto r1 = f1.get0();
+    auto r2 = f2.get0();
+    BOOST_REQUIRE_EQUAL(p.rounds, 1);
+    BOOST_REQUIRE_EQUAL(r1.value().last_offset, model::offset(0));
+    BOOST_REQUIRE_EQUAL(r2.value().last_offset, model::offset(1));
+    b.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(propagates_errors_to_every_caller) {
+    fake_partition p;
+    p.fail = true;
+    auto b = p.make_batcher(0ms);
+    auto f1 = b.replicate(make_records(1));
+    auto f2 = b.replicate(make_records(1));
+    BOOST_REQUIRE(!f1.get0());
+    BOOST_REQUIRE(!f2.get0());
+    BOOST_REQUIRE_EQUAL(p.rounds, 1);
+    b.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(stop_flushes_pending_commits) {
+    fake_partition p;
+    auto b = p.make_batcher(1h);
+    auto f = b.replicate(make_records(1));
+    b.stop().get();
+    BOOST_REQUIRE(f.get0());
+    BOOST_REQUIRE_EQUAL(p.rounds, 1);
+    BOOST_REQUIRE(!b.replicate(make_records(1)).get0());
+}
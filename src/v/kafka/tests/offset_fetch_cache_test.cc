@@ -0,0 +1,115 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/offset_fetch_cache.h"
+
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std::chrono_literals; // NOLINT
+
+namespace {
+
+kafka::offset_fetch_response
+make_fetch(model::topic topic, std::vector<int64_t> offsets) {
+    kafka::offset_fetch_response resp(kafka::error_code::none);
+    kafka::offset_fetch_response_topic t{.name = std::move(topic)};
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        t.partitions.push_back(kafka::offset_fetch_response_partition{
+          .partition_index = model::partition_id(i),
+          .committed_offset = model::offset(offsets[i]),
+          .metadata = "",
+          .error_code = kafka::error_code::none,
+        });
+    }
+    resp.data.topics.push_back(std::move(t));
+    return resp;
+}
+
+model::offset committed(
+  const kafka::offset_fetch_response& resp, model::partition_id id) {
+    for (const auto& t : resp.data.topics) {
+        for (const auto& p : t.partitions) {
+            if (p.partition_index == id) {
+                return p.committed_offset;
+            }
+        }
+    }
+    return model::offset(-1);
+}
+
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(offset_fetch_cache_miss_until_fetched) {
+    kafka::offset_fetch_cache cache;
+    kafka::group_id group("g");
+
+    BOOST_REQUIRE(!cache.get(group, 10s));
+    cache.put(group, make_fetch(model::topic("t"), {5, 7}));
+
+    auto resp = cache.get(group, 10s);
+    BOOST_REQUIRE(resp);
+    BOOST_REQUIRE_EQUAL(
+      committed(*resp, model::partition_id(0)), model::offset(5));
+    BOOST_REQUIRE_EQUAL(
+      committed(*resp, model::partition_id(1)), model::offset(7));
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1);
+    BOOST_REQUIRE_EQUAL(cache.misses(), 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(offset_fetch_cache_expires_entries) {
+    kafka::offset_fetch_cache cache;
+    kafka::group_id group("g");
+    cache.put(group, make_fetch(model::topic("t"), {5}));
+
+    // lowres clock ticks every 10ms
+    ss::sleep(50ms).get();
+    BOOST_REQUIRE(!cache.get(group, 10ms));
+    BOOST_REQUIRE(cache.get(group, 10s));
+}
+
+SEASTAR_THREAD_TEST_CASE(offset_fetch_cache_applies_acknowledged_commits) {
+    kafka::offset_fetch_cache cache;
+    kafka::group_id group("g");
+    cache.put(group, make_fetch(model::topic("t"), {5, 7}));
+
+    kafka::offset_commit_request_topic topic{.name = model::topic("t")};
+    topic.partitions.push_back(kafka::offset_commit_request_partition{
+      .partition_index = model::partition_id(0),
+      .committed_offset = model::offset(10)});
+    topic.partitions.push_back(kafka::offset_commit_request_partition{
+      .partition_index = model::partition_id(1),
+      .committed_offset = model::offset(20)});
+    std::vector<kafka::offset_commit_request_topic> topics{topic};
+
+    kafka::offset_commit_response resp;
+    kafka::offset_commit_response_topic result{.name = model::topic("t")};
+    result.partitions.push_back(
+      {.partition_index = model::partition_id(0),
+       .error_code = kafka::error_code::none});
+    result.partitions.push_back(
+      {.partition_index = model::partition_id(1),
+       .error_code = kafka::error_code::not_coordinator});
+    resp.data.topics.push_back(std::move(result));
+
+    cache.apply(group, topics, resp);
+    auto fetched = cache.get(group, 10s);
+    BOOST_REQUIRE(fetched);
+    BOOST_REQUIRE_EQUAL(
+      committed(*fetched, model::partition_id(0)), model::offset(10));
+    // a rejected commit leaves the offset the coordinator had
+    BOOST_REQUIRE_EQUAL(
+      committed(*fetched, model::partition_id(1)), model::offset(7));
+
+    // commits of groups that are not cached are not tracked
+    cache.apply(kafka::group_id("other"), topics, resp);
+    BOOST_REQUIRE(!cache.contains(kafka::group_id("other")));
+}
@@ -0,0 +1,424 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/client.h"
+#include "kafka/errors.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/produce_request.h"
+#include "model/compression.h"
+#include "random/generators.h"
+#include "redpanda/tests/fixture.h"
+#include "storage/parser_utils.h"
+#include "storage/record_batch_builder.h"
+#include "utils/hdr_hist.h"
+#include "vlog.h"
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/future-util.hh>
+#include <seastar/core/thread.hh>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/range/irange.hpp>
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * End to end produce/fetch benchmark against an in-process single node
+ * cluster. Produce requests are sent by --concurrency clients in parallel,
+ * each with one batch for one of the partitions of the topic, then every
+ * partition is fetched back from the beginning. Throughput and latency
+ * percentiles of both phases are written as a json object, to stdout or to
+ * --output.
+ */
+
+using namespace std::chrono_literals; // NOLINT
+
+static ss::logger lgr{"produce_consume_bench"};
+
+static void cli_opts(boost::program_options::options_description_easy_init o) {
+    namespace po = boost::program_options;
+    o("partitions",
+      po::value<int>()->default_value(4),
+      "number of partitions of the benchmark topic");
+    o("batches",
+      po::value<size_t>()->default_value(10000),
+      "total number of batches produced");
+    o("records-per-batch",
+      po::value<size_t>()->default_value(100),
+      "number of records of every batch");
+    o("record-size",
+      po::value<size_t>()->default_value(1024),
+      "size of the value of every record");
+    o("acks",
+      po::value<int16_t>()->default_value(-1),
+      "acks of the produce requests, -1 or 1");
+    o("compression",
+      po::value<std::string>()->default_value("none"),
+      "compression of the batches: none, gzip, snappy, lz4 or zstd");
+    o("concurrency",
+      po::value<size_t>()->default_value(8),
+      "number of clients producing and fetching in parallel");
+    o("output",
+      po::value<std::string>()->default_value(""),
+      "file to write the results to, stdout if empty");
+}
+
+struct bench_cfg {
+    int partitions;
+    size_t batches;
+    size_t records_per_batch;
+    size_t record_size;
+    int16_t acks;
+    model::compression compression;
+    size_t concurrency;
+    std::string output;
+
+    size_t batch_bytes() const { return records_per_batch * record_size; }
+};
+
+struct phase_result {
+    phase_result() = default;
+
+    size_t requests{0};
+    size_t records{0};
+    size_t bytes{0};
+    size_t errors{0};
+    std::chrono::steady_clock::duration elapsed{0};
+    hdr_hist latency_us;
+
+    ss::sstring to_json() const {
+        const double secs
+          = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+              .count();
+        return fmt::format(
+          "{{\"requests\":{},\"records\":{},\"bytes\":{},\"errors\":{},"
+          "\"duration_ms\":{},\"records_per_sec\":{:.1f},"
+          "\"mb_per_sec\":{:.2f},\"latency_us\":{{\"p50\":{},\"p90\":{},"
+          "\"p99\":{},\"p999\":{},\"max\":{}}}}}",
+          requests,
+          records,
+          bytes,
+          errors,
+          std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+            .count(),
+          secs > 0 ? double(records) / secs : 0,
+          secs > 0 ? double(bytes) / secs / (1 << 20) : 0,
+          latency_us.get_value_at(50),
+          latency_us.get_value_at(90),
+          latency_us.get_value_at(99),
+          latency_us.get_value_at(99.9),
+          latency_us.get_value_at(100));
+    }
+};
+
+class produce_consume_bench : public redpanda_thread_fixture {
+public:
+    explicit produce_consume_bench(bench_cfg cfg)
+      : _cfg(std::move(cfg)) {}
+
+    void setup() {
+        wait_for_controller_leadership().get();
+        add_topic(_tp_ns, _cfg.partitions).get();
+        for (auto p : boost::irange(0, _cfg.partitions)) {
+            wait_for_leader(make_ntp(model::partition_id(p)));
+        }
+        for (size_t i = 0; i < _cfg.concurrency; ++i) {
+            auto c = std::make_unique<kafka::client>(
+              make_kafka_client().get0());
+            c->connect().get();
+            _clients.push_back(std::move(c));
+        }
+    }
+
+    void teardown() {
+        for (auto& c : _clients) {
+            c->stop().get();
+        }
+    }
+
+    phase_result produce() {
+        phase_result res;
+        auto start = std::chrono::steady_clock::now();
+        ss::parallel_for_each(
+          boost::irange<size_t>(0, _clients.size()),
+          [this, &res](size_t i) {
+              return ss::do_for_each(
+                boost::irange<size_t>(
+                  std::min(i, _cfg.batches), _cfg.batches, _clients.size()),
+                [this, &res, &client = *_clients[i]](size_t n) {
+                    return produce_one(
+                      client, model::partition_id(n % _cfg.partitions), res);
+                });
+          })
+          .get();
+        res.elapsed = std::chrono::steady_clock::now() - start;
+        return res;
+    }
+
+    phase_result fetch() {
+        phase_result res;
+        auto start = std::chrono::steady_clock::now();
+        ss::parallel_for_each(
+          boost::irange<size_t>(0, _clients.size()),
+          [this, &res](size_t i) {
+              return ss::do_for_each(
+                boost::irange<int>(
+                  std::min<int>(i, _cfg.partitions),
+                  _cfg.partitions,
+                  int(_clients.size())),
+                [this, &res, &client = *_clients[i]](int p) {
+                    return fetch_partition(
+                      client, model::partition_id(p), res);
+                });
+          })
+          .get();
+        res.elapsed = std::chrono::steady_clock::now() - start;
+        return res;
+    }
+
+    ss::sstring config_json() const {
+        return fmt::format(
+          "{{\"partitions\":{},\"batches\":{},\"records_per_batch\":{},"
+          "\"record_size\":{},\"acks\":{},\"compression\":\"{}\","
+          "\"concurrency\":{},\"cores\":{}}}",
+          _cfg.partitions,
+          _cfg.batches,
+          _cfg.records_per_batch,
+          _cfg.record_size,
+          _cfg.acks,
+          _cfg.compression,
+          _cfg.concurrency,
+          ss::smp::count);
+    }
+
+private:
+    model::ntp make_ntp(model::partition_id p) const {
+        return model::ntp(_tp_ns.ns, _tp_ns.tp, p);
+    }
+
+    void wait_for_leader(model::ntp ntp) {
+        tests::cooperative_spin_wait_with_timeout(10s, [this, ntp] {
+            auto shard = app.shard_table.local().shard_for(ntp);
+            if (!shard) {
+                return ss::make_ready_future<bool>(false);
+            }
+            return app.partition_manager.invoke_on(
+              *shard, [ntp](cluster::partition_manager& pm) {
+                  auto p = pm.get(ntp);
+                  return p && p->is_leader();
+              });
+        }).get();
+    }
+
+    ss::future<model::record_batch> make_batch() {
+        storage::record_batch_builder builder(
+          model::well_known_record_batch_types[1], model::offset(0));
+        for (size_t i = 0; i < _cfg.records_per_batch; ++i) {
+            iobuf v;
+            v.append(_value.data(), _value.size());
+            builder.add_raw_kv(iobuf{}, std::move(v));
+        }
+        auto batch = std::move(builder).build();
+        if (_cfg.compression == model::compression::none) {
+            return ss::make_ready_future<model::record_batch>(
+              std::move(batch));
+        }
+        return storage::internal::compress_batch(
+          _cfg.compression, std::move(batch));
+    }
+
+    ss::future<> produce_one(
+      kafka::client& client, model::partition_id p, phase_result& res) {
+        return make_batch().then([this, &client, p, &res](
+                                   model::record_batch batch) {
+            kafka::produce_request::partition partition;
+            partition.id = p;
+            partition.adapter.batch = std::move(batch);
+            kafka::produce_request::topic tp;
+            tp.name = _tp_ns.tp;
+            tp.partitions.push_back(std::move(partition));
+            std::vector<kafka::produce_request::topic> topics;
+            topics.push_back(std::move(tp));
+            kafka::produce_request req(
+              std::nullopt, _cfg.acks, std::move(topics));
+            req.timeout = 10s;
+            auto sent = std::chrono::steady_clock::now();
+            return client.dispatch(std::move(req))
+              .then([this, &res, sent](kafka::produce_response r) {
+                  res.latency_us.record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - sent)
+                      .count());
+                  ++res.requests;
+                  for (auto& t : r.topics) {
+                      for (auto& p : t.partitions) {
+                          if (p.error != kafka::error_code::none) {
+                              ++res.errors;
+                              continue;
+                          }
+                          res.records += _cfg.records_per_batch;
+                          res.bytes += _cfg.batch_bytes();
+                      }
+                  }
+              });
+        });
+    }
+
+    /// walks the batches of a record set and returns the offset following
+    /// the last one, counts the records on the way
+    static model::offset next_offset(iobuf record_set, size_t& records) {
+        iobuf_parser parser(std::move(record_set));
+        model::offset next{0};
+        while (parser.bytes_left() > 0) {
+            auto base_offset = parser.consume_be_type<int64_t>();
+            auto length = parser.consume_be_type<int32_t>();
+            // partition leader epoch, magic, crc and attributes
+            parser.skip(sizeof(int32_t) + 1 + sizeof(int32_t) + 2);
+            auto last_offset_delta = parser.consume_be_type<int32_t>();
+            parser.skip(length - (sizeof(int32_t) * 3 + 1 + 2));
+            records += last_offset_delta + 1;
+            next = model::offset(base_offset + last_offset_delta + 1);
+        }
+        return next;
+    }
+
+    ss::future<> fetch_partition(
+      kafka::client& client, model::partition_id p, phase_result& res) {
+        return ss::do_with(
+          model::offset(0),
+          model::offset(-1),
+          [this, &client, p, &res](
+            model::offset& fetch_offset, model::offset& high_watermark) {
+              return ss::do_until(
+                [&] { return fetch_offset >= high_watermark; },
+                [&, this, p] {
+                    kafka::fetch_request::partition partition;
+                    partition.id = p;
+                    partition.fetch_offset = fetch_offset;
+                    partition.log_start_offset = model::offset(0);
+                    partition.partition_max_bytes = 1_MiB;
+                    kafka::fetch_request::topic topic;
+                    topic.name = _tp_ns.tp;
+                    topic.partitions.push_back(partition);
+                    kafka::fetch_request req;
+                    req.min_bytes = 1;
+                    req.max_bytes = 10_MiB;
+                    req.max_wait_time = 100ms;
+                    req.topics.push_back(std::move(topic));
+
+                    auto sent = std::chrono::steady_clock::now();
+                    return client
+                      .dispatch(std::move(req), kafka::api_version(4))
+                      .then([&, sent](kafka::fetch_response r) {
+                          res.latency_us.record(
+                            std::chrono::duration_cast<
+                              std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - sent)
+                              .count());
+                          ++res.requests;
+                          on_fetch_response(
+                            std::move(r), fetch_offset, high_watermark, res);
+                      });
+                });
+          });
+    }
+
+    void on_fetch_response(
+      kafka::fetch_response r,
+      model::offset& fetch_offset,
+      model::offset& high_watermark,
+      phase_result& res) {
+        if (r.partitions.empty() || r.partitions[0].responses.empty()) {
+            ++res.errors;
+            high_watermark = fetch_offset;
+            return;
+        }
+        auto& pr = r.partitions[0].responses[0];
+        if (pr.has_error()) {
+            ++res.errors;
+            high_watermark = fetch_offset;
+            return;
+        }
+        high_watermark = pr.high_watermark;
+        if (!pr.record_set || pr.record_set->empty()) {
+            return;
+        }
+        size_t records = 0;
+        res.bytes += pr.record_set->size_bytes();
+        fetch_offset = next_offset(std::move(*pr.record_set), records);
+        res.records += records;
+    }
+
+    bench_cfg _cfg;
+    model::topic_namespace _tp_ns{
+      model::ns("kafka"), model::topic("produce-consume-bench")};
+    ss::sstring _value = random_generators::gen_alphanum_string(
+      _cfg.record_size);
+    std::vector<std::unique_ptr<kafka::client>> _clients;
+};
+
+static bench_cfg cfg_from_args(const boost::program_options::variables_map& m) {
+    bench_cfg cfg{
+      .partitions = m["partitions"].as<int>(),
+      .batches = m["batches"].as<size_t>(),
+      .records_per_batch = m["records-per-batch"].as<size_t>(),
+      .record_size = m["record-size"].as<size_t>(),
+      .acks = m["acks"].as<int16_t>(),
+      .compression = boost::lexical_cast<model::compression>(
+        m["compression"].as<std::string>()),
+      .concurrency = m["concurrency"].as<size_t>(),
+      .output = m["output"].as<std::string>(),
+    };
+    // acks=0 produce requests are not answered, a client waiting for the
+    // response would never complete
+    if (cfg.acks != -1 && cfg.acks != 1) {
+        throw std::invalid_argument(
+          fmt::format("unsupported acks {}, expected -1 or 1", cfg.acks));
+    }
+    if (cfg.partitions <= 0 || cfg.concurrency == 0) {
+        throw std::invalid_argument(
+          "partitions and concurrency must be positive");
+    }
+    return cfg;
+}
+
+int main(int args, char** argv, char** env) {
+    ss::app_template app;
+    cli_opts(app.add_options());
+    return app.run(args, argv, [&app] {
+        return ss::async([&app] {
+            auto cfg = cfg_from_args(app.configuration());
+            auto output = cfg.output;
+            produce_consume_bench bench(std::move(cfg));
+            bench.setup();
+            vlog(lgr.info, "Producing: {}", bench.config_json());
+            auto produced = bench.produce();
+            vlog(lgr.info, "Fetching");
+            auto fetched = bench.fetch();
+            bench.teardown();
+
+            auto json = fmt::format(
+              "{{\"config\":{},\"produce\":{},\"fetch\":{}}}\n",
+              bench.config_json(),
+              produced.to_json(),
+              fetched.to_json());
+            if (output.empty()) {
+                std::cout << json;
+            } else {
+                std::ofstream(output) << json;
+            }
+            return produced.errors + fetched.errors > 0 ? 1 : 0;
+        });
+    });
+}
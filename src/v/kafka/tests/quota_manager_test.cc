@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+#include "config/configuration.h"
+#include "kafka/quota_manager.h"
+#include "units.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include <chrono>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(test_quota_manager_produce_throttle) {
+    kafka::quota_manager mgr;
+    const auto rate = config::shard_local_cfg().target_quota_byte_rate();
+    const auto now = kafka::quota_manager::clock::now();
+    auto q = mgr.get_client_quota("client", now);
+
+    // a window worth of bytes passes without delay
+    auto delay = mgr.record_produce_tp_and_throttle(*q, rate, now);
+    BOOST_REQUIRE_EQUAL(delay.duration.count(), 0);
+
+    // half a second in debt
+    delay = mgr.record_produce_tp_and_throttle(*q, rate / 2, now);
+    BOOST_REQUIRE(delay.first_violation);
+    BOOST_REQUIRE_EQUAL(
+      std::chrono::duration_cast<std::chrono::milliseconds>(delay.duration)
+        .count(),
+      500);
+
+    // the debt is paid off over time
+    delay = mgr.record_produce_tp_and_throttle(*q, 0, now + 250ms);
+    BOOST_REQUIRE(!delay.first_violation);
+    BOOST_REQUIRE_EQUAL(
+      std::chrono::duration_cast<std::chrono::milliseconds>(delay.duration)
+        .count(),
+      250);
+    delay = mgr.record_produce_tp_and_throttle(*q, 0, now + 1s);
+    BOOST_REQUIRE_EQUAL(delay.duration.count(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_quota_manager_clients_are_separate) {
+    kafka::quota_manager mgr;
+    const auto rate = config::shard_local_cfg().target_quota_byte_rate();
+    const auto now = kafka::quota_manager::clock::now();
+    auto a = mgr.get_client_quota("a", now);
+    auto b = mgr.get_client_quota("b", now);
+    BOOST_REQUIRE_EQUAL(mgr.get_client_quota("a", now).get(), a.get());
+    BOOST_REQUIRE_EQUAL(
+      mgr.get_client_quota(std::nullopt, now)->client_id, ss::sstring(""));
+
+    auto delay = mgr.record_produce_tp_and_throttle(*a, rate * 2, now);
+    BOOST_REQUIRE_GT(delay.duration.count(), 0);
+    delay = mgr.record_produce_tp_and_throttle(*b, rate, now);
+    BOOST_REQUIRE_EQUAL(delay.duration.count(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_quota_manager_no_fetch_quota) {
+    kafka::quota_manager mgr;
+    const auto now = kafka::quota_manager::clock::now();
+    auto q = mgr.get_client_quota("client", now);
+    BOOST_REQUIRE(!mgr.has_fetch_quota());
+
+    // fetches are not throttled without a fetch quota
+    mgr.record_fetch_tp(*q, 1_GiB, now);
+    auto delay = mgr.fetch_throttle(*q, now);
+    BOOST_REQUIRE_EQUAL(delay.duration.count(), 0);
+}
@@ -80,7 +80,11 @@ get_request_context(application& app, ss::input_stream<char>&& input) {
                               app.shard_table.local(),
                               app.partition_manager,
                               app.coordinator_ntp_mapper,
-                              app.fetch_session_cache);
+                              app.fetch_session_cache,
+                              app.metadata_response_cache,
+                              app.down_conversion_cache,
+                              app.controller->get_credential_store(),
+                              nullptr);
                         });
                 });
           });
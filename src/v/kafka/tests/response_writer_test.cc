@@ -0,0 +1,112 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE kafka
+#include "bytes/iobuf.h"
+#include "kafka/requests/request_reader.h"
+#include "kafka/requests/response.h"
+#include "kafka/requests/response_writer.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <iterator>
+#include <vector>
+
+using namespace kafka; // NOLINT
+
+static iobuf make_record_set(size_t size) {
+    iobuf b;
+    b.append(ss::temporary_buffer<char>(size));
+    return b;
+}
+
+// mixes copied and shared writes, as a fetch response does
+static void encode(response_writer& w, std::vector<std::optional<iobuf>>& rs) {
+    w.write(int32_t(0));
+    w.write(std::string_view("topic"));
+    w.write_array(rs, [](std::optional<iobuf>& r, response_writer& w) {
+        w.write(int64_t(42));
+        w.write(std::move(r));
+    });
+    w.write_bytes_wrapped([](response_writer& w) {
+        w.write_varint(1000);
+        return true;
+    });
+}
+
+BOOST_AUTO_TEST_CASE(size_only_writer_counts_the_encoding) {
+    std::vector<std::optional<iobuf>> rs;
+    rs.emplace_back(make_record_set(4096));
+    rs.emplace_back(std::nullopt);
+    rs.emplace_back(make_record_set(100));
+
+    response_writer sizing(response_writer::size_only{});
+    encode(sizing, rs);
+    // the record sets are not consumed by the sizing pass
+    BOOST_REQUIRE_EQUAL(rs[0]->size_bytes(), 4096);
+
+    iobuf out;
+    response_writer writer(out);
+    encode(writer, rs);
+    BOOST_REQUIRE_EQUAL(sizing.copied_bytes() + 4096 + 100, out.size_bytes());
+}
+
+BOOST_AUTO_TEST_CASE(presized_response_copies_into_one_fragment) {
+    auto make = [] {
+        std::vector<std::optional<iobuf>> rs;
+        for (int i = 0; i < 200; ++i) {
+            rs.emplace_back(std::nullopt);
+        }
+        return rs;
+    };
+    auto rs = make();
+    response sizing(response_writer::size_only{});
+    encode(sizing.writer(), rs);
+
+    response resp;
+    resp.reserve(sizing.writer().copied_bytes());
+    rs = make();
+    encode(resp.writer(), rs);
+    BOOST_REQUIRE_EQUAL(
+      resp.buf().size_bytes(), sizing.writer().copied_bytes());
+    BOOST_REQUIRE_EQUAL(
+      std::distance(resp.buf().begin(), resp.buf().end()), 1);
+}
+
+BOOST_AUTO_TEST_CASE(compact_encodings_round_trip) {
+    iobuf out;
+    response_writer w(out);
+    std::vector<int32_t> ints{1, 2, 3};
+    w.write_unsigned_varint(300);
+    w.write_compact(std::string_view("topic"));
+    w.write_compact(std::optional<ss::sstring>());
+    w.write_compact_array(
+      ints, [](int32_t i, response_writer& w) { w.write(i); });
+    std::optional<std::vector<int32_t>> null_ints;
+    w.write_compact_nullable_array(
+      null_ints, [](int32_t i, response_writer& w) { w.write(i); });
+    w.write_tagged_fields();
+    // a single tagged field the reader does not know about
+    w.write_unsigned_varint(1);
+    w.write_unsigned_varint(7);
+    w.write_unsigned_varint(2);
+    w.write(int16_t(0));
+    w.write(int8_t(42));
+
+    request_reader r(std::move(out));
+    BOOST_REQUIRE_EQUAL(r.read_unsigned_varint(), 300);
+    BOOST_REQUIRE_EQUAL(r.read_compact_string(), "topic");
+    BOOST_REQUIRE(!r.read_compact_nullable_string());
+    auto read_int = [](request_reader& r) { return r.read_int32(); };
+    BOOST_REQUIRE(r.read_compact_array(read_int) == ints);
+    BOOST_REQUIRE(!r.read_compact_nullable_array(read_int));
+    r.consume_tagged_fields();
+    r.consume_tagged_fields();
+    BOOST_REQUIRE_EQUAL(r.read_int8(), 42);
+}
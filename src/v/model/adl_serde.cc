@@ -229,24 +229,32 @@ batch_header adl<batch_header>::from(iobuf_parser& in) {
 }
 
 void adl<model::record_batch>::to(iobuf& out, model::record_batch&& batch) {
+    /*
+     * records are sent in the same format they are kept in memory, the
+     * fragments of the batch are shared with the output so the replication
+     * payloads are never copied nor materialized record by record
+     */
     batch_header hdr{
       .bhdr = batch.header(),
-      .is_compressed = static_cast<int8_t>(batch.compressed() ? 1 : 0)};
+      .is_compressed = batch.compressed() ? batch_header::compressed
+                                          : batch_header::packed_records};
     reflection::serialize(out, hdr);
-    if (batch.compressed()) {
-        reflection::serialize(out, std::move(batch).release_data());
-        return;
-    }
-    batch.for_each_record(
-      [&out](model::record r) { reflection::serialize(out, std::move(r)); });
+    auto records = std::move(batch).release_data();
+    reflection::adl<int32_t>{}.to(out, records.size_bytes());
+    out.append_fragments(std::move(records));
 }
 
 model::record_batch adl<model::record_batch>::from(iobuf_parser& in) {
     auto hdr = reflection::adl<batch_header>{}.from(in);
-    if (hdr.is_compressed == 1) {
+    if (hdr.is_compressed == batch_header::compressed) {
         auto io = reflection::adl<iobuf>{}.from(in);
         return model::record_batch(hdr.bhdr, std::move(io));
     }
+    if (hdr.is_compressed == batch_header::packed_records) {
+        auto io = reflection::adl<iobuf>{}.from(in);
+        return model::record_batch(
+          hdr.bhdr, std::move(io), model::record_batch::tag_ctor_ng{});
+    }
     auto recs = std::vector<model::record>{};
     recs.reserve(hdr.bhdr.record_count);
     for (int i = 0; i < hdr.bhdr.record_count; ++i) {
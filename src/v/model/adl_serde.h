@@ -80,6 +80,16 @@ struct adl<model::record_batch_header> {
 };
 
 struct batch_header {
+    /// encoding of the records that follow the header
+    enum records_encoding : int8_t {
+        // records serialized one by one, sent by older nodes
+        encoded_records = 0,
+        // compressed records as a single iobuf
+        compressed = 1,
+        // records in the on disk format as a single iobuf
+        packed_records = 2,
+    };
+
     model::record_batch_header bhdr;
     int8_t is_compressed;
 };
@@ -19,7 +19,11 @@ enum class errc {
     topic_name_len_exceeded,
     topic_name_empty,
     invalid_topic_name,
-    forbidden_topic_name
+    forbidden_topic_name,
+    invalid_batch_crc,
+    invalid_record_framing,
+    invalid_record_count,
+    invalid_offset_delta
 };
 
 struct errc_category final : public std::error_category {
@@ -38,6 +42,14 @@ struct errc_category final : public std::error_category {
                    "failed for";
         case errc::forbidden_topic_name:
             return "Invalid topic name:";
+        case errc::invalid_batch_crc:
+            return "Invalid record batch: crc mismatch";
+        case errc::invalid_record_framing:
+            return "Invalid record batch: record does not fit its size";
+        case errc::invalid_record_count:
+            return "Invalid record batch: records do not match the count";
+        case errc::invalid_offset_delta:
+            return "Invalid record batch: offset deltas out of order";
         default:
             return "model::errc::unknown";
         }
@@ -521,6 +521,12 @@ public:
           _header, _records.share(0, _records.size_bytes()), _compressed);
     }
 
+    /// \brief shares the batch with another shard, see iobuf::foreign_share
+    record_batch foreign_share(ss::deleter owner) const {
+        return record_batch(
+          _header, _records.foreign_share(std::move(owner)), _compressed);
+    }
+
     /**
      * Set the batch max timestamp and recalculate checksums.
      *
@@ -529,15 +535,30 @@ public:
      * rather than at create time by the client.
      */
     void set_max_timestamp(timestamp_type ts_type, timestamp ts) {
+        if (assign_max_timestamp(ts_type, ts)) {
+            _header.header_crc = model::internal_header_only_crc(_header);
+        }
+    }
+
+    /**
+     * Set the batch max timestamp and update the kafka crc from the header
+     * fields alone, the records are not read. header_crc is unset for the
+     * caller to compute once along with the other fields it rewrites, see
+     * model::assign_base_offset(). Returns false if the batch was left as is.
+     */
+    bool assign_max_timestamp(timestamp_type ts_type, timestamp ts) {
         if (
           _header.attrs.timestamp_type() == ts_type
           && _header.max_timestamp == ts) {
-            return;
+            return false;
         }
+        const auto prev = _header;
         _header.attrs.set_timestamp_type(ts_type);
         _header.max_timestamp = ts;
-        _header.crc = model::crc_record_batch(*this);
-        _header.header_crc = model::internal_header_only_crc(_header);
+        _header.crc = model::crc_record_batch_update(
+          _header.crc, prev, _header, _records.size_bytes());
+        _header.header_crc = 0;
+        return true;
     }
 
     /**
@@ -9,10 +9,12 @@
 
 #include "model/record_batch_reader.h"
 
+#include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/smp.hh>
 
 #include <memory>
+#include <optional>
 
 namespace model {
 using data_t = record_batch_reader::data_t;
@@ -56,7 +58,8 @@ record_batch_reader make_foreign_record_batch_reader(record_batch_reader&& r) {
                         auto& d = std::get<data_t>(recs);
                         auto p = std::make_unique<data_t>(std::move(d));
                         return storage_t(foreign_data_t{
-                          .buffer = ss::make_foreign(std::move(p)),
+                          .buffer = record_batch_reader::foreign_buffer(
+                            ss::make_foreign(std::move(p))),
                           .index = 0});
                     }
                     return recs;
@@ -71,6 +74,98 @@ record_batch_reader make_foreign_record_batch_reader(record_batch_reader&& r) {
     return record_batch_reader(std::move(frn));
 }
 
+record_batch_reader make_pipelined_record_batch_reader(
+  record_batch_reader&& r, size_t max_buffered_bytes) {
+    class pipelined_reader final : public record_batch_reader::impl {
+        using impl_ptr
+          = ss::lw_shared_ptr<std::unique_ptr<record_batch_reader::impl>>;
+
+    public:
+        pipelined_reader(
+          std::unique_ptr<record_batch_reader::impl> i, size_t max_bytes)
+          : _ptr(ss::make_lw_shared(std::move(i)))
+          , _max_bytes(max_bytes) {}
+        pipelined_reader(const pipelined_reader&) = delete;
+        pipelined_reader& operator=(const pipelined_reader&) = delete;
+        pipelined_reader(pipelined_reader&&) = delete;
+        pipelined_reader& operator=(pipelined_reader&&) = delete;
+        ~pipelined_reader() override {
+            if (_next) {
+                // the load holds the reader until it completes
+                (void)std::move(*_next).then_wrapped(
+                  [](ss::future<storage_t> f) { f.ignore_ready_future(); });
+            }
+        }
+
+        bool is_end_of_stream() const final {
+            return !_next && (*_ptr)->is_end_of_stream();
+        }
+
+        void print(std::ostream& os) final {
+            fmt::print(os, "pipelined_record_batch_reader. proxy for:");
+            (*_ptr)->print(os);
+        }
+
+        ss::future<storage_t> do_load_slice(timeout_clock::time_point t) final {
+            auto f = ss::make_ready_future<storage_t>();
+            if (_next) {
+                f = std::move(*_next);
+                _next.reset();
+            } else {
+                f = load(t);
+            }
+            return f.then([this, t](storage_t s) {
+                if (
+                  !(*_ptr)->is_end_of_stream()
+                  && size_bytes(s) <= _max_bytes) {
+                    _next = load(t);
+                }
+                return s;
+            });
+        }
+
+        ss::future<> finally() noexcept final {
+            auto f = ss::now();
+            if (_next) {
+                f = std::move(*_next).then_wrapped(
+                  [](ss::future<storage_t> f) { f.ignore_ready_future(); });
+                _next.reset();
+            }
+            return f.then([p = _ptr] { return (*p)->finally(); });
+        }
+
+    private:
+        ss::future<storage_t> load(timeout_clock::time_point t) {
+            return (*_ptr)->do_load_slice(t).finally([p = _ptr] {});
+        }
+
+        static size_t size_bytes(const storage_t& s) {
+            return ss::visit(
+              s,
+              [](const data_t& d) {
+                  size_t bytes = 0;
+                  for (const auto& b : d) {
+                      bytes += b.size_bytes();
+                  }
+                  return bytes;
+              },
+              [](const foreign_data_t& d) {
+                  size_t bytes = 0;
+                  for (size_t i = d.index; i < d.buffer->size(); ++i) {
+                      bytes += (*d.buffer)[i].size_bytes();
+                  }
+                  return bytes;
+              });
+        }
+
+        impl_ptr _ptr;
+        size_t _max_bytes;
+        std::optional<ss::future<storage_t>> _next;
+    };
+    return make_record_batch_reader<pipelined_reader>(
+      std::move(r).release(), max_buffered_bytes);
+}
+
 record_batch_reader make_memory_record_batch_reader(storage_t batches) {
     class reader final : public record_batch_reader::impl {
     public:
@@ -113,7 +208,8 @@ make_foreign_memory_record_batch_reader(record_batch_reader::data_t data) {
     auto batches = std::make_unique<record_batch_reader::data_t>(
       std::move(data));
     return make_memory_record_batch_reader(record_batch_reader::foreign_data_t{
-      .buffer = ss::make_foreign(std::move(batches)),
+      .buffer = record_batch_reader::foreign_buffer(
+        ss::make_foreign(std::move(batches))),
       .index = 0,
     });
 }
@@ -18,6 +18,7 @@
 #include "utils/concepts-enabled.h"
 
 #include <seastar/core/circular_buffer.hh>
+#include <seastar/core/deleter.hh>
 #include <seastar/core/do_with.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/sharded.hh>
@@ -47,8 +48,32 @@ CONCEPT(template<typename ReferenceConsumer> concept bool ReferenceBatchReaderCo
 class record_batch_reader final {
 public:
     using data_t = ss::circular_buffer<model::record_batch>;
+    /**
+     * Batches of another shard handed to this one.
+     *
+     * A batch is taken out of the buffer by sharing its bytes rather than
+     * copying them. Every batch shared holds the buffer, which is freed on
+     * its shard once the last of them and the buffer itself are gone.
+     */
+    class foreign_buffer {
+    public:
+        explicit foreign_buffer(ss::foreign_ptr<std::unique_ptr<data_t>> b)
+          : _batches(b.get())
+          , _owner(ss::make_object_deleter(std::move(b))) {}
+
+        data_t& operator*() const { return *_batches; }
+        data_t* operator->() const { return _batches; }
+
+        record_batch share(size_t i) {
+            return (*_batches)[i].foreign_share(_owner.share());
+        }
+
+    private:
+        data_t* _batches;
+        ss::deleter _owner;
+    };
     struct foreign_data_t {
-        ss::foreign_ptr<std::unique_ptr<data_t>> buffer;
+        foreign_buffer buffer;
         size_t index{0};
     };
     using storage_t = std::variant<data_t, foreign_data_t>;
@@ -109,9 +134,9 @@ public:
                   return batch;
               },
               [](foreign_data_t& d) {
-                  // cannot have a move-only type from a remote core
-                  // we must make a copy. for iteration use for_each_ref
-                  return (*d.buffer)[d.index++].copy();
+                  // cannot have a move-only type from a remote core, the
+                  // bytes are shared instead
+                  return d.buffer.share(d.index++);
               });
         }
         ss::future<> load_slice(timeout_clock::time_point timeout) {
@@ -294,6 +319,17 @@ ss::future<record_batch_reader::data_t> consume_reader_to_memory(
 
 /// \brief wraps a reader into a foreign_ptr<unique_ptr>
 record_batch_reader make_foreign_record_batch_reader(record_batch_reader&&);
+
+/**
+ * Wraps a reader so that the next slice is loaded while the consumer works
+ * on the current one. At most one slice is loaded ahead, and only after a
+ * slice of no more than `max_buffered_bytes`. Meant for the long sequential
+ * scans, such as recovery and compaction, where the reader would otherwise
+ * sit idle between slices.
+ */
+record_batch_reader make_pipelined_record_batch_reader(
+  record_batch_reader&&, size_t max_buffered_bytes);
+
 std::ostream& operator<<(std::ostream& os, const record_batch_reader& r);
 
 } // namespace model
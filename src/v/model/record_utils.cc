@@ -13,6 +13,9 @@
 #include "model/record.h"
 #include "reflection/adl.h"
 #include "utils/vint.h"
+#include "utils/vint_bulk.h"
+
+#include <array>
 
 namespace model {
 
@@ -52,6 +55,36 @@ uint32_t internal_header_only_crc(const record_batch_header& header) {
     return c.value();
 }
 
+void assign_base_offset(record_batch_header& header, model::offset o) {
+    if (header.header_crc == 0) {
+        header.base_offset = o;
+        header.header_crc = internal_header_only_crc(header);
+        return;
+    }
+    if (header.base_offset == o) {
+        return;
+    }
+    // crcs of messages of the same length differ by the crc without pre and
+    // post conditioning of their difference, here the offset bytes followed
+    // by the rest of the header. leading zeros do not change that crc
+    static constexpr size_t trailing = packed_record_batch_header_size
+                                       - sizeof(header.header_crc)
+                                       - sizeof(header.size_bytes)
+                                       - sizeof(header.base_offset);
+    static const uint32_t zeros = crc32c_zeros(trailing);
+    static const uint32_t zero_offset_crc = [] {
+        auto c = crc32();
+        c.extend(uint64_t(0));
+        return c.value();
+    }();
+    auto c = crc32();
+    c.extend(
+      ss::cpu_to_le(static_cast<uint64_t>(header.base_offset()))
+      ^ ss::cpu_to_le(static_cast<uint64_t>(o())));
+    header.header_crc ^= crc32c_shift(zeros, c.value() ^ zero_offset_crc);
+    header.base_offset = o;
+}
+
 template<typename T, typename = std::enable_if_t<std::is_integral_v<T>, T>>
 void crc_extend_cpu_to_be(crc32& crc, T i) {
     auto j = ss::cpu_to_be(i);
@@ -87,6 +120,21 @@ int32_t crc_record_batch(const record_batch& b) {
     return crc_record_batch(b.header(), b.data());
 }
 
+int32_t crc_record_batch_update(
+  int32_t crc,
+  const record_batch_header& prev,
+  const record_batch_header& next,
+  size_t records_size) {
+    // crc(h + r) = crc(h) * x^(8 * |r|) ^ crc(r), so replacing the header
+    // fields of the same size shifts the difference of their crcs over r
+    auto a = crc32();
+    crc_record_batch_header(a, prev);
+    auto b = crc32();
+    crc_record_batch_header(b, next);
+    const auto delta = crc32c_combine(a.value() ^ b.value(), 0, records_size);
+    return static_cast<int32_t>(static_cast<uint32_t>(crc) ^ delta);
+}
+
 template<typename Parser, typename ParserData>
 static std::vector<model::record_header>
 parse_record_headers(Parser& parser, ParserData parser_data) {
@@ -110,18 +158,69 @@ parse_record_headers(Parser& parser, ParserData parser_data) {
     return headers;
 }
 
-template<typename Parser, typename ParserData>
-static model::record do_parse_one_record_from_buffer(
-  Parser& parser,
-  int32_t record_size,
-  model::record_attributes::type attr,
-  ParserData parser_data) {
+std::optional<record_prefix>
+decode_record_prefix(const char* src, size_t len) {
+    static_assert(
+      sizeof(model::record_attributes::type) == 1,
+      "model attributes expected to be one byte");
+    const auto* p = reinterpret_cast<const uint8_t*>(src); // NOLINT
+    int64_t size_bytes = 0;
+    const size_t size_length = vint::deserialize_n(p, len, &size_bytes, 1);
+    // the attributes byte sits between the size and the other varints
+    if (size_length == 0 || size_length == len) {
+        return std::nullopt;
+    }
+    const size_t fields_begin = size_length + 1;
+    std::array<int64_t, 3> fields{};
+    const size_t fields_length = vint::deserialize_n(
+      p + fields_begin, len - fields_begin, fields.data(), fields.size());
+    if (fields_length == 0) {
+        return std::nullopt;
+    }
+    return record_prefix{
+      .size_bytes = size_bytes,
+      .attributes = static_cast<int8_t>(p[size_length]),
+      .timestamp_delta = fields[0],
+      .offset_delta = fields[1],
+      .key_size = fields[2],
+      .size_field_length = size_length,
+      .encoded_size = fields_begin + fields_length};
+}
+
+static record_prefix read_record_prefix(iobuf_parser_base& parser) {
+    // records within a fragment decode their varints in bulk
+    if (auto prefix = decode_record_prefix(
+          parser.segment_data(), parser.segment_bytes_left())) {
+        parser.skip(prefix->encoded_size);
+        return *prefix;
+    }
+    /*
+     * require that record attributes be unaffected by endianness. all of the
+     * other record fields are properly handled by virtue of their types being
+     * either blobs or variable length integers.
+     */
+    auto [record_size, rv] = parser.read_varlong();
+    auto attr = parser.consume_type<model::record_attributes::type>();
     auto [timestamp_delta, tv] = parser.read_varlong();
     auto [offset_delta, ov] = parser.read_varlong();
     auto [key_length, kv] = parser.read_varlong();
+    return record_prefix{
+      .size_bytes = record_size,
+      .attributes = attr,
+      .timestamp_delta = timestamp_delta,
+      .offset_delta = offset_delta,
+      .key_size = key_length,
+      .size_field_length = rv,
+      .encoded_size = size_t(rv) + 1 + tv + ov + kv};
+}
+
+template<typename Parser, typename ParserData>
+static model::record
+do_parse_one_record_from_buffer(Parser& parser, ParserData parser_data) {
+    const auto prefix = read_record_prefix(parser);
     iobuf key;
-    if (key_length > 0) {
-        key = parser_data(parser, key_length);
+    if (prefix.key_size > 0) {
+        key = parser_data(parser, prefix.key_size);
     }
     auto [value_length, vv] = parser.read_varlong();
     iobuf value;
@@ -130,44 +229,27 @@ static model::record do_parse_one_record_from_buffer(
     }
     auto headers = parse_record_headers(parser, parser_data);
     return model::record(
-      record_size,
-      model::record_attributes(attr),
-      static_cast<int64_t>(timestamp_delta),
-      static_cast<int32_t>(offset_delta),
-      key_length,
+      prefix.size_bytes,
+      model::record_attributes(prefix.attributes),
+      prefix.timestamp_delta,
+      static_cast<int32_t>(prefix.offset_delta),
+      prefix.key_size,
       std::move(key),
       value_length,
       std::move(value),
       std::move(headers));
 }
 
-static std::pair<int64_t, model::record_attributes::type>
-parse_record_meta_from_buffer(iobuf_parser_base& parser) {
-    /*
-     * require that record attributes be unaffected by endianness. all of the
-     * other record fields are properly handled by virtue of their types being
-     * either blobs or variable length integers.
-     */
-    static_assert(
-      sizeof(model::record_attributes::type) == 1,
-      "model attributes expected to be one byte");
-    auto [record_size, rv] = parser.read_varlong();
-    auto attr = parser.consume_type<model::record_attributes::type>();
-    return std::make_pair(record_size, attr);
-}
-
 model::record parse_one_record_from_buffer(iobuf_parser& parser) {
-    auto [record_size, attr] = parse_record_meta_from_buffer(parser);
     return do_parse_one_record_from_buffer(
-      parser, record_size, attr, [](iobuf_parser& parser, int64_t len) {
+      parser, [](iobuf_parser& parser, int64_t len) {
           return parser.share(len);
       });
 }
 
 model::record parse_one_record_copy_from_buffer(iobuf_const_parser& parser) {
-    auto [record_size, attr] = parse_record_meta_from_buffer(parser);
     return do_parse_one_record_from_buffer(
-      parser, record_size, attr, [](iobuf_const_parser& parser, int64_t len) {
+      parser, [](iobuf_const_parser& parser, int64_t len) {
           return parser.copy(len);
       });
 }
@@ -14,6 +14,8 @@
 #include "bytes/iobuf_parser.h"
 #include "hashing/crc32c.h"
 
+#include <optional>
+
 namespace model {
 
 struct record_batch_header;
@@ -25,11 +27,40 @@ void crc_record_batch_header(crc32&, const record_batch_header&);
 /// \brief int32_t because that's what kafka uses
 int32_t crc_record_batch(const record_batch& b);
 int32_t crc_record_batch(const record_batch_header&, const iobuf&);
+/// \brief kafka crc of a batch whose header fields changed from `prev` to
+/// `next`, from its crc and the size of its records without reading them
+int32_t crc_record_batch_update(
+  int32_t crc,
+  const record_batch_header& prev,
+  const record_batch_header& next,
+  size_t records_size);
 
 /// \brief uint32_t because that's what crc32c uses
 /// it is *only* record_batch_header.header_crc;
 uint32_t internal_header_only_crc(const record_batch_header&);
 
+/// \brief sets the base offset of the header along with its header_crc. A
+/// header_crc of the header is patched for the offset in constant time, an
+/// unset header_crc (0) is computed
+void assign_base_offset(record_batch_header&, model::offset);
+
+/// \brief fields of an encoded record before its key
+struct record_prefix {
+    int64_t size_bytes;
+    int8_t attributes;
+    int64_t timestamp_delta;
+    int64_t offset_delta;
+    int64_t key_size;
+    // bytes of the size_bytes field, the record ends size_bytes after it
+    size_t size_field_length;
+    // bytes of all the fields
+    size_t encoded_size;
+};
+
+/// \brief decodes the prefix of a record from contiguous bytes with the bulk
+/// varint decoder, nullopt when the bytes end before the key size
+std::optional<record_prefix> decode_record_prefix(const char* src, size_t len);
+
 model::record parse_one_record_from_buffer(iobuf_parser& parser);
 model::record parse_one_record_copy_from_buffer(iobuf_const_parser& parser);
 void append_record_to_buffer(iobuf& a, const model::record& r);
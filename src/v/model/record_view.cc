@@ -0,0 +1,169 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/record_view.h"
+
+#include "model/record_utils.h"
+#include "utils/vint.h"
+#include "vassert.h"
+
+#include <fmt/format.h>
+
+#include <stdexcept>
+
+namespace model {
+
+static int64_t read_varlong(iobuf::iterator_consumer& in) {
+    auto [val, length_size] = vint::deserialize(in);
+    in.skip(length_size);
+    return val;
+}
+
+// skips the bytes of a key or value, negative lengths are null fields
+static void skip_field(iobuf::iterator_consumer& in, int64_t len) {
+    if (len > 0) {
+        in.skip(len);
+    }
+}
+
+static iobuf copy_field(iobuf::iterator_consumer in, int32_t len) {
+    if (len <= 0) {
+        return iobuf();
+    }
+    return iobuf_copy(in, len);
+}
+
+iobuf record_view::copy_key() const { return copy_field(_key, _key_size); }
+
+bytes record_view::copy_key_bytes() const {
+    if (_key_size <= 0) {
+        return bytes();
+    }
+    bytes ret(bytes::initialized_later{}, _key_size);
+    auto in = _key;
+    in.consume_to(ret.size(), ret.begin());
+    return ret;
+}
+
+iobuf record_view::copy_value() const {
+    return copy_field(_value, _val_size);
+}
+
+std::vector<record_header> record_view::copy_headers() const {
+    std::vector<record_header> headers;
+    headers.reserve(_headers_count);
+    auto in = _headers;
+    read_varlong(in);
+    for (int32_t i = 0; i < _headers_count; ++i) {
+        const auto key_length = static_cast<int32_t>(read_varlong(in));
+        auto key = copy_field(in, key_length);
+        skip_field(in, key_length);
+        const auto value_length = static_cast<int32_t>(read_varlong(in));
+        auto value = copy_field(in, value_length);
+        skip_field(in, value_length);
+        headers.emplace_back(
+          key_length, std::move(key), value_length, std::move(value));
+    }
+    return headers;
+}
+
+iobuf record_view::copy_encoded() const {
+    auto in = _begin;
+    return iobuf_copy(in, _encoded_size);
+}
+
+record record_view::copy_record() const {
+    return record(
+      _size_bytes,
+      _attributes,
+      _timestamp_delta,
+      _offset_delta,
+      _key_size,
+      copy_key(),
+      _val_size,
+      copy_value(),
+      copy_headers());
+}
+
+record_view_reader::record_view_reader(const record_batch& batch)
+  : _in(batch.data().cbegin(), batch.data().cend())
+  , _size_bytes(batch.data().size_bytes())
+  , _remaining(batch.record_count()) {
+    vassert(
+      !batch.compressed(),
+      "Record iteration is not supported for compressed batches.");
+}
+
+// the fixed fields of the record, decoded in bulk when they are contiguous
+static record_prefix read_record_prefix(iobuf::iterator_consumer& in) {
+    if (auto prefix = decode_record_prefix(
+          in.segment_data(), in.segment_bytes_left())) {
+        in.skip(prefix->encoded_size);
+        return *prefix;
+    }
+    const size_t begin = in.bytes_consumed();
+    record_prefix prefix{};
+    prefix.size_bytes = read_varlong(in);
+    prefix.size_field_length = in.bytes_consumed() - begin;
+    prefix.attributes = in.consume_type<record_attributes::type>();
+    prefix.timestamp_delta = read_varlong(in);
+    prefix.offset_delta = read_varlong(in);
+    prefix.key_size = read_varlong(in);
+    prefix.encoded_size = in.bytes_consumed() - begin;
+    return prefix;
+}
+
+record_view record_view_reader::next() {
+    record_view r(_in);
+    const size_t begin = _in.bytes_consumed();
+    const auto prefix = read_record_prefix(_in);
+    const auto record_size = prefix.size_bytes;
+    const size_t end = begin + prefix.size_field_length + record_size;
+    if (unlikely(record_size <= 0 || end > _size_bytes)) {
+        throw std::out_of_range(fmt::format(
+          "Record of {} bytes at position {} does not fit the {} bytes of "
+          "the batch",
+          record_size,
+          begin,
+          _size_bytes));
+    }
+    r._size_bytes = static_cast<int32_t>(record_size);
+    r._encoded_size = end - begin;
+    r._attributes = record_attributes(prefix.attributes);
+    r._timestamp_delta = prefix.timestamp_delta;
+    r._offset_delta = static_cast<int32_t>(prefix.offset_delta);
+    r._key_size = static_cast<int32_t>(prefix.key_size);
+    r._key = _in;
+    skip_field(_in, r._key_size);
+    r._val_size = static_cast<int32_t>(read_varlong(_in));
+    r._value = _in;
+    skip_field(_in, r._val_size);
+    r._headers = _in;
+    r._headers_count = static_cast<int32_t>(read_varlong(_in));
+    // the headers are only decoded when they are copied
+    if (unlikely(_in.bytes_consumed() > end)) {
+        throw std::out_of_range(fmt::format(
+          "Record at position {} is larger than its size of {} bytes",
+          begin,
+          record_size));
+    }
+    _in.skip(end - _in.bytes_consumed());
+    --_remaining;
+    return r;
+}
+
+void record_view_reader::ensure_consumed() const {
+    const size_t left = _size_bytes - _in.bytes_consumed();
+    if (unlikely(left)) {
+        throw std::out_of_range(fmt::format(
+          "Record iteration stopped with {} bytes remaining", left));
+    }
+}
+
+} // namespace model
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "model/record.h"
+#include "seastarx.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/loop.hh>
+
+#include <cstdint>
+#include <vector>
+
+namespace model {
+
+/**
+ * Record decoded in place from the data of an uncompressed record batch.
+ *
+ * Only the fixed fields and the position of the key, value and headers are
+ * decoded, nothing is allocated until one of the copy_*() accessors is used.
+ * A view refers to the data of the batch and must not outlive it.
+ */
+class record_view {
+public:
+    // Size in bytes of everything except the size_bytes field.
+    int32_t size_bytes() const { return _size_bytes; }
+    // Size in bytes of the encoded record, size_bytes field included.
+    size_t encoded_size_bytes() const { return _encoded_size; }
+    // Position of the encoded record in the data of the batch.
+    size_t position() const { return _begin.bytes_consumed(); }
+
+    record_attributes attributes() const { return _attributes; }
+    int64_t timestamp_delta() const { return _timestamp_delta; }
+    int32_t offset_delta() const { return _offset_delta; }
+
+    int32_t key_size() const { return _key_size; }
+    iobuf copy_key() const;
+    bytes copy_key_bytes() const;
+
+    int32_t value_size() const { return _val_size; }
+    iobuf copy_value() const;
+
+    int32_t headers_count() const { return _headers_count; }
+    std::vector<record_header> copy_headers() const;
+
+    /// \brief the encoded record, e.g. to append it to another batch
+    iobuf copy_encoded() const;
+    /// \brief materializes the whole record
+    record copy_record() const;
+
+private:
+    using consumer = iobuf::iterator_consumer;
+
+    explicit record_view(consumer begin) noexcept
+      : _begin(begin)
+      , _key(begin)
+      , _value(begin)
+      , _headers(begin) {}
+
+    friend class record_view_reader;
+
+    consumer _begin;
+    consumer _key;
+    consumer _value;
+    consumer _headers;
+    size_t _encoded_size{0};
+    int32_t _size_bytes{0};
+    record_attributes _attributes;
+    int64_t _timestamp_delta{0};
+    int32_t _offset_delta{0};
+    int32_t _key_size{0};
+    int32_t _val_size{0};
+    int32_t _headers_count{0};
+};
+
+/**
+ * Decodes the records of an uncompressed batch as views, one at a time. The
+ * batch must outlive the reader and the views it returns.
+ */
+class record_view_reader {
+public:
+    explicit record_view_reader(const record_batch&);
+
+    bool done() const { return _remaining == 0; }
+    /// \brief throws std::out_of_range when the record is malformed
+    record_view next();
+    /// \brief throws std::out_of_range when bytes follow the last record
+    void ensure_consumed() const;
+
+private:
+    iobuf::iterator_consumer _in;
+    size_t _size_bytes;
+    int32_t _remaining;
+};
+
+/**
+ * Iterate over records without materializing them.
+ *
+ * Use `model::async_for_each_record_view(..)` for futurized version.
+ */
+template<typename Func>
+inline void for_each_record_view(const record_batch& batch, Func f) {
+    record_view_reader reader(batch);
+    while (!reader.done()) {
+        f(reader.next());
+    }
+    reader.ensure_consumed();
+}
+
+template<typename Func>
+inline ss::future<>
+async_for_each_record_view(const record_batch& batch, Func f) {
+    return ss::do_with(
+      record_view_reader(batch),
+      [f = std::move(f)](record_view_reader& reader) mutable {
+          return ss::do_until(
+                   [&reader] { return reader.done(); },
+                   [&reader, &f] { return f(reader.next()); })
+            .then([&reader] { reader.ensure_consumed(); });
+      });
+}
+
+} // namespace model
@@ -174,3 +174,73 @@ SEASTAR_THREAD_TEST_CASE(record_batch_sharing) {
         BOOST_CHECK(v1[i] == v2[i]);
     }
 }
+
+SEASTAR_THREAD_TEST_CASE(foreign_batches_are_shared) {
+    auto batches = make_batches(offset(1), offset(2), offset(3));
+    std::vector<const char*> bytes;
+    ss::circular_buffer<record_batch> expected;
+    for (auto& b : batches) {
+        bytes.push_back(b.data().begin()->get());
+        expected.push_back(b.copy());
+    }
+    ss::circular_buffer<record_batch> consumed;
+    {
+        auto reader = make_foreign_memory_record_batch_reader(
+          std::move(batches));
+        consumed = reader.consume(consumer(3), no_timeout).get0();
+    }
+    // the reader is gone, its batches are held by the ones consumed
+    BOOST_REQUIRE_EQUAL(consumed.size(), expected.size());
+    for (size_t i = 0; i < consumed.size(); ++i) {
+        BOOST_CHECK(consumed[i] == expected[i]);
+        BOOST_CHECK(consumed[i].data().begin()->get() == bytes[i]);
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_pipelined_consume) {
+    do_test_consume(make_pipelined_record_batch_reader(
+      make_generating_reader(
+        make_batches(offset(1), offset(2), offset(3), offset(4))),
+      1024 * 1024));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_pipelined_interrupt_consume) {
+    do_test_interrupt_consume(make_pipelined_record_batch_reader(
+      make_generating_reader(
+        make_batches(offset(1), offset(2), offset(3), offset(4), offset(5))),
+      1024 * 1024));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_pipelined_loads_next_slice_ahead) {
+    size_t loads = 0;
+    auto batches = make_batches(offset(1), offset(2), offset(3));
+    auto reader = make_pipelined_record_batch_reader(
+      make_generating_record_batch_reader(
+        [&loads, batches = std::move(batches)]() mutable {
+            ++loads;
+            if (batches.empty()) {
+                return ss::make_ready_future<record_batch_opt>();
+            }
+            auto batch = std::move(batches.front());
+            batches.pop_front();
+            return ss::make_ready_future<record_batch_opt>(std::move(batch));
+        }),
+      1024 * 1024);
+
+    struct load_consumer {
+        size_t* loads;
+        std::vector<size_t> seen;
+
+        ss::future<ss::stop_iteration> operator()(record_batch&) {
+            seen.push_back(*loads);
+            return ss::make_ready_future<ss::stop_iteration>(
+              ss::stop_iteration::no);
+        }
+        std::vector<size_t> end_of_stream() { return std::move(seen); }
+    };
+    auto seen = std::move(reader)
+                  .for_each_ref(load_consumer{.loads = &loads}, no_timeout)
+                  .get0();
+    // each batch is consumed once the slice after it is loading
+    BOOST_REQUIRE(seen == (std::vector<size_t>{2, 3, 4}));
+}
@@ -7,9 +7,13 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "model/adl_serde.h"
+#include "model/errc.h"
 #include "model/record.h"
 #include "model/record_utils.h"
+#include "model/record_view.h"
 #include "model/timestamp.h"
+#include "model/validation.h"
 #include "storage/tests/utils/random_batch.h"
 
 #include <seastar/testing/thread_test_case.hh>
@@ -18,6 +22,8 @@
 #include <boost/test/data/test_case.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+
 namespace bdata = boost::unit_test::data;
 
 std::array<model::compression, 5> compressions{
@@ -78,3 +84,165 @@ SEASTAR_THREAD_TEST_CASE(set_max_timestamp) {
     BOOST_TEST(crc == batch.header().crc);
     BOOST_TEST(hdr_crc == batch.header().header_crc);
 }
+
+SEASTAR_THREAD_TEST_CASE(set_max_timestamp_updates_crc_incrementally) {
+    for (bool compressed : {false, true}) {
+        auto batch = storage::test::make_random_batch(
+          model::offset(0), 10, compressed);
+        batch.set_max_timestamp(
+          model::timestamp_type::append_time,
+          model::timestamp(batch.header().max_timestamp() + 1000));
+        BOOST_REQUIRE_EQUAL(
+          batch.header().crc, model::crc_record_batch(batch));
+        BOOST_REQUIRE_EQUAL(
+          batch.header().header_crc,
+          model::internal_header_only_crc(batch.header()));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(assign_base_offset_patches_header_crc) {
+    auto batch = storage::test::make_random_batch(model::offset(0), 10, true);
+    auto& hdr = batch.header();
+    for (auto o : {1, 10, 255, 256, 1 << 20, 3, 0}) {
+        model::assign_base_offset(hdr, model::offset(o));
+        BOOST_REQUIRE_EQUAL(hdr.base_offset, model::offset(o));
+        BOOST_REQUIRE_EQUAL(
+          hdr.header_crc, model::internal_header_only_crc(hdr));
+    }
+    model::assign_base_offset(hdr, model::offset(1LL << 40));
+    BOOST_REQUIRE_EQUAL(hdr.header_crc, model::internal_header_only_crc(hdr));
+
+    // an unset crc is computed
+    hdr.header_crc = 0;
+    model::assign_base_offset(hdr, model::offset(7));
+    BOOST_REQUIRE_EQUAL(hdr.header_crc, model::internal_header_only_crc(hdr));
+}
+
+SEASTAR_THREAD_TEST_CASE(serialize_shares_records) {
+    for (bool compressed : {false, true}) {
+        auto batch = storage::test::make_random_batch(
+          model::offset(0), 10, compressed);
+        auto expected = batch.share();
+        std::vector<const char*> records;
+        for (auto& f : batch.data()) {
+            records.push_back(f.get());
+        }
+
+        auto out = reflection::to_iobuf(std::move(batch));
+        // every fragment of the records is sent by reference
+        for (auto ptr : records) {
+            BOOST_REQUIRE(std::any_of(
+              out.begin(), out.end(), [ptr](const iobuf::fragment& f) {
+                  return f.get() == ptr;
+              }));
+        }
+
+        iobuf_parser parser(std::move(out));
+        auto result = reflection::adl<model::record_batch>{}.from(parser);
+        BOOST_REQUIRE_EQUAL(result, expected);
+        BOOST_REQUIRE_EQUAL(result.compressed(), expected.compressed());
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(record_views_decode_records) {
+    auto batch = storage::test::make_random_batch(model::offset(0), 10, false);
+    auto records = batch.copy_records();
+    size_t i = 0;
+    iobuf encoded;
+    model::for_each_record_view(batch, [&](const model::record_view& v) {
+        BOOST_REQUIRE_LT(i, records.size());
+        const auto& r = records[i++];
+        BOOST_REQUIRE_EQUAL(v.size_bytes(), r.size_bytes());
+        BOOST_REQUIRE_EQUAL(v.offset_delta(), r.offset_delta());
+        BOOST_REQUIRE_EQUAL(v.timestamp_delta(), r.timestamp_delta());
+        BOOST_REQUIRE_EQUAL(v.key_size(), r.key_size());
+        BOOST_REQUIRE_EQUAL(v.copy_key(), r.key());
+        BOOST_REQUIRE_EQUAL(v.value_size(), r.value_size());
+        BOOST_REQUIRE_EQUAL(v.copy_value(), r.value());
+        BOOST_REQUIRE_EQUAL(
+          static_cast<size_t>(v.headers_count()), r.headers().size());
+        BOOST_REQUIRE(v.copy_record() == r);
+        BOOST_REQUIRE_EQUAL(v.position(), encoded.size_bytes());
+        encoded.append(v.copy_encoded());
+    });
+    BOOST_REQUIRE_EQUAL(i, records.size());
+    // the views cover the data of the batch
+    BOOST_REQUIRE_EQUAL(encoded, batch.data());
+}
+
+SEASTAR_THREAD_TEST_CASE(record_views_detect_truncated_batches) {
+    auto batch = storage::test::make_random_batch(model::offset(0), 10, false);
+    auto data = batch.data().copy();
+    data.trim_back(1);
+    auto truncated = model::record_batch(
+      batch.header(), std::move(data), model::record_batch::tag_ctor_ng{});
+    BOOST_REQUIRE_THROW(
+      model::for_each_record_view(truncated, [](const model::record_view&) {}),
+      std::out_of_range);
+}
+
+SEASTAR_THREAD_TEST_CASE(validate_record_batch_accepts_valid_batches) {
+    for (bool compressed : {false, true}) {
+        auto batch = storage::test::make_random_batch(
+          model::offset(0), 10, compressed);
+        BOOST_REQUIRE(
+          !model::validate_record_batch(batch.header(), batch.data()));
+    }
+    // records split across fragments are framed the same
+    auto batch = storage::test::make_random_batch(model::offset(0), 10, false);
+    iobuf fragmented;
+    for (auto& f : batch.data()) {
+        for (size_t i = 0; i < f.size(); ++i) {
+            iobuf byte;
+            byte.append(f.get() + i, 1);
+            fragmented.append_fragments(std::move(byte));
+        }
+    }
+    BOOST_REQUIRE(!model::validate_record_batch(batch.header(), fragmented));
+}
+
+SEASTAR_THREAD_TEST_CASE(validate_record_batch_detects_corruption) {
+    auto batch = storage::test::make_random_batch(model::offset(0), 10, false);
+    auto hdr = batch.header();
+    auto validate = [](model::record_batch_header hdr, const iobuf& records) {
+        hdr.crc = model::crc_record_batch(hdr, records);
+        return model::validate_record_batch(hdr, records);
+    };
+
+    auto corrupted = batch.header();
+    corrupted.crc ^= 1;
+    BOOST_REQUIRE_EQUAL(
+      model::validate_record_batch(corrupted, batch.data()),
+      make_error_code(model::errc::invalid_batch_crc));
+
+    // a crc mismatch is reported before the framing
+    auto truncated = batch.data().copy();
+    truncated.trim_back(1);
+    BOOST_REQUIRE_EQUAL(
+      model::validate_record_batch(hdr, truncated),
+      make_error_code(model::errc::invalid_batch_crc));
+    BOOST_REQUIRE_EQUAL(
+      validate(hdr, truncated),
+      make_error_code(model::errc::invalid_record_framing));
+
+    auto more = hdr;
+    more.record_count += 1;
+    BOOST_REQUIRE_EQUAL(
+      validate(more, batch.data()),
+      make_error_code(model::errc::invalid_record_count));
+    auto fewer = hdr;
+    fewer.record_count -= 1;
+    BOOST_REQUIRE_EQUAL(
+      validate(fewer, batch.data()),
+      make_error_code(model::errc::invalid_record_count));
+
+    auto last = hdr;
+    last.last_offset_delta += 1;
+    BOOST_REQUIRE_EQUAL(
+      validate(last, batch.data()),
+      make_error_code(model::errc::invalid_offset_delta));
+    last.last_offset_delta -= 2;
+    BOOST_REQUIRE_EQUAL(
+      validate(last, batch.data()),
+      make_error_code(model::errc::invalid_offset_delta));
+}
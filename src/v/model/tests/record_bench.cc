@@ -0,0 +1,43 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/record.h"
+#include "model/record_view.h"
+#include "storage/tests/utils/random_batch.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+// parsing the records of an uncompressed batch, as produce requests and
+// compaction do
+struct record_parse_bench {
+    record_parse_bench()
+      : batch(
+        storage::test::make_random_batch(model::offset(0), 1000, false)) {}
+
+    model::record_batch batch;
+};
+
+PERF_TEST_F(record_parse_bench, for_each_record) {
+    perf_tests::start_measuring_time();
+    int64_t deltas = 0;
+    batch.for_each_record(
+      [&deltas](model::record r) { deltas += r.offset_delta(); });
+    perf_tests::do_not_optimize(deltas);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(record_parse_bench, for_each_record_view) {
+    perf_tests::start_measuring_time();
+    int64_t deltas = 0;
+    model::for_each_record_view(
+      batch,
+      [&deltas](const model::record_view& r) { deltas += r.offset_delta(); });
+    perf_tests::do_not_optimize(deltas);
+    perf_tests::stop_measuring_time();
+}
@@ -15,6 +15,7 @@
 
 #include <seastar/core/lowres_clock.hh>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <iosfwd>
@@ -78,4 +79,12 @@ inline timestamp new_timestamp() {
 }
 
 inline timestamp timestamp::now() { return new_timestamp(); }
+
+/// \brief wall clock timestamp that does not go back on the shard: when the
+/// clock steps backwards the last timestamp is handed out until it caught up
+inline timestamp new_monotonic_timestamp() {
+    static thread_local timestamp last = timestamp::min();
+    last = std::max(last, new_timestamp());
+    return last;
+}
 } // namespace model
@@ -9,12 +9,19 @@
 
 #include "model/validation.h"
 
+#include "hashing/crc32c.h"
 #include "model/errc.h"
+#include "model/record.h"
+#include "model/record_utils.h"
 #include "seastarx.h"
+#include "utils/vint.h"
+#include "utils/vint_bulk.h"
 #include "vlog.h"
 
 #include <seastar/util/log.hh>
 
+#include <array>
+
 namespace model {
 
 std::error_code validate_kafka_topic_name(const model::topic& tpc) {
@@ -37,4 +44,163 @@ std::error_code validate_kafka_topic_name(const model::topic& tpc) {
     return make_error_code(errc::success);
 }
 
+namespace {
+
+// size, attributes, timestamp delta, offset delta and key size
+constexpr size_t max_record_prefix_length = 4 * vint::max_length + 1;
+
+/**
+ * Walks the records of a batch and extends the crc with every byte it steps
+ * over. The varints are peeked in place when the fragment holds enough bytes
+ * for them, and copied out of the fragments that split them otherwise, so
+ * the bytes are only read once for both the crc and the framing.
+ */
+class record_walker {
+public:
+    record_walker(crc32& crc, const iobuf& records)
+      : _crc(crc)
+      , _in(records.cbegin(), records.cend()) {}
+
+    /// contiguous bytes from the current position, at most `n`
+    std::pair<const char*, size_t> peek(size_t n) {
+        if (_in.segment_bytes_left() >= n) {
+            return {_in.segment_data(), n};
+        }
+        auto in = _in;
+        size_t len = 0;
+        in.consume(n, [this, &len](const char* src, size_t max) {
+            std::copy_n(src, max, _scratch.data() + len);
+            len += max;
+            return ss::stop_iteration::no;
+        });
+        return {_scratch.data(), len};
+    }
+
+    /// peeks one varint, 0 bytes when the records end before it does
+    std::pair<int64_t, size_t> peek_varint() {
+        auto [src, len] = peek(vint::max_length);
+        int64_t v = 0;
+        const auto n = vint::deserialize_n(
+          reinterpret_cast<const uint8_t*>(src), len, &v, 1); // NOLINT
+        return {v, n};
+    }
+
+    /// checksums the next `n` bytes, returns the bytes there were
+    size_t consume(size_t n) {
+        return _in.consume(n, [this](const char* src, size_t max) {
+            _crc.extend(src, max);
+            return ss::stop_iteration::no;
+        });
+    }
+
+    size_t bytes_consumed() const { return _in.bytes_consumed(); }
+
+private:
+    crc32& _crc;
+    iobuf::iterator_consumer _in;
+    std::array<char, max_record_prefix_length> _scratch{};
+};
+
+/// checks the framing of one record, the walker ends past it on success
+errc validate_record(
+  record_walker& w,
+  size_t records_left,
+  int64_t& prev_offset_delta,
+  int32_t last_offset_delta) {
+    auto [src, len] = w.peek(max_record_prefix_length);
+    const auto prefix = decode_record_prefix(src, len);
+    if (!prefix || prefix->size_bytes <= 0) {
+        return errc::invalid_record_framing;
+    }
+    const auto record_size = prefix->size_field_length
+                             + static_cast<size_t>(prefix->size_bytes);
+    if (record_size > records_left || prefix->encoded_size > record_size) {
+        return errc::invalid_record_framing;
+    }
+    if (
+      prefix->offset_delta <= prev_offset_delta
+      || prefix->offset_delta > last_offset_delta) {
+        return errc::invalid_offset_delta;
+    }
+    prev_offset_delta = prefix->offset_delta;
+
+    // bytes of the record after the fields already decoded
+    size_t left = record_size - prefix->encoded_size;
+    w.consume(prefix->encoded_size);
+    if (prefix->key_size > 0) {
+        if (static_cast<size_t>(prefix->key_size) > left) {
+            return errc::invalid_record_framing;
+        }
+        w.consume(prefix->key_size);
+        left -= prefix->key_size;
+    }
+
+    auto [value_size, value_length] = w.peek_varint();
+    if (value_length == 0 || value_length > left) {
+        return errc::invalid_record_framing;
+    }
+    w.consume(value_length);
+    left -= value_length;
+    if (value_size > 0) {
+        if (static_cast<size_t>(value_size) > left) {
+            return errc::invalid_record_framing;
+        }
+        w.consume(value_size);
+        left -= value_size;
+    }
+
+    auto [headers, headers_length] = w.peek_varint();
+    if (headers_length == 0 || headers_length > left || headers < 0) {
+        return errc::invalid_record_framing;
+    }
+    // the headers are checksummed as they are, the count fits the record
+    w.consume(left);
+    return errc::success;
+}
+
+} // namespace
+
+std::error_code
+validate_record_batch(const record_batch_header& hdr, const iobuf& records) {
+    crc32 crc;
+    crc_record_batch_header(crc, hdr);
+    record_walker w(crc, records);
+    const auto size = records.size_bytes();
+
+    auto err = errc::success;
+    if (hdr.attrs.compression() == compression::none) {
+        if (hdr.record_count < 0) {
+            err = errc::invalid_record_count;
+        }
+        int64_t prev_offset_delta = -1;
+        for (int32_t i = 0; err == errc::success && i < hdr.record_count;
+             ++i) {
+            if (w.bytes_consumed() == size) {
+                err = errc::invalid_record_count;
+                break;
+            }
+            err = validate_record(
+              w,
+              size - w.bytes_consumed(),
+              prev_offset_delta,
+              hdr.last_offset_delta);
+        }
+        if (err == errc::success) {
+            if (w.bytes_consumed() != size) {
+                err = errc::invalid_record_count;
+            } else if (
+              hdr.record_count > 0
+              && prev_offset_delta != hdr.last_offset_delta) {
+                err = errc::invalid_offset_delta;
+            }
+        }
+    }
+    // a corrupted batch is reported as such before its framing
+    w.consume(size - w.bytes_consumed());
+    if (static_cast<int32_t>(crc.value()) != hdr.crc) {
+        return make_error_code(errc::invalid_batch_crc);
+    }
+    return make_error_code(err);
+}
+
 } // namespace model
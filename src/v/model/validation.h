@@ -10,6 +10,7 @@
  */
 
 #pragma once
+#include "bytes/iobuf.h"
 #include "model/fundamental.h"
 
 #include <system_error>
@@ -18,4 +19,18 @@ namespace model {
 
 std::error_code validate_kafka_topic_name(const model::topic&);
 
+struct record_batch_header;
+
+/// \brief validates the records of a batch against its header together with
+/// the kafka crc of the batch, in a single pass over the bytes of the records.
+///
+/// Each record is checksummed as its framing is checked: the fields before
+/// the key are decoded with the bulk varint decoder, the key and value
+/// lengths must fit the size of the record, the offset deltas must increase
+/// up to the last offset delta of the header and the records must match the
+/// record count and fill the batch. The records of compressed batches are
+/// only checksummed. A crc mismatch is reported over a framing error.
+std::error_code
+validate_record_batch(const record_batch_header&, const iobuf& records);
+
 } // namespace model
@@ -44,6 +44,14 @@ ss::future<shared_broker_t> brokers::find(model::topic_partition tp) {
     return ss::make_ready_future<shared_broker_t>(*b_it);
 }
 
+std::optional<int32_t>
+brokers::partition_count(const model::topic& t) const {
+    if (auto it = _partition_counts.find(t); it != _partition_counts.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
 ss::future<> brokers::erase(model::node_id node_id) {
     if (auto b_it = _brokers.find(node_id); b_it != _brokers.end()) {
         auto broker = *b_it;
@@ -54,52 +62,86 @@ ss::future<> brokers::erase(model::node_id node_id) {
 }
 
 ss::future<> brokers::apply(kafka::metadata_response&& res) {
-    return ss::do_with(std::move(res), [this](kafka::metadata_response& res) {
-        auto new_brokers_begin = std::partition(
-          res.brokers.begin(),
-          res.brokers.end(),
-          [this](const kafka::metadata_response::broker& broker) {
-              return _brokers.count(broker.node_id);
-          });
-
-        return ssx::parallel_transform(
-                 new_brokers_begin,
-                 res.brokers.end(),
-                 [](const kafka::metadata_response::broker& b) {
-                     return make_broker(
-                       b.node_id, unresolved_address(b.host, b.port));
-                 })
-          .then([this, &res, new_brokers_begin, topics{std::move(res.topics)}](
-                  std::vector<shared_broker_t> broker_endpoints) mutable {
-              brokers_t brokers;
-              brokers.reserve(
-                broker_endpoints.size()
-                + std::distance(res.brokers.begin(), new_brokers_begin));
-              // Insert new brokers
-              for (auto& b : broker_endpoints) {
-                  brokers.emplace(std::move(b));
-              }
-              // Insert existing brokers
-              for (auto it = res.brokers.begin(); it != new_brokers_begin;
-                   ++it) {
-                  auto b = _brokers.find(it->node_id);
-                  if (b != _brokers.end()) {
-                      brokers.emplace(*b);
-                  }
-              }
-
-              leaders_t leaders;
-              for (const auto& t : topics) {
-                  for (auto const& p : t.partitions) {
-                      leaders.emplace(
-                        model::topic_partition(t.name, p.index), p.leader);
-                  }
-              }
-
-              std::swap(brokers, _brokers);
-              std::swap(leaders, _leaders);
-          });
-    });
+    return apply_brokers(std::move(res.brokers))
+      .then([this, topics{std::move(res.topics)}]() {
+          _leaders.clear();
+          _partition_counts.clear();
+          for (const auto& t : topics) {
+              insert_topic(t);
+          }
+      });
+}
+
+ss::future<> brokers::apply_topics(kafka::metadata_response&& res) {
+    return apply_brokers(std::move(res.brokers))
+      .then([this, topics{std::move(res.topics)}]() {
+          for (const auto& t : topics) {
+              erase_topic(t.name);
+              insert_topic(t);
+          }
+      });
+}
+
+ss::future<> brokers::apply_brokers(
+  std::vector<kafka::metadata_response::broker>&& res_brokers) {
+    return ss::do_with(
+      std::move(res_brokers),
+      [this](std::vector<kafka::metadata_response::broker>& res_brokers) {
+          auto new_brokers_begin = std::partition(
+            res_brokers.begin(),
+            res_brokers.end(),
+            [this](const kafka::metadata_response::broker& broker) {
+                return _brokers.count(broker.node_id);
+            });
+
+          return ssx::parallel_transform(
+                   new_brokers_begin,
+                   res_brokers.end(),
+                   [](const kafka::metadata_response::broker& b) {
+                       return make_broker(
+                         b.node_id, unresolved_address(b.host, b.port));
+                   })
+            .then([this, &res_brokers, new_brokers_begin](
+                    std::vector<shared_broker_t> broker_endpoints) mutable {
+                brokers_t brokers;
+                brokers.reserve(
+                  broker_endpoints.size()
+                  + std::distance(res_brokers.begin(), new_brokers_begin));
+                // Insert new brokers
+                for (auto& b : broker_endpoints) {
+                    brokers.emplace(std::move(b));
+                }
+                // Insert existing brokers
+                for (auto it = res_brokers.begin(); it != new_brokers_begin;
+                     ++it) {
+                    auto b = _brokers.find(it->node_id);
+                    if (b != _brokers.end()) {
+                        brokers.emplace(*b);
+                    }
+                }
+                std::swap(brokers, _brokers);
+            });
+      });
+}
+
+void brokers::insert_topic(const kafka::metadata_response::topic& t) {
+    if (!t.partitions.empty()) {
+        _partition_counts.emplace(t.name, t.partitions.size());
+    }
+    for (auto const& p : t.partitions) {
+        _leaders.emplace(model::topic_partition(t.name, p.index), p.leader);
+    }
+}
+
+void brokers::erase_topic(const model::topic& t) {
+    auto it = _partition_counts.find(t);
+    if (it == _partition_counts.end()) {
+        return;
+    }
+    for (int32_t p = 0; p < it->second; ++p) {
+        _leaders.erase(model::topic_partition(t, model::partition_id(p)));
+    }
+    _partition_counts.erase(it);
 }
 
 } // namespace pandaproxy::client
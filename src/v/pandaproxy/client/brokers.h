@@ -20,6 +20,8 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 
+#include <optional>
+
 namespace pandaproxy::client {
 
 /// \brief during connection, the node_id isn't known.
@@ -30,6 +32,7 @@ class brokers {
       = absl::flat_hash_set<shared_broker_t, broker_hash, broker_eq>;
     using leaders_t
       = absl::flat_hash_map<model::topic_partition, model::node_id>;
+    using partition_counts_t = absl::flat_hash_map<model::topic, int32_t>;
 
 public:
     /// \brief stop and wait for all outstanding activity to finish.
@@ -43,19 +46,40 @@ public:
     /// \brief Retrieve the broker for the given topic_partition.
     ss::future<shared_broker_t> find(model::topic_partition tp);
 
+    /// \brief Number of partitions of the topic, as of the last metadata.
+    std::optional<int32_t> partition_count(const model::topic& t) const;
+
     /// \brief Remove a broker.
     ss::future<> erase(model::node_id id);
 
     /// \brief Apply the given metadata response.
+    ///
+    /// The brokers and topics of the response replace all of the known ones.
     ss::future<> apply(kafka::metadata_response&& res);
 
+    /// \brief Apply the metadata response of some topics.
+    ///
+    /// The brokers of the response replace the known ones, the topics of the
+    /// response replace the partitions of those topics, other topics are left
+    /// as they are.
+    ss::future<> apply_topics(kafka::metadata_response&& res);
+
 private:
+    /// \brief Replace the known brokers, connecting to the new ones.
+    ss::future<>
+    apply_brokers(std::vector<kafka::metadata_response::broker>&& brokers);
+
+    void insert_topic(const kafka::metadata_response::topic& t);
+    void erase_topic(const model::topic& t);
+
     /// \brief Brokers map a model::node_id to a kafka::client.
     brokers_t _brokers;
     /// \brief Next broker to select with round-robin
     size_t _next_broker;
     /// \brief Leaders map a partition to a model::node_id.
     leaders_t _leaders;
+    /// \brief Partition counts of the topics.
+    partition_counts_t _partition_counts;
 };
 
 } // namespace pandaproxy::client
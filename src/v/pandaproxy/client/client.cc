@@ -33,6 +33,10 @@ client::client(std::vector<unresolved_address> broker_addrs)
   , _wait_or_start_update_metadata{[this](wait_or_start::tag tag) {
       return update_metadata(tag);
   }}
+  , _pending_topics{}
+  , _wait_or_start_update_topics{[this](wait_or_start::tag tag) {
+      return update_pending_topics(tag);
+  }}
   , _producer{_brokers, [this](std::exception_ptr ex) {
                   return mitigate_error(std::move(ex));
               }} {}
@@ -68,6 +72,13 @@ ss::future<> client::connect() {
 ss::future<> client::stop() {
     return _gate.close()
       .then([this]() { return _producer.stop(); })
+      .then([this]() {
+          return ssx::parallel_transform(
+            std::move(_prefetchers),
+            [](decltype(_prefetchers)::value_type p) {
+                return p.second->stop();
+            });
+      })
       .then([this]() { return _brokers.stop(); });
 }
 
@@ -77,20 +88,52 @@ ss::future<> client::update_metadata(wait_or_start::tag) {
         return broker
           ->dispatch(kafka::metadata_request{.list_all_topics = true})
           .then([this](kafka::metadata_response res) {
-              // Create new seeds from the returned set of brokers
-              std::vector<unresolved_address> seeds;
-              seeds.reserve(res.brokers.size());
-              for (const auto& b : res.brokers) {
-                  seeds.emplace_back(b.host, b.port);
-              }
-              std::swap(_seeds, seeds);
-
+              update_seeds(res.brokers);
               return _brokers.apply(std::move(res));
           })
           .finally([]() { vlog(ppclog.trace, "updated metadata"); });
     });
 }
 
+ss::future<> client::update_topic_metadata(model::topic topic) {
+    _pending_topics.insert(topic);
+    return ss::do_until(
+      [this, topic{std::move(topic)}]() {
+          return !_pending_topics.contains(topic);
+      },
+      [this]() { return _wait_or_start_update_topics(); });
+}
+
+ss::future<> client::update_pending_topics(wait_or_start::tag) {
+    std::vector<model::topic> topics(
+      _pending_topics.begin(), _pending_topics.end());
+    _pending_topics.clear();
+    vlog(ppclog.debug, "updating metadata of {} topics", topics.size());
+    return _brokers.any().then(
+      [this, topics{std::move(topics)}](shared_broker_t broker) mutable {
+          return broker
+            ->dispatch(kafka::metadata_request{
+              .topics{std::move(topics)},
+              .allow_auto_topic_creation = false})
+            .then([this](kafka::metadata_response res) {
+                update_seeds(res.brokers);
+                return _brokers.apply_topics(std::move(res));
+            })
+            .finally([]() { vlog(ppclog.trace, "updated topic metadata"); });
+      });
+}
+
+void client::update_seeds(
+  const std::vector<kafka::metadata_response::broker>& brokers) {
+    // Create new seeds from the returned set of brokers
+    std::vector<unresolved_address> seeds;
+    seeds.reserve(brokers.size());
+    for (const auto& b : brokers) {
+        seeds.emplace_back(b.host, b.port);
+    }
+    std::swap(_seeds, seeds);
+}
+
 ss::future<> client::mitigate_error(std::exception_ptr ex) {
     try {
         std::rethrow_exception(ex);
@@ -110,8 +153,15 @@ ss::future<> client::mitigate_error(std::exception_ptr ex) {
         case kafka::error_code::unknown_topic_or_partition:
         case kafka::error_code::not_leader_for_partition:
         case kafka::error_code::leader_not_available: {
+            // only the topic moved, the rest of the metadata is still good
             vlog(ppclog.debug, "partition_error: {}", ex);
-            return _wait_or_start_update_metadata();
+            return update_topic_metadata(ex.tp.topic);
+        }
+        case kafka::error_code::fetch_session_id_not_found:
+        case kafka::error_code::invalid_fetch_session_epoch: {
+            // the session was reset, the retry is a full fetch
+            vlog(ppclog.debug, "partition_error: {}", ex);
+            return ss::now();
         }
         default:
             // TODO(Ben): Maybe vassert
@@ -141,27 +191,87 @@ ss::future<kafka::fetch_response::partition> client::fetch_partition(
   model::topic_partition tp,
   model::offset offset,
   int32_t max_bytes,
+  std::chrono::milliseconds timeout) {
+    auto prefetcher = get_prefetcher(tp);
+    return prefetcher->fetch(offset, max_bytes, timeout)
+      .handle_exception([tp](std::exception_ptr ex) {
+          return make_fetch_response(tp, ex);
+      })
+      .finally([prefetcher]() {});
+}
+
+client::shared_prefetch_partition
+client::get_prefetcher(const model::topic_partition& tp) {
+    if (auto it = _prefetchers.find(tp); it != _prefetchers.end()) {
+        return it->second;
+    }
+    auto fetch = [this, tp](
+                   fetch_session* session,
+                   model::offset offset,
+                   int32_t max_bytes,
+                   std::chrono::milliseconds timeout) {
+        return do_fetch(tp, session, offset, max_bytes, timeout);
+    };
+    return _prefetchers
+      .emplace(tp, ss::make_lw_shared<prefetch_partition>(tp, fetch))
+      .first->second;
+}
+
+static ss::future<kafka::fetch_response::partition> handle_fetch_response(
+  const model::topic_partition& tp,
+  fetch_session* session,
+  ss::future<kafka::fetch_response> f) {
+    using ret_t = kafka::fetch_response::partition;
+    if (f.failed()) {
+        // the broker may have moved the session on, or not
+        if (session) {
+            session->reset();
+        }
+        return ss::make_exception_future<ret_t>(f.get_exception());
+    }
+    auto res = f.get0();
+    if (session) {
+        session->apply(res);
+    }
+    if (res.error != kafka::error_code::none) {
+        return ss::make_exception_future<ret_t>(partition_error(tp, res.error));
+    }
+    if (res.partitions.empty()) {
+        // an incremental fetch leaves out the partitions that did not change
+        return ss::make_ready_future<ret_t>(
+          make_fetch_response(tp, kafka::error_code::none));
+    }
+    return ss::make_ready_future<ret_t>(std::move(res.partitions[0]));
+}
+
+ss::future<kafka::fetch_response::partition> client::do_fetch(
+  model::topic_partition tp,
+  fetch_session* session,
+  model::offset offset,
+  int32_t max_bytes,
   std::chrono::milliseconds timeout) {
     using namespace std::chrono_literals;
     auto build_request =
-      [offset, max_bytes, timeout](model::topic_partition& tp) {
-          return make_fetch_request(tp, offset, max_bytes, timeout);
+      [session, offset, max_bytes, timeout](model::topic_partition& tp) {
+          return make_fetch_request(tp, offset, max_bytes, timeout, session);
       };
 
     return ss::do_with(
       std::move(build_request),
       std::move(tp),
-      [this](auto& build_request, model::topic_partition& tp) {
+      [this, session](auto& build_request, model::topic_partition& tp) {
           return retry_with_mitigation(
                    shard_local_cfg().retries(),
                    shard_local_cfg().retry_base_backoff(),
-                   [this, &tp, &build_request]() {
+                   [this, &tp, &build_request, session]() {
                        return _brokers.find(tp)
                          .then([&tp, &build_request](shared_broker_t&& b) {
                              return b->dispatch(build_request(tp));
                          })
-                         .then([](kafka::fetch_response res) {
-                             return std::move(res.partitions[0]);
+                         .then_wrapped([&tp, session](
+                                         ss::future<kafka::fetch_response> f) {
+                             return handle_fetch_response(
+                               tp, session, std::move(f));
                          });
                    },
                    [this](std::exception_ptr ex) { return mitigate_error(ex); })
@@ -16,6 +16,7 @@
 #include "pandaproxy/client/brokers.h"
 #include "pandaproxy/client/configuration.h"
 #include "pandaproxy/client/fetcher.h"
+#include "pandaproxy/client/prefetch_partition.h"
 #include "pandaproxy/client/producer.h"
 #include "pandaproxy/client/retry_with_mitigation.h"
 #include "utils/retry.h"
@@ -90,6 +91,18 @@ public:
     ss::future<kafka::produce_response::partition> produce_record_batch(
       model::topic_partition tp, model::record_batch&& batch);
 
+    /// \brief Partition for a record produced without one.
+    ///
+    /// See producer::partition_for.
+    std::optional<model::partition_id>
+    partition_for(const model::topic& topic, const std::optional<iobuf>& key) {
+        return _producer.partition_for(topic, key);
+    }
+
+    /// \brief Fetch a partition from offset.
+    ///
+    /// A partition read in order is served from the records fetched ahead of
+    /// it, see prefetch_partition.
     ss::future<kafka::fetch_response::partition> fetch_partition(
       model::topic_partition tp,
       model::offset offset,
@@ -97,6 +110,19 @@ public:
       std::chrono::milliseconds timeout);
 
 private:
+    using shared_prefetch_partition = ss::lw_shared_ptr<prefetch_partition>;
+
+    /// \brief Fetch a partition from its leader, in the session if one is
+    /// given.
+    ss::future<kafka::fetch_response::partition> do_fetch(
+      model::topic_partition tp,
+      fetch_session* session,
+      model::offset offset,
+      int32_t max_bytes,
+      std::chrono::milliseconds timeout);
+
+    shared_prefetch_partition get_prefetcher(const model::topic_partition& tp);
+
     /// \brief Connect and update metdata.
     ss::future<> do_connect(unresolved_address addr);
 
@@ -108,6 +134,19 @@ private:
     /// Uses round-robin load-balancing strategy.
     ss::future<> update_metadata(wait_or_start::tag);
 
+    /// \brief Update the metadata of a topic
+    ///
+    /// The topics that need an update while one is in progress are updated
+    /// together by the next one, the future returned is satisfied once an
+    /// update that includes the topic has finished.
+    ss::future<> update_topic_metadata(model::topic topic);
+
+    /// \brief Update the metadata of the pending topics
+    ss::future<> update_pending_topics(wait_or_start::tag);
+
+    /// \brief Seeds are the brokers of the last metadata.
+    void update_seeds(const std::vector<kafka::metadata_response::broker>&);
+
     /// \brief Handle errors by performing an action that may fix the cause of
     /// the error
     ss::future<> mitigate_error(std::exception_ptr ex);
@@ -118,8 +157,15 @@ private:
     brokers _brokers;
     /// \brief Update metadata, or wait for an existing one.
     wait_or_start _wait_or_start_update_metadata;
+    /// \brief Topics waiting for a metadata update.
+    absl::flat_hash_set<model::topic> _pending_topics;
+    /// \brief Update the pending topics, or wait for an existing update.
+    wait_or_start _wait_or_start_update_topics;
     /// \brief Batching producer.
     producer _producer;
+    /// \brief Records fetched ahead, per partition.
+    absl::flat_hash_map<model::topic_partition, shared_prefetch_partition>
+      _prefetchers;
     /// \brief Wait for retries.
     ss::gate _gate;
 };
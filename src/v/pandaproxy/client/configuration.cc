@@ -55,9 +55,17 @@ configuration::configuration()
   , produce_batch_delay(
       *this,
       "produce_batch_delay_ms",
-      "Delay (in milliseconds) to wait before sending batch",
+      "Delay (in milliseconds) a batch waits for more records after its "
+      "first record before it is sent",
       config::required::no,
-      100ms) {}
+      100ms)
+  , fetch_prefetch_bytes(
+      *this,
+      "fetch_prefetch_bytes",
+      "Number of bytes of a partition fetched ahead of its consumer, 0 "
+      "disables prefetching",
+      config::required::no,
+      1048576) {}
 
 void configuration::read_yaml(const YAML::Node& root_node) {
     if (!root_node["pandaproxy_client"]) {
@@ -22,7 +22,8 @@ kafka::fetch_request make_fetch_request(
   const model::topic_partition& tp,
   model::offset offset,
   int32_t max_bytes,
-  std::chrono::milliseconds timeout) {
+  std::chrono::milliseconds timeout,
+  const fetch_session* session) {
     std::vector<kafka::fetch_request::partition> partitions;
     partitions.push_back(kafka::fetch_request::partition{
       .id{tp.partition},
@@ -40,8 +41,10 @@ kafka::fetch_request make_fetch_request(
       .min_bytes = 0,
       .max_bytes = max_bytes,
       .isolation_level = 0,
-      .session_id = 0,
-      .session_epoch = 0,
+      .session_id = session ? session->id()()
+                            : kafka::invalid_fetch_session_id(),
+      .session_epoch = session ? session->epoch()()
+                               : kafka::final_fetch_session_epoch(),
       .topics{std::move(topics)}};
 }
 
@@ -66,6 +69,11 @@ make_fetch_response(const model::topic_partition& tp, std::exception_ptr ex) {
         vlog(ppclog.error, "std::exception_ptr");
         error = kafka::error_code::unknown_server_error;
     }
+    return make_fetch_response(tp, error);
+}
+
+kafka::fetch_response::partition
+make_fetch_response(const model::topic_partition& tp, kafka::error_code error) {
     kafka::fetch_response::partition_response pr{
       .id{tp.partition},
       .error = error,
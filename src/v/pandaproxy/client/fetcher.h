@@ -11,17 +11,57 @@
 
 #pragma once
 
+#include "kafka/fetch_session.h"
 #include "kafka/requests/fetch_request.h"
+#include "kafka/types.h"
 
 namespace pandaproxy::client {
 
+/// \brief Fetch session of a partition read in order.
+///
+/// The first request creates the session on the broker, the ones after it
+/// are incremental, the broker keeps the state of the partition between them
+/// instead of building it for every request. Any failure starts over with a
+/// full request, which closes the previous session of the broker.
+class fetch_session {
+public:
+    kafka::fetch_session_id id() const { return _id; }
+    kafka::fetch_session_epoch epoch() const { return _epoch; }
+
+    /// \brief Move to the epoch after a request was answered.
+    void apply(const kafka::fetch_response& res) {
+        if (res.error != kafka::error_code::none) {
+            reset();
+            return;
+        }
+        _id = kafka::fetch_session_id(res.session_id);
+        _epoch = _id == kafka::invalid_fetch_session_id
+                   ? kafka::initial_fetch_session_epoch
+                   : kafka::next_epoch(_epoch);
+    }
+
+    void reset() { _epoch = kafka::initial_fetch_session_epoch; }
+
+private:
+    kafka::fetch_session_id _id{kafka::invalid_fetch_session_id};
+    kafka::fetch_session_epoch _epoch{kafka::initial_fetch_session_epoch};
+};
+
+/// \brief Fetch request of a partition.
+///
+/// The request is sessionless unless a session is given.
 kafka::fetch_request make_fetch_request(
   const model::topic_partition& tp,
   model::offset offset,
   int32_t max_bytes,
-  std::chrono::milliseconds timeout);
+  std::chrono::milliseconds timeout,
+  const fetch_session* session = nullptr);
 
 kafka::fetch_response::partition
 make_fetch_response(const model::topic_partition& tp, std::exception_ptr ex);
 
+/// \brief Partition of a fetch response without records.
+kafka::fetch_response::partition
+make_fetch_response(const model::topic_partition& tp, kafka::error_code error);
+
 } // namespace pandaproxy::client
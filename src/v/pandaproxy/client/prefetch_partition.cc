@@ -0,0 +1,208 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/client/prefetch_partition.h"
+
+#include "bytes/iobuf_parser.h"
+#include "kafka/errors.h"
+#include "pandaproxy/client/configuration.h"
+#include "pandaproxy/client/logger.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <algorithm>
+#include <utility>
+
+namespace pandaproxy::client {
+
+namespace {
+
+// base offset, batch length, leader epoch, magic, crc, attributes
+constexpr size_t last_offset_delta_pos = sizeof(int64_t) + sizeof(int32_t)
+                                         + sizeof(int32_t) + sizeof(int8_t)
+                                         + sizeof(int32_t) + sizeof(int16_t);
+// the batch length does not count the base offset and itself
+constexpr size_t batch_length_size = sizeof(int64_t) + sizeof(int32_t);
+
+} // namespace
+
+ss::future<prefetch_partition::response> prefetch_partition::fetch(
+  model::offset offset,
+  int32_t max_bytes,
+  std::chrono::milliseconds timeout) {
+    return ss::with_gate(_gate, [this, offset, max_bytes, timeout]() {
+        _timeout = timeout;
+        trim(offset);
+        if (buffered(offset)) {
+            auto res = take(offset, max_bytes);
+            maybe_prefetch();
+            return ss::make_ready_future<response>(std::move(res));
+        }
+        if (!_in_flight || offset != _next_offset) {
+            return fetch_direct(offset, max_bytes, timeout);
+        }
+        return _in_flight->get_shared_future().then(
+          [this, offset, max_bytes, timeout]() {
+              if (buffered(offset)) {
+                  auto res = take(offset, max_bytes);
+                  maybe_prefetch();
+                  return ss::make_ready_future<response>(std::move(res));
+              }
+              return fetch_direct(offset, max_bytes, timeout);
+          });
+    });
+}
+
+ss::future<prefetch_partition::response> prefetch_partition::fetch_direct(
+  model::offset offset,
+  int32_t max_bytes,
+  std::chrono::milliseconds timeout) {
+    reset();
+    return _fetch(nullptr, offset, max_bytes, timeout)
+      .then([this, offset, gen = _generation](response res) {
+          if (
+            gen != _generation || res.responses.size() != 1
+            || res.responses[0].has_error()) {
+              return res;
+          }
+          _next_offset = offset;
+          // the batches are shared with the response, not copied
+          apply(res.responses[0]);
+          maybe_prefetch();
+          return res;
+      });
+}
+
+void prefetch_partition::maybe_prefetch() {
+    const auto max_buffered = shard_local_cfg().fetch_prefetch_bytes();
+    if (
+      _in_flight || _gate.is_closed() || _next_offset < model::offset(0)
+      || _buffered_bytes >= size_t(std::max(max_buffered, 0))) {
+        return;
+    }
+    _in_flight.emplace();
+    const auto max_bytes = int32_t(max_buffered - _buffered_bytes);
+    (void)ss::with_gate(
+      _gate,
+      [this, max_bytes, offset = _next_offset, gen = _generation]() {
+          return _fetch(&_session, offset, max_bytes, _timeout)
+            .then_wrapped([this, offset, gen](ss::future<response> f) {
+                bool more = true;
+                try {
+                    auto res = f.get0();
+                    if (
+                      gen == _generation && offset == _next_offset
+                      && res.responses.size() == 1) {
+                        more = apply(res.responses[0]);
+                    }
+                } catch (...) {
+                    vlog(
+                      ppclog.debug,
+                      "prefetch of {} failed: {}",
+                      _tp,
+                      std::current_exception());
+                    more = false;
+                }
+                auto in_flight = std::exchange(_in_flight, std::nullopt);
+                in_flight->set_value();
+                // an idle consumer is not prefetched for, a fetch that came
+                // back empty waits for the next read
+                if (more) {
+                    maybe_prefetch();
+                }
+            });
+      });
+}
+
+bool prefetch_partition::apply(kafka::fetch_response::partition_response& r) {
+    if (r.has_error()) {
+        return false;
+    }
+    // an incremental fetch leaves out the partitions that did not change
+    if (r.high_watermark >= model::offset(0)) {
+        _high_watermark = r.high_watermark;
+        _last_stable_offset = r.last_stable_offset;
+        _log_start_offset = r.log_start_offset;
+    }
+    if (!r.record_set || r.record_set->empty()) {
+        return false;
+    }
+    auto& record_set = *r.record_set;
+    iobuf_const_parser parser(record_set);
+    size_t pos = 0;
+    bool buffered_any = false;
+    // a truncated batch at the end of the record set is left out
+    while (parser.bytes_left() >= last_offset_delta_pos + sizeof(int32_t)) {
+        auto base_offset = model::offset(parser.consume_be_type<int64_t>());
+        auto size = batch_length_size
+                    + size_t(parser.consume_be_type<int32_t>());
+        parser.skip(last_offset_delta_pos - batch_length_size);
+        auto last_offset_delta = parser.consume_be_type<int32_t>();
+        if (
+          size < last_offset_delta_pos + sizeof(int32_t)
+          || size > record_set.size_bytes() - pos) {
+            break;
+        }
+        if (base_offset >= _next_offset || _batches.empty()) {
+            _batches.push_back(buffered_batch{
+              .base_offset = base_offset,
+              .last_offset = base_offset + model::offset(last_offset_delta),
+              .record_set = record_set.share(pos, size)});
+            _buffered_bytes += size;
+            _next_offset = _batches.back().last_offset + model::offset(1);
+            buffered_any = true;
+        }
+        pos += size;
+        parser.skip(size - last_offset_delta_pos - sizeof(int32_t));
+    }
+    return buffered_any;
+}
+
+prefetch_partition::response
+prefetch_partition::take(model::offset offset, int32_t max_bytes) {
+    iobuf record_set;
+    for (auto& b : _batches) {
+        if (b.last_offset < offset) {
+            continue;
+        }
+        const auto size = b.record_set.size_bytes();
+        if (
+          !record_set.empty()
+          && record_set.size_bytes() + size > size_t(max_bytes)) {
+            break;
+        }
+        record_set.append(b.record_set.share(0, size));
+    }
+    response res{_tp.topic};
+    res.responses.push_back(kafka::fetch_response::partition_response{
+      .id{_tp.partition},
+      .error = kafka::error_code::none,
+      .high_watermark{_high_watermark},
+      .last_stable_offset{_last_stable_offset},
+      .log_start_offset{_log_start_offset},
+      .aborted_transactions{},
+      .record_set{std::move(record_set)}});
+    return res;
+}
+
+void prefetch_partition::trim(model::offset offset) {
+    while (!_batches.empty() && _batches.front().last_offset < offset) {
+        _buffered_bytes -= _batches.front().record_set.size_bytes();
+        _batches.pop_front();
+    }
+}
+
+void prefetch_partition::reset() {
+    ++_generation;
+    _batches.clear();
+    _buffered_bytes = 0;
+    _next_offset = model::offset(-1);
+}
+
+} // namespace pandaproxy::client
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "kafka/requests/fetch_request.h"
+#include "model/fundamental.h"
+#include "pandaproxy/client/fetcher.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <chrono>
+#include <deque>
+#include <optional>
+
+namespace pandaproxy::client {
+
+/// \brief Records of a partition fetched ahead of its consumer.
+///
+/// A consumer reading the partition in order is served from the buffer. The
+/// next fetch starts as soon as the previous one returns records, until
+/// fetch_prefetch_bytes are buffered, and a read waits for the fetch in flight
+/// rather than starting one of its own. A read at an offset that is neither
+/// buffered nor in flight drops the buffer and is fetched directly.
+///
+/// The fetches ahead run one at a time in a fetch session, the direct ones
+/// are sessionless.
+class prefetch_partition {
+public:
+    using response = kafka::fetch_response::partition;
+    /// \brief Fetch the partition, in the session if one is given.
+    using fetch_func = ss::noncopyable_function<ss::future<response>(
+      fetch_session*, model::offset, int32_t, std::chrono::milliseconds)>;
+
+    prefetch_partition(model::topic_partition tp, fetch_func&& fetch)
+      : _tp(std::move(tp))
+      , _fetch(std::move(fetch)) {}
+
+    ss::future<response> fetch(
+      model::offset offset,
+      int32_t max_bytes,
+      std::chrono::milliseconds timeout);
+
+    size_t buffered_bytes() const { return _buffered_bytes; }
+
+    ss::future<> stop() {
+        reset();
+        return _gate.close();
+    }
+
+private:
+    struct buffered_batch {
+        model::offset base_offset;
+        model::offset last_offset;
+        iobuf record_set;
+    };
+
+    /// \brief Serve the buffered batches from offset on, up to max_bytes.
+    ///
+    /// The batches stay buffered until a read moves past them, so a read of
+    /// the same offset is served again.
+    response take(model::offset offset, int32_t max_bytes);
+
+    /// \brief Fetch offset directly, then prefetch what follows.
+    ss::future<response> fetch_direct(
+      model::offset offset,
+      int32_t max_bytes,
+      std::chrono::milliseconds timeout);
+
+    /// \brief Start the next fetch ahead, unless one is in flight or the
+    /// buffer is full.
+    void maybe_prefetch();
+
+    /// \brief Buffer a response, returns true if it held records.
+    bool apply(kafka::fetch_response::partition_response& r);
+
+    bool buffered(model::offset offset) const {
+        return !_batches.empty() && _batches.front().base_offset <= offset
+               && offset <= _batches.back().last_offset;
+    }
+
+    /// \brief Drop the batches of offsets before offset.
+    void trim(model::offset offset);
+
+    /// \brief Drop the buffer, fetches ahead in flight are ignored.
+    void reset();
+
+    model::topic_partition _tp;
+    fetch_func _fetch;
+    fetch_session _session;
+    std::deque<buffered_batch> _batches;
+    size_t _buffered_bytes{0};
+    // offset of the next fetch ahead, unknown until a read
+    model::offset _next_offset{-1};
+    std::chrono::milliseconds _timeout{0};
+    model::offset _high_watermark{-1};
+    model::offset _last_stable_offset{-1};
+    model::offset _log_start_offset{-1};
+    std::optional<ss::shared_promise<>> _in_flight;
+    // bumped by reset(), a fetch ahead of an older generation is stale
+    uint64_t _generation{0};
+    ss::gate _gate;
+};
+
+} // namespace pandaproxy::client
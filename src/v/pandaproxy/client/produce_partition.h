@@ -25,6 +25,10 @@
 namespace pandaproxy::client {
 
 /// \brief Batch multiple client requests, flush them based on size or time.
+///
+/// A batch is sent once it holds produce_batch_record_count records or
+/// produce_batch_size_bytes bytes, or produce_batch_delay after its first
+/// record, whichever comes first.
 class produce_partition {
 public:
     using response = produce_batcher::partition_response;
@@ -61,15 +65,17 @@ private:
         vassert(!_in_flight, "do_consume should not run concurrently");
 
         _in_flight = true;
+        _lingered = false;
         _record_count = 0;
         _size_bytes = 0;
         return _batcher.consume();
     }
 
     bool try_consume(bool timed_out) {
-        if (_in_flight || _record_count == 0) {
+        if (_record_count == 0) {
             return false;
         }
+        _lingered |= timed_out;
 
         auto batch_record_count
           = shard_local_cfg().produce_batch_record_count();
@@ -78,12 +84,17 @@ private:
         auto threshold_met = _record_count >= batch_record_count
                              || _size_bytes >= batch_size_bytes;
 
-        if (!timed_out && !threshold_met) {
-            _timer.cancel();
-            _timer.arm(shard_local_cfg().produce_batch_delay());
+        if (_in_flight || (!_lingered && !threshold_met)) {
+            // the batch lingers from its first record on, like linger.ms of
+            // the kafka clients, neither records trickling in nor the batch
+            // in flight postpone it
+            if (!_lingered && !_timer.armed()) {
+                _timer.arm(shard_local_cfg().produce_batch_delay());
+            }
             return false;
         }
 
+        _timer.cancel();
         _consumer(do_consume());
         return true;
     }
@@ -94,6 +105,7 @@ private:
     int32_t _record_count{};
     int32_t _size_bytes{};
     bool _in_flight{};
+    bool _lingered{};
 };
 
 } // namespace pandaproxy::client
@@ -9,6 +9,7 @@
 
 #include "pandaproxy/client/producer.h"
 
+#include "hashing/xx.h"
 #include "kafka/errors.h"
 #include "kafka/requests/produce_request.h"
 #include "model/fundamental.h"
@@ -17,25 +18,40 @@
 #include "pandaproxy/client/error.h"
 #include "pandaproxy/client/logger.h"
 #include "pandaproxy/client/retry_with_mitigation.h"
+#include "random/generators.h"
+#include "vassert.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/gate.hh>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <exception>
+#include <utility>
 
 namespace pandaproxy::client {
 
-kafka::produce_request
-make_produce_request(model::topic_partition tp, model::record_batch&& batch) {
-    std::vector<kafka::produce_request::partition> partitions;
-    partitions.emplace_back(kafka::produce_request::partition{
-      .id{tp.partition},
-      .data{},
-      .adapter = kafka::kafka_batch_adapter{
-        .v2_format = true, .valid_crc = true, .batch{std::move(batch)}}});
+kafka::produce_request make_produce_request(
+  std::vector<std::pair<model::topic_partition, model::record_batch>>&&
+    batches) {
+    absl::flat_hash_map<
+      model::topic,
+      std::vector<kafka::produce_request::partition>>
+      partitions;
+    for (auto& [tp, batch] : batches) {
+        partitions[tp.topic].emplace_back(kafka::produce_request::partition{
+          .id{tp.partition},
+          .data{},
+          .adapter = kafka::kafka_batch_adapter{
+            .v2_format = true, .valid_crc = true, .batch{std::move(batch)}}});
+    }
 
     std::vector<kafka::produce_request::topic> topics;
-    topics.emplace_back(kafka::produce_request::topic{
-      .name{std::move(tp.topic)}, .partitions{std::move(partitions)}});
+    topics.reserve(partitions.size());
+    for (auto& [topic, ps] : partitions) {
+        topics.emplace_back(kafka::produce_request::topic{
+          .name{topic}, .partitions{std::move(ps)}});
+    }
     std::optional<ss::sstring> t_id;
     int16_t acks = -1;
     return kafka::produce_request(t_id, acks, std::move(topics));
@@ -73,25 +89,119 @@ producer::produce(model::topic_partition tp, model::record_batch&& batch) {
     return get_context(std::move(tp))->produce(std::move(batch));
 }
 
+std::optional<model::partition_id> producer::partition_for(
+  const model::topic& topic, const std::optional<iobuf>& key) {
+    auto count = _brokers.partition_count(topic);
+    if (!count) {
+        return std::nullopt;
+    }
+    if (key) {
+        incremental_xxhash64 h;
+        for (const auto& f : *key) {
+            h.update(f.get(), f.size());
+        }
+        return model::partition_id(h.digest() % *count);
+    }
+    auto it = _sticky.find(topic);
+    if (it == _sticky.end()) {
+        it = _sticky
+               .emplace(
+                 topic,
+                 sticky_partition{.id{random_generators::get_int(*count - 1)}})
+               .first;
+    } else if (it->second.sent || it->second.id() >= *count) {
+        // another partition than the one of the batch just sent
+        auto next = *count > 1 ? random_generators::get_int(*count - 2)
+                               : int32_t(0);
+        if (*count > 1 && next >= it->second.id()) {
+            ++next;
+        }
+        it->second = sticky_partition{.id{next}};
+    }
+    return it->second.id;
+}
+
 ss::future<kafka::produce_response::partition>
 producer::do_send(model::topic_partition tp, model::record_batch&& batch) {
-    return _brokers.find(tp)
-      .then([tp{std::move(tp)},
-             batch{std::move(batch)}](shared_broker_t broker) mutable {
-          return broker->dispatch(
-            make_produce_request(std::move(tp), std::move(batch)));
-      })
-      .then([](kafka::produce_response res) mutable {
-          auto topic = std::move(res.topics[0]);
-          auto partition = std::move(topic.partitions[0]);
-          if (partition.error != kafka::error_code::none) {
+    return _brokers.find(tp).then(
+      [this, tp, batch{std::move(batch)}](shared_broker_t broker) mutable {
+          if (_gate.is_closed()) {
               return ss::make_exception_future<
-                kafka::produce_response::partition>(partition_error(
-                model::topic_partition(topic.name, partition.id),
-                partition.error));
+                kafka::produce_response::partition>(
+                ss::gate_closed_exception());
+          }
+          auto [it, inserted] = _pending.try_emplace(broker->id());
+          if (inserted) {
+              it->second.broker = broker;
+              // the batches the other partitions consume in this task join
+              // the request
+              (void)ss::with_gate(_gate, [this, id = broker->id()] {
+                  return ss::later().then([this, id] { return flush(id); });
+              });
+          }
+          auto [s_it, s_inserted] = it->second.sends.try_emplace(
+            tp, pending_send{.batch = std::move(batch)});
+          vassert(s_inserted, "{} has more than one batch in flight", tp);
+          return s_it->second.promise.get_future();
+      });
+}
+
+ss::future<> producer::flush(model::node_id id) {
+    auto it = _pending.find(id);
+    if (it == _pending.end()) {
+        return ss::now();
+    }
+    auto req = std::move(it->second);
+    _pending.erase(it);
+
+    std::vector<std::pair<model::topic_partition, model::record_batch>>
+      batches;
+    batches.reserve(req.sends.size());
+    absl::flat_hash_map<
+      model::topic_partition,
+      ss::promise<kafka::produce_response::partition>>
+      promises;
+    for (auto& [tp, s] : req.sends) {
+        batches.emplace_back(tp, std::move(s.batch));
+        promises.emplace(tp, std::move(s.promise));
+    }
+    vlog(
+      ppclog.debug,
+      "send produce request: {{broker: {}, partitions: {}}}",
+      id,
+      batches.size());
+    return req.broker->dispatch(make_produce_request(std::move(batches)))
+      .then_wrapped([promises{std::move(promises)}](
+                      ss::future<kafka::produce_response> f) mutable {
+          if (f.failed()) {
+              auto ex = f.get_exception();
+              for (auto& [_, p] : promises) {
+                  p.set_exception(ex);
+              }
+              return;
+          }
+          auto res = f.get0();
+          for (auto& topic : res.topics) {
+              for (auto& partition : topic.partitions) {
+                  auto tp = model::topic_partition(topic.name, partition.id);
+                  auto p_it = promises.find(tp);
+                  if (p_it == promises.end()) {
+                      continue;
+                  }
+                  if (partition.error != kafka::error_code::none) {
+                      p_it->second.set_exception(
+                        partition_error(std::move(tp), partition.error));
+                  } else {
+                      p_it->second.set_value(std::move(partition));
+                  }
+                  promises.erase(p_it);
+              }
+          }
+          // partitions missing from the response
+          for (auto& [tp, p] : promises) {
+              p.set_exception(
+                partition_error(tp, kafka::error_code::unknown_server_error));
           }
-          return ss::make_ready_future<kafka::produce_response::partition>(
-            std::move(partition));
       });
 }
 
@@ -11,17 +11,29 @@
 
 #pragma once
 
+#include "bytes/iobuf.h"
 #include "model/fundamental.h"
+#include "pandaproxy/client/broker.h"
 #include "pandaproxy/client/produce_batcher.h"
 #include "pandaproxy/client/produce_partition.h"
 #include "ssx/future-util.h"
 
+#include <seastar/core/gate.hh>
+
 #include <absl/container/flat_hash_map.h>
 
+#include <optional>
+
 namespace pandaproxy::client {
 
 class brokers;
 
+/// \brief Batching producer.
+///
+/// Records are batched per partition by produce_partition. The batches
+/// ready in the same task are coalesced per leader, every broker receives
+/// one produce request for all of its partitions instead of one request per
+/// partition.
 class producer {
 public:
     using error_handler
@@ -38,20 +50,52 @@ public:
     ss::future<kafka::produce_response::partition>
     produce(model::topic_partition tp, model::record_batch&& batch);
 
+    /// \brief Partition for a record produced without one.
+    ///
+    /// Keyed records are hashed to a partition. Records without a key stick
+    /// to one partition until its batch is sent, then move to another one at
+    /// random, so they fill fewer and larger batches than round-robin would.
+    /// Returns nothing when the partitions of the topic are not known.
+    std::optional<model::partition_id>
+    partition_for(const model::topic& topic, const std::optional<iobuf>& key);
+
     ss::future<> stop() {
         return ssx::parallel_transform(
-          std::move(_partitions),
-          [](partitions_t::value_type p) { return p.second->stop(); });
+                 std::move(_partitions),
+                 [](partitions_t::value_type p) { return p.second->stop(); })
+          .then([this] { return _gate.close(); });
     }
 
 private:
+    struct pending_send {
+        model::record_batch batch;
+        ss::promise<kafka::produce_response::partition> promise;
+    };
+    /// \brief The batches waiting for the next request to a broker.
+    struct pending_request {
+        shared_broker_t broker;
+        absl::flat_hash_map<model::topic_partition, pending_send> sends;
+    };
+    struct sticky_partition {
+        model::partition_id id;
+        // the batch was sent, the next record moves to another partition
+        bool sent{false};
+    };
+
     ss::future<> send(model::topic_partition tp, model::record_batch&& batch);
 
     ss::future<kafka::produce_response::partition>
     do_send(model::topic_partition tp, model::record_batch&& batch);
 
+    /// \brief Send the pending batches of the broker in one request.
+    ss::future<> flush(model::node_id id);
+
     auto make_consumer(model::topic_partition tp) {
         return [this, tp](model::record_batch&& batch) {
+            if (auto it = _sticky.find(tp.topic);
+                it != _sticky.end() && it->second.id == tp.partition) {
+                it->second.sent = true;
+            }
             (void)send(tp, std::move(batch));
         };
     }
@@ -69,6 +113,9 @@ private:
       _partitions;
     error_handler _error_handler;
     brokers& _brokers;
+    absl::flat_hash_map<model::node_id, pending_request> _pending;
+    absl::flat_hash_map<model::topic, sticky_partition> _sticky;
+    ss::gate _gate;
 };
 
 } // namespace pandaproxy::client
@@ -0,0 +1,87 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/client/brokers.h"
+
+#include "kafka/errors.h"
+#include "kafka/requests/metadata_request.h"
+#include "model/fundamental.h"
+#include "pandaproxy/client/error.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/tools/old/interface.hpp>
+
+namespace ppc = pandaproxy::client;
+
+namespace {
+
+kafka::metadata_response::topic make_topic(model::topic t, int32_t count) {
+    kafka::metadata_response::topic topic{
+      .err_code = kafka::error_code::none, .name = std::move(t)};
+    for (int32_t p = 0; p < count; ++p) {
+        topic.partitions.push_back(kafka::metadata_response::partition{
+          .err_code = kafka::error_code::none,
+          .index = model::partition_id(p),
+          .leader = model::node_id(1)});
+    }
+    return topic;
+}
+
+kafka::metadata_response
+make_metadata(std::vector<kafka::metadata_response::topic> topics) {
+    kafka::metadata_response res;
+    res.topics = std::move(topics);
+    return res;
+}
+
+/// \brief Error of finding the leader, there are no brokers to find.
+kafka::error_code
+find_error(ppc::brokers& brokers, const model::topic& t, int32_t p) {
+    try {
+        brokers.find(model::topic_partition(t, model::partition_id(p))).get();
+    } catch (const ppc::partition_error& ex) {
+        return ex.error;
+    }
+    return kafka::error_code::none;
+}
+
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(test_brokers_apply_topics) {
+    const model::topic a{"a"};
+    const model::topic b{"b"};
+    ppc::brokers brokers;
+    brokers.apply(make_metadata({make_topic(a, 3), make_topic(b, 1)})).get();
+    BOOST_REQUIRE_EQUAL(*brokers.partition_count(a), 3);
+    BOOST_REQUIRE_EQUAL(*brokers.partition_count(b), 1);
+
+    // the topics of the response are replaced, the others are left alone
+    brokers.apply_topics(make_metadata({make_topic(a, 2)})).get();
+    BOOST_REQUIRE_EQUAL(*brokers.partition_count(a), 2);
+    BOOST_REQUIRE_EQUAL(*brokers.partition_count(b), 1);
+    BOOST_REQUIRE_EQUAL(
+      find_error(brokers, a, 1), kafka::error_code::leader_not_available);
+    BOOST_REQUIRE_EQUAL(
+      find_error(brokers, a, 2), kafka::error_code::unknown_topic_or_partition);
+    BOOST_REQUIRE_EQUAL(
+      find_error(brokers, b, 0), kafka::error_code::leader_not_available);
+
+    // a topic that is gone has no partitions in the response
+    brokers.apply_topics(make_metadata({make_topic(a, 0)})).get();
+    BOOST_REQUIRE(!brokers.partition_count(a));
+    BOOST_REQUIRE_EQUAL(
+      find_error(brokers, a, 0), kafka::error_code::unknown_topic_or_partition);
+
+    // a full update replaces every topic
+    brokers.apply(make_metadata({make_topic(a, 1)})).get();
+    BOOST_REQUIRE_EQUAL(*brokers.partition_count(a), 1);
+    BOOST_REQUIRE(!brokers.partition_count(b));
+    brokers.stop().get();
+}
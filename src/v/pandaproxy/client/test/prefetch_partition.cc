@@ -0,0 +1,177 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/client/prefetch_partition.h"
+
+#include "bytes/iobuf_parser.h"
+#include "kafka/errors.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/response_writer.h"
+#include "kafka/requests/response_writer_utils.h"
+#include "model/fundamental.h"
+#include "pandaproxy/client/configuration.h"
+#include "pandaproxy/client/fetcher.h"
+#include "pandaproxy/client/test/utils.h"
+
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace ppc = pandaproxy::client;
+using namespace std::chrono_literals;
+
+namespace {
+
+// every fetch returns a batch of two records, up to this offset
+const model::offset log_end{10};
+const model::topic_partition tp{model::topic{"t"}, model::partition_id{0}};
+
+iobuf make_record_set(model::offset offset) {
+    iobuf record_set;
+    if (offset >= log_end) {
+        return record_set;
+    }
+    auto batch = make_batch(offset, 2);
+    batch.header().base_offset = offset;
+    auto writer{kafka::response_writer(record_set)};
+    kafka::writer_serialize_batch(writer, std::move(batch));
+    return record_set;
+}
+
+struct fetch_call {
+    bool in_session;
+    model::offset offset;
+};
+
+struct fake_broker {
+    std::vector<fetch_call> calls;
+
+    ppc::prefetch_partition::fetch_func fetch_func() {
+        return [this](
+                 ppc::fetch_session* session,
+                 model::offset offset,
+                 int32_t,
+                 std::chrono::milliseconds) {
+            calls.push_back({session != nullptr, offset});
+            kafka::fetch_response::partition res{tp.topic};
+            res.responses.push_back(kafka::fetch_response::partition_response{
+              .id{tp.partition},
+              .error = kafka::error_code::none,
+              .high_watermark{log_end},
+              .last_stable_offset{log_end},
+              .log_start_offset{model::offset{0}},
+              .aborted_transactions{},
+              .record_set{make_record_set(offset)}});
+            return ss::make_ready_future<kafka::fetch_response::partition>(
+              std::move(res));
+        };
+    }
+
+    size_t direct_calls() const {
+        return std::count_if(calls.begin(), calls.end(), [](fetch_call c) {
+            return !c.in_session;
+        });
+    }
+};
+
+/// \brief Base offset of the first batch fetched from offset
+model::offset fetch_base_offset(ppc::prefetch_partition& p, model::offset o) {
+    auto res = p.fetch(o, 1, 1s).get0();
+    BOOST_REQUIRE_EQUAL(res.responses.size(), 1);
+    const auto& r = res.responses[0];
+    BOOST_REQUIRE_EQUAL(r.error, kafka::error_code::none);
+    BOOST_REQUIRE(r.record_set && !r.record_set->empty());
+    iobuf_const_parser parser(*r.record_set);
+    return model::offset(parser.consume_be_type<int64_t>());
+}
+
+// let the fetches ahead run
+void settle() { ss::sleep(10ms).get(); }
+
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(test_prefetch_partition_in_order) {
+    ppc::shard_local_cfg().fetch_prefetch_bytes.set_value(1024 * 1024);
+    fake_broker broker;
+    ppc::prefetch_partition p(tp, broker.fetch_func());
+    const model::offset first{0};
+
+    BOOST_REQUIRE_EQUAL(fetch_base_offset(p, first), first);
+    settle();
+    // one read, the rest of the partition was fetched ahead in the session
+    BOOST_REQUIRE_EQUAL(broker.direct_calls(), 1);
+    BOOST_REQUIRE(!broker.calls[0].in_session);
+    BOOST_REQUIRE_GE(broker.calls.size(), 6);
+    BOOST_REQUIRE_EQUAL(broker.calls[5].offset, log_end);
+
+    for (auto o = model::offset(2); o < log_end; o += 2) {
+        BOOST_REQUIRE_EQUAL(fetch_base_offset(p, o), o);
+    }
+    BOOST_REQUIRE_EQUAL(broker.direct_calls(), 1);
+    p.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_prefetch_partition_out_of_order) {
+    ppc::shard_local_cfg().fetch_prefetch_bytes.set_value(1024 * 1024);
+    fake_broker broker;
+    ppc::prefetch_partition p(tp, broker.fetch_func());
+    const model::offset first{0};
+    const model::offset third{4};
+
+    p.fetch(first, 1, 1s).get();
+    settle();
+    BOOST_REQUIRE_EQUAL(fetch_base_offset(p, third), third);
+    BOOST_REQUIRE_EQUAL(broker.direct_calls(), 1);
+
+    // the batches before offset 4 were dropped, a rewind is fetched directly
+    BOOST_REQUIRE_EQUAL(fetch_base_offset(p, first), first);
+    BOOST_REQUIRE_EQUAL(broker.direct_calls(), 2);
+    p.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_prefetch_partition_bounded) {
+    const auto batch_size = make_record_set(model::offset(0)).size_bytes();
+    // configuration under test
+    ppc::shard_local_cfg().fetch_prefetch_bytes.set_value(
+      int32_t(2 * batch_size - 1));
+    fake_broker broker;
+    ppc::prefetch_partition p(tp, broker.fetch_func());
+
+    p.fetch(model::offset(0), 1, 1s).get();
+    settle();
+    BOOST_REQUIRE_EQUAL(broker.calls.size(), 2);
+    BOOST_REQUIRE_EQUAL(p.buffered_bytes(), 2 * batch_size);
+
+    // reading on frees the buffer for the next fetch ahead
+    p.fetch(model::offset(2), 1, 1s).get();
+    settle();
+    BOOST_REQUIRE_EQUAL(broker.calls.size(), 3);
+    BOOST_REQUIRE_EQUAL(broker.calls[2].offset, model::offset(4));
+    BOOST_REQUIRE_EQUAL(p.buffered_bytes(), 2 * batch_size);
+    p.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_prefetch_partition_disabled) {
+    // configuration under test
+    ppc::shard_local_cfg().fetch_prefetch_bytes.set_value(0);
+    fake_broker broker;
+    ppc::prefetch_partition p(tp, broker.fetch_func());
+
+    p.fetch(model::offset(0), 1, 1s).get();
+    p.fetch(model::offset(2), 1, 1s).get();
+    settle();
+    BOOST_REQUIRE_EQUAL(broker.calls.size(), 2);
+    BOOST_REQUIRE_EQUAL(broker.direct_calls(), 2);
+    p.stop().get();
+}
@@ -17,6 +17,7 @@
 #include "pandaproxy/client/configuration.h"
 #include "pandaproxy/client/test/utils.h"
 
+#include <seastar/core/sleep.hh>
 #include <seastar/testing/thread_test_case.hh>
 
 #include <boost/test/tools/old/interface.hpp>
@@ -64,3 +65,34 @@ SEASTAR_THREAD_TEST_CASE(test_produce_partition_record_count) {
     auto c_res2 = c_res2_fut.get0();
     BOOST_REQUIRE_EQUAL(c_res2.base_offset, model::offset{3});
 }
+
+SEASTAR_THREAD_TEST_CASE(test_produce_partition_linger) {
+    using namespace std::chrono_literals;
+    std::vector<model::record_batch> consumed_batches;
+    auto consumer = [&consumed_batches](model::record_batch&& batch) {
+        consumed_batches.push_back(std::move(batch));
+    };
+
+    ppc::shard_local_cfg().produce_batch_size_bytes.set_value(1024 * 1024);
+    ppc::shard_local_cfg().produce_batch_record_count.set_value(1000);
+    // configuration under test
+    ppc::shard_local_cfg().produce_batch_delay.set_value(100ms);
+
+    ppc::produce_partition producer(consumer);
+
+    auto c_res0_fut = producer.produce(make_batch(model::offset(0), 1));
+    ss::sleep(60ms).get();
+    // a record joining the batch does not postpone it
+    auto c_res1_fut = producer.produce(make_batch(model::offset(1), 1));
+    ss::sleep(60ms).get();
+
+    BOOST_REQUIRE_EQUAL(consumed_batches.size(), 1);
+    BOOST_REQUIRE_EQUAL(consumed_batches[0].record_count(), 2);
+    producer.handle_response(kafka::produce_response::partition{
+      .id{model::partition_id{42}},
+      .error = kafka::error_code::none,
+      .base_offset{model::offset{0}}});
+    BOOST_REQUIRE_EQUAL(c_res1_fut.get0().base_offset, model::offset{1});
+    c_res0_fut.get();
+    producer.stop().get();
+}
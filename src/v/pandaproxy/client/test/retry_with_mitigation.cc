@@ -10,6 +10,7 @@
 #include "pandaproxy/client/retry_with_mitigation.h"
 
 #include <seastar/core/future.hh>
+#include <seastar/core/sleep.hh>
 #include <seastar/testing/thread_test_case.hh>
 
 #include <absl/container/flat_hash_set.h>
@@ -89,3 +90,23 @@ SEASTAR_THREAD_TEST_CASE(test_retry_fail_all) {
     BOOST_REQUIRE_EQUAL(ctx.calls(), 3);
     BOOST_REQUIRE_EQUAL(errors, 3);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_retry_waits_for_mitigation) {
+    bool mitigated{false};
+    size_t calls{0};
+    auto res = ppc::retry_with_mitigation(
+      1,
+      0ms,
+      [&mitigated, &calls]() {
+          if (calls++ == 0) {
+              return ss::make_exception_future(counted_error(calls));
+          }
+          BOOST_REQUIRE(mitigated);
+          return ss::now();
+      },
+      [&mitigated](std::exception_ptr) {
+          return ss::sleep(10ms).then([&mitigated]() { mitigated = true; });
+      });
+    BOOST_REQUIRE_NO_THROW(res.get());
+    BOOST_REQUIRE_EQUAL(calls, 2);
+}
@@ -57,7 +57,14 @@ configuration::configuration()
       "disable_metrics",
       "Disable registering metrics",
       config::required::no,
-      false) {}
+      false)
+  , produce_chunk_bytes(
+      *this,
+      "produce_chunk_bytes",
+      "Bytes of keys and values of a partition produced at once while a "
+      "produce request is parsed",
+      config::required::no,
+      1_MiB) {}
 
 void configuration::read_yaml(const YAML::Node& root_node) {
     if (!root_node["pandaproxy"]) {
@@ -32,6 +32,7 @@ struct configuration final : public config::config_store {
     config::property<ss::sstring> admin_api_doc_dir;
     config::property<ss::sstring> api_doc_dir;
     config::property<bool> disable_metrics;
+    config::property<size_t> produce_chunk_bytes;
 
     configuration();
 
@@ -0,0 +1,137 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/fetch_writer.h"
+
+#include "kafka/requests/kafka_batch_adapter.h"
+#include "pandaproxy/json/rjson_util.h"
+#include "vassert.h"
+
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/loop.hh>
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace pandaproxy {
+
+fetch_format parse_fetch_format(std::string_view accept) {
+    std::vector<std::string_view> types;
+    boost::split(
+      types, accept, boost::is_any_of(",; "), boost::token_compress_on);
+    auto accepts = [&types](std::string_view t) {
+        return std::find(types.begin(), types.end(), t) != types.end();
+    };
+    if (accepts("application/octet-stream")) {
+        return fetch_format::binary;
+    }
+    if (
+      accepts("application/x-ndjson")
+      || accepts("application/vnd.kafka.binary.v2+ndjson")) {
+        return fetch_format::ndjson;
+    }
+    return fetch_format::json;
+}
+
+std::string_view fetch_content_type(fetch_format fmt) {
+    switch (fmt) {
+    case fetch_format::json:
+        return "application/json";
+    case fetch_format::ndjson:
+        return "application/x-ndjson";
+    case fetch_format::binary:
+        return "application/octet-stream";
+    }
+    return "application/json";
+}
+
+static void append_sized(iobuf& out, int32_t size, iobuf bytes) {
+    const auto be = ss::cpu_to_be(size < 0 ? int32_t(-1) : size);
+    out.append(reinterpret_cast<const char*>(&be), sizeof(be));
+    if (size > 0) {
+        out.append(std::move(bytes));
+    }
+}
+
+iobuf encode_fetched_record(
+  fetch_format fmt,
+  json::serialization_format value_fmt,
+  json::fetched_record&& r) {
+    iobuf out;
+    switch (fmt) {
+    case fetch_format::json:
+        [[fallthrough]];
+    case fetch_format::ndjson: {
+        out = json::rjson_serialize_iobuf(std::move(r), value_fmt);
+        out.append("\n", 1);
+        break;
+    }
+    case fetch_format::binary: {
+        const auto offset = ss::cpu_to_be(r.offset());
+        out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        append_sized(out, r.record.key_size(), r.record.copy_key());
+        append_sized(out, r.record.value_size(), r.record.copy_value());
+        break;
+    }
+    }
+    return out;
+}
+
+static ss::future<> write_iobuf(ss::output_stream<char>& out, iobuf buf) {
+    return ss::do_with(std::move(buf), [&out](iobuf& buf) {
+        return ss::do_for_each(buf, [&out](iobuf::fragment& f) {
+            return out.write(f.get(), f.size());
+        });
+    });
+}
+
+ss::future<> write_fetched_records(
+  ss::output_stream<char>& out,
+  fetch_format fmt,
+  json::serialization_format value_fmt,
+  kafka::fetch_response::partition v) {
+    vassert(v.responses.size() == 1, "expected a single partition_response");
+    auto r = std::move(v.responses[0]);
+    if (!r.record_set || r.record_set->empty()) {
+        return ss::now();
+    }
+    kafka::kafka_batch_adapter adapter;
+    adapter.adapt(std::move(*r.record_set));
+    if (!adapter.batch) {
+        return ss::now();
+    }
+    // decoded one record at a time, each written before the next one
+    return ss::do_with(
+      std::move(*adapter.batch),
+      std::move(v.name),
+      [&out, fmt, value_fmt, partition = r.id](
+        model::record_batch& batch, model::topic& topic) {
+          return model::async_for_each_record_view(
+            batch,
+            [&out, &batch, &topic, fmt, value_fmt, partition](
+              const model::record_view& record) {
+                const auto offset = model::offset(
+                  batch.base_offset()() + record.offset_delta());
+                return write_iobuf(
+                  out,
+                  encode_fetched_record(
+                    fmt,
+                    value_fmt,
+                    json::fetched_record{
+                      .topic = topic,
+                      .partition = partition,
+                      .offset = offset,
+                      .record = record}));
+            });
+      });
+}
+
+} // namespace pandaproxy
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "kafka/requests/fetch_request.h"
+#include "pandaproxy/json/requests/fetch.h"
+#include "pandaproxy/json/types.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/iostream.hh>
+
+#include <cstdint>
+#include <string_view>
+
+namespace pandaproxy {
+
+/// Layout of the records of a fetch response
+enum class fetch_format : uint8_t {
+    // one JSON array holding every record
+    json = 0,
+    // one JSON record per line
+    ndjson,
+    // length prefixed records, see encode_fetched_record
+    binary
+};
+
+/// Layout of the fetch response requested by the Accept header
+fetch_format parse_fetch_format(std::string_view accept);
+
+/// Content type of the fetch responses in `fmt`
+std::string_view fetch_content_type(fetch_format fmt);
+
+/**
+ * Encodes a record in a streamed layout.
+ *
+ * An ndjson record is the JSON object of the json layout followed by a
+ * newline. A binary record is its big endian int64 offset, the int32 size of
+ * its key, the key, the int32 size of its value and the value, the sizes of
+ * null keys and values are -1. The key and value bytes are not encoded.
+ */
+iobuf encode_fetched_record(
+  fetch_format, json::serialization_format, json::fetched_record&&);
+
+/// Writes the records of the fetched partition to `out` one at a time as
+/// they are decoded, the response is never built in memory
+ss::future<> write_fetched_records(
+  ss::output_stream<char>& out,
+  fetch_format,
+  json::serialization_format,
+  kafka::fetch_response::partition);
+
+} // namespace pandaproxy
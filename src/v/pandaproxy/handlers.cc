@@ -9,24 +9,25 @@
 
 #include "handlers.h"
 
+#include "bytes/iobuf.h"
 #include "kafka/requests/fetch_request.h"
 #include "model/fundamental.h"
+#include "pandaproxy/configuration.h"
+#include "pandaproxy/fetch_writer.h"
 #include "pandaproxy/json/requests/fetch.h"
 #include "pandaproxy/json/requests/produce.h"
 #include "pandaproxy/json/rjson_util.h"
+#include "pandaproxy/produce_stream.h"
 #include "pandaproxy/reply.h"
-#include "raft/types.h"
-#include "ssx/future-util.h"
-#include "storage/record_batch_builder.h"
 
 #include <seastar/core/future.hh>
 
-#include <absl/container/flat_hash_map.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <algorithm>
 #include <chrono>
+#include <memory>
 
 namespace ppj = pandaproxy::json;
 
@@ -34,14 +35,20 @@ namespace pandaproxy {
 
 ppj::serialization_format parse_serialization_format(std::string_view accept) {
     std::vector<std::string_view> none = {
-      "", "*/*", "application/json", "application/vnd.kafka.v2+json"};
+      "",
+      "*/*",
+      "application/json",
+      "application/vnd.kafka.v2+json",
+      "application/x-ndjson",
+      "application/octet-stream"};
 
     std::vector<ss::sstring> results;
     boost::split(
       results, accept, boost::is_any_of(",; "), boost::token_compress_on);
 
     if (std::any_of(results.begin(), results.end(), [](std::string_view v) {
-            return v == "application/vnd.kafka.binary.v2+json";
+            return v == "application/vnd.kafka.binary.v2+json"
+                   || v == "application/vnd.kafka.binary.v2+ndjson";
         })) {
         return ppj::serialization_format::binary_v2;
     }
@@ -92,6 +99,7 @@ get_topics_records(server::request_t rq, server::reply_t rp) {
         rp.rep = unprocessable_entity("Unsupported serialization format");
         return ss::make_ready_future<server::reply_t>(std::move(rp));
     }
+    auto fetch_fmt = parse_fetch_format(rq.req->get_header("Accept"));
 
     model::topic_partition tp{
       model::topic(rq.req->param["topic_name"]),
@@ -108,16 +116,43 @@ get_topics_records(server::request_t rq, server::reply_t rp) {
     rq.req.reset();
     return rq.ctx.client
       .fetch_partition(std::move(tp), offset, max_bytes, timeout)
-      .then([fmt,
-             rp = std::move(rp)](kafka::fetch_response::partition res) mutable {
-          rapidjson::StringBuffer str_buf;
-          rapidjson::Writer<rapidjson::StringBuffer> w(str_buf);
-
-          ppj::rjson_serialize_fmt(fmt)(w, std::move(res));
-
-          // TODO Ben: Prevent this linearization
-          ss::sstring json_rslt = str_buf.GetString();
-          rp.rep->write_body("json", json_rslt);
+      .then([fmt, fetch_fmt, rp = std::move(rp)](
+              kafka::fetch_response::partition res) mutable {
+          if (
+            fetch_fmt == fetch_format::json || res.responses.size() != 1
+            || res.responses[0].has_error()) {
+              // written a fragment at a time, never linearized
+              rp.rep->write_body(
+                "json",
+                [body = ppj::rjson_serialize_iobuf(std::move(res), fmt)](
+                  ss::output_stream<char>&& out) mutable {
+                    return ss::do_with(
+                      std::move(out),
+                      [body = std::move(body)](
+                        ss::output_stream<char>& out) mutable {
+                          return write_iobuf_to_output_stream(
+                                   std::move(body), out)
+                            .finally([&out] { return out.close(); });
+                      });
+                });
+              return std::move(rp);
+          }
+          // streamed in a chunked body as the records are decoded
+          rp.rep->write_body(
+            "bin",
+            [fmt, fetch_fmt, res = std::move(res)](
+              ss::output_stream<char>&& out) mutable {
+                return ss::do_with(
+                  std::move(out),
+                  [fmt, fetch_fmt, res = std::move(res)](
+                    ss::output_stream<char>& out) mutable {
+                      return write_fetched_records(
+                               out, fetch_fmt, fmt, std::move(res))
+                        .finally([&out] { return out.close(); });
+                  });
+            });
+          rp.rep->add_header(
+            "Content-Type", ss::sstring(fetch_content_type(fetch_fmt)));
           return std::move(rp);
       });
 }
@@ -130,42 +165,18 @@ post_topics_name(server::request_t rq, server::reply_t rp) {
         return ss::make_ready_future<server::reply_t>(std::move(rp));
     }
 
-    auto raw_records = ppj::rjson_parse(
-      rq.req->content.data(), ppj::produce_request_handler(fmt));
-
-    absl::flat_hash_map<model::partition_id, storage::record_batch_builder>
-      partition_builders;
-
-    for (auto& r : raw_records) {
-        auto it = partition_builders
-                    .try_emplace(r.id, raft::data_batch_type, model::offset(0))
-                    .first;
-        it->second.add_raw_kv(
-          std::move(r.key).value_or(iobuf{}),
-          std::move(r.value).value_or(iobuf{}));
-    }
-
-    std::vector<kafka::produce_request::partition> partitions;
-    partitions.reserve(partition_builders.size());
-    for (auto& pb : partition_builders) {
-        partitions.emplace_back(kafka::produce_request::partition{
-          .id = pb.first,
-          .data = {},
-          .adapter = kafka::kafka_batch_adapter{
-            .v2_format = true,
-            .valid_crc = true,
-            .batch = std::move(pb.second).build()}});
-    }
-
     auto topic = model::topic(rq.req->param["topic_name"]);
-    return ssx::parallel_transform(
-             std::move(partitions),
-             [topic,
-              rq{std::move(rq)}](kafka::produce_request::partition p) mutable {
-                 return rq.ctx.client.produce_record_batch(
-                   model::topic_partition(topic, p.id),
-                   std::move(*p.adapter.batch));
-             })
+    auto& client = rq.ctx.client;
+    auto stream = std::make_unique<produce_stream>(
+      client,
+      topic,
+      fmt,
+      rq.req->content.data(),
+      shard_local_cfg().produce_chunk_bytes());
+    auto f = stream->run();
+    // the body parsed by the stream is owned by the request
+    return std::move(f)
+      .finally([rq{std::move(rq)}, stream = std::move(stream)] {})
       .then([topic, rp{std::move(rp)}](auto responses) mutable {
           std::vector<kafka::produce_response::topic> topics;
           topics.push_back(kafka::produce_response::topic{
@@ -24,8 +24,8 @@ struct error_body {
     ss::sstring message;
 };
 
-inline void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const error_body& v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, const error_body& v) {
     w.StartObject();
     w.Key("error_code");
     ::json::rjson_serialize(w, v.error_code);
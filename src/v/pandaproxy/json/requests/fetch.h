@@ -17,6 +17,7 @@
 #include "kafka/errors.h"
 #include "kafka/requests/fetch_request.h"
 #include "model/record.h"
+#include "model/record_view.h"
 #include "model/record_batch_reader.h"
 #include "pandaproxy/json/iobuf.h"
 #include "pandaproxy/json/requests/error_reply.h"
@@ -33,15 +34,50 @@
 
 namespace pandaproxy::json {
 
+/// A record of a fetched partition
+struct fetched_record {
+    const model::topic& topic;
+    model::partition_id partition;
+    model::offset offset;
+    // refers to the fetched batch, which outlives it
+    model::record_view record;
+};
+
+template<>
+class rjson_serialize_impl<fetched_record> {
+public:
+    explicit rjson_serialize_impl(serialization_format fmt)
+      : _fmt(fmt) {}
+
+    template<typename Buffer>
+    void operator()(rapidjson::Writer<Buffer>& w, fetched_record&& v) {
+        w.StartObject();
+        w.Key("topic");
+        ::json::rjson_serialize(w, v.topic);
+        w.Key("key");
+        rjson_serialize_fmt(_fmt)(w, v.record.copy_key());
+        w.Key("value");
+        rjson_serialize_fmt(_fmt)(w, v.record.copy_value());
+        w.Key("partition");
+        ::json::rjson_serialize(w, v.partition);
+        w.Key("offset");
+        ::json::rjson_serialize(w, v.offset);
+        w.EndObject();
+    }
+
+private:
+    serialization_format _fmt;
+};
+
 template<>
 class rjson_serialize_impl<kafka::fetch_response::partition> {
 public:
     explicit rjson_serialize_impl(serialization_format fmt)
       : _fmt(fmt) {}
 
+    template<typename Buffer>
     void operator()(
-      rapidjson::Writer<rapidjson::StringBuffer>& w,
-      kafka::fetch_response::partition&& v) {
+      rapidjson::Writer<Buffer>& w, kafka::fetch_response::partition&& v) {
         vassert(
           v.responses.size() == 1, "expected a single partition_response");
 
@@ -58,21 +94,18 @@ public:
         if (r.record_set && !r.record_set->empty()) {
             kafka::kafka_batch_adapter adapter;
             adapter.adapt(std::move(*r.record_set));
-            adapter.batch->for_each_record(
-              [this, &w, &v, &r, &adapter](model::record record) {
-                  w.StartObject();
-                  w.Key("topic");
-                  ::json::rjson_serialize(w, v.name);
-                  w.Key("key");
-                  rjson_serialize_fmt(_fmt)(w, record.release_key());
-                  w.Key("value");
-                  rjson_serialize_fmt(_fmt)(w, record.release_value());
-                  w.Key("partition");
-                  ::json::rjson_serialize(w, r.id);
-                  w.Key("offset");
-                  ::json::rjson_serialize(
-                    w, adapter.batch->base_offset()() + record.offset_delta());
-                  w.EndObject();
+            model::for_each_record_view(
+              *adapter.batch,
+              [this, &w, &v, &r, &adapter](const model::record_view& record) {
+                  rjson_serialize_fmt(_fmt)(
+                    w,
+                    fetched_record{
+                      .topic = v.name,
+                      .partition = r.id,
+                      .offset = model::offset(
+                        adapter.batch->base_offset()()
+                        + record.offset_delta()),
+                      .record = record});
               });
         }
         w.EndArray();
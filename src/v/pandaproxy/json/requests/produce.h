@@ -27,7 +27,8 @@
 namespace pandaproxy::json {
 
 struct record {
-    model::partition_id id;
+    // the producer chooses the partition of records without one
+    std::optional<model::partition_id> id;
     std::optional<iobuf> key;
     std::optional<iobuf> value;
 };
@@ -55,6 +56,13 @@ public:
     explicit produce_request_handler(serialization_format fmt)
       : _fmt(fmt) {}
 
+    /// Leading records of the result which were parsed entirely
+    size_t complete_records() const {
+        const bool in_record = state != state::empty
+                               && state != state::records;
+        return in_record ? result.size() - 1 : result.size();
+    }
+
     bool Null() { return false; }
     bool Bool(bool) { return false; }
     bool Int64(int64_t) { return false; }
@@ -151,9 +159,9 @@ public:
     bool EndArray(rapidjson::SizeType) { return state == state::records; }
 };
 
-inline void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const kafka::produce_response::partition& v) {
+template<typename Buffer>
+void rjson_serialize(
+  rapidjson::Writer<Buffer>& w, const kafka::produce_response::partition& v) {
     w.StartObject();
     w.Key("partition");
     w.Int(v.id);
@@ -166,9 +174,9 @@ inline void rjson_serialize(
     w.EndObject();
 }
 
-inline void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const kafka::produce_response::topic& v) {
+template<typename Buffer>
+void rjson_serialize(
+  rapidjson::Writer<Buffer>& w, const kafka::produce_response::topic& v) {
     w.StartObject();
     w.Key("offsets");
     w.StartArray();
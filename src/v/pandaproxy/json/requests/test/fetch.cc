@@ -15,13 +15,16 @@
 #include "kafka/requests/response_writer_utils.h"
 #include "model/fundamental.h"
 #include "model/record.h"
+#include "model/record_view.h"
 #include "model/timestamp.h"
 #include "pandaproxy/client/test/utils.h"
+#include "pandaproxy/fetch_writer.h"
 #include "pandaproxy/json/requests/fetch.h"
 #include "pandaproxy/json/rjson_util.h"
 #include "pandaproxy/json/types.h"
 #include "seastarx.h"
 
+#include <seastar/core/byteorder.hh>
 #include <seastar/testing/thread_test_case.hh>
 
 #include <boost/test/tools/interface.hpp>
@@ -29,6 +32,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
 #include <type_traits>
 
 namespace ppj = pandaproxy::json;
@@ -89,3 +93,63 @@ SEASTAR_THREAD_TEST_CASE(test_produce_fetch_one) {
 
     BOOST_REQUIRE_EQUAL(str_buf.GetString(), expected);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_fetch_format_from_accept) {
+    BOOST_REQUIRE(
+      pandaproxy::parse_fetch_format("application/vnd.kafka.binary.v2+json")
+      == pandaproxy::fetch_format::json);
+    BOOST_REQUIRE(
+      pandaproxy::parse_fetch_format("application/vnd.kafka.binary.v2+ndjson")
+      == pandaproxy::fetch_format::ndjson);
+    BOOST_REQUIRE(
+      pandaproxy::parse_fetch_format("text/plain, application/octet-stream")
+      == pandaproxy::fetch_format::binary);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_fetch_record_ndjson) {
+    auto batch = make_batch(model::offset{0}, 1);
+    auto record = model::record_view_reader(batch).next();
+    const model::topic topic{"topic"};
+
+    auto buf = pandaproxy::encode_fetched_record(
+      pandaproxy::fetch_format::ndjson,
+      ppj::serialization_format::binary_v2,
+      ppj::fetched_record{
+        .topic = topic,
+        .partition = model::partition_id{1},
+        .offset = model::offset{3},
+        .record = record});
+
+    iobuf_parser p(std::move(buf));
+    BOOST_REQUIRE_EQUAL(
+      p.read_string(p.bytes_left()),
+      "{\"topic\":\"topic\",\"key\":\"AAAAAAAAAAA=\",\"value\":\"\","
+      "\"partition\":1,\"offset\":3}\n");
+}
+
+SEASTAR_THREAD_TEST_CASE(test_fetch_record_binary) {
+    auto batch = make_batch(model::offset{0}, 1);
+    auto record = model::record_view_reader(batch).next();
+    const auto value_size = record.value_size();
+    const model::topic topic{"topic"};
+
+    auto buf = pandaproxy::encode_fetched_record(
+      pandaproxy::fetch_format::binary,
+      ppj::serialization_format::none,
+      ppj::fetched_record{
+        .topic = topic,
+        .partition = model::partition_id{1},
+        .offset = model::offset{3},
+        .record = record});
+
+    iobuf_parser p(std::move(buf));
+    BOOST_REQUIRE_EQUAL(ss::be_to_cpu(p.consume_type<int64_t>()), 3);
+    BOOST_REQUIRE_EQUAL(ss::be_to_cpu(p.consume_type<int32_t>()), 8);
+    const auto key = p.read_string(8);
+    BOOST_REQUIRE(
+      std::all_of(key.begin(), key.end(), [](char c) { return c == 0; }));
+    BOOST_REQUIRE_EQUAL(
+      ss::be_to_cpu(p.consume_type<int32_t>()),
+      value_size < 0 ? -1 : value_size);
+    BOOST_REQUIRE_EQUAL(p.bytes_left(), size_t(std::max(value_size, 0)));
+}
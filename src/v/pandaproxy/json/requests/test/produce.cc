@@ -17,6 +17,9 @@
 
 #include <seastar/testing/thread_test_case.hh>
 
+#include <rapidjson/reader.h>
+#include <rapidjson/stream.h>
+
 namespace ppj = pandaproxy::json;
 
 auto make_binary_v2_handler() {
@@ -45,12 +48,28 @@ SEASTAR_THREAD_TEST_CASE(test_produce_request) {
     auto parser = iobuf_parser(std::move(*records[0].value));
     auto value = parser.read_string(parser.bytes_left());
     BOOST_TEST(value == "vectorized");
-    BOOST_TEST(records[0].id == model::partition_id(0));
+    BOOST_TEST(records[0].id.value() == model::partition_id(0));
 
     parser = iobuf_parser(std::move(*records[1].value));
     value = parser.read_string(parser.bytes_left());
     BOOST_TEST(value == "pandaproxy");
-    BOOST_TEST(records[1].id == model::partition_id(1));
+    BOOST_TEST(records[1].id.value() == model::partition_id(1));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_produce_request_no_partition) {
+    auto input = R"(
+      {
+        "records": [
+          {
+            "value": "dmVjdG9yaXplZA=="
+          }
+        ]
+      })";
+
+    auto records = ppj::rjson_parse(input, make_binary_v2_handler());
+    BOOST_REQUIRE_EQUAL(records.size(), 1);
+    BOOST_TEST(!records[0].id);
+    BOOST_TEST(!!records[0].value);
 }
 
 SEASTAR_THREAD_TEST_CASE(test_produce_request_empty) {
@@ -220,3 +239,27 @@ SEASTAR_THREAD_TEST_CASE(test_produce_response) {
 
     BOOST_TEST(output == expected);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_produce_request_complete_records) {
+    auto input = R"({"records":[{"value":"dmVjdG9yaXplZA==","partition":0}]})";
+    auto handler = make_binary_v2_handler();
+    rapidjson::Reader reader;
+    rapidjson::StringStream ss(input);
+    reader.IterativeParseInit();
+
+    // a record being parsed is not complete
+    while (handler.result.empty()) {
+        BOOST_REQUIRE(
+          reader.IterativeParseNext<rapidjson::kParseDefaultFlags>(
+            ss, handler));
+    }
+    BOOST_REQUIRE_EQUAL(handler.complete_records(), 0);
+
+    while (!reader.IterativeParseComplete()) {
+        BOOST_REQUIRE(
+          reader.IterativeParseNext<rapidjson::kParseDefaultFlags>(
+            ss, handler));
+    }
+    BOOST_REQUIRE_EQUAL(handler.complete_records(), 1);
+    BOOST_REQUIRE(handler.result[0].id == model::partition_id(0));
+}
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include "bytes/iobuf.h"
+#include "json/iobuf_stream.h"
 #include "json/json.h"
 #include "pandaproxy/json/types.h"
 #include "utils/concepts-enabled.h"
@@ -58,8 +60,8 @@ struct rjson_serialize_fmt_impl {
         rjson_serialize_impl<std::remove_reference_t<T>>{fmt}(
           std::forward<T>(t));
     }
-    template<typename T>
-    void operator()(rapidjson::Writer<rapidjson::StringBuffer>& w, T&& t) {
+    template<typename Buffer, typename T>
+    void operator()(rapidjson::Writer<Buffer>& w, T&& t) {
         rjson_serialize_impl<std::remove_reference_t<T>>{fmt}(
           w, std::forward<T>(t));
     }
@@ -69,6 +71,16 @@ inline rjson_serialize_fmt_impl rjson_serialize_fmt(serialization_format fmt) {
     return rjson_serialize_fmt_impl{fmt};
 }
 
+/// \brief Serialize into the fragments of an iobuf, for responses too big to
+/// be held in one buffer.
+template<typename T>
+iobuf rjson_serialize_iobuf(T&& v, serialization_format fmt) {
+    ::json::iobuf_ostream os;
+    ::json::iobuf_writer wrt(os);
+    rjson_serialize_fmt(fmt)(wrt, std::forward<T>(v));
+    return os.release();
+}
+
 template<typename Handler>
 CONCEPT(requires std::is_same_v<
         decltype(std::declval<Handler>().result),
@@ -83,4 +95,19 @@ typename Handler::rjson_parse_result
     return std::move(handler.result);
 }
 
+/// \brief Parse a fragmented iobuf in place.
+template<typename Handler>
+CONCEPT(requires std::is_same_v<
+        decltype(std::declval<Handler>().result),
+        typename Handler::rjson_parse_result>)
+typename Handler::rjson_parse_result
+  rjson_parse(const iobuf& buf, Handler&& handler) {
+    rapidjson::Reader reader;
+    ::json::iobuf_istream is(buf);
+    if (!reader.Parse(is, handler)) {
+        throw parse_error(reader.GetErrorOffset());
+    }
+    return std::move(handler.result);
+}
+
 } // namespace pandaproxy::json
@@ -17,6 +17,7 @@ namespace pandaproxy {
 
 probe::probe(ss::httpd::path_description& path_desc)
   : _request_hist()
+  , _request_size_hist()
   , _metrics() {
     namespace sm = ss::metrics;
     std::vector<sm::label_instance> labels{
@@ -24,10 +25,15 @@ probe::probe(ss::httpd::path_description& path_desc)
     _metrics.add_group(
       "pandaproxy",
       {sm::make_histogram(
-        "request_latency",
-        sm::description("Request latency"),
-        std::move(labels),
-        [this] { return _request_hist.seastar_histogram_logform(); })});
+         "request_latency",
+         sm::description("Request latency"),
+         labels,
+         [this] { return _request_hist.seastar_histogram_logform(); }),
+       sm::make_histogram(
+         "request_size_bytes",
+         sm::description("Request size in bytes, records produced included"),
+         labels,
+         [this] { return _request_size_hist.seastar_histogram_logform(); })});
 }
 
 } // namespace pandaproxy
\ No newline at end of file
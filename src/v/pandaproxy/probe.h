@@ -22,9 +22,12 @@ class probe {
 public:
     probe(ss::httpd::path_description& path_desc);
     hdr_hist& hist() { return _request_hist; }
+    /// Bytes of the requests, as charged to the memory semaphore
+    hdr_hist& size_hist() { return _request_size_hist; }
 
 private:
     hdr_hist _request_hist;
+    hdr_hist _request_size_hist;
     ss::metrics::metric_groups _metrics;
 };
 
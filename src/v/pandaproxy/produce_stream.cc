@@ -0,0 +1,147 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/produce_stream.h"
+
+#include "pandaproxy/json/rjson_util.h"
+#include "pandaproxy/logger.h"
+#include "raft/types.h"
+#include "vlog.h"
+
+#include <seastar/core/loop.hh>
+
+namespace pandaproxy {
+
+produce_stream::produce_stream(
+  client::client& client,
+  model::topic topic,
+  json::serialization_format fmt,
+  const char* body,
+  size_t chunk_bytes)
+  : _client(client)
+  , _topic(std::move(topic))
+  , _chunk_bytes(chunk_bytes)
+  , _stream(body)
+  , _handler(fmt) {}
+
+ss::future<std::vector<kafka::produce_response::partition>>
+produce_stream::run() {
+    _reader.IterativeParseInit();
+    return ss::repeat([this] { return parse(); })
+      .then_wrapped([this](ss::future<> f) {
+          if (!f.failed()) {
+              return finish();
+          }
+          // the batches in flight refer to this stream
+          auto e = f.get_exception();
+          return ss::parallel_for_each(
+                   _partitions,
+                   [](auto& p) {
+                       return std::exchange(p.second.inflight, ss::now())
+                         .handle_exception([](const std::exception_ptr&) {});
+                   })
+            .then([e] { return ss::make_exception_future<>(e); });
+      })
+      .then([this] {
+          std::vector<kafka::produce_response::partition> ret;
+          ret.reserve(_partitions.size());
+          for (auto& [_, p] : _partitions) {
+              if (p.response) {
+                  ret.push_back(std::move(*p.response));
+              }
+          }
+          return ret;
+      });
+}
+
+ss::future<ss::stop_iteration> produce_stream::parse() {
+    while (!_reader.IterativeParseComplete()) {
+        if (!_reader.IterativeParseNext<rapidjson::kParseDefaultFlags>(
+              _stream, _handler)) {
+            return ss::make_exception_future<ss::stop_iteration>(
+              json::parse_error(_reader.GetErrorOffset()));
+        }
+        if (auto full = drain(); full) {
+            return flush(*full, _partitions[*full]).then([] {
+                return ss::stop_iteration::no;
+            });
+        }
+    }
+    return ss::make_ready_future<ss::stop_iteration>(ss::stop_iteration::yes);
+}
+
+std::optional<model::partition_id> produce_stream::drain() {
+    auto& records = _handler.result;
+    const auto complete = _handler.complete_records();
+    std::optional<model::partition_id> full;
+    for (size_t i = 0; i < complete; ++i) {
+        auto& r = records[i];
+        // a topic unknown to the client goes to partition 0, the error of
+        // its response refreshes the metadata
+        const auto id = r.id ? *r.id
+                             : _client.partition_for(_topic, r.key)
+                                 .value_or(model::partition_id(0));
+        auto& p = _partitions[id];
+        if (!p.builder) {
+            p.builder.emplace(raft::data_batch_type, model::offset(0));
+        }
+        auto key = std::move(r.key).value_or(iobuf{});
+        auto value = std::move(r.value).value_or(iobuf{});
+        p.bytes += key.size_bytes() + value.size_bytes();
+        p.builder->add_raw_kv(std::move(key), std::move(value));
+        if (p.bytes >= _chunk_bytes) {
+            full = id;
+        }
+    }
+    records.erase(records.begin(), records.begin() + complete);
+    return full;
+}
+
+ss::future<>
+produce_stream::flush(model::partition_id id, partition_state& p) {
+    auto batch = std::move(*p.builder).build();
+    p.builder.reset();
+    p.bytes = 0;
+    vlog(
+      plog.debug,
+      "Producing {} streamed records to {}/{}",
+      batch.record_count(),
+      _topic,
+      id);
+    return std::exchange(p.inflight, ss::now())
+      .then([this, id, &p, batch = std::move(batch)]() mutable {
+          p.inflight = _client
+                         .produce_record_batch(
+                           model::topic_partition(_topic, id), std::move(batch))
+                         .then([&p](kafka::produce_response::partition r) {
+                             if (!p.response) {
+                                 p.response = std::move(r);
+                             } else if (
+                               p.response->error == kafka::error_code::none) {
+                                 p.response->error = r.error;
+                             }
+                         });
+      });
+}
+
+ss::future<> produce_stream::finish() {
+    return ss::do_for_each(
+             _partitions,
+             [this](auto& e) {
+                 return e.second.builder ? flush(e.first, e.second)
+                                         : ss::now();
+             })
+      .then([this] {
+          return ss::parallel_for_each(_partitions, [](auto& e) {
+              return std::exchange(e.second.inflight, ss::now());
+          });
+      });
+}
+
+} // namespace pandaproxy
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "kafka/requests/produce_request.h"
+#include "model/fundamental.h"
+#include "pandaproxy/client/client.h"
+#include "pandaproxy/json/requests/produce.h"
+#include "pandaproxy/json/types.h"
+#include "seastarx.h"
+#include "storage/record_batch_builder.h"
+
+#include <seastar/core/future.hh>
+
+#include <absl/container/node_hash_map.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/stream.h>
+
+#include <optional>
+#include <vector>
+
+namespace pandaproxy {
+
+/**
+ * Produces the records of a produce request body while it is parsed.
+ *
+ * The body is parsed one token at a time, every complete record is added to
+ * the batch of its partition. A batch holding `chunk_bytes` of keys and
+ * values is handed to the client right away, its produce_batcher appends it
+ * while the rest of the body is parsed. A partition has one batch in flight
+ * at most, the parsing waits for it before sending the next one, so the
+ * memory used by a request is bounded by its partitions and not by its
+ * records. The response of a partition has the offset of its first batch
+ * and the first error of its batches.
+ */
+class produce_stream {
+public:
+    produce_stream(
+      client::client&,
+      model::topic,
+      json::serialization_format,
+      const char* body,
+      size_t chunk_bytes);
+
+    /// The stream has to be kept alive until the returned future resolves
+    ss::future<std::vector<kafka::produce_response::partition>> run();
+
+private:
+    struct partition_state {
+        std::optional<storage::record_batch_builder> builder;
+        size_t bytes{0};
+        ss::future<> inflight = ss::now();
+        std::optional<kafka::produce_response::partition> response;
+    };
+
+    ss::future<ss::stop_iteration> parse();
+    std::optional<model::partition_id> drain();
+    ss::future<> flush(model::partition_id, partition_state&);
+    ss::future<> finish();
+
+    client::client& _client;
+    model::topic _topic;
+    size_t _chunk_bytes;
+    rapidjson::Reader _reader;
+    rapidjson::StringStream _stream;
+    json::produce_request_handler<> _handler;
+    // stable references, the batches in flight update their partition
+    absl::node_hash_map<model::partition_id, partition_state> _partitions;
+};
+
+} // namespace pandaproxy
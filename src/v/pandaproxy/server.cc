@@ -71,6 +71,7 @@ struct handler_adaptor : ss::httpd::handler_base {
               server::request_t rq{std::move(req), this->_ctx};
               server::reply_t rp{std::move(rep)};
               auto req_size = get_request_size(*rq.req);
+              _probe.size_hist().record(req_size);
 
               return ss::with_semaphore(
                        _ctx.mem_sem,
@@ -20,8 +20,39 @@
 #include <absl/container/btree_map.h>
 #include <boost/range/irange.hpp>
 
+#include <array>
+#include <utility>
+#include <vector>
+
 namespace raft {
 
+namespace {
+enum class delta_type : int8_t {
+    add = 0,
+    truncate = 1,
+    prefix_truncate = 2,
+};
+
+template<typename Offsets>
+iobuf make_add_delta(
+  const absl::btree_map<model::offset, group_configuration>& cfgs,
+  const Offsets& offsets) {
+    iobuf buf;
+    reflection::serialize(buf, delta_type::add);
+    reflection::adl<uint64_t>{}.to(buf, offsets.size());
+    for (auto o : offsets) {
+        reflection::serialize(buf, o, cfgs.at(o));
+    }
+    return buf;
+}
+
+iobuf make_truncate_delta(delta_type type, model::offset offset) {
+    iobuf buf;
+    reflection::serialize(buf, type, offset);
+    return buf;
+}
+} // namespace
+
 configuration_manager::configuration_manager(
   group_configuration initial_cfg,
   raft::group_id group,
@@ -48,8 +79,10 @@ ss::future<> configuration_manager::truncate(model::offset offset) {
         _configurations.erase(it, _configurations.end());
 
         _highest_known_offset = std::min(offset, _highest_known_offset);
-        return store_highest_known_offset().then(
-          [this] { return store_configurations(); });
+        return store_highest_known_offset().then([this, offset] {
+            return store_delta(
+              make_truncate_delta(delta_type::truncate, offset));
+        });
     });
 }
 
@@ -68,8 +101,10 @@ ss::future<> configuration_manager::prefix_truncate(model::offset offset) {
         }
         _configurations.erase(_configurations.begin(), it);
         _highest_known_offset = std::max(offset, _highest_known_offset);
-        return store_highest_known_offset().then(
-          [this] { return store_configurations(); });
+        return store_highest_known_offset().then([this, offset] {
+            return store_delta(
+              make_truncate_delta(delta_type::prefix_truncate, offset));
+        });
     });
 }
 
@@ -88,6 +123,8 @@ ss::future<>
 configuration_manager::add(std::vector<offset_configuration> configurations) {
     return _lock.with([this,
                        configurations = std::move(configurations)]() mutable {
+        std::vector<model::offset> offsets;
+        offsets.reserve(configurations.size());
         for (auto& co : configurations) {
             vlog(
               _ctxlog.trace,
@@ -95,11 +132,12 @@ configuration_manager::add(std::vector<offset_configuration> configurations) {
               co.cfg,
               co.offset);
             add_configuration(co.offset, std::move(co.cfg));
+            offsets.push_back(co.offset);
             _highest_known_offset = std::max(_highest_known_offset, co.offset);
         }
         _config_changed.broadcast();
-        return store_configurations().then(
-          [this] { return store_highest_known_offset(); });
+        return store_delta(make_add_delta(_configurations, offsets))
+          .then([this] { return store_highest_known_offset(); });
     });
 }
 
@@ -117,8 +155,8 @@ configuration_manager::add(model::offset offset, group_configuration cfg) {
         add_configuration(offset, std::move(cfg));
         _highest_known_offset = std::max(offset, _highest_known_offset);
         _config_changed.broadcast();
-        return store_configurations().then(
-          [this] { return store_highest_known_offset(); });
+        return store_delta(make_add_delta(_configurations, std::array{offset}))
+          .then([this] { return store_highest_known_offset(); });
     });
 }
 
@@ -196,27 +234,98 @@ deserialize_configurations(iobuf&& buf) {
 }
 
 bytes configuration_manager::configurations_map_key() {
-    iobuf buf;
-    reflection::serialize(buf, metadata_key::config_map, _group);
-    return iobuf_to_bytes(buf);
+    return details::serialize_group_key(_group, metadata_key::config_map);
 }
 
 bytes configuration_manager::highest_known_offset_key() {
-    iobuf buf;
-    reflection::serialize(
-      buf, metadata_key::config_latest_known_offset, _group);
-    return iobuf_to_bytes(buf);
+    return details::serialize_group_key(
+      _group, metadata_key::config_latest_known_offset);
+}
+
+bytes configuration_manager::delta_key(size_t slot) {
+    return details::configuration_delta_key(_group, slot);
 }
 
 ss::future<> configuration_manager::store_configurations() {
     return serialize_configurations(_configurations).then([this](iobuf buf) {
-        return _storage.kvs().put(
-          storage::kvstore::key_space::consensus,
-          configurations_map_key(),
-          std::move(buf));
+        return _storage.kvs()
+          .put(
+            storage::kvstore::key_space::consensus,
+            configurations_map_key(),
+            std::move(buf))
+          .then([this] {
+              _map_stored = true;
+              return remove_deltas(std::exchange(_deltas, 0));
+          });
     });
 }
 
+ss::future<> configuration_manager::store_delta(iobuf delta) {
+    if (!_map_stored || _deltas == max_deltas) {
+        return store_configurations();
+    }
+    return _storage.kvs().put(
+      storage::kvstore::key_space::consensus,
+      delta_key(_deltas++),
+      std::move(delta));
+}
+
+ss::future<> configuration_manager::remove_deltas(size_t count) {
+    // the newest first, when interrupted the deltas left behind are a prefix
+    // of the ones already included in the map so replaying them again on top
+    // of it yields the same configurations
+    auto slots = boost::irange<size_t>(0, count);
+    return ss::do_for_each(
+      slots.begin(), slots.end(), [this, count](size_t i) {
+          return _storage.kvs().remove(
+            storage::kvstore::key_space::consensus, delta_key(count - i - 1));
+      });
+}
+
+void configuration_manager::replay_deltas() {
+    while (_deltas < max_deltas) {
+        auto buf = _storage.kvs().get(
+          storage::kvstore::key_space::consensus, delta_key(_deltas));
+        if (!buf) {
+            break;
+        }
+        apply_delta(std::move(*buf));
+        ++_deltas;
+    }
+}
+
+void configuration_manager::apply_delta(iobuf buf) {
+    iobuf_parser parser(std::move(buf));
+    const auto type = reflection::adl<delta_type>{}.from(parser);
+    switch (type) {
+    case delta_type::add: {
+        const auto size = reflection::adl<uint64_t>{}.from(parser);
+        for (uint64_t i = 0; i < size; ++i) {
+            auto offset = reflection::adl<model::offset>{}.from(parser);
+            auto cfg = reflection::adl<group_configuration>{}.from(parser);
+            _configurations.insert_or_assign(offset, std::move(cfg));
+        }
+        return;
+    }
+    case delta_type::truncate: {
+        const auto offset = reflection::adl<model::offset>{}.from(parser);
+        _configurations.erase(
+          _configurations.lower_bound(offset), _configurations.end());
+        return;
+    }
+    case delta_type::prefix_truncate: {
+        const auto offset = reflection::adl<model::offset>{}.from(parser);
+        _configurations.erase(
+          _configurations.begin(), _configurations.lower_bound(offset));
+        return;
+    }
+    }
+    vassert(
+      false,
+      "unknown configuration delta type {}",
+      static_cast<int>(type));
+}
+
 ss::future<> configuration_manager::store_highest_known_offset() {
     return _storage.kvs().put(
       storage::kvstore::key_space::consensus,
@@ -239,12 +348,15 @@ ss::future<> configuration_manager::start() {
             f = deserialize_configurations(std::move(*map_buf))
                   .then([this](underlying_t cfgs) {
                       _configurations = std::move(cfgs);
-                      if (!_configurations.empty()) {
-                          _highest_known_offset
-                            = _configurations.rbegin()->first;
-                      }
+                      _map_stored = true;
                   });
         }
+        f = f.then([this] {
+            replay_deltas();
+            if (_map_stored && !_configurations.empty()) {
+                _highest_known_offset = _configurations.rbegin()->first;
+            }
+        });
 
         auto offset_buf = _storage.kvs().get(
           storage::kvstore::key_space::consensus, highest_known_offset_key());
@@ -307,8 +419,14 @@ ss::future<offset_configuration> configuration_manager::wait_for_change(
 }
 
 ss::future<> configuration_manager::remove_persistent_state() {
-    return _storage.kvs()
-      .remove(storage::kvstore::key_space::consensus, configurations_map_key())
+    // deltas go first, they are never left behind without the map
+    return remove_deltas(max_deltas)
+      .then([this] {
+          _deltas = 0;
+          _map_stored = false;
+          return _storage.kvs().remove(
+            storage::kvstore::key_space::consensus, configurations_map_key());
+      })
       .then([this] {
           return _storage.kvs().remove(
             storage::kvstore::key_space::consensus, highest_known_offset_key());
@@ -43,10 +43,20 @@ namespace raft {
  * The highest known offset is not group_configuration offset, it is an offset
  * up to which all configuration are guranted to be present in configuration
  * manager.
+ *
+ * Every change is persisted as a small delta record describing it, the whole
+ * configurations map is written only once per `max_deltas` changes. Starting
+ * group reads the map and replays the deltas on top of it.
  */
 class configuration_manager {
 public:
     static constexpr size_t offset_update_treshold = 64_MiB;
+    /**
+     * Number of changes stored as deltas before the whole map is written
+     * again. Delta keys are reused after each write of the map so their set
+     * is bounded.
+     */
+    static constexpr size_t max_deltas = 32;
 
     configuration_manager(
       group_configuration, raft::group_id, storage::api&, ctx_log&);
@@ -139,9 +149,14 @@ private:
     using underlying_t = absl::btree_map<model::offset, group_configuration>;
 
     ss::future<> store_configurations();
+    ss::future<> store_delta(iobuf);
+    ss::future<> remove_deltas(size_t);
+    void replay_deltas();
+    void apply_delta(iobuf);
     ss::future<> store_highest_known_offset();
     bytes configurations_map_key();
     bytes highest_known_offset_key();
+    bytes delta_key(size_t);
 
     void add_configuration(model::offset, group_configuration);
 
@@ -161,6 +176,12 @@ private:
      * bootstrap redpanda will have to read up to 64MB per raft group.
      */
     size_t _bytes_since_last_offset_update = 0;
+    /**
+     * Deltas stored since the map was last written, they occupy the delta
+     * keys [0, _deltas). Deltas are only written on top of a stored map.
+     */
+    size_t _deltas = 0;
+    bool _map_stored = false;
     ctx_log& _ctxlog;
 };
 } // namespace raft
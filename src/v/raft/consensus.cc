@@ -16,6 +16,7 @@
 #include "raft/consensus_client_protocol.h"
 #include "raft/consensus_utils.h"
 #include "raft/errc.h"
+#include "raft/follower_lag_probe.h"
 #include "raft/logger.h"
 #include "raft/prevote_stm.h"
 #include "raft/recovery_stm.h"
@@ -23,6 +24,7 @@
 #include "raft/types.h"
 #include "raft/vote_stm.h"
 #include "reflection/adl.h"
+#include "resource_mgmt/io_priority.h"
 #include "utils/state_crc_file.h"
 #include "utils/state_crc_file_errc.h"
 #include "vlog.h"
@@ -32,9 +34,18 @@
 
 #include <fmt/ostream.h>
 
+#include <cmath>
 #include <iterator>
 
 namespace raft {
+static std::optional<write_behind_buffer::clock_type::duration>
+write_behind_lag(const storage::ntp_config& cfg) {
+    if (!cfg.has_overrides() || !cfg.get_overrides().write_behind) {
+        return std::nullopt;
+    }
+    return *cfg.get_overrides().write_behind;
+}
+
 consensus::consensus(
   model::node_id nid,
   group_id group,
@@ -45,7 +56,9 @@ consensus::consensus(
   model::timeout_clock::duration disk_timeout,
   consensus_client_protocol client,
   consensus::leader_cb_t cb,
-  storage::api& storage)
+  storage::api& storage,
+  recovery_scheduler* recovery_scheduler,
+  follower_lag_probe* lag_probe)
   : _self(std::move(nid))
   , _group(group)
   , _jit(std::move(jit))
@@ -63,9 +76,16 @@ consensus::consensus(
   , _recovery_append_timeout(
       config::shard_local_cfg().recovery_append_timeout_ms())
   , _storage(storage)
+  , _recovery_scheduler(recovery_scheduler)
+  , _lag_probe(lag_probe)
   , _snapshot_mgr(
       std::filesystem::path(_log.config().work_directory()), _io_priority)
-  , _configuration_manager(std::move(initial_cfg), _group, _storage, _ctxlog) {
+  , _configuration_manager(std::move(initial_cfg), _group, _storage, _ctxlog)
+  , _replication_window(
+      config::shard_local_cfg().raft_replication_window_bytes())
+  , _write_behind(
+      config::shard_local_cfg().raft_write_behind_max_bytes(),
+      write_behind_lag(_log.config())) {
     setup_metrics();
     update_follower_stats(_configuration_manager.get_latest());
     _vote_timeout.set_callback([this] {
@@ -80,6 +100,7 @@ void consensus::setup_metrics() {
     }
 
     _probe.setup_metrics(_log.config().ntp());
+    _produce_latency.setup_metrics(_log.config().ntp());
     auto labels = probe::create_metric_labels(_log.config().ntp());
     namespace sm = ss::metrics;
 
@@ -89,12 +110,53 @@ void consensus::setup_metrics() {
         "leader_for",
         [this] { return is_leader(); },
         sm::description("Number of groups for which node is a leader"),
-        labels)});
+        labels),
+       sm::make_derive(
+         "replication_window_hits",
+         [this] { return _replication_window.get_stats().hits; },
+         sm::description(
+           "Number of follower recovery reads served from memory"),
+         labels),
+       sm::make_derive(
+         "replication_window_misses",
+         [this] { return _replication_window.get_stats().misses; },
+         sm::description("Number of follower recovery reads from the log"),
+         labels)});
+    if (!_write_behind.enabled()) {
+        return;
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("raft"),
+      {sm::make_gauge(
+         "write_behind_lag_bytes",
+         [this] { return _write_behind.lag_bytes(); },
+         sm::description("Bytes of acknowledged writes not yet in the log"),
+         labels),
+       sm::make_gauge(
+         "write_behind_lag_ms",
+         [this] {
+             return std::chrono::duration_cast<std::chrono::milliseconds>(
+                      _write_behind.lag())
+               .count();
+         },
+         sm::description("Time the oldest acknowledged write not yet in the "
+                         "log has waited"),
+         labels),
+       sm::make_derive(
+         "write_behind_dropped_batches",
+         [this] { return _write_behind.dropped(); },
+         sm::description("Number of acknowledged batches dropped as the "
+                         "leadership was lost before they were in the log"),
+         labels)});
 }
 
 void consensus::do_step_down() {
     _hbeat = clock_type::now();
     _vstate = vote_state::follower;
+    // the log may be truncated by the next leader
+    _replication_window.clear();
+    // reads waiting for the lease fail now
+    _lease_renewed.broadcast();
 }
 
 void consensus::maybe_step_down() {
@@ -127,6 +189,8 @@ ss::future<> consensus::stop() {
     _vote_timeout.cancel();
     _as.request_abort();
     _commit_index_updated.broken();
+    _lease_renewed.broken();
+    _write_behind.stop();
 
     return _event_manager.stop()
       .then([this] { return _bg.close(); })
@@ -212,6 +276,9 @@ consensus::success_reply consensus::update_follower_index(
     }
 
     update_node_hbeat_timestamp(node);
+    if (reply.term == _term) {
+        maybe_extend_lease(idx, seq);
+    }
 
     // If recovery is in progress the recovery STM will handle follower index
     // updates
@@ -273,6 +340,11 @@ void consensus::maybe_promote_to_voter(model::node_id id) {
         return _op_lock.get_units()
           .then([this, id](ss::semaphore_units<> u) mutable {
               auto latest_cfg = _configuration_manager.get_latest();
+              // every reply of a caught up learner requests its promotion
+              if (latest_cfg.is_voter(id)) {
+                  return ss::make_ready_future<std::error_code>(
+                    errc::success);
+              }
               latest_cfg.promote_to_voter(id);
 
               return replicate_configuration(
@@ -291,6 +363,12 @@ void consensus::process_append_entries_reply(
   follower_req_seq seq_id) {
     auto is_success = update_follower_index(node, std::move(r), seq_id);
     if (is_success) {
+        if (_lag_probe && _fstats.contains(node)) {
+            auto dirty = _log.offsets().dirty_offset;
+            auto match = _fstats.get(node).match_index;
+            _lag_probe->record(
+              node, dirty > match ? uint64_t((dirty - match)()) : 0);
+        }
         maybe_promote_to_voter(node);
         maybe_update_leader_commit_idx();
     }
@@ -334,8 +412,10 @@ void consensus::dispatch_recovery(follower_index_metadata& idx) {
     idx.is_recovering = true;
     // background
     (void)with_gate(_bg, [this, &idx] {
+        // recovery reads may stream a large part of the log, keep them off
+        // the priority class of the replication path
         auto recovery = std::make_unique<recovery_stm>(
-          this, idx.node_id, _io_priority);
+          this, idx.node_id, raft_recovery_priority());
         auto ptr = recovery.get();
         return ptr->apply()
           .handle_exception([this, &idx](const std::exception_ptr& e) {
@@ -369,6 +449,11 @@ consensus::replicate(model::record_batch_reader&& rdr, replicate_options opts) {
     } else {
         _probe.replicate_requests_ack_none();
     }
+    if (_write_behind.enabled()) {
+        return replicate_write_behind(std::move(rdr)).finally([this] {
+            _probe.replicate_done();
+        });
+    }
     // For relaxed consistency, append data to leader disk without flush
     // asynchronous replication is provided by Raft protocol recovery mechanism.
     return _op_lock
@@ -378,9 +463,11 @@ consensus::replicate(model::record_batch_reader&& rdr, replicate_options opts) {
                 errc::not_leader);
           }
 
-          return disk_append(model::make_record_batch_reader<
-                               details::term_assigning_reader>(
-                               std::move(rdr), model::term_id(_term)))
+          // the appender sets the term with the offset of each batch
+          return disk_append(
+                   std::move(rdr),
+                   update_window::no,
+                   model::term_id(_term))
             .then([this](storage::append_result res) {
                 // update last_visible_index immediately after append succeed
                 maybe_update_last_visible_index(res.last_offset);
@@ -391,6 +478,114 @@ consensus::replicate(model::record_batch_reader&& rdr, replicate_options opts) {
       .finally([this] { _probe.replicate_done(); });
 }
 
+ss::future<result<replicate_result>>
+consensus::replicate_write_behind(model::record_batch_reader&& rdr) {
+    using ret_t = result<replicate_result>;
+    return model::consume_reader_to_memory(std::move(rdr), model::no_timeout)
+      .then([this](ss::circular_buffer<model::record_batch> batches) {
+          size_t bytes = 0;
+          for (const auto& b : batches) {
+              bytes += b.size_bytes();
+          }
+          return _write_behind.reserve(bytes).then(
+            [this, batches = std::move(batches)](
+              ss::semaphore_units<> units) mutable {
+                return _op_lock.with([this,
+                                      batches = std::move(batches),
+                                      units = std::move(units)]() mutable {
+                    if (!is_leader()) {
+                        return ret_t(errc::not_leader);
+                    }
+                    // the batches get these offsets when they are appended:
+                    // every other append of the leader drains the buffer
+                    // first
+                    auto next = _write_behind.next_offset(
+                      _log.offsets().dirty_offset);
+                    auto last = next;
+                    for (const auto& b : batches) {
+                        const auto delta = b.header().last_offset_delta;
+                        last = next + model::offset(delta);
+                        next = last + model::offset(1);
+                    }
+                    _write_behind.push(write_behind_buffer::entry{
+                      .term = _term,
+                      .last_offset = last,
+                      .batches = std::move(batches),
+                      .queued_at = write_behind_buffer::clock_type::now(),
+                      .units = std::move(units)});
+                    dispatch_write_behind();
+                    return ret_t(replicate_result{.last_offset = last});
+                });
+            });
+      });
+}
+
+void consensus::dispatch_write_behind() {
+    if (std::exchange(_write_behind_dispatched, true)) {
+        return;
+    }
+    (void)ss::with_gate(_bg, [this] {
+        return _op_lock.with([this] {
+            _write_behind_dispatched = false;
+            return flush_write_behind();
+        });
+    }).handle_exception([this](const std::exception_ptr& e) {
+        vlog(_ctxlog.warn, "Error appending write behind batches - {}", e);
+    });
+}
+
+ss::future<> consensus::flush_write_behind() {
+    if (_write_behind.empty()) {
+        return ss::now();
+    }
+    auto entries = _write_behind.take();
+    ss::circular_buffer<model::record_batch> batches;
+    model::offset expected;
+    size_t dropped = 0;
+    for (auto& e : entries) {
+        // acknowledged by a leadership of an earlier term, the log of the
+        // current leader decides what follows
+        if (!is_leader() || e.term != _term) {
+            dropped += e.batches.size();
+            continue;
+        }
+        expected = e.last_offset;
+        for (auto& b : e.batches) {
+            b.set_term(e.term);
+            batches.push_back(std::move(b));
+        }
+    }
+    if (dropped > 0) {
+        _write_behind.record_dropped(dropped);
+        vlog(_ctxlog.warn, "Dropped {} write behind batches", dropped);
+    }
+    if (batches.empty()) {
+        _write_behind.drained();
+        return ss::now();
+    }
+    return disk_append(
+             model::make_memory_record_batch_reader(std::move(batches)))
+      .then([this, expected](storage::append_result res) {
+          vassert(
+            res.last_offset == expected,
+            "write behind batches appended up to {}, acknowledged up to {}",
+            res.last_offset,
+            expected);
+          maybe_update_last_visible_index(res.last_offset);
+      })
+      .finally([this, entries = std::move(entries)] {
+          // the units of the entries are released with them
+          _write_behind.drained();
+      });
+}
+
+ss::future<ss::semaphore_units<>> consensus::get_append_units() {
+    return _op_lock.get_units().then([this](ss::semaphore_units<> u) {
+        return flush_write_behind().then(
+          [u = std::move(u)]() mutable { return std::move(u); });
+    });
+}
+
 void consensus::dispatch_flush_with_lock() {
     if (!_has_pending_flushes) {
         return;
@@ -440,6 +635,7 @@ bool consensus::should_skip_vote(bool ignore_heartbeat) {
     }
 
     skip_vote |= _vstate == vote_state::leader; // already a leader
+    skip_vote |= _leadership_declined;
     skip_vote |= !_configuration_manager.get_latest().is_voter(
       _self); // not a voter
 
@@ -529,8 +725,38 @@ void consensus::dispatch_vote(bool leadership_transfer) {
     });
 }
 void consensus::arm_vote_timeout() {
-    if (!_bg.is_closed()) {
-        _vote_timeout.rearm(_jit());
+    if (_bg.is_closed()) {
+        return;
+    }
+    // when a leader fails, the groups that took appends since the last
+    // timeout elect first, each order of magnitude of appended records
+    // narrows the jitter window. every group still elects within
+    // base + jitter of losing its leader
+    const auto dirty = _log.offsets().dirty_offset;
+    uint64_t appended = 0;
+    if (dirty > _vote_timeout_dirty_offset) {
+        appended = dirty() - _vote_timeout_dirty_offset();
+    }
+    _vote_timeout_dirty_offset = dirty;
+    const auto divisor = 1 + static_cast<uint64_t>(std::log10(1.0 + appended));
+    _vote_timeout.rearm(
+      clock_type::now() + _jit.base_duration()
+      + _jit.next_jitter_duration(divisor));
+}
+
+duration_type consensus::min_election_timeout() const {
+    const auto& cfg = config::shard_local_cfg();
+    if (!cfg.raft_adaptive_election_timeout()) {
+        return _jit.base_duration();
+    }
+    // voters without round trip samples use the static timeout
+    return std::min<duration_type>(
+      cfg.raft_election_timeout_ms(), cfg.raft_election_timeout_floor_ms());
+}
+
+void consensus::set_election_timeout(duration_type timeout) {
+    if (timeout != _jit.base_duration()) {
+        _jit.reset(timeout, timeout / 2);
     }
 }
 
@@ -717,23 +943,24 @@ ss::future<> consensus::start() {
 }
 
 bytes consensus::voted_for_key() const {
-    iobuf buf;
-    reflection::serialize(buf, metadata_key::voted_for, _group);
-    return iobuf_to_bytes(buf);
+    return details::serialize_group_key(_group, metadata_key::voted_for);
 }
 
 ss::future<>
 consensus::write_voted_for(consensus::voted_for_configuration config) {
     auto key = voted_for_key();
     iobuf val = reflection::to_iobuf(config);
+    // elections wait for the vote to be persisted
     return _storage.kvs().put(
-      storage::kvstore::key_space::consensus, std::move(key), std::move(val));
+      storage::kvstore::key_space::consensus,
+      std::move(key),
+      std::move(val),
+      storage::kvstore::urgent::yes);
 }
 
 bytes consensus::last_applied_key() const {
-    iobuf buf;
-    reflection::serialize(buf, metadata_key::last_applied_offset, _group);
-    return iobuf_to_bytes(buf);
+    return details::serialize_group_key(
+      _group, metadata_key::last_applied_offset);
 }
 
 ss::future<> consensus::write_last_applied(model::offset o) {
@@ -1191,7 +1418,9 @@ consensus::do_install_snapshot(install_snapshot_request&& r) {
     vlog(_ctxlog.trace, "Install snapshot request: {}", r);
 
     install_snapshot_reply reply{
-      .term = _term, .bytes_stored = r.chunk.size_bytes(), .success = false};
+      .term = _term,
+      .bytes_stored = _received_snapshot_bytes,
+      .success = false};
 
     bool is_done = r.done;
     // Raft paper: Reply immediately if term < currentTerm (§7.1)
@@ -1213,6 +1442,7 @@ consensus::do_install_snapshot(install_snapshot_request&& r) {
     auto f = ss::now();
     // Create new snapshot file if first chunk (offset is 0) (§7.2)
     if (r.file_offset == 0) {
+        _received_snapshot_bytes = 0;
         // discard old chunks, previous snaphost wasn't finished
         if (_snapshot_writer) {
             f = _snapshot_writer->close().then(
@@ -1226,6 +1456,19 @@ consensus::do_install_snapshot(install_snapshot_request&& r) {
         });
     }
 
+    // the leader pipelines chunks, one that does not continue the snapshot
+    // received so far is rejected. the leader starts over from offset 0
+    if (r.file_offset != _received_snapshot_bytes) {
+        vlog(
+          _ctxlog.warn,
+          "Snapshot chunk at offset {} does not follow the {} bytes received",
+          r.file_offset,
+          _received_snapshot_bytes);
+        return ss::make_ready_future<install_snapshot_reply>(reply);
+    }
+    _received_snapshot_bytes += r.chunk.size_bytes();
+    reply.bytes_stored = _received_snapshot_bytes;
+
     // Write data into snapshot file at given offset (§7.3)
     f = f.then([this, chunk = std::move(r.chunk)]() mutable {
         return write_iobuf_to_output_stream(
@@ -1266,6 +1509,7 @@ ss::future<install_snapshot_reply> consensus::finish_snapshot(
           .then([this] { return _snapshot_mgr.remove_partial_snapshots(); })
           .then([this, reply]() mutable {
               _snapshot_writer.reset();
+              _received_snapshot_bytes = 0;
               reply.bytes_stored = 0;
               reply.success = false;
               return reply;
@@ -1278,6 +1522,7 @@ ss::future<install_snapshot_reply> consensus::finish_snapshot(
       })
       .then([this, reply]() mutable {
           _snapshot_writer.reset();
+          _received_snapshot_bytes = 0;
           return hydrate_snapshot().then([reply]() mutable {
               reply.success = true;
               return reply;
@@ -1366,23 +1611,27 @@ ss::future<std::error_code> consensus::replicate_configuration(
     vlog(_ctxlog.debug, "Replicating group configuration {}", cfg);
     return ss::with_gate(
       _bg, [this, u = std::move(u), cfg = std::move(cfg)]() mutable {
-          auto batches = details::serialize_configuration_as_batches(
-            std::move(cfg));
-          for (auto& b : batches) {
-              b.set_term(model::term_id(_term));
-          }
-          auto seqs = next_followers_request_seq();
-          append_entries_request req(
-            _self,
-            meta(),
-            model::make_memory_record_batch_reader(std::move(batches)));
-          /**
-           * We use replicate_batcher::do_flush directly as we already hold the
-           * _op_lock mutex when replicating configuration
-           */
-          return _batcher
-            .do_flush({}, std::move(req), std::move(u), std::move(seqs))
-            .then([] { return std::error_code(errc::success); });
+          // the configuration follows the acknowledged writes
+          return flush_write_behind().then(
+            [this, u = std::move(u), cfg = std::move(cfg)]() mutable {
+                auto batches = details::serialize_configuration_as_batches(
+                  std::move(cfg));
+                for (auto& b : batches) {
+                    b.set_term(model::term_id(_term));
+                }
+                auto seqs = next_followers_request_seq();
+                append_entries_request req(
+                  _self,
+                  meta(),
+                  model::make_memory_record_batch_reader(std::move(batches)));
+                /**
+                 * We use replicate_batcher::do_flush directly as we already
+                 * hold the _op_lock mutex when replicating configuration
+                 */
+                return _batcher
+                  .do_flush({}, std::move(req), std::move(u), std::move(seqs))
+                  .then([] { return std::error_code(errc::success); });
+            });
       });
 }
 
@@ -1404,20 +1653,59 @@ ss::future<> consensus::flush_log() {
     return _log.flush().then([this] { _has_pending_flushes = false; });
 }
 
+/// appends to the log and shares the appended batches with the window
+class window_appender {
+public:
+    window_appender(storage::log_appender a, replication_window& w) noexcept
+      : _appender(std::move(a))
+      , _window(&w) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch& b) {
+        // offsets are assigned by the appender
+        return _appender(b).then([w = _window, &b](ss::stop_iteration s) {
+            w->append(b);
+            return s;
+        });
+    }
+
+    ss::future<storage::append_result> end_of_stream() {
+        return _appender.end_of_stream();
+    }
+
+private:
+    storage::log_appender _appender;
+    replication_window* _window;
+};
+
 ss::future<storage::append_result>
-consensus::disk_append(model::record_batch_reader&& reader) {
+consensus::disk_append(
+  model::record_batch_reader&& reader,
+  update_window window,
+  std::optional<model::term_id> term) {
     using ret_t = storage::append_result;
     auto cfg = storage::log_append_config{
       // no fsync explicit on a per write, we verify at the end to
       // batch fsync
       storage::log_append_config::fsync::no,
       _io_priority,
-      model::timeout_clock::now() + _disk_timeout};
-    return details::for_each_ref_extract_configuration(
-             _log.offsets().dirty_offset,
-             std::move(reader),
-             _log.make_appender(cfg),
-             cfg.timeout)
+      model::timeout_clock::now() + _disk_timeout,
+      // a follower rarely reads back what it replicates, do not let it push
+      // out the batches the partitions this node leads are served from
+      is_leader() ? storage::cache_priority::normal
+                  : storage::cache_priority::low,
+      term};
+    auto append = [this, &reader, &cfg](auto appender) {
+        return details::for_each_ref_extract_configuration(
+          _log.offsets().dirty_offset,
+          std::move(reader),
+          std::move(appender),
+          cfg.timeout);
+    };
+    auto f = window && _replication_window.max_bytes() > 0
+               ? append(
+                 window_appender(_log.make_appender(cfg), _replication_window))
+               : append(_log.make_appender(cfg));
+    return std::move(f)
       .then([this](std::tuple<ret_t, std::vector<offset_configuration>> t) {
           auto& [ret, configurations] = t;
           _has_pending_flushes = true;
@@ -1457,8 +1745,16 @@ clock_type::time_point consensus::last_append_timestamp(model::node_id id) {
     return _fstats.get(id).last_append_timestamp;
 }
 
-void consensus::update_node_append_timestamp(model::node_id id) {
-    _fstats.get(id).last_append_timestamp = clock_type::now();
+bool consensus::has_stale_commit_index(model::node_id id) const {
+    return _fstats.get(id).last_sent_commit_index < _commit_index;
+}
+
+void consensus::update_node_append_timestamp(
+  model::node_id id, model::offset sent_commit_index) {
+    auto& f = _fstats.get(id);
+    f.last_append_timestamp = clock_type::now();
+    f.last_sent_commit_index = std::max(
+      f.last_sent_commit_index, sent_commit_index);
     update_node_hbeat_timestamp(id);
 }
 
@@ -1467,7 +1763,83 @@ void consensus::update_node_hbeat_timestamp(model::node_id id) {
 }
 
 follower_req_seq consensus::next_follower_sequence(model::node_id id) {
-    return _fstats.get(id).last_sent_seq++;
+    auto& idx = _fstats.get(id);
+    auto seq = idx.last_sent_seq++;
+    if (!idx.lease_probe) {
+        idx.lease_probe.emplace(seq, clock_type::now());
+    }
+    return seq;
+}
+
+void consensus::maybe_extend_lease(
+  follower_index_metadata& idx, follower_req_seq seq) {
+    if (!idx.lease_probe || seq < idx.lease_probe->first) {
+        return;
+    }
+    idx.last_acked_request_sent = idx.lease_probe->second;
+    idx.lease_probe.reset();
+    _lease_renewed.broadcast();
+}
+
+bool consensus::has_leader_lease() const {
+    if (!is_leader() || _transferring_leadership) {
+        return false;
+    }
+    if (_log.get_term(_commit_index) != _term) {
+        return false;
+    }
+    const auto lease
+      = min_election_timeout()
+        - config::shard_local_cfg().raft_leader_lease_clock_drift_ms();
+    if (lease <= duration_type::zero()) {
+        return false;
+    }
+    const auto now = clock_type::now();
+    auto acked = config().quorum_match([this, now](model::node_id id) {
+        if (id == _self) {
+            return now;
+        }
+        if (!_fstats.contains(id)) {
+            return clock_type::time_point::min();
+        }
+        return _fstats.get(id).last_acked_request_sent;
+    });
+    // acknowledgements given to an earlier leadership of this node
+    if (acked < std::max(_became_leader_at, _lease_floor)) {
+        return false;
+    }
+    return now < acked + lease;
+}
+
+ss::future<result<model::offset>>
+consensus::linearizable_barrier(clock_type::time_point deadline) {
+    using ret_t = result<model::offset>;
+    if (has_leader_lease()) {
+        _probe.lease_read();
+        return ss::make_ready_future<ret_t>(_commit_index);
+    }
+    if (!is_leader()) {
+        return ss::make_ready_future<ret_t>(errc::not_leader);
+    }
+    _probe.lease_wait();
+    const auto now = clock_type::now();
+    const auto timeout = deadline > now ? deadline - now
+                                        : duration_type::zero();
+    return _lease_renewed
+      .wait(timeout, [this] { return !is_leader() || has_leader_lease(); })
+      .then_wrapped([this](ss::future<> f) {
+          try {
+              f.get();
+          } catch (const ss::condition_variable_timed_out&) {
+              return ret_t(errc::timeout);
+          } catch (const ss::broken_condition_variable&) {
+              return ret_t(errc::not_leader);
+          }
+          if (!has_leader_lease()) {
+              return ret_t(errc::not_leader);
+          }
+          return ret_t(_commit_index);
+      });
 }
 
 absl::flat_hash_map<model::node_id, follower_req_seq>
@@ -1505,10 +1877,17 @@ ss::future<> consensus::maybe_commit_configuration(ss::semaphore_units<> u) {
     }
 
     auto latest_cfg = _configuration_manager.get_latest();
-    // as a leader replicate new simple configuration
+    /*
+     * as a leader replicate new simple configuration. replicas added to the
+     * group join as learners, which replicate without being counted in the
+     * quorum. the old configuration is kept until all of them are promoted,
+     * so the replicas being replaced keep serving writes while the new ones
+     * catch up rather than the group running short of a replica
+     */
     if (
       latest_cfg.type() == configuration_type::joint
-      && !latest_cfg.current_config().voters.empty()) {
+      && !latest_cfg.current_config().voters.empty()
+      && latest_cfg.current_config().learners.empty()) {
         latest_cfg.discard_old_config();
         vlog(
           _ctxlog.trace,
@@ -1565,6 +1944,7 @@ consensus::do_maybe_update_leader_commit_idx(ss::semaphore_units<> u) {
           "Applying entries from {} to {}",
           range_start,
           _commit_index);
+        _commit_index_updated_at = produce_latency_probe::clock_type::now();
         _commit_index_updated.broadcast();
         _event_manager.notify_commit_index(_commit_index);
         maybe_update_last_visible_index(_commit_index);
@@ -1612,6 +1992,47 @@ void consensus::trigger_leadership_notification() {
       .current_leader = _leader_id});
 }
 
+void consensus::warm_batch_cache() {
+    const size_t bytes
+      = config::shard_local_cfg().raft_leader_cache_warmup_bytes();
+    if (bytes == 0 || _bg.is_closed()) {
+        return;
+    }
+    const auto start = _log.tail_offset(bytes);
+    const auto offsets = _log.offsets();
+    if (!start || *start > offsets.dirty_offset) {
+        return;
+    }
+    // the first fetches after a failover read the tail, get it from disk
+    // ahead of them without competing with the appends
+    storage::log_reader_config cfg(
+      *start,
+      offsets.dirty_offset,
+      0,
+      bytes,
+      cache_warmup_priority(),
+      std::nullopt,
+      std::nullopt,
+      std::nullopt);
+    struct discard_consumer {
+        ss::future<ss::stop_iteration> operator()(model::record_batch) {
+            return ss::make_ready_future<ss::stop_iteration>(
+              ss::stop_iteration::no);
+        }
+        void end_of_stream() {}
+    };
+    (void)ss::with_gate(_bg, [this, cfg] {
+        return _log.make_reader(cfg)
+          .then([](model::record_batch_reader reader) {
+              return std::move(reader).consume(
+                discard_consumer{}, model::no_timeout);
+          })
+          .handle_exception([this](const std::exception_ptr& e) {
+              vlog(_ctxlog.debug, "Batch cache warm up failed - {}", e);
+          });
+    });
+}
+
 std::ostream& operator<<(std::ostream& o, const consensus& c) {
     fmt::print(
       o,
@@ -1706,15 +2127,30 @@ consensus::transfer_leadership(std::optional<model::node_id> target) {
           make_error_code(errc::not_leader));
     }
 
-    // no explicit node was requested. choose the most up to date follower
+    /*
+     * no explicit node was requested. choose the most up to date voter,
+     * preferring the ones that answered within an election timeout so that
+     * an unreachable node is not picked
+     */
     if (!target) {
-        auto it = std::max_element(
-          _fstats.begin(), _fstats.end(), [](const auto& a, const auto& b) {
-              return a.second.last_dirty_log_index
-                     < b.second.last_dirty_log_index;
-          });
+        const auto conf = _configuration_manager.get_latest();
+        const auto alive_since = clock_type::now() - _jit.base_duration();
+        auto rank = [alive_since](const follower_index_metadata& m) {
+            return std::make_pair(
+              m.last_hbeat_timestamp > alive_since, m.last_dirty_log_index);
+        };
+        auto best = _fstats.end();
+        for (auto it = _fstats.begin(); it != _fstats.end(); ++it) {
+            if (!conf.is_voter(it->first)) {
+                continue;
+            }
+            if (
+              best == _fstats.end() || rank(best->second) < rank(it->second)) {
+                best = it;
+            }
+        }
 
-        if (unlikely(it == _fstats.end())) {
+        if (unlikely(best == _fstats.end())) {
             vlog(
               _ctxlog.debug,
               "Cannot transfer leadership. No suitable target node found");
@@ -1722,7 +2158,7 @@ consensus::transfer_leadership(std::optional<model::node_id> target) {
               make_error_code(errc::node_does_not_exists));
         }
 
-        target = it->first;
+        target = best->first;
     }
 
     if (*target == _self) {
@@ -1863,7 +2299,21 @@ consensus::transfer_leadership(std::optional<model::node_id> target) {
         });
     });
 
-    return f.finally([this] { _transferring_leadership = false; });
+    return f.finally([this] {
+        _transferring_leadership = false;
+        /*
+         * the target may still win an election it was asked to start even
+         * though voters heard from this node recently, the lease is only
+         * extended again by requests sent once that election timed out
+         */
+        auto timeout = _jit.base_duration();
+        if (config::shard_local_cfg().raft_adaptive_election_timeout()) {
+            timeout = std::max<duration_type>(
+              timeout,
+              config::shard_local_cfg().raft_election_timeout_ceiling_ms());
+        }
+        _lease_floor = clock_type::now() + timeout;
+    });
 }
 
 ss::future<> consensus::remove_persistent_state() {
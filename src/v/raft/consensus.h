@@ -20,7 +20,10 @@
 #include "raft/logger.h"
 #include "raft/prevote_stm.h"
 #include "raft/probe.h"
+#include "raft/produce_latency_probe.h"
 #include "raft/replicate_batcher.h"
+#include "raft/replication_window.h"
+#include "raft/write_behind_buffer.h"
 #include "raft/timeout_jitter.h"
 #include "raft/types.h"
 #include "rpc/connection_cache.h"
@@ -39,6 +42,8 @@ class replicate_entries_stm;
 class vote_stm;
 class prevote_stm;
 class recovery_stm;
+class recovery_scheduler;
+class follower_lag_probe;
 /// consensus for one raft group
 class consensus {
 public:
@@ -67,7 +72,9 @@ public:
       model::timeout_clock::duration disk_timeout,
       consensus_client_protocol,
       leader_cb_t,
-      storage::api&);
+      storage::api&,
+      recovery_scheduler* = nullptr,
+      follower_lag_probe* = nullptr);
 
     /// Initial call. Allow for internal state recovery
     ss::future<> start();
@@ -113,7 +120,38 @@ public:
     const model::ntp& ntp() const { return _log.config().ntp(); }
     clock_type::time_point last_heartbeat() const { return _hbeat; };
 
+    /// \brief election timeout of the group, set by the heartbeat manager
+    /// from the round trip times to the leader when the election timeout is
+    /// adaptive
+    void set_election_timeout(duration_type);
+
+    /**
+     * \brief true while no other node can have been elected leader
+     *
+     * A follower does not grant votes for an election timeout after it heard
+     * from the leader. Once a majority of the voters acknowledged requests
+     * sent at or after a point in time the leader holds a lease up to an
+     * election timeout, less raft_leader_lease_clock_drift_ms, after it.
+     * Adaptive election timeouts are no shorter than their floor, which then
+     * bounds the lease. The lease also requires an entry of the current term
+     * to be committed, so the commit index reflects every write acknowledged
+     * by earlier leaders, and it is given up while leadership is transferred.
+     */
+    bool has_leader_lease() const;
+    /**
+     * Resolves with the commit index once the node is known to be the leader
+     * of the group, state read up to that offset is then linearizable. While
+     * the leader lease holds this does not wait, otherwise it waits for the
+     * followers to acknowledge the next heartbeats. Fails with
+     * errc::not_leader when leadership is lost and errc::timeout when the
+     * lease is not renewed before the deadline.
+     */
+    ss::future<result<model::offset>>
+      linearizable_barrier(clock_type::time_point deadline);
+
     clock_type::time_point last_append_timestamp(model::node_id);
+    /// true if the follower has not yet been sent the current commit index
+    bool has_stale_commit_index(model::node_id) const;
     /**
      * \brief Persist snapshot with given data and start offset
      *
@@ -122,6 +160,12 @@ public:
      * consensus operations lock.
      */
     ss::future<> write_snapshot(write_snapshot_cfg);
+    /// \brief opens the current snapshot, the input of the reader is at the
+    /// data of the state machine once the metadata was read
+    ss::future<std::optional<storage::snapshot_reader>> open_snapshot() {
+        return _snapshot_mgr.open_snapshot();
+    }
+    model::offset last_snapshot_index() const { return _last_snapshot_index; }
 
     /// Increment and returns next append_entries order tracking sequence for
     /// follower with given node id
@@ -160,6 +204,16 @@ public:
      */
     model::offset last_visible_index() const { return _last_visible_index; };
 
+    /**
+     * Resolves as soon as the last visible index reaches the given offset. The
+     * returned future fails with offset_monitor::wait_aborted if the deadline
+     * expires or consensus is stopped before that happens.
+     */
+    ss::future<> wait_for_visible_offset(
+      model::offset offset, clock_type::time_point deadline) {
+        return _consumable_offset_monitor.wait(offset, deadline, _as);
+    }
+
     ss::future<offset_configuration>
     wait_for_config_change(model::offset last_seen, ss::abort_source& as) {
         return _configuration_manager.wait_for_change(last_seen, as);
@@ -182,6 +236,11 @@ public:
         return _log.timequery(cfg);
     }
 
+    ss::future<std::optional<storage::key_lookup_result>>
+    lookup_key(storage::key_lookup_config cfg) {
+        return _log.lookup_key(std::move(cfg));
+    }
+
     model::offset start_offset() const { return _log.offsets().start_offset; }
 
     event_manager& events() { return _event_manager; }
@@ -191,6 +250,7 @@ public:
     }
 
     const storage::ntp_config& log_config() const { return _log.config(); }
+    const storage::log& log() const { return _log; }
 
     /*
      * Attempt to transfer leadership to another node in this raft group. If no
@@ -199,6 +259,10 @@ public:
     ss::future<std::error_code>
       transfer_leadership(std::optional<model::node_id>);
 
+    /// \brief the node no longer starts elections for the group, e.g. while
+    /// it hands over its leaderships before stopping
+    void decline_leadership() { _leadership_declined = true; }
+
     ss::future<> remove_persistent_state();
 
     /**
@@ -209,6 +273,7 @@ public:
     model::offset read_last_applied() const;
 
     probe& get_probe() { return _probe; };
+    produce_latency_probe& produce_latency() { return _produce_latency; }
 
 private:
     friend replicate_entries_stm;
@@ -245,8 +310,23 @@ private:
     ss::future<result<replicate_result>>
     do_replicate(model::record_batch_reader&&);
 
+    /// acknowledges relaxed consistency writes once they are sequenced
+    ss::future<result<replicate_result>>
+    replicate_write_behind(model::record_batch_reader&&);
+    /// \brief appends the write behind batches ahead of any other append
+    /// of the leader. must be called under the op lock
+    ss::future<> flush_write_behind();
+    void dispatch_write_behind();
+    /// \brief op lock units of a leader append, with the log caught up with
+    /// the acknowledged writes
+    ss::future<ss::semaphore_units<>> get_append_units();
+
+    using update_window = ss::bool_class<struct update_window_tag>;
     ss::future<storage::append_result>
-    disk_append(model::record_batch_reader&&);
+    disk_append(
+      model::record_batch_reader&&,
+      update_window = update_window::no,
+      std::optional<model::term_id> term = std::nullopt);
 
     using success_reply = ss::bool_class<struct successfull_reply_tag>;
 
@@ -279,11 +359,17 @@ private:
     ss::future<> maybe_update_follower_commit_idx(model::offset);
 
     void arm_vote_timeout();
-    void update_node_append_timestamp(model::node_id);
+    /// shortest election timeout of the voters of the group
+    duration_type min_election_timeout() const;
+    void update_node_append_timestamp(model::node_id, model::offset);
     void update_node_hbeat_timestamp(model::node_id);
+    void maybe_extend_lease(follower_index_metadata&, follower_req_seq);
 
     void update_follower_stats(const group_configuration&);
     void trigger_leadership_notification();
+    /// reads the last raft_leader_cache_warmup_bytes of the active segment
+    /// into the batch cache in the background
+    void warm_batch_cache();
 
     /// \brief _does not_ hold the lock.
     ss::future<> flush_log();
@@ -333,14 +419,20 @@ private:
     model::node_id _voted_for;
     std::optional<model::node_id> _leader_id;
     bool _transferring_leadership{false};
+    bool _leadership_declined{false};
 
     /// useful for when we are not the leader
     clock_type::time_point _hbeat = clock_type::now();
     clock_type::time_point _became_leader_at = clock_type::now();
+    /// acknowledgements of requests sent before do not extend the lease
+    clock_type::time_point _lease_floor = clock_type::time_point::min();
+    ss::condition_variable _lease_renewed;
     /// used to keep track if we are a leader, or transitioning
     vote_state _vstate = vote_state::follower;
     /// used for votes only. heartbeats are done by heartbeat_manager
     timer_type _vote_timeout;
+    /// end of the log when the vote timeout was last armed
+    model::offset _vote_timeout_dirty_offset;
 
     /// used for keepint tally on followers
     follower_stats _fstats;
@@ -357,21 +449,34 @@ private:
     /// used for notifying when commits happened to log
     event_manager _event_manager;
     probe _probe;
+    produce_latency_probe _produce_latency;
     ctx_log _ctxlog;
     ss::condition_variable _commit_index_updated;
+    produce_latency_probe::clock_type::time_point _commit_index_updated_at;
 
     std::chrono::milliseconds _replicate_append_timeout;
     std::chrono::milliseconds _recovery_append_timeout;
     ss::metrics::metric_groups _metrics;
     ss::abort_source _as;
     storage::api& _storage;
+    // shared by the groups of the shard, recoveries are not scheduled when
+    // the group has none
+    recovery_scheduler* _recovery_scheduler;
+    follower_lag_probe* _lag_probe;
     storage::snapshot_manager _snapshot_mgr;
     std::optional<storage::snapshot_writer> _snapshot_writer;
+    // bytes of the snapshot being received written by _snapshot_writer
+    size_t _received_snapshot_bytes{0};
     model::offset _last_snapshot_index;
     model::term_id _last_snapshot_term;
     configuration_manager _configuration_manager;
     model::offset _last_visible_index;
     offset_monitor _consumable_offset_monitor;
+    // batches last appended as the leader, only used for recovery
+    replication_window _replication_window;
+    // relaxed consistency writes acknowledged ahead of the log
+    write_behind_buffer _write_behind;
+    bool _write_behind_dispatched{false};
     friend std::ostream& operator<<(std::ostream&, const consensus&);
 };
 
@@ -13,6 +13,7 @@
 #include "model/fundamental.h"
 #include "model/record.h"
 #include "model/timestamp.h"
+#include "raft/configuration_manager.h"
 #include "raft/logger.h"
 #include "random/generators.h"
 #include "reflection/adl.h"
@@ -305,4 +306,30 @@ model::record_batch_reader make_config_extracting_reader(
     return model::record_batch_reader(std::move(reader));
 }
 
+bytes serialize_group_key(raft::group_id group, metadata_key key_type) {
+    iobuf buf;
+    reflection::serialize(buf, key_type, group);
+    return iobuf_to_bytes(buf);
+}
+
+bytes configuration_delta_key(raft::group_id group, size_t slot) {
+    iobuf buf;
+    reflection::serialize(
+      buf, metadata_key::config_delta, group, static_cast<uint32_t>(slot));
+    return iobuf_to_bytes(buf);
+}
+
+std::vector<bytes> persistent_state_keys(raft::group_id group) {
+    std::vector<bytes> keys{
+      serialize_group_key(group, metadata_key::voted_for),
+      serialize_group_key(group, metadata_key::config_map),
+      serialize_group_key(group, metadata_key::config_latest_known_offset),
+      serialize_group_key(group, metadata_key::last_applied_offset)};
+    keys.reserve(keys.size() + configuration_manager::max_deltas);
+    for (size_t i = 0; i < configuration_manager::max_deltas; ++i) {
+        keys.push_back(configuration_delta_key(group, i));
+    }
+    return keys;
+}
+
 } // namespace raft::details
@@ -51,6 +51,16 @@ ss::circular_buffer<model::record_batch> make_ghost_batches_in_gaps(
 ss::future<>
 persist_snapshot(storage::snapshot_manager&, snapshot_metadata, iobuf&&);
 
+/// key of the group metadata in the consensus key space of the kvstore
+bytes serialize_group_key(raft::group_id, metadata_key);
+
+/// key of the configuration delta stored in the given slot
+bytes configuration_delta_key(raft::group_id, size_t);
+
+/// keys of all the metadata the group keeps in the kvstore, moving the group
+/// to another shard moves these
+std::vector<bytes> persistent_state_keys(raft::group_id);
+
 /// looks up for the broker with request id in a vector of brokers
 template<typename Iterator>
 Iterator find_machine(Iterator begin, Iterator end, model::node_id id) {
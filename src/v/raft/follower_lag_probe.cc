@@ -0,0 +1,48 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/follower_lag_probe.h"
+
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+
+#include <seastar/core/metrics.hh>
+
+namespace raft {
+
+// up to a billion offsets behind at two significant figures
+static constexpr int64_t max_lag = 1'000'000'000;
+static constexpr int32_t significant_figures = 2;
+
+void follower_lag_probe::record(model::node_id id, uint64_t lag) {
+    auto [it, inserted] = _followers.try_emplace(
+      id, follower{hdr_hist(max_lag, 1, significant_figures), {}});
+    if (inserted) {
+        setup_metrics(id, it->second);
+    }
+    it->second.lag.record(lag);
+}
+
+void follower_lag_probe::setup_metrics(model::node_id id, follower& f) {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    auto follower_label = sm::label("follower");
+    f.metrics.add_group(
+      prometheus_sanitize::metrics_name("raft"),
+      {sm::make_histogram(
+        "follower_lag_offsets",
+        [&f] { return f.lag.seastar_histogram_logform(); },
+        sm::description("Offsets the follower is behind the leader log when "
+                        "it acknowledges append entries requests"),
+        {follower_label(id())})});
+}
+
+} // namespace raft
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/metadata.h"
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/metrics_registration.hh>
+
+#include <absl/container/node_hash_map.h>
+
+#include <cstdint>
+
+namespace raft {
+
+/**
+ * Lag of the followers of the groups a shard leads, by follower node.
+ *
+ * Every append entries reply a leader accepts records how many offsets the
+ * follower is behind the leader log. Histograms are registered as the
+ * follower nodes are first seen, so a slow node shows up as one series
+ * however many groups it follows.
+ */
+class follower_lag_probe {
+public:
+    void record(model::node_id, uint64_t lag);
+
+    const hdr_hist* histogram(model::node_id id) const {
+        auto it = _followers.find(id);
+        return it == _followers.end() ? nullptr : &it->second.lag;
+    }
+
+private:
+    struct follower {
+        hdr_hist lag;
+        ss::metrics::metric_groups metrics;
+    };
+
+    void setup_metrics(model::node_id, follower&);
+
+    // metrics hold references to the histograms, the addresses are stable
+    absl::node_hash_map<model::node_id, follower> _followers;
+};
+
+} // namespace raft
@@ -11,7 +11,15 @@
 
 #include "config/configuration.h"
 #include "prometheus/prometheus_sanitize.h"
+#include "raft/logger.h"
 #include "resource_mgmt/io_priority.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/smp.hh>
+
+#include <algorithm>
 
 namespace raft {
 
@@ -25,15 +33,81 @@ group_manager::group_manager(
   , _disk_timeout(disk_timeout)
   , _client(make_rpc_client_protocol(self, clients))
   , _heartbeats(heartbeat_interval, _client, _self)
+  , _recovery_scheduler(
+      config::shard_local_cfg().recovery_max_concurrent_per_shard(),
+      config::shard_local_cfg().recovery_rate_bytes() / ss::smp::count)
   , _storage(storage.local()) {
     setup_metrics();
 }
 
 ss::future<> group_manager::start() { return _heartbeats.start(); }
 
+static ss::future<> drain_group(
+  ss::lw_shared_ptr<consensus> c, clock_type::time_point deadline) {
+    if (clock_type::now() >= deadline || !c->is_leader()) {
+        return ss::now();
+    }
+    return c->transfer_leadership(std::nullopt)
+      .then([c](std::error_code ec) {
+          if (ec) {
+              vlog(
+                raftlog.info,
+                "Unable to transfer leadership of group {} - {}",
+                c->group(),
+                ec.message());
+          }
+      })
+      .handle_exception([c](const std::exception_ptr& e) {
+          vlog(
+            raftlog.info,
+            "Unable to transfer leadership of group {} - {}",
+            c->group(),
+            e);
+      });
+}
+
+ss::future<> group_manager::drain_leadership(
+  size_t concurrency, clock_type::time_point deadline) {
+    return ss::with_gate(_gate, [this, concurrency, deadline] {
+        std::vector<ss::lw_shared_ptr<consensus>> leaders;
+        for (auto& c : _groups) {
+            c->decline_leadership();
+            if (c->is_leader()) {
+                leaders.push_back(c);
+            }
+        }
+        // cluster metadata operations wait on the controller
+        std::stable_partition(
+          leaders.begin(),
+          leaders.end(),
+          [](const ss::lw_shared_ptr<consensus>& c) {
+              return c->group() == raft::group_id(0);
+          });
+        vlog(
+          raftlog.info,
+          "Transferring leadership of {} groups",
+          leaders.size());
+        return ss::do_with(
+          std::move(leaders),
+          ss::semaphore(std::max<size_t>(concurrency, 1)),
+          [deadline](
+            std::vector<ss::lw_shared_ptr<consensus>>& leaders,
+            ss::semaphore& sem) {
+              return ss::parallel_for_each(
+                leaders, [&sem, deadline](ss::lw_shared_ptr<consensus> c) {
+                    return ss::with_semaphore(sem, 1, [c, deadline] {
+                        return drain_group(c, deadline);
+                    });
+                });
+          });
+    });
+}
+
 ss::future<> group_manager::stop() {
     return _gate.close()
       .then([this] { return _heartbeats.stop(); })
+      // recoveries waiting for admission hold the groups gates
+      .then([this] { return _recovery_scheduler.stop(); })
       .then([this] {
           return ss::parallel_for_each(
             _groups,
@@ -56,7 +130,9 @@ ss::future<ss::lw_shared_ptr<raft::consensus>> group_manager::create_group(
       [this](raft::leadership_status st) {
           trigger_leadership_notification(std::move(st));
       },
-      _storage);
+      _storage,
+      &_recovery_scheduler,
+      &_lag_probe);
 
     return ss::with_gate(_gate, [this, raft] {
         return _heartbeats.register_group(raft).then([this, raft] {
@@ -77,11 +153,46 @@ ss::future<> group_manager::remove(ss::lw_shared_ptr<raft::consensus> c) {
       });
 }
 
+ss::future<> group_manager::shutdown(ss::lw_shared_ptr<raft::consensus> c) {
+    return c->stop()
+      .then(
+        [this, id = c->group()] { return _heartbeats.deregister_group(id); })
+      .finally([this, c] {
+          _groups.erase(
+            std::remove(_groups.begin(), _groups.end(), c), _groups.end());
+      });
+}
+
 void group_manager::trigger_leadership_notification(
   raft::leadership_status st) {
     for (auto& cb : _notifications) {
         cb.second(st.group, st.term, st.current_leader);
     }
+    if (_batch_notifications.empty() || _gate.is_closed()) {
+        return;
+    }
+    auto [it, inserted] = _pending_leadership_index.emplace(
+      st.group, _pending_leadership.size());
+    if (!inserted) {
+        _pending_leadership[it->second] = st;
+        return;
+    }
+    _pending_leadership.push_back(st);
+    if (_pending_leadership.size() > 1) {
+        return;
+    }
+    // the changes of the tasks already queued are delivered with this one
+    (void)ss::with_gate(_gate, [this] {
+        return ss::later().then([this] { dispatch_leadership_batch(); });
+    });
+}
+
+void group_manager::dispatch_leadership_batch() {
+    auto changes = std::exchange(_pending_leadership, {});
+    _pending_leadership_index.clear();
+    for (auto& cb : _batch_notifications) {
+        cb.second(changes);
+    }
 }
 
 void group_manager::setup_metrics() {
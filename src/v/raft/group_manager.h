@@ -13,7 +13,9 @@
 #include "cluster/types.h"
 #include "raft/consensus.h"
 #include "raft/consensus_client_protocol.h"
+#include "raft/follower_lag_probe.h"
 #include "raft/heartbeat_manager.h"
+#include "raft/recovery_scheduler.h"
 #include "raft/rpc_client_protocol.h"
 #include "raft/types.h"
 #include "storage/api.h"
@@ -33,6 +35,8 @@ class group_manager {
 public:
     using leader_cb_t = ss::noncopyable_function<void(
       raft::group_id, model::term_id, std::optional<model::node_id>)>;
+    using leaders_cb_t = ss::noncopyable_function<void(
+      const std::vector<raft::leadership_status>&)>;
 
     group_manager(
       model::node_id self,
@@ -49,6 +53,17 @@ public:
 
     ss::future<> remove(ss::lw_shared_ptr<raft::consensus>);
 
+    /// Stops the group keeping its persistent state, the group is handed
+    /// over to another shard which carries on as the same member
+    ss::future<> shutdown(ss::lw_shared_ptr<raft::consensus>);
+
+    /// \brief hands the groups led by the node over to their most caught up
+    /// voter before the node stops, the controller group first. At most
+    /// `concurrency` transfers run at once and none starts past `deadline`.
+    /// The groups no longer start elections afterwards.
+    ss::future<>
+      drain_leadership(size_t concurrency, clock_type::time_point deadline);
+
     cluster::notification_id_type
     register_leadership_notification(leader_cb_t cb) {
         auto id = _notification_id++;
@@ -60,6 +75,28 @@ public:
         return id;
     }
 
+    /// \brief the leadership changes of the groups are delivered together
+    /// once per reactor tick, with the last change of each group only. a
+    /// storm of elections costs a call per subscriber rather than one per
+    /// subscriber and change
+    cluster::notification_id_type
+    register_leadership_batch_notification(leaders_cb_t cb) {
+        auto id = _notification_id++;
+        std::vector<raft::leadership_status> all;
+        all.reserve(_groups.size());
+        for (auto& gr : _groups) {
+            all.push_back(raft::leadership_status{
+              .term = gr->term(),
+              .group = gr->group(),
+              .current_leader = gr->get_leader_id()});
+        }
+        if (!all.empty()) {
+            cb(all);
+        }
+        _batch_notifications.emplace_back(id, std::move(cb));
+        return id;
+    }
+
     void unregister_leadership_notification(cluster::notification_id_type id) {
         auto it = std::find_if(
           _notifications.begin(),
@@ -69,22 +106,42 @@ public:
           });
         if (it != _notifications.end()) {
             _notifications.erase(it);
+            return;
+        }
+        auto bit = std::find_if(
+          _batch_notifications.begin(),
+          _batch_notifications.end(),
+          [id](
+            const std::pair<cluster::notification_id_type, leaders_cb_t>& n) {
+              return n.first == id;
+          });
+        if (bit != _batch_notifications.end()) {
+            _batch_notifications.erase(bit);
         }
     }
 
 private:
     void trigger_leadership_notification(raft::leadership_status);
+    void dispatch_leadership_batch();
     void setup_metrics();
 
     model::node_id _self;
     model::timeout_clock::duration _disk_timeout;
     raft::consensus_client_protocol _client;
     raft::heartbeat_manager _heartbeats;
+    raft::recovery_scheduler _recovery_scheduler;
+    raft::follower_lag_probe _lag_probe;
     ss::gate _gate;
     std::vector<ss::lw_shared_ptr<raft::consensus>> _groups;
     cluster::notification_id_type _notification_id{0};
     std::vector<std::pair<cluster::notification_id_type, leader_cb_t>>
       _notifications;
+    std::vector<std::pair<cluster::notification_id_type, leaders_cb_t>>
+      _batch_notifications;
+    /// changes of the current tick by group, in the order of their first
+    /// change
+    std::vector<raft::leadership_status> _pending_leadership;
+    absl::flat_hash_map<raft::group_id, size_t> _pending_leadership_index;
     ss::metrics::metric_groups _metrics;
     storage::api& _storage;
 };
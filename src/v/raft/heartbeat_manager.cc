@@ -27,6 +27,8 @@
 #include <bits/stdint-uintn.h>
 #include <boost/range/iterator_range.hpp>
 
+#include <algorithm>
+
 namespace raft {
 ss::logger hbeatlog{"r/heartbeat"};
 using consensus_ptr = heartbeat_manager::consensus_ptr;
@@ -62,7 +64,15 @@ static std::vector<heartbeat_manager::node_heartbeat> requests_for_range(
 
             auto last_append_timestamp = ptr->last_append_timestamp(n.id());
 
-            if (last_append_timestamp > last_heartbeat) {
+            /*
+             * data traffic carries the commit index, a recent append makes a
+             * heartbeat redundant unless the commit index advanced after the
+             * append was sent. in that case the heartbeat is what delivers the
+             * new commit index to the follower.
+             */
+            if (
+              last_append_timestamp > last_heartbeat
+              && !ptr->has_stale_commit_index(n.id())) {
                 vlog(
                   hbeatlog.trace,
                   "Skipping sending beat to {} gr: {} last hb {}, last append "
@@ -138,7 +148,45 @@ heartbeat_manager::send_heartbeats(std::vector<node_heartbeat> reqs) {
       });
 }
 
+/// a few round trips of margin over the heartbeat interval, as the raft
+/// paper suggests keeping the election timeout an order of magnitude above
+/// the time to reach the followers
+static duration_type
+election_timeout_for(duration_type rtt, duration_type heartbeat_interval) {
+    const auto& cfg = config::shard_local_cfg();
+    return std::clamp<duration_type>(
+      2 * heartbeat_interval + 10 * rtt,
+      cfg.raft_election_timeout_floor_ms(),
+      cfg.raft_election_timeout_ceiling_ms());
+}
+
+void heartbeat_manager::update_election_timeouts() {
+    if (!config::shard_local_cfg().raft_adaptive_election_timeout()) {
+        return;
+    }
+    absl::flat_hash_map<model::node_id, duration_type> timeouts;
+    for (const auto& [id, rtts] : _rtts) {
+        if (auto p99 = rtts.percentile(0.99); p99) {
+            timeouts.emplace(
+              id, election_timeout_for(*p99, _heartbeat_interval));
+        }
+    }
+    if (timeouts.empty()) {
+        return;
+    }
+    for (auto& ptr : _consensus_groups) {
+        auto leader = ptr->get_leader_id();
+        if (ptr->is_leader() || !leader) {
+            continue;
+        }
+        if (auto it = timeouts.find(*leader); it != timeouts.end()) {
+            ptr->set_election_timeout(it->second);
+        }
+    }
+}
+
 ss::future<> heartbeat_manager::do_dispatch_heartbeats() {
+    update_election_timeouts();
     auto reqs = requests_for_range(_consensus_groups, _heartbeat_interval);
     return send_heartbeats(std::move(reqs));
 }
@@ -162,15 +210,19 @@ ss::future<> heartbeat_manager::do_self_heartbeat(node_heartbeat&& r) {
 }
 
 ss::future<> heartbeat_manager::do_heartbeat(node_heartbeat&& r) {
+    const auto sent = clock_type::now();
     auto f = _client_protocol.heartbeat(
       r.target,
       std::move(r.request),
       rpc::client_opts(
-        next_heartbeat_timeout(), rpc::compression_type::zstd, 512));
+        next_heartbeat_timeout(), rpc::compression_type::adaptive, 512));
     _dispatch_sem.signal();
     return f
-      .then([node = r.target, groups = std::move(r.sequence_map), this](
+      .then([node = r.target, groups = std::move(r.sequence_map), sent, this](
               result<heartbeat_reply> ret) mutable {
+          if (ret) {
+              _rtts[node].record(clock_type::now() - sent);
+          }
           process_reply(node, std::move(groups), std::move(ret));
       })
       .handle_exception_type([](const ss::gate_closed_exception&) {});
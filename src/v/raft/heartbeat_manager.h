@@ -16,6 +16,7 @@
 #include "outcome.h"
 #include "raft/consensus.h"
 #include "raft/consensus_client_protocol.h"
+#include "raft/rtt_window.h"
 #include "raft/types.h"
 #include "rpc/connection_cache.h"
 #include "utils/mutex.h"
@@ -82,6 +83,12 @@ extern ss::logger hbeatlog;
  *
  *    heartbeat({L0, L1}) -> {F0, F1}(node-b)
  *    heartbeat({L0, L1}) -> {F0, F1}(node-c)
+ *
+ * The manager also keeps the round trip times of the heartbeats sent to each
+ * node. With raft_adaptive_election_timeout the election timeout of the
+ * groups a node follows is derived from the p99 round trip time to their
+ * leader, within raft_election_timeout_floor_ms and
+ * raft_election_timeout_ceiling_ms.
  */
 class heartbeat_manager {
 public:
@@ -122,6 +129,8 @@ private:
     /// \brief unprotected, must be used inside the gate & semaphore
     ss::future<> do_dispatch_heartbeats();
 
+    void update_election_timeouts();
+
     ss::future<> send_heartbeats(std::vector<node_heartbeat>);
 
     /// \brief sends a batch to one node
@@ -152,5 +161,6 @@ private:
     consensus_client_protocol _client_protocol;
     ss::semaphore _dispatch_sem{0};
     model::node_id _self;
+    absl::flat_hash_map<model::node_id, rtt_window> _rtts;
 };
 } // namespace raft
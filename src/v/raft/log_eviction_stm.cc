@@ -9,11 +9,19 @@
 
 #include "raft/log_eviction_stm.h"
 
+#include "model/record_batch_reader.h"
 #include "raft/consensus.h"
+#include "raft/errc.h"
 #include "raft/types.h"
+#include "reflection/adl.h"
+#include "resource_mgmt/io_priority.h"
+#include "storage/record_batch_builder.h"
 
 #include <seastar/core/future-util.hh>
 
+#include <algorithm>
+#include <limits>
+
 namespace raft {
 
 log_eviction_stm::log_eviction_stm(
@@ -23,11 +31,18 @@ log_eviction_stm::log_eviction_stm(
   , _as(as) {}
 
 ss::future<> log_eviction_stm::start() {
+    // truncations below the start offset were applied before the restart,
+    // the ones above the last snapshot are applied again as no-ops
+    _next = std::max(_raft->start_offset(), model::offset(0));
     monitor_log_eviction();
+    apply_prefix_truncations();
     return ss::now();
 }
 
-ss::future<> log_eviction_stm::stop() { return _gate.close(); }
+ss::future<> log_eviction_stm::stop() {
+    _applied.stop();
+    return _gate.close();
+}
 
 void log_eviction_stm::monitor_log_eviction() {
     (void)ss::with_gate(_gate, [this] {
@@ -68,4 +83,100 @@ log_eviction_stm::handle_deletion_notification(model::offset last_evicted) {
             write_snapshot_cfg::should_prefix_truncate::no));
       });
 }
+
+ss::future<std::error_code> log_eviction_stm::truncate(
+  model::offset start_offset, model::timeout_clock::time_point deadline) {
+    storage::record_batch_builder builder(
+      prefix_truncate_batch_type, model::offset(0));
+    builder.add_raw_kv(iobuf(), reflection::to_iobuf(start_offset));
+    return _raft
+      ->replicate(
+        model::make_memory_record_batch_reader(std::move(builder).build()),
+        replicate_options(consistency_level::quorum_ack))
+      .then([this, deadline](result<replicate_result> r) {
+          if (!r) {
+              return ss::make_ready_future<std::error_code>(r.error());
+          }
+          return _applied.wait(r.value().last_offset, deadline, _as)
+            .then([] { return make_error_code(errc::success); })
+            .handle_exception_type([](const offset_monitor::wait_aborted&) {
+                return make_error_code(errc::timeout);
+            });
+      });
+}
+
+void log_eviction_stm::apply_prefix_truncations() {
+    (void)ss::with_gate(_gate, [this] {
+        return ss::do_until(
+          [this] { return _as.abort_requested() || _gate.is_closed(); },
+          [this] { return apply_committed(); });
+    });
+}
+
+ss::future<> log_eviction_stm::apply_committed() {
+    return _raft->events()
+      .wait(_next, model::no_timeout, _as)
+      .then([this] {
+          // the batches below the start offset are gone with the prefix
+          _next = std::max(_next, _raft->start_offset());
+          const auto committed = _raft->committed_offset();
+          if (committed < _next) {
+              return ss::now();
+          }
+          // the type filter skips the records of all the other batches
+          storage::log_reader_config cfg(
+            _next,
+            committed,
+            0,
+            std::numeric_limits<size_t>::max(),
+            raft_priority(),
+            prefix_truncate_batch_type,
+            std::nullopt,
+            _as);
+          return _raft->make_reader(cfg)
+            .then([](model::record_batch_reader reader) {
+                return model::consume_reader_to_memory(
+                  std::move(reader), model::no_timeout);
+            })
+            .then([this, committed](model::record_batch_reader::data_t bs) {
+                // only the greatest start offset is left to apply
+                model::offset start;
+                for (auto& b : bs) {
+                    const auto base = b.base_offset();
+                    b.for_each_record([&start, base](model::record r) {
+                        // nothing can be truncated past the request itself
+                        start = std::max(
+                          start,
+                          std::min(
+                            base,
+                            reflection::from_iobuf<model::offset>(
+                              r.release_value())));
+                    });
+                }
+                return do_truncate(start).then([this, committed] {
+                    _next = committed + model::offset(1);
+                    _applied.notify(committed);
+                });
+            });
+      })
+      .handle_exception([this](std::exception_ptr e) {
+          vlog(_logger.trace, "Error applying prefix truncation - {}", e);
+      });
+}
+
+ss::future<> log_eviction_stm::do_truncate(model::offset start) {
+    if (start <= model::offset(0) || start <= _raft->start_offset()) {
+        return ss::now();
+    }
+    vlog(
+      _logger.info,
+      "Truncating the prefix of {} before offset {}",
+      _raft->ntp(),
+      start);
+    // the empty snapshot ends right before the new start offset, writing it
+    // prefix truncates the log. a later snapshot is one of segments evicted
+    // by retention, which moves the start offset past it on its own
+    return _raft->write_snapshot(
+      write_snapshot_cfg(start - model::offset(1), iobuf()));
+}
 } // namespace raft
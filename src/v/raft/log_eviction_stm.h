@@ -10,6 +10,8 @@
  */
 
 #pragma once
+#include "model/timeout_clock.h"
+#include "raft/offset_monitor.h"
 #include "seastarx.h"
 #include "storage/types.h"
 
@@ -23,7 +25,13 @@ class consensus;
 
 /**
  * Responsible for taking snapshots triggered by underlying log segments
- * eviction
+ * eviction, and for the prefix truncations requested by the clients.
+ *
+ * A requested truncation is replicated as a single prefix_truncate batch
+ * holding the new start offset. Every replica applies the committed batch
+ * with an empty snapshot up to the offset before it, which moves the start
+ * offset of the log and drops the segments below it. Only the headers of the
+ * committed batches are read for that, see apply_prefix_truncations.
  */
 class log_eviction_stm {
 public:
@@ -33,15 +41,27 @@ public:
 
     ss::future<> stop();
 
+    /// \brief replicates `start_offset` as the new start offset of the log,
+    /// resolves once the truncation was applied on this replica. Must be
+    /// called on the leader.
+    ss::future<std::error_code>
+      truncate(model::offset start_offset, model::timeout_clock::time_point);
+
 private:
     ss::future<> handle_deletion_notification(model::offset);
     void monitor_log_eviction();
+    void apply_prefix_truncations();
+    ss::future<> apply_committed();
+    ss::future<> do_truncate(model::offset);
 
     consensus* _raft;
     ss::logger& _logger;
     ss::abort_source& _as;
     ss::gate _gate;
     model::offset _previous_eviction_offset;
+    // next offset checked for prefix truncations
+    model::offset _next;
+    offset_monitor _applied;
 };
 
 } // namespace raft
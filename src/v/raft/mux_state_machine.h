@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
 #include "model/fundamental.h"
 #include "model/record.h"
 #include "model/record_batch_reader.h"
@@ -19,19 +22,26 @@
 #include "raft/consensus.h"
 #include "raft/errc.h"
 #include "raft/state_machine.h"
+#include "reflection/adl.h"
 #include "utils/expiring_promise.h"
+#include "utils/mutex.h"
 #include "vassert.h"
 
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
 #include <seastar/core/semaphore.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/util/bool_class.hh>
 #include <seastar/util/log.hh>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/node_hash_map.h>
 
 #include <optional>
 #include <system_error>
+#include <type_traits>
 #include <variant>
+#include <vector>
 
 namespace raft {
 
@@ -47,6 +57,18 @@ CONCEPT(
 )
 // clang-format on
 
+namespace details {
+// states may declare which of their batches can be applied concurrently
+template<typename State, typename = void>
+struct has_concurrency_key : std::false_type {};
+
+template<typename State>
+struct has_concurrency_key<
+  State,
+  std::void_t<decltype(std::declval<const State&>().concurrency_key(
+    std::declval<const model::record_batch&>()))>> : std::true_type {};
+} // namespace details
+
 using persistent_last_applied
   = ss::bool_class<struct persistent_last_applied_tag>;
 
@@ -66,6 +88,26 @@ using persistent_last_applied
 // when batch is applicable for one state is has to be not applicable for
 // another
 //
+// Committed batches are applied in groups (see state_machine::apply_batches).
+// A state may provide
+//
+//   std::optional<bytes> concurrency_key(const model::record_batch&) const;
+//
+// to declare which of its updates commute. Batches with distinct keys are
+// applied concurrently, batches with the same key in offset order under a
+// lock of the key. A batch without a key waits for all batches before it
+// and is applied on its own. Updates of states without the method are
+// applied one at a time, in offset order.
+//
+// When every state provides
+//
+//   ss::future<iobuf> take_snapshot();
+//   ss::future<> apply_snapshot(model::offset, iobuf);
+//
+// the states can be snapshotted every set_snapshot_interval() batches. The
+// snapshot includes the states in their order, and the log is prefix
+// truncated up to it so only the batches that follow it are replayed.
+//
 // +---------+               +---------+      +-------+ +---------+
 // | caller  |               | mux_stm |      | raft  | | state_1 |
 // +---------+               +---------+      +-------+ +---------+
@@ -104,6 +146,21 @@ public:
     /// Replicates record batch
     ss::future<result<raft::replicate_result>> replicate(model::record_batch&&);
 
+    /// Snapshots the states after every `batches` applied batches, zero
+    /// disables snapshots
+    void set_snapshot_interval(size_t batches) {
+        vassert(
+          snapshots_supported || batches == 0,
+          "Snapshots require all states to support them");
+        _snapshot_interval = batches;
+    }
+
+    /// Snapshots the states at the last applied batch now, unless nothing
+    /// was applied since the last snapshot. A follower that misses the log
+    /// truncated up to it, e.g. a node that just joined, installs the
+    /// snapshot instead of replaying the log.
+    ss::future<> write_snapshot_now();
+
     /// Replicates record batch and waits until state will be applied to the
     /// state machine
     ss::future<std::error_code> replicate_and_wait(
@@ -111,6 +168,14 @@ public:
       model::timeout_clock::time_point timeout,
       ss::abort_source& as);
 
+    /// Replicates the batches with a single append to raft and waits until
+    /// each of them is applied. The results are in the order of the batches,
+    /// a failed replication fails all of them.
+    ss::future<std::vector<std::error_code>> replicate_and_wait(
+      std::vector<model::record_batch>&& batches,
+      model::timeout_clock::time_point timeout,
+      ss::abort_source& as);
+
 private:
     using promise_t = expiring_promise<std::error_code>;
     // promises used to wait for result of state applies, keyed by offser
@@ -118,7 +183,40 @@ private:
     using container_t
       = absl::flat_hash_map<model::offset, expiring_promise<std::error_code>>;
 
+    using state_t = std::variant<T*...>;
+    static constexpr bool snapshots_supported
+      = (details::has_snapshot<T>::value && ...);
+
+    // updates applied concurrently by a group of batches
+    struct apply_group {
+        absl::node_hash_map<bytes, mutex, bytes_type_hash, bytes_type_eq>
+          locks;
+        std::vector<ss::future<>> in_flight;
+
+        // waits for the updates in flight, the first failure is returned
+        ss::future<> drain() {
+            return ss::when_all_succeed(in_flight.begin(), in_flight.end())
+              .finally([this] {
+                  in_flight.clear();
+                  locks.clear();
+              });
+        }
+    };
+
+    ss::future<std::error_code> wait_for_apply(
+      model::offset, model::timeout_clock::time_point, ss::abort_source&);
+
     ss::future<> apply(model::record_batch b) final;
+    ss::future<> apply_batches(std::vector<model::record_batch>) final;
+    ss::future<> apply_snapshot(model::offset, iobuf) final;
+    ss::future<> do_apply_batches(std::vector<model::record_batch>);
+    ss::future<> maybe_write_snapshot(model::offset);
+    ss::future<> do_write_snapshot(model::offset);
+
+    std::optional<state_t> find_state(const model::record_batch&);
+    static std::optional<bytes>
+    concurrency_key(state_t, const model::record_batch&);
+    ss::future<> apply_to_state(state_t, model::record_batch);
 
     container_t _promises;
 
@@ -164,6 +262,11 @@ private:
     // we keep states in a tuple to automatically dispatch updates to correct
     // state
     std::tuple<T&...> _state;
+    size_t _snapshot_interval{0};
+    size_t _batches_since_snapshot{0};
+    // snapshots on demand are taken between groups of batches
+    mutex _apply_mutex;
+    model::offset _last_applied_batch;
 };
 
 template<typename... T>
@@ -199,27 +302,85 @@ ss::future<std::error_code> mux_state_machine<T...>::replicate_and_wait(
                 if (!r) {
                     return ss::make_ready_future<ret_t>(r.error());
                 }
+                return wait_for_apply(r.value().last_offset, timeout, as);
+            });
+      });
+}
 
-                auto last_offset = r.value().last_offset;
-
-                auto [it, insterted] = _promises.emplace(
-                  last_offset, expiring_promise<ret_t>{});
-                vassert(
-                  insterted,
-                  "Prosmise for offset {} already registered",
-                  last_offset);
-                return it->second
-                  .get_future_with_timeout(
-                    timeout, [] { return errc::timeout; }, as)
-                  .then_wrapped(
-                    [this, last_offset](ss::future<std::error_code> ec) {
-                        _promises.erase(last_offset);
-                        return ec;
-                    });
+template<typename... T>
+ss::future<std::vector<std::error_code>>
+mux_state_machine<T...>::replicate_and_wait(
+  std::vector<model::record_batch>&& batches,
+  model::timeout_clock::time_point timeout,
+  ss::abort_source& as) {
+    using ret_t = std::vector<std::error_code>;
+    // raft assigns consecutive offsets to the batches, the last offset of
+    // each is found from the end of the append by the records that follow it
+    std::vector<model::offset> records_after(batches.size());
+    model::offset after(0);
+    for (size_t i = batches.size(); i-- > 0;) {
+        records_after[i] = after;
+        after += batches[i].record_count();
+    }
+    model::record_batch_reader::data_t data;
+    data.reserve(batches.size());
+    for (auto& b : batches) {
+        data.push_back(std::move(b));
+    }
+    return _mutex.get_units().then(
+      [this,
+       data = std::move(data),
+       records_after = std::move(records_after),
+       timeout,
+       &as](ss::semaphore_units<> u) mutable {
+          return _c
+            ->replicate(
+              model::make_memory_record_batch_reader(std::move(data)),
+              raft::replicate_options{raft::consistency_level::quorum_ack})
+            .then([this,
+                   u = std::move(u),
+                   records_after = std::move(records_after),
+                   timeout,
+                   &as](result<raft::replicate_result> r) {
+                if (!r) {
+                    return ss::make_ready_future<ret_t>(
+                      ret_t(records_after.size(), r.error()));
+                }
+                std::vector<ss::future<std::error_code>> applied;
+                applied.reserve(records_after.size());
+                for (auto d : records_after) {
+                    applied.push_back(
+                      wait_for_apply(r.value().last_offset - d, timeout, as));
+                }
+                return ss::do_with(
+                  std::move(applied),
+                  [](std::vector<ss::future<std::error_code>>& applied) {
+                      return ss::when_all_succeed(
+                        applied.begin(), applied.end());
+                  });
             });
       });
 }
 
+// must be called under _mutex, so that the batch is not applied before the
+// promise is registered
+template<typename... T>
+ss::future<std::error_code> mux_state_machine<T...>::wait_for_apply(
+  model::offset last_offset,
+  model::timeout_clock::time_point timeout,
+  ss::abort_source& as) {
+    auto [it, insterted] = _promises.emplace(
+      last_offset, expiring_promise<std::error_code>{});
+    vassert(
+      insterted, "Prosmise for offset {} already registered", last_offset);
+    return it->second
+      .get_future_with_timeout(timeout, [] { return errc::timeout; }, as)
+      .then_wrapped([this, last_offset](ss::future<std::error_code> ec) {
+          _promises.erase(last_offset);
+          return ec;
+      });
+}
+
 // return value only if state accepts given batch type
 template<typename State>
 static std::optional<State*>
@@ -231,12 +392,11 @@ is_batch_applicable(State& s, const model::record_batch& batch) {
 }
 
 template<typename... T>
-ss::future<> mux_state_machine<T...>::apply(model::record_batch b) {
-    // lookup for the state to apply the update
+std::optional<typename mux_state_machine<T...>::state_t>
+mux_state_machine<T...>::find_state(const model::record_batch& b) {
     auto state = std::apply(
       [&b](T&... st) {
-          using variant_t = std::variant<T*...>;
-          std::optional<variant_t> res;
+          std::optional<state_t> res;
           (void)((res = is_batch_applicable(st, b), res) || ...);
           return res;
       },
@@ -249,29 +409,198 @@ ss::future<> mux_state_machine<T...>::apply(model::record_batch b) {
             || b.header().type == raft::configuration_batch_type,
           "State handler for batch of type: {} not found",
           b.header().type);
-        return ss::now();
     }
+    return state;
+}
+
+template<typename... T>
+std::optional<bytes> mux_state_machine<T...>::concurrency_key(
+  state_t state, const model::record_batch& b) {
+    return std::visit(
+      [&b](auto* st) -> std::optional<bytes> {
+          using state_type = std::remove_pointer_t<decltype(st)>;
+          if constexpr (details::has_concurrency_key<state_type>::value) {
+              return st->concurrency_key(b);
+          } else {
+              return std::nullopt;
+          }
+      },
+      state);
+}
 
+template<typename... T>
+ss::future<>
+mux_state_machine<T...>::apply_to_state(state_t state, model::record_batch b) {
     auto last_offset = b.last_offset();
     // apply update
     auto result_f = std::visit(
       [b = std::move(b)](auto& state) mutable {
           return state->apply_update(std::move(b));
       },
-      *state);
+      state);
 
     return result_f.then([this, last_offset](std::error_code ec) {
-        auto f = _mutex.with([this, last_offset, ec] {
+        return _mutex.with([this, last_offset, ec] {
             if (auto it = _promises.find(last_offset); it != _promises.end()) {
                 it->second.set_value(ec);
             }
         });
-        if (!_persist_last_applied) {
-            return f;
-        }
-        return f.then(
-          [this, last_offset] { return write_last_applied(last_offset); });
     });
 }
 
+template<typename... T>
+ss::future<> mux_state_machine<T...>::apply(model::record_batch b) {
+    auto state = find_state(b);
+    if (!state) {
+        return ss::now();
+    }
+    auto last_offset = b.last_offset();
+    auto f = apply_to_state(*state, std::move(b));
+    if (!_persist_last_applied) {
+        return f;
+    }
+    return f.then(
+      [this, last_offset] { return write_last_applied(last_offset); });
+}
+
+template<typename... T>
+ss::future<> mux_state_machine<T...>::apply_batches(
+  std::vector<model::record_batch> batches) {
+    return _apply_mutex.with(
+      [this, batches = std::move(batches)]() mutable {
+          return do_apply_batches(std::move(batches));
+      });
+}
+
+template<typename... T>
+ss::future<> mux_state_machine<T...>::do_apply_batches(
+  std::vector<model::record_batch> batches) {
+    auto last_offset = batches.back().last_offset();
+    _batches_since_snapshot += batches.size();
+    return ss::do_with(
+             std::move(batches),
+             apply_group{},
+             [this](
+               std::vector<model::record_batch>& batches, apply_group& group) {
+                 return ss::do_for_each(
+                          batches,
+                          [this, &group](model::record_batch& b) {
+                              auto state = find_state(b);
+                              if (!state) {
+                                  return ss::now();
+                              }
+                              auto key = concurrency_key(*state, b);
+                              if (!key) {
+                                  return group.drain().then(
+                                    [this, state = *state, &b] {
+                                        return apply_to_state(
+                                          state, std::move(b));
+                                    });
+                              }
+                              auto& lock = group.locks[*key];
+                              group.in_flight.push_back(
+                                lock.with([this, state = *state, &b] {
+                                    return apply_to_state(state, std::move(b));
+                                }));
+                              return ss::now();
+                          })
+                   .finally([&group] { return group.drain(); });
+             })
+      .then([this, last_offset] {
+          _last_applied_batch = last_offset;
+          // once per group, the updates may complete out of order
+          if (!_persist_last_applied) {
+              return ss::now();
+          }
+          return write_last_applied(last_offset);
+      })
+      .then([this, last_offset] { return maybe_write_snapshot(last_offset); });
+}
+
+template<typename... T>
+ss::future<> mux_state_machine<T...>::write_snapshot_now() {
+    if constexpr (!snapshots_supported) {
+        return ss::now();
+    } else {
+        return _apply_mutex.with([this] {
+            if (_batches_since_snapshot == 0) {
+                return ss::now();
+            }
+            _batches_since_snapshot = 0;
+            return do_write_snapshot(_last_applied_batch);
+        });
+    }
+}
+
+template<typename... T>
+ss::future<>
+mux_state_machine<T...>::maybe_write_snapshot(model::offset last_offset) {
+    if constexpr (!snapshots_supported) {
+        return ss::now();
+    } else {
+        if (
+          _snapshot_interval == 0
+          || _batches_since_snapshot < _snapshot_interval) {
+            return ss::now();
+        }
+        _batches_since_snapshot = 0;
+        return do_write_snapshot(last_offset);
+    }
+}
+
+template<typename... T>
+ss::future<>
+mux_state_machine<T...>::do_write_snapshot(model::offset last_offset) {
+    if constexpr (!snapshots_supported) {
+        return ss::now();
+    } else {
+        return ss::do_with(iobuf{}, [this, last_offset](iobuf& data) {
+            auto f = ss::now();
+            std::apply(
+              [&f, &data](T&... st) {
+                  ((f = f.then([&st, &data] {
+                        return st.take_snapshot().then([&data](iobuf b) {
+                            reflection::serialize(data, std::move(b));
+                        });
+                    })),
+                   ...);
+              },
+              _state);
+            return f.then([this, last_offset, &data] {
+                return write_snapshot(last_offset, std::move(data));
+            });
+        });
+    }
+}
+
+template<typename... T>
+ss::future<>
+mux_state_machine<T...>::apply_snapshot(model::offset offset, iobuf data) {
+    if constexpr (!snapshots_supported) {
+        return state_machine::apply_snapshot(offset, std::move(data));
+    } else {
+        _batches_since_snapshot = 0;
+        _last_applied_batch = offset;
+        return ss::do_with(
+          iobuf_parser(std::move(data)),
+          [this, offset](iobuf_parser& parser) {
+              auto f = ss::now();
+              std::apply(
+                [&f, &parser, offset](T&... st) {
+                    ((f = f.then([&st, &parser, offset] {
+                          // a state added after the snapshot was written
+                          // gets an empty one
+                          auto data = parser.bytes_left() > 0
+                                        ? reflection::adl<iobuf>{}.from(parser)
+                                        : iobuf{};
+                          return st.apply_snapshot(offset, std::move(data));
+                      })),
+                     ...);
+                },
+                _state);
+              return f;
+          });
+    }
+}
+
 } // namespace raft
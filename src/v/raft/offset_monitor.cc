@@ -13,13 +13,26 @@
 
 #include <seastar/core/future-util.hh>
 
+#include <memory>
+
 namespace raft {
 
+offset_monitor::offset_monitor()
+  : _timer([this] { handle_timeout(); }) {}
+
+offset_monitor::~offset_monitor() noexcept { clear(); }
+
 void offset_monitor::stop() {
     for (auto& waiter : _waiters) {
-        waiter.second->done.set_exception(wait_aborted());
+        waiter.done.set_exception(wait_aborted());
     }
-    _waiters.clear();
+    clear();
+}
+
+void offset_monitor::clear() {
+    _timer.cancel();
+    _deadlines.clear();
+    _waiters.clear_and_dispose(std::default_delete<waiter>());
 }
 
 ss::future<> offset_monitor::wait(
@@ -30,36 +43,64 @@ ss::future<> offset_monitor::wait(
     if (offset <= _last_applied) {
         return ss::now();
     }
-    auto w = std::make_unique<waiter>(this, timeout, as);
+    auto w = std::make_unique<waiter>(this, offset, timeout, as);
     auto f = w->done.get_future();
-    if (!f.available()) {
+    if (f.available()) {
         // the future may already be available, for example if an abort had
         // already be requested. in that case, skip adding as a waiter.
-        _waiters.emplace(offset, std::move(w));
+        return f;
     }
+    _waiters.insert(*w);
+    if (timeout != model::no_timeout) {
+        _deadlines.insert(*w);
+        if (!_timer.armed() || timeout < _timer.get_timeout()) {
+            _timer.rearm(timeout);
+        }
+    }
+    w.release();
     return f;
 }
 
 void offset_monitor::notify(model::offset offset) {
     _last_applied = std::max(offset, _last_applied);
 
-    while (true) {
-        auto it = _waiters.begin();
-        if (it == _waiters.end() || offset < it->first) {
-            return;
-        }
-        it->second->done.set_value();
-        // when the waiter is destroyed here by erase, then if they are active,
-        // the timer is cancelled and the abort source subscription is removed.
-        _waiters.erase(it);
+    while (!_waiters.empty() && _waiters.begin()->offset <= offset) {
+        auto& w = *_waiters.begin();
+        w.done.set_value();
+        remove(w);
+    }
+}
+
+void offset_monitor::remove(waiter& w) {
+    if (w.deadline_hook.is_linked()) {
+        _deadlines.erase(_deadlines.iterator_to(w));
+    }
+    // the abort source subscription is removed when the waiter is destroyed.
+    // the timer is left armed, it re-arms for the next deadline when it fires
+    _waiters.erase_and_dispose(
+      _waiters.iterator_to(w), std::default_delete<waiter>());
+}
+
+void offset_monitor::handle_timeout() {
+    const auto now = model::timeout_clock::now();
+    while (!_deadlines.empty() && _deadlines.begin()->deadline <= now) {
+        auto& w = *_deadlines.begin();
+        w.done.set_exception(wait_aborted());
+        remove(w);
+    }
+    if (!_deadlines.empty()) {
+        _timer.arm(_deadlines.begin()->deadline);
     }
 }
 
 offset_monitor::waiter::waiter(
   offset_monitor* mon,
+  model::offset offset,
   model::timeout_clock::time_point timeout,
   std::optional<std::reference_wrapper<ss::abort_source>> as)
-  : mon(mon) {
+  : mon(mon)
+  , offset(offset)
+  , deadline(timeout) {
     if (as) {
         auto opt_sub = as->get().subscribe(
           [this]() noexcept { handle_abort(); });
@@ -67,27 +108,14 @@ offset_monitor::waiter::waiter(
             sub = std::move(*opt_sub);
         } else {
             done.set_exception(wait_aborted());
-            return;
         }
     }
-    if (timeout != model::no_timeout) {
-        timer.set_callback([this] { handle_abort(); });
-        timer.arm(timeout);
-    }
 }
 
 void offset_monitor::waiter::handle_abort() {
+    vassert(offset_hook.is_linked(), "waiter not found");
     done.set_exception(wait_aborted());
-    auto it = std::find_if(
-      mon->_waiters.begin(),
-      mon->_waiters.end(),
-      [this](const waiters_type::value_type& w) {
-          return w.second.get() == this;
-      });
-    vassert(it != mon->_waiters.end(), "waiter not found");
-    // when the waiter is destroyed here by erase, then if they are active,
-    // the timer is cancelled and the abort source subscription is removed.
-    mon->_waiters.erase(it); // *this is no longer valid after erase
+    mon->remove(*this); // *this is no longer valid after remove
 }
 
 } // namespace raft
@@ -18,7 +18,7 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/timer.hh>
 
-#include <absl/container/btree_map.h>
+#include <boost/intrusive/set.hpp>
 
 namespace raft {
 
@@ -28,9 +28,21 @@ namespace raft {
  * Utility for manging waiters based on a threshold offset. Supports multiple
  * waiters on the same offset, as well as timeout and abort source methods of
  * aborting a wait.
+ *
+ * Waiters are kept in intrusive trees ordered by offset and by deadline, so
+ * that a notify waking k of n waiters costs O(k log n) and an abort unlinks
+ * its waiter in place. The deadlines share a single timer armed for the
+ * earliest of them, rather than a timer per waiter.
  */
 class offset_monitor {
 public:
+    offset_monitor();
+    ~offset_monitor() noexcept;
+    offset_monitor(const offset_monitor&) = delete;
+    offset_monitor& operator=(const offset_monitor&) = delete;
+    offset_monitor(offset_monitor&&) = delete;
+    offset_monitor& operator=(offset_monitor&&) = delete;
+
     /**
      * Exception used to indicate an aborted wait, either from a requested abort
      * via an abort source or because a timeout occurred.
@@ -67,26 +79,60 @@ public:
     void notify(model::offset);
 
 private:
+    using hook_type = boost::intrusive::set_member_hook<>;
+
     struct waiter {
         offset_monitor* mon;
+        model::offset offset;
+        model::timeout_clock::time_point deadline;
         ss::promise<> done;
-        ss::timer<model::timeout_clock> timer;
         ss::abort_source::subscription sub;
+        hook_type offset_hook;
+        // linked only if the wait has a deadline
+        hook_type deadline_hook;
 
         waiter(
           offset_monitor*,
+          model::offset,
           model::timeout_clock::time_point,
           std::optional<std::reference_wrapper<ss::abort_source>>);
 
         void handle_abort();
     };
 
-    friend waiter;
+    struct offset_order {
+        bool operator()(const waiter& a, const waiter& b) const {
+            return a.offset < b.offset;
+        }
+    };
 
-    using waiters_type
-      = absl::btree_multimap<model::offset, std::unique_ptr<waiter>>;
+    struct deadline_order {
+        bool operator()(const waiter& a, const waiter& b) const {
+            return a.deadline < b.deadline;
+        }
+    };
+
+    friend waiter;
 
+    // waiters of equal keys are kept in the order they were inserted
+    using waiters_type = boost::intrusive::multiset<
+      waiter,
+      boost::intrusive::member_hook<waiter, hook_type, &waiter::offset_hook>,
+      boost::intrusive::compare<offset_order>>;
+    using deadlines_type = boost::intrusive::multiset<
+      waiter,
+      boost::intrusive::member_hook<waiter, hook_type, &waiter::deadline_hook>,
+      boost::intrusive::compare<deadline_order>>;
+
+    /// unlinks the waiter and destroys it
+    void remove(waiter&);
+    void handle_timeout();
+    void clear();
+
+    // the waiters are owned by the offset tree
     waiters_type _waiters;
+    deadlines_type _deadlines;
+    ss::timer<model::timeout_clock> _timer;
     model::offset _last_applied;
 };
 
@@ -79,6 +79,31 @@ void probe::setup_metrics(const model::ntp& ntp) {
          [this] { return _log_flushes; },
          sm::description("Number of log flushes"),
          labels),
+       sm::make_derive(
+         "replicate_batch_flushes",
+         [this] { return _replicate_batch_flushed; },
+         sm::description("Number of replicate batches sent to followers"),
+         labels),
+       sm::make_derive(
+         "replicate_batch_immediate_flushes",
+         [this] { return _replicate_batch_flushed_immediately; },
+         sm::description(
+           "Number of replicate batches flushed without lingering because "
+           "of low request rate"),
+         labels),
+       sm::make_derive(
+         "replicate_batch_size_flushes",
+         [this] { return _replicate_batch_flushed_on_size; },
+         sm::description(
+           "Number of replicate batches flushed after reaching the byte "
+           "threshold"),
+         labels),
+       sm::make_derive(
+         "replicate_batch_timer_flushes",
+         [this] { return _replicate_batch_flushed_on_timer; },
+         sm::description(
+           "Number of replicate batches flushed when linger time expired"),
+         labels),
        sm::make_derive(
          "log_truncations",
          [this] { return _log_truncations; },
@@ -103,6 +128,24 @@ void probe::setup_metrics(const model::ntp& ntp) {
          "recovery_requests_errors",
          [this] { return _recovery_request_error; },
          sm::description("Number of failed recovery requests"),
+         labels),
+       sm::make_derive(
+         "lease_reads",
+         [this] { return _lease_reads; },
+         sm::description(
+           "Number of linearizable reads served under the leader lease"),
+         labels),
+       sm::make_derive(
+         "lease_waits",
+         [this] { return _lease_waits; },
+         sm::description(
+           "Number of linearizable reads that waited for the leader lease"),
+         labels),
+       sm::make_derive(
+         "follower_appends_throttled",
+         [this] { return _follower_appends_throttled; },
+         sm::description("Number of replicate rounds not sent to a follower "
+                         "with too many bytes in flight"),
          labels)});
 }
 
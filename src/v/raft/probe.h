@@ -32,6 +32,15 @@ public:
     void log_flushed() { ++_log_flushes; }
 
     void replicate_batch_flushed() { ++_replicate_batch_flushed; }
+    void replicate_batch_flushed_immediately() {
+        ++_replicate_batch_flushed_immediately;
+    }
+    void replicate_batch_flushed_on_size() {
+        ++_replicate_batch_flushed_on_size;
+    }
+    void replicate_batch_flushed_on_timer() {
+        ++_replicate_batch_flushed_on_timer;
+    }
     void recovery_append_request() { ++_recovery_requests; }
     void configuration_update() { ++_configuration_updates; }
 
@@ -46,6 +55,10 @@ public:
     void replicate_request_error() { ++_replicate_request_error; };
     void recovery_request_error() { ++_recovery_request_error; };
 
+    void lease_read() { ++_lease_reads; }
+    void lease_wait() { ++_lease_waits; }
+    void follower_append_throttled() { ++_follower_appends_throttled; }
+
 private:
     uint64_t _vote_requests = 0;
     uint64_t _append_requests = 0;
@@ -56,6 +69,9 @@ private:
     uint64_t _replicate_requests_done = 0;
     uint64_t _log_flushes = 0;
     uint64_t _replicate_batch_flushed = 0;
+    uint64_t _replicate_batch_flushed_immediately = 0;
+    uint64_t _replicate_batch_flushed_on_size = 0;
+    uint64_t _replicate_batch_flushed_on_timer = 0;
     uint32_t _log_truncations = 0;
     uint32_t _configuration_updates = 0;
     uint64_t _recovery_requests = 0;
@@ -63,6 +79,9 @@ private:
     uint64_t _heartbeat_request_error = 0;
     uint64_t _replicate_request_error = 0;
     uint64_t _recovery_request_error = 0;
+    uint64_t _lease_reads = 0;
+    uint64_t _lease_waits = 0;
+    uint64_t _follower_appends_throttled = 0;
 
     ss::metrics::metric_groups _metrics;
 };
@@ -0,0 +1,74 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/produce_latency_probe.h"
+
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "raft/probe.h"
+
+#include <seastar/core/metrics.hh>
+
+#include <array>
+
+namespace raft {
+
+// number of partitions of this shard with histograms
+static thread_local size_t enabled_probes = 0;
+
+// a minute at two significant figures keeps a histogram within a few KB
+static constexpr int64_t max_latency_us = 60'000'000;
+static constexpr int32_t significant_figures = 2;
+
+static constexpr std::array<const char*, produce_latency_probe::stages_count>
+  stage_names{
+    "request_decode",
+    "batcher_wait",
+    "local_append",
+    "follower_append",
+    "flush",
+    "commit_notify",
+  };
+
+produce_latency_probe::~produce_latency_probe() noexcept {
+    if (!_hists.empty()) {
+        --enabled_probes;
+    }
+}
+
+void produce_latency_probe::setup_metrics(const model::ntp& ntp) {
+    if (
+      !_hists.empty()
+      || enabled_probes
+           >= config::shard_local_cfg().produce_latency_max_partitions()) {
+        return;
+    }
+    ++enabled_probes;
+    _hists.reserve(stages_count);
+    for (size_t i = 0; i < stages_count; ++i) {
+        _hists.emplace_back(max_latency_us, 1, significant_figures);
+    }
+
+    namespace sm = ss::metrics;
+    auto labels = probe::create_metric_labels(ntp);
+    std::vector<sm::metric_definition> defs;
+    defs.reserve(stages_count);
+    for (size_t i = 0; i < stages_count; ++i) {
+        defs.push_back(sm::make_histogram(
+          fmt::format("{}_latency_us", stage_names[i]),
+          [this, i] { return _hists[i].seastar_histogram_logform(); },
+          sm::description(
+            fmt::format("Produce latency of the {} stage", stage_names[i])),
+          labels));
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("raft:produce"), std::move(defs));
+}
+
+} // namespace raft
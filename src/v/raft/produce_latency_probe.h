@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/fundamental.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/metrics_registration.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace raft {
+
+/**
+ * Breaks the latency of the produce requests of a partition down into the
+ * stages a request goes through, each of them with its own histogram:
+ *
+ *  request_decode  - parsing and crc verification of the kafka batch
+ *  batcher_wait    - time spent in the replicate batcher before the batch is
+ *                    dispatched in an append entries round
+ *  local_append    - append of the round to the leader log
+ *  follower_append - append entries round trip to each of the followers
+ *  flush           - flush of the leader log
+ *  commit_notify   - time between the commit index covering the round being
+ *                    updated and the waiting replicate call resuming
+ *
+ * Histograms are expensive, only the first produce_latency_max_partitions
+ * partitions of a shard get them. The probes of the remaining partitions are
+ * disabled and record nothing.
+ */
+class produce_latency_probe {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    enum class stage : uint8_t {
+        request_decode = 0,
+        batcher_wait,
+        local_append,
+        follower_append,
+        flush,
+        commit_notify,
+    };
+    static constexpr size_t stages_count = 6;
+
+    produce_latency_probe() = default;
+    produce_latency_probe(const produce_latency_probe&) = delete;
+    produce_latency_probe& operator=(const produce_latency_probe&) = delete;
+    produce_latency_probe(produce_latency_probe&&) = delete;
+    produce_latency_probe& operator=(produce_latency_probe&&) = delete;
+    ~produce_latency_probe() noexcept;
+
+    /// allocates histograms and registers them if the shard has not run
+    /// out of partitions with histograms yet
+    void setup_metrics(const model::ntp&);
+
+    bool enabled() const { return !_hists.empty(); }
+
+    void record(stage s, clock_type::duration d) {
+        if (_hists.empty()) {
+            return;
+        }
+        _hists[static_cast<size_t>(s)].record(
+          std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    }
+
+    const hdr_hist& histogram(stage s) const {
+        return _hists[static_cast<size_t>(s)];
+    }
+
+private:
+    std::vector<hdr_hist> _hists;
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace raft
@@ -0,0 +1,90 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/recovery_scheduler.h"
+
+#include <seastar/core/gate.hh>
+
+#include <algorithm>
+
+namespace raft {
+
+recovery_scheduler::recovery_scheduler(
+  size_t max_concurrent, size_t rate_bytes)
+  : _max_concurrent(std::max<size_t>(1, max_concurrent))
+  , _refill_bytes(
+      rate_bytes == 0
+        ? 0
+        : std::max<size_t>(
+          1, rate_bytes / (std::chrono::seconds(1) / refill_interval)))
+  // a second worth of bytes may be sent at once
+  , _bucket_size(rate_bytes)
+  , _tokens(_bucket_size) {
+    if (_refill_bytes > 0) {
+        _refill_timer.set_callback([this] { refill(); });
+        _refill_timer.arm_periodic(refill_interval);
+    }
+}
+
+ss::future<recovery_scheduler::permit>
+recovery_scheduler::admit(size_t lag_bytes) {
+    if (_stopped) {
+        return ss::make_exception_future<permit>(ss::gate_closed_exception());
+    }
+    if (_running < _max_concurrent && _waiters.empty()) {
+        ++_running;
+        return ss::make_ready_future<permit>(permit(this));
+    }
+    auto& w = _waiters.emplace_back(
+      waiter{.lag_bytes = lag_bytes, .seq = _next_seq++});
+    auto f = w.promise.get_future();
+    std::push_heap(_waiters.begin(), _waiters.end(), waiter_cmp{});
+    return f;
+}
+
+void recovery_scheduler::release() {
+    --_running;
+    while (!_stopped && _running < _max_concurrent && !_waiters.empty()) {
+        std::pop_heap(_waiters.begin(), _waiters.end(), waiter_cmp{});
+        auto w = std::move(_waiters.back());
+        _waiters.pop_back();
+        ++_running;
+        w.promise.set_value(permit(this));
+    }
+}
+
+ss::future<> recovery_scheduler::throttle(size_t bytes) {
+    if (_refill_bytes == 0 || bytes == 0) {
+        return ss::now();
+    }
+    // the tokens are not returned, the refill timer adds them back
+    return _tokens.wait(std::min(bytes, _bucket_size));
+}
+
+void recovery_scheduler::refill() {
+    const auto available = std::max<ssize_t>(0, _tokens.available_units());
+    const auto missing = _bucket_size - std::min<size_t>(
+                           _bucket_size, available);
+    if (missing > 0) {
+        _tokens.signal(std::min(missing, _refill_bytes));
+    }
+}
+
+ss::future<> recovery_scheduler::stop() {
+    _stopped = true;
+    _refill_timer.cancel();
+    _tokens.broken();
+    auto waiters = std::exchange(_waiters, {});
+    for (auto& w : waiters) {
+        w.promise.set_exception(ss::gate_closed_exception());
+    }
+    return ss::now();
+}
+
+} // namespace raft
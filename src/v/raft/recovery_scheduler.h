@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace raft {
+
+/**
+ * Shares the recovery resources of a shard between its raft groups.
+ *
+ * After a node restart every partition it hosts starts recovering at once,
+ * the reads and appends of the recoveries compete with each other and with
+ * the produce path. The scheduler admits a bounded number of recoveries at a
+ * time, the waiting ones are admitted in the order of the bytes they miss so
+ * the followers closest to the end of the log get back in sync first. The
+ * admitted recoveries draw the bytes they send from a shared token bucket.
+ */
+class recovery_scheduler {
+public:
+    using clock_type = ss::lowres_clock;
+    static constexpr auto refill_interval = std::chrono::milliseconds(100);
+
+    /// Admission of a recovery, releases its slot when destroyed
+    class permit {
+    public:
+        permit() noexcept = default;
+        explicit permit(recovery_scheduler* s) noexcept
+          : _sched(s) {}
+        permit(const permit&) = delete;
+        permit& operator=(const permit&) = delete;
+        permit(permit&& o) noexcept
+          : _sched(std::exchange(o._sched, nullptr)) {}
+        permit& operator=(permit&& o) noexcept {
+            if (this != &o) {
+                release();
+                _sched = std::exchange(o._sched, nullptr);
+            }
+            return *this;
+        }
+        ~permit() noexcept { release(); }
+
+    private:
+        void release() noexcept {
+            if (_sched) {
+                std::exchange(_sched, nullptr)->release();
+            }
+        }
+
+        recovery_scheduler* _sched{nullptr};
+    };
+
+    /**
+     * \param max_concurrent recoveries running at the same time
+     * \param rate_bytes bytes per second all the recoveries may send, 0
+     *                   disables the throttling
+     */
+    recovery_scheduler(size_t max_concurrent, size_t rate_bytes);
+    recovery_scheduler(const recovery_scheduler&) = delete;
+    recovery_scheduler& operator=(const recovery_scheduler&) = delete;
+    recovery_scheduler(recovery_scheduler&&) = delete;
+    recovery_scheduler& operator=(recovery_scheduler&&) = delete;
+    ~recovery_scheduler() noexcept = default;
+
+    /// Resolves when the recovery of a follower missing `lag_bytes` may run
+    ss::future<permit> admit(size_t lag_bytes);
+
+    /// Resolves when `bytes` may be sent. Requests larger than the bucket
+    /// are charged the bucket size
+    ss::future<> throttle(size_t bytes);
+
+    /// Fails the waiting admissions and throttled requests
+    ss::future<> stop();
+
+    size_t running() const { return _running; }
+    size_t waiting() const { return _waiters.size(); }
+
+private:
+    struct waiter {
+        size_t lag_bytes;
+        uint64_t seq;
+        ss::promise<permit> promise;
+    };
+    // heap order, the top is the smallest lag, ties in arrival order
+    struct waiter_cmp {
+        bool operator()(const waiter& a, const waiter& b) const {
+            if (a.lag_bytes != b.lag_bytes) {
+                return a.lag_bytes > b.lag_bytes;
+            }
+            return a.seq > b.seq;
+        }
+    };
+
+    void release();
+    void refill();
+
+    size_t _max_concurrent;
+    size_t _running{0};
+    uint64_t _next_seq{0};
+    std::vector<waiter> _waiters;
+    bool _stopped{false};
+
+    size_t _refill_bytes;
+    size_t _bucket_size;
+    ss::semaphore _tokens;
+    ss::timer<clock_type> _refill_timer;
+};
+
+} // namespace raft
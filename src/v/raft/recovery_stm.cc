@@ -9,6 +9,7 @@
 
 #include "raft/recovery_stm.h"
 
+#include "config/configuration.h"
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
 #include "outcome_future_utils.h"
@@ -31,6 +32,39 @@ recovery_stm::recovery_stm(
   , _prio(prio)
   , _ctxlog(_ptr->_ctxlog) {}
 
+ss::future<> recovery_stm::admit() {
+    if (_ptr->_recovery_scheduler == nullptr) {
+        return ss::now();
+    }
+    auto meta = get_follower_meta();
+    if (!meta) {
+        _stop_requested = true;
+        return ss::now();
+    }
+    auto lstats = _ptr->_log.offsets();
+    // a follower behind the start of the log misses all of it
+    const auto start = std::max(meta.value()->next_index, lstats.start_offset);
+    const auto lag = start > lstats.dirty_offset
+                       ? 0
+                       : _ptr->_log.size_bytes(start, lstats.dirty_offset);
+    return _ptr->_recovery_scheduler->admit(lag).then(
+      [this, lag](recovery_scheduler::permit p) {
+          vlog(
+            _ctxlog.trace,
+            "Admitted node {} recovery, missing {} bytes",
+            _node_id,
+            lag);
+          _permit = std::move(p);
+      });
+}
+
+ss::future<> recovery_stm::throttle(size_t bytes) {
+    if (_ptr->_recovery_scheduler == nullptr) {
+        return ss::now();
+    }
+    return _ptr->_recovery_scheduler->throttle(bytes);
+}
+
 ss::future<> recovery_stm::do_recover() {
     // We have to send all the records that leader have, event those that are
     // beyond commit index, thanks to that after majority have recovered
@@ -47,6 +81,11 @@ ss::future<> recovery_stm::do_recover() {
     if (meta.value()->next_index < lstats.start_offset) {
         return install_snapshot();
     }
+    // the log the follower misses up to the snapshot does not have to be
+    // sent, for a large lag installing the snapshot is cheaper
+    if (is_snapshot_cheaper(meta.value()->next_index)) {
+        return install_snapshot();
+    }
 
     /**
      * We have to store committed_index before doing read as we perform
@@ -85,17 +124,32 @@ ss::future<> recovery_stm::do_recover() {
       meta.value()->next_index, lstats.dirty_offset);
 }
 
-ss::future<> recovery_stm::read_range_for_recovery(
+ss::future<ss::circular_buffer<model::record_batch>>
+recovery_stm::read_batches(
   model::offset start_offset, model::offset end_offset) {
+    // 32KB is a modest estimate. It has good batching and it also prevents an
+    // OOM situation where we have a lot of raft groups recovering at the same
+    // time and all drawing from memory. If this setting proves difficult,
+    // we'll need to throttle with a core-local semaphore
+    static constexpr size_t max_bytes = 32 * 1024;
+    // followers a little behind are sent the batches the leader appended last
+    if (auto batches = _ptr->_replication_window.read(
+          start_offset, end_offset, max_bytes)) {
+        vlog(
+          _ctxlog.trace,
+          "Read batches in range [{},{}] for node {} recovery from memory",
+          start_offset,
+          end_offset,
+          _node_id);
+        return ss::make_ready_future<
+          ss::circular_buffer<model::record_batch>>(std::move(*batches));
+    }
+
     storage::log_reader_config cfg(
       start_offset,
       end_offset,
       1,
-      // 32KB is a modest estimate. It has good batching and it also prevents an
-      // OOM situation where we have a lot of raft groups recovering at the same
-      // time and all drawing from memory. If this setting proves difficult,
-      // we'll need to throttle with a core-local semaphore
-      32 * 1024,
+      max_bytes,
       _prio,
       std::nullopt,
       std::nullopt,
@@ -109,10 +163,25 @@ ss::future<> recovery_stm::read_range_for_recovery(
       _node_id);
 
     // TODO: add timeout of maybe 1minute?
-    return _ptr->_log.make_reader(cfg)
-      .then([](model::record_batch_reader reader) {
+    return _ptr->_log.make_reader(cfg).then(
+      [](model::record_batch_reader reader) {
           return model::consume_reader_to_memory(
             std::move(reader), model::no_timeout);
+      });
+}
+
+ss::future<> recovery_stm::read_range_for_recovery(
+  model::offset start_offset, model::offset end_offset) {
+    return read_batches(start_offset, end_offset)
+      .then([this](ss::circular_buffer<model::record_batch> batches) {
+          size_t bytes = 0;
+          for (const auto& b : batches) {
+              bytes += b.size_bytes();
+          }
+          return throttle(bytes).then(
+            [batches = std::move(batches)]() mutable {
+                return std::move(batches);
+            });
       })
       .then(
         [this, start_offset](ss::circular_buffer<model::record_batch> batches) {
@@ -148,7 +217,7 @@ ss::future<> recovery_stm::read_range_for_recovery(
 }
 
 ss::future<> recovery_stm::open_snapshot_reader() {
-    return _ptr->_snapshot_mgr.open_snapshot().then(
+    return _ptr->_snapshot_mgr.open_snapshot(_prio).then(
       [this](std::optional<storage::snapshot_reader> rdr) {
           if (rdr) {
               _snapshot_reader = std::make_unique<storage::snapshot_reader>(
@@ -160,72 +229,156 @@ ss::future<> recovery_stm::open_snapshot_reader() {
       });
 }
 
-ss::future<> recovery_stm::send_install_snapshot_request() {
-    // send 32KB at a time
-    return read_iobuf_exactly(_snapshot_reader->input(), 32_KiB)
-      .then([this](iobuf chunk) mutable {
-          auto chunk_size = chunk.size_bytes();
-          install_snapshot_request req{
-            .term = _ptr->term(),
-            .group = _ptr->group(),
-            .node_id = _ptr->_self,
-            .last_included_index = _ptr->_last_snapshot_index,
-            .file_offset = _sent_snapshot_bytes,
-            .chunk = std::move(chunk),
-            .done = (_sent_snapshot_bytes + chunk_size) == _snapshot_size};
+bool recovery_stm::is_snapshot_cheaper(model::offset next_index) const {
+    const auto snapshot_index = _ptr->_last_snapshot_index;
+    if (snapshot_index < next_index) {
+        return false;
+    }
+    const auto lag = _ptr->_log.size_bytes(next_index, snapshot_index);
+    const auto min_lag
+      = config::shard_local_cfg().recovery_snapshot_min_lag_bytes();
+    if (lag < min_lag) {
+        return false;
+    }
+    vlog(
+      _ctxlog.debug,
+      "Node {} misses {} bytes of log covered by snapshot at {}, installing "
+      "snapshot",
+      _node_id,
+      lag,
+      snapshot_index);
+    return true;
+}
 
-          vlog(
-            _ctxlog.trace,
-            "Sending install snapshot request to {}, last included index: {}",
-            _node_id,
-            req.last_included_index);
-          return _ptr->_client_protocol
-            .install_snapshot(
-              _node_id,
-              std::move(req),
-              rpc::client_opts(append_entries_timeout()))
-            .then([this](result<install_snapshot_reply> reply) {
-                return handle_install_snapshot_reply(reply);
-            });
+ss::future<> recovery_stm::send_install_snapshot_chunks() {
+    // chunks are read in order and sent without waiting for the replies of
+    // the ones before. the follower rejects a chunk that does not continue
+    // what it received, so a reordered request fails the transfer rather
+    // than corrupting the snapshot
+    const auto in_flight = std::max<size_t>(
+      1, config::shard_local_cfg().recovery_snapshot_chunks_in_flight());
+    return ss::do_with(
+      ss::semaphore(in_flight), [this, in_flight](ss::semaphore& sem) {
+          return ss::do_until(
+                   [this] {
+                       return _snapshot_failed || _stop_requested
+                              || _sent_snapshot_bytes == _snapshot_size;
+                   },
+                   [this, &sem] {
+                       return ss::get_units(sem, 1).then(
+                         [this](ss::semaphore_units<> u) {
+                             // send 32KB at a time
+                             return throttle(32_KiB)
+                               .then([this] {
+                                   return read_iobuf_exactly(
+                                     _snapshot_reader->input(), 32_KiB);
+                               })
+                               .then([this, u = std::move(u)](
+                                       iobuf chunk) mutable {
+                                   send_install_snapshot_request(
+                                     std::move(chunk), std::move(u));
+                               });
+                         });
+                   })
+            .finally([&sem, in_flight] { return sem.wait(in_flight); });
       });
 }
 
+void recovery_stm::send_install_snapshot_request(
+  iobuf chunk, ss::semaphore_units<> u) {
+    auto chunk_size = chunk.size_bytes();
+    if (chunk_size == 0) {
+        // snapshot is shorter than its reported size
+        _snapshot_failed = true;
+        return;
+    }
+    install_snapshot_request req{
+      .term = _ptr->term(),
+      .group = _ptr->group(),
+      .node_id = _ptr->_self,
+      .last_included_index = _ptr->_last_snapshot_index,
+      .file_offset = _sent_snapshot_bytes,
+      .chunk = std::move(chunk),
+      .done = (_sent_snapshot_bytes + chunk_size) == _snapshot_size};
+    _sent_snapshot_bytes += chunk_size;
+
+    vlog(
+      _ctxlog.trace,
+      "Sending install snapshot request to {}, last included index: {}, "
+      "offset: {}",
+      _node_id,
+      req.last_included_index,
+      req.file_offset);
+    // waited for by send_install_snapshot_chunks through the units
+    (void)_ptr->_client_protocol
+      .install_snapshot(
+        _node_id, std::move(req), rpc::client_opts(append_entries_timeout()))
+      .then([this](result<install_snapshot_reply> reply) {
+          handle_install_snapshot_reply(reply);
+      })
+      .handle_exception([this](const std::exception_ptr& e) {
+          vlog(_ctxlog.warn, "Install snapshot request failed - {}", e);
+          _snapshot_failed = true;
+      })
+      .finally([u = std::move(u)] {});
+}
+
 ss::future<> recovery_stm::close_snapshot_reader() {
     return _snapshot_reader->close().then([this] {
         _snapshot_reader.reset();
         _snapshot_size = 0;
         _sent_snapshot_bytes = 0;
+        _acked_snapshot_bytes = 0;
+        _snapshot_failed = false;
+        _snapshot_reply_term = std::nullopt;
     });
 }
 
-ss::future<> recovery_stm::handle_install_snapshot_reply(
+void recovery_stm::handle_install_snapshot_reply(
   result<install_snapshot_reply> reply) {
     // snapshot delivery failed
-    if (reply.has_error() || !reply.value().success) {
-        return close_snapshot_reader();
+    if (reply.has_error()) {
+        _snapshot_failed = true;
+        return;
     }
     if (reply.value().term > _ptr->_term) {
-        return close_snapshot_reader().then(
-          [this, term = reply.value().term] { return _ptr->step_down(term); });
+        _snapshot_failed = true;
+        _snapshot_reply_term = std::max(
+          reply.value().term, _snapshot_reply_term.value_or(model::term_id{}));
+        return;
     }
-    _sent_snapshot_bytes = reply.value().bytes_stored;
-
-    // we will send next chunk as a part of recovery loop
-    if (_sent_snapshot_bytes != _snapshot_size) {
-        return ss::now();
-    }
-
-    auto meta = get_follower_meta();
-    if (!meta) {
-        // stop recovery when node was removed
-        _stop_requested = true;
-        return ss::make_ready_future<>();
+    if (!reply.value().success) {
+        _snapshot_failed = true;
+        return;
     }
+    _acked_snapshot_bytes = std::max(
+      _acked_snapshot_bytes, reply.value().bytes_stored);
+}
 
-    // snapshot received by the follower, continue with recovery
-    (*meta)->match_index = _ptr->_last_snapshot_index;
-    (*meta)->next_index = details::next_offset(_ptr->_last_snapshot_index);
-    return close_snapshot_reader();
+ss::future<> recovery_stm::finish_install_snapshot() {
+    const bool installed = !_snapshot_failed
+                           && _acked_snapshot_bytes == _snapshot_size;
+    const auto term = _snapshot_reply_term;
+    // a failed transfer starts over from the first chunk in the next
+    // recovery loop
+    return close_snapshot_reader().then([this, installed, term] {
+        if (term) {
+            return _ptr->step_down(*term);
+        }
+        if (!installed) {
+            return ss::now();
+        }
+        auto meta = get_follower_meta();
+        if (!meta) {
+            // stop recovery when node was removed
+            _stop_requested = true;
+            return ss::now();
+        }
+        // snapshot received by the follower, continue with recovery
+        (*meta)->match_index = _ptr->_last_snapshot_index;
+        (*meta)->next_index = details::next_offset(_ptr->_last_snapshot_index);
+        return ss::now();
+    });
 }
 
 ss::future<> recovery_stm::install_snapshot() {
@@ -240,7 +393,8 @@ ss::future<> recovery_stm::install_snapshot() {
             return ss::now();
         }
 
-        return send_install_snapshot_request();
+        return send_install_snapshot_chunks().then(
+          [this] { return finish_install_snapshot(); });
     });
 }
 
@@ -283,7 +437,7 @@ ss::future<> recovery_stm::replicate(
       std::move(reader),
       flush);
 
-    _ptr->update_node_append_timestamp(_node_id);
+    _ptr->update_node_append_timestamp(_node_id, commit_idx);
 
     auto seq = _ptr->next_follower_sequence(_node_id);
     return dispatch_append_entries(std::move(r)).then([this, seq](auto r) {
@@ -365,14 +519,17 @@ ss::future<> recovery_stm::apply() {
     return ss::with_gate(
              _ptr->_bg,
              [this] {
-                 return do_recover().then([this] {
-                     return ss::do_until(
-                       [this] { return is_recovery_finished(); },
-                       [this] { return do_recover(); });
-                 });
+                 return admit()
+                   .then([this] { return do_recover(); })
+                   .then([this] {
+                       return ss::do_until(
+                         [this] { return is_recovery_finished(); },
+                         [this] { return do_recover(); });
+                   });
              })
       .finally([this] {
           vlog(_ctxlog.trace, "Finished node {} recovery", _node_id);
+          _permit.reset();
           auto meta = get_follower_meta();
           if (meta) {
               meta.value()->is_recovering = false;
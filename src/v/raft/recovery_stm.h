@@ -13,8 +13,11 @@
 
 #include "model/metadata.h"
 #include "raft/consensus.h"
+#include "raft/recovery_scheduler.h"
 #include "raft/types.h"
 
+#include <seastar/core/semaphore.hh>
+
 namespace raft {
 
 class recovery_stm {
@@ -23,8 +26,12 @@ public:
     ss::future<> apply();
 
 private:
+    ss::future<> admit();
+    ss::future<> throttle(size_t bytes);
     ss::future<> do_recover();
     ss::future<> read_range_for_recovery(model::offset, model::offset);
+    ss::future<ss::circular_buffer<model::record_batch>>
+      read_batches(model::offset, model::offset);
     ss::future<> replicate(
       model::record_batch_reader&&, append_entries_request::flush_after_append);
     ss::future<result<append_entries_reply>>
@@ -32,9 +39,12 @@ private:
     std::optional<follower_index_metadata*> get_follower_meta();
     clock_type::time_point append_entries_timeout();
 
+    bool is_snapshot_cheaper(model::offset next_index) const;
     ss::future<> install_snapshot();
-    ss::future<> send_install_snapshot_request();
-    ss::future<> handle_install_snapshot_reply(result<install_snapshot_reply>);
+    ss::future<> send_install_snapshot_chunks();
+    void send_install_snapshot_request(iobuf, ss::semaphore_units<>);
+    void handle_install_snapshot_reply(result<install_snapshot_reply>);
+    ss::future<> finish_install_snapshot();
     ss::future<> open_snapshot_reader();
     ss::future<> close_snapshot_reader();
 
@@ -47,10 +57,15 @@ private:
     model::offset _committed_offset;
     ss::io_priority_class _prio;
     ctx_log _ctxlog;
-    // tracking follower snapshot delivery
+    // tracking follower snapshot delivery, chunks are pipelined so the bytes
+    // sent run ahead of the ones the follower acknowledged
     std::unique_ptr<storage::snapshot_reader> _snapshot_reader;
     size_t _sent_snapshot_bytes = 0;
+    size_t _acked_snapshot_bytes = 0;
     size_t _snapshot_size = 0;
+    bool _snapshot_failed = false;
+    std::optional<model::term_id> _snapshot_reply_term;
+    std::optional<recovery_scheduler::permit> _permit;
     // needed to early exit. (node down)
     bool _stop_requested = false;
 };
@@ -9,6 +9,7 @@
 
 #include "raft/replicate_batcher.h"
 
+#include "config/configuration.h"
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
 #include "raft/consensus_utils.h"
@@ -20,6 +21,7 @@
 #include <seastar/core/sleep.hh>
 #include <seastar/core/smp.hh>
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 
@@ -27,27 +29,75 @@ namespace raft {
 using namespace std::chrono_literals; // NOLINT
 replicate_batcher::replicate_batcher(consensus* ptr, size_t cache_size)
   : _ptr(ptr)
-  , _max_batch_size(cache_size) {
+  , _max_batch_size(cache_size)
+  , _inflight_window(
+      config::shard_local_cfg().raft_max_inflight_append_requests())
+  , _last_arrival(arrival_clock::now()) {
     _flush_timer.set_callback([this] {
-        (void)ss::with_gate(_ptr->_bg, [this] {
-            // background block further caching too
-            return _lock.with([this] { return flush(); });
-        }).handle_exception_type([this](const ss::gate_closed_exception&) {
-            vlog(
-              _ptr->_ctxlog.debug,
-              "Gate closed while flushing replicate requests");
-        });
+        _ptr->_probe.replicate_batch_flushed_on_timer();
+        dispatch_background_flush();
     });
 }
 
+void replicate_batcher::dispatch_background_flush() {
+    (void)ss::with_gate(_ptr->_bg, [this] {
+        // background block further caching too
+        return _lock.with([this] { return flush(); });
+    }).handle_exception_type([this](const ss::gate_closed_exception&) {
+        vlog(
+          _ptr->_ctxlog.debug, "Gate closed while flushing replicate requests");
+    });
+}
+
+size_t replicate_batcher::flush_bytes_threshold() const {
+    return _inflight_flushes > 0 ? _max_batch_size
+                                 : std::min(_max_batch_size, min_batch_bytes);
+}
+
+clock_type::duration replicate_batcher::linger_duration() const {
+    // wait for roughly two more requests to arrive
+    auto linger = std::chrono::duration_cast<clock_type::duration>(
+      _arrival_interval * 2);
+    return std::clamp<clock_type::duration>(linger, min_linger, max_linger);
+}
+
+replicate_batcher::flush_policy replicate_batcher::on_arrival() {
+    auto now = arrival_clock::now();
+    auto interval = now - _last_arrival;
+    _last_arrival = now;
+    _arrival_interval = (_arrival_interval * 7 + interval) / 8;
+
+    if (_pending_bytes >= flush_bytes_threshold()) {
+        return flush_policy::on_size;
+    }
+    if (_inflight_flushes == 0 && _arrival_interval >= max_linger) {
+        return flush_policy::immediate;
+    }
+    return flush_policy::linger;
+}
+
 ss::future<result<replicate_result>>
 replicate_batcher::replicate(model::record_batch_reader&& r) {
     return _lock
       .with(
         [this, r = std::move(r)]() mutable { return do_cache(std::move(r)); })
       .then([this](item_ptr i) {
-          if (_pending_bytes < _max_batch_size || !_flush_timer.armed()) {
-              _flush_timer.rearm(clock_type::now() + 4ms);
+          switch (on_arrival()) {
+          case flush_policy::immediate:
+              _ptr->_probe.replicate_batch_flushed_immediately();
+              _flush_timer.cancel();
+              dispatch_background_flush();
+              break;
+          case flush_policy::on_size:
+              _ptr->_probe.replicate_batch_flushed_on_size();
+              _flush_timer.cancel();
+              dispatch_background_flush();
+              break;
+          case flush_policy::linger:
+              if (!_flush_timer.armed()) {
+                  _flush_timer.arm(linger_duration());
+              }
+              break;
           }
           return i->_promise.get_future();
       });
@@ -55,6 +105,7 @@ replicate_batcher::replicate(model::record_batch_reader&& r) {
 
 ss::future<> replicate_batcher::stop() {
     _flush_timer.cancel();
+    _inflight_window.broken();
     // we keep a lock here to make sure that all inflight requests have finished
     // already
     return _lock.with([this]() {
@@ -89,6 +140,7 @@ replicate_batcher::do_cache(model::record_batch_reader&& r) {
               }
           }
           i->record_count = record_count;
+          i->arrival = produce_latency_probe::clock_type::now();
           _item_cache.emplace_back(i);
           return i;
       });
@@ -106,42 +158,108 @@ ss::future<> replicate_batcher::flush() {
       [this,
        data = std::move(data),
        notifications = std::move(notifications)]() mutable {
-          return _ptr->_op_lock.get_units().then(
-            [this,
-             data = std::move(data),
-             notifications = std::move(notifications)](
-              ss::semaphore_units<> u) mutable {
-                // we have to check if we are the leader
-                // it is critical as term could have been updated already by
-                // vote request and entries from current node could be accepted
-                // by the followers while it is no longer a leader
-                // this problem caused truncation failure.
-
-                if (!_ptr->is_leader()) {
-                    for (auto& n : notifications) {
-                        n->_promise.set_value(errc::not_leader);
-                    }
-                    return ss::make_ready_future<>();
-                }
-
-                auto meta = _ptr->meta();
-                auto const term = model::term_id(meta.term);
-                for (auto& b : data) {
-                    b.set_term(term);
-                }
-                auto seqs = _ptr->next_followers_request_seq();
-                append_entries_request req(
-                  _ptr->_self,
-                  std::move(meta),
-                  model::make_memory_record_batch_reader(std::move(data)));
-                return do_flush(
-                  std::move(notifications),
-                  std::move(req),
-                  std::move(u),
-                  std::move(seqs));
+          // bound the number of append entries rounds in flight, while the
+          // window is full new requests accumulate in the batcher
+          return ss::get_units(_inflight_window, 1)
+            .then([this,
+                   data = std::move(data),
+                   notifications = std::move(notifications)](
+                    ss::semaphore_units<> window) mutable {
+                return _ptr->get_append_units().then(
+                  [this,
+                   data = std::move(data),
+                   notifications = std::move(notifications),
+                   window = std::move(window)](
+                    ss::semaphore_units<> u) mutable {
+                      // we have to check if we are the leader
+                      // it is critical as term could have been updated
+                      // already by vote request and entries from current node
+                      // could be accepted by the followers while it is no
+                      // longer a leader this problem caused truncation
+                      // failure.
+
+                      if (!_ptr->is_leader()) {
+                          for (auto& n : notifications) {
+                              n->_promise.set_value(errc::not_leader);
+                          }
+                          return;
+                      }
+
+                      auto& latency = _ptr->_produce_latency;
+                      if (latency.enabled()) {
+                          auto now = produce_latency_probe::clock_type::now();
+                          for (auto& n : notifications) {
+                              latency.record(
+                                produce_latency_probe::stage::batcher_wait,
+                                now - n->arrival);
+                          }
+                      }
+
+                      auto meta = _ptr->meta();
+                      auto const term = model::term_id(meta.term);
+                      size_t bytes = 0;
+                      for (auto& b : data) {
+                          b.set_term(term);
+                          bytes += b.size_bytes();
+                      }
+                      auto seqs = _ptr->next_followers_request_seq();
+                      append_entries_request req(
+                        _ptr->_self,
+                        std::move(meta),
+                        model::make_memory_record_batch_reader(
+                          std::move(data)));
+                      dispatch_round(
+                        std::move(notifications),
+                        std::move(req),
+                        std::move(u),
+                        std::move(seqs),
+                        std::move(window),
+                        bytes);
+                  });
+            });
+      });
+}
+
+void replicate_batcher::dispatch_round(
+  std::vector<item_ptr> notifications,
+  append_entries_request req,
+  ss::semaphore_units<> u,
+  absl::flat_hash_map<model::node_id, follower_req_seq> seqs,
+  ss::semaphore_units<> window,
+  size_t bytes) {
+    /*
+     * The op lock units are held until the round is appended to the leader
+     * log and dispatched to the followers, which keeps rounds ordered. Waiting
+     * for the round to be committed happens in the background so the next
+     * round can be dispatched before the follower acks arrive.
+     */
+    ++_inflight_flushes;
+    (void)ss::with_gate(
+      _ptr->_bg,
+      [this,
+       notifications = std::move(notifications),
+       req = std::move(req),
+       u = std::move(u),
+       seqs = std::move(seqs),
+       window = std::move(window),
+       bytes]() mutable {
+          return do_flush(
+                   std::move(notifications),
+                   std::move(req),
+                   std::move(u),
+                   std::move(seqs),
+                   bytes)
+            .finally([this, window = std::move(window)] {
+                --_inflight_flushes;
             });
+      })
+      .handle_exception_type([this](const ss::gate_closed_exception&) {
+          vlog(
+            _ptr->_ctxlog.debug,
+            "Gate closed while dispatching replicate requests");
       });
 }
+
 static void propagate_result(
   result<replicate_result> r,
   std::vector<replicate_batcher::item_ptr>& notifications) {
@@ -174,10 +292,11 @@ ss::future<> replicate_batcher::do_flush(
   std::vector<replicate_batcher::item_ptr>&& notifications,
   append_entries_request&& req,
   ss::semaphore_units<> u,
-  absl::flat_hash_map<model::node_id, follower_req_seq> seqs) {
+  absl::flat_hash_map<model::node_id, follower_req_seq> seqs,
+  size_t bytes) {
     _ptr->_probe.replicate_batch_flushed();
     auto stm = ss::make_lw_shared<replicate_entries_stm>(
-      _ptr, std::move(req), std::move(seqs));
+      _ptr, std::move(req), std::move(seqs), bytes);
     return stm->apply(std::move(u))
       .then_wrapped([this, stm, notifications = std::move(notifications)](
                       ss::future<result<replicate_result>> fut) mutable {
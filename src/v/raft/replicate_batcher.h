@@ -13,10 +13,15 @@
 
 #include "model/record_batch_reader.h"
 #include "outcome.h"
+#include "raft/produce_latency_probe.h"
 #include "raft/types.h"
 #include "utils/mutex.h"
 
+#include <seastar/core/semaphore.hh>
+
 #include <absl/container/flat_hash_map.h>
+
+#include <chrono>
 namespace raft {
 class consensus;
 
@@ -26,10 +31,16 @@ public:
         ss::promise<result<replicate_result>> _promise;
         replicate_result ret;
         size_t record_count;
+        produce_latency_probe::clock_type::time_point arrival;
     };
     using item_ptr = ss::lw_shared_ptr<item>;
     // 1MB default size
     static constexpr size_t default_batch_bytes = 1024 * 1024;
+    // byte threshold used when there is no append in flight
+    static constexpr size_t min_batch_bytes = 128 * 1024;
+    // bounds of the time a request may wait for others to join its batch
+    static constexpr std::chrono::milliseconds min_linger{1};
+    static constexpr std::chrono::milliseconds max_linger{4};
 
     explicit replicate_batcher(
       consensus* ptr, size_t cache_size = default_batch_bytes);
@@ -47,19 +58,50 @@ public:
     ss::future<> stop();
 
     // it will lock on behalf of caller to append entries to leader log.
+    // \param bytes size of the batches of the request, 0 when unknown
     ss::future<> do_flush(
       std::vector<item_ptr>&&,
       append_entries_request&&,
       ss::semaphore_units<>,
-      absl::flat_hash_map<model::node_id, follower_req_seq>);
+      absl::flat_hash_map<model::node_id, follower_req_seq>,
+      size_t bytes = 0);
 
 private:
+    /**
+     * Flush policy. Partitions with a low arrival rate flush right away as
+     * there is nothing to coalesce with, hot partitions linger for a period
+     * derived from the recent arrival rate. The byte threshold grows to
+     * _max_batch_size only while appends are in flight, when batching more
+     * doesn't add latency.
+     */
+    enum class flush_policy { immediate, on_size, linger };
+    using arrival_clock = std::chrono::steady_clock;
+
+    flush_policy on_arrival();
+    size_t flush_bytes_threshold() const;
+    clock_type::duration linger_duration() const;
+    void dispatch_background_flush();
+    void dispatch_round(
+      std::vector<item_ptr>,
+      append_entries_request,
+      ss::semaphore_units<>,
+      absl::flat_hash_map<model::node_id, follower_req_seq>,
+      ss::semaphore_units<>,
+      size_t);
+
     ss::future<item_ptr> do_cache(model::record_batch_reader&&);
 
     consensus* _ptr;
     size_t _max_batch_size{default_batch_bytes};
     size_t _pending_bytes{0};
     timer_type _flush_timer;
+    // limits append entries rounds, and therefore requests sent to every
+    // follower, that are in flight at the same time
+    ss::semaphore _inflight_window;
+    // ewma of time between replicate requests
+    arrival_clock::duration _arrival_interval{max_linger};
+    arrival_clock::time_point _last_arrival;
+    uint32_t _inflight_flushes{0};
 
     std::vector<item_ptr> _item_cache;
     ss::circular_buffer<model::record_batch> _data_cache;
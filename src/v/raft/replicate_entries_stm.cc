@@ -9,6 +9,7 @@
 
 #include "raft/replicate_entries_stm.h"
 
+#include "config/configuration.h"
 #include "likely.h"
 #include "model/fundamental.h"
 #include "model/metadata.h"
@@ -46,8 +47,12 @@ ss::future<result<append_entries_reply>> replicate_entries_stm::do_dispatch_one(
     using ret_t = result<append_entries_reply>;
 
     if (n == _ptr->_self) {
+        auto start = produce_latency_probe::clock_type::now();
         auto f = _ptr->flush_log()
-                   .then([this, units]() {
+                   .then([this, units, start]() {
+                       _ptr->_produce_latency.record(
+                         produce_latency_probe::stage::flush,
+                         produce_latency_probe::clock_type::now() - start);
                        auto lstats = _ptr->_log.offsets();
                        auto last_idx = lstats.committed_offset;
                        append_entries_reply reply;
@@ -78,11 +83,19 @@ clock_type::time_point replicate_entries_stm::append_entries_timeout() {
 ss::future<result<append_entries_reply>>
 replicate_entries_stm::send_append_entries_request(
   model::node_id n, append_entries_request req) {
-    _ptr->update_node_append_timestamp(n);
+    _ptr->update_node_append_timestamp(n, req.meta.commit_index);
     vlog(_ctxlog.trace, "Sending append entries request {} to {}", req.meta, n);
 
-    auto f = _ptr->_client_protocol.append_entries(
-      n, std::move(req), rpc::client_opts(append_entries_timeout()));
+    auto start = produce_latency_probe::clock_type::now();
+    auto f = _ptr->_client_protocol
+               .append_entries(
+                 n, std::move(req), rpc::client_opts(append_entries_timeout()))
+               .then([this, start](result<append_entries_reply> r) {
+                   _ptr->_produce_latency.record(
+                     produce_latency_probe::stage::follower_append,
+                     produce_latency_probe::clock_type::now() - start);
+                   return r;
+               });
     _dispatch_sem.signal();
     return f;
 }
@@ -93,8 +106,17 @@ ss::future<> replicate_entries_stm::dispatch_one(
     return ss::with_gate(
              _req_bg,
              [this, id, units]() mutable {
+                 const bool tracked = id != _ptr->self();
+                 if (tracked) {
+                     _ptr->_fstats.get(id).inflight_bytes += _req_bytes;
+                 }
                  return dispatch_single_retry(id, std::move(units))
-                   .then([this, id](result<append_entries_reply> reply) {
+                   .then([this, id, tracked](
+                           result<append_entries_reply> reply) {
+                       // the follower may have left the group meanwhile
+                       if (tracked && _ptr->_fstats.contains(id)) {
+                           _ptr->_fstats.get(id).inflight_bytes -= _req_bytes;
+                       }
                        auto it = _followers_seq.find(id);
                        auto seq = it == _followers_seq.end()
                                     ? follower_req_seq(0)
@@ -128,7 +150,16 @@ replicate_entries_stm::append_to_self() {
     return share_request()
       .then([this](append_entries_request req) mutable {
           vlog(_ctxlog.trace, "Self append entries - {}", req.meta);
-          return _ptr->disk_append(std::move(req.batches));
+          auto start = produce_latency_probe::clock_type::now();
+          return _ptr
+            ->disk_append(
+              std::move(req.batches), consensus::update_window::yes)
+            .then([this, start](storage::append_result res) {
+                _ptr->_produce_latency.record(
+                  produce_latency_probe::stage::local_append,
+                  produce_latency_probe::clock_type::now() - start);
+                return res;
+            });
       })
       .then([](storage::append_result res) {
           return result<storage::append_result>(std::move(res));
@@ -146,36 +177,78 @@ inline bool replicate_entries_stm::is_follower_recovering(model::node_id id) {
     return id != _ptr->self() && _ptr->_fstats.get(id).is_recovering;
 }
 
+/// a follower slower than the others accumulates the rounds it did not reply
+/// to yet. past the limit it is skipped, the next request it is sent then
+/// fails and recovery catches it up from the log, so quorum writes do not
+/// wait on it and the leader does not hold more of its rounds in memory.
+/// a single round larger than the limit is still sent to an idle follower
+bool replicate_entries_stm::is_follower_throttled(model::node_id id) {
+    const auto& meta = _ptr->_fstats.get(id);
+    return _req_bytes > 0 && meta.inflight_bytes > 0
+           && meta.inflight_bytes + _req_bytes
+                > config::shard_local_cfg()
+                    .raft_max_inflight_bytes_per_follower();
+}
+
 ss::future<result<replicate_result>>
 replicate_entries_stm::apply(ss::semaphore_units<> u) {
-    // first append lo leader log, no flushing
+    std::vector<ss::semaphore_units<>> vec;
+    vec.push_back(std::move(u));
+    auto units = ss::make_lw_shared<std::vector<ss::semaphore_units<>>>(
+      std::move(vec));
+    /*
+     * the request carries the offset and term of the leader log before the
+     * round, so followers are sent the round while it is appended to the
+     * leader log. the leader flushes it once appended. commit index only
+     * counts the flushed offset of the leader as one of the voters, a quorum
+     * of followers commits the round before the leader flush finishes.
+     */
+    uint16_t requests_count = 0;
+    _ptr->config().for_each_broker(
+      [this, &requests_count, units](const model::broker& n) {
+          if (n.id() == _ptr->self()) {
+              return;
+          }
+          // We are not dispatching request to followers that are
+          // recovering
+          if (is_follower_recovering(n.id())) {
+              vlog(
+                _ctxlog.trace,
+                "Skipping sending append request to {}, recovering",
+                n.id());
+              return;
+          }
+          if (is_follower_throttled(n.id())) {
+              vlog(
+                _ctxlog.debug,
+                "Skipping sending append request to {}, {} bytes in flight",
+                n.id(),
+                _ptr->_fstats.get(n.id()).inflight_bytes);
+              _ptr->_probe.follower_append_throttled();
+              return;
+          }
+          ++requests_count;
+          (void)dispatch_one(n.id(), units); // background
+      });
     return append_to_self()
-      .then([this, u = std::move(u)](
+      .then([this, requests_count, units](
               result<storage::append_result> append_result) mutable {
-          if (!append_result) {
-              return ss::make_ready_future<result<storage::append_result>>(
-                append_result);
+          if (append_result) {
+              // leader flush
+              ++requests_count;
+              (void)dispatch_one(_ptr->self(), units); // background
+          } else {
+              /*
+               * followers may have appended the round already, the leader
+               * must not append different entries of the same term at the
+               * same offsets. the next election settles the log.
+               */
+              vlog(
+                _ctxlog.warn,
+                "Stepping down, leader append failed in term {}",
+                _ptr->term());
+              _ptr->do_step_down();
           }
-          // dispatch requests to followers & leader flush
-          std::vector<ss::semaphore_units<>> vec;
-          vec.push_back(std::move(u));
-          auto units = ss::make_lw_shared<std::vector<ss::semaphore_units<>>>(
-            std::move(vec));
-          uint16_t requests_count = 0;
-          _ptr->config().for_each_broker(
-            [this, &requests_count, units](const model::broker& n) {
-                // We are not dispatching request to followers that are
-                // recovering
-                if (is_follower_recovering(n.id())) {
-                    vlog(
-                      _ctxlog.trace,
-                      "Skipping sending append request to {}, recovering",
-                      n.id());
-                    return;
-                }
-                ++requests_count;
-                (void)dispatch_one(n.id(), units); // background
-            });
           // Wait until all RPCs will be dispatched
           return _dispatch_sem.wait(requests_count)
             .then([append_result, units]() mutable { return append_result; });
@@ -201,6 +274,12 @@ replicate_entries_stm::apply(ss::semaphore_units<> u) {
           };
           return _ptr->_commit_index_updated.wait(stop_cond).then(
             [this, appended_offset, appended_term] {
+                if (_ptr->committed_offset() >= appended_offset) {
+                    _ptr->_produce_latency.record(
+                      produce_latency_probe::stage::commit_notify,
+                      produce_latency_probe::clock_type::now()
+                        - _ptr->_commit_index_updated_at);
+                }
                 return process_result(appended_offset, appended_term);
             });
       });
@@ -240,10 +319,12 @@ ss::future<> replicate_entries_stm::wait() { return _req_bg.close(); }
 replicate_entries_stm::replicate_entries_stm(
   consensus* p,
   append_entries_request r,
-  absl::flat_hash_map<model::node_id, follower_req_seq> seqs)
+  absl::flat_hash_map<model::node_id, follower_req_seq> seqs,
+  size_t bytes)
   : _ptr(p)
   , _req(std::move(r))
   , _followers_seq(std::move(seqs))
+  , _req_bytes(bytes)
   , _share_sem(1)
   , _ctxlog(_ptr->_ctxlog) {}
 
@@ -41,9 +41,10 @@ namespace raft {
 ///    3) current node is not the leader (FAILURE)
 ///
 ///  Algorithm steps:
-///    1) Append entry to leader log without flush
-///    2) Dispatch append entries RPC calls to followers and in parallel flush
-///       entries to leader disk
+///    1) Dispatch append entries RPC calls to followers and in parallel
+///       append entry to leader log without flush
+///    2) Once appended flush entries to leader disk, a quorum of followers
+///       may commit them before the leader flush finishes
 ///    3) Wait for (1),(2) or (3)
 ///    4) When
 ///       ->(1) reply with success
@@ -76,10 +77,12 @@ namespace raft {
 
 class replicate_entries_stm {
 public:
+    /// \param bytes size of the batches of the request
     replicate_entries_stm(
       consensus*,
       append_entries_request,
-      absl::flat_hash_map<model::node_id, follower_req_seq>);
+      absl::flat_hash_map<model::node_id, follower_req_seq>,
+      size_t bytes = 0);
     ~replicate_entries_stm();
 
     /// caller have to pass _op_sem semaphore units, the apply call will do the
@@ -105,6 +108,7 @@ private:
       send_append_entries_request(model::node_id, append_entries_request);
     result<replicate_result> process_result(model::offset, model::term_id);
     bool is_follower_recovering(model::node_id);
+    bool is_follower_throttled(model::node_id);
     clock_type::time_point append_entries_timeout();
     /// This append will happen under the lock
     ss::future<result<storage::append_result>> append_to_self();
@@ -112,6 +116,7 @@ private:
     /// we keep a copy around until we finish the retries
     append_entries_request _req;
     absl::flat_hash_map<model::node_id, follower_req_seq> _followers_seq;
+    size_t _req_bytes;
     ss::semaphore _share_sem;
     ss::semaphore _dispatch_sem{0};
     ss::gate _req_bg;
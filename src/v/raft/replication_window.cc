@@ -0,0 +1,72 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/replication_window.h"
+
+#include <algorithm>
+
+namespace raft {
+
+void replication_window::append(model::record_batch& batch) {
+    const size_t bytes = batch.size_bytes();
+    if (bytes > _max_bytes) {
+        clear();
+        return;
+    }
+    // a gap, e.g. after the log was truncated, breaks the range
+    if (
+      !_batches.empty()
+      && batch.base_offset() != _batches.back().last_offset() + 1) {
+        clear();
+    }
+    evict_to(_max_bytes - bytes);
+    _batches.push_back(batch.share());
+    _bytes += bytes;
+}
+
+std::optional<ss::circular_buffer<model::record_batch>>
+replication_window::read(
+  model::offset start, model::offset end, size_t max_bytes) {
+    if (
+      _batches.empty() || start < _batches.front().base_offset()
+      || start > _batches.back().last_offset()) {
+        ++_stats.misses;
+        return std::nullopt;
+    }
+    ++_stats.hits;
+    auto it = std::lower_bound(
+      _batches.begin(),
+      _batches.end(),
+      start,
+      [](const model::record_batch& b, model::offset o) {
+          return b.last_offset() < o;
+      });
+    ss::circular_buffer<model::record_batch> ret;
+    size_t bytes = 0;
+    for (; it != _batches.end() && it->base_offset() <= end; ++it) {
+        const size_t batch_bytes = it->size_bytes();
+        if (!ret.empty() && bytes + batch_bytes > max_bytes) {
+            break;
+        }
+        bytes += batch_bytes;
+        ret.push_back(it->share());
+    }
+    return ret;
+}
+
+void replication_window::clear() { evict_to(0); }
+
+void replication_window::evict_to(size_t bytes) {
+    while (_bytes > bytes) {
+        _bytes -= static_cast<size_t>(_batches.front().size_bytes());
+        _batches.pop_front();
+    }
+}
+
+} // namespace raft
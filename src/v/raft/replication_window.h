@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "seastarx.h"
+
+#include <seastar/core/circular_buffer.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace raft {
+
+/**
+ * Batches the leader appended last, kept so that followers a little behind
+ * are recovered from memory rather than by reading the log.
+ *
+ * The window holds shares of the buffers of the appended batches, no data is
+ * copied, and is bounded by max_bytes. It only holds a contiguous range of
+ * offsets ending at the last batch appended, the oldest batches are dropped
+ * first.
+ */
+class replication_window {
+public:
+    struct stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+    };
+
+    explicit replication_window(size_t max_bytes) noexcept
+      : _max_bytes(max_bytes) {}
+
+    /// \brief batch appended to the log, offsets already assigned
+    void append(model::record_batch&);
+
+    /// \brief batches from the one holding `start` up to `end`, or to
+    /// `max_bytes` but at least one, when the window holds `start`
+    std::optional<ss::circular_buffer<model::record_batch>>
+    read(model::offset start, model::offset end, size_t max_bytes);
+
+    void clear();
+
+    size_t max_bytes() const { return _max_bytes; }
+    size_t size_bytes() const { return _bytes; }
+    const stats& get_stats() const { return _stats; }
+
+private:
+    void evict_to(size_t bytes);
+
+    size_t _max_bytes;
+    size_t _bytes{0};
+    ss::circular_buffer<model::record_batch> _batches;
+    stats _stats;
+};
+
+} // namespace raft
@@ -9,6 +9,7 @@
 
 #include "raft/rpc_client_protocol.h"
 
+#include "config/configuration.h"
 #include "outcome_future_utils.h"
 #include "raft/raftgen_service.h"
 #include "rpc/connection_cache.h"
@@ -16,6 +17,11 @@
 #include "rpc/transport.h"
 #include "rpc/types.h"
 
+#include <seastar/core/future-util.hh>
+
+#include <algorithm>
+#include <iterator>
+
 namespace raft {
 
 ss::future<result<vote_reply>> rpc_client_protocol::vote(
@@ -32,6 +38,93 @@ ss::future<result<vote_reply>> rpc_client_protocol::vote(
 }
 
 ss::future<result<append_entries_reply>> rpc_client_protocol::append_entries(
+  model::node_id n, append_entries_request&& r, rpc::client_opts opts) {
+    if (!config::shard_local_cfg().raft_batch_append_entries()) {
+        return send_append_entries(n, std::move(r), std::move(opts));
+    }
+    auto& queue = _append_queues[n];
+    queue.pending.push_back(
+      pending_append{std::move(r), std::move(opts), {}});
+    auto f = queue.pending.back().done.get_future();
+    if (!queue.flush_scheduled) {
+        queue.flush_scheduled = true;
+        // requests of the other groups dispatched in this cycle join the
+        // batch, the queue of a node is flushed in order
+        (void)ss::later().then([self = shared_from_this(), n] {
+            self->flush_appends(n, self->_append_queues[n]);
+        });
+    }
+    return f;
+}
+
+void rpc_client_protocol::flush_appends(model::node_id n, append_queue& q) {
+    auto pending = std::exchange(q.pending, {});
+    q.flush_scheduled = false;
+    for (size_t i = 0; i < pending.size(); i += max_batch_requests) {
+        auto begin = std::make_move_iterator(pending.begin() + i);
+        auto end = std::make_move_iterator(
+          pending.begin() + std::min(pending.size(), i + max_batch_requests));
+        send_batch(n, std::vector<pending_append>(begin, end));
+    }
+}
+
+void rpc_client_protocol::send_batch(
+  model::node_id n, std::vector<pending_append> batch) {
+    if (batch.size() == 1) {
+        auto& p = batch.front();
+        (void)send_append_entries(n, std::move(p.request), std::move(p.opts))
+          .forward_to(std::move(p.done));
+        return;
+    }
+    append_entries_batch_request req;
+    req.requests.reserve(batch.size());
+    std::vector<ss::promise<result<append_entries_reply>>> done;
+    done.reserve(batch.size());
+    // the batch times out with the first of its requests
+    auto opts = std::move(batch.front().opts);
+    for (auto& p : batch) {
+        opts.timeout = std::min(opts.timeout, p.opts.timeout);
+        req.requests.push_back(std::move(p.request));
+        done.push_back(std::move(p.done));
+    }
+    using ret_t = result<append_entries_batch_reply>;
+    (void)_connection_cache.local()
+      .with_node_client<raftgen_client_protocol>(
+        _self,
+        ss::this_shard_id(),
+        n,
+        [req = std::move(req),
+         opts = std::move(opts)](raftgen_client_protocol client) mutable {
+            return client.append_entries_batch(std::move(req), std::move(opts))
+              .then(&rpc::get_ctx_data<append_entries_batch_reply>);
+        })
+      .then_wrapped([done = std::move(done)](ss::future<ret_t> f) mutable {
+          if (f.failed()) {
+              auto e = f.get_exception();
+              for (auto& p : done) {
+                  p.set_exception(e);
+              }
+              return;
+          }
+          auto r = f.get0();
+          if (!r || r.value().replies.size() != done.size()) {
+              auto ec = r ? make_error_code(errc::append_entries_dispatch_error)
+                          : r.error();
+              for (auto& p : done) {
+                  p.set_value(result<append_entries_reply>(ec));
+              }
+              return;
+          }
+          auto& replies = r.value().replies;
+          for (size_t i = 0; i < done.size(); ++i) {
+              done[i].set_value(
+                result<append_entries_reply>(std::move(replies[i])));
+          }
+      });
+}
+
+ss::future<result<append_entries_reply>>
+rpc_client_protocol::send_append_entries(
   model::node_id n, append_entries_request&& r, rpc::client_opts opts) {
     return _connection_cache.local().with_node_client<raftgen_client_protocol>(
       _self,
@@ -20,13 +20,28 @@
 #include "rpc/connection_cache.h"
 #include "rpc/transport.h"
 
+#include <seastar/core/shared_ptr.hh>
+
+#include <absl/container/flat_hash_map.h>
+
 #include <system_error>
+#include <vector>
 
 namespace raft {
 
 /// Raft client protocol implementation underlied by RPC connections cache
-class rpc_client_protocol final : public consensus_client_protocol::impl {
+///
+/// Append entries requests of all the groups of the shard sent to the same
+/// node in the same reactor cycle are packed into one append_entries_batch
+/// rpc of up to max_batch_requests requests, the node applies the requests
+/// of each group in the order they were sent. A request alone is sent with
+/// the append_entries rpc.
+class rpc_client_protocol final
+  : public consensus_client_protocol::impl
+  , public ss::enable_shared_from_this<rpc_client_protocol> {
 public:
+    static constexpr size_t max_batch_requests = 64;
+
     explicit rpc_client_protocol(
       model::node_id self, ss::sharded<rpc::connection_cache>& cache)
       : _self(self)
@@ -48,8 +63,25 @@ public:
     timeout_now(model::node_id, timeout_now_request&&, rpc::client_opts) final;
 
 private:
+    struct pending_append {
+        append_entries_request request;
+        rpc::client_opts opts;
+        ss::promise<result<append_entries_reply>> done;
+    };
+    // requests to a node waiting for the next batch
+    struct append_queue {
+        std::vector<pending_append> pending;
+        bool flush_scheduled{false};
+    };
+
+    ss::future<result<append_entries_reply>> send_append_entries(
+      model::node_id, append_entries_request&&, rpc::client_opts);
+    void flush_appends(model::node_id, append_queue&);
+    void send_batch(model::node_id, std::vector<pending_append>);
+
     model::node_id _self;
     ss::sharded<rpc::connection_cache>& _connection_cache;
+    absl::flat_hash_map<model::node_id, append_queue> _append_queues;
 };
 
 inline consensus_client_protocol make_rpc_client_protocol(
@@ -0,0 +1,30 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/rtt_window.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace raft {
+
+std::optional<duration_type> rtt_window::percentile(double p) const {
+    if (_size < min_samples) {
+        return std::nullopt;
+    }
+    auto sorted = _samples;
+    auto end = sorted.begin() + _size;
+    // nearest rank
+    const auto rank = static_cast<size_t>(std::ceil(p * _size));
+    auto nth = sorted.begin() + std::clamp<size_t>(rank, 1, _size) - 1;
+    std::nth_element(sorted.begin(), nth, end);
+    return *nth;
+}
+
+} // namespace raft
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "raft/types.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+namespace raft {
+
+/**
+ * Round trip times of the last heartbeats sent to a node.
+ *
+ * Holds the `capacity` most recent samples, new ones overwrite the oldest.
+ * Percentiles are only reported once `min_samples` were recorded, so that a
+ * few samples taken while a connection is established do not decide the
+ * election timeout.
+ */
+class rtt_window {
+public:
+    static constexpr size_t capacity = 64;
+    static constexpr size_t min_samples = 8;
+
+    void record(duration_type rtt) {
+        _samples[_next] = rtt;
+        _next = (_next + 1) % capacity;
+        if (_size < capacity) {
+            ++_size;
+        }
+    }
+
+    /// \brief rtt no more than `p` (in [0, 1]) of the samples exceed
+    std::optional<duration_type> percentile(double p) const;
+
+    size_t size() const { return _size; }
+
+private:
+    std::array<duration_type, capacity> _samples{};
+    size_t _next{0};
+    size_t _size{0};
+};
+
+} // namespace raft
@@ -17,6 +17,7 @@
 #include "seastarx.h"
 #include "utils/copy_range.h"
 
+#include <seastar/core/loop.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/shared_ptr.hh>
 
@@ -139,6 +140,15 @@ public:
         });
     }
 
+    [[gnu::always_inline]] ss::future<append_entries_batch_reply>
+    append_entries_batch(
+      append_entries_batch_request&& r, rpc::streaming_context&) final {
+        return _probe.append_entries_batch().then(
+          [this, r = std::move(r)]() mutable {
+              return dispatch_append_entries_batch(std::move(r.requests));
+          });
+    }
+
     [[gnu::always_inline]] ss::future<install_snapshot_reply> install_snapshot(
       install_snapshot_request&& r, rpc::streaming_context&) final {
         return _probe.install_snapshot().then([this,
@@ -173,6 +183,13 @@ private:
         absl::flat_hash_map<ss::shard_id, hbeats_ptr> shard_requests;
         std::vector<append_entries_request> group_missing_requests;
     };
+    // requests of a batch with their position in it
+    using indexed_requests
+      = std::vector<std::pair<size_t, append_entries_request>>;
+    using indexed_requests_ptr
+      = ss::foreign_ptr<std::unique_ptr<indexed_requests>>;
+    using indexed_replies
+      = std::vector<std::pair<size_t, append_entries_reply>>;
 
     static ss::future<vote_reply> make_failed_vote_reply() {
         return ss::make_ready_future<vote_reply>(vote_reply{
@@ -280,6 +297,102 @@ private:
         return ret;
     }
 
+    ss::future<append_entries_batch_reply>
+    dispatch_append_entries_batch(std::vector<append_entries_request> reqs) {
+        append_entries_batch_reply ret;
+        ret.replies.resize(reqs.size());
+        absl::flat_hash_map<ss::shard_id, indexed_requests_ptr> shard_requests;
+        for (size_t i = 0; i < reqs.size(); ++i) {
+            auto group = reqs[i].target_group();
+            if (unlikely(!_shard_table.contains(group))) {
+                ret.replies[i] = append_entries_reply{
+                  .group = group,
+                  .result = append_entries_reply::status::group_unavailable};
+                continue;
+            }
+            auto shard = _shard_table.shard_for(group);
+            auto it = shard_requests.find(shard);
+            if (it == shard_requests.end()) {
+                it = shard_requests
+                       .emplace(
+                         shard,
+                         ss::make_foreign(
+                           std::make_unique<indexed_requests>()))
+                       .first;
+            }
+            it->second->emplace_back(
+              i, append_entries_request::make_foreign(std::move(reqs[i])));
+        }
+
+        std::vector<ss::future<indexed_replies>> futures;
+        futures.reserve(shard_requests.size());
+        for (auto& [shard, req] : shard_requests) {
+            // dispatch to each core in parallel
+            futures.push_back(dispatch_batch_to_core(shard, std::move(req)));
+        }
+        return ss::when_all_succeed(futures.begin(), futures.end())
+          .then([ret = std::move(ret)](
+                  std::vector<indexed_replies> replies) mutable {
+              for (auto& part : replies) {
+                  for (auto& [idx, reply] : part) {
+                      ret.replies[idx] = std::move(reply);
+                  }
+              }
+              return std::move(ret);
+          });
+    }
+
+    ss::future<indexed_replies>
+    dispatch_batch_to_core(ss::shard_id shard, indexed_requests_ptr requests) {
+        return with_scheduling_group(
+          get_scheduling_group(),
+          [this, shard, r = std::move(requests)]() mutable {
+              return _group_manager.invoke_on(
+                shard,
+                get_smp_service_group(),
+                [this, r = std::move(r)](ConsensusManager& m) mutable {
+                    return dispatch_batch_to_groups(m, std::move(r));
+                });
+          });
+    }
+
+    /// groups are appended in parallel, the requests of a group one after
+    /// the other in the order they were sent
+    ss::future<indexed_replies>
+    dispatch_batch_to_groups(ConsensusManager& m, indexed_requests_ptr reqs) {
+        absl::flat_hash_map<group_id, std::vector<size_t>> by_group;
+        for (size_t i = 0; i < reqs->size(); ++i) {
+            by_group[(*reqs)[i].second.target_group()].push_back(i);
+        }
+        indexed_replies replies;
+        replies.reserve(reqs->size());
+        return ss::do_with(
+          std::move(reqs),
+          std::move(by_group),
+          std::move(replies),
+          [this, &m](
+            indexed_requests_ptr& reqs,
+            absl::flat_hash_map<group_id, std::vector<size_t>>& by_group,
+            indexed_replies& replies) {
+              return ss::parallel_for_each(
+                       by_group,
+                       [this, &m, &reqs, &replies](auto& group_requests) {
+                           return ss::do_for_each(
+                             group_requests.second,
+                             [this, &m, &reqs, &replies](size_t i) {
+                                 auto idx = (*reqs)[i].first;
+                                 return dispatch_append_entries(
+                                          m, std::move((*reqs)[i].second))
+                                   .then([&replies,
+                                          idx](append_entries_reply r) {
+                                       replies.emplace_back(idx, std::move(r));
+                                   });
+                             });
+                       })
+                .then([&replies] { return std::move(replies); });
+          });
+    }
+
     ss::future<append_entries_reply>
     dispatch_append_entries(ConsensusManager& m, append_entries_request&& r) {
         auto group = group_id(r.meta.group);
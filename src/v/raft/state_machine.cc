@@ -9,12 +9,25 @@
 
 #include "raft/state_machine.h"
 
+#include "bytes/iobuf_parser.h"
+#include "config/configuration.h"
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
+#include "prometheus/prometheus_sanitize.h"
 #include "raft/consensus.h"
+#include "raft/probe.h"
+#include "raft/types.h"
+#include "reflection/adl.h"
 #include "storage/log.h"
 #include "storage/record_batch_builder.h"
 
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics.hh>
+
+#include <utility>
+
 namespace raft {
 
 state_machine::state_machine(
@@ -23,10 +36,13 @@ state_machine::state_machine(
   , _io_prio(io_prio)
   , _log(log)
   , _next(0)
-  , _bootstrap_last_applied(_raft->read_last_applied()) {}
+  , _bootstrap_last_applied(_raft->read_last_applied())
+  // batch sizes up to 128MiB at two significant figures
+  , _batch_size(128_MiB, 1, 2) {}
 
 ss::future<> state_machine::start() {
     vlog(_log.info, "Starting state machine");
+    setup_metrics();
     (void)ss::with_gate(_gate, [this] {
         return ss::do_until(
           [this] { return _gate.is_closed(); }, [this] { return apply(); });
@@ -35,6 +51,7 @@ ss::future<> state_machine::start() {
 }
 
 ss::future<> state_machine::stop() {
+    _metrics.clear();
     _waiters.stop();
     _as.request_abort();
     return _gate.close();
@@ -47,6 +64,11 @@ ss::future<> state_machine::wait(
     });
 }
 
+void state_machine::skip_applied(model::offset offset) {
+    _next = offset + model::offset(1);
+    _waiters.notify(offset);
+}
+
 model::offset state_machine::bootstrap_last_applied() const {
     return _bootstrap_last_applied;
 }
@@ -60,17 +82,137 @@ state_machine::batch_applicator::operator()(model::record_batch batch) {
         return ss::make_ready_future<ss::stop_iteration>(
           ss::stop_iteration::yes);
     }
+    _batches_bytes += batch.size_bytes();
+    _batches.push_back(std::move(batch));
+    if (
+      _batches.size() < max_apply_batches
+      && _batches_bytes < max_apply_bytes) {
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::no);
+    }
+    return flush().then([] { return ss::stop_iteration::no; });
+}
+
+ss::future<model::offset> state_machine::batch_applicator::end_of_stream() {
+    if (_batches.empty() || _machine->stop_batch_applicator()) {
+        return ss::make_ready_future<model::offset>(_last_applied);
+    }
+    return flush().then([this] { return _last_applied; });
+}
 
-    auto last_offset = batch.last_offset();
-    return _machine->apply(std::move(batch)).then([this, last_offset] {
-        _last_applied = last_offset;
-        _machine->_waiters.notify(_last_applied);
-        return ss::stop_iteration::no;
-    });
+ss::future<> state_machine::batch_applicator::flush() {
+    auto last_offset = _batches.back().last_offset();
+    std::vector<size_t> sizes;
+    sizes.reserve(_batches.size());
+    for (const auto& b : _batches) {
+        sizes.push_back(b.size_bytes());
+    }
+    _batches_bytes = 0;
+    return _machine->apply_batches(std::exchange(_batches, {}))
+      .then([this, last_offset, sizes = std::move(sizes)] {
+          _machine->batches_applied(last_offset, sizes);
+          _last_applied = last_offset;
+          // a failure of a later group applies the batches from here again
+          _machine->_next = last_offset + model::offset(1);
+          _machine->_waiters.notify(_last_applied);
+      });
+}
+
+ss::future<>
+state_machine::apply_batches(std::vector<model::record_batch> batches) {
+    return ss::do_with(
+      std::move(batches), [this](std::vector<model::record_batch>& batches) {
+          return ss::do_for_each(batches, [this](model::record_batch& b) {
+              return apply(std::move(b));
+          });
+      });
 }
 
 bool state_machine::stop_batch_applicator() { return _gate.is_closed(); }
 
+void state_machine::batches_applied(
+  model::offset last_applied, const std::vector<size_t>& sizes) {
+    _applied_batches += sizes.size();
+    for (auto s : sizes) {
+        _applied_bytes += s;
+        _batch_size.record(s);
+    }
+    if (last_applied >= _raft->committed_offset()) {
+        _behind_since.reset();
+    }
+}
+
+uint64_t state_machine::apply_lag_offsets() const {
+    const auto committed = _raft->committed_offset();
+    const auto applied = _next - model::offset(1);
+    return committed > applied ? (committed - applied)() : 0;
+}
+
+std::chrono::milliseconds state_machine::apply_lag() const {
+    if (!_behind_since || apply_lag_offsets() == 0) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+      ss::lowres_clock::now() - *_behind_since);
+}
+
+void state_machine::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    auto labels = probe::create_metric_labels(_raft->ntp());
+    labels.push_back(sm::label("state_machine")(_log.name()));
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("raft:state_machine"),
+      {sm::make_gauge(
+         "apply_lag_offsets",
+         [this] { return apply_lag_offsets(); },
+         sm::description("Committed offsets not applied to the state machine"),
+         labels),
+       sm::make_gauge(
+         "apply_lag_ms",
+         [this] { return apply_lag().count(); },
+         sm::description("Milliseconds the state machine has been behind the "
+                         "commit index"),
+         labels),
+       sm::make_derive(
+         "applied_batches",
+         [this] { return _applied_batches; },
+         sm::description("Number of batches applied"),
+         labels),
+       sm::make_derive(
+         "applied_bytes",
+         [this] { return _applied_bytes; },
+         sm::description("Bytes of the batches applied"),
+         labels),
+       sm::make_histogram(
+         "applied_batch_size_bytes",
+         [this] { return _batch_size.seastar_histogram_logform(); },
+         sm::description("Sizes of the batches applied"),
+         labels),
+       sm::make_derive(
+         "snapshots_written",
+         [this] { return _snapshot_stats.written; },
+         sm::description("Number of snapshots written"),
+         labels),
+       sm::make_derive(
+         "snapshots_loaded",
+         [this] { return _snapshot_stats.loaded; },
+         sm::description("Number of snapshots loaded"),
+         labels),
+       sm::make_gauge(
+         "snapshot_size_bytes",
+         [this] { return _snapshot_stats.written_bytes; },
+         sm::description("Size of the last snapshot written"),
+         labels),
+       sm::make_gauge(
+         "snapshot_load_ms",
+         [this] { return _snapshot_stats.load_time.count(); },
+         sm::description("Milliseconds it took to load the last snapshot"),
+         labels)});
+}
+
 model::record_batch_reader make_checkpoint() {
     storage::record_batch_builder builder(
       state_machine::checkpoint_batch_type, model::offset(0));
@@ -102,6 +244,14 @@ ss::future<> state_machine::apply() {
     // wait until consensus commit index is >= _next
     return _raft->events()
       .wait(_next, model::no_timeout, _as)
+      .then([this] {
+          // committed up to _next at least, the lag starts now if applying
+          // was caught up
+          if (!_behind_since) {
+              _behind_since = ss::lowres_clock::now();
+          }
+          return maybe_load_snapshot();
+      })
       .then([this] {
           // build a reader for log range [_next, +inf).
           storage::log_reader_config config(
@@ -123,6 +273,91 @@ ss::future<> state_machine::apply() {
       });
 }
 
+ss::future<> state_machine::maybe_load_snapshot() {
+    // batches up to the snapshot may be gone from the log
+    if (_raft->last_snapshot_index() < _next) {
+        return ss::now();
+    }
+    return _raft->open_snapshot().then(
+      [this](std::optional<storage::snapshot_reader> reader) {
+          if (!reader) {
+              return ss::now();
+          }
+          return ss::do_with(
+            std::move(*reader), [this](storage::snapshot_reader& reader) {
+                return load_snapshot(reader).finally(
+                  [&reader] { return reader.close(); });
+            });
+      });
+}
+
+static ss::future<iobuf> read_to_end(ss::input_stream<char>& in) {
+    return ss::do_with(iobuf{}, [&in](iobuf& data) {
+        return ss::repeat([&in, &data] {
+                   return in.read().then([&data](ss::temporary_buffer<char> b) {
+                       if (b.empty()) {
+                           return ss::stop_iteration::yes;
+                       }
+                       data.append(std::move(b));
+                       return ss::stop_iteration::no;
+                   });
+               })
+          .then([&data] { return std::move(data); });
+    });
+}
+
+ss::future<> state_machine::load_snapshot(storage::snapshot_reader& reader) {
+    auto start = ss::lowres_clock::now();
+    return reader.read_metadata()
+      .then([&reader](iobuf buf) {
+          auto parser = iobuf_parser(std::move(buf));
+          auto md = reflection::adl<snapshot_metadata>{}.from(parser);
+          return read_to_end(reader.input())
+            .then([offset = md.last_included_index](iobuf data) {
+                return std::make_pair(offset, std::move(data));
+            });
+      })
+      .then([this, start](std::pair<model::offset, iobuf> snapshot) {
+          const auto offset = snapshot.first;
+          auto& data = snapshot.second;
+          if (offset < _next) {
+              return ss::now();
+          }
+          vlog(
+            _log.info,
+            "Loading snapshot of {} bytes up to offset {}",
+            data.size_bytes(),
+            offset);
+          const size_t size = data.size_bytes();
+          return apply_snapshot(offset, std::move(data))
+            .then([this, offset, size, start] {
+                _next = offset + model::offset(1);
+                _waiters.notify(offset);
+                if (offset >= _raft->committed_offset()) {
+                    _behind_since.reset();
+                }
+                ++_snapshot_stats.loaded;
+                _snapshot_stats.loaded_bytes = size;
+                _snapshot_stats.load_time
+                  = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    ss::lowres_clock::now() - start);
+            });
+      });
+}
+
+ss::future<> state_machine::apply_snapshot(model::offset, iobuf) {
+    return ss::now();
+}
+
+ss::future<> state_machine::write_snapshot(model::offset o, iobuf data) {
+    const size_t size = data.size_bytes();
+    return _raft->write_snapshot(write_snapshot_cfg(o, std::move(data)))
+      .then([this, size] {
+          ++_snapshot_stats.written;
+          _snapshot_stats.written_bytes = size;
+      });
+}
+
 ss::future<> state_machine::write_last_applied(model::offset o) {
     return _raft->write_last_applied(o);
 }
@@ -17,12 +17,21 @@
 #include "raft/offset_monitor.h"
 #include "raft/types.h"
 #include "seastarx.h"
+#include "storage/snapshot.h"
+#include "units.h"
+#include "utils/hdr_hist.h"
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/file.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/util/log.hh>
 
+#include <chrono>
+#include <optional>
+#include <vector>
+
 namespace raft {
 
 class consensus;
@@ -53,10 +62,17 @@ class consensus;
  * The state machine tracks which batches have been applied. Use the `wait`
  * primitive to wait until a particular log offset has been applied to the state
  * machine.
+ *
+ * Metrics of the state machine are labeled with the ntp of the group and the
+ * name of its logger. They report how far applying trails the commit index,
+ * in offsets and in time, the applied batches and their sizes, and the
+ * snapshots written and loaded.
  */
 class state_machine {
 public:
     static constexpr model::record_batch_type checkpoint_batch_type{5};
+    static constexpr size_t max_apply_batches = 64;
+    static constexpr size_t max_apply_bytes = 1_MiB;
     state_machine(consensus*, ss::logger& log, ss::io_priority_class io_prio);
 
     // start after ready to receive batches through apply upcall.
@@ -73,6 +89,14 @@ public:
      * is returned an error is logged and the same batch will be applied again.
      */
     virtual ss::future<> apply(model::record_batch) = 0;
+    /**
+     * Batches read from the log are applied in groups of up to
+     * max_apply_batches or max_apply_bytes, in offset order. The default
+     * applies them one at a time with apply(record_batch). State machines
+     * that know which batches are independent may override it to apply them
+     * concurrently, the group is complete when the returned future is.
+     */
+    virtual ss::future<> apply_batches(std::vector<model::record_batch>);
     /**
      * Return last applied offset established when STM starts. This can be used
      * to wait for the entries to be applied when STM is starting.
@@ -88,22 +112,70 @@ public:
     ss::future<result<replicate_result>>
       quorum_write_empty_batch(model::timeout_clock::time_point);
 
+    /**
+     * Replaces the state with a snapshot written by write_snapshot() which
+     * includes every batch up to the offset. It is loaded before the batches
+     * that follow it are applied, at startup once the log was prefix
+     * truncated or when the leader installed a snapshot. The default ignores
+     * snapshots.
+     */
+    virtual ss::future<> apply_snapshot(model::offset, iobuf);
+    /**
+     * Persists a snapshot of the state which includes every batch up to an
+     * applied offset and prefix truncates the log up to it.
+     */
+    ss::future<> write_snapshot(model::offset, iobuf);
+
+    struct snapshot_stats {
+        uint64_t written{0};
+        uint64_t loaded{0};
+        // sizes of the last snapshot written and loaded
+        size_t written_bytes{0};
+        size_t loaded_bytes{0};
+        std::chrono::milliseconds load_time{0};
+    };
+    const snapshot_stats& get_snapshot_stats() const {
+        return _snapshot_stats;
+    }
+
+    /// committed offsets not applied yet
+    uint64_t apply_lag_offsets() const;
+    /// time since the first committed offset not applied yet was committed,
+    /// zero when the state machine is caught up
+    std::chrono::milliseconds apply_lag() const;
+
+protected:
+    /**
+     * The state already includes the batches up to the offset, e.g. it was
+     * restored from a snapshot the state machine keeps itself. Applying
+     * starts after the offset, it must be called before start().
+     */
+    void skip_applied(model::offset);
+
 private:
     class batch_applicator {
     public:
         explicit batch_applicator(state_machine*);
         ss::future<ss::stop_iteration> operator()(model::record_batch);
-        model::offset end_of_stream() const { return _last_applied; }
+        ss::future<model::offset> end_of_stream();
 
     private:
+        ss::future<> flush();
+
         state_machine* _machine;
         model::offset _last_applied;
+        std::vector<model::record_batch> _batches;
+        size_t _batches_bytes{0};
     };
 
     friend batch_applicator;
 
     ss::future<> apply();
     bool stop_batch_applicator();
+    ss::future<> maybe_load_snapshot();
+    ss::future<> load_snapshot(storage::snapshot_reader&);
+    void batches_applied(model::offset, const std::vector<size_t>&);
+    void setup_metrics();
 
     consensus* _raft;
     ss::io_priority_class _io_prio;
@@ -113,6 +185,13 @@ private:
     ss::abort_source _as;
     ss::gate _gate;
     model::offset _bootstrap_last_applied;
+    snapshot_stats _snapshot_stats;
+    // set once the commit index is past the applied offsets
+    std::optional<ss::lowres_clock::time_point> _behind_since;
+    uint64_t _applied_batches{0};
+    uint64_t _applied_bytes{0};
+    hdr_hist _batch_size;
+    ss::metrics::metric_groups _metrics;
 };
 
 } // namespace raft
@@ -7,6 +7,7 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "config/configuration.h"
 #include "finjector/hbadger.h"
 #include "model/fundamental.h"
 #include "model/metadata.h"
@@ -19,6 +20,7 @@
 #include "storage/tests/utils/disk_log_builder.h"
 #include "storage/tests/utils/random_batch.h"
 #include "test_utils/async.h"
+#include "units.h"
 
 #include <system_error>
 
@@ -525,3 +527,66 @@ FIXTURE_TEST(test_snapshot_recovery_last_config, raft_test_fixture) {
 
     validate_logs_replication(gr);
 };
+
+FIXTURE_TEST(test_snapshot_recovery_of_lagging_follower, raft_test_fixture) {
+    // any lag covered by the snapshot is worth installing it
+    ss::smp::invoke_on_all([] {
+        auto& cfg = config::shard_local_cfg();
+        cfg.get("recovery_snapshot_min_lag_bytes").set_value(size_t(0));
+        cfg.get("recovery_snapshot_chunks_in_flight").set_value(size_t(2));
+    }).get();
+
+    raft_group gr = raft_group(raft::group_id(0), 3);
+    gr.enable_all();
+    auto leader_id = wait_for_group_leader(gr);
+    model::node_id disabled_id;
+    for (auto& [id, _] : gr.get_members()) {
+        // disable one of the non leader nodes
+        if (leader_id != id) {
+            disabled_id = id;
+            gr.disable_node(id);
+            break;
+        }
+    }
+    bool success = replicate_random_batches(gr, 5).get0();
+    BOOST_REQUIRE(success);
+
+    tests::cooperative_spin_wait_with_timeout(2s, [&gr] {
+        auto offset
+          = gr.get_members().begin()->second.consensus->committed_offset();
+        if (offset <= model::offset(0)) {
+            return false;
+        }
+        return are_all_commit_indexes_the_same(gr);
+    }).get0();
+
+    // the leader keeps its log, the follower still gets the snapshot
+    auto snapshot_index = get_leader_raft(gr)->committed_offset();
+    for (auto& [_, member] : gr.get_members()) {
+        member.consensus
+          ->write_snapshot(raft::write_snapshot_cfg(
+            snapshot_index,
+            iobuf{},
+            raft::write_snapshot_cfg::should_prefix_truncate::no))
+          .get0();
+    }
+    gr.enable_node(disabled_id);
+    success = replicate_random_batches(gr, 5).get0();
+    BOOST_REQUIRE(success);
+
+    wait_for(
+      10s,
+      [this, &gr] { return are_all_commit_indexes_the_same(gr); },
+      "After recovery state is consistent");
+
+    // the follower log starts after the snapshot, it was not shipped the
+    // entries the snapshot covers
+    BOOST_REQUIRE_GT(
+      gr.get_member(disabled_id).log->offsets().start_offset, snapshot_index);
+
+    ss::smp::invoke_on_all([] {
+        auto& cfg = config::shard_local_cfg();
+        cfg.get("recovery_snapshot_min_lag_bytes").set_value(size_t(256_MiB));
+        cfg.get("recovery_snapshot_chunks_in_flight").set_value(size_t(4));
+    }).get();
+};
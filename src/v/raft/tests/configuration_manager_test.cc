@@ -105,7 +105,7 @@ struct config_manager_fixture {
         // compare recovered with original manager
         for (int i = 0; i < 2000; ++i) {
             auto expected = _cfg_mgr.get(model::offset(i));
-            auto have = _cfg_mgr.get(model::offset(i));
+            auto have = recovered.get(model::offset(i));
             BOOST_REQUIRE_EQUAL(expected.has_value(), have.has_value());
             if (expected.has_value()) {
                 BOOST_REQUIRE_EQUAL(expected, have);
@@ -227,3 +227,19 @@ FIXTURE_TEST(test_start_write_concurrency, config_manager_fixture) {
     BOOST_REQUIRE_EQUAL(
       new_cfg_manager.get_highest_known_offset(), model::offset(3000));
 }
+
+FIXTURE_TEST(test_recovery_from_deltas, config_manager_fixture) {
+    // enough changes for the map to be written a few times in between
+    const auto changes = 3 * raft::configuration_manager::max_deltas + 5;
+    for (size_t i = 0; i < changes; ++i) {
+        auto offset = model::offset(10 * (i + 1));
+        add_random_cfg(offset);
+        if (i % 7 == 6) {
+            _cfg_mgr.truncate(offset).get0();
+        }
+        if (i % 11 == 10) {
+            _cfg_mgr.prefix_truncate(model::offset(10 * i)).get0();
+        }
+        validate_recovery();
+    }
+}
@@ -0,0 +1,28 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/follower_lag_probe.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+SEASTAR_THREAD_TEST_CASE(lag_histogram_per_follower) {
+    raft::follower_lag_probe probe;
+    BOOST_REQUIRE(probe.histogram(model::node_id(1)) == nullptr);
+    for (uint64_t lag = 0; lag < 100; ++lag) {
+        probe.record(model::node_id(1), 0);
+        probe.record(model::node_id(2), 1000 + lag);
+    }
+    const auto* fast = probe.histogram(model::node_id(1));
+    const auto* slow = probe.histogram(model::node_id(2));
+    BOOST_REQUIRE(fast && slow);
+    BOOST_REQUIRE_EQUAL(fast->get_value_at(99.0), 0);
+    BOOST_REQUIRE_GE(slow->get_value_at(50.0), 1000);
+}
@@ -7,6 +7,7 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "config/configuration.h"
 #include "finjector/hbadger.h"
 #include "model/metadata.h"
 #include "model/timeout_clock.h"
@@ -110,4 +111,45 @@ FIXTURE_TEST(
     // wait for next leader to be elected after recovery
     wait_for_group_leader(gr);
     assert_at_most_one_leader(gr);
-};
\ No newline at end of file
+};
+FIXTURE_TEST(test_leader_lease_linearizable_reads, raft_test_fixture) {
+    // the election timeout of the fixture is twice the heartbeat interval
+    config::shard_local_cfg()
+      .get("raft_leader_lease_clock_drift_ms")
+      .set_value(std::chrono::milliseconds(20));
+    raft_group gr = raft_group(raft::group_id(0), 3);
+    gr.enable_all();
+    auto leader_id = wait_for_group_leader(gr);
+    auto leader = gr.member_consensus(leader_id);
+
+    auto res = leader->linearizable_barrier(raft::clock_type::now() + 10s)
+                 .get0();
+    BOOST_REQUIRE(res);
+    BOOST_REQUIRE_EQUAL(res.value(), leader->committed_offset());
+
+    for (auto& [id, node] : gr.get_members()) {
+        if (id == leader_id) {
+            continue;
+        }
+        BOOST_REQUIRE(!node.consensus->has_leader_lease());
+        auto r = node.consensus
+                   ->linearizable_barrier(raft::clock_type::now() + 1s)
+                   .get0();
+        BOOST_REQUIRE(r.error() == raft::errc::not_leader);
+    }
+
+    // without a majority acknowledging heartbeats the lease runs out
+    std::vector<model::node_id> followers;
+    for (auto& [id, _] : gr.get_members()) {
+        if (id != leader_id) {
+            followers.push_back(id);
+        }
+    }
+    for (auto id : followers) {
+        gr.disable_node(id);
+    }
+    res = leader->linearizable_barrier(raft::clock_type::now() + 500ms)
+            .get0();
+    BOOST_REQUIRE(!res);
+    BOOST_REQUIRE(!leader->has_leader_lease());
+};
@@ -51,6 +51,34 @@ FIXTURE_TEST(add_two_nodes_to_the_cluster, raft_test_fixture) {
     BOOST_REQUIRE_EQUAL(leader.consensus->config().brokers().size(), 3);
 };
 
+FIXTURE_TEST(added_node_promoted_before_leaving_joint, raft_test_fixture) {
+    raft_group gr = raft_group(raft::group_id(0), 1);
+    gr.enable_all();
+    auto res = replicate_random_batches(gr, 5).get0();
+    BOOST_REQUIRE(res);
+    auto new_node = gr.create_new_node(model::node_id(2));
+    res = retry_with_leader(gr, 5, 1s, [new_node](raft_node& leader) {
+              return leader.consensus->add_group_members({new_node})
+                .then([](std::error_code ec) { return !ec; });
+          }).get0();
+    BOOST_REQUIRE(res);
+
+    // the configuration only becomes simple once the learner is a voter
+    tests::cooperative_spin_wait_with_timeout(5s, [&gr] {
+        auto leader_id = gr.get_leader_id();
+        if (!leader_id) {
+            return false;
+        }
+        auto cfg = gr.get_member(*leader_id).consensus->config();
+        if (cfg.type() == raft::configuration_type::joint) {
+            return false;
+        }
+        BOOST_REQUIRE(cfg.current_config().learners.empty());
+        return cfg.is_voter(model::node_id(2));
+    }).get0();
+    validate_logs_replication(gr);
+}
+
 void verify_node_is_behind(raft_group& gr, model::node_id removed) {
     tests::cooperative_spin_wait_with_timeout(3s, [&gr, removed] {
         return ss::async([&gr, removed] {
@@ -7,6 +7,7 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "bytes/bytes.h"
 #include "model/fundamental.h"
 #include "model/record.h"
 #include "model/timeout_clock.h"
@@ -165,6 +166,27 @@ struct simple_kv {
     }
 };
 
+// applies updates of distinct keys concurrently and out of order
+template<int8_t bt>
+struct keyed_kv : simple_kv<bt> {
+    ss::future<std::error_code> apply_update(model::record_batch&& b) {
+        return ss::sleep(
+                 std::chrono::milliseconds(random_generators::get_int(5)))
+          .then([this, b = std::move(b)]() mutable {
+              return this->do_apply_update(std::move(b));
+          });
+    }
+
+    // every command starts with its key
+    std::optional<bytes> concurrency_key(const model::record_batch& b) const {
+        auto r = b.copy_records();
+        auto key = reflection::adl<ss::sstring>{}.from(
+          r.begin()->release_value());
+        // NOLINTNEXTLINE
+        return bytes(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    }
+};
+
 ss::logger kvlog{"kv-test"};
 
 template<typename T>
@@ -251,6 +273,37 @@ FIXTURE_TEST(
     BOOST_CHECK(state.kv_map.empty());
 }
 
+FIXTURE_TEST(test_replicate_batches_and_wait, mux_state_machine_fixture) {
+    start_raft();
+    simple_kv<batch_type_1> state;
+    raft::mux_state_machine stm(
+      kvlog, _raft.get(), raft::persistent_last_applied::yes, state);
+    stm.start().get0();
+    auto stop = ss::defer([&stm] { stm.stop().get0(); });
+    wait_for_leader();
+    ss::abort_source as;
+
+    std::vector<model::record_batch> batches;
+    batches.push_back(serialize_cmd(set_cmd{"a", 1}, batch_type_1));
+    batches.push_back(serialize_cmd(set_cmd{"b", 2}, batch_type_1));
+    batches.push_back(serialize_cmd(set_cmd{"a", 3}, batch_type_1));
+    auto res = stm
+                 .replicate_and_wait(
+                   std::move(batches), model::timeout_clock::now() + 2s, as)
+                 .get0();
+
+    // every batch gets the result of its own update
+    BOOST_REQUIRE_EQUAL(res.size(), 3);
+    BOOST_REQUIRE_EQUAL(res[0], errc::success);
+    BOOST_REQUIRE_EQUAL(res[1], errc::success);
+    BOOST_REQUIRE_EQUAL(res[2], errc::key_already_exists);
+    BOOST_CHECK(state.kv_map.find("a")->second == 1);
+    BOOST_CHECK(state.kv_map.find("b")->second == 2);
+    // applied up to the commit index
+    BOOST_REQUIRE_EQUAL(stm.apply_lag_offsets(), 0);
+    BOOST_REQUIRE_EQUAL(stm.apply_lag().count(), 0);
+}
+
 FIXTURE_TEST(test_concurrent_sets, mux_state_machine_fixture) {
     start_raft();
     simple_kv<batch_type_1> state;
@@ -355,6 +408,50 @@ FIXTURE_TEST(test_stm_recovery, mux_state_machine_fixture) {
     BOOST_REQUIRE_EQUAL(state.kv_map.contains("test-2"), 1);
 }
 
+FIXTURE_TEST(test_stm_concurrent_recovery, mux_state_machine_fixture) {
+    static constexpr int keys = 20;
+    {
+        auto cfg = storage::log_builder_config();
+        cfg.base_dir = _data_dir;
+        storage::disk_log_builder builder(cfg);
+        model::offset offset(0);
+        builder | storage::start(_ntp) | storage::add_segment(0);
+        auto add = [&builder, &offset](auto cmd) {
+            builder
+              .add_batch(serialize_cmd(std::move(cmd), batch_type_1, offset++))
+              .get0();
+        };
+        // commands of a key interleave with the commands of the others
+        for (int i = 0; i < keys; ++i) {
+            add(set_cmd{fmt::format("key-{}", i), i});
+        }
+        for (int step = 0; step < 3; ++step) {
+            for (int i = 0; i < keys; ++i) {
+                add(cas_cmd{fmt::format("key-{}", i), i + step, i + step + 1});
+            }
+        }
+        for (int i = 0; i < keys; i += 2) {
+            add(delete_cmd{fmt::format("key-{}", i)});
+        }
+        builder.stop().get0();
+    }
+    start_raft();
+    keyed_kv<batch_type_1> state;
+    raft::mux_state_machine stm(
+      kvlog, _raft.get(), raft::persistent_last_applied::yes, state);
+    stm.start().get0();
+    auto stop = ss::defer([&stm] { stm.stop().get0(); });
+    wait_for_leader();
+    auto offset = _storage.local().log_mgr().get(_ntp)->offsets().dirty_offset;
+    stm.wait(offset, model::timeout_clock::now() + 5s).get0();
+    // the updates of every key were applied in offset order
+    BOOST_REQUIRE_EQUAL(state.kv_map.size(), keys / 2);
+    for (int i = 1; i < keys; i += 2) {
+        BOOST_REQUIRE_EQUAL(
+          state.kv_map.find(fmt::format("key-{}", i))->second, i + 3);
+    }
+}
+
 FIXTURE_TEST(test_mulitple_states, mux_state_machine_fixture) {
     start_raft();
     simple_kv<batch_type_1> state_1;
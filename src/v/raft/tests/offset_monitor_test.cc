@@ -272,3 +272,24 @@ SEASTAR_THREAD_TEST_CASE(wait_abort_source_with_timeout_abort_before_timeout) {
 
     BOOST_REQUIRE(mon.empty());
 }
+
+SEASTAR_THREAD_TEST_CASE(wait_timeouts_expire_in_deadline_order) {
+    raft::offset_monitor mon;
+
+    auto late = mon.wait(
+      model::offset(0),
+      model::timeout_clock::now() + std::chrono::seconds(30),
+      std::nullopt);
+    auto early = mon.wait(
+      model::offset(1), model::timeout_clock::now(), std::nullopt);
+    auto none = mon.wait(model::offset(2), model::no_timeout, std::nullopt);
+
+    BOOST_CHECK_THROW(early.get(), raft::offset_monitor::wait_aborted);
+    BOOST_REQUIRE(!late.available());
+    BOOST_REQUIRE(!none.available());
+
+    mon.notify(model::offset(2));
+    BOOST_CHECK_NO_THROW(late.get());
+    BOOST_CHECK_NO_THROW(none.get());
+    BOOST_REQUIRE(mon.empty());
+}
@@ -0,0 +1,55 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "config/configuration.h"
+#include "raft/produce_latency_probe.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+using namespace std::chrono_literals; // NOLINT
+
+static model::ntp make_ntp(int p) {
+    return model::ntp(
+      model::ns("test"), model::topic("produce"), model::partition_id(p));
+}
+
+SEASTAR_THREAD_TEST_CASE(histograms_bounded_per_shard) {
+    config::shard_local_cfg()
+      .get("produce_latency_max_partitions")
+      .set_value(size_t(2));
+    using stage = raft::produce_latency_probe::stage;
+    std::vector<std::unique_ptr<raft::produce_latency_probe>> probes;
+    for (int i = 0; i < 3; ++i) {
+        probes.push_back(std::make_unique<raft::produce_latency_probe>());
+        probes.back()->setup_metrics(make_ntp(i));
+    }
+    BOOST_REQUIRE(probes[0]->enabled());
+    BOOST_REQUIRE(probes[1]->enabled());
+    BOOST_REQUIRE(!probes[2]->enabled());
+    // disabled probes ignore samples
+    probes[2]->record(stage::flush, 1ms);
+
+    probes[0]->record(stage::flush, 1ms);
+    probes[0]->record(stage::flush, 3ms);
+    auto flush = probes[0]->histogram(stage::flush).seastar_histogram_logform();
+    BOOST_REQUIRE_EQUAL(flush.sample_count, 2);
+    auto append
+      = probes[0]->histogram(stage::local_append).seastar_histogram_logform();
+    BOOST_REQUIRE_EQUAL(append.sample_count, 0);
+
+    // released slot is taken by the next partition
+    probes.erase(probes.begin());
+    probes.push_back(std::make_unique<raft::produce_latency_probe>());
+    probes.back()->setup_metrics(make_ntp(3));
+    BOOST_REQUIRE(probes.back()->enabled());
+}
@@ -0,0 +1,85 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/recovery_scheduler.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <optional>
+#include <vector>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(admits_smallest_lag_first) {
+    raft::recovery_scheduler sched(1, 0);
+    auto running = sched.admit(100).get0();
+    BOOST_REQUIRE_EQUAL(sched.running(), 1);
+
+    std::vector<size_t> order;
+    std::vector<ss::future<>> admitted;
+    std::optional<raft::recovery_scheduler::permit> current;
+    for (size_t lag : {300, 10, 200, 10}) {
+        admitted.push_back(sched.admit(lag).then(
+          [&order, &current, lag](raft::recovery_scheduler::permit p) {
+              order.push_back(lag);
+              current = std::move(p);
+          }));
+    }
+    BOOST_REQUIRE_EQUAL(sched.waiting(), 4);
+
+    // every released permit admits exactly one waiter
+    running = raft::recovery_scheduler::permit();
+    for (size_t i = 0; i < 4; ++i) {
+        ss::later().get();
+        BOOST_REQUIRE_EQUAL(order.size(), i + 1);
+        BOOST_REQUIRE_EQUAL(sched.running(), 1);
+        current.reset();
+    }
+    ss::when_all_succeed(admitted.begin(), admitted.end()).get();
+    BOOST_REQUIRE(order == std::vector<size_t>({10, 10, 200, 300}));
+    BOOST_REQUIRE_EQUAL(sched.running(), 0);
+    sched.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(stop_fails_waiting_admissions) {
+    raft::recovery_scheduler sched(1, 0);
+    auto p = sched.admit(0).get0();
+    auto waiting = sched.admit(0);
+    sched.stop().get();
+    BOOST_REQUIRE_THROW(waiting.get(), ss::gate_closed_exception);
+    BOOST_REQUIRE_THROW(sched.admit(0).get(), ss::gate_closed_exception);
+}
+
+SEASTAR_THREAD_TEST_CASE(throttles_to_rate) {
+    // 10 KiB per refill interval with a 100 KiB bucket
+    raft::recovery_scheduler sched(1, 100 * 1024);
+    const auto start = ss::lowres_clock::now();
+    // drains the bucket without waiting
+    sched.throttle(100 * 1024).get();
+    // needs three refills
+    sched.throttle(30 * 1024).get();
+    const auto elapsed = ss::lowres_clock::now() - start;
+    BOOST_REQUIRE_GE(elapsed, 2 * raft::recovery_scheduler::refill_interval);
+    sched.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(unlimited_rate_does_not_wait) {
+    raft::recovery_scheduler sched(1, 0);
+    for (int i = 0; i < 100; ++i) {
+        auto f = sched.throttle(1024 * 1024);
+        BOOST_REQUIRE(f.available());
+        f.get();
+    }
+    sched.stop().get();
+}
@@ -0,0 +1,99 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/replication_window.h"
+#include "seastarx.h"
+#include "storage/tests/utils/random_batch.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <limits>
+
+static size_t append_all(
+  raft::replication_window& w,
+  ss::circular_buffer<model::record_batch>& batches) {
+    size_t bytes = 0;
+    for (auto& b : batches) {
+        w.append(b);
+        bytes += b.size_bytes();
+    }
+    return bytes;
+}
+
+SEASTAR_THREAD_TEST_CASE(read_from_window) {
+    raft::replication_window w(std::numeric_limits<size_t>::max());
+    auto batches = storage::test::make_random_batches(model::offset(0), 10);
+    BOOST_REQUIRE_EQUAL(append_all(w, batches), w.size_bytes());
+
+    // a range starting in the middle of a batch returns the whole batch
+    auto start = batches[3].base_offset() + 1;
+    auto read = w.read(
+      start, batches[6].last_offset(), std::numeric_limits<size_t>::max());
+    BOOST_REQUIRE(read);
+    BOOST_REQUIRE_EQUAL(read->size(), 4);
+    BOOST_REQUIRE_EQUAL(read->front().base_offset(), batches[3].base_offset());
+    BOOST_REQUIRE_EQUAL(read->back().last_offset(), batches[6].last_offset());
+    BOOST_REQUIRE(read->front() == batches[3]);
+
+    // at least one batch is returned
+    read = w.read(batches[0].base_offset(), batches[9].last_offset(), 1);
+    BOOST_REQUIRE(read);
+    BOOST_REQUIRE_EQUAL(read->size(), 1);
+
+    // offsets after the window are not in it
+    read = w.read(
+      batches[9].last_offset() + 1,
+      batches[9].last_offset() + 10,
+      std::numeric_limits<size_t>::max());
+    BOOST_REQUIRE(!read);
+    BOOST_REQUIRE_EQUAL(w.get_stats().hits, 2);
+    BOOST_REQUIRE_EQUAL(w.get_stats().misses, 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(window_is_bounded) {
+    auto batches = storage::test::make_random_batches(model::offset(0), 10);
+    size_t tail_bytes = 0;
+    for (size_t i = 5; i < batches.size(); ++i) {
+        tail_bytes += batches[i].size_bytes();
+    }
+    raft::replication_window w(tail_bytes);
+    append_all(w, batches);
+    BOOST_REQUIRE_LE(w.size_bytes(), tail_bytes);
+
+    // the oldest batches are evicted first
+    BOOST_REQUIRE(!w.read(
+      batches[0].base_offset(),
+      batches[9].last_offset(),
+      std::numeric_limits<size_t>::max()));
+    auto read = w.read(
+      batches[5].base_offset(),
+      batches[9].last_offset(),
+      std::numeric_limits<size_t>::max());
+    BOOST_REQUIRE(read);
+    BOOST_REQUIRE_EQUAL(read->size(), 5);
+}
+
+SEASTAR_THREAD_TEST_CASE(gap_clears_window) {
+    raft::replication_window w(std::numeric_limits<size_t>::max());
+    auto batches = storage::test::make_random_batches(model::offset(0), 5);
+    append_all(w, batches);
+
+    // e.g. the log was truncated and appended again by another leader
+    auto next = storage::test::make_random_batches(
+      batches.back().last_offset() + 10, 1);
+    append_all(w, next);
+    BOOST_REQUIRE_EQUAL(w.size_bytes(), next[0].size_bytes());
+    BOOST_REQUIRE(!w.read(
+      batches[0].base_offset(),
+      batches[4].last_offset(),
+      std::numeric_limits<size_t>::max()));
+
+    w.clear();
+    BOOST_REQUIRE_EQUAL(w.size_bytes(), 0);
+}
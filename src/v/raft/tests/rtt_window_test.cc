@@ -0,0 +1,39 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/rtt_window.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <chrono>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(percentiles_need_min_samples) {
+    raft::rtt_window w;
+    for (size_t i = 1; i < raft::rtt_window::min_samples; ++i) {
+        w.record(10ms);
+        BOOST_REQUIRE(!w.percentile(0.99));
+    }
+    w.record(10ms);
+    BOOST_REQUIRE(w.percentile(0.99) == raft::duration_type(10ms));
+}
+
+SEASTAR_THREAD_TEST_CASE(percentiles_of_recent_samples) {
+    raft::rtt_window w;
+    for (int i = 1; i <= 100; ++i) {
+        w.record(raft::duration_type(std::chrono::milliseconds(i)));
+    }
+    // only the last `capacity` samples are kept: 37ms..100ms
+    BOOST_REQUIRE_EQUAL(w.size(), raft::rtt_window::capacity);
+    BOOST_REQUIRE(w.percentile(0) == raft::duration_type(37ms));
+    BOOST_REQUIRE(w.percentile(0.5) == raft::duration_type(68ms));
+    BOOST_REQUIRE(w.percentile(0.99) == raft::duration_type(100ms));
+    BOOST_REQUIRE(w.percentile(1) == raft::duration_type(100ms));
+}
@@ -94,6 +94,39 @@ SEASTAR_THREAD_TEST_CASE(append_entries_requests) {
       .get0();
 }
 
+SEASTAR_THREAD_TEST_CASE(append_entries_batch_request_roundtrip) {
+    raft::append_entries_batch_request req;
+    for (int i = 0; i < 3; ++i) {
+        auto meta = raft::protocol_metadata{
+          .group = raft::group_id(i),
+          .commit_index = model::offset(100 + i),
+          .term = model::term_id(10),
+          .prev_log_index = model::offset(99 + i),
+          .prev_log_term = model::term_id(9),
+          .last_visible_index = model::offset(100 + i),
+        };
+        req.requests.emplace_back(
+          model::node_id(1),
+          meta,
+          model::make_memory_record_batch_reader(
+            storage::test::make_random_batches(model::offset(0), 2, false)));
+    }
+
+    auto d = async_serialize_roundtrip_rpc(std::move(req)).get0();
+
+    BOOST_REQUIRE_EQUAL(d.requests.size(), 3);
+    for (int i = 0; i < 3; ++i) {
+        auto& r = d.requests[i];
+        BOOST_REQUIRE_EQUAL(r.node_id, model::node_id(1));
+        BOOST_REQUIRE_EQUAL(r.meta.group, raft::group_id(i));
+        BOOST_REQUIRE_EQUAL(r.meta.commit_index, model::offset(100 + i));
+        auto batches = model::consume_reader_to_memory(
+                         std::move(r.batches), model::no_timeout)
+                         .get0();
+        BOOST_REQUIRE_EQUAL(batches.size(), 2);
+    }
+}
+
 model::broker create_test_broker() {
     return model::broker(
       model::node_id(random_generators::get_int(1000)), // id
@@ -0,0 +1,78 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/write_behind_buffer.h"
+#include "seastarx.h"
+#include "storage/tests/utils/random_batch.h"
+#include "units.h"
+
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+using namespace std::chrono_literals; // NOLINT
+
+static raft::write_behind_buffer::entry make_entry(
+  model::offset last, size_t bytes, raft::write_behind_buffer& buf) {
+    return raft::write_behind_buffer::entry{
+      .term = model::term_id(1),
+      .last_offset = last,
+      .batches = storage::test::make_random_batches(model::offset(0), 1),
+      .queued_at = raft::write_behind_buffer::clock_type::now(),
+      .units = buf.reserve(bytes).get0()};
+}
+
+SEASTAR_THREAD_TEST_CASE(write_behind_offsets_follow_the_buffer) {
+    raft::write_behind_buffer buf(1024, 1s);
+    BOOST_REQUIRE(buf.enabled());
+    BOOST_REQUIRE_EQUAL(buf.next_offset(model::offset(9)), model::offset(10));
+
+    buf.push(make_entry(model::offset(14), 100, buf));
+    // the log has not seen the batches yet
+    BOOST_REQUIRE_EQUAL(buf.next_offset(model::offset(9)), model::offset(15));
+    BOOST_REQUIRE_EQUAL(buf.lag_bytes(), 100);
+
+    auto entries = buf.take();
+    BOOST_REQUIRE_EQUAL(entries.size(), 1);
+    BOOST_REQUIRE(buf.empty());
+    // taken entries count until they are appended
+    BOOST_REQUIRE_EQUAL(buf.lag_bytes(), 100);
+    entries.clear();
+    buf.drained();
+    BOOST_REQUIRE_EQUAL(buf.lag_bytes(), 0);
+    BOOST_REQUIRE(buf.lag() == 0s);
+}
+
+SEASTAR_THREAD_TEST_CASE(write_behind_waits_for_room) {
+    raft::write_behind_buffer buf(1024, 1h);
+    buf.push(make_entry(model::offset(0), 1024, buf));
+
+    auto f = buf.reserve(1);
+    ss::sleep(10ms).get();
+    BOOST_REQUIRE(!f.available());
+
+    buf.take();
+    buf.drained();
+    f.get();
+    BOOST_REQUIRE(!raft::write_behind_buffer(1024, std::nullopt).enabled());
+}
+
+SEASTAR_THREAD_TEST_CASE(write_behind_bounds_lag) {
+    raft::write_behind_buffer buf(1_MiB, 20ms);
+    buf.push(make_entry(model::offset(0), 1, buf));
+    // lowres clock ticks every 10ms
+    ss::sleep(50ms).get();
+
+    auto f = buf.reserve(1);
+    ss::sleep(10ms).get();
+    BOOST_REQUIRE(!f.available());
+
+    auto entries = buf.take();
+    buf.drained();
+    f.get();
+}
@@ -19,21 +19,33 @@
 
 #include <seastar/core/app-template.hh>
 #include <seastar/core/fstream.hh>
+#include <seastar/core/lowres_clock.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/util/defer.hh>
 
+#include <absl/container/flat_hash_map.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <fstream>
 #include <string>
 
 auto& tronlog = raft::tron::tronlog;
 namespace ch = std::chrono;
+namespace po = boost::program_options; // NOLINT
 
-void cli_opts(boost::program_options::options_description_easy_init o) {
-    namespace po = boost::program_options;
+void cli_opts(po::options_description_easy_init o) {
     o("ip",
       po::value<std::string>()->default_value("127.0.0.1"),
       "ip to connect to");
     o("port", po::value<uint16_t>()->default_value(20776), "port for service");
+    o("servers",
+      po::value<std::vector<std::string>>()->multitoken(),
+      "--servers 127.0.0.1:20776 --servers 127.0.0.1:20777, every node of "
+      "the raft groups, instead of --ip and --port");
     o("concurrency",
       po::value<std::size_t>()->default_value(1),
       "number of concurrent requests per TCP connection");
@@ -49,6 +61,34 @@ void cli_opts(boost::program_options::options_description_easy_init o) {
     o("ca-cert",
       po::value<std::string>()->default_value(""),
       "CA root certificate");
+    o("groups",
+      po::value<std::string>()->default_value("1"),
+      "comma separated numbers of raft groups to sweep, at most the groups "
+      "of the servers");
+    o("records-per-batch",
+      po::value<std::string>()->default_value("1"),
+      "comma separated batch sizes in records to sweep");
+    o("consistency",
+      po::value<std::string>()->default_value("quorum_ack"),
+      "comma separated consistency levels to sweep: quorum_ack, leader_ack "
+      "or no_ack");
+    o("duration-sec",
+      po::value<uint32_t>()->default_value(10),
+      "seconds each run of the sweep lasts");
+    o("warmup-sec",
+      po::value<uint32_t>()->default_value(2),
+      "seconds of load before the sweep that are not measured, the leaders "
+      "of the groups are found meanwhile");
+    o("output",
+      po::value<std::string>()->default_value(""),
+      "file the results are written to, one json object per run");
+    o("baseline",
+      po::value<std::string>()->default_value(""),
+      "results of an earlier sweep, the benchmark fails when a run regresses");
+    o("max-regression-pct",
+      po::value<double>()->default_value(10),
+      "percent the p99 latency or the bytes/s per core of a run may regress "
+      "over the baseline");
 }
 
 struct load_gen_cfg {
@@ -56,7 +96,7 @@ struct load_gen_cfg {
     std::size_t value_size;
     std::size_t concurrency;
     std::size_t parallelism;
-    rpc::transport_configuration client_cfg;
+    std::vector<rpc::transport_configuration> servers;
     ss::sharded<hdr_hist>* hist;
 };
 
@@ -64,11 +104,33 @@ inline std::ostream& operator<<(std::ostream& o, const load_gen_cfg& cfg) {
     return o << "{'key_size':" << cfg.key_size
              << ", 'value_size':" << cfg.value_size
              << ", 'concurrency':" << cfg.concurrency
-             << ", 'parallelism':" << cfg.parallelism << "}";
+             << ", 'parallelism':" << cfg.parallelism
+             << ", 'servers':" << cfg.servers.size() << "}";
 }
 
-// 1. creates cfg.parallelism number of TCP connections
-// 2. launches cfg.concurrency * parallelism number of requests
+/// one point of the sweep
+struct run_cfg {
+    int32_t groups;
+    std::size_t records_per_batch;
+    raft::consistency_level consistency;
+};
+
+struct run_stats {
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t bytes{0};
+
+    run_stats& operator+=(const run_stats& o) {
+        requests += o.requests;
+        errors += o.errors;
+        bytes += o.bytes;
+        return *this;
+    }
+};
+
+// 1. creates cfg.parallelism number of TCP connections to every server
+// 2. keeps cfg.concurrency * parallelism number of requests in flight for
+//    the duration of a run, spread round robin over the groups of the run
 class client_loadgen {
 public:
     using cli = rpc::client<raft::tron::trongen_client_protocol>;
@@ -76,61 +138,128 @@ public:
       : _cfg(std::move(cfg))
       , _mem(ss::memory::stats().total_memory() * .9) {
         vlog(tronlog.debug, "Mem for loadgen: {}", _mem.available_units());
-        for (std::size_t i = 0; i < _cfg.parallelism; ++i) {
-            _clients.push_back(std::make_unique<cli>(_cfg.client_cfg));
+        for (auto& server : _cfg.servers) {
+            std::vector<std::unique_ptr<cli>> conns;
+            for (std::size_t i = 0; i < _cfg.parallelism; ++i) {
+                conns.push_back(std::make_unique<cli>(server));
+            }
+            _clients.push_back(std::move(conns));
         }
     }
-    ss::future<> execute_loadgen() {
+    ss::future<run_stats> execute_run(run_cfg run, ch::milliseconds duration) {
+        _run = run;
+        _stats = {};
+        _deadline = ss::lowres_clock::now() + duration;
         return ss::parallel_for_each(
-          _clients.begin(), _clients.end(), [this](auto& c) {
-              return ss::parallel_for_each(
-                boost::irange(std::size_t(0), _cfg.concurrency),
-                [this, &c](std::size_t) mutable { return execute_one(c); });
+                 boost::irange(std::size_t(0), _cfg.parallelism),
+                 [this](std::size_t conn) {
+                     return ss::parallel_for_each(
+                       boost::irange(std::size_t(0), _cfg.concurrency),
+                       [this, conn](std::size_t) {
+                           return ss::do_until(
+                             [this] {
+                                 return ss::lowres_clock::now() >= _deadline;
+                             },
+                             [this, conn] { return execute_one(conn); });
+                       });
+                 })
+          .then([this] { return _stats; });
+    }
+    /// what the servers replicated, summed
+    ss::future<raft::tron::stats_reply> server_stats() {
+        return ss::map_reduce(
+          _clients.begin(),
+          _clients.end(),
+          [](std::vector<std::unique_ptr<cli>>& conns) {
+              return conns.front()
+                ->stats(
+                  raft::tron::stats_request{},
+                  rpc::client_opts(rpc::no_timeout))
+                .then([](auto r) {
+                    if (!r) {
+                        throw std::runtime_error(fmt::format(
+                          "Error reading server stats:{}",
+                          r.error().message()));
+                    }
+                    return r.value().data;
+                });
+          },
+          raft::tron::stats_reply{},
+          [](raft::tron::stats_reply acc, const raft::tron::stats_reply& s) {
+              acc.batches += s.batches;
+              acc.bytes += s.bytes;
+              acc.groups += s.groups;
+              acc.cores += s.cores;
+              return acc;
           });
     }
     ss::future<> connect() {
-        return ss::parallel_for_each(
-          _clients.begin(), _clients.end(), [](auto& c) {
-              return c->connect();
-          });
+        return ss::parallel_for_each(_clients, [](auto& conns) {
+            return ss::parallel_for_each(
+              conns, [](auto& c) { return c->connect(); });
+        });
     }
     ss::future<> stop() {
-        return ss::parallel_for_each(
-          _clients.begin(), _clients.end(), [](auto& c) { return c->stop(); });
+        return ss::parallel_for_each(_clients, [](auto& conns) {
+            return ss::parallel_for_each(
+              conns, [](auto& c) { return c->stop(); });
+        });
     }
 
 private:
-    ss::future<> execute_one(std::unique_ptr<cli>& c) {
-        auto mem_sz = _cfg.key_size + _cfg.value_size + 20;
-        return with_semaphore(_mem, mem_sz, [this, &c] {
-            return c
-              ->replicate(
-                gen_entry(),
-                rpc::client_opts(rpc::client_opts(rpc::no_timeout)))
-              .then_wrapped([m = _cfg.hist->local().auto_measure()](auto f) {
+    ss::future<> execute_one(std::size_t conn) {
+        auto mem_sz = (_cfg.key_size + _cfg.value_size + 20)
+                      * _run.records_per_batch;
+        return with_semaphore(_mem, mem_sz, [this, conn] {
+            auto group = raft::group_id(
+              raft::tron::first_group() + _next_group++ % _run.groups);
+            // the server a group was last replicated through, the leader
+            const auto server = _leaders[group];
+            auto batch = data_batch();
+            const auto bytes = batch.size_bytes();
+            raft::tron::put_request req{
+              .group = group, .consistency = _run.consistency};
+            req.batches.push_back(std::move(batch));
+            return _clients[server][conn]
+              ->put(std::move(req), rpc::client_opts(rpc::no_timeout))
+              .then_wrapped([this, group, bytes,
+                             m = _cfg.hist->local().auto_measure()](auto f) {
                   try {
-                      (void)f.get0();
+                      auto r = f.get0();
+                      if (r && r.value().data.success) {
+                          ++_stats.requests;
+                          _stats.bytes += bytes;
+                          return;
+                      }
+                      vlog(
+                        tronlog.debug,
+                        "Error replicating to group {}:{}",
+                        group,
+                        r ? std::string(r.value().data.failure_reason)
+                          : r.error().message());
                   } catch (...) {
                       vlog(
                         tronlog.info,
                         "Error sending payload:{}",
                         std::current_exception());
                   }
+                  // failures are not latencies, try the next server
+                  m->set_trace(false);
+                  ++_stats.errors;
+                  auto& server = _leaders[group];
+                  server = (server + 1) % _clients.size();
               });
         });
     }
 
-    model::record_batch_reader gen_entry() {
-        ss::circular_buffer<model::record_batch> batches;
-        batches.reserve(1);
-        batches.push_back(data_batch());
-        return model::make_memory_record_batch_reader(std::move(batches));
-    }
     model::record_batch data_batch() {
         storage::record_batch_builder bldr(
           raft::data_batch_type, _offset_index);
-        bldr.add_raw_kv(rand_iobuf(_cfg.key_size), rand_iobuf(_cfg.value_size));
-        ++_offset_index;
+        for (std::size_t i = 0; i < _run.records_per_batch; ++i) {
+            bldr.add_raw_kv(
+              rand_iobuf(_cfg.key_size), rand_iobuf(_cfg.value_size));
+        }
+        _offset_index += _run.records_per_batch;
         return std::move(bldr).build();
     }
     iobuf rand_iobuf(size_t n) const {
@@ -143,14 +272,74 @@ private:
     model::offset _offset_index{0};
     load_gen_cfg _cfg;
     ss::semaphore _mem;
-    std::vector<std::unique_ptr<cli>> _clients;
+    std::vector<std::vector<std::unique_ptr<cli>>> _clients;
+    // index of the server of each group in _clients
+    absl::flat_hash_map<raft::group_id, std::size_t> _leaders;
+    run_cfg _run{};
+    run_stats _stats;
+    uint64_t _next_group{0};
+    ss::lowres_clock::time_point _deadline;
 };
 
+static std::vector<std::string> split_list(const std::string& s) {
+    std::vector<std::string> parts;
+    boost::split(parts, s, boost::is_any_of(","));
+    return parts;
+}
+
+static raft::consistency_level parse_consistency(const std::string& s) {
+    if (s == "quorum_ack") {
+        return raft::consistency_level::quorum_ack;
+    }
+    if (s == "leader_ack") {
+        return raft::consistency_level::leader_ack;
+    }
+    if (s == "no_ack") {
+        return raft::consistency_level::no_ack;
+    }
+    throw std::invalid_argument(fmt::format("Unknown consistency:{}", s));
+}
+
+static std::string_view consistency_name(raft::consistency_level l) {
+    switch (l) {
+    case raft::consistency_level::quorum_ack:
+        return "quorum_ack";
+    case raft::consistency_level::leader_ack:
+        return "leader_ack";
+    case raft::consistency_level::no_ack:
+        return "no_ack";
+    }
+    return "unknown";
+}
+
+/// every combination of the swept options
+static std::vector<run_cfg> runs_from_opts(const po::variables_map& m) {
+    std::vector<run_cfg> runs;
+    for (auto& g : split_list(m["groups"].as<std::string>())) {
+        for (auto& r : split_list(m["records-per-batch"].as<std::string>())) {
+            for (auto& c : split_list(m["consistency"].as<std::string>())) {
+                runs.push_back(run_cfg{
+                  .groups = boost::lexical_cast<int32_t>(g),
+                  .records_per_batch = boost::lexical_cast<std::size_t>(r),
+                  .consistency = parse_consistency(c)});
+            }
+        }
+    }
+    return runs;
+}
+
 inline load_gen_cfg cfg_from_opts_in_thread(
   boost::program_options::variables_map& m, ss::sharded<hdr_hist>* h) {
+    std::vector<ss::socket_address> addrs;
+    if (m.find("servers") != m.end()) {
+        for (auto& s : m["servers"].as<std::vector<std::string>>()) {
+            addrs.emplace_back(ss::ipv4_addr(s));
+        }
+    } else {
+        addrs.emplace_back(
+          ss::ipv4_addr(m["ip"].as<std::string>(), m["port"].as<uint16_t>()));
+    }
     rpc::transport_configuration client_cfg;
-    client_cfg.server_addr = ss::socket_address(
-      ss::ipv4_addr(m["ip"].as<std::string>(), m["port"].as<uint16_t>()));
     auto ca_cert = m["ca-cert"].as<std::string>();
     if (ca_cert != "") {
         auto builder = ss::tls::credentials_builder();
@@ -162,27 +351,185 @@ inline load_gen_cfg cfg_from_opts_in_thread(
         client_cfg.credentials
           = builder.build_reloadable_certificate_credentials().get0();
     }
-    client_cfg.max_queued_bytes = ss::memory::stats().total_memory() * .8;
+    client_cfg.max_queued_bytes = ss::memory::stats().total_memory() * .8
+                                  / addrs.size();
+    std::vector<rpc::transport_configuration> servers;
+    for (auto& addr : addrs) {
+        auto cfg = client_cfg;
+        cfg.server_addr = addr;
+        servers.push_back(std::move(cfg));
+    }
     return load_gen_cfg{
       .key_size = m["key-size"].as<std::size_t>(),
       .value_size = m["value-size"].as<std::size_t>(),
       .concurrency = m["concurrency"].as<std::size_t>(),
       .parallelism = m["parallelism"].as<std::size_t>(),
-      .client_cfg = std::move(client_cfg),
+      .servers = std::move(servers),
       .hist = h};
 }
 
-inline hdr_hist aggregate_in_thread(ss::sharded<hdr_hist>& h) {
-    hdr_hist retval;
-    for (auto i = 0; i < ss::smp::count; ++i) {
-        h.invoke_on(i, [&retval](const hdr_hist& o) { retval += o; }).get();
+inline hdr_hist_counts aggregate_in_thread(ss::sharded<hdr_hist>& h) {
+    // only the counts of the buckets holding values cross shards
+    return h
+      .map_reduce0(
+        [](const hdr_hist& o) { return o.counts(); },
+        hdr_hist_counts{},
+        [](hdr_hist_counts acc, const hdr_hist_counts& c) {
+            acc += c;
+            return acc;
+        })
+      .get0();
+}
+
+/// the measurements of a run, the unit of the regression gate
+struct run_result {
+    run_cfg run;
+    std::size_t batch_bytes;
+    run_stats stats;
+    int64_t p50_us;
+    int64_t p90_us;
+    int64_t p99_us;
+    int64_t p999_us;
+    int64_t max_us;
+    double bytes_per_sec;
+    double bytes_per_sec_per_core;
+
+    bool same_run(const run_result& o) const {
+        return run.groups == o.run.groups
+               && run.records_per_batch == o.run.records_per_batch
+               && run.consistency == o.run.consistency
+               && batch_bytes == o.batch_bytes;
+    }
+};
+
+static std::string to_json(const run_result& r) {
+    return fmt::format(
+      R"({{"groups":{},"records_per_batch":{},"batch_bytes":{},)"
+      R"("consistency":"{}","requests":{},"errors":{},"p50_us":{},)"
+      R"("p90_us":{},"p99_us":{},"p999_us":{},"max_us":{},)"
+      R"("bytes_per_sec":{:.0f},"bytes_per_sec_per_core":{:.0f}}})",
+      r.run.groups,
+      r.run.records_per_batch,
+      r.batch_bytes,
+      consistency_name(r.run.consistency),
+      r.stats.requests,
+      r.stats.errors,
+      r.p50_us,
+      r.p90_us,
+      r.p99_us,
+      r.p999_us,
+      r.max_us,
+      r.bytes_per_sec,
+      r.bytes_per_sec_per_core);
+}
+
+static run_result from_json(const std::string& line) {
+    rapidjson::Document doc;
+    doc.Parse(line.c_str());
+    if (doc.HasParseError() || !doc.IsObject()) {
+        throw std::runtime_error(fmt::format("Invalid result:{}", line));
+    }
+    run_result r{};
+    r.run.groups = doc["groups"].GetInt();
+    r.run.records_per_batch = doc["records_per_batch"].GetUint64();
+    r.run.consistency = parse_consistency(doc["consistency"].GetString());
+    r.batch_bytes = doc["batch_bytes"].GetUint64();
+    r.p99_us = doc["p99_us"].GetInt64();
+    r.bytes_per_sec_per_core = doc["bytes_per_sec_per_core"].GetDouble();
+    return r;
+}
+
+static std::vector<run_result> read_baseline(const std::string& path) {
+    std::vector<run_result> ret;
+    if (path.empty()) {
+        return ret;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(fmt::format("Cannot read baseline:{}", path));
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            ret.push_back(from_json(line));
+        }
     }
-    return retval;
+    return ret;
 }
-void write_latency_in_thread(ss::sharded<hdr_hist>& hist) {
-    auto h = aggregate_in_thread(hist);
-    // write to file instead
-    std::cout << std::endl << h << std::endl;
+
+/// the runs slower than their baseline by more than max_pct
+static size_t count_regressions(
+  const std::vector<run_result>& results,
+  const std::vector<run_result>& baseline,
+  double max_pct) {
+    size_t regressions = 0;
+    for (auto& r : results) {
+        auto it = std::find_if(
+          baseline.begin(), baseline.end(), [&r](const run_result& b) {
+              return r.same_run(b);
+          });
+        if (it == baseline.end()) {
+            continue;
+        }
+        const double slack = max_pct / 100;
+        const bool latency = r.p99_us > it->p99_us * (1 + slack);
+        const bool throughput = r.bytes_per_sec_per_core
+                                < it->bytes_per_sec_per_core * (1 - slack);
+        if (latency || throughput) {
+            ++regressions;
+            vlog(
+              tronlog.error,
+              "Regression of {}. p99_us:{} (baseline {}), "
+              "bytes_per_sec_per_core:{:.0f} (baseline {:.0f})",
+              to_json(r),
+              r.p99_us,
+              it->p99_us,
+              r.bytes_per_sec_per_core,
+              it->bytes_per_sec_per_core);
+        }
+    }
+    return regressions;
+}
+
+static run_result execute_run_in_thread(
+  ss::sharded<client_loadgen>& client,
+  ss::sharded<hdr_hist>& hist,
+  const load_gen_cfg& lcfg,
+  run_cfg run,
+  ch::milliseconds duration) {
+    const auto counts_before = aggregate_in_thread(hist);
+    const auto server_before = client.local().server_stats().get0();
+    const auto begin = ch::steady_clock::now();
+    auto stats = client
+                   .map_reduce0(
+                     [run, duration](client_loadgen& c) {
+                         return c.execute_run(run, duration);
+                     },
+                     run_stats{},
+                     [](run_stats acc, const run_stats& s) {
+                         acc += s;
+                         return acc;
+                     })
+                   .get0();
+    const double secs = ch::duration<double>(ch::steady_clock::now() - begin)
+                          .count();
+    const auto server_after = client.local().server_stats().get0();
+    const auto counts = aggregate_in_thread(hist).since(counts_before);
+    const auto replicated = server_after.bytes - server_before.bytes;
+    return run_result{
+      .run = run,
+      .batch_bytes = run.records_per_batch
+                     * (lcfg.key_size + lcfg.value_size),
+      .stats = stats,
+      .p50_us = counts.get_value_at(50),
+      .p90_us = counts.get_value_at(90),
+      .p99_us = counts.get_value_at(99),
+      .p999_us = counts.get_value_at(99.9),
+      .max_us = counts.get_value_at(100),
+      .bytes_per_sec = stats.bytes / secs,
+      .bytes_per_sec_per_core = replicated / secs
+                                / std::max<uint32_t>(server_after.cores, 1),
+    };
 }
 
 int main(int args, char** argv, char** env) {
@@ -195,6 +542,9 @@ int main(int args, char** argv, char** env) {
     return app.run(args, argv, [&] {
         return ss::async([&] {
             auto& cfg = app.configuration();
+            const auto runs = runs_from_opts(cfg);
+            const auto baseline = read_baseline(
+              cfg["baseline"].as<std::string>());
             vlog(tronlog.info, "constructing histogram");
             hist.start().get();
             auto hd = ss::defer([&hist] { hist.stop().get(); });
@@ -205,11 +555,49 @@ int main(int args, char** argv, char** env) {
             auto cd = ss::defer([&client] { client.stop().get(); });
             vlog(tronlog.info, "connecting clients");
             client.invoke_on_all(&client_loadgen::connect).get();
-            vlog(tronlog.info, "invoking loadgen");
-            client.invoke_on_all(&client_loadgen::execute_loadgen).get();
-            vlog(tronlog.info, "writing results");
-            write_latency_in_thread(hist);
+
+            const auto server = client.local().server_stats().get0();
+            vlog(
+              tronlog.info,
+              "servers have {} groups on {} cores",
+              server.groups,
+              server.cores);
+            auto widest = std::max_element(
+              runs.begin(), runs.end(), [](const run_cfg& a, const run_cfg& b) {
+                  return a.groups < b.groups;
+              });
+            vlog(tronlog.info, "warming up");
+            execute_run_in_thread(
+              client,
+              hist,
+              lcfg,
+              *widest,
+              ch::seconds(cfg["warmup-sec"].as<uint32_t>()));
+
+            std::ofstream out;
+            const auto output = cfg["output"].as<std::string>();
+            if (!output.empty()) {
+                out.open(output);
+            }
+            std::vector<run_result> results;
+            for (auto& run : runs) {
+                auto r = execute_run_in_thread(
+                  client,
+                  hist,
+                  lcfg,
+                  run,
+                  ch::seconds(cfg["duration-sec"].as<uint32_t>()));
+                const auto line = to_json(r);
+                std::cout << line << std::endl;
+                if (out.is_open()) {
+                    out << line << std::endl;
+                }
+                results.push_back(r);
+            }
             vlog(tronlog.info, "stopping");
+            const auto regressions = count_regressions(
+              results, baseline, cfg["max-regression-pct"].as<double>());
+            return regressions > 0 ? 1 : 0;
         });
     });
 }
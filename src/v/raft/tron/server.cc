@@ -34,6 +34,7 @@
 #include <seastar/core/thread.hh>
 #include <seastar/util/defer.hh>
 
+#include <absl/container/flat_hash_map.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <fmt/format.h>
@@ -62,6 +63,9 @@ void cli_opts(po::options_description_easy_init o) {
       po::value<int32_t>()->default_value(100),
       "raft heartbeat timeout in milliseconds");
     o("node-id", po::value<int32_t>(), "node-id required");
+    o("groups",
+      po::value<int32_t>()->default_value(1),
+      "number of raft groups, spread over the cores");
     o("key",
       po::value<ss::sstring>()->default_value(""),
       "key for TLS seccured connection");
@@ -95,65 +99,95 @@ public:
             storage::debug_sanitize_files::yes))
       , _hbeats(raft_heartbeat_interval, _consensus_client_protocol, self) {}
 
-    ss::lw_shared_ptr<raft::consensus> consensus_for(raft::group_id) {
-        return _consensus;
+    ss::lw_shared_ptr<raft::consensus> consensus_for(raft::group_id g) {
+        auto it = _groups.find(g);
+        return it == _groups.end() ? nullptr : it->second;
     }
 
-    ss::future<> start(raft::group_configuration init_cfg) {
+    void account(size_t batches, size_t bytes) {
+        _stats.batches += batches;
+        _stats.bytes += bytes;
+    }
+    raft::tron::stats_reply stats() const { return _stats; }
+
+    /// starts the groups of the core, the group ids of the core under
+    /// simple_shard_lookup among the first `groups` ones
+    ss::future<> start(raft::group_configuration init_cfg, int32_t groups) {
         return _storage.start()
-          .then([this, init_cfg = std::move(init_cfg)]() mutable {
-              return _storage.log_mgr()
-                .manage(storage::ntp_config(
-                  _ntp, _storage.log_mgr().config().base_dir))
-                .then(
-                  [this, cfg = std::move(init_cfg)](storage::log log) mutable {
-                      _consensus = ss::make_lw_shared<raft::consensus>(
-                        _self,
-                        raft::group_id(66),
-                        std::move(cfg),
-                        raft::timeout_jitter(
-                          config::shard_local_cfg().raft_election_timeout_ms()),
-                        log,
-                        ss::default_priority_class(),
-                        std::chrono::seconds(1),
-                        _consensus_client_protocol,
-                        [this](raft::leadership_status st) {
-                            if (!st.current_leader) {
-                                vlog(
-                                  tronlog.info,
-                                  "No leader in group {}",
-                                  st.group);
-                                return;
-                            }
-                            vlog(
-                              tronlog.info,
-                              "New leader {} elected in group {}",
-                              st.current_leader.value(),
-                              st.group);
-                        },
-                        _storage);
-                      return _consensus->start().then(
-                        [this] { return _hbeats.register_group(_consensus); });
-                  });
+          .then([this, init_cfg = std::move(init_cfg), groups]() mutable {
+              std::vector<raft::group_id> ids;
+              for (int32_t i = 0; i < groups; ++i) {
+                  raft::group_id g(raft::tron::first_group() + i);
+                  if (g() % ss::smp::count == ss::this_shard_id()) {
+                      ids.push_back(g);
+                  }
+              }
+              _stats.groups = ids.size();
+              return ss::do_with(
+                std::move(ids),
+                [this, cfg = std::move(init_cfg)](
+                  std::vector<raft::group_id>& ids) mutable {
+                    return ss::do_for_each(
+                      ids, [this, cfg = std::move(cfg)](raft::group_id g) {
+                          return start_group(g, cfg);
+                      });
+                });
           })
           .then([this] { return _hbeats.start(); });
     }
     ss::future<> stop() {
-        return _consensus->stop()
+        return ss::parallel_for_each(
+                 _groups, [](auto& p) { return p.second->stop(); })
           .then([this] { return _hbeats.stop(); })
           .then([this] { return _storage.stop(); });
     }
 
 private:
+    ss::future<>
+    start_group(raft::group_id g, raft::group_configuration cfg) {
+        auto ntp = model::ntp(
+          model::ns("master_control_program"),
+          model::topic("tron"),
+          model::partition_id(g()));
+        return _storage.log_mgr()
+          .manage(
+            storage::ntp_config(ntp, _storage.log_mgr().config().base_dir))
+          .then([this, g, cfg = std::move(cfg)](storage::log log) mutable {
+              auto c = ss::make_lw_shared<raft::consensus>(
+                _self,
+                g,
+                std::move(cfg),
+                raft::timeout_jitter(
+                  config::shard_local_cfg().raft_election_timeout_ms()),
+                log,
+                ss::default_priority_class(),
+                std::chrono::seconds(1),
+                _consensus_client_protocol,
+                [this](raft::leadership_status st) {
+                    if (!st.current_leader) {
+                        vlog(tronlog.info, "No leader in group {}", st.group);
+                        return;
+                    }
+                    vlog(
+                      tronlog.info,
+                      "New leader {} elected in group {}",
+                      st.current_leader.value(),
+                      st.group);
+                },
+                _storage);
+              _groups.emplace(g, c);
+              return c->start().then(
+                [this, c] { return _hbeats.register_group(c); });
+          });
+    }
+
     model::node_id _self;
     raft::consensus_client_protocol _consensus_client_protocol;
     storage::api _storage;
     raft::heartbeat_manager _hbeats;
-    model::ntp _ntp{
-      model::ns("master_control_program"),
-      model::topic("tron"),
-      model::partition_id(ss::this_shard_id())};
-    ss::lw_shared_ptr<raft::consensus> _consensus;
+    absl::flat_hash_map<raft::group_id, ss::lw_shared_ptr<raft::consensus>>
+      _groups;
+    raft::tron::stats_reply _stats;
 };
 
 static std::pair<model::node_id, rpc::transport_configuration>
@@ -322,7 +356,8 @@ int main(int args, char** argv, char** env) {
             vlog(tronlog.info, "Starting group manager");
             group_manager
               .invoke_on_all([&cfg](simple_group_manager& m) {
-                  return m.start(group_cfg_from_args(cfg));
+                  return m.start(
+                    group_cfg_from_args(cfg), cfg["groups"].as<int32_t>());
               })
               .get();
             app_signal.wait().get();
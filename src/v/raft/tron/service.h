@@ -19,7 +19,16 @@
 #include "raft/types.h"
 #include "seastarx.h"
 
+#include <iterator>
+
 namespace raft::tron {
+/**
+ * Besides the raft group manager interface, the ConsensusManager accounts
+ * what its groups replicate, for the stats of the benchmark:
+ *
+ *   void account(size_t batches, size_t bytes);
+ *   stats_reply stats() const;
+ */
 template<typename ConsensusManager, typename ShardLookup>
 CONCEPT(
   requires raft::RaftGroupManager<ConsensusManager>()
@@ -35,38 +44,107 @@ struct service final : trongen_service {
       , _shard_table(tbl) {}
     ss::future<stats_reply>
     stats(stats_request&&, rpc::streaming_context&) final {
-        return ss::make_ready_future<stats_reply>(stats_reply{});
+        return _group_manager.map_reduce0(
+          [](const ConsensusManager& m) { return m.stats(); },
+          stats_reply{.cores = ss::smp::count},
+          [](stats_reply acc, const stats_reply& s) {
+              acc.batches += s.batches;
+              acc.bytes += s.bytes;
+              acc.groups += s.groups;
+              return acc;
+          });
     }
     ss::future<put_reply>
     replicate(model::record_batch_reader&& r, rpc::streaming_context&) final {
-        auto shard = _shard_table.shard_for(raft::group_id(66));
+        return do_replicate(
+          first_group, std::move(r), raft::consistency_level::quorum_ack);
+    }
+    ss::future<put_reply> put(put_request&& r, rpc::streaming_context&) final {
+        auto shard = _shard_table.shard_for(r.group);
         return with_scheduling_group(
           get_scheduling_group(), [this, shard, r = std::move(r)]() mutable {
               return _group_manager.invoke_on(
                 shard,
                 get_smp_service_group(),
-                [this, r = std::move(r)](ConsensusManager& m) mutable {
-                    return m.consensus_for(group_id(66))
-                      ->replicate(
-                        std::move(r),
-                        raft::replicate_options(
-                          raft::consistency_level::quorum_ack))
-                      .then_wrapped([](ss::future<result<replicate_result>> f) {
-                          put_reply ret;
-                          try {
-                              f.get();
-                              ret.success = true;
-                          } catch (...) {
-                              ret.failure_reason = fmt::format(
-                                "{}", std::current_exception());
-                              tronlog.error(
-                                "failed to replicate: {}", ret.failure_reason);
+                [r = std::move(r)](ConsensusManager& m) mutable {
+                    auto c = m.consensus_for(r.group);
+                    if (!c) {
+                        return ss::make_ready_future<put_reply>(put_reply{
+                          .success = false,
+                          .failure_reason = fmt::format(
+                            "no raft group {}", r.group)});
+                    }
+                    const size_t count = r.batches.size();
+                    size_t bytes = 0;
+                    for (const auto& b : r.batches) {
+                        bytes += b.size_bytes();
+                    }
+                    ss::circular_buffer<model::record_batch> batches;
+                    batches.reserve(r.batches.size());
+                    std::move(
+                      r.batches.begin(),
+                      r.batches.end(),
+                      std::back_inserter(batches));
+                    return replicate_on(
+                             *c,
+                             model::make_memory_record_batch_reader(
+                               std::move(batches)),
+                             r.consistency)
+                      .then([&m, count, bytes](put_reply reply) {
+                          if (reply.success) {
+                              m.account(count, bytes);
                           }
-                          return ret;
+                          return reply;
                       });
                 });
           });
     }
+
+private:
+    ss::future<put_reply> do_replicate(
+      raft::group_id group,
+      model::record_batch_reader&& r,
+      raft::consistency_level consistency) {
+        auto shard = _shard_table.shard_for(group);
+        return with_scheduling_group(
+          get_scheduling_group(),
+          [this, shard, group, consistency, r = std::move(r)]() mutable {
+              return _group_manager.invoke_on(
+                shard,
+                get_smp_service_group(),
+                [group, consistency, r = std::move(r)](
+                  ConsensusManager& m) mutable {
+                    return replicate_on(
+                      *m.consensus_for(group), std::move(r), consistency);
+                });
+          });
+    }
+
+    static ss::future<put_reply> replicate_on(
+      raft::consensus& c,
+      model::record_batch_reader&& r,
+      raft::consistency_level consistency) {
+        return c
+          .replicate(std::move(r), raft::replicate_options(consistency))
+          .then_wrapped([](ss::future<result<replicate_result>> f) {
+              put_reply ret;
+              try {
+                  auto r = f.get0();
+                  ret.success = bool(r);
+                  if (!r) {
+                      ret.failure_reason = r.error().message();
+                  }
+              } catch (...) {
+                  ret.failure_reason = fmt::format(
+                    "{}", std::current_exception());
+              }
+              if (!ret.success) {
+                  tronlog.error("failed to replicate: {}", ret.failure_reason);
+              }
+              return ret;
+          });
+    }
+
     ss::sharded<ConsensusManager>& _group_manager;
     ShardLookup& _shard_table;
 };
@@ -12,12 +12,31 @@
 #pragma once
 
 #include "bytes/iobuf.h"
+#include "model/adl_serde.h"
 #include "model/async_adl_serde.h"
+#include "model/record.h"
 #include "raft/types.h"
 
+#include <vector>
+
 namespace raft::tron {
+/// groups of a server are numbered from the first one, see --groups
+inline constexpr raft::group_id first_group(66);
+
 struct stats_request {};
-struct stats_reply {};
+/// what the groups of a server replicated since it started
+struct stats_reply {
+    uint64_t batches{0};
+    uint64_t bytes{0};
+    uint32_t groups{0};
+    uint32_t cores{0};
+};
+/// replicates the batches to one of the groups of the server
+struct put_request {
+    raft::group_id group;
+    raft::consistency_level consistency;
+    std::vector<model::record_batch> batches;
+};
 struct put_reply {
     bool success;
     ss::sstring failure_reason;
@@ -16,6 +16,9 @@
 #include "vassert.h"
 #include "vlog.h"
 
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+
 #include <fmt/ostream.h>
 
 #include <type_traits>
@@ -187,6 +190,41 @@ async_adl<raft::append_entries_request>::from(iobuf_parser& in) {
     return ss::make_ready_future<raft::append_entries_request>(std::move(ret));
 }
 
+ss::future<> async_adl<raft::append_entries_batch_request>::to(
+  iobuf& out, raft::append_entries_batch_request&& batch) {
+    reflection::adl<uint32_t>{}.to(out, batch.requests.size());
+    return ss::do_with(
+      std::move(batch), [&out](raft::append_entries_batch_request& batch) {
+          return ss::do_for_each(
+            batch.requests, [&out](raft::append_entries_request& r) {
+                return async_adl<raft::append_entries_request>{}.to(
+                  out, std::move(r));
+            });
+      });
+}
+
+ss::future<raft::append_entries_batch_request>
+async_adl<raft::append_entries_batch_request>::from(iobuf_parser& in) {
+    const auto count = reflection::adl<uint32_t>{}.from(in);
+    auto batch = raft::append_entries_batch_request{};
+    batch.requests.reserve(count);
+    return ss::do_with(
+      std::move(batch),
+      boost::irange<uint32_t>(0, count),
+      [&in](raft::append_entries_batch_request& batch, auto& range) {
+          return ss::do_for_each(
+                   range,
+                   [&in, &batch](uint32_t) {
+                       return async_adl<raft::append_entries_request>{}
+                         .from(in)
+                         .then([&batch](raft::append_entries_request r) {
+                             batch.requests.push_back(std::move(r));
+                         });
+                   })
+            .then([&batch] { return std::move(batch); });
+      });
+}
+
 void adl<raft::protocol_metadata>::to(
   iobuf& out, raft::protocol_metadata request) {
     std::array<bytes::value_type, 6 * vint::max_length> staging{};
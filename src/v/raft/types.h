@@ -30,6 +30,8 @@
 
 #include <cstdint>
 #include <exception>
+#include <optional>
+#include <utility>
 
 namespace raft {
 using clock_type = ss::lowres_clock;
@@ -42,6 +44,8 @@ using group_id = named_type<int64_t, struct raft_group_id_type>;
 
 static constexpr const model::record_batch_type configuration_batch_type{2};
 static constexpr const model::record_batch_type data_batch_type{1};
+// new start offset of the log, see log_eviction_stm::truncate
+static constexpr const model::record_batch_type prefix_truncate_batch_type{9};
 
 struct protocol_metadata {
     group_id group;
@@ -80,6 +84,18 @@ struct follower_index_metadata {
     // timestamp of last append_entries_rpc call
     clock_type::time_point last_append_timestamp;
     clock_type::time_point last_hbeat_timestamp;
+    // the first request sent since the follower acknowledged one, with the
+    // time it was sent. a reply to it, or to any later request, proves that
+    // the follower heard from the leader after that time
+    std::optional<std::pair<follower_req_seq, clock_type::time_point>>
+      lease_probe;
+    // send time of the latest request the follower is known to have received
+    clock_type::time_point last_acked_request_sent;
+    // leader commit index carried by the last append entries request sent to
+    // this follower
+    model::offset last_sent_commit_index;
+    // bytes of the replicate rounds sent to the follower and not replied to
+    size_t inflight_bytes{0};
     uint64_t failed_appends{0};
     // The pair of sequences used to track append entries requests sent and
     // received by the follower. Every time append entries request is created
@@ -206,6 +222,16 @@ struct heartbeat_reply {
     std::vector<append_entries_reply> meta;
 };
 
+/// \brief append entries requests of many groups sent to the same node in a
+/// single rpc. requests of a group are applied in order, the replies are in
+/// the order of the requests
+struct append_entries_batch_request {
+    std::vector<append_entries_request> requests;
+};
+struct append_entries_batch_reply {
+    std::vector<append_entries_reply> replies;
+};
+
 struct vote_request {
     model::node_id node_id;
     group_id group;
@@ -380,6 +406,7 @@ enum class metadata_key : int8_t {
     config_map = 1,
     config_latest_known_offset = 2,
     last_applied_offset = 3,
+    config_delta = 4,
 };
 
 std::ostream& operator<<(std::ostream& o, const consistency_level& l);
@@ -416,6 +443,12 @@ struct async_adl<raft::heartbeat_reply> {
     ss::future<raft::heartbeat_reply> from(iobuf_parser& in);
 };
 
+template<>
+struct async_adl<raft::append_entries_batch_request> {
+    ss::future<> to(iobuf& out, raft::append_entries_batch_request&& request);
+    ss::future<raft::append_entries_batch_request> from(iobuf_parser& in);
+};
+
 template<>
 struct adl<raft::snapshot_metadata> {
     void to(iobuf& out, raft::snapshot_metadata&& request);
@@ -234,6 +234,7 @@ void vote_stm::update_vote_state(ss::semaphore_units<> u) {
     vlog(_ctxlog.info, "became the leader term:{}", _ptr->term());
 
     _ptr->trigger_leadership_notification();
+    _ptr->warm_batch_cache();
     replicate_config_as_new_leader(std::move(u));
 }
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#include "raft/write_behind_buffer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace raft {
+
+write_behind_buffer::write_behind_buffer(
+  size_t max_bytes, std::optional<clock_type::duration> max_lag)
+  : _max_bytes(max_bytes)
+  , _max_lag(max_lag)
+  , _mem(max_bytes) {}
+
+ss::future<ss::semaphore_units<>> write_behind_buffer::reserve(size_t bytes) {
+    return _progress
+      .wait([this] {
+          auto o = oldest();
+          return !o || clock_type::now() - *o < *_max_lag;
+      })
+      .then([this, bytes] {
+          // a write larger than the buffer waits for it to be empty
+          return ss::get_units(_mem, std::min(bytes, _max_bytes));
+      });
+}
+
+void write_behind_buffer::push(entry e) { _entries.push_back(std::move(e)); }
+
+ss::circular_buffer<write_behind_buffer::entry> write_behind_buffer::take() {
+    if (!_entries.empty() && !_draining) {
+        _draining = _entries.front().queued_at;
+    }
+    return std::exchange(_entries, {});
+}
+
+void write_behind_buffer::drained() {
+    _draining = std::nullopt;
+    _progress.broadcast();
+}
+
+void write_behind_buffer::stop() {
+    _progress.broken();
+    _mem.broken();
+}
+
+size_t write_behind_buffer::lag_bytes() const {
+    const auto available = _mem.available_units();
+    return available >= 0 ? _max_bytes - std::min<size_t>(_max_bytes, available)
+                          : _max_bytes;
+}
+
+write_behind_buffer::clock_type::duration write_behind_buffer::lag() const {
+    auto o = oldest();
+    return o ? clock_type::now() - *o : clock_type::duration::zero();
+}
+
+std::optional<write_behind_buffer::clock_type::time_point>
+write_behind_buffer::oldest() const {
+    if (_draining) {
+        return _draining;
+    }
+    if (!_entries.empty()) {
+        return _entries.front().queued_at;
+    }
+    return std::nullopt;
+}
+
+} // namespace raft
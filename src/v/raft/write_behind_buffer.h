@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "seastarx.h"
+
+#include <seastar/core/circular_buffer.hh>
+#include <seastar/core/condition-variable.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/semaphore.hh>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace raft {
+
+/**
+ * Relaxed consistency writes acknowledged before they are appended to the
+ * log, for topics with write behind enabled.
+ *
+ * A leader_ack or no_ack replicate reserves the bytes of its batches,
+ * assigns them the next offsets under the op lock, queues them here and
+ * returns. Consensus appends the queued batches to the log in the
+ * background, and before any other append of the leader, so the offsets
+ * assigned here are the ones the batches get in the log.
+ *
+ * The lag of the log behind the acknowledged writes is bounded: a write
+ * waits while the buffer holds max_bytes, or while its oldest batch has been
+ * waiting for longer than max_lag.
+ */
+class write_behind_buffer {
+public:
+    using clock_type = ss::lowres_clock;
+
+    struct entry {
+        model::term_id term;
+        model::offset last_offset;
+        ss::circular_buffer<model::record_batch> batches;
+        clock_type::time_point queued_at;
+        ss::semaphore_units<> units;
+    };
+
+    /// disabled when max_lag is not set
+    write_behind_buffer(
+      size_t max_bytes, std::optional<clock_type::duration> max_lag);
+
+    bool enabled() const { return _max_lag.has_value(); }
+
+    /// \brief waits until the bytes of a write fit within the bounds
+    ss::future<ss::semaphore_units<>> reserve(size_t bytes);
+
+    /// \brief offset of the next write, following the log or the buffer
+    model::offset next_offset(model::offset dirty_offset) const {
+        if (_entries.empty()) {
+            return dirty_offset + model::offset(1);
+        }
+        return _entries.back().last_offset + model::offset(1);
+    }
+
+    void push(entry);
+
+    /// \brief entries to append, the lag counts them until drained()
+    ss::circular_buffer<entry> take();
+    void drained();
+
+    /// \brief unblocks and fails the writes waiting for room
+    void stop();
+
+    bool empty() const { return _entries.empty(); }
+    /// bytes acknowledged but not yet in the log
+    size_t lag_bytes() const;
+    /// time the oldest batch not yet in the log has waited
+    clock_type::duration lag() const;
+
+    void record_dropped(size_t n) { _dropped += n; }
+    uint64_t dropped() const { return _dropped; }
+
+private:
+    std::optional<clock_type::time_point> oldest() const;
+
+    size_t _max_bytes;
+    std::optional<clock_type::duration> _max_lag;
+    ss::semaphore _mem;
+    ss::circular_buffer<entry> _entries;
+    // queued at of the oldest entry taken but not yet appended
+    std::optional<clock_type::time_point> _draining;
+    ss::condition_variable _progress;
+    uint64_t _dropped{0};
+};
+
+} // namespace raft
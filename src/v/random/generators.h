@@ -32,9 +32,15 @@ inline std::random_device::result_type get_seed() {
     return seed;
 }
 // NOLINTNEXTLINE
-static thread_local std::default_random_engine gen(internal::get_seed());
+inline thread_local std::default_random_engine gen(internal::get_seed());
 } // namespace internal
 
+/// reseeds the generator of the calling shard, e.g. to replay a randomized
+/// sequence of operations
+inline void seed(std::default_random_engine::result_type s) {
+    internal::gen.seed(s);
+}
+
 template<typename T>
 T get_int() {
     std::uniform_int_distribution<T> dist;
@@ -10,9 +10,11 @@
 #define BOOST_TEST_MODULE random
 #include "random/fast_prng.h"
 #include "random/generators.h"
+#include "random/simple_time_jitter.h"
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
 #include <set>
 #include <utility>
 
@@ -34,3 +36,13 @@ BOOST_AUTO_TEST_CASE(alphanum_generator) {
         }
     }
 }
+BOOST_AUTO_TEST_CASE(jitter_window_narrowed_by_divisor) {
+    using namespace std::chrono_literals;
+    simple_time_jitter<std::chrono::steady_clock, std::chrono::milliseconds>
+      jit(1500ms, 1000ms);
+    for (auto i = 0; i < 100; ++i) {
+        BOOST_REQUIRE_LT(jit.next_jitter_duration(1), 1000ms);
+        BOOST_REQUIRE_LT(jit.next_jitter_duration(4), 250ms);
+        BOOST_REQUIRE_EQUAL(jit.next_jitter_duration(5000), 0ms);
+    }
+}
@@ -13,6 +13,8 @@
 
 #include "random/fast_prng.h"
 
+#include <algorithm>
+
 template<
   typename ClockType,
   typename DurationType = typename ClockType::duration>
@@ -33,8 +35,21 @@ public:
     DurationType next_jitter_duration() {
         return DurationType(_rand() % _jitter.count());
     }
+    /// jitter drawn from the first 1/divisor of the window, so that callers
+    /// with a larger divisor tend to fire first while the timeout stays
+    /// under base + jitter
+    DurationType next_jitter_duration(uint64_t divisor) {
+        const auto window = std::max<typename DurationType::rep>(
+          _jitter.count() / std::max<uint64_t>(divisor, 1), 1);
+        return DurationType(_rand() % window);
+    }
     DurationType next_duration() { return _base + next_jitter_duration(); }
 
+    void reset(DurationType base, DurationType jitter) {
+        _base = base;
+        _jitter = jitter;
+    }
+
 private:
     DurationType _base;
     DurationType _jitter;
@@ -21,9 +21,12 @@
 #include "redpanda/admin/api-doc/config.json.h"
 #include "redpanda/admin/api-doc/kafka.json.h"
 #include "redpanda/admin/api-doc/raft.json.h"
+#include "resource_mgmt/io_priority.h"
 #include "rpc/simple_protocol.h"
+#include "security/scram_algorithm.h"
 #include "storage/chunk_cache.h"
 #include "storage/directories.h"
+#include "storage/hugepage_arena.h"
 #include "syschecks/syschecks.h"
 #include "test_utils/logs.h"
 #include "utils/file_io.h"
@@ -32,18 +35,26 @@
 
 #include <seastar/core/metrics.hh>
 #include <seastar/core/prometheus.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sleep.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/http/api_docs.hh>
 #include <seastar/http/exception.hh>
+#include <seastar/http/function_handlers.hh>
 #include <seastar/json/json_elements.hh>
 #include <seastar/util/defer.hh>
 
+#include <absl/container/flat_hash_map.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <sys/utsname.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <exception>
+#include <filesystem>
+#include <string_view>
 #include <vector>
 
 int application::run(int ac, char** av) {
@@ -75,6 +86,7 @@ int application::run(int ac, char** av) {
                 hydrate_config(cfg);
                 initialize();
                 check_environment();
+                calibrate_disk(cfg);
                 setup_metrics();
                 configure_admin_server();
                 wire_up_services();
@@ -100,8 +112,43 @@ void application::initialize() {
     _scheduling_groups.create_groups().get();
     _deferred.emplace_back(
       [this] { _scheduling_groups.destroy_groups().get(); });
-    _smp_groups.create_groups().get();
+    _smp_groups
+      .create_groups(smp_groups::config{
+        .produce_max_nonlocal_requests
+        = config::shard_local_cfg().produce_smp_max_nonlocal_requests(),
+        .fetch_max_nonlocal_requests
+        = config::shard_local_cfg().fetch_smp_max_nonlocal_requests(),
+        .group_max_nonlocal_requests
+        = config::shard_local_cfg().group_smp_max_nonlocal_requests(),
+        .admin_max_nonlocal_requests
+        = config::shard_local_cfg().admin_smp_max_nonlocal_requests()})
+      .get();
     _deferred.emplace_back([this] { _smp_groups.destroy_groups().get(); });
+    construct_service(
+      _cpu_profiler,
+      config::shard_local_cfg().cpu_profiler_enabled(),
+      config::shard_local_cfg().cpu_profiler_sample_period_ms())
+      .get();
+    construct_service(
+      _scheduling_group_probe,
+      _scheduling_groups.all(),
+      config::shard_local_cfg().scheduling_group_probe_interval_ms(),
+      config::shard_local_cfg().disable_metrics())
+      .get();
+    _scheduling_group_probe.invoke_on_all(&scheduling_group_probe::start)
+      .get();
+    construct_service(
+      _smp_group_probe,
+      _smp_groups.all(),
+      config::shard_local_cfg().scheduling_group_probe_interval_ms(),
+      config::shard_local_cfg().disable_metrics())
+      .get();
+    _smp_group_probe.invoke_on_all(&smp_group_probe::start).get();
+    construct_service(_iobuf_pool_probe).get();
+    if (!config::shard_local_cfg().disable_metrics()) {
+        _iobuf_pool_probe.invoke_on_all(&iobuf_pool_probe::setup_metrics)
+          .get();
+    }
 }
 
 void application::setup_metrics() {
@@ -171,6 +218,45 @@ void application::check_environment() {
     storage::directories::initialize(
       config::shard_local_cfg().data_directory().as_sstring())
       .get();
+    for (auto& dir : config::shard_local_cfg().extra_data_directories()) {
+        storage::directories::initialize(dir).get();
+    }
+}
+
+/// seastar configures its io queues once at startup, the calibration only
+/// applies from the next start, when rpk passes the io-config.yaml next to
+/// the configuration file, the file iotune writes, to seastar.
+void application::calibrate_disk(const po::variables_map& cfg) {
+    if (!config::shard_local_cfg().enable_disk_calibration()) {
+        return;
+    }
+    if (cfg.count("io-properties") || cfg.count("io-properties-file")) {
+        vlog(_log.info, "IO properties given, skipping disk calibration");
+        return;
+    }
+    const auto io_config = std::filesystem::path(
+                             cfg["redpanda-cfg"].as<std::string>())
+                             .parent_path()
+                           / "io-config.yaml";
+    if (ss::file_exists(io_config.string()).get0()) {
+        vlog(
+          _log.info,
+          "IO properties stored in {}, skipping disk calibration",
+          io_config.string());
+        return;
+    }
+    syschecks::systemd_message("calibrating disk");
+    const auto data_dir
+      = config::shard_local_cfg().data_directory().as_sstring();
+    auto c = syschecks::calibrate_disk(
+               data_dir,
+               config::shard_local_cfg().disk_calibration_duration_ms())
+               .get0();
+    syschecks::write_io_properties(io_config, data_dir, c).get();
+    vlog(
+      _log.info,
+      "Stored the disk calibration in {}, it applies from the next start",
+      io_config.string());
 }
 
 void application::configure_admin_server() {
@@ -230,6 +316,9 @@ void application::configure_admin_server() {
                 });
               admin_register_raft_routes(server);
               admin_register_kafka_routes(server);
+              admin_register_profiler_routes(server);
+              admin_register_security_routes(server);
+              admin_register_partition_routes(server);
           })
           .get();
     }
@@ -268,8 +357,9 @@ static storage::kvstore_config kvstore_config_from_global_config() {
       storage::debug_sanitize_files::no);
 }
 
-static storage::log_config manager_config_from_global_config() {
-    return storage::log_config(
+static storage::log_config
+manager_config_from_global_config(scheduling_groups& sgs) {
+    auto cfg = storage::log_config(
       storage::log_config::storage_type::disk,
       config::shard_local_cfg().data_directory().as_sstring(),
       config::shard_local_cfg().log_segment_size(),
@@ -286,17 +376,98 @@ static storage::log_config manager_config_from_global_config() {
         .min_size = config::shard_local_cfg().reclaim_min_size(),
         .max_size = config::shard_local_cfg().reclaim_max_size(),
       });
+    if (config::shard_local_cfg().reclaim_adaptive_target()) {
+        cfg.reclaim_opts.min_target = memory_groups::batch_cache_min_memory();
+        cfg.reclaim_opts.max_target = ss::memory::stats().total_memory();
+    }
+    cfg.broker_memory = config::shard_local_cfg().enable_memory_broker();
+    cfg.compaction_sg = sgs.compaction_sg();
+    cfg.flush_coalesce_window = std::chrono::microseconds(
+      config::shard_local_cfg().segment_fsync_coalesce_window_us());
+    cfg.compaction_throttle_cfg = storage::compaction_throttle::config{
+      .max_bytes_per_sec
+      = config::shard_local_cfg().compaction_max_bytes_per_sec(),
+      .target_latency
+      = config::shard_local_cfg().compaction_backpressure_latency_ms(),
+    };
+    cfg.compaction_round_max_bytes
+      = config::shard_local_cfg().compaction_round_max_bytes();
+    cfg.segment_pool_files
+      = config::shard_local_cfg().log_segment_pool_files();
+    cfg.segment_prepare_percent
+      = config::shard_local_cfg().log_segment_prepare_percent();
+    cfg.disk_pressure_free_percent
+      = config::shard_local_cfg().disk_pressure_free_percent();
+    cfg.disk_pressure_target_free_percent
+      = config::shard_local_cfg().disk_pressure_target_free_percent();
+    cfg.disk_pressure_interval
+      = config::shard_local_cfg().disk_pressure_check_interval_ms();
+    cfg.readers_cache_cfg = storage::readers_cache::config{
+      .max_readers = config::shard_local_cfg().log_readers_cache_size(),
+      .idle_timeout = config::shard_local_cfg().log_readers_cache_idle_ms(),
+    };
+    cfg.probes_cfg = storage::log_probes::config{
+      .aggregate = config::shard_local_cfg().aggregate_partition_metrics(),
+      .detail_limit
+      = config::shard_local_cfg().partition_metrics_detail_limit(),
+      .rank_interval
+      = config::shard_local_cfg().partition_metrics_rank_interval_ms(),
+    };
+    cfg.reaper_cfg = storage::log_reaper::config{
+      .max_bytes_per_sec
+      = config::shard_local_cfg().log_deletion_max_bytes_per_sec(),
+      .sg = sgs.compaction_sg(),
+    };
+    cfg.index_interval = config::shard_local_cfg().log_index_interval_bytes();
+    cfg.adaptive_index = config::shard_local_cfg().log_index_adaptive();
+    cfg.extra_dirs = config::shard_local_cfg().extra_data_directories();
+    cfg.cold_storage_dir = config::shard_local_cfg().cold_storage_directory();
+    cfg.cold_storage_local_retention
+      = config::shard_local_cfg().cold_storage_local_retention_ms();
+    if (cfg.cold_storage_dir) {
+        cfg.cold_cache_cfg = storage::internal::segment_chunk_cache::config{
+          .directory = fmt::format("{}/cold_cache", cfg.base_dir),
+          .max_bytes = config::shard_local_cfg().cold_storage_cache_bytes(),
+          .prefetch_chunks
+          = config::shard_local_cfg().cold_storage_prefetch_chunks(),
+        };
+    }
+    return cfg;
+}
+
+static archival::uploader_config archival_config_from_global_config() {
+    auto& cfg = config::shard_local_cfg();
+    return archival::uploader_config{
+      .endpoint = cfg.archival_api_endpoint(),
+      .bucket = *cfg.archival_bucket(),
+      .upload_concurrency = cfg.archival_upload_concurrency(),
+      .max_bytes_per_sec = cfg.archival_upload_max_bytes_per_sec(),
+      .interval = cfg.archival_upload_interval_ms(),
+      .part_size = cfg.archival_upload_part_size(),
+    };
 }
 
 // add additional services in here
 void application::wire_up_services() {
     ss::smp::invoke_on_all([] {
+        if (config::shard_local_cfg().enable_memory_broker()) {
+            memory_broker::local().set_budget(
+              memory_groups::brokered_memory());
+        }
+        if (config::shard_local_cfg().enable_storage_hugepages()) {
+            storage::internal::hugepages().start(
+              memory_groups::storage_hugepage_memory());
+        }
         return storage::internal::chunks().start();
     }).get();
 
     // cluster
     syschecks::systemd_message("Adding raft client cache");
-    construct_service(_raft_connection_cache).get();
+    construct_service(
+      _raft_connection_cache,
+      config::shard_local_cfg().rpc_client_connections_per_peer(),
+      rpc::metrics_disabled(config::shard_local_cfg().disable_metrics()))
+      .get();
     syschecks::systemd_message("Building shard-lookup tables");
     construct_service(shard_table).get();
 
@@ -304,7 +475,7 @@ void application::wire_up_services() {
     construct_service(
       storage,
       kvstore_config_from_global_config(),
-      manager_config_from_global_config())
+      manager_config_from_global_config(_scheduling_groups))
       .get();
 
     if (coproc_enabled()) {
@@ -336,6 +507,16 @@ void application::wire_up_services() {
       .get();
     vlog(_log.info, "Partition manager started");
 
+    if (config::shard_local_cfg().archival_bucket()) {
+        syschecks::systemd_message("Creating archival uploader");
+        construct_service(
+          archival_uploader,
+          archival_config_from_global_config(),
+          std::ref(partition_manager),
+          std::ref(storage))
+          .get();
+    }
+
     // controller
 
     syschecks::systemd_message("Creating cluster::controller");
@@ -381,7 +562,7 @@ void application::wire_up_services() {
     construct_service(
       group_router,
       _scheduling_groups.kafka_sg(),
-      _smp_groups.kafka_smp_sg(),
+      _smp_groups.group_smp_sg(),
       std::ref(_group_manager),
       std::ref(shard_table),
       std::ref(coordinator_ntp_mapper))
@@ -399,6 +580,17 @@ void application::wire_up_services() {
     rpc_cfg.load_balancing_algo
       = ss::server_socket::load_balancing_algorithm::port;
     rpc_cfg.max_service_memory_per_core = memory_groups::rpc_total_memory();
+    if (config::shard_local_cfg().enable_memory_broker()) {
+        rpc_cfg.memory_share = memory_broker::share{
+          .min_bytes = memory_groups::rpc_min_memory(),
+          .max_bytes = memory_groups::rpc_max_memory()};
+    }
+    // raft votes and heartbeats keep their own pool, snapshots are capped
+    rpc_cfg.protected_memory_per_core
+      = config::shard_local_cfg().rpc_server_protected_memory();
+    rpc_cfg.bulk_memory_per_core
+      = memory_groups::rpc_total_memory()
+        * config::shard_local_cfg().rpc_server_bulk_memory_percent() / 100;
     auto rpc_server_addr
       = config::shard_local_cfg().rpc_server().resolve().get0();
     rpc_cfg.addrs.push_back(rpc_server_addr);
@@ -438,6 +630,12 @@ void application::wire_up_services() {
 
     rpc::server_configuration kafka_cfg("kafka_rpc");
     kafka_cfg.max_service_memory_per_core = memory_groups::kafka_total_memory();
+    if (config::shard_local_cfg().enable_memory_broker()) {
+        kafka_cfg.memory_share = memory_broker::share{
+          .min_bytes = memory_groups::kafka_min_memory(),
+          .max_bytes = memory_groups::kafka_max_memory()};
+        kafka_cfg.memory_priority = memory_broker::priority::kafka;
+    }
     auto kafka_addr = config::shard_local_cfg().kafka_api().resolve().get0();
     kafka_cfg.addrs.push_back(kafka_addr);
     syschecks::systemd_message("Building TLS credentials for kafka");
@@ -460,7 +658,13 @@ void application::wire_up_services() {
     construct_service(_kafka_server, kafka_cfg).get();
     construct_service(
       fetch_session_cache,
-      config::shard_local_cfg().fetch_session_eviction_timeout_ms())
+      config::shard_local_cfg().fetch_session_eviction_timeout_ms(),
+      config::shard_local_cfg().fetch_session_cache_memory_bytes())
+      .get();
+    construct_service(metadata_response_cache).get();
+    construct_service(
+      down_conversion_cache,
+      config::shard_local_cfg().kafka_down_conversion_cache_bytes())
       .get();
 }
 
@@ -471,6 +675,11 @@ void application::start() {
     syschecks::systemd_message("Starting the partition manager");
     partition_manager.invoke_on_all(&cluster::partition_manager::start).get();
 
+    if (config::shard_local_cfg().archival_bucket()) {
+        syschecks::systemd_message("Starting archival uploader");
+        archival_uploader.invoke_on_all(&archival::uploader::start).get();
+    }
+
     syschecks::systemd_message("Starting Raft group manager");
     raft_group_manager.invoke_on_all(&raft::group_manager::start).get();
 
@@ -478,7 +687,11 @@ void application::start() {
     _group_manager.invoke_on_all(&kafka::group_manager::start).get();
 
     syschecks::systemd_message("Starting controller");
-    controller->start().get0();
+    // fibers spawned by the controller inherit its scheduling group
+    ss::with_scheduling_group(
+      _scheduling_groups.controller_sg(),
+      [this] { return controller->start(); })
+      .get0();
 
     // FIXME: in first patch explain why this is started after the
     // controller so the broker set will be available. Then next patch fix.
@@ -498,7 +711,7 @@ void application::start() {
             partition_manager,
             shard_table.local());
           proto->register_service<cluster::service>(
-            _scheduling_groups.cluster_sg(),
+            _scheduling_groups.controller_sg(),
             _smp_groups.cluster_smp_sg(),
             std::ref(controller->get_topics_frontend()),
             std::ref(controller->get_members_manager()),
@@ -539,7 +752,10 @@ void application::start() {
     _kafka_server
       .invoke_on_all([this](rpc::server& s) {
           auto proto = std::make_unique<kafka::protocol>(
-            _smp_groups.kafka_smp_sg(),
+            kafka::protocol::api_smp_groups{
+              .produce = _smp_groups.produce_smp_sg(),
+              .fetch = _smp_groups.fetch_smp_sg(),
+              .other = _smp_groups.kafka_smp_sg()},
             metadata_cache,
             controller->get_topics_frontend(),
             _quota_mgr,
@@ -547,7 +763,10 @@ void application::start() {
             shard_table,
             partition_manager,
             coordinator_ntp_mapper,
-            fetch_session_cache);
+            fetch_session_cache,
+            metadata_response_cache,
+            down_conversion_cache,
+            controller->get_credential_store());
           s.set_protocol(std::move(proto));
       })
       .get();
@@ -555,10 +774,32 @@ void application::start() {
     vlog(
       _log.info, "Started Kafka API server listening at {}", conf.kafka_api());
 
+    // runs first on shutdown, while the rpc servers still run
+    _deferred.emplace_back([this] { drain_leadership(); });
+
     vlog(_log.info, "Successfully started Redpanda!");
     syschecks::systemd_notify_ready();
 }
 
+void application::drain_leadership() {
+    const auto& cfg = config::shard_local_cfg();
+    const auto timeout = cfg.shutdown_leadership_transfer_timeout_ms();
+    if (timeout <= std::chrono::milliseconds::zero()) {
+        return;
+    }
+    vlog(_log.info, "Transferring leadership before stopping");
+    const auto deadline = raft::clock_type::now() + timeout;
+    const auto concurrency = cfg.shutdown_leadership_transfer_concurrency();
+    raft_group_manager
+      .invoke_on_all([concurrency, deadline](raft::group_manager& m) {
+          return m.drain_leadership(concurrency, deadline);
+      })
+      .handle_exception([this](const std::exception_ptr& e) {
+          vlog(_log.warn, "Error transferring leadership - {}", e);
+      })
+      .get();
+}
+
 void application::admin_register_raft_routes(ss::http_server& server) {
     ss::httpd::raft_json::transfer_leadership.set(
       server._routes, [this](std::unique_ptr<ss::httpd::request> req) {
@@ -604,7 +845,9 @@ void application::admin_register_raft_routes(ss::http_server& server) {
           auto shard = shard_table.local().shard_for(group_id);
 
           return partition_manager.invoke_on(
-            shard, [group_id, target](cluster::partition_manager& pm) mutable {
+            shard,
+            _smp_groups.admin_smp_sg(),
+            [group_id, target](cluster::partition_manager& pm) mutable {
                 auto consensus = pm.consensus_for(group_id);
                 if (!consensus) {
                     throw ss::httpd::not_found_exception();
@@ -673,6 +916,7 @@ void application::admin_register_kafka_routes(ss::http_server& server) {
 
           return partition_manager.invoke_on(
             *shard,
+            _smp_groups.admin_smp_sg(),
             [ntp = std::move(ntp),
              target](cluster::partition_manager& pm) mutable {
                 auto partition = pm.get(ntp);
@@ -689,4 +933,415 @@ void application::admin_register_kafka_routes(ss::http_server& server) {
                   });
             });
       });
+
+    /*
+     * GET /v1/kafka/group_offsets?group=<id>[&max_age_ms=<ms>]
+     *
+     * committed offsets of the group, one `topic partition offset` line per
+     * partition. offsets may be up to max_age_ms (default 10s) behind the
+     * coordinator, so that lag monitoring may scrape every group often
+     */
+    server._routes.add(
+      ss::httpd::operation_type::GET,
+      ss::httpd::url("/v1/kafka/group_offsets"),
+      new ss::httpd::function_handler(
+        [this](
+          std::unique_ptr<ss::httpd::request> req,
+          std::unique_ptr<ss::httpd::reply> rep) {
+            auto group = kafka::group_id(req->get_query_param("group"));
+            if (group().empty()) {
+                throw ss::httpd::bad_param_exception("Group is required");
+            }
+            std::chrono::milliseconds max_age(10000);
+            if (auto age = req->get_query_param("max_age_ms"); !age.empty()) {
+                try {
+                    max_age = std::chrono::milliseconds(std::stoull(age));
+                } catch (...) {
+                    throw ss::httpd::bad_param_exception(
+                      fmt::format("Max age must be an integer: {}", age));
+                }
+            }
+            return group_router.local()
+              .cached_offset_fetch(group, max_age)
+              .then([group, rep = std::move(rep)](
+                      kafka::offset_fetch_response resp) mutable {
+                  if (resp.data.error_code != kafka::error_code::none) {
+                      throw ss::httpd::server_error_exception(fmt::format(
+                        "Unable to fetch offsets of group {}: {}",
+                        group,
+                        resp.data.error_code));
+                  }
+                  for (const auto& t : resp.data.topics) {
+                      for (const auto& p : t.partitions) {
+                          rep->_content += fmt::format(
+                            "{} {} {}\n",
+                            t.name,
+                            p.partition_index,
+                            p.committed_offset);
+                      }
+                  }
+                  return std::move(rep);
+              });
+        },
+        "txt"));
+
+    /*
+     * GET /v1/kafka/keys?topic=<topic>&partition=<id>&key=<key>
+     *
+     * latest record of a key in a partition of a compacted topic led by this
+     * node, as an `<offset> <timestamp> <base64 value>` line. the value is
+     * `-` for a tombstone. the compacted indices of the closed segments point
+     * at the batches to read, so only the active segment is scanned
+     */
+    server._routes.add(
+      ss::httpd::operation_type::GET,
+      ss::httpd::url("/v1/kafka/keys"),
+      new ss::httpd::function_handler(
+        [this](
+          std::unique_ptr<ss::httpd::request> req,
+          std::unique_ptr<ss::httpd::reply> rep) {
+            auto topic = model::topic(req->get_query_param("topic"));
+            if (topic().empty()) {
+                throw ss::httpd::bad_param_exception("Topic is required");
+            }
+            auto p = req->get_query_param("partition");
+            model::partition_id partition;
+            try {
+                partition = model::partition_id(std::stoll(p));
+            } catch (...) {
+                throw ss::httpd::bad_param_exception(
+                  fmt::format("Partition id must be an integer: {}", p));
+            }
+            auto k = req->get_query_param("key");
+            if (k.empty()) {
+                throw ss::httpd::bad_param_exception("Key is required");
+            }
+            bytes key(reinterpret_cast<const uint8_t*>(k.data()), k.size());
+
+            model::ntp ntp(cluster::kafka_namespace, topic, partition);
+            auto shard = shard_table.local().shard_for(ntp);
+            if (!shard) {
+                throw ss::httpd::not_found_exception(fmt::format(
+                  "Topic partition {}:{} not found", topic, partition));
+            }
+            return partition_manager
+              .invoke_on(
+                *shard,
+                _smp_groups.admin_smp_sg(),
+                [ntp = std::move(ntp), key = std::move(key)](
+                  cluster::partition_manager& pm) mutable {
+                    auto partition = pm.get(ntp);
+                    if (!partition) {
+                        throw ss::httpd::not_found_exception();
+                    }
+                    if (!partition->is_leader()) {
+                        throw ss::httpd::bad_param_exception(
+                          fmt::format("Not the leader of {}", ntp));
+                    }
+                    if (!partition->log_config().is_compacted()) {
+                        throw ss::httpd::bad_param_exception(
+                          fmt::format("Not a compacted topic: {}", ntp));
+                    }
+                    return partition
+                      ->lookup_key(std::move(key), kafka_read_priority())
+                      .then([](std::optional<storage::key_lookup_result> r) {
+                          if (!r) {
+                              throw ss::httpd::not_found_exception(
+                                "Key not found");
+                          }
+                          ss::sstring value("-");
+                          if (r->value) {
+                              value = security::base64_encode(
+                                iobuf_to_bytes(*r->value));
+                          }
+                          return ss::sstring(fmt::format(
+                            "{} {} {}\n", r->offset, r->timestamp, value));
+                      });
+                })
+              .then([rep = std::move(rep)](ss::sstring line) mutable {
+                  rep->_content = std::move(line);
+                  return std::move(rep);
+              });
+        },
+        "txt"));
+}
+
+void application::admin_register_profiler_routes(ss::http_server& server) {
+    /*
+     * GET /v1/profiler/cpu[?shard=<id>][&group=<scheduling group>]
+     *
+     * folded stacks of the samples currently held by the profilers, of all
+     * the shards unless one is given. the output can be fed directly to
+     * flamegraph.pl
+     */
+    server._routes.add(
+      ss::httpd::operation_type::GET,
+      ss::httpd::url("/v1/profiler/cpu"),
+      new ss::httpd::function_handler(
+        [this](
+          std::unique_ptr<ss::httpd::request> req,
+          std::unique_ptr<ss::httpd::reply> rep) {
+            auto collect = [](const cpu_profiler& p) { return p.collect(); };
+            auto merge = [](
+                           cpu_profiler::folded_stacks acc,
+                           cpu_profiler::folded_stacks s) {
+                for (auto& [stack, count] : s) {
+                    acc[stack] += count;
+                }
+                return acc;
+            };
+            auto f = ss::make_ready_future<cpu_profiler::folded_stacks>();
+            if (auto shard = req->get_query_param("shard"); !shard.empty()) {
+                ss::shard_id id;
+                try {
+                    id = std::stoul(shard);
+                } catch (...) {
+                    throw ss::httpd::bad_param_exception(
+                      fmt::format("Shard must be an integer: {}", shard));
+                }
+                if (id >= ss::smp::count) {
+                    throw ss::httpd::bad_param_exception(
+                      fmt::format("Invalid shard {}", id));
+                }
+                f = _cpu_profiler.invoke_on(id, collect);
+            } else {
+                f = _cpu_profiler.map_reduce0(
+                  collect, cpu_profiler::folded_stacks{}, merge);
+            }
+            return f.then([group = req->get_query_param("group"),
+                           rep = std::move(rep)](
+                            cpu_profiler::folded_stacks stacks) mutable {
+                std::vector<std::pair<ss::sstring, uint64_t>> lines;
+                lines.reserve(stacks.size());
+                for (auto& [stack, count] : stacks) {
+                    // stacks start with the scheduling group name
+                    std::string_view s(stack);
+                    if (
+                      group.empty()
+                      || (s.size() > group.size()
+                          && s.substr(0, group.size()) == group
+                          && s[group.size()] == ';')) {
+                        lines.emplace_back(stack, count);
+                    }
+                }
+                std::sort(
+                  lines.begin(), lines.end(), [](auto& a, auto& b) {
+                      return a.second > b.second;
+                  });
+                for (auto& [stack, count] : lines) {
+                    rep->_content += fmt::format("{} {}\n", stack, count);
+                }
+                return std::move(rep);
+            });
+        },
+        "txt"));
+}
+
+void application::admin_register_security_routes(ss::http_server& server) {
+    static constexpr auto user_timeout = std::chrono::seconds(5);
+    /*
+     * POST /v1/security/users?username=<name>[&mechanism=<mechanism>]
+     *
+     * creates the user with the password in the body of the request. the
+     * credential is derived here, once, and replicated through the controller
+     * to every core of every node. the mechanism is SCRAM-SHA-256, the
+     * default, or SCRAM-SHA-512
+     */
+    server._routes.add(
+      ss::httpd::operation_type::POST,
+      ss::httpd::url("/v1/security/users"),
+      new ss::httpd::function_handler(
+        [this](
+          std::unique_ptr<ss::httpd::request> req,
+          std::unique_ptr<ss::httpd::reply> rep) {
+            auto user = security::credential_user(
+              req->get_query_param("username"));
+            if (user().empty()) {
+                throw ss::httpd::bad_param_exception("Username is required");
+            }
+            if (req->content.empty()) {
+                throw ss::httpd::bad_param_exception("Password is required");
+            }
+            auto mechanism = req->get_query_param("mechanism");
+            security::scram_credential credential;
+            if (
+              mechanism.empty() || mechanism == security::scram_sha256::name) {
+                credential = security::scram_sha256::make_credentials(
+                  req->content, security::scram_sha256::min_iterations);
+            } else if (mechanism == security::scram_sha512::name) {
+                credential = security::scram_sha512::make_credentials(
+                  req->content, security::scram_sha512::min_iterations);
+            } else {
+                throw ss::httpd::bad_param_exception(
+                  fmt::format("Unsupported mechanism {}", mechanism));
+            }
+            return controller->get_security_frontend()
+              .local()
+              .create_user(
+                user,
+                std::move(credential),
+                model::timeout_clock::now() + user_timeout)
+              .then([user, rep = std::move(rep)](std::error_code err) mutable {
+                  if (err) {
+                      throw ss::httpd::server_error_exception(fmt::format(
+                        "Unable to create user {}: {}", user, err.message()));
+                  }
+                  return std::move(rep);
+              });
+        },
+        "txt"));
+
+    // DELETE /v1/security/users?username=<name>
+    server._routes.add(
+      ss::httpd::operation_type::DELETE,
+      ss::httpd::url("/v1/security/users"),
+      new ss::httpd::function_handler(
+        [this](
+          std::unique_ptr<ss::httpd::request> req,
+          std::unique_ptr<ss::httpd::reply> rep) {
+            auto user = security::credential_user(
+              req->get_query_param("username"));
+            if (user().empty()) {
+                throw ss::httpd::bad_param_exception("Username is required");
+            }
+            return controller->get_security_frontend()
+              .local()
+              .delete_user(user, model::timeout_clock::now() + user_timeout)
+              .then([user, rep = std::move(rep)](std::error_code err) mutable {
+                  if (err) {
+                      throw ss::httpd::server_error_exception(fmt::format(
+                        "Unable to delete user {}: {}", user, err.message()));
+                  }
+                  return std::move(rep);
+              });
+        },
+        "txt"));
+}
+
+using partition_samples
+  = absl::flat_hash_map<model::ntp, cluster::partition_counters>;
+
+/// counters of the partitions of every shard
+static ss::future<partition_samples>
+snapshot_partitions(ss::sharded<cluster::partition_manager>& pm) {
+    using shard_samples
+      = std::vector<std::pair<model::ntp, cluster::partition_counters>>;
+    return pm.map_reduce0(
+      [](const cluster::partition_manager& mgr) {
+          shard_samples ret;
+          ret.reserve(mgr.partitions().size());
+          for (const auto& [ntp, p] : mgr.partitions()) {
+              ret.emplace_back(ntp, p->probe().counters());
+          }
+          return ret;
+      },
+      partition_samples{},
+      [](partition_samples acc, shard_samples s) {
+          for (auto& [ntp, c] : s) {
+              acc.insert_or_assign(std::move(ntp), c);
+          }
+          return acc;
+      });
+}
+
+void application::admin_register_partition_routes(ss::http_server& server) {
+    static constexpr auto max_window = std::chrono::seconds(10);
+    /*
+     * GET /v1/partitions/hot[?window_ms=<ms>][&limit=<n>]
+     *
+     * partitions of this node with the most produce bytes, fetch bytes,
+     * requests and batch cache misses over a window (default 1s, at most
+     * 10s). one `<metric> <ns>/<topic>/<partition> <per second>` line per
+     * partition among the top `limit` (default 10) of every metric. the
+     * counters are always maintained, sampling only reads them twice
+     */
+    server._routes.add(
+      ss::httpd::operation_type::GET,
+      ss::httpd::url("/v1/partitions/hot"),
+      new ss::httpd::function_handler(
+        [this](
+          std::unique_ptr<ss::httpd::request> req,
+          std::unique_ptr<ss::httpd::reply> rep) {
+            std::chrono::milliseconds window(1000);
+            size_t limit = 10;
+            try {
+                if (auto w = req->get_query_param("window_ms"); !w.empty()) {
+                    window = std::chrono::milliseconds(std::stoull(w));
+                }
+                if (auto l = req->get_query_param("limit"); !l.empty()) {
+                    limit = std::stoull(l);
+                }
+            } catch (...) {
+                throw ss::httpd::bad_param_exception(
+                  "Window and limit must be integers");
+            }
+            if (window.count() == 0 || window > max_window) {
+                throw ss::httpd::bad_param_exception(fmt::format(
+                  "Window must be between 1ms and {}ms",
+                  std::chrono::milliseconds(max_window).count()));
+            }
+            return snapshot_partitions(partition_manager)
+              .then([this, window](partition_samples before) {
+                  return ss::sleep(window).then(
+                    [this, before = std::move(before)]() mutable {
+                        return snapshot_partitions(partition_manager)
+                          .then([before = std::move(before)](
+                                  partition_samples after) {
+                              for (auto& [ntp, c] : after) {
+                                  if (auto it = before.find(ntp);
+                                      it != before.end()) {
+                                      c -= it->second;
+                                  }
+                              }
+                              return after;
+                          });
+                    });
+              })
+              .then([window, limit, rep = std::move(rep)](
+                      partition_samples samples) mutable {
+                  using field = uint64_t cluster::partition_counters::*;
+                  static constexpr std::array<
+                    std::pair<std::string_view, field>,
+                    4>
+                    metrics{{
+                      {"produce_bytes",
+                       &cluster::partition_counters::produce_bytes},
+                      {"fetch_bytes",
+                       &cluster::partition_counters::fetch_bytes},
+                      {"requests", &cluster::partition_counters::requests},
+                      {"cache_misses",
+                       &cluster::partition_counters::cache_misses},
+                    }};
+                  std::vector<std::pair<uint64_t, const model::ntp*>> top;
+                  top.reserve(samples.size());
+                  for (const auto& [name, f] : metrics) {
+                      top.clear();
+                      for (const auto& [ntp, c] : samples) {
+                          if (c.*f > 0) {
+                              top.emplace_back(c.*f, &ntp);
+                          }
+                      }
+                      const auto n = std::min(limit, top.size());
+                      std::partial_sort(
+                        top.begin(),
+                        top.begin() + n,
+                        top.end(),
+                        [](const auto& a, const auto& b) {
+                            return a.first > b.first;
+                        });
+                      for (size_t i = 0; i < n; ++i) {
+                          const auto& ntp = *top[i].second;
+                          rep->_content += fmt::format(
+                            "{} {}/{}/{} {}\n",
+                            name,
+                            ntp.ns,
+                            ntp.tp.topic,
+                            ntp.tp.partition,
+                            top[i].first * 1000 / window.count());
+                      }
+                  }
+                  return std::move(rep);
+              });
+        },
+        "txt"));
 }
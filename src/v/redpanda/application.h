@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "archival/uploader.h"
 #include "cluster/controller.h"
 #include "cluster/metadata_cache.h"
 #include "cluster/metadata_dissemination_service.h"
@@ -18,7 +19,9 @@
 #include "config/configuration.h"
 #include "coproc/router.h"
 #include "coproc/service.h"
+#include "kafka/down_conversion.h"
 #include "kafka/fetch_session_cache.h"
+#include "kafka/metadata_response_cache.h"
 #include "kafka/groups/coordinator_ntp_mapper.h"
 #include "kafka/groups/group_manager.h"
 #include "kafka/groups/group_router.h"
@@ -30,6 +33,10 @@
 #include "rpc/server.h"
 #include "seastarx.h"
 #include "storage/api.h"
+#include "utils/cpu_profiler.h"
+#include "utils/iobuf_pool_probe.h"
+#include "utils/scheduling_group_probe.h"
+#include "utils/smp_group_probe.h"
 
 #include <seastar/core/app-template.hh>
 #include <seastar/core/metrics_registration.hh>
@@ -49,6 +56,8 @@ public:
     void configure_admin_server();
     void wire_up_services();
     void start();
+    /// hands over the leaderships of the node before its services stop
+    void drain_leadership();
 
     void shutdown() {
         while (!_deferred.empty()) {
@@ -62,12 +71,15 @@ public:
     ss::sharded<storage::api> storage;
     ss::sharded<coproc::router> router;
     ss::sharded<cluster::partition_manager> partition_manager;
+    ss::sharded<archival::uploader> archival_uploader;
     ss::sharded<raft::group_manager> raft_group_manager;
     ss::sharded<cluster::metadata_dissemination_service>
       md_dissemination_service;
     ss::sharded<kafka::coordinator_ntp_mapper> coordinator_ntp_mapper;
     std::unique_ptr<cluster::controller> controller;
     ss::sharded<kafka::fetch_session_cache> fetch_session_cache;
+    ss::sharded<kafka::metadata_response_cache> metadata_response_cache;
+    ss::sharded<kafka::down_conversion_cache> down_conversion_cache;
 
 private:
     using deferred_actions
@@ -78,9 +90,13 @@ private:
     ss::app_template setup_app_template();
     void validate_arguments(const po::variables_map&);
     void hydrate_config(const po::variables_map&);
+    void calibrate_disk(const po::variables_map&);
 
     void admin_register_raft_routes(ss::http_server& server);
     void admin_register_kafka_routes(ss::http_server& server);
+    void admin_register_profiler_routes(ss::http_server& server);
+    void admin_register_security_routes(ss::http_server& server);
+    void admin_register_partition_routes(ss::http_server& server);
 
     bool coproc_enabled() {
         const auto& cfg = config::shard_local_cfg();
@@ -110,6 +126,10 @@ private:
     ss::sharded<kafka::group_manager> _group_manager;
     ss::sharded<rpc::server> _rpc;
     ss::sharded<ss::http_server> _admin;
+    ss::sharded<cpu_profiler> _cpu_profiler;
+    ss::sharded<scheduling_group_probe> _scheduling_group_probe;
+    ss::sharded<smp_group_probe> _smp_group_probe;
+    ss::sharded<iobuf_pool_probe> _iobuf_pool_probe;
     ss::sharded<kafka::quota_manager> _quota_mgr;
     ss::sharded<rpc::server> _kafka_server;
     ss::metrics::metric_groups _metrics;
@@ -184,7 +184,11 @@ public:
           app.shard_table.local(),
           app.partition_manager,
           app.coordinator_ntp_mapper,
-          app.fetch_session_cache);
+          app.fetch_session_cache,
+          app.metadata_response_cache,
+          app.down_conversion_cache,
+          app.controller->get_credential_store(),
+          nullptr);
 
         iobuf buf;
         kafka::fetch_request request;
@@ -203,7 +207,11 @@ public:
           app.shard_table.local(),
           app.partition_manager,
           app.coordinator_ntp_mapper,
-          app.fetch_session_cache);
+          app.fetch_session_cache,
+          app.metadata_response_cache,
+          app.down_conversion_cache,
+          app.controller->get_credential_store(),
+          nullptr);
     }
 
     application app;
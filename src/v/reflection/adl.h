@@ -11,20 +11,29 @@
 
 #pragma once
 
+#include "bytes/details/out_of_range.h"
 #include "bytes/iobuf.h"
 #include "bytes/iobuf_parser.h"
 #include "reflection/for_each_field.h"
+#include "reflection/to_tuple.h"
 #include "seastarx.h"
 #include "utils/named_type.h"
 
 #include <seastar/core/byteorder.hh>
 #include <seastar/core/sstring.hh>
 
+#include <algorithm>
 #include <optional>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
 namespace reflection {
+/// iobufs of at least this size are serialized by sharing their fragments,
+/// smaller ones are copied so that keys and values of records do not bloat
+/// the number of fragments sent down the wire
+inline constexpr size_t min_shared_iobuf_bytes = 512;
+
 template<typename T>
 struct is_std_vector : std::false_type {};
 template<typename... Args>
@@ -53,6 +62,64 @@ struct is_ss_bool<ss::bool_class<T>> : std::true_type {};
 template<typename T>
 inline constexpr bool is_ss_bool_v = is_ss_bool<T>::value;
 
+template<typename T>
+struct adl;
+
+namespace detail {
+
+template<typename T, typename = void>
+struct has_compact_adl : std::false_type {};
+
+template<typename T>
+struct has_compact_adl<T, std::void_t<decltype(adl<T>::is_compact)>>
+  : std::bool_constant<adl<T>::is_compact> {};
+
+template<typename T>
+inline constexpr bool has_compact_adl_v = has_compact_adl<T>::value;
+
+template<typename T, typename Fields>
+struct has_compact_fields : std::false_type {};
+
+// fields without padding in between, each of them compact
+template<typename T, typename... F>
+struct has_compact_fields<T, std::tuple<F&...>>
+  : std::bool_constant<
+      (has_compact_adl_v<std::decay_t<F>> && ...)
+      && (sizeof(F) + ... + 0) == sizeof(T)> {};
+
+/// whether the in memory layout of T is the layout adl writes, so that it
+/// is serialized with a single copy of its bytes. types with their own adl
+/// specialization are never compact
+template<typename T>
+constexpr bool is_compact() {
+    if constexpr (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__) {
+        return false;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        // any other byte than 0 or 1 read into a bool is undefined
+        return false;
+    } else if constexpr (std::is_integral_v<T>) {
+        return true;
+    } else if constexpr (std::is_enum_v<T>) {
+        return is_compact<std::underlying_type_t<T>>();
+    } else if constexpr (is_named_type_v<T>) {
+        using value_type = typename T::type;
+        return has_compact_adl_v<value_type>
+               && sizeof(T) == sizeof(value_type);
+    } else if constexpr (std::is_same_v<T, std::chrono::milliseconds>) {
+        return sizeof(T) == sizeof(int64_t);
+    } else if constexpr (
+      std::is_aggregate_v<T> && std::is_standard_layout_v<T>
+      && std::is_trivially_copyable_v<T>) {
+        return has_compact_fields<
+          T,
+          decltype(reflection::to_tuple(std::declval<T&>()))>::value;
+    } else {
+        return false;
+    }
+}
+
+} // namespace detail
+
 template<typename T>
 struct adl {
     using type = std::remove_reference_t<std::decay_t<T>>;
@@ -70,6 +137,7 @@ struct adl {
     static constexpr bool is_ss_bool = is_ss_bool_v<T>;
     static constexpr bool is_chrono_milliseconds
       = std::is_same_v<type, std::chrono::milliseconds>;
+    static constexpr bool is_compact = detail::is_compact<type>();
 
     static_assert(
       is_optional || is_sstring || is_vector || is_named_type || is_iobuf
@@ -98,9 +166,23 @@ struct adl {
             using value_type = typename type::value_type;
             int32_t n = in.consume_type<int32_t>();
             std::vector<value_type> ret;
-            ret.reserve(n);
-            while (n-- > 0) {
-                ret.push_back(adl<value_type>{}.from(in));
+            if constexpr (detail::has_compact_adl_v<value_type>) {
+                // checked before resizing for the vector, a corrupt size
+                // must not allocate the memory it claims
+                const size_t bytes = std::max(n, 0) * sizeof(value_type);
+                if (bytes > in.bytes_left()) {
+                    details::throw_out_of_range(
+                      "Invalid vector of {} bytes, {} bytes left",
+                      bytes,
+                      in.bytes_left());
+                }
+                ret.resize(std::max(n, 0));
+                in.consume_to(bytes, reinterpret_cast<char*>(ret.data()));
+            } else {
+                ret.reserve(n);
+                while (n-- > 0) {
+                    ret.push_back(adl<value_type>{}.from(in));
+                }
             }
             return ret;
         } else if constexpr (is_iobuf) {
@@ -115,6 +197,8 @@ struct adl {
         } else if constexpr (is_chrono_milliseconds) {
             return std::chrono::milliseconds(
               ss::le_to_cpu(in.consume_type<int64_t>()));
+        } else if constexpr (is_compact) {
+            return in.consume_type<type>();
         } else if constexpr (is_standard_layout) {
             T t;
             reflection::for_each_field(t, [&in](auto& field) mutable {
@@ -149,13 +233,23 @@ struct adl {
         } else if constexpr (is_vector) {
             using value_type = typename type::value_type;
             adl<int32_t>{}.to(out, t.size());
-            for (value_type& i : t) {
-                adl<value_type>{}.to(out, std::move(i));
+            if constexpr (detail::has_compact_adl_v<value_type>) {
+                out.append(
+                  reinterpret_cast<const char*>(t.data()),
+                  t.size() * sizeof(value_type));
+            } else {
+                for (value_type& i : t) {
+                    adl<value_type>{}.to(out, std::move(i));
+                }
             }
             return;
         } else if constexpr (is_iobuf) {
             adl<int32_t>{}.to(out, t.size_bytes());
-            out.append(std::move(t));
+            if (t.size_bytes() >= min_shared_iobuf_bytes) {
+                out.append_fragments(std::move(t));
+            } else {
+                out.append(std::move(t));
+            }
             return;
         } else if constexpr (is_enum) {
             using e_type = std::underlying_type_t<type>;
@@ -169,6 +263,9 @@ struct adl {
         } else if constexpr (is_chrono_milliseconds) {
             adl<int64_t>{}.to(out, t.count());
             return;
+        } else if constexpr (is_compact) {
+            out.append(reinterpret_cast<const char*>(&t), sizeof(type));
+            return;
         } else if constexpr (is_standard_layout) {
             /*
             std::apply(
@@ -13,8 +13,21 @@
 #include "reflection/adl.h"
 #include "ssx/future-util.h"
 
-#include <boost/range/irange.hpp>
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+
+#include <algorithm>
+
 namespace reflection {
+
+/// \brief work done in between checks for preemption while (de)serializing
+/// the elements of a container, whichever limit is reached first. without
+/// checks a multi megabyte message stalls the reactor
+struct yield_budget {
+    size_t bytes{128 * 1024};
+    size_t elements{1024};
+};
+
 template<typename T>
 struct async_adl {
     using type = std::remove_reference_t<std::decay_t<T>>;
@@ -28,24 +41,73 @@ struct async_adl {
     }
 };
 
+/// \brief serializes the vector with the layout of adl, giving the reactor
+/// a chance to preempt every chunk of the budget
+template<typename T>
+ss::future<>
+async_serialize_vector(iobuf& out, std::vector<T> v, yield_budget budget) {
+    adl<int32_t>{}.to(out, v.size());
+    return ss::do_with(
+      std::move(v), size_t(0), [&out, budget](std::vector<T>& v, size_t& i) {
+          return ss::repeat([&out, &v, &i, budget] {
+              const size_t until = std::min(v.size(), i + budget.elements);
+              const size_t start_bytes = out.size_bytes();
+              while (i < until
+                     && out.size_bytes() - start_bytes < budget.bytes) {
+                  auto f = async_adl<T>{}.to(out, std::move(v[i++]));
+                  if (!f.available()) {
+                      return f.then([] { return ss::stop_iteration::no; });
+                  }
+                  f.get();
+              }
+              return ss::make_ready_future<ss::stop_iteration>(
+                ss::stop_iteration(i == v.size()));
+          });
+      });
+}
+
+/// \brief reverse of async_serialize_vector
+template<typename T>
+ss::future<std::vector<T>>
+async_deserialize_vector(iobuf_parser& in, yield_budget budget) {
+    const size_t size = std::max(adl<int32_t>{}.from(in), 0);
+    std::vector<T> ret;
+    ret.reserve(size);
+    return ss::do_with(
+      std::move(ret), [&in, size, budget](std::vector<T>& ret) {
+          return ss::repeat([&in, &ret, size, budget] {
+                     const size_t until = std::min(
+                       size, ret.size() + budget.elements);
+                     const size_t start_bytes = in.bytes_consumed();
+                     while (ret.size() < until
+                            && in.bytes_consumed() - start_bytes
+                                 < budget.bytes) {
+                         auto f = async_adl<T>{}.from(in);
+                         if (!f.available()) {
+                             return f.then([&ret](T t) {
+                                 ret.push_back(std::move(t));
+                                 return ss::stop_iteration::no;
+                             });
+                         }
+                         ret.push_back(f.get0());
+                     }
+                     return ss::make_ready_future<ss::stop_iteration>(
+                       ss::stop_iteration(ret.size() == size));
+                 })
+            .then([&ret] { return std::move(ret); });
+      });
+}
+
 template<typename T>
 struct async_adl<std::vector<T>> {
     using value_type = std::remove_reference_t<std::decay_t<T>>;
 
     ss::future<> to(iobuf& out, std::vector<value_type> t) {
-        reflection::serialize<int32_t>(out, t.size());
-        return ss::do_with(std::move(t), [&out](auto& t) {
-            return ss::do_for_each(t, [&out](value_type& element) {
-                return async_adl<value_type>{}.to(out, std::move(element));
-            });
-        });
+        return async_serialize_vector(out, std::move(t), yield_budget{});
     }
 
     ss::future<std::vector<value_type>> from(iobuf_parser& in) {
-        const auto size = adl<int32_t>{}.from(in);
-        return ssx::async_transform(
-          boost::irange<size_t>(0, size),
-          [&in](size_t) { return async_adl<value_type>{}.from(in); });
+        return async_deserialize_vector<value_type>(in, yield_budget{});
     }
 };
 } // namespace reflection
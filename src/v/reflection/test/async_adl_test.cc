@@ -57,3 +57,27 @@ SEASTAR_THREAD_TEST_CASE(test_async_adl_collection) {
     const auto seconds_hash = std::hash<iobuf>{}(second_out);
     BOOST_REQUIRE_EQUAL(originals_hash, seconds_hash);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_async_adl_chunked_vector) {
+    std::vector<model::ntp> ntps;
+    for (int i = 0; i < 5000; ++i) {
+        ntps.emplace_back(make_random_ntp());
+    }
+    // chunks smaller than the vector, the layout is the one of adl
+    const auto expected = reflection::to_iobuf(ntps);
+    for (auto budget : {
+           reflection::yield_budget{.bytes = 1024, .elements = 4096},
+           reflection::yield_budget{.bytes = 1 << 20, .elements = 7},
+         }) {
+        iobuf out;
+        reflection::async_serialize_vector(out, ntps, budget).get();
+        BOOST_REQUIRE(out == expected);
+
+        iobuf_parser in(std::move(out));
+        auto result = reflection::async_deserialize_vector<model::ntp>(
+                        in, budget)
+                        .get0();
+        BOOST_REQUIRE_EQUAL(ntps, result);
+        BOOST_REQUIRE_EQUAL(in.bytes_left(), 0);
+    }
+}
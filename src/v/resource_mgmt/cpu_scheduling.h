@@ -16,6 +16,8 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/scheduling.hh>
 
+#include <vector>
+
 // manage cpu scheduling groups. scheduling groups are global, so one instance
 // of this class can be created at the top level and passed down into any server
 // and any shard that needs to schedule continuations into a given group.
@@ -30,8 +32,12 @@ public:
           .then([this](ss::scheduling_group sg) { _kafka = sg; })
           .then([] { return ss::create_scheduling_group("cluster", 300); })
           .then([this](ss::scheduling_group sg) { _cluster = sg; })
+          .then([] { return ss::create_scheduling_group("controller", 300); })
+          .then([this](ss::scheduling_group sg) { _controller = sg; })
           .then([] { return ss::create_scheduling_group("coproc", 100); })
-          .then([this](ss::scheduling_group sg) { _coproc = sg; });
+          .then([this](ss::scheduling_group sg) { _coproc = sg; })
+          .then([] { return ss::create_scheduling_group("compaction", 100); })
+          .then([this](ss::scheduling_group sg) { _compaction = sg; });
     }
 
     ss::future<> destroy_groups() {
@@ -39,19 +45,37 @@ public:
           .then([this] { return destroy_scheduling_group(_raft); })
           .then([this] { return destroy_scheduling_group(_kafka); })
           .then([this] { return destroy_scheduling_group(_cluster); })
-          .then([this] { return destroy_scheduling_group(_coproc); });
+          .then([this] { return destroy_scheduling_group(_controller); })
+          .then([this] { return destroy_scheduling_group(_coproc); })
+          .then([this] { return destroy_scheduling_group(_compaction); });
     }
 
     ss::scheduling_group admin_sg() { return _admin; }
     ss::scheduling_group raft_sg() { return _raft; }
     ss::scheduling_group kafka_sg() { return _kafka; }
     ss::scheduling_group cluster_sg() { return _cluster; }
+    ss::scheduling_group controller_sg() { return _controller; }
     ss::scheduling_group coproc_sg() { return _coproc; }
+    ss::scheduling_group compaction_sg() { return _compaction; }
+
+    std::vector<ss::scheduling_group> all() {
+        return {
+          ss::default_scheduling_group(),
+          _admin,
+          _raft,
+          _kafka,
+          _cluster,
+          _controller,
+          _coproc,
+          _compaction};
+    }
 
 private:
     ss::scheduling_group _admin;
     ss::scheduling_group _raft;
     ss::scheduling_group _kafka;
     ss::scheduling_group _cluster;
+    ss::scheduling_group _controller;
     ss::scheduling_group _coproc;
+    ss::scheduling_group _compaction;
 };
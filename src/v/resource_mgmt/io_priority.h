@@ -20,9 +20,16 @@
 class priority_manager {
 public:
     ss::io_priority_class raft_priority() { return _raft_priority; }
+    ss::io_priority_class raft_recovery_priority() {
+        return _raft_recovery_priority;
+    }
     ss::io_priority_class controller_priority() { return _controller_priority; }
     ss::io_priority_class kafka_read_priority() { return _kafka_read_priority; }
     ss::io_priority_class compaction_priority() { return _compaction_priority; }
+    ss::io_priority_class archival_priority() { return _archival_priority; }
+    ss::io_priority_class cache_warmup_priority() {
+        return _cache_warmup_priority;
+    }
 
     static priority_manager& local() {
         static thread_local priority_manager pm = priority_manager();
@@ -32,23 +39,36 @@ public:
 private:
     priority_manager()
       : _raft_priority(ss::engine().register_one_priority_class("raft", 1000))
+      , _raft_recovery_priority(
+          ss::engine().register_one_priority_class("raft_recovery", 200))
       , _controller_priority(
           ss::engine().register_one_priority_class("controller", 1000))
       , _kafka_read_priority(
           ss::engine().register_one_priority_class("kafka_read", 200))
       , _compaction_priority(
-          ss::engine().register_one_priority_class("compaction", 200)) {}
+          ss::engine().register_one_priority_class("compaction", 200))
+      , _archival_priority(
+          ss::engine().register_one_priority_class("archival", 100))
+      , _cache_warmup_priority(
+          ss::engine().register_one_priority_class("cache_warmup", 100)) {}
 
     ss::io_priority_class _raft_priority;
+    ss::io_priority_class _raft_recovery_priority;
     ss::io_priority_class _controller_priority;
     ss::io_priority_class _kafka_read_priority;
     ss::io_priority_class _compaction_priority;
+    ss::io_priority_class _archival_priority;
+    ss::io_priority_class _cache_warmup_priority;
 };
 
 inline ss::io_priority_class raft_priority() {
     return priority_manager::local().raft_priority();
 }
 
+inline ss::io_priority_class raft_recovery_priority() {
+    return priority_manager::local().raft_recovery_priority();
+}
+
 inline ss::io_priority_class controller_priority() {
     return priority_manager::local().controller_priority();
 }
@@ -60,3 +80,11 @@ inline ss::io_priority_class kafka_read_priority() {
 inline ss::io_priority_class compaction_priority() {
     return priority_manager::local().compaction_priority();
 }
+
+inline ss::io_priority_class archival_priority() {
+    return priority_manager::local().archival_priority();
+}
+
+inline ss::io_priority_class cache_warmup_priority() {
+    return priority_manager::local().cache_warmup_priority();
+}
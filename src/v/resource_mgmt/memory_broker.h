@@ -0,0 +1,284 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "prometheus/prometheus_sanitize.h"
+#include "seastarx.h"
+#include "vassert.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/core/timer.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Per shard broker of the memory held by the subsystems that buffer data:
+ * the rpc services, the appender chunks and the batch cache.
+ *
+ * A subsystem registers a pool with a priority and a share of the budget.
+ * The broker guarantees every pool its minimum and sets the capacity of each
+ * pool from what the pools use, every rebalance_interval:
+ *
+ *  - a pool starved for memory grows by half of its capacity, first from the
+ *    idle budget, then from the pools of lower priority above their minimum;
+ *  - the idle budget left is split between the pools by how far each may
+ *    still grow;
+ *  - when the pools use more than the budget, the capacity of the pools of
+ *    lowest priority is cut towards their minimum first.
+ *
+ * A capacity below what a pool uses is backpressure: a semaphore pool blocks
+ * new reservations until enough is released, a cache evicts down to it.
+ */
+class memory_broker {
+public:
+    static constexpr auto rebalance_interval = std::chrono::milliseconds(50);
+
+    /// Pools of lower value are served first and throttled last.
+    enum class priority : uint8_t {
+        rpc = 0,
+        kafka = 1,
+        appenders = 2,
+        cache = 3,
+    };
+
+    struct share {
+        size_t min_bytes{0};
+        size_t max_bytes{0};
+    };
+
+    /// Memory of a subsystem brokered with the others of the shard. The pool
+    /// is registered for its lifetime and starts with its minimum.
+    class pool {
+    public:
+        pool(ss::sstring name, priority p, share s)
+          : _name(std::move(name))
+          , _priority(p)
+          , _share(s)
+          , _capacity(s.min_bytes) {
+            vassert(
+              s.min_bytes <= s.max_bytes,
+              "memory pool {} minimum {} above its maximum {}",
+              _name,
+              s.min_bytes,
+              s.max_bytes);
+            memory_broker::local().add(this);
+        }
+        pool(const pool&) = delete;
+        pool& operator=(const pool&) = delete;
+        pool(pool&&) = delete;
+        pool& operator=(pool&&) = delete;
+        virtual ~pool() noexcept { memory_broker::local().remove(this); }
+
+        /// bytes held by the subsystem
+        virtual size_t used() const = 0;
+        /// the subsystem waits for memory
+        virtual bool starved() const = 0;
+
+        const ss::sstring& name() const { return _name; }
+        priority prio() const { return _priority; }
+        const share& get_share() const { return _share; }
+        size_t capacity() const { return _capacity; }
+        /// times the capacity was set below what the pool used
+        uint64_t throttles() const { return _throttles; }
+
+        void setup_metrics() {
+            namespace sm = ss::metrics;
+            auto pool_label = sm::label("pool");
+            const std::vector<sm::label_instance> labels = {
+              pool_label(_name)};
+            _metrics.add_group(
+              prometheus_sanitize::metrics_name("memory_broker"),
+              {
+                sm::make_gauge(
+                  "used_bytes",
+                  [this] { return used(); },
+                  sm::description("Bytes held by the pool"),
+                  labels),
+                sm::make_gauge(
+                  "capacity_bytes",
+                  [this] { return _capacity; },
+                  sm::description("Bytes the pool may hold"),
+                  labels),
+                sm::make_gauge(
+                  "min_bytes",
+                  [this] { return _share.min_bytes; },
+                  sm::description("Bytes guaranteed to the pool"),
+                  labels),
+                sm::make_derive(
+                  "throttles",
+                  [this] { return _throttles; },
+                  sm::description("Number of times the capacity of the "
+                                  "pool was cut below its use"),
+                  labels),
+              });
+        }
+
+    protected:
+        /// \brief the broker changed the capacity of the pool
+        virtual void on_capacity(size_t prev, size_t next) = 0;
+
+    private:
+        friend memory_broker;
+
+        void set_capacity(size_t next) {
+            if (next == _capacity) {
+                return;
+            }
+            if (next < used()) {
+                ++_throttles;
+            }
+            const auto prev = std::exchange(_capacity, next);
+            on_capacity(prev, next);
+        }
+
+        ss::sstring _name;
+        priority _priority;
+        share _share;
+        size_t _capacity;
+        uint64_t _throttles{0};
+        ss::metrics::metric_groups _metrics;
+    };
+
+    /// A pool of the units of a semaphore, e.g. the memory of an rpc server.
+    /// The semaphore is expected to start with the minimum of the share.
+    class semaphore_pool final : public pool {
+    public:
+        semaphore_pool(ss::sstring name, priority p, share s, ss::semaphore& m)
+          : pool(std::move(name), p, s)
+          , _sem(m) {}
+
+        size_t used() const final {
+            const auto available = _sem.current();
+            return available >= capacity() ? 0 : capacity() - available;
+        }
+        bool starved() const final { return _sem.waiters() > 0; }
+
+    private:
+        void on_capacity(size_t prev, size_t next) final {
+            if (next > prev) {
+                _sem.signal(next - prev);
+            } else {
+                // units in use are returned to the broker as they are freed
+                _sem.consume(prev - next);
+            }
+        }
+
+        ss::semaphore& _sem;
+    };
+
+    static memory_broker& local() {
+        static thread_local memory_broker broker;
+        return broker;
+    }
+
+    /// \brief memory the pools of the shard share
+    void set_budget(size_t bytes) { _budget = bytes; }
+    size_t budget() const { return _budget; }
+
+    const std::vector<pool*>& pools() const { return _pools; }
+
+    void rebalance() {
+        const size_t n = _pools.size();
+        std::vector<size_t> caps(n);
+        size_t total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const auto& s = _pools[i]->get_share();
+            caps[i] = std::clamp(_pools[i]->used(), s.min_bytes, s.max_bytes);
+            total += caps[i];
+        }
+        if (total > _budget) {
+            // pools are in priority order, the last ones give back first
+            size_t excess = total - _budget;
+            for (size_t i = n; i-- > 0 && excess > 0;) {
+                const auto cut = std::min(
+                  excess, caps[i] - _pools[i]->get_share().min_bytes);
+                caps[i] -= cut;
+                excess -= cut;
+            }
+            total = _budget + excess;
+        }
+        size_t idle = _budget > total ? _budget - total : 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!_pools[i]->starved()) {
+                continue;
+            }
+            const auto max = _pools[i]->get_share().max_bytes;
+            size_t want = std::min(
+              max - caps[i], std::max<size_t>(caps[i] / 2, 1));
+            const auto from_idle = std::min(want, idle);
+            caps[i] += from_idle;
+            idle -= from_idle;
+            want -= from_idle;
+            for (size_t j = n; j-- > i + 1 && want > 0;) {
+                if (_pools[j]->prio() == _pools[i]->prio()) {
+                    break;
+                }
+                const auto min = _pools[j]->get_share().min_bytes;
+                const auto take = std::min(want, caps[j] - min);
+                caps[j] -= take;
+                caps[i] += take;
+                want -= take;
+            }
+        }
+        // headroom, so that pools do not wait for the next rebalance
+        size_t room = 0;
+        for (size_t i = 0; i < n; ++i) {
+            room += _pools[i]->get_share().max_bytes - caps[i];
+        }
+        if (room > 0 && idle > 0) {
+            const double ratio = std::min(1.0, double(idle) / room);
+            for (size_t i = 0; i < n; ++i) {
+                const auto max = _pools[i]->get_share().max_bytes;
+                caps[i] += static_cast<size_t>((max - caps[i]) * ratio);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            _pools[i]->set_capacity(caps[i]);
+        }
+    }
+
+private:
+    memory_broker() noexcept {
+        _timer.set_callback([this] { rebalance(); });
+    }
+
+    void add(pool* p) {
+        auto it = std::upper_bound(
+          _pools.begin(), _pools.end(), p, [](const pool* a, const pool* b) {
+              return a->prio() < b->prio();
+          });
+        _pools.insert(it, p);
+        if (!_timer.armed()) {
+            _timer.arm_periodic(rebalance_interval);
+        }
+    }
+    void remove(pool* p) {
+        _pools.erase(std::find(_pools.begin(), _pools.end(), p));
+        // the timer is disarmed before the shard exits with its services
+        if (_pools.empty()) {
+            _timer.cancel();
+        }
+    }
+
+    size_t _budget{0};
+    // in priority order
+    std::vector<pool*> _pools;
+    ss::timer<ss::lowres_clock> _timer;
+};
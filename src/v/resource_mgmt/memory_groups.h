@@ -46,4 +46,60 @@ struct memory_groups {
     static size_t chunk_cache_max_memory() {
         return ss::memory::stats().total_memory() * .30; // NOLINT
     }
+
+    /**
+     * Shared budget for the adaptive read-ahead of sequential segment readers.
+     * Only read-ahead beyond the default window of a stream is charged.
+     */
+    static size_t storage_read_ahead_memory() {
+        return ss::memory::stats().total_memory() * .05; // NOLINT
+    }
+
+    /**
+     * Memory the brokered pools of a shard share, see memory_broker. Each
+     * pool is guaranteed its minimum below and borrows up to its maximum.
+     */
+    static size_t brokered_memory() {
+        return ss::memory::stats().total_memory() * .80; // NOLINT
+    }
+    static size_t rpc_min_memory() {
+        return ss::memory::stats().total_memory() * .10; // NOLINT
+    }
+    static size_t rpc_max_memory() {
+        return ss::memory::stats().total_memory() * .40; // NOLINT
+    }
+    static size_t kafka_min_memory() {
+        return ss::memory::stats().total_memory() * .10; // NOLINT
+    }
+    static size_t kafka_max_memory() {
+        return ss::memory::stats().total_memory() * .40; // NOLINT
+    }
+    static size_t batch_cache_max_memory() {
+        return ss::memory::stats().total_memory() * .60; // NOLINT
+    }
+
+    /**
+     * Floor of the adaptive size target of the batch cache. Above it the
+     * cache follows the free memory of the shard, up to all of it.
+     */
+    static size_t batch_cache_min_memory() {
+        return ss::memory::stats().total_memory() * .02; // NOLINT
+    }
+
+    /**
+     * Budget for the entries of sealed segment indices. The least recently
+     * used indices are evicted, and reloaded from disk on access.
+     */
+    static size_t storage_index_memory() {
+        return ss::memory::stats().total_memory() * .02; // NOLINT
+    }
+
+    /**
+     * Huge pages allocated at startup for the chunk cache and the batch
+     * cache when enabled, the floors of the two pools. It is carved out of
+     * their memory rather than added to it.
+     */
+    static size_t storage_hugepage_memory() {
+        return chunk_cache_min_memory() + batch_cache_min_memory();
+    }
 };
@@ -14,56 +14,110 @@
 #include "seastarx.h"
 
 #include <seastar/core/reactor.hh>
+#include <seastar/core/sstring.hh>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
 
 // manage SMP scheduling groups. These scheduling groups are global, so one
 // instance of this class can be created at the top level and passed down into
 // any server and any shard that needs to schedule continuations into a given
 // group.
+//
+// Every workload gets a group of its own: a group holds at most
+// max_nonlocal_requests calls from one shard to another in flight, a flood of
+// fetch hops waits on the units of the fetch group and leaves those of
+// produce alone.
 class smp_groups {
 public:
-    smp_groups() = default;
-    ss::future<> create_groups() {
-        ss::smp_service_group_config smp_sg_config;
-        smp_sg_config.max_nonlocal_requests = 5000;
+    static constexpr uint32_t default_max_nonlocal_requests = 5000;
 
-        return create_smp_service_group(smp_sg_config)
-          .then([this](ss::smp_service_group sg) {
-              _raft = std::make_unique<ss::smp_service_group>(sg);
+    // max_nonlocal_requests of the groups sized by the configuration
+    struct config {
+        uint32_t produce_max_nonlocal_requests = default_max_nonlocal_requests;
+        uint32_t fetch_max_nonlocal_requests = default_max_nonlocal_requests;
+        uint32_t group_max_nonlocal_requests = default_max_nonlocal_requests;
+        uint32_t admin_max_nonlocal_requests = default_max_nonlocal_requests;
+    };
+
+    smp_groups() = default;
+    ss::future<> create_groups(config cfg) {
+        return create_group(_raft, default_max_nonlocal_requests)
+          .then([this] {
+              return create_group(_kafka, default_max_nonlocal_requests);
           })
-          .then([smp_sg_config] {
-              return ss::create_smp_service_group(smp_sg_config);
+          .then([this] {
+              return create_group(_cluster, default_max_nonlocal_requests);
           })
-          .then([this](ss::smp_service_group sg) {
-              _kafka = std::make_unique<ss::smp_service_group>(sg);
+          .then([this] {
+              return create_group(_coproc, default_max_nonlocal_requests);
           })
-          .then([smp_sg_config] {
-              return ss::create_smp_service_group(smp_sg_config);
+          .then([this, cfg] {
+              return create_group(_produce, cfg.produce_max_nonlocal_requests);
           })
-          .then([this](ss::smp_service_group sg) {
-              _cluster = std::make_unique<ss::smp_service_group>(sg);
+          .then([this, cfg] {
+              return create_group(_fetch, cfg.fetch_max_nonlocal_requests);
           })
-          .then([smp_sg_config] {
-              return ss::create_smp_service_group(smp_sg_config);
+          .then([this, cfg] {
+              return create_group(_group, cfg.group_max_nonlocal_requests);
           })
-          .then([this](ss::smp_service_group sg) {
-              _coproc = std::make_unique<ss::smp_service_group>(sg);
+          .then([this, cfg] {
+              return create_group(_admin, cfg.admin_max_nonlocal_requests);
           });
     }
     ss::smp_service_group raft_smp_sg() { return *_raft; }
     ss::smp_service_group kafka_smp_sg() { return *_kafka; }
     ss::smp_service_group cluster_smp_sg() { return *_cluster; }
     ss::smp_service_group coproc_smp_sg() { return *_coproc; }
+    ss::smp_service_group produce_smp_sg() { return *_produce; }
+    ss::smp_service_group fetch_smp_sg() { return *_fetch; }
+    // group coordinator
+    ss::smp_service_group group_smp_sg() { return *_group; }
+    ss::smp_service_group admin_smp_sg() { return *_admin; }
+
+    std::vector<std::pair<ss::sstring, ss::smp_service_group>> all() {
+        return {
+          {"raft", *_raft},
+          {"kafka", *_kafka},
+          {"cluster", *_cluster},
+          {"coproc", *_coproc},
+          {"produce", *_produce},
+          {"fetch", *_fetch},
+          {"group", *_group},
+          {"admin", *_admin}};
+    }
 
     ss::future<> destroy_groups() {
         return destroy_smp_service_group(*_kafka)
           .then([this] { return destroy_smp_service_group(*_raft); })
           .then([this] { return destroy_smp_service_group(*_cluster); })
-          .then([this] { return destroy_smp_service_group(*_coproc); });
+          .then([this] { return destroy_smp_service_group(*_coproc); })
+          .then([this] { return destroy_smp_service_group(*_produce); })
+          .then([this] { return destroy_smp_service_group(*_fetch); })
+          .then([this] { return destroy_smp_service_group(*_group); })
+          .then([this] { return destroy_smp_service_group(*_admin); });
     }
 
 private:
+    static ss::future<> create_group(
+      std::unique_ptr<ss::smp_service_group>& g,
+      uint32_t max_nonlocal_requests) {
+        ss::smp_service_group_config smp_sg_config;
+        smp_sg_config.max_nonlocal_requests = max_nonlocal_requests;
+        return ss::create_smp_service_group(smp_sg_config)
+          .then([&g](ss::smp_service_group sg) {
+              g = std::make_unique<ss::smp_service_group>(sg);
+          });
+    }
+
     std::unique_ptr<ss::smp_service_group> _raft;
     std::unique_ptr<ss::smp_service_group> _kafka;
     std::unique_ptr<ss::smp_service_group> _cluster;
     std::unique_ptr<ss::smp_service_group> _coproc;
+    std::unique_ptr<ss::smp_service_group> _produce;
+    std::unique_ptr<ss::smp_service_group> _fetch;
+    std::unique_ptr<ss::smp_service_group> _group;
+    std::unique_ptr<ss::smp_service_group> _admin;
 };
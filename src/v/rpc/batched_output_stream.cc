@@ -11,17 +11,27 @@
 
 #include "likely.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/scattered_message.hh>
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
 namespace rpc {
 batched_output_stream::batched_output_stream(
-  ss::output_stream<char> o, size_t cache)
+  ss::output_stream<char> o,
+  size_t cache,
+  coalesce_flushes coalesce,
+  pack_fragments pack,
+  flush_observer observer)
   : _out(std::move(o))
   , _cache_size(cache)
-  , _write_sem(std::make_unique<ss::semaphore>(1)) {}
+  , _write_sem(std::make_unique<ss::semaphore>(1))
+  , _coalesce(coalesce)
+  , _pack(pack)
+  , _observer(std::move(observer)) {}
 
 [[gnu::cold]] static ss::future<>
 already_closed_error(ss::scattered_message<char>& msg) {
@@ -34,40 +44,132 @@ ss::future<> batched_output_stream::write(ss::scattered_message<char> msg) {
     if (unlikely(_closed)) {
         return already_closed_error(msg);
     }
-    return ss::with_semaphore(
+    auto f = ss::with_semaphore(
       *_write_sem, 1, [this, v = std::move(msg)]() mutable {
           if (unlikely(_closed)) {
               return already_closed_error(v);
           }
           const size_t vbytes = v.size();
-          return _out.write(std::move(v)).then([this, vbytes] {
+          auto f = _pack ? _out.write(pack_small_fragments(std::move(v)))
+                         : _out.write(std::move(v));
+          return f.then([this, vbytes] {
               _unflushed_bytes += vbytes;
-              if (
-                _write_sem->waiters() == 0 || _unflushed_bytes >= _cache_size) {
-                  return do_flush();
+              if (_unflushed_bytes >= _cache_size) {
+                  return do_flush(flush_reason::size);
+              }
+              if (!_coalesce && _write_sem->waiters() == 0) {
+                  return do_flush(flush_reason::idle);
               }
               return ss::make_ready_future<>();
           });
       });
+    if (!_coalesce) {
+        return f;
+    }
+    return f.then([this] { return coalesced_flush(); });
+}
+ss::net::packet
+batched_output_stream::pack_small_fragments(ss::scattered_message<char> msg) {
+    auto p = std::move(msg).release();
+    if (p.nr_frags() <= 1) {
+        return p;
+    }
+    ss::scattered_message<char> ret;
+    ss::temporary_buffer<char> pack;
+    size_t packed = 0;
+    auto append_pack = [&ret, &pack, &packed] {
+        if (packed > 0) {
+            pack.trim(packed);
+            ret.append(std::move(pack));
+            packed = 0;
+        }
+    };
+    for (const auto& f : p.fragments()) {
+        if (f.size >= max_packed_fragment) {
+            append_pack();
+            ret.append_static(f.base, f.size);
+            continue;
+        }
+        for (size_t offset = 0; offset < f.size;) {
+            if (packed == pack.size()) {
+                append_pack();
+                pack = ss::temporary_buffer<char>(tls_record_size);
+            }
+            const size_t n = std::min(f.size - offset, pack.size() - packed);
+            // NOLINTNEXTLINE
+            std::copy_n(f.base + offset, n, pack.get_write() + packed);
+            packed += n;
+            offset += n;
+        }
+    }
+    append_pack();
+    // the fragments written as they are still point into the message
+    ret.on_delete([p = std::move(p)] {});
+    return std::move(ret).release();
 }
-ss::future<> batched_output_stream::do_flush() {
+
+ss::future<> batched_output_stream::coalesced_flush() {
     if (_unflushed_bytes == 0) {
         return ss::make_ready_future<>();
     }
+    if (_pending_flush) {
+        // corked, the round is flushed at its end
+        return _pending_flush->get_shared_future();
+    }
+    // opens the round, whatever is written in it from now on is flushed at
+    // its end. background, stop() waits for the pending flush
+    _pending_flush = std::make_unique<ss::shared_promise<>>();
+    (void)ss::later().then([this] {
+        // bytes written from now on are covered by the next round
+        auto p = std::move(_pending_flush);
+        return flush(flush_reason::coalesced)
+          .then_wrapped([p = std::move(p)](ss::future<> f) mutable {
+              if (f.failed()) {
+                  p->set_exception(f.get_exception());
+              } else {
+                  p->set_value();
+              }
+          });
+    });
+    if (_write_sem->waiters() > 0) {
+        // the queued writes go out with this one
+        return _pending_flush->get_shared_future();
+    }
+    // the stream was idle, waiting for the round only adds latency
+    return flush(flush_reason::idle);
+}
+ss::future<> batched_output_stream::do_flush(flush_reason r) {
+    if (_unflushed_bytes == 0) {
+        return ss::make_ready_future<>();
+    }
+    if (_observer) {
+        _observer(r, _unflushed_bytes);
+    }
     _unflushed_bytes = 0;
     return _out.flush();
 }
+ss::future<> batched_output_stream::flush(flush_reason r) {
+    return ss::with_semaphore(
+      *_write_sem, 1, [this, r] { return do_flush(r); });
+}
 ss::future<> batched_output_stream::flush() {
-    return ss::with_semaphore(*_write_sem, 1, [this] { return do_flush(); });
+    return flush(flush_reason::requested);
 }
 ss::future<> batched_output_stream::stop() {
     if (_closed) {
         return ss::make_ready_future<>();
     }
     _closed = true;
-    return ss::with_semaphore(*_write_sem, 1, [this] {
-        return do_flush().then([this] { return _out.close(); });
-    });
+    auto f = _pending_flush ? _pending_flush->get_shared_future()
+                            : ss::make_ready_future<>();
+    return f.handle_exception([](const std::exception_ptr&) {})
+      .then([this] {
+          return ss::with_semaphore(*_write_sem, 1, [this] {
+              return do_flush(flush_reason::requested).then([this] {
+                  return _out.close();
+              });
+          });
+      });
 }
 
 } // namespace rpc
@@ -14,20 +14,64 @@
 #include "seastarx.h"
 
 #include <seastar/core/iostream.hh>
+#include <seastar/core/scattered_message.hh>
 #include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/util/bool_class.hh>
+#include <seastar/util/noncopyable_function.hh>
 
 #include <cstdint>
+#include <memory>
 
 namespace rpc {
 
+using coalesce_flushes = ss::bool_class<struct coalesce_flushes_tag>;
+using pack_fragments = ss::bool_class<struct pack_fragments_tag>;
+
+/// why the bytes written to a batched_output_stream were flushed
+enum class flush_reason : uint8_t {
+    // the unflushed bytes reached the cache size
+    size = 0,
+    // nothing else was being written
+    idle,
+    // end of the reactor round, covering the writes corked in it
+    coalesced,
+    // flush() or stop()
+    requested,
+};
+inline constexpr size_t flush_reasons = 4;
+
 /// \brief batch operations for zero copy interface of an output_stream<char>
+///
+/// With coalesce_flushes::yes the writes are corked adaptively. A write to
+/// an idle stream, with no flush of the round pending and no other write
+/// queued, is flushed at once. The writes that follow it in the same reactor
+/// round are corked and go out with a single flush at the end of the round,
+/// e.g. the replies of requests that arrived back to back. The write future
+/// resolves once its bytes are flushed. The stream must not be moved once it
+/// has been written to.
+///
+/// With pack_fragments::yes the small fragments of a message are copied
+/// into buffers of a TLS record before they are written, see
+/// pack_small_fragments().
 class batched_output_stream {
 public:
+    /// called with the reason and the bytes of every flush
+    using flush_observer = ss::noncopyable_function<void(flush_reason, size_t)>;
+
     static constexpr size_t default_max_unflushed_bytes = 1024 * 1024;
+    /// largest plaintext of a TLS record
+    static constexpr size_t tls_record_size = 16 * 1024;
+    /// fragments from this size on are written as they are
+    static constexpr size_t max_packed_fragment = tls_record_size / 4;
 
     batched_output_stream() = default;
     explicit batched_output_stream(
-      ss::output_stream<char>, size_t cache = default_max_unflushed_bytes);
+      ss::output_stream<char>,
+      size_t cache = default_max_unflushed_bytes,
+      coalesce_flushes = coalesce_flushes::no,
+      pack_fragments = pack_fragments::no,
+      flush_observer = nullptr);
     ~batched_output_stream() noexcept = default;
     // NOTE: explicitly defined for a gcc
     batched_output_stream(batched_output_stream&& o) noexcept
@@ -35,7 +79,11 @@ public:
       , _cache_size(o._cache_size)
       , _write_sem(std::move(o._write_sem))
       , _unflushed_bytes(o._unflushed_bytes)
-      , _closed(o._closed) {}
+      , _closed(o._closed)
+      , _coalesce(o._coalesce)
+      , _pack(o._pack)
+      , _pending_flush(std::move(o._pending_flush))
+      , _observer(std::move(o._observer)) {}
     batched_output_stream& operator=(batched_output_stream&& o) noexcept {
         if (this != &o) {
             this->~batched_output_stream();
@@ -53,13 +101,30 @@ public:
     /// do not use `_fd.shutdown_output();` on connected_sockets
     ss::future<> stop();
 
+    /// \brief copies runs of fragments smaller than max_packed_fragment
+    /// into buffers of tls_record_size
+    ///
+    /// A TLS stream encrypts every fragment of a message into a record of
+    /// its own, each with its header, tag and write to the socket. Encoded
+    /// responses are made of many small fragments, packed they go out in
+    /// full records instead. Larger fragments, e.g. record batches, are
+    /// not copied.
+    static ss::net::packet pack_small_fragments(ss::scattered_message<char>);
+
 private:
-    ss::future<> do_flush();
+    ss::future<> flush(flush_reason);
+    ss::future<> do_flush(flush_reason);
+    ss::future<> coalesced_flush();
 
     ss::output_stream<char> _out;
     size_t _cache_size{0};
     std::unique_ptr<ss::semaphore> _write_sem;
     size_t _unflushed_bytes{0};
     bool _closed = false;
+    coalesce_flushes _coalesce{coalesce_flushes::no};
+    pack_fragments _pack{pack_fragments::no};
+    // resolved by the deferred flush covering the writes of this round
+    std::unique_ptr<ss::shared_promise<>> _pending_flush;
+    flush_observer _observer;
 };
 } // namespace rpc
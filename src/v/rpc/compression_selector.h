@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "rpc/types.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace rpc {
+
+/// Picks codec and level for the messages sent over a single connection.
+///
+/// Compressing a message pays off when the time it saves on the wire is
+/// longer than the cpu time spent compressing it. The selector keeps moving
+/// averages of the cost per byte and ratio of every candidate, measured on the
+/// messages sent over the connection, and of the transfer time per byte of
+/// the connection, measured from the round trips of large requests. Every
+/// message is sent with the candidate of the lowest expected cost, every
+/// exploration_interval-th message tries another candidate so the estimates
+/// follow the changes of traffic and network.
+class compression_selector {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    struct choice {
+        compression_type type;
+        int level;
+
+        bool operator==(const choice& o) const {
+            return type == o.type && level == o.level;
+        }
+    };
+
+    static constexpr std::array<choice, 4> candidates{{
+      {compression_type::none, 0},
+      {compression_type::lz4, 1},
+      {compression_type::zstd, 1},
+      {compression_type::zstd, 3},
+    }};
+
+    static constexpr size_t exploration_interval = 64;
+    // round trips of smaller requests are dominated by latency
+    static constexpr size_t min_transfer_sample_bytes = 16 * 1024;
+    static constexpr size_t transfer_window = 16;
+
+    compression_selector() noexcept;
+
+    /// Returns codec for a payload of given size
+    choice select(size_t payload_size, size_t min_compression_bytes);
+
+    /// Records cost and ratio of compression with a codec
+    void record_compression(
+      choice,
+      size_t payload_size,
+      size_t compressed_size,
+      clock_type::duration);
+
+    /// Records round trip of a request with given size on the wire. Server
+    /// side processing is included, so the minimum of a window of samples is
+    /// taken as the transfer cost
+    void record_round_trip(size_t wire_size, clock_type::duration);
+
+    /// Expected cost in nanoseconds of sending one payload byte with the
+    /// candidate
+    double expected_cost(const choice&) const;
+
+    double transfer_ns_per_byte() const { return _transfer_ns_per_byte; }
+
+private:
+    struct estimate {
+        double ns_per_byte;
+        double ratio;
+    };
+
+    std::optional<size_t> index_of(const choice&) const;
+
+    std::array<estimate, candidates.size()> _estimates;
+    double _transfer_ns_per_byte;
+    double _window_min_ns_per_byte{0};
+    size_t _window_samples{0};
+    size_t _messages{0};
+    size_t _next_exploration{0};
+};
+
+} // namespace rpc
@@ -16,12 +16,19 @@ connection::connection(
   boost::intrusive::list<connection>& hook,
   ss::connected_socket f,
   ss::socket_address a,
-  server_probe& p)
+  server_probe& p,
+  pack_fragments pack)
   : addr(std::move(a))
   , _hook(hook)
   , _fd(std::move(f))
   , _in(_fd.input())
-  , _out(_fd.output())
+  // replies of requests arriving back to back go out with a single flush
+  , _out(
+      _fd.output(),
+      batched_output_stream::default_max_unflushed_bytes,
+      coalesce_flushes::yes,
+      pack,
+      [&p](flush_reason r, size_t bytes) { p.flushed(r, bytes); })
   , _probe(p) {
     _hook.push_back(*this);
     _probe.connection_established();
@@ -29,7 +29,8 @@ public:
       boost::intrusive::list<connection>& hook,
       ss::connected_socket f,
       ss::socket_address a,
-      server_probe& p);
+      server_probe& p,
+      pack_fragments = pack_fragments::no);
     ~connection() noexcept;
     connection(const connection&) = delete;
     connection& operator=(const connection&) = delete;
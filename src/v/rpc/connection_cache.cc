@@ -9,7 +9,12 @@
 
 #include "rpc/connection_cache.h"
 
+#include "prometheus/prometheus_sanitize.h"
 #include "rpc/backoff_policy.h"
+#include "rpc/logger.h"
+
+#include <seastar/core/metrics.hh>
+#include <seastar/core/sleep.hh>
 
 #include <fmt/format.h>
 
@@ -17,6 +22,42 @@
 
 namespace rpc {
 
+connection_cache::connection_cache(
+  size_t connections_per_peer, metrics_disabled disable_metrics)
+  : _connections_per_peer(connections_per_peer) {
+    if (!disable_metrics) {
+        setup_metrics();
+    }
+}
+
+void connection_cache::setup_metrics() {
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("rpc_client:connection_cache"),
+      {sm::make_gauge(
+         "connections_per_peer",
+         [this] { return _connections_per_peer; },
+         sm::description("Number of shards owning a connection to each peer")),
+       sm::make_derive(
+         "local_requests",
+         [this] { return _local_requests; },
+         sm::description(
+           "Requests sent over a connection owned by the calling shard")),
+       sm::make_derive(
+         "forwarded_requests",
+         [this] { return _forwarded_requests; },
+         sm::description(
+           "Requests forwarded to the shard owning the connection")),
+       sm::make_gauge(
+         "peers_down",
+         [this] {
+             return std::count_if(_cache.begin(), _cache.end(), [](auto& p) {
+                 return p.second->is_peer_down();
+             });
+         },
+         sm::description("Number of peers known to be down"))});
+}
+
 /// \brief needs to be a future, because mutations may come from different
 /// fibers and they need to be synchronized
 ss::future<> connection_cache::emplace(
@@ -33,10 +74,85 @@ ss::future<> connection_cache::emplace(
           if (_cache.find(n) != _cache.end()) {
               return;
           }
-          _cache.emplace(
-            n,
-            ss::make_lw_shared<rpc::reconnect_transport>(
-              std::move(c), std::move(backoff_policy)));
+          auto t = ss::make_lw_shared<rpc::reconnect_transport>(
+            std::move(c), std::move(backoff_policy));
+          t->set_failure_observer([this, n] { report_failure(n); });
+          _cache.emplace(n, std::move(t));
+      });
+}
+
+void connection_cache::report_failure(model::node_id n) {
+    if (_gate.is_closed()) {
+        return;
+    }
+    (void)ss::with_gate(_gate, [this, n] {
+        return container().invoke_on(
+          liveness_shard(n),
+          [n](connection_cache& cache) { cache.on_peer_down(n); });
+    });
+}
+
+void connection_cache::on_peer_down(model::node_id n) {
+    if (_gate.is_closed() || !contains(n)) {
+        return;
+    }
+    auto t = get(n);
+    if (t->is_peer_down()) {
+        // already probing
+        return;
+    }
+    rpclog.info("peer {} at {} is down", n, t->server_address());
+    // the local transport first, so that a repeated report is ignored
+    t->set_peer_down(true);
+    (void)ss::with_gate(_gate, [this, n, t] {
+        return mark_peer(n, true).then(
+          [this, n, t] { return probe_peer(n, t); });
+    });
+}
+
+ss::future<> connection_cache::mark_peer(model::node_id n, bool down) {
+    // sent from the liveness shard only, the updates of a peer are received
+    // in order by every shard
+    return container().invoke_on_all([n, down](connection_cache& cache) {
+        if (cache.contains(n)) {
+            cache.get(n)->set_peer_down(down);
+        }
+    });
+}
+
+std::chrono::milliseconds
+connection_cache::probe_delay(const transport_ptr& t) {
+    const auto backoff = std::max(t->backoff_duration(), min_probe_backoff);
+    // between half and the whole backoff, so that the peers probing the
+    // same node do not synchronize
+    const auto half = backoff.count() / 2;
+    return std::chrono::milliseconds(half + _rand() % (half + 1));
+}
+
+ss::future<> connection_cache::probe_peer(model::node_id n, transport_ptr t) {
+    return ss::repeat([this, n, t] {
+               return ss::sleep_abortable(probe_delay(t), _as)
+                 .then([this, n, t] {
+                     if (!contains(n) || get(n) != t) {
+                         // removed, stop probing
+                         return ss::make_ready_future<ss::stop_iteration>(
+                           ss::stop_iteration::yes);
+                     }
+                     return ss::futurize_invoke([t] { return t->probe(); })
+                       .then([this, n](result<transport*> r) {
+                           if (!r) {
+                               return ss::make_ready_future<
+                                 ss::stop_iteration>(ss::stop_iteration::no);
+                           }
+                           rpclog.info("peer {} is up", n);
+                           return mark_peer(n, false).then(
+                             [] { return ss::stop_iteration::yes; });
+                       });
+                 });
+           })
+      .handle_exception_type([](const ss::sleep_aborted&) {})
+      .handle_exception([n](std::exception_ptr e) {
+          rpclog.debug("stopped probing peer {}: {}", n, e);
       });
 }
 ss::future<> connection_cache::remove(model::node_id n) {
@@ -62,9 +178,12 @@ ss::future<> connection_cache::remove(model::node_id n) {
 
 /// \brief closes all client connections
 ss::future<> connection_cache::stop() {
-    return parallel_for_each(_cache, [](auto& it) {
-        auto& [_, cli] = it;
-        return cli->stop();
+    _as.request_abort();
+    return _gate.close().then([this] {
+        return parallel_for_each(_cache, [](auto& it) {
+            auto& [_, cli] = it;
+            return cli->stop();
+        });
     });
 }
 
@@ -14,15 +14,20 @@
 #include "model/metadata.h"
 #include "outcome.h"
 #include "outcome_future_utils.h"
+#include "random/fast_prng.h"
 #include "rpc/backoff_policy.h"
 #include "rpc/connection.h"
 #include "rpc/errc.h"
 #include "rpc/reconnect_transport.h"
 #include "rpc/types.h"
 
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/shared_ptr.hh>
 
+#include <algorithm>
 #include <chrono>
 #include <unordered_map>
 
@@ -34,13 +39,36 @@ public:
     using underlying = std::unordered_map<model::node_id, transport_ptr>;
     using iterator = typename underlying::iterator;
 
+    /// number of shards owning a connection to every peer, requests sent
+    /// from other shards are forwarded to one of the owners
+    static constexpr size_t default_connections_per_peer = 3;
+
+    /// shortest wait before probing a peer found down
+    static constexpr std::chrono::milliseconds min_probe_backoff{100};
+
+    /// \brief shard tracking the liveness of `node`. It learns about the
+    /// connection failures of every shard, probes the peer while it is down
+    /// and tells the other shards when the peer is back
+    static ss::shard_id liveness_shard(model::node_id node) {
+        return node() % ss::smp::count;
+    }
+
+    /// \brief shard owning the connection to `node` used by `src` shard.
+    /// When there are at least as many connections as shards every shard
+    /// owns its own connection and requests are never forwarded
     static inline ss::shard_id shard_for(
       model::node_id self,
       ss::shard_id src,
       model::node_id node,
-      ss::shard_id max_shards = ss::smp::count);
+      ss::shard_id max_shards = ss::smp::count,
+      size_t connections_per_peer = default_connections_per_peer);
+
+    explicit connection_cache(
+      size_t connections_per_peer = default_connections_per_peer,
+      metrics_disabled disable_metrics = metrics_disabled::no);
+
+    size_t connections_per_peer() const { return _connections_per_peer; }
 
-    connection_cache() = default;
     bool contains(model::node_id n) const {
         return _cache.find(n) != _cache.end();
     }
@@ -69,7 +97,13 @@ public:
         model::node_id node_id,
         Func&& f) {
         using ret_t = result_wrap_t<std::invoke_result_t<Func, Protocol>>;
-        auto shard = rpc::connection_cache::shard_for(self, src_shard, node_id);
+        auto shard = rpc::connection_cache::shard_for(
+          self, src_shard, node_id, ss::smp::count, _connections_per_peer);
+        if (shard == ss::this_shard_id()) {
+            ++_local_requests;
+        } else {
+            ++_forwarded_requests;
+        }
 
         return container().invoke_on(
           shard,
@@ -94,21 +128,45 @@ public:
     }
 
 private:
+    void setup_metrics();
+
+    void report_failure(model::node_id);
+    void on_peer_down(model::node_id);
+    ss::future<> mark_peer(model::node_id, bool down);
+    ss::future<> probe_peer(model::node_id, transport_ptr);
+    std::chrono::milliseconds probe_delay(const transport_ptr&);
+
     ss::semaphore _sem{1}; // to add/remove nodes
+    ss::gate _gate;
+    ss::abort_source _as;
+    fast_prng _rand;
     underlying _cache;
+    size_t _connections_per_peer;
+    uint64_t _local_requests{0};
+    uint64_t _forwarded_requests{0};
+    ss::metrics::metric_groups _metrics;
 };
 inline ss::shard_id connection_cache::shard_for(
   model::node_id self,
   ss::shard_id src_shard,
   model::node_id n,
-  ss::shard_id total_shards) {
-    static const constexpr size_t vnodes = 3;
+  ss::shard_id total_shards,
+  size_t connections_per_peer) {
+    if (connections_per_peer >= total_shards) {
+        return src_shard;
+    }
+    static const constexpr size_t primes = 3;
     /// make deterministic - choose 1 prime to mix node_id with
     /// https://planetmath.org/goodhashtableprimes
-    static const constexpr std::array<size_t, vnodes> universe{
+    static const constexpr std::array<size_t, primes> universe{
       {402653189, 805306457, 1610612741}};
+    const size_t vnode = jump_consistent_hash(
+      src_shard, std::max<size_t>(connections_per_peer, 1));
     // NOLINTNEXTLINE
-    size_t h = universe[jump_consistent_hash(src_shard, vnodes)];
+    size_t h = universe[vnode % primes];
+    if (vnode >= primes) {
+        boost::hash_combine(h, vnode);
+    }
     boost::hash_combine(h, std::hash<model::node_id>{}(n));
     boost::hash_combine(h, std::hash<model::node_id>{}(self));
     // use self node id to shift jump_consistent_hash_assignment
@@ -238,10 +238,17 @@ inline std::ostream& operator<<(std::ostream& o, const throughput& t) {
 }
 
 inline hdr_hist aggregate_in_thread(ss::sharded<hdr_hist>& h) {
+    // only the counts of the buckets holding values cross shards
     hdr_hist retval;
-    for (auto i = 0; i < ss::smp::count; ++i) {
-        h.invoke_on(i, [&retval](const hdr_hist& o) { retval += o; }).get();
-    }
+    retval += h
+                .map_reduce0(
+                  [](const hdr_hist& o) { return o.counts(); },
+                  hdr_hist_counts{},
+                  [](hdr_hist_counts acc, const hdr_hist_counts& c) {
+                      acc += c;
+                      return acc;
+                  })
+                .get0();
     return retval;
 }
 
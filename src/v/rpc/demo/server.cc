@@ -69,9 +69,9 @@ int main(int args, char** argv, char** env) {
                   auto begin = boost::make_counting_iterator(uint32_t(0));
                   auto end = boost::make_counting_iterator(uint32_t(ss::smp::count));
                   return ss::do_for_each(begin, end, [&h, &serv](uint32_t i) {
-                              return serv.invoke_on(i, [&h](const rpc::server& s) {
-                                    h += s.histogram();
-                              });
+                              return serv.invoke_on(i, [](const rpc::server& s) {
+                                    return s.histogram().counts();
+                              }).then([&h](hdr_hist_counts c) { h += c; });
                      }) .then([&h] { return write_histogram("server.hdr", h); });
               }).then([&serv] { return serv.stop(); });
             // clang-format on
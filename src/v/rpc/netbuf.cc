@@ -10,13 +10,35 @@
 #include "rpc/netbuf.h"
 
 #include "bytes/iobuf.h"
-#include "compression/stream_zstd.h"
+#include "compression/compression.h"
 #include "hashing/xx.h"
 #include "reflection/adl.h"
 #include "rpc/types.h"
 #include "vassert.h"
 
+#include <fmt/format.h>
+
 namespace rpc {
+static compression::type as_codec(compression_type c) {
+    switch (c) {
+    case compression_type::zstd:
+        return compression::type::zstd;
+    case compression_type::lz4:
+        return compression::type::lz4;
+    default:
+        throw std::runtime_error(
+          fmt::format("no rpc codec for compression type: {}", int(c)));
+    }
+}
+
+iobuf compress_payload(compression_type c, int level, const iobuf& b) {
+    return compression::compressor::compress(b, as_codec(c), level);
+}
+
+iobuf uncompress_payload(compression_type c, const iobuf& b) {
+    return compression::compressor::uncompress(b, as_codec(c));
+}
+
 iobuf header_as_iobuf(const header& h) {
     iobuf b;
     b.reserve_memory(size_of_rpc_header);
@@ -36,19 +58,17 @@ ss::scattered_message<char> netbuf::as_scattered() && {
     }
     if (
       _out.size_bytes() >= _min_compression_bytes
-      && rpc::compression_type::zstd == _hdr.compression) {
-        compression::stream_zstd fn;
-        _out = fn.compress(std::move(_out));
+      && rpc::compression_type::none != _hdr.compression) {
+        _out = compress_payload(_hdr.compression, _compression_level, _out);
     } else {
         // didn't meet min requirements
         _hdr.compression = rpc::compression_type::none;
     }
+    // payload may share fragments of record batches, hash them in place
     incremental_xxhash64 h;
-    auto in = iobuf::iterator_consumer(_out.cbegin(), _out.cend());
-    in.consume(_out.size_bytes(), [&h](const char* src, size_t sz) {
-        h.update(src, sz);
-        return ss::stop_iteration::no;
-    });
+    for (const auto& f : _out) {
+        h.update(f.get(), f.size());
+    }
     _hdr.payload_checksum = h.digest();
     _hdr.payload_size = _out.size_bytes();
     _hdr.header_checksum = rpc::checksum_header_only(_hdr);
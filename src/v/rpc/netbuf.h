@@ -18,6 +18,11 @@
 #include <seastar/core/scattered_message.hh>
 
 namespace rpc {
+
+/// (de)compression of payloads with the codec contexts of the shard
+iobuf compress_payload(compression_type, int level, const iobuf&);
+iobuf uncompress_payload(compression_type, const iobuf&);
+
 class netbuf {
 public:
     /// \brief used to send the bytes down the wire
@@ -27,12 +32,15 @@ public:
     void set_status(rpc::status);
     void set_correlation_id(uint32_t);
     void set_compression(rpc::compression_type c);
+    /// codec specific level, 0 is the default of the codec
+    void set_compression_level(int);
     void set_service_method_id(uint32_t);
     void set_min_compression_bytes(size_t);
     iobuf& buffer();
 
 private:
     size_t _min_compression_bytes{1024};
+    int _compression_level{0};
     header _hdr;
     iobuf _out;
 };
@@ -45,6 +53,9 @@ inline void netbuf::set_compression(rpc::compression_type c) {
       int(c));
     _hdr.compression = c;
 }
+inline void netbuf::set_compression_level(int level) {
+    _compression_level = level;
+}
 inline void netbuf::set_status(rpc::status st) {
     _hdr.meta = std::underlying_type_t<rpc::status>(st);
 }
@@ -11,13 +11,14 @@
 
 #pragma once
 
-#include "compression/stream_zstd.h"
 #include "hashing/xx.h"
 #include "likely.h"
 #include "reflection/async_adl.h"
 #include "rpc/logger.h"
+#include "rpc/netbuf.h"
 #include "rpc/types.h"
 #include "seastarx.h"
+#include "vassert.h"
 #include "vlog.h"
 
 #include <seastar/core/do_with.hh>
@@ -90,21 +91,40 @@ ss::future<T> parse_type_wihout_compression(iobuf io) {
     return reflection::async_adl<T>{}.from(*raw).finally([p = std::move(p)] {});
 }
 
-template<typename T>
-ss::future<T> parse_type(ss::input_stream<char>& in, const header& h) {
+/// \brief reads the payload described by the header, validated against its
+/// checksum and uncompressed
+inline ss::future<iobuf>
+read_payload(ss::input_stream<char>& in, const header& h) {
     return read_iobuf_exactly(in, h.payload_size).then([h](iobuf io) {
         validate_payload_and_header(io, h);
         if (h.compression == compression_type::none) {
-            return rpc::parse_type_wihout_compression<T>(std::move(io));
+            return io;
         }
-        if (h.compression == compression_type::zstd) {
-            compression::stream_zstd fn;
-            io = fn.uncompress(std::move(io));
-            return rpc::parse_type_wihout_compression<T>(std::move(io));
+        if (
+          h.compression == compression_type::zstd
+          || h.compression == compression_type::lz4) {
+            return uncompress_payload(h.compression, io);
         }
-        return ss::make_exception_future<T>(std::runtime_error(
-          fmt::format("no compression supported. header: {}", h)));
+        throw std::runtime_error(
+          fmt::format("no compression supported. header: {}", h));
+    });
+}
+
+template<typename T>
+ss::future<T> parse_type(ss::input_stream<char>& in, const header& h) {
+    return read_payload(in, h).then([](iobuf io) {
+        return rpc::parse_type_wihout_compression<T>(std::move(io));
     });
 }
 
+/// \brief decodes a payload of a type whose async_adl never defers, with
+/// the parser on the stack
+template<typename T>
+T parse_type_inline(iobuf io) {
+    iobuf_parser parser(std::move(io));
+    auto f = reflection::async_adl<T>{}.from(parser);
+    vassert(f.available(), "inline decoding of the payload deferred");
+    return f.get0();
+}
+
 } // namespace rpc
@@ -76,7 +76,27 @@ void server_probe::setup_metrics(
           [this] { return _requests_received - _requests_completed; },
           sm::description(fmt::format(
             "{}: Number of requests being processed by server", proto))),
+        sm::make_histogram(
+          "flushed_bytes",
+          [this] { return _flushed_bytes.seastar_histogram_logform(); },
+          sm::description(fmt::format(
+            "{}: Bytes of the replies written to a connection per flush",
+            proto))),
       });
+    auto reason = sm::label("reason");
+    const std::array<const char*, flush_reasons> reasons = {
+      "size", "idle", "coalesced", "requested"};
+    std::vector<sm::metric_definition> flushes;
+    flushes.reserve(flush_reasons);
+    for (size_t i = 0; i < flush_reasons; ++i) {
+        flushes.push_back(sm::make_derive(
+          "flushes",
+          [this, i] { return _flushes[i]; },
+          sm::description(fmt::format(
+            "{}: Number of flushes of the replies to a connection", proto)),
+          {reason(reasons[i])}));
+    }
+    mgs.add_group(prometheus_sanitize::metrics_name(proto), std::move(flushes));
 }
 
 std::ostream& operator<<(std::ostream& o, const server_probe& p) {
@@ -42,13 +42,33 @@ ss::future<result<transport*>> reconnect_transport::get_connected() {
     return reconnect();
 }
 
+void reconnect_transport::set_peer_down(bool down) {
+    if (_peer_down && !down) {
+        // the peer is back, the next request connects at once
+        _backoff_policy.reset();
+    }
+    _peer_down = down;
+}
+
 ss::future<result<transport*>> reconnect_transport::reconnect() {
     using ret_t = result<transport*>;
-    if (!has_backoff_expired(
-          _stamp, _backoff_policy.current_backoff_duration())) {
+    if (
+      _peer_down
+      || !has_backoff_expired(
+        _stamp, _backoff_policy.current_backoff_duration())) {
         return ss::make_ready_future<ret_t>(errc::exponential_backoff);
     }
     _stamp = rpc::clock_type::now();
+    return do_connect();
+}
+
+ss::future<result<transport*>> reconnect_transport::probe() {
+    _stamp = rpc::clock_type::now();
+    return do_connect();
+}
+
+ss::future<result<transport*>> reconnect_transport::do_connect() {
+    using ret_t = result<transport*>;
     return with_gate(_dispatch_gate, [this] {
         return with_semaphore(_connected_sem, 1, [this] {
             if (is_valid()) {
@@ -65,6 +85,9 @@ ss::future<result<transport*>> reconnect_transport::reconnect() {
                     _backoff_policy.next_backoff();
                     rpclog.trace(
                       "error reconnecting {}", std::current_exception());
+                    if (!_peer_down && _failure_observer) {
+                        _failure_observer();
+                    }
                     return ss::make_ready_future<ret_t>(
                       errc::disconnected_endpoint);
                 }
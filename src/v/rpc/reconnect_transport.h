@@ -20,10 +20,17 @@
 #include <seastar/core/gate.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/net/socket_defs.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <chrono>
 
 namespace rpc {
 class reconnect_transport {
 public:
+    /// called when a connection attempt fails while the peer is not known
+    /// to be down, see connection_cache
+    using failure_observer = ss::noncopyable_function<void()>;
+
     explicit reconnect_transport(
       rpc::transport_configuration c, backoff_policy backoff_policy)
       : _transport(std::move(c))
@@ -44,11 +51,31 @@ public:
 
     ss::future<> stop();
 
+    void set_failure_observer(failure_observer o) {
+        _failure_observer = std::move(o);
+    }
+
+    /// \brief liveness of the peer as agreed by all the shards. While the
+    /// peer is down reconnect() fails at once, only probe() connects
+    void set_peer_down(bool down);
+    bool is_peer_down() const { return _peer_down; }
+
+    /// \brief connects regardless of the backoff and the peer liveness
+    ss::future<result<transport*>> probe();
+
+    std::chrono::milliseconds backoff_duration() {
+        return _backoff_policy.current_backoff_duration();
+    }
+
 private:
+    ss::future<result<transport*>> do_connect();
+
     rpc::transport _transport;
     rpc::clock_type::time_point _stamp{rpc::clock_type::now()};
     ss::semaphore _connected_sem{1};
     ss::gate _dispatch_gate;
     backoff_policy _backoff_policy;
+    failure_observer _failure_observer;
+    bool _peer_down{false};
 };
 } // namespace rpc
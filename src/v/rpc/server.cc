@@ -28,16 +28,30 @@ namespace rpc {
 
 server::server(server_configuration c)
   : cfg(std::move(c))
-  , _memory(cfg.max_service_memory_per_core)
+  , _memory(
+      cfg.memory_share ? cfg.memory_share->min_bytes
+                       : cfg.max_service_memory_per_core)
+  , _protected_memory(cfg.protected_memory_per_core)
+  , _bulk_memory(
+      cfg.bulk_memory_per_core ? *cfg.bulk_memory_per_core
+                               : ss::semaphore::max_counter())
   , _creds(cfg.credentials) {}
 
 server::~server() = default;
 
 void server::start() {
     vassert(_proto, "must have a registered protocol before starting");
+    if (cfg.memory_share) {
+        _memory_pool = std::make_unique<memory_broker::semaphore_pool>(
+          cfg.name, cfg.memory_priority, *cfg.memory_share, _memory);
+    }
     if (!cfg.disable_metrics) {
         setup_metrics();
+        _proto->setup_metrics();
         _probe.setup_metrics(_metrics, cfg.name.c_str());
+        if (_memory_pool) {
+            _memory_pool->setup_metrics();
+        }
     }
     for (auto addr : cfg.addrs) {
         ss::server_socket ss;
@@ -109,7 +123,9 @@ ss::future<> server::accept(ss::server_socket& s) {
                 _connections,
                 std::move(ar.connection),
                 ar.remote_address,
-                _probe);
+                _probe,
+                // TLS encrypts the fragments of a write one by one
+                pack_fragments(bool(_creds)));
               vlog(
                 rpclog.trace, "Incoming connection from {}", ar.remote_address);
               if (_conn_gate.is_closed()) {
@@ -150,6 +166,11 @@ ss::future<> server::stop() {
           _connections, [](connection& c) { return c.shutdown(); });
     });
 }
+size_t server::memory_capacity() const {
+    return _memory_pool ? _memory_pool->capacity()
+                        : cfg.max_service_memory_per_core;
+}
+
 void server::setup_metrics() {
     namespace sm = ss::metrics;
     if (!_proto) {
@@ -159,17 +180,39 @@ void server::setup_metrics() {
       prometheus_sanitize::metrics_name(cfg.name),
       {sm::make_total_bytes(
          "max_service_mem_bytes",
-         [this] { return cfg.max_service_memory_per_core; },
+         [this] { return memory_capacity(); },
          sm::description(
            fmt::format("{}: Maximum memory allowed for RPC", cfg.name))),
        sm::make_total_bytes(
          "consumed_mem_bytes",
-         [this] { return cfg.max_service_memory_per_core - _memory.current(); },
+         [this] {
+             return _memory_pool ? _memory_pool->used()
+                                 : cfg.max_service_memory_per_core
+                                     - _memory.current();
+         },
          sm::description(
            fmt::format("{}: Memory consumed by request processing", cfg.name))),
+       sm::make_total_bytes(
+         "consumed_protected_mem_bytes",
+         [this] {
+             return cfg.protected_memory_per_core
+                    - _protected_memory.available_units();
+         },
+         sm::description(fmt::format(
+           "{}: Memory consumed by latency critical requests", cfg.name))),
        sm::make_histogram(
          "dispatch_handler_latency",
          [this] { return _hist.seastar_histogram_logform(); },
-         sm::description(fmt::format("{}: Latency ", cfg.name)))});
+         sm::description(fmt::format("{}: Latency ", cfg.name))),
+       sm::make_gauge(
+         "dispatch_handler_latency_p50_us",
+         [this] { return _hist.window_value_at(50.0); },
+         sm::description(fmt::format(
+           "{}: Median latency over the last minute", cfg.name))),
+       sm::make_gauge(
+         "dispatch_handler_latency_p99_us",
+         [this] { return _hist.window_value_at(99.0); },
+         sm::description(fmt::format(
+           "{}: 99th percentile latency over the last minute", cfg.name)))});
 }
 } // namespace rpc
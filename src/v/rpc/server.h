@@ -14,6 +14,7 @@
 #include "rpc/connection.h"
 #include "rpc/types.h"
 #include "utils/hdr_hist.h"
+#include "utils/windowed_hdr_hist.h"
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/gate.hh>
@@ -41,8 +42,11 @@ public:
         ss::lw_shared_ptr<connection> conn;
 
         server_probe& probe() { return _s->_probe; }
+        const server_configuration& cfg() const { return _s->cfg; }
         ss::semaphore& memory() { return _s->_memory; }
-        hdr_hist& hist() { return _s->_hist; }
+        ss::semaphore& protected_memory() { return _s->_protected_memory; }
+        ss::semaphore& bulk_memory() { return _s->_bulk_memory; }
+        windowed_hdr_hist& hist() { return _s->_hist; }
         ss::gate& conn_gate() { return _s->_conn_gate; }
         ss::abort_source& abort_source() { return _s->_as; }
         bool abort_requested() const { return _s->_as.abort_requested(); }
@@ -62,6 +66,9 @@ public:
         // the lifetime of all references here are guaranteed to live
         // until the end of the server (container/parent)
         virtual ss::future<> apply(server::resources) = 0;
+        /// \brief called on start when the metrics of the server are
+        /// enabled
+        virtual void setup_metrics() {}
     };
 
     explicit server(server_configuration);
@@ -78,20 +85,26 @@ public:
     ss::future<> stop();
 
     const server_configuration cfg; // NOLINT
-    const hdr_hist& histogram() const { return _hist; }
+    const hdr_hist& histogram() const { return _hist.hist(); }
 
 private:
     friend resources;
     ss::future<> accept(ss::server_socket&);
     void setup_metrics();
 
+    size_t memory_capacity() const;
+
     std::unique_ptr<protocol> _proto;
     ss::semaphore _memory;
+    ss::semaphore _protected_memory;
+    ss::semaphore _bulk_memory;
+    // registered on start so that the semaphore does not move anymore
+    std::unique_ptr<memory_broker::semaphore_pool> _memory_pool;
     std::vector<std::unique_ptr<ss::server_socket>> _listeners;
     boost::intrusive::list<connection> _connections;
     ss::abort_source _as;
     ss::gate _conn_gate;
-    hdr_hist _hist;
+    windowed_hdr_hist _hist;
     server_probe _probe;
     ss::metrics::metric_groups _metrics;
     ss::shared_ptr<ss::tls::server_credentials> _creds;
@@ -11,10 +11,13 @@
 
 #pragma once
 
+#include "rpc/batched_output_stream.h"
 #include "seastarx.h"
+#include "utils/hdr_hist.h"
 
 #include <seastar/core/metrics_registration.hh>
 
+#include <array>
 #include <iostream>
 
 namespace rpc {
@@ -46,6 +49,12 @@ public:
 
     void waiting_for_available_memory() { ++_requests_blocked_memory; }
 
+    /// a flush of the replies of a connection, a writev of `bytes`
+    void flushed(flush_reason r, size_t bytes) {
+        ++_flushes[static_cast<size_t>(r)];
+        _flushed_bytes.record(bytes);
+    }
+
     void setup_metrics(ss::metrics::metric_groups& mgs, const char* name);
 
 private:
@@ -60,6 +69,8 @@ private:
     uint32_t _corrupted_headers = 0;
     uint32_t _method_not_found_errors = 0;
     uint32_t _requests_blocked_memory = 0;
+    std::array<uint64_t, flush_reasons> _flushes{};
+    hdr_hist _flushed_bytes;
     friend std::ostream& operator<<(std::ostream& o, const server_probe& p);
 };
 
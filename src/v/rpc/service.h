@@ -16,6 +16,7 @@
 #include "rpc/parse_utils.h"
 #include "rpc/types.h"
 #include "seastarx.h"
+#include "vassert.h"
 
 #include <seastar/core/reactor.hh>
 #include <seastar/core/scheduling.hh>
@@ -35,6 +36,12 @@ struct service {
     virtual ss::smp_service_group& get_smp_service_group() = 0;
     /// \brief return nullptr when method not found
     virtual method* method_from_id(uint32_t) = 0;
+    /// \brief how the server admits the memory of a request to the method
+    virtual memory_class method_memory_class(uint32_t) const {
+        return memory_class::normal;
+    }
+    /// \brief called once by the server when its metrics are enabled
+    virtual void setup_metrics() {}
 };
 
 class rpc_internal_body_parsing_exception : public std::exception {
@@ -83,5 +90,48 @@ struct service::execution_helper {
                 });
           });
     }
+
+    /// \brief as exec, for methods whose request and reply are (de)coded
+    /// without deferring: the request is decoded with a parser on the stack
+    /// and the reply is written directly into the returned netbuf, saving
+    /// the heap allocations and continuations of the general path
+    template<typename Func>
+    static ss::future<netbuf> exec_inline(
+      ss::input_stream<char>& in,
+      streaming_context& ctx,
+      uint32_t method_id,
+      Func&& f) {
+        return ctx.permanent_memory_reservation(ctx.get_header().payload_size)
+          .then([f = std::forward<Func>(f), method_id, &in, &ctx]() mutable {
+              return read_payload(in, ctx.get_header())
+                .then_wrapped([f = std::forward<Func>(f),
+                               &ctx](ss::future<iobuf> io_f) mutable {
+                    auto input = decode_inline(std::move(io_f));
+                    ctx.signal_body_parse();
+                    return f(std::move(input), ctx);
+                })
+                .then([method_id](Output out) {
+                    netbuf b;
+                    b.set_service_method_id(method_id);
+                    auto encoded = reflection::async_adl<Output>{}.to(
+                      b.buffer(), std::move(out));
+                    vassert(
+                      encoded.available(),
+                      "inline encoding of the reply deferred");
+                    encoded.get();
+                    return b;
+                });
+          });
+    }
+
+private:
+    static Input decode_inline(ss::future<iobuf> io_f) {
+        try {
+            return parse_type_inline<Input>(io_f.get0());
+        } catch (...) {
+            throw rpc_internal_body_parsing_exception(
+              std::current_exception());
+        }
+    }
 };
 } // namespace rpc
@@ -14,7 +14,9 @@
 
 #include <seastar/core/future-util.hh>
 
+#include <algorithm>
 #include <exception>
+#include <vector>
 
 namespace rpc {
 struct server_context_impl final : streaming_context {
@@ -22,6 +24,32 @@ struct server_context_impl final : streaming_context {
       : res(std::move(s))
       , hdr(h) {}
     ss::future<ss::semaphore_units<>> reserve_memory(size_t ask) final {
+        switch (mclass) {
+        case memory_class::latency_critical:
+            // larger than the whole protected memory, admitted as any other
+            if (ask <= res.cfg().protected_memory_per_core) {
+                return get_units(res.protected_memory(), ask);
+            }
+            break;
+        case memory_class::bulk:
+            if (res.cfg().bulk_memory_per_core) {
+                // a request larger than the bulk memory takes all of it
+                const auto bulk = std::min(
+                  ask, *res.cfg().bulk_memory_per_core);
+                return get_units(res.bulk_memory(), bulk)
+                  .then([this, ask](ss::semaphore_units<> u) {
+                      // released with the context, as the shared units
+                      bulk_units.push_back(std::move(u));
+                      return reserve_shared_memory(ask);
+                  });
+            }
+            break;
+        case memory_class::normal:
+            break;
+        }
+        return reserve_shared_memory(ask);
+    }
+    ss::future<ss::semaphore_units<>> reserve_shared_memory(size_t ask) {
         auto fut = get_units(res.memory(), ask);
         if (res.memory().waiters()) {
             res.probe().waiting_for_available_memory();
@@ -33,6 +61,8 @@ struct server_context_impl final : streaming_context {
     server::resources res;
     header hdr;
     ss::promise<> pr;
+    memory_class mclass{memory_class::normal};
+    std::vector<ss::semaphore_units<>> bulk_units;
 };
 
 ss::future<> simple_protocol::apply(server::resources rs) {
@@ -59,7 +89,12 @@ ss::future<> simple_protocol::apply(server::resources rs) {
 ss::future<>
 send_reply(ss::lw_shared_ptr<server_context_impl> ctx, netbuf buf) {
     buf.set_min_compression_bytes(1024);
-    buf.set_compression(rpc::compression_type::zstd);
+    // reply with the codec the client picked for its connection
+    if (auto c = ctx->get_header().compression; c <= compression_type::max) {
+        buf.set_compression(c);
+    } else {
+        buf.set_compression(compression_type::none);
+    }
     buf.set_correlation_id(ctx->get_header().correlation_id);
 
     auto view = std::move(buf).as_scattered();
@@ -106,6 +141,7 @@ simple_protocol::dispatch_method_once(header h, server::resources rs) {
         }
 
         method* m = it->get()->method_from_id(method_id);
+        ctx->mclass = it->get()->method_memory_class(method_id);
 
         return (*m)(ctx->res.conn->input(), *ctx)
           .then_wrapped([ctx, m = ctx->res.hist().auto_measure(), rs](
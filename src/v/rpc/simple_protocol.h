@@ -26,6 +26,11 @@ public:
         return "vectorized internal rpc protocol";
     };
     ss::future<> apply(server::resources) final;
+    void setup_metrics() final {
+        for (auto& s : _services) {
+            s->setup_metrics();
+        }
+    }
 
 private:
     ss::future<> dispatch_method_once(header, server::resources);
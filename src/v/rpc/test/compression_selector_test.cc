@@ -0,0 +1,76 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE rpc
+#include "rpc/compression_selector.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+using selector = rpc::compression_selector;
+
+static void
+record_round_trips(selector& s, size_t size, selector::clock_type::duration d) {
+    for (size_t i = 0; i < 10 * selector::transfer_window; ++i) {
+        s.record_round_trip(size, d);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(small_payloads_are_not_compressed) {
+    selector s;
+    record_round_trips(s, 1024 * 1024, 100ms);
+    for (size_t i = 0; i < 2 * selector::exploration_interval; ++i) {
+        BOOST_REQUIRE(
+          s.select(100, 1024).type == rpc::compression_type::none);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fast_link_skips_compression) {
+    selector s;
+    // ~10GB/s link
+    record_round_trips(s, 1024 * 1024, 100us);
+    BOOST_REQUIRE(
+      s.select(1024 * 1024, 1024).type == rpc::compression_type::none);
+}
+
+BOOST_AUTO_TEST_CASE(slow_link_compresses_harder) {
+    selector s;
+    // ~10MB/s link
+    record_round_trips(s, 1024 * 1024, 100ms);
+    auto c = s.select(1024 * 1024, 1024);
+    BOOST_REQUIRE(c.type == rpc::compression_type::zstd);
+}
+
+BOOST_AUTO_TEST_CASE(measured_cost_changes_choice) {
+    selector s;
+    // ~100MB/s link, compression priors win
+    record_round_trips(s, 1024 * 1024, 10ms);
+    BOOST_REQUIRE(
+      s.select(1024 * 1024, 1024).type != rpc::compression_type::none);
+    // payload does not compress, every codec only adds cpu cost
+    for (auto& c : selector::candidates) {
+        for (int i = 0; i < 50; ++i) {
+            s.record_compression(c, 1024 * 1024, 1024 * 1024, 5ms);
+        }
+    }
+    BOOST_REQUIRE(
+      s.select(1024 * 1024, 1024).type == rpc::compression_type::none);
+}
+
+BOOST_AUTO_TEST_CASE(explores_other_codecs) {
+    selector s;
+    bool compressed = false;
+    for (size_t i = 0; i < 2 * selector::exploration_interval; ++i) {
+        compressed |= s.select(1024 * 1024, 1024).type
+                      != rpc::compression_type::none;
+    }
+    BOOST_REQUIRE(compressed);
+}
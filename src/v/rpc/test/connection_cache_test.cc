@@ -0,0 +1,48 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE rpc
+#include "rpc/connection_cache.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+
+static std::set<ss::shard_id>
+owners(model::node_id node, ss::shard_id shards, size_t connections) {
+    std::set<ss::shard_id> ret;
+    for (ss::shard_id i = 0; i < shards; ++i) {
+        ret.insert(rpc::connection_cache::shard_for(
+          model::node_id(0), i, node, shards, connections));
+    }
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(connections_bounded_by_fan_out) {
+    for (size_t connections : {1, 3, 8, 16}) {
+        for (int n = 1; n < 10; ++n) {
+            auto o = owners(model::node_id(n), 32, connections);
+            BOOST_REQUIRE_GE(o.size(), 1);
+            BOOST_REQUIRE_LE(o.size(), connections);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(connection_per_shard_is_never_forwarded) {
+    for (ss::shard_id i = 0; i < 32; ++i) {
+        BOOST_REQUIRE_EQUAL(
+          rpc::connection_cache::shard_for(
+            model::node_id(0), i, model::node_id(1), 32, 32),
+          i);
+        BOOST_REQUIRE_EQUAL(
+          rpc::connection_cache::shard_for(
+            model::node_id(0), i, model::node_id(1), 32, 64),
+          i);
+    }
+}
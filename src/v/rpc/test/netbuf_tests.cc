@@ -7,9 +7,11 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "rpc/batched_output_stream.h"
 #include "rpc/netbuf.h"
 #include "rpc/parse_utils.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/thread_test_case.hh>
 
@@ -18,6 +20,9 @@
 
 #include <fmt/ostream.h>
 
+#include <utility>
+#include <vector>
+
 namespace rpc {
 /// \brief expects the inputstream to be prefixed by an rpc::header
 template<typename T>
@@ -45,3 +50,88 @@ SEASTAR_THREAD_TEST_CASE(netbuf_pod) {
     BOOST_REQUIRE_EQUAL(src.y, dst.y);
     BOOST_REQUIRE_EQUAL(src.z, dst.z);
 }
+
+SEASTAR_THREAD_TEST_CASE(pack_small_fragments) {
+    using stream = rpc::batched_output_stream;
+    const auto small = ss::sstring(100, 's');
+    const auto large = ss::sstring(stream::max_packed_fragment, 'l');
+    ss::scattered_message<char> msg;
+    ss::sstring expected;
+    // a record and a half of small fragments, a large one, and a small one
+    const size_t small_frags = 3 * stream::tls_record_size / 2 / small.size();
+    for (size_t i = 0; i < small_frags; ++i) {
+        msg.append_static(small.data(), small.size());
+        expected += small;
+    }
+    msg.append_static(large.data(), large.size());
+    expected += large;
+    msg.append_static(small.data(), small.size());
+    expected += small;
+
+    auto p = stream::pack_small_fragments(std::move(msg));
+    BOOST_REQUIRE_EQUAL(p.nr_frags(), 4);
+    BOOST_REQUIRE_EQUAL(p.fragments()[0].size, stream::tls_record_size);
+    BOOST_REQUIRE_EQUAL(p.fragments()[2].size, large.size());
+    p.linearize();
+    BOOST_REQUIRE_EQUAL(
+      ss::sstring(p.fragments()[0].base, p.fragments()[0].size), expected);
+}
+
+namespace {
+struct flush_log {
+    std::vector<std::pair<rpc::flush_reason, size_t>> flushes;
+
+    rpc::batched_output_stream make_stream(size_t cache) {
+        return rpc::batched_output_stream(
+          make_iobuf_output_stream(iobuf()),
+          cache,
+          rpc::coalesce_flushes::yes,
+          rpc::pack_fragments::no,
+          [this](rpc::flush_reason r, size_t bytes) {
+              flushes.emplace_back(r, bytes);
+          });
+    }
+};
+
+ss::scattered_message<char> message(const ss::sstring& data) {
+    ss::scattered_message<char> msg;
+    msg.append_static(data.data(), data.size());
+    return msg;
+}
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(adaptive_corking) {
+    const auto data = ss::sstring(100, 'x');
+    flush_log log;
+    auto out = log.make_stream(rpc::batched_output_stream::tls_record_size);
+
+    // an idle stream flushes at once
+    out.write(message(data)).get();
+    BOOST_REQUIRE_EQUAL(log.flushes.size(), 1);
+    BOOST_REQUIRE(log.flushes[0].first == rpc::flush_reason::idle);
+    BOOST_REQUIRE_EQUAL(log.flushes[0].second, data.size());
+
+    // the writes of a round are corked behind the first one
+    log.flushes.clear();
+    std::vector<ss::future<>> writes;
+    for (int i = 0; i < 4; ++i) {
+        writes.push_back(out.write(message(data)));
+    }
+    ss::when_all_succeed(writes.begin(), writes.end()).get();
+    BOOST_REQUIRE_LE(log.flushes.size(), 2);
+    BOOST_REQUIRE(log.flushes.back().first == rpc::flush_reason::coalesced);
+    size_t flushed = 0;
+    for (const auto& f : log.flushes) {
+        flushed += f.second;
+    }
+    BOOST_REQUIRE_EQUAL(flushed, 4 * data.size());
+
+    // past the cache size the bytes go out without waiting for the round
+    log.flushes.clear();
+    const auto large = ss::sstring(
+      rpc::batched_output_stream::tls_record_size, 'l');
+    out.write(message(large)).get();
+    BOOST_REQUIRE_EQUAL(log.flushes.size(), 1);
+    BOOST_REQUIRE(log.flushes[0].first == rpc::flush_reason::size);
+    out.stop().get();
+}
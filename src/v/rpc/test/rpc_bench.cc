@@ -8,10 +8,16 @@
 // by the Apache License, Version 2.0
 
 #include "reflection/adl.h"
+#include "rpc/test/rpc_integration_fixture.h"
 
 #include <seastar/core/reactor.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sharded.hh>
+#include <seastar/core/thread.hh>
 #include <seastar/testing/perf_tests.hh>
+#include <seastar/util/defer.hh>
+
+#include <boost/range/irange.hpp>
 
 struct small_t {
     int8_t a = 1;
@@ -85,3 +91,43 @@ PERF_TEST(big_10mb, serialize) {
 PERF_TEST(big_10mb, deserialize) {
     return deserialize_big(10 << 20 /*10MB*/, 1 << 15 /*32KB*/);
 }
+
+/*
+ * Client and server share the core, the reported time per run is the cost of
+ * a full request round trip, its inverse is the requests per second served
+ * by one core. Run with `-c 1`.
+ */
+static constexpr size_t echo_requests_per_run = 1000;
+
+static ss::future<size_t> echo_requests(size_t in_flight) {
+    return ss::async([in_flight] {
+        rpc_integration_fixture f;
+        f.configure_server();
+        f.register_services();
+        f.start_server();
+        rpc::client<echo::echo_client_protocol> client(f.client_config());
+        client.connect().get();
+        auto stop = ss::defer([&client] { client.stop().get(); });
+
+        ss::semaphore sem(in_flight);
+        perf_tests::start_measuring_time();
+        ss::parallel_for_each(
+          boost::irange<size_t>(0, echo_requests_per_run),
+          [&sem, &client](size_t) {
+              return ss::with_semaphore(sem, 1, [&client] {
+                  return client
+                    .echo(
+                      echo::echo_req{.str = "ping"},
+                      rpc::client_opts(rpc::no_timeout))
+                    .discard_result();
+              });
+          })
+          .get();
+        perf_tests::stop_measuring_time();
+        return echo_requests_per_run;
+    });
+}
+
+PERF_TEST(rpc_echo, one_in_flight) { return echo_requests(1); }
+
+PERF_TEST(rpc_echo, back_to_back_64) { return echo_requests(64); }
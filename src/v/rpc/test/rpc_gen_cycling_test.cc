@@ -270,6 +270,16 @@ FIXTURE_TEST(rpc_mixed_compression, rpc_integration_fixture) {
                       0 /*min bytes compress*/))
                   .get0();
     BOOST_REQUIRE_EQUAL(echo_resp.value().data.str, data);
+    BOOST_TEST_MESSAGE("Calling echo method with lz4 and adaptive compression");
+    for (auto c :
+         {rpc::compression_type::lz4, rpc::compression_type::adaptive}) {
+        echo_resp = client
+                      .echo(
+                        echo::echo_req{.str = data},
+                        rpc::client_opts(rpc::no_timeout, c, 0))
+                      .get0();
+        BOOST_REQUIRE_EQUAL(echo_resp.value().data.str, data);
+    }
 
     // close resources
     client.stop().get();
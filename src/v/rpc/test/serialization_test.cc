@@ -40,6 +40,49 @@ SEASTAR_THREAD_TEST_CASE(serialize_with_fragmented_buffer) {
     BOOST_CHECK_EQUAL(b.size_bytes(), 55 + complex_custom_bytes());
 }
 
+SEASTAR_THREAD_TEST_CASE(serialize_compact_pod) {
+    static_assert(reflection::adl<compact_pod>::is_compact);
+    // padding between x and y
+    static_assert(!reflection::adl<pod>::is_compact);
+    static_assert(!reflection::adl<pod_with_vector>::is_compact);
+
+    auto b = iobuf();
+    reflection::serialize(b, compact_pod{.x = 4, .y = 5, .z = 6});
+    // the same bytes as serializing the fields one by one
+    auto expected = iobuf();
+    reflection::serialize(expected, int32_t(4), int32_t(5), int64_t(6));
+    BOOST_REQUIRE(b == expected);
+
+    auto it = reflection::from_iobuf<compact_pod>(std::move(b));
+    BOOST_CHECK_EQUAL(it.x, 4);
+    BOOST_CHECK_EQUAL(it.y, 5);
+    BOOST_CHECK_EQUAL(it.z, 6);
+}
+
+SEASTAR_THREAD_TEST_CASE(serialize_compact_pod_vector) {
+    std::vector<compact_pod> v;
+    for (int32_t i = 0; i < 100; ++i) {
+        v.push_back(compact_pod{.x = i, .y = -i, .z = i * 1000});
+    }
+    auto b = reflection::to_iobuf(v);
+    BOOST_CHECK_EQUAL(b.size_bytes(), sizeof(int32_t) + 100 * 16);
+
+    auto out = reflection::from_iobuf<std::vector<compact_pod>>(std::move(b));
+    BOOST_REQUIRE_EQUAL(out.size(), v.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+        BOOST_CHECK_EQUAL(out[i].x, v[i].x);
+        BOOST_CHECK_EQUAL(out[i].y, v[i].y);
+        BOOST_CHECK_EQUAL(out[i].z, v[i].z);
+    }
+
+    // a size beyond the bytes left does not allocate for it
+    auto truncated = iobuf();
+    reflection::serialize(truncated, int32_t(1 << 30));
+    BOOST_CHECK_THROW(
+      reflection::from_iobuf<std::vector<compact_pod>>(std::move(truncated)),
+      std::out_of_range);
+}
+
 SEASTAR_THREAD_TEST_CASE(serialize_pod_with_vector) {
     auto b = iobuf();
     pod_with_vector it;
@@ -32,6 +32,13 @@ inline constexpr size_t pod_bytes() {
            + sizeof(int64_t); // pod::z
 }
 
+// no padding between the fields, serialized with a single copy
+struct compact_pod {
+    int32_t x = 1;
+    int32_t y = 2;
+    int64_t z = 3;
+};
+
 struct complex_custom {
     pod pit;
     iobuf oi;
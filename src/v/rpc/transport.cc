@@ -87,7 +87,12 @@ ss::future<> base_transport::do_connect() {
           }
           _probe.connection_established();
           _in = _fd->input();
-          _out = batched_output_stream(_fd->output());
+          // TLS encrypts the fragments of a write one by one
+          _out = batched_output_stream(
+            _fd->output(),
+            batched_output_stream::default_max_unflushed_bytes,
+            coalesce_flushes::no,
+            pack_fragments(bool(_creds)));
       });
 }
 ss::future<> base_transport::connect() {
@@ -187,8 +192,35 @@ transport::send(netbuf b, rpc::client_opts opts) {
           });
 
           // send
+          const bool adaptive = opts.compression
+                                == compression_type::adaptive;
+          const auto payload_size = b.buffer().size_bytes();
+          auto codec = compression_selector::candidates[0];
+          if (adaptive) {
+              codec = _compression.select(
+                payload_size, opts.min_compression_bytes);
+              b.set_compression(codec.type);
+              b.set_compression_level(codec.level);
+          }
+          const auto start = compression_selector::clock_type::now();
           auto view = std::move(b).as_scattered();
           const auto sz = view.size();
+          if (adaptive && codec.type != compression_type::none) {
+              _compression.record_compression(
+                codec,
+                payload_size,
+                sz - size_of_rpc_header,
+                compression_selector::clock_type::now() - start);
+          }
+          if (adaptive) {
+              fut = fut.then([this, sz, start](ret_t r) {
+                  if (r) {
+                      _compression.record_round_trip(
+                        sz, compression_selector::clock_type::now() - start);
+                  }
+                  return r;
+              });
+          }
           return get_units(_memory, sz)
             .then([this, v = std::move(view), f = std::move(fut)](
                     ss::semaphore_units<> units) mutable {
@@ -15,6 +15,7 @@
 #include "reflection/async_adl.h"
 #include "rpc/batched_output_stream.h"
 #include "rpc/client_probe.h"
+#include "rpc/compression_selector.h"
 #include "rpc/errc.h"
 #include "rpc/netbuf.h"
 #include "rpc/parse_utils.h"
@@ -113,6 +114,8 @@ private:
     absl::flat_hash_map<uint32_t, std::unique_ptr<internal::response_handler>>
       _correlations;
     uint32_t _correlation_idx{0};
+    // used by requests with adaptive compression
+    compression_selector _compression;
     ss::metrics::metric_groups _metrics;
 
     friend std::ostream& operator<<(std::ostream&, const transport&);
@@ -153,7 +156,10 @@ transport::send_typed(Input r, uint32_t method_id, rpc::client_opts opts) {
     _probe.request();
 
     auto b = std::make_unique<rpc::netbuf>();
-    b->set_compression(opts.compression);
+    if (opts.compression != compression_type::adaptive) {
+        // adaptive codec is picked once the payload size is known
+        b->set_compression(opts.compression);
+    }
     b->set_min_compression_bytes(opts.min_compression_bytes);
     auto raw_b = b.get();
     raw_b->set_service_method_id(method_id);
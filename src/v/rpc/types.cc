@@ -52,8 +52,15 @@ std::ostream& operator<<(std::ostream& o, const server_configuration& c) {
     for (auto& a : c.addrs) {
         o << a;
     }
-    o << ", max_service_memory_per_core: " << c.max_service_memory_per_core
-      << ", has_tls_credentials: " << (c.credentials ? "yes" : "no")
+    o << ", max_service_memory_per_core: " << c.max_service_memory_per_core;
+    if (c.memory_share) {
+        o << ", memory_share: {min: " << c.memory_share->min_bytes
+          << ", max: " << c.memory_share->max_bytes << "}";
+    }
+    o << ", protected_memory_per_core: " << c.protected_memory_per_core
+      << ", bulk_memory_per_core: "
+      << (c.bulk_memory_per_core ? *c.bulk_memory_per_core : 0);
+    o << ", has_tls_credentials: " << (c.credentials ? "yes" : "no")
       << ", metrics_enabled:" << !c.disable_metrics;
     return o << "}";
 }
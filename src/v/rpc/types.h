@@ -13,6 +13,7 @@
 
 #include "likely.h"
 #include "outcome.h"
+#include "resource_mgmt/memory_broker.h"
 #include "seastarx.h"
 
 #include <seastar/core/future.hh>
@@ -30,6 +31,7 @@
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <optional>
 #include <type_traits>
 #include <vector>
 
@@ -45,14 +47,19 @@ static constexpr clock_type::time_point no_timeout
 enum class compression_type : uint8_t {
     none = 0,
     zstd,
+    lz4,
     min = none,
-    max = zstd,
+    max = lz4,
+    /// \brief not a wire format. client option to pick the codec and level
+    /// per connection, see rpc::compression_selector
+    adaptive = 0xff,
 };
 
 struct negotiation_frame {
     int8_t version = 0;
     /// \brief 0 - no compression
     ///        1 - zstd
+    ///        2 - lz4
     compression_type compression = compression_type::none;
 };
 
@@ -177,6 +184,18 @@ inline result<T> get_ctx_data(result<client_context<T>>&& ctx) {
 
 using metrics_disabled = ss::bool_class<struct metrics_disabled_tag>;
 
+/// how the memory of a request is admitted by the server, declared per
+/// method with `memory_class` in the codegen json of the service
+enum class memory_class : uint8_t {
+    // the shared memory of the server
+    normal = 0,
+    // small requests that must not queue behind others, e.g. heartbeats.
+    // admitted from the protected memory of the server
+    latency_critical,
+    // admitted from the shared memory within the bulk memory of the server
+    bulk,
+};
+
 struct server_configuration {
     std::vector<ss::socket_address> addrs;
     int64_t max_service_memory_per_core;
@@ -186,6 +205,16 @@ struct server_configuration {
     // we use the same default as seastar for load balancing algorithm
     ss::server_socket::load_balancing_algorithm load_balancing_algo
       = ss::server_socket::load_balancing_algorithm::connection_distribution;
+    // when set the memory of the service is brokered with the other pools
+    // of the shard within the share, max_service_memory_per_core is unused
+    std::optional<memory_broker::share> memory_share;
+    memory_broker::priority memory_priority = memory_broker::priority::rpc;
+    // dedicated to memory_class::latency_critical requests, outside of the
+    // shared memory. with 0 they are admitted from the shared memory
+    size_t protected_memory_per_core = 0;
+    // bounds the shared memory that memory_class::bulk requests hold at
+    // once. if not set, only the shared memory does
+    std::optional<size_t> bulk_memory_per_core;
 
     explicit server_configuration(ss::sstring n)
       : name(std::move(n)) {}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "security/scram_credential.h"
+
+#include <seastar/core/future.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <optional>
+
+namespace security {
+
+/**
+ * Credentials of the users, an instance per core.
+ *
+ * The controller replicates the credentials derived when a user is created
+ * and applies them to the store of every core. A connection is authenticated
+ * against the store of its own core, without crossing shards and without
+ * deriving the salted password again.
+ */
+class credential_store {
+public:
+    using container_type
+      = absl::flat_hash_map<credential_user, scram_credential>;
+    using const_iterator = container_type::const_iterator;
+
+    credential_store() noexcept = default;
+    credential_store(const credential_store&) = delete;
+    credential_store& operator=(const credential_store&) = delete;
+    credential_store(credential_store&&) noexcept = default;
+    credential_store& operator=(credential_store&&) noexcept = default;
+    ~credential_store() noexcept = default;
+
+    void put(credential_user user, scram_credential credential) {
+        _credentials.insert_or_assign(std::move(user), std::move(credential));
+    }
+
+    bool remove(const credential_user& user) {
+        return _credentials.erase(user) > 0;
+    }
+
+    std::optional<scram_credential> get(const credential_user& user) const {
+        if (auto it = _credentials.find(user); it != _credentials.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    bool contains(const credential_user& user) const {
+        return _credentials.contains(user);
+    }
+
+    void clear() { _credentials.clear(); }
+
+    size_t size() const { return _credentials.size(); }
+    const_iterator begin() const { return _credentials.cbegin(); }
+    const_iterator end() const { return _credentials.cend(); }
+
+    ss::future<> stop() { return ss::now(); }
+
+private:
+    container_type _credentials;
+};
+
+} // namespace security
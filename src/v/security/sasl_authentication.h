@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "outcome.h"
+#include "seastarx.h"
+#include "vassert.h"
+
+#include <seastar/core/sstring.hh>
+
+#include <memory>
+
+namespace security {
+
+/// \brief a SASL mechanism, run by the server of a connection
+class sasl_mechanism {
+public:
+    sasl_mechanism() = default;
+    sasl_mechanism(const sasl_mechanism&) = delete;
+    sasl_mechanism& operator=(const sasl_mechanism&) = delete;
+    sasl_mechanism(sasl_mechanism&&) = delete;
+    sasl_mechanism& operator=(sasl_mechanism&&) = delete;
+    virtual ~sasl_mechanism() = default;
+
+    virtual bool complete() const = 0;
+    virtual bool failed() const = 0;
+    /// \brief the authenticated user, once complete
+    virtual const ss::sstring& principal() const = 0;
+    /// \brief consumes a message of the client, returns the reply
+    virtual result<bytes> authenticate(bytes_view) = 0;
+};
+
+/*
+ * SASL state of a kafka connection.
+ *
+ *   initial -> handshake -> authenticate -> complete
+ *                                        -> failed
+ *
+ * a connection of a listener without authentication starts complete.
+ */
+class sasl_server final {
+public:
+    enum class sasl_state {
+        initial,
+        handshake,
+        authenticate,
+        complete,
+        failed,
+    };
+
+    explicit sasl_server(sasl_state state) noexcept
+      : _state(state) {}
+
+    sasl_state state() const { return _state; }
+    void set_state(sasl_state state) { _state = state; }
+    bool complete() const { return _state == sasl_state::complete; }
+
+    bool has_mechanism() const { return bool(_mechanism); }
+    sasl_mechanism& mechanism() {
+        vassert(_mechanism, "sasl mechanism is not set");
+        return *_mechanism;
+    }
+    void set_mechanism(std::unique_ptr<sasl_mechanism> m) {
+        _mechanism = std::move(m);
+    }
+
+    const ss::sstring& principal() const { return _principal; }
+    void set_principal(ss::sstring principal) {
+        _principal = std::move(principal);
+    }
+
+private:
+    sasl_state _state;
+    std::unique_ptr<sasl_mechanism> _mechanism;
+    ss::sstring _principal;
+};
+
+} // namespace security
@@ -0,0 +1,378 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "security/scram_algorithm.h"
+
+#include "vassert.h"
+
+#include <fmt/format.h>
+#include <gnutls/crypto.h>
+#include <gnutls/gnutls.h>
+#include <libbase64.h>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace security {
+
+namespace {
+
+gnutls_mac_algorithm_t mac_algorithm(hash_function h) {
+    switch (h) {
+    case hash_function::sha256:
+        return GNUTLS_MAC_SHA256;
+    case hash_function::sha512:
+        return GNUTLS_MAC_SHA512;
+    }
+    __builtin_unreachable();
+}
+
+gnutls_digest_algorithm_t digest_algorithm(hash_function h) {
+    switch (h) {
+    case hash_function::sha256:
+        return GNUTLS_DIG_SHA256;
+    case hash_function::sha512:
+        return GNUTLS_DIG_SHA512;
+    }
+    __builtin_unreachable();
+}
+
+bytes_view to_bytes_view(std::string_view s) {
+    // NOLINTNEXTLINE
+    return {reinterpret_cast<const uint8_t*>(s.data()), s.size()};
+}
+
+std::string_view to_string_view(bytes_view b) {
+    // NOLINTNEXTLINE
+    return {reinterpret_cast<const char*>(b.data()), b.size()};
+}
+
+ss::sstring to_sstring(std::string_view s) {
+    return ss::sstring(s.data(), s.size());
+}
+
+bytes xor_bytes(bytes_view a, bytes_view b) {
+    vassert(a.size() == b.size(), "xor of {} and {} bytes", a.size(), b.size());
+    auto out = ss::uninitialized_string<bytes>(a.size());
+    std::transform(a.begin(), a.end(), b.begin(), out.begin(), std::bit_xor{});
+    return out;
+}
+
+std::vector<std::string_view> split_attributes(std::string_view msg) {
+    std::vector<std::string_view> attrs;
+    while (true) {
+        auto end = msg.find(',');
+        attrs.push_back(msg.substr(0, end));
+        if (end == std::string_view::npos) {
+            return attrs;
+        }
+        msg.remove_prefix(end + 1);
+    }
+}
+
+/// \brief value of attribute `name` in `name=value`
+std::string_view attribute(std::string_view attr, char name) {
+    if (attr.size() < 2 || attr[0] != name || attr[1] != '=') {
+        throw scram_exception(
+          fmt::format("expected attribute {} in scram message", name));
+    }
+    return attr.substr(2);
+}
+
+/// \brief the nonce is printable ascii without commas
+bool valid_nonce(std::string_view nonce) {
+    return !nonce.empty()
+           && std::all_of(nonce.begin(), nonce.end(), [](char c) {
+                  return c >= 0x21 && c <= 0x7e && c != ',';
+              });
+}
+
+/// \brief usernames escape `,` and `=` as `=2C` and `=3D`
+ss::sstring decode_saslname(std::string_view name) {
+    ss::sstring out;
+    out.reserve(name.size());
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (name[i] != '=') {
+            out += name[i];
+            continue;
+        }
+        auto code = name.substr(i + 1, 2);
+        if (code == "2C") {
+            out += ',';
+        } else if (code == "3D") {
+            out += '=';
+        } else {
+            throw scram_exception("invalid escape in scram username");
+        }
+        i += 2;
+    }
+    return out;
+}
+
+} // namespace
+
+size_t digest_size(hash_function h) {
+    return gnutls_hash_get_len(digest_algorithm(h));
+}
+
+bytes hmac(hash_function h, bytes_view key, bytes_view data) {
+    auto out = ss::uninitialized_string<bytes>(digest_size(h));
+    auto ret = gnutls_hmac_fast(
+      mac_algorithm(h),
+      key.data(),
+      key.size(),
+      data.data(),
+      data.size(),
+      out.data());
+    if (ret < 0) {
+        throw scram_exception(
+          fmt::format("hmac failed: {}", gnutls_strerror(ret)));
+    }
+    return out;
+}
+
+bytes hash(hash_function h, bytes_view data) {
+    auto out = ss::uninitialized_string<bytes>(digest_size(h));
+    auto ret = gnutls_hash_fast(
+      digest_algorithm(h), data.data(), data.size(), out.data());
+    if (ret < 0) {
+        throw scram_exception(
+          fmt::format("hash failed: {}", gnutls_strerror(ret)));
+    }
+    return out;
+}
+
+bytes random_bytes(size_t n) {
+    auto out = ss::uninitialized_string<bytes>(n);
+    auto ret = gnutls_rnd(GNUTLS_RND_RANDOM, out.data(), n);
+    if (ret < 0) {
+        throw scram_exception(
+          fmt::format("random generator failed: {}", gnutls_strerror(ret)));
+    }
+    return out;
+}
+
+ss::sstring base64_encode(bytes_view b) {
+    auto out = ss::uninitialized_string((b.size() + 2) / 3 * 4);
+    size_t len = 0;
+    ::base64_encode(to_string_view(b).data(), b.size(), out.data(), &len, 0);
+    out.resize(len);
+    return out;
+}
+
+bytes base64_decode(std::string_view s) {
+    auto out = ss::uninitialized_string<bytes>(s.size() / 4 * 3 + 3);
+    size_t len = 0;
+    // NOLINTNEXTLINE
+    auto dst = reinterpret_cast<char*>(out.data());
+    if (::base64_decode(s.data(), s.size(), dst, &len, 0) != 1) {
+        throw scram_exception("invalid base64 in scram message");
+    }
+    out.resize(len);
+    return out;
+}
+
+bool equal_in_constant_time(bytes_view a, bytes_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+client_first_message::client_first_message(bytes_view data) {
+    auto msg = to_string_view(data);
+    // gs2-header = gs2-cbind-flag "," [ authzid ] ","
+    auto cbind_end = msg.find(',');
+    if (cbind_end == std::string_view::npos) {
+        throw scram_exception("client first message without gs2 header");
+    }
+    auto cbind = msg.substr(0, cbind_end);
+    if (cbind != "n" && cbind != "y") {
+        throw scram_exception("scram channel binding is not supported");
+    }
+    auto authzid_end = msg.find(',', cbind_end + 1);
+    if (authzid_end == std::string_view::npos) {
+        throw scram_exception("client first message without gs2 header");
+    }
+    auto authzid = msg.substr(cbind_end + 1, authzid_end - cbind_end - 1);
+    _gs2_header = to_sstring(msg.substr(0, authzid_end + 1));
+    _bare_message = to_sstring(msg.substr(authzid_end + 1));
+
+    auto attrs = split_attributes(_bare_message);
+    if (attrs.size() < 2) {
+        throw scram_exception("client first message without nonce");
+    }
+    // reserved-mext, a mandatory extension nobody understands yet
+    if (attrs[0].substr(0, 2) == "m=") {
+        throw scram_exception("unsupported mandatory scram extension");
+    }
+    _username = decode_saslname(attribute(attrs[0], 'n'));
+    if (_username.empty()) {
+        throw scram_exception("client first message without username");
+    }
+    if (
+      !authzid.empty()
+      && decode_saslname(attribute(authzid, 'a')) != _username) {
+        throw scram_exception("scram authorization id is not the username");
+    }
+    auto nonce = attribute(attrs[1], 'r');
+    if (!valid_nonce(nonce)) {
+        throw scram_exception("invalid client nonce");
+    }
+    _nonce = to_sstring(nonce);
+    for (size_t i = 2; i < attrs.size(); ++i) {
+        if (attrs[i] == "tokenauth=true") {
+            _token_authenticated = true;
+        }
+    }
+}
+
+server_first_message::server_first_message(
+  ss::sstring nonce, bytes salt, int iterations)
+  : _nonce(std::move(nonce))
+  , _salt(std::move(salt))
+  , _iterations(iterations) {}
+
+ss::sstring server_first_message::sstring() const {
+    return fmt::format(
+      "r={},s={},i={}", _nonce, base64_encode(_salt), _iterations);
+}
+
+client_final_message::client_final_message(bytes_view data) {
+    auto msg = to_string_view(data);
+    auto attrs = split_attributes(msg);
+    if (attrs.size() < 3) {
+        throw scram_exception("incomplete client final message");
+    }
+    _channel_binding = base64_decode(attribute(attrs[0], 'c'));
+    auto nonce = attribute(attrs[1], 'r');
+    if (!valid_nonce(nonce)) {
+        throw scram_exception("invalid nonce in client final message");
+    }
+    _nonce = to_sstring(nonce);
+    // the proof is the last attribute, what comes before it is signed
+    const auto proof = attrs.back();
+    _proof = base64_decode(attribute(proof, 'p'));
+    _msg_no_proof = to_sstring(msg.substr(0, msg.size() - proof.size() - 1));
+}
+
+server_final_message::server_final_message(
+  std::optional<ss::sstring> error, bytes signature)
+  : _error(std::move(error))
+  , _signature(std::move(signature)) {}
+
+ss::sstring server_final_message::sstring() const {
+    if (_error) {
+        return fmt::format("e={}", *_error);
+    }
+    return fmt::format("v={}", base64_encode(_signature));
+}
+
+ss::sstring auth_message(
+  const client_first_message& client_first,
+  const server_first_message& server_first,
+  const client_final_message& client_final) {
+    return fmt::format(
+      "{},{},{}",
+      client_first.bare_message(),
+      server_first.sstring(),
+      client_final.msg_no_proof());
+}
+
+template<typename Traits>
+bytes scram_algorithm<Traits>::salted_password(
+  std::string_view password, bytes_view salt, int iterations) {
+    // Hi(str, salt, i), a single block of PBKDF2 with HMAC as the PRF
+    static constexpr std::array<uint8_t, 4> block_index{0, 0, 0, 1};
+    const auto key = to_bytes_view(password);
+    bytes salted(salt.data(), salt.size());
+    salted.append(block_index.data(), block_index.size());
+    auto u = hmac(Traits::hash, key, salted);
+    bytes result = u;
+    for (int i = 1; i < iterations; ++i) {
+        u = hmac(Traits::hash, key, u);
+        std::transform(
+          result.begin(),
+          result.end(),
+          u.begin(),
+          result.begin(),
+          std::bit_xor{});
+    }
+    return result;
+}
+
+template<typename Traits>
+bytes scram_algorithm<Traits>::client_key(bytes_view salted_password) {
+    return hmac(Traits::hash, salted_password, to_bytes_view("Client Key"));
+}
+
+template<typename Traits>
+bytes scram_algorithm<Traits>::server_key(bytes_view salted_password) {
+    return hmac(Traits::hash, salted_password, to_bytes_view("Server Key"));
+}
+
+template<typename Traits>
+bytes scram_algorithm<Traits>::stored_key(bytes_view client_key) {
+    return hash(Traits::hash, client_key);
+}
+
+template<typename Traits>
+scram_credential scram_algorithm<Traits>::make_credentials(
+  std::string_view password, int iterations) {
+    auto salt = random_bytes(key_size());
+    auto salted = salted_password(password, salt, iterations);
+    return scram_credential(
+      std::move(salt),
+      server_key(salted),
+      stored_key(client_key(salted)),
+      iterations);
+}
+
+template<typename Traits>
+bytes scram_algorithm<Traits>::client_proof(
+  bytes_view salted_password, std::string_view auth_message) {
+    auto key = client_key(salted_password);
+    auto signature = hmac(
+      Traits::hash, stored_key(key), to_bytes_view(auth_message));
+    return xor_bytes(key, signature);
+}
+
+template<typename Traits>
+bool scram_algorithm<Traits>::verify_proof(
+  const scram_credential& credential,
+  std::string_view auth_message,
+  bytes_view client_proof) {
+    if (
+      credential.stored_key().size() != key_size()
+      || client_proof.size() != key_size()) {
+        return false;
+    }
+    auto signature = hmac(
+      Traits::hash, credential.stored_key(), to_bytes_view(auth_message));
+    auto client_key = xor_bytes(client_proof, signature);
+    return equal_in_constant_time(
+      stored_key(client_key), credential.stored_key());
+}
+
+template<typename Traits>
+bytes scram_algorithm<Traits>::server_signature(
+  bytes_view server_key, std::string_view auth_message) {
+    return hmac(Traits::hash, server_key, to_bytes_view(auth_message));
+}
+
+template class scram_algorithm<scram_sha256_traits>;
+template class scram_algorithm<scram_sha512_traits>;
+
+} // namespace security
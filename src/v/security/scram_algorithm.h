@@ -0,0 +1,197 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "seastarx.h"
+#include "security/scram_credential.h"
+
+#include <seastar/core/sstring.hh>
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+/*
+ * SCRAM (RFC 5802) with the hash functions of RFC 7677.
+ *
+ * The salted password of a user is derived with Hi(), which runs thousands of
+ * HMAC rounds on purpose. It is derived once, when the credential of the user
+ * is created, and only the StoredKey and ServerKey derived from it are kept,
+ * see scram_credential. A client proves that it knows the ClientKey, which
+ * the server checks against the StoredKey with a single HMAC and hash:
+ *
+ *   ClientSignature := HMAC(StoredKey, AuthMessage)
+ *   ClientKey       := ClientProof XOR ClientSignature
+ *   StoredKey       =? H(ClientKey)
+ *
+ * so authenticating a connection never derives a key.
+ */
+namespace security {
+
+class scram_exception final : public std::runtime_error {
+public:
+    explicit scram_exception(const std::string& msg)
+      : std::runtime_error(msg) {}
+};
+
+enum class hash_function { sha256, sha512 };
+
+size_t digest_size(hash_function);
+bytes hmac(hash_function, bytes_view key, bytes_view data);
+bytes hash(hash_function, bytes_view data);
+/// \brief bytes of the random generator of the tls library, fit for salts
+/// and nonces
+bytes random_bytes(size_t);
+
+ss::sstring base64_encode(bytes_view);
+/// \brief throws scram_exception on bytes that are not base64
+bytes base64_decode(std::string_view);
+
+/// \brief compares in a time that does not depend on where the bytes differ
+bool equal_in_constant_time(bytes_view, bytes_view);
+
+/*
+ * client-first-message = gs2-header client-first-message-bare
+ * client-first-message-bare = [reserved-mext ","] username "," nonce
+ *                             ["," extensions]
+ *
+ * channel binding is not supported, gs2 headers other than `n` and `y` are
+ * rejected.
+ */
+class client_first_message {
+public:
+    explicit client_first_message(bytes_view);
+
+    const ss::sstring& gs2_header() const { return _gs2_header; }
+    const ss::sstring& username() const { return _username; }
+    const ss::sstring& nonce() const { return _nonce; }
+    const ss::sstring& bare_message() const { return _bare_message; }
+    /// \brief the tokenauth extension of delegation tokens
+    bool token_authenticated() const { return _token_authenticated; }
+
+private:
+    ss::sstring _gs2_header;
+    ss::sstring _username;
+    ss::sstring _nonce;
+    ss::sstring _bare_message;
+    bool _token_authenticated{false};
+};
+
+// server-first-message = [reserved-mext ","] nonce "," salt ","
+//                        iteration-count ["," extensions]
+class server_first_message {
+public:
+    server_first_message(ss::sstring nonce, bytes salt, int iterations);
+
+    const ss::sstring& nonce() const { return _nonce; }
+    const bytes& salt() const { return _salt; }
+    int iterations() const { return _iterations; }
+    ss::sstring sstring() const;
+
+private:
+    ss::sstring _nonce;
+    bytes _salt;
+    int _iterations;
+};
+
+// client-final-message = client-final-message-without-proof "," proof
+// client-final-message-without-proof = channel-binding "," nonce
+//                                      ["," extensions]
+class client_final_message {
+public:
+    explicit client_final_message(bytes_view);
+
+    const bytes& channel_binding() const { return _channel_binding; }
+    const ss::sstring& nonce() const { return _nonce; }
+    const bytes& proof() const { return _proof; }
+    const ss::sstring& msg_no_proof() const { return _msg_no_proof; }
+
+private:
+    bytes _channel_binding;
+    ss::sstring _nonce;
+    bytes _proof;
+    ss::sstring _msg_no_proof;
+};
+
+// server-final-message = (server-error / verifier) ["," extensions]
+class server_final_message {
+public:
+    server_final_message(std::optional<ss::sstring> error, bytes signature);
+
+    const std::optional<ss::sstring>& error() const { return _error; }
+    const bytes& signature() const { return _signature; }
+    ss::sstring sstring() const;
+
+private:
+    std::optional<ss::sstring> _error;
+    bytes _signature;
+};
+
+/// \brief the message both sides sign, see RFC 5802 section 3
+ss::sstring auth_message(
+  const client_first_message&,
+  const server_first_message&,
+  const client_final_message&);
+
+struct scram_sha256_traits {
+    static constexpr hash_function hash = hash_function::sha256;
+    static constexpr const char* name = "SCRAM-SHA-256";
+    static constexpr int min_iterations = 4096;
+};
+
+struct scram_sha512_traits {
+    static constexpr hash_function hash = hash_function::sha512;
+    static constexpr const char* name = "SCRAM-SHA-512";
+    static constexpr int min_iterations = 4096;
+};
+
+template<typename Traits>
+class scram_algorithm {
+public:
+    static constexpr const char* name = Traits::name;
+    static constexpr int min_iterations = Traits::min_iterations;
+    static size_t key_size() { return digest_size(Traits::hash); }
+
+    /// \brief Hi(), the expensive part, once per credential
+    static bytes
+    salted_password(std::string_view password, bytes_view salt, int iterations);
+
+    static bytes client_key(bytes_view salted_password);
+    static bytes server_key(bytes_view salted_password);
+    static bytes stored_key(bytes_view client_key);
+
+    /// \brief derives the credential of a password with a random salt
+    static scram_credential
+    make_credentials(std::string_view password, int iterations);
+
+    /// \brief proof the client sends, only clients know the password
+    static bytes
+    client_proof(bytes_view salted_password, std::string_view auth_message);
+
+    /// \brief checks the proof of a client against the stored key
+    static bool verify_proof(
+      const scram_credential&,
+      std::string_view auth_message,
+      bytes_view client_proof);
+
+    static bytes
+    server_signature(bytes_view server_key, std::string_view auth_message);
+};
+
+using scram_sha256 = scram_algorithm<scram_sha256_traits>;
+using scram_sha512 = scram_algorithm<scram_sha512_traits>;
+
+extern template class scram_algorithm<scram_sha256_traits>;
+extern template class scram_algorithm<scram_sha512_traits>;
+
+} // namespace security
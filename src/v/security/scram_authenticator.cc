@@ -0,0 +1,116 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "security/scram_authenticator.h"
+
+#include "security/errc.h"
+#include "security/logger.h"
+#include "vlog.h"
+
+#include <fmt/format.h>
+
+namespace security {
+
+namespace {
+bytes to_bytes(const ss::sstring& s) {
+    // NOLINTNEXTLINE
+    return bytes(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+}
+} // namespace
+
+template<typename T>
+result<bytes> scram_authenticator<T>::authenticate(bytes_view message) {
+    try {
+        switch (_state) {
+        case state::client_first_message:
+            return handle_client_first(message);
+        case state::client_final_message:
+            return handle_client_final(message);
+        case state::complete:
+        case state::failed:
+            break;
+        }
+        _state = state::failed;
+        return errc::invalid_scram_state;
+    } catch (const scram_exception& e) {
+        vlog(
+          seclog.info, "{} authentication failed: {}", scram::name, e.what());
+        _state = state::failed;
+        return errc::invalid_scram_message;
+    }
+}
+
+template<typename T>
+result<bytes> scram_authenticator<T>::handle_client_first(bytes_view message) {
+    _client_first = std::make_unique<client_first_message>(message);
+    vlog(
+      seclog.debug,
+      "{} client first message of user {}",
+      scram::name,
+      _client_first->username());
+
+    // delegation tokens are not supported
+    if (_client_first->token_authenticated()) {
+        _state = state::failed;
+        return errc::invalid_credentials;
+    }
+
+    _credential = _credentials.get(
+      credential_user(_client_first->username()));
+    // a credential derived for the other hash function has keys of another
+    // size, it does not verify any proof of this mechanism
+    if (
+      !_credential || _credential->stored_key().size() != scram::key_size()
+      || _credential->iterations() < scram::min_iterations) {
+        _state = state::failed;
+        return errc::invalid_credentials;
+    }
+
+    auto nonce = fmt::format(
+      "{}{}",
+      _client_first->nonce(),
+      base64_encode(random_bytes(scram::key_size())));
+    _server_first = std::make_unique<server_first_message>(
+      std::move(nonce), _credential->salt(), _credential->iterations());
+    _state = state::client_final_message;
+    return to_bytes(_server_first->sstring());
+}
+
+template<typename T>
+result<bytes> scram_authenticator<T>::handle_client_final(bytes_view message) {
+    client_final_message client_final(message);
+    _state = state::failed;
+    if (client_final.nonce() != _server_first->nonce()) {
+        return errc::invalid_credentials;
+    }
+    // without channel binding the client echoes its gs2 header
+    if (
+      client_final.channel_binding() != to_bytes(_client_first->gs2_header())) {
+        return errc::invalid_credentials;
+    }
+    auto auth = auth_message(*_client_first, *_server_first, client_final);
+    if (!scram::verify_proof(*_credential, auth, client_final.proof())) {
+        vlog(
+          seclog.info,
+          "{} authentication of user {} failed",
+          scram::name,
+          _client_first->username());
+        return errc::invalid_credentials;
+    }
+    server_final_message server_final(
+      std::nullopt, scram::server_signature(_credential->server_key(), auth));
+    _principal = _client_first->username();
+    _state = state::complete;
+    return to_bytes(server_final.sstring());
+}
+
+template class scram_authenticator<scram_sha256>;
+template class scram_authenticator<scram_sha512>;
+
+} // namespace security
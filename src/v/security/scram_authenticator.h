@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "security/credential_store.h"
+#include "security/sasl_authentication.h"
+#include "security/scram_algorithm.h"
+
+#include <memory>
+#include <optional>
+
+namespace security {
+
+/**
+ * Server side of a SCRAM exchange, two round trips:
+ *
+ *   client-first-message -> server-first-message
+ *   client-final-message -> server-final-message
+ *
+ * The credential of the user is looked up in the store of the core of the
+ * connection, verifying the proof costs a HMAC and a hash.
+ */
+template<typename T>
+class scram_authenticator final : public sasl_mechanism {
+public:
+    using scram = T;
+
+    explicit scram_authenticator(const credential_store& credentials)
+      : _credentials(credentials) {}
+
+    result<bytes> authenticate(bytes_view) override;
+    bool complete() const override { return _state == state::complete; }
+    bool failed() const override { return _state == state::failed; }
+    const ss::sstring& principal() const override { return _principal; }
+
+private:
+    enum class state {
+        client_first_message,
+        client_final_message,
+        complete,
+        failed,
+    };
+
+    result<bytes> handle_client_first(bytes_view);
+    result<bytes> handle_client_final(bytes_view);
+
+    state _state{state::client_first_message};
+    const credential_store& _credentials;
+    std::optional<scram_credential> _credential;
+    ss::sstring _principal;
+    std::unique_ptr<client_first_message> _client_first;
+    std::unique_ptr<server_first_message> _server_first;
+};
+
+using scram_sha256_authenticator = scram_authenticator<scram_sha256>;
+using scram_sha512_authenticator = scram_authenticator<scram_sha512>;
+
+extern template class scram_authenticator<scram_sha256>;
+extern template class scram_authenticator<scram_sha512>;
+
+} // namespace security
@@ -0,0 +1,50 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "security/scram_credential.h"
+
+#include "bytes/iobuf_parser.h"
+
+#include <fmt/ostream.h>
+
+namespace security {
+
+std::ostream& operator<<(std::ostream& os, const scram_credential& c) {
+    fmt::print(os, "{{iterations: {}}}", c._iterations);
+    return os;
+}
+
+} // namespace security
+
+namespace reflection {
+
+void adl<security::scram_credential>::to(
+  iobuf& out, security::scram_credential c) {
+    reflection::serialize(
+      out,
+      bytes_to_iobuf(c.salt()),
+      bytes_to_iobuf(c.server_key()),
+      bytes_to_iobuf(c.stored_key()),
+      c.iterations());
+}
+
+security::scram_credential
+adl<security::scram_credential>::from(iobuf_parser& in) {
+    auto salt = iobuf_to_bytes(adl<iobuf>{}.from(in));
+    auto server_key = iobuf_to_bytes(adl<iobuf>{}.from(in));
+    auto stored_key = iobuf_to_bytes(adl<iobuf>{}.from(in));
+    auto iterations = adl<int>{}.from(in);
+    return security::scram_credential(
+      std::move(salt),
+      std::move(server_key),
+      std::move(stored_key),
+      iterations);
+}
+
+} // namespace reflection
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "reflection/adl.h"
+#include "seastarx.h"
+#include "utils/named_type.h"
+
+#include <seastar/core/sstring.hh>
+
+#include <iosfwd>
+
+namespace security {
+
+using credential_user = named_type<ss::sstring, struct credential_user_type>;
+
+/**
+ * What the server knows of the password of a user. The salted password is
+ * not kept, a client proof is verified with the stored key and the server
+ * proves it knows the password with the server key.
+ */
+class scram_credential {
+public:
+    scram_credential() noexcept = default;
+    scram_credential(
+      bytes salt, bytes server_key, bytes stored_key, int iterations) noexcept
+      : _salt(std::move(salt))
+      , _server_key(std::move(server_key))
+      , _stored_key(std::move(stored_key))
+      , _iterations(iterations) {}
+
+    const bytes& salt() const { return _salt; }
+    const bytes& server_key() const { return _server_key; }
+    const bytes& stored_key() const { return _stored_key; }
+    int iterations() const { return _iterations; }
+
+    bool operator==(const scram_credential& o) const {
+        return _salt == o._salt && _server_key == o._server_key
+               && _stored_key == o._stored_key && _iterations == o._iterations;
+    }
+
+private:
+    // prints the iterations only, the keys stand in for the password
+    friend std::ostream& operator<<(std::ostream&, const scram_credential&);
+
+    bytes _salt;
+    bytes _server_key;
+    bytes _stored_key;
+    int _iterations{0};
+};
+
+} // namespace security
+
+namespace reflection {
+
+template<>
+struct adl<security::scram_credential> {
+    void to(iobuf&, security::scram_credential);
+    security::scram_credential from(iobuf_parser&);
+};
+
+} // namespace reflection
@@ -0,0 +1,155 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE security
+#include "bytes/iobuf_parser.h"
+#include "security/credential_store.h"
+#include "security/errc.h"
+#include "security/scram_algorithm.h"
+#include "security/scram_authenticator.h"
+
+#include <boost/test/unit_test.hpp>
+#include <fmt/format.h>
+
+#include <string_view>
+
+using namespace security; // NOLINT
+
+namespace {
+bytes to_bytes(std::string_view s) {
+    // NOLINTNEXTLINE
+    return bytes(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+}
+
+std::string_view to_string_view(const bytes& b) {
+    // NOLINTNEXTLINE
+    return {reinterpret_cast<const char*>(b.data()), b.size()};
+}
+
+// RFC 7677 section 3
+constexpr std::string_view rfc_password = "pencil";
+constexpr std::string_view rfc_salt = "W22ZaJ0SNY7soEsUEjb6gQ==";
+constexpr std::string_view rfc_client_first
+  = "n,,n=user,r=rOprNGfwEbeRWgbNEkqO";
+constexpr std::string_view rfc_nonce
+  = "rOprNGfwEbeRWgbNEkqO%hvYDpWUa2RaTCAfuxFIlj)hNlF$k0";
+constexpr std::string_view rfc_client_final
+  = "c=biws,r=rOprNGfwEbeRWgbNEkqO%hvYDpWUa2RaTCAfuxFIlj)hNlF$k0,"
+    "p=dHzbZapWIk4jUhN+Ute9ytag9zjfMHgsqmmiz7AndVQ=";
+constexpr std::string_view rfc_server_signature
+  = "6rriTRBi23WpRR/wtup+mMhUZUn/dB5nLTJRsjl95G4=";
+
+// the client side of the exchange, against whatever nonce the server picks
+template<typename Scram>
+result<bytes> run_client(
+  sasl_mechanism& server,
+  std::string_view user,
+  std::string_view password,
+  const bytes& salt,
+  int iterations) {
+    const auto bare = fmt::format("n={},r=fyko+d2lbbFgONRv9qkxdawL", user);
+    auto server_first = server.authenticate(to_bytes("n,," + bare));
+    if (!server_first) {
+        return server_first.error();
+    }
+    auto first = to_string_view(server_first.value());
+    auto nonce = first.substr(2, first.find(',') - 2);
+    const auto no_proof = fmt::format("c=biws,r={}", nonce);
+    const auto auth = fmt::format("{},{},{}", bare, first, no_proof);
+    auto proof = Scram::client_proof(
+      Scram::salted_password(password, salt, iterations), auth);
+    return server.authenticate(
+      to_bytes(fmt::format("{},p={}", no_proof, base64_encode(proof))));
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(rfc7677_test_vector) {
+    const auto salt = base64_decode(rfc_salt);
+    auto salted = scram_sha256::salted_password(rfc_password, salt, 4096);
+    auto credential = scram_credential(
+      salt,
+      scram_sha256::server_key(salted),
+      scram_sha256::stored_key(scram_sha256::client_key(salted)),
+      4096);
+
+    client_first_message client_first(to_bytes(rfc_client_first));
+    BOOST_CHECK_EQUAL(client_first.username(), "user");
+    BOOST_CHECK_EQUAL(client_first.gs2_header(), "n,,");
+    server_first_message server_first(ss::sstring(rfc_nonce), salt, 4096);
+    client_final_message client_final(to_bytes(rfc_client_final));
+    BOOST_CHECK_EQUAL(client_final.nonce(), rfc_nonce);
+
+    auto auth = auth_message(client_first, server_first, client_final);
+    BOOST_CHECK(
+      scram_sha256::client_proof(salted, auth) == client_final.proof());
+    BOOST_CHECK(
+      scram_sha256::verify_proof(credential, auth, client_final.proof()));
+    auto signature = scram_sha256::server_signature(
+      credential.server_key(), auth);
+    BOOST_CHECK_EQUAL(base64_encode(signature), rfc_server_signature);
+
+    auto bad_proof = client_final.proof();
+    bad_proof[0] ^= 1;
+    BOOST_CHECK(!scram_sha256::verify_proof(credential, auth, bad_proof));
+}
+
+BOOST_AUTO_TEST_CASE(authenticates_without_deriving_keys) {
+    credential_store store;
+    auto credential = scram_sha512::make_credentials("secret", 4096);
+    store.put(credential_user("alice"), credential);
+
+    scram_sha512_authenticator server(store);
+    auto reply = run_client<scram_sha512>(
+      server, "alice", "secret", credential.salt(), 4096);
+    BOOST_REQUIRE(reply.has_value());
+    BOOST_CHECK(server.complete());
+    BOOST_CHECK_EQUAL(server.principal(), "alice");
+    BOOST_CHECK(to_string_view(reply.value()).substr(0, 2) == "v=");
+
+    // a completed exchange takes no further message
+    BOOST_CHECK(!server.authenticate(to_bytes("n,,n=alice,r=abc")));
+}
+
+BOOST_AUTO_TEST_CASE(rejects_invalid_credentials) {
+    credential_store store;
+    auto credential = scram_sha256::make_credentials("secret", 4096);
+    store.put(credential_user("alice"), credential);
+
+    scram_sha256_authenticator wrong_password(store);
+    auto reply = run_client<scram_sha256>(
+      wrong_password, "alice", "guess", credential.salt(), 4096);
+    BOOST_CHECK(reply.error() == errc::invalid_credentials);
+    BOOST_CHECK(wrong_password.failed());
+
+    scram_sha256_authenticator unknown_user(store);
+    reply = run_client<scram_sha256>(
+      unknown_user, "bob", "secret", credential.salt(), 4096);
+    BOOST_CHECK(reply.error() == errc::invalid_credentials);
+
+    // the keys of a sha256 credential do not verify sha512 proofs
+    scram_sha512_authenticator other_mechanism(store);
+    reply = run_client<scram_sha512>(
+      other_mechanism, "alice", "secret", credential.salt(), 4096);
+    BOOST_CHECK(reply.error() == errc::invalid_credentials);
+
+    scram_sha256_authenticator malformed(store);
+    BOOST_CHECK(
+      malformed.authenticate(to_bytes("p=tls,,n=alice,r=abc")).error()
+      == errc::invalid_scram_message);
+}
+
+BOOST_AUTO_TEST_CASE(credential_serde) {
+    auto credential = scram_sha256::make_credentials("secret", 8192);
+    iobuf buf;
+    reflection::adl<scram_credential>{}.to(buf, credential);
+    iobuf_parser parser(std::move(buf));
+    auto decoded = reflection::adl<scram_credential>{}.from(parser);
+    BOOST_CHECK(decoded == credential);
+    BOOST_CHECK_EQUAL(decoded.iterations(), 8192);
+}
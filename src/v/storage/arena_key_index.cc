@@ -0,0 +1,159 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/arena_key_index.h"
+
+#include "hashing/xx.h"
+#include "vassert.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace storage::internal {
+
+uint64_t arena_key_index::hash(bytes_view k) {
+    // NOLINTNEXTLINE
+    return xxhash_64(reinterpret_cast<const char*>(k.data()), k.size());
+}
+
+uint32_t arena_key_index::fingerprint(uint64_t h) {
+    // the low bits pick the slot, so use the high ones for the fingerprint
+    const auto fp = static_cast<uint32_t>(h >> 32U);
+    return fp > tombstone ? fp : tombstone + 1;
+}
+
+size_t arena_key_index::probe(bytes_view k, uint64_t h) const {
+    const size_t mask = _slots.size() - 1;
+    const uint32_t fp = fingerprint(h);
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const auto& s = _slots[i];
+        if (s.fingerprint == empty) {
+            return i;
+        }
+        if (
+          s.fingerprint == fp && s.key_size == k.size()
+          && key_at(i) == k) {
+            return i;
+        }
+    }
+}
+
+size_t arena_key_index::find(bytes_view k) const {
+    if (_size == 0) {
+        return npos;
+    }
+    const auto i = probe(k, hash(k));
+    return _slots[i].fingerprint == empty ? npos : i;
+}
+
+bytes_view arena_key_index::key_in(const arena_t& arena, const slot& s) {
+    const auto& chunk = arena[s.key_pos / arena_chunk_size];
+    return bytes_view(chunk.get() + s.key_pos % arena_chunk_size, s.key_size);
+}
+
+bytes_view arena_key_index::key_at(size_t i) const {
+    return key_in(_arena, _slots[i]);
+}
+
+size_t arena_key_index::memory_usage_after_insert(size_t key_size) const {
+    size_t slots = _slots.capacity();
+    if (needs_grow()) {
+        slots = std::max(initial_capacity, slots * 2);
+    }
+    size_t chunks = _arena.size();
+    if (needs_chunk(key_size)) {
+        ++chunks;
+    }
+    return slots * sizeof(slot) + chunks * arena_chunk_size;
+}
+
+void arena_key_index::insert(bytes_view k, value_type v) {
+    vassert(
+      k.size() <= arena_chunk_size,
+      "key of {} bytes does not fit in an arena chunk",
+      k.size());
+    if (needs_grow()) {
+        rehash(std::max(initial_capacity, _slots.size() * 2));
+    }
+    slot s;
+    s.key_size = static_cast<uint32_t>(k.size());
+    s.key_pos = append_key(k);
+    s.base_offset = v.base_offset;
+    s.delta = v.delta;
+    place(k, s);
+    ++_size;
+}
+
+void arena_key_index::place(bytes_view k, slot s) {
+    const auto h = hash(k);
+    s.fingerprint = fingerprint(h);
+    // new entries never reuse tombstones. that keeps erase_at() cheap and the
+    // table is rebuilt by compact() anyway after evictions
+    auto i = probe(k, h);
+    vassert(
+      _slots[i].fingerprint == empty, "key is already in the arena_key_index");
+    _slots[i] = s;
+}
+
+uint32_t arena_key_index::append_key(bytes_view k) {
+    if (needs_chunk(k.size())) {
+        _arena.emplace_back(arena_chunk_size);
+        _arena_tail = 0;
+    }
+    const size_t pos = (_arena.size() - 1) * arena_chunk_size + _arena_tail;
+    vassert(
+      pos + k.size() <= std::numeric_limits<uint32_t>::max(),
+      "arena_key_index arena is full: {} chunks",
+      _arena.size());
+    std::copy(k.begin(), k.end(), _arena.back().get_write() + _arena_tail);
+    _arena_tail += k.size();
+    return static_cast<uint32_t>(pos);
+}
+
+void arena_key_index::rehash(size_t capacity) {
+    auto old = std::exchange(_slots, std::vector<slot>(capacity));
+    _tombstones = 0;
+    for (auto& s : old) {
+        if (s.fingerprint > tombstone) {
+            place(key_in(_arena, s), s);
+        }
+    }
+}
+
+void arena_key_index::erase_at(size_t i) {
+    vassert(is_live(i), "erasing an empty arena_key_index slot: {}", i);
+    _slots[i].fingerprint = tombstone;
+    --_size;
+    ++_tombstones;
+}
+
+void arena_key_index::compact() {
+    auto old_slots = std::exchange(
+      _slots, std::vector<slot>(std::max(initial_capacity, _slots.size())));
+    auto old_arena = std::exchange(_arena, {});
+    _arena_tail = 0;
+    _tombstones = 0;
+    for (auto& s : old_slots) {
+        if (s.fingerprint > tombstone) {
+            const auto k = key_in(old_arena, s);
+            s.key_pos = append_key(k);
+            place(k, s);
+        }
+    }
+}
+
+void arena_key_index::clear() {
+    _slots = {};
+    _arena = {};
+    _arena_tail = 0;
+    _size = 0;
+    _tombstones = 0;
+}
+
+} // namespace storage::internal
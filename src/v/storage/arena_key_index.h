@@ -0,0 +1,140 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "units.h"
+
+#include <seastar/core/temporary_buffer.hh>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace storage::internal {
+
+/**
+ * Open addressing map from key to the latest {base_offset, delta} seen for
+ * it, built for the spill_key_index.
+ *
+ * Slots are 24 bytes and hold a 32-bit fingerprint of the key hash, the
+ * value and the position of the key in an append-only arena of fixed size
+ * chunks. Lookups use linear probing and only touch the arena when the
+ * fingerprints match. Compared to a node based map there is no per-key
+ * allocation and no node header, so the same memory budget holds several
+ * times more small keys.
+ *
+ * Keys are never removed from the arena. erase_at() leaves a tombstone and
+ * compact() rebuilds the table and arena from the live entries.
+ */
+class arena_key_index {
+public:
+    struct value_type {
+        model::offset base_offset;
+        int32_t delta{0};
+    };
+    static constexpr size_t arena_chunk_size = 64_KiB;
+    static constexpr size_t initial_capacity = 16;
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    arena_key_index() = default;
+    arena_key_index(const arena_key_index&) = delete;
+    arena_key_index& operator=(const arena_key_index&) = delete;
+    arena_key_index(arena_key_index&& o) noexcept
+      : _slots(std::move(o._slots))
+      , _arena(std::move(o._arena))
+      , _arena_tail(std::exchange(o._arena_tail, 0))
+      , _size(std::exchange(o._size, 0))
+      , _tombstones(std::exchange(o._tombstones, 0)) {}
+    arena_key_index& operator=(arena_key_index&& o) noexcept {
+        if (this != &o) {
+            this->~arena_key_index();
+            new (this) arena_key_index(std::move(o));
+        }
+        return *this;
+    }
+    ~arena_key_index() noexcept = default;
+
+    /// returns the slot of the key or npos if the key is not indexed
+    size_t find(bytes_view) const;
+    /// key must not be indexed and must fit in an arena chunk
+    void insert(bytes_view, value_type);
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    /// bytes held by the slot array and the arena
+    size_t memory_usage() const {
+        return _slots.capacity() * sizeof(slot)
+               + _arena.size() * arena_chunk_size;
+    }
+    /// memory_usage() after inserting a key of `key_size` bytes
+    size_t memory_usage_after_insert(size_t key_size) const;
+
+    /// slot level access used to drain the index
+    size_t capacity() const { return _slots.size(); }
+    bool is_live(size_t i) const { return _slots[i].fingerprint > tombstone; }
+    bytes_view key_at(size_t i) const;
+    value_type value_at(size_t i) const {
+        return value_type{_slots[i].base_offset, _slots[i].delta};
+    }
+    void set_value_at(size_t i, value_type v) {
+        _slots[i].base_offset = v.base_offset;
+        _slots[i].delta = v.delta;
+    }
+    /// keys stay valid until the next compact(), insert() or clear()
+    void erase_at(size_t i);
+
+    /// drops tombstones and the arena space of erased keys
+    void compact();
+    void clear();
+
+private:
+    struct slot {
+        uint32_t fingerprint{empty};
+        uint32_t key_size{0};
+        uint32_t key_pos{0};
+        int32_t delta{0};
+        model::offset base_offset;
+    };
+    static_assert(sizeof(slot) == 24, "slot layout changed");
+
+    // fingerprints of live slots are always > tombstone
+    static constexpr uint32_t empty = 0;
+    static constexpr uint32_t tombstone = 1;
+
+    using arena_t = std::vector<ss::temporary_buffer<uint8_t>>;
+
+    static uint64_t hash(bytes_view);
+    static bytes_view key_in(const arena_t&, const slot&);
+    static uint32_t fingerprint(uint64_t h);
+    bool needs_grow() const {
+        // max load factor of 7/8, tombstones included
+        return (_size + _tombstones + 1) * 8 > _slots.size() * 7;
+    }
+    bool needs_chunk(size_t key_size) const {
+        return _arena.empty() || _arena_tail + key_size > arena_chunk_size;
+    }
+    size_t probe(bytes_view, uint64_t h) const;
+    void rehash(size_t capacity);
+    uint32_t append_key(bytes_view);
+    void place(bytes_view, slot);
+
+    std::vector<slot> _slots;
+    arena_t _arena;
+    size_t _arena_tail{0};
+    size_t _size{0};
+    size_t _tombstones{0};
+};
+
+} // namespace storage::internal
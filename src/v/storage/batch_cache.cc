@@ -9,35 +9,83 @@
 
 #include "batch_cache.h"
 
+#include "storage/hugepage_arena.h"
 #include "vassert.h"
 
 namespace storage {
 
-batch_cache::entry_ptr
-batch_cache::put(batch_cache_index& index, const model::record_batch& input) {
+/// copies the records into the hugepage arena while it has room
+static model::record_batch copy_batch(const model::record_batch& b) {
+    auto& arena = internal::hugepages();
+    if (!arena.enabled()) {
+        return b.copy();
+    }
+    return model::record_batch(
+      b.header().copy(),
+      arena.copy(b.data()),
+      model::record_batch::tag_ctor_ng{});
+}
+
+batch_cache::entry_ptr batch_cache::put(
+  batch_cache_index& index,
+  const model::record_batch& input,
+  cache_priority priority) {
 #ifdef SEASTAR_DEFAULT_ALLOCATOR
     static const size_t threshold = ss::memory::stats().total_memory() * .2;
     while (_size_bytes > threshold) {
         reclaim(1);
     }
 #endif
+    trim();
     // we must copy memory to prevent holding onto bigger memory from
     // temporary buffers
-    auto batch = input.copy();
+    auto batch = copy_batch(input);
     _size_bytes += batch.memory_usage();
     auto e = new entry(index, std::move(batch));
 
     // if weak_from_this were to cause an allocation--which it shouldn't--`e`
     // wouldn't be visible to the reclaimer since it isn't on a lru/pool list.
     auto p = e->weak_from_this();
-    _lru.push_back(*e);
+    if (priority == cache_priority::low) {
+        _probation.push_front(*e);
+    } else {
+        _probation.push_back(*e);
+    }
     return p;
 }
 
+void batch_cache::touch(entry_ptr& e) {
+    if (e) {
+        auto p = e.get();
+        p->_hook.unlink();
+        if (!p->_is_protected) {
+            p->_is_protected = true;
+            _protected_bytes += p->memory_usage();
+            ++_stats.promotions;
+        }
+        _protected.push_back(*p);
+        maybe_demote();
+    }
+}
+
+void batch_cache::maybe_demote() {
+    const auto max_bytes = (_size_bytes * max_protected_percent) / 100;
+    // intrusive list size() is O(N). always keep the most recent entry.
+    while (_protected_bytes > max_bytes
+           && &_protected.front() != &_protected.back()) {
+        auto& e = _protected.front();
+        e._hook.unlink();
+        e._is_protected = false;
+        _protected_bytes -= e.memory_usage();
+        _probation.push_back(e);
+        ++_stats.demotions;
+    }
+}
+
 batch_cache::~batch_cache() noexcept {
     clear();
     vassert(
-      _size_bytes == 0 && _lru.empty(),
+      _size_bytes == 0 && _protected_bytes == 0 && empty(),
       "Detected incorrect batch_cache accounting. {}",
       *this);
 }
@@ -48,9 +96,32 @@ void batch_cache::evict(entry_ptr&& e) {
         // invalidates the caller's entry_ptr. simply interacting with the
         // r-value reference `e` wouldn't do that.
         auto p = std::exchange(e, {});
-        _size_bytes -= p->_batch.memory_usage();
-        _lru.erase_and_dispose(
-          _lru.iterator_to(*p), [](entry* e) { delete e; });
+        _size_bytes -= p->memory_usage();
+        if (p->_is_protected) {
+            _protected_bytes -= p->memory_usage();
+        }
+        auto& lru = lru_of(*p);
+        lru.erase_and_dispose(lru.iterator_to(*p), [](entry* e) { delete e; });
+    }
+}
+
+void batch_cache::put_decompressed(
+  entry_ptr& e, const model::record_batch& decompressed) {
+    if (!e || e->_decompressed) {
+        return;
+    }
+    // copy to release references to the decompression buffers. the copy may
+    // trigger a reclaim which invalidates the entry
+    auto batch = copy_batch(decompressed);
+    if (!e || !e->valid()) {
+        return;
+    }
+    const auto bytes = batch.memory_usage();
+    e->_decompressed = std::move(batch);
+    _size_bytes += bytes;
+    if (e->_is_protected) {
+        _protected_bytes += bytes;
+        maybe_demote();
     }
 }
 
@@ -58,7 +129,6 @@ size_t batch_cache::reclaim(size_t size) {
     if (is_memory_reclaiming()) {
         return 0;
     }
-    batch_reclaiming_lock lock(*this);
 
     /*
      * if the time since the last reclaim is < `reclaim_growth_window` --
@@ -77,6 +147,14 @@ size_t batch_cache::reclaim(size_t size) {
     _reclaim_size = std::min(_reclaim_size, _reclaim_opts.max_size);
     _reclaim_size = std::max(size, _reclaim_size);
 
+    const size_t reclaimed = release(_reclaim_size);
+    _last_reclaim = ss::lowres_clock::now();
+    return reclaimed;
+}
+
+size_t batch_cache::release(size_t size) {
+    batch_reclaiming_lock lock(*this);
+
     /*
      * reclaiming is a two pass process. given that the entry isn't pinned (in
      * which case it is skipped), the first step is to reclaim the batch's
@@ -85,42 +163,15 @@ size_t batch_cache::reclaim(size_t size) {
      * otherwise if the index is locked, removal is deferred but the entry is
      * invalidated. invalidation is important because the batch reference in the
      * index still exists even though the batch data was removed.
+     *
+     * the probation segment is drained first so that read-once batches are
+     * released before any batch that has been hit since it was inserted.
      */
     size_t reclaimed = 0;
-    intrusive_list<entry, &entry::_hook> reclaimed_entries;
+    lru_list reclaimed_entries;
 
-    for (auto it = _lru.begin(); it != _lru.end();) {
-        if (reclaimed >= _reclaim_size) {
-            break;
-        }
-
-        // skip any entry that has a live reference.
-        if (unlikely(it->pinned())) {
-            ++it;
-            continue;
-        }
-
-        // reclaim the batch's record data
-        reclaimed += it->_batch.memory_usage();
-        it->_batch.clear_data();
-
-        /*
-         * if the owning index is locked invalidate the entry but leave it on
-         * the lru list for deferred deletion so as to not invalidate any open
-         * iterators on the index.
-         */
-        if (unlikely(it->_index.locked())) {
-            reclaimed -= it->_batch.memory_usage();
-            it->invalidate();
-            ++it;
-            continue;
-        }
-
-        // collect the entries that will be fully removed
-        it = _lru.erase_and_dispose(it, [&reclaimed_entries](entry* e) {
-            reclaimed_entries.push_back(*e);
-        });
-    }
+    reclaim_from(_probation, size, reclaimed, reclaimed_entries);
+    reclaim_from(_protected, size, reclaimed, reclaimed_entries);
 
     /*
      * final removal from the index is deferred because there is some chance
@@ -143,11 +194,86 @@ size_t batch_cache::reclaim(size_t size) {
         index->remove(offset);
     });
 
-    _last_reclaim = ss::lowres_clock::now();
     _size_bytes -= reclaimed;
     return reclaimed;
 }
 
+void batch_cache::trim() {
+    const auto limit = std::min(_target_bytes, _capacity);
+    if (_size_bytes > limit && !is_memory_reclaiming()) {
+        release(_size_bytes - limit);
+    }
+}
+
+void batch_cache::update_target(const memory_signals& s) {
+    if (_reclaim_opts.max_target == 0) {
+        return;
+    }
+    const bool pressure = s.reclaims > _signals.reclaims
+                          || s.allocation_failures
+                               > _signals.allocation_failures
+                          || s.free_memory
+                               < s.total_memory * low_free_percent / 100;
+    const size_t high_free = s.total_memory * high_free_percent / 100;
+    if (pressure || s.write_waiters) {
+        // back off from what is cached so that the cut takes effect even if
+        // the target was far above the size of the cache
+        _target_bytes = std::max(
+          _reclaim_opts.min_target,
+          std::min(_target_bytes, _size_bytes) / 4 * 3);
+    } else if (s.free_memory > high_free) {
+        _target_bytes = std::min(
+          _reclaim_opts.max_target,
+          _target_bytes + (s.free_memory - high_free) / 2);
+    }
+    _signals = s;
+    trim();
+}
+
+void batch_cache::reclaim_from(
+  lru_list& lru, size_t target, size_t& reclaimed, lru_list& removed) {
+    for (auto it = lru.begin(); it != lru.end();) {
+        if (reclaimed >= target) {
+            break;
+        }
+
+        // skip any entry that has a live reference.
+        if (unlikely(it->pinned())) {
+            ++it;
+            continue;
+        }
+
+        // reclaim the batch's record data
+        auto released = it->memory_usage();
+        it->_batch.clear_data();
+        it->_decompressed.reset();
+        const bool locked = it->_index.locked();
+        if (unlikely(locked)) {
+            released -= it->memory_usage();
+        }
+        reclaimed += released;
+        if (it->_is_protected) {
+            _protected_bytes -= released;
+        }
+
+        /*
+         * if the owning index is locked invalidate the entry but leave it on
+         * the lru list for deferred deletion so as to not invalidate any open
+         * iterators on the index.
+         */
+        if (unlikely(locked)) {
+            it->invalidate();
+            ++it;
+            continue;
+        }
+
+        // collect the entries that will be fully removed
+        ++_stats.evictions;
+        it = lru.erase_and_dispose(
+          it, [&removed](entry* e) { removed.push_back(*e); });
+    }
+}
+
 std::optional<model::record_batch>
 batch_cache_index::get(model::offset offset) {
     lock_guard lk(*this);
@@ -160,13 +286,49 @@ batch_cache_index::get(model::offset offset) {
     return std::nullopt;
 }
 
+batch_cache::entry_ptr*
+batch_cache_index::find_entry(const model::record_batch& compressed) {
+    auto it = _index.find(compressed.base_offset());
+    if (it == _index.end() || !it->second || !it->second->valid()) {
+        return nullptr;
+    }
+    // the data of a segment may be replaced by compaction under the cache.
+    // the crc tells apart a cached batch from its rewritten version
+    if (it->second->batch().header().crc != compressed.header().crc) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+std::optional<model::record_batch>
+batch_cache_index::get_decompressed(const model::record_batch& compressed) {
+    lock_guard lk(*this);
+    if (auto e = find_entry(compressed); e) {
+        if (auto& d = (*e)->decompressed(); d) {
+            return d->share();
+        }
+    }
+    return std::nullopt;
+}
+
+void batch_cache_index::put_decompressed(
+  const model::record_batch& compressed,
+  const model::record_batch& decompressed) {
+    lock_guard lk(*this);
+    if (auto e = find_entry(compressed); e) {
+        _cache->put_decompressed(*e, decompressed);
+    }
+}
+
 batch_cache_index::read_result batch_cache_index::read(
   model::offset offset,
   model::offset max_offset,
   std::optional<model::record_batch_type> type_filter,
   std::optional<model::timestamp> first_ts,
   size_t max_bytes,
-  bool skip_lru_promote) {
+  bool skip_lru_promote,
+  size_t budget,
+  bool strict_budget) {
     lock_guard lk(*this);
     read_result ret;
     ret.next_batch = offset;
@@ -180,9 +342,18 @@ batch_cache_index::read_result batch_cache_index::read(
         take &= !first_ts || batch.header().first_timestamp >= *first_ts;
 
         if (take) {
+            // the header tells the size before the batch is shared
+            const size_t size = batch.header().size_bytes;
+            if (
+              (strict_budget || !ret.batches.empty())
+              && ret.size_bytes + size > budget) {
+                ret.over_budget = true;
+                break;
+            }
             batch_cache::entry::lock_guard g(*it->second);
             ret.batches.emplace_back(batch.share());
             ret.memory_usage += batch.memory_usage();
+            ret.size_bytes += size;
             if (!skip_lru_promote) {
                 _cache->touch(it->second);
             }
@@ -249,7 +420,9 @@ std::ostream& operator<<(std::ostream& o, const batch_cache& b) {
     // Do _not_ print size of _lru
     return o << "{is_reclaiming:" << b.is_memory_reclaiming()
              << ", size_bytes: " << b._size_bytes
-             << ", lru_empty:" << b._lru.empty() << "}";
+             << ", protected_bytes: " << b._protected_bytes
+             << ", target_bytes: " << b._target_bytes
+             << ", lru_empty:" << b.empty() << "}";
 }
 std::ostream&
 operator<<(std::ostream& o, const batch_cache_index::read_result& c) {
@@ -12,6 +12,7 @@
 #pragma once
 #include "config/configuration.h"
 #include "model/record.h"
+#include "storage/types.h"
 #include "utils/intrusive_list_helpers.h"
 #include "vassert.h"
 
@@ -88,13 +89,39 @@ class batch_cache_index;
  * the future, consider other solutions like blocking the reclaimer or only
  * allowing asynchronous reclaims while executing within the batch catch.
  *
- * TODO:
- *  - add probes to track statistics
+ * Scan resistance
+ * ===============
+ *
+ * The LRU is segmented. Newly inserted batches enter a probation segment and
+ * are only promoted into the protected segment when they are hit again. The
+ * reclaimer drains the probation segment before touching protected entries, so
+ * a large read-once scan (e.g. a consumer catching up from the start of a log)
+ * churns through probation without evicting the hot tail that live consumers
+ * keep hitting. The protected segment is bounded to a share of the cache and
+ * its least recently used entries are demoted back into probation.
+ *
+ * Size target
+ * ===========
+ *
+ * Reclaim upcalls happen in the allocation path, once memory is already
+ * short. With an adaptive target the cache is kept to a size that follows the
+ * memory signals of the shard, see `update_target`. Pressure cuts the target
+ * multiplicatively, free memory above a high watermark raises it again by
+ * half of the headroom. The cache evicts down to the target before inserting,
+ * so the memory it gives up is there for the chunk cache of the appenders
+ * before they stall on allocations, and is taken back once writes settle.
  */
 class batch_cache {
     /// Minimum size reclaimed in low-memory situations.
     static constexpr size_t min_reclaim_size = 128 << 10;
 
+    /// Share of the cached bytes that may live in the protected segment.
+    static constexpr size_t max_protected_percent = 80;
+    /// Free memory below which the shard is considered under pressure.
+    static constexpr size_t low_free_percent = 10;
+    /// Free memory above which the size target grows.
+    static constexpr size_t high_free_percent = 25;
+
     using reclaimer = ss::memory::reclaimer;
     using reclaim_scope = ss::memory::reclaimer_scope;
     using reclaim_result = ss::memory::reclaiming_result;
@@ -105,6 +132,26 @@ public:
         ss::lowres_clock::duration stable_window;
         size_t min_size;
         size_t max_size;
+        // bounds of the adaptive size target, disabled when max_target is 0
+        size_t min_target{0};
+        size_t max_target{0};
+    };
+
+    /// Memory signals of the shard sampled by the owner of the cache.
+    struct memory_signals {
+        size_t free_memory{0};
+        size_t total_memory{0};
+        // counters, the target reacts to their increase since the last sample
+        uint64_t reclaims{0};
+        uint64_t allocation_failures{0};
+        // writers of the shard are waiting for memory
+        bool write_waiters{false};
+    };
+
+    struct stats {
+        uint64_t promotions{0};
+        uint64_t demotions{0};
+        uint64_t evictions{0};
     };
 
     /*
@@ -150,6 +197,18 @@ public:
             return _batch;
         }
 
+        // the decompressed form of a compressed batch, attached the first
+        // time a consumer needs its records
+        std::optional<model::record_batch>& decompressed() {
+            vassert(_valid, "cannot access invalided batch");
+            return _decompressed;
+        }
+
+        size_t memory_usage() const {
+            return _batch.memory_usage()
+                   + (_decompressed ? _decompressed->memory_usage() : 0);
+        }
+
         void pin() { _pinned = true; }
         void unpin() { _pinned = false; }
         bool pinned() const { return _pinned; }
@@ -163,8 +222,11 @@ public:
         // interact with an invalid entry.
         bool _valid{true};
         model::record_batch _batch;
+        std::optional<model::record_batch> _decompressed;
 
         bool _pinned{false};
+        // true if the entry lives in the protected segment of the lru
+        bool _is_protected{false};
         intrusive_list_hook _hook;
         batch_cache_index& _index;
     };
@@ -175,7 +237,10 @@ public:
       : _reclaimer(
         [this](reclaimer::request r) { return reclaim(r); },
         reclaim_scope::sync)
-      , _reclaim_opts(opts) {}
+      , _reclaim_opts(opts)
+      , _target_bytes(
+          opts.max_target > 0 ? opts.max_target
+                              : std::numeric_limits<size_t>::max()) {}
 
     batch_cache(const batch_cache&) = delete;
     batch_cache& operator=(const batch_cache&) = delete;
@@ -189,21 +254,28 @@ public:
      * and the moved from reclaimer will deregister itself properly.
      */
     batch_cache(batch_cache&& o) noexcept
-      : _lru(std::move(o._lru))
+      : _probation(std::move(o._probation))
+      , _protected(std::move(o._protected))
       , _reclaimer(
           [this](reclaimer::request r) { return reclaim(r); },
           reclaim_scope::sync)
       , _is_reclaiming(o._is_reclaiming)
       , _size_bytes(o._size_bytes)
-      , _reclaim_opts(o._reclaim_opts) {
+      , _protected_bytes(o._protected_bytes)
+      , _reclaim_opts(o._reclaim_opts)
+      , _stats(o._stats)
+      , _target_bytes(o._target_bytes)
+      , _signals(o._signals)
+      , _capacity(o._capacity) {
         o._size_bytes = 0;
+        o._protected_bytes = 0;
         o._is_reclaiming = false;
     }
 
     ~batch_cache() noexcept;
 
     /// Returns true if the cache is empty, and false otherwise.
-    bool empty() const { return _lru.empty(); }
+    bool empty() const { return _probation.empty() && _protected.empty(); }
 
     /// Removes all entries from the cache and entry pool.
     void clear() { reclaim(std::numeric_limits<size_t>::max()); }
@@ -214,8 +286,14 @@ public:
      *
      * The returned weak_ptr will be invalidated if its memory is reclaimed. To
      * evict the entry, move it into batch_cache::evict().
+     *
+     * A low priority batch is inserted at the head of the probation segment,
+     * it is reclaimed before any other batch unless it is hit first.
      */
-    entry_ptr put(batch_cache_index&, const model::record_batch&);
+    entry_ptr put(
+      batch_cache_index&,
+      const model::record_batch&,
+      cache_priority = cache_priority::normal);
 
     /**
      * \brief Remove a batch from the cache.
@@ -234,15 +312,18 @@ public:
     void evict(entry_ptr&& e);
 
     /**
-     * Notify the cache that the specified entry was recently used.
+     * Attach the decompressed form of a cached compressed batch to its entry.
+     * The decompressed batch is accounted with the entry and released with it
+     * on eviction or reclaim.
      */
-    void touch(entry_ptr& e) {
-        if (e) {
-            auto p = e.get();
-            p->_hook.unlink();
-            _lru.push_back(*p);
-        }
-    }
+    void
+    put_decompressed(entry_ptr& e, const model::record_batch& decompressed);
+
+    /**
+     * Notify the cache that the specified entry was recently used. An entry in
+     * the probation segment is promoted into the protected segment.
+     */
+    void touch(entry_ptr& e);
 
     /**
      * \brief Evict batches up to the accumulated size specified.
@@ -258,6 +339,27 @@ public:
      */
     bool is_memory_reclaiming() const { return _is_reclaiming; }
 
+    const stats& get_stats() const { return _stats; }
+
+    /**
+     * Adjust the size target to the memory signals of the shard and evict
+     * down to it. Expected to be called periodically, a no-op unless the
+     * target is adaptive.
+     */
+    void update_target(const memory_signals&);
+
+    size_t target_bytes() const { return _target_bytes; }
+    size_t size_bytes() const { return _size_bytes; }
+
+    /**
+     * Bound of the cache on top of its target, set by the memory broker.
+     * The cache evicts down to it.
+     */
+    void set_capacity(size_t bytes) {
+        _capacity = bytes;
+        trim();
+    }
+
 private:
     struct batch_reclaiming_lock {
         explicit batch_reclaiming_lock(batch_cache& b) noexcept
@@ -291,14 +393,49 @@ private:
                               : reclaim_result::reclaimed_nothing;
     }
 
-    intrusive_list<entry, &entry::_hook> _lru;
+    using lru_list = intrusive_list<entry, &entry::_hook>;
+
+    lru_list& lru_of(entry& e) {
+        return e._is_protected ? _protected : _probation;
+    }
+
+    /*
+     * Demote the least recently used protected entries into probation until
+     * the protected segment fits in its share of the cache.
+     */
+    void maybe_demote();
+
+    /*
+     * Reclaim record data from the entries of `lru` in lru order until
+     * `target` bytes are reclaimed. See `reclaim(size_t)`.
+     */
+    void reclaim_from(
+      lru_list& lru, size_t target, size_t& reclaimed, lru_list& removed);
+
+    /*
+     * Release at least `size` bytes in lru order, see `reclaim(size_t)`.
+     */
+    size_t release(size_t size);
+
+    /*
+     * Evict down to the size target and the capacity.
+     */
+    void trim();
+
+    lru_list _probation;
+    lru_list _protected;
     reclaimer _reclaimer;
     bool _is_reclaiming{false};
     size_t _size_bytes{0};
+    size_t _protected_bytes{0};
 
     reclaim_options _reclaim_opts;
+    stats _stats;
     ss::lowres_clock::time_point _last_reclaim;
     size_t _reclaim_size;
+    size_t _target_bytes;
+    memory_signals _signals;
+    size_t _capacity{std::numeric_limits<size_t>::max()};
 
     friend std::ostream& operator<<(std::ostream&, const batch_cache&);
 };
@@ -310,8 +447,12 @@ public:
     struct read_result {
         ss::circular_buffer<model::record_batch> batches;
         size_t memory_usage{0};
+        // bytes of the batches as counted against a read budget
+        size_t size_bytes{0};
         model::offset next_batch;
         std::optional<model::offset> next_cached_batch;
+        // the read stopped at a batch that did not fit in the budget
+        bool over_budget{false};
 
         friend std::ostream& operator<<(std::ostream&, const read_result&);
     };
@@ -332,7 +473,9 @@ public:
 
     bool empty() const { return _index.empty(); }
 
-    void put(const model::record_batch& batch) {
+    void put(
+      const model::record_batch& batch,
+      cache_priority priority = cache_priority::normal) {
         lock_guard lk(*this);
         auto offset = batch.header().base_offset;
         if (likely(!_index.contains(offset))) {
@@ -342,7 +485,7 @@ public:
              * entries are initialized in the cache and index, clean-up happens
              * correctly on either side.
              */
-            auto p = _cache->put(*this, batch);
+            auto p = _cache->put(*this, batch, priority);
             _index.emplace(offset, std::move(p));
         }
     }
@@ -370,6 +513,11 @@ public:
      * When `skip_lru_promote` is true a cache hit doesn't change the position
      * of the batch in the lru list. This is useful when the read is known to
      * not be repeated in the near future.
+     *
+     * The batches returned fit in `budget` bytes of their headers' size. The
+     * read stops before the first batch that does not fit and sets
+     * `.over_budget`, unless `strict_budget` is false and it is the first
+     * batch returned.
      */
     read_result read(
       model::offset offset,
@@ -377,7 +525,26 @@ public:
       std::optional<model::record_batch_type> type_filter,
       std::optional<model::timestamp> first_ts,
       size_t max_bytes,
-      bool skip_lru_promote);
+      bool skip_lru_promote,
+      size_t budget = std::numeric_limits<size_t>::max(),
+      bool strict_budget = false);
+
+    /**
+     * Return the decompressed form of a compressed batch if that batch is
+     * cached and was decompressed before. The cached batch must match the
+     * base offset and crc of `compressed`. The lru position of the batch is
+     * not changed.
+     */
+    std::optional<model::record_batch>
+    get_decompressed(const model::record_batch& compressed);
+
+    /**
+     * Cache the decompressed form of a compressed batch. It is dropped if the
+     * compressed batch is not cached.
+     */
+    void put_decompressed(
+      const model::record_batch& compressed,
+      const model::record_batch& decompressed);
 
     /**
      * Removes all batches that _may_ contain the specified offset.
@@ -425,6 +592,8 @@ private:
 
     bool locked() const { return _locked; }
 
+    batch_cache::entry_ptr* find_entry(const model::record_batch& compressed);
+
     void lock() {
         vassert(!_locked, "batch cache index double lock");
         _locked = true;
@@ -1,6 +1,7 @@
 #pragma once
 #include "resource_mgmt/memory_groups.h"
 #include "seastarx.h"
+#include "storage/hugepage_arena.h"
 #include "storage/logger.h"
 #include "storage/segment_appender_chunk.h"
 #include "vassert.h"
@@ -14,6 +15,8 @@
 
 #include <boost/iterator/counting_iterator.hpp>
 
+#include <algorithm>
+
 namespace storage::internal {
 
 class chunk_cache {
@@ -47,7 +50,7 @@ public:
           boost::counting_iterator<size_t>(0),
           boost::counting_iterator<size_t>(num_chunks),
           [this](size_t) {
-              auto c = ss::make_lw_shared<chunk>(alignment);
+              auto c = make_chunk();
               _size_total += chunk::chunk_size;
               add(c);
           });
@@ -65,6 +68,10 @@ public:
         }
     }
 
+    /// A chunk that does not return to the cache, its memory is freed with
+    /// its last reference.
+    void forget(const chunk_ptr&) { _size_total -= chunk::chunk_size; }
+
     ss::future<chunk_ptr> get() {
         // don't steal if there are waiters
         if (!_sem.waiters()) {
@@ -74,6 +81,42 @@ public:
           [this](ss::semaphore_units<>) { return do_get(); });
     }
 
+    /**
+     * Appenders report their recent write rate so that the write-behind
+     * budget of the shard can be split between them.
+     */
+    void update_write_rate(double prev, double next) {
+        // clamp to guard against accumulated floating point error
+        _write_rate = std::max(0.0, _write_rate + next - prev);
+    }
+
+    /**
+     * The number of chunks an appender writing at `rate` bytes per second may
+     * have in flight: its share of the pool proportional to its rate, capped
+     * at `max_chunks` and never less than one chunk.
+     */
+    size_t write_behind_chunks(double rate, size_t max_chunks) const {
+        max_chunks = std::max<size_t>(max_chunks, 1);
+        if (rate <= 0 || _write_rate <= 0) {
+            return 1;
+        }
+        const double pool = _size_limit / chunk::chunk_size;
+        const auto share = static_cast<size_t>(pool * rate / _write_rate);
+        return std::clamp<size_t>(share, 1, max_chunks);
+    }
+
+    /// Bytes of the chunks allocated, in use or pooled.
+    size_t size_total() const { return _size_total; }
+    /// Bound of the chunks allocated, set by the memory broker if enabled.
+    void set_size_limit(size_t bytes) {
+        _size_limit = std::max<size_t>(bytes, chunk::chunk_size);
+    }
+
+    /// Appenders are waiting for a chunk to be returned.
+    bool has_waiters() const { return _sem.waiters() > 0; }
+    /// Chunks that could not be allocated below the size limit.
+    uint64_t allocation_failures() const { return _allocation_failures; }
+
 private:
     ss::future<chunk_ptr> do_get() {
         if (auto c = pop_or_allocate(); c) {
@@ -83,6 +126,22 @@ private:
           [this](ss::semaphore_units<>) { return do_get(); });
     }
 
+    /// chunks are carved from the hugepage arena while it has slots left
+    static chunk_ptr make_chunk() {
+        auto& arena = hugepages();
+        if (arena.enabled()) {
+            if (auto* slot = arena.allocate(chunk::chunk_size); slot) {
+                try {
+                    return ss::make_lw_shared<chunk>(alignment, arena, slot);
+                } catch (...) {
+                    arena.deallocate(slot, chunk::chunk_size);
+                    throw;
+                }
+            }
+        }
+        return ss::make_lw_shared<chunk>(alignment);
+    }
+
     chunk_ptr pop_or_allocate() {
         if (!_chunks.empty()) {
             auto c = _chunks.front();
@@ -93,10 +152,11 @@ private:
         }
         if (_size_total < _size_limit) {
             try {
-                auto c = ss::make_lw_shared<chunk>(alignment);
+                auto c = make_chunk();
                 _size_total += chunk::chunk_size;
                 return c;
             } catch (const std::bad_alloc& e) {
+                ++_allocation_failures;
                 vlog(stlog.debug, "chunk allocation failed: {}", e);
             }
         }
@@ -107,8 +167,10 @@ private:
     ss::semaphore _sem{0};
     size_t _size_available{0};
     size_t _size_total{0};
+    double _write_rate{0};
+    uint64_t _allocation_failures{0};
     const size_t _size_target;
-    const size_t _size_limit;
+    size_t _size_limit;
 };
 
 inline chunk_cache& chunks() {
@@ -0,0 +1,53 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/committed_offset_monitor.h"
+
+#include "storage/segment.h"
+
+namespace storage {
+
+ss::future<model::offset> committed_offset_monitor::wait(
+  model::offset offset, model::offset committed, ss::abort_source& as) {
+    if (committed >= offset) {
+        return ss::make_ready_future<model::offset>(committed);
+    }
+    if (as.abort_requested()) {
+        return ss::make_exception_future<model::offset>(
+          ss::abort_requested_exception());
+    }
+    auto it = _waiters.emplace(_waiters.end());
+    it->offset = offset;
+    auto sub = as.subscribe([this, it]() noexcept {
+        it->promise.set_exception(ss::abort_requested_exception());
+        _waiters.erase(it);
+    });
+    it->sub = std::move(*sub);
+    return it->promise.get_future();
+}
+
+void committed_offset_monitor::notify(model::offset committed) {
+    for (auto it = _waiters.begin(); it != _waiters.end();) {
+        if (it->offset <= committed) {
+            it->promise.set_value(committed);
+            it = _waiters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void committed_offset_monitor::stop() {
+    for (auto& w : _waiters) {
+        w.promise.set_exception(segment_closed_exception());
+    }
+    _waiters.clear();
+}
+
+} // namespace storage
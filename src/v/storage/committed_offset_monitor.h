@@ -0,0 +1,56 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+
+#include <list>
+
+namespace storage {
+
+/**
+ * Waiters for the committed offset of a log to reach an offset.
+ *
+ * Lets the readers tailing a log park until data was flushed instead of
+ * polling its offsets. A log has a handful of waiters at most, they are kept
+ * in a list.
+ */
+class committed_offset_monitor {
+public:
+    /// Resolves with the committed offset once it is at least `offset`,
+    /// right away when `committed` already is
+    ss::future<model::offset>
+    wait(model::offset offset, model::offset committed, ss::abort_source&);
+
+    /// Resolves the waiters up to the new committed offset
+    void notify(model::offset committed);
+
+    /// Fails the waiters with segment_closed_exception
+    void stop();
+
+    bool empty() const { return _waiters.empty(); }
+
+private:
+    struct waiter {
+        model::offset offset;
+        ss::promise<model::offset> promise;
+        ss::abort_source::subscription sub;
+    };
+
+    std::list<waiter> _waiters;
+};
+
+} // namespace storage
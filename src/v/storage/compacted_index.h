@@ -38,6 +38,11 @@ struct compacted_index {
         truncation = 1U,
         /// needed to determine if we should self compact first
         self_compaction = 1U << 1U,
+        /// a key_bloom_filter is stored between the entries and the footer
+        bloom_filter = 1U << 2U,
+        /// some indexed record is a tombstone, a record without a value.
+        /// segments without it skip tombstone expiry in cross compaction
+        tombstones = 1U << 3U,
     };
     struct footer {
         uint32_t size{0};
@@ -62,6 +67,12 @@ struct compacted_index {
                                           + sizeof(footer::flags)
                                           + sizeof(footer::crc)
                                           + sizeof(footer::version);
+    /// with footer_flags::bloom_filter the file is laid out as
+    ///
+    ///    [entries: footer.size bytes][filter][UINT32 size, UINT32 crc][footer]
+    ///
+    /// readers that do not know the flag stop after footer.size bytes
+    static constexpr size_t filter_trailer_size = 2 * sizeof(uint32_t);
     // for the readers and friends
     struct entry {
         entry(entry_type t, bytes k, model::offset o, int32_t d) noexcept
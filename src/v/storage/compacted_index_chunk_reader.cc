@@ -16,6 +16,7 @@
 #include "storage/compacted_index_reader.h"
 #include "storage/logger.h"
 #include "utils/to_string.h"
+#include "vlog.h"
 
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
@@ -76,10 +77,7 @@ ss::future<> compacted_index_chunk_reader::verify_integrity() {
                  int32_t(_footer->size),
                  crc32{},
                  ss::make_file_input_stream(
-                   _handle,
-                   0,
-                   _file_size.value() - compacted_index::footer_size,
-                   std::move(options)),
+                   _handle, 0, _footer->size, std::move(options)),
                  [](
                    int32_t& max_bytes, crc32& crc, ss::input_stream<char>& in) {
                      return ss::do_until(
@@ -160,6 +158,70 @@ compacted_index_chunk_reader::load_footer() {
     });
 }
 
+ss::future<std::optional<key_bloom_filter>>
+compacted_index_chunk_reader::load_key_filter() {
+    using ret_t = std::optional<key_bloom_filter>;
+    return load_footer().then([this](compacted_index::footer footer) {
+        const bool has_filter = (footer.flags
+                                 & compacted_index::footer_flags::bloom_filter)
+                                == compacted_index::footer_flags::bloom_filter;
+        const size_t trailer_end = _file_size.value()
+                                   - compacted_index::footer_size;
+        if (
+          !has_filter
+          || trailer_end
+               < footer.size + compacted_index::filter_trailer_size) {
+            return ss::make_ready_future<ret_t>(std::nullopt);
+        }
+        const size_t region = trailer_end - footer.size;
+        ss::file_input_stream_options options;
+        options.buffer_size = 4096;
+        options.io_priority_class = _iopc;
+        options.read_ahead = 0;
+        return ss::do_with(
+          ss::make_file_input_stream(
+            _handle, footer.size, region, std::move(options)),
+          [this, region](ss::input_stream<char>& in) {
+              return ::read_iobuf_exactly(in, region)
+                .then([this, region](iobuf buf) {
+                    return parse_key_filter(std::move(buf), region);
+                })
+                .finally([&in] { return in.close(); });
+          });
+    });
+}
+
+std::optional<key_bloom_filter>
+compacted_index_chunk_reader::parse_key_filter(iobuf buf, size_t region) {
+    if (buf.size_bytes() != region) {
+        vlog(stlog.warn, "short read of key filter: {}", *this);
+        return std::nullopt;
+    }
+    const size_t filter_size = region - compacted_index::filter_trailer_size;
+    iobuf_parser trailer(
+      buf.share(filter_size, compacted_index::filter_trailer_size));
+    const auto size = ss::le_to_cpu(trailer.consume_type<uint32_t>());
+    const auto expected_crc = ss::le_to_cpu(trailer.consume_type<uint32_t>());
+    buf.trim_back(compacted_index::filter_trailer_size);
+    crc32 crc;
+    for (auto& f : buf) {
+        crc.extend(f.get(), f.size());
+    }
+    if (size != filter_size || crc.value() != expected_crc) {
+        vlog(
+          stlog.warn,
+          "ignoring invalid key filter - size:{}, expected:{}, crc:{}, "
+          "expected:{} - {}",
+          size,
+          filter_size,
+          crc.value(),
+          expected_crc,
+          *this);
+        return std::nullopt;
+    }
+    return key_bloom_filter::from_iobuf(std::move(buf));
+}
+
 void compacted_index_chunk_reader::print(std::ostream& o) const { o << *this; }
 
 bool compacted_index_chunk_reader::is_end_of_stream() const {
@@ -34,6 +34,8 @@ public:
 
     ss::future<compacted_index::footer> load_footer() final;
 
+    ss::future<std::optional<key_bloom_filter>> load_key_filter() final;
+
     ss::future<> verify_integrity() final;
 
     void reset() final;
@@ -47,6 +49,7 @@ public:
 
 private:
     bool is_footer_loaded() const;
+    std::optional<key_bloom_filter> parse_key_filter(iobuf, size_t region);
 
     ss::file _handle;
     ss::io_priority_class _iopc;
@@ -35,6 +35,8 @@ public:
 
     bool contains(model::offset) const;
     void add(model::offset);
+    /// no record is kept
+    bool empty() const { return _to_keep.isEmpty(); }
 
 private:
     model::offset _base;
@@ -12,6 +12,7 @@
 #include "compression/compression.h"
 #include "model/record.h"
 #include "model/record_utils.h"
+#include "model/record_view.h"
 #include "random/generators.h"
 #include "storage/index_state.h"
 #include "storage/logger.h"
@@ -29,6 +30,9 @@
 
 namespace storage::internal {
 
+// raft::data_batch_type, other batches are internal and keep their codec
+static constexpr auto data_batch_type = model::record_batch_type(1);
+
 ss::future<ss::stop_iteration>
 compaction_key_reducer::operator()(compacted_index::entry&& e) {
     using stop_t = ss::stop_iteration;
@@ -111,17 +115,56 @@ compacted_offset_list_reducer::operator()(compacted_index::entry&& e) {
     return ss::make_ready_future<stop_t>(stop_t::no);
 }
 
+ss::future<ss::stop_iteration>
+compaction_key_map_reducer::operator()(compacted_index::entry&& e) {
+    using stop_t = ss::stop_iteration;
+    const model::offset o = e.offset + model::offset(e.delta);
+    if (auto it = _map->offsets.find(e.key); it != _map->offsets.end()) {
+        it->second = std::max(it->second, o);
+        return ss::make_ready_future<stop_t>(stop_t::no);
+    }
+    if (_map->memory_usage() + e.key.size() > _max_mem) {
+        _complete = false;
+        return ss::make_ready_future<stop_t>(stop_t::yes);
+    }
+    _map->keys_mem_usage += e.key.size();
+    _map->offsets.emplace(std::move(e.key), o);
+    return ss::make_ready_future<stop_t>(stop_t::no);
+}
+
+ss::future<ss::stop_iteration>
+cross_compacted_offset_list_reducer::operator()(compacted_index::entry&& e) {
+    using stop_t = ss::stop_iteration;
+    const model::offset o = e.offset + model::offset(e.delta);
+    if (auto it = _map->offsets.find(e.key);
+        it != _map->offsets.end() && it->second > o) {
+        ++_dropped;
+    } else {
+        _list.add(o);
+    }
+    return ss::make_ready_future<stop_t>(stop_t::no);
+}
+
+std::optional<compacted_offset_list>
+cross_compacted_offset_list_reducer::end_of_stream() {
+    if (_dropped == 0 && !_rewrite) {
+        return std::nullopt;
+    }
+    return std::move(_list);
+}
+
 std::optional<model::record_batch>
 copy_data_segment_reducer::filter(model::record_batch&& batch) {
     // 1. compute which records to keep
     const auto base = batch.base_offset();
     std::vector<int32_t> offset_deltas;
     offset_deltas.reserve(batch.record_count());
-    batch.for_each_record([this, base, &offset_deltas](const model::record& r) {
-        if (should_keep(base, r.offset_delta())) {
-            offset_deltas.push_back(r.offset_delta());
-        }
-    });
+    model::for_each_record_view(
+      batch, [this, base, &offset_deltas](const model::record_view& r) {
+          if (should_keep(base, r)) {
+              offset_deltas.push_back(r.offset_delta());
+          }
+      });
 
     // 2. no record to keep
     if (offset_deltas.empty()) {
@@ -133,36 +176,34 @@ copy_data_segment_reducer::filter(model::record_batch&& batch) {
         return std::move(batch);
     }
 
-    // 4. filter
-    iobuf ret;
-    int32_t rec_count = 0;
+    // 4. filter, the encoded records kept are shared with the new batch
+    struct kept_record {
+        size_t position;
+        size_t size;
+    };
+    std::vector<kept_record> kept;
+    kept.reserve(offset_deltas.size());
     std::optional<int64_t> first_timestamp_delta;
     int64_t last_timestamp_delta;
-    batch.for_each_record([&rec_count,
-                           &first_timestamp_delta,
-                           &last_timestamp_delta,
-                           &ret,
-                           &offset_deltas](model::record record) {
-        // contains the key
-        if (std::count(
-              offset_deltas.begin(),
-              offset_deltas.end(),
-              record.offset_delta())) {
-            /*
-             * TODO when we further optimize lazy record materialization ot
-             * make use of views we can avoid this re-encoding by copying or
-             * sharing the view. either way, we were building
-             * record batch with the uncompressed records so they were being
-             * re-encoded.
-             */
-            if (!first_timestamp_delta) {
-                first_timestamp_delta = record.timestamp_delta();
-            }
-            last_timestamp_delta = record.timestamp_delta();
-            model::append_record_to_buffer(ret, record);
-            ++rec_count;
-        }
-    });
+    model::for_each_record_view(
+      batch,
+      [&kept, &first_timestamp_delta, &last_timestamp_delta, &offset_deltas](
+        const model::record_view& record) {
+          // contains the key
+          if (std::count(
+                offset_deltas.begin(),
+                offset_deltas.end(),
+                record.offset_delta())) {
+              if (!first_timestamp_delta) {
+                  first_timestamp_delta = record.timestamp_delta();
+              }
+              last_timestamp_delta = record.timestamp_delta();
+              kept.push_back(kept_record{
+                .position = record.position(),
+                .size = record.encoded_size_bytes()});
+          }
+      });
+    const auto rec_count = static_cast<int32_t>(kept.size());
     // From: DefaultRecordBatch.java
     // On Compaction: Unlike the older message formats, magic v2 and above
     // preserves the first and last offset/sequence numbers from the
@@ -213,80 +254,130 @@ copy_data_segment_reducer::filter(model::record_batch&& batch) {
     h.first_timestamp = first_time;
     h.max_timestamp = last_time;
     h.record_count = rec_count;
+    auto data = std::move(batch).release_data();
+    iobuf ret;
+    for (const auto& r : kept) {
+        ret.append(data.share(r.position, r.size));
+    }
     reset_size_checksum_metadata(h, ret);
     auto new_batch = model::record_batch(
       h, std::move(ret), model::record_batch::tag_ctor_ng{});
     return new_batch;
 }
 ss::future<ss::stop_iteration> copy_data_segment_reducer::do_compaction(
-  model::compression original, model::record_batch&& b) {
+  model::record_batch&& b, std::optional<model::record_batch> compressed) {
     using stop_t = ss::stop_iteration;
     auto to_copy = filter(std::move(b));
     if (to_copy == std::nullopt) {
         return ss::make_ready_future<stop_t>(stop_t::no);
     }
-    return compress_batch(original, std::move(to_copy.value()))
-      .then([this](model::record_batch&& b) {
-          return ss::do_with(std::move(b), [this](model::record_batch& batch) {
-              auto const start_offset = _appender->file_byte_offset();
-              auto const header_size = batch.header().size_bytes;
-              _acc += header_size;
-              if (_idx.maybe_index(
-                    _acc,
-                    32_KiB,
-                    start_offset,
-                    batch.base_offset(),
-                    batch.last_offset(),
-                    batch.header().first_timestamp,
-                    batch.header().max_timestamp)) {
-                  _acc = 0;
-              }
-              return storage::write(*_appender, batch)
-                .then([this, start_offset, header_size] {
-                    vassert(
-                      _appender->file_byte_offset()
-                        == start_offset + header_size,
-                      "Size must be deterministic. Expected:{} == {}",
-                      _appender->file_byte_offset(),
-                      start_offset + header_size);
-                });
-          });
-      })
+    const auto current = compressed
+                           ? compressed->header().attrs.compression()
+                           : model::compression::none;
+    const auto c = output_compression(*to_copy, current);
+    if (
+      compressed && c == current
+      && to_copy->record_count() == compressed->record_count()) {
+        // every record is kept, the batch is written as it was read rather
+        // than compressed again
+        return write(std::move(*compressed));
+    }
+    return compress_batch(c, std::move(to_copy.value()))
+      .then([this](model::record_batch&& b) { return write(std::move(b)); });
+}
+
+model::compression copy_data_segment_reducer::output_compression(
+  const model::record_batch& b, model::compression current) const {
+    if (_target && b.header().type == data_batch_type) {
+        return *_target;
+    }
+    return current;
+}
+
+ss::future<ss::stop_iteration>
+copy_data_segment_reducer::write(model::record_batch&& b) {
+    using stop_t = ss::stop_iteration;
+    return ss::do_with(
+             std::move(b),
+             [this](model::record_batch& batch) {
+                 auto const start_offset = _appender->file_byte_offset();
+                 auto const header_size = batch.header().size_bytes;
+                 _acc += header_size;
+                 if (_idx.maybe_index(
+                       _acc,
+                       32_KiB,
+                       start_offset,
+                       batch.base_offset(),
+                       batch.last_offset(),
+                       batch.header().first_timestamp,
+                       batch.header().max_timestamp)) {
+                     _acc = 0;
+                 }
+                 return storage::write(*_appender, batch)
+                   .then([this, start_offset, header_size] {
+                       vassert(
+                         _appender->file_byte_offset()
+                           == start_offset + header_size,
+                         "Size must be deterministic. Expected:{} == {}",
+                         _appender->file_byte_offset(),
+                         start_offset + header_size);
+                   });
+             })
       .then([] { return ss::make_ready_future<stop_t>(stop_t::no); });
 }
 
 ss::future<ss::stop_iteration>
 copy_data_segment_reducer::operator()(model::record_batch&& b) {
-    const auto comp = b.header().attrs.compression();
-    if (!b.compressed()) {
-        return do_compaction(comp, std::move(b));
-    }
-    return decompress_batch(std::move(b))
-      .then([comp, this](model::record_batch&& b) {
-          return do_compaction(comp, std::move(b));
-      });
+    auto f = _throttle ? _throttle->throttle(b.size_bytes()) : ss::now();
+    return f.then([this, b = std::move(b)]() mutable {
+        if (!b.compressed()) {
+            return do_compaction(std::move(b), std::nullopt);
+        }
+        // the segment may release its cache while it is being compacted
+        auto cache = _src && _src->has_cache() ? &_src->cache() : nullptr;
+        return ss::do_with(
+          std::move(b), [this, cache](model::record_batch& compressed) {
+              return decompress_batch(compressed, cache)
+                .then([this, &compressed](model::record_batch&& b) {
+                    return do_compaction(std::move(b), std::move(compressed));
+                });
+          });
+    });
+}
+
+ss::future<ss::stop_iteration>
+recompression_check_reducer::operator()(model::record_batch&& b) {
+    _found = b.header().type == data_batch_type
+             && b.header().attrs.compression() != _target;
+    return ss::make_ready_future<ss::stop_iteration>(
+      ss::stop_iteration(_found));
 }
 
 ss::future<ss::stop_iteration>
 index_rebuilder_reducer::operator()(model::record_batch&& b) {
     using stop_t = ss::stop_iteration;
-    auto f = ss::now();
-    if (!b.compressed()) {
-        f = do_index(std::move(b));
-    } else {
-        f = internal::decompress_batch(std::move(b))
-              .then([this](model::record_batch&& b) {
-                  return do_index(std::move(b));
-              });
-    }
-    return f.then([] { return ss::make_ready_future<stop_t>(stop_t::no); });
+    auto f = _throttle ? _throttle->throttle(b.size_bytes()) : ss::now();
+    return f
+      .then([this, b = std::move(b)]() mutable {
+          if (!b.compressed()) {
+              return do_index(std::move(b));
+          }
+          return internal::decompress_batch(std::move(b))
+            .then([this](model::record_batch&& b) {
+                return do_index(std::move(b));
+            });
+      })
+      .then([] { return ss::make_ready_future<stop_t>(stop_t::no); });
 }
 
 ss::future<> index_rebuilder_reducer::do_index(model::record_batch&& b) {
     return ss::do_with(std::move(b), [this](model::record_batch& b) {
-        return model::for_each_record(
-          b, [this, o = b.base_offset()](model::record& r) {
-              return _w->index(r.key(), o, r.offset_delta());
+        return model::async_for_each_record_view(
+          b, [this, o = b.base_offset()](const model::record_view& r) {
+              if (r.value_size() < 0) {
+                  _w->set_flag(compacted_index::footer_flags::tombstones);
+              }
+              return _w->index(r.copy_key_bytes(), o, r.offset_delta());
           });
     });
 }
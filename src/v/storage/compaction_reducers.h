@@ -12,15 +12,21 @@
 #pragma once
 
 #include "model/record_batch_reader.h"
+#include "model/record_view.h"
 #include "storage/compacted_index.h"
 #include "storage/compacted_index_writer.h"
 #include "storage/compacted_offset_list.h"
+#include "storage/compaction_throttle.h"
 #include "storage/index_state.h"
 #include "storage/logger.h"
+#include "storage/segment.h"
 #include "storage/segment_appender.h"
 #include "units.h"
 
+#include <seastar/util/bool_class.hh>
+
 #include <absl/container/btree_map.h>
+#include <absl/container/flat_hash_map.h>
 #include <absl/container/node_hash_map.h>
 #include <fmt/core.h>
 #include <roaring/roaring.hh>
@@ -90,35 +96,139 @@ private:
     compacted_offset_list _list;
 };
 
+/// latest offset of every key seen across a range of segments
+struct key_offset_map {
+    using underlying_t = absl::
+      flat_hash_map<bytes, model::offset, bytes_type_hash, bytes_type_eq>;
+
+    size_t memory_usage() const {
+        // one control byte per slot
+        return keys_mem_usage
+               + offsets.capacity() * (sizeof(underlying_t::value_type) + 1);
+    }
+
+    underlying_t offsets;
+    size_t keys_mem_usage{0};
+};
+
+/// Adds the entries of a compacted index to a key_offset_map. Stops early,
+/// returning false from end_of_stream(), once a new key would exceed the
+/// memory budget of the map.
+class compaction_key_map_reducer : public compaction_reducer {
+public:
+    static constexpr const size_t default_max_memory_usage = 64_MiB;
+
+    explicit compaction_key_map_reducer(
+      key_offset_map& map, size_t max_mem = default_max_memory_usage) noexcept
+      : _map(&map)
+      , _max_mem(max_mem) {}
+
+    ss::future<ss::stop_iteration> operator()(compacted_index::entry&&);
+    bool end_of_stream() const { return _complete; }
+
+private:
+    key_offset_map* _map;
+    size_t _max_mem;
+    bool _complete{true};
+};
+
+/// Computes the records of one segment to keep given a key_offset_map built
+/// over it and newer segments. A record is dropped only if the map holds a
+/// later offset for its key. Returns std::nullopt if nothing can be dropped,
+/// unless `rewrite` is set, e.g. because the segment has tombstones to expire.
+class cross_compacted_offset_list_reducer : public compaction_reducer {
+public:
+    cross_compacted_offset_list_reducer(
+      model::offset base, const key_offset_map& map, bool rewrite = false)
+      : _list(base, Roaring{})
+      , _map(&map)
+      , _rewrite(rewrite) {}
+
+    ss::future<ss::stop_iteration> operator()(compacted_index::entry&&);
+    std::optional<compacted_offset_list> end_of_stream();
+
+private:
+    compacted_offset_list _list;
+    const key_offset_map* _map;
+    bool _rewrite;
+    size_t _dropped{0};
+};
+
 class copy_data_segment_reducer : public compaction_reducer {
 public:
-    copy_data_segment_reducer(compacted_offset_list l, segment_appender* a)
+    /// tombstones kept by the offset list are dropped too
+    using drop_tombstones = ss::bool_class<struct drop_tombstones_tag>;
+
+    /// batches are decompressed through the batch cache of `src`, if set,
+    /// which likely holds the decompressed form from indexing at append time.
+    /// the data batches are written in the `target` codec, if set
+    copy_data_segment_reducer(
+      compacted_offset_list l,
+      segment_appender* a,
+      compaction_throttle* t = nullptr,
+      ss::lw_shared_ptr<segment> src = nullptr,
+      drop_tombstones drop = drop_tombstones::no,
+      std::optional<model::compression> target = std::nullopt)
       : _list(std::move(l))
-      , _appender(a) {}
+      , _appender(a)
+      , _throttle(t)
+      , _src(std::move(src))
+      , _drop_tombstones(drop)
+      , _target(target) {}
 
     ss::future<ss::stop_iteration> operator()(model::record_batch&&);
     storage::index_state end_of_stream() { return std::move(_idx); }
 
 private:
-    ss::future<ss::stop_iteration>
-    do_compaction(model::compression, model::record_batch&&);
-
-    bool should_keep(model::offset base, int32_t delta) const {
-        const auto o = base + model::offset(delta);
+    /// \param compressed the batch as read, if `b` was decompressed from it
+    ss::future<ss::stop_iteration> do_compaction(
+      model::record_batch&& b, std::optional<model::record_batch> compressed);
+    ss::future<ss::stop_iteration> write(model::record_batch&&);
+
+    bool should_keep(model::offset base, const model::record_view& r) const {
+        if (_drop_tombstones && r.value_size() < 0) {
+            return false;
+        }
+        const auto o = base + model::offset(r.offset_delta());
         return _list.contains(o);
     }
     std::optional<model::record_batch> filter(model::record_batch&&);
+    /// the codec `b` is written in, `current` is the one it was read in
+    model::compression
+    output_compression(const model::record_batch& b, model::compression current)
+      const;
 
     compacted_offset_list _list;
     segment_appender* _appender;
+    compaction_throttle* _throttle;
+    ss::lw_shared_ptr<segment> _src;
+    drop_tombstones _drop_tombstones;
+    std::optional<model::compression> _target;
     index_state _idx;
     size_t _acc{0};
 };
 
+/// stops at the first data batch that is not in the `target` codec,
+/// end_of_stream() tells if one was found
+class recompression_check_reducer : public compaction_reducer {
+public:
+    explicit recompression_check_reducer(model::compression target) noexcept
+      : _target(target) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch&&);
+    bool end_of_stream() const { return _found; }
+
+private:
+    model::compression _target;
+    bool _found{false};
+};
+
 class index_rebuilder_reducer : public compaction_reducer {
 public:
-    explicit index_rebuilder_reducer(compacted_index_writer* w) noexcept
-      : _w(w) {}
+    explicit index_rebuilder_reducer(
+      compacted_index_writer* w, compaction_throttle* t = nullptr) noexcept
+      : _w(w)
+      , _throttle(t) {}
     ss::future<ss::stop_iteration> operator()(model::record_batch&&);
     void end_of_stream() {}
 
@@ -126,6 +236,7 @@ private:
     ss::future<> do_index(model::record_batch&&);
 
     compacted_index_writer* _w;
+    compaction_throttle* _throttle;
 };
 
 } // namespace storage::internal
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#include "storage/compaction_throttle.h"
+
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/sleep.hh>
+
+#include <fmt/ostream.h>
+
+namespace storage {
+
+compaction_throttle::compaction_throttle(config cfg, ss::abort_source& as)
+  : _cfg(cfg)
+  , _as(&as)
+  , _available(static_cast<int64_t>(cfg.max_bytes_per_sec)) {}
+
+ss::future<> compaction_throttle::throttle(size_t bytes) {
+    if (_cfg.max_bytes_per_sec == 0) {
+        return ss::now();
+    }
+    const auto now = clock_type::now();
+    maybe_adjust_rate(now);
+    refill(now);
+    // the bucket is allowed to go negative so that batches larger than the
+    // burst size still make progress; the debt is paid back by sleeping
+    _available -= static_cast<int64_t>(bytes);
+    if (_available >= 0) {
+        return ss::now();
+    }
+    const auto rate = std::max<size_t>(current_rate(), 1);
+    const auto wait = std::chrono::duration_cast<clock_type::duration>(
+      std::chrono::microseconds(
+        (-_available * 1'000'000) / static_cast<int64_t>(rate)));
+    if (!_as) {
+        return ss::sleep<clock_type>(wait);
+    }
+    return ss::sleep_abortable<clock_type>(wait, *_as)
+      .handle_exception_type([](const ss::sleep_aborted&) {});
+}
+
+void compaction_throttle::refill(clock_type::time_point now) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      now - _last_refill);
+    _last_refill = now;
+    const auto rate = static_cast<int64_t>(current_rate());
+    // at most one second worth of burst
+    _available = std::min(
+      rate, _available + (rate * elapsed.count()) / 1'000'000);
+}
+
+void compaction_throttle::record_foreground_latency(
+  std::chrono::microseconds d) {
+    if (_cfg.target_latency.count() == 0) {
+        return;
+    }
+    _latency.record(d.count());
+    _has_samples = true;
+}
+
+void compaction_throttle::maybe_adjust_rate(clock_type::time_point now) {
+    if (now - _window_start < window) {
+        return;
+    }
+    _window_start = now;
+    if (!_has_samples) {
+        // no foreground traffic - compaction may use the full ceiling
+        _rate_percent = std::min<uint32_t>(
+          100, _rate_percent + recovery_step_percent);
+        return;
+    }
+    const auto p99 = std::chrono::microseconds(_latency.get_value_at(99.0));
+    _latency = hdr_hist();
+    _has_samples = false;
+    if (p99 > _cfg.target_latency) {
+        _rate_percent = std::max(min_rate_percent, _rate_percent / 2);
+        vlog(
+          stlog.debug,
+          "foreground p99 {}us above target, compaction rate {} bytes/s",
+          p99.count(),
+          current_rate());
+    } else {
+        _rate_percent = std::min<uint32_t>(
+          100, _rate_percent + recovery_step_percent);
+    }
+}
+
+std::ostream& operator<<(std::ostream& o, const compaction_throttle& t) {
+    fmt::print(
+      o,
+      "{{max_bytes_per_sec:{}, target_latency:{}ms, rate_percent:{}, "
+      "available:{}}}",
+      t._cfg.max_bytes_per_sec,
+      t._cfg.target_latency.count(),
+      t._rate_percent,
+      t._available);
+    return o;
+}
+
+} // namespace storage
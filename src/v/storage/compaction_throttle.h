@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+
+#include <chrono>
+#include <cstdint>
+
+namespace storage {
+
+/**
+ * Token bucket limiting the rate at which compaction reads and rewrites
+ * segment data on a shard.
+ *
+ * The effective rate starts at the configured ceiling. Every window the p99
+ * of the foreground flush latencies reported through
+ * record_foreground_latency() is compared with the target: above it the rate
+ * is halved (down to min_rate_percent of the ceiling), below it the rate
+ * recovers additively. A ceiling of zero disables throttling altogether and a
+ * target of zero disables the backpressure.
+ */
+class compaction_throttle {
+public:
+    using clock_type = ss::lowres_clock;
+    static constexpr std::chrono::seconds window{1};
+    static constexpr uint32_t min_rate_percent = 5;
+    static constexpr uint32_t recovery_step_percent = 10;
+
+    struct config {
+        size_t max_bytes_per_sec{0};
+        std::chrono::milliseconds target_latency{0};
+    };
+
+    compaction_throttle() = default;
+    compaction_throttle(config, ss::abort_source&);
+
+    /// waits until `bytes` may be processed. returns early on abort
+    ss::future<> throttle(size_t bytes);
+
+    void record_foreground_latency(std::chrono::microseconds);
+
+    /// current rate in bytes per second; zero if unthrottled
+    size_t current_rate() const {
+        return (_cfg.max_bytes_per_sec * _rate_percent) / 100;
+    }
+
+private:
+    void refill(clock_type::time_point);
+    void maybe_adjust_rate(clock_type::time_point);
+
+    config _cfg;
+    ss::abort_source* _as{nullptr};
+    uint32_t _rate_percent{100};
+    int64_t _available{0};
+    clock_type::time_point _last_refill{clock_type::now()};
+    clock_type::time_point _window_start{clock_type::now()};
+    hdr_hist _latency;
+    bool _has_samples{false};
+
+    friend std::ostream& operator<<(std::ostream&, const compaction_throttle&);
+};
+
+} // namespace storage
@@ -69,8 +69,11 @@ void disk_log_appender::release_lock() {
 
 ss::future<ss::stop_iteration>
 disk_log_appender::operator()(model::record_batch& batch) {
-    batch.header().base_offset = _idx;
-    batch.header().header_crc = model::internal_header_only_crc(batch.header());
+    // the term is not covered by the header crc
+    if (_config.term) {
+        batch.set_term(*_config.term);
+    }
+    model::assign_base_offset(batch.header(), _idx);
     if (_last_term != batch.term()) {
         release_lock();
     }
@@ -113,7 +116,7 @@ disk_log_appender::append_batch_to_segment(const model::record_batch& batch) {
         return ss::make_ready_future<ss::stop_iteration>(
           ss::stop_iteration::no);
     }
-    return _seg->append(batch).then([this](append_result r) {
+    return _seg->append(batch, _config.cache).then([this](append_result r) {
         _idx = r.last_offset + model::offset(1); // next base offset
         _byte_size += r.byte_size;
         // do not track base_offset, only the last one
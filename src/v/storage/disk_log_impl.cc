@@ -13,7 +13,9 @@
 #include "model/fundamental.h"
 #include "model/timeout_clock.h"
 #include "reflection/adl.h"
+#include "storage/compaction_reducers.h"
 #include "storage/disk_log_appender.h"
+#include "storage/key_lookup.h"
 #include "storage/log_manager.h"
 #include "storage/logger.h"
 #include "storage/offset_assignment.h"
@@ -35,7 +37,10 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iterator>
+#include <limits>
 
 namespace storage {
 
@@ -46,7 +51,8 @@ disk_log_impl::disk_log_impl(
   , _segs(std::move(segs))
   , _kvstore(kvstore)
   , _start_offset(read_start_offset())
-  , _lock_mngr(_segs)
+  , _lock_mngr(_segs, _probe)
+  , _readers_cache(_segs, _probe, manager.config().readers_cache_cfg)
   , _max_segment_size(internal::jitter_segment_size(max_segment_size())) {
     const bool is_compacted = config().is_compacted();
     for (auto& s : _segs) {
@@ -55,7 +61,7 @@ disk_log_impl::disk_log_impl(
             s->mark_as_compacted_segment();
         }
     }
-    _probe.setup_metrics(this->config().ntp());
+    manager.probes().add(_probe, this->config().ntp(), _segs);
 }
 disk_log_impl::~disk_log_impl() {
     vassert(_closed, "log segment must be closed before deleting:{}", *this);
@@ -64,25 +70,31 @@ disk_log_impl::~disk_log_impl() {
 ss::future<> disk_log_impl::remove() {
     vassert(!_closed, "Invalid double closing of log - {}", *this);
     _closed = true;
-    // gets all the futures started in the background
-    std::vector<ss::future<>> permanent_delete;
-    permanent_delete.reserve(_segs.size());
-    while (!_segs.empty()) {
-        auto s = _segs.back();
-        _segs.pop_back();
-        permanent_delete.emplace_back(
-          remove_segment_permanently(s, "disk_log_impl::remove()"));
-    }
-    // wait for all futures
-    return ss::when_all_succeed(
-             permanent_delete.begin(), permanent_delete.end())
+    // parked readers hold the segments
+    return _readers_cache.stop()
+      .then([this] {
+          // gets all the futures started in the background
+          std::vector<ss::future<>> permanent_delete;
+          permanent_delete.reserve(_segs.size());
+          while (!_segs.empty()) {
+              auto s = _segs.back();
+              _segs.pop_back();
+              permanent_delete.emplace_back(
+                remove_segment_permanently(s, "disk_log_impl::remove()"));
+          }
+          // wait for all futures
+          return ss::when_all_succeed(
+            permanent_delete.begin(), permanent_delete.end());
+      })
+      .then([this] { return _removal_gate.close(); })
       .then([this]() {
           vlog(stlog.info, "Finished removing all segments:{}", config());
       })
       .then([this] {
           return _kvstore.remove(
             kvstore::key_space::storage, start_offset_key());
-      });
+      })
+      .then([this] { return close_next_segment(); });
 }
 ss::future<> disk_log_impl::close() {
     vassert(!_closed, "Invalid double closing of log - {}", *this);
@@ -92,13 +104,85 @@ ss::future<> disk_log_impl::close() {
       && !_eviction_monitor->promise.get_future().available()) {
         _eviction_monitor->promise.set_exception(segment_closed_exception());
     }
-    return ss::parallel_for_each(_segs, [](ss::lw_shared_ptr<segment>& h) {
-        return h->close().handle_exception([h](std::exception_ptr e) {
-            vlog(stlog.error, "Error closing segment:{} - {}", e, h);
-        });
+    _committed_monitor.stop();
+    // parked readers hold the segments
+    return _readers_cache.stop()
+      .then([this] {
+          return ss::parallel_for_each(
+            _segs, [](ss::lw_shared_ptr<segment>& h) {
+                return h->close().handle_exception([h](std::exception_ptr e) {
+                    vlog(stlog.error, "Error closing segment:{} - {}", e, h);
+                });
+            });
+      })
+      .then([this] { return _removal_gate.close(); })
+      .then([this] { return close_next_segment(); });
+}
+
+ss::future<> disk_log_impl::close_next_segment() {
+    return _prepare_gate.close().then([this] {
+        if (!_next_segment) {
+            return ss::now();
+        }
+        return _next_segment->close().finally(
+          [this] { _next_segment.reset(); });
+    });
+}
+
+void disk_log_impl::maybe_prepare_segment(const segment& active) {
+    const auto percent = _manager.config().segment_prepare_percent;
+    if (
+      percent == 0 || _preparing || _next_segment
+      || _prepare_gate.is_closed()) {
+        return;
+    }
+    // the next segment is opened while the active one fills up
+    const auto filled = active.appender().file_byte_offset() * 100;
+    if (filled < _max_segment_size * percent) {
+        return;
+    }
+    _preparing = true;
+    (void)ss::with_gate(_prepare_gate, [this] {
+        return _manager.prepare_log_segment(config())
+          .then([this](prepared_segment_files files) {
+              _next_segment = std::move(files);
+          })
+          .handle_exception([this](std::exception_ptr e) {
+              vlog(
+                stlog.warn,
+                "Error preparing the next segment of {}: {}",
+                config().ntp(),
+                e);
+          })
+          .finally([this] { _preparing = false; });
     });
 }
 
+ss::future<ss::lw_shared_ptr<segment>> disk_log_impl::make_next_segment(
+  model::offset o, model::term_id t, ss::io_priority_class pc) {
+    if (!_next_segment) {
+        return _manager.make_log_segment(config(), o, t, pc);
+    }
+    auto files = std::move(*_next_segment);
+    _next_segment.reset();
+    if (files.compaction_index.has_value() != config().is_compacted()) {
+        return ss::do_with(std::move(files), [this, o, t, pc](auto& files) {
+            return files.close().then([this, o, t, pc] {
+                return _manager.make_log_segment(config(), o, t, pc);
+            });
+        });
+    }
+    return _manager.make_log_segment(config(), o, t, pc, std::move(files))
+      .handle_exception([this, o, t, pc](std::exception_ptr e) {
+          vlog(
+            stlog.warn,
+            "Error rolling to the prepared segment of {}: {}",
+            config().ntp(),
+            e);
+          return _manager.make_log_segment(config(), o, t, pc);
+      });
+}
+
 model::offset disk_log_impl::size_based_gc_max_offset(size_t max_size) {
     size_t reclaimed_size = 0;
     model::offset ret;
@@ -170,6 +254,15 @@ disk_log_impl::monitor_eviction(ss::abort_source& as) {
       .promise.get_future();
 }
 
+ss::future<model::offset> disk_log_impl::wait_for_committed_offset(
+  model::offset o, ss::abort_source& as) {
+    if (_closed) {
+        return ss::make_exception_future<model::offset>(
+          segment_closed_exception());
+    }
+    return _committed_monitor.wait(o, offsets().committed_offset, as);
+}
+
 void disk_log_impl::set_collectible_offset(model::offset o) {
     _max_collectible_offset = o;
 }
@@ -200,6 +293,8 @@ ss::future<> disk_log_impl::garbage_collect_segments(
       },
       [this, ctx] {
           auto ptr = _segs.front();
+          auto guard = _readers_cache.evict_range(
+            ptr->offsets().base_offset, ptr->offsets().dirty_offset);
           // we have to use std::max in here to prevent start_offset from being
           // `moved backward`. The _kvstore.put calls may be reordered and we do
           // not want to update kvstore with stall data. We leverage the fact
@@ -226,7 +321,8 @@ ss::future<> disk_log_impl::garbage_collect_segments(
                 // execute then independently from `gc` and `prefix_truncate`
                 // apis)
                 _start_offset = read_start_offset();
-            });
+            })
+            .finally([g = std::move(guard)] {});
       });
 }
 
@@ -251,14 +347,47 @@ ss::future<> disk_log_impl::do_compact(compaction_config cfg) {
       });
     if (segit != _segs.end()) {
         auto seg = *segit;
+        const auto before = seg->size_bytes();
+        auto guard = _readers_cache.evict_range(
+          seg->offsets().base_offset, seg->offsets().dirty_offset);
         return storage::internal::self_compact_segment(seg, cfg, _probe)
-          .finally([seg] { seg->mark_as_finished_self_compaction(); });
+          .then([this, seg, before] {
+              _probe.add_compaction_result(before, seg->size_bytes());
+          })
+          .finally([seg, g = std::move(guard)] {
+              seg->mark_as_finished_self_compaction();
+          });
     }
     // all segments are self-compacted
     // do cross segment compaction
-    return ss::now();
+    std::vector<ss::lw_shared_ptr<segment>> segs;
+    for (auto& s : _segs) {
+        if (s->has_appender() || !s->is_compacted_segment()) {
+            break;
+        }
+        segs.push_back(s);
+    }
+    // nothing was sealed since the last pass
+    if (
+      segs.size() < 2
+      || segs.back()->offsets().dirty_offset <= _cross_compacted_offset) {
+        return ss::now();
+    }
+    auto end = segs.back()->offsets().dirty_offset;
+    auto guard = _readers_cache.evict_range(
+      segs.front()->offsets().base_offset, end);
+    return storage::internal::cross_compact_segments(
+             std::move(segs),
+             cfg,
+             _probe,
+             internal::compaction_key_map_reducer::default_max_memory_usage)
+      .then([this, end] { _cross_compacted_offset = end; })
+      .finally([g = std::move(guard)] {});
 }
 ss::future<> disk_log_impl::compact(compaction_config cfg) {
+    if (config().has_overrides()) {
+        cfg.compression = config().get_overrides().compression;
+    }
     ss::future<> f = ss::now();
     if (config().is_collectable()) {
         f = gc(cfg);
@@ -273,11 +402,93 @@ ss::future<> disk_log_impl::compact(compaction_config cfg) {
         f = ss::now();
     }
     if (config().is_compacted() && !_segs.empty()) {
-        f = f.then([this, cfg] { return do_compact(cfg); });
+        f = f.then([this, cfg] { return do_compact(cfg); }).finally([this] {
+            _probe.set_compaction_backlog(backlog());
+        });
+    } else if (config().is_collectable()) {
+        // compaction rewrites in the topic codec, others are rewritten on
+        // their own while the log is idle, one segment per pass
+        if (cfg.compression) {
+            f = f.then([this, cfg] { return recompress(cfg); });
+        }
+        // compacted segments are rewritten in place, they stay local
+        if (cfg.cold_storage_time && cfg.cold_storage_dir) {
+            f = f.then([this, cfg] { return move_to_cold_storage(cfg); });
+        }
     }
     return f;
 }
 
+ss::future<> disk_log_impl::recompress(compaction_config cfg) {
+    auto segit = std::find_if(
+      _segs.begin(), _segs.end(), [](ss::lw_shared_ptr<segment>& s) {
+          return s->has_appender()
+                 || (!s->reader().is_cold() && !s->finished_recompression());
+      });
+    if (
+      segit == _segs.end() || (*segit)->has_appender()
+      || cfg.asrc->abort_requested()) {
+        return ss::now();
+    }
+    auto seg = *segit;
+    auto guard = _readers_cache.evict_range(
+      seg->offsets().base_offset, seg->offsets().dirty_offset);
+    return internal::recompress_segment(seg, cfg, _probe)
+      .finally([seg, g = std::move(guard)] {
+          seg->mark_as_finished_recompression();
+      });
+}
+
+ss::future<> disk_log_impl::move_to_cold_storage(compaction_config cfg) {
+    // internal logs are read on startup, they stay local
+    constexpr std::string_view redpanda_ignored_ns = "redpanda";
+    constexpr std::string_view kafka_ignored_ns = "kafka_internal";
+    if (
+      config().ntp().ns() == redpanda_ignored_ns
+      || config().ntp().ns() == kafka_ignored_ns) {
+        return ss::now();
+    }
+    std::vector<ss::lw_shared_ptr<segment>> segs;
+    for (auto& s : _segs) {
+        if (
+          s->has_appender()
+          || s->index().max_timestamp() > *cfg.cold_storage_time) {
+            break;
+        }
+        if (!s->reader().is_cold()) {
+            segs.push_back(s);
+        }
+    }
+    if (segs.empty()) {
+        return ss::now();
+    }
+    auto dir = std::filesystem::path(*cfg.cold_storage_dir)
+               / config().ntp().path();
+    return ss::do_with(
+      std::move(segs),
+      [this, cfg, dir = std::move(dir)](
+        std::vector<ss::lw_shared_ptr<segment>>& segs) {
+          return ss::do_for_each(
+            segs, [this, cfg, dir](ss::lw_shared_ptr<segment>& s) {
+                if (cfg.asrc->abort_requested() || s->is_closed()) {
+                    return ss::now();
+                }
+                auto guard = _readers_cache.evict_range(
+                  s->offsets().base_offset, s->offsets().dirty_offset);
+                return internal::move_segment_to_cold_storage(
+                         s, dir, cfg, _probe)
+                  .handle_exception([s](const std::exception_ptr& e) {
+                      vlog(
+                        stlog.warn,
+                        "Error moving segment {} to the storage tier - {}",
+                        s,
+                        e);
+                  })
+                  .finally([g = std::move(guard)] {});
+            });
+      });
+}
+
 ss::future<> disk_log_impl::gc(compaction_config cfg) {
     vassert(!_closed, "gc on closed log - {}", *this);
 
@@ -321,6 +532,87 @@ model::term_id disk_log_impl::term() const {
     return _segs.back()->offsets().term;
 }
 
+std::vector<segment_file> disk_log_impl::closed_segments() const {
+    std::vector<segment_file> ret;
+    for (auto& s : _segs) {
+        if (s->has_appender() || s->is_closed()) {
+            break;
+        }
+        ret.push_back(segment_file{
+          .base_offset = s->offsets().base_offset,
+          .committed_offset = s->offsets().committed_offset,
+          .term = s->offsets().term,
+          .max_timestamp = s->index().max_timestamp(),
+          .size_bytes = s->reader().file_size(),
+          .data_path = s->reader().filename(),
+          .index_path = s->index().filename(),
+        });
+    }
+    return ret;
+}
+
+compaction_backlog disk_log_impl::backlog() const {
+    compaction_backlog ret;
+    if (!config().is_compacted()) {
+        return ret;
+    }
+    // mirrors do_compact(): segments are compacted alone first, then the
+    // closed compacted prefix is compacted across once it has two segments
+    size_t prefix = 0;
+    size_t sealed = 0;
+    for (auto& s : _segs) {
+        if (s->has_appender() || !s->is_compacted_segment()) {
+            break;
+        }
+        ++prefix;
+        const auto bytes = s->size_bytes();
+        if (!s->finished_self_compaction()) {
+            ret.dirty_bytes += bytes;
+        } else if (s->offsets().dirty_offset > _cross_compacted_offset) {
+            sealed += bytes;
+        } else {
+            ret.clean_bytes += bytes;
+        }
+    }
+    if (prefix < 2) {
+        ret.clean_bytes += sealed;
+    } else {
+        ret.dirty_bytes += sealed;
+    }
+    ret.reclaimable_bytes = static_cast<size_t>(
+      ret.dirty_bytes * (1.0 - _probe.compaction_ratio()));
+    return ret;
+}
+
+size_t
+disk_log_impl::size_bytes(model::offset first, model::offset last) const {
+    size_t ret = 0;
+    for (auto& seg : _segs) {
+        auto& o = seg->offsets();
+        if (o.base_offset <= last && o.dirty_offset >= first) {
+            ret += seg->size_bytes();
+        }
+    }
+    return ret;
+}
+
+std::optional<model::offset> disk_log_impl::tail_offset(size_t bytes) {
+    if (_segs.empty()) {
+        return std::nullopt;
+    }
+    auto& seg = _segs.back();
+    if (!seg->has_appender() || !seg->has_cache() || seg->empty()) {
+        return std::nullopt;
+    }
+    const auto size = seg->size_bytes();
+    if (size > bytes) {
+        if (auto e = seg->index().find_nearest_position(size - bytes); e) {
+            return e->offset;
+        }
+    }
+    return seg->offsets().base_offset;
+}
+
 offset_stats disk_log_impl::offsets() const {
     if (_segs.empty()) {
         offset_stats ret;
@@ -382,7 +674,7 @@ ss::future<> disk_log_impl::new_segment(
   model::offset o, model::term_id t, ss::io_priority_class pc) {
     vassert(
       o() >= 0 && t() >= 0, "offset:{} and term:{} must be initialized", o, t);
-    return _manager.make_log_segment(config(), o, t, pc)
+    return make_next_segment(o, t, pc)
       .then([this](ss::lw_shared_ptr<segment> handles) mutable {
           return remove_empty_segments().then(
             [this, h = std::move(handles)]() mutable {
@@ -390,6 +682,7 @@ ss::future<> disk_log_impl::new_segment(
                 if (config().is_compacted()) {
                     h->mark_as_compacted_segment();
                 }
+                h->index().set_density(index_density());
                 _segs.add(std::move(h));
                 _probe.segment_created();
             });
@@ -429,7 +722,16 @@ ss::future<> disk_log_impl::flush() {
     if (_segs.empty()) {
         return ss::make_ready_future<>();
     }
-    return _segs.back()->flush();
+    // flush latency is the foreground signal compaction backs off on
+    const auto start = std::chrono::steady_clock::now();
+    return _segs.back()->flush().then([this, start] {
+        _manager.throttle().record_foreground_latency(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start));
+        if (!_committed_monitor.empty()) {
+            _committed_monitor.notify(offsets().committed_offset);
+        }
+    });
 }
 
 size_t disk_log_impl::max_segment_size() const {
@@ -443,6 +745,20 @@ size_t disk_log_impl::max_segment_size() const {
              : _manager.config().max_segment_size;
 }
 
+segment_index::density disk_log_impl::index_density() const {
+    // a topic interval always gives a fixed density
+    if (config().has_overrides() && config().get_overrides().index_interval) {
+        return segment_index::density{
+          .step = *config().get_overrides().index_interval,
+          .adaptive = false,
+          .segment_bytes = _max_segment_size};
+    }
+    return segment_index::density{
+      .step = _manager.config().index_interval,
+      .adaptive = _manager.config().adaptive_index,
+      .segment_bytes = _max_segment_size};
+}
+
 size_t disk_log_impl::bytes_left_before_roll() const {
     if (_segs.empty()) {
         return 0;
@@ -467,7 +783,11 @@ ss::future<> disk_log_impl::maybe_roll(
     }
     auto ptr = _segs.back();
     if (!ptr->has_appender()) {
-        return new_segment(next_offset, t, iopc);
+        // empty segments at the end of the log are closed by the roll
+        auto guard = _readers_cache.evict_range(
+          ptr->offsets().base_offset, model::offset::max());
+        return new_segment(next_offset, t, iopc)
+          .finally([g = std::move(guard)] {});
     }
     bool size_should_roll = false;
 
@@ -475,10 +795,23 @@ ss::future<> disk_log_impl::maybe_roll(
         size_should_roll = true;
     }
     if (t != term() || size_should_roll) {
-        return ptr->release_appender().then([this, next_offset, t, iopc] {
-            return new_segment(next_offset, t, iopc);
-        });
+        const auto start = std::chrono::steady_clock::now();
+        const bool prepared = _next_segment.has_value();
+        // readers parked on the active segment would hold up the release of
+        // its appender, and no longer reach the end of the log after the roll
+        auto guard = _readers_cache.evict_range(
+          ptr->offsets().base_offset, model::offset::max());
+        return ptr->release_appender()
+          .then([this, next_offset, t, iopc] {
+              return new_segment(next_offset, t, iopc);
+          })
+          .then([this, start, prepared] {
+              _probe.segment_rolled(
+                std::chrono::steady_clock::now() - start, prepared);
+          })
+          .finally([g = std::move(guard)] {});
     }
+    maybe_prepare_segment(*ptr);
     return ss::make_ready_future<>();
 }
 
@@ -502,19 +835,42 @@ disk_log_impl::make_reader(log_reader_config config) {
             config.start_offset,
             _start_offset)));
     }
-    return make_unchecked_reader(config);
+    if (auto r = _readers_cache.get(config); r) {
+        return ss::make_ready_future<model::record_batch_reader>(
+          std::move(*r));
+    }
+    return _lock_mngr.range_lock(config).then(
+      [this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
+          return _readers_cache.put(
+            std::make_unique<log_reader>(std::move(lease), cfg, _probe));
+      });
 }
 
 ss::future<model::record_batch_reader>
 disk_log_impl::make_reader(timequery_config config) {
     vassert(!_closed, "make_reader on closed log - {}", *this);
-    return _lock_mngr.range_lock(config).then(
-      [this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
+    return _lock_mngr.range_lock(config)
+      .then([](std::unique_ptr<lock_manager::lease> lease) {
+          if (lease->range.empty()) {
+              return ss::make_ready_future<
+                std::unique_ptr<lock_manager::lease>>(std::move(lease));
+          }
+          // the time index of the first segment is searched for where to
+          // start scanning, it may have been evicted
+          auto& idx = (*lease->range.begin())->index();
+          return idx.hydrate().then([lease = std::move(lease)]() mutable {
+              return std::move(lease);
+          });
+      })
+      .then([this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
           auto start_offset = _start_offset;
           if (!lease->range.empty()) {
+              auto& seg = *lease->range.begin();
               // adjust for partial visibility of segment prefix
-              start_offset = std::max(
-                start_offset, (*lease->range.begin())->offsets().base_offset);
+              start_offset = std::max(start_offset, seg->offsets().base_offset);
+              if (auto e = seg->index().find_nearest(cfg.time); e) {
+                  start_offset = std::max(start_offset, e->offset);
+              }
           }
           log_reader_config config(
             start_offset,
@@ -564,6 +920,112 @@ disk_log_impl::timequery(timequery_config cfg) {
       });
 }
 
+ss::future<std::optional<key_lookup_result>>
+disk_log_impl::lookup_key(key_lookup_config cfg) {
+    vassert(!_closed, "lookup_key on closed log - {}", *this);
+    using ret_t = std::optional<key_lookup_result>;
+    // a snapshot, the segment set changes while the lookup waits on reads
+    std::vector<ss::lw_shared_ptr<segment>> segs;
+    for (auto& s : _segs) {
+        if (s->offsets().base_offset <= cfg.max_offset) {
+            segs.push_back(s);
+        }
+    }
+    // the newest record of the key is in the newest segment holding it
+    std::reverse(segs.begin(), segs.end());
+    return ss::do_with(
+      std::move(segs),
+      size_t(0),
+      ret_t{},
+      std::move(cfg),
+      [this](
+        std::vector<ss::lw_shared_ptr<segment>>& segs,
+        size_t& i,
+        ret_t& ret,
+        key_lookup_config& cfg) {
+          return ss::do_until(
+                   [&] { return ret || i == segs.size(); },
+                   [&] {
+                       return lookup_key_in_segment(segs[i++], cfg)
+                         .then([&ret](ret_t r) { ret = std::move(r); });
+                   })
+            .then([&ret] { return std::move(ret); });
+      });
+}
+
+ss::future<std::optional<key_lookup_result>>
+disk_log_impl::lookup_key_in_segment(
+  ss::lw_shared_ptr<segment> s, const key_lookup_config& cfg) {
+    using ret_t = std::optional<key_lookup_result>;
+    if (s->is_closed()) {
+        // removed since the lookup started
+        return ss::make_ready_future<ret_t>();
+    }
+    const auto first = std::max(s->offsets().base_offset, _start_offset);
+    const auto last = std::min(s->offsets().dirty_offset, cfg.max_offset);
+    if (first > last) {
+        return ss::make_ready_future<ret_t>();
+    }
+    // the index of the active segment is written behind the appends
+    if (!config().is_compacted() || s->has_appender()) {
+        return scan_for_key(first, last, cfg);
+    }
+    return internal::compacted_index_key_offsets(
+             internal::compacted_index_path(s->reader().filename().c_str()),
+             cfg.key,
+             cfg.prio,
+             _manager.config().sanitize_fileops)
+      .then([this, first, last, &cfg](
+              std::optional<std::vector<model::offset>> offsets) {
+          if (!offsets) {
+              return scan_for_key(first, last, cfg);
+          }
+          auto& o = *offsets;
+          o.erase(
+            std::remove_if(
+              o.begin(),
+              o.end(),
+              [first, last](model::offset x) { return x < first || x > last; }),
+            o.end());
+          // newest first, an offset whose record is not the key is skipped
+          return ss::do_with(
+            std::move(o),
+            size_t(0),
+            ret_t{},
+            [this, &cfg](
+              std::vector<model::offset>& o, size_t& i, ret_t& ret) {
+                return ss::do_until(
+                         [&] { return ret || i == o.size(); },
+                         [&] {
+                             const auto x = o[i++];
+                             return scan_for_key(x, x, cfg).then(
+                               [&ret](ret_t r) { ret = std::move(r); });
+                         })
+                  .then([&ret] { return std::move(ret); });
+            });
+      });
+}
+
+ss::future<std::optional<key_lookup_result>> disk_log_impl::scan_for_key(
+  model::offset first, model::offset last, const key_lookup_config& cfg) {
+    // only data batches hold the records of users, raft::data_batch_type
+    log_reader_config reader_cfg(
+      first,
+      last,
+      0,
+      std::numeric_limits<size_t>::max(),
+      cfg.prio,
+      model::record_batch_type(1),
+      std::nullopt,
+      cfg.abort_source);
+    // lookups read once, they must not displace the tail of the log
+    reader_cfg.skip_batch_cache = true;
+    return make_unchecked_reader(reader_cfg)
+      .then([&cfg, last](model::record_batch_reader r) {
+          return internal::find_latest_record(std::move(r), cfg.key, last);
+      });
+}
+
 ss::future<> disk_log_impl::remove_segment_permanently(
   ss::lw_shared_ptr<segment> s, std::string_view ctx) {
     vlog(stlog.info, "{} - tombstone & delete segment: {}", ctx, s);
@@ -571,6 +1033,13 @@ ss::future<> disk_log_impl::remove_segment_permanently(
     _probe.delete_segment(*s);
     // background close
     s->tombstone();
+    // cold segments are on another file system
+    auto& pool = _manager.segment_pool();
+    const auto& base = config().base_directory();
+    const bool recycle = !s->reader().is_cold() && pool.wants(base);
+    if (recycle) {
+        s->keep_data_file();
+    }
     if (s->has_outstanding_locks()) {
         vlog(
           stlog.info,
@@ -581,6 +1050,15 @@ ss::future<> disk_log_impl::remove_segment_permanently(
       .handle_exception([s](std::exception_ptr e) {
           vlog(stlog.error, "Cannot close segment: {} - {}", e, s);
       })
+      .then([&pool, base, s, recycle] {
+          if (!recycle) {
+              return ss::now();
+          }
+          return pool.put(base, s->reader().filename().c_str())
+            .handle_exception([s](std::exception_ptr e) {
+                vlog(stlog.info, "Cannot recycle segment: {} - {}", e, s);
+            });
+      })
       .finally([s] {});
 }
 
@@ -597,26 +1075,34 @@ ss::future<> disk_log_impl::remove_full_segments(model::offset o) {
           return remove_segment_permanently(ptr, "remove_full_segments");
       });
 }
-ss::future<>
-disk_log_impl::remove_prefix_full_segments(truncate_prefix_config cfg) {
-    return ss::do_until(
-      [this, cfg] {
-          return _segs.empty()
-                 || _segs.front()->offsets().dirty_offset >= cfg.start_offset;
-      },
-      [this] {
-          auto ptr = _segs.front();
-          _segs.pop_front();
-          return remove_segment_permanently(ptr, "remove_prefix_full_segments");
-      });
+void disk_log_impl::remove_prefix_full_segments(truncate_prefix_config cfg) {
+    // the log is closing, the segments are closed along with it
+    if (_removal_gate.is_closed()) {
+        return;
+    }
+    while (!_segs.empty()
+           && _segs.front()->offsets().dirty_offset < cfg.start_offset) {
+        auto ptr = _segs.front();
+        _segs.pop_front();
+        // closing waits for the readers of the segment, the new start offset
+        // must not. the segments are out of the set, so nothing new reads them
+        (void)ss::with_gate(_removal_gate, [this, ptr] {
+            return remove_segment_permanently(
+              ptr, "remove_prefix_full_segments");
+        });
+    }
 }
 
 ss::future<> disk_log_impl::truncate_prefix(truncate_prefix_config cfg) {
     vassert(!_closed, "truncate_prefix() on closed log - {}", *this);
-    return _failure_probes.truncate_prefix().then([this, cfg]() mutable {
-        // dispatch the actual truncation
-        return do_truncate_prefix(cfg);
-    });
+    auto guard = _readers_cache.evict_range(
+      model::offset::min(), cfg.start_offset);
+    return _failure_probes.truncate_prefix()
+      .then([this, cfg]() mutable {
+          // dispatch the actual truncation
+          return do_truncate_prefix(cfg);
+      })
+      .finally([g = std::move(guard)] {});
 }
 
 ss::future<> disk_log_impl::do_truncate_prefix(truncate_prefix_config cfg) {
@@ -635,9 +1121,10 @@ ss::future<> disk_log_impl::do_truncate_prefix(truncate_prefix_config cfg) {
       .then([this, cfg] {
           /*
            * Then delete all segments (potentially including the active segment)
-           * whose max offset falls below the new starting offset.
+           * whose max offset falls below the new starting offset. The files are
+           * removed in the background, see remove_prefix_full_segments.
            */
-          return remove_prefix_full_segments(cfg);
+          remove_prefix_full_segments(cfg);
       })
       .then([this] {
           /*
@@ -686,10 +1173,14 @@ ss::future<> disk_log_impl::do_truncate_prefix(truncate_prefix_config cfg) {
 
 ss::future<> disk_log_impl::truncate(truncate_config cfg) {
     vassert(!_closed, "truncate() on closed log - {}", *this);
-    return _failure_probes.truncate().then([this, cfg]() mutable {
-        // dispatch the actual truncation
-        return do_truncate(cfg);
-    });
+    auto guard = _readers_cache.evict_range(
+      cfg.base_offset, model::offset::max());
+    return _failure_probes.truncate()
+      .then([this, cfg]() mutable {
+          // dispatch the actual truncation
+          return do_truncate(cfg);
+      })
+      .finally([g = std::move(guard)] {});
 }
 
 ss::future<> disk_log_impl::do_truncate(truncate_config cfg) {
@@ -722,8 +1213,15 @@ ss::future<> disk_log_impl::do_truncate(truncate_config cfg) {
         start = pidx->offset;
         initial_size = pidx->filepos;
     }
+    // truncations at one of the last batches need not scan the segment
+    auto exact = last.index().find_batch(cfg.base_offset);
     return last.flush()
-      .then([this, cfg, start, initial_size] {
+      .then([this, cfg, start, initial_size, exact] {
+          using type = internal::offset_to_filepos_consumer::type;
+          if (exact) {
+              return ss::make_ready_future<type>(std::make_pair(
+                cfg.base_offset - model::offset(1), exact->filepos));
+          }
           // an unchecked reader is created which does not enforce the logical
           // starting offset. this is needed because we really do want to read
           // all the data in the segment to find the correct physical offset.
@@ -772,10 +1270,9 @@ ss::future<> disk_log_impl::do_truncate(truncate_config cfg) {
       });
 }
 
-bytes disk_log_impl::start_offset_key() const {
+bytes disk_log_impl::start_offset_key(const model::ntp& ntp) {
     iobuf buf;
-    auto ntp = config().ntp();
-    reflection::serialize(buf, kvstore_key_type::start_offset, std::move(ntp));
+    reflection::serialize(buf, kvstore_key_type::start_offset, ntp);
     return iobuf_to_bytes(buf);
 }
 
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "model/fundamental.h"
+#include "storage/committed_offset_monitor.h"
 #include "storage/disk_log_appender.h"
 #include "storage/failure_probes.h"
 #include "storage/kvstore.h"
@@ -19,6 +20,7 @@
 #include "storage/log.h"
 #include "storage/log_reader.h"
 #include "storage/probe.h"
+#include "storage/readers_cache.h"
 #include "storage/segment_appender.h"
 #include "storage/segment_reader.h"
 #include "storage/types.h"
@@ -50,6 +52,8 @@ public:
     ss::future<> compact(compaction_config) final;
 
     ss::future<model::offset> monitor_eviction(ss::abort_source&) final;
+    ss::future<model::offset>
+      wait_for_committed_offset(model::offset, ss::abort_source&) final;
     void set_collectible_offset(model::offset) final;
 
     ss::future<model::record_batch_reader> make_reader(log_reader_config) final;
@@ -59,8 +63,17 @@ public:
     /// timequery
     ss::future<std::optional<timequery_result>>
     timequery(timequery_config cfg) final;
+    ss::future<std::optional<key_lookup_result>>
+      lookup_key(key_lookup_config) final;
     size_t segment_count() const final { return _segs.size(); }
+    std::vector<segment_file> closed_segments() const final;
+    compaction_backlog backlog() const final;
     offset_stats offsets() const final;
+    size_t size_bytes(model::offset, model::offset) const final;
+    std::optional<model::offset> tail_offset(size_t) final;
+    uint64_t batch_cache_misses() const final {
+        return _probe.batch_cache_misses();
+    }
     std::optional<model::term_id> get_term(model::offset) const final;
     std::ostream& print(std::ostream&) const final;
 
@@ -71,11 +84,13 @@ public:
     model::term_id term() const;
     segment_set& segments() { return _segs; }
     const segment_set& segments() const { return _segs; }
+    const readers_cache& readers() const { return _readers_cache; }
     size_t bytes_left_before_roll() const;
 
 private:
     friend class disk_log_appender; // for multi-term appends
     friend class disk_log_builder;  // for tests
+    friend class log_manager;       // for kvstore_keys
     friend std::ostream& operator<<(std::ostream& o, const disk_log_impl& d);
 
     // key types used to store data in key-value store
@@ -86,11 +101,21 @@ private:
     ss::future<model::record_batch_reader>
       make_unchecked_reader(log_reader_config);
 
-    bytes start_offset_key() const;
+    ss::future<std::optional<key_lookup_result>>
+    lookup_key_in_segment(ss::lw_shared_ptr<segment>, const key_lookup_config&);
+    /// latest record of the key in the data batches of [first, last]
+    ss::future<std::optional<key_lookup_result>> scan_for_key(
+      model::offset first, model::offset last, const key_lookup_config&);
+
+    bytes start_offset_key() const { return start_offset_key(config().ntp()); }
+    static bytes start_offset_key(const model::ntp&);
     model::offset read_start_offset() const;
 
     ss::future<> do_compact(compaction_config);
     ss::future<> gc(compaction_config);
+    ss::future<> move_to_cold_storage(compaction_config);
+    /// rewrites the oldest closed segment not yet in the topic codec
+    ss::future<> recompress(compaction_config);
 
     ss::future<> remove_empty_segments();
 
@@ -102,12 +127,19 @@ private:
       model::offset starting_offset,
       model::term_id term_for_this_segment,
       ss::io_priority_class prio);
+    /// \brief the next segment, from the prepared files when there are
+    ss::future<ss::lw_shared_ptr<segment>>
+      make_next_segment(model::offset, model::term_id, ss::io_priority_class);
+    /// \brief prepares the files of the next segment in the background once
+    /// the active segment passes log_config::segment_prepare_percent
+    void maybe_prepare_segment(const segment& active);
+    ss::future<> close_next_segment();
 
     ss::future<> do_truncate(truncate_config);
     ss::future<> remove_full_segments(model::offset o);
 
     ss::future<> do_truncate_prefix(truncate_prefix_config);
-    ss::future<> remove_prefix_full_segments(truncate_prefix_config);
+    void remove_prefix_full_segments(truncate_prefix_config);
 
     ss::future<>
     garbage_collect_max_partition_size(size_t max_bytes, ss::abort_source*);
@@ -122,6 +154,7 @@ private:
 
 private:
     size_t max_segment_size() const;
+    segment_index::density index_density() const;
     struct eviction_monitor {
         ss::promise<model::offset> promise;
         ss::abort_source::subscription subscription;
@@ -132,11 +165,21 @@ private:
     kvstore& _kvstore;
     model::offset _start_offset;
     lock_manager _lock_mngr;
+    readers_cache _readers_cache;
     storage::probe _probe;
     failure_probes _failure_probes;
     std::optional<eviction_monitor> _eviction_monitor;
+    committed_offset_monitor _committed_monitor;
     model::offset _max_collectible_offset;
+    // dirty offset of the newest segment covered by cross segment compaction
+    model::offset _cross_compacted_offset{model::offset::min()};
     size_t _max_segment_size;
+    // files of the next segment, opened ahead of the roll
+    std::optional<prepared_segment_files> _next_segment;
+    bool _preparing{false};
+    ss::gate _prepare_gate;
+    // background removal of the segments dropped by prefix truncation
+    ss::gate _removal_gate;
 };
 
 } // namespace storage
@@ -0,0 +1,50 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/flush_coordinator.h"
+
+namespace storage::internal {
+
+flush_coordinator::flush_coordinator() noexcept {
+    _timer.set_callback([this] { dispatch(); });
+}
+
+ss::future<> flush_coordinator::flush(const void* owner, ss::file f) {
+    ++_stats.requests;
+    if (auto it = _queued.find(owner); it != _queued.end()) {
+        return it->second->done.get_shared_future();
+    }
+    auto p = ss::make_lw_shared<pending>(std::move(f));
+    _queued.emplace(owner, p);
+    _order.push_back(p);
+    if (!_timer.armed()) {
+        _timer.arm(_window);
+    }
+    return p->done.get_shared_future();
+}
+
+void flush_coordinator::dispatch() {
+    _queued.clear();
+    auto batch = std::exchange(_order, {});
+    ++_stats.batches;
+    _stats.syncs += batch.size();
+    // waiters are resolved as their own file is synced; the batch only shares
+    // the point in time at which the syncs are issued
+    for (auto& p : batch) {
+        (void)p->file.flush().then_wrapped([p](ss::future<> f) {
+            if (f.failed()) {
+                p->done.set_exception(f.get_exception());
+            } else {
+                p->done.set_value();
+            }
+        });
+    }
+}
+
+} // namespace storage::internal
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace storage::internal {
+
+/**
+ * Group commit for the fdatasync calls of every segment appender on a shard.
+ *
+ * Flush requests are queued for a short window, then the syncs of all the
+ * queued files are issued together and every waiter completes when the sync
+ * of its file does. Requests for a file that already has a queued (not yet
+ * issued) sync join it, so N concurrent flushes of one log cost one
+ * fdatasync. A request never joins a sync that is already in flight since
+ * that sync may not cover the writes that preceded the request.
+ *
+ * A window of zero still batches every request made before the reactor
+ * polls timers again.
+ */
+class flush_coordinator {
+public:
+    struct stats {
+        // flush requests received
+        uint64_t requests{0};
+        // fdatasync calls issued
+        uint64_t syncs{0};
+        // batches of syncs dispatched together
+        uint64_t batches{0};
+
+        uint64_t coalesced() const { return requests - syncs; }
+    };
+
+    flush_coordinator() noexcept;
+    flush_coordinator(const flush_coordinator&) = delete;
+    flush_coordinator& operator=(const flush_coordinator&) = delete;
+    flush_coordinator(flush_coordinator&&) = delete;
+    flush_coordinator& operator=(flush_coordinator&&) = delete;
+    ~flush_coordinator() noexcept = default;
+
+    /// resolves once `f` was synced by an fdatasync issued after this call.
+    /// `owner` identifies the file for coalescing
+    ss::future<> flush(const void* owner, ss::file f);
+
+    void set_window(std::chrono::microseconds w) { _window = w; }
+    const stats& get_stats() const { return _stats; }
+
+private:
+    struct pending {
+        explicit pending(ss::file f) noexcept
+          : file(std::move(f)) {}
+
+        ss::file file;
+        ss::shared_promise<> done;
+    };
+    using pending_ptr = ss::lw_shared_ptr<pending>;
+
+    void dispatch();
+
+    std::chrono::microseconds _window{0};
+    absl::flat_hash_map<const void*, pending_ptr> _queued;
+    std::vector<pending_ptr> _order;
+    ss::timer<> _timer;
+    stats _stats;
+};
+
+inline flush_coordinator& flushes() {
+    static thread_local flush_coordinator coordinator;
+    return coordinator;
+}
+
+} // namespace storage::internal
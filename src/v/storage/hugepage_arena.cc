@@ -0,0 +1,110 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/hugepage_arena.h"
+
+#include "storage/logger.h"
+#include "vassert.h"
+#include "vlog.h"
+
+#include <seastar/core/temporary_buffer.hh>
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace storage::internal {
+
+void hugepage_arena::start(size_t bytes) {
+    vassert(!enabled(), "hugepage arena is already started");
+    const auto num_pages = bytes / page_size;
+    _pages.reserve(num_pages);
+    _free_pages.reserve(num_pages);
+    for (size_t i = 0; i < num_pages; ++i) {
+        auto page = ss::allocate_aligned_buffer<char>(page_size, page_size);
+        // best effort, the page still serves as a regular one otherwise
+        if (::madvise(page.get(), page_size, MADV_HUGEPAGE) != 0) {
+            vlog(
+              stlog.debug,
+              "madvise(MADV_HUGEPAGE) failed: {}",
+              std::strerror(errno));
+        }
+        _free_pages.push_back(page.get());
+        _pages.push_back(std::move(page));
+    }
+    vlog(stlog.info, "hugepage arena of {} pages", num_pages);
+}
+
+size_t hugepage_arena::slot_class(size_t size) {
+    size_t c = 0;
+    while ((min_slot_size << c) < size) {
+        ++c;
+    }
+    return c;
+}
+
+char* hugepage_arena::allocate(size_t size) {
+    if (size > max_slot_size) {
+        return nullptr;
+    }
+    const auto c = slot_class(size);
+    auto& slots = _free_slots[c];
+    const size_t slot_size = min_slot_size << c;
+    if (slots.empty()) {
+        if (_free_pages.empty()) {
+            ++_allocation_failures;
+            return nullptr;
+        }
+        const size_t num_slots = page_size / slot_size;
+        slots.reserve(slots.capacity() + num_slots);
+        auto* page = _free_pages.back();
+        _free_pages.pop_back();
+        // the first slot is handed out first
+        for (size_t i = num_slots; i > 0; --i) {
+            slots.push_back(page + (i - 1) * slot_size);
+        }
+    }
+    auto* slot = slots.back();
+    slots.pop_back();
+    _size_used += slot_size;
+    return slot;
+}
+
+void hugepage_arena::deallocate(char* slot, size_t size) noexcept {
+    const auto c = slot_class(size);
+    // never reallocates, see allocate()
+    _free_slots[c].push_back(slot);
+    _size_used -= min_slot_size << c;
+}
+
+iobuf hugepage_arena::copy(const iobuf& in) {
+    iobuf out;
+    auto it = iobuf::iterator_consumer(in.cbegin(), in.cend());
+    size_t left = in.size_bytes();
+    while (left > 0) {
+        const auto n = std::min(left, max_slot_size);
+        auto* slot = allocate(n);
+        if (!slot) {
+            out.append(iobuf_copy(it, left));
+            break;
+        }
+        it.consume_to(n, slot);
+        auto buf = ss::temporary_buffer<char>(
+          slot, n, ss::make_deleter([this, slot, n] { deallocate(slot, n); }));
+        // the fragment must not be packed into a heap allocation
+        out.append_take_ownership(
+          new iobuf::fragment(std::move(buf), iobuf::fragment::full{}));
+        left -= n;
+    }
+    return out;
+}
+
+} // namespace storage::internal
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+#include "seastarx.h"
+#include "units.h"
+
+#include <seastar/core/aligned_buffer.hh>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace storage::internal {
+
+/**
+ * Memory of the chunk cache and of the batch cache backed by huge pages.
+ *
+ * Both caches hold many buffers spread across the memory of the shard, so
+ * walking a large cache takes a TLB miss on almost every buffer. The arena
+ * allocates its memory once at startup in pages of 2MiB aligned to their
+ * size, which the kernel backs with a single huge page each, and carves them
+ * into the chunks and fragments of the caches.
+ *
+ * A page is carved into slots of a single power of two size the first time
+ * a slot of that size is needed, and stays carved for that size. Freed slots
+ * are kept on a free list of their size and the pages are only released with
+ * the arena. Requests the arena has no slot for are left to the caller to
+ * serve from the heap, the arena is never grown.
+ *
+ * The pages come from the seastar allocator, so they are accounted in the
+ * memory of the shard like any other allocation. The arena is sized after
+ * the floors of the pools it backs, see memory_groups.
+ */
+class hugepage_arena {
+public:
+    static constexpr size_t page_size = 2_MiB;
+    static constexpr size_t min_slot_size = 512;
+    static constexpr size_t max_slot_size = 64_KiB;
+
+    hugepage_arena() noexcept = default;
+    hugepage_arena(hugepage_arena&&) = delete;
+    hugepage_arena& operator=(hugepage_arena&&) = delete;
+    hugepage_arena(const hugepage_arena&) = delete;
+    hugepage_arena& operator=(const hugepage_arena&) = delete;
+    ~hugepage_arena() noexcept = default;
+
+    /// Allocates the pages of the arena, `bytes` rounded down to pages.
+    void start(size_t bytes);
+
+    /// The arena has pages, the caches allocate from it.
+    bool enabled() const { return !_pages.empty(); }
+
+    /// A slot of at least `size` bytes and aligned to its size, or nullptr
+    /// when `size` is above max_slot_size or no slot is left.
+    char* allocate(size_t size);
+    /// Returns a slot, `size` is the size it was allocated with.
+    void deallocate(char*, size_t size) noexcept;
+
+    /// Copies the bytes into fragments carved from the arena. The bytes it
+    /// has no slots left for are copied to the heap.
+    iobuf copy(const iobuf&);
+
+    /// Bytes of the pages of the arena.
+    size_t size_total() const { return _pages.size() * page_size; }
+    /// Bytes of the slots handed out.
+    size_t size_used() const { return _size_used; }
+    /// Slots that could not be allocated from the arena.
+    uint64_t allocation_failures() const { return _allocation_failures; }
+
+private:
+    static constexpr size_t slot_classes = 8;
+    static_assert(min_slot_size << (slot_classes - 1) == max_slot_size);
+
+    static size_t slot_class(size_t size);
+
+    std::vector<std::unique_ptr<char[], ss::free_deleter>> _pages;
+    // pages not carved into slots yet
+    std::vector<char*> _free_pages;
+    // free slots of each size, their capacity is reserved as pages are
+    // carved so that a slot is returned without allocating
+    std::array<std::vector<char*>, slot_classes> _free_slots;
+    size_t _size_used{0};
+    uint64_t _allocation_failures{0};
+};
+
+inline hugepage_arena& hugepages() {
+    static thread_local hugepage_arena arena;
+    return arena;
+}
+
+} // namespace storage::internal
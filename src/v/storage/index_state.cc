@@ -75,9 +75,11 @@ bool index_state::maybe_index(
     // always saving the first batch simplifies a lot of book keeping
     if (accumulator >= step || retval) {
         // We know that a segment cannot be > 4GB
+        // max_timestamp covers the batches which were not indexed too and
+        // is never below base_timestamp
         add_entry(
           batch_base_offset() - base_offset(),
-          last_timestamp() - base_timestamp(),
+          max_timestamp() - base_timestamp(),
           starting_position_in_file);
 
         retval = true;
@@ -98,14 +100,12 @@ std::ostream& operator<<(std::ostream& o, const index_state& s) {
              << ")}";
 }
 
-std::optional<index_state> index_state::hydrate_from_buffer(iobuf b) {
-    iobuf_parser parser(std::move(b));
-    index_state retval;
+static bool hydrate_header(iobuf_parser& parser, index_state& retval) {
     retval.version = reflection::adl<int8_t>{}.from(parser);
-    if (retval.version != 1) {
-        // we screwed up version 0; and we only have version 1, so
-        // we force the users to rebuild the all indices here
-        return std::nullopt;
+    if (retval.version != index_state::current_version) {
+        // we screwed up version 0 and version 1 time entries are not
+        // monotonic, so we force the users to rebuild the all indices here
+        return false;
     }
     retval.size = reflection::adl<uint32_t>{}.from(parser);
     retval.checksum = reflection::adl<uint64_t>{}.from(parser);
@@ -118,6 +118,27 @@ std::optional<index_state> index_state::hydrate_from_buffer(iobuf b) {
       reflection::adl<model::timestamp::type>{}.from(parser));
     retval.max_timestamp = model::timestamp(
       reflection::adl<model::timestamp::type>{}.from(parser));
+    return true;
+}
+
+std::optional<index_state> index_state::hydrate_header_from_buffer(iobuf b) {
+    if (b.size_bytes() < header_size) {
+        return std::nullopt;
+    }
+    iobuf_parser parser(std::move(b));
+    index_state retval;
+    if (!hydrate_header(parser, retval)) {
+        return std::nullopt;
+    }
+    return retval;
+}
+
+std::optional<index_state> index_state::hydrate_from_buffer(iobuf b) {
+    iobuf_parser parser(std::move(b));
+    index_state retval;
+    if (!hydrate_header(parser, retval)) {
+        return std::nullopt;
+    }
 
     const uint32_t vsize = ss::le_to_cpu(
       reflection::adl<uint32_t>{}.from(parser));
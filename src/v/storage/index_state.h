@@ -30,10 +30,16 @@ namespace storage {
    8 bytes - max_time
    4 bytes - index.size()
    [] relative_offset_index
-   [] relative_time_index
+   [] relative_time_index - running max, monotonic since version 2
    [] position_index
  */
 struct index_state {
+    /// \brief bytes preceding the entries: version through index.size()
+    static constexpr size_t header_size = sizeof(int8_t) + sizeof(uint32_t)
+                                          + sizeof(uint64_t) + sizeof(uint32_t)
+                                          + (4 * sizeof(int64_t))
+                                          + sizeof(uint32_t);
+
     index_state() = default;
     index_state(index_state&&) noexcept = default;
     index_state& operator=(index_state&&) noexcept = default;
@@ -41,7 +47,10 @@ struct index_state {
     index_state& operator=(const index_state&) = delete;
     ~index_state() noexcept = default;
 
-    int8_t version{1};
+    /// \brief indices of older versions are rebuilt on recovery
+    static constexpr int8_t current_version = 2;
+
+    int8_t version{current_version};
     /// \brief sizeof the index in bytes
     uint32_t size{0};
     /// \brief currently xxhash64
@@ -59,6 +68,8 @@ struct index_state {
 
     /// breaking indexes into their own has a 6x latency reduction
     std::vector<uint32_t> relative_offset_index;
+    /// max timestamp of all batches up to and including the indexed one,
+    /// relative to base_timestamp. does not decrease so it can be searched
     std::vector<uint32_t> relative_time_index;
     std::vector<uint32_t> position_index;
 
@@ -91,6 +102,9 @@ struct index_state {
       model::timestamp last_timestamp);
 
     static std::optional<index_state> hydrate_from_buffer(iobuf);
+    /// \brief parses only the header. entries and checksum are not verified
+    /// and must be loaded with hydrate_from_buffer() before use
+    static std::optional<index_state> hydrate_header_from_buffer(iobuf);
     static uint64_t checksum_state(const index_state&);
     friend std::ostream& operator<<(std::ostream&, const index_state&);
 };
@@ -0,0 +1,147 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/key_bloom_filter.h"
+
+#include "bytes/iobuf_parser.h"
+#include "hashing/xx.h"
+
+#include <seastar/core/byteorder.hh>
+
+#include <fmt/ostream.h>
+
+#include <algorithm>
+
+namespace storage {
+
+key_bloom_filter::block::block(uint32_t c, uint32_t bits_per_key)
+  : words((uint64_t(c) * bits_per_key + 63) / 64, 0)
+  // optimal number of probes is bits_per_key * ln(2)
+  , hashes(std::max<uint32_t>(1, (bits_per_key * 693 + 500) / 1000))
+  , capacity(c) {}
+
+void key_bloom_filter::block::add(uint64_t h) {
+    // double hashing: probe i is h1 + i * h2
+    const auto h1 = static_cast<uint32_t>(h);
+    const auto h2 = static_cast<uint32_t>(h >> 32U);
+    const auto nbits = bits();
+    for (uint32_t i = 0; i < hashes; ++i) {
+        const auto bit = (h1 + uint64_t(i) * h2) % nbits;
+        words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    ++keys;
+}
+
+bool key_bloom_filter::block::may_contain(uint64_t h) const {
+    const auto h1 = static_cast<uint32_t>(h);
+    const auto h2 = static_cast<uint32_t>(h >> 32U);
+    const auto nbits = bits();
+    for (uint32_t i = 0; i < hashes; ++i) {
+        const auto bit = (h1 + uint64_t(i) * h2) % nbits;
+        if ((words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t key_bloom_filter::hash(bytes_view k) {
+    // NOLINTNEXTLINE
+    return xxhash_64(reinterpret_cast<const char*>(k.data()), k.size());
+}
+
+void key_bloom_filter::add(bytes_view k) {
+    if (_blocks.empty() || _blocks.back().keys >= _blocks.back().capacity) {
+        const uint32_t n = _blocks.size();
+        const uint32_t capacity = n == 0 ? initial_block_keys
+                                         : std::min(
+                                           max_block_keys,
+                                           _blocks.back().capacity * 2);
+        const uint32_t bits = std::min(
+          max_bits_per_key, min_bits_per_key + 2 * n);
+        _blocks.emplace_back(capacity, bits);
+    }
+    _blocks.back().add(hash(k));
+}
+
+bool key_bloom_filter::may_contain(bytes_view k) const {
+    const auto h = hash(k);
+    return std::any_of(_blocks.begin(), _blocks.end(), [h](const block& b) {
+        return b.may_contain(h);
+    });
+}
+
+size_t key_bloom_filter::memory_usage() const {
+    size_t ret = 0;
+    for (auto& b : _blocks) {
+        ret += b.words.size() * sizeof(uint64_t);
+    }
+    return ret;
+}
+
+iobuf key_bloom_filter::to_iobuf() const {
+    iobuf ret;
+    const auto count = ss::cpu_to_le(static_cast<uint32_t>(_blocks.size()));
+    // NOLINTNEXTLINE
+    ret.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (auto& b : _blocks) {
+        const auto words = ss::cpu_to_le(static_cast<uint32_t>(b.words.size()));
+        const auto hashes = ss::cpu_to_le(b.hashes);
+        // NOLINTNEXTLINE
+        ret.append(reinterpret_cast<const char*>(&words), sizeof(words));
+        // NOLINTNEXTLINE
+        ret.append(reinterpret_cast<const char*>(&hashes), sizeof(hashes));
+        for (auto w : b.words) {
+            w = ss::cpu_to_le(w);
+            // NOLINTNEXTLINE
+            ret.append(reinterpret_cast<const char*>(&w), sizeof(w));
+        }
+    }
+    return ret;
+}
+
+std::optional<key_bloom_filter> key_bloom_filter::from_iobuf(iobuf buf) {
+    iobuf_parser parser(std::move(buf));
+    if (parser.bytes_left() < sizeof(uint32_t)) {
+        return std::nullopt;
+    }
+    key_bloom_filter ret;
+    const auto count = ss::le_to_cpu(parser.consume_type<uint32_t>());
+    ret._blocks.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (parser.bytes_left() < 2 * sizeof(uint32_t)) {
+            return std::nullopt;
+        }
+        const auto n = ss::le_to_cpu(parser.consume_type<uint32_t>());
+        const auto hashes = ss::le_to_cpu(parser.consume_type<uint32_t>());
+        if (
+          n == 0 || hashes == 0
+          || parser.bytes_left() < n * sizeof(uint64_t)) {
+            return std::nullopt;
+        }
+        std::vector<uint64_t> words;
+        words.reserve(n);
+        for (uint32_t j = 0; j < n; ++j) {
+            words.push_back(ss::le_to_cpu(parser.consume_type<uint64_t>()));
+        }
+        ret._blocks.emplace_back(std::move(words), hashes);
+    }
+    if (parser.bytes_left() != 0) {
+        return std::nullopt;
+    }
+    return ret;
+}
+
+std::ostream& operator<<(std::ostream& o, const key_bloom_filter& f) {
+    fmt::print(
+      o, "{{blocks:{}, memory_usage:{}}}", f._blocks.size(), f.memory_usage());
+    return o;
+}
+
+} // namespace storage
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "seastarx.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace storage {
+
+/**
+ * Bloom filter over the keys of a compacted index.
+ *
+ * The number of keys is not known while the index is written, so the filter
+ * is a sequence of blocks. The first block is sized for initial_block_keys
+ * keys and each new block doubles the capacity up to max_block_keys; a key
+ * may be in the filter if any block matches. Each block spends two more bits
+ * per key than the previous one (from 10, up to 16) so that the combined
+ * false positive rate stays around 1.5% however many blocks there are.
+ *
+ * Serialized format, all integers little endian:
+ *
+ *    UINT32 block_count
+ *    [UINT32 word_count, UINT32 hash_count, []UINT64 words] * block_count
+ */
+class key_bloom_filter {
+public:
+    static constexpr uint32_t min_bits_per_key = 10;
+    static constexpr uint32_t max_bits_per_key = 16;
+    static constexpr uint32_t initial_block_keys = 128;
+    static constexpr uint32_t max_block_keys = 256 * 1024;
+
+    void add(bytes_view);
+    bool may_contain(bytes_view) const;
+
+    size_t memory_usage() const;
+    bool empty() const { return _blocks.empty(); }
+
+    iobuf to_iobuf() const;
+    /// returns std::nullopt if the buffer is not a valid filter
+    static std::optional<key_bloom_filter> from_iobuf(iobuf);
+
+private:
+    struct block {
+        block(uint32_t capacity, uint32_t bits_per_key);
+        block(std::vector<uint64_t> w, uint32_t h) noexcept
+          : words(std::move(w))
+          , hashes(h) {}
+
+        void add(uint64_t h);
+        bool may_contain(uint64_t h) const;
+        uint64_t bits() const { return words.size() * 64; }
+
+        std::vector<uint64_t> words;
+        uint32_t hashes{0};
+        uint32_t keys{0};
+        uint32_t capacity{0};
+    };
+
+    static uint64_t hash(bytes_view);
+
+    std::vector<block> _blocks;
+
+    friend std::ostream& operator<<(std::ostream&, const key_bloom_filter&);
+};
+
+} // namespace storage
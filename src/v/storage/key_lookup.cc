@@ -0,0 +1,162 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/key_lookup.h"
+
+#include "model/record.h"
+#include "storage/compacted_index.h"
+#include "storage/compacted_index_reader.h"
+#include "storage/logger.h"
+#include "storage/parser_utils.h"
+#include "storage/segment_utils.h"
+#include "storage/spill_key_index.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <algorithm>
+
+namespace storage::internal {
+
+namespace {
+
+// raft::data_batch_type, the records of the other batches carry no user keys
+constexpr auto data_batch_type = model::record_batch_type(1);
+
+class key_offsets_reducer {
+public:
+    explicit key_offsets_reducer(bytes key)
+      : _key(std::move(key)) {}
+
+    ss::future<ss::stop_iteration> operator()(compacted_index::entry&& e) {
+        if (e.type == compacted_index::entry_type::key && e.key == _key) {
+            _offsets.push_back(e.offset + model::offset(e.delta));
+        }
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::no);
+    }
+
+    std::vector<model::offset> end_of_stream() {
+        std::sort(_offsets.begin(), _offsets.end(), std::greater<>());
+        _offsets.erase(
+          std::unique(_offsets.begin(), _offsets.end()), _offsets.end());
+        return std::move(_offsets);
+    }
+
+private:
+    bytes _key;
+    std::vector<model::offset> _offsets;
+};
+
+class latest_record_consumer {
+public:
+    latest_record_consumer(bytes key, model::offset max_offset)
+      : _key(bytes_to_iobuf(key))
+      , _max_offset(max_offset) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch b) {
+        if (b.base_offset() > _max_offset) {
+            return ss::make_ready_future<ss::stop_iteration>(
+              ss::stop_iteration::yes);
+        }
+        if (b.header().type != data_batch_type) {
+            return ss::make_ready_future<ss::stop_iteration>(
+              ss::stop_iteration::no);
+        }
+        if (!b.compressed()) {
+            consume(b);
+            return ss::make_ready_future<ss::stop_iteration>(
+              ss::stop_iteration::no);
+        }
+        return decompress_batch(std::move(b))
+          .then([this](model::record_batch b) {
+              consume(b);
+              return ss::stop_iteration::no;
+          });
+    }
+
+    std::optional<key_lookup_result> end_of_stream() {
+        return std::move(_result);
+    }
+
+private:
+    void consume(const model::record_batch& b) {
+        b.for_each_record([this, &b](model::record r) {
+            const auto o = b.base_offset() + model::offset(r.offset_delta());
+            if (
+              o > _max_offset || r.key_size() != int32_t(_key.size_bytes())
+              || r.key() != _key) {
+                return;
+            }
+            std::optional<iobuf> value;
+            if (r.value_size() >= 0) {
+                value = r.release_value();
+            }
+            _result = key_lookup_result{
+              .offset = o,
+              .timestamp = model::timestamp(
+                b.header().first_timestamp() + r.timestamp_delta()),
+              .value = std::move(value)};
+        });
+    }
+
+    iobuf _key;
+    model::offset _max_offset;
+    std::optional<key_lookup_result> _result;
+};
+
+} // namespace
+
+ss::future<std::optional<std::vector<model::offset>>>
+compacted_index_key_offsets(
+  std::filesystem::path path,
+  bytes key,
+  ss::io_priority_class iopc,
+  debug_sanitize_files sanitize) {
+    using ret_t = std::optional<std::vector<model::offset>>;
+    // the index identifies a key by the prefix it persists
+    if (key.size() > spill_key_index::max_key_size) {
+        key.resize(spill_key_index::max_key_size);
+    }
+    return make_reader_handle(path, sanitize)
+      .then([path, key = std::move(key), iopc](ss::file f) mutable {
+          auto reader = make_file_backed_compacted_reader(
+            path.string(), std::move(f), iopc, 64_KiB);
+          return reader.load_key_filter()
+            .then([reader, key = std::move(key)](
+                    std::optional<key_bloom_filter> filter) mutable {
+                if (filter && !filter->may_contain(key)) {
+                    return ss::make_ready_future<ret_t>(
+                      std::vector<model::offset>{});
+                }
+                reader.reset();
+                return reader
+                  .consume(
+                    key_offsets_reducer(std::move(key)), model::no_timeout)
+                  .then([](std::vector<model::offset> offsets) {
+                      return ret_t(std::move(offsets));
+                  });
+            })
+            .finally([reader]() mutable {
+                return reader.close().then_wrapped([](ss::future<>) {});
+            });
+      })
+      .handle_exception([path](std::exception_ptr e) {
+          vlog(stlog.debug, "cannot look up keys in {}: {}", path, e);
+          return ret_t();
+      });
+}
+
+ss::future<std::optional<key_lookup_result>> find_latest_record(
+  model::record_batch_reader reader, bytes key, model::offset max_offset) {
+    return std::move(reader).consume(
+      latest_record_consumer(std::move(key), max_offset), model::no_timeout);
+}
+
+} // namespace storage::internal
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/bytes.h"
+#include "model/fundamental.h"
+#include "model/record_batch_reader.h"
+#include "seastarx.h"
+#include "storage/types.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace storage::internal {
+
+/// \brief record offsets the compacted index at `path` holds for `key`,
+/// newest first. empty when the key filter rules the key out, std::nullopt
+/// when the index cannot be read. the index stores a prefix of long keys,
+/// so the records at the offsets must still be checked against the key
+ss::future<std::optional<std::vector<model::offset>>>
+compacted_index_key_offsets(
+  std::filesystem::path path,
+  bytes key,
+  ss::io_priority_class,
+  debug_sanitize_files);
+
+/// \brief latest data record of `key` at or below `max_offset` in `reader`
+ss::future<std::optional<key_lookup_result>> find_latest_record(
+  model::record_batch_reader reader, bytes key, model::offset max_offset);
+
+} // namespace storage::internal
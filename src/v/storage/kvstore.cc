@@ -59,6 +59,11 @@ ss::future<> kvstore::start() {
               "entries_removed",
               [this] { return _probe.entries_removed; },
               ss::metrics::description("Number of entries removaled")),
+            ss::metrics::make_total_operations(
+              "entries_coalesced",
+              [this] { return _probe.entries_coalesced; },
+              ss::metrics::description(
+                "Number of entries replaced by a later write before a flush")),
             ss::metrics::make_current_bytes(
               "cached_bytes",
               [this] { return _probe.cached_bytes; },
@@ -106,15 +111,19 @@ ss::future<> kvstore::stop() {
     // prevent new ops, signal flusher to exit
     auto f = _gate.close();
     _sem.signal();
+    _pending_bytes.broken();
 
     // it's ok for the flusher to run concurrently with stop() because the
     // flusher only operates on a snapshot of the pending ops that it takes when
     // it starts these ops begin cancelled would be ops that arrived between the
     // start of a flush and this service being stopped.
     for (auto& op : _ops) {
-        op.done.set_exception(ss::gate_closed_exception());
+        for (auto& p : op.done) {
+            p.set_exception(ss::gate_closed_exception());
+        }
     }
     _ops.clear();
+    _staged.clear();
 
     return f.then([this] {
         // wait until the flusher exists--it might create _segment
@@ -153,28 +162,59 @@ std::optional<iobuf> kvstore::get(key_space ks, bytes_view key) {
     return std::nullopt;
 }
 
-ss::future<> kvstore::put(key_space ks, bytes key, iobuf value) {
+ss::future<>
+kvstore::put(key_space ks, bytes key, iobuf value, urgent u) {
     _probe.entry_written();
-    return put(ks, std::move(key), std::make_optional<iobuf>(std::move(value)));
+    return put(
+      ks, std::move(key), std::make_optional<iobuf>(std::move(value)), u);
 }
 
-ss::future<> kvstore::remove(key_space ks, bytes key) {
+ss::future<> kvstore::remove(key_space ks, bytes key, urgent u) {
     _probe.entry_removed();
-    return put(ks, std::move(key), std::nullopt);
+    return put(ks, std::move(key), std::nullopt, u);
 }
 
-ss::future<> kvstore::put(key_space ks, bytes key, std::optional<iobuf> value) {
+ss::future<> kvstore::put(
+  key_space ks, bytes key, std::optional<iobuf> value, urgent u) {
     vassert(_started, "kvstore has not been started");
 
-    key = make_spaced_key(ks, key);
-    return ss::with_gate(
-      _gate, [this, key = std::move(key), value = std::move(value)]() mutable {
-          auto& w = _ops.emplace_back(std::move(key), std::move(value));
-          if (!_timer.armed()) {
-              _timer.arm(_conf.commit_interval);
-          }
-          return w.done.get_future();
-      });
+    op o(make_spaced_key(ks, key), std::move(value));
+    o.reserved = std::min(
+      o.key.size() + (o.value ? o.value->size_bytes() : 0), max_pending_bytes);
+    return ss::with_gate(_gate, [this, o = std::move(o), u]() mutable {
+        const auto units = o.reserved;
+        return _pending_bytes.wait(units).then(
+          [this, o = std::move(o), u]() mutable {
+              return stage_op(std::move(o), u);
+          });
+    });
+}
+
+ss::future<> kvstore::stage_op(op o, urgent u) {
+    // stop() failed the staged ops while this one waited
+    if (_gate.is_closed()) {
+        _pending_bytes.signal(o.reserved);
+        return ss::make_exception_future<>(ss::gate_closed_exception());
+    }
+    auto f = o.done.emplace_back().get_future();
+    if (auto it = _staged.find(o.key); it != _staged.end()) {
+        // the flush only needs the latest value of the key
+        _probe.entry_coalesced();
+        auto& w = _ops[it->second];
+        w.value = std::move(o.value);
+        w.done.push_back(std::move(o.done.back()));
+        _pending_bytes.signal(std::exchange(w.reserved, o.reserved));
+    } else {
+        _staged.emplace(o.key, _ops.size());
+        _ops.push_back(std::move(o));
+    }
+    if (u) {
+        _timer.cancel();
+        _sem.signal();
+    } else if (!_timer.armed()) {
+        _timer.arm(_conf.commit_interval);
+    }
+    return f;
 }
 
 void kvstore::apply_op(bytes key, std::optional<iobuf> value) {
@@ -213,6 +253,11 @@ ss::future<> kvstore::flush_and_apply_ops() {
 
     // flush and apply whatever happens to be queued up
     auto ops = std::exchange(_ops, {});
+    _staged.clear();
+    size_t reserved = 0;
+    for (auto& op : ops) {
+        reserved += op.reserved;
+    }
 
     // build the operation batch to be logged
     storage::record_batch_builder builder(kvstore_batch_type, _next_offset);
@@ -238,10 +283,13 @@ ss::future<> kvstore::flush_and_apply_ops() {
       .then([this, last_offset, ops = std::move(ops)]() mutable {
           for (auto& op : ops) {
               apply_op(std::move(op.key), std::move(op.value));
-              op.done.set_value();
+              for (auto& p : op.done) {
+                  p.set_value();
+              }
           }
           _next_offset = last_offset + model::offset(1);
-      });
+      })
+      .finally([this, reserved] { _pending_bytes.signal(reserved); });
 }
 
 ss::future<> kvstore::roll() {
@@ -16,6 +16,7 @@
 #include "storage/segment_set.h"
 #include "storage/snapshot.h"
 #include "storage/types.h"
+#include "units.h"
 #include "utils/mutex.h"
 
 #include <seastar/core/abort_source.hh>
@@ -23,6 +24,7 @@
 #include <seastar/core/gate.hh>
 #include <seastar/core/semaphore.hh>
 #include <seastar/core/timer.hh>
+#include <seastar/util/bool_class.hh>
 
 #include <absl/container/flat_hash_map.h>
 
@@ -48,6 +50,12 @@ namespace storage {
  * flushed to disk. Once the flush is complete the operations are applied to the
  * in-memory cache, and the associated promise is resolved.
  *
+ * An operation on a key with an operation still staged replaces it, only the
+ * latest value of a key is flushed and every waiter resolves with that flush.
+ * An urgent operation, e.g. persisting the raft vote, does not wait for the
+ * commit interval: it starts a flush right away, or right after the one in
+ * progress, which also takes every other staged operation along.
+ *
  * Concurrency
  * ===========
  *
@@ -63,12 +71,11 @@ namespace storage {
  * ===========
  *
  * The entire database is cached in memory, so users should not allow the set of
- * uniuqe keys to grow unbounded.  No backpressure is applied, so use
- * responsibly until this utility becomes more sophisticated. The initial set of
- * use cases--tracking raft voted-for and log's base offset--do not pose an
- * issue for either of these limitations since they exhibit a natural bound on
- * the set of unique keys and queue depth of at most a few bytes *
- * O(#-partitions-per-core).
+ * uniuqe keys to grow unbounded. The staged operations are bounded by
+ * max_pending_bytes, past it operations wait for flushes to catch up. The
+ * initial set of use cases--tracking raft voted-for and log's base offset--do
+ * not pose an issue since they exhibit a natural bound on the set of unique
+ * keys and queue depth of at most a few bytes * O(#-partitions-per-core).
  */
 static constexpr const model::record_batch_type kvstore_batch_type(4);
 
@@ -96,17 +103,26 @@ public:
         consensus = 1,
         storage = 2,
         controller = 3,
+        archival = 4,
+        coproc = 5,
         /* your sub-system here */
     };
 
+    /// flush without waiting for the commit interval
+    using urgent = ss::bool_class<struct kvstore_urgent_tag>;
+
+    /// bytes of keys and values staged for the next flush
+    static constexpr size_t max_pending_bytes = 16_MiB;
+
     explicit kvstore(kvstore_config kv_conf);
 
     ss::future<> start();
     ss::future<> stop();
 
     std::optional<iobuf> get(key_space ks, bytes_view key);
-    ss::future<> put(key_space ks, bytes key, iobuf value);
-    ss::future<> remove(key_space ks, bytes key);
+    ss::future<>
+    put(key_space ks, bytes key, iobuf value, urgent u = urgent::no);
+    ss::future<> remove(key_space ks, bytes key, urgent u = urgent::no);
 
     bool empty() const {
         vassert(_started, "kvstore has not been started");
@@ -127,7 +143,10 @@ private:
     struct op {
         bytes key;
         std::optional<iobuf> value;
-        ss::promise<> done;
+        // one per operation coalesced into this one
+        std::vector<ss::promise<>> done;
+        // units of _pending_bytes held for the key and value
+        size_t reserved{0};
 
         op(bytes&& key, std::optional<iobuf>&& value)
           : key(std::move(key))
@@ -141,13 +160,18 @@ private:
      * segment is created.
      */
     std::vector<op> _ops;
+    // position in _ops of the op staged for a key
+    absl::flat_hash_map<bytes, size_t, bytes_type_hash, bytes_type_eq> _staged;
+    ss::semaphore _pending_bytes{max_pending_bytes};
     ss::timer<> _timer;
     ss::semaphore _sem{0};
     ss::lw_shared_ptr<segment> _segment;
     model::offset _next_offset;
     absl::flat_hash_map<bytes, iobuf, bytes_type_hash, bytes_type_eq> _db;
 
-    ss::future<> put(key_space ks, bytes key, std::optional<iobuf> value);
+    ss::future<>
+    put(key_space ks, bytes key, std::optional<iobuf> value, urgent u);
+    ss::future<> stage_op(op, urgent);
     void apply_op(bytes key, std::optional<iobuf> value);
     ss::future<> flush_and_apply_ops();
     ss::future<> roll();
@@ -194,6 +218,7 @@ private:
         void entry_fetched() { ++entries_fetched; }
         void entry_written() { ++entries_written; }
         void entry_removed() { ++entries_removed; }
+        void entry_coalesced() { ++entries_coalesced; }
         void add_cached_bytes(size_t count) { cached_bytes += count; }
         void dec_cached_bytes(size_t count) { cached_bytes -= count; }
 
@@ -201,6 +226,7 @@ private:
         uint64_t entries_fetched{0};
         uint64_t entries_written{0};
         uint64_t entries_removed{0};
+        uint64_t entries_coalesced{0};
         size_t cached_bytes{0};
 
         ss::metrics::metric_groups metrics;
@@ -9,29 +9,48 @@
 
 #include "storage/lock_manager.h"
 
+#include "storage/probe.h"
+
 #include <seastar/core/future-util.hh>
 #include <seastar/core/rwlock.hh>
 #include <seastar/core/shared_ptr.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 
 namespace storage {
 
-static ss::future<std::unique_ptr<lock_manager::lease>>
-range(segment_set::underlying_t segs) {
+ss::future<std::unique_ptr<lock_manager::lease>>
+lock_manager::range(segment_set::underlying_t segs) {
     auto ctx = std::make_unique<lock_manager::lease>(
       segment_set(std::move(segs)));
     std::vector<ss::future<ss::rwlock::holder>> dispatch;
-    dispatch.reserve(ctx->range.size());
+    ctx->pins.reserve(ctx->range.size());
     for (auto& s : ctx->range) {
-        dispatch.emplace_back(s->read_lock());
+        if (auto pin = s->try_pin_read(); pin) {
+            ctx->pins.push_back(std::move(*pin));
+        } else {
+            dispatch.emplace_back(s->read_lock());
+        }
+    }
+    if (dispatch.empty()) {
+        return ss::make_ready_future<std::unique_ptr<lease>>(std::move(ctx));
     }
+    const bool waits = std::any_of(
+      dispatch.begin(), dispatch.end(), [](const auto& f) {
+          return !f.available();
+      });
+    const auto start = std::chrono::steady_clock::now();
     return ss::when_all_succeed(dispatch.begin(), dispatch.end())
-      .then(
-        [ctx = std::move(ctx)](std::vector<ss::rwlock::holder> lks) mutable {
-            ctx->locks = std::move(lks);
-            return std::move(ctx);
-        });
+      .then([this, waits, start, ctx = std::move(ctx)](
+              std::vector<ss::rwlock::holder> lks) mutable {
+          if (waits) {
+              _probe.add_lock_wait(std::chrono::steady_clock::now() - start);
+          }
+          ctx->locks = std::move(lks);
+          return std::move(ctx);
+      });
 }
 
 ss::future<std::unique_ptr<lock_manager::lease>>
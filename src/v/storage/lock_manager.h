@@ -19,10 +19,23 @@
 #include <seastar/core/rwlock.hh>
 
 namespace storage {
+class probe;
+
+/**
+ * Keeps the segments a reader covers from being truncated, compacted or
+ * removed under it.
+ *
+ * Most of the segments of a range are sealed and nothing destructive runs on
+ * them, those are pinned in place without a future per segment. Only the
+ * active segment and the segments a destructive operation holds or waits for
+ * are read locked, the time readers wait for those locks is recorded by the
+ * probe.
+ */
 class lock_manager {
 public:
-    explicit lock_manager(segment_set& s) noexcept
-      : _set(s) {}
+    lock_manager(segment_set& s, probe& p) noexcept
+      : _set(s)
+      , _probe(p) {}
     struct lease {
         explicit lease(segment_set s)
           : range(std::move(s)) {}
@@ -34,6 +47,7 @@ public:
 
         segment_set range;
         std::vector<ss::rwlock::holder> locks;
+        std::vector<segment::read_pin> pins;
 
         friend std::ostream& operator<<(std::ostream&, const lease&);
     };
@@ -42,7 +56,10 @@ public:
     ss::future<std::unique_ptr<lease>> range_lock(const log_reader_config& cfg);
 
 private:
+    ss::future<std::unique_ptr<lease>> range(segment_set::underlying_t);
+
     segment_set& _set;
+    probe& _probe;
 };
 
 } // namespace storage
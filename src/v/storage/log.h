@@ -63,16 +63,26 @@ public:
 
         virtual ss::future<std::optional<timequery_result>>
           timequery(timequery_config) = 0;
+        virtual ss::future<std::optional<key_lookup_result>>
+          lookup_key(key_lookup_config) = 0;
 
         const ntp_config& config() const { return _config; }
 
         virtual size_t segment_count() const = 0;
+        virtual std::vector<segment_file> closed_segments() const = 0;
+        virtual compaction_backlog backlog() const = 0;
         virtual storage::offset_stats offsets() const = 0;
+        virtual size_t
+          size_bytes(model::offset first, model::offset last) const = 0;
+        virtual std::optional<model::offset> tail_offset(size_t) = 0;
+        virtual uint64_t batch_cache_misses() const = 0;
         virtual std::ostream& print(std::ostream& o) const = 0;
         virtual std::optional<model::term_id> get_term(model::offset) const = 0;
 
         virtual ss::future<model::offset>
         monitor_eviction(ss::abort_source&) = 0;
+        virtual ss::future<model::offset>
+          wait_for_committed_offset(model::offset, ss::abort_source&) = 0;
         virtual void set_collectible_offset(model::offset) = 0;
 
     private:
@@ -126,8 +136,39 @@ public:
 
     size_t segment_count() const { return _impl->segment_count(); }
 
+    /// files of the segments which are no longer appended to, oldest first
+    std::vector<segment_file> closed_segments() const {
+        return _impl->closed_segments();
+    }
+
+    /// compaction still to do on the closed segments, empty unless compacted
+    compaction_backlog backlog() const { return _impl->backlog(); }
+
     storage::offset_stats offsets() const { return _impl->offsets(); }
 
+    /**
+     * \brief Approximate size of the batches in the range [first, last]
+     *
+     * Disk logs count whole segments, the size of every segment overlapping
+     * the range is included.
+     */
+    size_t size_bytes(model::offset first, model::offset last) const {
+        return _impl->size_bytes(first, last);
+    }
+
+    /**
+     * \brief Offset to read the last `bytes` of the active segment from
+     *
+     * The reads of the active segment are the ones populating the batch
+     * cache. Empty when the log has no batch cache or no active segment.
+     */
+    std::optional<model::offset> tail_offset(size_t bytes) {
+        return _impl->tail_offset(bytes);
+    }
+
+    /// reads of batches the batch cache did not hold
+    uint64_t batch_cache_misses() const { return _impl->batch_cache_misses(); }
+
     std::optional<model::term_id> get_term(model::offset o) const {
         return _impl->get_term(o);
     }
@@ -136,6 +177,20 @@ public:
         return _impl->timequery(cfg);
     }
 
+    /**
+     * \brief Latest record of a key at or below `cfg.max_offset`
+     *
+     * Segments are searched newest first. A closed segment of a compacted
+     * log is answered by its compacted index: its key filter rules the
+     * segment out, or the index points at the batches to read. Segments
+     * without a usable index, such as the active one, are scanned. Empty if
+     * the key is not in the log.
+     */
+    ss::future<std::optional<key_lookup_result>>
+    lookup_key(key_lookup_config cfg) {
+        return _impl->lookup_key(std::move(cfg));
+    }
+
     ss::future<> compact(compaction_config cfg) { return _impl->compact(cfg); }
 
     /**
@@ -149,6 +204,19 @@ public:
     ss::future<model::offset> monitor_eviction(ss::abort_source& as) {
         return _impl->monitor_eviction(as);
     }
+    /**
+     * \brief Returns a future that resolves with the committed offset once it
+     * reaches `o`
+     *
+     * Readers tailing the log wait for the flushes making new data visible.
+     * May throw ss::abort_requested_exception when the abort source was
+     * triggered or storage::segment_closed_exception when the log was closed
+     * while waiting.
+     */
+    ss::future<model::offset>
+    wait_for_committed_offset(model::offset o, ss::abort_source& as) {
+        return _impl->wait_for_committed_offset(o, as);
+    }
     /**
      * Controlls the max offset that may be evicted by log retention policy
      */
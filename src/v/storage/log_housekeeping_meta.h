@@ -13,48 +13,19 @@
 
 #include "storage/log.h"
 
+#include <seastar/core/lowres_clock.hh>
+
 namespace storage {
 struct log_housekeeping_meta {
-    enum class bitflags : uint32_t {
-        none = 0,
-        compacted = 1U,
-    };
+    using clock_type = ss::lowres_clock;
+
     explicit log_housekeeping_meta(log l) noexcept
       : handle(std::move(l)) {}
 
     log handle;
-    bitflags flags{bitflags::none};
-    ss::lowres_clock::time_point last_compaction;
+    // when the log is next due for retention and compaction; the log
+    // manager queues the log under this deadline
+    clock_type::time_point next_housekeeping = clock_type::now();
 };
 
-inline log_housekeeping_meta::bitflags operator|(
-  log_housekeeping_meta::bitflags a, log_housekeeping_meta::bitflags b) {
-    return log_housekeeping_meta::bitflags(
-      std::underlying_type_t<log_housekeeping_meta::bitflags>(a)
-      | std::underlying_type_t<log_housekeeping_meta::bitflags>(b));
-}
-
-inline void operator|=(
-  log_housekeeping_meta::bitflags& a, log_housekeeping_meta::bitflags b) {
-    a = (a | b);
-}
-
-inline log_housekeeping_meta::bitflags
-operator~(log_housekeeping_meta::bitflags a) {
-    return log_housekeeping_meta::bitflags(
-      ~std::underlying_type_t<log_housekeeping_meta::bitflags>(a));
-}
-
-inline log_housekeeping_meta::bitflags operator&(
-  log_housekeeping_meta::bitflags a, log_housekeeping_meta::bitflags b) {
-    return log_housekeeping_meta::bitflags(
-      std::underlying_type_t<log_housekeeping_meta::bitflags>(a)
-      & std::underlying_type_t<log_housekeeping_meta::bitflags>(b));
-}
-
-inline void operator&=(
-  log_housekeeping_meta::bitflags& a, log_housekeeping_meta::bitflags b) {
-    a = (a & b);
-}
-
 } // namespace storage
@@ -13,9 +13,16 @@
 #include "likely.h"
 #include "model/fundamental.h"
 #include "model/timestamp.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "resource_mgmt/io_priority.h"
+#include "resource_mgmt/memory_groups.h"
 #include "storage/batch_cache.h"
+#include "storage/chunk_cache.h"
 #include "storage/compacted_index_writer.h"
+#include "storage/disk_log_impl.h"
+#include "storage/flush_coordinator.h"
 #include "storage/fs_utils.h"
+#include "storage/hugepage_arena.h"
 #include "storage/log.h"
 #include "storage/logger.h"
 #include "storage/segment.h"
@@ -33,109 +40,658 @@
 #include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/metrics.hh>
 #include <seastar/core/print.hh>
+#include <seastar/core/reactor.hh>
 #include <seastar/core/seastar.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/thread.hh>
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 #include <filesystem>
 #include <optional>
+#include <vector>
+
+#include <sys/statvfs.h>
 
 namespace storage {
+
+namespace {
+/// the appender chunks of the shard, starved while appenders wait for one
+class chunk_cache_pool final : public memory_broker::pool {
+public:
+    chunk_cache_pool()
+      : memory_broker::pool(
+        "appenders",
+        memory_broker::priority::appenders,
+        memory_broker::share{
+          .min_bytes = memory_groups::chunk_cache_min_memory(),
+          .max_bytes = memory_groups::chunk_cache_max_memory()}) {}
+
+    size_t used() const final { return internal::chunks().size_total(); }
+    bool starved() const final { return internal::chunks().has_waiters(); }
+
+private:
+    void on_capacity(size_t, size_t next) final {
+        internal::chunks().set_size_limit(next);
+    }
+};
+
+/// the batch cache gives its memory back first, it never waits for it
+class batch_cache_pool final : public memory_broker::pool {
+public:
+    explicit batch_cache_pool(batch_cache& c)
+      : memory_broker::pool(
+        "batch_cache",
+        memory_broker::priority::cache,
+        memory_broker::share{
+          .min_bytes = memory_groups::batch_cache_min_memory(),
+          .max_bytes = memory_groups::batch_cache_max_memory()})
+      , _cache(c) {}
+
+    size_t used() const final { return _cache.size_bytes(); }
+    bool starved() const final { return false; }
+
+private:
+    void on_capacity(size_t, size_t next) final { _cache.set_capacity(next); }
+
+    batch_cache& _cache;
+};
+} // namespace
+
 using logs_type = absl::flat_hash_map<model::ntp, log_housekeeping_meta>;
 
 log_manager::log_manager(log_config config, kvstore& kvstore) noexcept
   : _config(std::move(config))
   , _kvstore(kvstore)
   , _jitter(_config.compaction_interval)
-  , _batch_cache(config.reclaim_opts) {
+  , _batch_cache(config.reclaim_opts)
+  , _compaction_throttle(_config.compaction_throttle_cfg, _abort_source)
+  , _reaper(_config.reaper_cfg)
+  , _segment_pool(_config.segment_pool_files)
+  , _probes(_config.probes_cfg) {
     _compaction_timer.set_callback([this] { trigger_housekeeping(); });
     _compaction_timer.rearm(_jitter());
+    internal::flushes().set_window(_config.flush_coalesce_window);
+    internal::cold_chunks().configure(_config.cold_cache_cfg);
+    if (_config.reclaim_opts.max_target > 0) {
+        _cache_target_timer.set_callback([this] { update_cache_target(); });
+        _cache_target_timer.arm_periodic(cache_target_interval);
+    }
+    if (_config.disk_pressure_free_percent > 0) {
+        _disk_pressure_timer.set_callback(
+          [this] { trigger_disk_pressure_reclaim(); });
+        _disk_pressure_timer.arm(_config.disk_pressure_interval);
+    }
+    if (_config.broker_memory) {
+        _memory_pools.push_back(std::make_unique<chunk_cache_pool>());
+        _memory_pools.push_back(
+          std::make_unique<batch_cache_pool>(_batch_cache));
+    }
+    setup_metrics();
+}
+
+void log_manager::update_cache_target() {
+    const auto mem = ss::memory::stats();
+    _batch_cache.update_target(batch_cache::memory_signals{
+      .free_memory = mem.free_memory(),
+      .total_memory = mem.total_memory(),
+      .reclaims = mem.reclaims(),
+      .allocation_failures = internal::chunks().allocation_failures(),
+      .write_waiters = internal::chunks().has_waiters(),
+    });
+}
+
+void log_manager::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    for (auto& p : _memory_pools) {
+        p->setup_metrics();
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:flush"),
+      {
+        sm::make_derive(
+          "requests",
+          [] { return internal::flushes().get_stats().requests; },
+          sm::description("Number of segment flush requests")),
+        sm::make_derive(
+          "fsyncs",
+          [] { return internal::flushes().get_stats().syncs; },
+          sm::description("Number of fdatasync calls issued")),
+        sm::make_derive(
+          "coalesced",
+          [] { return internal::flushes().get_stats().coalesced(); },
+          sm::description("Number of flush requests served by an fdatasync "
+                          "issued for another request")),
+        sm::make_derive(
+          "batches",
+          [] { return internal::flushes().get_stats().batches; },
+          sm::description("Number of batches of fdatasync calls")),
+      });
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:log_reaper"),
+      {
+        sm::make_gauge(
+          "pending",
+          [this] { return _reaper.pending(); },
+          sm::description("Number of removed logs with files left on disk")),
+        sm::make_derive(
+          "removed_bytes",
+          [this] { return _reaper.removed_bytes(); },
+          sm::description("Bytes of removed logs freed on disk")),
+      });
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:disk_pressure"),
+      {
+        sm::make_derive(
+          "reclaims",
+          [this] { return _disk_pressure_reclaims; },
+          sm::description("Number of removals of the oldest segments of the "
+                          "shard from a data directory short of free space")),
+        sm::make_derive(
+          "reclaimed_bytes",
+          [this] { return _disk_pressure_reclaimed_bytes; },
+          sm::description("Bytes of segments removed ahead of their "
+                          "retention to free disk space")),
+      });
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:segment_pool"),
+      {
+        sm::make_gauge(
+          "files",
+          [this] { return _segment_pool.size(); },
+          sm::description("Number of data files kept for reuse by new "
+                          "segments")),
+        sm::make_derive(
+          "recycled",
+          [this] { return _segment_pool.recycled(); },
+          sm::description("Number of data files prepared for reuse")),
+        sm::make_derive(
+          "reused",
+          [this] { return _segment_pool.reused(); },
+          sm::description("Number of segments created from a kept file")),
+      });
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:batch_cache"),
+      {
+        sm::make_gauge(
+          "size_bytes",
+          [this] { return _batch_cache.size_bytes(); },
+          sm::description("Bytes of batches cached on the shard")),
+        sm::make_gauge(
+          "target_bytes",
+          [this] { return _batch_cache.target_bytes(); },
+          sm::description("Size target of the batch cache of the shard")),
+        sm::make_derive(
+          "evictions",
+          [this] { return _batch_cache.get_stats().evictions; },
+          sm::description("Number of batches evicted from the cache")),
+      });
+    if (internal::hugepages().enabled()) {
+        _metrics.add_group(
+          prometheus_sanitize::metrics_name("storage:hugepage_arena"),
+          {
+            sm::make_gauge(
+              "size_bytes",
+              [] { return internal::hugepages().size_total(); },
+              sm::description("Bytes of huge pages of the shard")),
+            sm::make_gauge(
+              "used_bytes",
+              [] { return internal::hugepages().size_used(); },
+              sm::description("Bytes of huge pages used by the caches")),
+            sm::make_derive(
+              "allocation_failures",
+              [] { return internal::hugepages().allocation_failures(); },
+              sm::description("Chunks and fragments allocated on the heap "
+                              "once the huge pages were used up")),
+          });
+    }
+    if (!_config.cold_storage_dir) {
+        return;
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:cold_cache"),
+      {
+        sm::make_derive(
+          "hits",
+          [] { return internal::cold_chunks().get_stats().hits; },
+          sm::description("Number of chunk reads of cold segments served "
+                          "from the local staging cache")),
+        sm::make_derive(
+          "misses",
+          [] { return internal::cold_chunks().get_stats().misses; },
+          sm::description("Number of chunk reads of cold segments served "
+                          "from the storage tier")),
+        sm::make_derive(
+          "prefetches",
+          [] { return internal::cold_chunks().get_stats().prefetches; },
+          sm::description("Number of chunks read ahead from the storage "
+                          "tier")),
+        sm::make_derive(
+          "evictions",
+          [] { return internal::cold_chunks().get_stats().evictions; },
+          sm::description("Number of staged chunks dropped to stay within "
+                          "the cache size")),
+        sm::make_gauge(
+          "bytes",
+          [] { return internal::cold_chunks().get_stats().bytes; },
+          sm::description("Bytes of chunks staged on local disk")),
+      });
 }
 void log_manager::trigger_housekeeping() {
     (void)ss::with_gate(_open_gate, [this] {
-        auto next_housekeeping = _jitter();
-        return housekeeping().finally([this, next_housekeeping] {
-            // all of these *MUST* be in the finally
-            if (_open_gate.is_closed()) {
-                return;
-            }
+        return ss::with_scheduling_group(
+                 _config.compaction_sg,
+                 [this] {
+                     return _housekeeping_lock.with(
+                       [this] { return housekeeping(); });
+                 })
+          .finally([this] {
+              // all of these *MUST* be in the finally
+              if (_open_gate.is_closed()) {
+                  return;
+              }
 
-            _compaction_timer.rearm(next_housekeeping);
-        });
+              arm_housekeeping();
+          });
     }).handle_exception([](std::exception_ptr e) {
         vlog(stlog.info, "Error processing housekeeping(): {}", e);
     });
 }
 
-ss::future<> log_manager::stop() {
-    _compaction_timer.cancel();
-    _abort_source.request_abort();
-    return _open_gate.close().then([this] {
-        return ss::parallel_for_each(_logs, [](logs_type::value_type& entry) {
-            return entry.second.handle.close();
+void log_manager::trigger_disk_pressure_reclaim() {
+    (void)ss::with_gate(_open_gate, [this] {
+        return ss::with_scheduling_group(
+                 _config.compaction_sg,
+                 [this] {
+                     return _housekeeping_lock.with(
+                       [this] { return reclaim_disk_pressure(); });
+                 })
+          .finally([this] {
+              if (!_open_gate.is_closed()) {
+                  _disk_pressure_timer.arm(_config.disk_pressure_interval);
+              }
+          });
+    }).handle_exception([](std::exception_ptr e) {
+        vlog(stlog.info, "Error reclaiming disk space: {}", e);
+    });
+}
+
+ss::future<> log_manager::reclaim_disk_pressure() {
+    std::vector<ss::sstring> dirs = _config.extra_dirs;
+    dirs.push_back(_config.base_dir);
+    return ss::do_with(std::move(dirs), [this](std::vector<ss::sstring>& dirs) {
+        return ss::do_for_each(dirs, [this](const ss::sstring& dir) {
+            return ss::engine().statvfs(dir).then(
+              [this, &dir](struct statvfs st) {
+                  return reclaim_disk_pressure(dir, st);
+              });
         });
     });
 }
 
-inline logs_type::iterator find_next_non_compacted_log(logs_type& logs) {
-    using bflags = log_housekeeping_meta::bitflags;
-    return std::find_if(
-      logs.begin(), logs.end(), [](const logs_type::value_type& l) {
-          return bflags::none == (l.second.flags & bflags::compacted);
+bool log_manager::in_cold_storage(const segment_file& s) const {
+    if (!_config.cold_storage_dir) {
+        return false;
+    }
+    const auto& cold = *_config.cold_storage_dir;
+    return std::string_view(s.data_path).substr(0, cold.size())
+           == std::string_view(cold);
+}
+
+ss::future<> log_manager::reclaim_disk_pressure(
+  const ss::sstring& dir, const struct statvfs& st) {
+    const uint64_t total = uint64_t(st.f_blocks) * st.f_frsize;
+    const uint64_t free = uint64_t(st.f_bavail) * st.f_frsize;
+    if (free * 100 >= total * _config.disk_pressure_free_percent) {
+        return ss::now();
+    }
+    const uint64_t target = total
+                            * std::max(
+                              _config.disk_pressure_free_percent,
+                              _config.disk_pressure_target_free_percent)
+                            / 100;
+    const uint64_t used = uint64_t(st.f_blocks - st.f_bfree) * st.f_frsize;
+    /**
+     * The shards share the directory but not their logs, each frees its part
+     * of the missing space in proportion to the bytes it holds there. The
+     * gc of a log only removes a prefix of its segments, a segment is ranked
+     * by the newest timestamp up to it. The oldest segments of all the logs
+     * of the shard go first, through a single eviction time for the gc of
+     * each log. Internal logs are never collected, see disk_log_impl::gc().
+     */
+    struct candidate {
+        model::timestamp max_timestamp;
+        size_t size_bytes;
+    };
+    std::vector<candidate> candidates;
+    std::vector<model::ntp> ntps;
+    size_t held = 0;
+    for (const auto& [ntp, meta] : _logs) {
+        const auto& l = meta.handle;
+        if (l.config().base_directory() != dir) {
+            continue;
+        }
+        const auto segments = l.closed_segments();
+        const bool eligible = l.config().is_collectable()
+                              && ntp.ns() != "redpanda"
+                              && ntp.ns() != "kafka_internal";
+        auto ts = model::timestamp::min();
+        for (const auto& s : segments) {
+            if (in_cold_storage(s)) {
+                continue;
+            }
+            held += s.size_bytes;
+            ts = std::max(ts, s.max_timestamp);
+            if (eligible) {
+                candidates.push_back(candidate{ts, s.size_bytes});
+            }
+        }
+        if (eligible && !segments.empty()) {
+            ntps.push_back(ntp);
+        }
+    }
+    const auto share = uint64_t(
+      double(target - free) * held
+      / std::max<uint64_t>(1, std::max<uint64_t>(used, held)));
+    if (share == 0 || candidates.empty()) {
+        return ss::now();
+    }
+    std::sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const candidate& a, const candidate& b) {
+          return a.max_timestamp < b.max_timestamp;
+      });
+    size_t selected = 0;
+    auto threshold = model::timestamp::min();
+    for (const auto& c : candidates) {
+        threshold = c.max_timestamp;
+        selected += c.size_bytes;
+        if (selected >= share) {
+            break;
+        }
+    }
+    vlog(
+      stlog.warn,
+      "{} has {} of {} bytes free, removing {} bytes of segments up to "
+      "timestamp {} of {} logs",
+      dir,
+      free,
+      total,
+      selected,
+      threshold,
+      ntps.size());
+    ++_disk_pressure_reclaims;
+    auto cfg = compaction_config(
+      threshold,
+      std::nullopt,
+      compaction_priority(),
+      _abort_source,
+      debug_sanitize_files::no,
+      &_compaction_throttle);
+    return ss::do_with(
+      std::move(ntps), [this, cfg](std::vector<model::ntp>& ntps) {
+          return ss::do_for_each(ntps, [this, cfg](const model::ntp& ntp) {
+              auto it = _logs.find(ntp);
+              if (it == _logs.end() || _abort_source.abort_requested()) {
+                  return ss::now();
+              }
+              auto bytes = [](const log& l) {
+                  size_t sum = 0;
+                  for (const auto& s : l.closed_segments()) {
+                      sum += s.size_bytes;
+                  }
+                  return sum;
+              };
+              auto l = it->second.handle;
+              const auto before = bytes(l);
+              return l.compact(cfg)
+                .then([this, l, before, bytes] {
+                    const auto after = bytes(l);
+                    if (after < before) {
+                        _disk_pressure_reclaimed_bytes += before - after;
+                    }
+                })
+                .handle_exception([ntp](std::exception_ptr e) {
+                    vlog(
+                      stlog.warn,
+                      "Error removing segments of {} to free disk space: {}",
+                      ntp,
+                      e);
+                });
+          });
       });
 }
+
+ss::future<> log_manager::start() {
+    std::vector<ss::sstring> dirs = _config.extra_dirs;
+    dirs.push_back(_config.base_dir);
+    // every shard has a pool of its own in each data directory
+    auto f = ss::do_with(dirs, [this](std::vector<ss::sstring>& dirs) {
+        return ss::do_for_each(dirs, [this](const ss::sstring& dir) {
+            return _segment_pool.recover(dir);
+        });
+    });
+    // the trash of a directory is shared by the shards
+    if (ss::this_shard_id() != 0) {
+        return f;
+    }
+    if (_config.cold_storage_dir) {
+        dirs.push_back(*_config.cold_storage_dir);
+    }
+    return f.then([this, dirs = std::move(dirs)]() mutable {
+        return ss::do_with(
+          std::move(dirs), [this](std::vector<ss::sstring>& dirs) {
+              return ss::do_for_each(dirs, [this](const ss::sstring& dir) {
+                  return _reaper.recover(dir);
+              });
+          });
+    });
+}
+
+ss::future<> log_manager::stop() {
+    _compaction_timer.cancel();
+    _cache_target_timer.cancel();
+    _disk_pressure_timer.cancel();
+    _probes.stop();
+    _abort_source.request_abort();
+    return _open_gate.close()
+      .then([this] {
+          return ss::parallel_for_each(
+            _logs, [](logs_type::value_type& entry) {
+                return entry.second.handle.close();
+            });
+      })
+      .then([this] { return _reaper.stop(); })
+      .then([this] { return _segment_pool.stop(); })
+      .then([] { return internal::cold_chunks().stop(); });
+}
+
+void log_manager::arm_housekeeping() {
+    // the jittered interval bounds the wait, the queue only brings the next
+    // round forward
+    auto next = _jitter();
+    if (!_housekeeping_queue.empty()) {
+        next = std::min(
+          next,
+          std::max(
+            _housekeeping_queue.top().due,
+            housekeeping_clock::now() + housekeeping_min_interval));
+    }
+    _compaction_timer.rearm(next);
+}
+
+log_manager::housekeeping_clock::time_point
+log_manager::housekeeping_due(const log& l) const {
+    const auto now = housekeeping_clock::now();
+    // compaction and the growth of the active segment are not predictable
+    // from the closed segments, every log is still visited each interval
+    auto due = now + _config.compaction_interval;
+    if (!l.config().is_collectable()) {
+        return due;
+    }
+    auto segments = l.closed_segments();
+    if (segments.empty()) {
+        return due;
+    }
+    if (_config.retention_bytes) {
+        size_t bytes = 0;
+        for (const auto& s : segments) {
+            bytes += s.size_bytes;
+        }
+        if (bytes > *_config.retention_bytes) {
+            return now;
+        }
+    }
+    // a segment is due once its newest batch is older than the retention
+    auto due_after = [now](const segment_file& s, std::chrono::milliseconds r) {
+        const auto left = s.max_timestamp.value() + r.count()
+                          - model::timestamp::now().value();
+        return left <= 0 ? now : now + std::chrono::milliseconds(left);
+    };
+    due = std::min(due, due_after(segments.front(), _config.delete_retention));
+    if (_config.cold_storage_dir) {
+        auto local = std::find_if(
+          segments.begin(), segments.end(), [this](const segment_file& s) {
+              return !in_cold_storage(s);
+          });
+        if (local != segments.end()) {
+            due = std::min(
+              due, due_after(*local, _config.cold_storage_local_retention));
+        }
+    }
+    return due;
+}
+
+void log_manager::schedule_housekeeping(
+  log_housekeeping_meta& meta, bool visited) {
+    const auto now = housekeeping_clock::now();
+    auto due = housekeeping_due(meta.handle);
+    if (visited && due <= now) {
+        // still due right after a visit, e.g. a segment timestamped in the
+        // future holds back the ones behind it: wait for the next interval
+        due = now + _config.compaction_interval;
+    }
+    meta.next_housekeeping = due;
+    _housekeeping_queue.push(
+      housekeeping_entry{.due = due, .ntp = meta.handle.config().ntp()});
+    // while a round runs the timer is disarmed, it is armed after the round
+    if (_compaction_timer.armed() && due < _compaction_timer.get_timeout()) {
+        arm_housekeeping();
+    }
+}
+
+void log_manager::defer_housekeeping(log_housekeeping_meta& meta) {
+    const auto due = housekeeping_clock::now() + housekeeping_min_interval;
+    meta.next_housekeeping = due;
+    _housekeeping_queue.push(
+      housekeeping_entry{.due = due, .ntp = meta.handle.config().ntp()});
+}
+
 ss::future<> log_manager::housekeeping() {
     auto collection_threshold = model::timestamp(
       model::timestamp::now().value() - _config.delete_retention.count());
+    std::optional<model::timestamp> cold_storage_threshold;
+    if (_config.cold_storage_dir) {
+        cold_storage_threshold = model::timestamp(
+          model::timestamp::now().value()
+          - _config.cold_storage_local_retention.count());
+    }
     /**
-     * Note that this loop does a double find - which is not fast. This solution
-     * is the tradeoff to *not* lock the segment during log_manager::remove(ntp)
-     * and to *not* use an ordered container.
-     *
-     * The issue with keeping an iterator and effectively doing a iterator++
-     * is that during a concurrent log_manager::remove() we invalidate all the
-     * iterators for the absl::flat_hash_map; - an alternative here would be to
-     * use a lock
-     *
-     * Note that we also do not use an ordered container like an absl::tree-set
-     * because finds are frequent on this datastructure and we want to serve
-     * them as fast as we can since the majority of the time they will be in the
-     * hotpath / (request-response)
+     * Only the logs due by the start of the round are visited. Logs that are
+     * only collected keep the order of their deadlines, compacted logs follow
+     * with the dirtiest first, as long as their dirty bytes fit in the budget
+     * of the round. The rest wait for the next round. The visits hold ntps
+     * rather than iterators, the log is looked up again because a concurrent
+     * log_manager::remove() invalidates the iterators of the
+     * absl::flat_hash_map.
      */
-    using bflags = log_housekeeping_meta::bitflags;
-    return ss::do_until(
-             [this] {
-                 auto it = find_next_non_compacted_log(_logs);
-                 return it == _logs.end();
-             },
-             [this, collection_threshold] {
-                 auto it = find_next_non_compacted_log(_logs);
-                 if (it == _logs.end()) {
-                     // must check again because between the stop condition
-                     // and this continuation we might have removed the log
-                     return ss::now();
-                 }
-                 it->second.flags |= bflags::compacted;
-                 it->second.last_compaction = ss::lowres_clock::now();
-                 return it->second.handle.compact(compaction_config(
-                   collection_threshold,
-                   // TODO: [ch433] - this configuration needs to be updated
-                   _config.retention_bytes,
-                   // TODO: change default priority in application.cc
-                   ss::default_priority_class(),
-                   _abort_source));
-             })
-      .finally([this] {
-          for (auto& h : _logs) {
-              h.second.flags &= ~bflags::compacted;
+    struct visit {
+        model::ntp ntp;
+        bool compacted;
+        compaction_backlog backlog;
+    };
+    std::vector<visit> visits;
+    const auto now = housekeeping_clock::now();
+    while (!_housekeeping_queue.empty()
+           && _housekeeping_queue.top().due <= now) {
+        auto entry = _housekeeping_queue.top();
+        _housekeeping_queue.pop();
+        auto it = _logs.find(entry.ntp);
+        if (it == _logs.end() || it->second.next_housekeeping != entry.due) {
+            continue;
+        }
+        const auto& l = it->second.handle;
+        visits.push_back(visit{
+          .ntp = std::move(entry.ntp),
+          .compacted = l.config().is_compacted(),
+          .backlog = l.backlog(),
+        });
+    }
+    std::stable_sort(
+      visits.begin(), visits.end(), [](const visit& a, const visit& b) {
+          if (a.compacted != b.compacted) {
+              return !a.compacted;
           }
+          return a.backlog.dirty_ratio() > b.backlog.dirty_ratio();
+      });
+    return ss::do_with(
+      std::move(visits),
+      size_t(0),
+      [this, collection_threshold, cold_storage_threshold](
+        std::vector<visit>& visits, size_t& spent) {
+          return ss::do_for_each(
+            visits,
+            [this, collection_threshold, cold_storage_threshold, &spent](
+              visit& v) {
+                if (_abort_source.abort_requested()) {
+                    return ss::now();
+                }
+                auto it = _logs.find(v.ntp);
+                if (it == _logs.end()) {
+                    return ss::now();
+                }
+                const auto budget = _config.compaction_round_max_bytes;
+                const auto dirty = v.backlog.dirty_bytes;
+                // the dirtiest log is compacted even when over the budget
+                if (budget > 0 && spent > 0 && spent + dirty > budget) {
+                    defer_housekeeping(it->second);
+                    return ss::now();
+                }
+                spent += dirty;
+                auto cfg = compaction_config(
+                  collection_threshold,
+                  // TODO: [ch433] - this configuration needs to be updated
+                  _config.retention_bytes,
+                  compaction_priority(),
+                  _abort_source,
+                  debug_sanitize_files::no,
+                  &_compaction_throttle);
+                cfg.cold_storage_time = cold_storage_threshold;
+                cfg.cold_storage_dir = _config.cold_storage_dir;
+                return it->second.handle.compact(cfg)
+                  .handle_exception([ntp = v.ntp](std::exception_ptr e) {
+                      vlog(
+                        stlog.warn, "Error in housekeeping of {}: {}", ntp, e);
+                  })
+                  .finally([this, &v] {
+                      // the log may have been removed while it was compacted
+                      if (auto it = _logs.find(v.ntp); it != _logs.end()) {
+                          schedule_housekeeping(it->second, true);
+                      }
+                  });
+            });
       });
 }
+
 ss::future<ss::lw_shared_ptr<segment>> log_manager::make_log_segment(
   const ntp_config& ntp,
   model::offset base_offset,
@@ -145,18 +701,71 @@ ss::future<ss::lw_shared_ptr<segment>> log_manager::make_log_segment(
   size_t buf_size) {
     return ss::with_gate(
       _open_gate, [this, &ntp, base_offset, term, pc, version, buf_size] {
+          auto path = segment_path::make_segment_path(
+            ntp, base_offset, term, version);
+          return _segment_pool.take(ntp.base_directory(), std::move(path))
+            .then([this, &ntp, base_offset, term, pc, version, buf_size](
+                    std::optional<size_t> preallocated) {
+                return make_segment(
+                  ntp,
+                  base_offset,
+                  term,
+                  pc,
+                  version,
+                  buf_size,
+                  _config.sanitize_fileops,
+                  create_cache(),
+                  preallocated.value_or(0));
+            });
+      });
+}
+
+ss::future<prepared_segment_files>
+log_manager::prepare_log_segment(const ntp_config& ntp) {
+    return ss::with_gate(_open_gate, [this, &ntp] {
+        auto dir = std::filesystem::path(ntp.work_directory());
+        // a kept file of a removed segment is allocated already
+        return _segment_pool
+          .take(ntp.base_directory(), dir / prepared_segment_files::data_name)
+          .then([this, &ntp, dir](std::optional<size_t> preallocated) {
+              return prepare_segment_files(
+                dir,
+                ntp.is_compacted(),
+                _config.sanitize_fileops,
+                preallocated.value_or(0));
+          });
+    });
+}
+
+ss::future<ss::lw_shared_ptr<segment>> log_manager::make_log_segment(
+  const ntp_config& ntp,
+  model::offset base_offset,
+  model::term_id term,
+  ss::io_priority_class pc,
+  prepared_segment_files files) {
+    return ss::with_gate(
+      _open_gate,
+      [this, &ntp, base_offset, term, pc, files = std::move(files)]() mutable {
           return make_segment(
             ntp,
             base_offset,
             term,
             pc,
-            version,
-            buf_size,
-            _config.sanitize_fileops,
-            create_cache());
+            record_version_type::v1,
+            default_segment_readahead_size,
+            create_cache(),
+            std::move(files));
       });
 }
 
+std::optional<std::filesystem::path>
+log_manager::cold_storage_directory(const ntp_config& cfg) const {
+    if (!_config.cold_storage_dir) {
+        return std::nullopt;
+    }
+    return std::filesystem::path(*_config.cold_storage_dir) / cfg.ntp().path();
+}
+
 std::optional<batch_cache_index> log_manager::create_cache() {
     if (unlikely(_config.cache == log_config::with_cache::no)) {
         return std::nullopt;
@@ -179,27 +788,107 @@ ss::future<log> log_manager::do_manage(ntp_config cfg) {
     ss::sstring path = cfg.work_directory();
     vassert(
       _logs.find(cfg.ntp()) == _logs.end(), "cannot double register same ntp");
-    if (_config.stype == log_config::storage_type::memory) {
+    if (
+      _config.stype == log_config::storage_type::memory || cfg.is_ephemeral()) {
         auto l = storage::make_memory_backed_log(std::move(cfg));
-        _logs.emplace(l.config().ntp(), l);
+        auto [it, _] = _logs.emplace(l.config().ntp(), l);
+        schedule_housekeeping(it->second, false);
         // in-memory needs to write vote_for configuration
         return ss::recursive_touch_directory(path).then([l] { return l; });
     }
-    return recover_segments(
-             std::filesystem::path(path),
-             _config.sanitize_fileops,
-             cfg.is_compacted(),
-             [this] { return create_cache(); },
-             _abort_source)
-      .then([this, cfg = std::move(cfg)](segment_set segments) mutable {
-          auto l = storage::make_disk_backed_log(
-            std::move(cfg), *this, std::move(segments), _kvstore);
-          auto [_, success] = _logs.emplace(l.config().ntp(), l);
-          vassert(success, "Could not keep track of:{} - concurrency issue", l);
-          return l;
+    return place(std::move(cfg)).then([this](ntp_config cfg) {
+        return recover_segments(
+                 std::filesystem::path(cfg.work_directory()),
+                 _config.sanitize_fileops,
+                 cfg.is_compacted(),
+                 [this] { return create_cache(); },
+                 _abort_source,
+                 cold_storage_directory(cfg))
+          .then([this, cfg = std::move(cfg)](segment_set segments) mutable {
+              auto l = storage::make_disk_backed_log(
+                std::move(cfg), *this, std::move(segments), _kvstore);
+              auto [it, success] = _logs.emplace(l.config().ntp(), l);
+              vassert(
+                success, "Could not keep track of:{} - concurrency issue", l);
+              schedule_housekeeping(it->second, false);
+              return l;
+          });
+    });
+}
+
+ss::future<ntp_config> log_manager::place(ntp_config cfg) {
+    // logs asked for in another directory are left there
+    if (
+      _config.extra_dirs.empty()
+      || cfg.base_directory() != _config.base_dir) {
+        return ss::make_ready_future<ntp_config>(std::move(cfg));
+    }
+    struct placement {
+        ntp_config cfg;
+        std::vector<ss::sstring> dirs;
+        std::optional<ss::sstring> existing;
+        ss::sstring best;
+        double best_score{-1};
+    };
+    std::vector<ss::sstring> dirs;
+    dirs.reserve(_config.extra_dirs.size() + 1);
+    dirs.push_back(_config.base_dir);
+    dirs.insert(
+      dirs.end(), _config.extra_dirs.begin(), _config.extra_dirs.end());
+    return ss::do_with(
+      placement{.cfg = std::move(cfg), .dirs = std::move(dirs)},
+      [this](placement& p) {
+          // a log stays on the disk it was created on
+          return ss::do_for_each(
+                   p.dirs,
+                   [&p](const ss::sstring& dir) {
+                       if (p.existing) {
+                           return ss::now();
+                       }
+                       return ss::file_exists(p.cfg.work_directory(dir))
+                         .then([&p, dir](bool exists) {
+                             if (exists) {
+                                 p.existing = dir;
+                             }
+                         });
+                   })
+            .then([this, &p] {
+                if (p.existing) {
+                    return ss::now();
+                }
+                // the most free space per log of this shard
+                return ss::do_for_each(
+                  p.dirs, [this, &p](const ss::sstring& dir) {
+                      return ss::engine().statvfs(dir).then(
+                        [this, &p, dir](struct statvfs st) {
+                            const double free = double(st.f_bavail)
+                                                * st.f_frsize;
+                            const double score = free / (1 + logs_in(dir));
+                            if (score > p.best_score) {
+                                p.best = dir;
+                                p.best_score = score;
+                            }
+                        });
+                  });
+            })
+            .then([&p] {
+                p.cfg.base_directory() = p.existing ? *p.existing : p.best;
+                vlog(
+                  stlog.debug,
+                  "Placed {} in {}",
+                  p.cfg.ntp(),
+                  p.cfg.base_directory());
+                return std::move(p.cfg);
+            });
       });
 }
 
+size_t log_manager::logs_in(const ss::sstring& dir) const {
+    return std::count_if(_logs.begin(), _logs.end(), [&dir](const auto& l) {
+        return l.second.handle.config().base_directory() == dir;
+    });
+}
+
 ss::future<> log_manager::remove(model::ntp ntp) {
     vlog(stlog.info, "Asked to remove: {}", ntp);
     return ss::with_gate(_open_gate, [this, ntp = std::move(ntp)] {
@@ -211,14 +900,34 @@ ss::future<> log_manager::remove(model::ntp ntp) {
         storage::log lg = handle.mapped().handle;
         vlog(stlog.info, "Removing: {}", lg);
         // NOTE: it is ok to *not* externally synchronize the log here
-        // because remove, takes a write lock on each individual segments
-        // waiting for all of them to be closed before actually removing the
-        // underlying log. If there is a background operation like
-        // compaction or so, it will block correctly.
+        // because close, takes a write lock on each individual segments
+        // waiting for all of them to be closed before moving the underlying
+        // log. If there is a background operation like compaction or so, it
+        // will block correctly.
         auto ntp_dir = lg.config().work_directory();
+        auto base_dir = lg.config().base_directory();
         ss::sstring topic_dir = lg.config().topic_directory().string();
-        return lg.remove()
-          .then([dir = std::move(ntp_dir)] { return ss::remove_file(dir); })
+        auto cold_dir = cold_storage_directory(lg.config());
+        return lg.close()
+          .then([this, keys = kvstore_keys(lg.config().ntp())]() mutable {
+              return ss::do_with(
+                std::move(keys), [this](std::vector<bytes>& keys) {
+                    return ss::do_for_each(keys, [this](bytes& key) {
+                        return _kvstore.remove(
+                          kvstore::key_space::storage, std::move(key));
+                    });
+                });
+          })
+          .then([this, dir = std::move(ntp_dir), base = std::move(base_dir)] {
+              return move_to_trash(dir, base);
+          })
+          .then([this, dir = std::move(cold_dir)] {
+              if (!dir) {
+                  return ss::now();
+              }
+              // the cold segments go with the log
+              return move_to_trash(dir->string(), *_config.cold_storage_dir);
+          })
           .then([this, dir = std::move(topic_dir)]() mutable {
               // We always dispatch topic directory deletion to core 0 as
               // requests may come from different cores
@@ -228,6 +937,53 @@ ss::future<> log_manager::remove(model::ntp ntp) {
     });
 }
 
+ss::future<>
+log_manager::move_to_trash(ss::sstring dir, const ss::sstring& base) {
+    auto trash = log_reaper::trash_directory(base);
+    auto name = std::filesystem::path(dir).lexically_relative(base).string();
+    std::replace(name.begin(), name.end(), '/', '_');
+    // unique across restarts, the trash may still hold an earlier copy
+    auto target = trash
+                  / fmt::format(
+                    "{}-{}-{}-{}",
+                    name,
+                    model::timestamp::now().value(),
+                    ss::this_shard_id(),
+                    _trash_seq++);
+    return ss::file_exists(dir).then(
+      [this, dir, trash, target = std::move(target)](bool exists) {
+          if (!exists) {
+              return ss::now();
+          }
+          // the trash is on the file system of the directory, moving the
+          // log is a rename regardless of its size
+          return ss::recursive_touch_directory(trash.string())
+            .then([dir, target] {
+                return ss::rename_file(dir, target.string());
+            })
+            .then([this, target] { _reaper.enqueue(target); });
+      });
+}
+
+ss::future<> log_manager::shutdown(model::ntp ntp) {
+    vlog(stlog.info, "Asked to shutdown: {}", ntp);
+    return ss::with_gate(_open_gate, [this, ntp = std::move(ntp)] {
+        auto handle = _logs.extract(ntp);
+        if (handle.empty()) {
+            return ss::make_ready_future<>();
+        }
+        storage::log lg = handle.mapped().handle;
+        vlog(stlog.info, "Shutting down: {}", lg);
+        // like remove, close waits for the background operations holding
+        // the segments
+        return lg.close().finally([lg] {});
+    });
+}
+
+std::vector<bytes> log_manager::kvstore_keys(const model::ntp& ntp) {
+    return {disk_log_impl::start_offset_key(ntp)};
+}
+
 ss::future<> log_manager::dispatch_topic_dir_deletion(ss::sstring dir) {
     return ss::smp::submit_to(0, [dir = std::move(dir)]() mutable {
         static thread_local mutex fs_lock;
@@ -282,12 +1038,34 @@ std::ostream& operator<<(std::ostream& o, const log_config& c) {
     return o << ", compaction_interval_ms:" << c.compaction_interval.count()
              << ", delete_reteion_ms:" << c.delete_retention.count()
              << ", with_cache:" << c.cache
-             << ", relcaim_opts:" << c.reclaim_opts << "}";
+             << ", relcaim_opts:" << c.reclaim_opts
+             << ", compaction_max_bytes_per_sec:"
+             << c.compaction_throttle_cfg.max_bytes_per_sec
+             << ", compaction_target_latency_ms:"
+             << c.compaction_throttle_cfg.target_latency.count()
+             << ", compaction_round_max_bytes:" << c.compaction_round_max_bytes
+             << ", log_deletion_max_bytes_per_sec:"
+             << c.reaper_cfg.max_bytes_per_sec
+             << ", segment_pool_files:" << c.segment_pool_files
+             << ", segment_prepare_percent:" << c.segment_prepare_percent
+             << ", readers_cache_size:" << c.readers_cache_cfg.max_readers
+             << ", readers_cache_idle_ms:"
+             << c.readers_cache_cfg.idle_timeout.count()
+             << ", aggregate_metrics:" << c.probes_cfg.aggregate
+             << ", metrics_detail_limit:" << c.probes_cfg.detail_limit
+             << ", index_interval:" << c.index_interval
+             << ", adaptive_index:" << c.adaptive_index
+             << ", cold_storage_dir:" << c.cold_storage_dir.value_or("none")
+             << ", cold_storage_local_retention_ms:"
+             << c.cold_storage_local_retention.count()
+             << ", disk_pressure_free_percent:" << c.disk_pressure_free_percent
+             << ", disk_pressure_target_free_percent:"
+             << c.disk_pressure_target_free_percent << "}";
 }
 std::ostream& operator<<(std::ostream& o, const log_manager& m) {
     return o << "{config:" << m._config << ", logs.size:" << m._logs.size()
              << ", cache:" << m._batch_cache
              << ", compaction_timer.armed:" << m._compaction_timer.armed()
-             << "}";
+             << ", compaction_throttle:" << m._compaction_throttle << "}";
 }
 } // namespace storage
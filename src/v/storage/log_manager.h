@@ -13,12 +13,19 @@
 
 #include "model/fundamental.h"
 #include "random/simple_time_jitter.h"
+#include "resource_mgmt/memory_broker.h"
 #include "seastarx.h"
 #include "storage/batch_cache.h"
+#include "storage/compaction_throttle.h"
 #include "storage/kvstore.h"
 #include "storage/log.h"
 #include "storage/log_housekeeping_meta.h"
+#include "storage/log_reaper.h"
+#include "storage/probe.h"
+#include "storage/readers_cache.h"
 #include "storage/segment.h"
+#include "storage/segment_chunk_cache.h"
+#include "storage/segment_file_pool.h"
 #include "storage/types.h"
 #include "storage/version.h"
 #include "units.h"
@@ -29,13 +36,21 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/scheduling.hh>
 #include <seastar/core/sstring.hh>
 
 #include <absl/container/flat_hash_map.h>
 
 #include <array>
+#include <memory>
 #include <chrono>
+#include <functional>
 #include <optional>
+#include <queue>
+#include <vector>
+
+#include <sys/statvfs.h>
 
 namespace storage {
 
@@ -112,6 +127,48 @@ struct log_config {
       .min_size = 128_KiB,
       .max_size = 4_MiB,
     };
+    // scheduling group and rate limit for background compaction
+    ss::scheduling_group compaction_sg = ss::default_scheduling_group();
+    compaction_throttle::config compaction_throttle_cfg;
+    // dirty bytes of the compacted logs visited by a housekeeping round,
+    // zero compacts every log that is due
+    size_t compaction_round_max_bytes{0};
+    // window in which segment fsyncs on a shard are batched
+    std::chrono::microseconds flush_coalesce_window{0};
+    // closed segments older than the local retention move to this directory
+    std::optional<ss::sstring> cold_storage_dir;
+    std::chrono::milliseconds cold_storage_local_retention
+      = std::chrono::hours(24);
+    // local staging of the chunks read from the storage tier
+    internal::segment_chunk_cache::config cold_cache_cfg;
+    // bytes of batches between index entries, unless the topic overrides it
+    size_t index_interval = segment_index::default_data_buffer_step;
+    // derive the index interval of segments from their batch sizes
+    bool adaptive_index = false;
+    // register the appender chunks and the batch cache of the shard with
+    // the memory broker
+    bool broker_memory = false;
+    // data directories on other disks, new logs of base_dir are spread
+    // across them and base_dir
+    std::vector<ss::sstring> extra_dirs;
+    // rate limit and scheduling group of the removal of deleted logs
+    log_reaper::config reaper_cfg;
+    // data files of removed segments kept for reuse per data directory,
+    // zero removes them
+    size_t segment_pool_files{0};
+    // fill of the active segment, in percent of its size, from which the
+    // files of the next segment are prepared. zero creates them on roll
+    uint32_t segment_prepare_percent{0};
+    // readers of a log parked between fetches
+    readers_cache::config readers_cache_cfg;
+    // aggregation of the metrics of the logs
+    log_probes::config probes_cfg;
+    // free space of a data directory, in percent of its size, under which
+    // the oldest segments of the collectable logs are removed regardless of
+    // their retention until the target is free again. zero disables it
+    uint32_t disk_pressure_free_percent{0};
+    uint32_t disk_pressure_target_free_percent{0};
+    std::chrono::milliseconds disk_pressure_interval = std::chrono::seconds(10);
 
     friend std::ostream& operator<<(std::ostream& o, const log_config&);
 }; // namespace storage
@@ -134,8 +191,10 @@ struct log_config {
  *    <base>/<namespace>/<topic>/<partition>/
  *
  * where <base> is configured for each server (e.g.
- * /var/lib/redpanda/data). Log segments are stored in the ntp directory
- * with the naming convention:
+ * /var/lib/redpanda/data). With extra data directories a new log is placed
+ * on the directory with the most free space per log of this shard, an
+ * existing log is found on whichever directory holds it. Log segments are
+ * stored in the ntp directory with the naming convention:
  *
  *   <base offset>-<raft term>-<format version>.log
  *
@@ -144,6 +203,12 @@ struct log_config {
  * the segment, and <raft term> is special metadata specified by raft as
  * it interacts with the log.
  *
+ * Removed logs are moved to <base>/.deleted/ and their files are removed in
+ * the background by the log reaper of the shard. The data files of segments
+ * removed by retention or truncation may instead be kept in
+ * <base>/.recycled/<shard>/ for the next segments of the shard, see
+ * segment_file_pool.
+ *
  * Generally the log manager is instantiated as part of a sharded service
  * where each core manages a distinct set of logs. When the service is
  * shut down, calling `stop` on the log manager will close all of the
@@ -151,6 +216,10 @@ struct log_config {
  */
 class log_manager {
 public:
+    static constexpr auto cache_target_interval = std::chrono::seconds(1);
+    /// shortest time between two housekeeping rounds
+    static constexpr auto housekeeping_min_interval = std::chrono::seconds(1);
+
     explicit log_manager(log_config, kvstore& kvstore) noexcept;
 
     ss::future<log> manage(ntp_config);
@@ -158,6 +227,9 @@ public:
     /**
      * Remove an ntp and clean-up its storage.
      *
+     * The returned future resolves once the log is closed and its directory
+     * moved to the trash, the files are removed later by the log reaper.
+     *
      * NOTE: if removal of an ntp causes the parent topic directory to become
      * empty then it is also removed. Currently topic deletion is the only
      * action that drives partition removal, so this makes sense. This must be
@@ -166,6 +238,20 @@ public:
      */
     ss::future<> remove(model::ntp);
 
+    /**
+     * Close an ntp and stop managing it, leaving its storage in place.
+     *
+     * Used to hand the log over to the log manager of another shard, the
+     * kvstore entries under `kvstore_keys` belong to the log and have to be
+     * moved along.
+     */
+    ss::future<> shutdown(model::ntp);
+
+    /// Keys of the entries the log of an ntp keeps in the storage key space
+    static std::vector<bytes> kvstore_keys(const model::ntp&);
+
+    /// \brief queues the removal of the logs a previous run left in the trash
+    ss::future<> start();
     ss::future<> stop();
 
     ss::future<ss::lw_shared_ptr<segment>> make_log_segment(
@@ -176,6 +262,16 @@ public:
       record_version_type = record_version_type::v1,
       size_t buffer_size = default_segment_readahead_size);
 
+    /// \brief opens the files of the next segment of a log ahead of its roll
+    ss::future<prepared_segment_files> prepare_log_segment(const ntp_config&);
+    /// \brief the segment at `base_offset` from files prepared ahead
+    ss::future<ss::lw_shared_ptr<segment>> make_log_segment(
+      const ntp_config&,
+      model::offset base_offset,
+      model::term_id,
+      ss::io_priority_class pc,
+      prepared_segment_files);
+
     const log_config& config() const { return _config; }
 
     /// Returns the number of managed logs.
@@ -192,10 +288,44 @@ public:
     /// Returns the logs that match a model::topic_namespace
     absl::flat_hash_map<model::ntp, log> get(const model::topic_namespace&);
 
+    /// Rate limit shared by the compaction of all logs on this shard
+    compaction_throttle& throttle() { return _compaction_throttle; }
+
+    const log_reaper& reaper() const { return _reaper; }
+
+    /// Data files of removed segments reused by the next rolls
+    segment_file_pool& segment_pool() { return _segment_pool; }
+
+    /// Metrics of the logs of this shard
+    log_probes& probes() { return _probes; }
+
+    /// Bytes of segments removed ahead of their retention to free disk space
+    uint64_t disk_pressure_reclaimed_bytes() const {
+        return _disk_pressure_reclaimed_bytes;
+    }
+
 private:
     using logs_type = absl::flat_hash_map<model::ntp, log_housekeeping_meta>;
+    using housekeeping_clock = log_housekeeping_meta::clock_type;
+
+    struct housekeeping_entry {
+        housekeeping_clock::time_point due;
+        model::ntp ntp;
+
+        bool operator>(const housekeeping_entry& o) const {
+            return due > o.due;
+        }
+    };
+    // entries of removed or rescheduled logs are skipped when they are due
+    using housekeeping_queue = std::priority_queue<
+      housekeeping_entry,
+      std::vector<housekeeping_entry>,
+      std::greater<>>;
 
     ss::future<log> do_manage(ntp_config);
+    /// \brief sets the base directory of a log to the disk it belongs to
+    ss::future<ntp_config> place(ntp_config);
+    size_t logs_in(const ss::sstring& dir) const;
 
     /**
      * \brief delete old segments and trigger compacted segments
@@ -204,19 +334,58 @@ private:
     void trigger_housekeeping();
     void arm_housekeeping();
     ss::future<> housekeeping();
+    /// \brief queues the log under the time it is next due
+    void schedule_housekeeping(log_housekeeping_meta&, bool visited);
+    housekeeping_clock::time_point housekeeping_due(const log&) const;
+    /// \brief queues a log left out of a round for the next one
+    void defer_housekeeping(log_housekeeping_meta&);
+
+    /**
+     * \brief removes the oldest segments of the logs of the shard on the
+     *        data directories short of free space
+     */
+    void trigger_disk_pressure_reclaim();
+    ss::future<> reclaim_disk_pressure();
+    ss::future<>
+    reclaim_disk_pressure(const ss::sstring& dir, const struct statvfs&);
+    bool in_cold_storage(const segment_file&) const;
+
+    // samples the memory signals of the shard for the batch cache target
+    void update_cache_target();
 
     std::optional<batch_cache_index> create_cache();
+    std::optional<std::filesystem::path>
+    cold_storage_directory(const ntp_config&) const;
+
+    void setup_metrics();
 
     ss::future<> dispatch_topic_dir_deletion(ss::sstring dir);
+    /// \brief moves a directory to the trash of `base` for the reaper
+    ss::future<> move_to_trash(ss::sstring dir, const ss::sstring& base);
 
     log_config _config;
     kvstore& _kvstore;
     simple_time_jitter<ss::lowres_clock> _jitter;
     ss::timer<ss::lowres_clock> _compaction_timer;
+    ss::timer<ss::lowres_clock> _cache_target_timer;
+    ss::timer<ss::lowres_clock> _disk_pressure_timer;
+    // the housekeeping rounds and the disk pressure reclaims collect the same
+    // logs, one at a time
+    mutex _housekeeping_lock;
     logs_type _logs;
+    housekeeping_queue _housekeeping_queue;
     batch_cache _batch_cache;
     ss::gate _open_gate;
     ss::abort_source _abort_source;
+    compaction_throttle _compaction_throttle;
+    log_reaper _reaper;
+    segment_file_pool _segment_pool;
+    log_probes _probes;
+    uint64_t _trash_seq{0};
+    uint64_t _disk_pressure_reclaims{0};
+    uint64_t _disk_pressure_reclaimed_bytes{0};
+    std::vector<std::unique_ptr<memory_broker::pool>> _memory_pools;
+    ss::metrics::metric_groups _metrics;
 
     friend std::ostream& operator<<(std::ostream&, const log_manager&);
 };
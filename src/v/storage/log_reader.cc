@@ -41,6 +41,8 @@ batch_consumer::consume_result skipping_consumer::consume_batch_start(
     _expected_next_batch = header.last_offset() + model::offset(1);
 
     if (header.last_offset() < _reader._config.start_offset) {
+        // read past from the index entry found for the start offset
+        _reader._probe.add_index_seek_bytes(header.size_bytes);
         return skip_batch::yes;
     }
     if (header.base_offset() > _reader._config.max_offset) {
@@ -118,6 +120,7 @@ std::unique_ptr<continuous_batch_parser> log_segment_batch_reader::initialize(
   model::timeout_clock::time_point timeout,
   std::optional<model::offset> next_cached_batch) {
     auto input = _seg.offset_data_stream(_config.start_offset, _config.prio);
+    _probe.index_seek();
     return std::make_unique<continuous_batch_parser>(
       std::make_unique<skipping_consumer>(*this, timeout, next_cached_batch),
       std::move(input));
@@ -138,8 +141,15 @@ void log_segment_batch_reader::add_one(model::record_batch&& batch) {
     _config.bytes_consumed += size_bytes;
     _state.buffer_size += size_bytes;
     _probe.add_bytes_read(size_bytes);
-    if (!_config.skip_batch_cache) {
+    /*
+     * segments that are no longer appended to are read by catch-up consumers
+     * and recovery. those reads are read-once, and inserting every batch into
+     * the cache would copy it and evict the hot tail of the log.
+     */
+    if (
+      !_config.skip_batch_cache && _seg.has_appender() && _seg.has_cache()) {
         _seg.cache_put(b);
+        _probe.batch_cache_admit();
     }
 }
 ss::future<result<records_t>>
@@ -147,26 +157,41 @@ log_segment_batch_reader::read_some(model::timeout_clock::time_point timeout) {
     /*
      * fetch batches from the cache covering the range [_base, end] where
      * end is either the configured max offset or the end of the segment.
+     * only the batches that fit in what is left of the byte budget are
+     * shared, the same rule the skipping consumer applies to the headers
+     * read from disk.
      */
+    const auto left = _config.max_bytes
+                      - std::min(_config.bytes_consumed, _config.max_bytes);
     auto cache_read = _seg.cache_get(
       _config.start_offset,
       _config.max_offset,
       _config.type_filter,
       _config.first_timestamp,
       max_buffer_size,
-      _config.skip_batch_cache);
+      _config.skip_batch_cache,
+      left,
+      _config.strict_max_bytes || _config.bytes_consumed > 0);
 
     // handles cases where the type filter skipped batches. see
     // batch_cache_index::read for more details.
     _config.start_offset = cache_read.next_batch;
+    if (cache_read.over_budget) {
+        // the next batch is cached, reading its header from disk would not
+        // change that it does not fit
+        _config.over_budget = true;
+    }
 
     if (
-      !cache_read.batches.empty()
+      !cache_read.batches.empty() || cache_read.over_budget
       || _config.start_offset > _config.max_offset) {
-        _config.bytes_consumed += cache_read.memory_usage;
+        _config.bytes_consumed += cache_read.size_bytes;
         _probe.add_bytes_read(cache_read.memory_usage);
         _probe.add_cached_bytes_read(cache_read.memory_usage);
         _probe.add_cached_batches_read(cache_read.batches.size());
+        if (!cache_read.batches.empty()) {
+            _probe.batch_cache_hit();
+        }
         return ss::make_ready_future<result<records_t>>(
           std::move(cache_read.batches));
     }
@@ -181,9 +206,23 @@ log_segment_batch_reader::read_some(model::timeout_clock::time_point timeout) {
         return ss::make_ready_future<result<records_t>>(records_t{});
     }
 
+    _probe.batch_cache_miss();
     if (!_iterator) {
-        _iterator = initialize(timeout, cache_read.next_cached_batch);
+        /*
+         * the index of a cold segment may have been evicted. reload it so that
+         * the read starts near the requested offset instead of at the start of
+         * the segment.
+         */
+        return _seg.index().hydrate().then(
+          [this, timeout, next_cached = cache_read.next_cached_batch] {
+              _iterator = initialize(timeout, next_cached);
+              return read_from_disk();
+          });
     }
+    return read_from_disk();
+}
+
+ss::future<result<records_t>> log_segment_batch_reader::read_from_disk() {
     auto ptr = _iterator.get();
     return ptr->consume().then(
       [this](result<size_t> bytes_consumed) -> result<records_t> {
@@ -203,8 +242,13 @@ log_reader::log_reader(
   , _iterator(_lease->range.begin())
   , _config(config)
   , _probe(probe) {
-    if (config.abort_source) {
-        auto op_sub = config.abort_source.value().get().subscribe(
+    subscribe_abort();
+    make_segment_reader();
+}
+
+void log_reader::subscribe_abort() {
+    if (_config.abort_source) {
+        auto op_sub = _config.abort_source.value().get().subscribe(
           [this]() noexcept { set_end_of_stream(); });
 
         if (op_sub) {
@@ -214,13 +258,38 @@ log_reader::log_reader(
             set_end_of_stream();
         }
     }
+}
 
+void log_reader::make_segment_reader() {
     if (_iterator.next_seg != _lease->range.end()) {
         _iterator.reader = std::make_unique<log_segment_batch_reader>(
           **_iterator.next_seg, _config, _probe);
     }
 }
 
+ss::future<> log_reader::park() {
+    // the abort source of the request may be gone by the next one
+    _as_sub = ss::abort_source::subscription();
+    _config.abort_source = std::nullopt;
+    return _iterator.close();
+}
+
+void log_reader::reset_config(log_reader_config cfg) {
+    vassert(
+      cfg.start_offset == _config.start_offset,
+      "reader at {} cannot continue at {}",
+      _config.start_offset,
+      cfg.start_offset);
+    // the segment reader refers to the config of the log reader
+    _config = cfg;
+    _last_base = model::offset{};
+    _done = false;
+    subscribe_abort();
+    if (!_iterator.reader) {
+        make_segment_reader();
+    }
+}
+
 ss::future<> log_reader::find_next_valid_iterator() {
     if (_config.start_offset <= _iterator.offsets().dirty_offset) {
         return ss::make_ready_future<>();
@@ -235,10 +304,7 @@ ss::future<> log_reader::find_next_valid_iterator() {
             break;
         }
     }
-    if (_iterator.next_seg != _lease->range.end()) {
-        _iterator.reader = std::make_unique<log_segment_batch_reader>(
-          **_iterator.next_seg, _config, _probe);
-    }
+    make_segment_reader();
     if (tmp_reader) {
         auto raw = tmp_reader.get();
         return raw->close().finally([r = std::move(tmp_reader)] {});
@@ -251,12 +317,12 @@ log_reader::do_load_slice(model::timeout_clock::time_point timeout) {
     if (is_done()) {
         // must keep this function because, the segment might not be done
         // but offsets might have exceeded the read
-        set_end_of_stream();
+        _done = true;
         return _iterator.close().then(
           [] { return ss::make_ready_future<storage_t>(); });
     }
     if (_last_base == _config.start_offset) {
-        set_end_of_stream();
+        _done = true;
         return _iterator.close().then(
           [] { return ss::make_ready_future<storage_t>(); });
     }
@@ -311,11 +377,17 @@ static inline bool is_finished_offset(segment_set& s, model::offset o) {
     }
     return true;
 }
+bool log_reader::budget_exhausted() const {
+    // unless the read is strict, its first batch is read whatever its size
+    return (_config.strict_max_bytes || _config.bytes_consumed > 0)
+           && _config.bytes_consumed >= _config.max_bytes;
+}
+
 bool log_reader::is_done() {
     return is_end_of_stream()
            || is_finished_offset(_lease->range, _config.start_offset)
            || _config.start_offset > _config.max_offset
-           || _config.bytes_consumed > _config.max_bytes || _config.over_budget;
+           || budget_exhausted() || _config.over_budget;
 }
 
 } // namespace storage
@@ -105,6 +105,9 @@ private:
 
     void add_one(model::record_batch&&);
 
+    ss::future<result<ss::circular_buffer<model::record_batch>>>
+    read_from_disk();
+
 private:
     struct tmp_state {
         ss::circular_buffer<model::record_batch> buffer;
@@ -135,7 +138,7 @@ public:
     }
 
     bool is_end_of_stream() const final {
-        return _iterator.next_seg == _lease->range.end();
+        return _done || _iterator.next_seg == _lease->range.end();
     }
 
     ss::future<storage_t> do_load_slice(model::timeout_clock::time_point) final;
@@ -146,9 +149,29 @@ public:
         fmt::print(os, "storage::log_reader. config {}", _config);
     }
 
+    /// \brief offset the reader continues from
+    model::offset next_offset() const { return _config.start_offset; }
+    /// \brief whether the reader stopped at the bounds of its request, and
+    /// not at the end of its segments, on an abort or on an error
+    bool is_reusable() const {
+        return _iterator.next_seg != _lease->range.end();
+    }
+    const lock_manager::lease& lease() const { return *_lease; }
+
+    /// \brief closes the stream of the segment being read and detaches the
+    /// reader from the abort source of its request, see readers_cache
+    ss::future<> park();
+    /// \brief continues at next_offset() within the bounds of `cfg`, which
+    /// must start there
+    void reset_config(log_reader_config cfg);
+
 private:
     void set_end_of_stream() { _iterator.next_seg = _lease->range.end(); }
+    void subscribe_abort();
+    void make_segment_reader();
     bool is_done();
+    /// \brief no further batch fits in the byte budget of the request
+    bool budget_exhausted() const;
     ss::future<> find_next_valid_iterator();
 
     using reader_available = ss::bool_class<struct create_reader_tag>;
@@ -177,6 +200,8 @@ private:
     iterator_pair _iterator;
     log_reader_config _config;
     model::offset _last_base;
+    // the request is done, the segments may still be read by the next one
+    bool _done{false};
     probe& _probe;
     ss::abort_source::subscription _as_sub;
 };
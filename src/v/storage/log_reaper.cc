@@ -0,0 +1,163 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#include "storage/log_reaper.h"
+
+#include "storage/logger.h"
+#include "utils/directory_walker.h"
+#include "vlog.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/with_scheduling_group.hh>
+
+#include <utility>
+#include <vector>
+
+namespace storage {
+
+log_reaper::log_reaper(config cfg)
+  : _cfg(cfg)
+  , _throttle(
+      compaction_throttle::config{.max_bytes_per_sec = cfg.max_bytes_per_sec},
+      _as) {}
+
+std::filesystem::path log_reaper::trash_directory(const ss::sstring& base) {
+    return std::filesystem::path(base) / trash_dir_name;
+}
+
+void log_reaper::enqueue(std::filesystem::path dir) {
+    vlog(stlog.debug, "queued removal of {}", dir);
+    _queue.push_back(std::move(dir));
+    if (!std::exchange(_running, true)) {
+        start();
+    }
+    _cond.signal();
+}
+
+ss::future<> log_reaper::recover(const ss::sstring& base) {
+    auto trash = trash_directory(base);
+    return ss::file_exists(trash.string()).then([this, trash](bool exists) {
+        if (!exists) {
+            return ss::now();
+        }
+        return directory_walker::walk(
+          trash.string(), [this, trash](ss::directory_entry de) {
+              vlog(stlog.info, "removing leftover {}/{}", trash, de.name);
+              enqueue(trash / de.name.c_str());
+              return ss::now();
+          });
+    });
+}
+
+ss::future<> log_reaper::stop() {
+    _as.request_abort();
+    _cond.broken();
+    return _gate.close();
+}
+
+void log_reaper::start() {
+    (void)ss::with_gate(_gate, [this] {
+        return ss::with_scheduling_group(_cfg.sg, [this] { return run(); });
+    });
+}
+
+ss::future<> log_reaper::run() {
+    return ss::do_until(
+      [this] { return _as.abort_requested(); },
+      [this] {
+          return _cond.wait([this] { return !_queue.empty(); })
+            .then([this] {
+                auto dir = std::move(_queue.front());
+                _queue.pop_front();
+                _busy = true;
+                return remove_directory(dir)
+                  .handle_exception([dir](std::exception_ptr e) {
+                      // the directory is found again by the next recover()
+                      vlog(stlog.warn, "error removing {}: {}", dir, e);
+                  })
+                  .finally([this] { _busy = false; });
+            })
+            .handle_exception_type([](const ss::broken_condition_variable&) {
+            });
+      });
+}
+
+ss::future<> log_reaper::remove_directory(std::filesystem::path dir) {
+    return ss::do_with(
+      std::vector<ss::directory_entry>{},
+      [this, dir = std::move(dir)](std::vector<ss::directory_entry>& entries) {
+          return directory_walker::walk(
+                   dir.string(),
+                   [&entries](ss::directory_entry de) {
+                       entries.push_back(std::move(de));
+                       return ss::now();
+                   })
+            .then([this, &entries, dir] {
+                return ss::do_for_each(
+                  entries, [this, dir](const ss::directory_entry& de) {
+                      if (_as.abort_requested()) {
+                          return ss::now();
+                      }
+                      auto path = dir / de.name.c_str();
+                      if (de.type == ss::directory_entry_type::directory) {
+                          return remove_directory(std::move(path));
+                      }
+                      return remove_file(std::move(path));
+                  });
+            })
+            .then([this, dir] {
+                if (_as.abort_requested()) {
+                    return ss::now();
+                }
+                vlog(stlog.info, "removed {}", dir);
+                return ss::remove_file(dir.string());
+            });
+      });
+}
+
+ss::future<> log_reaper::remove_file(std::filesystem::path path) {
+    return ss::open_file_dma(path.string(), ss::open_flags::rw)
+      .then([this](ss::file f) {
+          return ss::do_with(std::move(f), [this](ss::file& f) {
+              return f.size()
+                .then([this, &f](uint64_t size) {
+                    return truncate_down(f, size);
+                })
+                .finally([&f] { return f.close(); });
+          });
+      })
+      .then([this, path] {
+          if (_as.abort_requested()) {
+              return ss::now();
+          }
+          return ss::remove_file(path.string());
+      });
+}
+
+ss::future<> log_reaper::truncate_down(ss::file& f, uint64_t size) {
+    // the extents of the last step are freed by the unlink
+    return ss::do_with(size, [this, &f](uint64_t& size) {
+        return ss::do_until(
+          [this, &size] { return size == 0 || _as.abort_requested(); },
+          [this, &f, &size] {
+              const auto step = std::min<uint64_t>(size, truncate_step);
+              return _throttle.throttle(step).then([this, &f, &size, step] {
+                  _removed_bytes += step;
+                  size -= step;
+                  return size == 0 ? ss::now() : f.truncate(size);
+              });
+          });
+    });
+}
+
+} // namespace storage
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+#include "storage/compaction_throttle.h"
+#include "units.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/condition-variable.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/sstring.hh>
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+
+namespace storage {
+
+/**
+ * Removes the files of deleted logs in the background of a shard.
+ *
+ * Removing a log moves its directory into the trash directory of the data
+ * directory holding it, which is a rename, and hands it to the reaper. The
+ * file system frees the extents of a file in the context of the unlink, for
+ * a large segment a burst of metadata writes that stalls the appends sharing
+ * the disk. The reaper truncates every file down in steps of truncate_step
+ * before unlinking it, at most max_bytes_per_sec per shard.
+ *
+ * Directories left in the trash when the shard stops are found again by
+ * recover() on the next start.
+ */
+class log_reaper {
+public:
+    static constexpr const char* trash_dir_name = ".deleted";
+    static constexpr size_t truncate_step = 32_MiB;
+
+    struct config {
+        // zero removes the files as fast as the disk allows
+        size_t max_bytes_per_sec{0};
+        ss::scheduling_group sg = ss::default_scheduling_group();
+    };
+
+    explicit log_reaper(config);
+
+    /// \brief directory of `base` that removed logs are moved to
+    static std::filesystem::path trash_directory(const ss::sstring& base);
+
+    /// \brief queues a directory of the trash for removal
+    void enqueue(std::filesystem::path);
+
+    /// \brief queues the directories left in the trash of `base`
+    ss::future<> recover(const ss::sstring& base);
+
+    ss::future<> stop();
+
+    /// directories queued or being removed
+    size_t pending() const { return _queue.size() + (_busy ? 1 : 0); }
+    uint64_t removed_bytes() const { return _removed_bytes; }
+
+private:
+    void start();
+    ss::future<> run();
+    ss::future<> remove_directory(std::filesystem::path);
+    ss::future<> remove_file(std::filesystem::path);
+    ss::future<> truncate_down(ss::file&, uint64_t size);
+
+    config _cfg;
+    ss::abort_source _as;
+    compaction_throttle _throttle;
+    std::deque<std::filesystem::path> _queue;
+    ss::condition_variable _cond;
+    ss::gate _gate;
+    bool _running{false};
+    bool _busy{false};
+    uint64_t _removed_bytes{0};
+};
+
+} // namespace storage
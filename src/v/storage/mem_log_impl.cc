@@ -7,6 +7,7 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "config/configuration.h"
 #include "likely.h"
 #include "model/fundamental.h"
 #include "model/record.h"
@@ -14,6 +15,8 @@
 #include "model/timeout_clock.h"
 #include "model/timestamp.h"
 #include "seastarx.h"
+#include "storage/committed_offset_monitor.h"
+#include "storage/key_lookup.h"
 #include "storage/log.h"
 #include "storage/logger.h"
 #include "storage/types.h"
@@ -28,6 +31,9 @@
 
 #include <boost/container/flat_map.hpp>
 #include <boost/intrusive/list_hook.hpp>
+
+#include <utility>
+
 namespace storage {
 struct entries_ordering {
     bool operator()(
@@ -48,10 +54,37 @@ struct entries_ordering {
     }
 };
 
+/// bytes held by the ephemeral logs of the shard
+static size_t& ephemeral_bytes() {
+    static thread_local size_t bytes{0};
+    return bytes;
+}
+
 struct mem_probe {
-    void add_bytes_written(size_t sz) { partition_bytes += sz; }
-    void remove_bytes_written(size_t sz) { partition_bytes -= sz; }
+    explicit mem_probe(bool ephemeral)
+      : ephemeral(ephemeral) {}
+    mem_probe(mem_probe&& o) noexcept
+      : partition_bytes(std::exchange(o.partition_bytes, 0))
+      , ephemeral(o.ephemeral) {}
+    mem_probe& operator=(mem_probe&&) = delete;
+    mem_probe(const mem_probe&) = delete;
+    mem_probe& operator=(const mem_probe&) = delete;
+    ~mem_probe() noexcept { remove_bytes_written(partition_bytes); }
+
+    void add_bytes_written(size_t sz) {
+        partition_bytes += sz;
+        if (ephemeral) {
+            ephemeral_bytes() += sz;
+        }
+    }
+    void remove_bytes_written(size_t sz) {
+        partition_bytes -= sz;
+        if (ephemeral) {
+            ephemeral_bytes() -= sz;
+        }
+    }
     size_t partition_bytes{0};
+    bool ephemeral;
 };
 
 struct mem_log_impl;
@@ -122,11 +155,14 @@ private:
 
 class mem_log_appender final : public log_appender::impl {
 public:
-    explicit mem_log_appender(
-      mem_log_impl& log, model::offset min_offset) noexcept
+    mem_log_appender(
+      mem_log_impl& log,
+      model::offset min_offset,
+      std::optional<model::term_id> term) noexcept
       : _log(log)
       , _min_offset(min_offset)
-      , _cur_offset(min_offset) {}
+      , _cur_offset(min_offset)
+      , _term(term) {}
 
     inline ss::future<ss::stop_iteration>
     operator()(model::record_batch&) final;
@@ -137,6 +173,7 @@ private:
     mem_log_impl& _log;
     model::offset _min_offset;
     model::offset _cur_offset;
+    std::optional<model::term_id> _term;
     size_t _byte_size{0};
 };
 
@@ -144,7 +181,8 @@ struct mem_log_impl final : log::impl {
     using underlying_t = std::deque<model::record_batch>;
     // forward ctor
     explicit mem_log_impl(ntp_config cfg)
-      : log::impl(std::move(cfg)) {}
+      : log::impl(std::move(cfg))
+      , _probe(config().is_ephemeral()) {}
     ~mem_log_impl() override = default;
     mem_log_impl(const mem_log_impl&) = delete;
     mem_log_impl& operator=(const mem_log_impl&) = delete;
@@ -155,6 +193,7 @@ struct mem_log_impl final : log::impl {
             _eviction_monitor->promise.set_exception(
               std::runtime_error("log closed"));
         }
+        _committed_monitor.stop();
         return ss::make_ready_future<>();
     }
     ss::future<> remove() final { return ss::make_ready_future<>(); }
@@ -247,7 +286,7 @@ struct mem_log_impl final : log::impl {
         const size_t max = max_partition_retention_size.value_or(
           std::numeric_limits<size_t>::max());
         size_t reclaimed = 0;
-        model::offset max_offset;
+        std::optional<model::offset> max_offset;
         for (const model::record_batch& b : _data) {
             if (
               b.header().max_timestamp <= eviction_time
@@ -259,25 +298,88 @@ struct mem_log_impl final : log::impl {
 
             break;
         }
+        if (max_offset) {
+            evict(*max_offset);
+        }
+        return ss::now();
+    }
+
+    /// retention bytes of the topic, or of the cluster if not set
+    std::optional<size_t> retention_bytes() const {
+        if (config().has_overrides()) {
+            const auto& v = config().get_overrides().retention_bytes;
+            if (v.is_disabled()) {
+                return std::nullopt;
+            }
+            if (v.has_value()) {
+                return v.value();
+            }
+        }
+        return config::shard_local_cfg().retention_bytes();
+    }
+
+    /**
+     * Ephemeral logs are bounded on append rather than by housekeeping: the
+     * oldest batches above the retention bytes, or above the shard memory
+     * budget, are evicted. As for the housekeeping, the eviction monitor is
+     * told first and the batches are erased once they are collectible.
+     */
+    void enforce_memory_bounds() {
+        if (!config().is_ephemeral() || _data.size() < 2) {
+            return;
+        }
+        const size_t budget
+          = config::shard_local_cfg().ephemeral_log_memory_bytes();
+        size_t excess = 0;
+        if (ephemeral_bytes() > budget) {
+            excess = std::min(
+              ephemeral_bytes() - budget, _probe.partition_bytes);
+        }
+        const auto max = retention_bytes();
+        if (max && _probe.partition_bytes > *max) {
+            excess = std::max(excess, _probe.partition_bytes - *max);
+        }
+        size_t reclaimed = 0;
+        std::optional<model::offset> max_offset;
+        // the newest batch holds the offsets of the log
+        for (auto it = _data.begin();
+             reclaimed < excess && it != std::prev(_data.end());
+             ++it) {
+            max_offset = it->last_offset();
+            reclaimed += it->size_bytes();
+        }
+        if (max_offset) {
+            evict(*max_offset);
+        }
+    }
+
+    void evict(model::offset max_offset) {
         if (_eviction_monitor) {
             _eviction_monitor->promise.set_value(max_offset);
             _eviction_monitor.reset();
         }
-        if (max_offset > _max_collectible_offset) {
-            return ss::now();
-        }
+        max_offset = std::min(max_offset, _max_collectible_offset);
 
         auto it = _data.begin();
-        while (it != _data.end() && it->last_offset() <= max_offset) {
+        while (std::next(it) != _data.end()
+               && it->last_offset() <= max_offset) {
             _probe.remove_bytes_written(it->size_bytes());
             it++;
         }
 
         if (it != _data.begin()) {
+            // erasing invalidates the iterators of the readers
+            for (auto& reader : _readers) {
+                reader.invalidate();
+            }
             _data.erase(_data.begin(), it);
             _data.shrink_to_fit();
         }
-        return ss::now();
+    }
+
+    ss::future<model::offset>
+    wait_for_committed_offset(model::offset o, ss::abort_source& as) final {
+        return _committed_monitor.wait(o, offsets().committed_offset, as);
     }
 
     ss::future<model::offset> monitor_eviction(ss::abort_source& as) final {
@@ -322,14 +424,25 @@ struct mem_log_impl final : log::impl {
           std::move(reader));
     }
 
-    log_appender make_appender(log_append_config) final {
+    ss::future<std::optional<key_lookup_result>>
+    lookup_key(key_lookup_config cfg) final {
+        // there are no indices, the log is scanned
+        auto reader = model::record_batch_reader(
+          std::make_unique<mem_iter_reader>(
+            _readers, _data.begin(), _data.end(), cfg.max_offset));
+        return internal::find_latest_record(
+          std::move(reader), std::move(cfg.key), cfg.max_offset);
+    }
+
+    log_appender make_appender(log_append_config cfg) final {
         auto o = offsets().dirty_offset;
         if (o() < 0) {
             o = model::offset(0);
         } else {
             o = o + model::offset(1);
         }
-        return log_appender(std::make_unique<mem_log_appender>(*this, o));
+        return log_appender(
+          std::make_unique<mem_log_appender>(*this, o, cfg.term));
     }
 
     std::optional<model::term_id> get_term(model::offset o) const final {
@@ -345,6 +458,22 @@ struct mem_log_impl final : log::impl {
     }
 
     size_t segment_count() const final { return 1; }
+    std::vector<segment_file> closed_segments() const final { return {}; }
+    compaction_backlog backlog() const final { return {}; }
+
+    size_t size_bytes(model::offset first, model::offset last) const final {
+        size_t ret = 0;
+        for (auto& b : _data) {
+            if (b.base_offset() <= last && b.last_offset() >= first) {
+                ret += b.size_bytes();
+            }
+        }
+        return ret;
+    }
+
+    std::optional<model::offset> tail_offset(size_t) final {
+        return std::nullopt;
+    }
 
     storage::offset_stats offsets() const final {
         // default value
@@ -372,6 +501,7 @@ struct mem_log_impl final : log::impl {
     boost::intrusive::list<mem_iter_reader> _readers;
     underlying_t _data;
     std::optional<eviction_monitor> _eviction_monitor;
+    committed_offset_monitor _committed_monitor;
     ss::rwlock _eviction_lock;
     mem_probe _probe;
     model::offset _max_collectible_offset;
@@ -379,6 +509,9 @@ struct mem_log_impl final : log::impl {
 
 ss::future<ss::stop_iteration>
 mem_log_appender::operator()(model::record_batch& batch) {
+    if (_term) {
+        batch.set_term(*_term);
+    }
     batch.header().base_offset = _cur_offset;
     _byte_size += batch.header().size_bytes;
     vlog(
@@ -402,6 +535,9 @@ ss::future<append_result> mem_log_appender::end_of_stream() {
       .last_offset = _cur_offset - model::offset(1),
       .byte_size = _byte_size,
       .last_term = _log._data.back().term()};
+    // appended batches are committed right away
+    _log._committed_monitor.notify(ret.last_offset);
+    _log.enforce_memory_bounds();
     return ss::make_ready_future<append_result>(ret);
 }
 
@@ -10,11 +10,14 @@
  */
 
 #pragma once
+#include "model/compression.h"
 #include "model/fundamental.h"
 #include "tristate.h"
 
 #include <seastar/core/sstring.hh>
 
+#include <chrono>
+#include <memory>
 #include <optional>
 
 namespace storage {
@@ -28,11 +31,27 @@ public:
         std::optional<model::compaction_strategy> compaction_strategy;
         // if not set, use the log_manager's configuration
         std::optional<size_t> segment_size;
+        // bytes of batches between index entries. if not set, use the
+        // log_manager's configuration
+        std::optional<size_t> index_interval;
 
         // partition retention settings. If tristate is disabled the feature
         // will be disabled if there is no value set the default will be used
         tristate<size_t> retention_bytes{std::nullopt};
         tristate<std::chrono::milliseconds> retention_time{std::nullopt};
+
+        // relaxed consistency writes are acknowledged before they are in
+        // the log, at most this long. if not set, writes go to the log first
+        std::optional<std::chrono::milliseconds> write_behind;
+
+        // codec of the data batches that compaction, or the recompression
+        // of closed segments, rewrites. if not set, batches keep the codec
+        // they were produced with
+        std::optional<model::compression> compression;
+
+        // the log is kept in memory and never written to local disk, see
+        // is_ephemeral()
+        bool ephemeral{false};
         friend std::ostream&
         operator<<(std::ostream&, const default_overrides&);
     };
@@ -69,6 +88,16 @@ public:
 
     bool has_overrides() const { return _overrides != nullptr; }
 
+    /// The overrides are owned, copies are explicit
+    ntp_config copy() const {
+        return ntp_config(
+          _ntp,
+          _base_dir,
+          _overrides ? std::make_unique<default_overrides>(*_overrides)
+                     : nullptr,
+          _ntp_id);
+    }
+
     bool is_compacted() const {
         if (_overrides && _overrides->cleanup_policy_bitflags) {
             return (_overrides->cleanup_policy_bitflags.value()
@@ -89,8 +118,15 @@ public:
                == model::cleanup_policy_bitflags::deletion;
     }
 
-    ss::sstring work_directory() const {
-        return fmt::format("{}/{}_{}", _base_dir, _ntp.path(), _ntp_id);
+    /// The log is held in memory only, bounded by retention bytes and the
+    /// shard memory budget. Its data is lost when every replica restarts
+    bool is_ephemeral() const { return _overrides && _overrides->ephemeral; }
+
+    ss::sstring work_directory() const { return work_directory(_base_dir); }
+
+    /// \brief the directory of the log if it was placed under `base`
+    ss::sstring work_directory(const ss::sstring& base) const {
+        return fmt::format("{}/{}_{}", base, _ntp.path(), _ntp_id);
     }
 
     std::filesystem::path topic_directory() const {
@@ -99,9 +135,8 @@ public:
 
 private:
     model::ntp _ntp;
-    /// \brief currently this is the basedir. In the future
-    /// this will be used to load balance on devices so that there is no
-    /// implicit hierarchy, simply directories with data
+    /// \brief the data directory of the disk the log is placed on, see
+    /// log_config::extra_dirs
     ss::sstring _base_dir;
 
     std::unique_ptr<default_overrides> _overrides;
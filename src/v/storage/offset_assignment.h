@@ -12,18 +12,44 @@
 #pragma once
 #include "model/record.h"
 #include "model/record_batch_reader.h"
+#include "model/timestamp.h"
+
+#include <optional>
 
 namespace storage {
+/**
+ * Assigns consecutive offsets to the batches and, for the topics with the
+ * LogAppendTime timestamp type, the append time as their max timestamp. The
+ * term of a leader append is set in the same pass, it is not covered by the
+ * crcs.
+ *
+ * Both rewrites are fused: the kafka crc is updated from the header fields
+ * that changed without reading the records and the header crc is computed
+ * once per batch, or patched for the offset when the timestamp is kept.
+ */
 template<typename Consumer>
 CONCEPT(requires model::BatchReaderConsumer<Consumer>())
 class assigning_consumer {
 public:
-    assigning_consumer(Consumer consumer, model::offset offset)
+    assigning_consumer(
+      Consumer consumer,
+      model::offset offset,
+      std::optional<model::timestamp> append_time = std::nullopt,
+      std::optional<model::term_id> term = std::nullopt)
       : _c(std::move(consumer))
-      , _offset(offset) {}
+      , _offset(offset)
+      , _append_time(append_time)
+      , _term(term) {}
 
     ss::future<ss::stop_iteration> operator()(model::record_batch&& batch) {
-        batch.header().base_offset = _offset;
+        if (_term) {
+            batch.set_term(*_term);
+        }
+        if (_append_time) {
+            batch.assign_max_timestamp(
+              model::timestamp_type::append_time, *_append_time);
+        }
+        model::assign_base_offset(batch.header(), _offset);
         _offset = batch.last_offset() + model::offset(1);
         return _c(std::move(batch));
     }
@@ -33,13 +59,18 @@ public:
 private:
     Consumer _c;
     model::offset _offset;
+    std::optional<model::timestamp> _append_time;
+    std::optional<model::term_id> _term;
 };
 
 template<typename Consumer>
 CONCEPT(requires model::BatchReaderConsumer<Consumer>())
 assigning_consumer<Consumer> wrap_with_offset_assignment(
-  Consumer&& consumer, model::offset offset) {
+  Consumer&& consumer,
+  model::offset offset,
+  std::optional<model::timestamp> append_time = std::nullopt,
+  std::optional<model::term_id> term = std::nullopt) {
     return assigning_consumer<Consumer>(
-      std::forward<Consumer>(consumer), offset);
+      std::forward<Consumer>(consumer), offset, append_time, term);
 }
 } // namespace storage
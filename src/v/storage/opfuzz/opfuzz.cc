@@ -18,11 +18,14 @@
 #include "vlog.h"
 
 #include <seastar/core/file.hh>
+#include <seastar/core/memory.hh>
 #include <seastar/core/seastar.hh>
 #include <seastar/util/backtrace.hh>
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
 namespace storage {
@@ -418,10 +421,20 @@ struct compact_op final : opfuzz::op {
 };
 
 ss::future<> opfuzz::execute() {
+    using clock_type = std::chrono::steady_clock;
     // execute commands in sequence
     return ss::do_for_each(_workload, [this](std::unique_ptr<op>& c) {
         vlog(fuzzlogger.info, "Executing: {}", c->name());
-        return c->invoke(op_context{&_term, &_log, &_as});
+        const auto start = clock_type::now();
+        return c->invoke(op_context{&_term, &_log, &_as})
+          .then([this, start, name = c->name()] {
+              const auto us = std::chrono::duration_cast<
+                std::chrono::microseconds>(clock_type::now() - start);
+              _timings.latency_us[name].push_back(us.count());
+              _timings.max_allocated_memory = std::max(
+                _timings.max_allocated_memory,
+                ss::memory::stats().allocated_memory());
+          });
     });
 }
 
@@ -20,8 +20,11 @@
 
 #include <seastar/util/log.hh>
 
+#include <absl/container/btree_map.h>
 #include <fmt/core.h>
 
+#include <vector>
+
 namespace storage {
 extern ss::logger fuzzlogger;
 
@@ -70,8 +73,17 @@ public:
     opfuzz(opfuzz&&) noexcept = default;
     opfuzz& operator=(opfuzz&&) noexcept = default;
 
+    /// what executing the workload took
+    struct timings {
+        /// microseconds each operation took, by operation name
+        absl::btree_map<ss::sstring, std::vector<uint64_t>> latency_us;
+        /// memory allocated by the shard at its highest after an operation
+        size_t max_allocated_memory{0};
+    };
+
     ss::future<> execute();
     const storage::log& log() const { return _log; }
+    const timings& execution_timings() const { return _timings; }
 
 private:
     std::unique_ptr<op> random_operation();
@@ -81,5 +93,6 @@ private:
     std::vector<std::unique_ptr<op>> _workload;
     storage::log _log;
     ss::abort_source _as;
+    timings _timings;
 };
 } // namespace storage
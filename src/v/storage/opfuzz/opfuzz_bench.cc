@@ -0,0 +1,379 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "config/configuration.h"
+#include "model/fundamental.h"
+#include "random/generators.h"
+#include "storage/kvstore.h"
+#include "storage/log_manager.h"
+#include "storage/opfuzz/opfuzz.h"
+#include "storage/types.h"
+#include "syschecks/syschecks.h"
+#include "units.h"
+#include "vlog.h"
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/memory.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/util/defer.hh>
+
+#include <absl/container/btree_map.h>
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/// Runs the randomized workloads of opfuzz under timing. Every repetition
+/// replays the same workloads, generated from --seed, on fresh logs and
+/// records the latency of each operation type and the memory high-water
+/// mark. The spread across repetitions makes a regression over a stored
+/// baseline significant or noise.
+
+namespace po = boost::program_options; // NOLINT
+
+static ss::logger benchlog{"opfuzz_bench"};
+
+void cli_opts(po::options_description_easy_init o) {
+    o("directory",
+      po::value<std::string>()->default_value("opfuzz_bench.data"),
+      "directory of the logs and the kvstore, the logs are removed after "
+      "every repetition");
+    o("ntps", po::value<size_t>()->default_value(4), "logs fuzzed per run");
+    o("ops", po::value<size_t>()->default_value(500), "operations per log");
+    o("repetitions",
+      po::value<size_t>()->default_value(5),
+      "times the same workloads are executed");
+    o("seed",
+      po::value<uint32_t>()->default_value(1),
+      "seed the workloads are generated from, keep it when comparing with a "
+      "baseline");
+    o("output",
+      po::value<std::string>()->default_value(""),
+      "file the results are written to, one json object per operation type");
+    o("baseline",
+      po::value<std::string>()->default_value(""),
+      "results of an earlier execution, the benchmark fails when an "
+      "operation type regresses");
+    o("max-regression-pct",
+      po::value<double>()->default_value(10),
+      "percent the p99 latency or the memory high-water mark may regress "
+      "over the baseline");
+    o("min-t",
+      po::value<double>()->default_value(3),
+      "welch t statistic over the repetitions above which a regression is "
+      "significant rather than noise");
+}
+
+/// a value measured once per repetition
+struct sampled {
+    double mean{0};
+    double stddev{0};
+    size_t samples{0};
+
+    static sampled of(const std::vector<double>& v) {
+        sampled s;
+        s.samples = v.size();
+        if (v.empty()) {
+            return s;
+        }
+        s.mean = std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+        if (v.size() > 1) {
+            double sq = 0;
+            for (auto x : v) {
+                sq += (x - s.mean) * (x - s.mean);
+            }
+            s.stddev = std::sqrt(sq / (v.size() - 1));
+        }
+        return s;
+    }
+
+    /// welch's t statistic of this being above the baseline
+    double t_over(const sampled& base) const {
+        const double var = (stddev * stddev) / std::max<size_t>(samples, 1)
+                           + (base.stddev * base.stddev)
+                               / std::max<size_t>(base.samples, 1);
+        if (var == 0) {
+            return mean > base.mean ? std::numeric_limits<double>::max() : 0;
+        }
+        return (mean - base.mean) / std::sqrt(var);
+    }
+};
+
+struct op_result {
+    ss::sstring op;
+    size_t count{0};
+    sampled p50_us;
+    sampled p99_us;
+};
+
+struct bench_result {
+    std::vector<op_result> ops;
+    sampled max_allocated_memory;
+};
+
+static double percentile(std::vector<uint64_t> v, double p) {
+    std::sort(v.begin(), v.end());
+    const auto rank = static_cast<size_t>(std::ceil(p / 100 * v.size()));
+    return v[std::max<size_t>(rank, 1) - 1];
+}
+
+struct repetition {
+    absl::btree_map<ss::sstring, std::vector<uint64_t>> latency_us;
+    size_t max_allocated_memory{0};
+};
+
+static repetition
+run_repetition_in_thread(storage::kvstore& kvs, const po::variables_map& cfg) {
+    const auto dir = cfg["directory"].as<std::string>();
+    // the same workloads every repetition, the logs are fuzzed one after the
+    // other so the random values are drawn in the same order too
+    random_generators::seed(cfg["seed"].as<uint32_t>());
+    storage::log_manager mngr(
+      storage::log_config(
+        storage::log_config::storage_type::disk,
+        dir,
+        200_MiB,
+        storage::debug_sanitize_files::no,
+        storage::log_config::with_cache::yes),
+      kvs);
+    auto deferred = ss::defer([&mngr] { mngr.stop().get(); });
+
+    std::vector<model::ntp> ntps;
+    std::vector<std::unique_ptr<storage::opfuzz>> logs;
+    for (size_t i = 0; i < cfg["ntps"].as<size_t>(); ++i) {
+        ntps.emplace_back("test.default", fmt::format("topic.{}", i), i);
+        auto ntp_cfg = storage::ntp_config(ntps.back(), mngr.config().base_dir);
+        if (i % 2 == 1) {
+            auto c = model::cleanup_policy_bitflags::compaction;
+            ntp_cfg = storage::ntp_config(
+              ntps.back(),
+              mngr.config().base_dir,
+              std::make_unique<storage::ntp_config::default_overrides>(
+                storage::ntp_config::default_overrides{
+                  .cleanup_policy_bitflags = c,
+                  .compaction_strategy = model::compaction_strategy::offset,
+                }));
+        }
+        auto log = mngr.manage(std::move(ntp_cfg)).get0();
+        logs.push_back(std::make_unique<storage::opfuzz>(
+          std::move(log), cfg["ops"].as<size_t>()));
+    }
+
+    const auto allocated_before = ss::memory::stats().allocated_memory();
+    repetition r;
+    for (auto& l : logs) {
+        l->execute().get();
+        const auto& t = l->execution_timings();
+        for (const auto& [op, us] : t.latency_us) {
+            auto& all = r.latency_us[op];
+            all.insert(all.end(), us.begin(), us.end());
+        }
+        const auto peak = std::max(t.max_allocated_memory, allocated_before);
+        r.max_allocated_memory = std::max(
+          r.max_allocated_memory, peak - allocated_before);
+    }
+    logs.clear();
+    for (auto& ntp : ntps) {
+        mngr.remove(ntp).get();
+    }
+    return r;
+}
+
+static bench_result aggregate(const std::vector<repetition>& reps) {
+    absl::btree_map<ss::sstring, std::vector<double>> p50;
+    absl::btree_map<ss::sstring, std::vector<double>> p99;
+    absl::btree_map<ss::sstring, size_t> count;
+    std::vector<double> memory;
+    for (const auto& r : reps) {
+        for (const auto& [op, us] : r.latency_us) {
+            p50[op].push_back(percentile(us, 50));
+            p99[op].push_back(percentile(us, 99));
+            count[op] += us.size();
+        }
+        memory.push_back(r.max_allocated_memory);
+    }
+    bench_result ret;
+    for (const auto& [op, v] : p99) {
+        ret.ops.push_back(op_result{
+          .op = op,
+          .count = count[op],
+          .p50_us = sampled::of(p50[op]),
+          .p99_us = sampled::of(v),
+        });
+    }
+    ret.max_allocated_memory = sampled::of(memory);
+    return ret;
+}
+
+static std::string to_json(const op_result& r) {
+    return fmt::format(
+      R"({{"op":"{}","count":{},"repetitions":{},"p50_us":{:.0f},)"
+      R"("p50_us_stddev":{:.0f},"p99_us":{:.0f},"p99_us_stddev":{:.0f}}})",
+      r.op,
+      r.count,
+      r.p99_us.samples,
+      r.p50_us.mean,
+      r.p50_us.stddev,
+      r.p99_us.mean,
+      r.p99_us.stddev);
+}
+
+static std::string memory_to_json(const sampled& m) {
+    return fmt::format(
+      R"({{"max_allocated_memory":{:.0f},"max_allocated_memory_stddev":{:.0f},)"
+      R"("repetitions":{}}})",
+      m.mean,
+      m.stddev,
+      m.samples);
+}
+
+static bench_result read_baseline(const std::string& path) {
+    bench_result ret;
+    if (path.empty()) {
+        return ret;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(fmt::format("Cannot read baseline:{}", path));
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        rapidjson::Document doc;
+        doc.Parse(line.c_str());
+        if (doc.HasParseError() || !doc.IsObject()) {
+            throw std::runtime_error(fmt::format("Invalid result:{}", line));
+        }
+        const size_t samples = doc["repetitions"].GetUint64();
+        if (doc.HasMember("op")) {
+            ret.ops.push_back(op_result{
+              .op = doc["op"].GetString(),
+              .count = doc["count"].GetUint64(),
+              .p99_us = sampled{
+                .mean = doc["p99_us"].GetDouble(),
+                .stddev = doc["p99_us_stddev"].GetDouble(),
+                .samples = samples}});
+        } else {
+            ret.max_allocated_memory = sampled{
+              .mean = doc["max_allocated_memory"].GetDouble(),
+              .stddev = doc["max_allocated_memory_stddev"].GetDouble(),
+              .samples = samples};
+        }
+    }
+    return ret;
+}
+
+/// worse than the baseline by more than max_pct, and by more than the spread
+/// of the repetitions explains
+static bool
+regressed(const sampled& s, const sampled& base, double max_pct, double min_t) {
+    return base.samples > 0 && s.mean > base.mean * (1 + max_pct / 100)
+           && s.t_over(base) > min_t;
+}
+
+static size_t count_regressions(
+  const bench_result& results,
+  const bench_result& baseline,
+  double max_pct,
+  double min_t) {
+    size_t regressions = 0;
+    for (const auto& r : results.ops) {
+        auto it = std::find_if(
+          baseline.ops.begin(),
+          baseline.ops.end(),
+          [&r](const op_result& b) { return b.op == r.op; });
+        if (it == baseline.ops.end()) {
+            continue;
+        }
+        if (regressed(r.p99_us, it->p99_us, max_pct, min_t)) {
+            ++regressions;
+            vlog(
+              benchlog.error,
+              "Regression of {}. p99_us:{:.0f} (baseline {:.0f}), t:{:.1f}",
+              r.op,
+              r.p99_us.mean,
+              it->p99_us.mean,
+              r.p99_us.t_over(it->p99_us));
+        }
+    }
+    const auto& m = results.max_allocated_memory;
+    const auto& base = baseline.max_allocated_memory;
+    if (regressed(m, base, max_pct, min_t)) {
+        ++regressions;
+        vlog(
+          benchlog.error,
+          "Regression of the memory high-water mark: {:.0f} (baseline {:.0f}), "
+          "t:{:.1f}",
+          m.mean,
+          base.mean,
+          m.t_over(base));
+    }
+    return regressions;
+}
+
+int main(int args, char** argv, char** env) {
+    syschecks::initialize_intrinsics();
+    std::setvbuf(stdout, nullptr, _IOLBF, 1024);
+    ss::app_template app;
+    cli_opts(app.add_options());
+    return app.run(args, argv, [&] {
+        return ss::async([&] {
+            auto& cfg = app.configuration();
+            const auto baseline = read_baseline(
+              cfg["baseline"].as<std::string>());
+            config::shard_local_cfg().get("disable_metrics").set_value(true);
+            const auto dir = cfg["directory"].as<std::string>();
+            storage::kvstore kvs(storage::kvstore_config(
+              1_MiB,
+              std::chrono::milliseconds(10),
+              dir,
+              storage::debug_sanitize_files::no));
+            kvs.start().get();
+            auto kd = ss::defer([&kvs] { kvs.stop().get(); });
+
+            std::vector<repetition> reps;
+            for (size_t i = 0; i < cfg["repetitions"].as<size_t>(); ++i) {
+                vlog(benchlog.info, "repetition {}", i);
+                reps.push_back(run_repetition_in_thread(kvs, cfg));
+            }
+            const auto results = aggregate(reps);
+
+            std::ofstream out;
+            const auto output = cfg["output"].as<std::string>();
+            if (!output.empty()) {
+                out.open(output);
+            }
+            auto print = [&out](const std::string& line) {
+                std::cout << line << std::endl;
+                if (out.is_open()) {
+                    out << line << std::endl;
+                }
+            };
+            for (const auto& r : results.ops) {
+                print(to_json(r));
+            }
+            print(memory_to_json(results.max_allocated_memory));
+
+            const auto regressions = count_regressions(
+              results,
+              baseline,
+              cfg["max-regression-pct"].as<double>(),
+              cfg["min-t"].as<double>());
+            return regressions > 0 ? 1 : 0;
+        });
+    });
+}
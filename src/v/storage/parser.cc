@@ -10,16 +10,16 @@
 #include "storage/parser.h"
 
 #include "bytes/iobuf.h"
-#include "bytes/iobuf_parser.h"
+#include "hashing/crc32c.h"
 #include "likely.h"
 #include "model/record.h"
-#include "model/record_utils.h"
-#include "reflection/adl.h"
 #include "storage/logger.h"
 #include "storage/parser.h"
 #include "storage/parser_utils.h"
 #include "vlog.h"
 
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/loop.hh>
 #include <seastar/core/smp.hh>
 #include <seastar/util/variant_utils.hh>
 
@@ -32,48 +32,58 @@ namespace storage {
 using stop_parser = batch_consumer::stop_parser;
 using skip_batch = batch_consumer::skip_batch;
 
-model::record_batch_header header_from_iobuf(iobuf b) {
-    iobuf_parser parser(std::move(b));
-    auto header_crc = reflection::adl<uint32_t>{}.from(parser);
-    auto sz = reflection::adl<int32_t>{}.from(parser);
-    using offset_t = model::offset::type;
-    auto off = model::offset(reflection::adl<offset_t>{}.from(parser));
-    auto type = reflection::adl<model::record_batch_type>{}.from(parser);
-    auto crc = reflection::adl<int32_t>{}.from(parser);
-    using attr_t = model::record_batch_attributes::type;
-    auto attrs = model::record_batch_attributes(
-      reflection::adl<attr_t>{}.from(parser));
-    auto delta = reflection::adl<int32_t>{}.from(parser);
-    using tmstmp_t = model::timestamp::type;
-    auto first = model::timestamp(reflection::adl<tmstmp_t>{}.from(parser));
-    auto max = model::timestamp(reflection::adl<tmstmp_t>{}.from(parser));
-    auto producer_id = reflection::adl<int64_t>{}.from(parser);
-    auto producer_epoch = reflection::adl<int16_t>{}.from(parser);
-    auto base_sequence = reflection::adl<int32_t>{}.from(parser);
-    auto record_count = reflection::adl<int32_t>{}.from(parser);
+template<typename T>
+static T consume_le(const char*& p) {
+    auto v = ss::read_le<T>(p);
+    p += sizeof(T);
+    return v;
+}
+
+/**
+ * Headers have a fixed little endian layout on disk, they are decoded
+ * straight from the contiguous buffer read from the input stream instead of
+ * going through an iobuf_parser field by field.
+ */
+static model::record_batch_header header_from_bytes(const char* begin) {
+    const char* p = begin;
+    model::record_batch_header hdr;
+    hdr.header_crc = consume_le<uint32_t>(p);
+    hdr.size_bytes = consume_le<int32_t>(p);
+    hdr.base_offset = model::offset(consume_le<model::offset::type>(p));
+    hdr.type = model::record_batch_type(
+      consume_le<model::record_batch_type::type>(p));
+    hdr.crc = consume_le<int32_t>(p);
+    hdr.attrs = model::record_batch_attributes(
+      consume_le<model::record_batch_attributes::type>(p));
+    hdr.last_offset_delta = consume_le<int32_t>(p);
+    hdr.first_timestamp = model::timestamp(
+      consume_le<model::timestamp::type>(p));
+    hdr.max_timestamp = model::timestamp(
+      consume_le<model::timestamp::type>(p));
+    hdr.producer_id = consume_le<int64_t>(p);
+    hdr.producer_epoch = consume_le<int16_t>(p);
+    hdr.base_sequence = consume_le<int32_t>(p);
+    hdr.record_count = consume_le<int32_t>(p);
     vassert(
-      parser.bytes_consumed() == model::packed_record_batch_header_size,
+      size_t(p - begin) == model::packed_record_batch_header_size,
       "Error in header parsing. Must consume:{} bytes, but consumed:{}",
       model::packed_record_batch_header_size,
-      parser.bytes_consumed());
-    auto hdr = model::record_batch_header{
-      .header_crc = header_crc,
-      .size_bytes = sz,
-      .base_offset = off,
-      .type = type,
-      .crc = crc,
-      .attrs = attrs,
-      .last_offset_delta = delta,
-      .first_timestamp = first,
-      .max_timestamp = max,
-      .producer_id = producer_id,
-      .producer_epoch = producer_epoch,
-      .base_sequence = base_sequence,
-      .record_count = record_count};
+      p - begin);
     hdr.ctx.owner_shard = ss::this_shard_id();
     return hdr;
 }
 
+/// model::internal_header_only_crc() hashes the fields after the header crc
+/// as little endian in their on disk order, i.e. the raw bytes following it.
+/// one crc32c pass over them is much cheaper than extending field by field
+static uint32_t header_crc_from_bytes(const char* begin) {
+    crc32 c;
+    c.extend(
+      begin + sizeof(uint32_t),
+      model::packed_record_batch_header_size - sizeof(uint32_t));
+    return c.value();
+}
+
 static ss::future<result<iobuf>> verify_read_iobuf(
   ss::input_stream<char>& in, size_t expected, ss::sstring msg) {
     return read_iobuf_exactly(in, expected)
@@ -92,89 +102,101 @@ static ss::future<result<iobuf>> verify_read_iobuf(
       });
 }
 
+/**
+ * Skipped batches are only checked through their header, the payload is
+ * discarded straight out of the input stream buffers. This keeps seeking to
+ * the requested offset from the nearest index entry free of allocations.
+ */
+ss::future<result<stop_parser>>
+continuous_batch_parser::verify_skip(size_t expected, const char* ctx) {
+    return _input.skip(expected).then([this, expected, ctx] {
+        if (unlikely(_input.eof())) {
+            vlog(
+              stlog.error,
+              "Cannot continue parsing. reached end of stream skipping {} "
+              "bytes. context:{}",
+              expected,
+              ctx);
+            return result<stop_parser>(
+              parser_errc::input_stream_not_enough_bytes);
+        }
+        return result<stop_parser>(stop_parser::no);
+    });
+}
+
+result<model::record_batch_header>
+continuous_batch_parser::decode_header(const ss::temporary_buffer<char>& b) {
+    if (b.empty()) {
+        // benign outcome. happens at end of file
+        return parser_errc::end_of_stream;
+    }
+    if (b.size() != model::packed_record_batch_header_size) {
+        stlog.error(
+          "Could not parse header. Expected:{}, but Got:{}. consumer:{}",
+          model::packed_record_batch_header_size,
+          b.size(),
+          *_consumer);
+        return parser_errc::input_stream_not_enough_bytes;
+    }
+    auto hdr = header_from_bytes(b.get());
+    if (hdr.header_crc == 0) {
+        // happens when we fallocate the file
+        return parser_errc::end_of_stream;
+    }
+    if (auto computed_crc = header_crc_from_bytes(b.get());
+        unlikely(hdr.header_crc != computed_crc)) {
+        vlog(
+          stlog.error,
+          "detected header corruption. stopping parser. Expected CRC of "
+          "{}, but got header CRC: {} - {}. consumer:{}",
+          computed_crc,
+          hdr.header_crc,
+          hdr,
+          *_consumer);
+        return parser_errc::header_only_crc_missmatch;
+    }
+    return hdr;
+}
+
+/**
+ * Skipped batches do not return to the caller, headers are decoded and
+ * validated in a loop until a batch is consumed. Headers and skipped payloads
+ * within the input stream buffer are handled without suspending.
+ */
 ss::future<result<stop_parser>> continuous_batch_parser::consume_header() {
-    return read_iobuf_exactly(_input, model::packed_record_batch_header_size)
-      .then([this](iobuf b) -> result<iobuf> {
-          if (b.empty()) {
-              // benign outcome. happens at end of file
-              return parser_errc::end_of_stream;
-          }
-          if (b.size_bytes() != model::packed_record_batch_header_size) {
-              stlog.error(
-                "Could not parse header. Expected:{}, but Got:{}. consumer:{}",
-                model::packed_record_batch_header_size,
-                b.size_bytes(),
-                *_consumer);
-              return parser_errc::input_stream_not_enough_bytes;
-          }
-          return b;
-      })
-      .then([](result<iobuf> b) {
-          if (!b) {
-              return ss::make_ready_future<result<model::record_batch_header>>(
-                b.error());
-          }
-          return ss::make_ready_future<result<model::record_batch_header>>(
-            header_from_iobuf(std::move(b.value())));
-      })
-      .then([this](result<model::record_batch_header> o) {
-          if (!o) {
-              return ss::make_ready_future<result<stop_parser>>(o.error());
-          }
-          if (o.value().header_crc == 0) {
-              // happens when we fallocate the file
-              return ss::make_ready_future<result<stop_parser>>(
-                parser_errc::end_of_stream);
-          }
-          if (auto computed_crc = model::internal_header_only_crc(o.value());
-              unlikely(o.value().header_crc != computed_crc)) {
-              vlog(
-                stlog.error,
-                "detected header corruption. stopping parser. Expected CRC of "
-                "{}, but got header CRC: {} - {}. consumer:{}",
-                computed_crc,
-                o.value().header_crc,
-                o.value(),
-                *_consumer);
-              return ss::make_ready_future<result<stop_parser>>(
-                parser_errc::header_only_crc_missmatch);
-          }
-          if (unlikely(o.value().header_crc == 0)) {
-              return ss::make_ready_future<result<stop_parser>>(
-                parser_errc::fallocated_file_read_zero_bytes_for_header);
-          }
-          _header = o.value();
-          const auto size_on_disk = _header.size_bytes;
-          auto ret = _consumer->consume_batch_start(
-            _header, _physical_base_offset, size_on_disk);
-          _physical_base_offset += size_on_disk;
-          if (std::holds_alternative<skip_batch>(ret)) {
-              auto s = std::get<skip_batch>(ret);
-              if (unlikely(bool(s))) {
-                  auto remaining = _header.size_bytes
-                                   - model::packed_record_batch_header_size;
-                  return verify_read_iobuf(
-                           _input, remaining, "parser::skip_batch")
-                    .then([this](result<iobuf> b) {
-                        if (!b) {
-                            return ss::make_ready_future<result<stop_parser>>(
-                              b.error());
-                        }
-                        // start again
-                        add_bytes_and_reset();
-                        return consume_header();
-                    });
+    using ret_t = std::optional<result<stop_parser>>;
+    return ss::repeat_until_value([this] {
+        return _input.read_exactly(model::packed_record_batch_header_size)
+          .then([this](ss::temporary_buffer<char> b) {
+              auto o = decode_header(b);
+              if (!o) {
+                  return ss::make_ready_future<ret_t>(o.error());
               }
-              return ss::make_ready_future<result<stop_parser>>(
-                stop_parser::no);
-          }
-          auto s = std::get<stop_parser>(ret);
-          if (unlikely(bool(s))) {
-              return ss::make_ready_future<result<stop_parser>>(
-                stop_parser::yes);
-          }
-          return ss::make_ready_future<result<stop_parser>>(stop_parser::no);
-      });
+              _header = o.value();
+              const auto size_on_disk = _header.size_bytes;
+              auto ret = _consumer->consume_batch_start(
+                _header, _physical_base_offset, size_on_disk);
+              _physical_base_offset += size_on_disk;
+              if (std::holds_alternative<skip_batch>(ret)) {
+                  auto s = std::get<skip_batch>(ret);
+                  if (unlikely(bool(s))) {
+                      auto remaining = _header.size_bytes
+                                       - model::packed_record_batch_header_size;
+                      return verify_skip(remaining, "parser::skip_batch")
+                        .then([this](result<stop_parser> r) -> ret_t {
+                            if (!r) {
+                                return r;
+                            }
+                            // start again
+                            add_bytes_and_reset();
+                            return std::nullopt;
+                        });
+                  }
+                  return ss::make_ready_future<ret_t>(stop_parser::no);
+              }
+              return ss::make_ready_future<ret_t>(std::get<stop_parser>(ret));
+          });
+    });
 }
 
 ss::future<result<stop_parser>> continuous_batch_parser::consume_one() {
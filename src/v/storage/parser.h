@@ -92,12 +92,21 @@ private:
     /// \brief consumes _one_ full batch.
     ss::future<result<batch_consumer::stop_parser>> consume_one();
 
-    /// \brief parses and _stores_ the header into _header variable
+    /// \brief parses and _stores_ the header into _header variable, batches
+    /// skipped by the consumer are passed over until one is consumed
     ss::future<result<batch_consumer::stop_parser>> consume_header();
 
+    /// \brief decodes and validates a header read from the input stream
+    result<model::record_batch_header>
+    decode_header(const ss::temporary_buffer<char>&);
+
     /// consume the [un]compressed records
     ss::future<result<batch_consumer::stop_parser>> consume_records();
 
+    /// discard the payload of a skipped batch without materializing it
+    ss::future<result<batch_consumer::stop_parser>>
+    verify_skip(size_t, const char*);
+
     size_t consumed_batch_bytes() const;
     void add_bytes_and_reset();
 
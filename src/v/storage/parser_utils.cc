@@ -14,6 +14,7 @@
 #include "model/record.h"
 #include "model/record_utils.h"
 #include "reflection/adl.h"
+#include "storage/batch_cache.h"
 #include "storage/logger.h"
 #include "vlog.h"
 
@@ -28,6 +29,17 @@ ss::future<model::record_batch> decompress_batch(model::record_batch&& b) {
     return decompress_batch(b);
 }
 
+static model::record_batch do_decompress_batch(const model::record_batch& b) {
+    iobuf body_buf = compression::compressor::uncompress(
+      b.data(), b.header().attrs.compression());
+    // must remove compression first!
+    auto h = b.header();
+    h.attrs.remove_compression();
+    reset_size_checksum_metadata(h, body_buf);
+    return model::record_batch(
+      h, std::move(body_buf), model::record_batch::tag_ctor_ng{});
+}
+
 ss::future<model::record_batch> decompress_batch(const model::record_batch& b) {
     if (unlikely(!b.compressed())) {
         return ss::make_exception_future<model::record_batch>(
@@ -36,15 +48,21 @@ ss::future<model::record_batch> decompress_batch(const model::record_batch& b) {
             "Asked to decompressed a non-compressed batch:{}",
             b.header())));
     }
-    iobuf body_buf = compression::compressor::uncompress(
-      b.data(), b.header().attrs.compression());
-    // must remove compression first!
-    auto h = b.header();
-    h.attrs.remove_compression();
-    reset_size_checksum_metadata(h, body_buf);
-    auto batch = model::record_batch(
-      h, std::move(body_buf), model::record_batch::tag_ctor_ng{});
-    return ss::make_ready_future<model::record_batch>(std::move(batch));
+    return ss::make_ready_future<model::record_batch>(do_decompress_batch(b));
+}
+
+ss::future<model::record_batch>
+decompress_batch(const model::record_batch& b, batch_cache_index* cache) {
+    if (!b.compressed() || !cache) {
+        return decompress_batch(b);
+    }
+    // synchronous so that the cache need only outlive the call
+    if (auto d = cache->get_decompressed(b); d) {
+        return ss::make_ready_future<model::record_batch>(std::move(*d));
+    }
+    auto d = do_decompress_batch(b);
+    cache->put_decompressed(b, d);
+    return ss::make_ready_future<model::record_batch>(std::move(d));
 }
 
 ss::future<model::record_batch>
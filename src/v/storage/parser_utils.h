@@ -14,12 +14,21 @@
 #include "bytes/iobuf_parser.h"
 #include "model/record.h"
 
+namespace storage {
+class batch_cache_index;
+} // namespace storage
+
 namespace storage::internal {
 
 /// \brief batch decompression
 ss::future<model::record_batch> decompress_batch(model::record_batch&&);
 /// \brief batch decompression
 ss::future<model::record_batch> decompress_batch(const model::record_batch&);
+/// \brief batch decompression through the decompressed form cached with the
+/// batch, if any. a cached batch is decompressed at most once. `cache` may be
+/// null
+ss::future<model::record_batch>
+decompress_batch(const model::record_batch&, batch_cache_index* cache);
 
 /// \brief batch compression
 ss::future<model::record_batch>
@@ -11,11 +11,22 @@
 
 #include "config/configuration.h"
 #include "prometheus/prometheus_sanitize.h"
+#include "storage/segment_set.h"
 
 #include <seastar/core/metrics.hh>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace storage {
-void probe::setup_metrics(const model::ntp& ntp) {
+probe::~probe() noexcept {
+    if (_topic_hook.is_linked()) {
+        _topic->remove(*this);
+    }
+}
+
+void probe::setup_metrics(const model::ntp& ntp, const segment_set& segs) {
     if (config::shard_local_cfg().disable_metrics()) {
         return;
     }
@@ -63,6 +74,32 @@ void probe::setup_metrics(const model::ntp& ntp) {
           [this] { return _cached_batches_read; },
           sm::description("Total number of cached batches read"),
           labels),
+        sm::make_derive(
+          "batch_cache_hits",
+          [this] { return _batch_cache_hits; },
+          sm::description("Number of reads served from the batch cache"),
+          labels),
+        sm::make_derive(
+          "batch_cache_misses",
+          [this] { return _batch_cache_misses; },
+          sm::description("Number of reads that missed the batch cache"),
+          labels),
+        sm::make_derive(
+          "batch_cache_admits",
+          [this] { return _batch_cache_admits; },
+          sm::description("Number of batches read from disk and admitted "
+                          "into the batch cache"),
+          labels),
+        sm::make_derive(
+          "readers_cache_hits",
+          [this] { return _readers_cache_hits; },
+          sm::description("Number of reads resumed from a parked reader"),
+          labels),
+        sm::make_derive(
+          "readers_cache_misses",
+          [this] { return _readers_cache_misses; },
+          sm::description("Number of reads which found no parked reader"),
+          labels),
         sm::make_derive(
           "log_segments_created",
           [this] { return _log_segments_created; },
@@ -89,6 +126,65 @@ void probe::setup_metrics(const model::ntp& ntp) {
           [this] { return _segment_compacted; },
           sm::description("Number of compacted segments"),
           labels),
+        sm::make_derive(
+          "index_seeks",
+          [this] { return _index_seeks; },
+          sm::description("Number of disk reads positioned through the "
+                          "segment indices"),
+          labels),
+        sm::make_total_bytes(
+          "index_seek_bytes",
+          [this] { return _index_seek_bytes; },
+          sm::description("Bytes read past between the index entries and the "
+                          "offsets the disk reads start from"),
+          labels),
+        sm::make_derive(
+          "lock_waits",
+          [this] { return _lock_waits; },
+          sm::description("Number of reads which waited for segment locks"),
+          labels),
+        sm::make_derive(
+          "lock_wait_us",
+          [this] { return _lock_wait_us; },
+          sm::description("Microseconds reads waited for segment locks"),
+          labels),
+        sm::make_derive(
+          "segment_rolls",
+          [this] { return _segment_rolls; },
+          sm::description("Number of rolls to a new segment"),
+          labels),
+        sm::make_derive(
+          "prepared_segment_rolls",
+          [this] { return _prepared_segment_rolls; },
+          sm::description("Number of rolls to a segment prepared ahead"),
+          labels),
+        sm::make_derive(
+          "segment_roll_us",
+          [this] { return _segment_roll_us; },
+          sm::description("Microseconds appends waited for segment rolls"),
+          labels),
+        sm::make_gauge(
+          "compaction_dirty_bytes",
+          [this] { return _backlog.dirty_bytes; },
+          sm::description("Bytes of closed segments still to compact"),
+          labels),
+        sm::make_gauge(
+          "compaction_reclaimable_bytes",
+          [this] { return _backlog.reclaimable_bytes; },
+          sm::description("Estimate of the bytes compacting the dirty "
+                          "segments would free"),
+          labels),
+        sm::make_gauge(
+          "index_memory_bytes",
+          [&segs] {
+              size_t bytes = 0;
+              for (const auto& s : segs) {
+                  bytes += s->index().memory_usage();
+              }
+              return bytes;
+          },
+          sm::description("Memory used by the entries of the segment indices"),
+          labels),
         sm::make_gauge(
           "partition_size",
           [this] { return _partition_bytes; },
@@ -97,6 +193,154 @@ void probe::setup_metrics(const model::ntp& ntp) {
       });
 }
 
+topic_probe::topic_probe(const model::topic_namespace& tp_ns) {
+    setup_metrics(tp_ns);
+}
+
+void topic_probe::add(probe& p) {
+    p._topic = this;
+    _logs.push_back(p);
+}
+
+void topic_probe::remove(probe& p) {
+    _removed.bytes_written += p._bytes_written;
+    _removed.bytes_read += p._bytes_read;
+    _removed.batches_written += p._batches_written;
+    _removed.batches_read += p._batches_read;
+    p._topic_hook.unlink();
+    p._topic = nullptr;
+}
+
+topic_probe::totals topic_probe::sum() const {
+    auto t = _removed;
+    for (const auto& p : _logs) {
+        t.bytes_written += p._bytes_written;
+        t.bytes_read += p._bytes_read;
+        t.batches_written += p._batches_written;
+        t.batches_read += p._batches_read;
+    }
+    return t;
+}
+
+uint64_t topic_probe::partition_bytes() const {
+    uint64_t bytes = 0;
+    for (const auto& p : _logs) {
+        bytes += p._partition_bytes;
+    }
+    return bytes;
+}
+
+void topic_probe::setup_metrics(const model::topic_namespace& tp_ns) {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    auto ns_label = sm::label("namespace");
+    auto topic_label = sm::label("topic");
+    const std::vector<sm::label_instance> labels = {
+      ns_label(tp_ns.ns()),
+      topic_label(tp_ns.tp()),
+    };
+
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:topic"),
+      {
+        sm::make_total_bytes(
+          "written_bytes",
+          [this] { return sum().bytes_written; },
+          sm::description("Total number of bytes written to the topic"),
+          labels),
+        sm::make_derive(
+          "batches_written",
+          [this] { return sum().batches_written; },
+          sm::description("Total number of batches written to the topic"),
+          labels),
+        sm::make_total_bytes(
+          "read_bytes",
+          [this] { return sum().bytes_read; },
+          sm::description("Total number of bytes read from the topic"),
+          labels),
+        sm::make_derive(
+          "batches_read",
+          [this] { return sum().batches_read; },
+          sm::description("Total number of batches read from the topic"),
+          labels),
+        sm::make_gauge(
+          "partition_size",
+          [this] { return partition_bytes(); },
+          sm::description("Current size of the partitions in bytes"),
+          labels),
+        sm::make_gauge(
+          "partitions",
+          [this] { return _logs.size(); },
+          sm::description("Number of partitions of the topic on the shard"),
+          labels),
+      });
+}
+
+log_probes::log_probes(config cfg)
+  : _cfg(cfg) {
+    if (_cfg.aggregate && _cfg.rank_interval.count() > 0) {
+        _rank_timer.set_callback([this] { rank(); });
+        _rank_timer.arm_periodic(_cfg.rank_interval);
+    }
+}
+
+void log_probes::add(
+  probe& p, const model::ntp& ntp, const segment_set& segs) {
+    if (!_cfg.aggregate) {
+        p.setup_metrics(ntp, segs);
+        return;
+    }
+    p._ntp = &ntp;
+    p._segs = &segs;
+    auto it = _topics.find(model::topic_namespace_view(ntp));
+    if (it == _topics.end()) {
+        auto tp_ns = model::topic_namespace(ntp.ns, ntp.tp.topic);
+        it = _topics.try_emplace(tp_ns, tp_ns).first;
+    }
+    it->second.add(p);
+}
+
+void log_probes::rank() {
+    std::vector<std::pair<uint64_t, probe*>> busy;
+    for (auto it = _topics.begin(); it != _topics.end();) {
+        if (it->second._logs.empty()) {
+            _topics.erase(it++);
+            continue;
+        }
+        for (auto& p : it->second._logs) {
+            const auto bytes = p._bytes_written + p._bytes_read;
+            const auto delta = bytes - std::exchange(p._ranked_bytes, bytes);
+            if (delta > 0) {
+                busy.emplace_back(delta, &p);
+            } else if (p._detailed) {
+                p._detailed = false;
+                p.clear_metrics();
+            }
+        }
+        ++it;
+    }
+    const auto n = std::min(_cfg.detail_limit, busy.size());
+    std::nth_element(
+      busy.begin(),
+      busy.begin() + n,
+      busy.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; i < busy.size(); ++i) {
+        auto& p = *busy[i].second;
+        if (i < n && !p._detailed) {
+            p._detailed = true;
+            p.setup_metrics(*p._ntp, *p._segs);
+        } else if (i >= n && p._detailed) {
+            p._detailed = false;
+            p.clear_metrics();
+        }
+    }
+    _detailed = n;
+}
+
 void probe::add_initial_segment(const segment& s) {
     _partition_bytes += s.reader().file_size();
 }
@@ -11,17 +11,36 @@
 
 #pragma once
 #include "model/fundamental.h"
+#include "model/metadata.h"
 #include "storage/logger.h"
 #include "storage/segment.h"
+#include "storage/types.h"
+#include "utils/intrusive_list_helpers.h"
 
+#include <seastar/core/lowres_clock.hh>
 #include <seastar/core/metrics_registration.hh>
 #include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
 
+#include <absl/container/node_hash_map.h>
+
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 
 namespace storage {
+class segment_set;
+class topic_probe;
+
 class probe {
 public:
+    probe() = default;
+    probe(const probe&) = delete;
+    probe& operator=(const probe&) = delete;
+    probe(probe&&) = delete;
+    probe& operator=(probe&&) = delete;
+    ~probe() noexcept;
+
     void add_bytes_written(uint64_t written) {
         _partition_bytes += written;
         _bytes_written += written;
@@ -38,6 +57,20 @@ public:
 
     void segment_compacted() { ++_segment_compacted; }
 
+    /// \brief sizes of a segment before and after compacting it alone
+    void add_compaction_result(size_t before, size_t after) {
+        _compaction_bytes_in += before;
+        _compaction_bytes_out += std::min(before, after);
+    }
+    /// share of the bytes compaction kept so far, 0 before any was observed
+    double compaction_ratio() const {
+        return _compaction_bytes_in == 0
+                 ? 0.0
+                 : static_cast<double>(_compaction_bytes_out)
+                     / _compaction_bytes_in;
+    }
+    void set_compaction_backlog(const compaction_backlog& b) { _backlog = b; }
+
     void batch_write_error(const std::exception_ptr& e) {
         stlog.error("Error writing record batch {}", e);
         ++_batch_write_errors;
@@ -50,7 +83,34 @@ public:
 
     void batch_parse_error() { ++_batch_parse_errors; }
 
-    void setup_metrics(const model::ntp&);
+    void batch_cache_hit() { ++_batch_cache_hits; }
+    void batch_cache_miss() { ++_batch_cache_misses; }
+    uint64_t batch_cache_misses() const { return _batch_cache_misses; }
+    void batch_cache_admit() { ++_batch_cache_admits; }
+
+    void readers_cache_hit() { ++_readers_cache_hits; }
+    void readers_cache_miss() { ++_readers_cache_misses; }
+
+    void index_seek() { ++_index_seeks; }
+    void add_lock_wait(std::chrono::steady_clock::duration d) {
+        ++_lock_waits;
+        _lock_wait_us
+          += std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    }
+    void segment_rolled(std::chrono::steady_clock::duration d, bool prepared) {
+        ++_segment_rolls;
+        _prepared_segment_rolls += prepared ? 1 : 0;
+        _segment_roll_us
+          += std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    }
+    void add_index_seek_bytes(uint64_t skipped) {
+        _index_seek_bytes += skipped;
+    }
+
+    /// \brief the index memory gauge sums the indices of `segs`, which must
+    /// outlive the probe metrics
+    void setup_metrics(const model::ntp&, const segment_set& segs);
+    void clear_metrics() { _metrics.clear(); }
 
     void delete_segment(const segment&);
 
@@ -59,6 +119,9 @@ public:
     void remove_partition_bytes(size_t remove) { _partition_bytes -= remove; }
 
 private:
+    friend class topic_probe;
+    friend class log_probes;
+
     uint64_t _partition_bytes = 0;
     uint64_t _bytes_written = 0;
     uint64_t _bytes_read = 0;
@@ -68,11 +131,128 @@ private:
     uint64_t _batches_read = 0;
     uint64_t _cached_batches_read = 0;
 
+    uint64_t _batch_cache_hits = 0;
+    uint64_t _batch_cache_misses = 0;
+    uint64_t _batch_cache_admits = 0;
+
+    uint64_t _readers_cache_hits = 0;
+    uint64_t _readers_cache_misses = 0;
+
+    uint64_t _index_seeks = 0;
+    uint64_t _index_seek_bytes = 0;
+
+    uint64_t _lock_waits = 0;
+    uint64_t _lock_wait_us = 0;
+
+    uint64_t _segment_rolls = 0;
+    uint64_t _prepared_segment_rolls = 0;
+    uint64_t _segment_roll_us = 0;
+
+    uint64_t _compaction_bytes_in = 0;
+    uint64_t _compaction_bytes_out = 0;
+    compaction_backlog _backlog;
+
     uint32_t _segment_compacted = 0;
     uint32_t _corrupted_compaction_index = 0;
     uint32_t _log_segments_created = 0;
     uint32_t _batch_parse_errors = 0;
     uint32_t _batch_write_errors = 0;
     ss::metrics::metric_groups _metrics;
+
+    // set while the metrics of the log are aggregated into its topic
+    topic_probe* _topic{nullptr};
+    const model::ntp* _ntp{nullptr};
+    const segment_set* _segs{nullptr};
+    intrusive_list_hook _topic_hook;
+    // bytes written and read when the log was last ranked
+    uint64_t _ranked_bytes{0};
+    bool _detailed{false};
+};
+
+/**
+ * Sums of the metrics of the logs of a topic on this shard.
+ *
+ * The counters of the logs which left the shard are kept, the sums do not
+ * go backwards when a partition moves away.
+ */
+class topic_probe {
+public:
+    explicit topic_probe(const model::topic_namespace&);
+    topic_probe(const topic_probe&) = delete;
+    topic_probe& operator=(const topic_probe&) = delete;
+    topic_probe(topic_probe&&) = delete;
+    topic_probe& operator=(topic_probe&&) = delete;
+    ~topic_probe() noexcept = default;
+
+    void add(probe&);
+    /// \brief keeps the counters of a log which is going away
+    void remove(probe&);
+
+private:
+    friend class log_probes;
+
+    struct totals {
+        uint64_t bytes_written{0};
+        uint64_t bytes_read{0};
+        uint64_t batches_written{0};
+        uint64_t batches_read{0};
+    };
+
+    totals sum() const;
+    uint64_t partition_bytes() const;
+    void setup_metrics(const model::topic_namespace&);
+
+    intrusive_list<probe, &probe::_topic_hook> _logs;
+    totals _removed;
+    ss::metrics::metric_groups _metrics;
+};
+
+/**
+ * The metrics of the logs of a shard, bounded in cardinality.
+ *
+ * Registering a few dozen series per log makes the metrics of a node with
+ * tens of thousands of partitions cost seconds per scrape, and a lot of
+ * memory. When aggregating, the logs are summed into a series per topic and
+ * the detail of a log is registered only while it ranks among the
+ * `detail_limit` logs of the shard with the most bytes written and read in
+ * the last `rank_interval`. An idle log registers nothing.
+ */
+class log_probes {
+public:
+    struct config {
+        bool aggregate{false};
+        size_t detail_limit{0};
+        std::chrono::milliseconds rank_interval{0};
+    };
+
+    explicit log_probes(config);
+    log_probes(const log_probes&) = delete;
+    log_probes& operator=(const log_probes&) = delete;
+    log_probes(log_probes&&) = delete;
+    log_probes& operator=(log_probes&&) = delete;
+    ~log_probes() noexcept = default;
+
+    /// \brief sets up the metrics of a log, `ntp` and `segs` must outlive
+    /// the probe
+    void add(probe&, const model::ntp& ntp, const segment_set& segs);
+
+    void stop() { _rank_timer.cancel(); }
+
+    /// \brief registers the detail of the busiest logs, and clears it from
+    /// the others
+    void rank();
+
+    size_t detailed() const { return _detailed; }
+
+private:
+    config _cfg;
+    absl::node_hash_map<
+      model::topic_namespace,
+      topic_probe,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      _topics;
+    ss::timer<ss::lowres_clock> _rank_timer;
+    size_t _detailed{0};
 };
 } // namespace storage
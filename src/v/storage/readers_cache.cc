@@ -0,0 +1,220 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/readers_cache.h"
+
+#include "storage/logger.h"
+#include "storage/probe.h"
+#include "vlog.h"
+
+#include <seastar/core/loop.hh>
+
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace storage {
+
+/*
+ * Hands a reader of the log out to a consumer, and back to the cache once
+ * consumed.
+ */
+class readers_cache::cached_reader final
+  : public model::record_batch_reader::impl {
+public:
+    cached_reader(readers_cache& c, std::unique_ptr<log_reader> r)
+      : _cache(c)
+      , _reader(std::move(r)) {
+        _cache._gate.enter();
+    }
+    cached_reader(cached_reader&&) = delete;
+    cached_reader& operator=(cached_reader&&) = delete;
+    cached_reader(const cached_reader&) = delete;
+    cached_reader& operator=(const cached_reader&) = delete;
+    ~cached_reader() noexcept final { _cache._gate.leave(); }
+
+    bool is_end_of_stream() const final { return _reader->is_end_of_stream(); }
+
+    ss::future<storage_t>
+    do_load_slice(model::timeout_clock::time_point t) final {
+        return _reader->do_load_slice(t);
+    }
+
+    ss::future<> finally() noexcept final {
+        // a reader resumed at the next offset would skip the batches loaded
+        // but not consumed
+        return _cache.release(std::move(_reader), is_slice_empty());
+    }
+
+    void print(std::ostream& os) final {
+        fmt::print(os, "storage::readers_cache::cached_reader ");
+        _reader->print(os);
+    }
+
+private:
+    readers_cache& _cache;
+    std::unique_ptr<log_reader> _reader;
+};
+
+readers_cache::range_guard::~range_guard() noexcept {
+    if (_cache) {
+        _cache->_guards.erase(_it);
+    }
+}
+
+readers_cache::readers_cache(segment_set& s, probe& p, config cfg)
+  : _set(s)
+  , _probe(p)
+  , _cfg(cfg) {
+    _idle_timer.set_callback([this] { evict_idle(); });
+}
+
+std::optional<model::record_batch_reader>
+readers_cache::get(const log_reader_config& cfg) {
+    if (_cfg.max_readers == 0 || _gate.is_closed()) {
+        return std::nullopt;
+    }
+    auto it = std::find_if(
+      _readers.begin(), _readers.end(), [&cfg](const entry& e) {
+          return e.reader->next_offset() == cfg.start_offset;
+      });
+    if (it == _readers.end()) {
+        _probe.readers_cache_miss();
+        return std::nullopt;
+    }
+    auto r = std::move(it->reader);
+    _readers.erase(it);
+    if (!reaches_end(*r)) {
+        dispose(std::move(r));
+        _probe.readers_cache_miss();
+        return std::nullopt;
+    }
+    r->reset_config(cfg);
+    _probe.readers_cache_hit();
+    return model::record_batch_reader(
+      std::make_unique<cached_reader>(*this, std::move(r)));
+}
+
+model::record_batch_reader
+readers_cache::put(std::unique_ptr<log_reader> r) {
+    if (_cfg.max_readers == 0 || _gate.is_closed()) {
+        return model::record_batch_reader(std::move(r));
+    }
+    return model::record_batch_reader(
+      std::make_unique<cached_reader>(*this, std::move(r)));
+}
+
+readers_cache::range_guard
+readers_cache::evict_range(model::offset base, model::offset last) {
+    auto g = range_guard(
+      *this, _guards.insert(_guards.end(), offset_range{base, last}));
+    for (auto it = _readers.begin(); it != _readers.end();) {
+        const auto r = range_of(*it->reader);
+        if (r.base <= last && base <= r.last) {
+            dispose(std::move(it->reader));
+            it = _readers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return g;
+}
+
+ss::future<> readers_cache::stop() {
+    _idle_timer.cancel();
+    // readers handed out are closed once consumed
+    auto f = _gate.close();
+    std::vector<std::unique_ptr<log_reader>> parked;
+    parked.reserve(_readers.size());
+    for (auto& e : _readers) {
+        parked.push_back(std::move(e.reader));
+    }
+    _readers.clear();
+    return ss::do_with(
+             std::move(parked),
+             [](std::vector<std::unique_ptr<log_reader>>& parked) {
+                 return ss::parallel_for_each(
+                   parked, [](std::unique_ptr<log_reader>& r) {
+                       return close(std::move(r));
+                   });
+             })
+      .then([f = std::move(f)]() mutable { return std::move(f); });
+}
+
+ss::future<>
+readers_cache::release(std::unique_ptr<log_reader> r, bool consumed) {
+    if (!consumed || !r->is_reusable() || _gate.is_closed()) {
+        return close(std::move(r));
+    }
+    auto raw = r.get();
+    return raw->park().then([this, r = std::move(r)]() mutable {
+        if (_gate.is_closed() || blocked(*r) || !reaches_end(*r)) {
+            return close(std::move(r));
+        }
+        _readers.push_back(
+          entry{.reader = std::move(r), .parked_at = ss::lowres_clock::now()});
+        if (_readers.size() > _cfg.max_readers) {
+            dispose(std::move(_readers.front().reader));
+            _readers.pop_front();
+        }
+        if (!_idle_timer.armed()) {
+            _idle_timer.arm(_cfg.idle_timeout);
+        }
+        return ss::now();
+    });
+}
+
+bool readers_cache::reaches_end(const log_reader& r) const {
+    const auto& range = r.lease().range;
+    return !range.empty() && !_set.empty() && range.back() == _set.back();
+}
+
+bool readers_cache::blocked(const log_reader& r) const {
+    const auto range = range_of(r);
+    return std::any_of(
+      _guards.begin(), _guards.end(), [&range](const offset_range& g) {
+          return range.base <= g.last && g.base <= range.last;
+      });
+}
+
+void readers_cache::dispose(std::unique_ptr<log_reader> r) {
+    (void)ss::with_gate(_gate, [r = std::move(r)]() mutable {
+        return close(std::move(r)).handle_exception([](std::exception_ptr e) {
+            vlog(stlog.warn, "error closing a cached reader: {}", e);
+        });
+    });
+}
+
+void readers_cache::evict_idle() {
+    const auto idle = ss::lowres_clock::now() - _cfg.idle_timeout;
+    while (!_readers.empty() && _readers.front().parked_at <= idle) {
+        dispose(std::move(_readers.front().reader));
+        _readers.pop_front();
+    }
+    if (!_readers.empty()) {
+        _idle_timer.arm(_readers.front().parked_at + _cfg.idle_timeout);
+    }
+}
+
+readers_cache::offset_range readers_cache::range_of(const log_reader& r) {
+    // a reusable reader holds a segment at least
+    const auto& range = r.lease().range;
+    const auto& back = range.back()->offsets();
+    return offset_range{
+      .base = range.front()->offsets().base_offset,
+      .last = std::max(back.base_offset, back.dirty_offset)};
+}
+
+ss::future<> readers_cache::close(std::unique_ptr<log_reader> r) {
+    auto raw = r.get();
+    return raw->finally().finally([r = std::move(r)] {});
+}
+
+} // namespace storage
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/fundamental.h"
+#include "model/record_batch_reader.h"
+#include "seastarx.h"
+#include "storage/log_reader.h"
+#include "storage/segment_set.h"
+#include "storage/types.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace storage {
+class probe;
+
+/**
+ * Readers of a log parked between the fetches of its consumers.
+ *
+ * A reader takes a lease on the segments it covers and walks them in order.
+ * A consumer tailing the log comes back for the next offset shortly after
+ * its previous fetch, which would build the lease and the reader all over
+ * again. Instead, a reader that stopped at the bounds of its request is
+ * parked here once consumed, keyed by the offset it continues from, and the
+ * next read starting at that offset resumes it. The lease, the segment
+ * iterator and the reader are reused. Only the stream of the segment is
+ * opened again, and only when the batch cache misses.
+ *
+ * Parked readers keep their segments locked. Operations that rewrite or
+ * remove segments evict the readers of those segments, and keep readers from
+ * being parked on them until they are done, see evict_range(). Readers idle
+ * for longer than idle_timeout are closed.
+ */
+class readers_cache {
+public:
+    struct config {
+        // parked readers per log, zero disables the cache
+        size_t max_readers{0};
+        std::chrono::milliseconds idle_timeout{0};
+    };
+
+private:
+    struct offset_range {
+        model::offset base;
+        model::offset last;
+    };
+
+public:
+    /// \brief keeps readers of a range of offsets from being parked
+    class range_guard {
+    public:
+        range_guard(range_guard&& o) noexcept
+          : _cache(std::exchange(o._cache, nullptr))
+          , _it(o._it) {}
+        range_guard& operator=(range_guard&&) = delete;
+        range_guard(const range_guard&) = delete;
+        range_guard& operator=(const range_guard&) = delete;
+        ~range_guard() noexcept;
+
+    private:
+        friend class readers_cache;
+        range_guard(
+          readers_cache& c, std::list<offset_range>::iterator it) noexcept
+          : _cache(&c)
+          , _it(it) {}
+
+        readers_cache* _cache;
+        std::list<offset_range>::iterator _it;
+    };
+
+    readers_cache(segment_set&, probe&, config);
+    readers_cache(readers_cache&&) = delete;
+    readers_cache& operator=(readers_cache&&) = delete;
+    readers_cache(const readers_cache&) = delete;
+    readers_cache& operator=(const readers_cache&) = delete;
+    ~readers_cache() noexcept = default;
+
+    /// \brief resumes the reader parked at the start offset of `cfg`
+    std::optional<model::record_batch_reader> get(const log_reader_config&);
+
+    /// \brief hands out a new reader, which is parked once consumed
+    model::record_batch_reader put(std::unique_ptr<log_reader>);
+
+    /// \brief closes the parked readers of the segments holding any offset
+    /// of [base, last], no reader of those is parked while the guard lives
+    [[nodiscard]] range_guard
+    evict_range(model::offset base, model::offset last);
+
+    /// \brief closes the parked readers and waits for the ones handed out
+    ss::future<> stop();
+
+    size_t size() const { return _readers.size(); }
+
+private:
+    class cached_reader;
+
+    struct entry {
+        std::unique_ptr<log_reader> reader;
+        ss::lowres_clock::time_point parked_at;
+    };
+
+    /// \brief parks a consumed reader, or closes it
+    ss::future<> release(std::unique_ptr<log_reader>, bool consumed);
+    /// \brief whether the segments of the reader still reach the end of the
+    /// log, the reader would miss the segments rolled after its lease
+    bool reaches_end(const log_reader&) const;
+    bool blocked(const log_reader&) const;
+    void dispose(std::unique_ptr<log_reader>);
+    void evict_idle();
+
+    static offset_range range_of(const log_reader&);
+    static ss::future<> close(std::unique_ptr<log_reader>);
+
+    segment_set& _set;
+    probe& _probe;
+    config _cfg;
+    // oldest first
+    std::list<entry> _readers;
+    std::list<offset_range> _guards;
+    ss::timer<ss::lowres_clock> _idle_timer;
+    ss::gate _gate;
+};
+
+} // namespace storage
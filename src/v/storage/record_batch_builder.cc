@@ -9,13 +9,19 @@
 
 #include "storage/record_batch_builder.h"
 
+#include "bytes/details/io_allocation_size.h"
+#include "hashing/crc32c.h"
 #include "model/record.h"
 #include "model/record_utils.h"
 #include "model/timeout_clock.h"
-#include "storage/parser_utils.h"
+#include "vassert.h"
 
+#include <seastar/core/byteorder.hh>
 #include <seastar/core/smp.hh>
 
+#include <algorithm>
+#include <array>
+
 namespace storage {
 
 record_batch_builder::record_batch_builder(
@@ -45,26 +51,64 @@ model::record_batch record_batch_builder::build() && {
       .ctx = model::record_batch_header::context(
         model::term_id(0), ss::this_shard_id())};
 
+    /**
+     * The records are written once, into fragments of the exact size left
+     * up to the largest iobuf allocation, and the crc covers every byte as
+     * it is written. The header fields covered by the crc are final.
+     */
+    auto crc = crc32();
+    model::crc_record_batch_header(crc, header);
     iobuf records;
+    size_t left = _records_size;
+    auto put = [&crc, &records, &left](const char* src, size_t n) {
+        crc.extend(src, n);
+        while (n > 0) {
+            if (records.available_bytes() == 0) {
+                records.reserve_exact_memory(std::min(
+                  std::max(left, n),
+                  details::io_allocation_size::max_chunk_size));
+            }
+            const auto k = std::min(n, records.available_bytes());
+            records.append(src, k);
+            src += k;
+            n -= k;
+            left -= k;
+        }
+    };
+    auto put_vint = [&put](int64_t v) {
+        std::array<uint8_t, vint::max_length> buf;
+        const auto n = vint::serialize(v, buf.data());
+        // NOLINTNEXTLINE
+        put(reinterpret_cast<const char*>(buf.data()), n);
+    };
+    auto put_iobuf = [&put](const iobuf& b) {
+        for (const auto& f : b) {
+            put(f.get(), f.size());
+        }
+    };
     for (auto& sr : _records) {
-        auto rec_sz = record_size(offset_delta, sr);
-        auto kz = sr.key.size_bytes();
-        auto vz = sr.value.size_bytes();
-        auto r = model::record(
-          rec_sz,
-          model::record_attributes{},
-          0,
-          offset_delta,
-          kz,
-          std::move(sr.key),
-          vz,
-          std::move(sr.value),
-          std::vector<model::record_header>{});
-        ++offset_delta;
-        model::append_record_to_buffer(records, r);
+        put_vint(sr.encoded_size);
+        const auto attrs = ss::cpu_to_be(model::record_attributes{}.value());
+        // NOLINTNEXTLINE
+        put(reinterpret_cast<const char*>(&attrs), sizeof(attrs));
+        put_vint(0); // timestamp delta
+        put_vint(offset_delta++);
+        put_vint(sr.key.size_bytes());
+        put_iobuf(sr.key);
+        put_vint(sr.value.size_bytes());
+        put_iobuf(sr.value);
+        put_vint(0); // headers
     }
+    vassert(
+      left == 0 && records.size_bytes() == _records_size,
+      "records of {} bytes encoded in {}",
+      _records_size,
+      records.size_bytes());
 
-    internal::reset_size_checksum_metadata(header, records);
+    header.size_bytes = model::packed_record_batch_header_size
+                        + records.size_bytes();
+    header.crc = crc.value();
+    header.header_crc = model::internal_header_only_crc(header);
     return model::record_batch(
       header, std::move(records), model::record_batch::tag_ctor_ng{});
 }
@@ -16,6 +16,11 @@
 #include "utils/vint.h"
 
 namespace storage {
+/**
+ * Builds an uncompressed batch of key/value records. The encoded size of a
+ * record is known when it is added, build() reserves the exact size of the
+ * records and computes the batch crc while it writes them.
+ */
 class record_batch_builder {
 public:
     record_batch_builder(model::record_batch_type, model::offset);
@@ -25,7 +30,10 @@ public:
     record_batch_builder& operator=(const record_batch_builder&) = delete;
 
     virtual record_batch_builder& add_raw_kv(iobuf&& key, iobuf&& value) {
-        _records.emplace_back(std::move(key), std::move(value));
+        auto& r = _records.emplace_back(std::move(key), std::move(value));
+        r.encoded_size = record_size(
+          static_cast<int32_t>(_records.size() - 1), r);
+        _records_size += vint::vint_size(r.encoded_size) + r.encoded_size;
         return *this;
     }
     virtual model::record_batch build() &&;
@@ -40,16 +48,21 @@ private:
 
         iobuf key;
         iobuf value;
+        // size of the record after its length
+        uint32_t encoded_size{0};
 
         uint32_t size_bytes() const {
             return key.size_bytes() + value.size_bytes();
         }
     };
 
-    uint32_t record_size(int32_t offset_delta, const serialized_record& r);
+    static uint32_t
+    record_size(int32_t offset_delta, const serialized_record& r);
 
     model::record_batch_type _batch_type;
     model::offset _base_offset;
     std::vector<serialized_record> _records;
+    // bytes of the encoded records
+    size_t _records_size{0};
 };
 } // namespace storage
@@ -11,6 +11,7 @@
 
 #include "compression/compression.h"
 #include "config/configuration.h"
+#include "model/record_view.h"
 #include "storage/compacted_index_writer.h"
 #include "storage/fs_utils.h"
 #include "storage/logger.h"
@@ -36,6 +37,7 @@
 #include <optional>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 namespace storage {
 
@@ -80,7 +82,8 @@ ss::future<> segment::close() {
      */
     return _gate.close().then([this] {
         return write_lock().then([this](ss::rwlock::holder h) {
-            return do_flush()
+            return drain_compaction_index()
+              .then([this] { return do_flush(); })
               .then([this] { return do_close(); })
               .then([this] { return remove_tombstones(); })
               .finally([h = std::move(h)] {});
@@ -94,7 +97,9 @@ ss::future<> segment::remove_tombstones() {
     }
     std::vector<std::filesystem::path> rm;
     rm.reserve(3);
-    rm.emplace_back(reader().filename().c_str());
+    if ((_flags & bitflags::keep_data_file) != bitflags::keep_data_file) {
+        rm.emplace_back(reader().filename().c_str());
+    }
     rm.emplace_back(index().filename().c_str());
     if (is_compacted_segment()) {
         rm.push_back(
@@ -139,6 +144,7 @@ ss::future<> segment::do_release_appender(
         std::optional<compacted_index_writer>& compacted_index) {
           return appender->close()
             .then([this] { return _idx.flush(); })
+            .then([this] { _idx.seal(); })
             .then([&compacted_index] {
                 if (compacted_index) {
                     return compacted_index->close();
@@ -167,7 +173,8 @@ ss::future<> segment::release_appender() {
     if (_destructive_ops.try_write_lock()) {
         _destructive_ops.write_unlock();
         return write_lock().then([this](ss::rwlock::holder h) {
-            return do_flush()
+            return drain_compaction_index()
+              .then([this] { return do_flush(); })
               .then([this] {
                   auto a = std::exchange(_appender, std::nullopt);
                   auto c
@@ -182,7 +189,8 @@ ss::future<> segment::release_appender() {
         });
     } else {
         return read_lock().then([this](ss::rwlock::holder h) {
-            return do_flush()
+            return drain_compaction_index()
+              .then([this] { return do_flush(); })
               .then([this] {
                   auto a = std::exchange(_appender, std::nullopt);
                   auto c
@@ -255,8 +263,11 @@ segment::do_truncate(model::offset prev_last_offset, size_t physical) {
     _tracker.stable_offset = prev_last_offset;
     _tracker.dirty_offset = prev_last_offset;
     _reader.set_file_size(physical);
-    cache_truncate(prev_last_offset + model::offset(1));
-    auto f = ss::now();
+    // batches still waiting to be indexed may put their decompressed form in
+    // the cache
+    auto f = drain_compaction_index().then([this, prev_last_offset] {
+        cache_truncate(prev_last_offset + model::offset(1));
+    });
     if (is_compacted_segment()) {
         // if compaction index is opened close it
         if (_compaction_index) {
@@ -304,6 +315,24 @@ ss::future<bool> segment::materialize_index() {
             _tracker.committed_offset = _idx.max_offset();
             _tracker.stable_offset = _idx.max_offset();
             _tracker.dirty_offset = _idx.max_offset();
+            // segments with a valid index on disk are not written to
+            _idx.seal();
+        }
+        return yn;
+    });
+}
+
+ss::future<bool> segment::materialize_index_header() {
+    vassert(
+      _tracker.base_offset == _tracker.dirty_offset,
+      "Materializing the index must happen tracking any data. {}",
+      *this);
+    return _idx.materialize_index_header().then([this](bool yn) {
+        if (yn) {
+            _tracker.committed_offset = _idx.max_offset();
+            _tracker.stable_offset = _idx.max_offset();
+            _tracker.dirty_offset = _idx.max_offset();
+            _idx.seal();
         }
         return yn;
     });
@@ -318,26 +347,93 @@ void segment::cache_truncate(model::offset offset) {
 ss::future<> segment::do_compaction_index_batch(const model::record_batch& b) {
     vassert(!b.compressed(), "wrong method. Call compact_index_batch. {}", b);
     auto& w = compaction_index();
-    return model::for_each_record(
-      b, [o = b.base_offset(), &w](const model::record& r) {
-          return w.index(r.key(), o, r.offset_delta());
+    return model::async_for_each_record_view(
+      b, [o = b.base_offset(), &w](const model::record_view& r) {
+          if (r.value_size() < 0) {
+              w.set_flag(compacted_index::footer_flags::tombstones);
+          }
+          return w.index(r.copy_key_bytes(), o, r.offset_delta());
       });
 }
 ss::future<> segment::compaction_index_batch(const model::record_batch& b) {
-    if (!has_compaction_index()) {
+    if (!has_compaction_index() || _compaction_index_failed) {
         return ss::now();
     }
     if (!b.compressed()) {
         return do_compaction_index_batch(b);
     }
-    return internal::decompress_batch(b).then([this](model::record_batch&& b) {
-        return ss::do_with(std::move(b), [this](model::record_batch& b) {
-            return do_compaction_index_batch(b);
-        });
+    // the decompressed form is kept with the cached batch for the compaction
+    // of this segment
+    auto cache = _cache ? &*_cache : nullptr;
+    return internal::decompress_batch(b, cache).then(
+      [this](model::record_batch&& b) {
+          return ss::do_with(std::move(b), [this](model::record_batch& b) {
+              return do_compaction_index_batch(b);
+          });
+      });
+}
+
+/**
+ * Indexing the keys of a batch hashes every key and may spill the key index
+ * to disk, it runs behind the appends so that produce latency does not pay
+ * for it. The batch is copied, at most compaction_index_backlog bytes wait
+ * to be indexed. The index is brought up to date before the segment is
+ * rolled, truncated or closed, which is also when an index that failed is
+ * removed: compaction rebuilds a missing index from the segment.
+ */
+ss::future<>
+segment::enqueue_compaction_index(const model::record_batch& b) {
+    if (!has_compaction_index() || _compaction_index_failed) {
+        return ss::now();
+    }
+    const auto bytes = std::min<size_t>(
+      b.size_bytes(), compaction_index_backlog);
+    return ss::get_units(_compaction_backlog, bytes)
+      .then([this, batch = b.copy()](ss::semaphore_units<> units) mutable {
+          _compaction_indexing
+            = _compaction_indexing
+                .then([this, batch = std::move(batch)]() mutable {
+                    return ss::do_with(
+                      std::move(batch), [this](model::record_batch& b) {
+                          return compaction_index_batch(b);
+                      });
+                })
+                .handle_exception([this](const std::exception_ptr& e) {
+                    vlog(
+                      stlog.error,
+                      "cannot index batch of {} for compaction, the index "
+                      "will be rebuilt - {}",
+                      _reader.filename(),
+                      e);
+                    _compaction_index_failed = true;
+                })
+                .finally([units = std::move(units)] {});
+      });
+}
+
+ss::future<> segment::drain_compaction_index() {
+    return std::exchange(_compaction_indexing, ss::now()).then([this] {
+        if (!_compaction_index_failed || !_compaction_index) {
+            return ss::now();
+        }
+        _compaction_index_failed = false;
+        return ss::do_with(
+                 std::exchange(_compaction_index, std::nullopt),
+                 [](std::optional<compacted_index_writer>& c) {
+                     return c->close().handle_exception(
+                       [](const std::exception_ptr& e) {
+                           vlog(
+                             stlog.warn,
+                             "error closing compacted index - {}",
+                             e);
+                       });
+                 })
+          .then([this] { return remove_compacted_index(_reader.filename()); });
     });
 }
 
-ss::future<append_result> segment::append(const model::record_batch& b) {
+ss::future<append_result>
+segment::append(const model::record_batch& b, cache_priority priority) {
     check_segment_not_closed("append()");
     vassert(
       b.base_offset() >= _tracker.base_offset,
@@ -362,7 +458,7 @@ ss::future<append_result> segment::append(const model::record_batch& b) {
     const auto start_physical_offset = _appender->file_byte_offset();
     // proxy serialization to segment_appender_utils
     auto write_fut
-      = write(*_appender, b).then([this, &b, start_physical_offset] {
+      = write(*_appender, b).then([this, &b, start_physical_offset, priority] {
             _tracker.dirty_offset = b.last_offset();
             const auto end_physical_offset = _appender->file_byte_offset();
             const auto expected_end_physical = start_physical_offset
@@ -384,10 +480,10 @@ ss::future<append_result> segment::append(const model::record_batch& b) {
               .last_offset = b.last_offset(),
               .byte_size = (size_t)b.size_bytes()};
             // cache always copies the batch
-            cache_put(b);
+            cache_put(b, priority);
             return ret;
         });
-    auto index_fut = compaction_index_batch(b);
+    auto index_fut = enqueue_compaction_index(b);
     return ss::when_all(std::move(write_fut), std::move(index_fut))
       .then([](std::tuple<ss::future<append_result>, ss::future<>> p) {
           auto& [append_fut, index_fut] = p;
@@ -429,6 +525,13 @@ segment::offset_data_stream(model::offset o, ss::io_priority_class iopc) {
     if (nearest) {
         position = nearest->filepos;
     }
+    // the newest bytes may still be held by the appender
+    if (_appender) {
+        auto tail = _appender->read_tail(position, _reader.file_size());
+        if (tail) {
+            return make_iobuf_input_stream(std::move(*tail));
+        }
+    }
     return _reader.data_stream(position, iopc);
 }
 
@@ -511,7 +614,8 @@ ss::future<ss::lw_shared_ptr<segment>> open_segment(
   const std::filesystem::path& path,
   debug_sanitize_files sanitize_fileops,
   std::optional<batch_cache_index> batch_cache,
-  size_t buf_size) {
+  size_t buf_size,
+  std::optional<std::filesystem::path> cold_data) {
     auto const meta = segment_path::parse_segment_filename(
       path.filename().string());
     if (!meta || meta->version != record_version_type::v1) {
@@ -532,22 +636,26 @@ ss::future<ss::lw_shared_ptr<segment>> open_segment(
     // preventing x-file synchronization This is fine, because truncation to
     // sealed segments are supposed to be very rare events. The hotpath of
     // truncating the appender, is optimized.
-    return internal::make_reader_handle(path, sanitize_fileops)
+    const auto data_path = cold_data.value_or(path);
+    const auto cold = segment_reader::cold(cold_data.has_value());
+    return internal::make_reader_handle(data_path, sanitize_fileops)
       .then([](ss::file f) {
           return f.stat().then([f](struct stat s) {
               return ss::make_ready_future<std::tuple<uint64_t, ss::file>>(
                 std::make_tuple(s.st_size, f));
           });
       })
-      .then([buf_size, path](std::tuple<uint64_t, ss::file> t) {
+      .then([buf_size, data_path, cold](std::tuple<uint64_t, ss::file> t) {
           auto& [size, fd] = t;
           return std::make_unique<segment_reader>(
-            path.string(), std::move(fd), size, buf_size);
+            data_path.string(), std::move(fd), size, buf_size, cold);
       })
-      .then([batch_cache = std::move(batch_cache), meta, sanitize_fileops](
-              std::unique_ptr<segment_reader> rdr) mutable {
+      .then([batch_cache = std::move(batch_cache),
+             meta,
+             sanitize_fileops,
+             path](std::unique_ptr<segment_reader> rdr) mutable {
           auto ptr = rdr.get();
-          auto index_name = std::filesystem::path(ptr->filename().c_str())
+          auto index_name = std::filesystem::path(path)
                               .replace_extension("base_index")
                               .string();
           return ss::open_file_dma(
@@ -597,23 +705,26 @@ ss::future<ss::lw_shared_ptr<segment>> make_segment(
   record_version_type version,
   size_t buf_size,
   debug_sanitize_files sanitize_fileops,
-  std::optional<batch_cache_index> batch_cache) {
+  std::optional<batch_cache_index> batch_cache,
+  size_t preallocated) {
     auto path = segment_path::make_segment_path(
       ntpc, base_offset, term, version);
     vlog(stlog.info, "Creating new segment {}", path.string());
     return open_segment(
              path, sanitize_fileops, std::move(batch_cache), buf_size)
-      .then([path, &ntpc, sanitize_fileops, pc](
+      .then([path, &ntpc, sanitize_fileops, pc, preallocated](
               ss::lw_shared_ptr<segment> seg) {
           return with_segment(
             std::move(seg),
-            [path, &ntpc, sanitize_fileops, pc](
+            [path, &ntpc, sanitize_fileops, pc, preallocated](
               const ss::lw_shared_ptr<segment>& seg) {
                 return internal::make_segment_appender(
                          path,
                          sanitize_fileops,
                          internal::number_of_chunks_from_config(ntpc),
-                         pc)
+                         pc,
+                         segment_appender::fallocation_step,
+                         preallocated)
                   .then([seg](segment_appender_ptr a) {
                       return ss::make_ready_future<ss::lw_shared_ptr<segment>>(
                         ss::make_lw_shared<segment>(
@@ -656,4 +767,171 @@ ss::future<ss::lw_shared_ptr<segment>> make_segment(
       });
 }
 
+ss::future<> prepared_segment_files::close() {
+    auto f = reader.close().then([this] { return writer.close(); });
+    f = f.then([this] { return index.close(); });
+    if (compaction_index) {
+        f = f.then([this] { return compaction_index->close(); });
+    }
+    return f;
+}
+
+ss::future<prepared_segment_files> prepare_segment_files(
+  std::filesystem::path dir,
+  bool compacted,
+  debug_sanitize_files sanitize_fileops,
+  size_t preallocated,
+  size_t falloc_step) {
+    auto files = ss::make_lw_shared<prepared_segment_files>();
+    files->dir = std::move(dir);
+    files->preallocated = preallocated;
+    const auto data = files->dir / prepared_segment_files::data_name;
+    auto f = internal::make_writer_handle(data, sanitize_fileops)
+               .then([files, falloc_step](ss::file w) {
+                   files->writer = std::move(w);
+                   if (files->preallocated > 0) {
+                       return ss::now();
+                   }
+                   // files left by an earlier prepare are staged again
+                   return files->writer.truncate(0)
+                     .then([files, falloc_step] {
+                         return files->writer.allocate(0, falloc_step);
+                     })
+                     .then([files, falloc_step] {
+                         files->preallocated = falloc_step;
+                     });
+               })
+               .then([files, data, sanitize_fileops] {
+                   return internal::make_reader_handle(data, sanitize_fileops)
+                     .then([files](ss::file r) {
+                         files->reader = std::move(r);
+                     });
+               })
+               .then([files, sanitize_fileops] {
+                   return internal::make_writer_handle(
+                            files->dir / prepared_segment_files::index_name,
+                            sanitize_fileops)
+                     .then([files](ss::file i) {
+                         files->index = std::move(i);
+                         return files->index.truncate(0);
+                     });
+               });
+    if (compacted) {
+        f = f.then([files, sanitize_fileops] {
+            return internal::make_writer_handle(
+                     files->dir
+                       / prepared_segment_files::compaction_index_name,
+                     sanitize_fileops)
+              .then([files](ss::file c) {
+                  files->compaction_index = std::move(c);
+                  return files->compaction_index->truncate(0);
+              });
+        });
+    }
+    return f.then_wrapped([files](ss::future<> f) {
+        if (!f.failed()) {
+            return ss::make_ready_future<prepared_segment_files>(
+              std::move(*files));
+        }
+        auto e = f.get_exception();
+        // only the files opened so far are closed
+        std::vector<ss::file> opened;
+        for (auto* fd : {&files->writer, &files->reader, &files->index}) {
+            if (*fd) {
+                opened.push_back(std::move(*fd));
+            }
+        }
+        if (files->compaction_index) {
+            opened.push_back(std::move(*files->compaction_index));
+        }
+        return ss::do_with(
+          std::move(opened), [e](std::vector<ss::file>& opened) {
+              return ss::do_for_each(
+                       opened,
+                       [](ss::file& fd) {
+                           return fd.close().handle_exception(
+                             [](std::exception_ptr) {});
+                       })
+                .then([e] {
+                    return ss::make_exception_future<prepared_segment_files>(
+                      e);
+                });
+          });
+    });
+}
+
+ss::future<ss::lw_shared_ptr<segment>> make_segment(
+  const ntp_config& ntpc,
+  model::offset base_offset,
+  model::term_id term,
+  ss::io_priority_class pc,
+  record_version_type version,
+  size_t buf_size,
+  std::optional<batch_cache_index> batch_cache,
+  prepared_segment_files files) {
+    auto path = segment_path::make_segment_path(
+      ntpc, base_offset, term, version);
+    auto index_path = std::filesystem::path(path).replace_extension(
+      "base_index");
+    auto compacted_path = internal::compacted_index_path(path);
+    vlog(stlog.info, "Creating new segment {} from staged files", path);
+    auto p = ss::make_lw_shared<prepared_segment_files>(std::move(files));
+    // the data file goes last, a segment only shows up with its indices
+    auto f = ss::rename_file(
+      (p->dir / prepared_segment_files::index_name).string(),
+      index_path.string());
+    if (p->compaction_index) {
+        f = f.then([p, compacted_path] {
+            return ss::rename_file(
+              (p->dir / prepared_segment_files::compaction_index_name)
+                .string(),
+              compacted_path.string());
+        });
+    }
+    f = f.then([p, path] {
+        return ss::rename_file(
+          (p->dir / prepared_segment_files::data_name).string(),
+          path.string());
+    });
+    return f
+      .handle_exception([p](std::exception_ptr e) {
+          return p->close().then_wrapped([e](ss::future<>) {
+              return ss::make_exception_future<>(e);
+          });
+      })
+      .then([p,
+             &ntpc,
+             base_offset,
+             term,
+             pc,
+             buf_size,
+             path,
+             index_path,
+             compacted_path,
+             batch_cache = std::move(batch_cache)]() mutable {
+          auto opts = segment_appender::options(
+            pc, internal::number_of_chunks_from_config(ntpc));
+          opts.preallocated = p->preallocated;
+          std::optional<compacted_index_writer> compaction;
+          if (p->compaction_index) {
+              compaction = make_file_backed_compacted_index(
+                compacted_path.string(),
+                std::move(*p->compaction_index),
+                pc,
+                segment_appender::write_behind_memory / 2);
+          }
+          return ss::make_lw_shared<segment>(
+            segment::offset_tracker(term, base_offset),
+            segment_reader(path.string(), std::move(p->reader), 0, buf_size),
+            segment_index(
+              index_path.string(),
+              std::move(p->index),
+              base_offset,
+              segment_index::default_data_buffer_step),
+            segment_appender(std::move(p->writer), opts),
+            std::move(compaction),
+            std::move(batch_cache));
+      });
+}
+
 } // namespace storage
@@ -18,12 +18,16 @@
 #include "storage/segment_reader.h"
 #include "storage/types.h"
 #include "storage/version.h"
+#include "units.h"
 
 #include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/rwlock.hh>
+#include <seastar/core/semaphore.hh>
 
 #include <exception>
+#include <limits>
 #include <optional>
 
 namespace storage {
@@ -37,6 +41,10 @@ constexpr size_t default_segment_readahead_size = 128 * 1024;
 
 class segment {
 public:
+    /// bytes of appended batches the compaction index may lag behind, past
+    /// it appends wait for the indexing
+    static constexpr size_t compaction_index_backlog = 4_MiB;
+
     struct offset_tracker {
         offset_tracker(model::term_id t, model::offset base)
           : term(t)
@@ -61,6 +69,9 @@ public:
         finished_self_compaction = 1U << 1U,
         mark_tombstone = 1U << 2U,
         closed = 1U << 3U,
+        finished_tombstone_expiry = 1U << 4U,
+        keep_data_file = 1U << 5U,
+        finished_recompression = 1U << 6U,
     };
 
 public:
@@ -88,8 +99,12 @@ public:
     /// We recommend using the const-ref method below over the r-value since we
     /// do not need to take ownership of the batch itself
     ss::future<append_result> append(model::record_batch&&);
-    ss::future<append_result> append(const model::record_batch&);
+    ss::future<append_result> append(
+      const model::record_batch&, cache_priority = cache_priority::normal);
     ss::future<bool> materialize_index();
+    /// \brief like materialize_index() but defers loading the index entries
+    /// until the segment is first read
+    ss::future<bool> materialize_index_header();
 
     /// main read interface
     ss::input_stream<char>
@@ -100,6 +115,8 @@ public:
     size_t size_bytes() const;
     void tombstone();
     bool is_tombstone() const;
+    /// \brief removing the tombstone leaves the data file for recycling
+    void keep_data_file();
     bool has_outstanding_locks() const;
     bool is_closed() const;
     bool has_compaction_index() const;
@@ -107,6 +124,14 @@ public:
     bool is_compacted_segment() const;
     void mark_as_finished_self_compaction();
     bool finished_self_compaction() const;
+    /// \brief cross compaction dropped the expired tombstones, kept in
+    /// memory only: after a restart the segment is rewritten once more
+    void mark_as_finished_tombstone_expiry();
+    bool finished_tombstone_expiry() const;
+    /// \brief the data batches were rewritten to the codec of the topic,
+    /// kept in memory only: after a restart the segment is checked again
+    void mark_as_finished_recompression();
+    bool finished_recompression() const;
     /// \brief used for compaction, to reset the tracker from index
     void force_set_commit_offset_from_index();
     // low level api's are discouraged and might be deprecated
@@ -131,8 +156,12 @@ public:
       std::optional<model::record_batch_type> type_filter,
       std::optional<model::timestamp> first_ts,
       size_t max_bytes,
-      bool skip_lru_promote);
-    void cache_put(const model::record_batch& batch);
+      bool skip_lru_promote,
+      size_t budget = std::numeric_limits<size_t>::max(),
+      bool strict_budget = false);
+    void cache_put(
+      const model::record_batch& batch,
+      cache_priority priority = cache_priority::normal);
 
     ss::future<ss::rwlock::holder> read_lock(
       ss::semaphore::time_point timeout = ss::semaphore::time_point::max());
@@ -140,6 +169,42 @@ public:
     ss::future<ss::rwlock::holder> write_lock(
       ss::semaphore::time_point timeout = ss::semaphore::time_point::max());
 
+    /// \brief a reader of the segment registered without a future or the
+    /// semaphore of read_lock(). write_lock() waits for the pins to drain
+    class read_pin {
+    public:
+        explicit read_pin(segment& s) noexcept
+          : _s(&s) {
+            ++_s->_read_pins;
+        }
+        read_pin(read_pin&& o) noexcept
+          : _s(std::exchange(o._s, nullptr)) {}
+        read_pin& operator=(read_pin&& o) noexcept {
+            if (this != &o) {
+                release();
+                _s = std::exchange(o._s, nullptr);
+            }
+            return *this;
+        }
+        read_pin(const read_pin&) = delete;
+        read_pin& operator=(const read_pin&) = delete;
+        ~read_pin() noexcept { release(); }
+
+    private:
+        void release() noexcept {
+            if (_s) {
+                std::exchange(_s, nullptr)->unpin_read();
+            }
+        }
+
+        segment* _s;
+    };
+
+    /// \brief pins a segment without an appender, nullopt while the lock
+    /// is held or a destructive operation waits for it, in which case the
+    /// reader waits in read_lock()
+    std::optional<read_pin> try_pin_read();
+
 private:
     void set_close();
     void cache_truncate(model::offset offset);
@@ -154,6 +219,9 @@ private:
     ss::future<> remove_tombstones();
     ss::future<> compaction_index_batch(const model::record_batch&);
     ss::future<> do_compaction_index_batch(const model::record_batch&);
+    ss::future<> enqueue_compaction_index(const model::record_batch&);
+    ss::future<> drain_compaction_index();
+    void unpin_read() noexcept;
 
     struct appender_callbacks : segment_appender::callbacks {
         explicit appender_callbacks(segment* segment)
@@ -176,8 +244,19 @@ private:
     bitflags _flags{bitflags::none};
     std::optional<segment_appender> _appender;
     std::optional<compacted_index_writer> _compaction_index;
+    // keys of the appended batches are indexed in the background, in append
+    // order, see enqueue_compaction_index()
+    ss::future<> _compaction_indexing = ss::now();
+    ss::semaphore _compaction_backlog{compaction_index_backlog};
+    bool _compaction_index_failed{false};
     std::optional<batch_cache_index> _cache;
     ss::rwlock _destructive_ops;
+    // readers pinned outside of the rwlock, see read_pin
+    size_t _read_pins{0};
+    // callers of write_lock() which do not hold it yet
+    size_t _pending_writers{0};
+    // resolved for the writer holding the lock when the last pin is gone
+    std::optional<ss::promise<>> _pins_drained;
     ss::gate _gate;
 
     absl::btree_map<size_t, model::offset> _inflight;
@@ -199,12 +278,16 @@ private:
  * Returns an open segment if the segment was successfully opened.
  * Including a valid index and recovery for the index if one does not
  * exist
+ *
+ * A segment moved to the storage tier reads its data from `cold_data`, its
+ * index stays next to `path`.
  */
 ss::future<ss::lw_shared_ptr<segment>> open_segment(
   const std::filesystem::path& path,
   debug_sanitize_files sanitize_fileops,
   std::optional<batch_cache_index> batch_cache,
-  size_t buf_size = default_segment_readahead_size);
+  size_t buf_size = default_segment_readahead_size,
+  std::optional<std::filesystem::path> cold_data = std::nullopt);
 
 ss::future<ss::lw_shared_ptr<segment>> make_segment(
   const ntp_config& ntpc,
@@ -214,7 +297,50 @@ ss::future<ss::lw_shared_ptr<segment>> make_segment(
   record_version_type version,
   size_t buf_size,
   debug_sanitize_files sanitize_fileops,
-  std::optional<batch_cache_index> batch_cache);
+  std::optional<batch_cache_index> batch_cache,
+  size_t preallocated = 0);
+
+/**
+ * Files of the next segment of a log, opened and allocated ahead of its roll
+ * under staging names in the directory of the log. The staging names are not
+ * segment names, recovery skips the files and the next prepare reuses them.
+ */
+struct prepared_segment_files {
+    static constexpr const char* data_name = "next.staged";
+    static constexpr const char* index_name = "next.staged_index";
+    static constexpr const char* compaction_index_name
+      = "next.staged_compaction_index";
+
+    std::filesystem::path dir;
+    ss::file reader;
+    ss::file writer;
+    ss::file index;
+    std::optional<ss::file> compaction_index;
+    // bytes allocated to the data file
+    size_t preallocated{0};
+
+    ss::future<> close();
+};
+
+/// \brief opens the staging files of the next segment in `dir`, allocating
+/// `falloc_step` to the data file unless `preallocated` bytes are already
+ss::future<prepared_segment_files> prepare_segment_files(
+  std::filesystem::path dir,
+  bool compacted,
+  debug_sanitize_files sanitize_fileops,
+  size_t preallocated,
+  size_t falloc_step = segment_appender::fallocation_step);
+
+/// \brief renames prepared files to the segment at `base_offset`
+ss::future<ss::lw_shared_ptr<segment>> make_segment(
+  const ntp_config& ntpc,
+  model::offset base_offset,
+  model::term_id term,
+  ss::io_priority_class pc,
+  record_version_type version,
+  size_t buf_size,
+  std::optional<batch_cache_index> batch_cache,
+  prepared_segment_files files);
 
 // bitflags operators
 [[gnu::always_inline]] inline segment::bitflags
@@ -274,6 +400,20 @@ inline bool segment::finished_self_compaction() const {
     return (_flags & bitflags::finished_self_compaction)
            == bitflags::finished_self_compaction;
 }
+inline void segment::mark_as_finished_tombstone_expiry() {
+    _flags |= bitflags::finished_tombstone_expiry;
+}
+inline bool segment::finished_tombstone_expiry() const {
+    return (_flags & bitflags::finished_tombstone_expiry)
+           == bitflags::finished_tombstone_expiry;
+}
+inline void segment::mark_as_finished_recompression() {
+    _flags |= bitflags::finished_recompression;
+}
+inline bool segment::finished_recompression() const {
+    return (_flags & bitflags::finished_recompression)
+           == bitflags::finished_recompression;
+}
 inline batch_cache_index& segment::cache() { return *_cache; }
 inline const batch_cache_index& segment::cache() const { return *_cache; }
 inline bool segment::has_cache() const { return _cache != std::nullopt; }
@@ -283,7 +423,9 @@ inline batch_cache_index::read_result segment::cache_get(
   std::optional<model::record_batch_type> type_filter,
   std::optional<model::timestamp> first_ts,
   size_t max_bytes,
-  bool skip_lru_promote) {
+  bool skip_lru_promote,
+  size_t budget,
+  bool strict_budget) {
     if (likely(bool(_cache))) {
         return _cache->read(
           offset,
@@ -291,15 +433,18 @@ inline batch_cache_index::read_result segment::cache_get(
           type_filter,
           first_ts,
           max_bytes,
-          skip_lru_promote);
+          skip_lru_promote,
+          budget,
+          strict_budget);
     }
     return batch_cache_index::read_result{
       .next_batch = offset,
     };
 }
-inline void segment::cache_put(const model::record_batch& batch) {
+inline void segment::cache_put(
+  const model::record_batch& batch, cache_priority priority) {
     if (likely(bool(_cache))) {
-        _cache->put(batch);
+        _cache->put(batch, priority);
     }
 }
 inline ss::future<ss::rwlock::holder>
@@ -308,11 +453,39 @@ segment::read_lock(ss::semaphore::time_point timeout) {
 }
 inline ss::future<ss::rwlock::holder>
 segment::write_lock(ss::semaphore::time_point timeout) {
-    return _destructive_ops.hold_write_lock(timeout);
+    // no new pins from now on, the ones taken before are waited for once the
+    // lock is held
+    ++_pending_writers;
+    return _destructive_ops.hold_write_lock(timeout).then_wrapped(
+      [this](ss::future<ss::rwlock::holder> f) {
+          --_pending_writers;
+          return f.then([this](ss::rwlock::holder h) {
+              if (_read_pins == 0) {
+                  return ss::make_ready_future<ss::rwlock::holder>(
+                    std::move(h));
+              }
+              _pins_drained = ss::promise<>();
+              return _pins_drained->get_future().then(
+                [h = std::move(h)]() mutable { return std::move(h); });
+          });
+      });
+}
+inline std::optional<segment::read_pin> segment::try_pin_read() {
+    if (_appender || _pending_writers > 0 || _destructive_ops.locked()) {
+        return std::nullopt;
+    }
+    return read_pin(*this);
+}
+inline void segment::unpin_read() noexcept {
+    if (--_read_pins == 0 && _pins_drained) {
+        _pins_drained->set_value();
+        _pins_drained = std::nullopt;
+    }
 }
 inline void segment::tombstone() { _flags |= bitflags::mark_tombstone; }
+inline void segment::keep_data_file() { _flags |= bitflags::keep_data_file; }
 inline bool segment::has_outstanding_locks() const {
-    return _destructive_ops.locked();
+    return _destructive_ops.locked() || _read_pins > 0;
 }
 inline bool segment::is_closed() const {
     return (_flags & bitflags::closed) == bitflags::closed;
@@ -12,6 +12,7 @@
 #include "config/configuration.h"
 #include "likely.h"
 #include "storage/chunk_cache.h"
+#include "storage/flush_coordinator.h"
 #include "storage/logger.h"
 #include "vassert.h"
 #include "vlog.h"
@@ -20,9 +21,14 @@
 #include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/semaphore.hh>
+#include <seastar/core/temporary_buffer.hh>
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
 namespace storage {
 
 [[gnu::cold]] static ss::future<>
@@ -34,7 +40,9 @@ size_missmatch_error(const char* ctx, size_t expected, size_t got) {
 segment_appender::segment_appender(ss::file f, options opts)
   : _out(std::move(f))
   , _opts(opts)
+  , _fallocation_offset(opts.preallocated)
   , _concurrent_flushes(ss::semaphore::max_counter())
+  , _window_start(ss::lowres_clock::now())
   , _inactive_timer([this] { handle_inactive_timer(); }) {
     const auto alignment = _out.disk_write_dma_alignment();
     vassert(
@@ -50,9 +58,16 @@ segment_appender::~segment_appender() noexcept {
       _bytes_flush_pending == 0 && _closed,
       "Must flush & close before deleting {}",
       *this);
+    release_tail();
     if (_head) {
-        internal::chunks().add(std::exchange(_head, nullptr));
+        recycle(std::exchange(_head, nullptr));
+    }
+    reclaim_parked();
+    // chunks still referenced by tail reads are freed by them
+    for (auto& c : _parked) {
+        internal::chunks().forget(c);
     }
+    internal::chunks().update_write_rate(_write_rate, 0);
 }
 
 segment_appender::segment_appender(segment_appender&& o) noexcept
@@ -64,8 +79,17 @@ segment_appender::segment_appender(segment_appender&& o) noexcept
   , _bytes_flush_pending(o._bytes_flush_pending)
   , _concurrent_flushes(std::move(o._concurrent_flushes))
   , _head(std::move(o._head))
+  , _write_behind(std::move(o._write_behind))
+  , _write_behind_chunks(o._write_behind_chunks)
+  , _write_rate(std::exchange(o._write_rate, 0))
+  , _window_bytes(o._window_bytes)
+  , _window_start(o._window_start)
   , _inflight(std::move(o._inflight))
   , _callbacks(std::exchange(o._callbacks, nullptr))
+  , _stable_offset(o._stable_offset)
+  , _direct_write_bytes(o._direct_write_bytes)
+  , _tail(std::move(o._tail))
+  , _parked(std::move(o._parked))
   , _inactive_timer([this] { handle_inactive_timer(); })
   , _previously_inactive(o._previously_inactive) {
     o._closed = true;
@@ -77,6 +101,11 @@ ss::future<> segment_appender::append(bytes_view s) {
 }
 
 ss::future<> segment_appender::append(const iobuf& io) {
+    if (io.size_bytes() >= direct_write_min_bytes) {
+        // see append(const char*, size_t)
+        _inactive_timer.cancel();
+        return append_direct(io).then([this] { arm_inactive_timer(); });
+    }
     return ss::do_for_each(
       io.begin(), io.end(), [this](const iobuf::fragment& f) {
           return append(f.get(), f.size());
@@ -88,14 +117,134 @@ ss::future<> segment_appender::append(const char* buf, const size_t n) {
     // cancelled because it firing may dispatch a background write, which as
     // currently formulated, is not safe to interlave with append.
     _inactive_timer.cancel();
-    return do_append(buf, n).then([this] {
-        if (_head && _head->bytes_pending()) {
-            _inactive_timer.arm(
-              config::shard_local_cfg().segment_appender_flush_timeout_ms());
+    return do_append(buf, n).then([this] { arm_inactive_timer(); });
+}
+
+void segment_appender::arm_inactive_timer() {
+    if (_head && _head->bytes_pending()) {
+        _inactive_timer.arm(
+          config::shard_local_cfg().segment_appender_flush_timeout_ms());
+    }
+}
+
+/// fragment of `io` holding the byte at `pos`, and the offset in it
+static std::pair<const iobuf::fragment*, size_t>
+locate(const iobuf& io, size_t pos) {
+    for (const auto& f : io) {
+        if (pos < f.size()) {
+            return {&f, pos};
         }
+        pos -= f.size();
+    }
+    return {nullptr, 0};
+}
+
+ss::future<>
+segment_appender::append_range(const iobuf& io, size_t pos, size_t len) {
+    return ss::do_with(pos, len, [this, &io](size_t& skip, size_t& left) {
+        return ss::do_for_each(
+          io.begin(),
+          io.end(),
+          [this, &skip, &left](const iobuf::fragment& f) {
+              if (skip >= f.size()) {
+                  skip -= f.size();
+                  return ss::now();
+              }
+              const size_t n = std::min(f.size() - skip, left);
+              const char* src = f.get() + std::exchange(skip, 0);
+              left -= n;
+              return n ? do_append(src, n) : ss::now();
+          });
     });
 }
 
+size_t segment_appender::direct_write_pad() const {
+    // the head is filled up, a full chunk is never handed back as the head
+    // once written, see dispatch_background_head_write()
+    if (_head) {
+        return _head->space_left();
+    }
+    const size_t offset = file_byte_offset() % internal::chunk_cache::alignment;
+    return offset == 0 ? 0 : chunk_size - offset;
+}
+
+size_t segment_appender::direct_write_size(const iobuf& io, size_t pos) const {
+    auto [f, offset] = locate(io, pos);
+    if (!f) {
+        return 0;
+    }
+    const char* src = f->get() + offset;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (reinterpret_cast<uintptr_t>(src) % _out.memory_dma_alignment() != 0) {
+        return 0;
+    }
+    // whole pages, the chunk taking the rest of the bytes is not hydrated
+    return ss::align_down<size_t>(
+      f->size() - offset, internal::chunk_cache::alignment);
+}
+
+/*
+ * large appends write the fragments of the iobuf to the file rather than
+ * copying them into chunks. the head is filled up and written first, then
+ * every fragment that starts page aligned both in memory and in the file is
+ * written as is, the bytes left over go through the chunks. in practice the
+ * fragments line up with the file when the bytes came from aligned buffers,
+ * e.g. those of dma reads, otherwise this is the regular copy.
+ */
+ss::future<> segment_appender::append_direct(const iobuf& io) {
+    // see do_append()
+    if (_previously_inactive) {
+        _previously_inactive = false;
+        return ss::get_units(_concurrent_flushes, ss::semaphore::max_counter())
+          .then([this, &io](ss::semaphore_units<>) {
+              return append_direct(io);
+          });
+    }
+    const size_t pad = direct_write_pad();
+    if (pad >= io.size_bytes() || direct_write_size(io, pad) == 0) {
+        return append_range(io, 0, io.size_bytes());
+    }
+    return append_range(io, 0, pad).then([this, &io, pad] {
+        return ss::do_with(pad, [this, &io](size_t& pos) {
+            return ss::repeat([this, &io, &pos] {
+                       return append_direct_once(io, pos);
+                   })
+              .then([this, &io, &pos] {
+                  return append_range(io, pos, io.size_bytes() - pos);
+              });
+        });
+    });
+}
+
+ss::future<ss::stop_iteration>
+segment_appender::append_direct_once(const iobuf& io, size_t& pos) {
+    const size_t n = direct_write_size(io, pos);
+    if (n == 0) {
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::yes);
+    }
+    vassert(
+      !_head && file_byte_offset() % internal::chunk_cache::alignment == 0,
+      "direct writes must start on a page of their own: {}",
+      *this);
+    return ss::do_until(
+             [this, n] {
+                 return next_committed_offset() + n <= _fallocation_offset;
+             },
+             [this] { return do_next_adaptive_fallocation(); })
+      .then([this] { return ss::get_units(_write_behind, 1); })
+      .then([this, &io, &pos, n](ss::semaphore_units<>) {
+          // do not hold the units, as for the chunks
+          auto [f, offset] = locate(io, pos);
+          // the share only keeps the bytes alive until they are written
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+          dispatch_background_direct_write(
+            const_cast<iobuf::fragment*>(f)->share(offset, n));
+          pos += n;
+          return ss::stop_iteration::no;
+      });
+}
+
 ss::future<> segment_appender::do_append(const char* buf, const size_t n) {
     vassert(!_closed, "append() on closed segment: {}", *this);
 
@@ -150,7 +299,12 @@ ss::future<> segment_appender::do_append(const char* buf, const size_t n) {
         return ss::make_ready_future<>();
     }
 
-    return ss::get_units(_concurrent_flushes, 1)
+    // wait for the in-flight writes to fit the write-behind budget before
+    // taking another chunk. as with the flush units, the budget is not held
+    return ss::get_units(_write_behind, 1)
+      .then([this](ss::semaphore_units<>) {
+          return ss::get_units(_concurrent_flushes, 1);
+      })
       .then([this, next_buf = buf + written, next_sz = n - written](
               ss::semaphore_units<>) {
           // do not hold the units!
@@ -163,9 +317,42 @@ ss::future<> segment_appender::do_append(const char* buf, const size_t n) {
       });
 }
 
+void segment_appender::account_write(size_t bytes) {
+    _window_bytes += bytes;
+    const auto now = ss::lowres_clock::now();
+    const auto elapsed = now - _window_start;
+    if (elapsed < write_rate_window) {
+        return;
+    }
+    const double secs = std::chrono::duration<double>(elapsed).count();
+    const double rate = static_cast<double>(_window_bytes) / secs;
+    // average with the previous rate to smooth out bursts
+    set_write_rate((_write_rate + rate) / 2);
+    _window_bytes = 0;
+    _window_start = now;
+}
+
+void segment_appender::set_write_rate(double bytes_per_sec) {
+    internal::chunks().update_write_rate(_write_rate, bytes_per_sec);
+    _write_rate = bytes_per_sec;
+    const auto budget = internal::chunks().write_behind_chunks(
+      _write_rate, _opts.number_of_chunks);
+    if (budget > _write_behind_chunks) {
+        _write_behind.signal(budget - _write_behind_chunks);
+    } else if (budget < _write_behind_chunks) {
+        _write_behind.consume(_write_behind_chunks - budget);
+    }
+    _write_behind_chunks = budget;
+}
+
 void segment_appender::handle_inactive_timer() {
     _previously_inactive = true;
 
+    // an inactive appender gives its write-behind budget back to the pool
+    set_write_rate(0);
+    _window_bytes = 0;
+    _window_start = ss::lowres_clock::now();
+
     if (_head && _head->bytes_pending()) {
         /*
          * this is the why the timer was originally set upon returning from
@@ -185,8 +372,9 @@ void segment_appender::handle_inactive_timer() {
      * completes. it may also return the chunk to the cache if it empty.
      */
     if (_concurrent_flushes.try_wait(ss::semaphore::max_counter())) {
+        release_tail();
         if (_head && !_head->bytes_pending()) {
-            internal::chunks().add(std::exchange(_head, nullptr));
+            recycle(std::exchange(_head, nullptr));
             vlog(
               stlog.debug, "reclaiming inactive chunk from appender {}", *this);
         }
@@ -266,6 +454,12 @@ ss::future<> segment_appender::truncate(size_t n) {
     return flush().then([this, n] { return do_truncation(n); }).then([this, n] {
         _committed_offset = n;
         _fallocation_offset = n;
+        _stable_offset = n;
+        release_tail();
+        if (_head && _head.use_count() > 1) {
+            // a tail read still references the chunk
+            recycle(std::exchange(_head, nullptr));
+        }
         auto f = ss::now();
         if (_head) {
             // NOTE: Important to reset chunks for offset accounting.  reset any
@@ -287,7 +481,10 @@ ss::future<> segment_appender::close() {
     vassert(!_closed, "close() on closed segment: {}", *this);
     _closed = true;
     return flush()
-      .then([this] { return do_truncation(_committed_offset); })
+      .then([this] {
+          release_tail();
+          return do_truncation(_committed_offset);
+      })
       .then([this] { return _out.close(); });
 }
 
@@ -350,6 +547,7 @@ void segment_appender::maybe_advance_stable_offset(
             break;
         }
 
+        _stable_offset = committed;
         if (_callbacks) {
             _callbacks->committed_physical_offset(committed);
         }
@@ -375,7 +573,12 @@ void segment_appender::dispatch_background_head_write() {
       "Writes can be at most a full segment. Expected {}, attempted write: {}",
       chunk::chunk_size,
       expected);
+    // file offset of the first byte of the chunk
+    track_tail(
+      h,
+      start_offset - ss::align_down<size_t>(h->flushed_pos(), h->alignment()));
     // accounting synchronously
+    account_write(h->bytes_pending());
     _committed_offset += h->bytes_pending();
     _bytes_flush_pending -= h->bytes_pending();
     // background write
@@ -383,24 +586,56 @@ void segment_appender::dispatch_background_head_write() {
     _inflight.emplace_back(
       ss::make_lw_shared<inflight_write>(_committed_offset));
     auto w = _inflight.back();
+    _write_behind.consume(1);
     (void)ss::with_semaphore(
       _concurrent_flushes,
       1,
       [h, w, this, start_offset, expected, src] {
           return _out.dma_write(start_offset, src, expected, _opts.priority)
             .then([this, h, w, expected](size_t got) {
-                if (h->is_full()) {
-                    h->reset();
-                }
-                if (h->is_empty()) {
-                    internal::chunks().add(h);
-                } else {
+                _write_behind.signal(1);
+                // a full chunk is held by the tail until trimmed
+                if (!h->is_full()) {
                     _head = h;
                 }
                 if (unlikely(expected != got)) {
                     return size_missmatch_error("chunk::write", expected, got);
                 }
                 maybe_advance_stable_offset(w);
+                trim_tail();
+                return ss::make_ready_future<>();
+            });
+      })
+      .handle_exception([this](std::exception_ptr e) {
+          vassert(false, "Could not dma_write: {} - {}", e, *this);
+      });
+}
+
+void segment_appender::dispatch_background_direct_write(
+  ss::temporary_buffer<char> buf) {
+    const size_t start_offset = _committed_offset;
+    // the bytes are not held by the tail, reads past them go to the file
+    account_write(buf.size());
+    _direct_write_bytes += buf.size();
+    _committed_offset += buf.size();
+    _inflight.emplace_back(
+      ss::make_lw_shared<inflight_write>(_committed_offset));
+    auto w = _inflight.back();
+    _write_behind.consume(1);
+    (void)ss::with_semaphore(
+      _concurrent_flushes,
+      1,
+      [this, w, start_offset, buf = std::move(buf)]() mutable {
+          const char* src = buf.get();
+          const size_t expected = buf.size();
+          return _out.dma_write(start_offset, src, expected, _opts.priority)
+            .then([this, w, expected, buf = std::move(buf)](size_t got) {
+                _write_behind.signal(1);
+                if (unlikely(expected != got)) {
+                    return size_missmatch_error("direct::write", expected, got);
+                }
+                maybe_advance_stable_offset(w);
+                trim_tail();
                 return ss::make_ready_future<>();
             });
       })
@@ -409,15 +644,105 @@ void segment_appender::dispatch_background_head_write() {
       });
 }
 
+void segment_appender::track_tail(
+  const ss::lw_shared_ptr<chunk>& c, size_t base) {
+    if (_tail.empty() || _tail.back().ptr != c) {
+        _tail.push_back(tail_chunk{.base = base, .ptr = c});
+    }
+}
+
+void segment_appender::trim_tail() {
+    // give the chunks back early when other appenders are waiting for them
+    const size_t keep = internal::chunks().has_waiters() ? 1 : tail_chunks;
+    while (_tail.size() > keep) {
+        auto& t = _tail.front();
+        if (t.ptr == _head || t.end() > _stable_offset) {
+            // still being written
+            break;
+        }
+        auto c = std::move(t.ptr);
+        _tail.pop_front();
+        recycle(std::move(c));
+    }
+    reclaim_parked();
+}
+
+void segment_appender::release_tail() {
+    while (!_tail.empty()) {
+        auto c = std::move(_tail.front().ptr);
+        _tail.pop_front();
+        if (c != _head) {
+            recycle(std::move(c));
+        }
+    }
+    reclaim_parked();
+}
+
+void segment_appender::recycle(ss::lw_shared_ptr<chunk> c) {
+    if (c.use_count() == 1) {
+        internal::chunks().add(c);
+    } else {
+        _parked.push_back(std::move(c));
+    }
+}
+
+void segment_appender::reclaim_parked() {
+    for (size_t i = 0; i < _parked.size();) {
+        if (_parked[i].use_count() == 1) {
+            internal::chunks().add(_parked[i]);
+            std::swap(_parked[i], _parked.back());
+            _parked.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+std::optional<iobuf>
+segment_appender::read_tail(size_t pos, size_t end) const {
+    if (_tail.empty() || pos >= end || pos < _tail.front().base) {
+        return std::nullopt;
+    }
+    iobuf ret;
+    for (const auto& t : _tail) {
+        if (pos >= end) {
+            break;
+        }
+        if (t.base > pos) {
+            return std::nullopt;
+        }
+        const auto last = std::min(end, t.end());
+        if (last <= pos) {
+            continue;
+        }
+        // the bytes below the stable offset are not written to again
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        auto* src = const_cast<char*>(t.ptr->data()) + (pos - t.base);
+        ret.append_take_ownership(new iobuf::fragment(
+          ss::temporary_buffer<char>(
+            src, last - pos, ss::make_object_deleter(t.ptr)),
+          iobuf::fragment::full{}));
+        pos = last;
+    }
+    if (pos < end) {
+        return std::nullopt;
+    }
+    return ret;
+}
+
 ss::future<> segment_appender::flush() {
     _inactive_timer.cancel();
     if (_head && _head->bytes_pending()) {
         dispatch_background_head_write();
     }
-    return ss::with_semaphore(
-             _concurrent_flushes,
-             ss::semaphore::max_counter(),
-             [this]() mutable { return _out.flush(); })
+    return ss::get_units(_concurrent_flushes, ss::semaphore::max_counter())
+      .then([this](ss::semaphore_units<> u) {
+          // every write dispatched before the flush has completed. writes
+          // dispatched from now on need not wait for the sync, which is
+          // batched with the syncs of the other appenders on this shard
+          u.return_all();
+          return internal::flushes().flush(this, _out);
+      })
       .handle_exception([this](std::exception_ptr e) {
           vassert(false, "Could not flush: {} - {}", e, *this);
       });
@@ -426,6 +751,7 @@ ss::future<> segment_appender::flush() {
 std::ostream& operator<<(std::ostream& o, const segment_appender& a) {
     // NOTE: intrusivelist.size() == O(N) but often N is very small, ~8
     return o << "{no_of_chunks:" << a._opts.number_of_chunks
+             << ", write_behind_chunks:" << a._write_behind_chunks
              << ", closed:" << a._closed
              << ", fallocation_offset:" << a._fallocation_offset
              << ", committed_offset:" << a._committed_offset
@@ -21,9 +21,14 @@
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/iostream.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sstring.hh>
 
+#include <chrono>
 #include <iostream>
+#include <optional>
+#include <vector>
 
 namespace storage {
 
@@ -40,6 +45,12 @@ public:
                                                      / chunk::chunk_size;
     static constexpr const size_t chunk_size = chunk::chunk_size;
     static constexpr const size_t fallocation_step = 32_MiB;
+    static constexpr const auto write_rate_window = std::chrono::milliseconds(
+      250);
+    // written chunks kept in memory to serve tail reads, including the head
+    static constexpr const size_t tail_chunks = 2;
+    // smallest iobuf considered for writing its own fragments to the file
+    static constexpr const size_t direct_write_min_bytes = 4 * chunk_size;
 
     struct options {
         options(ss::io_priority_class p, size_t chunks_no)
@@ -51,8 +62,11 @@ public:
           , falloc_step(step) {}
 
         ss::io_priority_class priority;
+        // upper bound of the write-behind budget
         size_t number_of_chunks{chunks_no_buffer};
         size_t falloc_step{fallocation_step};
+        // bytes allocated to the file already, e.g. a recycled file
+        size_t preallocated{0};
     };
 
     segment_appender(ss::file f, options opts);
@@ -80,12 +94,38 @@ public:
 
     void set_callbacks(callbacks* callbacks) { _callbacks = callbacks; }
 
+    /// number of chunk writes this appender may have in flight
+    size_t write_behind_chunks() const { return _write_behind_chunks; }
+
+    /// bytes written from the fragments of the appended iobufs, not copied
+    size_t direct_write_bytes() const { return _direct_write_bytes; }
+
+    /// \brief the bytes [pos, end) of the file, if the appender still holds
+    /// them in its chunks. The fragments share the memory of the chunks,
+    /// which are not reused while referenced. `end` must not be past the
+    /// bytes written to the file, i.e. the stable offset.
+    std::optional<iobuf> read_tail(size_t pos, size_t end) const;
+
 private:
     void dispatch_background_head_write();
     ss::future<> do_next_adaptive_fallocation();
     ss::future<> hydrate_last_half_page();
     ss::future<> do_truncation(size_t);
     ss::future<> do_append(const char* buf, const size_t n);
+    ss::future<> append_range(const iobuf&, size_t pos, size_t len);
+    ss::future<> append_direct(const iobuf&);
+    ss::future<ss::stop_iteration> append_direct_once(const iobuf&, size_t&);
+    size_t direct_write_pad() const;
+    size_t direct_write_size(const iobuf&, size_t pos) const;
+    void dispatch_background_direct_write(ss::temporary_buffer<char>);
+    void arm_inactive_timer();
+    void account_write(size_t bytes);
+    void set_write_rate(double bytes_per_sec);
+    void track_tail(const ss::lw_shared_ptr<chunk>&, size_t base);
+    void trim_tail();
+    void release_tail();
+    void recycle(ss::lw_shared_ptr<chunk>);
+    void reclaim_parked();
 
     /*
      * committed offset isn't updated until the background write is dispatched.
@@ -110,6 +150,20 @@ private:
     ss::semaphore _concurrent_flushes;
     ss::lw_shared_ptr<chunk> _head;
 
+    /*
+     * write-behind budget. the appender is given a share of the chunk cache
+     * pool proportional to its recent write rate, re-evaluated once per rate
+     * window: busy appenders get deeper pipelines while idle ones drop to a
+     * single chunk in flight. each background write consumes a unit, so the
+     * semaphore count goes negative when the budget shrinks below the number
+     * of writes already in flight.
+     */
+    ss::semaphore _write_behind{1};
+    size_t _write_behind_chunks{1};
+    double _write_rate{0};
+    size_t _window_bytes{0};
+    ss::lowres_clock::time_point _window_start;
+
     struct inflight_write {
         bool done;
         size_t offset;
@@ -121,6 +175,25 @@ private:
 
     ss::chunked_fifo<ss::lw_shared_ptr<inflight_write>> _inflight;
     callbacks* _callbacks = nullptr;
+    // bytes written to the file, all smaller offsets included
+    size_t _stable_offset{0};
+    size_t _direct_write_bytes{0};
+
+    /*
+     * tail of the file held in memory, oldest first. a chunk is tracked once
+     * its first write is dispatched along with the file offset of its first
+     * byte. tail reads share the chunk memory, so a chunk still referenced by
+     * a reader when it leaves the tail is parked until it is released rather
+     * than being handed back to the chunk cache for reuse.
+     */
+    struct tail_chunk {
+        size_t base;
+        ss::lw_shared_ptr<chunk> ptr;
+
+        size_t end() const { return base + ptr->flushed_pos(); }
+    };
+    ss::chunked_fifo<tail_chunk> _tail;
+    std::vector<ss::lw_shared_ptr<chunk>> _parked;
     void maybe_advance_stable_offset(const ss::lw_shared_ptr<inflight_write>&);
 
     ss::timer<ss::lowres_clock> _inactive_timer;
@@ -11,6 +11,7 @@
 
 #pragma once
 #include "seastarx.h"
+#include "storage/hugepage_arena.h"
 #include "units.h"
 #include "utils/intrusive_list_helpers.h"
 
@@ -18,6 +19,7 @@
 #include <seastar/core/aligned_buffer.hh>
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <ostream>
 
@@ -28,12 +30,22 @@ public:
 
     explicit segment_appender_chunk(size_t alignment)
       : _alignment(alignment)
-      , _buf(ss::allocate_aligned_buffer<char>(chunk_size, alignment)) {
+      , _buf(
+          ss::allocate_aligned_buffer<char>(chunk_size, alignment).release()) {
         // zero-out the buffer in case the alloctor gaves us a recycled buffer
         // that was from a valid previous segment.
         reset();
     }
 
+    /// \brief a chunk over a slot of the arena, which is returned to it. The
+    /// slots of the arena are aligned to their size, which covers alignment
+    segment_appender_chunk(
+      size_t alignment, internal::hugepage_arena& arena, char* slot)
+      : _alignment(alignment)
+      , _buf(slot, buffer_deleter{.arena = &arena}) {
+        reset();
+    }
+
     segment_appender_chunk(const segment_appender_chunk&) = delete;
     segment_appender_chunk& operator=(const segment_appender_chunk&) = delete;
     segment_appender_chunk(segment_appender_chunk&&) noexcept = delete;
@@ -96,10 +108,21 @@ public:
     intrusive_list_hook hook;
 
 private:
+    struct buffer_deleter {
+        internal::hugepage_arena* arena{nullptr};
+        void operator()(char* p) const noexcept {
+            if (arena) {
+                arena->deallocate(p, chunk_size);
+            } else {
+                ::free(p); // NOLINT
+            }
+        }
+    };
+
     size_t _alignment{0};
     size_t _pos{0};
     size_t _flushed_pos{0};
-    std::unique_ptr<char[], ss::free_deleter> _buf;
+    std::unique_ptr<char[], buffer_deleter> _buf;
     friend std::ostream&
     operator<<(std::ostream&, const segment_appender_chunk&);
 };
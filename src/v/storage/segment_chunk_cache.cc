@@ -0,0 +1,263 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/segment_chunk_cache.h"
+
+#include "storage/logger.h"
+#include "utils/directory_walker.h"
+#include "vlog.h"
+
+#include <seastar/core/align.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/smp.hh>
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <vector>
+
+namespace storage::internal {
+
+static constexpr size_t staging_alignment = 4096;
+
+ss::future<ss::temporary_buffer<char>> read_chunk(
+  ss::file f,
+  size_t file_size,
+  size_t chunk,
+  const ss::io_priority_class& pc) {
+    const size_t pos = chunk * segment_chunk_cache::chunk_size;
+    if (pos >= file_size) {
+        return ss::make_ready_future<ss::temporary_buffer<char>>();
+    }
+    const size_t len = std::min(
+      segment_chunk_cache::chunk_size, file_size - pos);
+    return f.dma_read_bulk<char>(pos, len, pc);
+}
+
+void segment_chunk_cache::configure(config cfg) {
+    // chunks of a previous configuration are left to the wipe of the new
+    // staging directory
+    _lru.clear();
+    _entries.clear();
+    _stats.bytes = 0;
+    _prepared.reset();
+    _cfg = std::move(cfg);
+}
+
+ss::future<ss::temporary_buffer<char>> segment_chunk_cache::get(
+  segment_id id,
+  ss::file f,
+  size_t file_size,
+  size_t chunk,
+  const ss::io_priority_class& pc) {
+    if (!enabled()) {
+        ++_stats.misses;
+        return read_chunk(std::move(f), file_size, chunk, pc);
+    }
+    const key k{.segment = id, .chunk = chunk};
+    entry_ptr e;
+    if (auto it = _entries.find(k); it != _entries.end()) {
+        ++_stats.hits;
+        e = it->second;
+        if (e->staged) {
+            _lru.erase(_lru.iterator_to(*e));
+            _lru.push_back(*e);
+        }
+    } else {
+        ++_stats.misses;
+        e = load(f, file_size, k, pc);
+        prefetch(f, file_size, k, pc);
+    }
+    return read_entry(std::move(e), std::move(f), file_size, pc);
+}
+
+ss::future<ss::temporary_buffer<char>> segment_chunk_cache::read_entry(
+  entry_ptr e, ss::file f, size_t file_size, const ss::io_priority_class& pc) {
+    const size_t chunk = e->k.chunk;
+    return e->loaded.get_shared_future()
+      .then([this, e, f, file_size, pc]() mutable {
+          if (!e->data.empty()) {
+              return ss::make_ready_future<ss::temporary_buffer<char>>(
+                e->data.share());
+          }
+          // the chunk was dropped before it could be staged
+          if (!e->staged) {
+              return read_chunk(std::move(f), file_size, e->k.chunk, pc);
+          }
+          return ss::open_file_dma(staged_path(e->k), ss::open_flags::ro)
+            .then([e, pc](ss::file staged) {
+                return staged.dma_read_bulk<char>(0, e->bytes, pc)
+                  .finally([staged]() mutable { return staged.close(); });
+            });
+      })
+      .handle_exception(
+        [f, file_size, chunk, pc](const std::exception_ptr&) mutable {
+            // the tier has the chunk whatever happened to the copy
+            return read_chunk(std::move(f), file_size, chunk, pc);
+        });
+}
+
+segment_chunk_cache::entry_ptr segment_chunk_cache::load(
+  ss::file f, size_t file_size, key k, ss::io_priority_class pc) {
+    auto e = ss::make_lw_shared<entry>(k);
+    _entries.emplace(k, e);
+    (void)ss::with_gate(*_gate, [this, e, f, file_size, pc]() mutable {
+        return read_chunk(std::move(f), file_size, e->k.chunk, pc)
+          .then([this, e, pc](ss::temporary_buffer<char> buf) {
+              e->bytes = buf.size();
+              e->data = std::move(buf);
+              e->loaded.set_value();
+              return stage(e, pc);
+          });
+    }).handle_exception([this, e](const std::exception_ptr& ex) {
+        // staging does not fail, the tier read did
+        vlog(stlog.debug, "Error reading cold chunk {} - {}", e->k.chunk, ex);
+        e->loaded.set_exception(ex);
+        erase(e);
+    });
+    return e;
+}
+
+void segment_chunk_cache::prefetch(
+  ss::file f, size_t file_size, key k, ss::io_priority_class pc) {
+    for (size_t i = 1; i <= _cfg.prefetch_chunks; ++i) {
+        const key next{.segment = k.segment, .chunk = k.chunk + i};
+        if (next.chunk * chunk_size >= file_size) {
+            break;
+        }
+        if (_entries.contains(next)) {
+            continue;
+        }
+        ++_stats.prefetches;
+        load(f, file_size, next, pc);
+    }
+}
+
+ss::future<>
+segment_chunk_cache::stage(entry_ptr e, ss::io_priority_class pc) {
+    return prepare()
+      .then([this, e, pc] {
+          const size_t size = ss::align_up(e->bytes, staging_alignment);
+          auto buf = ss::temporary_buffer<char>::aligned(
+            staging_alignment, size);
+          std::memcpy(buf.get_write(), e->data.get(), e->bytes);
+          std::memset(buf.get_write() + e->bytes, 0, size - e->bytes);
+          return ss::open_file_dma(
+                   staged_path(e->k),
+                   ss::open_flags::create | ss::open_flags::truncate
+                     | ss::open_flags::wo)
+            .then([buf = std::move(buf), pc](ss::file f) mutable {
+                auto* data = buf.get();
+                const auto size = buf.size();
+                return f.dma_write(0, data, size, pc)
+                  .discard_result()
+                  .finally([f]() mutable { return f.close(); })
+                  .finally([buf = std::move(buf)] {});
+            });
+      })
+      .then([this, e] {
+          e->data = {};
+          auto it = _entries.find(e->k);
+          if (it == _entries.end() || it->second != e) {
+              // invalidated while it was written
+              remove_staged(e->k);
+              return;
+          }
+          e->staged = true;
+          _stats.bytes += e->bytes;
+          _lru.push_back(*e);
+          evict();
+      })
+      .handle_exception([this, e](const std::exception_ptr& ex) {
+          vlog(stlog.debug, "Error staging cold chunk {} - {}", e->k.chunk, ex);
+          e->data = {};
+          erase(e);
+      });
+}
+
+void segment_chunk_cache::erase(const entry_ptr& e) {
+    auto it = _entries.find(e->k);
+    if (it == _entries.end() || it->second != e) {
+        return;
+    }
+    if (e->hook.is_linked()) {
+        _lru.erase(_lru.iterator_to(*e));
+    }
+    if (e->staged) {
+        e->staged = false;
+        _stats.bytes -= e->bytes;
+        remove_staged(e->k);
+    }
+    _entries.erase(it);
+}
+
+void segment_chunk_cache::evict() {
+    while (_stats.bytes > _cfg.max_bytes && !_lru.empty()) {
+        auto victim = _entries.find(_lru.front().k)->second;
+        ++_stats.evictions;
+        erase(victim);
+    }
+}
+
+void segment_chunk_cache::invalidate(segment_id id) {
+    std::vector<entry_ptr> victims;
+    for (auto& [k, e] : _entries) {
+        if (k.segment == id) {
+            victims.push_back(e);
+        }
+    }
+    for (auto& e : victims) {
+        erase(e);
+    }
+}
+
+void segment_chunk_cache::remove_staged(const key& k) {
+    (void)ss::with_gate(*_gate, [path = staged_path(k)] {
+        return ss::remove_file(path).handle_exception(
+          [path](const std::exception_ptr& e) {
+              vlog(stlog.debug, "Error removing staged chunk {} - {}", path, e);
+          });
+    });
+}
+
+ss::sstring segment_chunk_cache::staged_path(const key& k) const {
+    return fmt::format(
+      "{}/{}/{}-{}", *_cfg.directory, ss::this_shard_id(), k.segment, k.chunk);
+}
+
+ss::future<> segment_chunk_cache::prepare() {
+    if (!_prepared) {
+        auto dir = fmt::format("{}/{}", *_cfg.directory, ss::this_shard_id());
+        _prepared.emplace(
+          ss::recursive_touch_directory(dir)
+            .then([dir] {
+                return directory_walker::walk(
+                  dir, [dir](ss::directory_entry de) {
+                      return ss::remove_file(
+                        fmt::format("{}/{}", dir, de.name));
+                  });
+            })
+            .handle_exception([dir](const std::exception_ptr& e) {
+                vlog(
+                  stlog.warn,
+                  "Error emptying cold chunk staging directory {} - {}",
+                  dir,
+                  e);
+            }));
+    }
+    return _prepared->get_future();
+}
+
+ss::future<> segment_chunk_cache::stop() {
+    auto g = std::exchange(_gate, ss::make_lw_shared<ss::gate>());
+    return g->close().finally([g] {});
+}
+
+} // namespace storage::internal
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "units.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/io_queue.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/core/temporary_buffer.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include <boost/intrusive/list.hpp>
+
+#include <cstdint>
+#include <optional>
+
+namespace storage::internal {
+
+/**
+ * Local staging cache of the segments moved to the storage tier.
+ *
+ * Cold segments are read in fixed size chunks. A chunk read from the tier is
+ * written to a file of the staging directory on local disk and later reads of
+ * the chunk are served from there. The staged chunks of a shard are bounded
+ * by `max_bytes`, the least recently read ones are dropped first. A miss also
+ * reads the next `prefetch_chunks` chunks of the segment in the background so
+ * a consumer catching up on a cold segment mostly reads local chunks.
+ * Concurrent reads of a chunk share a single read of the tier.
+ *
+ * Segments are identified by an id handed out when their reader is opened, a
+ * reopened file never sees the chunks staged for a previous one. The staging
+ * directory of the shard is emptied the first time it is used.
+ */
+class segment_chunk_cache {
+public:
+    static constexpr size_t chunk_size = 1_MiB;
+
+    using segment_id = uint64_t;
+
+    struct config {
+        // none reads every chunk from the tier
+        std::optional<ss::sstring> directory;
+        size_t max_bytes{0};
+        size_t prefetch_chunks{2};
+    };
+
+    struct stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t prefetches{0};
+        uint64_t evictions{0};
+        // staged on local disk
+        size_t bytes{0};
+    };
+
+    segment_chunk_cache() noexcept = default;
+    segment_chunk_cache(const segment_chunk_cache&) = delete;
+    segment_chunk_cache& operator=(const segment_chunk_cache&) = delete;
+    segment_chunk_cache(segment_chunk_cache&&) = delete;
+    segment_chunk_cache& operator=(segment_chunk_cache&&) = delete;
+    ~segment_chunk_cache() noexcept = default;
+
+    void configure(config);
+
+    segment_id next_segment_id() { return ++_last_id; }
+
+    /// reads `chunk` of a cold segment of `file_size` bytes
+    ss::future<ss::temporary_buffer<char>> get(
+      segment_id,
+      ss::file,
+      size_t file_size,
+      size_t chunk,
+      const ss::io_priority_class&);
+
+    /// drops the chunks of a segment which is closed
+    void invalidate(segment_id);
+
+    /// waits for the background reads and removals
+    ss::future<> stop();
+
+    const stats& get_stats() const { return _stats; }
+
+private:
+    struct key {
+        segment_id segment;
+        size_t chunk;
+
+        bool operator==(const key& o) const {
+            return segment == o.segment && chunk == o.chunk;
+        }
+
+        template<typename H>
+        friend H AbslHashValue(H h, const key& k) {
+            return H::combine(std::move(h), k.segment, k.chunk);
+        }
+    };
+
+    /*
+     * A chunk is loading until the tier read completes, its data is then
+     * kept in memory until it is written to the staging directory, which
+     * makes it staged.
+     */
+    struct entry {
+        explicit entry(key k) noexcept
+          : k(k) {}
+
+        key k;
+        size_t bytes{0};
+        bool staged{false};
+        ss::temporary_buffer<char> data;
+        ss::shared_promise<> loaded;
+        boost::intrusive::list_member_hook<> hook;
+    };
+    using entry_ptr = ss::lw_shared_ptr<entry>;
+    using lru_t = boost::intrusive::list<
+      entry,
+      boost::intrusive::
+        member_hook<entry, boost::intrusive::list_member_hook<>, &entry::hook>>;
+
+    bool enabled() const { return _cfg.directory && _cfg.max_bytes > 0; }
+    ss::sstring staged_path(const key&) const;
+    ss::future<ss::temporary_buffer<char>> read_entry(
+      entry_ptr, ss::file, size_t file_size, const ss::io_priority_class&);
+    entry_ptr load(ss::file, size_t file_size, key, ss::io_priority_class);
+    void prefetch(ss::file, size_t file_size, key, ss::io_priority_class);
+    ss::future<> stage(entry_ptr, ss::io_priority_class);
+    void erase(const entry_ptr&);
+    void evict();
+    void remove_staged(const key&);
+    ss::future<> prepare();
+
+    config _cfg;
+    segment_id _last_id{0};
+    absl::flat_hash_map<key, entry_ptr> _entries;
+    lru_t _lru;
+    std::optional<ss::shared_future<>> _prepared;
+    // replaced on stop, the cache lives as long as the shard
+    ss::lw_shared_ptr<ss::gate> _gate = ss::make_lw_shared<ss::gate>();
+    stats _stats;
+};
+
+inline segment_chunk_cache& cold_chunks() {
+    static thread_local segment_chunk_cache cache;
+    return cache;
+}
+
+/// reads `chunk` of a file without staging it, the last chunk is shorter
+ss::future<ss::temporary_buffer<char>> read_chunk(
+  ss::file, size_t file_size, size_t chunk, const ss::io_priority_class&);
+
+} // namespace storage::internal
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#include "storage/segment_file_pool.h"
+
+#include "model/timestamp.h"
+#include "storage/logger.h"
+#include "utils/directory_walker.h"
+#include "vlog.h"
+
+#include <seastar/core/align.hh>
+#include <seastar/core/file.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/smp.hh>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+#include <sys/stat.h>
+
+namespace storage {
+
+segment_file_pool::segment_file_pool(size_t max_files)
+  : _max_files(max_files) {}
+
+std::filesystem::path
+segment_file_pool::pool_directory(const ss::sstring& base) {
+    return std::filesystem::path(base) / pool_dir_name
+           / fmt::format("{}", ss::this_shard_id());
+}
+
+bool segment_file_pool::wants(const ss::sstring& base) const {
+    if (_max_files == 0 || _gate.is_closed()) {
+        return false;
+    }
+    size_t files = 0;
+    if (auto it = _files.find(base); it != _files.end()) {
+        files += it->second.size();
+    }
+    if (auto it = _pending.find(base); it != _pending.end()) {
+        files += it->second;
+    }
+    return files < _max_files;
+}
+
+ss::future<> segment_file_pool::put(
+  const ss::sstring& base, std::filesystem::path path) {
+    if (!wants(base)) {
+        return ss::remove_file(path.string());
+    }
+    // unique across restarts, the pool may still hold files of a previous run
+    auto target = pool_directory(base)
+                  / fmt::format(
+                    "{}-{}.log", model::timestamp::now().value(), _seq++);
+    ++_pending[base];
+    return ss::with_gate(_gate, [this, base, path, target] {
+        return ss::recursive_touch_directory(target.parent_path().string())
+          .then([path, target] {
+              return ss::rename_file(path.string(), target.string());
+          })
+          .then_wrapped([this, base, path, target](ss::future<> f) {
+              if (!f.failed()) {
+                  return add(base, target);
+              }
+              vlog(
+                stlog.info,
+                "error recycling {}: {}",
+                path,
+                f.get_exception());
+              --_pending[base];
+              return ss::remove_file(path.string());
+          });
+    });
+}
+
+ss::future<std::optional<size_t>> segment_file_pool::take(
+  const ss::sstring& base, std::filesystem::path target) {
+    auto it = _files.find(base);
+    if (_gate.is_closed() || it == _files.end() || it->second.empty()) {
+        return ss::make_ready_future<std::optional<size_t>>(std::nullopt);
+    }
+    auto f = std::move(it->second.front());
+    it->second.pop_front();
+    return ss::with_gate(_gate, [this, f = std::move(f), target] {
+        return ss::rename_file(f.path.string(), target.string())
+          .then([this, size = f.size] {
+              ++_reused;
+              return std::optional<size_t>(size);
+          })
+          .handle_exception([path = f.path](std::exception_ptr e) {
+              // the segment gets a new file instead
+              vlog(stlog.warn, "error reusing {}: {}", path, e);
+              return ss::remove_file(path.string())
+                .handle_exception([](std::exception_ptr) {})
+                .then([] { return std::optional<size_t>(); });
+          });
+    });
+}
+
+ss::future<> segment_file_pool::recover(const ss::sstring& base) {
+    if (_max_files == 0) {
+        return ss::now();
+    }
+    auto dir = pool_directory(base);
+    return ss::file_exists(dir.string()).then([this, base, dir](bool exists) {
+        if (!exists) {
+            return ss::now();
+        }
+        return directory_walker::walk(
+          dir.string(), [this, base, dir](ss::directory_entry de) {
+              auto path = dir / de.name.c_str();
+              if (!wants(base)) {
+                  return ss::remove_file(path.string());
+              }
+              ++_pending[base];
+              // a file may have been left half prepared
+              return add(base, std::move(path));
+          });
+    });
+}
+
+ss::future<> segment_file_pool::stop() { return _gate.close(); }
+
+size_t segment_file_pool::size() const {
+    size_t ret = 0;
+    for (const auto& [_, files] : _files) {
+        ret += files.size();
+    }
+    return ret;
+}
+
+ss::future<size_t> segment_file_pool::prepare(std::filesystem::path path) {
+    return ss::open_file_dma(path.string(), ss::open_flags::rw)
+      .then([](ss::file f) {
+          return ss::do_with(std::move(f), [](ss::file& f) {
+              return f.stat()
+                .then([&f](struct stat st) {
+                    // preallocated extents past the end count as well
+                    const size_t size = ss::align_up<size_t>(
+                      std::max<size_t>(st.st_size, st.st_blocks * 512), 4096);
+                    // the old batches must not be read back on recovery of
+                    // the next segment, the extents go and come back empty
+                    return f.truncate(0)
+                      .then([&f, size] {
+                          return size == 0 ? ss::now() : f.allocate(0, size);
+                      })
+                      .then([&f] { return f.flush(); })
+                      .then([size] { return size; });
+                })
+                .finally([&f] { return f.close(); });
+          });
+      });
+}
+
+ss::future<>
+segment_file_pool::add(const ss::sstring& base, std::filesystem::path path) {
+    return prepare(path).then_wrapped(
+      [this, base, path](ss::future<size_t> f) {
+          --_pending[base];
+          if (f.failed()) {
+              vlog(
+                stlog.info,
+                "error preparing {} for reuse: {}",
+                path,
+                f.get_exception());
+              return ss::remove_file(path.string())
+                .handle_exception([](std::exception_ptr) {});
+          }
+          ++_recycled;
+          _files[base].push_back(file{.path = path, .size = f.get0()});
+          return ss::now();
+      });
+}
+
+} // namespace storage
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/sstring.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <optional>
+
+namespace storage {
+
+/**
+ * Data files of removed segments kept for the segments rolled next, per data
+ * directory of a shard.
+ *
+ * Rolling a segment creates its file and grows it in fallocation steps while
+ * it is appended to, retention unlinks it again. Each of these is a file
+ * system metadata update on the path of the appends. Instead, the data file
+ * of a segment removed by retention or truncation is renamed into the pool
+ * directory of its data directory. There it is emptied and preallocated
+ * again to its former size, in the background of the removal. A roll takes
+ * a file of the pool and renames it to the new segment: the segment starts
+ * empty with its extents allocated already.
+ *
+ * Files left in the pool when the shard stops are found again by recover()
+ * on the next start.
+ */
+class segment_file_pool {
+public:
+    static constexpr const char* pool_dir_name = ".recycled";
+
+    /// keeps up to `max_files` per data directory, zero disables the pool
+    explicit segment_file_pool(size_t max_files);
+
+    /// \brief directory of `base` holding the files of this shard
+    static std::filesystem::path pool_directory(const ss::sstring& base);
+
+    /// \brief whether a removed data file of `base` would be kept
+    bool wants(const ss::sstring& base) const;
+
+    /// \brief moves the data file of a removed segment of `base` into the
+    /// pool, the file is removed when it cannot be kept
+    ss::future<> put(const ss::sstring& base, std::filesystem::path);
+
+    /// \brief renames a file of the pool of `base` to `target`
+    ///
+    /// returns the bytes allocated to the file, nullopt when the pool holds
+    /// no file for `base`
+    ss::future<std::optional<size_t>>
+    take(const ss::sstring& base, std::filesystem::path target);
+
+    /// \brief adds the files left in the pool of `base`
+    ss::future<> recover(const ss::sstring& base);
+
+    ss::future<> stop();
+
+    /// files ready to be taken
+    size_t size() const;
+    uint64_t recycled() const { return _recycled; }
+    uint64_t reused() const { return _reused; }
+
+private:
+    struct file {
+        std::filesystem::path path;
+        size_t size;
+    };
+
+    /// \brief empties a file of the pool and allocates its former size to
+    /// it again, returns the allocated bytes
+    static ss::future<size_t> prepare(std::filesystem::path);
+    /// \brief prepares a file of the pool of `base`, removing it on errors
+    ss::future<> add(const ss::sstring& base, std::filesystem::path);
+
+    size_t _max_files;
+    // files being prepared count against the capacity of their directory
+    absl::flat_hash_map<ss::sstring, size_t> _pending;
+    absl::flat_hash_map<ss::sstring, std::deque<file>> _files;
+    ss::gate _gate;
+    uint64_t _seq{0};
+    uint64_t _recycled{0};
+    uint64_t _reused{0};
+};
+
+} // namespace storage
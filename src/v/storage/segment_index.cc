@@ -9,9 +9,12 @@
 
 #include "storage/segment_index.h"
 
+#include "likely.h"
 #include "model/timestamp.h"
+#include "resource_mgmt/memory_groups.h"
 #include "storage/logger.h"
 #include "vassert.h"
+#include "vlog.h"
 
 #include <seastar/core/fstream.hh>
 #include <seastar/core/iostream.hh>
@@ -24,6 +27,61 @@
 
 namespace storage {
 
+/*
+ * Shard-wide accounting of the entries held by sealed segment indices. Indices
+ * are kept in lru order and the coldest are evicted once the budget is
+ * exceeded. Indices with unflushed state are never evicted.
+ */
+class sealed_index_tracker {
+public:
+    explicit sealed_index_tracker(size_t budget) noexcept
+      : _budget(budget) {}
+
+    void track(segment_index& idx) {
+        untrack(idx);
+        idx._tracked_bytes = idx.memory_usage();
+        _bytes += idx._tracked_bytes;
+        _lru.push_back(idx);
+        maybe_evict(idx);
+    }
+
+    void untrack(segment_index& idx) {
+        if (idx._hook.is_linked()) {
+            _bytes -= idx._tracked_bytes;
+            idx._hook.unlink();
+        }
+        idx._tracked_bytes = 0;
+    }
+
+    void touch(segment_index& idx) {
+        if (idx._hook.is_linked()) {
+            idx._hook.unlink();
+            _lru.push_back(idx);
+        }
+    }
+
+private:
+    void maybe_evict(const segment_index& keep) {
+        for (auto it = _lru.begin(); _bytes > _budget && it != _lru.end();) {
+            auto& idx = *it++;
+            if (&idx == &keep || idx._needs_persistence) {
+                continue;
+            }
+            idx.release_entries();
+        }
+    }
+
+    intrusive_list<segment_index, &segment_index::_hook> _lru;
+    size_t _bytes{0};
+    size_t _budget;
+};
+
+static sealed_index_tracker& sealed_indices() {
+    static thread_local sealed_index_tracker tracker(
+      memory_groups::storage_index_memory());
+    return tracker;
+}
+
 static inline segment_index::entry translate_index_entry(
   const index_state& s, std::tuple<uint32_t, uint32_t, uint32_t> entry) {
     auto [relative_offset, relative_time, filepos] = entry;
@@ -42,22 +100,134 @@ segment_index::segment_index(
     _state.base_offset = base;
 }
 
+segment_index::segment_index(segment_index&& o) noexcept
+  : _name(std::move(o._name))
+  , _out(std::move(o._out))
+  , _step(o._step)
+  , _acc(o._acc)
+  , _adaptive(o._adaptive)
+  , _min_step(o._min_step)
+  , _avg_batch_size(o._avg_batch_size)
+  , _needs_persistence(o._needs_persistence)
+  , _sealed(o._sealed)
+  , _evicted(o._evicted)
+  , _state(std::move(o._state))
+  , _tail(std::move(o._tail))
+  , _tracked_bytes(std::exchange(o._tracked_bytes, 0)) {
+    // take over the position of the moved-from index in the lru
+    _hook.swap_nodes(o._hook);
+}
+
+segment_index::~segment_index() noexcept { sealed_indices().untrack(*this); }
+
+size_t segment_index::memory_usage() const {
+    return sizeof(uint32_t)
+           * (_state.relative_offset_index.capacity()
+              + _state.relative_time_index.capacity()
+              + _state.position_index.capacity());
+}
+
+void segment_index::set_density(density d) {
+    _step = std::max<size_t>(1, d.step);
+    _adaptive = d.adaptive;
+    _min_step = std::max(
+      min_adaptive_step, d.segment_bytes / max_adaptive_entries);
+    _avg_batch_size = 0;
+}
+
+void segment_index::adapt_step(size_t batch_size) {
+    // exponential moving average, 1/8 weight for the latest batch
+    _avg_batch_size = _avg_batch_size == 0
+                        ? batch_size
+                        : (_avg_batch_size * 7 + batch_size) / 8;
+    _step = std::clamp(
+      _avg_batch_size * adaptive_batches_per_entry,
+      _min_step,
+      std::max(_min_step, max_adaptive_step));
+}
+
+void segment_index::seal() {
+    _sealed = true;
+    // a sealed index no longer takes writes, nor is it truncated often
+    _tail = {};
+    if (!_evicted) {
+        sealed_indices().track(*this);
+    }
+}
+
+void segment_index::touch() { sealed_indices().touch(*this); }
+
+void segment_index::release_entries() {
+    sealed_indices().untrack(*this);
+    // only the header stays resident
+    _state.relative_offset_index = {};
+    _state.relative_time_index = {};
+    _state.position_index = {};
+    _evicted = true;
+}
+
+ss::future<> segment_index::hydrate() {
+    if (!_evicted) {
+        return ss::now();
+    }
+    return _out.size()
+      .then([this](uint64_t size) { return _out.dma_read_bulk<char>(0, size); })
+      .then([this](ss::temporary_buffer<char> buf) {
+          if (!_evicted) {
+              // hydrated concurrently
+              return;
+          }
+          _evicted = false;
+          iobuf b;
+          b.append(std::move(buf));
+          auto hydrated = index_state::hydrate_from_buffer(std::move(b));
+          if (!hydrated || hydrated->base_offset != _state.base_offset) {
+              // lookups fall back to reading from the start of the segment
+              vlog(stlog.warn, "Could not reload evicted index {}", _name);
+              return;
+          }
+          _state = std::move(hydrated.value());
+          if (_sealed) {
+              sealed_indices().track(*this);
+          }
+      });
+}
+
 void segment_index::reset() {
+    sealed_indices().untrack(*this);
     auto base = _state.base_offset;
     _state = {};
     _state.base_offset = base;
+    _tail = {};
     _acc = 0;
+    _evicted = false;
+    if (_sealed) {
+        sealed_indices().track(*this);
+    }
 }
 
 void segment_index::swap_index_state(index_state&& o) {
     _needs_persistence = true;
     _acc = 0;
+    _evicted = false;
+    _tail = {};
     std::swap(_state, o);
+    if (_sealed) {
+        sealed_indices().track(*this);
+    }
 }
 
 void segment_index::maybe_track(
   const model::record_batch_header& hdr, size_t filepos) {
+    vassert(!_evicted, "cannot track batches in an evicted index: {}", *this);
+    if (unlikely(_sealed)) {
+        sealed_indices().untrack(*this);
+        _sealed = false;
+    }
     _acc += hdr.size_bytes;
+    if (_adaptive) {
+        adapt_step(hdr.size_bytes);
+    }
     if (_state.maybe_index(
           _acc,
           _step,
@@ -68,27 +238,78 @@ void segment_index::maybe_track(
           hdr.max_timestamp)) {
         _acc = 0;
     }
+    if (_tail.size() == tail_positions) {
+        _tail.pop_front();
+    }
+    _tail.push_back(entry{
+      .offset = hdr.base_offset,
+      .timestamp = _state.max_timestamp,
+      .filepos = filepos,
+    });
     _needs_persistence = true;
 }
 
 std::optional<segment_index::entry>
-segment_index::find_nearest(model::timestamp t) {
-    if (t < _state.base_timestamp) {
+segment_index::find_batch(model::offset o) const {
+    auto it = std::lower_bound(
+      _tail.begin(), _tail.end(), o, [](const entry& e, model::offset o) {
+          return e.offset < o;
+      });
+    if (it == _tail.end() || it->offset != o) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+std::optional<segment_index::entry>
+segment_index::find_nearest_in_tail(model::offset o) const {
+    if (_tail.empty() || o < _tail.front().offset) {
         return std::nullopt;
     }
+    auto it = std::upper_bound(
+      _tail.begin(), _tail.end(), o, [](model::offset o, const entry& e) {
+          return o < e.offset;
+      });
+    return *std::prev(it);
+}
+
+std::optional<segment_index::entry>
+segment_index::find_nearest(model::timestamp t) {
     if (_state.empty()) {
         return std::nullopt;
     }
-    const uint32_t i = t() - _state.base_timestamp();
+    touch();
+    if (t <= _state.base_timestamp) {
+        return translate_index_entry(_state, _state.get_entry(0));
+    }
+    // the time index is a running max, the first entry reaching `t` may be
+    // preceded by matching batches which were not indexed, so the scan
+    // starts from the entry before it
+    const uint32_t needle = t() - _state.base_timestamp();
     auto it = std::lower_bound(
       std::begin(_state.relative_time_index),
       std::end(_state.relative_time_index),
-      i,
+      needle,
       std::less<uint32_t>{});
-    if (it == _state.relative_offset_index.end()) {
+    if (it != _state.relative_time_index.begin()) {
+        it = std::prev(it);
+    }
+    auto dist = std::distance(_state.relative_time_index.begin(), it);
+    return translate_index_entry(_state, _state.get_entry(dist));
+}
+
+std::optional<segment_index::entry>
+segment_index::find_nearest_position(size_t pos) {
+    if (_state.empty() || pos < _state.position_index.front()) {
         return std::nullopt;
     }
-    auto dist = std::distance(_state.relative_offset_index.begin(), it);
+    touch();
+    auto it = std::upper_bound(
+      std::begin(_state.position_index),
+      std::end(_state.position_index),
+      pos,
+      [](size_t pos, uint32_t filepos) { return pos < filepos; });
+    auto dist = std::distance(_state.position_index.begin(), std::prev(it));
     return translate_index_entry(_state, _state.get_entry(dist));
 }
 
@@ -97,6 +318,10 @@ segment_index::find_nearest(model::offset o) {
     if (o < _state.base_offset || _state.empty()) {
         return std::nullopt;
     }
+    if (auto e = find_nearest_in_tail(o); e) {
+        return e;
+    }
+    touch();
     const uint32_t needle = o() - _state.base_offset();
     auto it = std::lower_bound(
       std::begin(_state.relative_offset_index),
@@ -118,9 +343,17 @@ segment_index::find_nearest(model::offset o) {
 }
 
 ss::future<> segment_index::truncate(model::offset o) {
+    // the batches starting after the offset are gone
+    while (!_tail.empty() && _tail.back().offset > o) {
+        _tail.pop_back();
+    }
     if (o < _state.base_offset) {
         return ss::now();
     }
+    return hydrate().then([this, o] { return do_truncate(o); });
+}
+
+ss::future<> segment_index::do_truncate(model::offset o) {
     const uint32_t i = o() - _state.base_offset();
     auto it = std::lower_bound(
       std::begin(_state.relative_offset_index),
@@ -143,6 +376,9 @@ ss::future<> segment_index::truncate(model::offset o) {
               _state.relative_time_index.back() + _state.base_timestamp());
             _state.max_offset = o;
         }
+        if (_sealed) {
+            sealed_indices().track(*this);
+        }
     }
     return flush();
 }
@@ -162,11 +398,39 @@ ss::future<bool> segment_index::materialize_index() {
           if (!hydrated) {
               return false;
           }
+          sealed_indices().untrack(*this);
           _state = std::move(hydrated.value());
+          _evicted = false;
           return true;
       });
 }
 
+ss::future<bool> segment_index::materialize_index_header() {
+    return _out.size().then([this](uint64_t size) {
+        if (size < index_state::header_size) {
+            return ss::make_ready_future<bool>(false);
+        }
+        return _out.dma_read_bulk<char>(0, index_state::header_size)
+          .then([this, size](ss::temporary_buffer<char> buf) {
+              iobuf b;
+              b.append(std::move(buf));
+              auto hdr = index_state::hydrate_header_from_buffer(std::move(b));
+              // the size field excludes the version and itself
+              constexpr size_t prefix = sizeof(int8_t) + sizeof(uint32_t);
+              if (
+                !hdr || hdr->size + prefix != size
+                || hdr->base_offset != _state.base_offset
+                || hdr->max_offset < hdr->base_offset) {
+                  return false;
+              }
+              sealed_indices().untrack(*this);
+              _state = std::move(hdr.value());
+              _evicted = true;
+              return true;
+          });
+    });
+}
+
 ss::future<> segment_index::drop_all_data() {
     reset();
     return _out.truncate(0);
@@ -202,7 +466,9 @@ ss::future<> segment_index::close() {
 std::ostream& operator<<(std::ostream& o, const segment_index& i) {
     return o << "{file:" << i.filename() << ", offsets:" << i.base_offset()
              << ", index:" << i._state << ", step:" << i._step
-             << ", needs_persistence:" << i._needs_persistence << "}";
+             << ", adaptive:" << i._adaptive
+             << ", needs_persistence:" << i._needs_persistence
+             << ", sealed:" << i._sealed << ", evicted:" << i._evicted << "}";
 }
 std::ostream& operator<<(std::ostream& o, const segment_index_ptr& i) {
     if (i) {
@@ -14,7 +14,10 @@
 #include "model/record.h"
 #include "model/timestamp.h"
 #include "storage/index_state.h"
+#include "units.h"
+#include "utils/intrusive_list_helpers.h"
 
+#include <seastar/core/circular_buffer.hh>
 #include <seastar/core/file.hh>
 #include <seastar/core/unaligned.hh>
 
@@ -34,6 +37,18 @@ namespace storage {
  *
  * The name of this index _must_ be then:
  *     default/test/0/1-1-v1.base_index
+ *
+ * Once a segment stops taking writes its index is sealed. The entries of
+ * sealed indices are charged to a shard-wide budget (see
+ * memory_groups::storage_index_memory) and the least recently used ones are
+ * evicted when the budget is exceeded. Only the header (offset and timestamp
+ * bounds) of an evicted index stays resident; `hydrate()` reloads the entries
+ * from disk.
+ *
+ * While the segment takes writes the index also keeps the exact position of
+ * its last `tail_positions` batches in memory. Raft truncates the tail of
+ * the log on leadership changes and followers read from it; both find
+ * their batch there instead of scanning from the nearest sparse entry.
  */
 class segment_index {
 public:
@@ -48,17 +63,50 @@ public:
     // 32KB - a well known number as a sweet spot for fetching data from disk
     static constexpr size_t default_data_buffer_step = 4096 * 8;
 
+    // an adaptive index adds an entry about every this many batches
+    static constexpr size_t adaptive_batches_per_entry = 8;
+    // bounds of the step of an adaptive index. the lower bound grows with the
+    // segment so that no segment has more than `max_adaptive_entries`
+    static constexpr size_t min_adaptive_step = 4_KiB;
+    static constexpr size_t max_adaptive_step = 1_MiB;
+    static constexpr size_t max_adaptive_entries = 64 * 1024;
+    // batches of a writable segment whose position is known exactly
+    static constexpr size_t tail_positions = 128;
+
+    /// \brief how batches are sampled into entries. a fixed index adds an
+    /// entry every `step` bytes of batches. an adaptive one derives the step
+    /// from the running average of the batch sizes instead, so that small
+    /// batches are indexed densely and large ones sparsely
+    struct density {
+        // unused by adaptive indices
+        size_t step;
+        bool adaptive;
+        // expected size of the segment, bounds the adaptive step
+        size_t segment_bytes;
+    };
+
     segment_index(
       ss::sstring filename, ss::file, model::offset base, size_t step);
-    ~segment_index() noexcept = default;
-    segment_index(segment_index&&) noexcept = default;
-    segment_index& operator=(segment_index&&) noexcept = default;
+    ~segment_index() noexcept;
+    segment_index(segment_index&&) noexcept;
+    segment_index& operator=(segment_index&&) noexcept = delete;
     segment_index(const segment_index&) = delete;
     segment_index& operator=(const segment_index&) = delete;
 
     void maybe_track(const model::record_batch_header&, size_t filepos);
+
+    /// \brief returns std::nullopt if the index entries are evicted, in which
+    /// case callers fall back to the beginning of the segment
     std::optional<entry> find_nearest(model::offset);
-    std::optional<entry> find_nearest(model::timestamp);
+    /// \brief entry to scan from for the first batch with a timestamp at or
+    /// above `t`, no batch before it reaches `t`. O(log n)
+    std::optional<entry> find_nearest(model::timestamp t);
+    /// \brief last entry at or before the file position, the one to scan from
+    /// to read the segment from that position on. O(log n)
+    std::optional<entry> find_nearest_position(size_t);
+    /// \brief position of the batch starting at the offset if it is one of
+    /// the last batches appended, e.g. for truncating the log at it
+    std::optional<entry> find_batch(model::offset) const;
 
     model::offset base_offset() const { return _state.base_offset; }
     model::offset max_offset() const { return _state.max_offset; }
@@ -67,6 +115,9 @@ public:
     const ss::sstring& filename() const { return _name; }
 
     ss::future<bool> materialize_index();
+    /// \brief loads only the header. the entries are loaded by hydrate() on
+    /// first use, which is also when the checksum is verified
+    ss::future<bool> materialize_index_header();
     ss::future<> close();
     ss::future<> flush();
     ss::future<> truncate(model::offset);
@@ -82,13 +133,49 @@ public:
     void swap_index_state(index_state&&);
     bool needs_persistence() const { return _needs_persistence; }
 
+    /// \brief marks the index as no longer written to, making its entries
+    /// eligible for eviction
+    void seal();
+    bool is_sealed() const { return _sealed; }
+    bool is_evicted() const { return _evicted; }
+
+    /// \brief reloads the entries of an evicted index. no-op otherwise
+    ss::future<> hydrate();
+
+    /// \brief memory used by the index entries
+    size_t memory_usage() const;
+
+    /// \brief applies to the batches tracked from now on
+    void set_density(density);
+    size_t step() const { return _step; }
+
 private:
+    friend class sealed_index_tracker;
+
+    ss::future<> do_truncate(model::offset);
+    void release_entries();
+    void touch();
+    void adapt_step(size_t batch_size);
+    std::optional<entry> find_nearest_in_tail(model::offset) const;
+
     ss::sstring _name;
     ss::file _out;
     size_t _step;
     size_t _acc{0};
+    bool _adaptive{false};
+    size_t _min_step{min_adaptive_step};
+    // running average of the batch sizes of an adaptive index
+    size_t _avg_batch_size{0};
     bool _needs_persistence{false};
+    bool _sealed{false};
+    bool _evicted{false};
     index_state _state;
+    // exact positions of the last batches, oldest first
+    ss::circular_buffer<entry> _tail;
+
+    // membership in the shard-wide lru of sealed indices
+    intrusive_list_hook _hook;
+    size_t _tracked_bytes{0};
 
     friend std::ostream& operator<<(std::ostream&, const segment_index&);
 };
@@ -9,25 +9,144 @@
 
 #include "storage/segment_reader.h"
 
+#include "resource_mgmt/memory_groups.h"
 #include "vassert.h"
 
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/iostream.hh>
 #include <seastar/core/reactor.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sstring.hh>
 
 namespace storage {
 
+static ss::semaphore& read_ahead_budget() {
+    static thread_local ss::semaphore sem(
+      memory_groups::storage_read_ahead_memory());
+    return sem;
+}
+
+/*
+ * Wraps the file data source of a segment stream. It records how far the
+ * stream was consumed so that the next stream opened on the segment can be
+ * classified as sequential, and it owns the read-ahead memory charged to the
+ * stream until it is destroyed.
+ */
+class read_ahead_data_source final : public ss::data_source_impl {
+public:
+    read_ahead_data_source(
+      ss::data_source src,
+      size_t pos,
+      ss::lw_shared_ptr<segment_reader::read_ahead_state> state,
+      std::optional<ss::semaphore_units<>> units) noexcept
+      : _src(std::move(src))
+      , _pos(pos)
+      , _state(std::move(state))
+      , _units(std::move(units)) {}
+
+    ss::future<ss::temporary_buffer<char>> get() final {
+        return _src.get().then([this](ss::temporary_buffer<char> buf) {
+            advance(buf.size());
+            return buf;
+        });
+    }
+
+    ss::future<ss::temporary_buffer<char>> skip(uint64_t n) final {
+        advance(n);
+        return _src.skip(n);
+    }
+
+    ss::future<> close() final { return _src.close(); }
+
+private:
+    void advance(size_t n) {
+        _pos += n;
+        _state->end = std::max(_state->end, _pos);
+    }
+
+    ss::data_source _src;
+    size_t _pos;
+    ss::lw_shared_ptr<segment_reader::read_ahead_state> _state;
+    std::optional<ss::semaphore_units<>> _units;
+};
+
+/*
+ * Reads a segment of the storage tier chunk by chunk through the staging
+ * cache, which does the read-ahead of the stream by prefetching chunks.
+ */
+class cold_data_source final : public ss::data_source_impl {
+public:
+    cold_data_source(
+      internal::segment_chunk_cache::segment_id id,
+      ss::file f,
+      size_t pos,
+      size_t file_size,
+      const ss::io_priority_class& pc) noexcept
+      : _id(id)
+      , _file(std::move(f))
+      , _pos(pos)
+      , _file_size(file_size)
+      , _pc(pc) {}
+
+    ss::future<ss::temporary_buffer<char>> get() final {
+        using chunks = internal::segment_chunk_cache;
+        if (_pos >= _file_size) {
+            return ss::make_ready_future<ss::temporary_buffer<char>>();
+        }
+        const size_t chunk = _pos / chunks::chunk_size;
+        return internal::cold_chunks()
+          .get(_id, _file, _file_size, chunk, _pc)
+          .then([this, chunk](ss::temporary_buffer<char> buf) {
+              const size_t skip = _pos - chunk * chunks::chunk_size;
+              if (skip >= buf.size()) {
+                  // the file is shorter than its reader believes
+                  _pos = _file_size;
+                  return ss::temporary_buffer<char>();
+              }
+              buf.trim_front(skip);
+              _pos += buf.size();
+              return buf;
+          });
+    }
+
+    ss::future<ss::temporary_buffer<char>> skip(uint64_t n) final {
+        _pos = std::min(_file_size, _pos + n);
+        return ss::make_ready_future<ss::temporary_buffer<char>>();
+    }
+
+    ss::future<> close() final { return ss::now(); }
+
+private:
+    internal::segment_chunk_cache::segment_id _id;
+    ss::file _file;
+    size_t _pos;
+    size_t _file_size;
+    ss::io_priority_class _pc;
+};
+
 segment_reader::segment_reader(
   ss::sstring filename,
   ss::file data_file,
   size_t file_size,
-  size_t buffer_size) noexcept
+  size_t buffer_size,
+  cold c) noexcept
   : _filename(std::move(filename))
   , _data_file(std::move(data_file))
   , _file_size(file_size)
-  , _buffer_size(buffer_size) {}
+  , _buffer_size(buffer_size)
+  , _cold(c) {
+    if (_cold) {
+        _cold_id = internal::cold_chunks().next_segment_id();
+    }
+}
+
+ss::future<> segment_reader::close() {
+    if (_cold) {
+        internal::cold_chunks().invalidate(_cold_id);
+    }
+    return _data_file.close();
+}
 
 ss::input_stream<char>
 segment_reader::data_stream(size_t pos, const ss::io_priority_class& pc) {
@@ -36,13 +155,48 @@ segment_reader::data_stream(size_t pos, const ss::io_priority_class& pc) {
       "cannot read negative bytes. Asked to read at position: '{}' - {}",
       pos,
       *this);
+    if (_cold) {
+        return ss::input_stream<char>(
+          ss::data_source(std::make_unique<cold_data_source>(
+            _cold_id, _data_file, pos, _file_size, pc)));
+    }
+    /*
+     * catch-up consumers re-open a stream on every fetch, starting from the
+     * nearest index entry below the last offset they read. grow the window
+     * while that pattern holds, and fall back to the default otherwise.
+     */
+    auto& st = *_read_ahead;
+    const bool sequential = pos > st.start && pos <= st.end;
+    const size_t max_read_ahead = std::max(
+      default_read_ahead,
+      max_read_ahead_bytes / std::max<size_t>(1, _buffer_size));
+    st.read_ahead = sequential ? std::min(st.read_ahead * 2, max_read_ahead)
+                               : default_read_ahead;
+    st.start = pos;
+    st.end = pos;
+
+    // read-ahead above the default is charged to the shared budget
+    size_t read_ahead = default_read_ahead;
+    std::optional<ss::semaphore_units<>> units;
+    if (st.read_ahead > default_read_ahead) {
+        const size_t extra = (st.read_ahead - default_read_ahead)
+                             * _buffer_size;
+        if (read_ahead_budget().try_wait(extra)) {
+            units.emplace(read_ahead_budget(), extra);
+            read_ahead = st.read_ahead;
+        }
+    }
+
     ss::file_input_stream_options options;
     options.buffer_size = _buffer_size;
     options.io_priority_class = pc;
-    options.read_ahead = 4; // FIXME: scylla uses 10
+    options.read_ahead = read_ahead;
     options.dynamic_adjustments = _history;
-    return make_file_input_stream(
+    auto src = ss::make_file_data_source(
       _data_file, pos, _file_size - pos, std::move(options));
+    return ss::input_stream<char>(
+      ss::data_source(std::make_unique<read_ahead_data_source>(
+        std::move(src), pos, _read_ahead, std::move(units))));
 }
 
 ss::future<> segment_reader::truncate(size_t n) {
@@ -13,11 +13,13 @@
 
 #include "model/fundamental.h"
 #include "seastarx.h"
+#include "storage/segment_chunk_cache.h"
 
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/io_queue.hh>
 #include <seastar/core/iostream.hh>
+#include <seastar/util/bool_class.hh>
 #include <seastar/util/log.hh>
 
 #include <optional>
@@ -28,11 +30,32 @@ namespace storage {
 
 class segment_reader {
 public:
+    /// segments moved to the storage tier are read through the local
+    /// staging cache of their chunks
+    using cold = ss::bool_class<struct cold_segment_tag>;
+
+    /// read-ahead (in buffers) of a stream with no sequential history
+    static constexpr size_t default_read_ahead = 4;
+    /// upper bound of the adaptive read-ahead window in bytes
+    static constexpr size_t max_read_ahead_bytes = 8 * 1024 * 1024;
+
+    /**
+     * Tracks the streams opened on a segment to detect sequential consumers.
+     * A stream opened inside the range consumed by the previous stream is a
+     * continuation of it, and its read-ahead window is doubled.
+     */
+    struct read_ahead_state {
+        size_t start{0};
+        size_t end{0};
+        size_t read_ahead{default_read_ahead};
+    };
+
     segment_reader(
       ss::sstring filename,
       ss::file,
       size_t file_size,
-      size_t buffer_size) noexcept;
+      size_t buffer_size,
+      cold = cold::no) noexcept;
     ~segment_reader() noexcept = default;
     segment_reader(segment_reader&&) noexcept = default;
     segment_reader& operator=(segment_reader&&) noexcept = default;
@@ -48,8 +71,10 @@ public:
 
     bool empty() const { return _file_size == 0; }
 
+    bool is_cold() const { return bool(_cold); }
+
     /// close the underlying file handle
-    ss::future<> close() { return _data_file.close(); }
+    ss::future<> close();
 
     /// perform syscall stat
     ss::future<struct stat> stat() { return _data_file.stat(); }
@@ -70,8 +95,12 @@ private:
     ss::file _data_file;
     size_t _file_size{0};
     size_t _buffer_size{0};
+    cold _cold{cold::no};
+    internal::segment_chunk_cache::segment_id _cold_id{0};
     ss::lw_shared_ptr<ss::file_input_stream_history> _history
       = ss::make_lw_shared<ss::file_input_stream_history>();
+    ss::lw_shared_ptr<read_ahead_state> _read_ahead
+      = ss::make_lw_shared<read_ahead_state>();
 
     friend std::ostream& operator<<(std::ostream&, const segment_reader&);
 };
@@ -19,29 +19,65 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/loop.hh>
 #include <seastar/core/seastar.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/thread.hh>
 
+#include <absl/container/flat_hash_set.h>
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <chrono>
 #include <exception>
 
 namespace storage {
+
+/// number of segments of a log that are opened or materialized concurrently
+static constexpr size_t recovery_io_concurrency = 16;
+/// number of logs per shard that may replay (rebuild) segments concurrently
+static constexpr size_t max_concurrent_replays = 4;
+
+static ss::semaphore& replay_units() {
+    static thread_local ss::semaphore sem(max_concurrent_replays);
+    return sem;
+}
+
+/// time spent in each phase of recovering the segments of a log
+struct recovery_timings {
+    using clock_type = std::chrono::steady_clock;
+    clock_type::duration open{0};
+    clock_type::duration index{0};
+    clock_type::duration replay{0};
+};
+
+template<typename Duration>
+static int64_t to_millis(Duration d) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
 struct segment_ordering {
     using type = ss::lw_shared_ptr<segment>;
     bool operator()(const type& seg1, const type& seg2) const {
         return seg1->offsets().base_offset < seg2->offsets().base_offset;
     }
-    bool operator()(const type& seg, model::offset value) const {
-        return seg->offsets().dirty_offset < value;
-    }
-    bool operator()(const type& seg, model::timestamp value) const {
-        return seg->index().max_timestamp() < value;
-    }
 };
 
 segment_set::segment_set(segment_set::underlying_t segs)
   : _handles(std::move(segs)) {
     std::sort(_handles.begin(), _handles.end(), segment_ordering{});
+    _base_offsets.reserve(_handles.size());
+    for (auto& h : _handles) {
+        _base_offsets.push_back(h->offsets().base_offset);
+    }
+    rebuild_max_timestamps();
+}
+
+void segment_set::rebuild_max_timestamps() {
+    _max_timestamps.clear();
+    _max_timestamps.reserve(_handles.size());
+    auto max = model::timestamp::min();
+    for (auto& h : _handles) {
+        _max_timestamps.push_back(max);
+        max = std::max(max, h->index().max_timestamp());
+    }
 }
 
 void segment_set::add(ss::lw_shared_ptr<segment> h) {
@@ -55,68 +91,61 @@ void segment_set::add(ss::lw_shared_ptr<segment> h) {
           *h,
           *this);
     }
+    auto max = model::timestamp::min();
+    if (!_handles.empty()) {
+        max = std::max(
+          _max_timestamps.back(), _handles.back()->index().max_timestamp());
+    }
+    _max_timestamps.push_back(max);
+    _base_offsets.push_back(h->offsets().base_offset);
     _handles.emplace_back(std::move(h));
 }
 
-void segment_set::pop_back() { _handles.pop_back(); }
-void segment_set::pop_front() { _handles.pop_front(); }
-
-template<typename Iterator>
-struct needle_in_range {
-    bool operator()(Iterator ptr, model::offset o) {
-        auto& s = **ptr;
-        if (s.empty()) {
-            return false;
-        }
-        // must use max_offset
-        return o <= s.offsets().dirty_offset && o >= s.offsets().base_offset;
+void segment_set::pop_back() {
+    _handles.pop_back();
+    _base_offsets.pop_back();
+    _max_timestamps.pop_back();
+}
+void segment_set::pop_front() {
+    const auto removed = _handles.front()->index().max_timestamp();
+    _handles.pop_front();
+    _base_offsets.pop_front();
+    _max_timestamps.pop_front();
+    if (_handles.empty()) {
+        return;
     }
-
-    bool operator()(Iterator ptr, model::timestamp t) {
-        auto& s = **ptr;
-        if (s.empty()) {
-            return false;
-        }
-        // must use max_offset
-        return t <= s.index().max_timestamp()
-               && t >= s.index().base_timestamp();
+    // the running max of the segments past the new front includes it. it is
+    // unchanged unless the removed segment held the max, which retention and
+    // prefix truncation rarely see as timestamps mostly grow with offsets
+    _max_timestamps.front() = model::timestamp::min();
+    if (removed > _handles.front()->index().max_timestamp()) {
+        rebuild_max_timestamps();
     }
-};
+}
 
-template<typename Iterator, typename Needle>
-Iterator segments_lower_bound(Iterator begin, Iterator end, Needle needle) {
-    if (std::distance(begin, end) == 0) {
-        return end;
-    }
-    auto it = std::lower_bound(begin, end, needle, segment_ordering{});
-    if (it == end) {
-        it = std::prev(it);
+size_t segment_set::offset_lower_bound(model::offset o) const {
+    // segments are ordered and disjoint, only the last one starting at or
+    // before the offset may hold it
+    auto it = std::upper_bound(_base_offsets.begin(), _base_offsets.end(), o);
+    if (it == _base_offsets.begin()) {
+        return _handles.size();
     }
-    if (needle_in_range<Iterator>()(it, needle)) {
-        return it;
+    const size_t i = std::distance(_base_offsets.begin(), it) - 1;
+    const auto& s = *_handles[i];
+    // must use max_offset
+    if (s.empty() || o > s.offsets().dirty_offset) {
+        return _handles.size();
     }
-    if (std::distance(begin, it) > 0) {
-        it = std::prev(it);
-    }
-    if (needle_in_range<Iterator>()(it, needle)) {
-        return it;
-    }
-    return end;
+    return i;
 }
 
-/// lower_bound returns the element that is _strictly_ greater than or equal
-/// to bucket->dirty_offset() - see comparator above because our offsets are
-/// _inclusive_ we must check the previous iterator in the case that we are at
-/// the end, we also check the last element.
 segment_set::iterator segment_set::lower_bound(model::offset offset) {
-    return segments_lower_bound(
-      std::begin(_handles), std::end(_handles), offset);
+    return std::next(_handles.begin(), offset_lower_bound(offset));
 }
 
 segment_set::const_iterator
 segment_set::lower_bound(model::offset offset) const {
-    return segments_lower_bound(
-      std::cbegin(_handles), std::cend(_handles), offset);
+    return std::next(_handles.cbegin(), offset_lower_bound(offset));
 }
 // Lower bound for timestamp based indexing
 //
@@ -127,15 +156,31 @@ segment_set::lower_bound(model::offset offset) const {
 // entry is greater than the target timestamp, the broker will do binary search
 // on that time index to find the closest index entry and scan the log from
 // there. Otherwise it will move on to the next log segment.
+size_t segment_set::timestamp_lower_bound(model::timestamp needle) const {
+    // the running max does not decrease, binary search for the first segment
+    // whose running max reaches the needle
+    size_t lo = 0;
+    size_t hi = _handles.size();
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const auto max = std::max(
+          _max_timestamps[mid], _handles[mid]->index().max_timestamp());
+        if (max < needle) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 segment_set::iterator segment_set::lower_bound(model::timestamp needle) {
-    return std::lower_bound(
-      std::begin(_handles), std::end(_handles), needle, segment_ordering{});
+    return std::next(_handles.begin(), timestamp_lower_bound(needle));
 }
 
 segment_set::const_iterator
 segment_set::lower_bound(model::timestamp needle) const {
-    return segments_lower_bound(
-      std::cbegin(_handles), std::cend(_handles), needle);
+    return std::next(_handles.cbegin(), timestamp_lower_bound(needle));
 }
 
 std::ostream& operator<<(std::ostream& o, const segment_set& s) {
@@ -146,12 +191,40 @@ std::ostream& operator<<(std::ostream& o, const segment_set& s) {
     return o << "]}";
 }
 
+/*
+ * use the segment materialize instead of going through the index directly to
+ * hydrate the max_offset state. when `lazy` only the index header is read and
+ * the entries are loaded on first access to the segment.
+ */
+static ss::future<bool> materialize_segment_index(segment& s, bool lazy) {
+    auto f = ss::make_ready_future<bool>(false);
+    if (lazy) {
+        f = s.materialize_index_header();
+    }
+    // fall back to reading and verifying the whole index
+    f = f.then([&s](bool yn) {
+        return yn ? ss::make_ready_future<bool>(true) : s.materialize_index();
+    });
+    return f.handle_exception([&s](const std::exception_ptr& e) {
+        vlog(
+          stlog.info,
+          "Error materializing index:{}. Recovering parent "
+          "segment:{}. Details:{}",
+          s.index().filename(),
+          s.reader().filename(),
+          e);
+        return false;
+    });
+}
+
 // Recover the last segment. Whenever we close a segment, we will likely
 // open a new one to which we will direct new writes. That new segment
 // might be empty. To optimize log replay, implement #140.
-static ss::future<segment_set>
-unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
-    return ss::async([segments = std::move(segments), &as]() mutable {
+static ss::future<segment_set> unsafe_do_recover(
+  segment_set&& segments,
+  ss::abort_source& as,
+  ss::lw_shared_ptr<recovery_timings> timings) {
+    return ss::async([segments = std::move(segments), &as, timings]() mutable {
         if (segments.empty() || as.abort_requested()) {
             return std::move(segments);
         }
@@ -159,24 +232,37 @@ unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
         segment_set::underlying_t to_recover;
         to_recover.push_back(std::move(good.back()));
         good.pop_back(); // always recover last segment
+
+        /*
+         * only the newest sealed segment is likely to be read soon after
+         * startup. the indices of older segments are loaded lazily.
+         */
+        auto index_start = recovery_timings::clock_type::now();
+        absl::flat_hash_set<const segment*> valid;
+        ss::semaphore io_units(recovery_io_concurrency);
+        ss::parallel_for_each(
+          good,
+          [&good, &valid, &io_units](ss::lw_shared_ptr<segment>& s) {
+              const bool lazy = s != good.back();
+              return ss::with_semaphore(
+                io_units, 1, [&s, &valid, lazy] {
+                    return materialize_segment_index(*s, lazy).then(
+                      [&s, &valid](bool yn) {
+                          if (yn) {
+                              valid.insert(s.get());
+                          }
+                      });
+                });
+          })
+          .get();
+        timings->index = recovery_timings::clock_type::now() - index_start;
+
         // keep segments sorted
         auto good_end = std::stable_partition(
-          good.begin(), good.end(), [](ss::lw_shared_ptr<segment>& ss) {
-              auto& s = *ss;
-              try {
-                  // use the segment materialize instead of going through
-                  // the index directly to hydrate the max_offset state
-                  return s.materialize_index().get0();
-              } catch (...) {
-                  vlog(
-                    stlog.info,
-                    "Error materializing index:{}. Recovering parent "
-                    "segment:{}. Details:{}",
-                    s.index().filename(),
-                    s.reader().filename(),
-                    std::current_exception());
-              }
-              return false;
+          good.begin(),
+          good.end(),
+          [&valid](ss::lw_shared_ptr<segment>& s) {
+              return valid.contains(s.get());
           });
         std::move(
           std::move_iterator(good_end),
@@ -210,6 +296,9 @@ unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
             good.pop_back();
         }
 
+        // rebuilds are expensive. bound how many logs run them at once.
+        auto replay_start = recovery_timings::clock_type::now();
+        auto units = ss::get_units(replay_units(), 1).get0();
         for (auto& s : to_recover) {
             // check for abort
             if (unlikely(as.abort_requested())) {
@@ -236,12 +325,15 @@ unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
             vlog(stlog.info, "Recovered: {}", s);
             good.emplace_back(std::move(s));
         }
+        timings->replay = recovery_timings::clock_type::now() - replay_start;
         return segment_set(std::move(good));
     });
 }
 
-static ss::future<segment_set>
-do_recover(segment_set&& segments, ss::abort_source& as) {
+static ss::future<segment_set> do_recover(
+  segment_set&& segments,
+  ss::abort_source& as,
+  ss::lw_shared_ptr<recovery_timings> timings) {
     // light-weight copy used for clean-up if recovery fails
     segment_set::underlying_t copy;
     copy.reserve(segments.size());
@@ -253,7 +345,7 @@ do_recover(segment_set&& segments, ss::abort_source& as) {
     // are any pending io operations on a file associated with the segment
     // at the time of destruction seastar will complain about the file handle
     // being destroyed with pending ops.
-    return unsafe_do_recover(std::move(segments), as)
+    return unsafe_do_recover(std::move(segments), as, std::move(timings))
       .handle_exception(
         [copy = std::move(copy)](const std::exception_ptr& ex) mutable {
             return ss::do_with(
@@ -273,63 +365,186 @@ do_recover(segment_set&& segments, ss::abort_source& as) {
         });
 }
 
+/// a segment to open, with the tier copy of its data for cold segments
+struct segment_paths {
+    std::filesystem::path local;
+    std::optional<std::filesystem::path> cold;
+};
+
+/// lists the segment files of `dir`
+static ss::future<std::vector<std::filesystem::path>>
+list_segments(ss::sstring dir, ss::abort_source& as) {
+    return ss::do_with(
+      std::vector<std::filesystem::path>{},
+      [&as, dir = std::move(dir)](std::vector<std::filesystem::path>& paths) {
+          return directory_walker::walk(
+                   dir,
+                   [&as, dir, &paths](ss::directory_entry seg) {
+                       // abort if requested
+                       if (as.abort_requested()) {
+                           return ss::now();
+                       }
+                       /*
+                        * Skip non-regular files (including links)
+                        */
+                       if (
+                         !seg.type
+                         || *seg.type != ss::directory_entry_type::regular) {
+                           return ss::make_ready_future<>();
+                       }
+                       auto path = std::filesystem::path(
+                         fmt::format("{}/{}", dir, seg.name));
+                       try {
+                           auto is_valid
+                             = segment_path::parse_segment_filename(
+                               path.filename().string());
+                           if (!is_valid) {
+                               return ss::make_ready_future<>();
+                           }
+                       } catch (...) {
+                           // not a reader filename
+                           return ss::make_ready_future<>();
+                       }
+                       paths.push_back(std::move(path));
+                       return ss::make_ready_future<>();
+                   })
+            .then([&paths] { return std::move(paths); });
+      });
+}
+
+/// adds the segments of the storage tier directory to the local ones
+static ss::future<std::vector<segment_paths>> add_cold_segments(
+  std::vector<std::filesystem::path> local,
+  std::optional<ss::sstring> cold_dir,
+  std::filesystem::path dir,
+  ss::abort_source& as) {
+    std::vector<segment_paths> ret;
+    ret.reserve(local.size());
+    for (auto& p : local) {
+        ret.push_back(segment_paths{.local = std::move(p)});
+    }
+    if (!cold_dir) {
+        return ss::make_ready_future<std::vector<segment_paths>>(
+          std::move(ret));
+    }
+    return ss::file_exists(*cold_dir).then(
+      [&as, ret = std::move(ret), cold_dir, dir = std::move(dir)](
+        bool exists) mutable {
+          if (!exists) {
+              return ss::make_ready_future<std::vector<segment_paths>>(
+                std::move(ret));
+          }
+          return list_segments(*cold_dir, as)
+            .then([ret = std::move(ret), dir = std::move(dir)](
+                    std::vector<std::filesystem::path> cold) mutable {
+                absl::flat_hash_set<ss::sstring> local_names;
+                for (auto& p : ret) {
+                    local_names.insert(p.local.filename().string());
+                }
+                std::vector<std::filesystem::path> duplicates;
+                for (auto& p : cold) {
+                    // a move to the tier stopped before the local file was
+                    // removed, both copies hold the same data
+                    if (local_names.contains(p.filename().string())) {
+                        duplicates.push_back(std::move(p));
+                        continue;
+                    }
+                    auto local = dir / p.filename();
+                    ret.push_back(segment_paths{
+                      .local = std::move(local), .cold = std::move(p)});
+                }
+                return ss::do_with(
+                  std::move(duplicates),
+                  [ret = std::move(ret)](
+                    std::vector<std::filesystem::path>& duplicates) mutable {
+                      return ss::parallel_for_each(
+                               duplicates,
+                               [](const std::filesystem::path& p) {
+                                   vlog(
+                                     stlog.info,
+                                     "Removing tier copy of local segment {}",
+                                     p);
+                                   return ss::remove_file(p.string());
+                               })
+                        .then([ret = std::move(ret)]() mutable {
+                            return std::move(ret);
+                        });
+                  });
+            });
+      });
+}
+
 /**
  * \brief Open all segments in a directory.
  *
  * Returns an exceptional future if any error occured opening a
- * segment. Otherwise all open segment readers are returned.
+ * segment. Otherwise all open segment readers are returned. Segments found
+ * only in `cold_dir` are opened as cold segments.
  */
 static ss::future<segment_set::underlying_t> open_segments(
   ss::sstring dir,
+  std::optional<ss::sstring> cold_dir,
   debug_sanitize_files sanitize_fileops,
   std::function<std::optional<batch_cache_index>()> cache_factory,
   ss::abort_source& as) {
     using segs_type = segment_set::underlying_t;
-    return ss::do_with(
-      segs_type{},
-      [&as, cache_factory, sanitize_fileops, dir = std::move(dir)](
-        segs_type& segs) {
-          auto f = directory_walker::walk(
-            dir,
-            [&as, cache_factory, dir, sanitize_fileops, &segs](
-              ss::directory_entry seg) {
-                // abort if requested
-                if (as.abort_requested()) {
-                    return ss::now();
-                }
-                /*
-                 * Skip non-regular files (including links)
-                 */
-                if (
-                  !seg.type || *seg.type != ss::directory_entry_type::regular) {
-                    return ss::make_ready_future<>();
-                }
-                auto path = std::filesystem::path(
-                  fmt::format("{}/{}", dir, seg.name));
-                try {
-                    auto is_valid = segment_path::parse_segment_filename(
-                      path.filename().string());
-                    if (!is_valid) {
-                        return ss::make_ready_future<>();
-                    }
-                } catch (...) {
-                    // not a reader filename
-                    return ss::make_ready_future<>();
-                }
-                return open_segment(path, sanitize_fileops, cache_factory())
-                  .then([&segs](ss::lw_shared_ptr<segment> p) {
-                      segs.push_back(std::move(p));
-                  });
-            });
-          /*
-           * if the directory walker returns an exceptional future then all
-           * the segment readers that were created are cleaned up by
-           * ss::do_with.
-           */
-          return f.then([&segs]() mutable {
-              return ss::make_ready_future<segs_type>(std::move(segs));
-          });
+    using paths_type = std::vector<segment_paths>;
+    auto f = list_segments(dir, as).then(
+      [&as, dir, cold_dir = std::move(cold_dir)](
+        std::vector<std::filesystem::path> local) mutable {
+          return add_cold_segments(
+            std::move(local),
+            std::move(cold_dir),
+            std::filesystem::path(dir),
+            as);
       });
+    return f.then([&as, cache_factory, sanitize_fileops](paths_type ps) {
+        return ss::do_with(
+          segs_type{},
+          std::move(ps),
+          [&as, cache_factory, sanitize_fileops](
+            segs_type& segs, paths_type& paths) {
+              /*
+               * segments are opened concurrently once the directory listing
+               * is complete. if opening returns an exceptional future then
+               * all the segment readers that were created are cleaned up by
+               * ss::do_with.
+               */
+              auto io_units = ss::make_lw_shared<ss::semaphore>(
+                recovery_io_concurrency);
+              return ss::parallel_for_each(
+                       paths,
+                       [&as, &segs, io_units, cache_factory, sanitize_fileops](
+                         const segment_paths& p) {
+                           return ss::with_semaphore(
+                             *io_units,
+                             1,
+                             [&as,
+                              &segs,
+                              &p,
+                              cache_factory,
+                              sanitize_fileops] {
+                                 if (as.abort_requested()) {
+                                     return ss::now();
+                                 }
+                                 return open_segment(
+                                          p.local,
+                                          sanitize_fileops,
+                                          cache_factory(),
+                                          default_segment_readahead_size,
+                                          p.cold)
+                                   .then(
+                                     [&segs](ss::lw_shared_ptr<segment> s) {
+                                         segs.push_back(std::move(s));
+                                     });
+                             });
+                       })
+                .finally([io_units] {})
+                .then([&segs]() mutable {
+                    return ss::make_ready_future<segs_type>(std::move(segs));
+                });
+          });
+    });
 }
 
 ss::future<segment_set> recover_segments(
@@ -337,13 +552,31 @@ ss::future<segment_set> recover_segments(
   debug_sanitize_files sanitize_fileops,
   bool is_compaction_enabled,
   std::function<std::optional<batch_cache_index>()> cache_factory,
-  ss::abort_source& as) {
+  ss::abort_source& as,
+  std::optional<std::filesystem::path> cold_dir) {
+    auto timings = ss::make_lw_shared<recovery_timings>();
+    auto start = recovery_timings::clock_type::now();
+    auto dir = path.string();
     return ss::recursive_touch_directory(path.string())
-      .then([&as, cache_factory, sanitize_fileops, path = std::move(path)] {
+      .then([&as,
+             cache_factory,
+             sanitize_fileops,
+             path = std::move(path),
+             cold_dir = std::move(cold_dir)] {
+          std::optional<ss::sstring> cold;
+          if (cold_dir) {
+              cold = cold_dir->string();
+          }
           return open_segments(
-            path.string(), sanitize_fileops, cache_factory, as);
+            path.string(),
+            std::move(cold),
+            sanitize_fileops,
+            cache_factory,
+            as);
       })
-      .then([&as, is_compaction_enabled](segment_set::underlying_t segs) {
+      .then([&as, is_compaction_enabled, timings, start](
+              segment_set::underlying_t segs) {
+          timings->open = recovery_timings::clock_type::now() - start;
           auto segments = segment_set(std::move(segs));
           // we have to mark compacted segments before recovery to allow reading
           // gaps introduced by compaction
@@ -352,7 +585,20 @@ ss::future<segment_set> recover_segments(
                   s->mark_as_compacted_segment();
               }
           }
-          return do_recover(std::move(segments), as);
+          return do_recover(std::move(segments), as, timings);
+      })
+      .then([timings, start, dir = std::move(dir)](segment_set segments) {
+          vlog(
+            stlog.info,
+            "Recovered {} segments in {} in {}ms (open: {}ms, index: {}ms, "
+            "replay: {}ms)",
+            segments.size(),
+            dir,
+            to_millis(recovery_timings::clock_type::now() - start),
+            to_millis(timings->open),
+            to_millis(timings->index),
+            to_millis(timings->replay));
+          return segments;
       });
 }
 
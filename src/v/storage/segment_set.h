@@ -68,8 +68,14 @@ public:
     type& operator[](size_t i) { return _handles[i]; }
     const type& operator[](size_t i) const { return _handles[i]; }
 
+    /// \brief the segment holding the offset, end() if none does. the
+    /// search runs over a contiguous copy of the base offsets, so it touches
+    /// a single segment. O(log n)
     iterator lower_bound(model::offset o);
     const_iterator lower_bound(model::offset o) const;
+    /// \brief first segment holding a batch with a timestamp at or above
+    /// `o`. timestamps are not monotonic across segments so the search runs
+    /// over the running max of the segments' max timestamps. O(log n)
     iterator lower_bound(model::timestamp o);
     const_iterator lower_bound(model::timestamp o) const;
 
@@ -81,7 +87,17 @@ public:
     const_iterator end() const { return _handles.end(); }
 
 private:
+    void rebuild_max_timestamps();
+    size_t offset_lower_bound(model::offset) const;
+    size_t timestamp_lower_bound(model::timestamp) const;
+
     underlying_t _handles;
+    // _base_offsets[i] is the base offset of _handles[i], which never changes
+    ss::circular_buffer<model::offset> _base_offsets;
+    // _max_timestamps[i] is the max timestamp of the segments before
+    // _handles[i]. segments only change at the back once a newer one is
+    // added, where the max timestamp is read from the segment itself
+    ss::circular_buffer<model::timestamp> _max_timestamps;
 
     friend std::ostream& operator<<(std::ostream&, const segment_set&);
 };
@@ -91,7 +107,8 @@ ss::future<segment_set> recover_segments(
   debug_sanitize_files sanitize_fileops,
   bool is_compaction_enabled,
   std::function<std::optional<batch_cache_index>()> batch_cache_factory,
-  ss::abort_source& as);
+  ss::abort_source& as,
+  std::optional<std::filesystem::path> cold_dir = std::nullopt);
 
 std::ostream& operator<<(std::ostream&, const segment_set&);
 
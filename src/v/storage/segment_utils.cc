@@ -17,6 +17,7 @@
 #include "storage/compacted_index_writer.h"
 #include "storage/compaction_reducers.h"
 #include "storage/index_state.h"
+#include "storage/key_bloom_filter.h"
 #include "storage/lock_manager.h"
 #include "storage/log_reader.h"
 #include "storage/logger.h"
@@ -27,7 +28,9 @@
 #include "vassert.h"
 #include "vlog.h"
 
+#include <seastar/core/align.hh>
 #include <seastar/core/file-types.hh>
+#include <seastar/core/fstream.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/rwlock.hh>
@@ -41,6 +44,9 @@
 namespace storage::internal {
 using namespace storage; // NOLINT
 
+// slice loaded ahead of the reducers of a full segment scan
+static constexpr size_t full_reader_read_ahead_bytes = 1_MiB;
+
 inline std::filesystem::path
 data_segment_staging_name(const ss::lw_shared_ptr<segment>& s) {
     return std::filesystem::path(
@@ -119,16 +125,21 @@ ss::future<segment_appender_ptr> make_segment_appender(
   const std::filesystem::path& path,
   debug_sanitize_files debug,
   size_t number_of_chunks,
-  ss::io_priority_class iopc) {
+  ss::io_priority_class iopc,
+  size_t falloc_step,
+  size_t preallocated) {
     return internal::make_writer_handle(path, debug)
-      .then([number_of_chunks, iopc, path](ss::file writer) {
+      .then([number_of_chunks, iopc, falloc_step, preallocated, path](
+              ss::file writer) {
           try {
               // NOTE: This try-catch is needed to not uncover the real
               // exception during an OOM condition, since the appender allocates
               // 1MB of memory aligned buffers
+              auto opts = segment_appender::options(
+                iopc, number_of_chunks, falloc_step);
+              opts.preallocated = preallocated;
               return ss::make_ready_future<segment_appender_ptr>(
-                std::make_unique<segment_appender>(
-                  writer, segment_appender::options(iopc, number_of_chunks)));
+                std::make_unique<segment_appender>(writer, opts));
           } catch (...) {
               auto e = std::current_exception();
               vlog(stlog.error, "could not allocate appender: {}", e);
@@ -165,10 +176,16 @@ ss::future<> copy_filtered_entries(
       [bm = std::move(to_copy_index),
        reader](compacted_index_writer& writer) mutable {
           reader.reset();
-          return reader
-            .consume(
-              index_filtered_copy_reducer(std::move(bm), writer),
-              model::no_timeout)
+          return reader.load_footer()
+            .then([reader, bm = std::move(bm), &writer](
+                    compacted_index::footer footer) mutable {
+                // the tombstones kept are only expired by cross compaction
+                writer.set_flag(
+                  footer.flags & compacted_index::footer_flags::tombstones);
+                return reader.consume(
+                  index_filtered_copy_reducer(std::move(bm), writer),
+                  model::no_timeout);
+            })
             // must be last
             .finally([&writer] {
                 writer.set_flag(compacted_index::footer_flags::self_compaction);
@@ -278,48 +295,73 @@ do_compact_segment_index(ss::lw_shared_ptr<segment> s, compaction_config cfg) {
           return write_clean_compacted_index(reader, cfg);
       });
 }
-ss::future<storage::index_state> do_copy_segment_data(
-  ss::lw_shared_ptr<segment> s,
-  compaction_config cfg,
-  storage::probe& pb,
-  ss::rwlock::holder h) {
-    auto idx_path = std::filesystem::path(s->reader().filename());
-    idx_path.replace_extension(".compaction_index");
+/// \brief consumes the compacted index of a segment with the given reducer
+template<typename Reducer>
+static auto consume_compacted_index(
+  const ss::lw_shared_ptr<segment>& s, compaction_config cfg, Reducer red) {
+    auto idx_path = compacted_index_path(s->reader().filename().c_str());
     return make_reader_handle(idx_path, cfg.sanitize)
-      .then([s, cfg, idx_path](ss::file f) {
+      .then([cfg, idx_path, red = std::move(red)](ss::file f) mutable {
           auto reader = make_file_backed_compacted_reader(
             idx_path.string(), std::move(f), cfg.iopc, 64_KiB);
-          return generate_compacted_list(s->offsets().base_offset, reader)
+          return reader.consume(std::move(red), model::no_timeout)
             .finally([reader]() mutable {
                 return reader.close().then_wrapped([](ss::future<>) {});
             });
-      })
+      });
+}
+
+static ss::future<storage::index_state> do_copy_segment_data(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  storage::probe& pb,
+  ss::rwlock::holder h,
+  compacted_offset_list list,
+  copy_data_segment_reducer::drop_tombstones drop
+  = copy_data_segment_reducer::drop_tombstones::no) {
+    const auto tmpname = data_segment_staging_name(s);
+    // the rewrite is no larger than the segment. a single extent saves the
+    // fallocations on the way, each of which waits for the writes in flight
+    const auto falloc_step = ss::align_up<size_t>(
+      std::max<size_t>(s->size_bytes(), 1), 4096);
+    return make_segment_appender(
+             tmpname,
+             cfg.sanitize,
+             segment_appender::chunks_no_buffer,
+             cfg.iopc,
+             falloc_step)
+      .then([l = std::move(list), &pb, h = std::move(h), cfg, s, drop](
+              segment_appender_ptr w) mutable {
+          auto raw = w.get();
+          auto red = copy_data_segment_reducer(
+            std::move(l), raw, cfg.throttle, s, drop, cfg.compression);
+          auto r = create_segment_full_reader(s, cfg, pb, std::move(h));
+          return std::move(r)
+            .consume(std::move(red), model::no_timeout)
+            .finally([raw, w = std::move(w)]() mutable {
+                return raw->close()
+                  .handle_exception([](std::exception_ptr e) {
+                      vlog(
+                        stlog.error,
+                        "Error copying index to new segment:{}",
+                        e);
+                  })
+                  .finally([w = std::move(w)] {});
+            });
+      });
+}
+
+ss::future<storage::index_state> do_copy_segment_data(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  storage::probe& pb,
+  ss::rwlock::holder h) {
+    return consume_compacted_index(
+             s, cfg, compacted_offset_list_reducer(s->offsets().base_offset))
       .then(
         [cfg, s, &pb, h = std::move(h)](compacted_offset_list list) mutable {
-            const auto tmpname = data_segment_staging_name(s);
-            return make_segment_appender(
-                     tmpname,
-                     cfg.sanitize,
-                     segment_appender::chunks_no_buffer,
-                     cfg.iopc)
-              .then([l = std::move(list), &pb, h = std::move(h), cfg, s](
-                      segment_appender_ptr w) mutable {
-                  auto raw = w.get();
-                  auto red = copy_data_segment_reducer(std::move(l), raw);
-                  auto r = create_segment_full_reader(s, cfg, pb, std::move(h));
-                  return std::move(r)
-                    .consume(std::move(red), model::no_timeout)
-                    .finally([raw, w = std::move(w)]() mutable {
-                        return raw->close()
-                          .handle_exception([](std::exception_ptr e) {
-                              vlog(
-                                stlog.error,
-                                "Error copying index to new segment:{}",
-                                e);
-                          })
-                          .finally([w = std::move(w)] {});
-                    });
-              });
+            return do_copy_segment_data(
+              s, cfg, pb, std::move(h), std::move(list));
         });
 }
 
@@ -338,8 +380,10 @@ model::record_batch_reader create_segment_full_reader(
     auto lease = std::make_unique<lock_manager::lease>(
       segment_set(std::move(set)));
     lease->locks.push_back(std::move(h));
-    return model::make_record_batch_reader<log_reader>(
-      std::move(lease), reader_cfg, pb);
+    return model::make_pipelined_record_batch_reader(
+      model::make_record_batch_reader<log_reader>(
+        std::move(lease), reader_cfg, pb),
+      full_reader_read_ahead_bytes);
 }
 
 ss::future<> do_swap_data_file_handles(
@@ -378,6 +422,112 @@ ss::future<> do_swap_data_file_handles(
       });
 }
 
+/// \brief writes the data of `s` to `dest` through a staging file which is
+/// renamed once complete, a crash never leaves a partial segment in the tier
+static ss::future<>
+copy_data_file(ss::lw_shared_ptr<segment> s, std::filesystem::path dest) {
+    auto staging = std::filesystem::path(
+      fmt::format("{}.staging", dest.string()));
+    return ss::open_file_dma(
+             staging.string(),
+             ss::open_flags::create | ss::open_flags::truncate
+               | ss::open_flags::wo)
+      .then([s](ss::file f) {
+          return ss::do_with(
+            s->reader().data_stream(0, ss::default_priority_class()),
+            ss::make_file_output_stream(std::move(f)),
+            [](ss::input_stream<char>& in, ss::output_stream<char>& out) {
+                return ss::copy(in, out)
+                  .then([&out] { return out.flush(); })
+                  .finally([&in, &out] {
+                      return out.close().finally([&in] { return in.close(); });
+                  });
+            });
+      })
+      .then([staging, dest] {
+          return ss::rename_file(staging.string(), dest.string());
+      })
+      .handle_exception([staging](std::exception_ptr e) {
+          return ss::remove_file(staging.string())
+            .handle_exception([](const std::exception_ptr&) {})
+            .then([e] { return ss::make_exception_future<>(e); });
+      });
+}
+
+ss::future<> move_segment_to_cold_storage(
+  ss::lw_shared_ptr<segment> s,
+  std::filesystem::path dir,
+  compaction_config cfg,
+  probe& pb) {
+    return s->write_lock().then([s, dir = std::move(dir), cfg, &pb](
+                                  ss::rwlock::holder h) mutable {
+        if (s->is_closed()) {
+            return ss::make_exception_future<>(segment_closed_exception());
+        }
+        const auto local = std::filesystem::path(
+          s->reader().filename().c_str());
+        auto dest = dir / local.filename();
+        return ss::recursive_touch_directory(dir.string())
+          .then([s, dest] { return copy_data_file(s, dest); })
+          .then([s] { return s->reader().close(); })
+          .then([dest, cfg] { return make_reader_handle(dest, cfg.sanitize); })
+          .then([s, dest, &pb](ss::file f) {
+              return f.stat().then([s, dest, f, &pb](struct stat st) mutable {
+                  auto r = segment_reader(
+                    dest.string(),
+                    std::move(f),
+                    st.st_size,
+                    default_segment_readahead_size,
+                    segment_reader::cold::yes);
+                  // update partition size probe
+                  pb.delete_segment(*s.get());
+                  std::swap(s->reader(), r);
+                  pb.add_initial_segment(*s.get());
+              });
+          })
+          .then([local] {
+              vlog(stlog.info, "Moved segment {} to the storage tier", local);
+              return ss::remove_file(local.string());
+          })
+          .finally([h = std::move(h)] {});
+    });
+}
+
+/// \brief replaces the data file of a segment with its compacted staging
+/// file, under the segment write lock
+static ss::future<> swap_compacted_segment(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  storage::probe& pb,
+  storage::index_state idx) {
+    return s->write_lock()
+      .then([s, idx = std::move(idx)](ss::rwlock::holder h) mutable {
+          using type = std::tuple<index_state, ss::rwlock::holder>;
+          if (s->is_closed()) {
+              return ss::make_exception_future<type>(
+                segment_closed_exception());
+          }
+          return ss::make_ready_future<type>(
+            std::make_tuple(std::move(idx), std::move(h)));
+      })
+      .then([cfg, s, &pb](std::tuple<index_state, ss::rwlock::holder> h) {
+          return s->index()
+            .drop_all_data()
+            .then([s, cfg, &pb] {
+                auto compacted_file = data_segment_staging_name(s);
+                return do_swap_data_file_handles(compacted_file, s, cfg, pb);
+            })
+            .then([h = std::move(h), s]() mutable {
+                auto& [idx, lock] = h;
+                s->index().swap_index_state(std::move(idx));
+                s->force_set_commit_offset_from_index();
+                // FIXME(noah): crashes if we evic the cache
+                // s->cache().purge();
+                return s->index().flush().finally([l = std::move(lock)] {});
+            });
+      });
+}
+
 ss::future<> do_self_compact_segment(
   ss::lw_shared_ptr<segment> s, compaction_config cfg, storage::probe& pb) {
     return s->read_lock()
@@ -394,32 +544,280 @@ ss::future<> do_self_compact_segment(
                 return do_copy_segment_data(s, cfg, pb, std::move(h));
             });
       })
-      .then([s](storage::index_state idx) {
-          return s->write_lock().then(
-            [s, idx = std::move(idx)](ss::rwlock::holder h) mutable {
-                using type = std::tuple<index_state, ss::rwlock::holder>;
+      .then([s, cfg, &pb](storage::index_state idx) {
+          return swap_compacted_segment(s, cfg, pb, std::move(idx));
+      });
+}
+
+ss::future<> recompress_segment(
+  ss::lw_shared_ptr<segment> s, compaction_config cfg, storage::probe& pb) {
+    vassert(cfg.compression, "recompression without a codec: {}", cfg);
+    return s->read_lock()
+      .then([s, cfg, &pb](ss::rwlock::holder h) {
+          if (s->is_closed()) {
+              return ss::make_exception_future<bool>(
+                segment_closed_exception());
+          }
+          return create_segment_full_reader(s, cfg, pb, std::move(h))
+            .consume(
+              recompression_check_reducer(*cfg.compression),
+              model::no_timeout);
+      })
+      .then([s, cfg, &pb](bool needed) {
+          if (!needed) {
+              return ss::now();
+          }
+          return s->read_lock()
+            .then([s, cfg, &pb](ss::rwlock::holder h) {
                 if (s->is_closed()) {
-                    return ss::make_exception_future<type>(
+                    return ss::make_exception_future<index_state>(
                       segment_closed_exception());
                 }
-                return ss::make_ready_future<type>(
-                  std::make_tuple(std::move(idx), std::move(h)));
+                // every record is kept
+                const auto o = s->offsets();
+                Roaring all;
+                all.addRange(0, (o.dirty_offset - o.base_offset)() + 1);
+                return do_copy_segment_data(
+                  s,
+                  cfg,
+                  pb,
+                  std::move(h),
+                  compacted_offset_list(o.base_offset, std::move(all)));
+            })
+            .then([s, cfg, &pb](storage::index_state idx) {
+                return swap_compacted_segment(s, cfg, pb, std::move(idx));
             });
-      })
-      .then([cfg, s, &pb](std::tuple<index_state, ss::rwlock::holder> h) {
-          return s->index()
-            .drop_all_data()
-            .then([s, cfg, &pb] {
-                auto compacted_file = data_segment_staging_name(s);
-                return do_swap_data_file_handles(compacted_file, s, cfg, pb);
+      });
+}
+
+struct compacted_index_summary {
+    std::optional<key_bloom_filter> filter;
+    compacted_index::footer_flags flags{compacted_index::footer_flags::none};
+};
+
+static ss::future<compacted_index_summary> load_compacted_index_summary(
+  const ss::lw_shared_ptr<segment>& s, compaction_config cfg) {
+    auto idx_path = compacted_index_path(s->reader().filename().c_str());
+    return make_reader_handle(idx_path, cfg.sanitize)
+      .then([cfg, idx_path](ss::file f) mutable {
+          auto reader = make_file_backed_compacted_reader(
+            idx_path.string(), std::move(f), cfg.iopc, 64_KiB);
+          return reader.load_key_filter()
+            .then([reader](std::optional<key_bloom_filter> filter) mutable {
+                // the footer was read with the filter
+                return reader.load_footer().then(
+                  [filter = std::move(filter)](
+                    compacted_index::footer footer) mutable {
+                      return compacted_index_summary{
+                        .filter = std::move(filter), .flags = footer.flags};
+                  });
             })
-            .then([h = std::move(h), s]() mutable {
-                auto& [idx, lock] = h;
-                s->index().swap_index_state(std::move(idx));
-                s->force_set_commit_offset_from_index();
-                // FIXME(noah): crashes if we evic the cache
-                // s->cache().purge();
-                return s->index().flush().finally([l = std::move(lock)] {});
+            .finally([reader]() mutable {
+                return reader.close().then_wrapped([](ss::future<>) {});
+            });
+      });
+}
+
+/// tombstones of a segment expire with the segment, once its newest record
+/// is past the eviction time of the compaction
+static bool may_expire_tombstones(
+  const ss::lw_shared_ptr<segment>& s,
+  compacted_index::footer_flags flags,
+  compaction_config cfg) {
+    return bool(flags & compacted_index::footer_flags::tombstones)
+           && !s->finished_tombstone_expiry()
+           && s->index().max_timestamp() < cfg.eviction_time;
+}
+
+/// true if any key with a newer value than `last` may be in the filter
+static ss::future<bool> may_hold_superseded_keys(
+  const key_bloom_filter& filter,
+  const key_offset_map& map,
+  model::offset last) {
+    return ss::do_with(
+      map.offsets.begin(),
+      false,
+      [&filter, &map, last](
+        key_offset_map::underlying_t::const_iterator& it, bool& found) {
+          return ss::do_until(
+                   [&] { return found || it == map.offsets.end(); },
+                   [&] {
+                       // bounded steps so large maps do not stall the reactor
+                       for (size_t i = 0; i < 1024 && !found; ++i) {
+                           if (it == map.offsets.end()) {
+                               break;
+                           }
+                           found = it->second > last
+                                   && filter.may_contain(it->first);
+                           ++it;
+                       }
+                       return ss::now();
+                   })
+            .then([&found] { return found; });
+      });
+}
+
+/// \brief every record of `s` is superseded. the data is dropped without
+/// reading it, the segment keeps its offsets and reads as empty
+static ss::future<storage::index_state> drop_segment_data(
+  ss::lw_shared_ptr<segment> s, compaction_config cfg, ss::rwlock::holder h) {
+    return make_handle(
+             data_segment_staging_name(s),
+             ss::open_flags::rw | ss::open_flags::create
+               | ss::open_flags::truncate,
+             writer_opts(),
+             cfg.sanitize)
+      .then([](ss::file f) { return f.close().finally([f] {}); })
+      .then([s, h = std::move(h)] {
+          const auto& segidx = s->index();
+          storage::index_state idx;
+          idx.base_offset = s->offsets().base_offset;
+          idx.max_offset = s->offsets().dirty_offset;
+          idx.base_timestamp = segidx.base_timestamp();
+          idx.max_timestamp = segidx.max_timestamp();
+          return idx;
+      });
+}
+
+/// \brief drops the records of `s` that the map proves to be superseded,
+/// and its tombstones if `expire` is set
+static ss::future<> do_cross_compact_segment(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  storage::probe& pb,
+  const key_offset_map& map,
+  bool expire) {
+    return s->read_lock().then([cfg, s, &pb, &map, expire](
+                                 ss::rwlock::holder h) {
+        if (s->is_closed()) {
+            return ss::make_exception_future<>(segment_closed_exception());
+        }
+        return consume_compacted_index(
+                 s,
+                 cfg,
+                 cross_compacted_offset_list_reducer(
+                   s->offsets().base_offset, map, expire))
+          .then([cfg, s, &pb, expire, h = std::move(h)](
+                  std::optional<compacted_offset_list> list) mutable {
+              if (!list) {
+                  return ss::now();
+              }
+              using drop_tombstones
+                = copy_data_segment_reducer::drop_tombstones;
+              auto f = list->empty()
+                         ? drop_segment_data(s, cfg, std::move(h))
+                         : do_copy_segment_data(
+                           s,
+                           cfg,
+                           pb,
+                           std::move(h),
+                           std::move(*list),
+                           drop_tombstones(expire));
+              return f
+                .then([s, cfg, &pb](storage::index_state idx) {
+                    pb.segment_compacted();
+                    return swap_compacted_segment(s, cfg, pb, std::move(idx));
+                })
+                .then([s, expire] {
+                    if (expire) {
+                        s->mark_as_finished_tombstone_expiry();
+                    }
+                });
+          });
+    });
+}
+
+/// `indexed` is set if the map holds every key of `s` and of the segments
+/// before it, which were cross compacted first. only then no older value of
+/// a key is left behind its tombstone in `s`, and the tombstone may expire
+static ss::future<> cross_compact_segment(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  storage::probe& pb,
+  const key_offset_map& map,
+  bool indexed) {
+    // the footer and key filter of the index lets us skip reading the whole
+    // index of segments that hold neither tombstones to expire nor any of
+    // the keys rewritten by newer segments
+    return load_compacted_index_summary(s, cfg).then(
+      [s, cfg, &pb, &map, indexed](compacted_index_summary summary) {
+          const bool expire = indexed
+                              && may_expire_tombstones(s, summary.flags, cfg);
+          auto f = ss::make_ready_future<bool>(true);
+          if (!expire && summary.filter) {
+              f = ss::do_with(
+                std::move(*summary.filter),
+                [s, &map](const key_bloom_filter& f) {
+                    return may_hold_superseded_keys(
+                      f, map, s->offsets().dirty_offset);
+                });
+          }
+          return f.then([s, cfg, &pb, &map, expire](bool candidate) {
+              if (!candidate) {
+                  vlog(
+                    stlog.trace,
+                    "skipping cross compaction of {}, no superseded keys",
+                    s->reader().filename());
+                  return ss::now();
+              }
+              return do_cross_compact_segment(s, cfg, pb, map, expire);
+          });
+      });
+}
+
+ss::future<> cross_compact_segments(
+  std::vector<ss::lw_shared_ptr<segment>> segs,
+  compaction_config cfg,
+  storage::probe& pb,
+  size_t max_memory) {
+    return ss::do_with(
+      std::move(segs),
+      key_offset_map{},
+      size_t(0),
+      size_t(0),
+      [cfg, &pb, max_memory](
+        std::vector<ss::lw_shared_ptr<segment>>& segs,
+        key_offset_map& map,
+        size_t& covered,
+        size_t& indexed) {
+          // 1. oldest to newest, index keys until the map is out of memory
+          auto index_keys = [cfg, max_memory, &segs, &map, &covered, &indexed] {
+              if (covered == segs.size() || cfg.asrc->abort_requested()) {
+                  return ss::make_ready_future<ss::stop_iteration>(
+                    ss::stop_iteration::yes);
+              }
+              return consume_compacted_index(
+                       segs[covered],
+                       cfg,
+                       compaction_key_map_reducer(map, max_memory))
+                .then([&covered, &indexed](bool complete) {
+                    ++covered;
+                    if (complete) {
+                        indexed = covered;
+                    }
+                    return ss::stop_iteration(!complete);
+                });
+          };
+          return ss::repeat(std::move(index_keys))
+            .then([cfg, &pb, &segs, &map, &covered, &indexed] {
+                vlog(
+                  stlog.debug,
+                  "cross compacting {} segments with {} keys ({} bytes)",
+                  covered,
+                  map.offsets.size(),
+                  map.memory_usage());
+                // 2. rewrite the indexed segments that hold stale records
+                return ss::do_for_each(
+                  segs.begin(),
+                  std::next(segs.begin(), covered),
+                  [cfg, &pb, &segs, &map, &indexed](
+                    ss::lw_shared_ptr<segment>& s) {
+                      if (cfg.asrc->abort_requested()) {
+                          return ss::now();
+                      }
+                      const bool all_keys = size_t(&s - segs.data()) < indexed;
+                      return cross_compact_segment(s, cfg, pb, map, all_keys);
+                  });
             });
       });
 }
@@ -429,11 +827,12 @@ ss::future<> rebuild_compaction_index(
   std::filesystem::path p,
   compaction_config cfg) {
     return make_compacted_index_writer(p, cfg.sanitize, cfg.iopc)
-      .then([r = std::move(rdr)](compacted_index_writer w) mutable {
+      .then([r = std::move(rdr), cfg](compacted_index_writer w) mutable {
           auto u = std::make_unique<compacted_index_writer>(std::move(w));
           auto ptr = u.get();
           return std::move(r)
-            .consume(index_rebuilder_reducer(ptr), model::no_timeout)
+            .consume(
+              index_rebuilder_reducer(ptr, cfg.throttle), model::no_timeout)
             .then_wrapped([x = std::move(u)](ss::future<> fut) mutable {
                 return x->close()
                   .handle_exception([](std::exception_ptr e) {
@@ -35,6 +35,27 @@ ss::future<> self_compact_segment(
   storage::compaction_config,
   storage::probe&);
 
+/// \brief deduplicates keys across adjacent, self-compacted segments.
+///
+/// A map of the latest offset of every key is built from the compacted
+/// indices of `segs`, oldest first, until it reaches `max_memory`. Every
+/// segment covered by the map is then rewritten without the records that have
+/// a newer value for their key. Acquires its own locks on the segments.
+ss::future<> cross_compact_segments(
+  std::vector<ss::lw_shared_ptr<storage::segment>>,
+  storage::compaction_config,
+  storage::probe&,
+  size_t max_memory);
+
+/// \brief rewrites the data batches of a closed segment in the codec of
+/// `cfg.compression`. The segment is read once to find a batch in another
+/// codec, it is left as it is if there is none. Acquires its own locks on the
+/// segment.
+ss::future<> recompress_segment(
+  ss::lw_shared_ptr<storage::segment>,
+  storage::compaction_config,
+  storage::probe&);
+
 /// make file handle with default opts
 ss::future<ss::file>
 make_writer_handle(const std::filesystem::path&, storage::debug_sanitize_files);
@@ -47,11 +68,15 @@ ss::future<compacted_index_writer> make_compacted_index_writer(
   storage::debug_sanitize_files debug,
   ss::io_priority_class iopc);
 
+/// \param falloc_step bytes the file grows by, a writer knowing roughly how
+/// much it writes fallocates it at once
 ss::future<segment_appender_ptr> make_segment_appender(
   const std::filesystem::path& path,
   storage::debug_sanitize_files debug,
   size_t number_of_chunks,
-  ss::io_priority_class iopc);
+  ss::io_priority_class iopc,
+  size_t falloc_step = segment_appender::fallocation_step,
+  size_t preallocated = 0);
 
 size_t number_of_chunks_from_config(const storage::ntp_config&);
 
@@ -104,6 +129,15 @@ ss::future<> do_swap_data_file_handles(
 
 std::filesystem::path compacted_index_path(std::filesystem::path segment_path);
 
+/// \brief copies the data file of a closed segment to `dir` of the storage
+/// tier and reads the segment from there, its index stays local. Takes the
+/// segment write lock
+ss::future<> move_segment_to_cold_storage(
+  ss::lw_shared_ptr<storage::segment>,
+  std::filesystem::path dir,
+  storage::compaction_config,
+  storage::probe&);
+
 using jitter_percents = named_type<int, struct jitter_percents_tag>;
 static constexpr jitter_percents default_segment_size_jitter(5);
 
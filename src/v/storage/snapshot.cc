@@ -22,19 +22,20 @@
 
 namespace storage {
 
-ss::future<std::optional<snapshot_reader>> snapshot_manager::open_snapshot() {
-    auto path = _dir / snapshot_filename;
-    return ss::file_exists(path.string()).then([this, path](bool exists) {
+ss::future<std::optional<snapshot_reader>>
+snapshot_manager::open_snapshot(ss::io_priority_class io_prio) {
+    auto path = snapshot_path();
+    return ss::file_exists(path.string()).then([path, io_prio](bool exists) {
         if (!exists) {
             return ss::make_ready_future<std::optional<snapshot_reader>>(
               std::nullopt);
         }
         return ss::open_file_dma(path.string(), ss::open_flags::ro)
-          .then([this, path](ss::file file) {
+          .then([path, io_prio](ss::file file) {
               // ss::file::~file will automatically close the file. so no
               // worries about leaking an fd if something goes wrong here.
               ss::file_input_stream_options options;
-              options.io_priority_class = _io_prio;
+              options.io_priority_class = io_prio;
               auto input = ss::make_file_input_stream(file, options);
               return ss::make_ready_future<std::optional<snapshot_reader>>(
                 snapshot_reader(file, std::move(input), path));
@@ -47,7 +48,7 @@ ss::future<snapshot_writer> snapshot_manager::start_snapshot() {
     // unique file names when tests run fast.
     auto filename = fmt::format(
       "{}.partial.{}.{}",
-      snapshot_filename,
+      _filename,
       ss::lowres_system_clock::now().time_since_epoch().count(),
       random_generators::gen_alphanum_string(4));
 
@@ -74,7 +75,7 @@ ss::future<> snapshot_manager::finish_snapshot(snapshot_writer& writer) {
 
 ss::future<> snapshot_manager::remove_partial_snapshots() {
     std::regex re(fmt::format(
-      "^{}\\.partial\\.(\\d+)\\.([a-zA-Z0-9]{{4}})$", snapshot_filename));
+      "^{}\\.partial\\.(\\d+)\\.([a-zA-Z0-9]{{4}})$", _filename));
     return directory_walker::walk(
       _dir.string(), [this, re = std::move(re)](ss::directory_entry ent) {
           if (!ent.type || *ent.type != ss::directory_entry_type::regular) {
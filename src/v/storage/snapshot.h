@@ -17,6 +17,7 @@
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/seastar.hh>
+#include <seastar/core/sstring.hh>
 #include <seastar/util/log.hh>
 
 #include <filesystem>
@@ -66,7 +67,10 @@ class snapshot_writer;
  *       snapshot_manager mgr("/path/to/ntp/", io_priority);
  *
  *    All snapshots will be stored in the provided directory, and snapshot
- *    readers and writers will be created using the given io priority.
+ *    readers and writers will be created using the given io priority. State
+ *    kept next to the raft snapshot uses a file name of its own:
+ *
+ *       snapshot_manager mgr("/path/to/ntp/", io_priority, "producers");
  *
  *    Open the current snapshot.
  *
@@ -89,21 +93,30 @@ class snapshot_writer;
  *       mgr.remove_partial_snapshots();
  */
 class snapshot_manager {
-    static constexpr const char* snapshot_filename = "snapshot";
-
 public:
+    static constexpr const char* default_snapshot_filename = "snapshot";
+
     snapshot_manager(
-      std::filesystem::path dir, ss::io_priority_class io_prio) noexcept
+      std::filesystem::path dir,
+      ss::io_priority_class io_prio,
+      ss::sstring filename = default_snapshot_filename) noexcept
       : _dir(std::move(dir))
-      , _io_prio(io_prio) {}
+      , _io_prio(io_prio)
+      , _filename(std::move(filename)) {}
 
-    ss::future<std::optional<snapshot_reader>> open_snapshot();
+    ss::future<std::optional<snapshot_reader>> open_snapshot() {
+        return open_snapshot(_io_prio);
+    }
+    /// Opens the snapshot for reading with a different io priority than the
+    /// one of the manager
+    ss::future<std::optional<snapshot_reader>>
+      open_snapshot(ss::io_priority_class);
 
     ss::future<snapshot_writer> start_snapshot();
     ss::future<> finish_snapshot(snapshot_writer&);
 
     std::filesystem::path snapshot_path() const {
-        return _dir / snapshot_filename;
+        return _dir / _filename.c_str();
     }
 
     ss::future<> remove_partial_snapshots();
@@ -111,6 +124,7 @@ public:
 private:
     std::filesystem::path _dir;
     ss::io_priority_class _io_prio;
+    ss::sstring _filename;
 };
 
 /**
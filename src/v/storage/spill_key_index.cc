@@ -21,6 +21,8 @@
 #include <seastar/core/file.hh>
 #include <seastar/core/future-util.hh>
 
+#include <boost/range/irange.hpp>
+
 #include <fmt/ostream.h>
 
 namespace storage::internal {
@@ -47,75 +49,63 @@ spill_key_index::~spill_key_index() {
 
 ss::future<>
 spill_key_index::index(bytes_view v, model::offset base_offset, int32_t delta) {
-    if (auto it = _midx.find(v); it != _midx.end()) {
-        auto& pair = it->second;
-        if (base_offset > pair.base_offset) {
-            pair.base_offset = base_offset;
-            pair.delta = delta;
-        }
-        return ss::now();
-    }
-    // not found
-    return add_key(bytes(v), value_type{base_offset, delta});
-}
-
-ss::future<> spill_key_index::add_key(bytes b, value_type v) {
-    auto f = ss::now();
-    // we use 2 * map usage to prevent the indices map to grow over
-    // the requested memory limit. We keep the load factor of the map
-    // between 0.874 and 0.86 to prevent if from regrowing. We evict
-    // multiple keys at a time to optimize the number of rehashes
-
-    auto const expected_size = 2 * idx_mem_usage() + _keys_mem_usage + b.size();
-
-    if (expected_size >= _max_mem && _midx.load_factor() > 0.874) {
-        f = ss::do_until(
-              [this] {
-                  // stop condition
-                  return _midx.empty() || _midx.load_factor() <= 0.86;
-              },
-              [this] {
-                  // evict random entry
-                  auto n = random_generators::get_int<size_t>(
-                    0, _midx.size() - 1);
-                  auto mit = std::next(_midx.begin(), n);
-                  auto node = _midx.extract(mit);
-
-                  return ss::do_with(
-                    node.key(),
-                    node.mapped(),
-                    [this](const bytes& k, value_type o) {
-                        _keys_mem_usage -= k.size();
-                        return spill(compacted_index::entry_type::key, k, o);
-                    });
-              })
-              .then([this] { _midx.rehash(0); });
-    }
-
-    return f.then([this, b = std::move(b), v]() mutable {
-        // convert iobuf to key
-        _keys_mem_usage += b.size();
-        _midx.insert({std::move(b), v});
-    });
+    return index_key(v, value_type{base_offset, delta});
 }
 
 ss::future<>
 spill_key_index::index(bytes&& b, model::offset base_offset, int32_t delta) {
-    if (auto it = _midx.find(b); it != _midx.end()) {
-        auto& pair = it->second;
+    return index_key(b, value_type{base_offset, delta});
+}
+
+ss::future<> spill_key_index::index_key(bytes_view k, value_type v) {
+    // only the first max_key_size bytes are persisted, so that is also the
+    // identity of the key in memory
+    k = k.substr(0, std::min(max_key_size, k.size()));
+    if (auto i = _midx.find(k); i != underlying_t::npos) {
         // must use both base+delta, since we only want to keep the latest
         // which might be inserted into the batch multiple times by client
-        const auto record = base_offset + model::offset(delta);
-        const auto current = pair.base_offset + model::offset(pair.delta);
-        if (record > current) {
-            pair.base_offset = base_offset;
-            pair.delta = delta;
+        const auto current = _midx.value_at(i);
+        const auto record = v.base_offset + model::offset(v.delta);
+        if (record > current.base_offset + model::offset(current.delta)) {
+            _midx.set_value_at(i, v);
         }
         return ss::now();
     }
     // not found
-    return add_key(std::move(b), value_type{base_offset, delta});
+    return add_key(k, v);
+}
+
+ss::future<> spill_key_index::add_key(bytes_view b, value_type v) {
+    if (
+      _midx.empty() || _midx.memory_usage_after_insert(b.size()) <= _max_mem) {
+        _midx.insert(b, v);
+        return ss::now();
+    }
+    // the key view is not guaranteed to outlive the eviction
+    return evict_keys().then(
+      [this, key = bytes(b), v] { _midx.insert(key, v); });
 }
+
+ss::future<> spill_key_index::evict_keys() {
+    // spill a random half of the keys and then compact the arena. evicting in
+    // bulk amortizes the cost of compact() over many inserts
+    return ss::do_for_each(
+             boost::irange<size_t>(0, _midx.capacity()),
+             [this](size_t i) {
+                 if (
+                   !_midx.is_live(i)
+                   || random_generators::get_int<int>(0, 1) == 0) {
+                     return ss::now();
+                 }
+                 // the key stays readable in the arena until compact()
+                 auto k = _midx.key_at(i);
+                 auto v = _midx.value_at(i);
+                 _midx.erase_at(i);
+                 return spill(compacted_index::entry_type::key, k, v);
+             })
+      .then([this] { _midx.compact(); });
+}
+
 ss::future<> spill_key_index::index(
   const iobuf& key, model::offset base_offset, int32_t delta) {
     return index(
@@ -151,6 +141,9 @@ ss::future<> spill_key_index::spill(
         size_t key_size = std::min(max_key_size, b.size());
 
         payload.append(b.data(), key_size);
+        if (type == compacted_index::entry_type::key) {
+            _filter.add(b.substr(0, key_size));
+        }
     }
     const size_t size = payload.size_bytes() - size_reservation;
     const size_t size_le = ss::cpu_to_le(size); // downcast
@@ -172,19 +165,18 @@ ss::future<> spill_key_index::spill(
 }
 
 ss::future<> spill_key_index::drain_all_keys() {
-    return ss::do_until(
-      [this] {
-          // stop condition
-          return _midx.empty();
-      },
-      [this] {
-          auto node = _midx.extract(_midx.begin());
-          _keys_mem_usage -= node.key().size();
-          return ss::do_with(
-            node.key(), node.mapped(), [this](const bytes& k, value_type o) {
-                return spill(compacted_index::entry_type::key, k, o);
-            });
-      });
+    return ss::do_for_each(
+             boost::irange<size_t>(0, _midx.capacity()),
+             [this](size_t i) {
+                 if (!_midx.is_live(i)) {
+                     return ss::now();
+                 }
+                 return spill(
+                   compacted_index::entry_type::key,
+                   _midx.key_at(i),
+                   _midx.value_at(i));
+             })
+      .then([this] { _midx.clear(); });
 }
 
 void spill_key_index::set_flag(compacted_index::footer_flags f) {
@@ -208,23 +200,44 @@ ss::future<> spill_key_index::truncate(model::offset o) {
 }
 
 ss::future<> spill_key_index::close() {
-    return drain_all_keys().then([this] {
-        vassert(
-          _keys_mem_usage == 0,
-          "Failed to drain all keys, {} bytes left",
-          _keys_mem_usage);
-        _footer.crc = _crc.value();
-        return ss::do_with(
-                 reflection::to_iobuf(_footer),
-                 [this](iobuf& b) {
-                     vassert(
-                       b.size_bytes() == compacted_index::footer_size,
-                       "Footer is bigger than expected: {}",
-                       b);
-                     return _appender.append(b);
-                 })
-          .then([this] { return _appender.close(); });
-    });
+    return drain_all_keys()
+      .then([this] { return write_filter(); })
+      .then([this] {
+          vassert(
+            _midx.empty(), "Failed to drain all keys, {} left", _midx.size());
+          _footer.crc = _crc.value();
+          return ss::do_with(
+                   reflection::to_iobuf(_footer),
+                   [this](iobuf& b) {
+                       vassert(
+                         b.size_bytes() == compacted_index::footer_size,
+                         "Footer is bigger than expected: {}",
+                         b);
+                       return _appender.append(b);
+                   })
+            .then([this] { return _appender.close(); });
+      });
+}
+
+ss::future<> spill_key_index::write_filter() {
+    if (_filter.empty()) {
+        return ss::now();
+    }
+    set_flag(compacted_index::footer_flags::bloom_filter);
+    iobuf buf = _filter.to_iobuf();
+    crc32 crc;
+    for (auto& f : buf) {
+        crc.extend(f.get(), f.size());
+    }
+    const auto size = ss::cpu_to_le(static_cast<uint32_t>(buf.size_bytes()));
+    const auto crc_le = ss::cpu_to_le(crc.value());
+    // NOLINTNEXTLINE
+    buf.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    // NOLINTNEXTLINE
+    buf.append(reinterpret_cast<const char*>(&crc_le), sizeof(crc_le));
+    _filter = key_bloom_filter{};
+    return ss::do_with(
+      std::move(buf), [this](iobuf& b) { return _appender.append(b); });
 }
 
 void spill_key_index::print(std::ostream& o) const { o << *this; }
@@ -232,11 +245,11 @@ void spill_key_index::print(std::ostream& o) const { o << *this; }
 std::ostream& operator<<(std::ostream& o, const spill_key_index& k) {
     fmt::print(
       o,
-      "{{name:{}, max_mem:{}, key_mem_usage:{}, persisted_entries:{}, "
+      "{{name:{}, max_mem:{}, mem_usage:{}, persisted_entries:{}, "
       "in_memory_entries:{}, file_appender:{}}}",
       k.filename(),
       k._max_mem,
-      k._keys_mem_usage,
+      k._midx.memory_usage(),
       k._footer.keys,
       k._midx.size(),
       k._appender);
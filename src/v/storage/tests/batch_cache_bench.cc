@@ -0,0 +1,91 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/record.h"
+#include "random/generators.h"
+#include "storage/batch_cache.h"
+#include "storage/tests/utils/random_batch.h"
+#include "test_utils/alloc_counter.h"
+#include "units.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <vector>
+
+/// batches of a single index, the cache is large enough to hold all of them
+/// so that nothing but the benchmarked operation evicts
+struct batch_cache_bench {
+    static constexpr int num_batches = 1024;
+
+    static storage::batch_cache::reclaim_options opts() {
+        return {
+          .growth_window = std::chrono::milliseconds(3000),
+          .stable_window = std::chrono::milliseconds(10000),
+          .min_size = 128_KiB,
+          .max_size = 1_GiB,
+        };
+    }
+
+    batch_cache_bench() {
+        for (auto& b : storage::test::make_random_batches(
+               model::offset(0), num_batches, false)) {
+            batches.push_back(std::move(b));
+        }
+    }
+
+    void fill(storage::batch_cache_index& index) {
+        for (auto& b : batches) {
+            index.put(b);
+        }
+    }
+
+    std::vector<model::record_batch> batches;
+};
+
+PERF_TEST_F(batch_cache_bench, put) {
+    storage::batch_cache cache(opts());
+    storage::batch_cache_index index(cache);
+    tests::alloc_counter allocs("batch_cache.put");
+    fill(index);
+    allocs.stop(batches.size());
+}
+
+PERF_TEST_F(batch_cache_bench, get) {
+    storage::batch_cache cache(opts());
+    storage::batch_cache_index index(cache);
+    fill(index);
+    std::vector<model::offset> offsets;
+    offsets.reserve(batches.size());
+    for (size_t i = 0; i < batches.size(); ++i) {
+        const auto& b = batches[random_generators::get_int(
+          batches.size() - 1)];
+        offsets.push_back(b.last_offset());
+    }
+    size_t hits = 0;
+    tests::alloc_counter allocs("batch_cache.get");
+    for (auto o : offsets) {
+        hits += index.get(o).has_value();
+    }
+    allocs.stop(offsets.size());
+    perf_tests::do_not_optimize(hits);
+}
+
+// the low memory path, releases a batch at a time in lru order
+PERF_TEST_F(batch_cache_bench, reclaim) {
+    storage::batch_cache cache(opts());
+    storage::batch_cache_index index(cache);
+    fill(index);
+    tests::alloc_counter allocs("batch_cache.reclaim");
+    size_t reclaims = 0;
+    while (!cache.empty()) {
+        cache.reclaim(1);
+        ++reclaims;
+    }
+    allocs.stop(reclaims);
+}
@@ -260,3 +260,191 @@ SEASTAR_THREAD_TEST_CASE(index_truncate_hole_missing_prev) {
     BOOST_CHECK(!index.get(model::offset(11)));
     BOOST_CHECK(!index.get(model::offset(41)));
 }
+
+SEASTAR_THREAD_TEST_CASE(scan_does_not_evict_hot_entries) {
+    static storage::batch_cache::reclaim_options opts = {
+      .growth_window = std::chrono::milliseconds(3000),
+      .stable_window = std::chrono::milliseconds(10000),
+      .min_size = 1,
+      .max_size = 1,
+    };
+
+    std::unique_ptr<storage::batch_cache_index> index;
+    storage::batch_cache c(opts);
+    index = std::make_unique<storage::batch_cache_index>(c);
+
+    // hot entry is hit after insertion and promoted
+    auto hot = c.put(*index, make_batch(10));
+    c.touch(hot);
+    BOOST_CHECK(c.get_stats().promotions == 1);
+
+    // a read-once scan inserted after the hot entry
+    std::vector<storage::batch_cache::entry_ptr> scan;
+    for (int i = 0; i < 3; i++) {
+        scan.push_back(c.put(*index, make_batch(10)));
+    }
+
+    // reclaim drains the probation segment first
+    for (size_t i = 0; i < scan.size(); i++) {
+        c.reclaim(1);
+        BOOST_CHECK(hot);
+        BOOST_CHECK(!scan[i]);
+    }
+    BOOST_CHECK(c.get_stats().evictions == scan.size());
+
+    c.reclaim(1);
+    BOOST_CHECK(!hot);
+}
+
+SEASTAR_THREAD_TEST_CASE(low_priority_reclaimed_first) {
+    static storage::batch_cache::reclaim_options opts = {
+      .growth_window = std::chrono::milliseconds(3000),
+      .stable_window = std::chrono::milliseconds(10000),
+      .min_size = 1,
+      .max_size = 1,
+    };
+
+    std::unique_ptr<storage::batch_cache_index> index;
+    storage::batch_cache c(opts);
+    index = std::make_unique<storage::batch_cache_index>(c);
+
+    auto normal = c.put(*index, make_batch(10));
+    // replicated by a follower after the batch of the partition it leads
+    auto low = c.put(*index, make_batch(10), storage::cache_priority::low);
+    auto hit = c.put(*index, make_batch(10), storage::cache_priority::low);
+    c.touch(hit);
+
+    c.reclaim(1);
+    BOOST_CHECK(!low);
+    BOOST_CHECK(normal);
+    BOOST_CHECK(hit);
+
+    c.reclaim(1);
+    BOOST_CHECK(!normal);
+    BOOST_CHECK(hit);
+}
+
+SEASTAR_THREAD_TEST_CASE(decompressed_form_follows_entry) {
+    storage::batch_cache c(opts);
+    storage::batch_cache_index index(c);
+
+    // stand-ins for a compressed batch and its decompressed form
+    auto b = make_batch(10);
+    auto d = make_batch(100);
+    index.put(b);
+    BOOST_CHECK(!index.get_decompressed(b));
+
+    index.put_decompressed(b, d);
+    auto r = index.get_decompressed(b);
+    BOOST_REQUIRE(r);
+    BOOST_CHECK_EQUAL(r->record_count(), 100);
+
+    // a rewritten batch at the same offset does not match
+    BOOST_CHECK(!index.get_decompressed(make_batch(11)));
+
+    // a batch that is not cached drops the decompressed form
+    auto other = make_batch(10, model::offset(100));
+    index.put_decompressed(other, d);
+    BOOST_CHECK(!index.get_decompressed(other));
+
+    // both forms are released together
+    auto size = c.reclaim(1);
+    BOOST_CHECK(size > d.memory_usage());
+    BOOST_CHECK(!index.get_decompressed(b));
+    BOOST_CHECK(c.empty());
+}
+
+SEASTAR_THREAD_TEST_CASE(target_follows_memory_signals) {
+    auto adaptive = opts;
+    adaptive.min_target = 1;
+    adaptive.max_target = 1 << 30;
+    storage::batch_cache c(adaptive);
+    storage::batch_cache_index index(c);
+    std::vector<storage::batch_cache::entry_ptr> entries;
+    for (int i = 0; i < 8; i++) {
+        entries.push_back(c.put(index, make_batch(10, model::offset(i))));
+    }
+    const auto cached = c.size_bytes();
+    BOOST_CHECK_EQUAL(c.target_bytes(), adaptive.max_target);
+
+    // plenty of free memory and no reclaims leave the target at its bound
+    storage::batch_cache::memory_signals s{
+      .free_memory = 900, .total_memory = 1000};
+    c.update_target(s);
+    BOOST_CHECK_EQUAL(c.target_bytes(), adaptive.max_target);
+
+    // a reclaim cuts the target below the cached bytes and evicts down to it
+    s.reclaims = 1;
+    c.update_target(s);
+    BOOST_CHECK_LT(c.target_bytes(), cached);
+    BOOST_CHECK_LE(c.size_bytes(), c.target_bytes());
+    BOOST_CHECK(!entries.front());
+    BOOST_CHECK(entries.back());
+
+    // no new reclaim, free memory above the watermark grows it again
+    const auto cut = c.target_bytes();
+    c.update_target(s);
+    BOOST_CHECK_GT(c.target_bytes(), cut);
+
+    // writers waiting for chunks take memory back from the cache
+    const auto grown = c.target_bytes();
+    s.write_waiters = true;
+    c.update_target(s);
+    BOOST_CHECK_LT(c.target_bytes(), grown);
+}
+
+SEASTAR_THREAD_TEST_CASE(fixed_target_ignores_memory_signals) {
+    storage::batch_cache c(opts);
+    storage::batch_cache_index index(c);
+    auto e = c.put(index, make_batch(10));
+    c.update_target(storage::batch_cache::memory_signals{
+      .free_memory = 0, .total_memory = 1000, .reclaims = 10});
+    BOOST_CHECK(e);
+    BOOST_CHECK_EQUAL(c.target_bytes(), std::numeric_limits<size_t>::max());
+}
+
+SEASTAR_THREAD_TEST_CASE(index_read_within_budget) {
+    storage::batch_cache cache(opts);
+    storage::batch_cache_index index(cache);
+
+    // [0:9][10:19][20:29]
+    index.put(make_batch(10, model::offset(0)));
+    index.put(make_batch(10, model::offset(10)));
+    index.put(make_batch(10, model::offset(20)));
+    const size_t size = make_batch(10).size_bytes();
+
+    auto read = [&index](size_t budget, bool strict) {
+        return index.read(
+          model::offset(0),
+          model::offset(100),
+          std::nullopt,
+          std::nullopt,
+          std::numeric_limits<size_t>::max(),
+          false,
+          budget,
+          strict);
+    };
+
+    auto r = read(std::numeric_limits<size_t>::max(), true);
+    BOOST_CHECK_EQUAL(r.batches.size(), 3);
+    BOOST_CHECK_EQUAL(r.size_bytes, 3 * size);
+    BOOST_CHECK(!r.over_budget);
+
+    // stops before the batch that does not fit
+    r = read(2 * size + 1, true);
+    BOOST_CHECK_EQUAL(r.batches.size(), 2);
+    BOOST_CHECK_EQUAL(r.size_bytes, 2 * size);
+    BOOST_CHECK_EQUAL(r.next_batch, model::offset(20));
+    BOOST_CHECK(r.over_budget);
+
+    // the first batch may exceed a budget that is not strict
+    r = read(size - 1, false);
+    BOOST_CHECK_EQUAL(r.batches.size(), 1);
+    BOOST_CHECK_EQUAL(r.next_batch, model::offset(10));
+    BOOST_CHECK(r.over_budget);
+
+    r = read(size - 1, true);
+    BOOST_CHECK(r.batches.empty());
+    BOOST_CHECK_EQUAL(r.next_batch, model::offset(0));
+    BOOST_CHECK(r.over_budget);
+}
@@ -0,0 +1,61 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/committed_offset_monitor.h"
+#include "storage/segment.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+SEASTAR_THREAD_TEST_CASE(committed_offset_already_reached) {
+    ss::abort_source as;
+    storage::committed_offset_monitor m;
+    auto f = m.wait(model::offset(5), model::offset(7), as);
+    BOOST_REQUIRE(f.available());
+    BOOST_CHECK_EQUAL(f.get0(), model::offset(7));
+    BOOST_CHECK(m.empty());
+}
+
+SEASTAR_THREAD_TEST_CASE(waiters_resolve_up_to_committed_offset) {
+    ss::abort_source as;
+    storage::committed_offset_monitor m;
+    auto first = m.wait(model::offset(3), model::offset(1), as);
+    auto second = m.wait(model::offset(10), model::offset(1), as);
+    BOOST_CHECK(!first.available());
+
+    m.notify(model::offset(5));
+    BOOST_REQUIRE(first.available());
+    BOOST_CHECK_EQUAL(first.get0(), model::offset(5));
+    BOOST_CHECK(!second.available());
+    BOOST_CHECK(!m.empty());
+
+    m.notify(model::offset(10));
+    BOOST_CHECK_EQUAL(second.get0(), model::offset(10));
+    BOOST_CHECK(m.empty());
+}
+
+SEASTAR_THREAD_TEST_CASE(abort_fails_the_waiter) {
+    ss::abort_source as;
+    storage::committed_offset_monitor m;
+    auto f = m.wait(model::offset(3), model::offset(1), as);
+    as.request_abort();
+    BOOST_CHECK_THROW(f.get(), ss::abort_requested_exception);
+    BOOST_CHECK(m.empty());
+    // notifying after the abort does not touch the erased waiter
+    m.notify(model::offset(3));
+}
+
+SEASTAR_THREAD_TEST_CASE(stop_fails_the_waiters) {
+    ss::abort_source as;
+    storage::committed_offset_monitor m;
+    auto f = m.wait(model::offset(3), model::offset(1), as);
+    m.stop();
+    BOOST_CHECK_THROW(f.get(), storage::segment_closed_exception);
+    BOOST_CHECK(m.empty());
+}
@@ -9,6 +9,7 @@
 
 #include "model/fundamental.h"
 #include "random/generators.h"
+#include "storage/arena_key_index.h"
 #include "storage/compacted_index.h"
 #include "storage/compaction_reducers.h"
 
@@ -37,3 +38,63 @@ PERF_TEST_F(reducer_bench, compaction_key_reducer_test) {
         perf_tests::stop_measuring_time();
     });
 }
+
+/// compares the spill_key_index table with the node map it replaced. keys are
+/// the typical small producer keys for which per-node overhead dominates
+struct key_index_bench {
+    static constexpr size_t key_count = 100'000;
+    using value_type = storage::internal::arena_key_index::value_type;
+
+    key_index_bench() {
+        keys.reserve(key_count);
+        for (size_t i = 0; i < key_count; ++i) {
+            keys.push_back(random_generators::get_bytes(16));
+        }
+    }
+
+    std::vector<bytes> keys;
+};
+
+PERF_TEST_F(key_index_bench, node_hash_map_insert) {
+    absl::node_hash_map<bytes, value_type, bytes_type_hash, bytes_type_eq> m;
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        m.emplace(keys[i], value_type{model::offset(i), 0});
+    }
+    perf_tests::do_not_optimize(m);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(key_index_bench, arena_key_index_insert) {
+    storage::internal::arena_key_index idx;
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        idx.insert(keys[i], value_type{model::offset(i), 0});
+    }
+    perf_tests::do_not_optimize(idx);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(key_index_bench, node_hash_map_lookup) {
+    absl::node_hash_map<bytes, value_type, bytes_type_hash, bytes_type_eq> m;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        m.emplace(keys[i], value_type{model::offset(i), 0});
+    }
+    perf_tests::start_measuring_time();
+    for (auto& k : keys) {
+        perf_tests::do_not_optimize(m.find(k));
+    }
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(key_index_bench, arena_key_index_lookup) {
+    storage::internal::arena_key_index idx;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        idx.insert(keys[i], value_type{model::offset(i), 0});
+    }
+    perf_tests::start_measuring_time();
+    for (auto& k : keys) {
+        perf_tests::do_not_optimize(idx.find(k));
+    }
+    perf_tests::stop_measuring_time();
+}
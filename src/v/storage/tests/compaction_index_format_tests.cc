@@ -74,14 +74,21 @@ FIXTURE_TEST(format_verification_max_key, compacted_topic_fixture) {
      * Length of an entry is equal to
      *
      * max_key_size + sizeof(uint8_t) + sizeof(uint16_t) + vint(42) + vint(66)
+     *
+     * followed by the key filter and its trailer
      */
     iobuf data = std::move(index_data).release_iobuf();
+    storage::key_bloom_filter filter;
+    filter.add(bytes_view(
+      key.data(), storage::internal::spill_key_index::max_key_size));
 
     BOOST_REQUIRE_EQUAL(
       data.size_bytes(),
       storage::compacted_index::footer_size
         + std::numeric_limits<uint16_t>::max() - 2 * vint::max_length
-        + vint::vint_size(42) + vint::vint_size(66) + 1 + 2);
+        + vint::vint_size(42) + vint::vint_size(66) + 1 + 2
+        + filter.to_iobuf().size_bytes()
+        + storage::compacted_index::filter_trailer_size);
     iobuf_parser p(data.share(0, data.size_bytes()));
 
     const size_t entry = p.consume_type<uint16_t>(); // SIZE
@@ -344,3 +351,201 @@ FIXTURE_TEST(index_filtered_copy_tests, compacted_topic_fixture) {
         }
     }
 }
+
+FIXTURE_TEST(key_map_reducer_drops_older_offsets, compacted_topic_fixture) {
+    tmpbuf_file::store_t index_data;
+    auto idx = storage::make_file_backed_compacted_index(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      1_KiB);
+
+    const auto key1 = random_generators::get_bytes(128);
+    const auto key2 = random_generators::get_bytes(128);
+    for (auto i = 0; i < 10; ++i) {
+        idx.index(i % 2 ? key1 : key2, model::offset(i), 0).get();
+    }
+    idx.close().get();
+
+    // a newer segment with a later value for key1 only
+    storage::internal::key_offset_map map;
+    map.keys_mem_usage += key1.size();
+    map.offsets.emplace(key1, model::offset(100));
+
+    auto rdr = storage::make_file_backed_compacted_reader(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      32_KiB);
+    auto complete = rdr
+                      .consume(
+                        storage::internal::compaction_key_map_reducer(map),
+                        model::no_timeout)
+                      .get0();
+    BOOST_REQUIRE(complete);
+    BOOST_REQUIRE_EQUAL(map.offsets.size(), 2);
+    BOOST_REQUIRE_EQUAL(map.offsets[key1], model::offset(100));
+    BOOST_REQUIRE_EQUAL(map.offsets[key2], model::offset(8));
+
+    rdr.reset();
+    auto list = rdr
+                  .consume(
+                    storage::internal::cross_compacted_offset_list_reducer(
+                      model::offset(0), map),
+                    model::no_timeout)
+                  .get0();
+    BOOST_REQUIRE(list);
+    BOOST_REQUIRE(list->contains(model::offset(8)));
+    for (auto i = 0; i < 10; ++i) {
+        if (i != 8) {
+            BOOST_REQUIRE(!list->contains(model::offset(i)));
+        }
+    }
+}
+
+FIXTURE_TEST(cross_compacted_list_for_tombstones, compacted_topic_fixture) {
+    tmpbuf_file::store_t index_data;
+    auto idx = storage::make_file_backed_compacted_index(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      1_KiB);
+    const auto key = random_generators::get_bytes(128);
+    idx.index(key, model::offset(0), 0).get();
+    idx.set_flag(storage::compacted_index::footer_flags::tombstones);
+    idx.close().get();
+
+    auto rdr = storage::make_file_backed_compacted_reader(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      32_KiB);
+    auto footer = rdr.load_footer().get0();
+    BOOST_REQUIRE(bool(
+      footer.flags & storage::compacted_index::footer_flags::tombstones));
+
+    // no newer segment holds the key
+    storage::internal::key_offset_map map;
+    using reducer_t = storage::internal::cross_compacted_offset_list_reducer;
+    rdr.reset();
+    auto unchanged = rdr
+                       .consume(
+                         reducer_t(model::offset(0), map), model::no_timeout)
+                       .get0();
+    BOOST_REQUIRE(!unchanged);
+
+    // a segment whose tombstones expire is rewritten anyway
+    rdr.reset();
+    auto list = rdr
+                  .consume(
+                    reducer_t(model::offset(0), map, true), model::no_timeout)
+                  .get0();
+    BOOST_REQUIRE(list);
+    BOOST_REQUIRE(!list->empty());
+    BOOST_REQUIRE(list->contains(model::offset(0)));
+
+    // every record superseded, the list keeps nothing
+    map.keys_mem_usage += key.size();
+    map.offsets.emplace(key, model::offset(10));
+    rdr.reset();
+    auto superseded = rdr
+                        .consume(
+                          reducer_t(model::offset(0), map), model::no_timeout)
+                        .get0();
+    BOOST_REQUIRE(superseded);
+    BOOST_REQUIRE(superseded->empty());
+}
+
+FIXTURE_TEST(arena_key_index_insert_find_compact, compacted_topic_fixture) {
+    using storage::internal::arena_key_index;
+    arena_key_index idx;
+    std::vector<bytes> keys;
+    for (auto i = 0; i < 1000; ++i) {
+        keys.push_back(random_generators::get_bytes(20 + i % 7));
+        idx.insert(keys.back(), {model::offset(i), i % 3});
+    }
+    BOOST_REQUIRE_EQUAL(idx.size(), keys.size());
+    for (auto i = 0; i < 1000; ++i) {
+        auto slot = idx.find(keys[i]);
+        BOOST_REQUIRE(slot != arena_key_index::npos);
+        BOOST_REQUIRE_EQUAL(idx.key_at(slot), bytes_view(keys[i]));
+        BOOST_REQUIRE_EQUAL(idx.value_at(slot).base_offset, model::offset(i));
+        BOOST_REQUIRE_EQUAL(idx.value_at(slot).delta, i % 3);
+    }
+    BOOST_REQUIRE_EQUAL(
+      idx.find(random_generators::get_bytes(19)), arena_key_index::npos);
+
+    // erase the even keys and reclaim their arena space
+    for (auto i = 0; i < 1000; i += 2) {
+        idx.erase_at(idx.find(keys[i]));
+    }
+    const auto before = idx.memory_usage();
+    idx.compact();
+    BOOST_REQUIRE_EQUAL(idx.size(), 500);
+    BOOST_REQUIRE_LE(idx.memory_usage(), before);
+    for (auto i = 0; i < 1000; ++i) {
+        BOOST_REQUIRE_EQUAL(
+          idx.find(keys[i]) == arena_key_index::npos, i % 2 == 0);
+    }
+    idx.clear();
+    BOOST_REQUIRE(idx.empty());
+    BOOST_REQUIRE_EQUAL(idx.memory_usage(), 0);
+}
+
+FIXTURE_TEST(key_bloom_filter_roundtrip, compacted_topic_fixture) {
+    storage::key_bloom_filter filter;
+    std::vector<bytes> keys;
+    // enough keys to span several blocks
+    for (auto i = 0; i < 2000; ++i) {
+        keys.push_back(random_generators::get_bytes(32));
+        filter.add(keys.back());
+    }
+    auto copy = storage::key_bloom_filter::from_iobuf(filter.to_iobuf());
+    BOOST_REQUIRE(copy);
+    size_t false_positives = 0;
+    for (auto i = 0; i < 2000; ++i) {
+        BOOST_REQUIRE(copy->may_contain(keys[i]));
+        false_positives += copy->may_contain(
+          random_generators::get_bytes(32));
+    }
+    BOOST_REQUIRE_LT(false_positives, 100);
+
+    // truncated buffers are rejected instead of misread
+    auto buf = filter.to_iobuf();
+    buf.trim_back(8);
+    BOOST_REQUIRE(!storage::key_bloom_filter::from_iobuf(std::move(buf)));
+}
+
+FIXTURE_TEST(index_writes_key_filter, compacted_topic_fixture) {
+    tmpbuf_file::store_t index_data;
+    auto idx = storage::make_file_backed_compacted_index(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      1_KiB);
+    std::vector<bytes> keys;
+    for (auto i = 0; i < 100; ++i) {
+        keys.push_back(random_generators::get_bytes(64));
+        idx.index(keys.back(), model::offset(i), 0).get();
+    }
+    idx.close().get();
+
+    auto rdr = storage::make_file_backed_compacted_reader(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      32_KiB);
+    rdr.verify_integrity().get();
+    auto footer = rdr.load_footer().get0();
+    BOOST_REQUIRE(
+      (footer.flags & storage::compacted_index::footer_flags::bloom_filter)
+      == storage::compacted_index::footer_flags::bloom_filter);
+    auto filter = rdr.load_key_filter().get0();
+    BOOST_REQUIRE(filter);
+    for (auto& k : keys) {
+        BOOST_REQUIRE(filter->may_contain(k));
+    }
+    // the entries are unaffected by the filter
+    auto vec = compaction_index_reader_to_memory(rdr).get0();
+    BOOST_REQUIRE_EQUAL(vec.size(), 100);
+}
@@ -0,0 +1,57 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/compaction_throttle.h"
+#include "units.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(unthrottled_by_default) {
+    storage::compaction_throttle t;
+    BOOST_CHECK_EQUAL(t.current_rate(), 0);
+    BOOST_CHECK(t.throttle(1_GiB).available());
+}
+
+SEASTAR_THREAD_TEST_CASE(burst_then_wait) {
+    ss::abort_source as;
+    storage::compaction_throttle t({.max_bytes_per_sec = 1_MiB}, as);
+    BOOST_CHECK_EQUAL(t.current_rate(), 1_MiB);
+
+    // one second worth of bytes is available up front
+    BOOST_CHECK(t.throttle(1_MiB).available());
+
+    // the bucket is empty, so the next call has to wait
+    auto f = t.throttle(1_MiB);
+    BOOST_CHECK(!f.available());
+
+    // abort releases waiters early
+    as.request_abort();
+    f.get();
+}
+
+SEASTAR_THREAD_TEST_CASE(backs_off_on_slow_foreground) {
+    ss::abort_source as;
+    storage::compaction_throttle t(
+      {.max_bytes_per_sec = 1_MiB, .target_latency = 10ms}, as);
+
+    t.record_foreground_latency(100ms);
+    ss::sleep(storage::compaction_throttle::window + 20ms).get();
+    t.throttle(1).get();
+    BOOST_CHECK_EQUAL(t.current_rate(), 1_MiB / 2);
+
+    // fast foreground operations let the rate recover
+    t.record_foreground_latency(1ms);
+    ss::sleep(storage::compaction_throttle::window + 20ms).get();
+    t.throttle(1).get();
+    BOOST_CHECK_EQUAL(t.current_rate(), (1_MiB * 60) / 100);
+}
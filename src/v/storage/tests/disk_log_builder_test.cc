@@ -17,6 +17,7 @@
 #include <seastar/core/file.hh>
 #include <seastar/core/reactor.hh>
 
+#include <algorithm>
 #include <optional>
 
 FIXTURE_TEST(kitchen_sink, log_builder_fixture) {
@@ -126,3 +127,58 @@ FIXTURE_TEST(iterator_invalidation, log_builder_fixture) {
     BOOST_REQUIRE_EQUAL(config_batches.size(), 2);
     BOOST_REQUIRE_EQUAL(all_batches.size(), 4);
 }
+
+FIXTURE_TEST(read_pins_hold_off_destructive_ops, log_builder_fixture) {
+    using namespace storage; // NOLINT
+    b | start() | add_segment(0)
+      | add_random_batch(0, 10, maybe_compress_batches::no) | add_segment(10)
+      | add_random_batch(10, 10, maybe_compress_batches::no);
+    auto& sealed = b.get_segment(0);
+    sealed.release_appender().get();
+    // the active segment is always locked
+    BOOST_REQUIRE(!b.get_segment(1).try_pin_read());
+
+    auto pin = sealed.try_pin_read();
+    BOOST_REQUIRE(pin);
+    BOOST_REQUIRE(sealed.has_outstanding_locks());
+    auto lock = sealed.write_lock();
+    BOOST_REQUIRE(!lock.available());
+    // readers arriving after the writer wait behind it
+    BOOST_REQUIRE(!sealed.try_pin_read());
+    pin = std::nullopt;
+    lock.get0();
+    BOOST_REQUIRE(!sealed.has_outstanding_locks());
+    BOOST_REQUIRE(sealed.try_pin_read());
+
+    // reads across both segments see all batches
+    auto batches = b.consume().get0();
+    b | stop();
+    BOOST_REQUIRE_EQUAL(batches.size(), 2);
+}
+
+FIXTURE_TEST(segment_set_lookups, log_builder_fixture) {
+    using namespace storage; // NOLINT
+    b | start();
+    for (int i = 0; i < 20; ++i) {
+        b | add_segment(i * 10)
+          | add_random_batch(i * 10, 10, maybe_compress_batches::no);
+    }
+    auto& segs = b.get_log_segments();
+    auto linear_find = [&segs](model::offset o) {
+        return std::find_if(segs.begin(), segs.end(), [o](const auto& s) {
+            return !s->empty() && s->offsets().base_offset <= o
+                   && o <= s->offsets().dirty_offset;
+        });
+    };
+    for (int o = -1; o < 210; ++o) {
+        BOOST_REQUIRE(
+          segs.lower_bound(model::offset(o)) == linear_find(model::offset(o)));
+    }
+    for (auto& s : segs) {
+        auto ts = s->index().max_timestamp();
+        auto it = segs.lower_bound(ts);
+        BOOST_REQUIRE(it != segs.end());
+        BOOST_REQUIRE((*it)->index().max_timestamp() >= ts);
+    }
+    b | stop();
+}
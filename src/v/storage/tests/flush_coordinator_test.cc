@@ -0,0 +1,63 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/flush_coordinator.h"
+#include "utils/tmpbuf_file.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+static ss::file make_file(tmpbuf_file::store_t& store) {
+    return ss::file(ss::make_shared(tmpbuf_file(store)));
+}
+
+SEASTAR_THREAD_TEST_CASE(same_file_shares_one_sync) {
+    storage::internal::flush_coordinator c;
+    tmpbuf_file::store_t store;
+    auto f = make_file(store);
+    int owner = 0;
+
+    auto f0 = c.flush(&owner, f);
+    auto f1 = c.flush(&owner, f);
+    auto f2 = c.flush(&owner, f);
+    ss::when_all_succeed(std::move(f0), std::move(f1), std::move(f2)).get();
+
+    BOOST_CHECK_EQUAL(c.get_stats().requests, 3);
+    BOOST_CHECK_EQUAL(c.get_stats().syncs, 1);
+    BOOST_CHECK_EQUAL(c.get_stats().batches, 1);
+    BOOST_CHECK_EQUAL(c.get_stats().coalesced(), 2);
+}
+
+SEASTAR_THREAD_TEST_CASE(files_are_synced_in_one_batch) {
+    storage::internal::flush_coordinator c;
+    c.set_window(std::chrono::milliseconds(5));
+    tmpbuf_file::store_t s0, s1;
+    int o0 = 0, o1 = 0;
+
+    auto f0 = c.flush(&o0, make_file(s0));
+    auto f1 = c.flush(&o1, make_file(s1));
+    BOOST_CHECK(!f0.available());
+    ss::when_all_succeed(std::move(f0), std::move(f1)).get();
+
+    BOOST_CHECK_EQUAL(c.get_stats().syncs, 2);
+    BOOST_CHECK_EQUAL(c.get_stats().batches, 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(request_after_dispatch_gets_a_new_sync) {
+    storage::internal::flush_coordinator c;
+    tmpbuf_file::store_t store;
+    auto f = make_file(store);
+    int owner = 0;
+
+    c.flush(&owner, f).get();
+    c.flush(&owner, f).get();
+
+    BOOST_CHECK_EQUAL(c.get_stats().syncs, 2);
+    BOOST_CHECK_EQUAL(c.get_stats().batches, 2);
+}
@@ -0,0 +1,108 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "random/generators.h"
+#include "storage/hugepage_arena.h"
+#include "storage/segment_appender_chunk.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+/// walks cached buffers in a random order, touching a few bytes of each, the
+/// way lookups of a large batch cache do. the buffers of the heap are spread
+/// by the allocations interleaved with them, the ones of the arena are packed
+/// into huge pages. the time difference is mostly the TLB misses, run the
+/// cases under `perf stat -e dTLB-load-misses` to count them
+struct hugepage_bench {
+    using chunk = storage::segment_appender_chunk;
+    using chunk_ptr = std::unique_ptr<chunk>;
+
+    static constexpr size_t cache_bytes = 64_MiB;
+    static constexpr size_t alignment = 4_KiB;
+    static constexpr size_t num_chunks = cache_bytes / chunk::chunk_size;
+    static constexpr size_t fragment_size = 1_KiB;
+    static constexpr size_t num_fragments = cache_bytes / fragment_size;
+
+    hugepage_bench() {
+        arena.start(2 * cache_bytes);
+        auto data = random_generators::gen_alphanum_string(fragment_size);
+        iobuf fragment;
+        fragment.append(data.data(), data.size());
+        for (size_t i = 0; i < num_chunks; ++i) {
+            heap_chunks.push_back(std::make_unique<chunk>(alignment));
+            spread();
+            arena_chunks.push_back(std::make_unique<chunk>(
+              alignment, arena, arena.allocate(chunk::chunk_size)));
+        }
+        for (size_t i = 0; i < num_fragments; ++i) {
+            heap_fragments.push_back(fragment.copy());
+            spread();
+            arena_fragments.push_back(arena.copy(fragment));
+        }
+        order.resize(std::max(num_chunks, num_fragments));
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937(0));
+    }
+
+    /// an allocation of a random size between two cached buffers
+    void spread() {
+        filler.push_back(std::make_unique<char[]>(
+          random_generators::get_int<size_t>(1_KiB, 32_KiB)));
+    }
+
+    void walk_chunks(const std::vector<chunk_ptr>& chunks) {
+        size_t sum = 0;
+        perf_tests::start_measuring_time();
+        for (auto i : order) {
+            if (i < chunks.size()) {
+                const auto* d = chunks[i]->data();
+                sum += d[0] + d[chunk::chunk_size / 2];
+            }
+        }
+        perf_tests::do_not_optimize(sum);
+        perf_tests::stop_measuring_time();
+    }
+
+    void walk_fragments(const std::vector<iobuf>& fragments) {
+        size_t sum = 0;
+        perf_tests::start_measuring_time();
+        for (auto i : order) {
+            for (const auto& f : fragments[i]) {
+                sum += f.get()[0] + f.get()[f.size() - 1];
+            }
+        }
+        perf_tests::do_not_optimize(sum);
+        perf_tests::stop_measuring_time();
+    }
+
+    storage::internal::hugepage_arena arena;
+    std::vector<chunk_ptr> heap_chunks;
+    std::vector<chunk_ptr> arena_chunks;
+    std::vector<iobuf> heap_fragments;
+    std::vector<iobuf> arena_fragments;
+    std::vector<std::unique_ptr<char[]>> filler;
+    std::vector<size_t> order;
+};
+
+PERF_TEST_F(hugepage_bench, heap_chunks) { walk_chunks(heap_chunks); }
+
+PERF_TEST_F(hugepage_bench, arena_chunks) { walk_chunks(arena_chunks); }
+
+PERF_TEST_F(hugepage_bench, heap_fragments) {
+    walk_fragments(heap_fragments);
+}
+
+PERF_TEST_F(hugepage_bench, arena_fragments) {
+    walk_fragments(arena_fragments);
+}
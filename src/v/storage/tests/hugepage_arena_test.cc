@@ -0,0 +1,89 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf_parser.h"
+#include "random/generators.h"
+#include "storage/hugepage_arena.h"
+#include "storage/segment_appender_chunk.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <cstdint>
+#include <vector>
+
+using storage::internal::hugepage_arena;
+
+SEASTAR_THREAD_TEST_CASE(hugepage_arena_carves_aligned_slots) {
+    hugepage_arena arena;
+    BOOST_REQUIRE(!arena.enabled());
+    BOOST_REQUIRE(arena.allocate(1) == nullptr);
+
+    arena.start(2 * hugepage_arena::page_size);
+    BOOST_REQUIRE(arena.enabled());
+    BOOST_REQUIRE_EQUAL(arena.size_total(), 2 * hugepage_arena::page_size);
+
+    auto* small = arena.allocate(100);
+    BOOST_REQUIRE(small != nullptr);
+    BOOST_REQUIRE_EQUAL(arena.size_used(), hugepage_arena::min_slot_size);
+    auto* chunk = arena.allocate(16_KiB);
+    BOOST_REQUIRE(chunk != nullptr);
+    BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(chunk) % 16_KiB, 0);
+    BOOST_REQUIRE(arena.allocate(hugepage_arena::max_slot_size + 1) == nullptr);
+
+    // both pages are carved, other sizes have no slots left
+    BOOST_REQUIRE(arena.allocate(1_KiB) == nullptr);
+    BOOST_REQUIRE_EQUAL(arena.allocation_failures(), 1);
+
+    // a returned slot is handed out again
+    arena.deallocate(chunk, 16_KiB);
+    BOOST_REQUIRE(arena.allocate(16_KiB) == chunk);
+    arena.deallocate(chunk, 16_KiB);
+    arena.deallocate(small, 100);
+    BOOST_REQUIRE_EQUAL(arena.size_used(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(hugepage_arena_copies_iobufs) {
+    hugepage_arena arena;
+    arena.start(hugepage_arena::page_size);
+    auto data = random_generators::gen_alphanum_string(256_KiB);
+    iobuf in;
+    in.append(data.data(), data.size());
+
+    {
+        auto out = arena.copy(in);
+        BOOST_REQUIRE_EQUAL(out, in);
+        BOOST_REQUIRE_EQUAL(
+          arena.size_used(), 4 * hugepage_arena::max_slot_size);
+        // the fragments return their slots once released
+    }
+    BOOST_REQUIRE_EQUAL(arena.size_used(), 0);
+
+    // the bytes beyond the arena are copied to the heap
+    std::vector<iobuf> copies;
+    for (int i = 0; i < 12; ++i) {
+        copies.push_back(arena.copy(in));
+        BOOST_REQUIRE_EQUAL(copies.back(), in);
+    }
+    BOOST_REQUIRE_GT(arena.allocation_failures(), 0);
+    BOOST_REQUIRE_LE(arena.size_used(), arena.size_total());
+}
+
+SEASTAR_THREAD_TEST_CASE(hugepage_arena_backs_appender_chunks) {
+    hugepage_arena arena;
+    arena.start(hugepage_arena::page_size);
+    auto* slot = arena.allocate(storage::segment_appender_chunk::chunk_size);
+    {
+        storage::segment_appender_chunk chunk(4_KiB, arena, slot);
+        BOOST_REQUIRE(chunk.data() == slot);
+        BOOST_REQUIRE(chunk.is_empty());
+        const char c = 'x';
+        BOOST_REQUIRE_EQUAL(chunk.append(&c, 1), 1);
+    }
+    BOOST_REQUIRE_EQUAL(arena.size_used(), 0);
+}
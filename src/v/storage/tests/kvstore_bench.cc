@@ -0,0 +1,58 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "config/configuration.h"
+#include "random/generators.h"
+#include "storage/kvstore.h"
+#include "test_utils/alloc_counter.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+#include <vector>
+
+/// a put resolves once the write ahead log of the store is flushed, which
+/// happens every commit interval. `concurrency` puts are in flight at a time
+/// and share the flushes
+static ss::future<> put(size_t concurrency) {
+    return ss::async([concurrency] {
+        static constexpr size_t puts = 64;
+        config::shard_local_cfg().get("disable_metrics").set_value(true);
+        auto kvs = std::make_unique<storage::kvstore>(storage::kvstore_config(
+          8192,
+          std::chrono::milliseconds(10),
+          fmt::format("kvstore_bench_{}", random_generators::get_int(4000)),
+          storage::debug_sanitize_files::yes));
+        kvs->start().get();
+        const auto value = bytes_to_iobuf(random_generators::get_bytes(100));
+        tests::alloc_counter allocs(
+          fmt::format("kvstore.put_concurrency_{}", concurrency));
+        for (size_t i = 0; i < puts; i += concurrency) {
+            std::vector<ss::future<>> inflight;
+            inflight.reserve(concurrency);
+            for (size_t j = i; j < i + concurrency; ++j) {
+                inflight.push_back(kvs->put(
+                  storage::kvstore::key_space::testing,
+                  random_generators::get_bytes(16),
+                  value.copy()));
+            }
+            ss::when_all_succeed(inflight.begin(), inflight.end()).get();
+        }
+        allocs.stop(puts);
+        kvs->stop().get();
+    });
+}
+
+PERF_TEST(kvstore, put_latency) { return put(1); }
+
+PERF_TEST(kvstore, put_concurrency_16) { return put(16); }
@@ -201,3 +201,48 @@ SEASTAR_THREAD_TEST_CASE(kvstore) {
     }
     kvs->stop().get();
 }
+
+SEASTAR_THREAD_TEST_CASE(coalesced_and_urgent_writes) {
+    set_configuration("disable_metrics", true);
+
+    auto dir = fmt::format("kvstore_test_{}", random_generators::get_int(4000));
+    // only urgent writes flush before the interval
+    auto conf = storage::kvstore_config(
+      8192, std::chrono::hours(1), dir, storage::debug_sanitize_files::yes);
+
+    auto kvs = std::make_unique<storage::kvstore>(conf);
+    kvs->start().get();
+
+    const auto key = random_generators::get_bytes(2);
+    std::vector<iobuf> values;
+    std::vector<ss::future<>> writes;
+    for (int i = 0; i < 10; ++i) {
+        values.push_back(bytes_to_iobuf(random_generators::get_bytes(100)));
+        writes.push_back(kvs->put(
+          storage::kvstore::key_space::testing, key, values.back().copy()));
+    }
+    // takes the staged writes of the key along
+    auto vote = kvs->put(
+      storage::kvstore::key_space::consensus,
+      key,
+      values.front().copy(),
+      storage::kvstore::urgent::yes);
+    vote.get();
+    ss::when_all_succeed(writes.begin(), writes.end()).get();
+
+    BOOST_REQUIRE(
+      kvs->get(storage::kvstore::key_space::testing, key).value()
+      == values.back());
+    BOOST_REQUIRE(
+      kvs->get(storage::kvstore::key_space::consensus, key).value()
+      == values.front());
+    kvs->stop().get();
+
+    // the latest value is the one flushed
+    kvs = std::make_unique<storage::kvstore>(conf);
+    kvs->start().get();
+    BOOST_REQUIRE(
+      kvs->get(storage::kvstore::key_space::testing, key).value()
+      == values.back());
+    kvs->stop().get();
+}
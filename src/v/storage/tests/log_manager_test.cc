@@ -13,12 +13,17 @@
 #include "storage/api.h"
 #include "storage/directories.h"
 #include "storage/disk_log_appender.h"
+#include "storage/log_reaper.h"
+#include "storage/probe.h"
 #include "storage/segment_appender.h"
 #include "storage/segment_appender_utils.h"
+#include "storage/segment_file_pool.h"
 #include "storage/segment_reader.h"
 #include "storage/tests/utils/random_batch.h"
+#include "utils/directory_walker.h"
 #include "utils/file_sanitizer.h"
 
+#include <seastar/core/sleep.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/thread_test_case.hh>
 #include <seastar/util/defer.hh>
@@ -114,3 +119,246 @@ SEASTAR_THREAD_TEST_CASE(test_can_load_logs) {
     BOOST_CHECK(
       file_exists(seg4->reader().filename() + ".cannotrecover").get0());
 }
+
+SEASTAR_THREAD_TEST_CASE(test_logs_spread_across_data_directories) {
+    auto conf = make_config();
+    conf.base_dir = "test.dir_" + random_generators::gen_alphanum_string(4);
+    conf.extra_dirs.push_back(conf.base_dir + ".extra");
+    directories::initialize(conf.base_dir).get();
+    directories::initialize(conf.extra_dirs[0]).get();
+    auto ntp0 = model::ntp("ns", "spread", 0);
+    auto ntp1 = model::ntp("ns", "spread", 1);
+    ss::sstring dir0;
+    ss::sstring dir1;
+    {
+        storage::api store(
+          storage::kvstore_config(
+            1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+          conf);
+        store.start().get();
+        auto stop = ss::defer([&store] { store.stop().get(); });
+        auto& m = store.log_mgr();
+        // both directories are on the same disk, the log count decides
+        auto l0 = m.manage(ntp_config(ntp0, conf.base_dir)).get0();
+        auto l1 = m.manage(ntp_config(ntp1, conf.base_dir)).get0();
+        dir0 = l0.config().base_directory();
+        dir1 = l1.config().base_directory();
+        BOOST_CHECK_NE(dir0, dir1);
+        BOOST_CHECK(file_exists(l1.config().work_directory()).get0());
+    }
+    storage::api store(
+      storage::kvstore_config(
+        1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+      conf);
+    store.start().get();
+    auto stop = ss::defer([&store] { store.stop().get(); });
+    auto& m = store.log_mgr();
+    // the logs are found again in reverse order of placement
+    auto l1 = m.manage(ntp_config(ntp1, conf.base_dir)).get0();
+    BOOST_CHECK_EQUAL(l1.config().base_directory(), dir1);
+    auto l0 = m.manage(ntp_config(ntp0, conf.base_dir)).get0();
+    BOOST_CHECK_EQUAL(l0.config().base_directory(), dir0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_remove_frees_files_in_background) {
+    auto conf = make_config();
+    conf.base_dir = "test.dir_" + random_generators::gen_alphanum_string(4);
+    conf.reaper_cfg.max_bytes_per_sec = 1_MiB;
+    directories::initialize(conf.base_dir).get();
+    storage::api store(
+      storage::kvstore_config(
+        1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+      conf);
+    store.start().get();
+    auto stop = ss::defer([&store] { store.stop().get(); });
+    auto& m = store.log_mgr();
+    auto ntp = model::ntp("ns", "removed", 0);
+    auto log = m.manage(ntp_config(ntp, conf.base_dir)).get0();
+    auto work_dir = log.config().work_directory();
+    auto seg = m.make_log_segment(
+                  log.config(),
+                  model::offset(0),
+                  model::term_id(1),
+                  ss::default_priority_class())
+                 .get0();
+    write_batches(seg);
+    seg->close().get();
+
+    m.remove(ntp).get();
+    // the name of the log is free as soon as remove returns
+    BOOST_CHECK(!file_exists(work_dir).get0());
+    BOOST_CHECK_EQUAL(m.size(), 0);
+    auto trash = storage::log_reaper::trash_directory(conf.base_dir);
+    while (m.reaper().pending() > 0) {
+        ss::sleep(10ms).get();
+    }
+    BOOST_CHECK(directory_walker::empty(trash).get0());
+    BOOST_CHECK_GT(m.reaper().removed_bytes(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_housekeeping_visits_logs_when_due) {
+    auto conf = make_config();
+    conf.base_dir = "test.dir_" + random_generators::gen_alphanum_string(4);
+    // without the deadline of the log the round would start in an hour
+    conf.compaction_interval = 1h;
+    conf.delete_retention = 1ms;
+    directories::initialize(conf.base_dir).get();
+    storage::api store(
+      storage::kvstore_config(
+        1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+      conf);
+    store.start().get();
+    auto stop = ss::defer([&store] { store.stop().get(); });
+    auto& m = store.log_mgr();
+    auto cfg = ntp_config(model::ntp("ns", "due", 0), conf.base_dir);
+    directories::initialize(cfg.work_directory()).get();
+    for (auto base : {model::offset(0), model::offset(100)}) {
+        auto seg = m.make_log_segment(
+                      cfg,
+                      base,
+                      model::term_id(1),
+                      ss::default_priority_class())
+                     .get0();
+        write_batches(seg);
+        seg->close().get();
+    }
+    auto log = m.manage(ntp_config(cfg.ntp(), conf.base_dir)).get0();
+    BOOST_REQUIRE_EQUAL(log.segment_count(), 2);
+    log.set_collectible_offset(model::offset::max());
+
+    // the oldest segment is past the retention already
+    for (int i = 0; i < 500 && log.segment_count() > 1; ++i) {
+        ss::sleep(10ms).get();
+    }
+    BOOST_REQUIRE_EQUAL(log.segment_count(), 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_rolls_reuse_files_of_removed_segments) {
+    auto conf = make_config();
+    conf.base_dir = "test.dir_" + random_generators::gen_alphanum_string(4);
+    conf.compaction_interval = 1h;
+    conf.delete_retention = 1ms;
+    conf.segment_pool_files = 1;
+    directories::initialize(conf.base_dir).get();
+    storage::api store(
+      storage::kvstore_config(
+        1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+      conf);
+    store.start().get();
+    auto stop = ss::defer([&store] { store.stop().get(); });
+    auto& m = store.log_mgr();
+    auto cfg = ntp_config(model::ntp("ns", "pool", 0), conf.base_dir);
+    directories::initialize(cfg.work_directory()).get();
+    for (auto base : {model::offset(0), model::offset(100)}) {
+        auto seg = m.make_log_segment(
+                      cfg,
+                      base,
+                      model::term_id(1),
+                      ss::default_priority_class())
+                     .get0();
+        write_batches(seg);
+        seg->close().get();
+    }
+    BOOST_REQUIRE_EQUAL(m.segment_pool().reused(), 0);
+    auto log = m.manage(ntp_config(cfg.ntp(), conf.base_dir)).get0();
+    log.set_collectible_offset(model::offset::max());
+
+    // retention hands the file of the oldest segment to the pool
+    for (int i = 0; i < 500 && m.segment_pool().size() == 0; ++i) {
+        ss::sleep(10ms).get();
+    }
+    BOOST_REQUIRE_EQUAL(log.segment_count(), 1);
+    BOOST_REQUIRE_EQUAL(m.segment_pool().size(), 1);
+    auto pool = segment_file_pool::pool_directory(conf.base_dir);
+    BOOST_CHECK(!directory_walker::empty(pool).get0());
+
+    auto seg = m.make_log_segment(
+                  cfg,
+                  model::offset(1000),
+                  model::term_id(2),
+                  ss::default_priority_class())
+                 .get0();
+    BOOST_REQUIRE_EQUAL(m.segment_pool().reused(), 1);
+    BOOST_REQUIRE_EQUAL(m.segment_pool().size(), 0);
+    // the kept file starts empty, nothing of the removed segment is left
+    BOOST_REQUIRE_EQUAL(seg->reader().file_size(), 0);
+    BOOST_REQUIRE_EQUAL(
+      ss::file_size(seg->reader().filename()).get0(), uint64_t(0));
+    write_batches(seg);
+    BOOST_REQUIRE_GT(seg->size_bytes(), 0);
+    seg->close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(only_the_busiest_logs_register_detail) {
+    log_probes probes(log_probes::config{
+      .aggregate = true,
+      .detail_limit = 2,
+    });
+    segment_set segs(segment_set::underlying_t{});
+    std::vector<model::ntp> ntps;
+    for (int i = 0; i < 4; ++i) {
+        ntps.emplace_back(
+          model::ns("test"), model::topic("busy"), model::partition_id(i));
+    }
+    std::vector<std::unique_ptr<probe>> logs;
+    for (auto& ntp : ntps) {
+        logs.push_back(std::make_unique<probe>());
+        probes.add(*logs.back(), ntp, segs);
+    }
+
+    // idle logs register nothing
+    probes.rank();
+    BOOST_REQUIRE_EQUAL(probes.detailed(), 0);
+
+    logs[0]->add_bytes_written(10);
+    logs[1]->add_bytes_read(20);
+    logs[2]->add_bytes_written(30);
+    probes.rank();
+    BOOST_REQUIRE_EQUAL(probes.detailed(), 2);
+
+    // a log going away leaves its counters with its topic
+    logs.clear();
+    probes.rank();
+    BOOST_REQUIRE_EQUAL(probes.detailed(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_ephemeral_log_is_bounded_in_memory) {
+    auto conf = make_config();
+    conf.base_dir = "test.dir_" + random_generators::gen_alphanum_string(4);
+    directories::initialize(conf.base_dir).get();
+    storage::api store(
+      storage::kvstore_config(
+        1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+      conf);
+    store.start().get();
+    auto stop = ss::defer([&store] { store.stop().get(); });
+    auto overrides = std::make_unique<ntp_config::default_overrides>();
+    overrides->retention_bytes = tristate<size_t>(
+      std::make_optional<size_t>(1_KiB));
+    overrides->ephemeral = true;
+    auto log = store.log_mgr()
+                 .manage(ntp_config(
+                   model::ntp("ns", "ephemeral", 0),
+                   conf.base_dir,
+                   std::move(overrides)))
+                 .get0();
+    auto append = [&log] {
+        log_append_config cfg{
+          log_append_config::fsync::yes,
+          ss::default_priority_class(),
+          model::no_timeout};
+        auto reader = model::make_memory_record_batch_reader(
+          test::make_random_batches(model::offset(0), 10));
+        std::move(reader)
+          .for_each_ref(log.make_appender(cfg), cfg.timeout)
+          .get0();
+    };
+
+    // the batches above the retention are kept until collectible
+    append();
+    BOOST_CHECK_EQUAL(log.offsets().start_offset, model::offset(0));
+    log.set_collectible_offset(log.offsets().dirty_offset);
+    append();
+    BOOST_CHECK_GT(log.offsets().start_offset, model::offset(0));
+    BOOST_CHECK(directory_walker::empty(log.config().work_directory()).get0());
+}
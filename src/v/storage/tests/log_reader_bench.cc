@@ -0,0 +1,84 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/fundamental.h"
+#include "model/record_batch_reader.h"
+#include "random/generators.h"
+#include "storage/tests/utils/disk_log_builder.h"
+#include "test_utils/alloc_counter.h"
+
+#include <seastar/core/thread.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <limits>
+
+/// reads of a single segment through log_segment_batch_reader. the batch
+/// cache is skipped so that every read parses the batches off the file
+static storage::log_reader_config
+uncached(model::offset start, model::offset max) {
+    auto cfg = storage::log_reader_config(
+      start,
+      max,
+      0,
+      std::numeric_limits<size_t>::max(),
+      ss::default_priority_class(),
+      std::nullopt,
+      std::nullopt,
+      std::nullopt);
+    cfg.skip_batch_cache = true;
+    return cfg;
+}
+
+static ss::future<> read(bool sequential) {
+    return ss::async([sequential] {
+        static constexpr int batches = 512;
+        static constexpr int reads = 512;
+        storage::disk_log_builder builder;
+        builder.start().get();
+        builder.add_segment(model::offset(0)).get();
+        builder
+          .add_random_batches(
+            model::offset(0),
+            batches,
+            storage::maybe_compress_batches::no,
+            storage::append_config(),
+            storage::disk_log_builder::should_flush_after::yes)
+          .get();
+        auto& log = builder.get_log();
+        const auto last = log.offsets().dirty_offset;
+        size_t ops = 0;
+        tests::alloc_counter allocs(
+          sequential ? "log_reader.sequential" : "log_reader.random");
+        if (sequential) {
+            auto reader = log.make_reader(uncached(model::offset(0), last))
+                            .get0();
+            ops = model::consume_reader_to_memory(
+                    std::move(reader), model::no_timeout)
+                    .get0()
+                    .size();
+        } else {
+            for (int i = 0; i < reads; ++i) {
+                auto o = model::offset(
+                  random_generators::get_int<model::offset::type>(last()));
+                auto reader = log.make_reader(uncached(o, o)).get0();
+                ops += model::consume_reader_to_memory(
+                         std::move(reader), model::no_timeout)
+                         .get0()
+                         .size();
+            }
+        }
+        allocs.stop(ops);
+        builder.stop().get();
+    });
+}
+
+PERF_TEST(log_reader, sequential) { return read(true); }
+
+// every read looks up the segment index and scans from its nearest entry
+PERF_TEST(log_reader, random) { return read(false); }
@@ -13,6 +13,7 @@
 #include "storage/segment_appender.h"
 
 #include <seastar/core/reactor.hh>
+#include <seastar/core/sleep.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/thread_test_case.hh>
 
@@ -217,3 +218,126 @@ SEASTAR_THREAD_TEST_CASE(test_can_append_little_data) {
     BOOST_REQUIRE_EQUAL(appender.file_byte_offset(), data.size());
     appender.close().get();
 }
+
+SEASTAR_THREAD_TEST_CASE(test_write_behind_budget_follows_write_rate) {
+    auto f = ss::open_file_dma(
+               "test_log_segment_write_behind.log",
+               ss::open_flags::create | ss::open_flags::rw
+                 | ss::open_flags::truncate)
+               .get0();
+    auto appender = segment_appender(
+      f, segment_appender::options(ss::default_priority_class(), 8));
+    BOOST_REQUIRE_EQUAL(appender.write_behind_chunks(), 1);
+
+    const auto data = random_generators::gen_alphanum_string(
+      segment_appender::chunk_size);
+    appender.append(data.data(), data.size()).get();
+    // allow for the granularity of the lowres clock
+    ss::sleep(
+      segment_appender::write_rate_window + std::chrono::milliseconds(20))
+      .get();
+    // the only writer on the shard gets the whole budget
+    appender.append(data.data(), data.size()).get();
+    BOOST_REQUIRE_EQUAL(appender.write_behind_chunks(), 8);
+
+    appender.close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_read_tail_shares_written_chunks) {
+    auto f = ss::open_file_dma(
+               "test_log_segment_read_tail.log",
+               ss::open_flags::create | ss::open_flags::rw
+                 | ss::open_flags::truncate)
+               .get0();
+    auto appender = segment_appender(
+      f, segment_appender::options(ss::default_priority_class(), 1));
+
+    iobuf expected;
+    auto append = [&](size_t n) {
+        const auto data = random_generators::gen_alphanum_string(n);
+        expected.append(data.data(), data.size());
+        appender.append(data.data(), data.size()).get();
+        appender.flush().get();
+    };
+    append(segment_appender::chunk_size + 100);
+    const auto first = expected.size_bytes();
+    auto head = appender.read_tail(0, first);
+    BOOST_REQUIRE(head);
+    BOOST_REQUIRE_EQUAL(*head, expected.share(0, first));
+
+    // the oldest chunks leave the tail, the newest bytes are still served
+    append(2 * segment_appender::chunk_size);
+    const auto size = expected.size_bytes();
+    BOOST_REQUIRE(!appender.read_tail(0, size));
+    auto tail = appender.read_tail(size - 50, size);
+    BOOST_REQUIRE(tail);
+    BOOST_REQUIRE_EQUAL(*tail, expected.share(size - 50, 50));
+
+    // the chunks referenced by a read are not reused
+    appender.truncate(0).get();
+    append(segment_appender::chunk_size);
+    BOOST_REQUIRE_EQUAL(*head, expected.share(0, first));
+    appender.close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_appends_aligned_fragments_directly) {
+    auto f = ss::open_file_dma(
+               "test_log_segment_direct.log",
+               ss::open_flags::create | ss::open_flags::rw
+                 | ss::open_flags::truncate)
+               .get0();
+    auto appender = segment_appender(
+      f, segment_appender::options(ss::default_priority_class(), 4));
+    constexpr size_t page = 4_KiB;
+    constexpr size_t fragment_size = 8 * page;
+
+    iobuf expected;
+    auto aligned_fragment = [&](iobuf& io, size_t n) {
+        auto buf = ss::temporary_buffer<char>::aligned(page, n);
+        const auto data = random_generators::gen_alphanum_string(n);
+        std::copy_n(data.data(), n, buf.get_write());
+        io.append_take_ownership(
+          new iobuf::fragment(std::move(buf), iobuf::fragment::full{}));
+    };
+    auto verify = [&] {
+        appender.flush().get();
+        BOOST_REQUIRE_EQUAL(appender.file_byte_offset(), expected.size_bytes());
+        auto in = make_file_input_stream(f, 0);
+        auto result = read_iobuf_exactly(in, expected.size_bytes()).get0();
+        BOOST_REQUIRE_EQUAL(result, expected);
+        in.close().get();
+    };
+
+    // the head holds a page, the fragments line up with the file past it
+    const auto head = random_generators::gen_alphanum_string(page);
+    expected.append(head.data(), head.size());
+    appender.append(head.data(), head.size()).get();
+    iobuf batch;
+    aligned_fragment(batch, fragment_size);
+    aligned_fragment(batch, fragment_size);
+    const auto tail = random_generators::gen_alphanum_string(100);
+    batch.append(tail.data(), tail.size());
+    expected.append(batch.share(0, batch.size_bytes()));
+    appender.append(batch).get();
+    BOOST_REQUIRE_EQUAL(
+      appender.direct_write_bytes(),
+      2 * fragment_size - (segment_appender::chunk_size - page));
+    verify();
+
+    // unaligned bytes after the direct writes are copied into a new head
+    const auto more = random_generators::gen_alphanum_string(page + 10);
+    expected.append(more.data(), more.size());
+    appender.append(more.data(), more.size()).get();
+    verify();
+
+    // the fragments do not line up with the file anymore, all copied
+    const auto direct = appender.direct_write_bytes();
+    iobuf misaligned;
+    aligned_fragment(misaligned, fragment_size);
+    aligned_fragment(misaligned, fragment_size);
+    expected.append(misaligned.share(0, misaligned.size_bytes()));
+    appender.append(misaligned).get();
+    BOOST_REQUIRE_EQUAL(appender.direct_write_bytes(), direct);
+    verify();
+    appender.close().get();
+}
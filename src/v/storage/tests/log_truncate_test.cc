@@ -97,6 +97,32 @@ FIXTURE_TEST(test_truncate_in_the_middle_of_segment, storage_test_fixture) {
     }
 }
 
+FIXTURE_TEST(test_truncate_append_cycles_at_tail, storage_test_fixture) {
+    storage::log_manager mgr = make_log_manager();
+    info("config: {}", mgr.config());
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    auto log
+      = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0();
+    // truncations at the last batches find them without scanning the segment
+    for (auto i = 0; i < 5; i++) {
+        append_random_batches(log, 10, model::term_id(0));
+        log.flush().get0();
+        auto all_batches = read_and_validate_all_batches(log);
+        const auto kept = all_batches.size() - 3;
+        auto truncate_offset = all_batches[kept].base_offset();
+        info("Truncating at offset:{}", truncate_offset);
+        log
+          .truncate(storage::truncate_config(
+            truncate_offset, ss::default_priority_class()))
+          .get0();
+        auto read_batches = read_and_validate_all_batches(log);
+        BOOST_REQUIRE_EQUAL(read_batches.size(), kept);
+        BOOST_REQUIRE_EQUAL(
+          log.offsets().dirty_offset, expected_last(truncate_offset));
+    }
+}
+
 FIXTURE_TEST(test_truncate_empty_log, storage_test_fixture) {
     storage::log_manager mgr = make_log_manager();
     info("config: {}", mgr.config());
@@ -491,3 +517,50 @@ FIXTURE_TEST(test_concurrent_prefix_truncate_and_gc, storage_test_fixture) {
       (*impl.segments().begin())->offsets().base_offset,
       log.offsets().start_offset);
 }
+
+FIXTURE_TEST(test_prefix_truncate_drops_segments, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    info("config: {}", mgr.config());
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+
+    auto overrides = std::make_unique<storage::ntp_config::default_overrides>();
+    overrides->segment_size = 1024;
+    auto log = mgr
+                 .manage(storage::ntp_config(
+                   ntp, mgr.config().base_dir, std::move(overrides)))
+                 .get0();
+
+    for (auto i = 0; i < 10; i++) {
+        append_random_batches(log, 2, model::term_id(i));
+        log.flush().get0();
+    }
+    auto all_batches = read_and_validate_all_batches(log);
+    auto start = all_batches[all_batches.size() / 2].base_offset();
+    storage::disk_log_impl& impl = *reinterpret_cast<storage::disk_log_impl*>(
+      log.get_impl());
+    const auto segments = impl.segments().size();
+
+    log
+      .truncate_prefix(
+        storage::truncate_prefix_config(start, ss::default_priority_class()))
+      .get0();
+
+    // the segments below the start offset are out of the log right away,
+    // their files are removed in the background
+    BOOST_REQUIRE_EQUAL(log.offsets().start_offset, start);
+    BOOST_REQUIRE_LT(impl.segments().size(), segments);
+    for (const auto& s : impl.segments()) {
+        BOOST_REQUIRE_GE(s->offsets().dirty_offset, start);
+    }
+    auto batches = read_and_validate_all_batches(log);
+    BOOST_REQUIRE(!batches.empty());
+    BOOST_REQUIRE_GE(batches.front().last_offset(), start);
+    BOOST_REQUIRE_EQUAL(
+      batches.back().last_offset(), all_batches.back().last_offset());
+
+    // closing the log waits for the removals
+    mgr.shutdown(ntp).get0();
+}
@@ -41,3 +41,74 @@ SEASTAR_THREAD_TEST_CASE(test_offset_assignment) {
         model::no_timeout)
       .get();
 };
+
+struct append_time_validating_consumer {
+    ss::future<ss::stop_iteration> operator()(model::record_batch&& batch) {
+        const auto& hdr = batch.header();
+        BOOST_REQUIRE_EQUAL(
+          hdr.attrs.timestamp_type(), model::timestamp_type::append_time);
+        BOOST_REQUIRE_EQUAL(hdr.max_timestamp, append_time);
+        // both checksums are valid without rehashing the records twice
+        BOOST_REQUIRE_EQUAL(hdr.crc, model::crc_record_batch(batch));
+        BOOST_REQUIRE_EQUAL(
+          hdr.header_crc, model::internal_header_only_crc(hdr));
+        BOOST_REQUIRE_EQUAL(batch.base_offset(), starting_offset);
+        starting_offset += batch.record_count();
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::no);
+    }
+
+    void end_of_stream() {}
+
+    model::offset starting_offset;
+    model::timestamp append_time;
+};
+
+SEASTAR_THREAD_TEST_CASE(test_offset_and_append_time_assignment) {
+    auto batches = storage::test::make_random_batches(model::offset(0), 10);
+    auto reader = model::make_memory_record_batch_reader(std::move(batches));
+    auto starting_offset = model::offset(123);
+    auto append_time = model::timestamp(1000);
+    reader
+      .consume(
+        wrap_with_offset_assignment(
+          append_time_validating_consumer{starting_offset, append_time},
+          starting_offset,
+          append_time),
+        model::no_timeout)
+      .get();
+}
+
+struct term_validating_consumer {
+    ss::future<ss::stop_iteration> operator()(model::record_batch&& batch) {
+        BOOST_REQUIRE_EQUAL(batch.term(), term);
+        BOOST_REQUIRE_EQUAL(batch.base_offset(), starting_offset);
+        BOOST_REQUIRE_EQUAL(
+          batch.header().header_crc,
+          model::internal_header_only_crc(batch.header()));
+        starting_offset += batch.record_count();
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::no);
+    }
+
+    void end_of_stream() {}
+
+    model::offset starting_offset;
+    model::term_id term;
+};
+
+SEASTAR_THREAD_TEST_CASE(test_offset_and_term_assignment) {
+    auto batches = storage::test::make_random_batches(model::offset(0), 10);
+    auto reader = model::make_memory_record_batch_reader(std::move(batches));
+    auto starting_offset = model::offset(123);
+    auto term = model::term_id(7);
+    reader
+      .consume(
+        wrap_with_offset_assignment(
+          term_validating_consumer{starting_offset, term},
+          starting_offset,
+          std::nullopt,
+          term),
+        model::no_timeout)
+      .get();
+}
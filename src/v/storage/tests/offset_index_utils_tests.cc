@@ -17,6 +17,8 @@
 
 #include <boost/test/tools/old/interface.hpp>
 
+#include <array>
+
 struct context {
     context(model::offset base = model::offset(0)) {
         _base_offset = base;
@@ -126,3 +128,103 @@ FIXTURE_TEST(bucket_truncate, context) {
         BOOST_REQUIRE_EQUAL(p->filepos, 458048);
     }
 }
+
+FIXTURE_TEST(time_index_is_monotonic, context) {
+    const std::array<int64_t, 5> timestamps = {10, 50, 20, 30, 60};
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        auto hdr = modify_get(
+          model::offset(i), storage::segment_index::default_data_buffer_step);
+        hdr.first_timestamp = model::timestamp(timestamps[i]);
+        hdr.max_timestamp = model::timestamp(timestamps[i]);
+        _idx->maybe_track(hdr, i * 100); // indexed
+    }
+    BOOST_REQUIRE_EQUAL(_idx->max_timestamp(), model::timestamp(60));
+    auto expect = [this](int64_t ts, int64_t offset) {
+        auto p = _idx->find_nearest(model::timestamp(ts));
+        BOOST_REQUIRE(bool(p));
+        BOOST_REQUIRE_EQUAL(p->offset, model::offset(offset));
+    };
+    // no batch before the entry found reaches the timestamp
+    expect(5, 0);
+    expect(10, 0);
+    expect(25, 0);
+    expect(50, 0);
+    expect(55, 3);
+    expect(100, 4);
+
+    _idx->flush().get();
+    auto raw_idx = storage::index_state::hydrate_from_buffer(
+      _data.share_iobuf());
+    BOOST_REQUIRE(raw_idx != std::nullopt);
+    const std::vector<uint32_t> expected = {0, 40, 40, 40, 50};
+    BOOST_REQUIRE(raw_idx->relative_time_index == expected);
+}
+
+FIXTURE_TEST(find_nearest_position, context) {
+    for (size_t i = 0; i < 5; ++i) {
+        _idx->maybe_track(
+          modify_get(
+            model::offset(i * 10),
+            storage::segment_index::default_data_buffer_step),
+          100 + i * 100); // indexed
+    }
+    auto expect = [this](size_t pos, int64_t offset) {
+        auto p = _idx->find_nearest_position(pos);
+        BOOST_REQUIRE(bool(p));
+        BOOST_REQUIRE_EQUAL(p->offset, model::offset(offset));
+    };
+    BOOST_REQUIRE(!_idx->find_nearest_position(50));
+    expect(100, 0);
+    expect(150, 0);
+    expect(200, 10);
+    expect(499, 30);
+    expect(10000, 40);
+}
+
+FIXTURE_TEST(index_density, context) {
+    auto track = [this](size_t count, int32_t batch_size) {
+        size_t pos = 0;
+        for (size_t i = 0; i < count; ++i) {
+            _idx->maybe_track(modify_get(model::offset(i), batch_size), pos);
+            pos += batch_size;
+        }
+        _idx->flush().get();
+        auto raw = storage::index_state::hydrate_from_buffer(
+          _data.share_iobuf());
+        BOOST_REQUIRE(raw != std::nullopt);
+        auto entries = raw->relative_offset_index.size();
+        _idx->reset();
+        return entries;
+    };
+    // fixed: an entry every other batch
+    _idx->set_density(storage::segment_index::density{
+      .step = 1024, .adaptive = false, .segment_bytes = 1_GiB});
+    BOOST_REQUIRE_EQUAL(track(64, 512), 32);
+
+    // adaptive: small batches are indexed every 4KiB...
+    _idx->set_density(storage::segment_index::density{
+      .step = 1024, .adaptive = true, .segment_bytes = 64_MiB});
+    BOOST_REQUIRE_EQUAL(_idx->step(), 1024);
+    track(1, 512);
+    BOOST_REQUIRE_EQUAL(
+      _idx->step(), storage::segment_index::min_adaptive_step);
+    // ...unless the segment would hold too many entries
+    _idx->set_density(storage::segment_index::density{
+      .step = 1024, .adaptive = true, .segment_bytes = 1_GiB});
+    track(1, 512);
+    BOOST_REQUIRE_EQUAL(
+      _idx->step(), 1_GiB / storage::segment_index::max_adaptive_entries);
+    // large batches are indexed up to every 1MiB
+    _idx->set_density(storage::segment_index::density{
+      .step = 1024, .adaptive = true, .segment_bytes = 1_GiB});
+    track(1, 512_KiB);
+    BOOST_REQUIRE_EQUAL(
+      _idx->step(), storage::segment_index::max_adaptive_step);
+    // the step follows the average batch size
+    _idx->set_density(storage::segment_index::density{
+      .step = 1024, .adaptive = true, .segment_bytes = 64_MiB});
+    track(1, 8_KiB);
+    BOOST_REQUIRE_EQUAL(
+      _idx->step(),
+      8_KiB * storage::segment_index::adaptive_batches_per_entry);
+}
@@ -7,10 +7,12 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "bytes/bytes.h"
 #include "bytes/iobuf.h"
 #include "model/compression.h"
 #include "model/fundamental.h"
 #include "model/record.h"
+#include "reflection/adl.h"
 #include "storage/disk_log_appender.h"
 #include "storage/parser.h"
 #include "storage/segment_appender_utils.h"
@@ -206,3 +208,97 @@ SEASTAR_THREAD_TEST_CASE(test_skips) {
     check_batches(ctx.reporter.batches, batches);
 }
 #endif
+
+/// keeps the headers of the batches it does not skip
+class header_consumer final : public batch_consumer {
+public:
+    header_consumer(std::vector<model::record_batch_header>& out, bool skip)
+      : _out(out)
+      , _skip(skip) {}
+
+    consume_result consume_batch_start(
+      model::record_batch_header h, size_t, size_t) override {
+        // skip every other batch
+        _skipping = _skip && !_skipping;
+        if (_skipping) {
+            return skip_batch::yes;
+        }
+        _out.push_back(h);
+        return skip_batch::no;
+    }
+    void consume_records(iobuf&&) override {}
+    stop_parser consume_batch_end() override { return stop_parser::no; }
+    void print(std::ostream& os) const override { os << "header_consumer"; }
+
+private:
+    std::vector<model::record_batch_header>& _out;
+    bool _skip;
+    bool _skipping{false};
+};
+
+static iobuf
+to_disk_format(const ss::circular_buffer<model::record_batch>& bs) {
+    iobuf out;
+    for (const auto& b : bs) {
+        const auto& h = b.header();
+        reflection::serialize(
+          out,
+          h.header_crc,
+          h.size_bytes,
+          h.base_offset(),
+          h.type(),
+          h.crc,
+          h.attrs.value(),
+          h.last_offset_delta,
+          h.first_timestamp.value(),
+          h.max_timestamp.value(),
+          h.producer_id,
+          h.producer_epoch,
+          h.base_sequence,
+          h.record_count);
+        out.append(b.data().copy());
+    }
+    return out;
+}
+
+static result<size_t> parse(
+  iobuf data, std::vector<model::record_batch_header>& headers, bool skip) {
+    continuous_batch_parser parser(
+      std::make_unique<header_consumer>(headers, skip),
+      make_iobuf_input_stream(std::move(data)));
+    auto ret = parser.consume().get0();
+    parser.close().get();
+    return ret;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_decodes_headers) {
+    auto batches = test::make_random_batches(model::offset(0), 20);
+    for (bool skip : {false, true}) {
+        std::vector<model::record_batch_header> headers;
+        auto ret = parse(to_disk_format(batches), headers, skip);
+        BOOST_REQUIRE(ret);
+        BOOST_REQUIRE_EQUAL(headers.size(), skip ? 10 : 20);
+        for (size_t i = 0; i < headers.size(); ++i) {
+            const auto& expected = batches[skip ? i * 2 + 1 : i].header();
+            BOOST_REQUIRE_EQUAL(headers[i], expected);
+            BOOST_REQUIRE_EQUAL(headers[i].header_crc, expected.header_crc);
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_detects_header_corruption) {
+    auto batches = test::make_random_batches(model::offset(0), 3);
+    auto data = to_disk_format(batches);
+    // flip a bit of the record count of the second header
+    const size_t at = batches[0].size_bytes()
+                      + model::packed_record_batch_header_size - 1;
+    auto bytes = iobuf_to_bytes(data);
+    bytes[at] ^= 0x1;
+
+    std::vector<model::record_batch_header> headers;
+    auto ret = parse(bytes_to_iobuf(bytes), headers, false);
+    // the batch before the corruption is a partial read
+    BOOST_REQUIRE(ret);
+    BOOST_REQUIRE_EQUAL(ret.value(), size_t(batches[0].size_bytes()));
+    BOOST_REQUIRE_EQUAL(headers.size(), 1);
+}
@@ -0,0 +1,88 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "model/record.h"
+#include "model/record_utils.h"
+#include "random/generators.h"
+#include "storage/record_batch_builder.h"
+#include "units.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <vector>
+
+namespace {
+iobuf to_iobuf(const ss::sstring& s) {
+    iobuf b;
+    b.append(s.data(), s.size());
+    return b;
+}
+
+/// the reference encoding of the records, one append per record
+iobuf encode(const std::vector<std::pair<ss::sstring, ss::sstring>>& kvs) {
+    iobuf out;
+    int32_t delta = 0;
+    for (const auto& [k, v] : kvs) {
+        auto r = model::record(
+          sizeof(model::record_attributes::type) + vint::vint_size(0)
+            + vint::vint_size(delta) + vint::vint_size(k.size()) + k.size()
+            + vint::vint_size(v.size()) + v.size() + vint::vint_size(0),
+          model::record_attributes{},
+          0,
+          delta,
+          k.size(),
+          to_iobuf(k),
+          v.size(),
+          to_iobuf(v),
+          std::vector<model::record_header>{});
+        model::append_record_to_buffer(out, r);
+        ++delta;
+    }
+    return out;
+}
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(test_builds_records_in_one_pass) {
+    std::vector<std::pair<ss::sstring, ss::sstring>> kvs;
+    // values over the largest iobuf allocation span several fragments
+    for (size_t size : {0_KiB, 1_KiB, 200_KiB, 3, 300_KiB}) {
+        kvs.emplace_back(
+          random_generators::gen_alphanum_string(16),
+          random_generators::gen_alphanum_string(size));
+    }
+    storage::record_batch_builder builder(
+      model::record_batch_type(1), model::offset(10));
+    for (const auto& [k, v] : kvs) {
+        builder.add_raw_kv(to_iobuf(k), to_iobuf(v));
+    }
+    auto batch = std::move(builder).build();
+
+    const auto expected = encode(kvs);
+    BOOST_REQUIRE_EQUAL(batch.data(), expected);
+    BOOST_REQUIRE_EQUAL(
+      batch.header().size_bytes,
+      model::packed_record_batch_header_size + expected.size_bytes());
+    BOOST_REQUIRE_EQUAL(batch.header().record_count, int32_t(kvs.size()));
+    BOOST_REQUIRE_EQUAL(
+      batch.header().last_offset_delta, int32_t(kvs.size() - 1));
+    BOOST_REQUIRE_EQUAL(batch.header().crc, model::crc_record_batch(batch));
+    BOOST_REQUIRE_EQUAL(
+      batch.header().header_crc,
+      model::internal_header_only_crc(batch.header()));
+
+    size_t i = 0;
+    batch.for_each_record([&kvs, &i](model::record r) {
+        BOOST_REQUIRE_EQUAL(r.offset_delta(), int32_t(i));
+        BOOST_REQUIRE_EQUAL(r.key(), to_iobuf(kvs[i].first));
+        BOOST_REQUIRE_EQUAL(r.value(), to_iobuf(kvs[i].second));
+        ++i;
+    });
+    BOOST_REQUIRE_EQUAL(i, kvs.size());
+}
@@ -0,0 +1,70 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "random/generators.h"
+#include "seastarx.h"
+#include "storage/segment_appender.h"
+#include "test_utils/alloc_counter.h"
+#include "units.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+/// every run appends `bytes_per_run` to a fresh segment in writes of
+/// `write_size`, flushing every `flush_every` writes, 0 for a single flush
+/// when the run closes the appender
+static ss::future<> append(size_t write_size, size_t flush_every) {
+    return ss::async([write_size, flush_every] {
+        static constexpr size_t bytes_per_run = 8_MiB;
+        const size_t writes = bytes_per_run / write_size;
+        auto f = ss::open_file_dma(
+                   fmt::format(
+                     "segment_appender_bench_{}.log", ss::this_shard_id()),
+                   ss::open_flags::create | ss::open_flags::rw
+                     | ss::open_flags::truncate)
+                   .get0();
+        auto appender = storage::segment_appender(
+          f,
+          storage::segment_appender::options(ss::default_priority_class(), 1));
+        const auto data = random_generators::gen_alphanum_string(write_size);
+        auto name = fmt::format("segment_appender.append_{}", write_size);
+        if (flush_every) {
+            name += fmt::format("_flush_{}", flush_every);
+        }
+        tests::alloc_counter allocs(std::move(name));
+        for (size_t i = 1; i <= writes; ++i) {
+            appender.append(data.data(), data.size()).get();
+            if (flush_every && i % flush_every == 0) {
+                appender.flush().get();
+            }
+        }
+        appender.flush().get();
+        allocs.stop(writes);
+        appender.close().get();
+    });
+}
+
+PERF_TEST(segment_appender, append_256B) { return append(256, 0); }
+
+PERF_TEST(segment_appender, append_4KiB) { return append(4_KiB, 0); }
+
+PERF_TEST(segment_appender, append_64KiB) { return append(64_KiB, 0); }
+
+// a produce with acks=all flushes after every batch it appends
+PERF_TEST(segment_appender, append_4KiB_flush) { return append(4_KiB, 1); }
+
+PERF_TEST(segment_appender, append_4KiB_flush_16) {
+    return append(4_KiB, 16);
+}
@@ -0,0 +1,118 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "random/generators.h"
+#include "storage/segment_chunk_cache.h"
+
+#include <seastar/core/seastar.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <cstring>
+
+using chunk_cache = storage::internal::segment_chunk_cache;
+
+// two full chunks and a half one
+static constexpr size_t file_size = 2 * chunk_cache::chunk_size
+                                    + chunk_cache::chunk_size / 2;
+
+struct cold_file {
+    ss::sstring name = "test.cold."
+                       + random_generators::gen_alphanum_string(20);
+    ss::sstring cache_dir = "test.cold_cache."
+                            + random_generators::gen_alphanum_string(20);
+    ss::sstring data = random_generators::gen_alphanum_string(file_size);
+    ss::file f;
+
+    cold_file() {
+        auto out = ss::open_file_dma(
+                     name, ss::open_flags::create | ss::open_flags::rw)
+                     .get0();
+        auto buf = ss::temporary_buffer<char>::aligned(4096, file_size);
+        std::memcpy(buf.get_write(), data.data(), file_size);
+        out.dma_write(0, buf.get(), buf.size()).get();
+        out.close().get();
+        f = ss::open_file_dma(name, ss::open_flags::ro).get0();
+    }
+
+    ~cold_file() {
+        f.close().get();
+        ss::remove_file(name).get();
+    }
+
+    ss::sstring chunk(size_t i) const {
+        const size_t pos = i * chunk_cache::chunk_size;
+        return data.substr(
+          pos, std::min(chunk_cache::chunk_size, file_size - pos));
+    }
+
+    ss::sstring read(chunk_cache& c, chunk_cache::segment_id id, size_t i) {
+        auto buf = c.get(id, f, file_size, i, ss::default_priority_class())
+                     .get0();
+        return ss::sstring(buf.get(), buf.size());
+    }
+};
+
+SEASTAR_THREAD_TEST_CASE(disabled_cache_reads_the_tier) {
+    cold_file t;
+    chunk_cache c;
+    const auto id = c.next_segment_id();
+    for (size_t i = 0; i < 3; ++i) {
+        BOOST_REQUIRE_EQUAL(t.read(c, id, i), t.chunk(i));
+    }
+    BOOST_CHECK_EQUAL(c.get_stats().misses, 3);
+    BOOST_CHECK_EQUAL(c.get_stats().hits, 0);
+    BOOST_CHECK_EQUAL(c.get_stats().bytes, 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(staged_chunks_are_served_locally) {
+    cold_file t;
+    chunk_cache c;
+    c.configure(chunk_cache::config{
+      .directory = t.cache_dir,
+      .max_bytes = 10 * chunk_cache::chunk_size,
+      .prefetch_chunks = 2});
+    const auto id = c.next_segment_id();
+    BOOST_REQUIRE_EQUAL(t.read(c, id, 0), t.chunk(0));
+    // waits for the prefetches and the staging
+    c.stop().get();
+    BOOST_CHECK_EQUAL(c.get_stats().misses, 1);
+    BOOST_CHECK_EQUAL(c.get_stats().prefetches, 2);
+    BOOST_CHECK_EQUAL(c.get_stats().bytes, file_size);
+
+    for (size_t i = 0; i < 3; ++i) {
+        BOOST_REQUIRE_EQUAL(t.read(c, id, i), t.chunk(i));
+    }
+    BOOST_CHECK_EQUAL(c.get_stats().hits, 3);
+
+    c.invalidate(id);
+    c.stop().get();
+    BOOST_CHECK_EQUAL(c.get_stats().bytes, 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(least_recently_read_chunks_are_evicted) {
+    cold_file t;
+    chunk_cache c;
+    c.configure(chunk_cache::config{
+      .directory = t.cache_dir,
+      .max_bytes = chunk_cache::chunk_size,
+      .prefetch_chunks = 0});
+    const auto id = c.next_segment_id();
+    BOOST_REQUIRE_EQUAL(t.read(c, id, 0), t.chunk(0));
+    c.stop().get();
+    BOOST_REQUIRE_EQUAL(t.read(c, id, 1), t.chunk(1));
+    c.stop().get();
+    BOOST_CHECK_EQUAL(c.get_stats().evictions, 1);
+    BOOST_CHECK_EQUAL(c.get_stats().bytes, chunk_cache::chunk_size);
+
+    // the evicted chunk is read from the tier again
+    BOOST_REQUIRE_EQUAL(t.read(c, id, 0), t.chunk(0));
+    BOOST_CHECK_EQUAL(c.get_stats().misses, 3);
+    c.invalidate(id);
+    c.stop().get();
+}
@@ -0,0 +1,71 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "random/generators.h"
+#include "storage/segment_index.h"
+#include "test_utils/alloc_counter.h"
+#include "utils/tmpbuf_file.h"
+
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <vector>
+
+/// lookups in the index of a full segment, every batch spans a step of the
+/// index so that each one has an entry
+static ss::future<> lookup(bool by_timestamp) {
+    return ss::async([by_timestamp] {
+        static constexpr int32_t batches = 32'768;
+        static constexpr int records_per_batch = 10;
+        static constexpr int lookups = 4096;
+        static constexpr auto step
+          = storage::segment_index::default_data_buffer_step;
+        tmpbuf_file::store_t data;
+        storage::segment_index idx(
+          "segment_index_bench",
+          ss::file(ss::make_shared(tmpbuf_file(data))),
+          model::offset(0),
+          step);
+        model::record_batch_header hdr;
+        hdr.size_bytes = step;
+        hdr.last_offset_delta = records_per_batch - 1;
+        for (int32_t i = 0; i < batches; ++i) {
+            hdr.base_offset = model::offset(i * records_per_batch);
+            hdr.first_timestamp = model::timestamp(i * 1000);
+            hdr.max_timestamp = model::timestamp(i * 1000 + 999);
+            idx.maybe_track(hdr, size_t(i) * step);
+        }
+        std::vector<int64_t> keys;
+        keys.reserve(lookups);
+        for (int i = 0; i < lookups; ++i) {
+            keys.push_back(random_generators::get_int<int64_t>(
+              by_timestamp ? batches * 1000 - 1
+                           : batches * records_per_batch - 1));
+        }
+        size_t found = 0;
+        tests::alloc_counter allocs(
+          by_timestamp ? "segment_index.find_nearest_timestamp"
+                       : "segment_index.find_nearest_offset");
+        for (auto k : keys) {
+            auto e = by_timestamp ? idx.find_nearest(model::timestamp(k))
+                                  : idx.find_nearest(model::offset(k));
+            found += bool(e);
+        }
+        allocs.stop(keys.size());
+        perf_tests::do_not_optimize(found);
+        idx.close().get();
+    });
+}
+
+PERF_TEST(segment_index, find_nearest_offset) { return lookup(false); }
+
+PERF_TEST(segment_index, find_nearest_timestamp) { return lookup(true); }
@@ -15,8 +15,10 @@
 #include "model/timestamp.h"
 #include "random/generators.h"
 #include "storage/batch_cache.h"
+#include "storage/compacted_index_reader.h"
 #include "storage/log_manager.h"
 #include "storage/record_batch_builder.h"
+#include "storage/segment_utils.h"
 #include "storage/tests/storage_test_fixture.h"
 #include "storage/tests/utils/disk_log_builder.h"
 #include "storage/tests/utils/random_batch.h"
@@ -1066,3 +1068,334 @@ FIXTURE_TEST(check_segment_size_jitter, storage_test_fixture) {
         [size = sizes[0]](auto other) { return size == other; }),
       false);
 }
+
+FIXTURE_TEST(compaction_index_caught_up_on_roll, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(
+      ntp, mgr.config().base_dir, std::make_unique<overrides_t>(ov));
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+    storage::log_append_config append_cfg{
+      .should_fsync = storage::log_append_config::fsync::no,
+      .io_priority = ss::default_priority_class(),
+      .timeout = model::no_timeout,
+    };
+    // the keys are indexed behind the appends
+    constexpr int batches = 50;
+    for (int i = 0; i < batches; ++i) {
+        storage::record_batch_builder builder(
+          model::record_batch_type(1), model::offset(0));
+        builder.add_raw_kv(
+          bytes_to_iobuf(bytes(fmt::format("key-{}", i).c_str())),
+          bytes_to_iobuf(bytes("value")));
+        auto batch = std::move(builder).build();
+        batch.set_term(model::term_id(1));
+        model::make_memory_record_batch_reader({std::move(batch)})
+          .for_each_ref(log.make_appender(append_cfg), model::no_timeout)
+          .get0();
+    }
+    // a new term rolls the segment, which waits for its index
+    append_single_record_batch(log, 1, model::term_id(2));
+    auto& segs = get_disk_log(log)->segments();
+    BOOST_REQUIRE_EQUAL(segs.size(), 2);
+
+    auto path = storage::internal::compacted_index_path(
+      segs.front()->reader().filename().c_str());
+    auto f = ss::open_file_dma(path.string(), ss::open_flags::ro).get0();
+    auto rdr = storage::make_file_backed_compacted_reader(
+      path.string(), std::move(f), ss::default_priority_class(), 64_KiB);
+    auto entries = storage::compaction_index_reader_to_memory(rdr).get0();
+    rdr.close().get();
+    std::vector<model::offset> offsets;
+    for (auto& e : entries) {
+        offsets.push_back(e.offset);
+    }
+    std::sort(offsets.begin(), offsets.end());
+    BOOST_REQUIRE_EQUAL(offsets.size(), batches);
+    for (int i = 0; i < batches; ++i) {
+        BOOST_REQUIRE_EQUAL(offsets[i], model::offset(i));
+    }
+}
+
+FIXTURE_TEST(compaction_backlog_follows_compaction, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(
+      ntp, mgr.config().base_dir, std::make_unique<overrides_t>(ov));
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+    ss::abort_source as;
+    storage::compaction_config c_cfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+
+    // the active segment is not part of the backlog
+    append_single_record_batch(log, 14, model::term_id(1));
+    BOOST_REQUIRE_EQUAL(log.backlog().dirty_bytes, 0);
+    // a new term rolls the segment, all its batches share a key
+    append_single_record_batch(log, 1, model::term_id(2));
+    auto backlog = log.backlog();
+    BOOST_REQUIRE_GT(backlog.dirty_bytes, 0);
+    BOOST_REQUIRE_EQUAL(backlog.clean_bytes, 0);
+    BOOST_REQUIRE_EQUAL(backlog.dirty_ratio(), 1.0);
+    // nothing was compacted yet, all the dirty bytes may go
+    BOOST_REQUIRE_EQUAL(backlog.reclaimable_bytes, backlog.dirty_bytes);
+
+    log.compact(c_cfg).get0();
+    backlog = log.backlog();
+    BOOST_REQUIRE_EQUAL(backlog.dirty_bytes, 0);
+    BOOST_REQUIRE_GT(backlog.clean_bytes, 0);
+
+    append_single_record_batch(log, 14, model::term_id(3));
+    backlog = log.backlog();
+    BOOST_REQUIRE_GT(backlog.dirty_bytes, 0);
+    BOOST_REQUIRE_GT(backlog.dirty_ratio(), 0.0);
+    BOOST_REQUIRE_LT(backlog.dirty_ratio(), 1.0);
+    // the estimate follows what compaction freed so far
+    BOOST_REQUIRE_LT(backlog.reclaimable_bytes, backlog.dirty_bytes);
+
+    // compacting alone, then across the segments
+    for (int i = 0; i < 3 && log.backlog().dirty_bytes > 0; ++i) {
+        log.compact(c_cfg).get0();
+    }
+    BOOST_REQUIRE_EQUAL(log.backlog().dirty_bytes, 0);
+}
+
+FIXTURE_TEST(rolls_to_prepared_segments, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.max_segment_size = 100_KiB;
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.segment_prepare_percent = 50;
+    auto ntp = model::ntp("default", "test", 0);
+    size_t batches = 0;
+    {
+        storage::log_manager mgr = make_log_manager(cfg);
+        auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+        auto log = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir))
+                     .get0();
+        for (int i = 0; i < 10; ++i) {
+            append_exactly(log, 100, 100).get0();
+            // the files are prepared in the background of the appends
+            ss::sleep(10ms).get();
+        }
+        BOOST_REQUIRE_GT(log.segment_count(), 1);
+        batches = read_and_validate_all_batches(log).size();
+        BOOST_REQUIRE_EQUAL(batches, 1000);
+    }
+    // recovery skips the staged files left in the directory of the log
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto log
+      = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0();
+    BOOST_REQUIRE_EQUAL(read_and_validate_all_batches(log).size(), batches);
+    append_exactly(log, 100, 100).get0();
+    BOOST_REQUIRE_EQUAL(
+      read_and_validate_all_batches(log).size(), batches + 100);
+}
+
+FIXTURE_TEST(resumes_parked_readers, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.readers_cache_cfg = storage::readers_cache::config{
+      .max_readers = 2, .idle_timeout = 10s};
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    auto log
+      = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0();
+    const auto& readers = get_disk_log(log)->readers();
+    auto read_from = [&log](model::offset o) {
+        storage::log_reader_config rcfg(
+          o, log.offsets().committed_offset, ss::default_priority_class());
+        auto reader = log.make_reader(rcfg).get0();
+        return model::consume_reader_to_memory(
+                 std::move(reader), model::no_timeout)
+          .get0();
+    };
+
+    append_random_batches(log, 10);
+    auto first = read_from(model::offset(0));
+    BOOST_REQUIRE(!first.empty());
+    // the reader stopped at the end of the log and is parked there
+    BOOST_REQUIRE_EQUAL(readers.size(), 1);
+
+    append_random_batches(log, 10);
+    const auto next = first.back().last_offset() + model::offset(1);
+    auto second = read_from(next);
+    BOOST_REQUIRE(!second.empty());
+    BOOST_REQUIRE_EQUAL(second.front().base_offset(), next);
+    BOOST_REQUIRE_EQUAL(
+      second.back().last_offset(), log.offsets().committed_offset);
+    BOOST_REQUIRE_EQUAL(readers.size(), 1);
+
+    // the readers of a truncated range are closed
+    log.truncate(storage::truncate_config(next, ss::default_priority_class()))
+      .get0();
+    BOOST_REQUIRE_EQUAL(readers.size(), 0);
+    BOOST_REQUIRE_EQUAL(read_from(model::offset(0)).size(), first.size());
+}
+
+FIXTURE_TEST(recompresses_closed_segments, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.compression = model::compression::zstd;
+    auto ntp = model::ntp("default", "test", 0);
+    auto log = mgr.manage(storage::ntp_config(
+                            ntp,
+                            mgr.config().base_dir,
+                            std::make_unique<overrides_t>(ov)))
+                 .get0();
+    ss::abort_source as;
+    storage::compaction_config c_cfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+
+    append_single_record_batch(log, 14, model::term_id(1));
+    // a new term rolls the segment, the active one is left as it is
+    append_single_record_batch(log, 1, model::term_id(2));
+    log.flush().get0();
+    log.compact(c_cfg).get0();
+
+    auto batches = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(batches.size(), 15);
+    for (size_t i = 0; i < batches.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(batches[i].base_offset(), model::offset(i));
+        BOOST_REQUIRE_EQUAL(
+          batches[i].header().attrs.compression(),
+          i < 14 ? model::compression::zstd : model::compression::none);
+    }
+}
+
+FIXTURE_TEST(compaction_rewrites_to_topic_codec, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+    ov.compression = model::compression::lz4;
+    auto ntp = model::ntp("default", "test", 0);
+    auto log = mgr.manage(storage::ntp_config(
+                            ntp,
+                            mgr.config().base_dir,
+                            std::make_unique<overrides_t>(ov)))
+                 .get0();
+    ss::abort_source as;
+    storage::compaction_config c_cfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+
+    // all the batches share a key, the last of the segment is kept
+    append_single_record_batch(log, 14, model::term_id(1));
+    append_single_record_batch(log, 1, model::term_id(2));
+    log.flush().get0();
+    log.compact(c_cfg).get0();
+
+    auto batches = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(batches.size(), 2);
+    BOOST_REQUIRE_EQUAL(batches[0].base_offset(), model::offset(13));
+    BOOST_REQUIRE_EQUAL(
+      batches[0].header().attrs.compression(), model::compression::lz4);
+    BOOST_REQUIRE_EQUAL(
+      batches[1].header().attrs.compression(), model::compression::none);
+}
+
+FIXTURE_TEST(lookup_key_in_compacted_log, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+    auto ntp = model::ntp("default", "test", 0);
+    auto log = mgr.manage(storage::ntp_config(
+                            ntp,
+                            mgr.config().base_dir,
+                            std::make_unique<overrides_t>(ov)))
+                 .get0();
+    auto append = [&log](int key, ss::sstring value, model::term_id term) {
+        storage::record_batch_builder builder(
+          model::record_batch_type(1), model::offset(0));
+        builder.add_raw_kv(
+          bytes_to_iobuf(bytes(fmt::format("key-{}", key).c_str())),
+          bytes_to_iobuf(bytes(value.c_str())));
+        auto batch = std::move(builder).build();
+        batch.set_term(term);
+        storage::log_append_config append_cfg{
+          .should_fsync = storage::log_append_config::fsync::no,
+          .io_priority = ss::default_priority_class(),
+          .timeout = model::no_timeout,
+        };
+        model::make_memory_record_batch_reader({std::move(batch)})
+          .for_each_ref(log.make_appender(append_cfg), model::no_timeout)
+          .get0();
+    };
+    auto lookup = [&log](int key, model::offset max_offset) {
+        return log
+          .lookup_key(storage::key_lookup_config(
+            bytes(fmt::format("key-{}", key).c_str()),
+            max_offset,
+            ss::default_priority_class()))
+          .get0();
+    };
+    auto value_of = [](const storage::key_lookup_result& r) {
+        return iobuf_to_bytes(*r.value);
+    };
+
+    // every term rolls the segment, the closed ones are indexed
+    for (int i = 0; i < 10; ++i) {
+        append(i, "v1", model::term_id(1));
+    }
+    append(3, "v2", model::term_id(2));
+    append(7, "v3", model::term_id(3));
+    BOOST_REQUIRE_EQUAL(get_disk_log(log)->segments().size(), 3);
+    const auto max = log.offsets().dirty_offset;
+
+    // the first segment is answered by its index
+    auto r = lookup(0, max);
+    BOOST_REQUIRE(r);
+    BOOST_REQUIRE_EQUAL(r->offset, model::offset(0));
+    BOOST_REQUIRE_EQUAL(value_of(*r), bytes("v1"));
+    // the newest segment holding the key wins
+    r = lookup(3, max);
+    BOOST_REQUIRE(r);
+    BOOST_REQUIRE_EQUAL(r->offset, model::offset(10));
+    BOOST_REQUIRE_EQUAL(value_of(*r), bytes("v2"));
+    // the active segment is scanned
+    r = lookup(7, max);
+    BOOST_REQUIRE(r);
+    BOOST_REQUIRE_EQUAL(r->offset, model::offset(11));
+    BOOST_REQUIRE_EQUAL(value_of(*r), bytes("v3"));
+    // records past the max offset are not visible
+    r = lookup(3, model::offset(9));
+    BOOST_REQUIRE(r);
+    BOOST_REQUIRE_EQUAL(r->offset, model::offset(3));
+    BOOST_REQUIRE(!lookup(42, max));
+
+    ss::abort_source as;
+    storage::compaction_config c_cfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+    log.flush().get0();
+    log.compact(c_cfg).get0();
+    r = lookup(3, max);
+    BOOST_REQUIRE(r);
+    BOOST_REQUIRE_EQUAL(r->offset, model::offset(10));
+    BOOST_REQUIRE_EQUAL(value_of(*r), bytes("v2"));
+    r = lookup(9, max);
+    BOOST_REQUIRE(r);
+    BOOST_REQUIRE_EQUAL(value_of(*r), bytes("v1"));
+}
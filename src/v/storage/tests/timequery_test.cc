@@ -13,6 +13,8 @@
 
 #include <seastar/core/file.hh>
 
+#include <array>
+
 FIXTURE_TEST(timequery, log_builder_fixture) {
     using namespace storage; // NOLINT
 
@@ -113,3 +115,48 @@ FIXTURE_TEST(timequery_single_value, log_builder_fixture) {
     BOOST_TEST(res->offset == model::offset(0));
     b | stop();
 }
+
+FIXTURE_TEST(timequery_non_monotonic_segments, log_builder_fixture) {
+    using namespace storage; // NOLINT
+
+    b | start();
+
+    // seg0: timestamps [500...599], seg1: [100...199], seg2: [600...699]
+    // offsets are [0...299]
+    const std::array<int64_t, 3> bases = {500, 100, 600};
+    for (auto s = 0; s < 3; ++s) {
+        b | add_segment(s * 100);
+        for (auto i = 0; i < 100; ++i) {
+            auto batch = test::make_random_batch(
+              model::offset(s * 100 + i), 1, false);
+            batch.header().first_timestamp = model::timestamp(bases[s] + i);
+            batch.header().max_timestamp = model::timestamp(bases[s] + i);
+            b | add_batch(std::move(batch));
+        }
+    }
+
+    auto log = b.get_log();
+    auto query = [&log](int64_t ts) {
+        storage::timequery_config config(
+          model::timestamp(ts),
+          log.offsets().dirty_offset,
+          ss::default_priority_class());
+        return log.timequery(config).get0();
+    };
+    // the earliest batch at or above the timestamp
+    auto res = query(150);
+    BOOST_TEST(res);
+    BOOST_TEST(res->offset == model::offset(0));
+    res = query(550);
+    BOOST_TEST(res);
+    BOOST_TEST(res->offset == model::offset(50));
+    res = query(600);
+    BOOST_TEST(res);
+    BOOST_TEST(res->offset == model::offset(200));
+    res = query(650);
+    BOOST_TEST(res);
+    BOOST_TEST(res->offset == model::offset(250));
+    BOOST_TEST(!query(700));
+
+    b | stop();
+}
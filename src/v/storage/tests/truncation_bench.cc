@@ -0,0 +1,68 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/fundamental.h"
+#include "storage/segment_index.h"
+#include "storage/tests/utils/disk_log_builder.h"
+#include "storage/tests/utils/random_batch.h"
+#include "test_utils/alloc_counter.h"
+
+#include <seastar/core/thread.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+#include <vector>
+
+/// raft truncates the last batches of the log when a new leader overwrites
+/// what an old one appended. every round appends batches to the active
+/// segment and truncates `batches_back` of them away
+static ss::future<> truncate_tail(size_t batches_back) {
+    return ss::async([batches_back] {
+        static constexpr int rounds = 10;
+        static constexpr int batches_per_round = 600;
+        storage::disk_log_builder builder;
+        builder.start().get();
+        builder.add_segment(model::offset(0)).get();
+        auto cfg = storage::append_config();
+        cfg.should_fsync = storage::log_append_config::fsync::no;
+        model::offset next(0);
+        for (int r = 0; r < rounds; ++r) {
+            auto batches = storage::test::make_random_batches(
+              next, batches_per_round, false);
+            std::vector<model::offset> bases;
+            bases.reserve(batches.size());
+            for (auto& b : batches) {
+                bases.push_back(b.base_offset());
+                builder
+                  .add_batch(
+                    std::move(b),
+                    cfg,
+                    storage::disk_log_builder::should_flush_after::no)
+                  .get();
+            }
+            next = bases[bases.size() - batches_back];
+            tests::alloc_counter allocs(
+              fmt::format("truncation.last_{}_batches", batches_back));
+            builder.truncate(next).get();
+            allocs.stop(1);
+        }
+        builder.stop().get();
+    });
+}
+
+PERF_TEST(truncation, last_batch) { return truncate_tail(1); }
+
+PERF_TEST(truncation, last_32_batches) { return truncate_tail(32); }
+
+// beyond the positions kept by the index, scans from the nearest entry
+PERF_TEST(truncation, last_512_batches) {
+    static_assert(storage::segment_index::tail_positions < 512);
+    return truncate_tail(512);
+}
@@ -48,18 +48,33 @@ std::ostream& operator<<(std::ostream& o, const timequery_result& a) {
 std::ostream& operator<<(std::ostream& o, const timequery_config& a) {
     return o << "{max_offset:" << a.max_offset << ", time:" << a.time << "}";
 }
+std::ostream& operator<<(std::ostream& o, const key_lookup_config& a) {
+    return o << "{max_offset:" << a.max_offset
+             << ", key_size:" << a.key.size() << "}";
+}
+std::ostream& operator<<(std::ostream& o, const key_lookup_result& a) {
+    return o << "{offset:" << a.offset << ", timestamp:" << a.timestamp
+             << ", value_size:"
+             << (a.value ? int64_t(a.value->size_bytes()) : int64_t(-1))
+             << "}";
+}
 
 std::ostream&
 operator<<(std::ostream& o, const ntp_config::default_overrides& v) {
     fmt::print(
       o,
       "{{compaction_strategy: {}, cleanup_policy_bitflags: {}, segment_size: "
-      "{}, retention_bytes: {}, retention_time_ms: {}}}",
+      "{}, index_interval: {}, retention_bytes: {}, retention_time_ms: {}, "
+      "write_behind_ms: {}, compression: {}, ephemeral: {}}}",
       v.compaction_strategy,
       v.cleanup_policy_bitflags,
       v.segment_size,
+      v.index_interval,
       v.retention_bytes,
-      v.retention_time);
+      v.retention_time,
+      v.write_behind,
+      v.compression,
+      v.ephemeral);
 
     return o;
 }
@@ -99,13 +114,39 @@ std::ostream& operator<<(std::ostream& o, const offset_stats& s) {
     return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const compaction_backlog& b) {
+    fmt::print(
+      o,
+      "{{clean_bytes:{}, dirty_bytes:{}, reclaimable_bytes:{}}}",
+      b.clean_bytes,
+      b.dirty_bytes,
+      b.reclaimable_bytes);
+    return o;
+}
+
+std::ostream& operator<<(std::ostream& o, const segment_file& f) {
+    fmt::print(
+      o,
+      "{{base_offset:{}, committed_offset:{}, term:{}, size_bytes:{}, "
+      "data_path:{}}}",
+      f.base_offset,
+      f.committed_offset,
+      f.term,
+      f.size_bytes,
+      f.data_path);
+    return o;
+}
+
 std::ostream& operator<<(std::ostream& o, const compaction_config& c) {
     fmt::print(
       o,
-      "{{evicition_time:{}, max_bytes:{}, should_sanitize:{}}}",
+      "{{evicition_time:{}, max_bytes:{}, should_sanitize:{}, "
+      "cold_storage_time:{}, compression:{}}}",
       c.eviction_time,
       c.max_bytes.value_or(-1),
-      c.sanitize);
+      c.sanitize,
+      c.cold_storage_time.value_or(model::timestamp::missing()),
+      c.compression);
     return o;
 }
 
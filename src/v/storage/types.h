@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
 #include "model/fundamental.h"
 #include "model/limits.h"
 #include "model/record.h"
@@ -57,11 +59,50 @@ struct offset_stats {
     friend std::ostream& operator<<(std::ostream&, const offset_stats&);
 };
 
+/// a segment which is no longer appended to, as seen outside of storage
+struct segment_file {
+    model::offset base_offset;
+    model::offset committed_offset;
+    model::term_id term;
+    model::timestamp max_timestamp;
+    size_t size_bytes;
+    ss::sstring data_path;
+    ss::sstring index_path;
+
+    friend std::ostream& operator<<(std::ostream&, const segment_file&);
+};
+
+/// compaction work of the closed segments of a compacted log
+struct compaction_backlog {
+    // bytes rewritten by compaction since their last change
+    size_t clean_bytes{0};
+    // bytes never compacted alone, or sealed since the last cross segment
+    // pass
+    size_t dirty_bytes{0};
+    // estimate of the dirty bytes compaction would free
+    size_t reclaimable_bytes{0};
+
+    /// share of the closed compacted bytes still to compact
+    double dirty_ratio() const {
+        const auto total = clean_bytes + dirty_bytes;
+        return total == 0 ? 0.0 : static_cast<double>(dirty_bytes) / total;
+    }
+
+    friend std::ostream& operator<<(std::ostream&, const compaction_backlog&);
+};
+
+/// position the batches enter the batch cache at. low priority batches are
+/// the first ones reclaimed
+enum class cache_priority : int8_t { normal, low };
+
 struct log_append_config {
     using fsync = ss::bool_class<class skip_tag>;
     fsync should_fsync;
     ss::io_priority_class io_priority;
     model::timeout_clock::time_point timeout;
+    cache_priority cache{cache_priority::normal};
+    // term given to every batch as it is appended, along with its offset
+    std::optional<model::term_id> term;
 };
 struct append_result {
     log_clock::time_point append_time;
@@ -103,6 +144,33 @@ struct timequery_result {
     friend std::ostream& operator<<(std::ostream& o, const timequery_result&);
 };
 
+struct key_lookup_config {
+    key_lookup_config(
+      bytes k,
+      model::offset o,
+      ss::io_priority_class iop,
+      opt_abort_source_t as = std::nullopt) noexcept
+      : key(std::move(k))
+      , max_offset(o)
+      , prio(iop)
+      , abort_source(as) {}
+    bytes key;
+    model::offset max_offset;
+    ss::io_priority_class prio;
+    opt_abort_source_t abort_source;
+
+    friend std::ostream& operator<<(std::ostream& o, const key_lookup_config&);
+};
+/// the latest record of a key
+struct key_lookup_result {
+    model::offset offset;
+    model::timestamp timestamp;
+    /// std::nullopt for a tombstone
+    std::optional<iobuf> value;
+
+    friend std::ostream& operator<<(std::ostream& o, const key_lookup_result&);
+};
+
 struct truncate_config {
     truncate_config(model::offset o, ss::io_priority_class p)
       : base_offset(o)
@@ -216,18 +284,22 @@ struct log_reader_config {
     friend std::ostream& operator<<(std::ostream& o, const log_reader_config&);
 };
 
+class compaction_throttle;
+
 struct compaction_config {
     explicit compaction_config(
       model::timestamp upper,
       std::optional<size_t> max_bytes_in_log,
       ss::io_priority_class p,
       ss::abort_source& as,
-      debug_sanitize_files should_sanitize = debug_sanitize_files::no)
+      debug_sanitize_files should_sanitize = debug_sanitize_files::no,
+      compaction_throttle* t = nullptr)
       : eviction_time(upper)
       , max_bytes(max_bytes_in_log)
       , iopc(p)
       , sanitize(should_sanitize)
-      , asrc(&as) {}
+      , asrc(&as)
+      , throttle(t) {}
 
     // remove everything below eviction time
     model::timestamp eviction_time;
@@ -239,6 +311,14 @@ struct compaction_config {
     debug_sanitize_files sanitize;
     // abort source for compaction task
     ss::abort_source* asrc;
+    // optional rate limit for bytes read and rewritten by compaction
+    compaction_throttle* throttle;
+    // move closed segments older than this to the storage tier
+    std::optional<model::timestamp> cold_storage_time;
+    // base directory of the storage tier, logs use their ntp path under it
+    std::optional<ss::sstring> cold_storage_dir;
+    // codec of the data batches rewritten, set from the ntp_config overrides
+    std::optional<model::compression> compression;
 
     friend std::ostream& operator<<(std::ostream&, const compaction_config&);
 };
@@ -0,0 +1,192 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "seastarx.h"
+#include "syschecks/syschecks.h"
+#include "units.h"
+
+#include <seastar/core/aligned_buffer.hh>
+#include <seastar/core/file.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace syschecks {
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+constexpr size_t sequential_block = 1_MiB;
+constexpr size_t random_block = 4_KiB;
+constexpr size_t sequential_depth = 4;
+constexpr size_t random_depth = 64;
+// bounds the scratch file when the sequential writes outrun the duration
+constexpr uint64_t max_extent = 2_GiB;
+
+struct run_result {
+    uint64_t bytes{0};
+    clock_type::duration elapsed{};
+
+    uint64_t per_second(uint64_t units) const {
+        const auto us = std::max<int64_t>(
+          1,
+          std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count());
+        return units * 1'000'000 / us;
+    }
+    uint64_t bandwidth() const { return per_second(bytes); }
+    uint64_t iops(size_t block) const { return per_second(bytes / block); }
+};
+
+/// runs `op` from `depth` concurrent fibers until the duration elapses, a
+/// fiber stops early once its op returns 0 bytes
+template<typename Op>
+run_result run_for(std::chrono::milliseconds duration, size_t depth, Op op) {
+    run_result r;
+    const auto start = clock_type::now();
+    const auto deadline = start + duration;
+    std::vector<ss::future<>> fibers;
+    fibers.reserve(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        fibers.push_back(ss::repeat([deadline, &r, &op] {
+            if (clock_type::now() >= deadline) {
+                return ss::make_ready_future<ss::stop_iteration>(
+                  ss::stop_iteration::yes);
+            }
+            return op().then([&r](size_t n) {
+                r.bytes += n;
+                return ss::stop_iteration(n == 0);
+            });
+        }));
+    }
+    ss::when_all_succeed(fibers.begin(), fibers.end()).get();
+    r.elapsed = clock_type::now() - start;
+    return r;
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& o, const disk_calibration& c) {
+    fmt::print(
+      o,
+      "{{read_iops: {}, read_bandwidth: {}, write_iops: {}, write_bandwidth: "
+      "{}}}",
+      c.read_iops,
+      c.read_bandwidth,
+      c.write_iops,
+      c.write_bandwidth);
+    return o;
+}
+
+ss::future<disk_calibration>
+calibrate_disk(const ss::sstring& path, std::chrono::milliseconds duration) {
+    return ss::async([path, duration] {
+        const auto scratch = fmt::format("{}/.disk_calibration", path);
+        auto f = ss::open_file_dma(
+                   scratch,
+                   ss::open_flags::create | ss::open_flags::rw
+                     | ss::open_flags::truncate)
+                   .get0();
+        const auto alignment = f.disk_write_dma_alignment();
+        auto data = ss::allocate_aligned_buffer<char>(
+          sequential_block, alignment);
+        std::memset(data.get(), 'x', sequential_block);
+        std::mt19937_64 rng(std::random_device{}());
+        const auto& pc = ss::default_priority_class();
+        disk_calibration c;
+
+        // the sequential writes lay out the extent the other runs address
+        uint64_t next = 0;
+        auto swrite = run_for(duration, sequential_depth, [&] {
+            if (next >= max_extent) {
+                return ss::make_ready_future<size_t>(0);
+            }
+            const auto pos = std::exchange(next, next + sequential_block);
+            return f.dma_write(pos, data.get(), sequential_block, pc);
+        });
+        f.flush().get();
+        const uint64_t extent = std::max<uint64_t>(
+          swrite.bytes, sequential_block);
+        c.write_bandwidth = swrite.bandwidth();
+
+        next = 0;
+        auto sread = run_for(duration, sequential_depth, [&] {
+            const auto pos = std::exchange(next, next + sequential_block)
+                             % extent;
+            return f.dma_read<char>(pos, sequential_block, pc)
+              .then([](ss::temporary_buffer<char> b) { return b.size(); });
+        });
+        c.read_bandwidth = sread.bandwidth();
+
+        std::uniform_int_distribution<uint64_t> block(
+          0, extent / random_block - 1);
+        auto rread = run_for(duration, random_depth, [&] {
+            return f.dma_read<char>(block(rng) * random_block, random_block, pc)
+              .then([](ss::temporary_buffer<char> b) { return b.size(); });
+        });
+        c.read_iops = rread.iops(random_block);
+
+        auto rwrite = run_for(duration, random_depth, [&] {
+            return f.dma_write(
+              block(rng) * random_block, data.get(), random_block, pc);
+        });
+        f.flush().get();
+        c.write_iops = rwrite.iops(random_block);
+
+        f.close().get();
+        ss::remove_file(scratch).get();
+        checklog.info("Disk calibration of `{}': {}", path, c);
+        return c;
+    });
+}
+
+ss::future<> write_io_properties(
+  std::filesystem::path file,
+  const ss::sstring& mountpoint,
+  const disk_calibration& c) {
+    auto content = fmt::format(
+      "disks:\n"
+      "  - mountpoint: {}\n"
+      "    read_iops: {}\n"
+      "    read_bandwidth: {}\n"
+      "    write_iops: {}\n"
+      "    write_bandwidth: {}\n",
+      mountpoint,
+      c.read_iops,
+      c.read_bandwidth,
+      c.write_iops,
+      c.write_bandwidth);
+    return ss::async([file = std::move(file), content = std::move(content)] {
+        auto tmp = file;
+        tmp += ".tmp";
+        auto f = ss::open_file_dma(
+                   tmp.string(),
+                   ss::open_flags::create | ss::open_flags::wo
+                     | ss::open_flags::truncate)
+                   .get0();
+        auto out = ss::make_file_output_stream(std::move(f)).get0();
+        out.write(content.data(), content.size()).get();
+        out.flush().get();
+        out.close().get();
+        ss::rename_file(tmp.string(), file.string()).get();
+        const auto dir = file.parent_path();
+        ss::sync_directory(dir.empty() ? "." : dir.string()).get();
+    });
+}
+
+} // namespace syschecks
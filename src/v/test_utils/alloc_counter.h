@@ -0,0 +1,88 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+
+#include <seastar/core/memory.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace tests {
+
+/**
+ * perf_tests reports the time per op of a test, the allocations per op are
+ * reported next to it by bracketing the measured section with an
+ * alloc_counter instead of perf_tests::start/stop_measuring_time:
+ *
+ *   tests::alloc_counter allocs("segment_appender.append_4KiB");
+ *   ... work of `ops` operations ...
+ *   allocs.stop(ops);
+ *
+ * The counts of every test of the binary are printed once it exits. They
+ * are the allocations of shard 0, perf_tests runs the same test on every
+ * shard. They come from the seastar allocator, so they read 0 in builds with
+ * the default allocator.
+ */
+class alloc_counter {
+public:
+    explicit alloc_counter(std::string test)
+      : _test(std::move(test))
+      , _mallocs(ss::memory::stats().mallocs()) {
+        perf_tests::start_measuring_time();
+    }
+
+    /// ends the measured section of `ops` operations
+    void stop(size_t ops) {
+        perf_tests::stop_measuring_time();
+        if (ss::this_shard_id() != 0) {
+            return;
+        }
+        auto& t = totals()[_test];
+        t.allocs += ss::memory::stats().mallocs() - _mallocs;
+        t.ops += ops;
+    }
+
+private:
+    struct total {
+        uint64_t allocs{0};
+        uint64_t ops{0};
+    };
+
+    struct report {
+        std::map<std::string, total> tests;
+        ~report() {
+            fmt::print("\n{:<48} {:>12}\n", "test", "allocs/op");
+            for (auto& [name, t] : tests) {
+                fmt::print(
+                  "{:<48} {:>12.2f}\n",
+                  name,
+                  t.ops ? double(t.allocs) / t.ops : 0.0);
+            }
+        }
+    };
+
+    static std::map<std::string, total>& totals() {
+        static report r;
+        return r.tests;
+    }
+
+    std::string _test;
+    uint64_t _mallocs;
+};
+
+} // namespace tests
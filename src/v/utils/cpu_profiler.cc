@@ -0,0 +1,208 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/cpu_profiler.h"
+
+#include <seastar/core/scheduling.hh>
+#include <seastar/util/log.hh>
+
+#include <fmt/format.h>
+
+#include <execinfo.h>
+#include <link.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+static ss::logger proflog("cpu_profiler");
+
+// profiler of the shard running on this thread, used by the signal handler
+static thread_local cpu_profiler* local_profiler = nullptr;
+
+// frames of the signal handler when the interrupted pc can't be found
+static constexpr int handler_frames = 3;
+
+static uintptr_t interrupted_pc(const ucontext_t* ctx) {
+#if defined(__x86_64__)
+    return static_cast<uintptr_t>(ctx->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+    return static_cast<uintptr_t>(ctx->uc_mcontext.pc);
+#else
+    (void)ctx;
+    return 0;
+#endif
+}
+
+struct address_range {
+    uintptr_t begin{0};
+    uintptr_t end{0};
+};
+
+// address range of the loaded executable
+static const address_range& executable_range() {
+    static const address_range range = [] {
+        address_range ret;
+        // the executable is always the first object reported
+        dl_iterate_phdr(
+          [](dl_phdr_info* info, size_t, void* data) {
+              auto& r = *static_cast<address_range*>(data);
+              r.begin = info->dlpi_addr;
+              r.end = info->dlpi_addr;
+              for (int i = 0; i < info->dlpi_phnum; ++i) {
+                  const auto& ph = info->dlpi_phdr[i];
+                  if (ph.p_type == PT_LOAD) {
+                      r.end = std::max<uintptr_t>(
+                        r.end, info->dlpi_addr + ph.p_vaddr + ph.p_memsz);
+                  }
+              }
+              return 1;
+          },
+          &ret);
+        return ret;
+    }();
+    return range;
+}
+
+static void install_signal_handler(void (*handler)(int, siginfo_t*, void*)) {
+    static std::once_flag installed;
+    std::call_once(installed, [handler] {
+        // the first call of backtrace() loads libgcc, which is not async
+        // signal safe, make sure it happens out of the handler
+        std::array<void*, 1> frames{};
+        ::backtrace(frames.data(), frames.size());
+        executable_range();
+
+        struct sigaction sa {};
+        sa.sa_sigaction = handler;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (::sigaction(SIGPROF, &sa, nullptr) != 0) {
+            throw std::system_error(
+              errno, std::system_category(), "unable to install SIGPROF");
+        }
+    });
+}
+
+cpu_profiler::cpu_profiler(
+  bool enabled, std::chrono::milliseconds sample_period, size_t ring_size) {
+    if (!enabled || sample_period.count() <= 0) {
+        return;
+    }
+    _ring.resize(ring_size);
+    install_signal_handler(&cpu_profiler::on_signal);
+    local_profiler = this;
+
+    // reactor threads block most signals
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPROF);
+    ::pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+
+    sigevent sev{};
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev._sigev_un._tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    // cpu time of the thread, idle shards are not sampled
+    if (::timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &_timer) != 0) {
+        proflog.warn("Unable to create profiler timer, errno: {}", errno);
+        local_profiler = nullptr;
+        return;
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                sample_period)
+                .count();
+    itimerspec spec{};
+    spec.it_interval.tv_sec = ns / 1'000'000'000;
+    spec.it_interval.tv_nsec = ns % 1'000'000'000;
+    spec.it_value = spec.it_interval;
+    if (::timer_settime(_timer, 0, &spec, nullptr) != 0) {
+        proflog.warn("Unable to arm profiler timer, errno: {}", errno);
+        ::timer_delete(_timer);
+        local_profiler = nullptr;
+        return;
+    }
+    _timer_armed = true;
+}
+
+cpu_profiler::~cpu_profiler() noexcept {
+    if (_timer_armed) {
+        ::timer_delete(_timer);
+        _timer_armed = false;
+    }
+    if (local_profiler == this) {
+        local_profiler = nullptr;
+    }
+}
+
+ss::future<> cpu_profiler::stop() {
+    if (_timer_armed) {
+        ::timer_delete(_timer);
+        _timer_armed = false;
+    }
+    local_profiler = nullptr;
+    return ss::make_ready_future<>();
+}
+
+void cpu_profiler::on_signal(int, siginfo_t*, void* ctx) {
+    if (auto p = local_profiler; p) {
+        p->take_sample(static_cast<const ucontext_t*>(ctx));
+    }
+}
+
+void cpu_profiler::take_sample(const ucontext_t* ctx) noexcept {
+    if (_collecting) {
+        ++_dropped;
+        return;
+    }
+    auto& s = _ring[_samples % _ring.size()];
+    const int depth = std::max(::backtrace(s.frames.data(), max_frames), 0);
+    s.depth = static_cast<uint8_t>(depth);
+    s.first = static_cast<uint8_t>(std::min(handler_frames, depth));
+    const auto pc = interrupted_pc(ctx);
+    for (int i = 0; i < depth; ++i) {
+        if (reinterpret_cast<uintptr_t>(s.frames[i]) == pc) {
+            s.first = static_cast<uint8_t>(i);
+            break;
+        }
+    }
+    s.scheduling_group = ss::internal::scheduling_group_index(
+      ss::current_scheduling_group());
+    ++_samples;
+}
+
+cpu_profiler::folded_stacks cpu_profiler::collect() const {
+    folded_stacks ret;
+    _collecting = 1;
+    const auto& exe = executable_range();
+    const size_t count = std::min<size_t>(_samples, _ring.size());
+    std::string line;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& s = _ring[i];
+        if (s.depth <= s.first) {
+            continue;
+        }
+        line = ss::internal::scheduling_group_from_index(s.scheduling_group)
+                 .name();
+        // outermost frame first
+        for (int f = s.depth - 1; f >= s.first; --f) {
+            auto addr = reinterpret_cast<uintptr_t>(s.frames[f]);
+            if (addr >= exe.begin && addr < exe.end) {
+                addr -= exe.begin;
+            }
+            line += fmt::format(";{:#x}", addr);
+        }
+        ++ret[ss::sstring(line.data(), line.size())];
+    }
+    _collecting = 0;
+    return ret;
+}
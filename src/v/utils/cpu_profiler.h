@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/sstring.hh>
+
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <ctime>
+#include <unordered_map>
+#include <vector>
+
+#include <ucontext.h>
+
+/**
+ * Sampling cpu profiler of a shard, meant to stay on in production.
+ *
+ * A timer on the cpu time of the shard thread delivers SIGPROF every
+ * sample period. The signal handler captures the stack and the scheduling
+ * group the shard was running and stores them into a fixed size ring that
+ * overwrites the oldest samples, so memory is bounded and nothing is
+ * allocated in the handler.
+ *
+ * Stacks are reported in the folded format consumed by flamegraph.pl, i.e.
+ * one `<scheduling group>;<outermost frame>;...;<innermost frame> <count>`
+ * line per distinct stack. Frames of the executable are offsets from its
+ * load address, ready for addr2line, frames of shared objects are absolute
+ * addresses.
+ */
+class cpu_profiler {
+public:
+    using folded_stacks = std::unordered_map<ss::sstring, uint64_t>;
+
+    static constexpr size_t max_frames = 32;
+    static constexpr size_t default_ring_size = 4096;
+
+    cpu_profiler(
+      bool enabled,
+      std::chrono::milliseconds sample_period,
+      size_t ring_size = default_ring_size);
+    ~cpu_profiler() noexcept;
+    cpu_profiler(const cpu_profiler&) = delete;
+    cpu_profiler& operator=(const cpu_profiler&) = delete;
+    cpu_profiler(cpu_profiler&&) = delete;
+    cpu_profiler& operator=(cpu_profiler&&) = delete;
+
+    ss::future<> stop();
+
+    bool enabled() const { return _timer_armed; }
+
+    /// folds the samples in the ring. samples taken while folding are
+    /// dropped
+    folded_stacks collect() const;
+
+    uint64_t samples() const { return _samples; }
+    uint64_t dropped_samples() const { return _dropped; }
+
+private:
+    struct sample {
+        std::array<void*, max_frames> frames;
+        uint8_t depth{0};
+        // first frame of the interrupted code, frames before belong to
+        // the signal handler
+        uint8_t first{0};
+        uint8_t scheduling_group{0};
+    };
+
+    static void on_signal(int, siginfo_t*, void*);
+    void take_sample(const ucontext_t*) noexcept;
+
+    std::vector<sample> _ring;
+    timer_t _timer{};
+    bool _timer_armed{false};
+    uint64_t _samples{0};
+    uint64_t _dropped{0};
+    // set while the ring is read, makes the handler drop its sample
+    mutable volatile std::sig_atomic_t _collecting{0};
+};
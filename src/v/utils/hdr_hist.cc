@@ -11,10 +11,107 @@
 
 #include "likely.h"
 #include "utils/human.h"
+#include "utils/vint.h"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <utility>
+#include <vector>
+
+void hdr_hist_counts::append(int64_t value, int64_t count) {
+    std::array<uint8_t, 2 * vint::max_length> buf;
+    auto n = vint::serialize(value - _last_value, buf.data());
+    n += vint::serialize(count, buf.data() + n);
+    _buckets.append(buf.data(), n);
+    _last_value = value;
+}
+
+template<typename Func>
+void hdr_hist_counts::for_each_bucket(Func&& f) const {
+    bytes_view in(_buckets);
+    int64_t value = 0;
+    while (!in.empty()) {
+        auto [delta, delta_len] = vint::deserialize(in);
+        in.remove_prefix(delta_len);
+        auto [count, count_len] = vint::deserialize(in);
+        in.remove_prefix(count_len);
+        value += delta;
+        f(value, count);
+    }
+}
+
+int64_t hdr_hist_counts::get_value_at(double percentile) const {
+    int64_t total = 0;
+    for_each_bucket([&total](int64_t, int64_t count) { total += count; });
+    if (total == 0) {
+        return 0;
+    }
+    // same rounding as hdr_value_at_percentile
+    const auto p = std::min(percentile, 100.0);
+    const auto target = std::max<int64_t>(
+      1, static_cast<int64_t>((p / 100.0) * total + 0.5));
+    int64_t seen = 0;
+    int64_t found = 0;
+    for_each_bucket([&](int64_t value, int64_t count) {
+        if (seen < target) {
+            seen += count;
+            found = value;
+        }
+    });
+    return found;
+}
+
+hdr_hist_counts hdr_hist_counts::since(const hdr_hist_counts& earlier) const {
+    std::vector<std::pair<int64_t, int64_t>> before;
+    earlier.for_each_bucket([&before](int64_t value, int64_t count) {
+        before.emplace_back(value, count);
+    });
+    hdr_hist_counts ret;
+    ret._sample_count = _sample_count - earlier._sample_count;
+    ret._sample_sum = _sample_sum - earlier._sample_sum;
+    auto it = before.cbegin();
+    for_each_bucket([&](int64_t value, int64_t count) {
+        while (it != before.cend() && it->first < value) {
+            ++it;
+        }
+        if (it != before.cend() && it->first == value) {
+            count -= it->second;
+        }
+        if (count > 0) {
+            ret.append(value, count);
+        }
+    });
+    return ret;
+}
+
+hdr_hist_counts& hdr_hist_counts::operator+=(const hdr_hist_counts& o) {
+    std::vector<std::pair<int64_t, int64_t>> mine;
+    for_each_bucket([&mine](int64_t value, int64_t count) {
+        mine.emplace_back(value, count);
+    });
+    hdr_hist_counts merged;
+    merged._sample_count = _sample_count + o._sample_count;
+    merged._sample_sum = _sample_sum + o._sample_sum;
+    auto it = mine.cbegin();
+    o.for_each_bucket([&](int64_t value, int64_t count) {
+        for (; it != mine.cend() && it->first < value; ++it) {
+            merged.append(it->first, it->second);
+        }
+        if (it != mine.cend() && it->first == value) {
+            count += it->second;
+            ++it;
+        }
+        merged.append(value, count);
+    });
+    for (; it != mine.cend(); ++it) {
+        merged.append(it->first, it->second);
+    }
+    *this = std::move(merged);
+    return *this;
+}
 
 void hdr_hist::record(uint64_t value) {
     _sample_count++;
@@ -36,9 +133,33 @@ void hdr_hist::record_corrected(uint64_t value, uint64_t interval) {
 
 hdr_hist& hdr_hist::operator+=(const hdr_hist& o) {
     ::hdr_add(_hist.get(), o._hist.get());
+    _sample_count += o._sample_count;
+    _sample_sum += o._sample_sum;
+    return *this;
+}
+
+hdr_hist& hdr_hist::operator+=(const hdr_hist_counts& o) {
+    o.for_each_bucket([this](int64_t value, int64_t count) {
+        ::hdr_record_values(_hist.get(), value, count);
+    });
+    _sample_count += o.sample_count();
+    _sample_sum += o.sample_sum();
     return *this;
 }
 
+hdr_hist_counts hdr_hist::counts() const {
+    hdr_hist_counts ret;
+    ret._sample_count = _sample_count;
+    ret._sample_sum = _sample_sum;
+    // stack allocated; no cleanup needed
+    struct hdr_iter iter;
+    hdr_iter_recorded_init(&iter, _hist.get());
+    while (hdr_iter_next(&iter)) {
+        ret.append(iter.highest_equivalent_value, iter.count);
+    }
+    return ret;
+}
+
 ss::temporary_buffer<char> hdr_hist::print_classic() const {
     char* buf = nullptr;
     std::size_t len = 0;
@@ -17,6 +17,7 @@
 
 // vectorized types. needed comment to allow clang-format
 // header sorting to not resort cstdint
+#include "bytes/bytes.h"
 #include "seastarx.h"
 #include "static_deleter_fn.h"
 
@@ -42,6 +43,50 @@ inline hdr_histogram_ptr make_unique_hdr_histogram(
 }
 } // namespace hist_internal
 
+class hdr_hist;
+
+/**
+ * The counts of the buckets of a histogram holding values.
+ *
+ * A histogram keeps a counter for every bucket of its range, at the default
+ * granularity about 185KB, most of them zero. The counts keep the buckets
+ * holding values only, in ascending order, each as a vint of the distance of
+ * its value to the one of the previous bucket and a vint of its count. A
+ * latency histogram encodes into a few hundred bytes, which are cheap to take
+ * across shards and to subtract from a later take of the same histogram.
+ */
+class hdr_hist_counts {
+public:
+    uint64_t sample_count() const { return _sample_count; }
+    uint64_t sample_sum() const { return _sample_sum; }
+    bool empty() const { return _buckets.empty(); }
+    size_t encoded_size() const { return _buckets.size(); }
+
+    /// \brief highest value of the bucket below which `percentile` of the
+    /// counted values fall, like hdr_hist::get_value_at
+    int64_t get_value_at(double percentile) const;
+
+    /// \brief the counts added after `earlier`, which must have been taken
+    /// from the same histogram
+    hdr_hist_counts since(const hdr_hist_counts& earlier) const;
+
+    hdr_hist_counts& operator+=(const hdr_hist_counts&);
+
+private:
+    friend hdr_hist;
+
+    /// \brief appends a bucket, in ascending order of value
+    void append(int64_t value, int64_t count);
+
+    template<typename Func>
+    void for_each_bucket(Func&& f) const;
+
+    bytes _buckets;
+    int64_t _last_value{0};
+    uint64_t _sample_count{0};
+    uint64_t _sample_sum{0};
+};
+
 // VERY Expensive object. At default granularity is about 185KB
 class hdr_hist {
 public:
@@ -127,6 +172,9 @@ public:
     ~hdr_hist() noexcept;
 
     hdr_hist& operator+=(const hdr_hist& o);
+    hdr_hist& operator+=(const hdr_hist_counts& o);
+    /// \brief the non-empty buckets, see hdr_hist_counts
+    hdr_hist_counts counts() const;
     ss::temporary_buffer<char> print_classic() const;
     void record(uint64_t value);
     void record_multiple_times(uint64_t value, uint32_t times);
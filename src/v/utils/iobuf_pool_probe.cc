@@ -0,0 +1,82 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/iobuf_pool_probe.h"
+
+#include "bytes/details/io_fragment_pool.h"
+#include "prometheus/prometheus_sanitize.h"
+
+#include <seastar/core/metrics.hh>
+
+static const details::io_fragment_pool::stats& pool_stats() {
+    return details::io_fragment_pool::local().get_stats();
+}
+
+void iobuf_pool_probe::setup_metrics() {
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("iobuf"),
+      {
+        sm::make_gauge(
+          "fragments",
+          [] { return pool_stats().fragments; },
+          sm::description("Number of live iobuf fragments")),
+        sm::make_derive(
+          "fragment_allocations",
+          [] { return pool_stats().fragment_allocations; },
+          sm::description("Fragment objects allocated from the heap")),
+        sm::make_derive(
+          "fragment_reuses",
+          [] { return pool_stats().fragment_reuses; },
+          sm::description("Fragment objects reused from the free list")),
+        sm::make_derive(
+          "block_allocations",
+          [] { return pool_stats().block_allocations; },
+          sm::description("Fragments co-allocated with their buffer from "
+                          "the heap")),
+        sm::make_derive(
+          "block_reuses",
+          [] { return pool_stats().block_reuses; },
+          sm::description("Fragments co-allocated with their buffer reused "
+                          "from the free lists")),
+        sm::make_gauge(
+          "cached_bytes",
+          [] { return pool_stats().cached_bytes; },
+          sm::description("Bytes of fragment memory in the free lists")),
+        sm::make_gauge(
+          "reuse_ratio",
+          [] {
+              const auto& s = pool_stats();
+              const auto reuses = s.fragment_reuses + s.block_reuses;
+              const auto total = reuses + s.fragment_allocations
+                                 + s.block_allocations;
+              return total ? double(reuses) / double(total) : 0.0;
+          },
+          sm::description("Share of the fragment allocations served from "
+                          "the free lists")),
+        sm::make_gauge(
+          "fragmentation_ratio",
+          [] {
+              const auto& s = pool_stats();
+              if (s.released_capacity_bytes == 0) {
+                  return 0.0;
+              }
+              return 1.0
+                     - double(s.released_used_bytes)
+                         / double(s.released_capacity_bytes);
+          },
+          sm::description("Share of the capacity of the released fragments "
+                          "which was never used")),
+      });
+}
+
+ss::future<> iobuf_pool_probe::stop() {
+    _metrics.clear();
+    return ss::now();
+}
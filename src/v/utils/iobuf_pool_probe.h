@@ -0,0 +1,29 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/metrics_registration.hh>
+
+/**
+ * Exports the statistics of the iobuf fragment pool of the shard, see
+ * details::io_fragment_pool.
+ */
+class iobuf_pool_probe {
+public:
+    void setup_metrics();
+    ss::future<> stop();
+
+private:
+    ss::metrics::metric_groups _metrics;
+};
@@ -0,0 +1,126 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/scheduling_group_probe.h"
+
+#include "prometheus/prometheus_sanitize.h"
+#include "vassert.h"
+
+#include <seastar/core/metrics.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/with_scheduling_group.hh>
+
+#include <algorithm>
+
+// ten seconds at two significant figures
+static constexpr int64_t max_delay_us = 10'000'000;
+static constexpr int32_t significant_figures = 2;
+
+scheduling_group_probe::group_probe::group_probe(ss::scheduling_group sg)
+  : sg(sg)
+  , run_queue_delay(max_delay_us, 1, significant_figures) {}
+
+scheduling_group_probe::scheduling_group_probe(
+  std::vector<ss::scheduling_group> groups,
+  std::chrono::milliseconds probe_interval,
+  bool disable_metrics)
+  : _probe_interval(probe_interval)
+  , _disable_metrics(disable_metrics)
+  , _timer([this] { probe_groups(); }) {
+    _groups.reserve(groups.size());
+    for (auto sg : groups) {
+        _groups.emplace_back(sg);
+    }
+}
+
+void scheduling_group_probe::start() {
+    // the report function is called from the signal handler of the stall
+    // detector, on the stalled shard
+    _previous_stall_report = ss::engine().get_stall_detector_report_function();
+    ss::engine().set_stall_detector_report_function(
+      [this] { on_stall(); });
+    setup_metrics();
+    _timer.arm_periodic(_probe_interval);
+}
+
+ss::future<> scheduling_group_probe::stop() {
+    if (_timer.armed()) {
+        _timer.cancel();
+        ss::engine().set_stall_detector_report_function(
+          std::move(_previous_stall_report));
+    }
+    _metrics.clear();
+    return _gate.close();
+}
+
+const hdr_hist&
+scheduling_group_probe::run_queue_delay(ss::scheduling_group sg) const {
+    auto it = std::find_if(
+      _groups.begin(), _groups.end(), [sg](const group_probe& g) {
+          return g.sg == sg;
+      });
+    vassert(it != _groups.end(), "group {} is not probed", sg.name());
+    return it->run_queue_delay;
+}
+
+void scheduling_group_probe::on_stall() noexcept {
+    ++_stalls[ss::internal::scheduling_group_index(
+      ss::current_scheduling_group())];
+    if (_previous_stall_report) {
+        _previous_stall_report();
+    }
+}
+
+void scheduling_group_probe::probe_groups() {
+    if (_gate.is_closed()) {
+        return;
+    }
+    for (auto& g : _groups) {
+        if (g.in_flight) {
+            continue;
+        }
+        g.in_flight = true;
+        (void)ss::with_gate(
+          _gate, [&g, queued = clock_type::now()]() mutable {
+              return ss::with_scheduling_group(g.sg, [&g, queued] {
+                  g.run_queue_delay.record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                      clock_type::now() - queued)
+                      .count());
+                  g.in_flight = false;
+              });
+          });
+    }
+}
+
+void scheduling_group_probe::setup_metrics() {
+    if (_disable_metrics) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    auto group_label = sm::label("group");
+    std::vector<sm::metric_definition> defs;
+    defs.reserve(_groups.size() * 2);
+    for (auto& g : _groups) {
+        std::vector<sm::label_instance> labels{group_label(g.sg.name())};
+        defs.push_back(sm::make_histogram(
+          "run_queue_delay_us",
+          [&g] { return g.run_queue_delay.seastar_histogram_logform(); },
+          sm::description("Time tasks of the scheduling group wait to run"),
+          labels));
+        defs.push_back(sm::make_derive(
+          "stalls",
+          [this, sg = g.sg] { return stalls(sg); },
+          sm::description("Reactor stalls while the scheduling group was "
+                          "running"),
+          labels));
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("scheduling_group"), std::move(defs));
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/timer.hh>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Attributes the time tasks wait to run, and the reactor stalls, to the
+ * scheduling groups of a shard.
+ *
+ * Every probe interval a no-op task is queued into each of the groups, the
+ * time between queueing and running it is the run queue delay of the group,
+ * recorded into a histogram. A group whose delay grows while others stay
+ * flat is being starved by the groups with more shares or longer tasks.
+ *
+ * Stalls are counted by chaining into the stall detector report of the
+ * reactor, the group running when the detector fires is the one that
+ * overran the task quota.
+ */
+class scheduling_group_probe {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    scheduling_group_probe(
+      std::vector<ss::scheduling_group> groups,
+      std::chrono::milliseconds probe_interval,
+      bool disable_metrics);
+    scheduling_group_probe(const scheduling_group_probe&) = delete;
+    scheduling_group_probe& operator=(const scheduling_group_probe&) = delete;
+    scheduling_group_probe(scheduling_group_probe&&) = delete;
+    scheduling_group_probe& operator=(scheduling_group_probe&&) = delete;
+    ~scheduling_group_probe() noexcept = default;
+
+    void start();
+    ss::future<> stop();
+
+    /// run queue delay histogram of a group passed to the constructor
+    const hdr_hist& run_queue_delay(ss::scheduling_group) const;
+
+    uint64_t stalls(ss::scheduling_group sg) const {
+        return _stalls[ss::internal::scheduling_group_index(sg)];
+    }
+
+private:
+    struct group_probe {
+        explicit group_probe(ss::scheduling_group);
+
+        ss::scheduling_group sg;
+        hdr_hist run_queue_delay;
+        // a single probe task per group, a delayed group is not flooded
+        bool in_flight{false};
+    };
+
+    void probe_groups();
+    void on_stall() noexcept;
+    void setup_metrics();
+
+    std::vector<group_probe> _groups;
+    std::chrono::milliseconds _probe_interval;
+    bool _disable_metrics;
+    std::array<uint64_t, ss::max_scheduling_groups()> _stalls{};
+    std::function<void()> _previous_stall_report;
+    ss::timer<clock_type> _timer;
+    ss::gate _gate;
+    ss::metrics::metric_groups _metrics;
+};
@@ -0,0 +1,109 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/smp_group_probe.h"
+
+#include "prometheus/prometheus_sanitize.h"
+#include "vassert.h"
+
+#include <seastar/core/metrics.hh>
+#include <seastar/core/reactor.hh>
+
+#include <algorithm>
+
+// ten seconds at two significant figures
+static constexpr int64_t max_round_trip_us = 10'000'000;
+static constexpr int32_t significant_figures = 2;
+
+smp_group_probe::group_probe::group_probe(
+  ss::sstring name, ss::smp_service_group ssg)
+  : name(std::move(name))
+  , ssg(ssg)
+  , round_trip(max_round_trip_us, 1, significant_figures) {}
+
+smp_group_probe::smp_group_probe(
+  groups_t groups,
+  std::chrono::milliseconds probe_interval,
+  bool disable_metrics)
+  : _probe_interval(probe_interval)
+  , _disable_metrics(disable_metrics)
+  , _timer([this] { probe_groups(); }) {
+    _groups.reserve(groups.size());
+    for (auto& [name, ssg] : groups) {
+        _groups.emplace_back(std::move(name), ssg);
+    }
+}
+
+void smp_group_probe::start() {
+    setup_metrics();
+    if (ss::smp::count > 1) {
+        _timer.arm_periodic(_probe_interval);
+    }
+}
+
+ss::future<> smp_group_probe::stop() {
+    _timer.cancel();
+    _metrics.clear();
+    return _gate.close();
+}
+
+const hdr_hist& smp_group_probe::round_trip(const ss::sstring& name) const {
+    auto it = std::find_if(
+      _groups.begin(), _groups.end(), [&name](const group_probe& g) {
+          return g.name == name;
+      });
+    vassert(it != _groups.end(), "smp group {} is not probed", name);
+    return it->round_trip;
+}
+
+void smp_group_probe::probe_groups() {
+    if (_gate.is_closed()) {
+        return;
+    }
+    const auto target = (ss::this_shard_id() + 1) % ss::smp::count;
+    for (auto& g : _groups) {
+        if (g.in_flight) {
+            continue;
+        }
+        g.in_flight = true;
+        (void)ss::with_gate(
+          _gate, [&g, target, sent = clock_type::now()]() mutable {
+              return ss::smp::submit_to(
+                       target, ss::smp_submit_to_options(g.ssg), [] {})
+                .then_wrapped([&g, sent](ss::future<> f) {
+                    f.ignore_ready_future();
+                    g.round_trip.record(
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                        clock_type::now() - sent)
+                        .count());
+                    g.in_flight = false;
+                });
+          });
+    }
+}
+
+void smp_group_probe::setup_metrics() {
+    if (_disable_metrics) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    auto group_label = sm::label("group");
+    std::vector<sm::metric_definition> defs;
+    defs.reserve(_groups.size());
+    for (auto& g : _groups) {
+        defs.push_back(sm::make_histogram(
+          "round_trip_us",
+          [&g] { return g.round_trip.seastar_histogram_logform(); },
+          sm::description(
+            "Round trip of a cross shard call of the smp service group"),
+          {group_label(g.name)}));
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("smp_group"), std::move(defs));
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+/**
+ * Time the cross shard calls of each smp service group wait to run.
+ *
+ * A group lets a shard have at most max_nonlocal_requests calls in flight
+ * on another shard, a call over the limit waits for one of them to finish.
+ * Every probe interval a no-op call is sent with each of the groups to the
+ * next shard, its round trip is recorded into a histogram. A group whose
+ * round trip grows while the others stay flat is the one saturated.
+ *
+ * On a single shard there is no other shard to call, nothing is recorded.
+ */
+class smp_group_probe {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using groups_t = std::vector<std::pair<ss::sstring, ss::smp_service_group>>;
+
+    smp_group_probe(
+      groups_t groups,
+      std::chrono::milliseconds probe_interval,
+      bool disable_metrics);
+    smp_group_probe(const smp_group_probe&) = delete;
+    smp_group_probe& operator=(const smp_group_probe&) = delete;
+    smp_group_probe(smp_group_probe&&) = delete;
+    smp_group_probe& operator=(smp_group_probe&&) = delete;
+    ~smp_group_probe() noexcept = default;
+
+    void start();
+    ss::future<> stop();
+
+    /// round trip histogram of a group passed to the constructor
+    const hdr_hist& round_trip(const ss::sstring& name) const;
+
+private:
+    struct group_probe {
+        group_probe(ss::sstring, ss::smp_service_group);
+
+        ss::sstring name;
+        ss::smp_service_group ssg;
+        hdr_hist round_trip;
+        // a single probe call per group, a saturated group is not flooded
+        bool in_flight{false};
+    };
+
+    void probe_groups();
+    void setup_metrics();
+
+    std::vector<group_probe> _groups;
+    std::chrono::milliseconds _probe_interval;
+    bool _disable_metrics;
+    ss::timer<clock_type> _timer;
+    ss::gate _gate;
+    ss::metrics::metric_groups _metrics;
+};
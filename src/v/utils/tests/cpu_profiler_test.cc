@@ -0,0 +1,51 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/cpu_profiler.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std::chrono_literals; // NOLINT
+
+static volatile uint64_t sink = 0;
+
+static void spin_for(std::chrono::milliseconds d) {
+    auto end = std::chrono::steady_clock::now() + d;
+    while (std::chrono::steady_clock::now() < end) {
+        sink = sink + 1;
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(samples_busy_shard) {
+    cpu_profiler p(true, 1ms, 128);
+    BOOST_REQUIRE(p.enabled());
+    spin_for(200ms);
+    BOOST_REQUIRE_GT(p.samples(), 0);
+
+    auto stacks = p.collect();
+    BOOST_REQUIRE(!stacks.empty());
+    uint64_t total = 0;
+    for (auto& [stack, count] : stacks) {
+        BOOST_REQUIRE(stack.find(';') != ss::sstring::npos);
+        total += count;
+    }
+    // the ring keeps the latest samples only
+    BOOST_REQUIRE_LE(total, 128);
+    p.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(disabled_profiler_takes_no_samples) {
+    cpu_profiler p(false, 1ms);
+    BOOST_REQUIRE(!p.enabled());
+    spin_for(20ms);
+    BOOST_REQUIRE_EQUAL(p.samples(), 0);
+    BOOST_REQUIRE(p.collect().empty());
+}
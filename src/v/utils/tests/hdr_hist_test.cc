@@ -0,0 +1,69 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/hdr_hist.h"
+#include "utils/windowed_hdr_hist.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(counts_round_trip) {
+    hdr_hist h;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        h.record(v * 10);
+    }
+    auto c = h.counts();
+    BOOST_REQUIRE_EQUAL(c.sample_count(), 1000);
+    BOOST_REQUIRE_LT(c.encoded_size(), h.memory_size());
+
+    hdr_hist copy;
+    copy += c;
+    for (double p : {10.0, 50.0, 99.0, 100.0}) {
+        BOOST_REQUIRE_EQUAL(copy.get_value_at(p), h.get_value_at(p));
+        BOOST_REQUIRE_EQUAL(c.get_value_at(p), h.get_value_at(p));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(counts_merge_and_subtract) {
+    hdr_hist a;
+    hdr_hist b;
+    a.record(100);
+    a.record(300);
+    b.record(200);
+    b.record(300);
+
+    auto merged = a.counts();
+    merged += b.counts();
+    BOOST_REQUIRE_EQUAL(merged.sample_count(), 4);
+    BOOST_REQUIRE_EQUAL(merged.sample_sum(), 900);
+    BOOST_REQUIRE_EQUAL(merged.get_value_at(100.0), a.get_value_at(100.0));
+
+    auto before = a.counts();
+    a.record(5000);
+    auto after = a.counts().since(before);
+    BOOST_REQUIRE_EQUAL(after.sample_count(), 1);
+    BOOST_REQUIRE_EQUAL(after.get_value_at(0.0), a.get_value_at(100.0));
+}
+
+SEASTAR_THREAD_TEST_CASE(window_drops_old_values) {
+    windowed_hdr_hist h(1h, 2);
+    h.record(1'000'000);
+    BOOST_REQUIRE_EQUAL(h.window_counts().sample_count(), 1);
+    h.rotate();
+    h.record(10);
+    BOOST_REQUIRE_EQUAL(h.window_counts().sample_count(), 2);
+    h.rotate();
+    // the first slot left the window
+    BOOST_REQUIRE_EQUAL(h.window_counts().sample_count(), 1);
+    BOOST_REQUIRE_LT(h.window_value_at(100.0), 1'000);
+    BOOST_REQUIRE_GT(h.hist().get_value_at(100.0), 1'000);
+}
@@ -0,0 +1,106 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "resource_mgmt/memory_broker.h"
+
+#include <seastar/core/semaphore.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+using prio = memory_broker::priority;
+
+struct test_pool final : memory_broker::pool {
+    test_pool(prio p, size_t min, size_t max)
+      : memory_broker::pool(
+        "test", p, memory_broker::share{.min_bytes = min, .max_bytes = max}) {}
+
+    size_t used() const final { return in_use; }
+    bool starved() const final { return waiting; }
+    void on_capacity(size_t, size_t) final {}
+
+    size_t in_use{0};
+    bool waiting{false};
+};
+
+SEASTAR_THREAD_TEST_CASE(idle_budget_is_split_by_room) {
+    auto& broker = memory_broker::local();
+    broker.set_budget(100);
+    test_pool rpc(prio::rpc, 10, 40);
+    test_pool cache(prio::cache, 10, 40);
+    BOOST_REQUIRE_EQUAL(rpc.capacity(), 10);
+    broker.rebalance();
+    // 80 left above the minimums, more than both may grow
+    BOOST_REQUIRE_EQUAL(rpc.capacity(), 40);
+    BOOST_REQUIRE_EQUAL(cache.capacity(), 40);
+}
+
+SEASTAR_THREAD_TEST_CASE(starved_pool_borrows_from_lower_priority) {
+    auto& broker = memory_broker::local();
+    broker.set_budget(100);
+    test_pool kafka(prio::kafka, 10, 80);
+    test_pool cache(prio::cache, 10, 90);
+    // the cache filled the budget
+    kafka.in_use = 10;
+    cache.in_use = 90;
+    broker.rebalance();
+    BOOST_REQUIRE_EQUAL(kafka.capacity(), 10);
+    BOOST_REQUIRE_EQUAL(cache.capacity(), 90);
+
+    kafka.waiting = true;
+    broker.rebalance();
+    // grows by half of its capacity, taken from the cache
+    BOOST_REQUIRE_EQUAL(kafka.capacity(), 15);
+    BOOST_REQUIRE_EQUAL(cache.capacity(), 85);
+    BOOST_REQUIRE_EQUAL(cache.throttles(), 1);
+
+    // the cache gives back at most down to its minimum
+    kafka.in_use = 80;
+    broker.rebalance();
+    BOOST_REQUIRE_EQUAL(kafka.capacity(), 80);
+    BOOST_REQUIRE_EQUAL(cache.capacity(), 20);
+}
+
+SEASTAR_THREAD_TEST_CASE(lowest_priority_is_throttled_first) {
+    auto& broker = memory_broker::local();
+    broker.set_budget(100);
+    test_pool rpc(prio::rpc, 10, 80);
+    test_pool appenders(prio::appenders, 10, 80);
+    test_pool cache(prio::cache, 10, 80);
+    rpc.in_use = 50;
+    appenders.in_use = 40;
+    cache.in_use = 40;
+    broker.rebalance();
+    BOOST_REQUIRE_EQUAL(rpc.capacity(), 50);
+    BOOST_REQUIRE_EQUAL(cache.capacity(), 10);
+    BOOST_REQUIRE_EQUAL(appenders.capacity(), 40);
+}
+
+SEASTAR_THREAD_TEST_CASE(semaphore_pool_follows_capacity) {
+    auto& broker = memory_broker::local();
+    broker.set_budget(100);
+    ss::semaphore sem(10);
+    memory_broker::semaphore_pool pool(
+      "sem", prio::rpc, memory_broker::share{10, 60}, sem);
+    auto units = ss::consume_units(sem, 10);
+    BOOST_REQUIRE_EQUAL(pool.used(), 10);
+    broker.rebalance();
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 60);
+    BOOST_REQUIRE_EQUAL(sem.current(), 50);
+    BOOST_REQUIRE_EQUAL(pool.used(), 10);
+
+    // over budget the semaphore is left in debt until units are returned
+    auto more = ss::consume_units(sem, 40);
+    broker.set_budget(5);
+    broker.rebalance();
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 10);
+    BOOST_REQUIRE_EQUAL(sem.current(), 0);
+    more.return_all();
+    BOOST_REQUIRE_EQUAL(sem.current(), 0);
+    units.return_all();
+    BOOST_REQUIRE_EQUAL(sem.current(), 10);
+}
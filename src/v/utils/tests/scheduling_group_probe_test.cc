@@ -0,0 +1,48 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/scheduling_group_probe.h"
+
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(probes_every_group) {
+    auto sg = ss::create_scheduling_group("probed", 100).get0();
+    std::vector<ss::scheduling_group> groups{
+      ss::default_scheduling_group(), sg};
+    {
+        scheduling_group_probe probe(groups, 1ms, true);
+        probe.start();
+        ss::sleep(50ms).get();
+        probe.stop().get();
+
+        for (auto g : groups) {
+            auto h = probe.run_queue_delay(g).seastar_histogram_logform();
+            BOOST_REQUIRE_GT(h.sample_count, 0);
+            BOOST_REQUIRE_EQUAL(probe.stalls(g), 0);
+        }
+    }
+    ss::destroy_scheduling_group(sg).get();
+}
+
+SEASTAR_THREAD_TEST_CASE(stopped_probe_records_nothing) {
+    std::vector<ss::scheduling_group> groups{ss::default_scheduling_group()};
+    scheduling_group_probe probe(groups, 1ms, true);
+    probe.start();
+    probe.stop().get();
+    auto& h = probe.run_queue_delay(ss::default_scheduling_group());
+    auto before = h.seastar_histogram_logform().sample_count;
+    ss::sleep(10ms).get();
+    BOOST_REQUIRE_EQUAL(h.seastar_histogram_logform().sample_count, before);
+}
@@ -0,0 +1,42 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/smp_group_probe.h"
+
+#include <seastar/core/sleep.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(probes_every_group) {
+    ss::smp_service_group_config cfg;
+    cfg.max_nonlocal_requests = 10;
+    auto a = ss::create_smp_service_group(cfg).get0();
+    auto b = ss::create_smp_service_group(cfg).get0();
+    {
+        smp_group_probe probe({{"a", a}, {"b", b}}, 1ms, true);
+        probe.start();
+        ss::sleep(50ms).get();
+        probe.stop().get();
+
+        for (auto name : {"a", "b"}) {
+            auto h = probe.round_trip(name).seastar_histogram_logform();
+            if (ss::smp::count > 1) {
+                BOOST_REQUIRE_GT(h.sample_count, 0);
+            } else {
+                BOOST_REQUIRE_EQUAL(h.sample_count, 0);
+            }
+        }
+    }
+    ss::destroy_smp_service_group(b).get();
+    ss::destroy_smp_service_group(a).get();
+}
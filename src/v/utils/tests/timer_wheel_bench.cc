@@ -0,0 +1,77 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/timer_wheel.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <array>
+#include <deque>
+#include <random>
+
+using namespace std::chrono_literals; // NOLINT
+
+// session timeouts of a million group members, every run delivers a
+// heartbeat to heartbeats_per_run random members, rearming their timeout
+static constexpr size_t members = 1'000'000;
+static constexpr size_t heartbeats_per_run = 1000;
+static constexpr auto session_timeout = 10s;
+
+template<typename Timer>
+struct members_fixture {
+    template<typename... Args>
+    explicit members_fixture(Args&... args) {
+        for (size_t i = 0; i < members; ++i) {
+            auto& t = timers.emplace_back(args...);
+            t.set_callback([] {});
+            t.arm(deadline(i));
+        }
+        std::uniform_int_distribution<size_t> dist(0, members - 1);
+        for (auto& i : order) {
+            i = dist(rng);
+        }
+    }
+
+    // spread the deadlines like heartbeats arriving at random times
+    static ss::lowres_clock::time_point deadline(size_t i) {
+        return ss::lowres_clock::now() + session_timeout
+               + std::chrono::milliseconds(i % 3000);
+    }
+
+    void heartbeat() {
+        perf_tests::start_measuring_time();
+        for (size_t i = 0; i < heartbeats_per_run; ++i) {
+            const auto m = order[(next + i) % order.size()];
+            timers[m].arm(deadline(m + next));
+        }
+        perf_tests::stop_measuring_time();
+        next += heartbeats_per_run;
+    }
+
+    std::mt19937 rng{1};
+    std::array<size_t, 1 << 16> order;
+    size_t next{0};
+    std::deque<Timer> timers;
+};
+
+struct reactor_timers : members_fixture<ss::timer<ss::lowres_clock>> {};
+
+struct wheel_timers {
+    wheel_timers()
+      : fixture(wheel) {}
+
+    timer_wheel<ss::lowres_clock> wheel;
+    members_fixture<timer_wheel<ss::lowres_clock>::timer> fixture;
+};
+
+PERF_TEST_F(reactor_timers, heartbeat) { heartbeat(); }
+
+PERF_TEST_F(wheel_timers, heartbeat) { fixture.heartbeat(); }
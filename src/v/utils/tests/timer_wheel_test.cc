@@ -0,0 +1,132 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/timer_wheel.h"
+
+#include <seastar/core/manual_clock.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <deque>
+#include <random>
+
+using namespace std::chrono_literals; // NOLINT
+
+using wheel_t = timer_wheel<ss::manual_clock>;
+
+static void advance(wheel_t& w, ss::manual_clock::duration d) {
+    ss::manual_clock::advance(d);
+    w.advance(ss::manual_clock::now());
+}
+
+SEASTAR_THREAD_TEST_CASE(fires_after_deadline) {
+    wheel_t w(10ms);
+    wheel_t::timer t(w);
+    size_t fired = 0;
+    t.set_callback([&fired] { ++fired; });
+    t.arm(25ms);
+    BOOST_REQUIRE(t.armed());
+    BOOST_REQUIRE_EQUAL(w.armed(), 1);
+
+    advance(w, 20ms);
+    BOOST_REQUIRE_EQUAL(fired, 0);
+    advance(w, 10ms);
+    BOOST_REQUIRE_EQUAL(fired, 1);
+    BOOST_REQUIRE(!t.armed());
+    BOOST_REQUIRE_EQUAL(w.armed(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(rearm_and_cancel) {
+    wheel_t w(10ms);
+    wheel_t::timer t(w);
+    size_t fired = 0;
+    t.set_callback([&fired] { ++fired; });
+
+    t.arm(50ms);
+    advance(w, 40ms);
+    // rearming pushes the deadline back
+    t.arm(50ms);
+    advance(w, 40ms);
+    BOOST_REQUIRE_EQUAL(fired, 0);
+    BOOST_REQUIRE(t.cancel());
+    BOOST_REQUIRE(!t.cancel());
+    advance(w, 100ms);
+    BOOST_REQUIRE_EQUAL(fired, 0);
+    BOOST_REQUIRE_EQUAL(w.armed(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(callback_rearms_itself) {
+    wheel_t w(1ms);
+    wheel_t::timer t(w);
+    size_t fired = 0;
+    t.set_callback([&] {
+        if (++fired < 3) {
+            t.arm(5ms);
+        }
+    });
+    t.arm(5ms);
+    for (int i = 0; i < 20; ++i) {
+        advance(w, 1ms);
+    }
+    BOOST_REQUIRE_EQUAL(fired, 3);
+}
+
+SEASTAR_THREAD_TEST_CASE(deadlines_across_levels) {
+    wheel_t w(1ms);
+    std::deque<wheel_t::timer> timers;
+    std::vector<ss::manual_clock::time_point> deadlines;
+    std::vector<ss::manual_clock::time_point> fired_at;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(0, 1 << 20);
+
+    // the wheel is driven directly, advancing the manual clock a million
+    // times would queue a million timer expirations
+    auto now = ss::manual_clock::now();
+    const auto n = 10000;
+    deadlines.reserve(n);
+    fired_at.resize(n);
+    for (int i = 0; i < n; ++i) {
+        auto& t = timers.emplace_back(w);
+        t.set_callback([&fired_at, &now, i] { fired_at[i] = now; });
+        deadlines.push_back(now + std::chrono::milliseconds(dist(rng)));
+        t.arm(deadlines.back());
+    }
+    // one deadline beyond the span of the wheel
+    auto& far = timers.emplace_back(w);
+    bool far_fired = false;
+    far.set_callback([&far_fired] { far_fired = true; });
+    far.arm(now + std::chrono::milliseconds(wheel_t::max_ticks + 100));
+
+    while (w.armed() > 1) {
+        now += 1ms;
+        w.advance(now);
+    }
+    for (int i = 0; i < n; ++i) {
+        BOOST_REQUIRE(fired_at[i] >= deadlines[i]);
+        BOOST_REQUIRE(fired_at[i] < deadlines[i] + 1ms);
+    }
+
+    w.advance(far.get_timeout() - 1ms);
+    BOOST_REQUIRE(!far_fired);
+    w.advance(far.get_timeout());
+    BOOST_REQUIRE(far_fired);
+}
+
+SEASTAR_THREAD_TEST_CASE(destroyed_timers_are_unlinked) {
+    wheel_t w(10ms);
+    {
+        wheel_t::timer t(w);
+        t.set_callback([] { BOOST_FAIL("destroyed timer fired"); });
+        t.arm(10ms);
+        BOOST_REQUIRE_EQUAL(w.armed(), 1);
+    }
+    BOOST_REQUIRE_EQUAL(w.armed(), 0);
+    advance(w, 100ms);
+}
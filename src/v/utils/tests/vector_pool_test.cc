@@ -0,0 +1,41 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE utils
+#include "utils/vector_pool.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(vector_pool_reuses_storage) {
+    using pool = vector_pool<int, 2, 16>;
+    auto v = pool::get();
+    BOOST_REQUIRE_EQUAL(v.capacity(), 0);
+    v.assign({1, 2, 3});
+    const auto* data = v.data();
+    pool::put(std::move(v));
+
+    auto reused = pool::get();
+    BOOST_REQUIRE(reused.empty());
+    BOOST_REQUIRE_EQUAL(reused.data(), data);
+    BOOST_REQUIRE_GE(reused.capacity(), 3);
+    BOOST_REQUIRE_EQUAL(pool::get().capacity(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(vector_pool_bounds) {
+    using pool = vector_pool<long, 1, 4>;
+    // too large to be kept
+    pool::put(std::vector<long>(8));
+    BOOST_REQUIRE_EQUAL(pool::get().capacity(), 0);
+
+    // one vector at most
+    pool::put(std::vector<long>(2));
+    pool::put(std::vector<long>(3));
+    BOOST_REQUIRE_EQUAL(pool::get().capacity(), 2);
+    BOOST_REQUIRE_EQUAL(pool::get().capacity(), 0);
+}
@@ -0,0 +1,57 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/bytes.h"
+#include "utils/vint.h"
+#include "utils/vint_bulk.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <random>
+#include <vector>
+
+// the varints of small records, mostly one or two bytes long with the odd
+// timestamp delta of several bytes
+struct vint_bench {
+    static constexpr size_t count = 4096;
+
+    vint_bench() {
+        std::mt19937_64 rng(1);
+        for (size_t i = 0; i < count; ++i) {
+            const int64_t v = i % 5 == 0 ? int64_t(rng() % 10'000'000)
+                                         : int64_t(rng() % 1000);
+            encoded += vint::to_bytes(v);
+        }
+        out.resize(count);
+    }
+
+    bytes encoded;
+    std::vector<int64_t> out;
+};
+
+PERF_TEST_F(vint_bench, deserialize) {
+    perf_tests::start_measuring_time();
+    size_t pos = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const auto [v, n] = vint::deserialize(
+          bytes_view(encoded.data() + pos, encoded.size() - pos));
+        out[i] = v;
+        pos += n;
+    }
+    perf_tests::do_not_optimize(out);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(vint_bench, deserialize_n) {
+    perf_tests::start_measuring_time();
+    perf_tests::do_not_optimize(vint::deserialize_n(
+      encoded.data(), encoded.size(), out.data(), out.size()));
+    perf_tests::do_not_optimize(out);
+    perf_tests::stop_measuring_time();
+}
@@ -9,6 +9,7 @@
 
 #include "bytes/bytes.h"
 #include "utils/vint.h"
+#include "utils/vint_bulk.h"
 
 #include <seastar/testing/thread_test_case.hh>
 
@@ -17,7 +18,9 @@
 #include <array>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <vector>
 
 namespace {
 
@@ -36,3 +39,57 @@ void check_roundtrip_sweep(int64_t count) {
 SEASTAR_THREAD_TEST_CASE(sanity_signed_sweep_64) {
     check_roundtrip_sweep(100000000);
 }
+
+SEASTAR_THREAD_TEST_CASE(bulk_decoding_matches_deserialize) {
+    std::mt19937_64 rng(1);
+    std::vector<int64_t> values;
+    bytes buf;
+    for (size_t i = 0; i < 1000; ++i) {
+        // every encoded length from 1 to max_length bytes
+        const auto bits = rng() % 64;
+        auto v = static_cast<int64_t>(rng() >> (63 - bits));
+        if (rng() % 2) {
+            v = -v;
+        }
+        values.push_back(v);
+        buf += vint::to_bytes(v);
+    }
+    values.push_back(std::numeric_limits<int64_t>::min());
+    buf += vint::to_bytes(values.back());
+    values.push_back(std::numeric_limits<int64_t>::max());
+    buf += vint::to_bytes(values.back());
+
+    std::vector<int64_t> out(values.size());
+    BOOST_REQUIRE_EQUAL(
+      vint::deserialize_n(buf.data(), buf.size(), out.data(), out.size()),
+      buf.size());
+    BOOST_REQUIRE(out == values);
+
+    // runs starting anywhere in the buffer
+    size_t pos = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        int64_t v = 0;
+        const auto n = vint::deserialize_n(
+          buf.data() + pos, buf.size() - pos, &v, 1);
+        BOOST_REQUIRE_EQUAL(n, vint::vint_size(values[i]));
+        BOOST_REQUIRE_EQUAL(v, values[i]);
+        pos += n;
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(bulk_decoding_rejects_truncated_varints) {
+    std::vector<int64_t> values(20, std::numeric_limits<int64_t>::max());
+    bytes buf;
+    for (auto v : values) {
+        buf += vint::to_bytes(v);
+    }
+    std::vector<int64_t> out(values.size());
+    BOOST_REQUIRE_EQUAL(
+      vint::deserialize_n(buf.data(), buf.size() - 1, out.data(), out.size()),
+      0);
+    // more than max_length bytes
+    bytes longest(bytes::initialized_later{}, 32);
+    std::fill(longest.begin(), longest.end(), 0x80);
+    BOOST_REQUIRE_EQUAL(
+      vint::deserialize_n(longest.data(), longest.size(), out.data(), 1), 0);
+}
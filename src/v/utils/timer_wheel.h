@@ -0,0 +1,217 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "utils/intrusive_list_helpers.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Hierarchical timer wheel for large numbers of coarse grained timers.
+ *
+ * Every seastar timer is kept in the reactor's timer set, so arming one costs
+ * a lookup in a structure holding all armed timers of the shard. The wheel
+ * hashes timers into slots of `resolution` width instead, arming, rearming
+ * and cancelling a timer are constant time list operations. Timers due after
+ * the span of the first level are kept in coarser levels and are moved down
+ * as the wheel turns. A single seastar timer drives the wheel while it has
+ * armed timers.
+ *
+ * Timers fire on the first tick after their deadline, i.e. they are late by
+ * at most one resolution but never early.
+ */
+template<typename Clock = ss::lowres_clock>
+class timer_wheel {
+public:
+    using clock_type = Clock;
+    using duration = typename Clock::duration;
+    using time_point = typename Clock::time_point;
+
+    static constexpr size_t slot_bits = 6;
+    static constexpr size_t slots = size_t(1) << slot_bits;
+    static constexpr size_t levels = 4;
+    // ticks covered by all the levels, later deadlines wait in the last one
+    static constexpr uint64_t max_ticks = uint64_t(1) << (slot_bits * levels);
+
+    /**
+     * Timer of the wheel, it follows the interface of ss::timer.
+     *
+     * The callback may rearm or destroy the timer it is called from, once
+     * it destroyed the timer it must not touch it.
+     */
+    class timer {
+    public:
+        explicit timer(timer_wheel& w) noexcept
+          : _wheel(&w) {}
+        timer(const timer&) = delete;
+        timer& operator=(const timer&) = delete;
+        timer(timer&&) = delete;
+        timer& operator=(timer&&) = delete;
+        ~timer() { cancel(); }
+
+        void set_callback(ss::noncopyable_function<void()> f) {
+            _callback = std::move(f);
+        }
+
+        void arm(time_point deadline) {
+            cancel();
+            _deadline = deadline;
+            _wheel->insert(*this);
+        }
+        void arm(duration d) { arm(Clock::now() + d); }
+        void rearm(time_point deadline) { arm(deadline); }
+
+        bool cancel() {
+            if (!_hook.is_linked()) {
+                return false;
+            }
+            _hook.unlink();
+            _wheel->disarmed();
+            return true;
+        }
+
+        bool armed() const { return _hook.is_linked(); }
+        time_point get_timeout() const { return _deadline; }
+
+    private:
+        friend class timer_wheel;
+
+        timer_wheel* _wheel;
+        time_point _deadline;
+        uint64_t _tick{0};
+        ss::noncopyable_function<void()> _callback;
+        intrusive_list_hook _hook;
+    };
+
+    explicit timer_wheel(duration resolution = std::chrono::milliseconds(10))
+      : _resolution(resolution)
+      , _origin(Clock::now()) {
+        _ticker.set_callback([this] { advance(Clock::now()); });
+    }
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+    timer_wheel(timer_wheel&&) = delete;
+    timer_wheel& operator=(timer_wheel&&) = delete;
+    ~timer_wheel() = default;
+
+    /// Fires the timers due at or before `now`. Called by the wheel's own
+    /// seastar timer, it is public for tests and manual clocks
+    void advance(time_point now) {
+        const auto target = floor_tick(now);
+        while (_now < target && _armed > 0) {
+            ++_now;
+            cascade();
+            expire(_now & (slots - 1));
+        }
+        if (_armed == 0) {
+            _ticker.cancel();
+        }
+    }
+
+    /// Number of armed timers
+    size_t armed() const { return _armed; }
+
+    duration resolution() const { return _resolution; }
+
+private:
+    using slot_list = intrusive_list<timer, &timer::_hook>;
+
+    uint64_t floor_tick(time_point t) const {
+        if (t <= _origin) {
+            return 0;
+        }
+        return (t - _origin) / _resolution;
+    }
+
+    uint64_t ceil_tick(time_point t) const {
+        if (t <= _origin) {
+            return 0;
+        }
+        return (t - _origin + _resolution - duration(1)) / _resolution;
+    }
+
+    void insert(timer& t) {
+        if (_armed++ == 0) {
+            // nothing is in the wheel, skip the ticks spent idle
+            _now = std::max(_now, floor_tick(Clock::now()));
+            _ticker.arm_periodic(_resolution);
+        }
+        t._tick = std::max(ceil_tick(t._deadline), _now + 1);
+        place(t);
+    }
+
+    void place(timer& t) {
+        const auto delta = t._tick - std::min(t._tick, _now);
+        for (size_t level = 0; level < levels; ++level) {
+            const size_t shift = slot_bits * level;
+            if (delta < (uint64_t(1) << (shift + slot_bits))) {
+                _wheel[level][(t._tick >> shift) & (slots - 1)].push_back(t);
+                return;
+            }
+        }
+        // beyond the span of the wheel, parked in the last slot it reaches
+        // and placed again when that slot is cascaded
+        const size_t shift = slot_bits * (levels - 1);
+        const auto parked = _now + max_ticks - 1;
+        _wheel[levels - 1][(parked >> shift) & (slots - 1)].push_back(t);
+    }
+
+    /// Moves the timers of the upper level slots that start at the current
+    /// tick to the levels below
+    void cascade() {
+        for (size_t level = 1; level < levels; ++level) {
+            const size_t shift = slot_bits * level;
+            if ((_now & ((uint64_t(1) << shift) - 1)) != 0) {
+                return;
+            }
+            slot_list pending;
+            pending.splice(
+              pending.end(), _wheel[level][(_now >> shift) & (slots - 1)]);
+            while (!pending.empty()) {
+                auto& t = pending.front();
+                pending.pop_front();
+                place(t);
+            }
+        }
+    }
+
+    void expire(size_t slot) {
+        slot_list due;
+        due.splice(due.end(), _wheel[0][slot]);
+        while (!due.empty()) {
+            auto& t = due.front();
+            due.pop_front();
+            --_armed;
+            t._callback();
+        }
+    }
+
+    void disarmed() {
+        if (--_armed == 0) {
+            _ticker.cancel();
+        }
+    }
+
+    duration _resolution;
+    time_point _origin;
+    // last tick processed
+    uint64_t _now{0};
+    size_t _armed{0};
+    std::array<std::array<slot_list, slots>, levels> _wheel;
+    ss::timer<Clock> _ticker;
+};
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Per shard free list of vectors of T.
+ *
+ * Short lived structures decoded over and over, like the topics and
+ * partitions of kafka requests, take their vectors from the pool and give
+ * them back when done. The vectors keep their capacity in between so
+ * decoding allocates them only until the pool warmed up. At most
+ * `max_pooled` vectors of up to `max_capacity` elements are kept, larger
+ * ones are released to the allocator.
+ */
+template<typename T, size_t max_pooled = 128, size_t max_capacity = 1024>
+class vector_pool {
+public:
+    static std::vector<T> get() {
+        auto& free = free_list();
+        if (free.empty()) {
+            return {};
+        }
+        auto v = std::move(free.back());
+        free.pop_back();
+        return v;
+    }
+
+    /// destroys the elements, the storage is kept for the next get()
+    static void put(std::vector<T>&& v) {
+        auto& free = free_list();
+        if (
+          v.capacity() == 0 || v.capacity() > max_capacity
+          || free.size() >= max_pooled) {
+            return;
+        }
+        v.clear();
+        free.push_back(std::move(v));
+    }
+
+private:
+    static std::vector<std::vector<T>>& free_list() {
+        static thread_local std::vector<std::vector<T>> free;
+        return free;
+    }
+};
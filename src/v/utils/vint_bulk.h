@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "utils/vint.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace vint {
+namespace details {
+
+/*
+ * Bulk decoding loads a window of bytes and finds the bytes without the
+ * continuation bit, which end a varint, with a single vector compare. Every
+ * varint ending in the window is then decoded from one 64 bit load by
+ * compacting its 7 bit groups, rather than with a branch per byte.
+ */
+#if defined(__AVX2__)
+inline constexpr size_t window_size = 32;
+#else
+inline constexpr size_t window_size = 16;
+#endif
+
+/// \brief bit i is the most significant bit of byte i of x
+inline uint32_t msb_mask(uint64_t x) noexcept {
+    return ((x & 0x8080808080808080ULL) * 0x0002040810204081ULL) >> 56U;
+}
+
+/// \brief bit i is set when byte i of the window ends a varint
+inline uint32_t terminator_mask(const uint8_t* p) noexcept {
+#if defined(__AVX2__)
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(v));
+#elif defined(__SSE2__)
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return ~static_cast<uint32_t>(_mm_movemask_epi8(v)) & 0xffffU;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static constexpr uint8_t weights[16] = {
+      1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t v = vld1q_u8(p);
+    const uint8x16_t msb = vandq_u8(
+      vtstq_u8(v, vdupq_n_u8(0x80)), vld1q_u8(weights));
+    const uint32_t mask = vaddv_u8(vget_low_u8(msb))
+                          | (uint32_t(vaddv_u8(vget_high_u8(msb))) << 8U);
+    return ~mask & 0xffffU;
+#else
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    std::memcpy(&lo, p, sizeof(lo));
+    std::memcpy(&hi, p + sizeof(lo), sizeof(hi));
+    return ~(msb_mask(lo) | (msb_mask(hi) << 8U)) & 0xffffU;
+#endif
+}
+
+/// \brief the 7 bit groups of a varint of `len` bytes, 8 bytes are readable
+inline uint64_t compact_groups(const uint8_t* p, size_t len) noexcept {
+    uint64_t x = 0;
+    std::memcpy(&x, p, sizeof(x));
+    if (len < sizeof(x)) {
+        x &= (uint64_t(1) << (len * 8)) - 1;
+    }
+#if defined(__BMI2__)
+    uint64_t result = _pext_u64(x, 0x7f7f7f7f7f7f7f7fULL);
+#else
+    x &= 0x7f7f7f7f7f7f7f7fULL;
+    x = (x & 0x007f007f007f007fULL) | ((x & 0x7f007f007f007f00ULL) >> 1U);
+    x = (x & 0x00003fff00003fffULL) | ((x & 0x3fff00003fff0000ULL) >> 2U);
+    uint64_t result = (x & 0x000000000fffffffULL)
+                      | ((x & 0x0fffffff00000000ULL) >> 4U);
+#endif
+    // bytes 9 and 10 of the longest varints
+    if (len > 8) {
+        result |= uint64_t(p[8] & 0x7fU) << 56U;
+    }
+    if (len > 9) {
+        result |= uint64_t(p[9] & 0x7fU) << 63U;
+    }
+    return result;
+}
+
+} // namespace details
+
+/// \brief decodes `n` consecutive varints of [src, src + len) into `out`
+///
+/// Returns the number of bytes of the `n` varints, or 0 when the bytes end
+/// before the last of them or one is longer than max_length. Decodes the
+/// same values as deserialize().
+inline size_t deserialize_n(
+  const uint8_t* src, size_t len, int64_t* out, size_t n) noexcept {
+    size_t pos = 0;
+    size_t i = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (i < n && len - pos >= details::window_size) {
+        uint32_t stops = details::terminator_mask(src + pos);
+        size_t off = 0;
+        // varints near the end of the window are left to the next window,
+        // their 64 bit load would read past it
+        while (i < n && stops != 0 && off + 8 <= details::window_size) {
+            const size_t end = __builtin_ctz(stops) + 1;
+            const size_t size = end - off;
+            if (size > max_length) {
+                break;
+            }
+            out[i++] = decode_zigzag(
+              details::compact_groups(src + pos + off, size));
+            off = end;
+            stops &= stops - 1;
+        }
+        if (off == 0) {
+            // no varint ends in the window
+            break;
+        }
+        pos += off;
+    }
+#endif
+    for (; i < n; ++i) {
+        const auto [value, size] = deserialize(
+          bytes_view(src + pos, std::min(len - pos, max_length)));
+        if (size == 0 || (src[pos + size - 1] & 0x80U)) {
+            return 0;
+        }
+        out[i] = value;
+        pos += size;
+    }
+    return pos;
+}
+
+} // namespace vint
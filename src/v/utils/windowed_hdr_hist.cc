@@ -0,0 +1,32 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/windowed_hdr_hist.h"
+
+#include <algorithm>
+
+windowed_hdr_hist::windowed_hdr_hist(
+  std::chrono::milliseconds window, size_t slots)
+  : _slots(std::max<size_t>(slots, 1))
+  , _timer([this] { rotate(); }) {
+    _takes.push_back(_hist.counts());
+    _timer.arm_periodic(
+      std::max(window / _slots, std::chrono::milliseconds(1)));
+}
+
+hdr_hist_counts windowed_hdr_hist::window_counts() const {
+    return _hist.counts().since(_takes.front());
+}
+
+void windowed_hdr_hist::rotate() {
+    _takes.push_back(_hist.counts());
+    while (_takes.size() > _slots) {
+        _takes.pop_front();
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/circular_buffer.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_types.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <memory>
+
+/**
+ * A histogram, and the percentiles of the values it recorded lately.
+ *
+ * The histogram counts since its creation, which the prometheus histograms
+ * exported from it need. Percentiles of all time hide the latency of the last
+ * minutes behind hours of history, so the counts of the histogram are taken
+ * every `window / slots` and the counts of the window are the difference of
+ * the current counts to the oldest take. Only the compact hdr_hist_counts are
+ * kept per slot, not a histogram each.
+ */
+class windowed_hdr_hist {
+public:
+    static constexpr auto default_window = std::chrono::minutes(1);
+    static constexpr size_t default_slots = 6;
+
+    explicit windowed_hdr_hist(
+      std::chrono::milliseconds window = default_window,
+      size_t slots = default_slots);
+    windowed_hdr_hist(const windowed_hdr_hist&) = delete;
+    windowed_hdr_hist& operator=(const windowed_hdr_hist&) = delete;
+    windowed_hdr_hist(windowed_hdr_hist&&) = delete;
+    windowed_hdr_hist& operator=(windowed_hdr_hist&&) = delete;
+    ~windowed_hdr_hist() noexcept = default;
+
+    void record(uint64_t value) { _hist.record(value); }
+    std::unique_ptr<hdr_hist::measurement> auto_measure() {
+        return _hist.auto_measure();
+    }
+
+    /// \brief counts since the creation of the histogram
+    const hdr_hist& hist() const { return _hist; }
+    ss::metrics::histogram seastar_histogram_logform() const {
+        return _hist.seastar_histogram_logform();
+    }
+
+    /// \brief counts of the values recorded in the last window, give or take
+    /// a slot, to merge across shards
+    hdr_hist_counts window_counts() const;
+    int64_t window_value_at(double percentile) const {
+        return window_counts().get_value_at(percentile);
+    }
+
+    /// \brief takes the counts closing the current slot
+    void rotate();
+
+private:
+    hdr_hist _hist;
+    size_t _slots;
+    // counts at the start of each slot of the window, oldest first
+    ss::circular_buffer<hdr_hist_counts> _takes;
+    ss::timer<ss::lowres_clock> _timer;
+};
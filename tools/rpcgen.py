@@ -33,6 +33,7 @@ RPC_TEMPLATE = """
 #include "finjector/hbadger.h"
 #include "utils/string_switch.h"
 #include "random/fast_prng.h"
+#include "utils/hdr_hist.h"
 #include "outcome.h"
 #include "seastarx.h"
 
@@ -41,10 +42,12 @@ RPC_TEMPLATE = """
 #include "{{include}}"
 {%- endfor %}
 
+#include <seastar/core/metrics.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/core/scheduling.hh>
 
+#include <array>
 #include <functional>
 #include <chrono>
 #include <tuple>
@@ -60,7 +63,8 @@ public:
        : _sc(sc), _ssg(ssg) {}
 
     {{service_name}}_service({{service_name}}_service&& o) noexcept
-      : _sc(std::move(o._sc)), _ssg(std::move(o._ssg)), _methods(std::move(o._methods)) {}
+      : _sc(std::move(o._sc)), _ssg(std::move(o._ssg)), _methods(std::move(o._methods)),
+        _latency(std::move(o._latency)) {}
 
     {{service_name}}_service& operator=({{service_name}}_service&& o) noexcept {
        if(this != &o){
@@ -80,6 +84,18 @@ public:
        return _ssg;
     }
 
+    void setup_metrics() final {
+        namespace sm = ss::metrics;
+        {%- for method in methods %}
+        _metrics.add_group("rpc_service", {
+          sm::make_histogram(
+            "method_latency",
+            [this] { return _latency[{{loop.index - 1}}].seastar_histogram_logform(); },
+            sm::description("Latency of handling the requests of the method, in microseconds"),
+            {sm::label("service")("{{service_name}}"), sm::label("method")("{{method.name}}")})});
+        {%- endfor %}
+    }
+
     rpc::method* method_from_id(uint32_t idx) final {
        switch(idx) {
        {%- for method in methods %}
@@ -88,15 +104,28 @@ public:
          default: return nullptr;
        }
     }
+
+    rpc::memory_class method_memory_class(uint32_t idx) const final {
+       switch(idx) {
+       {%- for method in methods if method.memory_class != "normal" %}
+         case {{method.id}}: return rpc::memory_class::{{method.memory_class}};
+       {%- endfor %}
+         default: return rpc::memory_class::normal;
+       }
+    }
     {%- for method in methods %}
     /// \\brief {{method.input_type}} -> {{method.output_type}}
     virtual ss::future<rpc::netbuf>
     raw_{{method.name}}(ss::input_stream<char>& in, rpc::streaming_context& ctx) {
+      const auto begin = hdr_hist::clock_type::now();
       return execution_helper<{{method.input_type}},
-                              {{method.output_type}}>::exec(in, ctx, {{method.id}},
+                              {{method.output_type}}>::{{ "exec_inline" if method.inline_serde else "exec" }}(in, ctx, {{method.id}},
       [this](
           {{method.input_type}}&& t, rpc::streaming_context& ctx) -> ss::future<{{method.output_type}}> {
           return {{method.name}}(std::move(t), ctx);
+      }).then([this, begin](rpc::netbuf b) {
+          record_latency({{loop.index - 1}}, begin);
+          return b;
       });
     }
     virtual ss::future<{{method.output_type}}>
@@ -105,6 +134,11 @@ public:
     }
     {%- endfor %}
 private:
+    void record_latency(size_t idx, hdr_hist::clock_type::time_point begin) {
+        _latency[idx].record(std::chrono::duration_cast<std::chrono::microseconds>(
+          hdr_hist::clock_type::now() - begin).count());
+    }
+
     ss::scheduling_group _sc;
     ss::smp_service_group _ssg;
     std::array<rpc::method, {{methods|length}}> _methods{%raw %}{{{% endraw %}
@@ -114,6 +148,8 @@ private:
       }){{ "," if not loop.last }}
       {%- endfor %}
     {% raw %}}}{% endraw %};
+    std::array<hdr_hist, {{methods|length}}> _latency;
+    ss::metrics::metric_groups _metrics;
 };
 class {{service_name}}_client_protocol {
 public:
@@ -193,6 +229,9 @@ private:
 """
 
 
+MEMORY_CLASSES = ["normal", "latency_critical", "bulk"]
+
+
 def _read_file(name):
     with open(name, 'r') as f:
         return json.load(f)
@@ -212,6 +251,15 @@ def _enrich_methods(service):
 
     for m in service["methods"]:
         m["id"] = _xor_id(m)
+        # decode the request and encode the reply without deferring, for
+        # methods whose async_adl always resolve immediately
+        m.setdefault("inline_serde", False)
+        # admission of the request memory by the server, see
+        # rpc::memory_class
+        m.setdefault("memory_class", "normal")
+        if m["memory_class"] not in MEMORY_CLASSES:
+            raise ValueError("unknown memory_class %s of method %s" %
+                             (m["memory_class"], m["name"]))
 
     return service
 